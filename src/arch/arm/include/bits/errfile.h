@@ -15,6 +15,8 @@ FILE_SECBOOT ( PERMITTED );
  * @{
  */
 
+#define ERRFILE_arm64_sha	( ERRFILE_ARCH | ERRFILE_CORE | 0x00000000 )
+
 /** @} */
 
 #endif /* _BITS_ERRFILE_H */
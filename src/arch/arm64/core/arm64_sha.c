@@ -0,0 +1,317 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+FILE_SECBOOT ( PERMITTED );
+
+/** @file
+ *
+ * ARMv8 cryptographic extension SHA hardware acceleration
+ *
+ * The SHA instructions are an optional part of the ARMv8
+ * architecture, and so their presence is checked via the
+ * ID_AA64ISAR0_EL1 system register (which is accessible at EL1 and
+ * above, and is emulated by Linux for userspace).
+ *
+ */
+
+#include <stdint.h>
+#include <errno.h>
+#include <ipxe/sha1.h>
+#include <ipxe/sha256.h>
+
+/** SHA-1 instructions are supported */
+#define ID_AA64ISAR0_SHA1( isar0 ) ( ( (isar0) >> 8 ) & 0xf )
+
+/** SHA-256 instructions are supported */
+#define ID_AA64ISAR0_SHA2( isar0 ) ( ( (isar0) >> 12 ) & 0xf )
+
+/** SHA-1 round constants */
+static const uint32_t arm64_sha1_k[4] = {
+	0x5a827999, 0x6ed9eba1, 0x8f1bbcdc, 0xca62c1d6
+};
+
+/**
+ * Read instruction set attribute register
+ *
+ * @ret isar0		ID_AA64ISAR0_EL1 value
+ */
+static inline __attribute__ (( always_inline )) uint64_t
+arm64_isar0 ( void ) {
+	uint64_t isar0;
+
+	__asm__ ( "mrs %0, ID_AA64ISAR0_EL1" : "=r" ( isar0 ) );
+	return isar0;
+}
+
+/**
+ * Check if SHA-256 hardware acceleration is usable
+ *
+ * @ret rc		Return status code
+ */
+static int arm64_sha256_probe ( void ) {
+
+	if ( ! ID_AA64ISAR0_SHA2 ( arm64_isar0() ) )
+		return -ENOTSUP;
+	return 0;
+}
+
+/**
+ * Check if SHA-1 hardware acceleration is usable
+ *
+ * @ret rc		Return status code
+ */
+static int arm64_sha1_probe ( void ) {
+
+	if ( ! ID_AA64ISAR0_SHA1 ( arm64_isar0() ) )
+		return -ENOTSUP;
+	return 0;
+}
+
+/**
+ * Perform four SHA-256 rounds
+ *
+ * @v w			Register holding message schedule words
+ */
+#define ARM64_SHA256_ROUNDS( w )					\
+	"ld1 {v4.4s}, [%[k]], #16\n\t"					\
+	"add v5.4s, " w ".4s, v4.4s\n\t"				\
+	"mov v6.16b, v0.16b\n\t"					\
+	"sha256h q0, q1, v5.4s\n\t"					\
+	"sha256h2 q1, q6, v5.4s\n\t"
+
+/**
+ * Calculate four SHA-256 message schedule words
+ *
+ * @v w0		Register holding words W[t-16..t-13]
+ * @v w1		Register holding words W[t-12..t-9]
+ * @v w2		Register holding words W[t-8..t-5]
+ * @v w3		Register holding words W[t-4..t-1]
+ *
+ * On exit, w0 holds the words W[t..t+3].
+ */
+#define ARM64_SHA256_SCHEDULE( w0, w1, w2, w3 )				\
+	"sha256su0 " w0 ".4s, " w1 ".4s\n\t"				\
+	"sha256su1 " w0 ".4s, " w2 ".4s, " w3 ".4s\n\t"
+
+/**
+ * Digest SHA-256 data blocks
+ *
+ * @v digest		Digest (in big-endian order)
+ * @v data		Data blocks
+ * @v count		Number of blocks
+ */
+static void arm64_sha256_digest ( struct sha256_digest *digest,
+				  const void *data, size_t count ) {
+	const uint32_t *k;
+
+	__asm__ __volatile__ ( "ld1 {v0.16b, v1.16b}, [%[digest]]\n\t"
+			       "rev32 v0.16b, v0.16b\n\t"
+			       "rev32 v1.16b, v1.16b\n\t"
+			       "\n1:\n\t"
+			       "mov %[k], %[sha256_k]\n\t"
+			       "ld1 {v16.16b-v19.16b}, [%[data]], #64\n\t"
+			       "rev32 v16.16b, v16.16b\n\t"
+			       "rev32 v17.16b, v17.16b\n\t"
+			       "rev32 v18.16b, v18.16b\n\t"
+			       "rev32 v19.16b, v19.16b\n\t"
+			       "mov v2.16b, v0.16b\n\t"
+			       "mov v3.16b, v1.16b\n\t"
+			       /* Rounds 0-47 */
+			       ".rept 3\n\t"
+			       ARM64_SHA256_ROUNDS ( "v16" )
+			       ARM64_SHA256_SCHEDULE ( "v16", "v17", "v18",
+						       "v19" )
+			       ARM64_SHA256_ROUNDS ( "v17" )
+			       ARM64_SHA256_SCHEDULE ( "v17", "v18", "v19",
+						       "v16" )
+			       ARM64_SHA256_ROUNDS ( "v18" )
+			       ARM64_SHA256_SCHEDULE ( "v18", "v19", "v16",
+						       "v17" )
+			       ARM64_SHA256_ROUNDS ( "v19" )
+			       ARM64_SHA256_SCHEDULE ( "v19", "v16", "v17",
+						       "v18" )
+			       ".endr\n\t"
+			       /* Rounds 48-63 */
+			       ARM64_SHA256_ROUNDS ( "v16" )
+			       ARM64_SHA256_ROUNDS ( "v17" )
+			       ARM64_SHA256_ROUNDS ( "v18" )
+			       ARM64_SHA256_ROUNDS ( "v19" )
+			       /* Add to state */
+			       "add v0.4s, v0.4s, v2.4s\n\t"
+			       "add v1.4s, v1.4s, v3.4s\n\t"
+			       "subs %[count], %[count], #1\n\t"
+			       "b.ne 1b\n\t"
+			       "rev32 v0.16b, v0.16b\n\t"
+			       "rev32 v1.16b, v1.16b\n\t"
+			       "st1 {v0.16b, v1.16b}, [%[digest]]\n\t"
+			       : [data] "+r" ( data ), [count] "+r" ( count ),
+				 [k] "=&r" ( k )
+			       : [digest] "r" ( digest ),
+				 [sha256_k] "r" ( sha256_k )
+			       : "v0", "v1", "v2", "v3", "v4", "v5", "v6",
+				 "v16", "v17", "v18", "v19", "cc", "memory" );
+}
+
+/**
+ * Perform four SHA-1 rounds
+ *
+ * @v op		Round operation (c, p, or m)
+ * @v k			Register holding round constant
+ * @v w			Register holding message schedule words
+ */
+#define ARM64_SHA1_ROUNDS( op, k, w )					\
+	"add v5.4s, " w ".4s, " k ".4s\n\t"				\
+	"sha1h s7, s0\n\t"						\
+	"sha1" op " q0, s1, v5.4s\n\t"					\
+	"mov v1.16b, v7.16b\n\t"
+
+/**
+ * Calculate four SHA-1 message schedule words
+ *
+ * @v w0		Register holding words W[t-16..t-13]
+ * @v w1		Register holding words W[t-12..t-9]
+ * @v w2		Register holding words W[t-8..t-5]
+ * @v w3		Register holding words W[t-4..t-1]
+ *
+ * On exit, w0 holds the words W[t..t+3].
+ */
+#define ARM64_SHA1_SCHEDULE( w0, w1, w2, w3 )				\
+	"sha1su0 " w0 ".4s, " w1 ".4s, " w2 ".4s\n\t"			\
+	"sha1su1 " w0 ".4s, " w3 ".4s\n\t"
+
+/**
+ * Perform sixteen SHA-1 rounds and calculate message schedule words
+ *
+ * @v op		Round operation (c, p, or m)
+ * @v k			Register holding round constant
+ */
+#define ARM64_SHA1_ROUNDS_SCHEDULE( op, k )				\
+	ARM64_SHA1_ROUNDS ( op, k, "v16" )				\
+	ARM64_SHA1_SCHEDULE ( "v16", "v17", "v18", "v19" )		\
+	ARM64_SHA1_ROUNDS ( op, k, "v17" )				\
+	ARM64_SHA1_SCHEDULE ( "v17", "v18", "v19", "v16" )		\
+	ARM64_SHA1_ROUNDS ( op, k, "v18" )				\
+	ARM64_SHA1_SCHEDULE ( "v18", "v19", "v16", "v17" )		\
+	ARM64_SHA1_ROUNDS ( op, k, "v19" )				\
+	ARM64_SHA1_SCHEDULE ( "v19", "v16", "v17", "v18" )
+
+/**
+ * Digest SHA-1 data blocks
+ *
+ * @v digest		Digest (in big-endian order)
+ * @v data		Data blocks
+ * @v count		Number of blocks
+ */
+static void arm64_sha1_digest ( struct sha1_digest *digest,
+				const void *data, size_t count ) {
+
+	__asm__ __volatile__ ( "ld4r {v20.4s-v23.4s}, [%[sha1_k]]\n\t"
+			       "ld1 {v0.16b}, [%[digest]]\n\t"
+			       "ldr s1, [%[digest], #16]\n\t"
+			       "rev32 v0.16b, v0.16b\n\t"
+			       "rev32 v1.16b, v1.16b\n\t"
+			       "\n1:\n\t"
+			       "ld1 {v16.16b-v19.16b}, [%[data]], #64\n\t"
+			       "rev32 v16.16b, v16.16b\n\t"
+			       "rev32 v17.16b, v17.16b\n\t"
+			       "rev32 v18.16b, v18.16b\n\t"
+			       "rev32 v19.16b, v19.16b\n\t"
+			       "mov v2.16b, v0.16b\n\t"
+			       "mov v3.16b, v1.16b\n\t"
+			       /* Rounds 0-15 */
+			       ARM64_SHA1_ROUNDS_SCHEDULE ( "c", "v20" )
+			       /* Rounds 16-19 */
+			       ARM64_SHA1_ROUNDS ( "c", "v20", "v16" )
+			       ARM64_SHA1_SCHEDULE ( "v16", "v17", "v18",
+						     "v19" )
+			       /* Rounds 20-39 */
+			       ARM64_SHA1_ROUNDS ( "p", "v21", "v17" )
+			       ARM64_SHA1_SCHEDULE ( "v17", "v18", "v19",
+						     "v16" )
+			       ARM64_SHA1_ROUNDS ( "p", "v21", "v18" )
+			       ARM64_SHA1_SCHEDULE ( "v18", "v19", "v16",
+						     "v17" )
+			       ARM64_SHA1_ROUNDS ( "p", "v21", "v19" )
+			       ARM64_SHA1_SCHEDULE ( "v19", "v16", "v17",
+						     "v18" )
+			       ARM64_SHA1_ROUNDS ( "p", "v21", "v16" )
+			       ARM64_SHA1_SCHEDULE ( "v16", "v17", "v18",
+						     "v19" )
+			       ARM64_SHA1_ROUNDS ( "p", "v21", "v17" )
+			       ARM64_SHA1_SCHEDULE ( "v17", "v18", "v19",
+						     "v16" )
+			       /* Rounds 40-59 */
+			       ARM64_SHA1_ROUNDS ( "m", "v22", "v18" )
+			       ARM64_SHA1_SCHEDULE ( "v18", "v19", "v16",
+						     "v17" )
+			       ARM64_SHA1_ROUNDS ( "m", "v22", "v19" )
+			       ARM64_SHA1_SCHEDULE ( "v19", "v16", "v17",
+						     "v18" )
+			       ARM64_SHA1_ROUNDS ( "m", "v22", "v16" )
+			       ARM64_SHA1_SCHEDULE ( "v16", "v17", "v18",
+						     "v19" )
+			       ARM64_SHA1_ROUNDS ( "m", "v22", "v17" )
+			       ARM64_SHA1_SCHEDULE ( "v17", "v18", "v19",
+						     "v16" )
+			       ARM64_SHA1_ROUNDS ( "m", "v22", "v18" )
+			       ARM64_SHA1_SCHEDULE ( "v18", "v19", "v16",
+						     "v17" )
+			       /* Rounds 60-79 */
+			       ARM64_SHA1_ROUNDS ( "p", "v23", "v19" )
+			       ARM64_SHA1_SCHEDULE ( "v19", "v16", "v17",
+						     "v18" )
+			       ARM64_SHA1_ROUNDS ( "p", "v23", "v16" )
+			       ARM64_SHA1_ROUNDS ( "p", "v23", "v17" )
+			       ARM64_SHA1_ROUNDS ( "p", "v23", "v18" )
+			       ARM64_SHA1_ROUNDS ( "p", "v23", "v19" )
+			       /* Add to state */
+			       "add v0.4s, v0.4s, v2.4s\n\t"
+			       "add v1.4s, v1.4s, v3.4s\n\t"
+			       "subs %[count], %[count], #1\n\t"
+			       "b.ne 1b\n\t"
+			       "rev32 v0.16b, v0.16b\n\t"
+			       "rev32 v1.16b, v1.16b\n\t"
+			       "st1 {v0.16b}, [%[digest]]\n\t"
+			       "str s1, [%[digest], #16]\n\t"
+			       : [data] "+r" ( data ), [count] "+r" ( count )
+			       : [digest] "r" ( digest ),
+				 [sha1_k] "r" ( arm64_sha1_k )
+			       : "v0", "v1", "v2", "v3", "v5", "v7", "v16",
+				 "v17", "v18", "v19", "v20", "v21", "v22",
+				 "v23", "cc", "memory" );
+}
+
+/** SHA-256 hardware accelerator */
+struct sha256_accelerator arm64_sha256_accelerator __sha256_accelerator = {
+	.name = "armv8",
+	.probe = arm64_sha256_probe,
+	.digest = arm64_sha256_digest,
+};
+
+/** SHA-1 hardware accelerator */
+struct sha1_accelerator arm64_sha1_accelerator __sha1_accelerator = {
+	.name = "armv8",
+	.probe = arm64_sha1_probe,
+	.digest = arm64_sha1_digest,
+};
@@ -30,6 +30,7 @@
 FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 FILE_SECBOOT ( PERMITTED );
 
+#include <stdint.h>
 #include <string.h>
 
 /** Block size (for "ldp"/"stp") */
@@ -42,6 +43,10 @@ FILE_SECBOOT ( PERMITTED );
  * @v src		Source address
  * @v len		Length
  * @ret dest		Destination address
+ *
+ * All source data for each load/store step is loaded before being
+ * stored, so that this may also be used to copy overlapping regions
+ * forwards.
  */
 void arm64_memcpy ( void *dest, const void *src, size_t len ) {
 	size_t len_pre;
@@ -66,47 +71,80 @@ void arm64_memcpy ( void *dest, const void *src, size_t len ) {
 	len -= len_mid;
 	len_post = len;
 
-	/* Copy pre-aligned section */
-	__asm__ __volatile__ ( "cbz %2, 2f\n\t"
+	/* Copy pre-aligned section, using increasing sizes so that
+	 * each store is naturally aligned.
+	 */
+	__asm__ __volatile__ ( "tbz %w3, #0, 1f\n\t"
+			       "ldrb %w2, [%1], #1\n\t"
+			       "strb %w2, [%0], #1\n\t"
+			       "\n1:\n\t"
+			       "tbz %w3, #1, 1f\n\t"
+			       "ldrh %w2, [%1], #2\n\t"
+			       "strh %w2, [%0], #2\n\t"
+			       "\n1:\n\t"
+			       "tbz %w3, #2, 1f\n\t"
+			       "ldr %w2, [%1], #4\n\t"
+			       "str %w2, [%0], #4\n\t"
+			       "\n1:\n\t"
+			       "tbz %w3, #3, 1f\n\t"
+			       "ldr %2, [%1], #8\n\t"
+			       "str %2, [%0], #8\n\t"
 			       "\n1:\n\t"
-			       "ldrb %w3, [%1], #1\n\t"
-			       "strb %w3, [%0], #1\n\t"
-			       "sub %2, %2, #1\n\t"
-			       "cbnz %2, 1b\n\t"
-			       "\n2:\n\t"
 			       : "+r" ( dest ), "+r" ( src ),
-				 "=&r" ( discard_len ),
 				 "=&r" ( discard_data )
-			       : "2" ( len_pre )
+			       : "r" ( len_pre )
 			       : "memory" );
 
-	/* Copy aligned section */
-	__asm__ __volatile__ ( "cbz %2, 2f\n\t"
+	/* Copy aligned section, using pairs of NEON registers for
+	 * large blocks and pairs of general-purpose registers for
+	 * any remaining blocks.
+	 */
+	__asm__ __volatile__ ( "b 2f\n\t"
 			       "\n1:\n\t"
+			       "ldp q0, q1, [%1], #32\n\t"
+			       "ldp q2, q3, [%1], #32\n\t"
+			       "stp q0, q1, [%0], #32\n\t"
+			       "stp q2, q3, [%0], #32\n\t"
+			       "sub %2, %2, #64\n\t"
+			       "\n2:\n\t"
+			       "cmp %2, #64\n\t"
+			       "b.hs 1b\n\t"
+			       "cbz %2, 4f\n\t"
+			       "\n3:\n\t"
 			       "ldp %3, %4, [%1], #16\n\t"
 			       "stp %3, %4, [%0], #16\n\t"
 			       "sub %2, %2, #16\n\t"
-			       "cbnz %2, 1b\n\t"
-			       "\n2:\n\t"
+			       "cbnz %2, 3b\n\t"
+			       "\n4:\n\t"
 			       : "+r" ( dest ), "+r" ( src ),
 				 "=&r" ( discard_len ),
 				 "=&r" ( discard_low ),
 				 "=&r" ( discard_high )
 			       : "2" ( len_mid )
-			       : "memory" );
+			       : "v0", "v1", "v2", "v3", "cc", "memory" );
 
-	/* Copy post-aligned section */
-	__asm__ __volatile__ ( "cbz %2, 2f\n\t"
+	/* Copy post-aligned section, using decreasing sizes so that
+	 * each store is naturally aligned.
+	 */
+	__asm__ __volatile__ ( "tbz %w3, #3, 1f\n\t"
+			       "ldr %2, [%1], #8\n\t"
+			       "str %2, [%0], #8\n\t"
+			       "\n1:\n\t"
+			       "tbz %w3, #2, 1f\n\t"
+			       "ldr %w2, [%1], #4\n\t"
+			       "str %w2, [%0], #4\n\t"
+			       "\n1:\n\t"
+			       "tbz %w3, #1, 1f\n\t"
+			       "ldrh %w2, [%1], #2\n\t"
+			       "strh %w2, [%0], #2\n\t"
+			       "\n1:\n\t"
+			       "tbz %w3, #0, 1f\n\t"
+			       "ldrb %w2, [%1], #1\n\t"
+			       "strb %w2, [%0], #1\n\t"
 			       "\n1:\n\t"
-			       "ldrb %w3, [%1], #1\n\t"
-			       "strb %w3, [%0], #1\n\t"
-			       "sub %2, %2, #1\n\t"
-			       "cbnz %2, 1b\n\t"
-			       "\n2:\n\t"
 			       : "+r" ( dest ), "+r" ( src ),
-				 "=&r" ( discard_len ),
 				 "=&r" ( discard_data )
-			       : "2" ( len_post )
+			       : "r" ( len_post )
 			       : "memory" );
 }
 
@@ -117,11 +155,30 @@ void arm64_memcpy ( void *dest, const void *src, size_t len ) {
  * @v len		Length
  */
 void arm64_bzero ( void *dest, size_t len ) {
+
+	arm64_memset ( dest, len, 0 );
+}
+
+/**
+ * Fill memory region
+ *
+ * @v dest		Destination region
+ * @v len		Length
+ * @v character		Fill character
+ *
+ * The unusual parameter order is to allow for more efficient
+ * tail-calling to arm64_memset() when zeroing a region.
+ */
+void arm64_memset ( void *dest, size_t len, int character ) {
+	uint64_t pattern;
 	size_t len_pre;
 	size_t len_mid;
 	size_t len_post;
 	unsigned long discard_len;
 
+	/* Construct fill pattern */
+	pattern = ( ( ( uint8_t ) character ) * 0x0101010101010101ULL );
+
 	/* Calculate pre-aligned, aligned, and post-aligned lengths */
 	len_pre = ( ( ARM64_STRING_BLKSZ - ( ( intptr_t ) dest ) ) &
 		    ( ARM64_STRING_BLKSZ - 1 ) );
@@ -132,74 +189,66 @@ void arm64_bzero ( void *dest, size_t len ) {
 	len -= len_mid;
 	len_post = len;
 
-	/* Zero pre-aligned section */
-	__asm__ __volatile__ ( "cbz %1, 2f\n\t"
+	/* Fill pre-aligned section, using increasing sizes so that
+	 * each store is naturally aligned.
+	 */
+	__asm__ __volatile__ ( "tbz %w1, #0, 1f\n\t"
+			       "strb %w2, [%0], #1\n\t"
 			       "\n1:\n\t"
-			       "strb wzr, [%0], #1\n\t"
-			       "sub %1, %1, #1\n\t"
-			       "cbnz %1, 1b\n\t"
-			       "\n2:\n\t"
-			       : "+r" ( dest ),
-				 "=&r" ( discard_len )
-			       : "1" ( len_pre )
-			       : "memory" );
-
-	/* Zero aligned section */
-	__asm__ __volatile__ ( "cbz %1, 2f\n\t"
+			       "tbz %w1, #1, 1f\n\t"
+			       "strh %w2, [%0], #2\n\t"
 			       "\n1:\n\t"
-			       "stp xzr, xzr, [%0], #16\n\t"
-			       "sub %1, %1, #16\n\t"
-			       "cbnz %1, 1b\n\t"
-			       "\n2:\n\t"
-			       : "+r" ( dest ),
-				 "=&r" ( discard_len )
-			       : "1" ( len_mid )
+			       "tbz %w1, #2, 1f\n\t"
+			       "str %w2, [%0], #4\n\t"
+			       "\n1:\n\t"
+			       "tbz %w1, #3, 1f\n\t"
+			       "str %2, [%0], #8\n\t"
+			       "\n1:\n\t"
+			       : "+r" ( dest )
+			       : "r" ( len_pre ), "r" ( pattern )
 			       : "memory" );
 
-	/* Zero post-aligned section */
-	__asm__ __volatile__ ( "cbz %1, 2f\n\t"
+	/* Fill aligned section, using pairs of NEON registers for
+	 * large blocks and pairs of general-purpose registers for
+	 * any remaining blocks.
+	 */
+	__asm__ __volatile__ ( "dup v0.2d, %3\n\t"
+			       "b 2f\n\t"
 			       "\n1:\n\t"
-			       "strb wzr, [%0], #1\n\t"
-			       "sub %1, %1, #1\n\t"
-			       "cbnz %1, 1b\n\t"
+			       "stp q0, q0, [%0], #32\n\t"
+			       "stp q0, q0, [%0], #32\n\t"
+			       "sub %1, %1, #64\n\t"
 			       "\n2:\n\t"
+			       "cmp %1, #64\n\t"
+			       "b.hs 1b\n\t"
+			       "cbz %1, 4f\n\t"
+			       "\n3:\n\t"
+			       "stp %3, %3, [%0], #16\n\t"
+			       "sub %1, %1, #16\n\t"
+			       "cbnz %1, 3b\n\t"
+			       "\n4:\n\t"
 			       : "+r" ( dest ),
 				 "=&r" ( discard_len )
-			       : "1" ( len_post )
-			       : "memory" );
-}
-
-/**
- * Fill memory region
- *
- * @v dest		Destination region
- * @v len		Length
- * @v character		Fill character
- *
- * The unusual parameter order is to allow for more efficient
- * tail-calling to arm64_memset() when zeroing a region.
- */
-void arm64_memset ( void *dest, size_t len, int character ) {
-	size_t discard_offset;
-
-	/* Use optimised zeroing code if applicable */
-	if ( character == 0 ) {
-		arm64_bzero ( dest, len );
-		return;
-	}
+			       : "1" ( len_mid ), "r" ( pattern )
+			       : "v0", "cc", "memory" );
 
-	/* Fill one byte at a time.  Calling memset() with a non-zero
-	 * value is relatively rare and unlikely to be
-	 * performance-critical.
+	/* Fill post-aligned section, using decreasing sizes so that
+	 * each store is naturally aligned.
 	 */
-	__asm__ __volatile__ ( "cbz %0, 2f\n\t"
+	__asm__ __volatile__ ( "tbz %w1, #3, 1f\n\t"
+			       "str %2, [%0], #8\n\t"
 			       "\n1:\n\t"
-			       "sub %0, %0, #1\n\t"
-			       "strb %w2, [%1, %0]\n\t"
-			       "cbnz %0, 1b\n\t"
-			       "\n2:\n\t"
-			       : "=&r" ( discard_offset )
-			       : "r" ( dest ), "r" ( character ), "0" ( len )
+			       "tbz %w1, #2, 1f\n\t"
+			       "str %w2, [%0], #4\n\t"
+			       "\n1:\n\t"
+			       "tbz %w1, #1, 1f\n\t"
+			       "strh %w2, [%0], #2\n\t"
+			       "\n1:\n\t"
+			       "tbz %w1, #0, 1f\n\t"
+			       "strb %w2, [%0], #1\n\t"
+			       "\n1:\n\t"
+			       : "+r" ( dest )
+			       : "r" ( len_post ), "r" ( pattern )
 			       : "memory" );
 }
 
@@ -211,25 +260,9 @@ void arm64_memset ( void *dest, size_t len, int character ) {
  * @v len		Length
  */
 void arm64_memmove_forwards ( void *dest, const void *src, size_t len ) {
-	void *discard_dest;
-	const void *discard_src;
-	unsigned long discard_data;
 
-	/* Assume memmove() is not performance-critical, and perform a
-	 * bytewise copy for simplicity.
-	 */
-	__asm__ __volatile__ ( "b 2f\n\t"
-			       "\n1:\n\t"
-			       "ldrb %w2, [%1], #1\n\t"
-			       "strb %w2, [%0], #1\n\t"
-			       "\n2:\n\t"
-			       "cmp %0, %3\n\t"
-			       "bne 1b\n\t"
-			       : "=&r" ( discard_dest ),
-				 "=&r" ( discard_src ),
-				 "=&r" ( discard_data )
-			       : "r" ( dest + len ), "0" ( dest ), "1" ( src )
-			       : "memory" );
+	/* arm64_memcpy() loads before storing at every step */
+	arm64_memcpy ( dest, src, len );
 }
 
 /**
@@ -240,22 +273,98 @@ void arm64_memmove_forwards ( void *dest, const void *src, size_t len ) {
  * @v len		Length
  */
 void arm64_memmove_backwards ( void *dest, const void *src, size_t len ) {
-	size_t discard_offset;
+	size_t len_pre;
+	size_t len_mid;
+	size_t len_post;
 	unsigned long discard_data;
+	unsigned long discard_low;
+	unsigned long discard_high;
+	unsigned long discard_len;
+
+	/* Calculate pre-aligned, aligned, and post-aligned lengths,
+	 * aligning on the end of the destination region.
+	 */
+	dest += len;
+	src += len;
+	len_post = ( ( ( intptr_t ) dest ) & ( ARM64_STRING_BLKSZ - 1 ) );
+	if ( len_post > len )
+		len_post = len;
+	len -= len_post;
+	len_mid = ( len & ~( ARM64_STRING_BLKSZ - 1 ) );
+	len -= len_mid;
+	len_pre = len;
 
-	/* Assume memmove() is not performance-critical, and perform a
-	 * bytewise copy for simplicity.
+	/* Copy post-aligned section, using increasing sizes so that
+	 * each store is naturally aligned.
 	 */
-	__asm__ __volatile__ ( "cbz %0, 2f\n\t"
+	__asm__ __volatile__ ( "tbz %w3, #0, 1f\n\t"
+			       "ldrb %w2, [%1, #-1]!\n\t"
+			       "strb %w2, [%0, #-1]!\n\t"
+			       "\n1:\n\t"
+			       "tbz %w3, #1, 1f\n\t"
+			       "ldrh %w2, [%1, #-2]!\n\t"
+			       "strh %w2, [%0, #-2]!\n\t"
+			       "\n1:\n\t"
+			       "tbz %w3, #2, 1f\n\t"
+			       "ldr %w2, [%1, #-4]!\n\t"
+			       "str %w2, [%0, #-4]!\n\t"
 			       "\n1:\n\t"
-			       "sub %0, %0, #1\n\t"
-			       "ldrb %w1, [%3, %0]\n\t"
-			       "strb %w1, [%2, %0]\n\t"
-			       "cbnz %0, 1b\n\t"
+			       "tbz %w3, #3, 1f\n\t"
+			       "ldr %2, [%1, #-8]!\n\t"
+			       "str %2, [%0, #-8]!\n\t"
+			       "\n1:\n\t"
+			       : "+r" ( dest ), "+r" ( src ),
+				 "=&r" ( discard_data )
+			       : "r" ( len_post )
+			       : "memory" );
+
+	/* Copy aligned section */
+	__asm__ __volatile__ ( "b 2f\n\t"
+			       "\n1:\n\t"
+			       "ldp q2, q3, [%1, #-32]!\n\t"
+			       "ldp q0, q1, [%1, #-32]!\n\t"
+			       "stp q2, q3, [%0, #-32]!\n\t"
+			       "stp q0, q1, [%0, #-32]!\n\t"
+			       "sub %2, %2, #64\n\t"
 			       "\n2:\n\t"
-			       : "=&r" ( discard_offset ),
+			       "cmp %2, #64\n\t"
+			       "b.hs 1b\n\t"
+			       "cbz %2, 4f\n\t"
+			       "\n3:\n\t"
+			       "ldp %3, %4, [%1, #-16]!\n\t"
+			       "stp %3, %4, [%0, #-16]!\n\t"
+			       "sub %2, %2, #16\n\t"
+			       "cbnz %2, 3b\n\t"
+			       "\n4:\n\t"
+			       : "+r" ( dest ), "+r" ( src ),
+				 "=&r" ( discard_len ),
+				 "=&r" ( discard_low ),
+				 "=&r" ( discard_high )
+			       : "2" ( len_mid )
+			       : "v0", "v1", "v2", "v3", "cc", "memory" );
+
+	/* Copy pre-aligned section, using decreasing sizes so that
+	 * each store is naturally aligned.
+	 */
+	__asm__ __volatile__ ( "tbz %w3, #3, 1f\n\t"
+			       "ldr %2, [%1, #-8]!\n\t"
+			       "str %2, [%0, #-8]!\n\t"
+			       "\n1:\n\t"
+			       "tbz %w3, #2, 1f\n\t"
+			       "ldr %w2, [%1, #-4]!\n\t"
+			       "str %w2, [%0, #-4]!\n\t"
+			       "\n1:\n\t"
+			       "tbz %w3, #1, 1f\n\t"
+			       "ldrh %w2, [%1, #-2]!\n\t"
+			       "strh %w2, [%0, #-2]!\n\t"
+			       "\n1:\n\t"
+			       "tbz %w3, #0, 1f\n\t"
+			       "ldrb %w2, [%1, #-1]!\n\t"
+			       "strb %w2, [%0, #-1]!\n\t"
+			       "\n1:\n\t"
+			       : "+r" ( dest ), "+r" ( src ),
 				 "=&r" ( discard_data )
-			       : "r" ( dest ), "r" ( src ), "0" ( len )
+			       : "r" ( len_pre )
 			       : "memory" );
 }
 
@@ -39,6 +39,10 @@ FILE_SECBOOT ( PERMITTED );
 /** Number of steps in each iteration of the unrolled main checksumming loop */
 #define TCPIP_CHKSUM_UNROLL 4
 
+/** Block size used by NEON checksumming loop */
+#define TCPIP_CHKSUM_NEON_BLKSZ \
+	( TCPIP_CHKSUM_ALIGN * TCPIP_CHKSUM_UNROLL )
+
 /**
  * Calculate continued TCP/IP checkum
  *
@@ -55,6 +59,7 @@ uint16_t tcpip_continue_chksum ( uint16_t sum, const void *data,
 	unsigned int pre;
 	unsigned int post;
 	unsigned int first;
+	intptr_t neon;
 	uint64_t discard_low;
 	uint64_t discard_high;
 
@@ -74,6 +79,14 @@ uint16_t tcpip_continue_chksum ( uint16_t sum, const void *data,
 	pre = ( ( mid - start ) & ( TCPIP_CHKSUM_ALIGN - 1 ) );
 	post = ( ( end - mid ) & ( TCPIP_CHKSUM_ALIGN - 1 ) );
 
+	/* Calculate end of section to be summed using NEON.  This
+	 * covers a whole number of iterations of the unrolled loop,
+	 * leaving only the first (partial) iteration for the unrolled
+	 * loop itself.
+	 */
+	neon = ( start + pre +
+		 ( ( len - pre - post ) & ~( TCPIP_CHKSUM_NEON_BLKSZ - 1 ) ) );
+
 	/* Calculate number of steps in first iteration of unrolled loop */
 	first = ( ( ( len - pre - post ) / TCPIP_CHKSUM_ALIGN ) &
 		  ( TCPIP_CHKSUM_UNROLL - 1 ) );
@@ -105,6 +118,32 @@ uint16_t tcpip_continue_chksum ( uint16_t sum, const void *data,
 		  "ldr %2, [%1], #8\n\t"
 		  "adcs %0, %0, %2\n\t"
 		  "\n1:\n\t"
+		  /* Sum 64-byte blocks using NEON, if applicable.  Each
+		   * 32-bit word is accumulated into a 64-bit lane, which
+		   * cannot overflow, and so the carry flag is preserved.
+		   */
+		  "sub %2, %8, %1\n\t"
+		  "cbz %2, 3f\n\t"
+		  "movi v4.2d, #0\n\t"
+		  "movi v5.2d, #0\n\t"
+		  "movi v6.2d, #0\n\t"
+		  "movi v7.2d, #0\n\t"
+		  "\n4:\n\t"
+		  "ld1 {v0.4s, v1.4s, v2.4s, v3.4s}, [%1], #64\n\t"
+		  "uadalp v4.2d, v0.4s\n\t"
+		  "uadalp v5.2d, v1.4s\n\t"
+		  "uadalp v6.2d, v2.4s\n\t"
+		  "uadalp v7.2d, v3.4s\n\t"
+		  "sub %2, %8, %1\n\t"
+		  "cbnz %2, 4b\n\t"
+		  "add v4.2d, v4.2d, v5.2d\n\t"
+		  "add v6.2d, v6.2d, v7.2d\n\t"
+		  "add v4.2d, v4.2d, v6.2d\n\t"
+		  "mov %2, v4.d[0]\n\t"
+		  "mov %3, v4.d[1]\n\t"
+		  "adcs %0, %0, %2\n\t"
+		  "adcs %0, %0, %3\n\t"
+		  "\n3:\n\t"
 		  /* Jump into unrolled (x4) main loop */
 		  "adr %2, 2f\n\t"
 		  "sub %2, %2, %5, lsl #3\n\t"
@@ -169,8 +208,8 @@ uint16_t tcpip_continue_chksum ( uint16_t sum, const void *data,
 		  : "+r" ( sum ), "+r" ( data ), "=&r" ( discard_low ),
 		    "=&r" ( discard_high )
 		  : "r" ( pre ), "r" ( first ), "r" ( end - post ),
-		    "r" ( post )
-		  : "cc" );
+		    "r" ( post ), "r" ( neon )
+		  : "v0", "v1", "v2", "v3", "v4", "v5", "v6", "v7", "cc" );
 
 	return sum;
 }
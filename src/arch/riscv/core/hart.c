@@ -65,15 +65,13 @@ static int hart_node ( unsigned int *offset ) {
 }
 
 /**
- * Check for supported extension
+ * Get ISA description
  *
- * @v ext		Extension name (including leading underscore)
+ * @v isa		ISA description to fill in
  * @ret rc		Return status code
  */
-int hart_supported ( const char *ext ) {
+static int hart_isa ( const char **isa ) {
 	unsigned int offset;
-	const char *isa;
-	const char *tmp;
 	int rc;
 
 	/* Find boot hart node */
@@ -81,12 +79,30 @@ int hart_supported ( const char *ext ) {
 		return rc;
 
 	/* Get ISA description */
-	isa = fdt_string ( &sysfdt, offset, "riscv,isa" );
-	if ( ! isa ) {
+	*isa = fdt_string ( &sysfdt, offset, "riscv,isa" );
+	if ( ! *isa ) {
 		DBGC ( colour, "HART could not identify ISA\n" );
 		return -ENOENT;
 	}
-	DBGC ( colour, "HART supports %s\n", isa );
+	DBGC ( colour, "HART supports %s\n", *isa );
+
+	return 0;
+}
+
+/**
+ * Check for supported extension
+ *
+ * @v ext		Extension name (including leading underscore)
+ * @ret rc		Return status code
+ */
+int hart_supported ( const char *ext ) {
+	const char *isa;
+	const char *tmp;
+	int rc;
+
+	/* Get ISA description */
+	if ( ( rc = hart_isa ( &isa ) ) != 0 )
+		return rc;
 
 	/* Check for presence of extension */
 	tmp = isa;
@@ -98,3 +114,40 @@ int hart_supported ( const char *ext ) {
 
 	return -ENOTSUP;
 }
+
+/**
+ * Check for supported single-letter extension
+ *
+ * @v ext		Extension letter (e.g. 'v')
+ * @ret rc		Return status code
+ *
+ * Single-letter extensions appear as a run of lowercase letters
+ * immediately following the "rv32"/"rv64" base ISA prefix, and are
+ * terminated by an underscore or by the first multi-letter extension
+ * (which must begin with 's', 'x', or 'z').
+ */
+int hart_supported_base ( char ext ) {
+	const char *isa;
+	const char *tmp;
+	int rc;
+
+	/* Get ISA description */
+	if ( ( rc = hart_isa ( &isa ) ) != 0 )
+		return rc;
+
+	/* Skip "rv" prefix and XLEN */
+	if ( strncmp ( isa, "rv", 2 ) != 0 )
+		return -ENOTSUP;
+	for ( tmp = ( isa + 2 ) ; ( ( *tmp >= '0' ) && ( *tmp <= '9' ) ) ;
+	      tmp++ ) {}
+
+	/* Check for presence of extension */
+	for ( ; ( ( *tmp >= 'a' ) && ( *tmp <= 'z' ) ) ; tmp++ ) {
+		if ( ( *tmp == 's' ) || ( *tmp == 'x' ) || ( *tmp == 'z' ) )
+			break;
+		if ( *tmp == ext )
+			return 0;
+	}
+
+	return -ENOTSUP;
+}
@@ -30,6 +30,67 @@
 FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 
 #include <string.h>
+#include <ipxe/rvv.h>
+
+/*
+ * The vector routines below use vector registers v8-v15 without
+ * declaring them as clobbered.  The compiler is never permitted to
+ * generate vector instructions (since the base build does not enable
+ * the vector extension), and all vector registers are caller-saved.
+ */
+
+/**
+ * Copy memory area using vector unit
+ *
+ * @v dest		Destination address
+ * @v src		Source address
+ * @v len		Length
+ */
+static void riscv_vector_memcpy ( void *dest, const void *src, size_t len ) {
+	size_t discard_vl;
+
+	__asm__ __volatile__ ( ".option push\n\t"
+			       ".option arch, +v\n\t"
+			       "\n1:\n\t"
+			       "vsetvli %2, %3, e8, m8, ta, ma\n\t"
+			       "vle8.v v8, (%1)\n\t"
+			       "vse8.v v8, (%0)\n\t"
+			       "add %0, %0, %2\n\t"
+			       "add %1, %1, %2\n\t"
+			       "sub %3, %3, %2\n\t"
+			       "bnez %3, 1b\n\t"
+			       ".option pop\n\t"
+			       : "+r" ( dest ), "+r" ( src ),
+				 "=&r" ( discard_vl ), "+r" ( len )
+			       : : "memory" );
+}
+
+/**
+ * Fill memory region using vector unit
+ *
+ * @v dest		Destination region
+ * @v len		Length
+ * @v character		Fill character
+ */
+static void riscv_vector_memset ( void *dest, size_t len, int character ) {
+	size_t discard_vl;
+
+	__asm__ __volatile__ ( ".option push\n\t"
+			       ".option arch, +v\n\t"
+			       "vsetvli %1, zero, e8, m8, ta, ma\n\t"
+			       "vmv.v.x v8, %3\n\t"
+			       "\n1:\n\t"
+			       "vsetvli %1, %2, e8, m8, ta, ma\n\t"
+			       "vse8.v v8, (%0)\n\t"
+			       "add %0, %0, %1\n\t"
+			       "sub %2, %2, %1\n\t"
+			       "bnez %2, 1b\n\t"
+			       ".option pop\n\t"
+			       : "+r" ( dest ), "=&r" ( discard_vl ),
+				 "+r" ( len )
+			       : "r" ( character )
+			       : "memory" );
+}
 
 /**
  * Copy memory area
@@ -45,6 +106,12 @@ void riscv_memcpy ( void *dest, const void *src, size_t len ) {
 	size_t len_post;
 	unsigned long discard_data;
 
+	/* Use vector unit if available and worthwhile */
+	if ( rvv_enabled && ( len >= RVV_MIN_LEN ) ) {
+		riscv_vector_memcpy ( dest, src, len );
+		return;
+	}
+
 	/* Calculate pre-aligned, aligned, and post-aligned lengths.
 	 * (Align on the destination address, on the assumption that
 	 * misaligned stores are likely to be more expensive than
@@ -114,6 +181,12 @@ void riscv_bzero ( void *dest, size_t len ) {
 	size_t len_mid;
 	size_t len_post;
 
+	/* Use vector unit if available and worthwhile */
+	if ( rvv_enabled && ( len >= RVV_MIN_LEN ) ) {
+		riscv_vector_memset ( dest, len, 0 );
+		return;
+	}
+
 	/* Calculate pre-aligned, aligned, and post-aligned lengths */
 	len_pre = ( ( sizeof ( unsigned long ) - ( ( intptr_t ) dest ) ) &
 		    ( sizeof ( unsigned long ) - 1 ) );
@@ -181,6 +254,12 @@ void riscv_memset ( void *dest, size_t len, int character ) {
 		return;
 	}
 
+	/* Use vector unit if available and worthwhile */
+	if ( rvv_enabled && ( len >= RVV_MIN_LEN ) ) {
+		riscv_vector_memset ( dest, len, character );
+		return;
+	}
+
 	/* Fill one byte at a time.  Calling memset() with a non-zero
 	 * value is relatively rare and unlikely to be
 	 * performance-critical.
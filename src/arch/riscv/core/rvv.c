@@ -0,0 +1,79 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+/** @file
+ *
+ * Vector extension (V)
+ *
+ * The vector unit is used only to accelerate bulk operations such as
+ * memory copies and checksums.  The vector register state is never
+ * preserved across calls, and iPXE is single-threaded with no
+ * interrupt handlers that touch vector state, so we need only to
+ * enable the vector unit once at startup.
+ */
+
+#include <ipxe/hart.h>
+#include <ipxe/init.h>
+#include <ipxe/rvv.h>
+
+/** Vector unit is enabled and usable */
+unsigned int rvv_enabled;
+
+/**
+ * Enable vector unit
+ *
+ * The sstatus.VS field is WARL and is hardwired to zero if the vector
+ * extension is not implemented.
+ */
+static void rvv_init ( void ) {
+	unsigned long sstatus;
+	int rc;
+
+	/* Check for vector extension */
+	if ( ( rc = hart_supported_base ( 'v' ) ) != 0 ) {
+		DBGC ( &rvv_enabled, "RVV not supported\n" );
+		return;
+	}
+
+	/* Enable vector unit */
+	__asm__ __volatile__ ( "csrs sstatus, %1\n\t"
+			       "csrr %0, sstatus\n\t"
+			       : "=r" ( sstatus )
+			       : "r" ( SSTATUS_VS_INITIAL ) );
+	if ( ! ( sstatus & SSTATUS_VS_MASK ) ) {
+		DBGC ( &rvv_enabled, "RVV could not enable vector unit\n" );
+		return;
+	}
+
+	/* Mark as usable */
+	DBGC ( &rvv_enabled, "RVV enabled\n" );
+	rvv_enabled = 1;
+}
+
+/** Vector unit initialisation function */
+struct init_fn rvv_init_fn __init_fn ( INIT_NORMAL ) = {
+	.name = "rvv",
+	.initialise = rvv_init,
+};
@@ -12,5 +12,6 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 extern unsigned long boot_hart;
 
 extern int hart_supported ( const char *ext );
+extern int hart_supported_base ( char ext );
 
 #endif /* _IPXE_HART_H */
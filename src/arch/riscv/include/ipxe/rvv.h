@@ -0,0 +1,27 @@
+#ifndef _IPXE_RVV_H
+#define _IPXE_RVV_H
+
+/** @file
+ *
+ * Vector extension (V)
+ *
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+/** Vector state field within sstatus */
+#define SSTATUS_VS_MASK 0x00000600UL
+
+/** Vector state "initial" value within sstatus */
+#define SSTATUS_VS_INITIAL 0x00000200UL
+
+/** Minimum length for which vector operations are worthwhile */
+#define RVV_MIN_LEN 64
+
+#ifndef ASSEMBLY
+
+extern unsigned int rvv_enabled;
+
+#endif /* ASSEMBLY */
+
+#endif /* _IPXE_RVV_H */
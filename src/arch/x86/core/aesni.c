@@ -0,0 +1,390 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+FILE_SECBOOT ( PERMITTED );
+
+/** @file
+ *
+ * AES-NI and PCLMULQDQ hardware acceleration
+ *
+ * The AES instructions operate directly upon the round keys as
+ * constructed by the generic AES key expansion (including the
+ * decryption keys, which are already in the form required by the
+ * "equivalent inverse cipher").
+ *
+ * GHASH is calculated using carry-less multiplication, operating on
+ * byte-reversed blocks with a pre-shifted hash key in order to avoid
+ * the need to shift each product.
+ *
+ * The compiler is prevented from using SSE registers (via -mno-sse),
+ * and so there is no need (or indeed any way) to declare them as
+ * clobbered.  We use only %xmm0-%xmm5, since the remaining registers
+ * are callee-saved in the UEFI calling convention and would not be
+ * preserved by any code that we return to.
+ *
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <byteswap.h>
+#include <ipxe/cpuid.h>
+#include <ipxe/aes.h>
+#include <ipxe/gcm.h>
+
+/** Required CPU features */
+#define AESNI_FEATURES ( CPUID_FEATURES_INTEL_ECX_AES |		\
+			 CPUID_FEATURES_INTEL_ECX_PCLMULQDQ |		\
+			 CPUID_FEATURES_INTEL_ECX_SSSE3 )
+
+/** Number of GCM blocks encrypted in parallel */
+#define AESNI_GCM_PARALLEL 4
+
+/** Byte reversal mask (for use with PSHUFB) */
+static const uint8_t aesni_bswap[16] = {
+	15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0
+};
+
+/**
+ * Check if hardware acceleration is usable
+ *
+ * @ret rc		Return status code
+ */
+static int aesni_probe ( void ) {
+	struct x86_features features;
+
+	/* Check for required instructions */
+	x86_features ( &features );
+	if ( ( features.intel.ecx & AESNI_FEATURES ) != AESNI_FEATURES )
+		return -ENOTSUP;
+
+	return 0;
+}
+
+/**
+ * Encrypt single block
+ *
+ * @v aes		AES context
+ * @v src		Data to encrypt
+ * @v dst		Buffer for encrypted data
+ */
+static void aesni_encrypt ( struct aes_context *aes, const void *src,
+			    void *dst ) {
+	const union aes_matrix *key = aes->encrypt.key;
+	unsigned int rounds = ( aes->rounds - 2 );
+
+	__asm__ __volatile__ ( "movdqu (%2), %%xmm0\n\t"
+			       "movdqu (%0), %%xmm1\n\t"
+			       "pxor %%xmm1, %%xmm0\n\t"
+			       "\n1:\n\t"
+			       "add $16, %0\n\t"
+			       "movdqu (%0), %%xmm1\n\t"
+			       "aesenc %%xmm1, %%xmm0\n\t"
+			       "dec %1\n\t"
+			       "jnz 1b\n\t"
+			       "movdqu 16(%0), %%xmm1\n\t"
+			       "aesenclast %%xmm1, %%xmm0\n\t"
+			       "movdqu %%xmm0, (%3)\n\t"
+			       : "+r" ( key ), "+r" ( rounds )
+			       : "r" ( src ), "r" ( dst )
+			       : "memory" );
+}
+
+/**
+ * Decrypt single block
+ *
+ * @v aes		AES context
+ * @v src		Data to decrypt
+ * @v dst		Buffer for decrypted data
+ */
+static void aesni_decrypt ( struct aes_context *aes, const void *src,
+			    void *dst ) {
+	const union aes_matrix *key = aes->decrypt.key;
+	unsigned int rounds = ( aes->rounds - 2 );
+
+	__asm__ __volatile__ ( "movdqu (%2), %%xmm0\n\t"
+			       "movdqu (%0), %%xmm1\n\t"
+			       "pxor %%xmm1, %%xmm0\n\t"
+			       "\n1:\n\t"
+			       "add $16, %0\n\t"
+			       "movdqu (%0), %%xmm1\n\t"
+			       "aesdec %%xmm1, %%xmm0\n\t"
+			       "dec %1\n\t"
+			       "jnz 1b\n\t"
+			       "movdqu 16(%0), %%xmm1\n\t"
+			       "aesdeclast %%xmm1, %%xmm0\n\t"
+			       "movdqu %%xmm0, (%3)\n\t"
+			       : "+r" ( key ), "+r" ( rounds )
+			       : "r" ( src ), "r" ( dst )
+			       : "memory" );
+}
+
+/**
+ * Encrypt/decrypt blocks in counter mode
+ *
+ * @v aes		AES context
+ * @v ctr		Counter blocks
+ * @v src		Input data
+ * @v dst		Output data
+ *
+ * Exactly AESNI_GCM_PARALLEL blocks are processed.
+ */
+static void aesni_ctr ( struct aes_context *aes, const union gcm_block *ctr,
+			const void *src, void *dst ) {
+	const union aes_matrix *key = aes->encrypt.key;
+	unsigned int rounds = ( aes->rounds - 2 );
+
+	build_assert ( AESNI_GCM_PARALLEL == 4 );
+	__asm__ __volatile__ ( "movdqu (%0), %%xmm4\n\t"
+			       "movdqu 0(%2), %%xmm0\n\t"
+			       "movdqu 16(%2), %%xmm1\n\t"
+			       "movdqu 32(%2), %%xmm2\n\t"
+			       "movdqu 48(%2), %%xmm3\n\t"
+			       "pxor %%xmm4, %%xmm0\n\t"
+			       "pxor %%xmm4, %%xmm1\n\t"
+			       "pxor %%xmm4, %%xmm2\n\t"
+			       "pxor %%xmm4, %%xmm3\n\t"
+			       "\n1:\n\t"
+			       "add $16, %0\n\t"
+			       "movdqu (%0), %%xmm4\n\t"
+			       "aesenc %%xmm4, %%xmm0\n\t"
+			       "aesenc %%xmm4, %%xmm1\n\t"
+			       "aesenc %%xmm4, %%xmm2\n\t"
+			       "aesenc %%xmm4, %%xmm3\n\t"
+			       "dec %1\n\t"
+			       "jnz 1b\n\t"
+			       "movdqu 16(%0), %%xmm4\n\t"
+			       "aesenclast %%xmm4, %%xmm0\n\t"
+			       "aesenclast %%xmm4, %%xmm1\n\t"
+			       "aesenclast %%xmm4, %%xmm2\n\t"
+			       "aesenclast %%xmm4, %%xmm3\n\t"
+			       "movdqu 0(%3), %%xmm4\n\t"
+			       "pxor %%xmm4, %%xmm0\n\t"
+			       "movdqu %%xmm0, 0(%4)\n\t"
+			       "movdqu 16(%3), %%xmm4\n\t"
+			       "pxor %%xmm4, %%xmm1\n\t"
+			       "movdqu %%xmm1, 16(%4)\n\t"
+			       "movdqu 32(%3), %%xmm4\n\t"
+			       "pxor %%xmm4, %%xmm2\n\t"
+			       "movdqu %%xmm2, 32(%4)\n\t"
+			       "movdqu 48(%3), %%xmm4\n\t"
+			       "pxor %%xmm4, %%xmm3\n\t"
+			       "movdqu %%xmm3, 48(%4)\n\t"
+			       : "+r" ( key ), "+r" ( rounds )
+			       : "r" ( ctr ), "r" ( src ), "r" ( dst )
+			       : "memory" );
+}
+
+/**
+ * Construct pre-shifted hash key
+ *
+ * @v key		Hash key
+ * @v shash		Pre-shifted hash key to fill in
+ *
+ * The hash key is multiplied by (x) in the byte-reversed
+ * representation, which compensates for the bit reflection inherent
+ * in carry-less multiplication of byte-reversed values.
+ */
+static void aesni_shash ( const union gcm_block *key, uint64_t *shash ) {
+	uint64_t hi;
+	uint64_t lo;
+
+	/* Multiply by (x) in the byte-reversed representation */
+	memcpy ( &hi, &key->byte[0], sizeof ( hi ) );
+	memcpy ( &lo, &key->byte[8], sizeof ( lo ) );
+	hi = be64_to_cpu ( hi );
+	lo = be64_to_cpu ( lo );
+	shash[0] = ( ( lo << 1 ) | ( hi >> 63 ) );
+	shash[1] = ( ( hi << 1 ) | ( lo >> 63 ) );
+	if ( hi >> 63 )
+		shash[1] ^= ( 0xc2ULL << 56 );
+}
+
+/**
+ * Update hash
+ *
+ * @v hash		Accumulated hash
+ * @v shash		Pre-shifted hash key
+ * @v data		Data blocks
+ * @v count		Number of blocks (must be non-zero)
+ */
+static void aesni_ghash ( union gcm_block *hash, const uint64_t *shash,
+			  const void *data, size_t count ) {
+
+	__asm__ __volatile__ ( "movdqu (%4), %%xmm5\n\t"
+			       "movdqu (%2), %%xmm0\n\t"
+			       "movdqu (%3), %%xmm1\n\t"
+			       "pshufb %%xmm5, %%xmm0\n\t"
+			       "\n1:\n\t"
+			       /* Add data block */
+			       "movdqu (%0), %%xmm2\n\t"
+			       "pshufb %%xmm5, %%xmm2\n\t"
+			       "pxor %%xmm2, %%xmm0\n\t"
+			       /* Multiply (using Karatsuba) */
+			       "movdqa %%xmm0, %%xmm2\n\t"
+			       "pshufd $0x4e, %%xmm0, %%xmm3\n\t"
+			       "pshufd $0x4e, %%xmm1, %%xmm4\n\t"
+			       "pxor %%xmm0, %%xmm3\n\t"
+			       "pxor %%xmm1, %%xmm4\n\t"
+			       "pclmulqdq $0x00, %%xmm1, %%xmm0\n\t"
+			       "pclmulqdq $0x11, %%xmm1, %%xmm2\n\t"
+			       "pclmulqdq $0x00, %%xmm4, %%xmm3\n\t"
+			       "pxor %%xmm0, %%xmm3\n\t"
+			       "pxor %%xmm2, %%xmm3\n\t"
+			       "movdqa %%xmm3, %%xmm4\n\t"
+			       "pslldq $8, %%xmm4\n\t"
+			       "psrldq $8, %%xmm3\n\t"
+			       "pxor %%xmm4, %%xmm0\n\t"
+			       "pxor %%xmm3, %%xmm2\n\t"
+			       /* Reduce (first phase) */
+			       "movdqa %%xmm0, %%xmm4\n\t"
+			       "psllq $1, %%xmm4\n\t"
+			       "pxor %%xmm0, %%xmm4\n\t"
+			       "psllq $5, %%xmm4\n\t"
+			       "pxor %%xmm0, %%xmm4\n\t"
+			       "psllq $57, %%xmm4\n\t"
+			       "movdqa %%xmm4, %%xmm3\n\t"
+			       "pslldq $8, %%xmm3\n\t"
+			       "psrldq $8, %%xmm4\n\t"
+			       "pxor %%xmm3, %%xmm0\n\t"
+			       "pxor %%xmm4, %%xmm2\n\t"
+			       /* Reduce (second phase) */
+			       "movdqa %%xmm0, %%xmm3\n\t"
+			       "psrlq $5, %%xmm3\n\t"
+			       "pxor %%xmm0, %%xmm3\n\t"
+			       "psrlq $1, %%xmm3\n\t"
+			       "pxor %%xmm0, %%xmm3\n\t"
+			       "psrlq $1, %%xmm3\n\t"
+			       "pxor %%xmm3, %%xmm2\n\t"
+			       "pxor %%xmm2, %%xmm0\n\t"
+			       /* Move to next block */
+			       "add $16, %0\n\t"
+			       "dec %1\n\t"
+			       "jnz 1b\n\t"
+			       "pshufb %%xmm5, %%xmm0\n\t"
+			       "movdqu %%xmm0, (%2)\n\t"
+			       : "+r" ( data ), "+r" ( count )
+			       : "r" ( hash ), "r" ( shash ),
+				 "r" ( aesni_bswap )
+			       : "memory" );
+}
+
+/**
+ * Multiply polynomial by hash key in situ
+ *
+ * @v key		Hash key
+ * @v poly		Multiplicand and result
+ */
+static void aesni_gcm_multiply ( const union gcm_block *key,
+				 union gcm_block *poly ) {
+	union gcm_block res;
+	uint64_t shash[2];
+
+	/* Calculate ( 0 + poly ) * key */
+	aesni_shash ( key, shash );
+	memset ( &res, 0, sizeof ( res ) );
+	aesni_ghash ( &res, shash, poly, 1 );
+	memcpy ( poly, &res, sizeof ( *poly ) );
+}
+
+/**
+ * Encrypt/decrypt whole blocks and update hash
+ *
+ * @v context		Context
+ * @v src		Input data
+ * @v dst		Output data
+ * @v count		Number of blocks
+ * @v encrypt		Perform encryption (rather than decryption)
+ */
+static void aesni_gcm_crypt ( struct gcm_context *context, const void *src,
+			      void *dst, size_t count, int encrypt ) {
+	struct aes_context *aes = ( ( void * ) context->raw_ctx );
+	union gcm_block ctr[AESNI_GCM_PARALLEL];
+	union gcm_block buf[AESNI_GCM_PARALLEL];
+	uint64_t shash[2];
+	unsigned int blocks;
+	unsigned int i;
+	uint32_t value;
+	size_t len;
+
+	/* Construct pre-shifted hash key and counter blocks */
+	aesni_shash ( &context->key, shash );
+	for ( i = 0 ; i < AESNI_GCM_PARALLEL ; i++ )
+		memcpy ( &ctr[i], &context->ctr, sizeof ( ctr[i] ) );
+	value = be32_to_cpu ( context->ctr.ctr.value );
+
+	/* Process blocks */
+	for ( ; count ; count -= blocks, src += len, dst += len ) {
+
+		/* Calculate number of blocks */
+		blocks = AESNI_GCM_PARALLEL;
+		if ( blocks > count )
+			blocks = count;
+		len = ( blocks * sizeof ( buf[0] ) );
+
+		/* Update counter blocks (modulo 2^32) */
+		for ( i = 0 ; i < AESNI_GCM_PARALLEL ; i++ )
+			ctr[i].ctr.value = cpu_to_be32 ( value + i + 1 );
+		value += blocks;
+
+		/* Update hash with ciphertext, if decrypting */
+		if ( ! encrypt )
+			aesni_ghash ( &context->hash, shash, src, blocks );
+
+		/* Encrypt/decrypt, using a bounce buffer for any
+		 * trailing partial group of blocks.
+		 */
+		if ( blocks == AESNI_GCM_PARALLEL ) {
+			aesni_ctr ( aes, ctr, src, dst );
+		} else {
+			memcpy ( buf, src, len );
+			aesni_ctr ( aes, ctr, buf, buf );
+			memcpy ( dst, buf, len );
+		}
+
+		/* Update hash with ciphertext, if encrypting */
+		if ( encrypt )
+			aesni_ghash ( &context->hash, shash, dst, blocks );
+	}
+
+	/* Update counter */
+	context->ctr.ctr.value = cpu_to_be32 ( value );
+}
+
+/** AES-NI accelerator */
+struct aes_accelerator aesni_accelerator __aes_accelerator = {
+	.name = "aesni",
+	.probe = aesni_probe,
+	.encrypt = aesni_encrypt,
+	.decrypt = aesni_decrypt,
+};
+
+/** AES-NI GCM accelerator */
+struct gcm_accelerator aesni_gcm_accelerator __gcm_accelerator = {
+	.name = "aesni",
+	.raw_cipher = &aes_algorithm,
+	.probe = aesni_probe,
+	.multiply = aesni_gcm_multiply,
+	.crypt = aesni_gcm_crypt,
+};
@@ -27,8 +27,10 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 #include <stdint.h>
 #include <ipxe/device.h>
 #include <ipxe/init.h>
+#include <ipxe/pci.h>
 #include <realmode.h>
 #include <usr/autoboot.h>
+#include <config/general.h>
 
 uint16_t __bss16 ( autoboot_busdevfn );
 #define autoboot_busdevfn __use_data16 ( autoboot_busdevfn )
@@ -38,8 +40,12 @@ uint16_t __bss16 ( autoboot_busdevfn );
  */
 static void pci_autoboot_init ( void ) {
 
-	if ( autoboot_busdevfn )
+	if ( autoboot_busdevfn ) {
 		set_autoboot_busloc ( BUS_TYPE_PCI, autoboot_busdevfn );
+#ifdef PROBE_ROM_FILTER
+		pci_probe_only ( autoboot_busdevfn );
+#endif
+	}
 }
 
 /** PCI autoboot device initialisation function */
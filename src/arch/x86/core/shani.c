@@ -0,0 +1,332 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+FILE_SECBOOT ( PERMITTED );
+
+/** @file
+ *
+ * SHA extensions hardware acceleration
+ *
+ * The SHA instructions operate upon the digest state held in a
+ * non-standard order across two registers, and so the state is
+ * rearranged before and after digesting each run of blocks.
+ *
+ * The compiler is prevented from using SSE registers (via -mno-sse),
+ * and so there is no need (or indeed any way) to declare them as
+ * clobbered.  We use only %xmm0-%xmm5, since the remaining registers
+ * are callee-saved in the UEFI calling convention and would not be
+ * preserved by any code that we return to.  With so few registers
+ * available, the message schedule is held in memory.
+ *
+ */
+
+#include <stdint.h>
+#include <errno.h>
+#include <byteswap.h>
+#include <ipxe/cpuid.h>
+#include <ipxe/sha1.h>
+#include <ipxe/sha256.h>
+
+/** Required CPU features */
+#define SHANI_FEATURES CPUID_FEATURES_INTEL_ECX_SSSE3
+
+/** Dword byte reversal mask (for use with PSHUFB) */
+static const uint8_t shani_bswap32[16] = {
+	3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12
+};
+
+/** Block byte reversal mask (for use with PSHUFB) */
+static const uint8_t shani_bswap128[16] = {
+	15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0
+};
+
+/** SHA-256 state as used by the SHA instructions */
+struct shani_sha256_state {
+	/** State variables F, E, B, and A */
+	uint32_t abef[4];
+	/** State variables H, G, D, and C */
+	uint32_t cdgh[4];
+} __attribute__ (( packed ));
+
+/** SHA-1 state as used by the SHA instructions */
+struct shani_sha1_state {
+	/** State variables D, C, B, and A */
+	uint32_t abcd[4];
+	/** State variable E (in the uppermost dword) */
+	uint32_t e[4];
+} __attribute__ (( packed ));
+
+/**
+ * Check if hardware acceleration is usable
+ *
+ * @ret rc		Return status code
+ */
+static int shani_probe ( void ) {
+	struct x86_features features;
+	uint32_t discard_a;
+	uint32_t discard_c;
+	uint32_t discard_d;
+	uint32_t ebx;
+	int rc;
+
+	/* Check for required instructions */
+	x86_features ( &features );
+	if ( ( features.intel.ecx & SHANI_FEATURES ) != SHANI_FEATURES )
+		return -ENOTSUP;
+	if ( ( rc = cpuid_supported ( CPUID_STRUCTURED_FEATURES ) ) != 0 )
+		return rc;
+	cpuid ( CPUID_STRUCTURED_FEATURES, 0, &discard_a, &ebx, &discard_c,
+		&discard_d );
+	if ( ! ( ebx & CPUID_STRUCTURED_FEATURES_EBX_SHA ) )
+		return -ENOTSUP;
+
+	return 0;
+}
+
+/**
+ * Perform four SHA-256 rounds
+ *
+ * On entry, %xmm3 holds the four message schedule words for these
+ * rounds.
+ */
+#define SHANI_SHA256_ROUNDS						\
+	"movdqu %%xmm3, (%[w])\n\t"					\
+	"movdqu (%[k]), %%xmm0\n\t"					\
+	"paddd %%xmm3, %%xmm0\n\t"					\
+	"sha256rnds2 %%xmm1, %%xmm2\n\t"				\
+	"pshufd $0x0e, %%xmm0, %%xmm0\n\t"				\
+	"sha256rnds2 %%xmm2, %%xmm1\n\t"				\
+	"add $16, %[k]\n\t"						\
+	"add $16, %[w]\n\t"
+
+/**
+ * Digest SHA-256 data blocks
+ *
+ * @v digest		Digest (in big-endian order)
+ * @v data		Data blocks
+ * @v count		Number of blocks
+ */
+static void shani_sha256_digest ( struct sha256_digest *digest,
+				  const void *data, size_t count ) {
+	struct shani_sha256_state state;
+	uint32_t w[SHA256_ROUNDS];
+	const uint32_t *k;
+	uint32_t *wp;
+
+	/* Construct state */
+	state.abef[0] = be32_to_cpu ( digest->h[5] );
+	state.abef[1] = be32_to_cpu ( digest->h[4] );
+	state.abef[2] = be32_to_cpu ( digest->h[1] );
+	state.abef[3] = be32_to_cpu ( digest->h[0] );
+	state.cdgh[0] = be32_to_cpu ( digest->h[7] );
+	state.cdgh[1] = be32_to_cpu ( digest->h[6] );
+	state.cdgh[2] = be32_to_cpu ( digest->h[3] );
+	state.cdgh[3] = be32_to_cpu ( digest->h[2] );
+
+	/* Digest each block */
+	while ( count-- ) {
+		k = sha256_k;
+		wp = w;
+		__asm__ __volatile__ ( "movdqu (%[bswap]), %%xmm4\n\t"
+				       "movdqu 0(%[state]), %%xmm1\n\t"
+				       "movdqu 16(%[state]), %%xmm2\n\t"
+				       /* Rounds 0-15 */
+				       ".rept 4\n\t"
+				       "movdqu (%[data]), %%xmm3\n\t"
+				       "pshufb %%xmm4, %%xmm3\n\t"
+				       "add $16, %[data]\n\t"
+				       SHANI_SHA256_ROUNDS
+				       ".endr\n\t"
+				       /* Rounds 16-63 */
+				       ".rept 12\n\t"
+				       "movdqu -64(%[w]), %%xmm3\n\t"
+				       "movdqu -48(%[w]), %%xmm5\n\t"
+				       "sha256msg1 %%xmm5, %%xmm3\n\t"
+				       "movdqu -16(%[w]), %%xmm4\n\t"
+				       "movdqu -32(%[w]), %%xmm5\n\t"
+				       "palignr $4, %%xmm5, %%xmm4\n\t"
+				       "paddd %%xmm4, %%xmm3\n\t"
+				       "movdqu -16(%[w]), %%xmm4\n\t"
+				       "sha256msg2 %%xmm4, %%xmm3\n\t"
+				       SHANI_SHA256_ROUNDS
+				       ".endr\n\t"
+				       /* Add to state */
+				       "movdqu 0(%[state]), %%xmm4\n\t"
+				       "paddd %%xmm4, %%xmm1\n\t"
+				       "movdqu %%xmm1, 0(%[state])\n\t"
+				       "movdqu 16(%[state]), %%xmm4\n\t"
+				       "paddd %%xmm4, %%xmm2\n\t"
+				       "movdqu %%xmm2, 16(%[state])\n\t"
+				       : [data] "+r" ( data ), [k] "+r" ( k ),
+					 [w] "+r" ( wp )
+				       : [state] "r" ( &state ),
+					 [bswap] "r" ( shani_bswap32 )
+				       : "memory" );
+	}
+
+	/* Update digest */
+	digest->h[0] = cpu_to_be32 ( state.abef[3] );
+	digest->h[1] = cpu_to_be32 ( state.abef[2] );
+	digest->h[2] = cpu_to_be32 ( state.cdgh[3] );
+	digest->h[3] = cpu_to_be32 ( state.cdgh[2] );
+	digest->h[4] = cpu_to_be32 ( state.abef[1] );
+	digest->h[5] = cpu_to_be32 ( state.abef[0] );
+	digest->h[6] = cpu_to_be32 ( state.cdgh[1] );
+	digest->h[7] = cpu_to_be32 ( state.cdgh[0] );
+}
+
+/**
+ * Load four SHA-1 message schedule words from data block
+ *
+ * On exit, %xmm3 holds the four message schedule words.
+ */
+#define SHANI_SHA1_LOAD							\
+	"movdqu (%[data]), %%xmm3\n\t"					\
+	"pshufb %%xmm4, %%xmm3\n\t"					\
+	"movdqu %%xmm3, (%[w])\n\t"					\
+	"add $16, %[data]\n\t"						\
+	"add $16, %[w]\n\t"
+
+/**
+ * Calculate four SHA-1 message schedule words
+ *
+ * On exit, %xmm3 holds the four message schedule words.
+ */
+#define SHANI_SHA1_SCHEDULE						\
+	"movdqu -64(%[w]), %%xmm3\n\t"					\
+	"movdqu -48(%[w]), %%xmm5\n\t"					\
+	"sha1msg1 %%xmm5, %%xmm3\n\t"					\
+	"movdqu -32(%[w]), %%xmm5\n\t"					\
+	"pxor %%xmm5, %%xmm3\n\t"					\
+	"movdqu -16(%[w]), %%xmm5\n\t"					\
+	"sha1msg2 %%xmm5, %%xmm3\n\t"					\
+	"movdqu %%xmm3, (%[w])\n\t"					\
+	"add $16, %[w]\n\t"
+
+/**
+ * Perform four SHA-1 rounds
+ *
+ * @v func		Round function and constant selector
+ *
+ * On entry, %xmm3 holds the four message schedule words for these
+ * rounds and %xmm2 holds the state as it was prior to the preceding
+ * four rounds.
+ */
+#define SHANI_SHA1_ROUNDS( func )					\
+	"sha1nexte %%xmm3, %%xmm2\n\t"					\
+	"movdqa %%xmm2, %%xmm1\n\t"					\
+	"movdqa %%xmm0, %%xmm2\n\t"					\
+	"sha1rnds4 $" #func ", %%xmm1, %%xmm0\n\t"
+
+/**
+ * Digest SHA-1 data blocks
+ *
+ * @v digest		Digest (in big-endian order)
+ * @v data		Data blocks
+ * @v count		Number of blocks
+ */
+static void shani_sha1_digest ( struct sha1_digest *digest,
+				const void *data, size_t count ) {
+	struct shani_sha1_state state;
+	uint32_t w[80];
+	uint32_t *wp;
+
+	/* Construct state */
+	state.abcd[0] = be32_to_cpu ( digest->h[3] );
+	state.abcd[1] = be32_to_cpu ( digest->h[2] );
+	state.abcd[2] = be32_to_cpu ( digest->h[1] );
+	state.abcd[3] = be32_to_cpu ( digest->h[0] );
+	state.e[0] = 0;
+	state.e[1] = 0;
+	state.e[2] = 0;
+	state.e[3] = be32_to_cpu ( digest->h[4] );
+
+	/* Digest each block */
+	while ( count-- ) {
+		wp = w;
+		__asm__ __volatile__ ( "movdqu (%[bswap]), %%xmm4\n\t"
+				       "movdqu 0(%[state]), %%xmm0\n\t"
+				       "movdqu 16(%[state]), %%xmm1\n\t"
+				       /* Rounds 0-3 */
+				       SHANI_SHA1_LOAD
+				       "paddd %%xmm3, %%xmm1\n\t"
+				       "movdqa %%xmm0, %%xmm2\n\t"
+				       "sha1rnds4 $0, %%xmm1, %%xmm0\n\t"
+				       /* Rounds 4-15 */
+				       ".rept 3\n\t"
+				       SHANI_SHA1_LOAD
+				       SHANI_SHA1_ROUNDS ( 0 )
+				       ".endr\n\t"
+				       /* Rounds 16-19 */
+				       SHANI_SHA1_SCHEDULE
+				       SHANI_SHA1_ROUNDS ( 0 )
+				       /* Rounds 20-39 */
+				       ".rept 5\n\t"
+				       SHANI_SHA1_SCHEDULE
+				       SHANI_SHA1_ROUNDS ( 1 )
+				       ".endr\n\t"
+				       /* Rounds 40-59 */
+				       ".rept 5\n\t"
+				       SHANI_SHA1_SCHEDULE
+				       SHANI_SHA1_ROUNDS ( 2 )
+				       ".endr\n\t"
+				       /* Rounds 60-79 */
+				       ".rept 5\n\t"
+				       SHANI_SHA1_SCHEDULE
+				       SHANI_SHA1_ROUNDS ( 3 )
+				       ".endr\n\t"
+				       /* Add to state */
+				       "movdqu 16(%[state]), %%xmm1\n\t"
+				       "sha1nexte %%xmm1, %%xmm2\n\t"
+				       "movdqu %%xmm2, 16(%[state])\n\t"
+				       "movdqu 0(%[state]), %%xmm1\n\t"
+				       "paddd %%xmm1, %%xmm0\n\t"
+				       "movdqu %%xmm0, 0(%[state])\n\t"
+				       : [data] "+r" ( data ), [w] "+r" ( wp )
+				       : [state] "r" ( &state ),
+					 [bswap] "r" ( shani_bswap128 )
+				       : "memory" );
+	}
+
+	/* Update digest */
+	digest->h[0] = cpu_to_be32 ( state.abcd[3] );
+	digest->h[1] = cpu_to_be32 ( state.abcd[2] );
+	digest->h[2] = cpu_to_be32 ( state.abcd[1] );
+	digest->h[3] = cpu_to_be32 ( state.abcd[0] );
+	digest->h[4] = cpu_to_be32 ( state.e[3] );
+}
+
+/** SHA-256 hardware accelerator */
+struct sha256_accelerator shani_sha256_accelerator __sha256_accelerator = {
+	.name = "shani",
+	.probe = shani_probe,
+	.digest = shani_sha256_digest,
+};
+
+/** SHA-1 hardware accelerator */
+struct sha1_accelerator shani_sha1_accelerator __sha1_accelerator = {
+	.name = "shani",
+	.probe = shani_probe,
+	.digest = shani_sha1_digest,
+};
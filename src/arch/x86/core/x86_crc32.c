@@ -0,0 +1,348 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+FILE_SECBOOT ( PERMITTED );
+
+/** @file
+ *
+ * x86 CRC32 hardware acceleration
+ *
+ * CRC32C is calculated using the SSE4.2 CRC32 instruction, which
+ * implements the Castagnoli polynomial directly.  The instruction
+ * has a latency of several cycles but can be issued once per cycle,
+ * so large inputs are processed as three interleaved streams of
+ * fixed-length blocks.  The three partial CRCs are then combined by
+ * shifting each over the length of the following blocks, using
+ * lookup tables for the (linear) operation of appending a block of
+ * zeroes.
+ *
+ * CRC32 is calculated by using carry-less multiplication to fold
+ * the data four 128-bit blocks at a time, followed by a Barrett
+ * reduction to obtain the final 32-bit value.  The folding constants
+ * are powers of (x) modulo the bit-reversed IEEE 802.3 polynomial,
+ * as described in Intel's white paper "Fast CRC Computation for
+ * Generic Polynomials Using PCLMULQDQ Instruction".
+ *
+ * As with the AES-NI code, we use only %xmm0-%xmm5 since the
+ * remaining registers are callee-saved in the UEFI calling
+ * convention.
+ *
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <ipxe/cpuid.h>
+#include <ipxe/crc32.h>
+
+/** Length of each block within an interleaved CRC32C triplet */
+#define X86_CRC32C_BLOCK_LEN 256
+
+/** Lookup tables for appending a block of zeroes to a CRC32C */
+static uint32_t x86_crc32c_shift_table[4][256];
+
+/** Minimum length of data for which carry-less multiplication is used */
+#define X86_CRC32_PCLMUL_MIN_LEN 64
+
+/** Folding and reduction constants for CRC32 */
+static const uint64_t x86_crc32_constants[] = {
+	/* Fold by four blocks: x^(512+32) and x^(512-32) modulo P */
+	0x154442bd4ULL, 0x1c6e41596ULL,
+	/* Fold by one block: x^(128+32) and x^(128-32) modulo P */
+	0x1751997d0ULL, 0x0ccaa009eULL,
+	/* Fold 64 bits to 32 bits: x^64 modulo P */
+	0x163cd6124ULL, 0,
+	/* Low 32-bit mask */
+	0xffffffffULL, 0,
+	/* Barrett reduction: P and floor(x^64/P), bit-reversed */
+	0x1db710641ULL, 0x1f7011641ULL,
+};
+
+/**
+ * Update CRC32C word using SSE4.2 CRC32 instruction
+ *
+ * @v crc		CRC to update
+ * @v data		Data to checksum
+ * @ret crc		Updated CRC
+ */
+static inline __attribute__ (( always_inline )) unsigned long
+x86_crc32c_word ( unsigned long crc, const void *data ) {
+	unsigned long word;
+
+	memcpy ( &word, data, sizeof ( word ) );
+	__asm__ ( "crc32%z1 %1, %0" : "+r" ( crc ) : "r" ( word ) );
+	return crc;
+}
+
+/**
+ * Append a block of zeroes to CRC32C
+ *
+ * @v crc		CRC
+ * @ret crc		CRC with X86_CRC32C_BLOCK_LEN zero bytes appended
+ */
+static inline __attribute__ (( always_inline )) uint32_t
+x86_crc32c_shift ( uint32_t crc ) {
+
+	return ( x86_crc32c_shift_table[0][ ( crc >> 0 ) & 0xff ] ^
+		 x86_crc32c_shift_table[1][ ( crc >> 8 ) & 0xff ] ^
+		 x86_crc32c_shift_table[2][ ( crc >> 16 ) & 0xff ] ^
+		 x86_crc32c_shift_table[3][ ( crc >> 24 ) & 0xff ] );
+}
+
+/**
+ * Check if SSE4.2 CRC32 instruction is usable
+ *
+ * @ret rc		Return status code
+ */
+static int x86_crc32c_probe ( void ) {
+	static const unsigned long zero;
+	struct x86_features features;
+	unsigned long value;
+	unsigned int byte;
+	unsigned int i;
+	unsigned int j;
+
+	/* Check for SSE4.2 */
+	x86_features ( &features );
+	if ( ! ( features.intel.ecx & CPUID_FEATURES_INTEL_ECX_SSE4_2 ) )
+		return -ENOTSUP;
+
+	/* Construct tables for appending a block of zeroes */
+	for ( byte = 0 ; byte < 4 ; byte++ ) {
+		for ( i = 0 ; i < 256 ; i++ ) {
+			value = ( ( ( uint32_t ) i ) << ( 8 * byte ) );
+			for ( j = 0 ; j < X86_CRC32C_BLOCK_LEN ;
+			      j += sizeof ( zero ) ) {
+				value = x86_crc32c_word ( value, &zero );
+			}
+			x86_crc32c_shift_table[byte][i] = value;
+		}
+	}
+
+	return 0;
+}
+
+/**
+ * Update CRC32C using SSE4.2 CRC32 instruction
+ *
+ * @v crc		CRC to update
+ * @v data		Data to checksum
+ * @v len		Length of data
+ * @ret used		Length of data processed
+ */
+static size_t x86_crc32c_update ( uint32_t *crc, const void *data,
+				  size_t len ) {
+	unsigned long value = *crc;
+	unsigned long value1;
+	unsigned long value2;
+	const void *block;
+	size_t used = 0;
+	size_t offset;
+
+	/* Process triplets of blocks as three independent streams */
+	while ( ( len - used ) >= ( 3 * X86_CRC32C_BLOCK_LEN ) ) {
+		block = ( data + used );
+		value1 = 0;
+		value2 = 0;
+		for ( offset = 0 ; offset < X86_CRC32C_BLOCK_LEN ;
+		      offset += sizeof ( value ) ) {
+			value = x86_crc32c_word ( value, ( block + offset ) );
+			value1 = x86_crc32c_word ( value1,
+						   ( block + offset +
+						     X86_CRC32C_BLOCK_LEN ) );
+			value2 = x86_crc32c_word ( value2,
+						   ( block + offset +
+						     ( 2 * X86_CRC32C_BLOCK_LEN ) ));
+		}
+		value = ( x86_crc32c_shift ( x86_crc32c_shift ( value ) ^
+					     value1 ) ^ value2 );
+		used += ( 3 * X86_CRC32C_BLOCK_LEN );
+	}
+
+	/* Process remaining whole words */
+	for ( ; ( len - used ) >= sizeof ( value ) ;
+	      used += sizeof ( value ) ) {
+		value = x86_crc32c_word ( value, ( data + used ) );
+	}
+	*crc = value;
+
+	return used;
+}
+
+/**
+ * Check if carry-less multiplication is usable
+ *
+ * @ret rc		Return status code
+ */
+static int x86_crc32_probe ( void ) {
+	struct x86_features features;
+
+	/* Check for PCLMULQDQ */
+	x86_features ( &features );
+	if ( ! ( features.intel.ecx & CPUID_FEATURES_INTEL_ECX_PCLMULQDQ ) )
+		return -ENOTSUP;
+
+	return 0;
+}
+
+/**
+ * Update CRC32 using carry-less multiplication
+ *
+ * @v crc		CRC to update
+ * @v data		Data to checksum
+ * @v len		Length of data
+ * @ret used		Length of data processed
+ */
+static size_t x86_crc32_update ( uint32_t *crc, const void *data,
+				 size_t len ) {
+	uint32_t value = *crc;
+	size_t used;
+	size_t remaining;
+
+	/* Process only whole blocks, and only if worthwhile */
+	if ( len < X86_CRC32_PCLMUL_MIN_LEN )
+		return 0;
+	used = ( len & ~( ( size_t ) 0x0f ) );
+	remaining = used;
+
+	__asm__ __volatile__ ( /* Load first four blocks and add CRC */
+			       "movd %2, %%xmm0\n\t"
+			       "movdqu 0(%0), %%xmm1\n\t"
+			       "movdqu 16(%0), %%xmm2\n\t"
+			       "movdqu 32(%0), %%xmm3\n\t"
+			       "movdqu 48(%0), %%xmm4\n\t"
+			       "pxor %%xmm0, %%xmm1\n\t"
+			       "add $64, %0\n\t"
+			       "sub $64, %1\n\t"
+			       /* Fold by four blocks */
+			       "movdqu 0(%3), %%xmm0\n\t"
+			       "cmp $64, %1\n\t"
+			       "jb 2f\n\t"
+			       "\n1:\n\t"
+			       "movdqa %%xmm1, %%xmm5\n\t"
+			       "pclmulqdq $0x00, %%xmm0, %%xmm1\n\t"
+			       "pclmulqdq $0x11, %%xmm0, %%xmm5\n\t"
+			       "pxor %%xmm5, %%xmm1\n\t"
+			       "movdqu 0(%0), %%xmm5\n\t"
+			       "pxor %%xmm5, %%xmm1\n\t"
+			       "movdqa %%xmm2, %%xmm5\n\t"
+			       "pclmulqdq $0x00, %%xmm0, %%xmm2\n\t"
+			       "pclmulqdq $0x11, %%xmm0, %%xmm5\n\t"
+			       "pxor %%xmm5, %%xmm2\n\t"
+			       "movdqu 16(%0), %%xmm5\n\t"
+			       "pxor %%xmm5, %%xmm2\n\t"
+			       "movdqa %%xmm3, %%xmm5\n\t"
+			       "pclmulqdq $0x00, %%xmm0, %%xmm3\n\t"
+			       "pclmulqdq $0x11, %%xmm0, %%xmm5\n\t"
+			       "pxor %%xmm5, %%xmm3\n\t"
+			       "movdqu 32(%0), %%xmm5\n\t"
+			       "pxor %%xmm5, %%xmm3\n\t"
+			       "movdqa %%xmm4, %%xmm5\n\t"
+			       "pclmulqdq $0x00, %%xmm0, %%xmm4\n\t"
+			       "pclmulqdq $0x11, %%xmm0, %%xmm5\n\t"
+			       "pxor %%xmm5, %%xmm4\n\t"
+			       "movdqu 48(%0), %%xmm5\n\t"
+			       "pxor %%xmm5, %%xmm4\n\t"
+			       "add $64, %0\n\t"
+			       "sub $64, %1\n\t"
+			       "cmp $64, %1\n\t"
+			       "jae 1b\n\t"
+			       /* Fold four blocks into one block */
+			       "\n2:\n\t"
+			       "movdqu 16(%3), %%xmm0\n\t"
+			       "movdqa %%xmm1, %%xmm5\n\t"
+			       "pclmulqdq $0x00, %%xmm0, %%xmm1\n\t"
+			       "pclmulqdq $0x11, %%xmm0, %%xmm5\n\t"
+			       "pxor %%xmm5, %%xmm1\n\t"
+			       "pxor %%xmm2, %%xmm1\n\t"
+			       "movdqa %%xmm1, %%xmm5\n\t"
+			       "pclmulqdq $0x00, %%xmm0, %%xmm1\n\t"
+			       "pclmulqdq $0x11, %%xmm0, %%xmm5\n\t"
+			       "pxor %%xmm5, %%xmm1\n\t"
+			       "pxor %%xmm3, %%xmm1\n\t"
+			       "movdqa %%xmm1, %%xmm5\n\t"
+			       "pclmulqdq $0x00, %%xmm0, %%xmm1\n\t"
+			       "pclmulqdq $0x11, %%xmm0, %%xmm5\n\t"
+			       "pxor %%xmm5, %%xmm1\n\t"
+			       "pxor %%xmm4, %%xmm1\n\t"
+			       /* Fold by one block */
+			       "test %1, %1\n\t"
+			       "jz 4f\n\t"
+			       "\n3:\n\t"
+			       "movdqa %%xmm1, %%xmm5\n\t"
+			       "pclmulqdq $0x00, %%xmm0, %%xmm1\n\t"
+			       "pclmulqdq $0x11, %%xmm0, %%xmm5\n\t"
+			       "pxor %%xmm5, %%xmm1\n\t"
+			       "movdqu 0(%0), %%xmm5\n\t"
+			       "pxor %%xmm5, %%xmm1\n\t"
+			       "add $16, %0\n\t"
+			       "sub $16, %1\n\t"
+			       "jnz 3b\n\t"
+			       /* Fold 128 bits to 64 bits */
+			       "\n4:\n\t"
+			       "pclmulqdq $0x01, %%xmm1, %%xmm0\n\t"
+			       "psrldq $8, %%xmm1\n\t"
+			       "pxor %%xmm0, %%xmm1\n\t"
+			       /* Fold 64 bits to 32 bits */
+			       "movdqa %%xmm1, %%xmm2\n\t"
+			       "movdqu 32(%3), %%xmm0\n\t"
+			       "movdqu 48(%3), %%xmm3\n\t"
+			       "psrldq $4, %%xmm2\n\t"
+			       "pand %%xmm3, %%xmm1\n\t"
+			       "pclmulqdq $0x00, %%xmm0, %%xmm1\n\t"
+			       "pxor %%xmm2, %%xmm1\n\t"
+			       /* Barrett reduction to 32 bits */
+			       "movdqu 64(%3), %%xmm0\n\t"
+			       "movdqa %%xmm1, %%xmm2\n\t"
+			       "pand %%xmm3, %%xmm1\n\t"
+			       "pclmulqdq $0x10, %%xmm0, %%xmm1\n\t"
+			       "pand %%xmm3, %%xmm1\n\t"
+			       "pclmulqdq $0x00, %%xmm0, %%xmm1\n\t"
+			       "pxor %%xmm2, %%xmm1\n\t"
+			       "psrldq $4, %%xmm1\n\t"
+			       "movd %%xmm1, %2\n\t"
+			       : "+r" ( data ), "+r" ( remaining ),
+				 "+r" ( value )
+			       : "r" ( x86_crc32_constants )
+			       : "memory" );
+	*crc = value;
+
+	return used;
+}
+
+/** SSE4.2 CRC32C accelerator */
+struct crc32_accelerator x86_crc32c_accelerator __crc32_accelerator = {
+	.name = "sse4.2",
+	.poly = CRC32C_POLY,
+	.probe = x86_crc32c_probe,
+	.update = x86_crc32c_update,
+};
+
+/** PCLMULQDQ CRC32 accelerator */
+struct crc32_accelerator x86_crc32_accelerator __crc32_accelerator = {
+	.name = "pclmulqdq",
+	.poly = CRC32_POLY,
+	.probe = x86_crc32_probe,
+	.update = x86_crc32_update,
+};
@@ -30,8 +30,10 @@
 FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 FILE_SECBOOT ( PERMITTED );
 
+#include <stdint.h>
 #include <string.h>
 #include <config/defaults.h>
+#include <ipxe/cpuid.h>
 
 /* Use generic_memcpy_reverse() if we cannot safely set the direction flag */
 #ifdef UNSAFE_STD
@@ -40,6 +42,167 @@ FILE_SECBOOT ( PERMITTED );
 #define USE_GENERIC_MEMCPY_REVERSE 0
 #endif
 
+#ifdef __x86_64__
+
+/** String operation features have been probed */
+#define X86_STRING_PROBED 0x0001
+
+/** Enhanced REP MOVSB is supported */
+#define X86_STRING_ERMS 0x0002
+
+/** Fast short REP MOVSB is supported */
+#define X86_STRING_FSRM 0x0004
+
+/** Maximum length for small copies */
+#define X86_STRING_SMALL_MAX 128
+
+/** An unaligned 64-bit value */
+typedef uint64_t x86_string_u64_t __attribute__ (( may_alias, aligned ( 1 ) ));
+
+/** An unaligned 32-bit value */
+typedef uint32_t x86_string_u32_t __attribute__ (( may_alias, aligned ( 1 ) ));
+
+/** An unaligned 16-bit value */
+typedef uint16_t x86_string_u16_t __attribute__ (( may_alias, aligned ( 1 ) ));
+
+/** String operation features */
+static unsigned int x86_string_features;
+
+/**
+ * Get string operation features
+ *
+ * @ret features	String operation features
+ */
+static unsigned int x86_string_probe ( void ) {
+	uint32_t discard_a;
+	uint32_t discard_c;
+	uint32_t ebx;
+	uint32_t edx;
+
+	/* Use cached features, if available */
+	if ( x86_string_features )
+		return x86_string_features;
+
+	/* Mark as probed before doing anything that might itself
+	 * require memcpy() (such as debug output).
+	 */
+	x86_string_features = X86_STRING_PROBED;
+	if ( cpuid_supported ( CPUID_STRUCTURED_FEATURES ) != 0 )
+		return x86_string_features;
+	cpuid ( CPUID_STRUCTURED_FEATURES, 0, &discard_a, &ebx, &discard_c,
+		&edx );
+	if ( ebx & CPUID_STRUCTURED_FEATURES_EBX_ERMS )
+		x86_string_features |= X86_STRING_ERMS;
+	if ( edx & CPUID_STRUCTURED_FEATURES_EDX_FSRM )
+		x86_string_features |= X86_STRING_FSRM;
+
+	return x86_string_features;
+}
+
+/**
+ * Copy small memory area
+ *
+ * @v dest		Destination address
+ * @v src		Source address
+ * @v len		Length (at most X86_STRING_SMALL_MAX)
+ *
+ * Copies are performed using (possibly overlapping) unaligned head
+ * and tail moves.  All source data for each move is loaded before
+ * being stored, so that this remains safe for use by memmove() when
+ * the destination lies below the source.
+ */
+static inline __attribute__ (( always_inline )) void
+x86_memcpy_small ( void *dest, const void *src, size_t len ) {
+	const x86_string_u64_t *src64 = src;
+	x86_string_u64_t *dest64 = dest;
+	uint64_t head[2];
+	uint64_t tail[2];
+	size_t offset;
+
+	if ( len >= 16 ) {
+		tail[0] = *( ( const x86_string_u64_t * ) ( src + len - 16 ) );
+		tail[1] = *( ( const x86_string_u64_t * ) ( src + len - 8 ) );
+		for ( offset = 0 ; ( offset + 16 ) <= len ; offset += 16 ) {
+			head[0] = src64[0];
+			head[1] = src64[1];
+			dest64[0] = head[0];
+			dest64[1] = head[1];
+			src64 += 2;
+			dest64 += 2;
+		}
+		*( ( x86_string_u64_t * ) ( dest + len - 16 ) ) = tail[0];
+		*( ( x86_string_u64_t * ) ( dest + len - 8 ) ) = tail[1];
+	} else if ( len >= 8 ) {
+		head[0] = *( ( const x86_string_u64_t * ) src );
+		tail[0] = *( ( const x86_string_u64_t * ) ( src + len - 8 ) );
+		*( ( x86_string_u64_t * ) dest ) = head[0];
+		*( ( x86_string_u64_t * ) ( dest + len - 8 ) ) = tail[0];
+	} else if ( len >= 4 ) {
+		head[0] = *( ( const x86_string_u32_t * ) src );
+		tail[0] = *( ( const x86_string_u32_t * ) ( src + len - 4 ) );
+		*( ( x86_string_u32_t * ) dest ) = head[0];
+		*( ( x86_string_u32_t * ) ( dest + len - 4 ) ) = tail[0];
+	} else if ( len >= 2 ) {
+		head[0] = *( ( const x86_string_u16_t * ) src );
+		tail[0] = *( ( const x86_string_u16_t * ) ( src + len - 2 ) );
+		*( ( x86_string_u16_t * ) dest ) = head[0];
+		*( ( x86_string_u16_t * ) ( dest + len - 2 ) ) = tail[0];
+	} else if ( len ) {
+		*( ( uint8_t * ) dest ) = *( ( const uint8_t * ) src );
+	}
+}
+
+/**
+ * Copy memory area
+ *
+ * @v dest		Destination address
+ * @v src		Source address
+ * @v len		Length
+ * @ret dest		Destination address
+ */
+void * __attribute__ (( noinline )) __memcpy ( void *dest, const void *src,
+					       size_t len ) {
+	unsigned int features;
+	void *rdi = dest;
+	const void *rsi = src;
+	long discard_rcx;
+
+	/* Copy up to 16 bytes using head and tail moves */
+	if ( len <= 16 ) {
+		x86_memcpy_small ( dest, src, len );
+		return dest;
+	}
+
+	/* Short REP MOVSB is fast on CPUs supporting FSRM, and REP
+	 * MOVSB is fast for any length on CPUs supporting ERMS.
+	 * Otherwise, use unrolled moves for small copies and REP
+	 * MOVSQ for larger copies.
+	 */
+	features = x86_string_probe();
+	if ( ( len <= X86_STRING_SMALL_MAX ) &&
+	     ! ( features & X86_STRING_FSRM ) ) {
+		x86_memcpy_small ( dest, src, len );
+		return dest;
+	}
+	if ( ! ( features & X86_STRING_ERMS ) ) {
+		__asm__ __volatile__ ( "rep movsq"
+				       : "=&D" ( rdi ), "=&S" ( rsi ),
+					 "=&c" ( discard_rcx )
+				       : "0" ( rdi ), "1" ( rsi ),
+					 "2" ( len >> 3 )
+				       : "memory" );
+		len &= 7;
+	}
+	__asm__ __volatile__ ( "rep movsb"
+			       : "=&D" ( rdi ), "=&S" ( rsi ),
+				 "=&c" ( discard_rcx )
+			       : "0" ( rdi ), "1" ( rsi ), "2" ( len )
+			       : "memory" );
+	return dest;
+}
+
+#else /* __x86_64__ */
+
 /**
  * Copy memory area
  *
@@ -71,6 +234,8 @@ void * __attribute__ (( noinline )) __memcpy ( void *dest, const void *src,
 	return dest;
 }
 
+#endif /* __x86_64__ */
+
 /**
  * Copy memory area backwards
  *
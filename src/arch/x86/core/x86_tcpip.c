@@ -31,20 +31,21 @@ FILE_SECBOOT ( PERMITTED );
  */
 
 #include <limits.h>
+#include <ipxe/cpuid.h>
 #include <ipxe/tcpip.h>
 
 extern char x86_tcpip_loop_end[];
 
 /**
- * Calculate continued TCP/IP checkum
+ * Calculate continued TCP/IP checkum using general-purpose registers
  *
  * @v partial		Checksum of already-summed data, in network byte order
  * @v data		Data buffer
  * @v len		Length of data buffer
  * @ret cksum		Updated checksum, in network byte order
  */
-uint16_t tcpip_continue_chksum ( uint16_t partial, const void *data,
-				 size_t len ) {
+static inline __attribute__ (( always_inline )) uint16_t
+x86_tcpip_chksum ( uint16_t partial, const void *data, size_t len ) {
 	unsigned long sum = ( ( ~partial ) & 0xffff );
 	unsigned long initial_word_count;
 	unsigned long loop_count;
@@ -172,3 +173,235 @@ uint16_t tcpip_continue_chksum ( uint16_t partial, const void *data,
 
 	return ( ~sum & 0xffff );
 }
+
+#ifdef __x86_64__
+
+/*
+ * The SIMD checksum loops accumulate each 32-bit word of data into a
+ * 64-bit lane, and sum the lanes only once the loop is complete.
+ * This avoids any need to propagate carries within the loop, and
+ * cannot overflow for any input shorter than 16GB.
+ *
+ * The compiler is prevented from using SSE registers (via -mno-sse),
+ * and so there is no need (or indeed any way) to declare them as
+ * clobbered.  As with the AES-NI code, we use only %xmm0-%xmm5 (or
+ * %ymm0-%ymm5), since the remaining registers are callee-saved in
+ * the UEFI calling convention.
+ */
+
+/** Checksum SIMD features have been probed */
+#define X86_TCPIP_PROBED 0x0001
+
+/** SSE2 instructions are usable */
+#define X86_TCPIP_SSE2 0x0002
+
+/** AVX2 instructions are usable */
+#define X86_TCPIP_AVX2 0x0004
+
+/** Length of data processed by each iteration of a SIMD loop */
+#define X86_TCPIP_SIMD_BLOCK 64
+
+/** Minimum length of data for which the SIMD loops are used */
+#define X86_TCPIP_SIMD_MIN_LEN 256
+
+/** Extended control register mask for SSE and AVX state */
+#define X86_XCR0_SSE_AVX 0x00000006UL
+
+/** Checksum SIMD features */
+static unsigned int x86_tcpip_features;
+
+/**
+ * Get checksum SIMD features
+ *
+ * @ret features	Checksum SIMD features
+ *
+ * SSE instructions will fault unless the operating system has set
+ * CR4.OSFXSR, which we cannot check without privilege.  We therefore
+ * use SSE2 only on platforms that guarantee its availability.  AVX
+ * instructions require only that the operating system has enabled
+ * the relevant state via XCR0, which can be checked directly.
+ */
+static unsigned int x86_tcpip_probe ( void ) {
+	struct x86_features features;
+	uint32_t discard_a;
+	uint32_t discard_c;
+	uint32_t discard_d;
+	uint32_t ebx;
+	uint32_t xcr0;
+
+	/* Use cached features, if available */
+	if ( x86_tcpip_features )
+		return x86_tcpip_features;
+	x86_tcpip_features = X86_TCPIP_PROBED;
+
+	/* SSE2 is architecturally guaranteed on x86_64 */
+#if defined ( PLATFORM_efi ) || defined ( PLATFORM_linux )
+	x86_tcpip_features |= X86_TCPIP_SSE2;
+#endif
+
+	/* Check for AVX2 with operating system support */
+	x86_features ( &features );
+	if ( ! ( features.intel.ecx & CPUID_FEATURES_INTEL_ECX_OSXSAVE ) )
+		return x86_tcpip_features;
+	if ( ! ( features.intel.ecx & CPUID_FEATURES_INTEL_ECX_AVX ) )
+		return x86_tcpip_features;
+	if ( cpuid_supported ( CPUID_STRUCTURED_FEATURES ) != 0 )
+		return x86_tcpip_features;
+	cpuid ( CPUID_STRUCTURED_FEATURES, 0, &discard_a, &ebx, &discard_c,
+		&discard_d );
+	if ( ! ( ebx & CPUID_STRUCTURED_FEATURES_EBX_AVX2 ) )
+		return x86_tcpip_features;
+	__asm__ ( "xgetbv" : "=a" ( xcr0 ), "=d" ( discard_d ) : "c" ( 0 ) );
+	if ( ( xcr0 & X86_XCR0_SSE_AVX ) != X86_XCR0_SSE_AVX )
+		return x86_tcpip_features;
+	x86_tcpip_features |= X86_TCPIP_AVX2;
+
+	return x86_tcpip_features;
+}
+
+/**
+ * Sum 32-bit words using SSE2
+ *
+ * @v data		Data buffer
+ * @v count		Number of blocks
+ * @ret sum		Sum of 32-bit words
+ */
+static uint64_t x86_tcpip_sum_sse2 ( const void *data, size_t count ) {
+	uint64_t sum;
+
+#define X86_TCPIP_SSE2_STEP( offset )					\
+	"movdqu " #offset "(%1), %%xmm2\n\t"				\
+	"movdqa %%xmm2, %%xmm3\n\t"					\
+	"punpckldq %%xmm5, %%xmm2\n\t"				\
+	"punpckhdq %%xmm5, %%xmm3\n\t"				\
+	"paddq %%xmm2, %%xmm0\n\t"					\
+	"paddq %%xmm3, %%xmm1\n\t"
+
+	__asm__ ( "pxor %%xmm0, %%xmm0\n\t"
+		  "pxor %%xmm1, %%xmm1\n\t"
+		  "pxor %%xmm5, %%xmm5\n\t"
+		  "\n1:\n\t"
+		  X86_TCPIP_SSE2_STEP ( 0 )
+		  X86_TCPIP_SSE2_STEP ( 16 )
+		  X86_TCPIP_SSE2_STEP ( 32 )
+		  X86_TCPIP_SSE2_STEP ( 48 )
+		  "add $64, %1\n\t"
+		  "dec %2\n\t"
+		  "jnz 1b\n\t"
+		  "paddq %%xmm1, %%xmm0\n\t"
+		  "pshufd $0x4e, %%xmm0, %%xmm1\n\t"
+		  "paddq %%xmm1, %%xmm0\n\t"
+		  "movq %%xmm0, %0\n\t"
+		  : "=r" ( sum ), "+r" ( data ), "+r" ( count )
+		  : "m" ( *( const char ( * )[ count * X86_TCPIP_SIMD_BLOCK ] )
+			  data ) );
+
+	return sum;
+}
+
+/**
+ * Sum 32-bit words using AVX2
+ *
+ * @v data		Data buffer
+ * @v count		Number of blocks
+ * @ret sum		Sum of 32-bit words
+ */
+static uint64_t x86_tcpip_sum_avx2 ( const void *data, size_t count ) {
+	uint64_t sum;
+
+#define X86_TCPIP_AVX2_STEP( offset )					\
+	"vmovdqu " #offset "(%1), %%ymm2\n\t"				\
+	"vpunpckldq %%ymm5, %%ymm2, %%ymm3\n\t"			\
+	"vpunpckhdq %%ymm5, %%ymm2, %%ymm2\n\t"			\
+	"vpaddq %%ymm3, %%ymm0, %%ymm0\n\t"				\
+	"vpaddq %%ymm2, %%ymm1, %%ymm1\n\t"
+
+	__asm__ ( "vpxor %%ymm0, %%ymm0, %%ymm0\n\t"
+		  "vpxor %%ymm1, %%ymm1, %%ymm1\n\t"
+		  "vpxor %%ymm5, %%ymm5, %%ymm5\n\t"
+		  "\n1:\n\t"
+		  X86_TCPIP_AVX2_STEP ( 0 )
+		  X86_TCPIP_AVX2_STEP ( 32 )
+		  "add $64, %1\n\t"
+		  "dec %2\n\t"
+		  "jnz 1b\n\t"
+		  "vpaddq %%ymm1, %%ymm0, %%ymm0\n\t"
+		  "vextracti128 $1, %%ymm0, %%xmm1\n\t"
+		  "vpaddq %%xmm1, %%xmm0, %%xmm0\n\t"
+		  "vpshufd $0x4e, %%xmm0, %%xmm1\n\t"
+		  "vpaddq %%xmm1, %%xmm0, %%xmm0\n\t"
+		  "vmovq %%xmm0, %0\n\t"
+		  "vzeroupper\n\t"
+		  : "=r" ( sum ), "+r" ( data ), "+r" ( count )
+		  : "m" ( *( const char ( * )[ count * X86_TCPIP_SIMD_BLOCK ] )
+			  data ) );
+
+	return sum;
+}
+
+/**
+ * Calculate continued TCP/IP checkum using SIMD instructions
+ *
+ * @v features		Checksum SIMD features
+ * @v partial		Checksum of already-summed data, in network byte order
+ * @v data		Data buffer
+ * @v count		Number of blocks
+ * @ret cksum		Updated checksum, in network byte order
+ */
+static uint16_t x86_tcpip_chksum_simd ( unsigned int features,
+					uint16_t partial, const void *data,
+					size_t count ) {
+	uint64_t sum;
+
+	/* Sum 32-bit words */
+	if ( features & X86_TCPIP_AVX2 ) {
+		sum = x86_tcpip_sum_avx2 ( data, count );
+	} else {
+		sum = x86_tcpip_sum_sse2 ( data, count );
+	}
+
+	/* Fold down to 16 bits with end-around carry */
+	sum += ( ( ~partial ) & 0xffff );
+	sum = ( ( sum & 0xffffffffUL ) + ( sum >> 32 ) );
+	sum = ( ( sum & 0xffffffffUL ) + ( sum >> 32 ) );
+	sum = ( ( sum & 0xffff ) + ( sum >> 16 ) );
+	sum = ( ( sum & 0xffff ) + ( sum >> 16 ) );
+
+	return ( ~sum & 0xffff );
+}
+
+#endif /* __x86_64__ */
+
+/**
+ * Calculate continued TCP/IP checkum
+ *
+ * @v partial		Checksum of already-summed data, in network byte order
+ * @v data		Data buffer
+ * @v len		Length of data buffer
+ * @ret cksum		Updated checksum, in network byte order
+ */
+uint16_t tcpip_continue_chksum ( uint16_t partial, const void *data,
+				 size_t len ) {
+#ifdef __x86_64__
+	unsigned int features;
+	size_t count;
+
+	/* Use SIMD instructions for the bulk of large buffers, if
+	 * available.  The SIMD loops consume whole blocks (and hence
+	 * an even number of bytes), leaving any remainder to be
+	 * summed using general-purpose registers.
+	 */
+	if ( len >= X86_TCPIP_SIMD_MIN_LEN ) {
+		features = x86_tcpip_probe();
+		if ( features & ( X86_TCPIP_SSE2 | X86_TCPIP_AVX2 ) ) {
+			count = ( len / X86_TCPIP_SIMD_BLOCK );
+			partial = x86_tcpip_chksum_simd ( features, partial,
+							  data, count );
+			data += ( count * X86_TCPIP_SIMD_BLOCK );
+			len -= ( count * X86_TCPIP_SIMD_BLOCK );
+		}
+	}
+#endif
+
+	return x86_tcpip_chksum ( partial, data, len );
+}
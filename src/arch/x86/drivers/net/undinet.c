@@ -79,7 +79,7 @@ struct undi_nic {
 #define UNDI_INITIALIZE_RETRY_DELAY_MS 200
 
 /** Maximum number of received packets per poll */
-#define UNDI_RX_QUOTA 4
+#define UNDI_RX_QUOTA 16
 
 /** Alignment of received frame payload */
 #define UNDI_RX_ALIGN 16
@@ -278,18 +278,30 @@ static struct undinet_profiler * undinet_profiler ( unsigned int function ) {
 static int undinet_call ( struct undi_nic *undinic, unsigned int function,
 			  void *params, size_t params_len ) {
 	struct undinet_profiler *profiler = undinet_profiler ( function );
+	uint16_t skip_flag;
 	PXENV_EXIT_t exit;
 	uint32_t before;
 	uint32_t started;
 	uint32_t stopped;
 	uint32_t after;
 	int discard_D;
+	int discard_c;
+	int discard_S;
 	int rc;
 
 	/* Copy parameter block and entry point */
 	assert ( params_len <= sizeof ( undinet_params ) );
 	memcpy ( &undinet_params, params, params_len );
 
+	/* We never care about transmit completions.  When calling
+	 * PXENV_UNDI_ISR, ask the real-mode code to immediately
+	 * reissue PXENV_UNDI_ISR_IN_GET_NEXT for any transmit
+	 * completion, rather than incurring a pair of mode
+	 * transitions just to discard it.
+	 */
+	skip_flag = ( ( function == PXENV_UNDI_ISR ) ?
+		      PXENV_UNDI_ISR_OUT_TRANSMIT : 0 );
+
 	/* Call real-mode entry point.  This calling convention will
 	 * work with both the !PXE and the PXENV+ entry points.
 	 */
@@ -297,20 +309,41 @@ static int undinet_call ( struct undi_nic *undinic, unsigned int function,
 	__asm__ __volatile__ ( REAL_CODE ( "pushl %%ebp\n\t" /* gcc bug */
 					   RDTSC_IF_PROFILING
 					   "pushl %%eax\n\t"
+					   "\n1:\n\t"
+					   "pushw %%ds\n\t"
+					   "pushw %%si\n\t"
+					   "pushw %%cx\n\t"
 					   "pushw %%es\n\t"
 					   "pushw %%di\n\t"
 					   "pushw %%bx\n\t"
 					   "lcall *undinet_entry_point\n\t"
+					   "popw %%bx\n\t"
+					   "popw %%di\n\t"
+					   "popw %%es\n\t"
+					   "popw %%cx\n\t"
+					   "popw %%si\n\t"
+					   "popw %%ds\n\t"
+					   "jcxz 2f\n\t"
+					   "testw %%ax, %%ax\n\t"
+					   "jnz 2f\n\t"
+					   "cmpw %%cx, (%%si)\n\t"
+					   "jne 2f\n\t"
+					   "movw %6, (%%si)\n\t"
+					   "jmp 1b\n\t"
+					   "\n2:\n\t"
 					   "movw %%ax, %%bx\n\t"
 					   RDTSC_IF_PROFILING
-					   "addw $6, %%sp\n\t"
 					   "popl %%edx\n\t"
 					   "popl %%ebp\n\t" /* gcc bug */ )
 			       : "=a" ( stopped ), "=d" ( started ),
-				 "=b" ( exit ), "=D" ( discard_D )
-			       : "b" ( function ),
-			         "D" ( __from_data16 ( &undinet_params ) )
-			       : "ecx", "esi" );
+				 "=b" ( exit ), "=D" ( discard_D ),
+				 "=c" ( discard_c ), "=S" ( discard_S )
+			       : "i" ( PXENV_UNDI_ISR_IN_GET_NEXT ),
+				 "b" ( function ),
+			         "D" ( __from_data16 ( &undinet_params ) ),
+				 "c" ( skip_flag ),
+				 "S" ( __from_data16 ( &undinet_params.undi_isr.
+						       FuncFlag ) ) );
 	profile_stop ( &profiler->total );
 	before = profile_started ( &profiler->total );
 	after = profile_stopped ( &profiler->total );
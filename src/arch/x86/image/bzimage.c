@@ -41,6 +41,7 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 #include <ipxe/initrd.h>
 #include <ipxe/uaccess.h>
 #include <ipxe/image.h>
+#include <ipxe/uheap.h>
 #include <ipxe/segment.h>
 #include <ipxe/init.h>
 #include <ipxe/cpio.h>
@@ -70,8 +71,14 @@ struct bzimage_context {
 	size_t rm_memsz;
 	/** Non-real-mode kernel portion load address */
 	void *pm_kernel;
-	/** Non-real-mode kernel portion file and memory size */
+	/** Non-real-mode kernel portion file size */
 	size_t pm_sz;
+	/** Non-real-mode kernel portion memory size */
+	size_t pm_memsz;
+	/** Kernel initialisation memory size (or zero if not specified) */
+	size_t init_size;
+	/** Non-real-mode kernel portion was pre-placed */
+	int placed;
 	/** Video mode */
 	unsigned int vid_mode;
 	/** Memory limit */
@@ -146,6 +153,13 @@ static int bzimage_parse_header ( struct image *image,
 		}
 	}
 
+	/* Calculate memory size of protected-mode portion */
+	bzimg->pm_memsz = bzimg->pm_sz;
+
+	/* Extract kernel initialisation memory size */
+	bzimg->init_size = ( ( bzimg->version >= 0x020a ) ?
+			     bzhdr->init_size : 0 );
+
 	/* Determine image type */
 	is_bzimage = ( ( bzimg->version >= 0x0200 ) ?
 		       ( bzhdr->loadflags & BZI_LOAD_HIGH ) : 0 );
@@ -219,6 +233,10 @@ static void bzimage_update_header ( struct image *image,
 			bzhdr->setup_move_size = bzimg->rm_memsz;
 	}
 
+	/* Set protected-mode entry point, if pre-placed */
+	if ( bzimg->placed )
+		bzhdr->code32_start = virt_to_phys ( bzimg->pm_kernel );
+
 	/* Set video mode */
 	bzhdr->vid_mode = bzimg->vid_mode;
 	DBGC ( image, "bzImage %s vidmode %d\n",
@@ -346,7 +364,7 @@ static int bzimage_check_initrds ( struct image *image,
 	}
 
 	/* Limit region to avoiding kernel itself */
-	min = virt_to_phys ( bzimg->pm_kernel + bzimg->pm_sz );
+	min = virt_to_phys ( bzimg->pm_kernel + bzimg->pm_memsz );
 	if ( min < region.min )
 		min = region.min;
 
@@ -399,6 +417,21 @@ static void bzimage_load_initrds ( struct image *image,
 	assert ( len == bzimg->initrd_size );
 }
 
+/**
+ * Allow for kernel initialisation memory following pre-placed kernel
+ *
+ * @v bzimg		bzImage context
+ *
+ * A pre-placed kernel is executed in place, and will use the memory
+ * following its protected-mode portion (up to the initialisation
+ * size specified in its header) for decompression.
+ */
+static void bzimage_init_memsz ( struct bzimage_context *bzimg ) {
+
+	if ( bzimg->init_size > bzimg->pm_memsz )
+		bzimg->pm_memsz = bzimg->init_size;
+}
+
 /**
  * Execute bzImage image
  *
@@ -413,6 +446,13 @@ static int bzimage_exec ( struct image *image ) {
 	if ( ( rc = bzimage_parse_header ( image, &bzimg ) ) != 0 )
 		return rc;
 
+	/* Use pre-placed protected-mode portion, if applicable */
+	if ( image->placer == &bzimage_image_type ) {
+		bzimg.pm_kernel = ( image->rwdata + bzimg.rm_filesz );
+		bzimage_init_memsz ( &bzimg );
+		bzimg.placed = 1;
+	}
+
 	/* Prepare segments */
 	if ( ( rc = prep_segment ( bzimg.rm_kernel, bzimg.rm_filesz,
 				   bzimg.rm_memsz ) ) != 0 ) {
@@ -421,7 +461,7 @@ static int bzimage_exec ( struct image *image ) {
 		return rc;
 	}
 	if ( ( rc = prep_segment ( bzimg.pm_kernel, bzimg.pm_sz,
-				   bzimg.pm_sz ) ) != 0 ) {
+				   bzimg.pm_memsz ) ) != 0 ) {
 		DBGC ( image, "bzImage %s could not prepare PM segment: %s\n",
 		       image->name, strerror ( rc ) );
 		return rc;
@@ -440,8 +480,10 @@ static int bzimage_exec ( struct image *image ) {
 
 	/* Load segments */
 	memcpy ( bzimg.rm_kernel, image->data, bzimg.rm_filesz );
-	memcpy ( bzimg.pm_kernel, ( image->data + bzimg.rm_filesz ),
-		 bzimg.pm_sz );
+	if ( ! bzimg.placed ) {
+		memcpy ( bzimg.pm_kernel, ( image->data + bzimg.rm_filesz ),
+			 bzimg.pm_sz );
+	}
 
 	/* Store command line */
 	bzimage_set_cmdline ( image, &bzimg );
@@ -500,9 +542,89 @@ int bzimage_probe ( struct image *image ) {
 	return 0;
 }
 
+/**
+ * Pre-place bzImage image during download
+ *
+ * @v image		bzImage file (containing only the initial data)
+ * @v len		Total length of image
+ * @ret data		Pre-placed data buffer, or NULL
+ *
+ * A relocatable kernel may be downloaded directly to a suitably
+ * aligned address at the bottom of the external heap region, so
+ * that the protected-mode portion can be executed in place.  The
+ * kernel will use the memory following its protected-mode portion
+ * (up to the initialisation size specified in its header) for
+ * decompression, so this memory is reserved along with the image.
+ */
+static void * bzimage_place ( struct image *image, size_t len ) {
+	const struct bzimage_header *bzhdr;
+	struct bzimage_context bzimg;
+	physaddr_t align;
+	physaddr_t min;
+	physaddr_t kernel;
+	physaddr_t start;
+	size_t partial;
+	int rc;
+
+	/* Parse header as though the whole image were present */
+	if ( image->len < ( BZI_HDR_OFFSET + sizeof ( *bzhdr ) ) )
+		return NULL;
+	bzhdr = ( image->data + BZI_HDR_OFFSET );
+	partial = image->len;
+	image->len = len;
+	rc = bzimage_parse_header ( image, &bzimg );
+	image->len = partial;
+	if ( rc != 0 )
+		return NULL;
+
+	/* Only relocatable high-loaded kernels that specify their
+	 * initialisation size (boot protocol 2.10 and above) may be
+	 * placed.
+	 */
+	if ( ( bzimg.version < 0x020a ) || ( ! bzhdr->relocatable_kernel ) ||
+	     ( virt_to_phys ( bzimg.pm_kernel ) != BZI_LOAD_HIGH_ADDR ) )
+		return NULL;
+	bzimage_init_memsz ( &bzimg );
+	align = bzhdr->kernel_alignment;
+	if ( ( ! align ) || ( align & ( align - 1 ) ) )
+		return NULL;
+
+	/* Place protected-mode portion at the lowest suitably aligned
+	 * address within the external heap region.
+	 */
+	if ( uheap_limit == uheap_end )
+		return NULL;
+	min = ( ( uheap_limit > BZI_LOAD_HIGH_ADDR ) ?
+		uheap_limit : BZI_LOAD_HIGH_ADDR );
+	kernel = ( ( min + bzimg.rm_filesz + align - 1 ) & ~( align - 1 ) );
+	start = ( kernel - bzimg.rm_filesz );
+	if ( ( kernel < min ) ||
+	     ( ( kernel + bzimg.pm_memsz - 1 ) > bzimg.mem_limit ) )
+		return NULL;
+	if ( ( rc = uheap_reserve ( start, ( bzimg.rm_filesz +
+					     bzimg.pm_memsz ) ) ) != 0 )
+		return NULL;
+
+	DBGC ( image, "bzImage %s pre-placed with PM kernel at %#08lx\n",
+	       image->name, kernel );
+	return phys_to_virt ( start );
+}
+
+/**
+ * Release pre-placed bzImage image
+ *
+ * @v image		bzImage file
+ */
+static void bzimage_unplace ( struct image *image __unused ) {
+
+	uheap_release();
+}
+
 /** Linux bzImage image type */
 struct image_type bzimage_image_type __image_type ( PROBE_NORMAL ) = {
 	.name = "bzImage",
 	.probe = bzimage_probe,
 	.exec = bzimage_exec,
+	.place = bzimage_place,
+	.unplace = bzimage_unplace,
 };
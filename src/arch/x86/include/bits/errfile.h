@@ -29,6 +29,10 @@ FILE_SECBOOT ( PERMITTED );
 #define ERRFILE_rdtsc_timer	( ERRFILE_ARCH | ERRFILE_CORE | 0x00120000 )
 #define ERRFILE_acpi_timer	( ERRFILE_ARCH | ERRFILE_CORE | 0x00130000 )
 #define ERRFILE_rdrand		( ERRFILE_ARCH | ERRFILE_CORE | 0x00140000 )
+#define ERRFILE_aesni		( ERRFILE_ARCH | ERRFILE_CORE | 0x00150000 )
+#define ERRFILE_shani		( ERRFILE_ARCH | ERRFILE_CORE | 0x00160000 )
+#define ERRFILE_adx		( ERRFILE_ARCH | ERRFILE_CORE | 0x00170000 )
+#define ERRFILE_x86_crc32	( ERRFILE_ARCH | ERRFILE_CORE | 0x00180000 )
 
 #define ERRFILE_bootsector     ( ERRFILE_ARCH | ERRFILE_IMAGE | 0x00000000 )
 #define ERRFILE_bzimage	       ( ERRFILE_ARCH | ERRFILE_IMAGE | 0x00010000 )
@@ -4,6 +4,7 @@
 FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 
 #include <stdint.h>
+#include <ipxe/image.h>
 
 /**
  * A bzImage header
@@ -72,6 +73,20 @@ struct bzimage_header {
 	uint8_t pad2[3];
 	/** Maximum size of the kernel command line */
 	uint32_t cmdline_size;
+	/** Hardware subarchitecture */
+	uint32_t hardware_subarch;
+	/** Subarchitecture-specific data */
+	uint64_t hardware_subarch_data;
+	/** Offset of kernel payload */
+	uint32_t payload_offset;
+	/** Length of kernel payload */
+	uint32_t payload_length;
+	/** 64-bit physical pointer to linked list of setup data */
+	uint64_t setup_data;
+	/** Preferred loading address */
+	uint64_t pref_address;
+	/** Linear memory required during initialisation */
+	uint32_t init_size;
 } __attribute__ (( packed ));
 
 /** Offset of bzImage header within kernel image */
@@ -139,4 +154,6 @@ struct bzimage_cmdline {
 /** Maximum size of command line */
 #define BZI_CMDLINE_SIZE 0x7ff
 
+extern struct image_type bzimage_image_type __image_type ( PROBE_NORMAL );
+
 #endif /* _BZIMAGE_H */
@@ -43,6 +43,24 @@ struct x86_features {
 /** Get standard features */
 #define CPUID_FEATURES 0x00000001UL
 
+/** PCLMULQDQ instruction is supported */
+#define CPUID_FEATURES_INTEL_ECX_PCLMULQDQ 0x00000002UL
+
+/** SSSE3 instructions are supported */
+#define CPUID_FEATURES_INTEL_ECX_SSSE3 0x00000200UL
+
+/** SSE4.2 instructions are supported */
+#define CPUID_FEATURES_INTEL_ECX_SSE4_2 0x00100000UL
+
+/** AES instructions are supported */
+#define CPUID_FEATURES_INTEL_ECX_AES 0x02000000UL
+
+/** XSAVE is enabled by the operating system */
+#define CPUID_FEATURES_INTEL_ECX_OSXSAVE 0x08000000UL
+
+/** AVX instructions are supported */
+#define CPUID_FEATURES_INTEL_ECX_AVX 0x10000000UL
+
 /** RDRAND instruction is supported */
 #define CPUID_FEATURES_INTEL_ECX_RDRAND 0x40000000UL
 
@@ -55,6 +73,27 @@ struct x86_features {
 /** FXSAVE and FXRSTOR are supported */
 #define CPUID_FEATURES_INTEL_EDX_FXSR 0x01000000UL
 
+/** Get structured extended features */
+#define CPUID_STRUCTURED_FEATURES 0x00000007UL
+
+/** AVX2 instructions are supported */
+#define CPUID_STRUCTURED_FEATURES_EBX_AVX2 0x00000020UL
+
+/** BMI2 instructions (including MULX) are supported */
+#define CPUID_STRUCTURED_FEATURES_EBX_BMI2 0x00000100UL
+
+/** Enhanced REP MOVSB/STOSB are supported */
+#define CPUID_STRUCTURED_FEATURES_EBX_ERMS 0x00000200UL
+
+/** ADX instructions (ADCX and ADOX) are supported */
+#define CPUID_STRUCTURED_FEATURES_EBX_ADX 0x00080000UL
+
+/** SHA instructions are supported */
+#define CPUID_STRUCTURED_FEATURES_EBX_SHA 0x20000000UL
+
+/** Fast short REP MOVSB is supported */
+#define CPUID_STRUCTURED_FEATURES_EDX_FSRM 0x00000010UL
+
 /** Get largest extended function */
 #define CPUID_AMD_MAX_FN 0x80000000UL
 
@@ -31,6 +31,7 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include <errno.h>
 #include <byteswap.h>
 #include <ipxe/in.h>
@@ -40,9 +41,19 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 #include <ipxe/open.h>
 #include <ipxe/process.h>
 #include <ipxe/uri.h>
+#include <ipxe/umalloc.h>
 #include <realmode.h>
 #include <pxe.h>
 
+/** Length of PXE TFTP read-ahead buffer
+ *
+ * This must be large enough to hold a full TCP receive window (for
+ * HTTP-backed transfers) or a full TFTP block window, so that the
+ * underlying transfer is never throttled to a single block per
+ * pxenv_tftp_read() call.
+ */
+#define PXE_TFTP_READAHEAD_LEN ( 512 * 1024 )
+
 /** A PXE TFTP connection */
 struct pxe_tftp_connection {
 	/** Data transfer interface */
@@ -63,6 +74,18 @@ struct pxe_tftp_connection {
 	unsigned int blkidx;
 	/** Overall return status code */
 	int rc;
+	/** Read-ahead buffer (if any)
+	 *
+	 * When present, delivered data are written into this circular
+	 * buffer (indexed by file position modulo the buffer length)
+	 * rather than directly into the caller's buffer, and are
+	 * subsequently served to pxenv_tftp_read() from memory.
+	 */
+	void *readahead;
+	/** File position of next byte to be read from read-ahead buffer */
+	size_t read_offset;
+	/** File position of end of data in read-ahead buffer */
+	size_t fill_offset;
 };
 
 /**
@@ -83,10 +106,50 @@ static void pxe_tftp_close ( struct pxe_tftp_connection *pxe_tftp, int rc ) {
  * @ret len		Length of window
  */
 static size_t pxe_tftp_xfer_window ( struct pxe_tftp_connection *pxe_tftp ) {
+	size_t used;
+
+	/* Report free space in read-ahead buffer, if applicable */
+	if ( pxe_tftp->readahead ) {
+		used = ( pxe_tftp->fill_offset - pxe_tftp->read_offset );
+		return ( PXE_TFTP_READAHEAD_LEN - used );
+	}
 
 	return pxe_tftp->blksize;
 }
 
+/**
+ * Copy data to or from read-ahead buffer
+ *
+ * @v pxe_tftp		PXE TFTP connection
+ * @v offset		File position
+ * @v data		Data buffer
+ * @v len		Length of data
+ * @v write		Copy into (rather than out of) read-ahead buffer
+ */
+static void pxe_tftp_readahead_copy ( struct pxe_tftp_connection *pxe_tftp,
+				      size_t offset, void *data, size_t len,
+				      int write ) {
+	size_t pos;
+	size_t frag_len;
+
+	while ( len ) {
+		pos = ( offset % PXE_TFTP_READAHEAD_LEN );
+		frag_len = ( PXE_TFTP_READAHEAD_LEN - pos );
+		if ( frag_len > len )
+			frag_len = len;
+		if ( write ) {
+			memcpy ( ( pxe_tftp->readahead + pos ), data,
+				 frag_len );
+		} else {
+			memcpy ( data, ( pxe_tftp->readahead + pos ),
+				 frag_len );
+		}
+		offset += frag_len;
+		data += frag_len;
+		len -= frag_len;
+	}
+}
+
 /**
  * Receive new data
  *
@@ -109,6 +172,25 @@ static int pxe_tftp_xfer_deliver ( struct pxe_tftp_connection *pxe_tftp,
 	/* Copy data block to buffer */
 	if ( len == 0 ) {
 		/* No data (pure seek); treat as success */
+	} else if ( pxe_tftp->readahead ) {
+		if ( pxe_tftp->offset != pxe_tftp->fill_offset ) {
+			DBG ( " read-ahead discontinuity at %zx (expected "
+			      "%zx)", pxe_tftp->offset,
+			      pxe_tftp->fill_offset );
+			rc = -ENOBUFS;
+		} else if ( ( pxe_tftp->offset + len ) >
+			    ( pxe_tftp->read_offset +
+			      PXE_TFTP_READAHEAD_LEN ) ) {
+			DBG ( " read-ahead overrun at %zx (max %zx)",
+			      ( pxe_tftp->offset + len ),
+			      ( pxe_tftp->read_offset +
+				PXE_TFTP_READAHEAD_LEN ) );
+			rc = -ENOBUFS;
+		} else {
+			pxe_tftp_readahead_copy ( pxe_tftp, pxe_tftp->offset,
+						  iobuf->data, len, 1 );
+			pxe_tftp->fill_offset += len;
+		}
 	} else if ( pxe_tftp->offset < pxe_tftp->start ) {
 		DBG ( " buffer underrun at %zx (min %zx)",
 		      pxe_tftp->offset, pxe_tftp->start );
@@ -157,6 +239,17 @@ static struct pxe_tftp_connection pxe_tftp = {
 	.xfer = INTF_INIT ( pxe_tftp_xfer_desc ),
 };
 
+/**
+ * Free PXE TFTP read-ahead buffer
+ *
+ * @v pxe_tftp		PXE TFTP connection
+ */
+static void pxe_tftp_free ( struct pxe_tftp_connection *pxe_tftp ) {
+
+	ufree ( pxe_tftp->readahead );
+	pxe_tftp->readahead = NULL;
+}
+
 /**
  * Open PXE TFTP connection
  *
@@ -164,10 +257,12 @@ static struct pxe_tftp_connection pxe_tftp = {
  * @v port		TFTP server port (in network byte order)
  * @v filename		File name
  * @v blksize		Requested block size
+ * @v readahead		Use read-ahead buffer
  * @ret rc		Return status code
  */
 static int pxe_tftp_open ( IP4_t ipaddress, UDP_PORT_t port,
-			   UINT8_t *filename, UINT16_t blksize ) {
+			   UINT8_t *filename, UINT16_t blksize,
+			   int readahead ) {
 	union {
 		struct sockaddr sa;
 		struct sockaddr_in sin;
@@ -176,6 +271,7 @@ static int pxe_tftp_open ( IP4_t ipaddress, UDP_PORT_t port,
 	int rc;
 
 	/* Reset PXE TFTP connection structure */
+	pxe_tftp_free ( &pxe_tftp );
 	memset ( &pxe_tftp, 0, sizeof ( pxe_tftp ) );
 	intf_init ( &pxe_tftp.xfer, &pxe_tftp_xfer_desc, NULL );
 	if ( blksize < TFTP_DEFAULT_BLKSIZE )
@@ -183,6 +279,15 @@ static int pxe_tftp_open ( IP4_t ipaddress, UDP_PORT_t port,
 	pxe_tftp.blksize = blksize;
 	pxe_tftp.rc = -EINPROGRESS;
 
+	/* Allocate read-ahead buffer, if applicable.  Failure is
+	 * non-fatal; we fall back to reading one block at a time.
+	 */
+	if ( readahead ) {
+		pxe_tftp.readahead = umalloc ( PXE_TFTP_READAHEAD_LEN );
+		if ( ! pxe_tftp.readahead )
+			DBG ( " (no read-ahead)" );
+	}
+
 	/* Construct URI */
 	memset ( &server, 0, sizeof ( server ) );
 	server.sin.sin_family = AF_INET;
@@ -192,7 +297,7 @@ static int pxe_tftp_open ( IP4_t ipaddress, UDP_PORT_t port,
 	if ( port )
 		DBG ( ":%d", ntohs ( port ) );
 	DBG ( ":%s", filename );
-	uri = pxe_uri ( &server.sa, ( ( char * ) filename ) );
+	uri = pxe_tftp_uri ( &server.sa, ( ( char * ) filename ) );
 	if ( ! uri ) {
 		DBG ( " could not create URI\n" );
 		return -ENOMEM;
@@ -261,7 +366,7 @@ static PXENV_EXIT_t pxenv_tftp_open ( struct s_PXENV_TFTP_OPEN *tftp_open ) {
 	if ( ( rc = pxe_tftp_open ( tftp_open->ServerIPAddress,
 				    tftp_open->TFTPPort,
 				    tftp_open->FileName,
-				    tftp_open->PacketSize ) ) != 0 ) {
+				    tftp_open->PacketSize, 1 ) ) != 0 ) {
 		tftp_open->Status = PXENV_STATUS ( rc );
 		return PXENV_EXIT_FAILURE;
 	}
@@ -271,7 +376,14 @@ static PXENV_EXIT_t pxenv_tftp_open ( struct s_PXENV_TFTP_OPEN *tftp_open ) {
 		( pxe_tftp.max_offset == 0 ) ) {
 		step();
 	}
-	pxe_tftp.blksize = xfer_window ( &pxe_tftp.xfer );
+
+	/* When reading via the read-ahead buffer, blocks are served
+	 * from memory and so may use the requested block size
+	 * regardless of the block size (if any) negotiated by the
+	 * underlying transfer.
+	 */
+	if ( ! pxe_tftp.readahead )
+		pxe_tftp.blksize = xfer_window ( &pxe_tftp.xfer );
 	tftp_open->PacketSize = pxe_tftp.blksize;
 	DBG ( " blksize=%d", tftp_open->PacketSize );
 
@@ -304,6 +416,7 @@ static PXENV_EXIT_t pxenv_tftp_close ( struct s_PXENV_TFTP_CLOSE *tftp_close ) {
 	DBG ( "PXENV_TFTP_CLOSE" );
 
 	pxe_tftp_close ( &pxe_tftp, 0 );
+	pxe_tftp_free ( &pxe_tftp );
 	tftp_close->Status = PXENV_STATUS_SUCCESS;
 	return PXENV_EXIT_SUCCESS;
 }
@@ -370,14 +483,40 @@ static PXENV_EXIT_t pxenv_tftp_close ( struct s_PXENV_TFTP_CLOSE *tftp_close ) {
  * @ref pxe_x86_pmode16 "implementation note" for more details.)
  */
 static PXENV_EXIT_t pxenv_tftp_read ( struct s_PXENV_TFTP_READ *tftp_read ) {
+	void *buffer;
+	size_t len;
 	int rc;
 
 	DBG ( "PXENV_TFTP_READ to %04x:%04x",
 	      tftp_read->Buffer.segment, tftp_read->Buffer.offset );
+	buffer = real_to_virt ( tftp_read->Buffer.segment,
+				tftp_read->Buffer.offset );
+
+	/* Serve block from read-ahead buffer, if applicable */
+	if ( pxe_tftp.readahead ) {
+		while ( ( ( rc = pxe_tftp.rc ) == -EINPROGRESS ) &&
+			( ( pxe_tftp.fill_offset - pxe_tftp.read_offset ) <
+			  pxe_tftp.blksize ) ) {
+			step();
+		}
+		len = ( pxe_tftp.fill_offset - pxe_tftp.read_offset );
+		if ( len > pxe_tftp.blksize )
+			len = pxe_tftp.blksize;
+		pxe_tftp_readahead_copy ( &pxe_tftp, pxe_tftp.read_offset,
+					  buffer, len, 0 );
+		pxe_tftp.read_offset += len;
+		tftp_read->BufferSize = len;
+		tftp_read->PacketNumber = ++pxe_tftp.blkidx;
+		if ( rc == -EINPROGRESS ) {
+			xfer_window_changed ( &pxe_tftp.xfer );
+			rc = 0;
+		}
+		tftp_read->Status = PXENV_STATUS ( rc );
+		return ( rc ? PXENV_EXIT_FAILURE : PXENV_EXIT_SUCCESS );
+	}
 
 	/* Read single block into buffer */
-	pxe_tftp.buffer = real_to_virt ( tftp_read->Buffer.segment,
-					 tftp_read->Buffer.offset );
+	pxe_tftp.buffer = buffer;
 	pxe_tftp.size = pxe_tftp.blksize;
 	pxe_tftp.start = pxe_tftp.offset;
 	while ( ( ( rc = pxe_tftp.rc ) == -EINPROGRESS ) &&
@@ -484,7 +623,7 @@ PXENV_EXIT_t pxenv_tftp_read_file ( struct s_PXENV_TFTP_READ_FILE
 
 	/* Open TFTP file */
 	if ( ( rc = pxe_tftp_open ( tftp_read_file->ServerIPAddress, 0,
-				    tftp_read_file->FileName, 0 ) ) != 0 ) {
+				    tftp_read_file->FileName, 0, 0 ) ) != 0 ) {
 		tftp_read_file->Status = PXENV_STATUS ( rc );
 		return PXENV_EXIT_FAILURE;
 	}
@@ -554,7 +693,7 @@ static PXENV_EXIT_t pxenv_tftp_get_fsize ( struct s_PXENV_TFTP_GET_FSIZE
 
 	/* Open TFTP file */
 	if ( ( rc = pxe_tftp_open ( tftp_get_fsize->ServerIPAddress, 0,
-				    tftp_get_fsize->FileName, 0 ) ) != 0 ) {
+				    tftp_get_fsize->FileName, 0, 0 ) ) != 0 ) {
 		tftp_get_fsize->Status = PXENV_STATUS ( rc );
 		return PXENV_EXIT_FAILURE;
 	}
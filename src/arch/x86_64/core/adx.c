@@ -0,0 +1,224 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+FILE_SECBOOT ( PERMITTED );
+
+/** @file
+ *
+ * ADX big integer hardware acceleration
+ *
+ * Big integers are stored as arrays of 32-bit elements, which may be
+ * treated as arrays of 64-bit limbs whenever the number of elements
+ * is even.  Each row of a multiplication or Montgomery reduction is
+ * then calculated using MULX (which does not affect the flags) along
+ * with ADCX and ADOX (which propagate carries via CF and OF
+ * respectively), allowing two independent carry chains to be
+ * maintained through the row without any flag save and restore.
+ *
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <ipxe/cpuid.h>
+#include <ipxe/bigint.h>
+
+/** A 64-bit limb */
+typedef uint64_t adx_limb_t __attribute__ (( may_alias ));
+
+/**
+ * Check if hardware acceleration is usable
+ *
+ * @ret rc		Return status code
+ */
+static int adx_probe ( void ) {
+	uint32_t discard_a;
+	uint32_t discard_c;
+	uint32_t discard_d;
+	uint32_t ebx;
+	int rc;
+
+	/* Check for required instructions */
+	if ( ( rc = cpuid_supported ( CPUID_STRUCTURED_FEATURES ) ) != 0 )
+		return rc;
+	cpuid ( CPUID_STRUCTURED_FEATURES, 0, &discard_a, &ebx, &discard_c,
+		&discard_d );
+	if ( ! ( ebx & CPUID_STRUCTURED_FEATURES_EBX_BMI2 ) )
+		return -ENOTSUP;
+	if ( ! ( ebx & CPUID_STRUCTURED_FEATURES_EBX_ADX ) )
+		return -ENOTSUP;
+
+	return 0;
+}
+
+/**
+ * Multiply and accumulate one row
+ *
+ * @v multiplicand	Single limb to be multiplied
+ * @v multiplier	Limbs to be multiplied
+ * @v result		Limbs to accumulate product into
+ * @v count		Number of limbs in multiplier and result
+ * @ret carry		Carry out limb
+ *
+ * Calculates carry:result := ( multiplicand * multiplier ) + result.
+ * As for the generic implementation, the carry out cannot overflow
+ * beyond a single limb.
+ */
+static uint64_t adx_multiply_row ( uint64_t multiplicand,
+				   const adx_limb_t *multiplier,
+				   adx_limb_t *result, unsigned long count ) {
+	uint64_t low;
+	uint64_t high;
+	uint64_t carry;
+
+	/* Sanity check */
+	assert ( count > 0 );
+
+	/* At each step, the low half of the product is accumulated
+	 * into the result via the CF chain (ADCX), and the high half
+	 * of the previous step's product is accumulated via the OF
+	 * chain (ADOX).  The loop is constructed using only MOV, LEA,
+	 * JRCXZ and JMP, none of which affect the flags.  (LOOP
+	 * would also preserve the flags, but is significantly slower
+	 * on many CPUs.)
+	 */
+	__asm__ __volatile__ ( "xor %[carry], %[carry]\n\t" /* Clear CF, OF */
+			       "\n1:\n\t"
+			       "mulx (%[multiplier]), %[low], %[high]\n\t"
+			       "adcx (%[result]), %[low]\n\t"
+			       "adox %[carry], %[low]\n\t"
+			       "mov %[low], (%[result])\n\t"
+			       "mov %[high], %[carry]\n\t"
+			       "lea 8(%[multiplier]), %[multiplier]\n\t"
+			       "lea 8(%[result]), %[result]\n\t"
+			       "lea -1(%[count]), %[count]\n\t"
+			       "jrcxz 2f\n\t"
+			       "jmp 1b\n\t"
+			       "\n2:\n\t"
+			       "mov $0, %[low]\n\t"
+			       "adcx %[low], %[carry]\n\t"
+			       "adox %[low], %[carry]\n\t"
+			       : [low] "=&r" ( low ), [high] "=&r" ( high ),
+				 [carry] "=&r" ( carry ),
+				 [multiplier] "+r" ( multiplier ),
+				 [result] "+r" ( result ),
+				 [count] "+c" ( count )
+			       : [multiplicand] "d" ( multiplicand )
+			       : "memory" );
+
+	return carry;
+}
+
+/**
+ * Multiply big integers
+ *
+ * @v multiplicand0	Element 0 of big integer to be multiplied
+ * @v multiplicand_size	Number of elements in multiplicand
+ * @v multiplier0	Element 0 of big integer to be multiplied
+ * @v multiplier_size	Number of elements in multiplier
+ * @v result0		Element 0 of big integer to hold result
+ */
+static void adx_multiply ( const bigint_element_t *multiplicand0,
+			   unsigned int multiplicand_size,
+			   const bigint_element_t *multiplier0,
+			   unsigned int multiplier_size,
+			   bigint_element_t *result0 ) {
+	const adx_limb_t *multiplicand = ( ( const void * ) multiplicand0 );
+	const adx_limb_t *multiplier = ( ( const void * ) multiplier0 );
+	adx_limb_t *result = ( ( void * ) result0 );
+	unsigned int multiplicand_count = ( multiplicand_size / 2 );
+	unsigned int multiplier_count = ( multiplier_size / 2 );
+	unsigned int i;
+
+	/* Zero required portion of result */
+	memset ( result, 0, ( multiplier_count * sizeof ( result[0] ) ) );
+
+	/* Multiply integers one row at a time */
+	for ( i = 0 ; i < multiplicand_count ; i++ ) {
+		result[ i + multiplier_count ] =
+			adx_multiply_row ( multiplicand[i], multiplier,
+					   &result[i], multiplier_count );
+	}
+}
+
+/**
+ * Perform relaxed Montgomery reduction (REDC) of a big integer
+ *
+ * @v modulus0		Element 0 of big integer odd modulus
+ * @v value0		Element 0 of big integer to be reduced
+ * @v result0		Element 0 of big integer to hold result
+ * @v size		Number of elements in modulus and result
+ * @ret carry		Carry out
+ *
+ * See bigint_montgomery_relaxed_raw() for a description of the
+ * constraints on the input and output values.
+ */
+static int adx_montgomery ( const bigint_element_t *modulus0,
+			    bigint_element_t *value0,
+			    bigint_element_t *result0, unsigned int size ) {
+	const adx_limb_t *modulus = ( ( const void * ) modulus0 );
+	adx_limb_t *value = ( ( void * ) value0 );
+	adx_limb_t *result = ( ( void * ) result0 );
+	unsigned int count = ( size / 2 );
+	uint64_t negmodinv;
+	uint64_t multiple;
+	unsigned int i;
+	int overflow;
+
+	/* Calculate inverse of the least significant limb via Newton
+	 * iteration.  Any odd value is its own inverse modulo 2^3,
+	 * and each iteration doubles the number of correct bits.
+	 */
+	negmodinv = modulus[0];
+	for ( i = 0 ; i < 5 ; i++ )
+		negmodinv *= ( 2 - ( modulus[0] * negmodinv ) );
+	negmodinv = -negmodinv;
+
+	/* Perform multiprecision Montgomery reduction, storing the
+	 * carry out from each row in the result.
+	 */
+	for ( i = 0 ; i < count ; i++ ) {
+		multiple = ( value[i] * negmodinv );
+		result[i] = adx_multiply_row ( multiple, modulus, &value[i],
+					       count );
+		assert ( value[i] == 0 );
+	}
+
+	/* Add the accumulated carries */
+	overflow = bigint_add_raw ( result0, ( value0 + size ), size );
+
+	/* Copy to result buffer */
+	memcpy ( result0, ( value0 + size ), ( size * sizeof ( value0[0] ) ) );
+
+	return overflow;
+}
+
+/** ADX big integer hardware accelerator */
+struct bigint_accelerator adx_accelerator __bigint_accelerator = {
+	.name = "adx",
+	.limb = 2,
+	.probe = adx_probe,
+	.multiply = adx_multiply,
+	.montgomery = adx_montgomery,
+};
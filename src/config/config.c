@@ -93,6 +93,9 @@ REQUIRE_OBJECT ( ipv4 );
 #ifdef NET_PROTO_IPV6
 REQUIRE_OBJECT ( ipv6 );
 #endif
+#ifdef TCP_CUBIC
+REQUIRE_OBJECT ( tcp_cubic );
+#endif
 
 /*
  * Drag in all requested PXE support
@@ -127,6 +130,12 @@ REQUIRE_OBJECT ( nfs_open );
 #ifdef DOWNLOAD_PROTO_SLAM
 REQUIRE_OBJECT ( slam );
 #endif
+#ifdef DOWNLOAD_PROTO_ALC
+REQUIRE_OBJECT ( alc );
+#endif
+#ifdef DOWNLOAD_INFLATE
+REQUIRE_OBJECT ( inflate );
+#endif
 
 /*
  * Drag in all requested SAN boot protocols
@@ -138,6 +147,12 @@ REQUIRE_OBJECT ( iscsi );
 #ifdef SANBOOT_PROTO_HTTP
 REQUIRE_OBJECT ( httpblock );
 #endif
+#ifdef SANBOOT_PROTO_NVME_TCP
+REQUIRE_OBJECT ( nvmetcp );
+#endif
+#ifdef SANBOOT_PROTO_IMAGE
+REQUIRE_OBJECT ( imgblock );
+#endif
 
 /*
  * Drag in all requested resolvers
@@ -192,6 +207,12 @@ REQUIRE_OBJECT ( zlib );
 #ifdef IMAGE_GZIP
 REQUIRE_OBJECT ( gzip );
 #endif
+#ifdef IMAGE_ZSTD
+REQUIRE_OBJECT ( zstd );
+#endif
+#ifdef IMAGE_XZ
+REQUIRE_OBJECT ( xz );
+#endif
 #ifdef IMAGE_UCODE
 REQUIRE_OBJECT ( ucode );
 #endif
@@ -252,6 +273,9 @@ REQUIRE_OBJECT ( lotest_cmd );
 #ifdef VLAN_CMD
 REQUIRE_OBJECT ( vlan_cmd );
 #endif
+#ifdef BOND_CMD
+REQUIRE_OBJECT ( bond_cmd );
+#endif
 #ifdef POWEROFF_CMD
 REQUIRE_OBJECT ( poweroff_cmd );
 #endif
@@ -288,9 +312,21 @@ REQUIRE_OBJECT ( ipstat_cmd );
 #ifdef PROFSTAT_CMD
 REQUIRE_OBJECT ( profstat_cmd );
 #endif
+#ifdef MEMSTAT_CMD
+REQUIRE_OBJECT ( memstat_cmd );
+#endif
+#ifdef TRACESTAT_CMD
+REQUIRE_OBJECT ( tracestat_cmd );
+#endif
+#ifdef PCAP_CMD
+REQUIRE_OBJECT ( pcap_cmd );
+#endif
 #ifdef NTP_CMD
 REQUIRE_OBJECT ( ntp_cmd );
 #endif
+#ifdef PREWARM_CMD
+REQUIRE_OBJECT ( prewarm_cmd );
+#endif
 #ifdef CERT_CMD
 REQUIRE_OBJECT ( cert_cmd );
 #endif
@@ -324,6 +360,9 @@ REQUIRE_OBJECT ( gdbidt );
 REQUIRE_OBJECT ( gdbudp );
 REQUIRE_OBJECT ( gdbstub_cmd );
 #endif
+#ifdef IMAGE_CACHE
+REQUIRE_OBJECT ( imgcache );
+#endif
 
 /*
  * Drag in objects that are always required, but not dragged in via
@@ -359,6 +398,9 @@ REQUIRE_OBJECT ( cpuid_settings );
 #ifdef MEMMAP_SETTINGS
 REQUIRE_OBJECT ( memmap_settings );
 #endif
+#ifdef HEAP_SETTINGS
+REQUIRE_OBJECT ( heap_settings );
+#endif
 #ifdef VRAM_SETTINGS
 REQUIRE_OBJECT ( vram_settings );
 #endif
@@ -99,6 +99,34 @@ REQUIRE_OBJECT ( oid_p256 );
 REQUIRE_OBJECT ( oid_p384 );
 #endif
 
+/* AES-NI hardware acceleration */
+#if defined ( CRYPTO_ACCEL_AESNI ) && \
+    ( defined ( CRYPTO_CIPHER_AES_CBC ) || defined ( CRYPTO_CIPHER_AES_GCM ) )
+REQUIRE_OBJECT ( aesni );
+#endif
+
+/* SHA extensions hardware acceleration */
+#if defined ( CRYPTO_ACCEL_SHANI ) && \
+    ( defined ( CRYPTO_DIGEST_SHA1 ) || defined ( CRYPTO_DIGEST_SHA256 ) )
+REQUIRE_OBJECT ( shani );
+#endif
+
+/* ADX big integer hardware acceleration */
+#if defined ( CRYPTO_ACCEL_ADX )
+REQUIRE_OBJECT ( adx );
+#endif
+
+/* x86 CRC32 hardware acceleration */
+#if defined ( CRYPTO_ACCEL_X86_CRC32 )
+REQUIRE_OBJECT ( x86_crc32 );
+#endif
+
+/* ARMv8 SHA hardware acceleration */
+#if defined ( CRYPTO_ACCEL_ARM64_SHA ) && \
+    ( defined ( CRYPTO_DIGEST_SHA1 ) || defined ( CRYPTO_DIGEST_SHA256 ) )
+REQUIRE_OBJECT ( arm64_sha );
+#endif
+
 /* AES-CBC */
 #if defined ( CRYPTO_CIPHER_AES_CBC )
 REQUIRE_OBJECT ( oid_aes_cbc );
@@ -217,6 +245,13 @@ REQUIRE_OBJECT ( ecdhe_rsa_aes_gcm_sha256 );
 REQUIRE_OBJECT ( ecdhe_rsa_aes_gcm_sha384 );
 #endif
 
+/* ECDHE, RSA, ChaCha20-Poly1305, and SHA-256 */
+#if defined ( CRYPTO_EXCHANGE_ECDHE ) && defined ( CRYPTO_PUBKEY_RSA ) && \
+    defined ( CRYPTO_CIPHER_CHACHA20_POLY1305 ) && \
+    defined ( CRYPTO_DIGEST_SHA256 )
+REQUIRE_OBJECT ( ecdhe_rsa_chacha20_poly1305_sha256 );
+#endif
+
 /* ECDSA and SHA-224 */
 #if defined ( CRYPTO_PUBKEY_ECDSA ) && defined ( CRYPTO_DIGEST_SHA224 )
 REQUIRE_OBJECT ( ecdsa_sha224 );
@@ -266,3 +301,29 @@ REQUIRE_OBJECT ( ecdhe_ecdsa_aes_gcm_sha256 );
     defined ( CRYPTO_CIPHER_AES_GCM ) && defined ( CRYPTO_DIGEST_SHA384 )
 REQUIRE_OBJECT ( ecdhe_ecdsa_aes_gcm_sha384 );
 #endif
+
+/* ECDHE, ECDSA, ChaCha20-Poly1305, and SHA-256 */
+#if defined ( CRYPTO_EXCHANGE_ECDHE ) && defined ( CRYPTO_PUBKEY_ECDSA ) && \
+    defined ( CRYPTO_CIPHER_CHACHA20_POLY1305 ) && \
+    defined ( CRYPTO_DIGEST_SHA256 )
+REQUIRE_OBJECT ( ecdhe_ecdsa_chacha20_poly1305_sha256 );
+#endif
+
+/* TLSv1.3 key share, AES-GCM, and SHA-256 */
+#if defined ( CRYPTO_EXCHANGE_KEYSHARE ) && \
+    defined ( CRYPTO_CIPHER_AES_GCM ) && defined ( CRYPTO_DIGEST_SHA256 )
+REQUIRE_OBJECT ( tls13_aes_gcm_sha256 );
+#endif
+
+/* TLSv1.3 key share, AES-GCM, and SHA-384 */
+#if defined ( CRYPTO_EXCHANGE_KEYSHARE ) && \
+    defined ( CRYPTO_CIPHER_AES_GCM ) && defined ( CRYPTO_DIGEST_SHA384 )
+REQUIRE_OBJECT ( tls13_aes_gcm_sha384 );
+#endif
+
+/* TLSv1.3 key share, ChaCha20-Poly1305, and SHA-256 */
+#if defined ( CRYPTO_EXCHANGE_KEYSHARE ) && \
+    defined ( CRYPTO_CIPHER_CHACHA20_POLY1305 ) && \
+    defined ( CRYPTO_DIGEST_SHA256 )
+REQUIRE_OBJECT ( tls13_chacha20_poly1305_sha256 );
+#endif
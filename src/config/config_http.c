@@ -47,6 +47,18 @@ REQUIRE_OBJECT ( httpntlm );
 #ifdef HTTP_ENC_PEERDIST
 REQUIRE_OBJECT ( peerdist );
 #endif
+#ifdef HTTP_ENC_GZIP
+REQUIRE_OBJECT ( httpgzip );
+#endif
+#ifdef HTTP_PEERDIST_SERVER
+REQUIRE_OBJECT ( peerserv );
+#endif
 #ifdef HTTP_HACK_GCE
 REQUIRE_OBJECT ( httpgce );
 #endif
+#ifdef HTTP_PARALLEL
+REQUIRE_OBJECT ( httpmux );
+#endif
+#ifdef HTTP_VERSION_2
+REQUIRE_OBJECT ( http2 );
+#endif
@@ -22,6 +22,7 @@
 FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 
 #include <config/console.h>
+#include <config/general.h>
 
 /** @file
  *
@@ -39,3 +40,12 @@ PROVIDE_REQUIRING_SYMBOL();
 #ifdef CONSOLE_LINUX
 REQUIRE_OBJECT ( linux_console );
 #endif
+
+/*
+ * Drag in all requested download protocols
+ *
+ */
+
+#ifdef DOWNLOAD_PROTO_FILE
+REQUIRE_OBJECT ( linux_local );
+#endif
@@ -10,9 +10,19 @@
 FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 FILE_SECBOOT ( PERMITTED );
 
+#include <config/defaults.h>
+
 /** Minimum TLS version */
 #define TLS_VERSION_MIN TLS_VERSION_TLS_1_1
 
+/** TLS session cache timeout (in seconds)
+ *
+ * Session IDs and session tickets are retained for this long after
+ * the last connection to a server has closed, to allow subsequent
+ * connections to resume the session.
+ */
+#define TLS_SESSION_TIMEOUT 300
+
 /** Public-key exchange algorithm */
 #define CRYPTO_EXCHANGE_PUBKEY
 
@@ -22,6 +32,9 @@ FILE_SECBOOT ( PERMITTED );
 /** ECDHE key exchange algorithm */
 #define CRYPTO_EXCHANGE_ECDHE
 
+/** TLSv1.3 key share exchange algorithm */
+#define CRYPTO_EXCHANGE_KEYSHARE
+
 /** RSA public-key algorithm */
 #define CRYPTO_PUBKEY_RSA
 
@@ -34,6 +47,9 @@ FILE_SECBOOT ( PERMITTED );
 /** AES-GCM block cipher */
 #define CRYPTO_CIPHER_AES_GCM
 
+/** ChaCha20-Poly1305 stream cipher */
+#define CRYPTO_CIPHER_CHACHA20_POLY1305
+
 /** MD4 digest algorithm */
 //#define CRYPTO_DIGEST_MD4
 
@@ -32,6 +32,9 @@ FILE_SECBOOT ( PERMITTED );
 #if defined ( __i386__ ) || defined ( __x86_64__ )
 #define IOAPI_X86
 #define ENTROPY_RDRAND
+#define CRYPTO_ACCEL_AESNI
+#define CRYPTO_ACCEL_SHANI
+#define CRYPTO_ACCEL_X86_CRC32
 #define	UNSAFE_STD		/* Avoid setting direction flag */
 #define FDT_NULL
 #endif
@@ -41,6 +44,14 @@ FILE_SECBOOT ( PERMITTED );
 #define FDT_EFI
 #endif
 
+#if defined ( __x86_64__ )
+#define CRYPTO_ACCEL_ADX
+#endif
+
+#if defined ( __aarch64__ )
+#define CRYPTO_ACCEL_ARM64_SHA
+#endif
+
 #if defined ( __loongarch__ )
 #define IOAPI_LOONG64
 #define FDT_EFI
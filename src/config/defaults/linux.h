@@ -30,6 +30,17 @@ FILE_LICENCE ( GPL2_OR_LATER );
 
 #if defined ( __i386__ ) || defined ( __x86_64__ )
 #define ENTROPY_RDRAND
+#define CRYPTO_ACCEL_AESNI
+#define CRYPTO_ACCEL_SHANI
+#define CRYPTO_ACCEL_X86_CRC32
+#endif
+
+#if defined ( __x86_64__ )
+#define CRYPTO_ACCEL_ADX
+#endif
+
+#if defined ( __aarch64__ )
+#define CRYPTO_ACCEL_ARM64_SHA
 #endif
 
 #endif /* CONFIG_DEFAULTS_LINUX_H */
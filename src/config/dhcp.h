@@ -34,8 +34,9 @@ FILE_SECBOOT ( PERMITTED );
 /*
  * ProxyDHCP offers are given precedence by continue to wait for them
  * after a valid DHCPOFFER is received.  We'll wait through this
- * timeout for it.  The PXE spec indicates waiting through the 4 & 8
- * second timeouts, iPXE by default stops after 2.
+ * timeout (measured from the start of discovery, and overlapping with
+ * the DHCPREQUEST) for it.  The PXE spec indicates waiting through the
+ * 4 & 8 second timeouts, iPXE by default stops after 2.
  */
 #define DHCP_DISC_PROXY_TIMEOUT_SEC	2
 //#define DHCP_DISC_PROXY_TIMEOUT_SEC	11	/* as per PXE spec */
@@ -89,6 +90,16 @@ FILE_SECBOOT ( PERMITTED );
 #define PXEBS_MAX_TIMEOUT_SEC		3
 //#define PXEBS_MAX_TIMEOUT_SEC		7	/* as per PXE spec */
 
+/*
+ * A DHCPACK inherited from the PXE stack that loaded iPXE may be
+ * treated as an authoritative lease for up to this many seconds (or
+ * until the lease's renewal time T1, if sooner), in which case DHCP
+ * will not be repeated on that network device.  This is disabled by
+ * default, since the inherited DHCPACK will usually direct the PXE
+ * stack to load iPXE itself.
+ */
+#define DHCP_CACHED_LEASE_SEC		0
+
 #include <config/local/dhcp.h>
 
 #endif /* CONFIG_DHCP_H */
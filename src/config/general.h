@@ -33,6 +33,9 @@ FILE_SECBOOT ( PERMITTED );
   #undef NET_PROTO_LLDP
 #endif
 
+/* TCP congestion control algorithms */
+//#define TCP_CUBIC		/* CUBIC congestion control */
+
 /*****************************************************************************
  *
  * Download protocols
@@ -45,10 +48,11 @@ FILE_SECBOOT ( PERMITTED );
 #define DOWNLOAD_PROTO_HTTPS	/* Secure Hypertext Transfer Protocol */
 //#define DOWNLOAD_PROTO_FTP	/* File Transfer Protocol */
 //#define DOWNLOAD_PROTO_SLAM	/* Scalable Local Area Multicast */
+//#define DOWNLOAD_PROTO_ALC	/* Asynchronous Layered Coding multicast */
 //#define DOWNLOAD_PROTO_NFS	/* Network File System Protocol */
 
 /* Protocols supported only on platforms with filesystem abstractions */
-#if defined ( PLATFORM_efi )
+#if defined ( PLATFORM_efi ) || defined ( PLATFORM_linux )
   #define DOWNLOAD_PROTO_FILE	/* Local filesystem access */
 #endif
 
@@ -57,7 +61,14 @@ FILE_SECBOOT ( PERMITTED );
 #define HTTP_AUTH_DIGEST	/* Digest authentication */
 #define HTTP_AUTH_NTLM		/* NTLM authentication */
 //#define HTTP_ENC_PEERDIST	/* PeerDist content encoding */
+//#define HTTP_ENC_GZIP		/* gzip and deflate content encodings */
+//#define HTTP_PEERDIST_SERVER	/* Serve PeerDist content to peers */
 //#define HTTP_HACK_GCE		/* Google Compute Engine hacks */
+//#define HTTP_PARALLEL		/* Parallel range downloads */
+//#define HTTP_VERSION_2	/* HTTP/2 via TLS ALPN */
+
+/* Download extensions */
+//#define DOWNLOAD_INFLATE	/* Decompression during download */
 
 /* Disable protocols not historically included in BIOS builds */
 #if defined ( PLATFORM_pcbios )
@@ -78,6 +89,8 @@ FILE_SECBOOT ( PERMITTED );
   #define SANBOOT_PROTO_HTTP	/* HTTP SAN protocol */
   #define SANBOOT_PROTO_IB_SRP	/* Infiniband SCSI RDMA protocol */
   #define SANBOOT_PROTO_ISCSI	/* iSCSI protocol */
+  //#define SANBOOT_PROTO_NVME_TCP	/* NVMe/TCP protocol */
+  //#define SANBOOT_PROTO_IMAGE	/* Memory-backed image SAN protocol */
 #endif
 
 /*****************************************************************************
@@ -106,6 +119,7 @@ FILE_SECBOOT ( PERMITTED );
 #define IWMGMT_CMD		/* Wireless interface management commands */
 #define LOGIN_CMD		/* Login command */
 //#define LOTEST_CMD		/* Loopback testing commands */
+//#define MEMSTAT_CMD		/* Memory usage statistics commands */
 #define MENU_CMD		/* Menu commands */
 //#define NEIGHBOUR_CMD		/* Neighbour management commands */
 //#define NSLOOKUP_CMD		/* DNS resolving command */
@@ -114,6 +128,7 @@ FILE_SECBOOT ( PERMITTED );
 #define PARAM_CMD		/* Request parameter commands */
 #define PCI_CMD			/* PCI commands */
 //#define PING_CMD		/* Ping command */
+//#define PREWARM_CMD		/* HTTP connection pre-warming command */
 //#define PROFSTAT_CMD		/* Profiling commands */
 //#define PXE_CMD		/* PXE commands */
 #define ROUTE_CMD		/* Routing table management commands */
@@ -121,9 +136,12 @@ FILE_SECBOOT ( PERMITTED );
 #define SHELL_CMD		/* Shell command */
 #define SHIM_CMD		/* EFI shim command (or dummy command) */
 #define SYNC_CMD		/* Sync command */
+//#define TRACESTAT_CMD		/* Boot-time trace commands */
 //#define TIME_CMD		/* Time commands */
 #define USB_CMD			/* USB commands */
 #define VLAN_CMD		/* VLAN commands */
+//#define BOND_CMD		/* Link aggregation (bonding) commands */
+//#define PCAP_CMD		/* Packet capture commands */
 
 /* Commands supported only on systems capable of rebooting */
 #if ! defined ( REBOOT_NULL )
@@ -166,7 +184,9 @@ FILE_SECBOOT ( PERMITTED );
 //#define IMAGE_PNM		/* PNM graphical image support */
 #define IMAGE_PNG		/* PNG graphical image support */
 #define IMAGE_SCRIPT		/* iPXE script image support */
+//#define IMAGE_XZ		/* xz compressed image support */
 //#define IMAGE_ZLIB		/* ZLIB compressed image support */
+//#define IMAGE_ZSTD		/* Zstandard compressed image support */
 
 /* Image types supported only on BIOS platforms */
 #if defined ( PLATFORM_pcbios )
@@ -223,6 +243,74 @@ FILE_SECBOOT ( PERMITTED );
 #define BANNER_TIMEOUT		20
 #define ROM_BANNER_TIMEOUT	( 2 * BANNER_TIMEOUT )
 
+/*****************************************************************************
+ *
+ * TFTP window size
+ *
+ * This controls the number of data blocks that a TFTP server will be
+ * asked to send before waiting for an acknowledgement, using the
+ * "windowsize" option defined in RFC 7440.  A value of 1 disables
+ * the option, reverting to one acknowledgement per data block.
+ */
+
+#define TFTP_WINDOWSIZE		16
+
+/*****************************************************************************
+ *
+ * Parallel autoboot
+ *
+ * If AUTOBOOT_PARALLEL is defined, then autoboot will configure all
+ * candidate network devices simultaneously and boot from whichever
+ * device completes configuration first, rather than trying each
+ * device in turn.  This avoids waiting through a full configuration
+ * timeout for each unconnected device on multi-port hosts.
+ */
+
+//#define AUTOBOOT_PARALLEL
+
+/*****************************************************************************
+ *
+ * Devirtualised network device operations
+ *
+ * If NETDEV_DIRECT is defined, then the transmit and poll methods of
+ * a network driver that provides devirtualised operations will be
+ * called directly rather than via function pointers.  This avoids
+ * the cost of an indirect call (which may be substantial when
+ * retpolines are in use) for every packet in single-driver builds
+ * such as "bin-x86_64-efi/intel.efi".
+ */
+
+//#define NETDEV_DIRECT
+
+/*****************************************************************************
+ *
+ * Script connection prefetching
+ *
+ * If SCRIPT_PREFETCH is defined, then executing a script will first
+ * open pooled connections to the HTTP(S) servers referenced by any
+ * image fetching commands (such as "chain" or "initrd") within the
+ * script, so that DNS resolution and connection setup take place in
+ * the background while earlier commands are executing.
+ *
+ * This is disabled by default, since connections will be opened to
+ * every server named anywhere within the script (including within
+ * menu branches that are never taken), generating unsolicited
+ * traffic and server load.
+ */
+
+//#define SCRIPT_PREFETCH
+
+/*****************************************************************************
+ *
+ * Persistent image cache
+ *
+ * If IMAGE_CACHE is defined, then downloaded images may be cached on
+ * local storage at the location given by the "imgcache" setting, and
+ * revalidated against the server using a conditional request.
+ */
+
+//#define IMAGE_CACHE
+
 /*****************************************************************************
  *
  * ROM-specific options
@@ -230,6 +318,7 @@ FILE_SECBOOT ( PERMITTED );
  */
 
 #define AUTOBOOT_ROM_FILTER	/* Autoboot only devices matching our ROM */
+//#define PROBE_ROM_FILTER	/* Probe only the device matching our ROM */
 //#define NONPNP_HOOK_INT19	/* Hook INT19 on non-PnP BIOSes */
 
 /*****************************************************************************
@@ -0,0 +1,122 @@
+#ifndef CONFIG_NETDEV_H
+#define CONFIG_NETDEV_H
+
+/** @file
+ *
+ * Network device driver configuration
+ *
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+FILE_SECBOOT ( PERMITTED );
+
+#include <config/defaults.h>
+
+/*
+ * Intel 10/100/1000 (intel) descriptor rings
+ *
+ * Ring sizes must be a multiple of 8 descriptors, and must not exceed
+ * INTEL_MAX_NUM_RX_DESC receive descriptors.
+ */
+#define INTEL_NUM_RX_DESC	64	/* Number of receive descriptors */
+#define INTEL_RX_FILL		48	/* Receive descriptor ring fill level */
+#define INTEL_NUM_TX_DESC	32	/* Number of transmit descriptors */
+
+/*
+ * Intel 10 Gigabit (intelx and intelxvf) descriptor rings
+ *
+ * The same constraints apply as for the intel driver.
+ */
+#define INTELX_NUM_RX_DESC	128	/* Number of receive descriptors */
+#define INTELX_RX_FILL		96	/* Receive descriptor ring fill level */
+#define INTELX_NUM_TX_DESC	64	/* Number of transmit descriptors */
+
+/*
+ * Intel 40 Gigabit and 100 Gigabit (intelxl, intelxlvf and ice)
+ * descriptor rings
+ *
+ * The number of receive descriptors must be a multiple of 32 and at
+ * least 64.  The receive fill level must be a multiple of 8, greater
+ * than 8, and less than the number of transmit descriptors.
+ */
+#define INTELXL_RX_NUM_DESC	256	/* Number of receive descriptors */
+#define INTELXL_RX_FILL		128	/* Receive descriptor ring fill level */
+#define INTELXL_TX_NUM_DESC	256	/* Number of transmit descriptors */
+
+/*
+ * VMware vmxnet3 descriptor rings
+ *
+ * Ring sizes must be a power of two and at least 32 descriptors.
+ * Fill levels must not exceed the corresponding ring size.
+ */
+#define VMXNET3_NUM_RX_DESC	64	/* Number of receive descriptors */
+#define VMXNET3_RX_FILL		48	/* Receive descriptor ring fill level */
+#define VMXNET3_NUM_RX_BODY	32	/* Number of receive body descriptors */
+#define VMXNET3_RX_BODY_FILL	24	/* Receive body ring fill level */
+#define VMXNET3_NUM_TX_DESC	64	/* Number of transmit descriptors */
+
+/*
+ * Xen netfront descriptor rings
+ *
+ * Ring sizes must be a power of two, must not exceed 256 entries,
+ * and must fit within a single shared ring page.  Each receive and
+ * transmit descriptor has a dedicated, permanently granted page.
+ */
+#define NETFRONT_NUM_RX_DESC	64	/* Number of receive descriptors */
+#define NETFRONT_NUM_TX_DESC	64	/* Number of transmit descriptors */
+
+/*
+ * Broadcom NetXtreme-C/E (bnxt) receive buffers
+ *
+ * The number of receive buffers must be a power of two.  The receive
+ * descriptor ring is sized at twice the number of buffers.
+ */
+#define BNXT_NUM_RX_BUFFERS	32	/* Number of receive buffers */
+
+/*
+ * Hyper-V network virtual service client (netvsc) buffers
+ *
+ * The VMBus ring length applies to each of the inbound and outbound
+ * ring buffers, and must be a power of two and a multiple of the
+ * page size.  The number of transmit descriptors must be a power of
+ * two, must not exceed 256, and must be small enough that the
+ * outbound ring buffer can never run out of space.  The receive
+ * buffer length must be a multiple of the page size.
+ */
+#define NETVSC_RING_LEN		16384	/* VMBus ring buffer length */
+#define NETVSC_TX_NUM_DESC	64	/* Number of transmit descriptors */
+#define NETVSC_RX_BUF_LEN	1048576	/* Receive buffer length */
+
+/*
+ * USB CDC-ECM (ecm) and CDC-NCM (ncm) transfers
+ *
+ * The CDC-NCM bulk IN ring uses at least NCM_IN_MIN_COUNT buffers
+ * totalling at least NCM_IN_MIN_SIZE bytes, using the largest NTB
+ * input size supported by the device for which the ring does not
+ * exceed NCM_IN_MAX_SIZE bytes.  Transmitted packets are aggregated
+ * into a single NTB while at least NCM_OUT_MAX_FILL bulk OUT
+ * transfers are in progress.  NCM_OUT_MAX_SIZE must not exceed
+ * 65535 bytes.
+ */
+#define ECM_IN_MAX_FILL		16	/* Bulk IN maximum fill level */
+#define NCM_IN_MIN_COUNT	4	/* Bulk IN minimum buffer count */
+#define NCM_IN_MIN_SIZE		32768	/* Bulk IN minimum total size */
+#define NCM_IN_MAX_SIZE		262144	/* Bulk IN maximum total size */
+#define NCM_OUT_MAX_FILL	2	/* Bulk OUT fill level for aggregation */
+#define NCM_OUT_MAX_DATAGRAMS	16	/* Maximum datagrams per OUT NTB */
+#define NCM_OUT_MAX_SIZE	16384	/* Maximum OUT NTB size */
+
+/*
+ * EFI SNP interface (efi_snp) queues
+ *
+ * These limit the number of received packets held for collection by
+ * an external SNP consumer, and the number of transmit completions
+ * held for collection via GetStatus().  The transmit completion
+ * ring size must be a power of two.
+ */
+#define EFI_SNP_NUM_TX		64	/* Transmit completion ring size */
+#define EFI_SNP_MAX_RX		256	/* Maximum receive queue length */
+
+#include <config/local/netdev.h>
+
+#endif /* CONFIG_NETDEV_H */
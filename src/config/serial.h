@@ -26,6 +26,12 @@ FILE_LICENCE ( GPL2_OR_LATER );
 #define	COMSPEED	115200		/* Baud rate */
 #endif
 
+/* Transmit buffer size (a power of two, or zero to disable buffering).
+ * Buffered output is transmitted in the background, but may be lost
+ * if the system hangs before it has been transmitted.
+ */
+#define	COMTXBUF	1024
+
 /* Uncomment these to ignore the ACPI SPCR table (if present) */
 //#undef SERIAL_SPCR
 //#define SERIAL_FIXED
@@ -15,6 +15,11 @@ FILE_SECBOOT ( PERMITTED );
 //#undef		TIMER_PCBIOS
 //#define		TIMER_RDTSC
 
+/* Interpolate EFI timer ticks using the CPU cycle counter */
+#if defined ( __i386__ ) || defined ( __x86_64__ ) || defined ( __aarch64__ )
+  #define		TIMER_EFI_HIRES
+#endif
+
 #include <config/local/timer.h>
 
 #endif /* CONFIG_TIMER_H */
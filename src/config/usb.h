@@ -21,6 +21,9 @@ FILE_SECBOOT ( PERMITTED );
 #define USB_BLOCK		/* USB block devices */
 #define USB_KEYBOARD		/* USB keyboards */
 
+/* USB device attachment */
+//#define USB_DEFER_ATTACH	/* Attach devices in background after startup */
+
 /* USB quirks on EFI platforms */
 #if defined ( PLATFORM_efi )
   #define USB_EFI		/* Provide EFI_USB_IO_PROTOCOL interface */
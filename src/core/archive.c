@@ -27,6 +27,7 @@ FILE_SECBOOT ( PERMITTED );
 #include <string.h>
 #include <errno.h>
 #include <ipxe/image.h>
+#include <ipxe/trace.h>
 
 /** @file
  *
@@ -75,6 +76,7 @@ int image_extract ( struct image *image, const char *name,
 		       image->name, strerror ( rc ) );
 		goto err_extract;
 	}
+	trace ( "image", "extract", *extracted, 0 );
 
 	/* Register image */
 	if ( ( rc = register_image ( *extracted ) ) != 0 )
@@ -0,0 +1,534 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+FILE_SECBOOT ( PERMITTED );
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <ipxe/timer.h>
+#include <ipxe/blockcache.h>
+
+/** @file
+ *
+ * Block device cache
+ *
+ */
+
+/** Maximum number of dirty extents */
+#define BLOCK_CACHE_MAX_EXTENTS 32
+
+/**
+ * Free cache lines
+ *
+ * @v cache		Block cache
+ */
+static void block_cache_free_lines ( struct block_cache *cache ) {
+
+	free ( cache->line );
+	cache->line = NULL;
+	cache->stream = NULL;
+	cache->blocks = 0;
+	cache->ahead = 0;
+	INIT_LIST_HEAD ( &cache->lines );
+}
+
+/**
+ * Discard dirty extent
+ *
+ * @v cache		Block cache
+ * @v extent		Dirty extent
+ */
+static void block_cache_forget ( struct block_cache *cache,
+				 struct block_cache_extent *extent ) {
+
+	list_del ( &extent->list );
+	cache->extents--;
+	cache->dirty_len -= ( extent->count * cache->blksize );
+	free ( extent );
+}
+
+/**
+ * Free block cache
+ *
+ * @v cache		Block cache
+ *
+ * Any dirty data that has not been flushed is discarded.
+ */
+void block_cache_free ( struct block_cache *cache ) {
+	struct block_cache_extent *extent;
+	struct block_cache_extent *tmp;
+
+	/* Free cache lines */
+	block_cache_free_lines ( cache );
+
+	/* Discard any dirty extents */
+	list_for_each_entry_safe ( extent, tmp, &cache->dirty, list )
+		block_cache_forget ( cache, extent );
+}
+
+/**
+ * Allocate block cache
+ *
+ * @v cache		Block cache
+ * @v blksize		Block size
+ * @v capacity		Underlying device capacity (in blocks)
+ * @v blocks		Number of blocks per cache line
+ * @v count		Number of cache lines
+ * @ret rc		Return status code
+ *
+ * The cache will be left disabled if either @c blocks or @c count is
+ * zero, or if allocation fails.  Up to half of the cache lines may be
+ * filled by a single sequential read-ahead, which requires an
+ * additional buffer of that size.  Any dirty data is retained.
+ */
+int block_cache_alloc ( struct block_cache *cache, size_t blksize,
+			uint64_t capacity, unsigned int blocks,
+			unsigned int count ) {
+	struct block_cache_line *line;
+	size_t len = ( blocks * blksize );
+	unsigned int ahead;
+	void *data;
+	unsigned int i;
+
+	/* Free any existing cache lines */
+	block_cache_free_lines ( cache );
+	cache->blksize = blksize;
+	cache->capacity = capacity;
+
+	/* Do nothing if cache is disabled */
+	if ( ! ( blocks && count ) )
+		return 0;
+
+	/* Calculate maximum sequential read-ahead */
+	ahead = ( count / 2 );
+	if ( ! ahead )
+		ahead = 1;
+
+	/* Allocate cache lines, data buffers, and read-ahead buffer */
+	cache->line = zalloc ( ( count * ( sizeof ( *line ) + len ) ) +
+			       ( ( ahead > 1 ) ? ( ahead * len ) : 0 ) );
+	if ( ! cache->line )
+		return -ENOMEM;
+	data = &cache->line[count];
+	for ( i = 0 ; i < count ; i++ ) {
+		line = &cache->line[i];
+		line->data = ( data + ( i * len ) );
+		list_add_tail ( &line->list, &cache->lines );
+	}
+	if ( ahead > 1 )
+		cache->stream = ( data + ( count * len ) );
+	cache->blocks = blocks;
+	cache->ahead = ahead;
+	cache->streak = 0;
+	cache->next = ~( ( uint64_t ) 0 );
+
+	return 0;
+}
+
+/**
+ * Find cache line starting at a given block
+ *
+ * @v cache		Block cache
+ * @v start		Starting logical block address
+ * @ret line		Cache line, or NULL if not present
+ */
+static struct block_cache_line * block_cache_find ( struct block_cache *cache,
+						    uint64_t start ) {
+	struct block_cache_line *line;
+
+	list_for_each_entry ( line, &cache->lines, list ) {
+		if ( line->count && ( line->lba == start ) )
+			return line;
+	}
+	return NULL;
+}
+
+/**
+ * Fill cache lines from underlying device
+ *
+ * @v cache		Block cache
+ * @v start		Starting logical block address (aligned to a line)
+ * @ret line		Cache line containing starting block
+ * @ret rc		Return status code
+ */
+static int block_cache_fill ( struct block_cache *cache, uint64_t start,
+			      struct block_cache_line **line ) {
+	struct block_cache_line *tmp;
+	unsigned int lines;
+	unsigned int count;
+	unsigned int frag;
+	unsigned int i;
+	uint64_t lba;
+	void *buffer;
+	int rc;
+
+	/* Extend read-ahead window for sequential streams */
+	if ( start == cache->next ) {
+		if ( ( 1U << cache->streak ) < cache->ahead )
+			cache->streak++;
+	} else {
+		cache->streak = 0;
+	}
+	lines = ( 1U << cache->streak );
+	if ( lines > cache->ahead )
+		lines = cache->ahead;
+
+	/* Stop read-ahead at the first line already present */
+	for ( i = 1 ; i < lines ; i++ ) {
+		if ( block_cache_find ( cache,
+					( start + ( i * cache->blocks ) ) ) )
+			break;
+	}
+	lines = i;
+
+	/* Truncate at end of device */
+	count = ( lines * cache->blocks );
+	if ( ( start + count ) > cache->capacity )
+		count = ( cache->capacity - start );
+	lines = ( ( count + cache->blocks - 1 ) / cache->blocks );
+
+	/* Read directly into least recently used line, or into the
+	 * read-ahead buffer if filling multiple lines.
+	 */
+	tmp = list_last_entry ( &cache->lines, struct block_cache_line, list );
+	tmp->count = 0;
+	buffer = ( ( lines > 1 ) ? cache->stream : tmp->data );
+	if ( ( rc = cache->op->read ( cache, start, count, buffer ) ) != 0 )
+		return rc;
+	cache->next = ( start + count );
+
+	/* Refill least recently used lines, leaving the line
+	 * containing the starting block as the most recently used.
+	 */
+	for ( i = lines ; i-- ; ) {
+		lba = ( start + ( i * cache->blocks ) );
+		frag = ( start + count - lba );
+		if ( frag > cache->blocks )
+			frag = cache->blocks;
+		tmp = list_last_entry ( &cache->lines, struct block_cache_line,
+					list );
+		if ( buffer != tmp->data ) {
+			memcpy ( tmp->data, ( buffer + ( i * cache->blocks *
+							 cache->blksize ) ),
+				 ( frag * cache->blksize ) );
+		}
+		tmp->lba = lba;
+		tmp->count = frag;
+		list_del ( &tmp->list );
+		list_add ( &tmp->list, &cache->lines );
+	}
+
+	*line = tmp;
+	return 0;
+}
+
+/**
+ * Get cache line containing a block
+ *
+ * @v cache		Block cache
+ * @v lba		Logical block address
+ * @ret line		Cache line
+ * @ret rc		Return status code
+ */
+static int block_cache_line ( struct block_cache *cache, uint64_t lba,
+			      struct block_cache_line **line ) {
+	struct block_cache_line *tmp;
+	uint64_t start = ( lba - ( lba % cache->blocks ) );
+	int rc;
+
+	/* Find existing line, if present */
+	tmp = block_cache_find ( cache, start );
+	if ( tmp ) {
+		cache->hits++;
+	} else {
+		cache->misses++;
+		if ( ( rc = block_cache_fill ( cache, start, &tmp ) ) != 0 )
+			return rc;
+	}
+
+	/* Mark as most recently used */
+	list_del ( &tmp->list );
+	list_add ( &tmp->list, &cache->lines );
+	*line = tmp;
+	return 0;
+}
+
+/**
+ * Read from block device via cache lines
+ *
+ * @v cache		Block cache
+ * @v lba		Starting logical block address
+ * @v count		Number of logical blocks
+ * @v buffer		Data buffer
+ * @ret rc		Return status code
+ */
+static int block_cache_read_lines ( struct block_cache *cache, uint64_t lba,
+				    unsigned int count, void *buffer ) {
+	struct block_cache_line *line;
+	unsigned int offset;
+	unsigned int frag;
+	int rc;
+
+	/* Bypass cache if disabled, or for reads of at least a whole
+	 * line (which gain nothing from read-ahead).
+	 */
+	if ( count >= cache->blocks )
+		goto direct;
+
+	/* Read via cache lines */
+	while ( count ) {
+
+		/* Bypass cache for any blocks beyond the end of the
+		 * device (and let the device report the error).
+		 */
+		if ( lba >= cache->capacity )
+			goto direct;
+
+		/* Get cache line */
+		if ( ( rc = block_cache_line ( cache, lba, &line ) ) != 0 )
+			return rc;
+
+		/* Copy out data */
+		offset = ( lba - line->lba );
+		frag = ( line->count - offset );
+		if ( frag > count )
+			frag = count;
+		memcpy ( buffer, ( line->data + ( offset * cache->blksize ) ),
+			 ( frag * cache->blksize ) );
+
+		/* Move to next line */
+		buffer += ( frag * cache->blksize );
+		lba += frag;
+		count -= frag;
+	}
+
+	return 0;
+
+ direct:
+	return cache->op->read ( cache, lba, count, buffer );
+}
+
+/**
+ * Read from block device via cache
+ *
+ * @v cache		Block cache
+ * @v lba		Starting logical block address
+ * @v count		Number of logical blocks
+ * @v buffer		Data buffer
+ * @ret rc		Return status code
+ */
+int block_cache_read ( struct block_cache *cache, uint64_t lba,
+		       unsigned int count, void *buffer ) {
+	struct block_cache_extent *extent;
+	uint64_t start;
+	uint64_t end;
+	int rc;
+
+	/* Read via cache lines */
+	if ( ( rc = block_cache_read_lines ( cache, lba, count,
+					     buffer ) ) != 0 )
+		return rc;
+
+	/* Overlay any dirty data not yet written to the device */
+	list_for_each_entry ( extent, &cache->dirty, list ) {
+		start = extent->lba;
+		if ( start < lba )
+			start = lba;
+		end = ( extent->lba + extent->count );
+		if ( end > ( lba + count ) )
+			end = ( lba + count );
+		if ( start >= end )
+			continue;
+		memcpy ( ( buffer + ( ( start - lba ) * cache->blksize ) ),
+			 ( extent->data +
+			   ( ( start - extent->lba ) * cache->blksize ) ),
+			 ( ( end - start ) * cache->blksize ) );
+	}
+
+	return 0;
+}
+
+/**
+ * Invalidate cached blocks
+ *
+ * @v cache		Block cache
+ * @v lba		Starting logical block address
+ * @v count		Number of logical blocks
+ */
+void block_cache_invalidate ( struct block_cache *cache, uint64_t lba,
+			      unsigned int count ) {
+	struct block_cache_line *line;
+	struct block_cache_line *tmp;
+
+	/* Empty any overlapping lines, marking them as least recently
+	 * used so that they will be reused first.
+	 */
+	list_for_each_entry_safe ( line, tmp, &cache->lines, list ) {
+		if ( line->count && ( lba < ( line->lba + line->count ) ) &&
+		     ( ( lba + count ) > line->lba ) ) {
+			line->count = 0;
+			list_del ( &line->list );
+			list_add_tail ( &line->list, &cache->lines );
+		}
+	}
+}
+
+/**
+ * Write dirty data to block device
+ *
+ * @v cache		Block cache
+ * @ret rc		Return status code
+ *
+ * Dirty extents are written in order of block address.  On failure,
+ * any extents not yet written remain dirty.
+ */
+int block_cache_flush ( struct block_cache *cache ) {
+	struct block_cache_extent *extent;
+	int rc;
+
+	/* Write out each dirty extent in turn */
+	while ( ( extent = list_first_entry ( &cache->dirty,
+					      struct block_cache_extent,
+					      list ) ) ) {
+		if ( ( rc = cache->op->write ( cache, extent->lba,
+					       extent->count,
+					       extent->data ) ) != 0 )
+			return rc;
+		block_cache_forget ( cache, extent );
+	}
+
+	return 0;
+}
+
+/**
+ * Write to block device via cache
+ *
+ * @v cache		Block cache
+ * @v lba		Starting logical block address
+ * @v count		Number of logical blocks
+ * @v buffer		Data buffer
+ * @ret rc		Return status code
+ *
+ * If write-back is enabled, the data is held as a dirty extent
+ * (coalesced with any adjacent or overlapping dirty extents) until
+ * the next call to block_cache_flush().  Existing dirty data is
+ * flushed first if holding the new data would exceed the configured
+ * limits, and writes larger than the limit are passed straight
+ * through to the underlying device.
+ */
+int block_cache_write ( struct block_cache *cache, uint64_t lba,
+			unsigned int count, void *buffer ) {
+	struct block_cache_extent *extent;
+	struct block_cache_extent *tmp;
+	struct block_cache_extent *merged;
+	struct list_head *pos;
+	size_t blksize = cache->blksize;
+	unsigned int extents;
+	size_t dirty_len;
+	uint64_t start;
+	uint64_t end;
+	size_t len;
+	int dirty;
+	int rc;
+
+	/* Discard any stale cached data */
+	block_cache_invalidate ( cache, lba, count );
+
+	/* Write through unless write-back is enabled */
+	if ( ! cache->dirty_max )
+		goto direct;
+
+	/* Calculate extent covering all touching dirty extents */
+	start = lba;
+	end = ( lba + count );
+	extents = ( cache->extents + 1 );
+	dirty_len = cache->dirty_len;
+	list_for_each_entry ( extent, &cache->dirty, list ) {
+		if ( ( extent->lba > ( lba + count ) ) ||
+		     ( ( extent->lba + extent->count ) < lba ) )
+			continue;
+		if ( start > extent->lba )
+			start = extent->lba;
+		if ( end < ( extent->lba + extent->count ) )
+			end = ( extent->lba + extent->count );
+		extents--;
+		dirty_len -= ( extent->count * blksize );
+	}
+	len = ( ( end - start ) * blksize );
+	dirty_len += len;
+
+	/* Flush existing dirty data if limits would be exceeded */
+	if ( ( dirty_len > cache->dirty_max ) ||
+	     ( extents > BLOCK_CACHE_MAX_EXTENTS ) ) {
+		if ( ( rc = block_cache_flush ( cache ) ) != 0 )
+			return rc;
+		start = lba;
+		end = ( lba + count );
+		len = ( count * blksize );
+		if ( len > cache->dirty_max )
+			goto direct;
+	}
+
+	/* Allocate coalesced extent */
+	merged = malloc ( sizeof ( *merged ) + len );
+	if ( ! merged )
+		goto direct;
+	merged->lba = start;
+	merged->count = ( end - start );
+
+	/* Absorb touching dirty extents, and find insertion point */
+	dirty = block_cache_is_dirty ( cache );
+	pos = &cache->dirty;
+	list_for_each_entry_safe ( extent, tmp, &cache->dirty, list ) {
+		if ( ( extent->lba > ( lba + count ) ) ||
+		     ( ( extent->lba + extent->count ) < lba ) ) {
+			if ( ( pos == &cache->dirty ) &&
+			     ( extent->lba > start ) )
+				pos = &extent->list;
+			continue;
+		}
+		memcpy ( ( merged->data + ( ( extent->lba - start ) *
+					    blksize ) ),
+			 extent->data, ( extent->count * blksize ) );
+		block_cache_forget ( cache, extent );
+	}
+	memcpy ( ( merged->data + ( ( lba - start ) * blksize ) ), buffer,
+		 ( count * blksize ) );
+
+	/* Add to list of dirty extents */
+	list_add_tail ( &merged->list, pos );
+	cache->extents++;
+	cache->dirty_len += len;
+	if ( ! dirty )
+		cache->dirtied = currticks();
+
+	return 0;
+
+ direct:
+	/* Write out any dirty data first, to preserve ordering */
+	if ( ( rc = block_cache_flush ( cache ) ) != 0 )
+		return rc;
+	return cache->op->write ( cache, lba, count, buffer );
+}
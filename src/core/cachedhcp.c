@@ -34,7 +34,9 @@ FILE_SECBOOT ( PERMITTED );
 #include <ipxe/vlan.h>
 #include <ipxe/uaccess.h>
 #include <ipxe/uri.h>
+#include <ipxe/timer.h>
 #include <ipxe/cachedhcp.h>
+#include <config/dhcp.h>
 
 /** @file
  *
@@ -76,6 +78,14 @@ struct cached_dhcp_packet cached_pxebs = {
 	.name = PXEBS_SETTINGS_NAME,
 };
 
+/** Cached DHCP lease */
+static struct {
+	/** DHCPACK applied to a network device (if any) */
+	struct dhcp_packet *dhcppkt;
+	/** Time at which lease is no longer authoritative (in ticks) */
+	unsigned long expiry;
+} cached_lease;
+
 /** List of cached DHCP packets */
 static struct cached_dhcp_packet *cached_packets[] = {
 	&cached_dhcpack,
@@ -97,6 +107,42 @@ static void cachedhcp_free ( struct cached_dhcp_packet *cache ) {
 	cache->dhcppkt = NULL;
 }
 
+/**
+ * Record cached DHCPACK as an authoritative lease, if applicable
+ *
+ * @v dhcppkt		DHCPACK applied to a network device
+ */
+static void cachedhcp_lease ( struct dhcp_packet *dhcppkt ) {
+	unsigned long lifetime = DHCP_CACHED_LEASE_SEC;
+	unsigned long renewal;
+	uint32_t value;
+
+	/* Do nothing unless enabled */
+	if ( ! lifetime )
+		return;
+
+	/* Limit to the renewal time (T1), which defaults to half of
+	 * the lease time.
+	 */
+	if ( dhcppkt_fetch ( dhcppkt, DHCP_RENEWAL_TIME, &value,
+			     sizeof ( value ) ) == sizeof ( value ) ) {
+		renewal = ntohl ( value );
+	} else if ( dhcppkt_fetch ( dhcppkt, DHCP_LEASE_TIME, &value,
+				    sizeof ( value ) ) == sizeof ( value ) ) {
+		renewal = ( ntohl ( value ) / 2 );
+	} else {
+		renewal = 0;
+	}
+	if ( lifetime > renewal )
+		lifetime = renewal;
+	DBGC ( colour, "CACHEDHCP lease authoritative for %lds\n", lifetime );
+
+	/* Record lease */
+	dhcppkt_put ( cached_lease.dhcppkt );
+	cached_lease.dhcppkt = dhcppkt_get ( dhcppkt );
+	cached_lease.expiry = ( currticks() + ( lifetime * TICKS_PER_SEC ) );
+}
+
 /**
  * Apply cached DHCP packet settings
  *
@@ -188,6 +234,10 @@ static int cachedhcp_apply ( struct cached_dhcp_packet *cache,
 	/* Mark as used */
 	cache->flags |= CACHEDHCP_USED;
 
+	/* Record lease, if applicable */
+	if ( netdev && ( cache == &cached_dhcpack ) )
+		cachedhcp_lease ( cache->dhcppkt );
+
 	/* Free cached DHCP packet, if applicable */
 	if ( ! ( cache->flags & CACHEDHCP_RETAIN ) )
 		cachedhcp_free ( cache );
@@ -367,6 +417,10 @@ static void cachedhcp_shutdown ( int booting __unused ) {
 		       cached_dhcpack.name );
 	}
 	cachedhcp_free ( &cached_dhcpack );
+
+	/* Forget any cached lease */
+	dhcppkt_put ( cached_lease.dhcppkt );
+	cached_lease.dhcppkt = NULL;
 }
 
 /** Cached DHCP packet early startup function */
@@ -422,3 +476,26 @@ void cachedhcp_recycle ( struct net_device *netdev ) {
 		cache->flags &= ~CACHEDHCP_USED;
 	}
 }
+
+/**
+ * Check if cached DHCPACK is an authoritative lease for network device
+ *
+ * @v netdev		Network device
+ * @ret leased		Cached DHCPACK is an authoritative lease
+ */
+int cachedhcp_leased ( struct net_device *netdev ) {
+	struct settings *settings;
+
+	/* Check that the cached DHCPACK is still in use by this device */
+	settings = find_child_settings ( netdev_settings ( netdev ),
+					 DHCP_SETTINGS_NAME );
+	if ( ! ( cached_lease.dhcppkt &&
+		 ( settings == &cached_lease.dhcppkt->settings ) ) )
+		return 0;
+
+	/* Check that the lease has not reached its renewal time */
+	if ( ( ( signed long ) ( currticks() - cached_lease.expiry ) ) >= 0 )
+		return 0;
+
+	return 1;
+}
@@ -101,8 +101,11 @@ int getchar ( void ) {
 		 * power dissipation of a modern CPU considerably, and also
 		 * makes Etherboot waiting for user interaction waste a lot
 		 * less CPU time in a VMware session.
+		 *
+		 * Don't doze if any background tasks have work to do.
 		 */
-		cpu_nap();
+		if ( ! process_runnable() )
+			cpu_nap();
 
 		/* Keep processing background tasks while we wait for
 		 * input.
@@ -132,6 +135,26 @@ int iskey ( void ) {
 	return has_input() ? 1 : 0;
 }
 
+/**
+ * Check for pending output on any console
+ *
+ * @ret is_pending	Output is pending on a console
+ *
+ * This can be used to avoid generating output (such as progress
+ * updates) that would only add to a backlog of untransmitted output.
+ */
+int console_pending ( void ) {
+	struct console_driver *console;
+
+	for_each_table_entry ( console, CONSOLES ) {
+		if ( ( ! ( console->disabled & CONSOLE_DISABLED_OUTPUT ) ) &&
+		     ( console_usage & console->usage ) &&
+		     console->pending && console->pending() )
+			return 1;
+	}
+	return 0;
+}
+
 /**
  * Configure console
  *
@@ -35,7 +35,10 @@ FILE_SECBOOT ( PERMITTED );
 #include <ipxe/umalloc.h>
 #include <ipxe/image.h>
 #include <ipxe/xferbuf.h>
+#include <ipxe/inflate.h>
 #include <ipxe/downloader.h>
+#include <ipxe/imgcache.h>
+#include <ipxe/trace.h>
 
 /** @file
  *
@@ -57,6 +60,17 @@ struct downloader {
 	struct image *image;
 	/** Data transfer buffer */
 	struct xfer_buffer buffer;
+	/** Pre-placement has been attempted */
+	int placed;
+	/** Download flags */
+	unsigned int flags;
+
+	/** Entity tag of cached content, if any */
+	char *etag;
+	/** Cached content is current */
+	int current;
+	/** Entity tag of received content, if any */
+	char *validator;
 };
 
 /**
@@ -69,10 +83,60 @@ static void downloader_free ( struct refcnt *refcnt ) {
 		container_of ( refcnt, struct downloader, refcnt );
 
 	xferbuf_free ( &downloader->buffer );
+	free ( downloader->etag );
+	free ( downloader->validator );
 	image_put ( downloader->image );
 	free ( downloader );
 }
 
+/**
+ * Open data transfer interface
+ *
+ * @v downloader	Downloader
+ * @ret rc		Return status code
+ */
+static int downloader_open ( struct downloader *downloader ) {
+	int rc;
+
+	/* Instantiate child objects and attach to our interfaces */
+	if ( ( rc = xfer_open_uri ( &downloader->xfer,
+				    downloader->image->uri ) ) != 0 )
+		return rc;
+
+	/* Decompress data during download, if applicable */
+	if ( ( downloader->flags & DOWNLOAD_DECOMPRESS ) &&
+	     ( ( rc = add_inflate ( &downloader->xfer ) ) != 0 ) ) {
+		DBGC ( downloader, "DOWNLOADER %p could not decompress: %s\n",
+		       downloader, strerror ( rc ) );
+		return rc;
+	}
+
+	return 0;
+}
+
+/**
+ * Refetch image after failing to load cached content
+ *
+ * @v downloader	Downloader
+ * @ret rc		Return status code
+ */
+static int downloader_refetch ( struct downloader *downloader ) {
+
+	/* Discard cache state, so that the request is unconditional */
+	free ( downloader->etag );
+	downloader->etag = NULL;
+	free ( downloader->validator );
+	downloader->validator = NULL;
+	downloader->current = 0;
+
+	/* Discard any partially loaded content */
+	xferbuf_free ( &downloader->buffer );
+
+	/* Reopen data transfer interface */
+	intf_restart ( &downloader->xfer, 0 );
+	return downloader_open ( downloader );
+}
+
 /**
  * Terminate download
  *
@@ -83,6 +147,26 @@ static void downloader_finished ( struct downloader *downloader, int rc ) {
 	struct xfer_buffer *buffer = &downloader->buffer;
 	struct image *image = downloader->image;
 
+	/* Use cached content or update cache, if applicable */
+	if ( ( rc == 0 ) && downloader->current ) {
+		if ( ( rc = imgcache_load ( image, buffer ) ) != 0 ) {
+			DBGC ( downloader, "DOWNLOADER %p could not load "
+			       "cached content: %s\n", downloader,
+			       strerror ( rc ) );
+			if ( ( rc = downloader_refetch ( downloader ) ) == 0 )
+				return;
+		} else {
+			image_digest_update ( image, 0, buffer->data,
+					      buffer->len );
+		}
+	} else if ( ( rc == 0 ) && downloader->validator ) {
+		imgcache_save ( image, downloader->validator, buffer->data,
+				buffer->len );
+	}
+
+	/* Record trace event */
+	trace ( "download", "finished", image, rc );
+
 	/* Log download status */
 	if ( rc == 0 ) {
 		syslog ( LOG_NOTICE, "Downloaded \"%s\"\n", image->name );
@@ -91,6 +175,10 @@ static void downloader_finished ( struct downloader *downloader, int rc ) {
 			 image->name, strerror ( rc ) );
 	}
 
+	/* Release any spare capacity */
+	if ( rc == 0 )
+		xferbuf_trim ( buffer );
+
 	/* Transfer ownership from data transfer buffer to image */
 	image->data = buffer->data;
 	image->len = buffer->len;
@@ -140,6 +228,56 @@ static int downloader_progress ( struct downloader *downloader,
  *
  */
 
+/**
+ * Attempt to pre-place image data
+ *
+ * @v downloader	Downloader
+ * @v iobuf		I/O buffer containing first received data
+ * @v offset		Offset of received data within file
+ * @ret rc		Return status code
+ *
+ * If the total length is known and the first data received is from
+ * the start of the file, then allow the image type to choose to have
+ * the data downloaded directly to its final load address.
+ */
+static int downloader_place ( struct downloader *downloader,
+			      struct io_buffer *iobuf, size_t offset ) {
+	struct xfer_buffer *buffer = &downloader->buffer;
+	struct image *image = downloader->image;
+	const void *old_data = image->data;
+	size_t old_len = image->len;
+	size_t len = buffer->len;
+	void *data;
+	int rc;
+
+	/* Do nothing unless data starts at the beginning of a file
+	 * of known length.
+	 */
+	if ( offset || ( ! len ) )
+		return 0;
+
+	/* Release buffer before placement, since it may occupy the
+	 * space required for the placement.
+	 */
+	xferbuf_free ( buffer );
+
+	/* Offer initial data to image types */
+	image->data = iobuf->data;
+	image->len = iob_len ( iobuf );
+	data = image_place ( image, len );
+	image->data = old_data;
+	image->len = old_len;
+
+	/* Use pre-placed buffer, or reallocate external heap buffer */
+	if ( data ) {
+		xferbuf_fixed_init ( buffer, data, len );
+	} else if ( ( rc = xferbuf_ensure_size ( buffer, len ) ) != 0 ) {
+		return rc;
+	}
+
+	return 0;
+}
+
 /**
  * Handle received data
  *
@@ -151,15 +289,35 @@ static int downloader_progress ( struct downloader *downloader,
 static int downloader_deliver ( struct downloader *downloader,
 				struct io_buffer *iobuf,
 				struct xfer_metadata *meta ) {
+	struct xfer_buffer *buffer = &downloader->buffer;
+	size_t offset;
 	int rc;
 
+	/* Calculate offset of data within file */
+	offset = ( ( meta->flags & XFER_FL_ABS_OFFSET ) ? 0 : buffer->pos );
+	offset += meta->offset;
+
+	/* Attempt to pre-place image data on first receipt of data */
+	if ( iob_len ( iobuf ) && ( ! downloader->placed ) ) {
+		downloader->placed = 1;
+		if ( ( rc = downloader_place ( downloader, iobuf,
+					       offset ) ) != 0 )
+			goto err_place;
+	}
+
+	/* Accumulate image digest, if applicable */
+	image_digest_update ( downloader->image, offset, iobuf->data,
+			      iob_len ( iobuf ) );
+
 	/* Add data to buffer */
-	if ( ( rc = xferbuf_deliver ( &downloader->buffer, iob_disown ( iobuf ),
+	if ( ( rc = xferbuf_deliver ( buffer, iob_disown ( iobuf ),
 				      meta ) ) != 0 )
 		goto err_deliver;
 
 	return 0;
 
+ err_place:
+	free_iob ( iobuf );
  err_deliver:
 	downloader_finished ( downloader, rc );
 	return rc;
@@ -178,6 +336,65 @@ downloader_buffer ( struct downloader *downloader ) {
 	return &downloader->buffer;
 }
 
+/**
+ * Get entity tag of cached content
+ *
+ * @v downloader	Downloader
+ * @ret etag		Entity tag, or NULL if no content is cached
+ */
+static const char * downloader_etag ( struct downloader *downloader ) {
+
+	return downloader->etag;
+}
+
+/**
+ * Use cached content
+ *
+ * @v downloader	Downloader
+ * @ret rc		Return status code
+ */
+static int downloader_current ( struct downloader *downloader ) {
+
+	/* Fail unless we have cached content */
+	if ( ! downloader->etag )
+		return -ENOENT;
+
+	/* Load cached content on completion */
+	downloader->current = 1;
+	return 0;
+}
+
+/**
+ * Record entity tag of received content
+ *
+ * @v downloader	Downloader
+ * @v etag		Entity tag
+ */
+static void downloader_validator ( struct downloader *downloader,
+				   const char *etag ) {
+
+	/* Record entity tag, ignoring failures */
+	free ( downloader->validator );
+	downloader->validator = strdup ( etag );
+}
+
+/**
+ * Look up cached content
+ *
+ * @v downloader	Downloader
+ */
+static void downloader_lookup ( struct downloader *downloader ) {
+
+	/* Discard any existing cache state */
+	free ( downloader->etag );
+	free ( downloader->validator );
+	downloader->validator = NULL;
+	downloader->current = 0;
+
+	/* Look up image URI, ignoring failures */
+	imgcache_lookup ( downloader->image, &downloader->etag );
+}
+
 /**
  * Redirect data transfer interface
  *
@@ -203,6 +420,9 @@ static int downloader_vredirect ( struct downloader *downloader, int type,
 		/* Set image URI */
 		if ( ( rc = image_set_uri ( downloader->image, uri ) ) != 0 )
 			goto err;
+
+		/* Look up new image URI in cache */
+		downloader_lookup ( downloader );
 	}
 
 	/* Redirect to new location */
@@ -221,6 +441,10 @@ static struct interface_operation downloader_xfer_operations[] = {
 	INTF_OP ( xfer_deliver, struct downloader *, downloader_deliver ),
 	INTF_OP ( xfer_buffer, struct downloader *, downloader_buffer ),
 	INTF_OP ( xfer_vredirect, struct downloader *, downloader_vredirect ),
+	INTF_OP ( imgcache_etag, struct downloader *, downloader_etag ),
+	INTF_OP ( imgcache_current, struct downloader *, downloader_current ),
+	INTF_OP ( imgcache_validator, struct downloader *,
+		  downloader_validator ),
 	INTF_OP ( intf_close, struct downloader *, downloader_finished ),
 };
 
@@ -250,17 +474,68 @@ static struct interface_descriptor downloader_job_desc =
  *
  */
 
+/**
+ * Add decompression filter (when not present)
+ *
+ * @v xfer		Data transfer interface
+ * @ret rc		Return status code
+ */
+__weak int add_inflate ( struct interface *xfer __unused ) {
+	return -ENOTSUP;
+}
+
+/**
+ * Look up cached content (when image cache is not present)
+ *
+ * @v image		Image
+ * @v etag		Entity tag to fill in
+ * @ret rc		Return status code
+ */
+__weak int imgcache_lookup ( struct image *image __unused,
+			     char **etag __unused ) {
+	return -ENOTSUP;
+}
+
+/**
+ * Load cached content (when image cache is not present)
+ *
+ * @v image		Image
+ * @v buffer		Data transfer buffer to fill in
+ * @ret rc		Return status code
+ */
+__weak int imgcache_load ( struct image *image __unused,
+			   struct xfer_buffer *buffer __unused ) {
+	return -ENOTSUP;
+}
+
+/**
+ * Save content to cache (when image cache is not present)
+ *
+ * @v image		Image
+ * @v etag		Entity tag
+ * @v data		Content
+ * @v len		Length of content
+ * @ret rc		Return status code
+ */
+__weak int imgcache_save ( struct image *image __unused,
+			   const char *etag __unused,
+			   const void *data __unused, size_t len __unused ) {
+	return -ENOTSUP;
+}
+
 /**
  * Instantiate a downloader
  *
  * @v job		Job control interface
  * @v image		Image to fill with downloaded file
+ * @v flags		Download flags
  * @ret rc		Return status code
  *
  * Instantiates a downloader object to download the content of the
  * specified image from its URI.
  */
-int create_downloader ( struct interface *job, struct image *image ) {
+int create_downloader ( struct interface *job, struct image *image,
+			unsigned int flags ) {
 	struct downloader *downloader;
 	int rc;
 
@@ -274,13 +549,18 @@ int create_downloader ( struct interface *job, struct image *image ) {
 	intf_init ( &downloader->xfer, &downloader_xfer_desc,
 		    &downloader->refcnt );
 	downloader->image = image_get ( image );
+	downloader->flags = flags;
 	xferbuf_umalloc_init ( &downloader->buffer );
 
-	/* Instantiate child objects and attach to our interfaces */
-	if ( ( rc = xfer_open_uri ( &downloader->xfer, image->uri ) ) != 0 )
+	/* Look up image URI in cache */
+	downloader_lookup ( downloader );
+
+	/* Open data transfer interface */
+	if ( ( rc = downloader_open ( downloader ) ) != 0 )
 		goto err;
 
 	/* Attach parent interface, mortalise self, and return */
+	trace ( "download", "start", image, 0 );
 	intf_plug_plug ( &downloader->job, job );
 	ref_put ( &downloader->refcnt );
 	return 0;
@@ -143,6 +143,70 @@ static void fbcon_clear ( struct fbcon *fbcon, unsigned int ypos ) {
 	}
 }
 
+/**
+ * Render glyph row
+ *
+ * @v fbcon		Frame buffer console
+ * @v dest		Destination pixel row
+ * @v bitmask		Glyph row bitmask
+ * @v foreground	Foreground raw colour
+ * @v background	Background raw colour, or NULL to leave unchanged
+ */
+static void fbcon_render_row ( struct fbcon *fbcon, void *dest,
+			       uint8_t bitmask, const uint32_t *foreground,
+			       const uint32_t *background ) {
+	size_t pixel_len = fbcon->pixel->len;
+	unsigned int column;
+	const void *src;
+
+	for ( column = FBCON_CHAR_WIDTH ; column ;
+	      column--, bitmask <<= 1, dest += pixel_len ) {
+		if ( bitmask & 0x80 ) {
+			src = foreground;
+		} else if ( background ) {
+			src = background;
+		} else {
+			continue;
+		}
+		memcpy ( dest, src, pixel_len );
+	}
+}
+
+/**
+ * Get pre-rendered glyph rows for a colour pair
+ *
+ * @v fbcon		Frame buffer console
+ * @v foreground	Foreground raw colour
+ * @v background	Background raw colour
+ * @ret rows		Pre-rendered rows (indexed by glyph row bitmask)
+ */
+static const void * fbcon_glyph_rows ( struct fbcon *fbcon,
+				       uint32_t foreground,
+				       uint32_t background ) {
+	struct fbcon_glyph_rows *cache;
+	size_t len = fbcon->character.len;
+	unsigned int bitmask;
+	unsigned int i;
+
+	/* Use existing cache entry, if any */
+	for ( i = 0 ; i < FBCON_GLYPH_CACHE ; i++ ) {
+		cache = &fbcon->cache[i];
+		if ( ( cache->foreground == foreground ) &&
+		     ( cache->background == background ) )
+			return cache->rows;
+	}
+
+	/* Otherwise, replace the oldest entry */
+	cache = &fbcon->cache[ fbcon->cache_next++ % FBCON_GLYPH_CACHE ];
+	cache->foreground = foreground;
+	cache->background = background;
+	for ( bitmask = 0 ; bitmask <= 0xff ; bitmask++ ) {
+		fbcon_render_row ( fbcon, ( cache->rows + ( bitmask * len ) ),
+				   bitmask, &foreground, &background );
+	}
+	return cache->rows;
+}
+
 /**
  * Draw character at specified position
  *
@@ -153,15 +217,14 @@ static void fbcon_clear ( struct fbcon *fbcon, unsigned int ypos ) {
  */
 static void fbcon_draw ( struct fbcon *fbcon, struct fbcon_text_cell *cell,
 			 unsigned int xpos, unsigned int ypos ) {
+	uint8_t line[ FBCON_CHAR_WIDTH * sizeof ( uint32_t ) ];
 	const uint8_t *glyph;
+	const void *rows;
 	size_t offset;
-	size_t pixel_len;
-	size_t skip_len;
+	size_t stride;
+	size_t len;
 	unsigned int row;
-	unsigned int column;
-	uint8_t bitmask;
-	int transparent;
-	const void *src;
+	uint32_t background;
 
 	/* Get font character */
 	glyph = fbcon->font->glyph ( cell->character );
@@ -170,61 +233,90 @@ static void fbcon_draw ( struct fbcon *fbcon, struct fbcon_text_cell *cell,
 	offset = ( fbcon->indent +
 		   ( ypos * fbcon->character.stride ) +
 		   ( xpos * fbcon->character.len ) );
-	pixel_len = fbcon->pixel->len;
-	skip_len = ( fbcon->pixel->stride - fbcon->character.len );
-
-	/* Check for transparent background colour */
-	transparent = ( cell->background == FBCON_TRANSPARENT );
+	stride = fbcon->pixel->stride;
+	len = fbcon->character.len;
+	assert ( len <= sizeof ( line ) );
+
+	/* Draw character rows using pre-rendered glyph rows, unless
+	 * we need to blend the character onto a background picture.
+	 * (A transparent background with no background picture is
+	 * equivalent to an opaque black background.)
+	 */
+	background = cell->background;
+	if ( ! ( ( background == FBCON_TRANSPARENT ) &&
+		 fbcon->picture.start ) ) {
+		if ( background == FBCON_TRANSPARENT )
+			background = 0;
+		rows = fbcon_glyph_rows ( fbcon, cell->foreground,
+					  background );
+		for ( row = 0 ; row < fbcon->font->height ; row++ ) {
+			memcpy ( ( fbcon->start + offset ),
+				 ( rows + ( glyph[row] * len ) ), len );
+			offset += stride;
+		}
+		return;
+	}
 
-	/* Draw character rows */
+	/* Otherwise, blend each character row onto the background
+	 * picture and write it to the frame buffer in a single copy.
+	 */
 	for ( row = 0 ; row < fbcon->font->height ; row++ ) {
+		memcpy ( line, ( fbcon->picture.start + offset ), len );
+		fbcon_render_row ( fbcon, line, glyph[row],
+				   &cell->foreground, NULL );
+		memcpy ( ( fbcon->start + offset ), line, len );
+		offset += stride;
+	}
+}
 
-		/* Draw background picture, if applicable */
-		if ( transparent ) {
-			if ( fbcon->picture.start ) {
-				memcpy ( ( fbcon->start + offset ),
-					 ( fbcon->picture.start + offset ),
-					 fbcon->character.len );
-			} else {
-				memset ( ( fbcon->start + offset ), 0,
-					 fbcon->character.len );
-			}
-		}
-
-		/* Draw character row */
-		for ( column = FBCON_CHAR_WIDTH, bitmask = glyph[row] ;
-		      column ; column--, bitmask <<= 1, offset += pixel_len ) {
-			if ( bitmask & 0x80 ) {
-				src = &cell->foreground;
-			} else if ( ! transparent ) {
-				src = &cell->background;
-			} else {
-				continue;
-			}
-			memcpy ( ( fbcon->start + offset ), src, pixel_len );
-		}
+/**
+ * Update character cell
+ *
+ * @v fbcon		Frame buffer console
+ * @v cell		Text cell
+ * @v xpos		X position
+ * @v ypos		Y position
+ * @v character		Unicode character
+ * @v foreground	Foreground raw colour
+ * @v background	Background raw colour
+ *
+ * The cell is redrawn only if its contents have changed.
+ */
+static void fbcon_update ( struct fbcon *fbcon, struct fbcon_text_cell *cell,
+			   unsigned int xpos, unsigned int ypos,
+			   unsigned int character, uint32_t foreground,
+			   uint32_t background ) {
+
+	/* Do nothing if cell is unchanged */
+	if ( ( cell->character == character ) &&
+	     ( cell->foreground == foreground ) &&
+	     ( cell->background == background ) )
+		return;
 
-		/* Move to next row */
-		offset += skip_len;
-	}
+	/* Update and redraw cell */
+	cell->character = character;
+	cell->foreground = foreground;
+	cell->background = background;
+	fbcon_draw ( fbcon, cell, xpos, ypos );
 }
 
 /**
- * Redraw all characters
+ * Erase rows of characters
  *
  * @v fbcon		Frame buffer console
+ * @v ypos		Starting Y position
+ *
+ * Only those cells which are not already blank are redrawn.
  */
-static void fbcon_redraw ( struct fbcon *fbcon ) {
+static void fbcon_erase ( struct fbcon *fbcon, unsigned int ypos ) {
 	struct fbcon_text_cell *cell;
 	unsigned int xpos;
-	unsigned int ypos;
 
-	/* Redraw characters */
-	cell = fbcon_cell ( fbcon, 0, 0 );
-	for ( ypos = 0 ; ypos < fbcon->character.height ; ypos++ ) {
+	cell = fbcon_cell ( fbcon, 0, ypos );
+	for ( ; ypos < fbcon->character.height ; ypos++ ) {
 		for ( xpos = 0 ; xpos < fbcon->character.width ; xpos++ ) {
-			fbcon_draw ( fbcon, cell, xpos, ypos );
-			cell++;
+			fbcon_update ( fbcon, cell++, xpos, ypos, ' ',
+				       fbcon->foreground, fbcon->background );
 		}
 	}
 }
@@ -239,39 +331,57 @@ static void fbcon_scroll ( struct fbcon *fbcon ) {
 	struct fbcon_text_cell *new;
 	unsigned int xpos;
 	unsigned int ypos;
-	unsigned int character;
-	uint32_t foreground;
-	uint32_t background;
+	unsigned int height;
+	unsigned int row;
+	size_t offset;
+	size_t len;
 
 	/* Sanity check */
 	assert ( fbcon->ypos == fbcon->character.height );
+	height = ( fbcon->character.height - 1 );
 
-	/* Scroll up character array */
-	new = fbcon_cell ( fbcon, 0, 0 );
-	old = fbcon_cell ( fbcon, 0, 1 );
-	for ( ypos = 0 ; ypos < ( fbcon->character.height - 1 ) ; ypos++ ) {
-		for ( xpos = 0 ; xpos < fbcon->character.width ; xpos++ ) {
-			/* Redraw character (if changed) */
-			character = old->character;
-			foreground = old->foreground;
-			background = old->background;
-			if ( ( new->character != character ) ||
-			     ( new->foreground != foreground ) ||
-			     ( new->background != background ) ) {
-				new->character = character;
-				new->foreground = foreground;
-				new->background = background;
-				fbcon_draw ( fbcon, new, xpos, ypos );
+	if ( fbcon->picture.start ) {
+
+		/* Characters with a transparent background cannot be
+		 * moved without also moving the background picture,
+		 * so scroll up character array and redraw any
+		 * characters that have changed.
+		 */
+		new = fbcon_cell ( fbcon, 0, 0 );
+		old = fbcon_cell ( fbcon, 0, 1 );
+		for ( ypos = 0 ; ypos < height ; ypos++ ) {
+			for ( xpos = 0 ; xpos < fbcon->character.width ;
+			      xpos++ ) {
+				fbcon_update ( fbcon, new++, xpos, ypos,
+					       old->character, old->foreground,
+					       old->background );
+				old++;
 			}
-			new++;
-			old++;
 		}
+
+	} else {
+
+		/* Move the text area pixel rows up by one character
+		 * row, leaving the margins untouched.
+		 */
+		offset = fbcon->indent;
+		len = ( fbcon->character.width * fbcon->character.len );
+		for ( row = 0 ; row < ( height * fbcon->font->height ) ;
+		      row++ ) {
+			memmove ( ( fbcon->start + offset ),
+				  ( fbcon->start + offset +
+				    fbcon->character.stride ), len );
+			offset += fbcon->pixel->stride;
+		}
+
+		/* Scroll up character array to match */
+		memmove ( fbcon_cell ( fbcon, 0, 0 ), fbcon_cell ( fbcon, 0, 1 ),
+			  ( height * fbcon->character.width *
+			    sizeof ( fbcon->text.cells[0] ) ) );
 	}
 
-	/* Clear bottom row */
-	fbcon_clear ( fbcon, ypos );
-	for ( xpos = 0 ; xpos < fbcon->character.width ; xpos++ )
-		fbcon_draw ( fbcon, new++, xpos, ypos );
+	/* Erase bottom row */
+	fbcon_erase ( fbcon, height );
 
 	/* Update cursor position */
 	fbcon->ypos--;
@@ -338,11 +448,11 @@ static void fbcon_handle_ed ( struct ansiesc_context *ctx,
 	/* We assume that we always clear the whole screen */
 	assert ( params[0] == ANSIESC_ED_ALL );
 
-	/* Clear character array */
-	fbcon_clear ( fbcon, 0 );
+	/* Remove cursor, since its cell may not otherwise be redrawn */
+	fbcon_draw_cursor ( fbcon, 0 );
 
-	/* Redraw all characters */
-	fbcon_redraw ( fbcon );
+	/* Erase all characters, redrawing only those which change */
+	fbcon_erase ( fbcon, 0 );
 
 	/* Reset cursor position */
 	fbcon->xpos = 0;
@@ -587,6 +697,40 @@ static int fbcon_picture_init ( struct fbcon *fbcon,
 	return rc;
 }
 
+/**
+ * Initialise glyph row cache
+ *
+ * @v fbcon		Frame buffer console
+ * @ret rc		Return status code
+ */
+static int fbcon_cache_init ( struct fbcon *fbcon ) {
+	struct fbcon_glyph_rows *cache;
+	size_t len;
+	void *rows;
+	unsigned int i;
+
+	/* Allocate rows for all cache entries */
+	len = ( 256 /* bitmasks */ * fbcon->character.len );
+	rows = umalloc ( FBCON_GLYPH_CACHE * len );
+	if ( ! rows ) {
+		DBGC ( fbcon, "FBCON %p could not allocate glyph cache\n",
+		       fbcon );
+		return -ENOMEM;
+	}
+
+	/* Mark all entries as unused.  The transparent colour value
+	 * can never be passed in as an opaque colour pair.
+	 */
+	for ( i = 0 ; i < FBCON_GLYPH_CACHE ; i++ ) {
+		cache = &fbcon->cache[i];
+		cache->foreground = FBCON_TRANSPARENT;
+		cache->background = FBCON_TRANSPARENT;
+		cache->rows = ( rows + ( i * len ) );
+	}
+
+	return 0;
+}
+
 /**
  * Initialise frame buffer console
  *
@@ -696,6 +840,10 @@ int fbcon_init ( struct fbcon *fbcon, void *start,
 	}
 	fbcon_clear ( fbcon, 0 );
 
+	/* Allocate glyph row cache */
+	if ( ( rc = fbcon_cache_init ( fbcon ) ) != 0 )
+		goto err_cache;
+
 	/* Set framebuffer to all black (including margins) */
 	memset ( fbcon->start, 0, fbcon->len );
 
@@ -715,6 +863,8 @@ int fbcon_init ( struct fbcon *fbcon, void *start,
 
 	ufree ( fbcon->picture.start );
  err_picture:
+	ufree ( fbcon->cache[0].rows );
+ err_cache:
 	ufree ( fbcon->text.cells );
  err_text:
  err_margin:
@@ -729,5 +879,6 @@ int fbcon_init ( struct fbcon *fbcon, void *start,
 void fbcon_fini ( struct fbcon *fbcon ) {
 
 	ufree ( fbcon->text.cells );
+	ufree ( fbcon->cache[0].rows );
 	ufree ( fbcon->picture.start );
 }
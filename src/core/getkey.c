@@ -52,7 +52,8 @@ static int getchar_timeout ( unsigned long timeout ) {
 		step();
 		if ( iskey() )
 			return getchar();
-		cpu_nap();
+		if ( ! process_runnable() )
+			cpu_nap();
 	}
 
 	return -1;
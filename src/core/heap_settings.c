@@ -0,0 +1,280 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+FILE_SECBOOT ( PERMITTED );
+
+#include <string.h>
+#include <errno.h>
+#include <byteswap.h>
+#include <ipxe/init.h>
+#include <ipxe/settings.h>
+#include <ipxe/malloc.h>
+
+/** @file
+ *
+ * Heap usage statistics settings
+ *
+ * Heap settings are numerically encoded as:
+ *
+ *  Bits 31-16	Unused
+ *  Bits 15-8	Heap index (within the heap table)
+ *  Bits 7-0	Statistic
+ */
+
+/** Heap statistics */
+enum heap_statistic {
+	/** Used memory */
+	HEAP_STAT_USED = 0,
+	/** Free memory */
+	HEAP_STAT_FREE,
+	/** Largest free memory block */
+	HEAP_STAT_LARGEST,
+	/** Maximum used memory */
+	HEAP_STAT_MAXUSED,
+	/** Number of successful allocations */
+	HEAP_STAT_ALLOCS,
+	/** Number of times heap has grown */
+	HEAP_STAT_GROWS,
+};
+
+/**
+ * Construct heap setting tag
+ *
+ * @v index		Heap index
+ * @v stat		Statistic
+ * @ret tag		Setting tag
+ */
+#define HEAP_TAG( index, stat ) ( ( (index) << 8 ) | (stat) )
+
+/**
+ * Extract heap index from setting tag
+ *
+ * @v tag		Setting tag
+ * @ret index		Heap index
+ */
+#define HEAP_INDEX( tag ) ( ( (tag) >> 8 ) & 0xff )
+
+/**
+ * Extract statistic from setting tag
+ *
+ * @v tag		Setting tag
+ * @ret stat		Statistic
+ */
+#define HEAP_STAT( tag ) ( (tag) & 0xff )
+
+/** Heap settings scope */
+static const struct settings_scope heap_settings_scope;
+
+/**
+ * Check applicability of heap setting
+ *
+ * @v settings		Settings block
+ * @v setting		Setting
+ * @ret applies		Setting applies within this settings block
+ */
+static int heap_settings_applies ( struct settings *settings __unused,
+				   const struct setting *setting ) {
+
+	return ( setting->scope == &heap_settings_scope );
+}
+
+/**
+ * Fetch value of heap setting
+ *
+ * @v settings		Settings block
+ * @v setting		Setting to fetch
+ * @v data		Buffer to fill with setting data
+ * @v len		Length of buffer
+ * @ret len		Length of setting data, or negative error
+ */
+static int heap_settings_fetch ( struct settings *settings,
+				 struct setting *setting,
+				 void *data, size_t len ) {
+	struct heap *heap;
+	unsigned int index;
+	uint64_t result;
+
+	/* Identify heap */
+	index = HEAP_INDEX ( setting->tag );
+	if ( index >= table_num_entries ( HEAPS ) ) {
+		DBGC ( settings, "HEAP setting %s has no heap\n",
+		       setting->name );
+		return -ENOENT;
+	}
+	heap = &table_start ( HEAPS )[index];
+
+	/* Extract statistic */
+	switch ( HEAP_STAT ( setting->tag ) ) {
+	case HEAP_STAT_USED:
+		result = heap->usedmem;
+		break;
+	case HEAP_STAT_FREE:
+		result = heap->freemem;
+		break;
+	case HEAP_STAT_LARGEST:
+		result = heap_largest ( heap );
+		break;
+	case HEAP_STAT_MAXUSED:
+		result = heap->maxusedmem;
+		break;
+	case HEAP_STAT_ALLOCS:
+		result = heap->allocs;
+		break;
+	case HEAP_STAT_GROWS:
+		result = heap->grows;
+		break;
+	default:
+		DBGC ( settings, "HEAP setting %s has no statistic\n",
+		       setting->name );
+		return -ENOENT;
+	}
+
+	/* Return result */
+	result = cpu_to_be64 ( result );
+	if ( len > sizeof ( result ) )
+		len = sizeof ( result );
+	memcpy ( data, &result, len );
+
+	/* Set type if not already specified */
+	if ( ! setting->type )
+		setting->type = &setting_type_int32;
+
+	return sizeof ( result );
+}
+
+/** Heap settings operations */
+static struct settings_operations heap_settings_operations = {
+	.applies = heap_settings_applies,
+	.fetch = heap_settings_fetch,
+};
+
+/** Heap settings */
+static struct settings heap_settings = {
+	.refcnt = NULL,
+	.siblings = LIST_HEAD_INIT ( heap_settings.siblings ),
+	.children = LIST_HEAD_INIT ( heap_settings.children ),
+	.op = &heap_settings_operations,
+	.default_scope = &heap_settings_scope,
+};
+
+/** Initialise heap settings */
+static void heap_settings_init ( void ) {
+	int rc;
+
+	if ( ( rc = register_settings ( &heap_settings, NULL,
+					"heap" ) ) != 0 ) {
+		DBG ( "HEAP could not register settings: %s\n",
+		      strerror ( rc ) );
+		return;
+	}
+}
+
+/** Heap settings initialiser */
+struct init_fn heap_settings_init_fn __init_fn ( INIT_NORMAL ) = {
+	.name = "heap",
+	.initialise = heap_settings_init,
+};
+
+/** Heap used memory setting */
+const struct setting heapused_setting __setting ( SETTING_MISC, heapused ) = {
+	.name = "heapused",
+	.description = "Heap used memory",
+	.tag = HEAP_TAG ( 0, HEAP_STAT_USED ),
+	.type = &setting_type_int32,
+	.scope = &heap_settings_scope,
+};
+
+/** Heap free memory setting */
+const struct setting heapfree_setting __setting ( SETTING_MISC, heapfree ) = {
+	.name = "heapfree",
+	.description = "Heap free memory",
+	.tag = HEAP_TAG ( 0, HEAP_STAT_FREE ),
+	.type = &setting_type_int32,
+	.scope = &heap_settings_scope,
+};
+
+/** Heap largest free block setting */
+const struct setting heaplargest_setting
+	__setting ( SETTING_MISC, heaplargest ) = {
+	.name = "heaplargest",
+	.description = "Heap largest free block",
+	.tag = HEAP_TAG ( 0, HEAP_STAT_LARGEST ),
+	.type = &setting_type_int32,
+	.scope = &heap_settings_scope,
+};
+
+/** Heap maximum used memory setting */
+const struct setting heapmax_setting __setting ( SETTING_MISC, heapmax ) = {
+	.name = "heapmax",
+	.description = "Heap maximum used memory",
+	.tag = HEAP_TAG ( 0, HEAP_STAT_MAXUSED ),
+	.type = &setting_type_int32,
+	.scope = &heap_settings_scope,
+};
+
+/** Heap allocation count setting */
+const struct setting heapallocs_setting
+	__setting ( SETTING_MISC, heapallocs ) = {
+	.name = "heapallocs",
+	.description = "Heap allocation count",
+	.tag = HEAP_TAG ( 0, HEAP_STAT_ALLOCS ),
+	.type = &setting_type_int32,
+	.scope = &heap_settings_scope,
+};
+
+/** Heap cache discard count setting */
+const struct setting heapgrows_setting __setting ( SETTING_MISC, heapgrows ) = {
+	.name = "heapgrows",
+	.description = "Heap growth (cache discard) count",
+	.tag = HEAP_TAG ( 0, HEAP_STAT_GROWS ),
+	.type = &setting_type_int32,
+	.scope = &heap_settings_scope,
+};
+
+/** External heap used memory setting */
+const struct setting uheapused_setting __setting ( SETTING_MISC, uheapused ) = {
+	.name = "uheapused",
+	.description = "External heap used memory",
+	.tag = HEAP_TAG ( 1, HEAP_STAT_USED ),
+	.type = &setting_type_int32,
+	.scope = &heap_settings_scope,
+};
+
+/** External heap free memory setting */
+const struct setting uheapfree_setting __setting ( SETTING_MISC, uheapfree ) = {
+	.name = "uheapfree",
+	.description = "External heap free memory",
+	.tag = HEAP_TAG ( 1, HEAP_STAT_FREE ),
+	.type = &setting_type_int32,
+	.scope = &heap_settings_scope,
+};
+
+/** External heap maximum used memory setting */
+const struct setting uheapmax_setting __setting ( SETTING_MISC, uheapmax ) = {
+	.name = "uheapmax",
+	.description = "External heap maximum used memory",
+	.tag = HEAP_TAG ( 1, HEAP_STAT_MAXUSED ),
+	.type = &setting_type_int32,
+	.scope = &heap_settings_scope,
+};
@@ -36,8 +36,10 @@ FILE_SECBOOT ( PERMITTED );
 #include <ipxe/list.h>
 #include <ipxe/uaccess.h>
 #include <ipxe/umalloc.h>
+#include <ipxe/crypto.h>
 #include <ipxe/uri.h>
 #include <ipxe/image.h>
+#include <ipxe/trace.h>
 
 /** @file
  *
@@ -108,6 +110,15 @@ void free_image ( struct refcnt *refcnt ) {
 	if ( ! ( image->flags & IMAGE_STATIC_NAME ) )
 		free ( image->name );
 
+	/* Free any accumulated digests */
+	image_digest_discard ( image );
+
+	/* Release any pre-placed image data */
+	if ( image->placer ) {
+		image->placer->unplace ( image );
+		image->rwdata = NULL;
+	}
+
 	/* Free image data and image itself, if dynamically allocated */
 	if ( ! ( image->flags & IMAGE_STATIC ) ) {
 		ufree ( image->rwdata );
@@ -245,10 +256,13 @@ int image_set_cmdline ( struct image *image, const char *cmdline ) {
 int image_set_len ( struct image *image, size_t len ) {
 	void *new;
 
-	/* Refuse to reallocate static images */
-	if ( image->flags & IMAGE_STATIC )
+	/* Refuse to reallocate static or pre-placed images */
+	if ( ( image->flags & IMAGE_STATIC ) || image->placer )
 		return -ENOTTY;
 
+	/* Discard any accumulated digests, since the data will change */
+	image_digest_discard ( image );
+
 	/* (Re)allocate image data */
 	new = urealloc ( image->rwdata, len );
 	if ( ! new )
@@ -280,6 +294,168 @@ int image_set_data ( struct image *image, const void *data, size_t len ) {
 	return 0;
 }
 
+/**
+ * Pre-place image data during download
+ *
+ * @v image		Image (containing only the initial data)
+ * @v len		Total length of image
+ * @ret data		Pre-placed data buffer, or NULL
+ */
+void * image_place ( struct image *image, size_t len ) {
+	struct image_type *type;
+	void *data;
+
+	/* Try each type in turn */
+	for_each_table_entry ( type, IMAGE_TYPES ) {
+		if ( ! type->place )
+			continue;
+		data = type->place ( image, len );
+		if ( data ) {
+			image->placer = type;
+			DBGC ( image, "IMAGE %s pre-placed as %s at "
+			       "[%#08lx,%#08lx)\n", image->name, type->name,
+			       virt_to_phys ( data ),
+			       ( virt_to_phys ( data ) + len ) );
+			return data;
+		}
+	}
+
+	return NULL;
+}
+
+/**
+ * Find image digest accumulated during download
+ *
+ * @v image		Image
+ * @v digest		Digest algorithm
+ * @ret imgdigest	Image digest, or NULL if not found
+ */
+static struct image_digest * image_digest_find ( struct image *image,
+						 struct digest_algorithm
+						 *digest ) {
+	struct image_digest *imgdigest;
+
+	for ( imgdigest = image->digest ; imgdigest ;
+	      imgdigest = imgdigest->next ) {
+		if ( imgdigest->digest == digest )
+			return imgdigest;
+	}
+	return NULL;
+}
+
+/**
+ * Start accumulating image digest during download
+ *
+ * @v image		Image
+ * @v digest		Digest algorithm
+ * @ret rc		Return status code
+ */
+int image_digest_start ( struct image *image,
+			 struct digest_algorithm *digest ) {
+	struct image_digest *imgdigest;
+
+	/* Do nothing if this digest is already being accumulated */
+	if ( image_digest_find ( image, digest ) )
+		return 0;
+
+	/* Allocate and initialise digest */
+	imgdigest = zalloc ( sizeof ( *imgdigest ) + digest->ctxsize );
+	if ( ! imgdigest )
+		return -ENOMEM;
+	imgdigest->digest = digest;
+	imgdigest->ctx = ( ( ( void * ) imgdigest ) + sizeof ( *imgdigest ) );
+	digest_init ( digest, imgdigest->ctx );
+
+	/* Add to list of digests */
+	imgdigest->next = image->digest;
+	image->digest = imgdigest;
+
+	return 0;
+}
+
+/**
+ * Add downloaded data to image digest
+ *
+ * @v image		Image
+ * @v offset		Offset of data within image
+ * @v data		Data
+ * @v len		Length of data
+ *
+ * The digest can be accumulated only while data arrives in order.
+ * Any out-of-order data will cause the digest to be discarded at
+ * verification time, in favour of a digest over the complete image.
+ */
+void image_digest_update ( struct image *image, size_t offset,
+			   const void *data, size_t len ) {
+	struct image_digest *imgdigest;
+
+	/* Ignore empty data */
+	if ( ! len )
+		return;
+
+	/* Update each usable digest */
+	for ( imgdigest = image->digest ; imgdigest ;
+	      imgdigest = imgdigest->next ) {
+
+		/* Skip unusable digests */
+		if ( imgdigest->broken )
+			continue;
+
+		/* Give up on out-of-order data */
+		if ( offset != imgdigest->len ) {
+			DBGC ( image, "IMAGE %s %s digest abandoned at offset "
+			       "%#zx (expected %#zx)\n", image->name,
+			       imgdigest->digest->name, offset,
+			       imgdigest->len );
+			imgdigest->broken = 1;
+			continue;
+		}
+
+		/* Accumulate digest */
+		digest_update ( imgdigest->digest, imgdigest->ctx, data, len );
+		imgdigest->len += len;
+	}
+}
+
+/**
+ * Get image digest accumulated during download
+ *
+ * @v image		Image
+ * @v digest		Digest algorithm
+ * @v out		Digest output
+ * @ret rc		Return status code
+ */
+int image_digest_final ( struct image *image,
+			 struct digest_algorithm *digest, void *out ) {
+	struct image_digest *imgdigest = image_digest_find ( image, digest );
+	uint8_t ctx[ digest->ctxsize ];
+
+	/* Check that a complete digest is available */
+	if ( ( ! imgdigest ) || imgdigest->broken ||
+	     ( imgdigest->len != image->len ) )
+		return -ENOENT;
+
+	/* Finalise a copy of the context, leaving the original intact */
+	memcpy ( ctx, imgdigest->ctx, sizeof ( ctx ) );
+	digest_final ( digest, ctx, out );
+
+	return 0;
+}
+
+/**
+ * Discard image digests accumulated during download
+ *
+ * @v image		Image
+ */
+void image_digest_discard ( struct image *image ) {
+	struct image_digest *imgdigest;
+
+	while ( ( imgdigest = image->digest ) ) {
+		image->digest = imgdigest->next;
+		free ( imgdigest );
+	}
+}
+
 /**
  * Determine image type
  *
@@ -338,6 +514,7 @@ int register_image ( struct image *image ) {
 	DBGC ( image, "IMAGE %s at [%lx,%lx) registered\n",
 	       image->name, virt_to_phys ( image->data ),
 	       ( virt_to_phys ( image->data ) + image->len ) );
+	trace ( "image", "register", image, 0 );
 
 	/* Try to detect image type, if applicable.  Ignore failures,
 	 * since we expect to handle some unrecognised images
@@ -450,6 +627,7 @@ int image_exec ( struct image *image ) {
 
 	/* Record boot attempt */
 	syslog ( LOG_NOTICE, "Executing \"%s\"\n", image->name );
+	trace ( "image", "exec", image, 0 );
 
 	/* Temporarily unregister the image during its execution */
 	unregister_image ( image );
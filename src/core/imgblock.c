@@ -0,0 +1,360 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+FILE_SECBOOT ( PERMITTED );
+
+/** @file
+ *
+ * Memory-backed image SAN device
+ *
+ * A registered image may be opened as a block device using a URI of
+ * the form "image:<name>", allowing an image that has already been
+ * downloaded (e.g. via "imgfetch") to be booted via "sanboot"
+ * without any further network I/O.
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <assert.h>
+#include <ipxe/refcnt.h>
+#include <ipxe/interface.h>
+#include <ipxe/process.h>
+#include <ipxe/uri.h>
+#include <ipxe/open.h>
+#include <ipxe/image.h>
+#include <ipxe/blockdev.h>
+#include <ipxe/efi/efi_path.h>
+
+/** Block size used for image block devices */
+#define IMGBLOCK_BLKSIZE 512
+
+/** An image block device */
+struct image_block {
+	/** Reference count */
+	struct refcnt refcnt;
+	/** Block device interface */
+	struct interface block;
+	/** Data interface for pending command */
+	struct interface data;
+	/** Command completion process */
+	struct process process;
+	/** URI */
+	struct uri *uri;
+	/** Image */
+	struct image *image;
+	/** Pending command is a read capacity command */
+	int capacity;
+};
+
+/**
+ * Free image block device
+ *
+ * @v refcnt		Reference count
+ */
+static void imgblock_free ( struct refcnt *refcnt ) {
+	struct image_block *imgblock =
+		container_of ( refcnt, struct image_block, refcnt );
+
+	image_put ( imgblock->image );
+	uri_put ( imgblock->uri );
+	free ( imgblock );
+}
+
+/**
+ * Close image block device
+ *
+ * @v imgblock		Image block device
+ * @v rc		Reason for close
+ */
+static void imgblock_close ( struct image_block *imgblock, int rc ) {
+
+	/* Stop process */
+	process_del ( &imgblock->process );
+
+	/* Shut down interfaces */
+	intfs_shutdown ( rc, &imgblock->data, &imgblock->block, NULL );
+}
+
+/**
+ * Abort pending command
+ *
+ * @v imgblock		Image block device
+ * @v rc		Reason for close
+ */
+static void imgblock_abort ( struct image_block *imgblock, int rc ) {
+
+	/* Abandon pending command */
+	process_del ( &imgblock->process );
+	intf_restart ( &imgblock->data, rc );
+}
+
+/**
+ * Complete pending command
+ *
+ * @v imgblock		Image block device
+ */
+static void imgblock_step ( struct image_block *imgblock ) {
+	struct block_device_capacity capacity;
+
+	/* Report capacity, if applicable */
+	if ( imgblock->capacity ) {
+		capacity.blocks = ( imgblock->image->len / IMGBLOCK_BLKSIZE );
+		capacity.blksize = IMGBLOCK_BLKSIZE;
+		capacity.max_count = -1U;
+		block_capacity ( &imgblock->data, &capacity );
+		imgblock->capacity = 0;
+	}
+
+	/* Complete command */
+	intf_restart ( &imgblock->data, 0 );
+}
+
+/**
+ * Start command
+ *
+ * @v imgblock		Image block device
+ * @v data		Data interface
+ * @ret rc		Return status code
+ *
+ * The command is completed from the process, since the caller
+ * expects completion to be reported asynchronously.
+ */
+static int imgblock_command ( struct image_block *imgblock,
+			      struct interface *data ) {
+
+	/* Fail if a command is already pending */
+	if ( process_running ( &imgblock->process ) )
+		return -EBUSY;
+
+	/* Attach to data interface and schedule completion */
+	intf_plug_plug ( &imgblock->data, data );
+	process_add ( &imgblock->process );
+
+	return 0;
+}
+
+/**
+ * Check block range
+ *
+ * @v imgblock		Image block device
+ * @v lba		Starting logical block address
+ * @v count		Number of logical blocks
+ * @v len		Length of data buffer
+ * @ret offset		Offset within image, or negative error
+ */
+static long imgblock_offset ( struct image_block *imgblock, uint64_t lba,
+			      unsigned int count, size_t len ) {
+	uint64_t blocks = ( imgblock->image->len / IMGBLOCK_BLKSIZE );
+
+	/* Sanity check */
+	assert ( len == ( count * IMGBLOCK_BLKSIZE ) );
+
+	/* Check range */
+	if ( ( lba > blocks ) || ( count > ( blocks - lba ) ) ) {
+		DBGC ( imgblock, "IMGBLOCK %s [%#llx,%#llx) out of range\n",
+		       imgblock->image->name, ( ( unsigned long long ) lba ),
+		       ( ( unsigned long long ) ( lba + count ) ) );
+		return -ERANGE;
+	}
+
+	return ( lba * IMGBLOCK_BLKSIZE );
+}
+
+/**
+ * Read from image block device
+ *
+ * @v imgblock		Image block device
+ * @v data		Data interface
+ * @v lba		Starting logical block address
+ * @v count		Number of logical blocks
+ * @v buffer		Data buffer
+ * @v len		Length of data buffer
+ * @ret rc		Return status code
+ */
+static int imgblock_read ( struct image_block *imgblock,
+			   struct interface *data, uint64_t lba,
+			   unsigned int count, void *buffer, size_t len ) {
+	long offset;
+	int rc;
+
+	/* Check range */
+	offset = imgblock_offset ( imgblock, lba, count, len );
+	if ( offset < 0 )
+		return offset;
+
+	/* Start command */
+	if ( ( rc = imgblock_command ( imgblock, data ) ) != 0 )
+		return rc;
+
+	/* Copy data */
+	memcpy ( buffer, ( imgblock->image->data + offset ), len );
+
+	return 0;
+}
+
+/**
+ * Write to image block device
+ *
+ * @v imgblock		Image block device
+ * @v data		Data interface
+ * @v lba		Starting logical block address
+ * @v count		Number of logical blocks
+ * @v buffer		Data buffer
+ * @v len		Length of data buffer
+ * @ret rc		Return status code
+ */
+static int imgblock_write ( struct image_block *imgblock,
+			    struct interface *data, uint64_t lba,
+			    unsigned int count, void *buffer, size_t len ) {
+	long offset;
+	int rc;
+
+	/* Refuse to modify statically allocated images */
+	if ( imgblock->image->flags & IMAGE_STATIC )
+		return -EROFS;
+
+	/* Check range */
+	offset = imgblock_offset ( imgblock, lba, count, len );
+	if ( offset < 0 )
+		return offset;
+
+	/* Start command */
+	if ( ( rc = imgblock_command ( imgblock, data ) ) != 0 )
+		return rc;
+
+	/* Copy data */
+	memcpy ( ( imgblock->image->rwdata + offset ), buffer, len );
+
+	return 0;
+}
+
+/**
+ * Read image block device capacity
+ *
+ * @v imgblock		Image block device
+ * @v data		Data interface
+ * @ret rc		Return status code
+ */
+static int imgblock_read_capacity ( struct image_block *imgblock,
+				    struct interface *data ) {
+	int rc;
+
+	/* Start command */
+	if ( ( rc = imgblock_command ( imgblock, data ) ) != 0 )
+		return rc;
+
+	/* Report capacity on completion */
+	imgblock->capacity = 1;
+
+	return 0;
+}
+
+/**
+ * Describe image block device as an EFI device path
+ *
+ * @v imgblock		Image block device
+ * @ret path		EFI device path, or NULL on error
+ */
+static EFI_DEVICE_PATH_PROTOCOL *
+imgblock_efi_describe ( struct image_block *imgblock ) {
+
+	return efi_uri_path ( imgblock->uri );
+}
+
+/** Image block device interface operations */
+static struct interface_operation imgblock_block_operations[] = {
+	INTF_OP ( block_read, struct image_block *, imgblock_read ),
+	INTF_OP ( block_write, struct image_block *, imgblock_write ),
+	INTF_OP ( block_read_capacity, struct image_block *,
+		  imgblock_read_capacity ),
+	INTF_OP ( intf_close, struct image_block *, imgblock_close ),
+	EFI_INTF_OP ( efi_describe, struct image_block *,
+		      imgblock_efi_describe ),
+};
+
+/** Image block device interface descriptor */
+static struct interface_descriptor imgblock_block_desc =
+	INTF_DESC ( struct image_block, block, imgblock_block_operations );
+
+/** Image block device data interface operations */
+static struct interface_operation imgblock_data_operations[] = {
+	INTF_OP ( intf_close, struct image_block *, imgblock_abort ),
+};
+
+/** Image block device data interface descriptor */
+static struct interface_descriptor imgblock_data_desc =
+	INTF_DESC ( struct image_block, data, imgblock_data_operations );
+
+/** Image block device process descriptor */
+static struct process_descriptor imgblock_process_desc =
+	PROC_DESC_ONCE ( struct image_block, process, imgblock_step );
+
+/**
+ * Open image block device URI
+ *
+ * @v parent		Parent interface
+ * @v uri		URI
+ * @ret rc		Return status code
+ */
+static int imgblock_open_uri ( struct interface *parent, struct uri *uri ) {
+	struct image_block *imgblock;
+	struct image *image;
+
+	/* Sanity check */
+	if ( ! uri->opaque )
+		return -EINVAL;
+
+	/* Find matching image */
+	image = find_image ( uri->opaque );
+	if ( ! image )
+		return -ENOENT;
+
+	/* Allocate and initialise structure */
+	imgblock = zalloc ( sizeof ( *imgblock ) );
+	if ( ! imgblock )
+		return -ENOMEM;
+	ref_init ( &imgblock->refcnt, imgblock_free );
+	intf_init ( &imgblock->block, &imgblock_block_desc,
+		    &imgblock->refcnt );
+	intf_init ( &imgblock->data, &imgblock_data_desc, &imgblock->refcnt );
+	process_init_stopped ( &imgblock->process, &imgblock_process_desc,
+			       &imgblock->refcnt );
+	imgblock->uri = uri_get ( uri );
+	imgblock->image = image_get ( image );
+	DBGC ( imgblock, "IMGBLOCK %s opened (%#zx bytes)\n",
+	       image->name, image->len );
+
+	/* Attach to parent interface, mortalise self, and return */
+	intf_plug_plug ( &imgblock->block, parent );
+	ref_put ( &imgblock->refcnt );
+	return 0;
+}
+
+/** Image block device URI opener */
+struct uri_opener imgblock_uri_opener __uri_opener = {
+	.scheme = "image",
+	.open = imgblock_open_uri,
+};
@@ -0,0 +1,380 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+FILE_SECBOOT ( PERMITTED );
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <ipxe/interface.h>
+#include <ipxe/settings.h>
+#include <ipxe/image.h>
+#include <ipxe/uri.h>
+#include <ipxe/xferbuf.h>
+#include <ipxe/crypto.h>
+#include <ipxe/sha256.h>
+#include <ipxe/base16.h>
+#include <ipxe/imgcache.h>
+
+/** @file
+ *
+ * Persistent image cache
+ *
+ * Downloaded images may be cached on local storage (such as the EFI
+ * system partition) and revalidated against the server using a
+ * conditional request, avoiding the need to transfer unchanged
+ * images across the network.
+ *
+ * The cache is indexed by the SHA-256 digest of the image URI.  Each
+ * index entry (a "tag" file) records the server's entity tag along
+ * with the length and SHA-256 digest of the content, which is stored
+ * in a separate file named by its own digest.  Cached content is
+ * verified against this digest before use.
+ *
+ * The cache is included only if IMAGE_CACHE is defined, and is
+ * disabled unless the "imgcache" setting specifies the location of an
+ * existing cache directory (e.g. "file:/ipxe/cache").
+ */
+
+/** Image cache location setting */
+const struct setting imgcache_setting __setting ( SETTING_MISC, imgcache ) = {
+	.name = "imgcache",
+	.description = "Image cache location",
+	.type = &setting_type_string,
+};
+
+/**
+ * Get image cache backing store
+ *
+ * @ret store		Backing store, or NULL if not available
+ */
+static struct imgcache_store * imgcache_store ( void ) {
+	struct imgcache_store *store;
+
+	/* Use first available backing store */
+	for_each_table_entry ( store, IMGCACHE_STORES )
+		return store;
+	return NULL;
+}
+
+/**
+ * Calculate SHA-256 digest
+ *
+ * @v data		Data
+ * @v len		Length of data
+ * @v digest		Digest to fill in
+ */
+static void imgcache_digest ( const void *data, size_t len,
+			      uint8_t *digest ) {
+	uint8_t ctx[SHA256_CTX_SIZE];
+
+	digest_init ( &sha256_algorithm, ctx );
+	digest_update ( &sha256_algorithm, ctx, data, len );
+	digest_final ( &sha256_algorithm, ctx, digest );
+}
+
+/**
+ * Construct cache file URI
+ *
+ * @v digest		SHA-256 digest used to name the file
+ * @v suffix		File name suffix
+ * @ret uri		File URI, or NULL if cache is disabled
+ */
+static struct uri * imgcache_file ( const uint8_t *digest,
+				    const char *suffix ) {
+	char name[ base16_encoded_len ( SHA256_DIGEST_SIZE ) + 1 /* NUL */ ];
+	struct uri *uri;
+	char *location;
+	char *file;
+	size_t len;
+
+	/* Fetch cache location */
+	if ( fetch_string_setting_copy ( NULL, &imgcache_setting,
+					 &location ) < 0 )
+		return NULL;
+	if ( ! location )
+		return NULL;
+	len = strlen ( location );
+
+	/* Construct file URI */
+	base16_encode ( digest, SHA256_DIGEST_SIZE, name, sizeof ( name ) );
+	if ( asprintf ( &file, "%s%s%s.%s", location,
+			( ( len && ( location[ len - 1 ] == '/' ) ) ? "" : "/" ),
+			name, suffix ) < 0 ) {
+		uri = NULL;
+		goto err_file;
+	}
+	uri = parse_uri ( file );
+
+	free ( file );
+ err_file:
+	free ( location );
+	return uri;
+}
+
+/**
+ * Read image cache tag
+ *
+ * @v image		Image
+ * @v store		Backing store
+ * @v buffer		Data transfer buffer to fill in
+ * @ret tag		Image cache tag, or NULL on error
+ */
+static struct imgcache_tag * imgcache_tag ( struct image *image,
+					    struct imgcache_store *store,
+					    struct xfer_buffer *buffer ) {
+	uint8_t digest[SHA256_DIGEST_SIZE];
+	struct imgcache_tag *tag;
+	struct uri *uri;
+	char *location;
+	int rc;
+
+	/* Identify tag file */
+	location = format_uri_alloc ( image->uri );
+	if ( ! location )
+		return NULL;
+	imgcache_digest ( location, strlen ( location ), digest );
+	free ( location );
+	uri = imgcache_file ( digest, "tag" );
+	if ( ! uri )
+		return NULL;
+
+	/* Read tag file */
+	rc = store->read ( uri, buffer );
+	uri_put ( uri );
+	if ( rc != 0 )
+		return NULL;
+
+	/* Check tag */
+	tag = buffer->data;
+	if ( ( buffer->len <= sizeof ( *tag ) ) ||
+	     ( tag->magic != cpu_to_le32 ( IMGCACHE_MAGIC ) ) ) {
+		DBGC ( image, "IMGCACHE %s has invalid tag\n", image->name );
+		return NULL;
+	}
+
+	return tag;
+}
+
+/**
+ * Look up cached image
+ *
+ * @v image		Image
+ * @v etag		Entity tag of cached content to fill in
+ * @ret rc		Return status code
+ *
+ * The caller is responsible for eventually freeing the entity tag.
+ */
+int imgcache_lookup ( struct image *image, char **etag ) {
+	struct imgcache_store *store;
+	struct xfer_buffer buffer;
+	struct imgcache_tag *tag;
+	int rc;
+
+	/* Initialise entity tag */
+	*etag = NULL;
+
+	/* Do nothing unless a backing store exists */
+	store = imgcache_store();
+	if ( ! store )
+		return -ENOTSUP;
+
+	/* Read tag */
+	xferbuf_malloc_init ( &buffer );
+	tag = imgcache_tag ( image, store, &buffer );
+	if ( ! tag ) {
+		rc = -ENOENT;
+		goto err_tag;
+	}
+
+	/* Extract entity tag */
+	*etag = strndup ( tag->etag, ( buffer.len - sizeof ( *tag ) ) );
+	if ( ! *etag ) {
+		rc = -ENOMEM;
+		goto err_etag;
+	}
+	DBGC ( image, "IMGCACHE %s found %s entity tag %s\n",
+	       image->name, store->name, *etag );
+
+	/* Success */
+	rc = 0;
+
+ err_etag:
+ err_tag:
+	xferbuf_free ( &buffer );
+	return rc;
+}
+
+/**
+ * Load cached image
+ *
+ * @v image		Image
+ * @v buffer		Data transfer buffer to fill in
+ * @ret rc		Return status code
+ */
+int imgcache_load ( struct image *image, struct xfer_buffer *buffer ) {
+	uint8_t digest[SHA256_DIGEST_SIZE];
+	struct imgcache_store *store;
+	struct xfer_buffer tagbuf;
+	struct imgcache_tag *tag;
+	struct uri *uri;
+	int rc;
+
+	/* Identify backing store */
+	store = imgcache_store();
+	if ( ! store ) {
+		rc = -ENOTSUP;
+		goto err_store;
+	}
+
+	/* Read tag */
+	xferbuf_malloc_init ( &tagbuf );
+	tag = imgcache_tag ( image, store, &tagbuf );
+	if ( ! tag ) {
+		rc = -ENOENT;
+		goto err_tag;
+	}
+
+	/* Read content */
+	uri = imgcache_file ( tag->digest, "img" );
+	if ( ! uri ) {
+		rc = -ENOENT;
+		goto err_uri;
+	}
+	if ( ( rc = store->read ( uri, buffer ) ) != 0 ) {
+		DBGC ( image, "IMGCACHE %s could not read content: %s\n",
+		       image->name, strerror ( rc ) );
+		goto err_read;
+	}
+
+	/* Verify content */
+	imgcache_digest ( buffer->data, buffer->len, digest );
+	if ( ( buffer->len != le64_to_cpu ( tag->len ) ) ||
+	     ( memcmp ( digest, tag->digest, sizeof ( digest ) ) != 0 ) ) {
+		DBGC ( image, "IMGCACHE %s content is corrupt\n",
+		       image->name );
+		rc = -EIO;
+		goto err_verify;
+	}
+	DBGC ( image, "IMGCACHE %s loaded %#zx bytes from %s\n",
+	       image->name, buffer->len, store->name );
+
+ err_verify:
+ err_read:
+	uri_put ( uri );
+ err_uri:
+ err_tag:
+	xferbuf_free ( &tagbuf );
+ err_store:
+	return rc;
+}
+
+/**
+ * Save image to cache
+ *
+ * @v image		Image
+ * @v etag		Entity tag
+ * @v data		Content
+ * @v len		Length of content
+ * @ret rc		Return status code
+ */
+int imgcache_save ( struct image *image, const char *etag,
+		    const void *data, size_t len ) {
+	uint8_t digest[SHA256_DIGEST_SIZE];
+	struct imgcache_store *store;
+	struct imgcache_tag *tag;
+	size_t etag_len = strlen ( etag );
+	size_t tag_len = ( sizeof ( *tag ) + etag_len );
+	char *location;
+	struct uri *uri;
+	int rc;
+
+	/* Identify backing store */
+	store = imgcache_store();
+	if ( ! store ) {
+		rc = -ENOTSUP;
+		goto err_store;
+	}
+
+	/* Construct tag */
+	tag = malloc ( tag_len );
+	if ( ! tag ) {
+		rc = -ENOMEM;
+		goto err_alloc;
+	}
+	tag->magic = cpu_to_le32 ( IMGCACHE_MAGIC );
+	tag->len = cpu_to_le64 ( len );
+	imgcache_digest ( data, len, tag->digest );
+	memcpy ( tag->etag, etag, etag_len );
+
+	/* Write content before tag, so that a tag never refers to
+	 * content which does not exist.
+	 */
+	uri = imgcache_file ( tag->digest, "img" );
+	if ( ! uri ) {
+		rc = -ENOENT;
+		goto err_content_uri;
+	}
+	rc = store->write ( uri, data, len );
+	uri_put ( uri );
+	if ( rc != 0 ) {
+		DBGC ( image, "IMGCACHE %s could not write content: %s\n",
+		       image->name, strerror ( rc ) );
+		goto err_content;
+	}
+
+	/* Write tag */
+	location = format_uri_alloc ( image->uri );
+	if ( ! location ) {
+		rc = -ENOMEM;
+		goto err_location;
+	}
+	imgcache_digest ( location, strlen ( location ), digest );
+	free ( location );
+	uri = imgcache_file ( digest, "tag" );
+	if ( ! uri ) {
+		rc = -ENOENT;
+		goto err_tag_uri;
+	}
+	rc = store->write ( uri, tag, tag_len );
+	uri_put ( uri );
+	if ( rc != 0 ) {
+		DBGC ( image, "IMGCACHE %s could not write tag: %s\n",
+		       image->name, strerror ( rc ) );
+		goto err_tag;
+	}
+	DBGC ( image, "IMGCACHE %s saved %#zx bytes to %s with entity tag "
+	       "%s\n", image->name, len, store->name, etag );
+
+ err_tag:
+ err_tag_uri:
+ err_location:
+ err_content:
+ err_content_uri:
+	free ( tag );
+ err_alloc:
+ err_store:
+	return rc;
+}
@@ -0,0 +1,521 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+FILE_SECBOOT ( PERMITTED );
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <assert.h>
+#include <byteswap.h>
+#include <ipxe/iobuf.h>
+#include <ipxe/xfer.h>
+#include <ipxe/xferbuf.h>
+#include <ipxe/crc32.h>
+#include <ipxe/inflate.h>
+
+/** @file
+ *
+ * Decompression during download
+ *
+ * This data transfer filter decompresses gzip or zlib compressed
+ * data as it arrives, writing the decompressed data directly into
+ * the underlying data transfer buffer.  This avoids the need to hold
+ * both the compressed and decompressed copies of an image in memory
+ * at the same time, and allows decompression to overlap with the
+ * download.
+ *
+ */
+
+/**
+ * Close decompression filter
+ *
+ * @v inflate		Decompression filter
+ * @v rc		Reason for close
+ */
+static void inflate_close ( struct inflate *inflate, int rc ) {
+
+	/* Check for truncated data */
+	if ( ( rc == 0 ) && ( inflate->state != INFLATE_DONE ) ) {
+		DBGC ( inflate, "INFLATE %p truncated in state %d\n",
+		       inflate, inflate->state );
+		rc = -EINVAL;
+	}
+
+	/* Shut down interfaces */
+	intf_shutdown ( &inflate->raw, rc );
+	intf_shutdown ( &inflate->xfer, rc );
+}
+
+/**
+ * Check if decompression state is required
+ *
+ * @v inflate		Decompression filter
+ * @ret required	State is required
+ */
+static int inflate_required ( struct inflate *inflate ) {
+
+	switch ( inflate->state ) {
+	case INFLATE_EXTRA_LEN:
+	case INFLATE_EXTRA:
+		return ( inflate->flags & GZIP_FL_EXTRA );
+	case INFLATE_NAME:
+		return ( inflate->flags & GZIP_FL_NAME );
+	case INFLATE_COMMENT:
+		return ( inflate->flags & GZIP_FL_COMMENT );
+	case INFLATE_HCRC:
+		return ( inflate->flags & GZIP_FL_HCRC );
+	case INFLATE_FOOTER:
+		return ( inflate->format == DEFLATE_RAW );
+	default:
+		return 1;
+	}
+}
+
+/**
+ * Move to next required decompression state
+ *
+ * @v inflate		Decompression filter
+ */
+static void inflate_next ( struct inflate *inflate ) {
+
+	/* Reset header or footer */
+	inflate->fill = 0;
+
+	/* Move to next required state */
+	do {
+		inflate->state++;
+	} while ( ! inflate_required ( inflate ) );
+}
+
+/**
+ * Accumulate header or footer
+ *
+ * @v inflate		Decompression filter
+ * @v len		Required length
+ * @v data		Data pointer to update
+ * @v remaining		Remaining length to update
+ * @ret complete	Header or footer is complete
+ */
+static int inflate_fill ( struct inflate *inflate, size_t len,
+			  const void **data, size_t *remaining ) {
+	size_t frag_len;
+
+	/* Sanity check */
+	assert ( len <= sizeof ( inflate->hdr ) );
+
+	/* Copy as much as possible */
+	if ( inflate->fill < len ) {
+		frag_len = ( len - inflate->fill );
+		if ( frag_len > *remaining )
+			frag_len = *remaining;
+		memcpy ( ( inflate->hdr.bytes + inflate->fill ), *data,
+			 frag_len );
+		inflate->fill += frag_len;
+		*data += frag_len;
+		*remaining -= frag_len;
+	}
+
+	return ( inflate->fill >= len );
+}
+
+/**
+ * Process fixed header
+ *
+ * @v inflate		Decompression filter
+ * @v data		Data pointer to update
+ * @v remaining		Remaining length to update
+ * @ret rc		Return status code
+ */
+static int inflate_header ( struct inflate *inflate, const void **data,
+			    size_t *remaining ) {
+	const uint8_t *bytes = inflate->hdr.bytes;
+	unsigned int header;
+
+	/* Wait for enough data to identify the format */
+	if ( ! inflate_fill ( inflate, ( ZLIB_HEADER_BITS / 8 ), data,
+			      remaining ) )
+		return 0;
+
+	/* Handle zlib format */
+	if ( inflate->hdr.gzip.magic != cpu_to_be16 ( GZIP_MAGIC ) ) {
+
+		/* Check for a valid zlib header (which is stored with
+		 * the most significant byte first, unlike the rest of
+		 * the zlib format).
+		 */
+		header = ( ( bytes[0] << 8 ) | bytes[1] );
+		if ( ( ( bytes[0] & ZLIB_HEADER_CM_MASK ) !=
+		       ZLIB_HEADER_CM_DEFLATE ) || ( header % 31 ) ) {
+			DBGC ( inflate, "INFLATE %p unrecognised format "
+			       "%02x%02x\n", inflate, bytes[0], bytes[1] );
+			return -ENOEXEC;
+		}
+		DBGC ( inflate, "INFLATE %p using zlib format\n", inflate );
+
+		/* Leave the header to be parsed by the decompressor */
+		inflate->format = DEFLATE_ZLIB;
+		inflate->skip = inflate->fill;
+		deflate_init ( &inflate->deflate, inflate->format );
+		inflate->state = ( INFLATE_DATA - 1 );
+		inflate_next ( inflate );
+		return 0;
+	}
+
+	/* Wait for complete gzip header */
+	if ( ! inflate_fill ( inflate, sizeof ( inflate->hdr.gzip ), data,
+			      remaining ) )
+		return 0;
+
+	/* Parse gzip header */
+	if ( inflate->hdr.gzip.method != GZIP_METHOD_DEFLATE ) {
+		DBGC ( inflate, "INFLATE %p unsupported gzip method %d\n",
+		       inflate, inflate->hdr.gzip.method );
+		return -ENOTSUP;
+	}
+	inflate->flags = inflate->hdr.gzip.flags;
+	DBGC ( inflate, "INFLATE %p using gzip format (flags %#02x)\n",
+	       inflate, inflate->flags );
+
+	/* Start decompressor */
+	inflate->format = DEFLATE_RAW;
+	deflate_init ( &inflate->deflate, inflate->format );
+	inflate_next ( inflate );
+
+	return 0;
+}
+
+/**
+ * Decompress data
+ *
+ * @v inflate		Decompression filter
+ * @v data		Data pointer to update
+ * @v remaining		Remaining length to update
+ * @ret rc		Return status code
+ */
+static int inflate_data ( struct inflate *inflate, const void **data,
+			  size_t *remaining ) {
+	struct deflate *deflate = &inflate->deflate;
+	struct xfer_buffer *xferbuf;
+	struct deflate_chunk out;
+	const void *in;
+	size_t len;
+	size_t used;
+	int rc;
+
+	/* Get underlying data transfer buffer */
+	xferbuf = xfer_buffer ( &inflate->xfer );
+	if ( ! xferbuf ) {
+		DBGC ( inflate, "INFLATE %p has no underlying data transfer "
+		       "buffer\n", inflate );
+		return -ENOTSUP;
+	}
+
+	/* Use any part of the zlib header retained within the
+	 * header buffer, otherwise use the next step of input data.
+	 */
+	if ( inflate->skip ) {
+		in = inflate->hdr.bytes;
+		len = inflate->skip;
+	} else {
+		in = *data;
+		len = *remaining;
+		if ( len > INFLATE_STEP_LEN )
+			len = INFLATE_STEP_LEN;
+	}
+
+	/* Reserve space for the maximum possible decompressed length,
+	 * allowing for the completion of any partially decoded
+	 * duplicated string.
+	 */
+	if ( ( rc = xferbuf_reserve ( xferbuf, ( inflate->len +
+				      ( ( len + 1 ) *
+					DEFLATE_MAX_EXPANSION ) ) ) ) != 0 ) {
+		DBGC ( inflate, "INFLATE %p could not reserve space: %s\n",
+		       inflate, strerror ( rc ) );
+		return rc;
+	}
+	if ( ! xferbuf->data ) {
+		DBGC ( inflate, "INFLATE %p has no data buffer\n", inflate );
+		return -ENOTSUP;
+	}
+
+	/* Decompress data */
+	deflate_chunk_init ( &out, xferbuf->data, inflate->len,
+			     xferbuf->capacity );
+	if ( ( rc = deflate_inflate ( deflate, in, len, &out ) ) != 0 ) {
+		DBGC ( inflate, "INFLATE %p could not decompress: %s\n",
+		       inflate, strerror ( rc ) );
+		return rc;
+	}
+	assert ( out.offset <= out.len );
+	used = ( ( ( const void * ) deflate->in ) - in );
+
+	/* Consume input data */
+	if ( inflate->skip ) {
+		inflate->skip = 0;
+	} else {
+		*data += used;
+		*remaining -= used;
+	}
+
+	/* Update CRC and record decompressed data */
+	inflate->crc = crc32_le ( inflate->crc,
+				  ( xferbuf->data + inflate->len ),
+				  ( out.offset - inflate->len ) );
+	inflate->len = out.offset;
+	if ( ( rc = xferbuf_ensure_size ( xferbuf, inflate->len ) ) != 0 )
+		return rc;
+	xferbuf->pos = inflate->len;
+
+	/* Move to footer once decompression has finished */
+	if ( deflate_finished ( deflate ) ) {
+		DBGC ( inflate, "INFLATE %p decompressed %#zx bytes\n",
+		       inflate, inflate->len );
+		inflate_next ( inflate );
+		if ( inflate->state == INFLATE_FOOTER ) {
+			inflate->fill =
+				deflate_trailer ( deflate, inflate->hdr.bytes,
+						  sizeof ( inflate->hdr ) );
+		}
+	}
+
+	return 0;
+}
+
+/**
+ * Process gzip footer
+ *
+ * @v inflate		Decompression filter
+ * @v data		Data pointer to update
+ * @v remaining		Remaining length to update
+ * @ret rc		Return status code
+ */
+static int inflate_footer ( struct inflate *inflate, const void **data,
+			    size_t *remaining ) {
+	struct gzip_footer *footer = &inflate->hdr.footer;
+	uint32_t crc;
+	uint32_t len;
+
+	/* Wait for complete footer */
+	if ( ! inflate_fill ( inflate, sizeof ( *footer ), data, remaining ) )
+		return 0;
+
+	/* Verify CRC and length */
+	crc = ~inflate->crc;
+	if ( crc != le32_to_cpu ( footer->crc ) ) {
+		DBGC ( inflate, "INFLATE %p CRC mismatch (expected %08x, got "
+		       "%08x)\n", inflate, le32_to_cpu ( footer->crc ), crc );
+		return -EIO;
+	}
+	len = inflate->len;
+	if ( len != le32_to_cpu ( footer->len ) ) {
+		DBGC ( inflate, "INFLATE %p length mismatch (expected %#08x, "
+		       "got %#08x)\n", inflate, le32_to_cpu ( footer->len ),
+		       len );
+		return -EIO;
+	}
+
+	/* Finish decompression */
+	inflate_next ( inflate );
+
+	return 0;
+}
+
+/**
+ * Process compressed data
+ *
+ * @v inflate		Decompression filter
+ * @v data		Compressed data
+ * @v len		Length of compressed data
+ * @ret rc		Return status code
+ */
+static int inflate_process ( struct inflate *inflate, const void *data,
+			     size_t len ) {
+	size_t frag_len;
+	const char *end;
+	int rc;
+
+	while ( len ) {
+		switch ( inflate->state ) {
+		case INFLATE_HEADER:
+			if ( ( rc = inflate_header ( inflate, &data,
+						     &len ) ) != 0 )
+				return rc;
+			break;
+		case INFLATE_EXTRA_LEN:
+			if ( inflate_fill ( inflate,
+					    sizeof ( inflate->hdr.extra ),
+					    &data, &len ) ) {
+				inflate->skip =
+					le16_to_cpu ( inflate->hdr.extra.len );
+				inflate_next ( inflate );
+			}
+			break;
+		case INFLATE_EXTRA:
+			frag_len = inflate->skip;
+			if ( frag_len > len )
+				frag_len = len;
+			data += frag_len;
+			len -= frag_len;
+			inflate->skip -= frag_len;
+			if ( ! inflate->skip )
+				inflate_next ( inflate );
+			break;
+		case INFLATE_NAME:
+		case INFLATE_COMMENT:
+			end = memchr ( data, 0, len );
+			frag_len = ( end ? ( ( size_t ) ( end + 1 /* NUL */ -
+						( ( const char * ) data ) ) ) :
+				     len );
+			data += frag_len;
+			len -= frag_len;
+			if ( end )
+				inflate_next ( inflate );
+			break;
+		case INFLATE_HCRC:
+			if ( inflate_fill ( inflate,
+					    sizeof ( struct gzip_crc_header ),
+					    &data, &len ) ) {
+				inflate_next ( inflate );
+			}
+			break;
+		case INFLATE_DATA:
+			if ( ( rc = inflate_data ( inflate, &data,
+						   &len ) ) != 0 )
+				return rc;
+			break;
+		case INFLATE_FOOTER:
+			if ( ( rc = inflate_footer ( inflate, &data,
+						     &len ) ) != 0 )
+				return rc;
+			break;
+		default:
+			/* Ignore any trailing data */
+			DBGC ( inflate, "INFLATE %p ignoring %#zx trailing "
+			       "bytes\n", inflate, len );
+			return 0;
+		}
+	}
+
+	return 0;
+}
+
+/**
+ * Receive compressed data
+ *
+ * @v inflate		Decompression filter
+ * @v iobuf		I/O buffer
+ * @v meta		Data transfer metadata
+ * @ret rc		Return status code
+ */
+static int inflate_deliver ( struct inflate *inflate,
+			     struct io_buffer *iobuf,
+			     struct xfer_metadata *meta ) {
+	size_t len = iob_len ( iobuf );
+	size_t pos;
+	int rc;
+
+	/* Calculate position within compressed data */
+	pos = inflate->pos;
+	if ( meta->flags & XFER_FL_ABS_OFFSET )
+		pos = 0;
+	pos += meta->offset;
+
+	/* Ignore empty seeks (e.g. used to presize the buffer),
+	 * since the compressed length is not meaningful to the
+	 * recipient of the decompressed data.
+	 */
+	if ( ! len ) {
+		rc = 0;
+		goto done;
+	}
+
+	/* Compressed data must arrive in order */
+	if ( pos != inflate->pos ) {
+		DBGC ( inflate, "INFLATE %p out-of-order data at %#zx "
+		       "(expected %#zx)\n", inflate, pos, inflate->pos );
+		rc = -ENOTSUP;
+		goto err;
+	}
+	inflate->pos += len;
+
+	/* Process data */
+	if ( ( rc = inflate_process ( inflate, iobuf->data, len ) ) != 0 )
+		goto err;
+
+ done:
+	free_iob ( iobuf );
+	return rc;
+
+ err:
+	free_iob ( iobuf );
+	inflate_close ( inflate, rc );
+	return rc;
+}
+
+/** Decompression filter compressed data interface operations */
+static struct interface_operation inflate_raw_operations[] = {
+	INTF_OP ( xfer_deliver, struct inflate *, inflate_deliver ),
+	INTF_OP ( intf_close, struct inflate *, inflate_close ),
+};
+
+/** Decompression filter compressed data interface descriptor */
+static struct interface_descriptor inflate_raw_desc =
+	INTF_DESC_PASSTHRU ( struct inflate, raw, inflate_raw_operations,
+			     xfer );
+
+/** Decompression filter decompressed data interface operations */
+static struct interface_operation inflate_xfer_operations[] = {
+	INTF_OP ( intf_close, struct inflate *, inflate_close ),
+};
+
+/** Decompression filter decompressed data interface descriptor */
+static struct interface_descriptor inflate_xfer_desc =
+	INTF_DESC_PASSTHRU ( struct inflate, xfer, inflate_xfer_operations,
+			     raw );
+
+/**
+ * Add decompression filter
+ *
+ * @v xfer		Data transfer interface
+ * @ret rc		Return status code
+ */
+int add_inflate ( struct interface *xfer ) {
+	struct inflate *inflate;
+
+	/* Allocate and initialise structure */
+	inflate = zalloc ( sizeof ( *inflate ) );
+	if ( ! inflate )
+		return -ENOMEM;
+	ref_init ( &inflate->refcnt, NULL );
+	intf_init ( &inflate->xfer, &inflate_xfer_desc, &inflate->refcnt );
+	intf_init ( &inflate->raw, &inflate_raw_desc, &inflate->refcnt );
+	inflate->crc = 0xffffffffUL;
+
+	/* Attach to parent interface, mortalise self, and return */
+	intf_insert ( xfer, &inflate->xfer, &inflate->raw );
+	ref_put ( &inflate->refcnt );
+	return 0;
+}
@@ -177,6 +177,46 @@ static struct interface * intf_get_passthru ( struct interface *intf ) {
 	}
 }
 
+/** Number of entries in the operation method cache (must be a power of two)
+ *
+ * Interface descriptors and operation tables are static, so the
+ * method implementing a given operation type for a given descriptor
+ * never changes.  Caching the result allows data-path operations
+ * such as xfer_deliver() to avoid rescanning operation tables at
+ * every hop along a chain of interfaces.
+ */
+#define INTF_OP_CACHE_SIZE 64
+
+/** An operation method cache entry */
+struct interface_op_cache {
+	/** Destination interface descriptor, or NULL if unused */
+	struct interface_descriptor *desc;
+	/** Operation type */
+	void *type;
+	/** Implementing method, or NULL */
+	void *func;
+};
+
+/** Operation method cache */
+static struct interface_op_cache intf_op_cache[INTF_OP_CACHE_SIZE];
+
+/**
+ * Get operation method cache entry
+ *
+ * @v desc		Interface descriptor
+ * @v type		Operation type
+ * @ret cache		Operation method cache entry
+ */
+static inline struct interface_op_cache *
+intf_op_cache_entry ( struct interface_descriptor *desc, void *type ) {
+	unsigned long key;
+
+	key = ( ( ( ( intptr_t ) desc ) >> 3 ) ^
+		( ( ( intptr_t ) type ) >> 2 ) );
+	key ^= ( key >> 6 );
+	return &intf_op_cache[ key & ( INTF_OP_CACHE_SIZE - 1 ) ];
+}
+
 /**
  * Get object interface destination and operation method (without pass-through)
  *
@@ -189,17 +229,33 @@ void * intf_get_dest_op_no_passthru_untyped ( struct interface *intf,
 					      void *type,
 					      struct interface **dest ) {
 	struct interface_descriptor *desc;
+	struct interface_op_cache *cache;
 	struct interface_operation *op;
+	void *func = NULL;
 	unsigned int i;
 
 	*dest = intf_get ( intf->dest );
 	desc = (*dest)->desc;
+
+	/* Use cached method, if available */
+	cache = intf_op_cache_entry ( desc, type );
+	if ( ( cache->desc == desc ) && ( cache->type == type ) )
+		return cache->func;
+
+	/* Search operation table */
 	for ( i = desc->num_op, op = desc->op ; i ; i--, op++ ) {
-		if ( op->type == type )
-			return op->func;
+		if ( op->type == type ) {
+			func = op->func;
+			break;
+		}
 	}
 
-	return NULL;
+	/* Record result (including absence of a method) in cache */
+	cache->desc = desc;
+	cache->type = type;
+	cache->func = func;
+
+	return func;
 }
 
 /**
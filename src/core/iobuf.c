@@ -36,6 +36,12 @@ FILE_SECBOOT ( PERMITTED );
  *
  */
 
+/** Recycled receive I/O buffers */
+static LIST_HEAD ( iob_recycled );
+
+/** Number of recycled receive I/O buffers */
+static unsigned int iob_recycled_count;
+
 /**
  * Allocate I/O buffer with specified alignment and offset
  *
@@ -111,6 +117,9 @@ struct io_buffer * alloc_iob_raw ( size_t len, size_t align, size_t offset ) {
 
 	/* Populate descriptor */
 	memset ( &iobuf->map, 0, sizeof ( iobuf->map ) );
+	iobuf->rx_len = 0;
+	iobuf->flags = 0;
+	iobuf->frag = NULL;
 	iobuf->head = data;
 	iobuf->data = iobuf->tail = ( data + headroom );
 	iobuf->end = ( data + len );
@@ -145,13 +154,38 @@ struct io_buffer * alloc_iob ( size_t len ) {
 	return alloc_iob_raw ( len, align, 0 );
 }
 
+/**
+ * Release I/O buffer memory
+ *
+ * @v iobuf	I/O buffer
+ */
+static void iob_release ( struct io_buffer *iobuf ) {
+	size_t len;
+
+	/* Free buffer */
+	len = ( iobuf->end - iobuf->head );
+	if ( iobuf->end == iobuf ) {
+
+		/* Descriptor is inline */
+		free_phys ( iobuf->head, ( len + sizeof ( *iobuf ) ) );
+
+	} else {
+
+		/* Descriptor is detached */
+		free_phys ( iobuf->head, len );
+		free ( iobuf );
+	}
+}
+
 /**
  * Free I/O buffer
  *
  * @v iobuf	I/O buffer
+ *
+ * Receive I/O buffers will be retained for reuse, if possible.
  */
 void free_iob ( struct io_buffer *iobuf ) {
-	size_t len;
+	struct io_buffer *frag;
 
 	/* Allow free_iob(NULL) to be valid */
 	if ( ! iobuf )
@@ -163,19 +197,48 @@ void free_iob ( struct io_buffer *iobuf ) {
 	assert ( iobuf->tail <= iobuf->end );
 	assert ( ! dma_mapped ( &iobuf->map ) );
 
-	/* Free buffer */
-	len = ( iobuf->end - iobuf->head );
-	if ( iobuf->end == iobuf ) {
+	/* Free any chained fragments */
+	while ( ( frag = iobuf->frag ) != NULL ) {
+		iobuf->frag = frag->frag;
+		frag->frag = NULL;
+		free_iob ( frag );
+	}
 
-		/* Descriptor is inline */
-		free_phys ( iobuf->head, ( len + sizeof ( *iobuf ) ) );
+	/* Recycle receive I/O buffer, if applicable */
+	if ( iobuf->rx_len && ( iob_recycled_count < IOB_RECYCLE_MAX ) ) {
+		list_add ( &iobuf->list, &iob_recycled );
+		iob_recycled_count++;
+		return;
+	}
 
-	} else {
+	/* Release buffer */
+	iob_release ( iobuf );
+}
 
-		/* Descriptor is detached */
-		free_phys ( iobuf->head, len );
-		free ( iobuf );
+/**
+ * Reuse recycled receive I/O buffer
+ *
+ * @v len	Required length of buffer
+ * @ret iobuf	I/O buffer, or NULL if none available
+ */
+static struct io_buffer * iob_reuse ( size_t len ) {
+	struct io_buffer *iobuf;
+
+	/* Find a recycled buffer of the same requested length.  The
+	 * most recently freed buffer is checked first, since it is
+	 * the most likely to still be cached.
+	 */
+	list_for_each_entry ( iobuf, &iob_recycled, list ) {
+		if ( iobuf->rx_len == len ) {
+			list_del ( &iobuf->list );
+			iob_recycled_count--;
+			iobuf->data = iobuf->tail = iobuf->head;
+			iobuf->flags = 0;
+			return iobuf;
+		}
 	}
+
+	return NULL;
 }
 
 /**
@@ -184,15 +247,22 @@ void free_iob ( struct io_buffer *iobuf ) {
  * @v len		Length of I/O buffer
  * @v dma		DMA device
  * @ret iobuf		I/O buffer, or NULL on error
+ *
+ * A recycled receive I/O buffer of the same length will be reused,
+ * if available.
  */
 struct io_buffer * alloc_rx_iob ( size_t len, struct dma_device *dma ) {
 	struct io_buffer *iobuf;
 	int rc;
 
-	/* Allocate I/O buffer */
-	iobuf = alloc_iob ( len );
-	if ( ! iobuf )
-		goto err_alloc;
+	/* Reuse a recycled I/O buffer, or allocate a new I/O buffer */
+	iobuf = iob_reuse ( len );
+	if ( ! iobuf ) {
+		iobuf = alloc_iob ( len );
+		if ( ! iobuf )
+			goto err_alloc;
+		iobuf->rx_len = len;
+	}
 
 	/* Map I/O buffer */
 	if ( ( rc = iob_map_rx ( iobuf, dma ) ) != 0 )
@@ -311,3 +381,123 @@ struct io_buffer * iob_split ( struct io_buffer *iobuf, size_t len ) {
 	iob_pull ( iobuf, len );
 	return split;
 }
+
+/**
+ * Append fragment to chained I/O buffer
+ *
+ * @v iobuf		I/O buffer
+ * @v frag		Fragment to append (which may itself be chained)
+ *
+ * The fragment becomes owned by the (head) I/O buffer.  Transport
+ * checksums may be continued across fragments only at 16-bit
+ * boundaries, and so every fragment other than the last must
+ * contain an even number of bytes.
+ */
+void iob_chain ( struct io_buffer *iobuf, struct io_buffer *frag ) {
+
+	/* Find final fragment */
+	while ( iobuf->frag )
+		iobuf = iobuf->frag;
+
+	/* Append fragment */
+	assert ( ( iob_len ( iobuf ) & 1 ) == 0 );
+	iobuf->frag = frag;
+}
+
+/**
+ * Linearise chained I/O buffer
+ *
+ * @v iobuf		I/O buffer
+ * @ret linear		Linearised I/O buffer, or NULL on allocation failure
+ *
+ * Copy the contents of all fragments into a single contiguous I/O
+ * buffer.  The head I/O buffer will be reused if it has sufficient
+ * tailroom, otherwise a new I/O buffer will be allocated (preserving
+ * the headroom and transmit offload metadata of the head I/O buffer).
+ *
+ * On success, the original I/O buffer (and all fragments) will have
+ * been consumed.  If this call fails, then the original I/O buffer
+ * will be unmodified.
+ */
+struct io_buffer * iob_linearise ( struct io_buffer *iobuf ) {
+	struct io_buffer *linear;
+	struct io_buffer *frag;
+	size_t headroom;
+	size_t len;
+
+	/* Do nothing unless buffer is chained */
+	if ( ! iobuf->frag )
+		return iobuf;
+
+	/* Sanity check */
+	assert ( ! dma_mapped ( &iobuf->map ) );
+
+	/* Reuse head I/O buffer if possible, otherwise allocate a
+	 * new I/O buffer with the same headroom.
+	 */
+	len = iob_total_len ( iobuf );
+	if ( iob_tailroom ( iobuf ) >= ( len - iob_len ( iobuf ) ) ) {
+		linear = iobuf;
+	} else {
+		headroom = iob_headroom ( iobuf );
+		linear = alloc_iob ( headroom + len );
+		if ( ! linear )
+			return NULL;
+		iob_reserve ( linear, headroom );
+		memcpy ( iob_put ( linear, iob_len ( iobuf ) ), iobuf->data,
+			 iob_len ( iobuf ) );
+		linear->flags = iobuf->flags;
+		if ( iobuf->flags & ( IOB_TX_CSUM | IOB_TX_TSO ) ) {
+			linear->net_hdr = ( linear->data +
+					    ( iobuf->net_hdr - iobuf->data ) );
+			linear->trans_hdr = ( linear->data +
+					      ( iobuf->trans_hdr -
+						iobuf->data ) );
+			linear->trans_hdr_len = iobuf->trans_hdr_len;
+			linear->csum_offset = iobuf->csum_offset;
+			linear->mss = iobuf->mss;
+		}
+		linear->vlan_tci = iobuf->vlan_tci;
+	}
+
+	/* Copy in fragments */
+	for ( frag = iobuf->frag ; frag ; frag = frag->frag ) {
+		memcpy ( iob_put ( linear, iob_len ( frag ) ), frag->data,
+			 iob_len ( frag ) );
+	}
+
+	/* Free original I/O buffer (or just its fragments) */
+	if ( linear == iobuf ) {
+		frag = iobuf->frag;
+		iobuf->frag = NULL;
+		free_iob ( frag );
+	} else {
+		free_iob ( iobuf );
+	}
+
+	return linear;
+}
+
+/**
+ * Discard recycled receive I/O buffers
+ *
+ * @ret discarded	Number of cached items discarded
+ */
+static unsigned int iob_discard ( void ) {
+	struct io_buffer *iobuf;
+
+	/* Release least recently freed buffer, if any */
+	iobuf = list_last_entry ( &iob_recycled, struct io_buffer, list );
+	if ( ! iobuf )
+		return 0;
+	list_del ( &iobuf->list );
+	iob_recycled_count--;
+	iob_release ( iobuf );
+
+	return 1;
+}
+
+/** Recycled receive I/O buffer cache discarder */
+struct cache_discarder iob_discarder __cache_discarder ( CACHE_CHEAP ) = {
+	.discard = iob_discard,
+};
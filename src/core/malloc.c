@@ -59,6 +59,16 @@ struct memory_block {
 	struct list_head list;
 };
 
+/** A free block of memory held within a size-class bin */
+struct binned_block {
+	/** Size of this block */
+	size_t size;
+	/** Padding (as for a free block within the free block list) */
+	char pad[ sizeof ( ( ( struct memory_block * ) NULL )->pad ) ];
+	/** Next block within bin */
+	struct binned_block *next;
+};
+
 /** Physical address alignment maintained for free blocks of memory
  *
  * We keep memory blocks aligned on a power of two that is at least
@@ -186,10 +196,37 @@ static inline void valgrind_make_blocks_noaccess ( struct heap *heap ) {
 static inline void check_blocks ( struct heap *heap ) {
 	struct memory_block *block;
 	struct memory_block *prev = NULL;
+	struct binned_block *binned;
+	struct binned_block *next;
+	unsigned int count;
+	unsigned int i;
 
 	if ( ! ASSERTING )
 		return;
 
+	for ( i = 0 ; i < HEAP_BINS ; i++ ) {
+		count = 0;
+		for ( binned = heap->bins[i].first ; binned ; binned = next ) {
+			VALGRIND_MAKE_MEM_DEFINED ( binned,
+						    sizeof ( *binned ) );
+
+			/* Check alignment */
+			assert ( ( virt_to_phys ( binned ) &
+				   ( heap->align - 1 ) ) == 0 );
+
+			/* Check that block size matches bin */
+			assert ( binned->size == ( ( i + 1 ) * heap->align ) );
+
+			next = binned->next;
+			VALGRIND_MAKE_MEM_NOACCESS ( binned,
+						     sizeof ( *binned ) );
+			count++;
+		}
+
+		/* Check bin count */
+		assert ( count == heap->bins[i].count );
+	}
+
 	list_for_each_entry ( block, &heap->blocks, list ) {
 
 		/* Check alignment */
@@ -249,6 +286,163 @@ static void discard_all_cache ( void ) {
 	} while ( discarded );
 }
 
+/**
+ * Identify size-class bin
+ *
+ * @v heap		Heap
+ * @v size		Actual size of memory block
+ * @ret bin		Size-class bin, or NULL if not applicable
+ */
+static inline struct heap_bin * heap_bin ( struct heap *heap, size_t size ) {
+	size_t index;
+
+	/* Bins are not used for heaps that are permitted to shrink */
+	if ( heap->shrink )
+		return NULL;
+
+	/* Identify bin */
+	index = ( ( size / heap->align ) - 1 );
+	if ( index >= HEAP_BINS )
+		return NULL;
+	return &heap->bins[index];
+}
+
+/**
+ * Allocate a memory block from a size-class bin
+ *
+ * @v heap		Heap
+ * @v bin		Size-class bin
+ * @v actual_offset	Offset of memory block from physical alignment
+ * @v align_mask	Alignment mask
+ * @ret block		Memory block, or NULL
+ *
+ * Only the most recently freed block within the bin is considered.
+ * Blocks are binned only by size, and so this block may not satisfy
+ * the requested alignment.
+ */
+static void * heap_alloc_binned ( struct heap *heap __unused,
+				  struct heap_bin *bin, size_t actual_offset,
+				  size_t align_mask ) {
+	struct binned_block *block;
+
+	/* Check most recently freed block, if any */
+	block = bin->first;
+	if ( ! block )
+		return NULL;
+	if ( ( actual_offset - virt_to_phys ( block ) ) & align_mask )
+		return NULL;
+
+	/* Remove block from bin */
+	VALGRIND_MAKE_MEM_DEFINED ( block, sizeof ( *block ) );
+	bin->first = block->next;
+	bin->count--;
+	VALGRIND_MAKE_MEM_NOACCESS ( block, sizeof ( *block ) );
+
+	return block;
+}
+
+/**
+ * Insert a free memory block into the free list
+ *
+ * @v heap		Heap
+ * @v freeing		Free memory block
+ *
+ * The block will be merged with any adjacent free blocks.  Memory
+ * usage statistics must already have been updated by the caller.
+ */
+static void heap_insert_block ( struct heap *heap,
+				struct memory_block *freeing ) {
+	struct memory_block *block;
+	struct memory_block *tmp;
+	ssize_t gap_before;
+	ssize_t gap_after = -1;
+
+	/* Insert/merge into free list */
+	list_for_each_entry_safe ( block, tmp, &heap->blocks, list ) {
+		/* Calculate gaps before and after the "freeing" block */
+		gap_before = ( ( ( void * ) freeing ) - 
+			       ( ( ( void * ) block ) + block->size ) );
+		gap_after = ( ( ( void * ) block ) - 
+			      ( ( ( void * ) freeing ) + freeing->size ) );
+		/* Merge with immediately preceding block, if possible */
+		if ( gap_before == 0 ) {
+			DBGC2 ( heap, "HEAP merging [%p,%p) + [%p,%p) -> "
+				"[%p,%p)\n", block,
+				( ( ( void * ) block ) + block->size ), freeing,
+				( ( ( void * ) freeing ) + freeing->size ),
+				block,
+				( ( ( void * ) freeing ) + freeing->size ) );
+			block->size += freeing->size;
+			list_del ( &block->list );
+			VALGRIND_MAKE_MEM_NOACCESS ( freeing,
+						     sizeof ( *freeing ) );
+			freeing = block;
+		}
+		/* Stop processing as soon as we reach a following block */
+		if ( gap_after >= 0 )
+			break;
+	}
+
+	/* Insert before the immediately following block.  If
+	 * possible, merge the following block into the "freeing"
+	 * block.
+	 */
+	DBGC2 ( heap, "HEAP freed [%p,%p)\n",
+		freeing, ( ( ( void * ) freeing ) + freeing->size ) );
+	list_add_tail ( &freeing->list, &block->list );
+	if ( gap_after == 0 ) {
+		DBGC2 ( heap, "HEAP merging [%p,%p) + [%p,%p) -> [%p,%p)\n",
+			freeing, ( ( ( void * ) freeing ) + freeing->size ),
+			block, ( ( ( void * ) block ) + block->size ), freeing,
+			( ( ( void * ) block ) + block->size ) );
+		freeing->size += block->size;
+		list_del ( &block->list );
+		VALGRIND_MAKE_MEM_NOACCESS ( block, sizeof ( *block ) );
+	}
+
+	/* Allow heap to shrink */
+	if ( heap->shrink && heap->shrink ( freeing, freeing->size ) ) {
+		list_del ( &freeing->list );
+		heap->freemem -= freeing->size;
+		VALGRIND_MAKE_MEM_UNDEFINED ( freeing, freeing->size );
+	}
+}
+
+/**
+ * Merge all binned blocks into the free list
+ *
+ * @v heap		Heap
+ * @ret merged		Number of blocks merged
+ */
+static unsigned int heap_unbin_all ( struct heap *heap ) {
+	struct heap_bin *bin;
+	struct binned_block *binned;
+	struct memory_block *freeing;
+	unsigned int merged = 0;
+	unsigned int i;
+
+	for ( i = 0 ; i < HEAP_BINS ; i++ ) {
+		bin = &heap->bins[i];
+		while ( ( binned = bin->first ) ) {
+			VALGRIND_MAKE_MEM_DEFINED ( binned,
+						    sizeof ( *binned ) );
+			bin->first = binned->next;
+			bin->count--;
+			freeing = ( ( struct memory_block * ) binned );
+			VALGRIND_MAKE_MEM_UNDEFINED ( freeing,
+						      sizeof ( *freeing ) );
+			freeing->size = ( ( i + 1 ) * heap->align );
+			heap_insert_block ( heap, freeing );
+			merged++;
+		}
+	}
+	if ( merged ) {
+		DBGC ( heap, "HEAP merged %d binned blocks\n", merged );
+	}
+
+	return merged;
+}
+
 /**
  * Allocate a memory block
  *
@@ -273,6 +467,7 @@ static void * heap_alloc_block ( struct heap *heap, size_t size, size_t align,
 	size_t post_size;
 	struct memory_block *pre;
 	struct memory_block *post;
+	struct heap_bin *bin;
 	unsigned int grown;
 	void *ptr;
 
@@ -308,6 +503,23 @@ static void * heap_alloc_block ( struct heap *heap, size_t size, size_t align,
 
 	DBGC2 ( heap, "HEAP allocating %#zx (aligned %#zx+%#zx)\n",
 		size, align, offset );
+
+	/* Use a recently freed block of the same size, if possible */
+	bin = heap_bin ( heap, actual_size );
+	if ( bin && ( block = heap_alloc_binned ( heap, bin, actual_offset,
+						  align_mask ) ) ) {
+		heap->freemem -= actual_size;
+		heap->usedmem += actual_size;
+		if ( heap->usedmem > heap->maxusedmem )
+			heap->maxusedmem = heap->usedmem;
+		heap->allocs++;
+		ptr = ( ( ( void * ) block ) + offset - actual_offset );
+		DBGC2 ( heap, "HEAP allocated [%p,%p) from bin\n",
+			ptr, ( ptr + size ) );
+		VALGRIND_MAKE_MEM_UNDEFINED ( ptr, size );
+		goto done;
+	}
+
 	while ( 1 ) {
 		/* Search through blocks for the first one with enough space */
 		list_for_each_entry ( block, &heap->blocks, list ) {
@@ -363,6 +575,7 @@ static void * heap_alloc_block ( struct heap *heap, size_t size, size_t align,
 			heap->usedmem += actual_size;
 			if ( heap->usedmem > heap->maxusedmem )
 				heap->maxusedmem = heap->usedmem;
+			heap->allocs++;
 			/* Return allocated block */
 			ptr = ( ( ( void * ) block ) + offset - actual_offset );
 			DBGC2 ( heap, "HEAP allocated [%p,%p) within "
@@ -372,6 +585,10 @@ static void * heap_alloc_block ( struct heap *heap, size_t size, size_t align,
 			goto done;
 		}
 
+		/* Merge any binned blocks into the free list and retry */
+		if ( heap_unbin_all ( heap ) )
+			continue;
+
 		/* Attempt to grow heap to satisfy allocation */
 		DBGC ( heap, "HEAP attempting to grow for %#zx (aligned "
 		       "%#zx+%zx), used %zdkB\n", size, align, offset,
@@ -387,6 +604,7 @@ static void * heap_alloc_block ( struct heap *heap, size_t size, size_t align,
 			ptr = NULL;
 			goto done;
 		}
+		heap->grows++;
 	}
 
  done:
@@ -407,11 +625,12 @@ static void * heap_alloc_block ( struct heap *heap, size_t size, size_t align,
 static void heap_free_block ( struct heap *heap, void *ptr, size_t size ) {
 	struct memory_block *freeing;
 	struct memory_block *block;
-	struct memory_block *tmp;
+	struct binned_block *binned;
+	struct binned_block *next;
+	struct heap_bin *bin;
 	size_t sub_offset;
 	size_t actual_size;
-	ssize_t gap_before;
-	ssize_t gap_after = -1;
+	unsigned int i;
 
 	/* Allow for ptr==NULL */
 	if ( ! ptr )
@@ -451,61 +670,51 @@ static void heap_free_block ( struct heap *heap, void *ptr, size_t size ) {
 				       __builtin_return_address ( 0 ) );
 			}
 		}
-	}
-
-	/* Insert/merge into free list */
-	freeing->size = actual_size;
-	list_for_each_entry_safe ( block, tmp, &heap->blocks, list ) {
-		/* Calculate gaps before and after the "freeing" block */
-		gap_before = ( ( ( void * ) freeing ) - 
-			       ( ( ( void * ) block ) + block->size ) );
-		gap_after = ( ( ( void * ) block ) - 
-			      ( ( ( void * ) freeing ) + freeing->size ) );
-		/* Merge with immediately preceding block, if possible */
-		if ( gap_before == 0 ) {
-			DBGC2 ( heap, "HEAP merging [%p,%p) + [%p,%p) -> "
-				"[%p,%p)\n", block,
-				( ( ( void * ) block ) + block->size ), freeing,
-				( ( ( void * ) freeing ) + freeing->size ),
-				block,
-				( ( ( void * ) freeing ) + freeing->size ) );
-			block->size += actual_size;
-			list_del ( &block->list );
-			VALGRIND_MAKE_MEM_NOACCESS ( freeing,
-						     sizeof ( *freeing ) );
-			freeing = block;
+		for ( i = 0 ; i < HEAP_BINS ; i++ ) {
+			for ( binned = heap->bins[i].first ; binned ;
+			      binned = next ) {
+				VALGRIND_MAKE_MEM_DEFINED ( binned,
+							    sizeof ( *binned ));
+				next = binned->next;
+				if ( ( ( ( void * ) binned ) <
+				       ( ( void * ) freeing + actual_size ) ) &&
+				     ( ( void * ) freeing <
+				       ( ( void * ) binned +
+					 binned->size ) ) ) {
+					assert ( 0 );
+					DBGC ( heap, "HEAP double free of "
+					       "binned [%p,%p) from %p\n",
+					       binned, ( ( void * ) binned +
+							 binned->size ),
+					       __builtin_return_address ( 0 ) );
+				}
+				VALGRIND_MAKE_MEM_NOACCESS ( binned,
+							     sizeof (*binned) );
+			}
 		}
-		/* Stop processing as soon as we reach a following block */
-		if ( gap_after >= 0 )
-			break;
-	}
-
-	/* Insert before the immediately following block.  If
-	 * possible, merge the following block into the "freeing"
-	 * block.
-	 */
-	DBGC2 ( heap, "HEAP freed [%p,%p)\n",
-		freeing, ( ( ( void * ) freeing ) + freeing->size ) );
-	list_add_tail ( &freeing->list, &block->list );
-	if ( gap_after == 0 ) {
-		DBGC2 ( heap, "HEAP merging [%p,%p) + [%p,%p) -> [%p,%p)\n",
-			freeing, ( ( ( void * ) freeing ) + freeing->size ),
-			block, ( ( ( void * ) block ) + block->size ), freeing,
-			( ( ( void * ) block ) + block->size ) );
-		freeing->size += block->size;
-		list_del ( &block->list );
-		VALGRIND_MAKE_MEM_NOACCESS ( block, sizeof ( *block ) );
 	}
 
 	/* Update memory usage statistics */
 	heap->freemem += actual_size;
 	heap->usedmem -= actual_size;
 
-	/* Allow heap to shrink */
-	if ( heap->shrink && heap->shrink ( freeing, freeing->size ) ) {
-		list_del ( &freeing->list );
-		heap->freemem -= freeing->size;
-		VALGRIND_MAKE_MEM_UNDEFINED ( freeing, freeing->size );
+	/* Add small blocks to the appropriate size-class bin, if
+	 * possible.  Binned blocks are not merged into the free list
+	 * until an allocation would otherwise fail.
+	 */
+	bin = heap_bin ( heap, actual_size );
+	if ( bin && ( bin->count < HEAP_BIN_MAX ) ) {
+		binned = ( ( struct binned_block * ) freeing );
+		binned->size = actual_size;
+		binned->next = bin->first;
+		bin->first = binned;
+		bin->count++;
+		DBGC2 ( heap, "HEAP binned [%p,%p)\n", binned,
+			( ( ( void * ) binned ) + actual_size ) );
+		VALGRIND_MAKE_MEM_NOACCESS ( binned, sizeof ( *binned ) );
+	} else {
+		freeing->size = actual_size;
+		heap_insert_block ( heap, freeing );
 	}
 
 	/* Sanity checks */
@@ -590,7 +799,8 @@ void * heap_realloc ( struct heap *heap, void *old_ptr, size_t new_size ) {
 }
 
 /** The global heap */
-static struct heap heap = {
+static struct heap heap __heap ( HEAP_INTERNAL ) = {
+	.name = "heap",
 	.blocks = LIST_HEAD_INIT ( heap.blocks ),
 	.align = MIN_MEMBLOCK_ALIGN,
 	.ptr_align = sizeof ( void * ),
@@ -726,6 +936,16 @@ void free_phys ( void *ptr, size_t size ) {
 	heap_free_block ( &heap, ptr, size );
 }
 
+/**
+ * Get amount of free memory
+ *
+ * @ret freemem		Total amount of free memory in the global heap
+ */
+size_t malloc_freemem ( void ) {
+
+	return heap.freemem;
+}
+
 /**
  * Add memory to allocation pool
  *
@@ -786,12 +1006,43 @@ struct startup_fn heap_startup_fn __startup_fn ( STARTUP_EARLY ) = {
 	.shutdown = shutdown_cache,
 };
 
+/**
+ * Get size of largest free memory block
+ *
+ * @v heap		Heap
+ * @ret largest		Size of largest free memory block
+ */
+size_t heap_largest ( struct heap *heap ) {
+	struct memory_block *block;
+	size_t largest = 0;
+	unsigned int i;
+
+	/* Find largest block in free list */
+	valgrind_make_blocks_defined ( heap );
+	list_for_each_entry ( block, &heap->blocks, list ) {
+		if ( block->size > largest )
+			largest = block->size;
+	}
+	valgrind_make_blocks_noaccess ( heap );
+
+	/* Allow for binned blocks */
+	for ( i = 0 ; i < HEAP_BINS ; i++ ) {
+		if ( heap->bins[i].count &&
+		     ( ( ( i + 1 ) * heap->align ) > largest ) ) {
+			largest = ( ( i + 1 ) * heap->align );
+		}
+	}
+
+	return largest;
+}
+
 /**
  * Dump free block list (for debugging)
  *
  */
 void heap_dump ( struct heap *heap ) {
 	struct memory_block *block;
+	unsigned int i;
 
 	dbg_printf ( "HEAP free block list:\n" );
 	list_for_each_entry ( block, &heap->blocks, list ) {
@@ -799,4 +1050,11 @@ void heap_dump ( struct heap *heap ) {
 			     ( ( ( void * ) block ) + block->size ),
 			     block->size );
 	}
+	for ( i = 0 ; i < HEAP_BINS ; i++ ) {
+		if ( heap->bins[i].count ) {
+			dbg_printf ( "...bin %#zx: %d blocks\n",
+				     ( ( i + 1 ) * heap->align ),
+				     heap->bins[i].count );
+		}
+	}
 }
@@ -33,6 +33,7 @@ FILE_SECBOOT ( PERMITTED );
 #include <ipxe/job.h>
 #include <ipxe/monojob.h>
 #include <ipxe/timer.h>
+#include <ipxe/nap.h>
 
 /** @file
  *
@@ -40,6 +41,9 @@ FILE_SECBOOT ( PERMITTED );
  *
  */
 
+/** Progress display refresh interval */
+#define MONOJOB_REFRESH TICKS_PER_SEC
+
 static int monojob_rc;
 
 static void monojob_close ( struct interface *intf, int rc ) {
@@ -57,19 +61,39 @@ static struct interface_descriptor monojob_intf_desc =
 struct interface monojob = INTF_INIT ( monojob_intf_desc );
 
 /**
- * Clear previously displayed message
+ * Move cursor back over previously displayed message
  *
  * @v len		Length of previously displayed message
  */
-static void monojob_clear ( size_t len ) {
+static void monojob_rewind ( size_t len ) {
 	unsigned int i;
 
 	for ( i = 0 ; i < len ; i++ )
 		putchar ( '\b' );
+}
+
+/**
+ * Erase characters following the cursor
+ *
+ * @v len		Number of characters to erase
+ */
+static void monojob_erase ( size_t len ) {
+	unsigned int i;
+
 	for ( i = 0 ; i < len ; i++ )
 		putchar ( ' ' );
-	for ( i = 0 ; i < len ; i++ )
-		putchar ( '\b' );
+	monojob_rewind ( len );
+}
+
+/**
+ * Clear previously displayed message
+ *
+ * @v len		Length of previously displayed message
+ */
+static void monojob_clear ( size_t len ) {
+
+	monojob_rewind ( len );
+	monojob_erase ( len );
 }
 
 /**
@@ -91,6 +115,7 @@ int monojob_wait ( const char *string, unsigned long timeout ) {
 	unsigned long scaled_total;
 	unsigned int percentage;
 	size_t clear_len = 0;
+	size_t len;
 	int ongoing_rc;
 	int key;
 	int rc;
@@ -101,8 +126,12 @@ int monojob_wait ( const char *string, unsigned long timeout ) {
 	last_check = last_progress = last_display = currticks();
 	while ( monojob_rc == -EINPROGRESS ) {
 
-		/* Allow job to progress */
+		/* Allow job to progress, sleeping until the next
+		 * interrupt if there is nothing to do.
+		 */
 		step();
+		if ( process_idle() )
+			cpu_nap();
 		now = currticks();
 
 		/* Continue until a timer tick occurs (to minimise
@@ -137,25 +166,35 @@ int monojob_wait ( const char *string, unsigned long timeout ) {
 			break;
 		}
 
-		/* Display progress, if applicable */
+		/* Display progress, if applicable.  Skip this update
+		 * (rather than adding to the backlog) if a console is
+		 * still transmitting earlier output.
+		 */
 		elapsed = ( now - last_display );
-		if ( string && ( elapsed >= TICKS_PER_SEC ) ) {
-			monojob_clear ( clear_len );
+		if ( string && ( elapsed >= MONOJOB_REFRESH ) &&
+		     ( ! console_pending() ) ) {
+			/* Overwrite the previous message in place, to
+			 * minimise the number of characters written.
+			 */
+			monojob_rewind ( clear_len );
 			/* Normalise progress figures to avoid overflow */
 			scaled_completed = ( progress.completed / 128 );
 			scaled_total = ( progress.total / 128 );
 			if ( scaled_total ) {
 				percentage = ( ( 100 * scaled_completed ) /
 					       scaled_total );
-				clear_len = printf ( "%3d%%", percentage );
+				len = printf ( "%3d%%", percentage );
 			} else {
+				monojob_erase ( clear_len );
 				printf ( "." );
-				clear_len = 0;
+				clear_len = len = 0;
 			}
 			if ( progress.message[0] ) {
-				clear_len += printf ( " [%s]",
-						      progress.message );
+				len += printf ( " [%s]", progress.message );
 			}
+			if ( len < clear_len )
+				monojob_erase ( clear_len - len );
+			clear_len = len;
 			last_display = now;
 		}
 	}
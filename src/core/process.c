@@ -24,8 +24,10 @@
 FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 FILE_SECBOOT ( PERMITTED );
 
+#include <assert.h>
 #include <ipxe/list.h>
 #include <ipxe/init.h>
+#include <ipxe/timer.h>
 #include <ipxe/process.h>
 
 /** @file
@@ -34,10 +36,32 @@ FILE_SECBOOT ( PERMITTED );
  *
  * We implement a trivial form of cooperative multitasking, in which
  * all processes share a single stack and address space.
+ *
+ * A process that has nothing to do should remove itself from the run
+ * queue via process_del(), and will be added back via process_add()
+ * when an event (such as a timer expiry or data arrival) gives it
+ * something to do.
  */
 
-/** Process run queue */
-static LIST_HEAD ( run_queue );
+/** Time after which polling processes are considered to be idle
+ *
+ * This is long enough that traffic from any active transfer will
+ * keep the system in busy-polling mode, and short enough that
+ * waiting for a reply (e.g. to a DHCP request) will quickly fall
+ * back to sleeping between timer interrupts.
+ */
+#define PROCESS_IDLE_TIMEOUT ( TICKS_PER_SEC / 4 )
+
+/** Time at which polling processes last found work */
+static unsigned long process_activity;
+
+/** Process run queues (one per priority) */
+static struct list_head run_queues[PROCESS_PRIORITIES] = {
+	[PROCESS_PRIORITY_NORMAL] =
+		LIST_HEAD_INIT ( run_queues[PROCESS_PRIORITY_NORMAL] ),
+	[PROCESS_PRIORITY_POLL] =
+		LIST_HEAD_INIT ( run_queues[PROCESS_PRIORITY_POLL] ),
+};
 
 /**
  * Get pointer to object containing process
@@ -61,8 +85,10 @@ void process_add ( struct process *process ) {
 	if ( ! process_running ( process ) ) {
 		DBGC ( PROC_COL ( process ), "PROCESS " PROC_FMT
 		       " starting\n", PROC_DBG ( process ) );
+		assert ( process->desc->priority < PROCESS_PRIORITIES );
 		ref_get ( process->refcnt );
-		list_add_tail ( &process->list, &run_queue );
+		list_add_tail ( &process->list,
+				&run_queues[process->desc->priority] );
 	} else {
 		DBGC ( PROC_COL ( process ), "PROCESS " PROC_FMT
 		       " already started\n", PROC_DBG ( process ) );
@@ -91,24 +117,26 @@ void process_del ( struct process *process ) {
 }
 
 /**
- * Single-step a single process
+ * Single-step a single process from a run queue
+ *
+ * @v queue		Run queue
  *
  * This executes a single step of the first process in the run queue,
  * and moves the process to the end of the run queue.
  */
-void step ( void ) {
+static void step_queue ( struct list_head *queue ) {
 	struct process *process;
 	struct process_descriptor *desc;
 	void *object;
 
-	if ( ( process = list_first_entry ( &run_queue, struct process,
+	if ( ( process = list_first_entry ( queue, struct process,
 					    list ) ) ) {
 		ref_get ( process->refcnt ); /* Inhibit destruction mid-step */
 		desc = process->desc;
 		object = process_object ( process );
 		if ( desc->reschedule ) {
 			list_del ( &process->list );
-			list_add_tail ( &process->list, &run_queue );
+			list_add_tail ( &process->list, queue );
 		} else {
 			process_del ( process );
 		}
@@ -121,6 +149,59 @@ void step ( void ) {
 	}
 }
 
+/**
+ * Single-step processes
+ *
+ * This executes a single step of the first process in each run
+ * queue, in descending order of priority.
+ */
+void step ( void ) {
+	unsigned int priority;
+
+	for ( priority = PROCESS_PRIORITIES ; priority-- ; )
+		step_queue ( &run_queues[priority] );
+}
+
+/**
+ * Check if any normal-priority processes are runnable
+ *
+ * @ret runnable	Normal-priority processes are runnable
+ */
+int process_runnable ( void ) {
+
+	return ( ! list_empty ( &run_queues[PROCESS_PRIORITY_NORMAL] ) );
+}
+
+/**
+ * Record activity by a polling process
+ *
+ * Polling processes should call this function whenever polling finds
+ * work to do (e.g. a received packet).
+ */
+void process_active ( void ) {
+
+	process_activity = currticks();
+}
+
+/**
+ * Check if system is idle
+ *
+ * @ret idle		System is idle
+ *
+ * The system is idle if no normal-priority processes are runnable,
+ * and no polling process has found any work recently.  An idle
+ * system may sleep until the next interrupt via cpu_nap() rather
+ * than busy-polling, at the cost of adding up to one timer interrupt
+ * period of latency to the next event.  Any polling activity
+ * immediately returns the system to busy-polling mode.
+ */
+int process_idle ( void ) {
+
+	return ( ( ! process_runnable() ) &&
+		 ( ( currticks() - process_activity ) >=
+		   PROCESS_IDLE_TIMEOUT ) );
+}
+
 /**
  * Initialise processes
  *
@@ -26,6 +26,7 @@ FILE_SECBOOT ( PERMITTED );
 
 #include <stdint.h>
 #include <stdio.h>
+#include <string.h>
 #include <strings.h>
 #include <limits.h>
 #include <assert.h>
@@ -44,6 +45,10 @@ FILE_SECBOOT ( PERMITTED );
  * The algorithm for updating the mean and variance estimators is from
  * The Art of Computer Programming (via Wikipedia), with adjustments
  * to avoid the use of floating-point instructions.
+ *
+ * A histogram of samples (bucketed by the base-2 logarithm of the
+ * sample value) is also maintained, allowing for approximate
+ * percentiles to be reported in order to identify tail latencies.
  */
 
 /** Accumulated time excluded from profiling */
@@ -118,6 +123,7 @@ void profile_update ( struct profiler *profiler, unsigned long sample ) {
 	unsigned int accvar_delta_shift;
 	unsigned int accvar_delta_msb;
 	unsigned int accvar_shift;
+	unsigned int bucket;
 
 	/* Our scaling logic assumes that sample values never overflow
 	 * a signed long (i.e. that the high bit is always zero).
@@ -128,6 +134,13 @@ void profile_update ( struct profiler *profiler, unsigned long sample ) {
 	if ( profiler->count < INT_MAX )
 		profiler->count++;
 
+	/* Update histogram, limiting to avoid overflow */
+	bucket = flsl ( sample );
+	if ( bucket >= PROFILE_BUCKETS )
+		bucket = ( PROFILE_BUCKETS - 1 );
+	if ( profiler->histogram[bucket] < UINT_MAX )
+		profiler->histogram[bucket]++;
+
 	/* Adjust mean sample value scale if necessary.  Skip if
 	 * sample is zero (in which case flsl(sample)-1 would
 	 * underflow): in the case of a zero sample we have no need to
@@ -277,3 +290,49 @@ unsigned long profile_stddev ( struct profiler *profiler ) {
 
 	return isqrt ( profile_variance ( profiler ) );
 }
+
+/**
+ * Get approximate sample percentile
+ *
+ * @v profiler		Profiler
+ * @v percentile	Percentile (0-100)
+ * @ret value		Upper bound of histogram bucket containing percentile
+ */
+unsigned long profile_percentile ( struct profiler *profiler,
+				   unsigned int percentile ) {
+	unsigned long long total = 0;
+	unsigned long long threshold;
+	unsigned long long cumulative = 0;
+	unsigned int bucket;
+
+	/* Count samples */
+	for ( bucket = 0 ; bucket < PROFILE_BUCKETS ; bucket++ )
+		total += profiler->histogram[bucket];
+	if ( ! total )
+		return 0;
+
+	/* Find bucket containing the relevant sample */
+	threshold = ( ( ( total * percentile ) + 99 ) / 100 );
+	for ( bucket = 0 ; bucket < ( PROFILE_BUCKETS - 1 ) ; bucket++ ) {
+		cumulative += profiler->histogram[bucket];
+		if ( cumulative >= threshold )
+			return ( bucket ? ( ( 2UL << ( bucket - 1 ) ) - 1 ) : 0 );
+	}
+	return LONG_MAX;
+}
+
+/**
+ * Find profiler by name
+ *
+ * @v name		Profiler name
+ * @ret profiler	Profiler, or NULL if not found
+ */
+struct profiler * find_profiler ( const char *name ) {
+	struct profiler *profiler;
+
+	for_each_table_entry ( profiler, PROFILERS ) {
+		if ( strcmp ( profiler->name, name ) == 0 )
+			return profiler;
+	}
+	return NULL;
+}
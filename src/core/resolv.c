@@ -33,6 +33,8 @@ FILE_SECBOOT ( PERMITTED );
 #include <ipxe/process.h>
 #include <ipxe/socket.h>
 #include <ipxe/resolv.h>
+#include <ipxe/retry.h>
+#include <ipxe/timer.h>
 
 /** @file
  *
@@ -299,6 +301,31 @@ int resolv ( struct interface *resolv, const char *name,
  ***************************************************************************
  */
 
+/** Connection attempt delay
+ *
+ * When a name resolves to addresses in more than one address family,
+ * stream connections are attempted to each address in turn, with a
+ * further attempt being started whenever the previous attempt has
+ * not completed within this time (as recommended by RFC 8305 section
+ * 5).  The first attempt to complete is used.
+ */
+#define NAMED_ATTEMPT_DELAY ( 250 * TICKS_PER_MS )
+
+/** Maximum number of connection attempts (one per address family) */
+#define NAMED_MAX_ATTEMPTS 2
+
+struct named_socket;
+
+/** A named socket connection attempt */
+struct named_attempt {
+	/** Named socket */
+	struct named_socket *named;
+	/** Data transfer interface */
+	struct interface xfer;
+	/** Peer socket address */
+	struct sockaddr peer;
+};
+
 /** A named socket */
 struct named_socket {
 	/** Reference counter */
@@ -313,6 +340,21 @@ struct named_socket {
 	struct sockaddr local;
 	/** Stored local socket address exists */
 	int have_local;
+
+	/** Connection attempts */
+	struct named_attempt attempts[NAMED_MAX_ATTEMPTS];
+	/** Number of resolved addresses */
+	unsigned int count;
+	/** Number of connection attempts started */
+	unsigned int started;
+	/** Number of connection attempts in progress */
+	unsigned int active;
+	/** Name resolution is in progress */
+	int resolving;
+	/** Connection attempt delay timer */
+	struct retry_timer timer;
+	/** Most recent failure status code */
+	int rc;
 };
 
 /**
@@ -322,7 +364,14 @@ struct named_socket {
  * @v rc		Reason for termination
  */
 static void named_close ( struct named_socket *named, int rc ) {
+	unsigned int i;
+
+	/* Stop timer */
+	stop_timer ( &named->timer );
+
 	/* Shut down interfaces */
+	for ( i = 0 ; i < NAMED_MAX_ATTEMPTS ; i++ )
+		intf_shutdown ( &named->attempts[i].xfer, rc );
 	intf_shutdown ( &named->resolv, rc );
 	intf_shutdown ( &named->xfer, rc );
 }
@@ -350,13 +399,140 @@ static struct interface_descriptor named_xfer_desc =
 			     resolv );
 
 /**
- * Name resolved
+ * Terminate named socket opener if no further progress is possible
+ *
+ * @v named		Named socket
+ */
+static void named_check ( struct named_socket *named ) {
+
+	/* Do nothing while any attempt may still succeed */
+	if ( named->resolving || named->active ||
+	     ( named->started < named->count ) )
+		return;
+
+	/* Terminate named socket opener */
+	DBGC ( named, "NAMED %p all connection attempts failed: %s\n",
+	       named, strerror ( named->rc ) );
+	named_close ( named, named->rc );
+}
+
+/**
+ * Start next connection attempt
+ *
+ * @v named		Named socket
+ */
+static void named_next ( struct named_socket *named ) {
+	struct sockaddr *local = ( named->have_local ? &named->local : NULL );
+	struct named_attempt *attempt;
+	int rc;
+
+	/* Start the next attempt, if any, that can be opened */
+	while ( named->started < named->count ) {
+		attempt = &named->attempts[ named->started++ ];
+		DBGC ( named, "NAMED %p attempting %s\n",
+		       named, sock_ntoa ( &attempt->peer ) );
+		if ( ( rc = xfer_open_socket ( &attempt->xfer, named->semantics,
+					       &attempt->peer, local ) ) != 0 ) {
+			DBGC ( named, "NAMED %p could not open %s: %s\n",
+			       named, sock_ntoa ( &attempt->peer ),
+			       strerror ( rc ) );
+			named->rc = rc;
+			continue;
+		}
+		named->active++;
+		start_timer_fixed ( &named->timer, NAMED_ATTEMPT_DELAY );
+		return;
+	}
+
+	/* Terminate if there is nothing left to try */
+	named_check ( named );
+}
+
+/**
+ * Handle connection attempt delay timer expiry
+ *
+ * @v timer		Connection attempt delay timer
+ * @v fail		Failure indicator
+ */
+static void named_expired ( struct retry_timer *timer, int fail __unused ) {
+	struct named_socket *named =
+		container_of ( timer, struct named_socket, timer );
+
+	/* Start next connection attempt, if any */
+	if ( named->started < named->count )
+		named_next ( named );
+}
+
+/**
+ * Handle connection attempt window change
+ *
+ * @v attempt		Connection attempt
+ */
+static void named_attempt_window_changed ( struct named_attempt *attempt ) {
+	struct named_socket *named = attempt->named;
+	struct interface *socket;
+
+	/* Wait until connection is established */
+	if ( ! xfer_window ( &attempt->xfer ) )
+		return;
+	DBGC ( named, "NAMED %p connected to %s\n",
+	       named, sock_ntoa ( &attempt->peer ) );
+
+	/* Plug parent interface directly into the connected socket */
+	socket = intf_get ( attempt->xfer.dest );
+	intf_plug_plug ( named->xfer.dest, socket );
+	intf_unplug ( &named->xfer );
+	intf_unplug ( &attempt->xfer );
+
+	/* Notify parent that the connection is ready */
+	xfer_window_changed ( socket );
+	intf_put ( socket );
+
+	/* Abandon any other connection attempts */
+	named_close ( named, 0 );
+}
+
+/**
+ * Handle connection attempt failure
+ *
+ * @v attempt		Connection attempt
+ * @v rc		Reason for close
+ */
+static void named_attempt_close ( struct named_attempt *attempt, int rc ) {
+	struct named_socket *named = attempt->named;
+
+	DBGC ( named, "NAMED %p could not connect to %s: %s\n",
+	       named, sock_ntoa ( &attempt->peer ), strerror ( rc ) );
+
+	/* Shut down interface */
+	intf_shutdown ( &attempt->xfer, rc );
+	named->active--;
+	named->rc = rc;
+
+	/* Start next connection attempt immediately, if any */
+	stop_timer ( &named->timer );
+	named_next ( named );
+}
+
+/** Named socket connection attempt interface operations */
+static struct interface_operation named_attempt_ops[] = {
+	INTF_OP ( xfer_window_changed, struct named_attempt *,
+		  named_attempt_window_changed ),
+	INTF_OP ( intf_close, struct named_attempt *, named_attempt_close ),
+};
+
+/** Named socket connection attempt interface descriptor */
+static struct interface_descriptor named_attempt_desc =
+	INTF_DESC ( struct named_attempt, xfer, named_attempt_ops );
+
+/**
+ * Redirect to resolved address
  *
  * @v named		Named socket
  * @v sa		Completed socket address
  */
-static void named_resolv_done ( struct named_socket *named,
-				struct sockaddr *sa ) {
+static void named_redirect ( struct named_socket *named,
+			     struct sockaddr *sa ) {
 	int rc;
 
 	/* Nullify data transfer interface */
@@ -380,9 +556,71 @@ static void named_resolv_done ( struct named_socket *named,
 	named_close ( named, rc );
 }
 
+/**
+ * Name resolved
+ *
+ * @v named		Named socket
+ * @v sa		Completed socket address
+ */
+static void named_resolv_done ( struct named_socket *named,
+				struct sockaddr *sa ) {
+	struct named_attempt *attempt;
+	unsigned int i;
+
+	/* Connectionless sockets have nothing to race: use the
+	 * first address immediately.
+	 */
+	if ( named->semantics != SOCK_STREAM ) {
+		named_redirect ( named, sa );
+		return;
+	}
+
+	/* Use only the first address within each address family */
+	for ( i = 0 ; i < named->count ; i++ ) {
+		if ( named->attempts[i].peer.sa_family == sa->sa_family )
+			return;
+	}
+	if ( named->count >= NAMED_MAX_ATTEMPTS )
+		return;
+
+	/* Record address */
+	attempt = &named->attempts[ named->count++ ];
+	memcpy ( &attempt->peer, sa, sizeof ( attempt->peer ) );
+	DBGC ( named, "NAMED %p resolved to %s\n",
+	       named, sock_ntoa ( &attempt->peer ) );
+
+	/* Start connection attempt unless an earlier attempt is still
+	 * within its connection attempt delay.
+	 */
+	if ( ! timer_running ( &named->timer ) )
+		named_next ( named );
+}
+
+/**
+ * Name resolution finished
+ *
+ * @v named		Named socket
+ * @v rc		Reason for close
+ */
+static void named_resolv_close ( struct named_socket *named, int rc ) {
+
+	/* Shut down interface */
+	intf_shutdown ( &named->resolv, rc );
+	named->resolving = 0;
+
+	/* Fail immediately if no addresses were found */
+	if ( ! named->count ) {
+		named_close ( named, rc );
+		return;
+	}
+
+	/* Otherwise, continue with any connection attempts */
+	named_check ( named );
+}
+
 /** Named socket opener resolver interface operations */
 static struct interface_operation named_resolv_op[] = {
-	INTF_OP ( intf_close, struct named_socket *, named_close ),
+	INTF_OP ( intf_close, struct named_socket *, named_resolv_close ),
 	INTF_OP ( resolv_done, struct named_socket *, named_resolv_done ),
 };
 
@@ -404,6 +642,7 @@ int xfer_open_named_socket ( struct interface *xfer, int semantics,
 			     struct sockaddr *peer, const char *name,
 			     struct sockaddr *local ) {
 	struct named_socket *named;
+	unsigned int i;
 	int rc;
 
 	/* Allocate and initialise structure */
@@ -413,11 +652,19 @@ int xfer_open_named_socket ( struct interface *xfer, int semantics,
 	ref_init ( &named->refcnt, NULL );
 	intf_init ( &named->xfer, &named_xfer_desc, &named->refcnt );
 	intf_init ( &named->resolv, &named_resolv_desc, &named->refcnt );
+	for ( i = 0 ; i < NAMED_MAX_ATTEMPTS ; i++ ) {
+		named->attempts[i].named = named;
+		intf_init ( &named->attempts[i].xfer, &named_attempt_desc,
+			    &named->refcnt );
+	}
+	timer_init ( &named->timer, named_expired, &named->refcnt );
 	named->semantics = semantics;
 	if ( local ) {
 		memcpy ( &named->local, local, sizeof ( named->local ) );
 		named->have_local = 1;
 	}
+	named->resolving = 1;
+	named->rc = -ENOTCONN;
 
 	DBGC ( named, "NAMED %p opening \"%s\"\n",
 	       named, name );
@@ -77,12 +77,61 @@ FILE_SECBOOT ( PERMITTED );
  */
 #define SAN_REOPEN_DELAY_SECS 5
 
+/**
+ * Default read-ahead window (in kB)
+ *
+ * Bootloaders tend to read in very small chunks via INT 13 or
+ * EFI_BLOCK_IO, and so incur a full round trip to the SAN target for
+ * every few sectors.  Small reads are therefore expanded to fill an
+ * aligned read-ahead window, which is retained in the block cache.
+ */
+#define SAN_DEFAULT_READAHEAD 32
+
+/** Default block cache size (in kB) */
+#define SAN_DEFAULT_CACHE 256
+
+/**
+ * Default queue depth
+ *
+ * Operating system loaders tend to issue large reads during early
+ * boot, which are split into fragments of at most the underlying
+ * device's maximum transfer size.  Up to this many fragments may be
+ * in progress concurrently, striped across all available paths.
+ * Underlying devices that cannot handle concurrent commands will
+ * close their flow control window while a command is in progress.
+ */
+#define SAN_DEFAULT_DEPTH 4
+
+/**
+ * Default write-back buffer size (in kB)
+ *
+ * Write-back is disabled by default, since data held in the buffer
+ * will be lost if the operating system takes over the device (or
+ * the machine is reset) without first flushing it.
+ */
+#define SAN_DEFAULT_WRITEBACK 0
+
+/** Maximum age of buffered write data before it is written back */
+#define SAN_WRITEBACK_TIMEOUT ( 2 * TICKS_PER_SEC )
+
 /** List of SAN devices */
 LIST_HEAD ( san_devices );
 
 /** Number of times to retry commands */
 static unsigned long san_retries = SAN_DEFAULT_RETRIES;
 
+/** Read-ahead window (in kB) */
+static unsigned long san_readahead = SAN_DEFAULT_READAHEAD;
+
+/** Block cache size (in kB) */
+static unsigned long san_cache = SAN_DEFAULT_CACHE;
+
+/** Queue depth */
+static unsigned long san_depth = SAN_DEFAULT_DEPTH;
+
+/** Write-back buffer size (in kB) */
+static unsigned long san_writeback = SAN_DEFAULT_WRITEBACK;
+
 /**
  * Find SAN device by drive number
  *
@@ -128,10 +177,12 @@ static void sandev_free ( struct refcnt *refcnt ) {
 	assert ( ! timer_running ( &sandev->timer ) );
 	assert ( ! sandev->active );
 	assert ( list_empty ( &sandev->opened ) );
+	assert ( list_empty ( &sandev->requests ) );
 	for ( i = 0 ; i < sandev->paths ; i++ ) {
 		uri_put ( sandev->path[i].uri );
 		assert ( sandev->path[i].desc == NULL );
 	}
+	block_cache_free ( &sandev->cache );
 	free ( sandev );
 }
 
@@ -240,6 +291,7 @@ static int sanpath_open ( struct san_path *sanpath ) {
  */
 static void sanpath_close ( struct san_path *sanpath, int rc ) {
 	struct san_device *sandev = sanpath->sandev;
+	struct san_path *other;
 
 	/* Record status */
 	sanpath->path_rc = rc;
@@ -256,6 +308,16 @@ static void sanpath_close ( struct san_path *sanpath, int rc ) {
 		intfs_restart ( rc, &sandev->command, &sanpath->block, NULL );
 		sandev->active = NULL;
 		sandev_command_close ( sandev, rc );
+
+		/* Promote any other available path */
+		list_for_each_entry ( other, &sandev->opened, list ) {
+			if ( other->path_rc == 0 ) {
+				DBGC ( sandev->drive, "SAN %#02x.%d is active\n",
+				       sandev->drive, other->index );
+				sandev->active = other;
+				break;
+			}
+		}
 	} else {
 		intf_restart ( &sanpath->block, rc );
 	}
@@ -302,8 +364,10 @@ static size_t sanpath_block_window ( struct san_path *sanpath __unused ) {
 static void sanpath_step ( struct san_path *sanpath ) {
 	struct san_device *sandev = sanpath->sandev;
 
-	/* Ignore if we are already the active device */
-	if ( sanpath == sandev->active )
+	/* Ignore if we are already the active device or an
+	 * additional available path.
+	 */
+	if ( ( sanpath == sandev->active ) || ( sanpath->path_rc == 0 ) )
 		return;
 
 	/* Wait until path has become available */
@@ -313,11 +377,16 @@ static void sanpath_step ( struct san_path *sanpath ) {
 	/* Record status */
 	sanpath->path_rc = 0;
 
-	/* Mark as active path or close as applicable */
+	/* Mark as active path, retain as an additional path for
+	 * concurrent fragments, or close as applicable.
+	 */
 	if ( ! sandev->active ) {
 		DBGC ( sandev->drive, "SAN %#02x.%d is active\n",
 		       sandev->drive, sanpath->index );
 		sandev->active = sanpath;
+	} else if ( san_depth > 1 ) {
+		DBGC ( sandev->drive, "SAN %#02x.%d is available for "
+		       "striping\n", sandev->drive, sanpath->index );
 	} else {
 		DBGC ( sandev->drive, "SAN %#02x.%d is available\n",
 		       sandev->drive, sanpath->index );
@@ -578,6 +647,10 @@ int sandev_reset ( struct san_device *sandev ) {
 
 	DBGC ( sandev->drive, "SAN %#02x reset\n", sandev->drive );
 
+	/* Write back any buffered data */
+	if ( ( rc = sandev_flush ( sandev ) ) != 0 )
+		return rc;
+
 	/* Close and reopen underlying block device */
 	if ( ( rc = sandev_reopen ( sandev ) ) != 0 )
 		return rc;
@@ -585,12 +658,388 @@ int sandev_reset ( struct san_device *sandev ) {
 	return 0;
 }
 
+/**
+ * Close SAN device read/write fragment command
+ *
+ * @v frag		Read/write fragment
+ * @v rc		Reason for close
+ */
+static void sandev_fragment_close ( struct san_fragment *frag, int rc ) {
+
+	/* Restart interface */
+	intf_restart ( &frag->command, rc );
+
+	/* Record command status, and mark as unused if complete */
+	frag->sanpath = NULL;
+	frag->rc = rc;
+	if ( rc == 0 )
+		frag->count = 0;
+}
+
+/** SAN device read/write fragment command interface operations */
+static struct interface_operation sandev_fragment_op[] = {
+	INTF_OP ( intf_close, struct san_fragment *, sandev_fragment_close ),
+};
+
+/** SAN device read/write fragment command interface descriptor */
+static struct interface_descriptor sandev_fragment_desc =
+	INTF_DESC ( struct san_fragment, command, sandev_fragment_op );
+
+/**
+ * Count read/write fragments in progress
+ *
+ * @v sandev		SAN device
+ * @ret busy		Number of fragments in progress
+ */
+static unsigned int sandev_fragment_busy ( struct san_device *sandev ) {
+	unsigned int busy = 0;
+	unsigned int i;
+
+	for ( i = 0 ; i < SAN_MAX_DEPTH ; i++ ) {
+		if ( sandev->frag[i].sanpath )
+			busy++;
+	}
+	return busy;
+}
+
+/**
+ * Abort all read/write fragments in progress
+ *
+ * @v sandev		SAN device
+ * @v rc		Reason for abort
+ */
+static void sandev_fragment_abort ( struct san_device *sandev, int rc ) {
+	struct san_fragment *frag;
+	unsigned int i;
+
+	for ( i = 0 ; i < SAN_MAX_DEPTH ; i++ ) {
+		frag = &sandev->frag[i];
+		if ( frag->sanpath )
+			sandev_fragment_close ( frag, rc );
+	}
+}
+
+/**
+ * Choose SAN path for a read/write fragment
+ *
+ * @v sandev		SAN device
+ * @ret sanpath		SAN path, or NULL if no path can accept a command
+ *
+ * Fragments are striped across all available paths, choosing the
+ * least busy path.  A path that already has a command in progress is
+ * used only if its flow control window indicates that it is able to
+ * accept further commands.
+ */
+static struct san_path * sandev_stripe ( struct san_device *sandev ) {
+	struct san_path *sanpath;
+	struct san_path *best = NULL;
+	unsigned int best_busy = 0;
+	unsigned int busy;
+	unsigned int i;
+
+	list_for_each_entry ( sanpath, &sandev->opened, list ) {
+
+		/* Skip paths that are not yet available */
+		if ( sanpath->path_rc != 0 )
+			continue;
+
+		/* Count commands in progress on this path */
+		busy = 0;
+		for ( i = 0 ; i < SAN_MAX_DEPTH ; i++ ) {
+			if ( sandev->frag[i].sanpath == sanpath )
+				busy++;
+		}
+
+		/* Skip busy paths that cannot accept further commands */
+		if ( busy && ( ! xfer_window ( &sanpath->block ) ) )
+			continue;
+
+		/* Prefer the least busy path */
+		if ( ( ! best ) || ( busy < best_busy ) ) {
+			best = sanpath;
+			best_busy = busy;
+		}
+	}
+
+	return best;
+}
+
+/**
+ * Check whether or not a read/write request has fragments outstanding
+ *
+ * @v sandev		SAN device
+ * @v req		Read/write request
+ * @ret busy		Request has fragments outstanding
+ */
+static int sandev_request_busy ( struct san_device *sandev,
+				 struct san_request *req ) {
+	struct san_fragment *frag;
+	unsigned int i;
+
+	for ( i = 0 ; i < SAN_MAX_DEPTH ; i++ ) {
+		frag = &sandev->frag[i];
+		if ( ( frag->req == req ) && frag->count )
+			return 1;
+	}
+	return 0;
+}
+
+/**
+ * Complete read/write request
+ *
+ * @v sandev		SAN device
+ * @v req		Read/write request
+ * @v rc		Completion status code
+ */
+static void sandev_request_complete ( struct san_device *sandev,
+				      struct san_request *req, int rc ) {
+	struct san_fragment *frag;
+	unsigned int i;
+
+	/* Abort any fragments still in progress and release fragments */
+	for ( i = 0 ; i < SAN_MAX_DEPTH ; i++ ) {
+		frag = &sandev->frag[i];
+		if ( frag->req != req )
+			continue;
+		if ( frag->sanpath )
+			sandev_fragment_close ( frag, rc );
+		frag->count = 0;
+		frag->req = NULL;
+	}
+
+	/* Remove from list of outstanding requests */
+	list_del ( &req->list );
+	INIT_LIST_HEAD ( &req->list );
+
+	/* Record status and notify requester */
+	req->rc = rc;
+	if ( req->complete )
+		req->complete ( req, rc );
+}
+
+/**
+ * Queue read/write request
+ *
+ * @v sandev		SAN device
+ * @v req		Read/write request
+ * @v lba		Starting underlying block address
+ * @v count		Number of underlying blocks
+ * @v buffer		Data buffer
+ * @v block_rw		Block read/write method
+ */
+static void sandev_request ( struct san_device *sandev,
+			     struct san_request *req, uint64_t lba,
+			     unsigned int count, void *buffer,
+			     int ( * block_rw ) ( struct interface *control,
+						  struct interface *data,
+						  uint64_t lba,
+						  unsigned int count,
+						  void *buffer, size_t len ) ) {
+
+	req->lba = lba;
+	req->count = count;
+	req->buffer = buffer;
+	req->block_rw = block_rw;
+	req->rc = -EINPROGRESS;
+	list_add_tail ( &req->list, &sandev->requests );
+}
+
+/**
+ * Fail read/write request without queueing
+ *
+ * @v req		Read/write request
+ * @v rc		Completion status code
+ */
+static void sandev_request_fail ( struct san_request *req, int rc ) {
+
+	/* Record status and notify requester */
+	INIT_LIST_HEAD ( &req->list );
+	req->rc = rc;
+	if ( req->complete )
+		req->complete ( req, rc );
+}
+
+/**
+ * Progress outstanding read/write requests without blocking
+ *
+ * @v sandev		SAN device
+ *
+ * Fragments are allocated to requests in the order in which the
+ * requests were queued.
+ */
+static void sandev_progress ( struct san_device *sandev ) {
+	struct san_request *req;
+	struct san_request *tmp;
+	struct san_fragment *frag;
+	struct san_path *sanpath;
+	unsigned int i;
+	size_t len;
+	int rc;
+
+	/* Sanity check */
+	assert ( ! timer_running ( &sandev->timer ) );
+	assert ( san_depth <= SAN_MAX_DEPTH );
+
+	/* Initiate commands for unused and failed fragments */
+	for ( i = 0 ; i < SAN_MAX_DEPTH ; i++ ) {
+		frag = &sandev->frag[i];
+
+		/* Skip fragments already in progress */
+		if ( frag->sanpath )
+			continue;
+
+		/* Retry failed fragments, if permitted */
+		if ( frag->count && ( ( rc = frag->rc ) != 0 ) ) {
+			if ( frag->retries++ >= san_retries ) {
+				sandev_request_complete ( sandev, frag->req,
+							  rc );
+				continue;
+			}
+			frag->rc = 0;
+		}
+
+		/* Allocate next fragment, if any */
+		if ( ! frag->count ) {
+			if ( i >= san_depth )
+				continue;
+			req = NULL;
+			list_for_each_entry ( tmp, &sandev->requests, list ) {
+				if ( tmp->count ) {
+					req = tmp;
+					break;
+				}
+			}
+			if ( ! req )
+				continue;
+			frag->req = req;
+			frag->lba = req->lba;
+			frag->count = sandev->capacity.max_count;
+			if ( frag->count > req->count )
+				frag->count = req->count;
+			frag->buffer = req->buffer;
+			frag->retries = 0;
+			frag->rc = 0;
+			len = ( frag->count * sandev->capacity.blksize );
+			req->lba += frag->count;
+			req->buffer += len;
+			req->count -= frag->count;
+		}
+
+		/* Choose path */
+		sanpath = sandev_stripe ( sandev );
+		if ( ! sanpath )
+			break;
+
+		/* Initiate read/write command */
+		len = ( frag->count * sandev->capacity.blksize );
+		if ( ( rc = frag->req->block_rw ( &sanpath->block,
+						  &frag->command, frag->lba,
+						  frag->count, frag->buffer,
+						  len ) ) != 0 ) {
+			DBGC ( sandev->drive, "SAN %#02x.%d could not "
+			       "initiate read/write: %s\n", sandev->drive,
+			       sanpath->index, strerror ( rc ) );
+			/* Treat failure to initiate a concurrent
+			 * command as a transient flow control
+			 * limitation.
+			 */
+			if ( ! sandev_fragment_busy ( sandev ) )
+				frag->rc = rc;
+			break;
+		}
+		frag->sanpath = sanpath;
+		frag->started = currticks();
+	}
+
+	/* Time out any stuck commands */
+	for ( i = 0 ; i < SAN_MAX_DEPTH ; i++ ) {
+		frag = &sandev->frag[i];
+		if ( frag->sanpath &&
+		     ( ( currticks() - frag->started ) >
+		       SAN_COMMAND_TIMEOUT ) ) {
+			sandev_fragment_close ( frag, -ETIMEDOUT );
+		}
+	}
+
+	/* Complete any requests for which all fragments are complete */
+	list_for_each_entry_safe ( req, tmp, &sandev->requests, list ) {
+		if ( ( ! req->count ) && ( ! sandev_request_busy ( sandev,
+								   req ) ) ) {
+			sandev_request_complete ( sandev, req, 0 );
+		}
+	}
+}
+
+/**
+ * Read from or write to SAN device using concurrent fragments
+ *
+ * @v sandev		SAN device
+ * @v lba		Starting underlying block address
+ * @v count		Number of underlying blocks
+ * @v buffer		Data buffer
+ * @v block_rw		Block read/write method
+ * @ret rc		Return status code
+ */
+static int sandev_rw_concurrent ( struct san_device *sandev, uint64_t lba,
+				  unsigned int count, void *buffer,
+				  int ( * block_rw ) ( struct interface *control,
+						       struct interface *data,
+						       uint64_t lba,
+						       unsigned int count,
+						       void *buffer,
+						       size_t len ) ) {
+	struct san_request req;
+	unsigned int reopens = 0;
+	int rc;
+
+	/* Unquiesce system */
+	unquiesce();
+
+	/* Queue request */
+	req.complete = NULL;
+	sandev_request ( sandev, &req, lba, count, buffer, block_rw );
+
+	while ( 1 ) {
+
+		/* Reopen block device if applicable */
+		if ( sandev_needs_reopen ( sandev ) ) {
+			sandev_fragment_abort ( sandev, -ECONNRESET );
+			if ( ( rc = sandev_reopen ( sandev ) ) != 0 ) {
+
+				/* Delay reopening attempts */
+				sleep_fixed ( SAN_REOPEN_DELAY_SECS );
+
+				/* Retry opening indefinitely for
+				 * multipath devices.
+				 */
+				if ( ( sandev->paths <= 1 ) &&
+				     ( reopens++ >= san_retries ) ) {
+					sandev_request_complete ( sandev, &req,
+								  rc );
+					break;
+				}
+				continue;
+			}
+		}
+
+		/* Initiate, time out, and complete fragments */
+		sandev_progress ( sandev );
+		if ( req.rc != -EINPROGRESS )
+			break;
+
+		/* Allow commands to progress */
+		step();
+	}
+
+	return req.rc;
+}
+
 /**
  * Read from or write to SAN device
  *
  * @v sandev		SAN device
- * @v lba		Starting logical block address
- * @v count		Number of logical blocks
+ * @v lba		Starting underlying block address
+ * @v count		Number of underlying blocks
  * @v buffer		Data buffer
  * @v block_rw		Block read/write method
  * @ret rc		Return status code
@@ -606,12 +1055,21 @@ static int sandev_rw ( struct san_device *sandev, uint64_t lba,
 	size_t frag_len;
 	int rc;
 
+	/* Use concurrent fragments, if applicable.  Requests must also
+	 * be queued behind any outstanding asynchronous requests.
+	 */
+	if ( ( ( san_depth > 1 ) && ( count > sandev->capacity.max_count ) ) ||
+	     ( ! list_empty ( &sandev->requests ) ) ) {
+		return sandev_rw_concurrent ( sandev, lba, count, buffer,
+					      block_rw );
+	}
+
 	/* Initialise command parameters */
 	params.rw.block_rw = block_rw;
 	params.rw.buffer = buffer;
-	params.rw.lba = ( lba << sandev->blksize_shift );
+	params.rw.lba = lba;
 	params.rw.count = sandev->capacity.max_count;
-	remaining = ( count << sandev->blksize_shift );
+	remaining = count;
 
 	/* Read/write fragments */
 	while ( remaining ) {
@@ -635,6 +1093,88 @@ static int sandev_rw ( struct san_device *sandev, uint64_t lba,
 	return 0;
 }
 
+/**
+ * Read from SAN device block cache's underlying device
+ *
+ * @v cache		Block cache
+ * @v lba		Starting underlying block address
+ * @v count		Number of underlying blocks
+ * @v buffer		Data buffer
+ * @ret rc		Return status code
+ */
+static int sandev_cache_read ( struct block_cache *cache, uint64_t lba,
+			       unsigned int count, void *buffer ) {
+	struct san_device *sandev =
+		container_of ( cache, struct san_device, cache );
+
+	return sandev_rw ( sandev, lba, count, buffer, block_read );
+}
+
+/**
+ * Write to SAN device block cache's underlying device
+ *
+ * @v cache		Block cache
+ * @v lba		Starting underlying block address
+ * @v count		Number of underlying blocks
+ * @v buffer		Data buffer
+ * @ret rc		Return status code
+ */
+static int sandev_cache_write ( struct block_cache *cache, uint64_t lba,
+				unsigned int count, void *buffer ) {
+	struct san_device *sandev =
+		container_of ( cache, struct san_device, cache );
+
+	return sandev_rw ( sandev, lba, count, buffer, block_write );
+}
+
+/** SAN device block cache operations */
+static struct block_cache_operations sandev_cache_op = {
+	.read = sandev_cache_read,
+	.write = sandev_cache_write,
+};
+
+/**
+ * Write back any buffered data to SAN device
+ *
+ * @v sandev		SAN device
+ * @ret rc		Return status code
+ */
+int sandev_flush ( struct san_device *sandev ) {
+	int rc;
+
+	/* Do nothing unless there is buffered data */
+	if ( ! block_cache_is_dirty ( &sandev->cache ) )
+		return 0;
+
+	/* Write back buffered data */
+	DBGC2 ( sandev->drive, "SAN %#02x writing back %zd bytes\n",
+		sandev->drive, sandev->cache.dirty_len );
+	if ( ( rc = block_cache_flush ( &sandev->cache ) ) != 0 ) {
+		DBGC ( sandev->drive, "SAN %#02x could not write back: %s\n",
+		       sandev->drive, strerror ( rc ) );
+		return rc;
+	}
+
+	return 0;
+}
+
+/**
+ * Write back buffered data to SAN device, if it has become too old
+ *
+ * @v sandev		SAN device
+ * @ret rc		Return status code
+ */
+static int sandev_flush_expired ( struct san_device *sandev ) {
+	unsigned long age = ( currticks() - sandev->cache.dirtied );
+
+	/* Do nothing unless buffered data has expired */
+	if ( ( ! block_cache_is_dirty ( &sandev->cache ) ) ||
+	     ( age < SAN_WRITEBACK_TIMEOUT ) )
+		return 0;
+
+	return sandev_flush ( sandev );
+}
+
 /**
  * Read from SAN device
  *
@@ -648,9 +1188,15 @@ int sandev_read ( struct san_device *sandev, uint64_t lba,
 		  unsigned int count, void *buffer ) {
 	int rc;
 
-	/* Read from device */
-	if ( ( rc = sandev_rw ( sandev, lba, count, buffer,
-				block_read ) ) != 0 )
+	/* Write back any expired buffered data */
+	if ( ( rc = sandev_flush_expired ( sandev ) ) != 0 )
+		return rc;
+
+	/* Read from device via block cache */
+	if ( ( rc = block_cache_read ( &sandev->cache,
+				       ( lba << sandev->blksize_shift ),
+				       ( count << sandev->blksize_shift ),
+				       buffer ) ) != 0 )
 		return rc;
 
 	return 0;
@@ -669,9 +1215,15 @@ int sandev_write ( struct san_device *sandev, uint64_t lba,
 		   unsigned int count, void *buffer ) {
 	int rc;
 
-	/* Write to device */
-	if ( ( rc = sandev_rw ( sandev, lba, count, buffer,
-				block_write ) ) != 0 )
+	/* Write back any expired buffered data */
+	if ( ( rc = sandev_flush_expired ( sandev ) ) != 0 )
+		return rc;
+
+	/* Write to device via block cache (which may buffer the data) */
+	if ( ( rc = block_cache_write ( &sandev->cache,
+					( lba << sandev->blksize_shift ),
+					( count << sandev->blksize_shift ),
+					buffer ) ) != 0 )
 		return rc;
 
 	/* Quiesce system.  This is a heuristic designed to ensure
@@ -685,6 +1237,127 @@ int sandev_write ( struct san_device *sandev, uint64_t lba,
 	return 0;
 }
 
+/**
+ * Read from SAN device asynchronously
+ *
+ * @v sandev		SAN device
+ * @v req		Read/write request
+ * @v lba		Starting logical block address
+ * @v count		Number of logical blocks
+ * @v buffer		Data buffer
+ *
+ * The request's completion handler will be called once the read has
+ * completed, which may happen before this function returns.  The
+ * caller must call sandev_poll() and step() periodically until then.
+ * Asynchronous reads bypass the block cache, and so any buffered
+ * write data is first written back.
+ */
+void sandev_read_async ( struct san_device *sandev, struct san_request *req,
+			 uint64_t lba, unsigned int count, void *buffer ) {
+	int rc;
+
+	/* Write back any buffered data */
+	if ( ( rc = sandev_flush ( sandev ) ) != 0 ) {
+		sandev_request_fail ( req, rc );
+		return;
+	}
+
+	/* Unquiesce system */
+	unquiesce();
+
+	/* Queue and start request */
+	sandev_request ( sandev, req, ( lba << sandev->blksize_shift ),
+			 ( count << sandev->blksize_shift ), buffer,
+			 block_read );
+	sandev_poll ( sandev );
+}
+
+/**
+ * Write to SAN device asynchronously
+ *
+ * @v sandev		SAN device
+ * @v req		Read/write request
+ * @v lba		Starting logical block address
+ * @v count		Number of logical blocks
+ * @v buffer		Data buffer
+ *
+ * The request's completion handler will be called once the write has
+ * completed, which may happen before this function returns.  The
+ * caller must call sandev_poll() and step() periodically until then.
+ * Unlike sandev_write(), the system is not quiesced on completion,
+ * since further asynchronous requests may still be in progress.
+ * Asynchronous writes are never buffered, and so any previously
+ * buffered write data is first written back.
+ */
+void sandev_write_async ( struct san_device *sandev, struct san_request *req,
+			  uint64_t lba, unsigned int count, void *buffer ) {
+	int rc;
+
+	/* Write back any buffered data */
+	if ( ( rc = sandev_flush ( sandev ) ) != 0 ) {
+		sandev_request_fail ( req, rc );
+		return;
+	}
+
+	/* Discard any stale cached data */
+	lba <<= sandev->blksize_shift;
+	count <<= sandev->blksize_shift;
+	block_cache_invalidate ( &sandev->cache, lba, count );
+
+	/* Unquiesce system */
+	unquiesce();
+
+	/* Queue and start request */
+	sandev_request ( sandev, req, lba, count, buffer, block_write );
+	sandev_poll ( sandev );
+}
+
+/**
+ * Progress asynchronous SAN device requests
+ *
+ * @v sandev		SAN device
+ *
+ * This function does not itself call step(), and will block only if
+ * the underlying device needs to be reopened.
+ */
+void sandev_poll ( struct san_device *sandev ) {
+	int rc;
+
+	/* Do nothing unless requests are outstanding */
+	if ( list_empty ( &sandev->requests ) )
+		return;
+
+	/* Reopen block device if applicable.  Failures are reported
+	 * immediately rather than being retried after a delay, since
+	 * this may be called from an asynchronous context.
+	 */
+	if ( sandev_needs_reopen ( sandev ) ) {
+		sandev_fragment_abort ( sandev, -ECONNRESET );
+		if ( ( rc = sandev_reopen ( sandev ) ) != 0 ) {
+			sandev_cancel ( sandev, rc );
+			return;
+		}
+	}
+
+	/* Initiate, time out, and complete fragments */
+	sandev_progress ( sandev );
+}
+
+/**
+ * Cancel all outstanding SAN device requests
+ *
+ * @v sandev		SAN device
+ * @v rc		Reason for cancellation
+ */
+void sandev_cancel ( struct san_device *sandev, int rc ) {
+	struct san_request *req;
+
+	while ( ( req = list_first_entry ( &sandev->requests,
+					   struct san_request, list ) ) ) {
+		sandev_request_complete ( sandev, req, rc );
+	}
+}
+
 /**
  * Describe SAN device
  *
@@ -849,10 +1522,17 @@ struct san_device * alloc_sandev ( struct uri **uris, unsigned int count,
 	ref_init ( &sandev->refcnt, sandev_free );
 	intf_init ( &sandev->command, &sandev_command_desc, &sandev->refcnt );
 	timer_init ( &sandev->timer, sandev_command_expired, &sandev->refcnt );
+	block_cache_init ( &sandev->cache, &sandev_cache_op );
 	sandev->priv = ( ( ( void * ) sandev ) + size );
 	sandev->paths = count;
 	INIT_LIST_HEAD ( &sandev->opened );
 	INIT_LIST_HEAD ( &sandev->closed );
+	INIT_LIST_HEAD ( &sandev->requests );
+	for ( i = 0 ; i < SAN_MAX_DEPTH ; i++ ) {
+		sandev->frag[i].sandev = sandev;
+		intf_init ( &sandev->frag[i].command, &sandev_fragment_desc,
+			    &sandev->refcnt );
+	}
 	for ( i = 0 ; i < count ; i++ ) {
 		sanpath = &sandev->path[i];
 		sanpath->sandev = sandev;
@@ -869,6 +1549,41 @@ struct san_device * alloc_sandev ( struct uri **uris, unsigned int count,
 	return sandev;
 }
 
+/**
+ * Allocate SAN device block cache
+ *
+ * @v sandev		SAN device
+ *
+ * Failure to allocate the block cache is not an error; the device
+ * will simply be accessed without caching.
+ */
+static void sandev_cache ( struct san_device *sandev ) {
+	size_t blksize = sandev->capacity.blksize;
+	unsigned int blocks;
+	unsigned int count;
+	int rc;
+
+	/* Calculate cache geometry */
+	blocks = ( blksize ? ( ( san_readahead * 1024 ) / blksize ) : 0 );
+	count = ( san_readahead ? ( san_cache / san_readahead ) : 0 );
+
+	/* Configure write-back buffer */
+	sandev->cache.dirty_max = ( san_writeback * 1024 );
+
+	/* Allocate cache */
+	if ( ( rc = block_cache_alloc ( &sandev->cache, blksize,
+					sandev->capacity.blocks, blocks,
+					count ) ) != 0 ) {
+		DBGC ( sandev->drive, "SAN %#02x could not allocate block "
+		       "cache: %s\n", sandev->drive, strerror ( rc ) );
+		return;
+	}
+	if ( sandev->cache.blocks ) {
+		DBGC ( sandev->drive, "SAN %#02x caching %d lines of %d "
+		       "blocks\n", sandev->drive, count, blocks );
+	}
+}
+
 /**
  * Register SAN device
  *
@@ -909,6 +1624,9 @@ int register_sandev ( struct san_device *sandev, unsigned int drive,
 				     NULL ) ) != 0 )
 		goto err_capacity;
 
+	/* Allocate block cache */
+	sandev_cache ( sandev );
+
 	/* Configure as a CD-ROM, if applicable */
 	if ( ( rc = sandev_parse_iso9660 ( sandev ) ) != 0 )
 		goto err_iso9660;
@@ -944,16 +1662,26 @@ void unregister_sandev ( struct san_device *sandev ) {
 	/* Sanity check */
 	assert ( ! timer_running ( &sandev->timer ) );
 
+	/* Write back any buffered data (ignoring errors, since the
+	 * device is going away regardless).
+	 */
+	sandev_flush ( sandev );
+
 	/* Remove from list of SAN devices */
 	list_del ( &sandev->list );
 
+	/* Fail any outstanding asynchronous requests */
+	sandev_cancel ( sandev, -ENODEV );
+
 	/* Shut down interfaces */
 	sandev_restart ( sandev, 0 );
 
 	/* Remove ACPI descriptors */
 	sandev_undescribe ( sandev );
 
-	DBGC ( sandev->drive, "SAN %#02x unregistered\n", sandev->drive );
+	DBGC ( sandev->drive, "SAN %#02x unregistered (cache %ld hits, %ld "
+	       "misses)\n", sandev->drive, sandev->cache.hits,
+	       sandev->cache.misses );
 }
 
 /** The "san-drive" setting */
@@ -990,6 +1718,38 @@ const struct setting san_retries_setting __setting ( SETTING_SANBOOT_EXTRA,
 	.type = &setting_type_int8,
 };
 
+/** The "san-readahead" setting */
+const struct setting san_readahead_setting __setting ( SETTING_SANBOOT_EXTRA,
+						       san-readahead ) = {
+	.name = "san-readahead",
+	.description = "SAN read-ahead window (kB)",
+	.type = &setting_type_uint16,
+};
+
+/** The "san-depth" setting */
+const struct setting san_depth_setting __setting ( SETTING_SANBOOT_EXTRA,
+						   san-depth ) = {
+	.name = "san-depth",
+	.description = "SAN queue depth",
+	.type = &setting_type_uint8,
+};
+
+/** The "san-cache" setting */
+const struct setting san_cache_setting __setting ( SETTING_SANBOOT_EXTRA,
+						   san-cache ) = {
+	.name = "san-cache",
+	.description = "SAN block cache size (kB)",
+	.type = &setting_type_uint16,
+};
+
+/** The "san-writeback" setting */
+const struct setting san_writeback_setting __setting ( SETTING_SANBOOT_EXTRA,
+						       san-writeback ) = {
+	.name = "san-writeback",
+	.description = "SAN write-back buffer size (kB)",
+	.type = &setting_type_uint16,
+};
+
 /**
  * Apply SAN boot settings
  *
@@ -1003,6 +1763,32 @@ static int sandev_apply ( void ) {
 		san_retries = SAN_DEFAULT_RETRIES;
 	}
 
+	/* Apply "san-readahead" and "san-cache" settings */
+	if ( fetch_uint_setting ( NULL, &san_readahead_setting,
+				  &san_readahead ) < 0 ) {
+		san_readahead = SAN_DEFAULT_READAHEAD;
+	}
+	if ( fetch_uint_setting ( NULL, &san_cache_setting,
+				  &san_cache ) < 0 ) {
+		san_cache = SAN_DEFAULT_CACHE;
+	}
+
+	/* Apply "san-depth" setting */
+	if ( fetch_uint_setting ( NULL, &san_depth_setting,
+				  &san_depth ) < 0 ) {
+		san_depth = SAN_DEFAULT_DEPTH;
+	}
+	if ( ! san_depth )
+		san_depth = 1;
+	if ( san_depth > SAN_MAX_DEPTH )
+		san_depth = SAN_MAX_DEPTH;
+
+	/* Apply "san-writeback" setting */
+	if ( fetch_uint_setting ( NULL, &san_writeback_setting,
+				  &san_writeback ) < 0 ) {
+		san_writeback = SAN_DEFAULT_WRITEBACK;
+	}
+
 	return 0;
 }
 
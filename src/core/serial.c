@@ -32,6 +32,7 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 #include <stddef.h>
 #include <string.h>
 #include <ipxe/init.h>
+#include <ipxe/process.h>
 #include <ipxe/uart.h>
 #include <ipxe/console.h>
 #include <ipxe/serial.h>
@@ -61,6 +62,11 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 #define COMSPEED 0
 #endif
 
+/* Serial console transmit buffer size */
+#ifndef COMTXBUF
+#define COMTXBUF 0
+#endif
+
 /** Active serial console UART
  *
  * Explicitly initialised to @c NULL since this variable may be
@@ -84,10 +90,40 @@ struct uart * fixed_serial_console ( void ) {
 	return uart;
 }
 
+/** Serial console transmit buffer */
+static uint8_t serial_tx[COMTXBUF];
+
+/** Serial console transmit buffer producer index */
+static unsigned int serial_tx_prod;
+
+/** Serial console transmit buffer consumer index */
+static unsigned int serial_tx_cons;
+
+/**
+ * Transmit buffered characters
+ *
+ * @v block		Block until all characters are transmitted
+ */
+static void serial_drain ( int block ) {
+	uint8_t data;
+
+	while ( serial_tx_cons != serial_tx_prod ) {
+		if ( ! ( block || uart_transmit_ready ( serial_console ) ) )
+			break;
+		data = serial_tx[ serial_tx_cons++ & ( COMTXBUF - 1 ) ];
+		uart_transmit ( serial_console, data );
+	}
+}
+
 /**
  * Print a character to serial console
  *
  * @v character		Character to be printed
+ *
+ * If a transmit buffer is configured, then the character will be
+ * buffered rather than waiting for the UART to become ready.  If
+ * the buffer is full, the oldest buffered character will be
+ * transmitted (waiting for the UART if necessary) to make space.
  */
 static void serial_putchar ( int character ) {
 
@@ -95,8 +131,41 @@ static void serial_putchar ( int character ) {
 	if ( ! serial_console )
 		return;
 
-	/* Transmit character */
-	uart_transmit ( serial_console, character );
+	/* Transmit character directly if we have no transmit buffer */
+	if ( ! COMTXBUF ) {
+		uart_transmit ( serial_console, character );
+		return;
+	}
+
+	/* Transmit any buffered characters, if possible */
+	serial_drain ( 0 );
+
+	/* Transmit character immediately, if possible */
+	if ( ( serial_tx_cons == serial_tx_prod ) &&
+	     uart_transmit_ready ( serial_console ) ) {
+		uart_transmit ( serial_console, character );
+		return;
+	}
+
+	/* Make space in transmit buffer, if necessary */
+	if ( ( serial_tx_prod - serial_tx_cons ) >= COMTXBUF ) {
+		uart_transmit ( serial_console,
+				serial_tx[ serial_tx_cons++ &
+					   ( COMTXBUF - 1 ) ] );
+	}
+
+	/* Add character to transmit buffer */
+	serial_tx[ serial_tx_prod++ & ( COMTXBUF - 1 ) ] = character;
+}
+
+/**
+ * Check for pending output on serial console
+ *
+ * @ret is_pending	Output is pending
+ */
+static int serial_pending ( void ) {
+
+	return ( serial_tx_cons != serial_tx_prod );
 }
 
 /**
@@ -146,9 +215,32 @@ struct console_driver serial_console_driver __console_driver = {
 	.putchar = serial_putchar,
 	.getchar = serial_getchar,
 	.iskey = serial_iskey,
+	.pending = serial_pending,
 	.usage = CONSOLE_SERIAL,
 };
 
+/**
+ * Serial console transmit process
+ *
+ * @v process		Process
+ */
+static void serial_step ( struct process *process __unused ) {
+
+	/* Do nothing unless we have buffered characters */
+	if ( ! serial_pending() )
+		return;
+
+	/* Transmit buffered characters, if possible */
+	serial_drain ( 0 );
+
+	/* Avoid sleeping while characters remain to be transmitted */
+	if ( serial_pending() )
+		process_active();
+}
+
+/** Serial console transmit process */
+PERMANENT_PROCESS ( serial_process, serial_step );
+
 /** Initialise serial console */
 static void serial_init ( void ) {
 	struct uart *uart;
@@ -183,6 +275,7 @@ static void serial_shutdown ( int flags __unused ) {
 		return;
 
 	/* Flush any pending output */
+	serial_drain ( 1 );
 	uart_flush ( serial_console );
 
 	/* Leave console enabled; it's still usable */
@@ -67,6 +67,10 @@ FILE_SECBOOT ( PERMITTED );
 struct generic_setting {
 	/** List of generic settings */
 	struct list_head list;
+	/** Next generic setting in name hash bucket */
+	struct generic_setting *name_next;
+	/** Next generic setting in tag hash bucket */
+	struct generic_setting *tag_next;
 	/** Setting */
 	struct setting setting;
 	/** Size of setting name */
@@ -96,25 +100,129 @@ static inline void * generic_setting_data ( struct generic_setting *generic ) {
 		 generic->name_len );
 }
 
+/**
+ * Calculate generic setting name hash bucket
+ *
+ * @v name		Setting name
+ * @ret bucket		Hash bucket index
+ */
+static unsigned int generic_setting_name_hash ( const char *name ) {
+	unsigned int hash = 0;
+
+	while ( *name )
+		hash = ( ( hash * 31 ) + *(name++) );
+	return ( hash % GENERIC_SETTINGS_HASH_SIZE );
+}
+
+/**
+ * Calculate generic setting tag hash bucket
+ *
+ * @v tag		Setting tag
+ * @ret bucket		Hash bucket index
+ */
+static unsigned int generic_setting_tag_hash ( uint64_t tag ) {
+
+	/* Fold in any encapsulating option numbers */
+	tag ^= ( tag >> 32 );
+	tag ^= ( tag >> 16 );
+	tag ^= ( tag >> 8 );
+	return ( tag % GENERIC_SETTINGS_HASH_SIZE );
+}
+
 /**
  * Find generic setting
  *
  * @v generics		Generic settings block
  * @v setting		Setting to find
  * @ret generic		Generic setting, or NULL
+ *
+ * A generic setting may match either by tag or by name (see
+ * setting_cmp()), and so we must check the relevant bucket in each
+ * hash table.
  */
 static struct generic_setting *
 find_generic_setting ( struct generic_settings *generics,
 		       const struct setting *setting ) {
 	struct generic_setting *generic;
+	unsigned int bucket;
+
+	/* Check for a match by tag */
+	if ( setting->tag ) {
+		bucket = generic_setting_tag_hash ( setting->tag );
+		for ( generic = generics->by_tag[bucket] ; generic ;
+		      generic = generic->tag_next ) {
+			if ( setting_cmp ( &generic->setting, setting ) == 0 )
+				return generic;
+		}
+	}
 
-	list_for_each_entry ( generic, &generics->list, list ) {
-		if ( setting_cmp ( &generic->setting, setting ) == 0 )
-			return generic;
+	/* Check for a match by name */
+	if ( setting->name ) {
+		bucket = generic_setting_name_hash ( setting->name );
+		for ( generic = generics->by_name[bucket] ; generic ;
+		      generic = generic->name_next ) {
+			if ( setting_cmp ( &generic->setting, setting ) == 0 )
+				return generic;
+		}
 	}
+
 	return NULL;
 }
 
+/**
+ * Add generic setting to hash tables
+ *
+ * @v generics		Generic settings block
+ * @v generic		Generic setting
+ */
+static void generic_setting_hash ( struct generic_settings *generics,
+				   struct generic_setting *generic ) {
+	struct generic_setting **head;
+
+	/* Add to name hash table */
+	head = &generics->by_name[ generic_setting_name_hash (
+					generic->setting.name ) ];
+	generic->name_next = *head;
+	*head = generic;
+
+	/* Add to tag hash table, if applicable */
+	if ( generic->setting.tag ) {
+		head = &generics->by_tag[ generic_setting_tag_hash (
+					       generic->setting.tag ) ];
+		generic->tag_next = *head;
+		*head = generic;
+	}
+}
+
+/**
+ * Remove generic setting from hash tables
+ *
+ * @v generics		Generic settings block
+ * @v generic		Generic setting
+ */
+static void generic_setting_unhash ( struct generic_settings *generics,
+				     struct generic_setting *generic ) {
+	struct generic_setting **prev;
+
+	/* Remove from name hash table */
+	for ( prev = &generics->by_name[ generic_setting_name_hash (
+					      generic->setting.name ) ] ;
+	      *prev != generic ; prev = &(*prev)->name_next ) {
+		assert ( *prev != NULL );
+	}
+	*prev = generic->name_next;
+
+	/* Remove from tag hash table, if applicable */
+	if ( generic->setting.tag ) {
+		for ( prev = &generics->by_tag[ generic_setting_tag_hash (
+						     generic->setting.tag ) ] ;
+		      *prev != generic ; prev = &(*prev)->tag_next ) {
+			assert ( *prev != NULL );
+		}
+		*prev = generic->tag_next;
+	}
+}
+
 /**
  * Store value of generic setting
  *
@@ -156,13 +264,16 @@ int generic_settings_store ( struct settings *settings,
 
 	/* Delete existing generic setting, if any */
 	if ( old ) {
+		generic_setting_unhash ( generics, old );
 		list_del ( &old->list );
 		free ( old );
 	}
 
 	/* Add new setting to list, if any */
-	if ( new )
+	if ( new ) {
 		list_add ( &new->list, &generics->list );
+		generic_setting_hash ( generics, new );
+	}
 
 	return 0;
 }
@@ -216,6 +327,8 @@ void generic_settings_clear ( struct settings *settings ) {
 		free ( generic );
 	}
 	assert ( list_empty ( &generics->list ) );
+	memset ( generics->by_name, 0, sizeof ( generics->by_name ) );
+	memset ( generics->by_tag, 0, sizeof ( generics->by_tag ) );
 }
 
 /** Generic settings operations */
@@ -0,0 +1,296 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+FILE_SECBOOT ( PERMITTED );
+
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+#include <ipxe/malloc.h>
+#include <ipxe/slab.h>
+
+/** @file
+ *
+ * Slab allocator
+ *
+ */
+
+/** Minimum slab size */
+#define SLAB_MIN_SIZE 4096
+
+/** Minimum number of objects per slab */
+#define SLAB_MIN_OBJECTS 4
+
+/** Object alignment within a slab */
+#define SLAB_ALIGN ( 2 * sizeof ( void * ) )
+
+/** A slab */
+struct slab {
+	/** List of slabs within the cache */
+	struct list_head list;
+	/** Free object list */
+	void *free;
+	/** Number of objects in use */
+	unsigned int used;
+	/** Number of objects */
+	unsigned int count;
+};
+
+/** Offset of first object within a slab */
+#define SLAB_OFFSET \
+	( ( sizeof ( struct slab ) + SLAB_ALIGN - 1 ) & ~( SLAB_ALIGN - 1 ) )
+
+/** List of slab caches */
+struct list_head slab_caches = LIST_HEAD_INIT ( slab_caches );
+
+/**
+ * Initialise a slab cache
+ *
+ * @v cache		Slab cache
+ * @v name		Name
+ * @v size		Object size
+ */
+void slab_create ( struct slab_cache *cache, const char *name, size_t size ) {
+
+	memset ( cache, 0, sizeof ( *cache ) );
+	cache->name = name;
+	cache->size = size;
+	INIT_LIST_HEAD ( &cache->partial );
+	INIT_LIST_HEAD ( &cache->full );
+	INIT_LIST_HEAD ( &cache->list );
+}
+
+/**
+ * Calculate slab cache geometry
+ *
+ * @v cache		Slab cache
+ */
+static void slab_geometry ( struct slab_cache *cache ) {
+	size_t stride;
+	size_t slab_size;
+
+	/* Calculate object stride, allowing room for the free list
+	 * pointer within each free object.
+	 */
+	stride = cache->size;
+	if ( stride < sizeof ( void * ) )
+		stride = sizeof ( void * );
+	stride = ( ( stride + SLAB_ALIGN - 1 ) & ~( SLAB_ALIGN - 1 ) );
+
+	/* Use the smallest power-of-two slab size that can hold a
+	 * reasonable number of objects.
+	 */
+	slab_size = SLAB_MIN_SIZE;
+	while ( ( ( slab_size - SLAB_OFFSET ) / stride ) < SLAB_MIN_OBJECTS )
+		slab_size <<= 1;
+
+	cache->stride = stride;
+	cache->slab_size = slab_size;
+	DBGC ( cache, "SLAB %s using %zd-byte slabs of %zd %zd-byte "
+	       "objects\n", cache->name, slab_size,
+	       ( ( slab_size - SLAB_OFFSET ) / stride ), stride );
+}
+
+/**
+ * Allocate a new slab
+ *
+ * @v cache		Slab cache
+ * @ret slab		Slab, or NULL on allocation failure
+ */
+static struct slab * slab_grow ( struct slab_cache *cache ) {
+	struct slab *slab;
+	void *obj;
+	unsigned int i;
+
+	/* Calculate geometry and register cache, if not already done */
+	if ( ! cache->stride ) {
+		slab_geometry ( cache );
+		list_add_tail ( &cache->list, &slab_caches );
+	}
+
+	/* Allocate slab, aligned to its own size so that the slab
+	 * containing any object can be found by masking the address.
+	 */
+	slab = malloc_phys ( cache->slab_size, cache->slab_size );
+	if ( ! slab )
+		return NULL;
+	slab->used = 0;
+	slab->count = ( ( cache->slab_size - SLAB_OFFSET ) / cache->stride );
+
+	/* Construct free object list */
+	slab->free = NULL;
+	for ( i = slab->count ; i-- ; ) {
+		obj = ( ( ( void * ) slab ) + SLAB_OFFSET +
+			( i * cache->stride ) );
+		*( ( void ** ) obj ) = slab->free;
+		slab->free = obj;
+	}
+
+	/* Add to list of partial slabs */
+	list_add ( &slab->list, &cache->partial );
+	cache->slabs++;
+	cache->empty++;
+	DBGC2 ( cache, "SLAB %s added slab %p (%d slabs)\n",
+		cache->name, slab, cache->slabs );
+
+	return slab;
+}
+
+/**
+ * Free an empty slab
+ *
+ * @v cache		Slab cache
+ * @v slab		Slab
+ */
+static void slab_shrink ( struct slab_cache *cache, struct slab *slab ) {
+
+	/* Sanity check */
+	assert ( slab->used == 0 );
+
+	/* Remove from cache and free */
+	list_del ( &slab->list );
+	cache->slabs--;
+	cache->empty--;
+	DBGC2 ( cache, "SLAB %s removed slab %p (%d slabs)\n",
+		cache->name, slab, cache->slabs );
+	free_phys ( slab, cache->slab_size );
+}
+
+/**
+ * Allocate an object from a slab cache
+ *
+ * @v cache		Slab cache
+ * @ret ptr		Zeroed object, or NULL on allocation failure
+ *
+ * Objects allocated with slab_alloc() must be freed using
+ * slab_free(); they cannot be freed with the standard free().
+ */
+void * slab_alloc ( struct slab_cache *cache ) {
+	struct slab *slab;
+	void *obj;
+
+	/* Use first slab with a free object, or allocate a new slab */
+	slab = list_first_entry ( &cache->partial, struct slab, list );
+	if ( ! slab ) {
+		slab = slab_grow ( cache );
+		if ( ! slab )
+			return NULL;
+	}
+
+	/* Remove object from slab's free list */
+	obj = slab->free;
+	assert ( obj != NULL );
+	slab->free = *( ( void ** ) obj );
+	if ( slab->used++ == 0 )
+		cache->empty--;
+
+	/* Move slab to list of full slabs, if applicable */
+	if ( ! slab->free ) {
+		list_del ( &slab->list );
+		list_add ( &slab->list, &cache->full );
+	}
+
+	/* Update statistics */
+	if ( ++cache->used > cache->maxused )
+		cache->maxused = cache->used;
+
+	/* Zero object */
+	memset ( obj, 0, cache->size );
+	return obj;
+}
+
+/**
+ * Free an object to a slab cache
+ *
+ * @v cache		Slab cache
+ * @v ptr		Object allocated by slab_alloc(), or NULL
+ *
+ * If @c ptr is NULL, no action is taken.
+ */
+void slab_free ( struct slab_cache *cache, void *ptr ) {
+	struct slab *slab;
+
+	/* Do nothing if pointer is NULL */
+	if ( ! ptr )
+		return;
+
+	/* Identify slab */
+	slab = ( ( void * ) ( ( ( intptr_t ) ptr ) &
+			      ~( ( intptr_t ) ( cache->slab_size - 1 ) ) ) );
+	assert ( slab->used > 0 );
+	assert ( ( ( ptr - ( ( void * ) slab ) - SLAB_OFFSET ) %
+		   cache->stride ) == 0 );
+
+	/* Add object to slab's free list, moving a previously full
+	 * slab to the head of the list of partial slabs.
+	 */
+	if ( ! slab->free ) {
+		list_del ( &slab->list );
+		list_add ( &slab->list, &cache->partial );
+	}
+	*( ( void ** ) ptr ) = slab->free;
+	slab->free = ptr;
+	cache->used--;
+
+	/* Move newly empty slab to the tail of the list of partial
+	 * slabs, freeing it immediately if there is already an empty
+	 * slab available for reuse.
+	 */
+	if ( --slab->used == 0 ) {
+		cache->empty++;
+		if ( cache->empty > 1 ) {
+			slab_shrink ( cache, slab );
+		} else {
+			list_del ( &slab->list );
+			list_add_tail ( &slab->list, &cache->partial );
+		}
+	}
+}
+
+/**
+ * Discard some cached data
+ *
+ * @ret discarded	Number of cached items discarded
+ */
+static unsigned int slab_discard ( void ) {
+	struct slab_cache *cache;
+	struct slab *slab;
+
+	/* Free the first empty slab found in any cache */
+	list_for_each_entry ( cache, &slab_caches, list ) {
+		if ( ! cache->empty )
+			continue;
+		slab = list_last_entry ( &cache->partial, struct slab, list );
+		assert ( slab != NULL );
+		slab_shrink ( cache, slab );
+		return 1;
+	}
+
+	return 0;
+}
+
+/** Slab cache discarder */
+struct cache_discarder slab_discarder __cache_discarder ( CACHE_CHEAP ) = {
+	.discard = slab_discard,
+};
@@ -107,7 +107,8 @@ static unsigned int sleep_interruptible ( unsigned int secs,
 			step();
 			if ( interrupted && interrupted() )
 				return secs;
-			cpu_nap();
+			if ( ! process_runnable() )
+				cpu_nap();
 		}
 		start = now;
 	}
@@ -0,0 +1,88 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+FILE_SECBOOT ( PERMITTED );
+
+/** @file
+ *
+ * Boot-time event tracing
+ *
+ * Significant events (such as DHCP state changes, connection
+ * establishment, and image execution) are recorded into a small ring
+ * buffer, which may be inspected later to find out where the time
+ * taken to boot was spent.  Recording an event costs only a handful
+ * of stores, and so tracing is always enabled.
+ */
+
+#include <stddef.h>
+#include <ipxe/profile.h>
+#include <ipxe/timer.h>
+#include <ipxe/trace.h>
+
+/** Trace event ring buffer */
+static struct trace_event trace_events[TRACE_EVENTS];
+
+/** Total number of trace events recorded */
+unsigned int trace_count;
+
+/**
+ * Record trace event
+ *
+ * @v subsystem		Subsystem name
+ * @v name		Event name
+ * @v object		Associated object, or NULL
+ * @v value		Event-specific value
+ *
+ * The subsystem and event names must be static strings, since only
+ * the pointers are recorded.
+ */
+void trace ( const char *subsystem, const char *name, const void *object,
+	     long value ) {
+	struct trace_event *event;
+
+	/* Record event, overwriting the oldest event if necessary */
+	event = &trace_events[ trace_count++ % TRACE_EVENTS ];
+	event->timestamp = profile_timestamp();
+	event->ticks = currticks();
+	event->subsystem = subsystem;
+	event->name = name;
+	event->object = object;
+	event->value = value;
+}
+
+/**
+ * Get recorded trace event
+ *
+ * @v index		Event index (counting from the first event ever)
+ * @ret event		Trace event, or NULL if no longer available
+ */
+struct trace_event * trace_event ( unsigned int index ) {
+
+	/* Check that event has been recorded and not yet overwritten */
+	if ( ( index >= trace_count ) ||
+	     ( ( trace_count - index ) > TRACE_EVENTS ) )
+		return NULL;
+
+	return &trace_events[ index % TRACE_EVENTS ];
+}
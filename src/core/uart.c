@@ -41,6 +41,10 @@ static void null_uart_transmit ( struct uart *uart __unused,
 				 uint8_t byte __unused ) {
 }
 
+static int null_uart_transmit_ready ( struct uart *uart __unused ) {
+	return 1;
+}
+
 static int null_uart_data_ready ( struct uart *uart __unused ) {
 	return 0;
 }
@@ -59,6 +63,7 @@ static void null_uart_flush ( struct uart *uart __unused ) {
 /** Null UART operations */
 struct uart_operations null_uart_operations = {
 	.transmit = null_uart_transmit,
+	.transmit_ready = null_uart_transmit_ready,
 	.data_ready = null_uart_data_ready,
 	.receive = null_uart_receive,
 	.init = null_uart_init,
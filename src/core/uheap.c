@@ -23,6 +23,7 @@
 
 FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 
+#include <errno.h>
 #include <ipxe/io.h>
 #include <ipxe/memmap.h>
 #include <ipxe/malloc.h>
@@ -59,6 +60,9 @@ physaddr_t uheap_start;
 /** End of external heap */
 physaddr_t uheap_end;
 
+/** Length of reserved region below the external heap */
+static size_t uheap_reserved;
+
 /** In-use memory region */
 struct used_region uheap_used __used_region = {
 	.name = "uheap",
@@ -171,7 +175,8 @@ static unsigned int uheap_shrink ( void *ptr, size_t size ) {
 }
 
 /** The external heap */
-static struct heap uheap = {
+static struct heap uheap __heap ( HEAP_EXTERNAL ) = {
+	.name = "uheap",
 	.blocks = LIST_HEAD_INIT ( uheap.blocks ),
 	.align = UHEAP_ALIGN,
 	.ptr_align = UHEAP_ALIGN,
@@ -179,6 +184,62 @@ static struct heap uheap = {
 	.shrink = uheap_shrink,
 };
 
+/**
+ * Reserve memory at the bottom of the external heap region
+ *
+ * @v start		Start address
+ * @v len		Length of reservation
+ * @ret rc		Return status code
+ *
+ * The reserved memory (and any memory below it within the external
+ * heap region) will not be used for external heap allocations until
+ * the reservation is released.  Only one reservation may exist at
+ * any time.
+ */
+int uheap_reserve ( physaddr_t start, size_t len ) {
+	physaddr_t end;
+
+	/* Initialise heap, if it does not yet exist */
+	if ( uheap_limit == uheap_end )
+		uheap_find();
+
+	/* Refuse nested reservations */
+	if ( uheap_reserved )
+		return -EBUSY;
+
+	/* Check that reservation lies within the unused heap region */
+	end = ( ( start + len + UHEAP_ALIGN - 1 ) & ~( UHEAP_ALIGN - 1 ) );
+	if ( ( ! len ) || ( start < uheap_limit ) || ( end < start ) ||
+	     ( end > uheap_start ) ) {
+		DBGC ( &uheap, "UHEAP cannot reserve [%#08lx,%#08lx)\n",
+		       start, ( start + len ) );
+		return -ENOSPC;
+	}
+
+	/* Raise heap limit above reservation */
+	uheap_reserved = ( end - uheap_limit );
+	DBGC ( &uheap, "UHEAP reserved [%#08lx,%#08lx)\n", uheap_limit, end );
+	uheap_limit = end;
+
+	return 0;
+}
+
+/**
+ * Release reserved memory
+ *
+ */
+void uheap_release ( void ) {
+
+	/* Do nothing unless memory is reserved */
+	if ( ! uheap_reserved )
+		return;
+
+	/* Restore heap limit */
+	uheap_limit -= uheap_reserved;
+	uheap_reserved = 0;
+	DBGC ( &uheap, "UHEAP released reservation\n" );
+}
+
 /**
  * Reallocate external memory
  *
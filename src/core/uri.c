@@ -39,6 +39,7 @@ FILE_SECBOOT ( PERMITTED );
 #include <ipxe/params.h>
 #include <ipxe/tcpip.h>
 #include <ipxe/uri.h>
+#include <ipxe/settings.h>
 
 /**
  * Decode URI field
@@ -827,3 +828,63 @@ struct uri * pxe_uri ( struct sockaddr *sa_server, const char *filename ) {
 	/* Otherwise, construct a TFTP URI directly */
 	return tftp_uri ( sa_server, filename );
 }
+
+/** PXE TFTP URI prefix setting */
+const struct setting pxe_tftp_uri_setting __setting ( SETTING_MISC,
+						      pxe-tftp-uri ) = {
+	.name = "pxe-tftp-uri",
+	.description = "PXE TFTP API URI prefix",
+	.type = &setting_type_string,
+};
+
+/**
+ * Construct URI for a file requested via a PXE TFTP API
+ *
+ * @v sa_server		Server address
+ * @v filename		Filename
+ * @ret uri		URI, or NULL on failure
+ *
+ * If the "pxe-tftp-uri" setting is present, then the filename (with
+ * any DOS-style path separators converted and any leading separators
+ * removed) is appended to it to form the URI, allowing files
+ * requested by legacy network bootstrap programs to be fetched via
+ * e.g. HTTP.  For example, setting "pxe-tftp-uri" to
+ * "http://192.168.0.1/tftpboot/" would cause a request for
+ * "\\Boot\\x64\\boot.wim" to be fetched via
+ * "http://192.168.0.1/tftpboot/Boot/x64/boot.wim".
+ *
+ * Otherwise, this is equivalent to pxe_uri().
+ */
+struct uri * pxe_tftp_uri ( struct sockaddr *sa_server,
+			    const char *filename ) {
+	struct uri *uri;
+	char *prefix;
+	char *uri_string;
+	char *tmp;
+	int len;
+
+	/* Use plain PXE URI unless a prefix is configured */
+	len = fetch_string_setting_copy ( NULL, &pxe_tftp_uri_setting,
+					  &prefix );
+	if ( len <= 0 )
+		return pxe_uri ( sa_server, filename );
+
+	/* Construct URI string */
+	uri = NULL;
+	while ( ( *filename == '/' ) || ( *filename == '\\' ) )
+		filename++;
+	if ( asprintf ( &uri_string, "%s%s", prefix, filename ) < 0 )
+		goto err_asprintf;
+	for ( tmp = ( uri_string + len ) ; *tmp ; tmp++ ) {
+		if ( *tmp == '\\' )
+			*tmp = '/';
+	}
+
+	/* Parse URI */
+	uri = parse_uri ( uri_string );
+
+	free ( uri_string );
+ err_asprintf:
+	free ( prefix );
+	return uri;
+}
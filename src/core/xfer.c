@@ -31,6 +31,7 @@ FILE_SECBOOT ( PERMITTED );
 #include <ipxe/iobuf.h>
 #include <ipxe/xfer.h>
 #include <ipxe/open.h>
+#include <ipxe/imgcache.h>
 
 /** @file
  *
@@ -397,3 +398,72 @@ int xfer_check_order ( struct xfer_metadata *meta, size_t *pos, size_t len ) {
 
 	return 0;
 }
+
+/**
+ * Get entity tag of cached content
+ *
+ * @v intf		Data transfer interface
+ * @ret etag		Entity tag, or NULL if no content is cached
+ */
+const char * imgcache_etag ( struct interface *intf ) {
+	struct interface *dest;
+	imgcache_etag_TYPE ( void * ) *op =
+		intf_get_dest_op ( intf, imgcache_etag, &dest );
+	void *object = intf_object ( dest );
+	const char *etag;
+
+	if ( op ) {
+		etag = op ( object );
+	} else {
+		/* Default is to have no cached content */
+		etag = NULL;
+	}
+
+	intf_put ( dest );
+	return etag;
+}
+
+/**
+ * Report that cached content is current
+ *
+ * @v intf		Data transfer interface
+ * @ret rc		Return status code
+ */
+int imgcache_current ( struct interface *intf ) {
+	struct interface *dest;
+	imgcache_current_TYPE ( void * ) *op =
+		intf_get_dest_op ( intf, imgcache_current, &dest );
+	void *object = intf_object ( dest );
+	int rc;
+
+	if ( op ) {
+		rc = op ( object );
+	} else {
+		/* Default is to have no cached content */
+		rc = -ENOTSUP;
+	}
+
+	intf_put ( dest );
+	return rc;
+}
+
+/**
+ * Report entity tag of received content
+ *
+ * @v intf		Data transfer interface
+ * @v etag		Entity tag
+ */
+void imgcache_validator ( struct interface *intf, const char *etag ) {
+	struct interface *dest;
+	imgcache_validator_TYPE ( void * ) *op =
+		intf_get_dest_op ( intf, imgcache_validator, &dest );
+	void *object = intf_object ( dest );
+
+	if ( op ) {
+		op ( object, etag );
+	} else {
+		/* Default is to ignore the notification */
+	}
+
+	intf_put ( dest );
+}
@@ -63,6 +63,7 @@ void xferbuf_detach ( struct xfer_buffer *xferbuf ) {
 
 	xferbuf->data = NULL;
 	xferbuf->len = 0;
+	xferbuf->capacity = 0;
 	xferbuf->max = 0;
 	xferbuf->pos = 0;
 }
@@ -78,6 +79,78 @@ void xferbuf_free ( struct xfer_buffer *xferbuf ) {
 	xferbuf_detach ( xferbuf );
 }
 
+/**
+ * Trim data transfer buffer to size of data
+ *
+ * @v xferbuf		Data transfer buffer
+ *
+ * Any spare capacity left over from geometric growth is released.
+ * Failure to shrink the buffer is not treated as an error.
+ */
+void xferbuf_trim ( struct xfer_buffer *xferbuf ) {
+	int rc;
+
+	/* Do nothing if there is no spare capacity */
+	if ( xferbuf->capacity <= xferbuf->len )
+		return;
+
+	/* Free buffer completely if there is no data */
+	if ( ! xferbuf->len ) {
+		xferbuf_free ( xferbuf );
+		return;
+	}
+
+	/* Shrink buffer */
+	if ( ( rc = xferbuf->op->realloc ( xferbuf, xferbuf->len ) ) != 0 ) {
+		DBGC ( xferbuf, "XFERBUF %p could not trim buffer to %zd "
+		       "bytes: %s\n", xferbuf, xferbuf->len, strerror ( rc ) );
+		return;
+	}
+	xferbuf->capacity = xferbuf->len;
+}
+
+/**
+ * Ensure that data transfer buffer has capacity for the specified size
+ *
+ * @v xferbuf		Data transfer buffer
+ * @v len		Required minimum capacity
+ * @ret rc		Return status code
+ *
+ * The size of the data (as opposed to the size of the allocated
+ * buffer) is not changed.
+ */
+int xferbuf_reserve ( struct xfer_buffer *xferbuf, size_t len ) {
+	size_t capacity;
+	int rc;
+
+	/* If buffer is already large enough, do nothing */
+	if ( len <= xferbuf->capacity )
+		return 0;
+
+	/* Grow buffer geometrically, so that the total cost of
+	 * repeated extensions (e.g. for a chunked HTTP download with
+	 * no known content length) remains linear in the final size.
+	 */
+	capacity = ( xferbuf->capacity + ( xferbuf->capacity / 2 ) );
+	if ( capacity < len )
+		capacity = len;
+
+	/* Extend buffer, falling back to the exact size required */
+	rc = xferbuf->op->realloc ( xferbuf, capacity );
+	if ( ( rc != 0 ) && ( capacity > len ) ) {
+		capacity = len;
+		rc = xferbuf->op->realloc ( xferbuf, capacity );
+	}
+	if ( rc != 0 ) {
+		DBGC ( xferbuf, "XFERBUF %p could not extend buffer to "
+		       "%zd bytes: %s\n", xferbuf, len, strerror ( rc ) );
+		return rc;
+	}
+	xferbuf->capacity = capacity;
+
+	return 0;
+}
+
 /**
  * Ensure that data transfer buffer is large enough for the specified size
  *
@@ -85,7 +158,7 @@ void xferbuf_free ( struct xfer_buffer *xferbuf ) {
  * @v len		Required minimum size
  * @ret rc		Return status code
  */
-static int xferbuf_ensure_size ( struct xfer_buffer *xferbuf, size_t len ) {
+int xferbuf_ensure_size ( struct xfer_buffer *xferbuf, size_t len ) {
 	int rc;
 
 	/* Record maximum required size */
@@ -96,12 +169,9 @@ static int xferbuf_ensure_size ( struct xfer_buffer *xferbuf, size_t len ) {
 	if ( len <= xferbuf->len )
 		return 0;
 
-	/* Extend buffer */
-	if ( ( rc = xferbuf->op->realloc ( xferbuf, len ) ) != 0 ) {
-		DBGC ( xferbuf, "XFERBUF %p could not extend buffer to "
-		       "%zd bytes: %s\n", xferbuf, len, strerror ( rc ) );
+	/* Ensure that there is sufficient capacity */
+	if ( ( rc = xferbuf_reserve ( xferbuf, len ) ) != 0 )
 		return rc;
-	}
 	xferbuf->len = len;
 
 	return 0;
@@ -256,7 +326,7 @@ struct xfer_buffer_operations xferbuf_umalloc_operations = {
 static int xferbuf_fixed_realloc ( struct xfer_buffer *xferbuf, size_t len ) {
 
 	/* Refuse to allocate extra space */
-	if ( len > xferbuf->len ) {
+	if ( len > xferbuf->capacity ) {
 		/* Note that EFI relies upon this error mapping to
 		 * EFI_BUFFER_TOO_SMALL.
 		 */
@@ -42,6 +42,14 @@ FILE_SECBOOT ( PERMITTED );
 #include <ipxe/gcm.h>
 #include <ipxe/aes.h>
 
+/**
+ * Disable hardware acceleration
+ *
+ * This may be used to force the use of the generic implementation
+ * (e.g. for self-tests).
+ */
+int aes_accel_disabled;
+
 /** AES strides
  *
  * These are the strides (modulo 16) used to walk through the AES
@@ -406,6 +414,12 @@ static void aes_encrypt ( void *ctx, const void *src, void *dst, size_t len ) {
 	/* Sanity check */
 	assert ( len == sizeof ( *in ) );
 
+	/* Use hardware accelerator, if available */
+	if ( aes->accel ) {
+		aes->accel->encrypt ( aes, src, dst );
+		return;
+	}
+
 	/* Initialise input state */
 	memcpy ( in, src, sizeof ( *in ) );
 
@@ -442,6 +456,12 @@ static void aes_decrypt ( void *ctx, const void *src, void *dst, size_t len ) {
 	/* Sanity check */
 	assert ( len == sizeof ( *in ) );
 
+	/* Use hardware accelerator, if available */
+	if ( aes->accel ) {
+		aes->accel->decrypt ( aes, src, dst );
+		return;
+	}
+
 	/* Initialise input state */
 	memcpy ( in, src, sizeof ( *in ) );
 
@@ -671,6 +691,33 @@ aes_key_rcon ( uint32_t column, unsigned int rcon ) {
 		 ( column ^ rcon ) : ( column ^ ( rcon << 24 ) ) );
 }
 
+/**
+ * Find usable hardware accelerator
+ *
+ * @ret accel		Hardware accelerator, or NULL
+ */
+static struct aes_accelerator * aes_accelerator ( void ) {
+	static struct aes_accelerator *accel;
+	static int probed;
+
+	/* Do nothing if hardware acceleration is disabled */
+	if ( aes_accel_disabled )
+		return NULL;
+
+	/* Use first usable accelerator (probing only once) */
+	if ( ! probed ) {
+		for_each_table_entry ( accel, AES_ACCELERATORS ) {
+			if ( accel->probe() == 0 )
+				break;
+		}
+		if ( accel == table_end ( AES_ACCELERATORS ) )
+			accel = NULL;
+		probed = 1;
+	}
+
+	return accel;
+}
+
 /**
  * Set key
  *
@@ -777,6 +824,13 @@ static int aes_setkey ( void *ctx, const void *key, size_t keylen ) {
 	DBGC2 ( aes, "AES %p inverted %zd-bit key:\n", aes, ( keylen * 8 ) );
 	DBGC2_HDA ( aes, 0, &aes->decrypt, ( rounds * sizeof ( *dec ) ) );
 
+	/* Use hardware accelerator, if available */
+	aes->accel = aes_accelerator();
+	if ( aes->accel ) {
+		DBGC2 ( aes, "AES %p using %s acceleration\n",
+			aes, aes->accel->name );
+	}
+
 	return 0;
 }
 
@@ -38,6 +38,48 @@ FILE_SECBOOT ( PERMITTED );
 /** Minimum number of least significant bytes included in transcription */
 #define BIGINT_NTOA_LSB_MIN 16
 
+/**
+ * Disable hardware acceleration
+ *
+ * This may be used to force the use of the generic implementation
+ * (e.g. for self-tests).
+ */
+int bigint_accel_disabled;
+
+/**
+ * Find usable hardware accelerator
+ *
+ * @v sizes		Bitwise OR of all big integer sizes
+ * @ret accel		Hardware accelerator, or NULL
+ */
+static struct bigint_accelerator * bigint_accelerator ( unsigned int sizes ) {
+	static struct bigint_accelerator *accel;
+	static int probed;
+
+	/* Do nothing if hardware acceleration is disabled */
+	if ( bigint_accel_disabled )
+		return NULL;
+
+	/* Use first usable accelerator (probing only once) */
+	if ( ! probed ) {
+		for_each_table_entry ( accel, BIGINT_ACCELERATORS ) {
+			if ( accel->probe() == 0 )
+				break;
+		}
+		if ( accel == table_end ( BIGINT_ACCELERATORS ) )
+			accel = NULL;
+		if ( accel )
+			DBG ( "BIGINT using %s acceleration\n", accel->name );
+		probed = 1;
+	}
+
+	/* Check that sizes are a multiple of the limb size */
+	if ( accel && ( sizes & ( accel->limb - 1 ) ) )
+		return NULL;
+
+	return accel;
+}
+
 /**
  * Transcribe big integer (for debugging)
  *
@@ -127,6 +169,7 @@ void bigint_multiply_raw ( const bigint_element_t *multiplicand0,
 		*multiplier = ( ( const void * ) multiplier0 );
 	bigint_t ( result_size ) __attribute__ (( may_alias ))
 		*result = ( ( void * ) result0 );
+	struct bigint_accelerator *accel;
 	bigint_element_t multiplicand_element;
 	const bigint_element_t *multiplier_element;
 	bigint_element_t *result_element;
@@ -134,6 +177,14 @@ void bigint_multiply_raw ( const bigint_element_t *multiplicand0,
 	unsigned int i;
 	unsigned int j;
 
+	/* Use hardware accelerator, if available */
+	accel = bigint_accelerator ( multiplicand_size | multiplier_size );
+	if ( accel ) {
+		accel->multiply ( multiplicand0, multiplicand_size,
+				  multiplier0, multiplier_size, result0 );
+		return;
+	}
+
 	/* Zero required portion of result
 	 *
 	 * All elements beyond the length of the multiplier will be
@@ -176,23 +227,22 @@ void bigint_multiply_raw ( const bigint_element_t *multiplicand0,
 }
 
 /**
- * Reduce big integer R^2 modulo N
+ * Reduce power of two modulo N
  *
  * @v modulus0		Element 0 of big integer modulus
  * @v result0		Element 0 of big integer to hold result
  * @v size		Number of elements in modulus and result
+ * @v power		Power of two (must exceed the number of bits in N)
  *
- * Reduce the value R^2 modulo N, where R=2^n and n is the number of
- * bits in the representation of the modulus N, including any leading
- * zero bits.
+ * Reduce the value 2^p modulo N.
  */
-void bigint_reduce_raw ( const bigint_element_t *modulus0,
-			 bigint_element_t *result0, unsigned int size ) {
+static void bigint_reduce_power_raw ( const bigint_element_t *modulus0,
+				      bigint_element_t *result0,
+				      unsigned int size, unsigned int power ) {
 	const bigint_t ( size ) __attribute__ (( may_alias ))
 		*modulus = ( ( const void * ) modulus0 );
 	bigint_t ( size ) __attribute__ (( may_alias ))
 		*result = ( ( void * ) result0 );
-	const unsigned int width = ( 8 * sizeof ( bigint_element_t ) );
 	unsigned int shift;
 	int max;
 	int sign;
@@ -216,8 +266,8 @@ void bigint_reduce_raw ( const bigint_element_t *modulus0,
 	 * as the value being reduced modulo N, where k is a
 	 * non-negative integer bit shift.
 	 *
-	 * We want to reduce the initial value R^2=2^(2n), which we
-	 * may trivially represent using r=1 and k=2n.
+	 * We want to reduce the initial value 2^p (e.g. R^2=2^(2n)),
+	 * which we may trivially represent using r=1 and k=p.
 	 *
 	 * We then iterate over decrementing k, maintaining the loop
 	 * invariant:
@@ -257,13 +307,13 @@ void bigint_reduce_raw ( const bigint_element_t *modulus0,
 	 * add a single multiple of N to ensure that x is positive,
 	 * i.e. lies within the range 0 <= x < N.
 	 *
-	 * Since neither the modulus nor the value R^2 are secret, we
-	 * may elide approximately half of the total number of
-	 * iterations by constructing the initial representation of
-	 * R^2 as r=2^m and k=2n-m (for some m such that 2^m < N).
+	 * Since neither the modulus nor the value 2^p are secret, we
+	 * may elide a large part of the total number of iterations
+	 * by constructing the initial representation of 2^p as r=2^m
+	 * and k=p-m (for some m such that 2^m < N).
 	 */
 
-	/* Initialise x=R^2 */
+	/* Initialise x=2^p */
 	memset ( result, 0, sizeof ( *result ) );
 	max = ( bigint_max_set_bit ( modulus ) - 2 );
 	if ( max < 0 ) {
@@ -271,7 +321,7 @@ void bigint_reduce_raw ( const bigint_element_t *modulus0,
 		return;
 	}
 	bigint_set_bit ( result, max );
-	shift = ( ( 2 * size * width ) - max );
+	shift = ( power - max );
 	sign = 0;
 
 	/* Iterate as described above */
@@ -308,6 +358,25 @@ void bigint_reduce_raw ( const bigint_element_t *modulus0,
 	assert ( ! bigint_is_geq ( result, modulus ) );
 }
 
+/**
+ * Reduce big integer R^2 modulo N
+ *
+ * @v modulus0		Element 0 of big integer modulus
+ * @v result0		Element 0 of big integer to hold result
+ * @v size		Number of elements in modulus and result
+ *
+ * Reduce the value R^2 modulo N, where R=2^n and n is the number of
+ * bits in the representation of the modulus N, including any leading
+ * zero bits.
+ */
+void bigint_reduce_raw ( const bigint_element_t *modulus0,
+			 bigint_element_t *result0, unsigned int size ) {
+	const unsigned int width = ( 8 * sizeof ( bigint_element_t ) );
+
+	bigint_reduce_power_raw ( modulus0, result0, size,
+				  ( 2 * size * width ) );
+}
+
 /**
  * Compute inverse of odd big integer modulo any power of two
  *
@@ -502,6 +571,7 @@ int bigint_montgomery_relaxed_raw ( const bigint_element_t *modulus0,
 		*result = ( ( void * ) result0 );
 	static bigint_t ( 1 ) cached;
 	static bigint_t ( 1 ) negmodinv;
+	struct bigint_accelerator *accel;
 	bigint_element_t multiple;
 	bigint_element_t carry;
 	unsigned int i;
@@ -511,6 +581,11 @@ int bigint_montgomery_relaxed_raw ( const bigint_element_t *modulus0,
 	/* Sanity checks */
 	assert ( bigint_bit_is_set ( modulus, 0 ) );
 
+	/* Use hardware accelerator, if available */
+	accel = bigint_accelerator ( size );
+	if ( accel )
+		return accel->montgomery ( modulus0, value0, result0, size );
+
 	/* Calculate inverse (or use cached version) */
 	if ( cached.element[0] != modulus->element[0] ) {
 		bigint_mod_invert ( modulus, &negmodinv );
@@ -738,6 +813,102 @@ void bigint_mod_exp_ladder ( const bigint_element_t *multiplier0,
 	}
 }
 
+/**
+ * Perform modular exponentiation via a fixed window
+ *
+ * @v result0		Element 0 of result (initialised to identity element)
+ * @v base0		Element 0 of base
+ * @v size		Number of elements in result and base
+ * @v exponent0		Element 0 of exponent
+ * @v exponent_size	Number of elements in exponent
+ * @v modulus		Odd modulus
+ * @v product		Temporary working space for products
+ * @v table0		Element 0 of window table
+ *
+ * All values are in Montgomery form.  The exponent is scanned from
+ * the most significant bit in fixed-width windows, with one
+ * multiplication by a precomputed power of the base for each
+ * non-zero window.  The sequence of operations depends upon the
+ * exponent, and so this must never be used with a secret exponent.
+ */
+static void bigint_mod_exp_window_raw ( bigint_element_t *result0,
+					const bigint_element_t *base0,
+					unsigned int size,
+					const bigint_element_t *exponent0,
+					unsigned int exponent_size,
+					const void *modulus, void *product,
+					bigint_element_t *table0 ) {
+	bigint_t ( size ) __attribute__ (( may_alias ))
+		*result = ( ( void * ) result0 );
+	const bigint_t ( size ) __attribute__ (( may_alias ))
+		*base = ( ( const void * ) base0 );
+	const bigint_t ( exponent_size ) __attribute__ (( may_alias ))
+		*exponent = ( ( const void * ) exponent0 );
+	bigint_t ( size ) __attribute__ (( may_alias ))
+		*table = ( ( void * ) table0 );
+	unsigned int bits = bigint_max_set_bit ( exponent );
+	unsigned int width;
+	unsigned int count;
+	unsigned int digit;
+	unsigned int bit;
+	unsigned int i;
+
+	/* Choose window width
+	 *
+	 * Each additional bit of window width doubles the size of the
+	 * table but reduces the number of multiplications required.
+	 * Small exponents (such as the ubiquitous e=65537) are handled
+	 * most efficiently via simple square-and-multiply.
+	 */
+	if ( bits > 160 ) {
+		width = BIGINT_MOD_EXP_WINDOW;
+	} else if ( bits > 24 ) {
+		width = 3;
+	} else {
+		width = 1;
+	}
+	count = ( ( 1 << width ) - 1 );
+
+	/* Construct table of powers base^1, base^2, ..., base^count */
+	bigint_copy ( base, &table[0] );
+	for ( i = 1 ; i < count ; i++ ) {
+		bigint_copy ( &table[ i - 1 ], &table[i] );
+		bigint_mod_exp_ladder ( base->element, table[i].element, size,
+					modulus, product );
+	}
+
+	/* Process each window, starting from the most significant */
+	for ( bit = ( ( ( bits + width - 1 ) / width ) * width ) ; bit ; ) {
+
+		/* Shift previous windows up, if applicable */
+		if ( bit < bits ) {
+			for ( i = 0 ; i < width ; i++ ) {
+				bigint_mod_exp_ladder ( result->element,
+							result->element, size,
+							modulus, product );
+			}
+		}
+
+		/* Extract window */
+		digit = 0;
+		for ( i = width ; i-- ; ) {
+			bit--;
+			digit <<= 1;
+			if ( ( bit < bits ) &&
+			     bigint_bit_is_set ( exponent, bit ) ) {
+				digit |= 1;
+			}
+		}
+
+		/* Multiply by corresponding power of the base */
+		if ( digit ) {
+			bigint_mod_exp_ladder ( table[ digit - 1 ].element,
+						result->element, size,
+						modulus, product );
+		}
+	}
+}
+
 /**
  * Perform modular exponentiation of big integers
  *
@@ -748,13 +919,15 @@ void bigint_mod_exp_ladder ( const bigint_element_t *multiplier0,
  * @v size		Number of elements in base, modulus, and result
  * @v exponent_size	Number of elements in exponent
  * @v tmp		Temporary working space
+ * @v table0		Element 0 of window table, or NULL to use ladder
  */
-void bigint_mod_exp_raw ( const bigint_element_t *base0,
-			  const bigint_element_t *modulus0,
-			  const bigint_element_t *exponent0,
-			  bigint_element_t *result0,
-			  unsigned int size, unsigned int exponent_size,
-			  void *tmp ) {
+static void bigint_mod_exp_any_raw ( const bigint_element_t *base0,
+				     const bigint_element_t *modulus0,
+				     const bigint_element_t *exponent0,
+				     bigint_element_t *result0,
+				     unsigned int size,
+				     unsigned int exponent_size,
+				     void *tmp, bigint_element_t *table0 ) {
 	const bigint_t ( size ) __attribute__ (( may_alias )) *base =
 		( ( const void * ) base0 );
 	const bigint_t ( size ) __attribute__ (( may_alias )) *modulus =
@@ -800,8 +973,24 @@ void bigint_mod_exp_raw ( const bigint_element_t *base0,
 	if ( ! submask )
 		submask = ~submask;
 
-	/* Calculate (R^2 mod N) */
-	bigint_reduce ( &temp->modulus, &temp->stash );
+	/* Calculate (R^2 mod N)
+	 *
+	 * Direct reduction requires one shift and one addition or
+	 * subtraction per bit of R^2, which would dominate the cost
+	 * of exponentiation with a small exponent.  We instead reduce
+	 * only (R * 2^size mod N), which is the Montgomery form of
+	 * 2^size, and then obtain the Montgomery form of R=2^(width
+	 * * size) via repeated Montgomery squaring.  Since the width
+	 * is a power of two, this requires only a handful of
+	 * squarings.
+	 */
+	bigint_reduce_power_raw ( temp->modulus.element, temp->stash.element,
+				  size, ( ( width + 1 ) * size ) );
+	for ( i = size ; i < ( width * size ) ; i <<= 1 ) {
+		bigint_mod_exp_ladder ( temp->stash.element,
+					temp->stash.element, size,
+					&temp->modulus, &temp->product );
+	}
 
 	/* Initialise result = Montgomery(1, R^2 mod N) */
 	bigint_grow ( &temp->stash, &temp->product.full );
@@ -813,8 +1002,17 @@ void bigint_mod_exp_raw ( const bigint_element_t *base0,
 			    &temp->stash );
 
 	/* Calculate x1 = base^exponent modulo N */
-	bigint_ladder ( result, &temp->stash, exponent, bigint_mod_exp_ladder,
-			&temp->modulus, &temp->product );
+	if ( table0 ) {
+		bigint_mod_exp_window_raw ( result->element,
+					    temp->stash.element, size,
+					    exponent->element, exponent_size,
+					    &temp->modulus, &temp->product,
+					    table0 );
+	} else {
+		bigint_ladder ( result, &temp->stash, exponent,
+				bigint_mod_exp_ladder, &temp->modulus,
+				&temp->product );
+	}
 
 	/* Convert back out of Montgomery form */
 	bigint_grow ( result, &temp->product.full );
@@ -868,3 +1066,65 @@ void bigint_mod_exp_raw ( const bigint_element_t *base0,
 		bigint_add ( &temp->product.low, result );
 	}
 }
+
+/**
+ * Perform modular exponentiation of big integers
+ *
+ * @v base0		Element 0 of big integer base
+ * @v modulus0		Element 0 of big integer modulus
+ * @v exponent0		Element 0 of big integer exponent
+ * @v result0		Element 0 of big integer to hold result
+ * @v size		Number of elements in base, modulus, and result
+ * @v exponent_size	Number of elements in exponent
+ * @v tmp		Temporary working space
+ *
+ * The calculation is performed in constant time via a Montgomery
+ * ladder, and so the exponent may be secret.
+ */
+void bigint_mod_exp_raw ( const bigint_element_t *base0,
+			  const bigint_element_t *modulus0,
+			  const bigint_element_t *exponent0,
+			  bigint_element_t *result0,
+			  unsigned int size, unsigned int exponent_size,
+			  void *tmp ) {
+
+	bigint_mod_exp_any_raw ( base0, modulus0, exponent0, result0, size,
+				 exponent_size, tmp, NULL );
+}
+
+/**
+ * Perform modular exponentiation of big integers with a public exponent
+ *
+ * @v base0		Element 0 of big integer base
+ * @v modulus0		Element 0 of big integer modulus
+ * @v exponent0		Element 0 of big integer exponent
+ * @v result0		Element 0 of big integer to hold result
+ * @v size		Number of elements in base, modulus, and result
+ * @v exponent_size	Number of elements in exponent
+ * @v tmp		Temporary working space
+ *
+ * The calculation is performed via a fixed window, which is
+ * significantly faster than a Montgomery ladder but does not run in
+ * constant time.  This must be used only when the exponent is not
+ * secret (e.g. for RSA signature verification).
+ */
+void bigint_mod_exp_public_raw ( const bigint_element_t *base0,
+				 const bigint_element_t *modulus0,
+				 const bigint_element_t *exponent0,
+				 bigint_element_t *result0,
+				 unsigned int size, unsigned int exponent_size,
+				 void *tmp ) {
+	const bigint_t ( size ) __attribute__ (( may_alias )) *modulus =
+		( ( const void * ) modulus0 );
+	struct {
+		bigint_t ( size ) temp[4];
+		bigint_t ( size ) table[ ( 1 << BIGINT_MOD_EXP_WINDOW ) - 1 ];
+	} *temp = tmp;
+
+	/* Sanity check */
+	assert ( sizeof ( *temp ) ==
+		 bigint_mod_exp_public_tmp_len ( modulus ) );
+
+	bigint_mod_exp_any_raw ( base0, modulus0, exponent0, result0, size,
+				 exponent_size, tmp, temp->table[0].element );
+}
@@ -26,7 +26,7 @@ FILE_SECBOOT ( PERMITTED );
 
 #include <string.h>
 #include <stdlib.h>
-#include <ipxe/init.h>
+#include <assert.h>
 #include <ipxe/dhcp.h>
 #include <ipxe/settings.h>
 #include <ipxe/malloc.h>
@@ -86,11 +86,14 @@ static void certstore_found ( struct x509_chain *store,
 		x509_name ( cert ) );
 }
 
+static void certstore_populate ( struct x509_chain *store );
+
 /** Certificate store */
 struct x509_chain certstore = {
 	.refcnt = REF_INIT ( ref_no_free ),
 	.links = LIST_HEAD_INIT ( certstore.links ),
 	.found = certstore_found,
+	.populate = certstore_populate,
 };
 
 /**
@@ -165,8 +168,13 @@ struct cache_discarder certstore_discarder __cache_discarder ( CACHE_NORMAL ) ={
 /**
  * Construct permanent certificate store
  *
+ * @v store		Certificate store
+ *
+ * Permanent certificates are parsed only when the certificate store
+ * is first consulted, so that the cost of parsing a large bundle of
+ * certificates is not incurred by boots that never use them.
  */
-static void certstore_init ( void ) {
+static void certstore_populate ( struct x509_chain *store ) {
 	struct asn1_cursor *raw;
 	struct x509_certificate *cert;
 	int i;
@@ -176,6 +184,12 @@ static void certstore_init ( void ) {
 	if ( ! sizeof ( certstore_raw ) )
 		return;
 
+	/* Populate only once.  (Clearing the method also prevents
+	 * recursion via the duplicate check below.)
+	 */
+	assert ( store == &certstore );
+	store->populate = NULL;
+
 	/* Add certificates */
 	for ( i = 0 ; i < ( int ) ( sizeof ( certstore_raw ) /
 				    sizeof ( certstore_raw[0] ) ) ; i++ ) {
@@ -209,12 +223,6 @@ static void certstore_init ( void ) {
 	}
 }
 
-/** Certificate store initialisation function */
-struct init_fn certstore_init_fn __init_fn ( INIT_LATE ) = {
-	.name = "certstore",
-	.initialise = certstore_init,
-};
-
 /** Additional certificate setting */
 static struct setting cert_setting __setting ( SETTING_CRYPTO, cert ) = {
 	.name = "cert",
@@ -0,0 +1,209 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+FILE_SECBOOT ( PERMITTED );
+
+/** @file
+ *
+ * ChaCha20 stream cipher
+ *
+ * This is an implementation of the ChaCha20 stream cipher as
+ * described in RFC 8439, using a 32-bit block counter and a 96-bit
+ * nonce.
+ *
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <byteswap.h>
+#include <ipxe/rotate.h>
+#include <ipxe/crypto.h>
+#include <ipxe/chacha20.h>
+
+/** ChaCha20 constants ("expand 32-byte k") */
+static const uint32_t chacha20_constants[4] = {
+	0x61707865, 0x3320646e, 0x79622d32, 0x6b206574
+};
+
+/**
+ * Perform ChaCha20 quarter round
+ *
+ * @v x			Working state
+ * @v a			Index of first word
+ * @v b			Index of second word
+ * @v c			Index of third word
+ * @v d			Index of fourth word
+ */
+static inline __attribute__ (( always_inline )) void
+chacha20_quarter ( uint32_t *x, unsigned int a, unsigned int b,
+		   unsigned int c, unsigned int d ) {
+
+	x[a] += x[b];	x[d] = rol32 ( ( x[d] ^ x[a] ), 16 );
+	x[c] += x[d];	x[b] = rol32 ( ( x[b] ^ x[c] ), 12 );
+	x[a] += x[b];	x[d] = rol32 ( ( x[d] ^ x[a] ), 8 );
+	x[c] += x[d];	x[b] = rol32 ( ( x[b] ^ x[c] ), 7 );
+}
+
+/**
+ * Generate next keystream block
+ *
+ * @v context		ChaCha20 context
+ */
+static void chacha20_generate ( struct chacha20_context *context ) {
+	uint32_t x[16];
+	unsigned int i;
+
+	/* Initialise working state */
+	memcpy ( x, context->state, sizeof ( x ) );
+
+	/* Perform column and diagonal rounds */
+	for ( i = 0 ; i < CHACHA20_DOUBLE_ROUNDS ; i++ ) {
+		chacha20_quarter ( x, 0, 4, 8, 12 );
+		chacha20_quarter ( x, 1, 5, 9, 13 );
+		chacha20_quarter ( x, 2, 6, 10, 14 );
+		chacha20_quarter ( x, 3, 7, 11, 15 );
+		chacha20_quarter ( x, 0, 5, 10, 15 );
+		chacha20_quarter ( x, 1, 6, 11, 12 );
+		chacha20_quarter ( x, 2, 7, 8, 13 );
+		chacha20_quarter ( x, 3, 4, 9, 14 );
+	}
+
+	/* Add input state and serialise */
+	for ( i = 0 ; i < 16 ; i++ ) {
+		context->keystream.dword[i] =
+			cpu_to_le32 ( x[i] + context->state[i] );
+	}
+
+	/* Increment block counter */
+	context->state[12]++;
+	context->offset = 0;
+}
+
+/**
+ * Set key
+ *
+ * @v ctx		Context
+ * @v key		Key
+ * @v keylen		Key length
+ * @ret rc		Return status code
+ */
+int chacha20_setkey ( void *ctx, const void *key, size_t keylen ) {
+	struct chacha20_context *context = ctx;
+	uint32_t words[ CHACHA20_KEY_LEN / sizeof ( uint32_t ) ];
+	unsigned int i;
+
+	/* Check key length */
+	if ( keylen != CHACHA20_KEY_LEN ) {
+		DBGC ( context, "CHACHA20 %p unsupported key length (%zd "
+		       "bytes)\n", context, keylen );
+		return -EINVAL;
+	}
+
+	/* Construct constant and key portions of input state */
+	memcpy ( context->state, chacha20_constants,
+		 sizeof ( chacha20_constants ) );
+	memcpy ( words, key, sizeof ( words ) );
+	for ( i = 0 ; i < ( sizeof ( words ) / sizeof ( words[0] ) ) ; i++ )
+		context->state[ 4 + i ] = le32_to_cpu ( words[i] );
+
+	/* Reset counter and nonce */
+	memset ( &context->state[12], 0,
+		 ( 4 * sizeof ( context->state[0] ) ) );
+	context->offset = sizeof ( context->keystream );
+
+	return 0;
+}
+
+/**
+ * Set initialisation vector
+ *
+ * @v ctx		Context
+ * @v iv		Initialisation vector
+ * @v ivlen		Initialisation vector length
+ *
+ * The initialisation vector comprises the initial block counter and
+ * the nonce, as described by struct chacha20_iv.  A shorter
+ * initialisation vector will be zero-padded.
+ */
+void chacha20_setiv ( void *ctx, const void *iv, size_t ivlen ) {
+	struct chacha20_context *context = ctx;
+	union {
+		struct chacha20_iv iv;
+		uint32_t dword[ sizeof ( struct chacha20_iv ) /
+				sizeof ( uint32_t ) ];
+	} padded;
+	unsigned int i;
+
+	/* Construct padded initialisation vector */
+	memset ( &padded, 0, sizeof ( padded ) );
+	if ( ivlen > sizeof ( padded ) )
+		ivlen = sizeof ( padded );
+	memcpy ( &padded, iv, ivlen );
+
+	/* Construct counter and nonce portions of input state */
+	for ( i = 0 ; i < ( sizeof ( padded.dword ) /
+			    sizeof ( padded.dword[0] ) ) ; i++ ) {
+		context->state[ 12 + i ] = le32_to_cpu ( padded.dword[i] );
+	}
+
+	/* Discard any remaining keystream */
+	context->offset = sizeof ( context->keystream );
+}
+
+/**
+ * Encrypt data
+ *
+ * @v ctx		Context
+ * @v src		Data to encrypt
+ * @v dst		Buffer for encrypted data
+ * @v len		Length of data
+ */
+void chacha20_encrypt ( void *ctx, const void *src, void *dst, size_t len ) {
+	struct chacha20_context *context = ctx;
+	const uint8_t *in = src;
+	uint8_t *out = dst;
+
+	/* XOR data with keystream */
+	while ( len-- ) {
+		if ( context->offset == sizeof ( context->keystream ) )
+			chacha20_generate ( context );
+		*(out++) = ( *(in++) ^
+			     context->keystream.byte[ context->offset++ ] );
+	}
+}
+
+/** ChaCha20 algorithm */
+struct cipher_algorithm chacha20_algorithm = {
+	.name = "chacha20",
+	.ctxsize = CHACHA20_CTX_SIZE,
+	.blocksize = 1,
+	.alignsize = 1,
+	.authsize = 0,
+	.setkey = chacha20_setkey,
+	.setiv = chacha20_setiv,
+	.encrypt = chacha20_encrypt,
+	.decrypt = chacha20_encrypt,
+	.auth = cipher_null_auth,
+};
@@ -0,0 +1,203 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+FILE_SECBOOT ( PERMITTED );
+
+/** @file
+ *
+ * ChaCha20-Poly1305 authenticated encryption
+ *
+ * This is an implementation of the ChaCha20-Poly1305 AEAD
+ * construction as described in RFC 8439.
+ *
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <byteswap.h>
+#include <ipxe/crypto.h>
+#include <ipxe/chacha20.h>
+#include <ipxe/poly1305.h>
+
+/** A ChaCha20-Poly1305 context */
+struct chacha20_poly1305_context {
+	/** ChaCha20 context */
+	struct chacha20_context chacha20;
+	/** Poly1305 context */
+	struct poly1305_context poly1305;
+	/** Length of additional data */
+	uint64_t additional;
+	/** Length of ciphertext */
+	uint64_t len;
+};
+
+/** ChaCha20-Poly1305 length block */
+struct chacha20_poly1305_lengths {
+	/** Length of additional data (in little-endian order) */
+	uint64_t additional;
+	/** Length of ciphertext (in little-endian order) */
+	uint64_t len;
+} __attribute__ (( packed ));
+
+/**
+ * Set key
+ *
+ * @v ctx		Context
+ * @v key		Key
+ * @v keylen		Key length
+ * @ret rc		Return status code
+ */
+static int chacha20_poly1305_setkey ( void *ctx, const void *key,
+				      size_t keylen ) {
+	struct chacha20_poly1305_context *context = ctx;
+
+	return chacha20_setkey ( &context->chacha20, key, keylen );
+}
+
+/**
+ * Set initialisation vector
+ *
+ * @v ctx		Context
+ * @v iv		Initialisation vector (nonce)
+ * @v ivlen		Initialisation vector length
+ *
+ * A nonce shorter than @c CHACHA20_NONCE_LEN will be zero-padded.
+ */
+static void chacha20_poly1305_setiv ( void *ctx, const void *iv,
+				      size_t ivlen ) {
+	struct chacha20_poly1305_context *context = ctx;
+	struct chacha20_iv chacha20_iv;
+	union chacha20_block key;
+
+	/* Construct ChaCha20 initialisation vector */
+	memset ( &chacha20_iv, 0, sizeof ( chacha20_iv ) );
+	if ( ivlen > sizeof ( chacha20_iv.nonce ) )
+		ivlen = sizeof ( chacha20_iv.nonce );
+	memcpy ( chacha20_iv.nonce, iv, ivlen );
+	chacha20_setiv ( &context->chacha20, &chacha20_iv,
+			 sizeof ( chacha20_iv ) );
+
+	/* Generate Poly1305 one-time key from keystream block zero,
+	 * leaving the keystream positioned at the start of block one.
+	 */
+	memset ( &key, 0, sizeof ( key ) );
+	chacha20_encrypt ( &context->chacha20, &key, &key, sizeof ( key ) );
+	poly1305_init ( &context->poly1305, &key );
+
+	/* Reset lengths */
+	context->additional = 0;
+	context->len = 0;
+}
+
+/**
+ * Encrypt data
+ *
+ * @v ctx		Context
+ * @v src		Data to encrypt
+ * @v dst		Buffer for encrypted data, or NULL for additional data
+ * @v len		Length of data
+ */
+static void chacha20_poly1305_encrypt ( void *ctx, const void *src,
+					void *dst, size_t len ) {
+	struct chacha20_poly1305_context *context = ctx;
+
+	/* Accumulate additional data, if applicable */
+	if ( ! dst ) {
+		poly1305_update ( &context->poly1305, src, len );
+		context->additional += len;
+		return;
+	}
+
+	/* Pad additional data, if applicable */
+	if ( ! context->len )
+		poly1305_pad ( &context->poly1305 );
+
+	/* Encrypt data and accumulate ciphertext */
+	chacha20_encrypt ( &context->chacha20, src, dst, len );
+	poly1305_update ( &context->poly1305, dst, len );
+	context->len += len;
+}
+
+/**
+ * Decrypt data
+ *
+ * @v ctx		Context
+ * @v src		Data to decrypt
+ * @v dst		Buffer for decrypted data, or NULL for additional data
+ * @v len		Length of data
+ */
+static void chacha20_poly1305_decrypt ( void *ctx, const void *src,
+					void *dst, size_t len ) {
+	struct chacha20_poly1305_context *context = ctx;
+
+	/* Accumulate additional data, if applicable */
+	if ( ! dst ) {
+		poly1305_update ( &context->poly1305, src, len );
+		context->additional += len;
+		return;
+	}
+
+	/* Pad additional data, if applicable */
+	if ( ! context->len )
+		poly1305_pad ( &context->poly1305 );
+
+	/* Accumulate ciphertext and decrypt data */
+	poly1305_update ( &context->poly1305, src, len );
+	chacha20_encrypt ( &context->chacha20, src, dst, len );
+	context->len += len;
+}
+
+/**
+ * Generate authentication tag
+ *
+ * @v ctx		Context
+ * @v auth		Authentication tag
+ */
+static void chacha20_poly1305_auth ( void *ctx, void *auth ) {
+	struct chacha20_poly1305_context *context = ctx;
+	struct chacha20_poly1305_lengths lengths;
+
+	/* Accumulate padding and lengths */
+	poly1305_pad ( &context->poly1305 );
+	lengths.additional = cpu_to_le64 ( context->additional );
+	lengths.len = cpu_to_le64 ( context->len );
+	poly1305_update ( &context->poly1305, &lengths, sizeof ( lengths ) );
+
+	/* Generate authentication tag */
+	poly1305_final ( &context->poly1305, auth );
+}
+
+/** ChaCha20-Poly1305 algorithm */
+struct cipher_algorithm chacha20_poly1305_algorithm = {
+	.name = "chacha20_poly1305",
+	.ctxsize = sizeof ( struct chacha20_poly1305_context ),
+	.blocksize = 1,
+	.alignsize = 1,
+	.authsize = POLY1305_TAG_LEN,
+	.setkey = chacha20_poly1305_setkey,
+	.setiv = chacha20_poly1305_setiv,
+	.encrypt = chacha20_poly1305_encrypt,
+	.decrypt = chacha20_poly1305_decrypt,
+	.auth = chacha20_poly1305_auth,
+};
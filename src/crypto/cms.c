@@ -713,20 +713,24 @@ int cms_message ( struct image *image, struct cms_message **cms ) {
  *
  * @v cms		CMS message
  * @v part		Participant information
- * @v data		Signed data
- * @v len		Length of signed data
+ * @v image		Signed image
  * @v out		Digest output
  */
 static void cms_digest ( struct cms_message *cms,
 			 struct cms_participant *part,
-			 const void *data, size_t len, void *out ) {
+			 struct image *image, void *out ) {
 	struct digest_algorithm *digest = part->digest;
 	uint8_t ctx[ digest->ctxsize ];
 
-	/* Calculate digest */
-	digest_init ( digest, ctx );
-	digest_update ( digest, ctx, data, len );
-	digest_final ( digest, ctx, out );
+	/* Use digest accumulated during download, if available */
+	if ( image_digest_final ( image, digest, out ) == 0 ) {
+		DBGC ( cms, "CMS %p/%p using digest accumulated during "
+		       "download\n", cms, part );
+	} else {
+		digest_init ( digest, ctx );
+		digest_update ( digest, ctx, image->data, image->len );
+		digest_final ( digest, ctx, out );
+	}
 
 	DBGC ( cms, "CMS %p/%p digest value:\n", cms, part );
 	DBGC_HDA ( cms, 0, out, digest->digestsize );
@@ -738,14 +742,13 @@ static void cms_digest ( struct cms_message *cms,
  * @v cms		CMS message
  * @v part		Participant information
  * @v cert		Corresponding certificate
- * @v data		Signed data
- * @v len		Length of signed data
+ * @v image		Signed image
  * @ret rc		Return status code
  */
 static int cms_verify_digest ( struct cms_message *cms,
 			       struct cms_participant *part,
 			       struct x509_certificate *cert,
-			       const void *data, size_t len ) {
+			       struct image *image ) {
 	struct digest_algorithm *digest = part->digest;
 	struct pubkey_algorithm *pubkey = part->pubkey;
 	const struct asn1_cursor *key = &cert->subject.public_key.raw;
@@ -754,7 +757,7 @@ static int cms_verify_digest ( struct cms_message *cms,
 	int rc;
 
 	/* Generate digest */
-	cms_digest ( cms, part, data, len, digest_out );
+	cms_digest ( cms, part, image, digest_out );
 
 	/* Verify digest */
 	if ( ( rc = pubkey_verify ( pubkey, key, digest, digest_out,
@@ -772,8 +775,7 @@ static int cms_verify_digest ( struct cms_message *cms,
  *
  * @v cms		CMS message
  * @v part		Participant information
- * @v data		Signed data
- * @v len		Length of signed data
+ * @v image		Signed image
  * @v time		Time at which to validate certificates
  * @v store		Certificate store, or NULL to use default
  * @v root		Root certificate list, or NULL to use default
@@ -781,7 +783,7 @@ static int cms_verify_digest ( struct cms_message *cms,
  */
 static int cms_verify_signer ( struct cms_message *cms,
 			       struct cms_participant *part,
-			       const void *data, size_t len,
+			       struct image *image,
 			       time_t time, struct x509_chain *store,
 			       struct x509_root *root ) {
 	struct x509_certificate *cert;
@@ -814,7 +816,7 @@ static int cms_verify_signer ( struct cms_message *cms,
 	}
 
 	/* Verify digest */
-	if ( ( rc = cms_verify_digest ( cms, part, cert, data, len ) ) != 0 )
+	if ( ( rc = cms_verify_digest ( cms, part, cert, image ) ) != 0 )
 		return rc;
 
 	return 0;
@@ -851,9 +853,8 @@ int cms_verify ( struct cms_message *cms, struct image *image,
 		cert = x509_first ( part->chain );
 		if ( name && ( x509_check_name ( cert, name ) != 0 ) )
 			continue;
-		if ( ( rc = cms_verify_signer ( cms, part, image->data,
-						image->len, time, store,
-						root ) ) != 0 )
+		if ( ( rc = cms_verify_signer ( cms, part, image, time,
+						store, root ) ) != 0 )
 			return rc;
 		count++;
 	}
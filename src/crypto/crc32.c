@@ -22,9 +22,161 @@
 FILE_LICENCE ( GPL2_OR_LATER );
 FILE_SECBOOT ( PERMITTED );
 
+#include <string.h>
+#include <assert.h>
+#include <byteswap.h>
 #include <ipxe/crc32.h>
 
-#define CRCPOLY		0xedb88320
+/** @file
+ *
+ * Little-endian CRC32
+ *
+ * The generic engine uses "slicing-by-8" lookup tables, which are
+ * constructed on first use to avoid inflating the binary size.  A
+ * hardware accelerator may be used to process the bulk of the data.
+ *
+ */
+
+/** A CRC32 polynomial */
+struct crc32_polynomial {
+	/** Name */
+	const char *name;
+	/** Polynomial (bit-reversed) */
+	uint32_t poly;
+	/** Lookup tables */
+	uint32_t ( * table )[256];
+	/** Hardware accelerator (if any) */
+	struct crc32_accelerator *accel;
+	/** Lookup tables and accelerator have been initialised */
+	int initialised;
+};
+
+/** Disable hardware acceleration */
+int crc32_accel_disabled;
+
+/** CRC32 lookup tables */
+static uint32_t crc32_table[CRC32_SLICES][256];
+
+/** CRC32 polynomial */
+static struct crc32_polynomial crc32 = {
+	.name = "CRC32",
+	.poly = CRC32_POLY,
+	.table = crc32_table,
+};
+
+/** CRC32C lookup tables */
+static uint32_t crc32c_table[CRC32_SLICES][256];
+
+/** CRC32C polynomial */
+static struct crc32_polynomial crc32c = {
+	.name = "CRC32C",
+	.poly = CRC32C_POLY,
+	.table = crc32c_table,
+};
+
+/**
+ * Initialise lookup tables and find usable hardware accelerator
+ *
+ * @v polynomial	CRC32 polynomial
+ */
+static void crc32_init ( struct crc32_polynomial *polynomial ) {
+	struct crc32_accelerator *accel;
+	uint32_t ( * table )[256] = polynomial->table;
+	uint32_t value;
+	unsigned int slice;
+	unsigned int i;
+	unsigned int j;
+
+	/* Construct table for single bytes */
+	for ( i = 0 ; i < 256 ; i++ ) {
+		value = i;
+		for ( j = 0 ; j < 8 ; j++ ) {
+			value = ( ( value >> 1 ) ^
+				  ( ( value & 1 ) ? polynomial->poly : 0 ) );
+		}
+		table[0][i] = value;
+	}
+
+	/* Construct tables for bytes followed by zeroes */
+	for ( slice = 1 ; slice < CRC32_SLICES ; slice++ ) {
+		for ( i = 0 ; i < 256 ; i++ ) {
+			value = table[ slice - 1 ][i];
+			table[slice][i] = ( ( value >> 8 ) ^
+					    table[0][ value & 0xff ] );
+		}
+	}
+
+	/* Use first usable accelerator */
+	for_each_table_entry ( accel, CRC32_ACCELERATORS ) {
+		if ( ( accel->poly == polynomial->poly ) &&
+		     ( accel->probe() == 0 ) ) {
+			DBGC ( polynomial, "%s using %s acceleration\n",
+			       polynomial->name, accel->name );
+			polynomial->accel = accel;
+			break;
+		}
+	}
+
+	polynomial->initialised = 1;
+}
+
+/**
+ * Calculate 32-bit little-endian CRC checksum
+ *
+ * @v polynomial	CRC32 polynomial
+ * @v seed		Initial value
+ * @v data		Data to checksum
+ * @v len		Length of data
+ * @ret crc		CRC checksum
+ */
+static uint32_t crc32_calculate ( struct crc32_polynomial *polynomial,
+				  uint32_t seed, const void *data,
+				  size_t len ) {
+	uint32_t ( * table )[256] = polynomial->table;
+	struct crc32_accelerator *accel;
+	const uint8_t *src;
+	uint32_t crc = seed;
+	uint32_t lo;
+	uint32_t hi;
+	size_t used;
+
+	/* Initialise on first use */
+	if ( ! polynomial->initialised )
+		crc32_init ( polynomial );
+
+	/* Use hardware accelerator, if available */
+	accel = polynomial->accel;
+	if ( accel && ( ! crc32_accel_disabled ) ) {
+		used = accel->update ( &crc, data, len );
+		data += used;
+		len -= used;
+	}
+
+	/* Process blocks of eight bytes */
+	src = data;
+	build_assert ( CRC32_SLICES == 8 );
+	for ( ; len >= CRC32_SLICES ; src += CRC32_SLICES,
+					len -= CRC32_SLICES ) {
+		memcpy ( &lo, &src[0], sizeof ( lo ) );
+		memcpy ( &hi, &src[4], sizeof ( hi ) );
+		lo = ( le32_to_cpu ( lo ) ^ crc );
+		hi = le32_to_cpu ( hi );
+		crc = ( table[7][ ( lo >> 0 ) & 0xff ] ^
+			table[6][ ( lo >> 8 ) & 0xff ] ^
+			table[5][ ( lo >> 16 ) & 0xff ] ^
+			table[4][ ( lo >> 24 ) & 0xff ] ^
+			table[3][ ( hi >> 0 ) & 0xff ] ^
+			table[2][ ( hi >> 8 ) & 0xff ] ^
+			table[1][ ( hi >> 16 ) & 0xff ] ^
+			table[0][ ( hi >> 24 ) & 0xff ] );
+	}
+
+	/* Process remaining bytes */
+	for ( ; len ; src++, len-- )
+		crc = ( ( crc >> 8 ) ^ table[0][ ( crc ^ *src ) & 0xff ] );
+
+	return crc;
+}
 
 /**
  * Calculate 32-bit little-endian CRC checksum
@@ -37,20 +189,21 @@ FILE_SECBOOT ( PERMITTED );
  * protocol. To continue a CRC checksum over multiple calls, pass the
  * return value from one call as the @a seed parameter to the next.
  */
-u32 crc32_le ( u32 seed, const void *data, size_t len )
-{
-	u32 crc = seed;
-	const u8 *src = data;
-	u32 mult;
-	int i;
-
-	while ( len-- ) {
-		crc ^= *src++;
-		for ( i = 0; i < 8; i++ ) {
-			mult = ( crc & 1 ) ? CRCPOLY : 0;
-			crc = ( crc >> 1 ) ^ mult;
-		}
-	}
+u32 crc32_le ( u32 seed, const void *data, size_t len ) {
 
-	return crc;
+	return crc32_calculate ( &crc32, seed, data, len );
+}
+
+/**
+ * Calculate 32-bit little-endian CRC32C (Castagnoli) checksum
+ *
+ * @v seed	Initial value
+ * @v data	Data to checksum
+ * @v len	Length of data
+ *
+ * The seed is used in the same way as for crc32_le().
+ */
+u32 crc32c_le ( u32 seed, const void *data, size_t len ) {
+
+	return crc32_calculate ( &crc32c, seed, data, len );
 }
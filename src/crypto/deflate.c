@@ -29,6 +29,7 @@ FILE_SECBOOT ( PERMITTED );
 #include <errno.h>
 #include <assert.h>
 #include <ctype.h>
+#include <byteswap.h>
 #include <ipxe/deflate.h>
 
 /** @file
@@ -462,6 +463,307 @@ static void deflate_copy ( struct deflate_chunk *out, const void *in,
 	out->offset += len;
 }
 
+/**
+ * Construct fast lookup table entry
+ *
+ * @v raw		Raw symbol
+ * @v bits		Length of Huffman-coded symbol (in bits)
+ * @v distance		Symbol is from the distance alphabet
+ * @v entry		Fast lookup table entry to fill in
+ */
+static void deflate_fast_entry ( unsigned int raw, unsigned int bits,
+				 int distance, struct deflate_fast *entry ) {
+	unsigned int extra;
+	unsigned int extra_bits;
+
+	/* Record symbol length */
+	entry->bits = bits;
+
+	/* Resolve symbol to value and number of extra bits */
+	if ( distance ) {
+
+		/* Distance code */
+		extra_bits = ( raw / 2 );
+		if ( extra_bits )
+			extra_bits--;
+		entry->value = deflate_distance_base[raw];
+		entry->extra = extra_bits;
+
+	} else if ( raw < DEFLATE_LITLEN_END ) {
+
+		/* Literal value */
+		entry->value = raw;
+		entry->extra = DEFLATE_FAST_LITERAL;
+
+	} else if ( raw == DEFLATE_LITLEN_END ) {
+
+		/* End of block */
+		entry->value = 0;
+		entry->extra = DEFLATE_FAST_END;
+
+	} else {
+
+		/* Length code */
+		extra = ( raw - DEFLATE_LITLEN_END - 1 );
+		if ( extra < 28 ) {
+			extra_bits = ( extra / 4 );
+			if ( extra_bits )
+				extra_bits--;
+			entry->value = deflate_litlen_base[extra];
+			entry->extra = extra_bits;
+		} else {
+			entry->value = 258;
+			entry->extra = 0;
+		}
+	}
+}
+
+/**
+ * Construct fast lookup table
+ *
+ * @v alphabet		Huffman alphabet
+ * @v distance		Alphabet is the distance alphabet
+ */
+static void deflate_tabulate ( struct deflate_alphabet *alphabet,
+			       int distance ) {
+	struct deflate_huf_symbols *huf_sym;
+	struct deflate_fast entry;
+	unsigned int bits;
+	unsigned int first;
+	unsigned int huf;
+	unsigned int index;
+
+	/* Clear table (leaving longer symbols marked as absent) */
+	memset ( alphabet->fast, 0, sizeof ( alphabet->fast ) );
+
+	/* Populate table with all symbols short enough to fit */
+	for ( bits = 1 ; bits <= DEFLATE_FAST_BITS ; bits++ ) {
+		huf_sym = &alphabet->huf[ bits - 1 ];
+		first = ( huf_sym->start >> huf_sym->shift );
+		for ( huf = first ; huf < ( first + huf_sym->freq ) ; huf++ ) {
+
+			/* Construct entry */
+			deflate_fast_entry ( huf_sym->raw[huf], bits,
+					     distance, &entry );
+
+			/* Fill in all indices having this (bit-reversed)
+			 * Huffman-coded symbol as a prefix.
+			 */
+			index = ( ( ( deflate_reverse[ huf & 0xff ] << 8 ) |
+				    deflate_reverse[ huf >> 8 ] ) >>
+				  ( 16 - bits ) );
+			for ( ; index < ( 1 << DEFLATE_FAST_BITS ) ;
+			      index += ( 1 << bits ) ) {
+				alphabet->fast[index] = entry;
+			}
+		}
+	}
+}
+
+/**
+ * Decode a Huffman-coded symbol too long for the fast lookup table
+ *
+ * @v alphabet		Huffman alphabet
+ * @v accumulator	Accumulated input bits
+ * @v distance		Alphabet is the distance alphabet
+ * @v entry		Fast lookup table entry to fill in
+ * @ret entry		Fast lookup table entry
+ */
+static const struct deflate_fast *
+deflate_fast_long ( struct deflate_alphabet *alphabet, uint64_t accumulator,
+		    int distance, struct deflate_fast *entry ) {
+	struct deflate_huf_symbols *huf_sym;
+	uint16_t huf;
+	unsigned int lookup_index;
+
+	/* Normalise the bit-reversed accumulated value to 16 bits */
+	huf = ( ( deflate_reverse[ accumulator & 0xff ] << 8 ) |
+		deflate_reverse[ ( accumulator >> 8 ) & 0xff ] );
+
+	/* Find symbol set for this length */
+	lookup_index = ( huf >> DEFLATE_HUFFMAN_QL_SHIFT );
+	huf_sym = &alphabet->huf[ alphabet->lookup[ lookup_index ] ];
+	while ( huf < huf_sym->start )
+		huf_sym--;
+
+	/* Construct entry */
+	deflate_fast_entry ( huf_sym->raw[ huf >> huf_sym->shift ],
+			     huf_sym->bits, distance, entry );
+
+	return entry;
+}
+
+/**
+ * Copy duplicated string within output buffer
+ *
+ * @v dest		Destination
+ * @v distance		Distance to duplicated string
+ * @v len		Length to copy
+ *
+ * The caller must ensure that the output buffer has space for up to
+ * seven bytes beyond the end of the duplicated string.
+ */
+static void deflate_fast_copy ( uint8_t *dest, size_t distance, size_t len ) {
+	const uint8_t *src = ( dest - distance );
+	uint64_t word;
+	int remaining = len;
+
+	if ( distance >= sizeof ( word ) ) {
+
+		/* Copy a word at a time: no single word can overlap */
+		do {
+			memcpy ( &word, src, sizeof ( word ) );
+			memcpy ( dest, &word, sizeof ( word ) );
+			src += sizeof ( word );
+			dest += sizeof ( word );
+		} while ( ( remaining -= sizeof ( word ) ) > 0 );
+
+	} else if ( distance == 1 ) {
+
+		/* Repeat a single byte */
+		memset ( dest, *src, len );
+
+	} else {
+
+		/* Copy one byte at a time, to allow for overlap */
+		while ( len-- )
+			*(dest++) = *(src++);
+	}
+}
+
+/**
+ * Inflate literal/length and distance symbols using fast lookup tables
+ *
+ * @v deflate		Decompressor
+ * @v out		Output data buffer
+ * @ret rc		Return status code, or positive at end of block
+ *
+ * This decodes complete literal/length and distance pairs for as
+ * long as sufficient input data and output buffer space remain to
+ * guarantee that no symbol can be split by a buffer boundary.  The
+ * caller falls back to the resumable state machine for any
+ * remainder.
+ */
+static int deflate_fast ( struct deflate *deflate,
+			  struct deflate_chunk *out ) {
+	const struct deflate_fast *entry;
+	struct deflate_fast slow;
+	const uint8_t *in = deflate->in;
+	uint8_t *data = out->data;
+	size_t offset = out->offset;
+	uint64_t accumulator = deflate->accumulator;
+	unsigned int bits = deflate->bits;
+	unsigned int extra;
+	unsigned int excess;
+	unsigned int i;
+	uint64_t word;
+	size_t dup_len;
+	size_t dup_distance;
+	int rc = 0;
+
+	while ( ( ( deflate->end - in ) >= DEFLATE_FAST_MIN_IN ) &&
+		( offset <= out->len ) &&
+		( ( out->len - offset ) >= DEFLATE_FAST_MIN_OUT ) ) {
+
+		/* Refill accumulator a word at a time.  Bits above
+		 * the accumulated length are always exact copies of
+		 * the following input data, and so may safely be
+		 * combined with the newly read word.
+		 */
+		memcpy ( &word, in, sizeof ( word ) );
+		accumulator |= ( le64_to_cpu ( word ) << bits );
+		in += ( ( 63 - bits ) / 8 );
+		bits |= 56;
+
+		/* Decode literal/length symbol */
+		entry = &deflate->litlen.fast[ accumulator &
+					       ( ( 1 << DEFLATE_FAST_BITS ) -1 )];
+		if ( ! entry->bits ) {
+			entry = deflate_fast_long ( &deflate->litlen,
+						    accumulator, 0, &slow );
+		}
+		accumulator >>= entry->bits;
+		bits -= entry->bits;
+
+		/* Handle literal values and end of block */
+		if ( entry->extra & DEFLATE_FAST_LITERAL ) {
+			DBGCP ( deflate, "DEFLATE %p literal %#02x\n",
+				deflate, entry->value );
+			data[offset++] = entry->value;
+			continue;
+		}
+		if ( entry->extra & DEFLATE_FAST_END ) {
+			rc = 1;
+			break;
+		}
+
+		/* Calculate duplicate length */
+		extra = ( entry->extra & DEFLATE_FAST_EXTRA_MASK );
+		dup_len = ( entry->value +
+			    ( accumulator & ( ( 1 << extra ) - 1 ) ) );
+		accumulator >>= extra;
+		bits -= extra;
+
+		/* Decode distance symbol */
+		entry = &deflate->distance_codelen.fast[ accumulator &
+					( ( 1 << DEFLATE_FAST_BITS ) - 1 ) ];
+		if ( ! entry->bits ) {
+			entry = deflate_fast_long ( &deflate->distance_codelen,
+						    accumulator, 1, &slow );
+		}
+		accumulator >>= entry->bits;
+		bits -= entry->bits;
+
+		/* Calculate duplicate distance */
+		extra = ( entry->extra & DEFLATE_FAST_EXTRA_MASK );
+		dup_distance = ( entry->value +
+				 ( accumulator & ( ( 1 << extra ) - 1 ) ) );
+		accumulator >>= extra;
+		bits -= extra;
+		DBGCP ( deflate, "DEFLATE %p duplicate length %zd distance "
+			"%zd\n", deflate, dup_len, dup_distance );
+
+		/* Sanity check */
+		if ( dup_distance > offset ) {
+			DBGC ( deflate, "DEFLATE %p bad distance %zd (max "
+			       "%zd)\n", deflate, dup_distance, offset );
+			rc = -EINVAL;
+			break;
+		}
+
+		/* Copy data, allowing for overlap */
+		deflate_fast_copy ( ( data + offset ), dup_distance, dup_len );
+		offset += dup_len;
+	}
+
+	/* Return any whole bytes that will not fit within the
+	 * accumulator.  Such bytes must have been read during this
+	 * call, since the accumulator held at most 32 bits on entry.
+	 */
+	if ( bits > ( 8 * sizeof ( deflate->accumulator ) ) ) {
+		excess = ( ( bits - ( 8 * sizeof ( deflate->accumulator ) )
+			     + 7 ) / 8 );
+		in -= excess;
+		bits -= ( 8 * excess );
+	}
+	accumulator &= ( ( 1ULL << bits ) - 1 );
+
+	/* Update decompressor state */
+	deflate->in = in;
+	deflate->accumulator = accumulator;
+	deflate->bits = bits;
+	deflate->rotalumucca = 0;
+	for ( i = 0 ; i < ( 8 * sizeof ( deflate->rotalumucca ) ) ; i += 8 ) {
+		deflate->rotalumucca |=
+			( ( ( uint32_t ) deflate_reverse[ ( accumulator >> i ) &
+							  0xff ] ) <<
+			  ( 24 - i ) );
+	}
+	out->offset = offset;
+
+	return rc;
+}
+
 /**
  * Inflate compressed data
  *
@@ -781,6 +1083,7 @@ int deflate_inflate ( struct deflate *deflate, const void *data, size_t len,
 		if ( ( rc = deflate_alphabet ( deflate, &deflate->litlen,
 					       deflate->litlen_count, 0 ) ) !=0)
 			return rc;
+		deflate_tabulate ( &deflate->litlen, 0 );
 
 		/* Handle degenerate case of a single distance code
 		 * (for which it is impossible to construct a valid,
@@ -813,6 +1116,7 @@ int deflate_inflate ( struct deflate *deflate, const void *data, size_t len,
 					       distance_count,
 					       distance_offset ) ) != 0 )
 			return rc;
+		deflate_tabulate ( &deflate->distance_codelen, 1 );
 	}
 
  lzhuf_litlen: {
@@ -820,6 +1124,14 @@ int deflate_inflate ( struct deflate *deflate, const void *data, size_t len,
 		uint8_t byte;
 		unsigned int extra;
 		unsigned int bits;
+		int rc;
+
+		/* Decode as much as possible via the fast path */
+		rc = deflate_fast ( deflate, out );
+		if ( rc < 0 )
+			return rc;
+		if ( rc > 0 )
+			goto block_done;
 
 		/* Decode Huffman codes */
 		while ( 1 ) {
@@ -983,6 +1295,37 @@ int deflate_inflate ( struct deflate *deflate, const void *data, size_t len,
 	}
 }
 
+/**
+ * Recover data following the end of the compressed data
+ *
+ * @v deflate		Decompressor
+ * @v data		Buffer to fill in
+ * @v len		Length of buffer
+ * @ret len		Length of recovered data
+ *
+ * Once decompression has finished, the accumulator may still hold
+ * whole bytes of any data following the end of the compressed data
+ * (such as a gzip footer).  These bytes may have been read from an
+ * earlier input data buffer, and so cannot be recovered simply by
+ * rewinding the current input data pointer.
+ */
+size_t deflate_trailer ( struct deflate *deflate, void *data, size_t len ) {
+	uint8_t *bytes = data;
+	size_t used;
+
+	/* Sanity check */
+	assert ( deflate_finished ( deflate ) );
+
+	/* Discard any bits up to the next byte boundary */
+	deflate_discard_to_byte ( deflate );
+
+	/* Extract whole bytes */
+	for ( used = 0 ; ( ( used < len ) && deflate->bits ) ; used++ )
+		bytes[used] = deflate_consume ( deflate, 8 );
+
+	return used;
+}
+
 /**
  * Initialise decompressor
  *
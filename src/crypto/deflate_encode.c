@@ -0,0 +1,308 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+FILE_SECBOOT ( PERMITTED );
+
+#include <string.h>
+#include <ipxe/deflate.h>
+
+/** @file
+ *
+ * DEFLATE compression algorithm
+ *
+ * This file implements a simple streaming compressor for the DEFLATE
+ * algorithm specified in RFC 1951.  The entire input is assumed to be
+ * present in memory, and the output may be produced in arbitrarily
+ * sized pieces.
+ *
+ * Matches are found using a single-entry hash table (i.e. with no
+ * hash chains) and greedy parsing, and are encoded using the static
+ * Huffman codes.  This gives a modest compression ratio for general
+ * data, but an extremely high compression ratio for the long runs of
+ * repeated bytes that typically dominate memory dumps.
+ */
+
+/** Base lengths for length codes 257-285 */
+static const uint16_t deflate_encode_length_base[] = {
+	3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43,
+	51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+};
+
+/** Base distances for distance codes 0-29 */
+static const uint16_t deflate_encode_distance_base[] = {
+	1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257,
+	385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289,
+	16385, 24577
+};
+
+/**
+ * Reverse bits
+ *
+ * @v value		Value
+ * @v bits		Number of bits
+ * @ret reversed	Bit-reversed value
+ */
+static unsigned int deflate_encode_reverse ( unsigned int value,
+					     unsigned int bits ) {
+	unsigned int reversed = 0;
+
+	while ( bits-- ) {
+		reversed = ( ( reversed << 1 ) | ( value & 1 ) );
+		value >>= 1;
+	}
+	return reversed;
+}
+
+/**
+ * Get length of static literal/length code
+ *
+ * @v symbol		Literal/length symbol
+ * @ret bits		Length of code
+ */
+static inline unsigned int deflate_encode_bits ( unsigned int symbol ) {
+
+	if ( symbol < 144 )
+		return 8;
+	if ( symbol < 256 )
+		return 9;
+	if ( symbol < 280 )
+		return 7;
+	return 8;
+}
+
+/**
+ * Write bits to output
+ *
+ * @v encoder		Compressor
+ * @v out		Output data buffer
+ * @v value		Value (in output bit order)
+ * @v bits		Number of bits
+ *
+ * The caller must ensure that sufficient output space is available.
+ */
+static void deflate_encode_put ( struct deflate_encoder *encoder,
+				 struct deflate_chunk *out,
+				 uint32_t value, unsigned int bits ) {
+	uint8_t *data = out->data;
+
+	/* Accumulate bits */
+	encoder->bits |= ( value << encoder->count );
+	encoder->count += bits;
+
+	/* Write out any complete bytes */
+	while ( encoder->count >= 8 ) {
+		data[ out->offset++ ] = encoder->bits;
+		encoder->bits >>= 8;
+		encoder->count -= 8;
+	}
+}
+
+/**
+ * Write literal/length symbol to output
+ *
+ * @v encoder		Compressor
+ * @v out		Output data buffer
+ * @v symbol		Literal/length symbol
+ */
+static inline void deflate_encode_symbol ( struct deflate_encoder *encoder,
+					   struct deflate_chunk *out,
+					   unsigned int symbol ) {
+
+	deflate_encode_put ( encoder, out, encoder->codes[symbol],
+			     deflate_encode_bits ( symbol ) );
+}
+
+/**
+ * Write match to output
+ *
+ * @v encoder		Compressor
+ * @v out		Output data buffer
+ * @v len		Match length
+ * @v distance		Match distance
+ */
+static void deflate_encode_match ( struct deflate_encoder *encoder,
+				   struct deflate_chunk *out,
+				   unsigned int len, unsigned int distance ) {
+	unsigned int code;
+	unsigned int extra;
+
+	/* Write length code and extra bits */
+	code = ( ( sizeof ( deflate_encode_length_base ) /
+		   sizeof ( deflate_encode_length_base[0] ) ) - 1 );
+	while ( deflate_encode_length_base[code] > len )
+		code--;
+	extra = ( ( ( code < 8 ) || ( code == 28 ) ) ?
+		  0 : ( ( code / 4 ) - 1 ) );
+	deflate_encode_symbol ( encoder, out,
+				( DEFLATE_LITLEN_END + 1 + code ) );
+	deflate_encode_put ( encoder, out,
+			     ( len - deflate_encode_length_base[code] ),
+			     extra );
+
+	/* Write distance code and extra bits */
+	code = ( ( sizeof ( deflate_encode_distance_base ) /
+		   sizeof ( deflate_encode_distance_base[0] ) ) - 1 );
+	while ( deflate_encode_distance_base[code] > distance )
+		code--;
+	extra = ( ( code < 4 ) ? 0 : ( ( code / 2 ) - 1 ) );
+	deflate_encode_put ( encoder, out, deflate_encode_reverse ( code, 5 ),
+			     5 );
+	deflate_encode_put ( encoder, out,
+			     ( distance - deflate_encode_distance_base[code] ),
+			     extra );
+}
+
+/**
+ * Find longest match at current input position
+ *
+ * @v encoder		Compressor
+ * @v distance		Match distance to fill in
+ * @ret len		Match length, or zero if no match was found
+ */
+static unsigned int deflate_encode_find ( struct deflate_encoder *encoder,
+					  unsigned int *distance ) {
+	const uint8_t *in = ( encoder->data + encoder->offset );
+	size_t remaining = ( encoder->len - encoder->offset );
+	const uint8_t *prev;
+	unsigned int hash;
+	unsigned int max;
+	unsigned int len;
+	uint32_t candidate;
+
+	/* Look up and update most recent position with this hash */
+	if ( remaining < DEFLATE_ENCODE_MIN_MATCH )
+		return 0;
+	hash = ( ( ( ( in[0] << 16 ) | ( in[1] << 8 ) | in[2] ) *
+		   0x9e3779b1UL ) >> ( 32 - DEFLATE_ENCODE_HASH_BITS ) );
+	hash &= ( ( 1 << DEFLATE_ENCODE_HASH_BITS ) - 1 );
+	candidate = encoder->head[hash];
+	encoder->head[hash] = ( encoder->offset + 1 );
+	if ( ! candidate )
+		return 0;
+
+	/* Check that candidate lies within the permitted distance */
+	*distance = ( encoder->offset + 1 - candidate );
+	if ( *distance > DEFLATE_ENCODE_MAX_DISTANCE )
+		return 0;
+
+	/* Extend match as far as possible */
+	max = ( ( remaining < DEFLATE_ENCODE_MAX_MATCH ) ?
+		remaining : DEFLATE_ENCODE_MAX_MATCH );
+	prev = ( in - *distance );
+	for ( len = 0 ; ( len < max ) && ( prev[len] == in[len] ) ; len++ ) {}
+
+	return ( ( len >= DEFLATE_ENCODE_MIN_MATCH ) ? len : 0 );
+}
+
+/**
+ * Initialise compressor
+ *
+ * @v encoder		Compressor
+ * @v data		Input data
+ * @v len		Length of input data
+ *
+ * The input data must remain valid (and unmodified) until compression
+ * has finished.
+ */
+void deflate_encode_init ( struct deflate_encoder *encoder,
+			   const void *data, size_t len ) {
+	unsigned int base;
+	unsigned int bits;
+	unsigned int i;
+
+	/* Reset state */
+	memset ( encoder, 0, sizeof ( *encoder ) );
+	encoder->data = data;
+	encoder->len = len;
+
+	/* Construct bit-reversed static literal/length codes */
+	for ( i = 0 ; i <= DEFLATE_LITLEN_MAX_CODE ; i++ ) {
+		bits = deflate_encode_bits ( i );
+		if ( i < 144 ) {
+			base = ( 0x030 - 0 );
+		} else if ( i < 256 ) {
+			base = ( 0x190 - 144 );
+		} else if ( i < 280 ) {
+			base = ( 0x000 - 256 );
+		} else {
+			base = ( 0x0c0 - 280 );
+		}
+		encoder->codes[i] = deflate_encode_reverse ( ( base + i ),
+							     bits );
+	}
+
+	/* Start a single final block using the static Huffman codes */
+	encoder->bits = ( ( 1 << DEFLATE_HEADER_BFINAL_BIT ) |
+			  ( DEFLATE_HEADER_BTYPE_STATIC <<
+			    DEFLATE_HEADER_BTYPE_LSB ) );
+	encoder->count = DEFLATE_HEADER_BITS;
+}
+
+/**
+ * Compress data
+ *
+ * @v encoder		Compressor
+ * @v out		Output data buffer
+ *
+ * As much compressed data as will fit is appended to the output data
+ * buffer.  The caller should check deflate_encode_finished() to
+ * determine whether or not more output remains to be produced.
+ */
+void deflate_encode ( struct deflate_encoder *encoder,
+		      struct deflate_chunk *out ) {
+	const uint8_t *in;
+	unsigned int distance;
+	unsigned int len;
+
+	while ( ! encoder->finished ) {
+
+		/* Stop when output buffer is full */
+		if ( ( out->offset > out->len ) ||
+		     ( ( out->len - out->offset ) <
+		       DEFLATE_ENCODE_MAX_SYMBOL_LEN ) ) {
+			break;
+		}
+
+		/* Terminate block at end of input */
+		if ( encoder->offset == encoder->len ) {
+			deflate_encode_symbol ( encoder, out,
+						DEFLATE_LITLEN_END );
+			deflate_encode_put ( encoder, out, 0,
+					     ( ( 8 - encoder->count ) & 7 ) );
+			encoder->finished = 1;
+			break;
+		}
+
+		/* Write match or literal */
+		in = ( encoder->data + encoder->offset );
+		len = deflate_encode_find ( encoder, &distance );
+		if ( len ) {
+			deflate_encode_match ( encoder, out, len, distance );
+			encoder->offset += len;
+		} else {
+			deflate_encode_symbol ( encoder, out, *in );
+			encoder->offset++;
+		}
+	}
+}
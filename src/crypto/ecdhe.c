@@ -35,17 +35,19 @@ FILE_SECBOOT ( PERMITTED );
 #include <ipxe/ecdhe.h>
 
 /**
- * Calculate ECDHE key
+ * Calculate ECDHE shared secret
  *
  * @v curve		Elliptic curve
  * @v partner		Partner public curve point
  * @v private		Private key
- * @v public		Public curve point to fill in (may overlap partner key)
  * @v shared		Shared secret curve point to fill in
  * @ret rc		Return status code
+ *
+ * This may be used when the public curve point corresponding to the
+ * private key has already been calculated.
  */
-int ecdhe_key ( struct elliptic_curve *curve, const void *partner,
-		const void *private, void *public, void *shared ) {
+int ecdhe_shared ( struct elliptic_curve *curve, const void *partner,
+		   const void *private, void *shared ) {
 	int rc;
 
 	/* Construct shared key */
@@ -56,6 +58,34 @@ int ecdhe_key ( struct elliptic_curve *curve, const void *partner,
 		return rc;
 	}
 
+	/* Check that partner and shared keys are not the point at infinity */
+	if ( elliptic_is_infinity ( curve, shared ) ) {
+		DBGC ( curve, "CURVE %s constructed point at infinity\n",
+		       curve->name );
+		return -EPERM;
+	}
+
+	return 0;
+}
+
+/**
+ * Calculate ECDHE key
+ *
+ * @v curve		Elliptic curve
+ * @v partner		Partner public curve point
+ * @v private		Private key
+ * @v public		Public curve point to fill in (may overlap partner key)
+ * @v shared		Shared secret curve point to fill in
+ * @ret rc		Return status code
+ */
+int ecdhe_key ( struct elliptic_curve *curve, const void *partner,
+		const void *private, void *public, void *shared ) {
+	int rc;
+
+	/* Construct shared key */
+	if ( ( rc = ecdhe_shared ( curve, partner, private, shared ) ) != 0 )
+		return rc;
+
 	/* Construct public key */
 	if ( ( rc = elliptic_multiply ( curve, curve->base, private,
 					public ) ) != 0 ) {
@@ -64,12 +94,5 @@ int ecdhe_key ( struct elliptic_curve *curve, const void *partner,
 		return rc;
 	}
 
-	/* Check that partner and shared keys are not the point at infinity */
-	if ( elliptic_is_infinity ( curve, shared ) ) {
-		DBGC ( curve, "CURVE %s constructed point at infinity\n",
-		       curve->name );
-		return -EPERM;
-	}
-
 	return 0;
 }
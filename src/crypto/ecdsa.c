@@ -121,12 +121,12 @@ struct ecdsa_context {
 	bigint_element_t *temp0;
 	/** Element 0 of product buffer */
 	bigint_element_t *product0;
-	/** Curve point 1 */
+	/** Curve point */
 	void *point1;
-	/** Curve point 2 */
-	void *point2;
 	/** Scalar value */
 	void *scalar;
+	/** Second scalar value */
+	void *scalar2;
 	/** HMAC_DRBG state for random value generation */
 	struct hmac_drbg_state *drbg;
 };
@@ -386,8 +386,8 @@ static int ecdsa_alloc ( struct ecdsa_context *ctx ) {
 		bigint_t ( size ) temp;
 		bigint_t ( size * 2 ) product;
 		uint8_t point1[pointsize];
-		uint8_t point2[pointsize];
 		uint8_t scalar[keysize];
+		uint8_t scalar2[keysize];
 		struct hmac_drbg_state drbg;
 	} *dynamic;
 
@@ -410,8 +410,8 @@ static int ecdsa_alloc ( struct ecdsa_context *ctx ) {
 	ctx->temp0 = dynamic->temp.element;
 	ctx->product0 = dynamic->product.element;
 	ctx->point1 = dynamic->point1;
-	ctx->point2 = dynamic->point2;
 	ctx->scalar = dynamic->scalar;
+	ctx->scalar2 = dynamic->scalar2;
 	ctx->drbg = &dynamic->drbg;
 
 	return 0;
@@ -694,8 +694,8 @@ static int ecdsa_verify_rs ( struct ecdsa_context *ctx ) {
 	bigint_t ( size ) __attribute__ (( may_alias )) *x1 =
 		( ( void * ) temp );
 	void *point1 = ctx->point1;
-	void *point2 = ctx->point2;
-	void *scalar = ctx->scalar;
+	void *scalar1 = ctx->scalar;
+	void *scalar2 = ctx->scalar2;
 	int valid;
 	int rc;
 
@@ -711,33 +711,18 @@ static int ecdsa_verify_rs ( struct ecdsa_context *ctx ) {
 	bigint_montgomery ( modulus, product, u1 );
 	DBGC2 ( ctx, "ECDSA %p      u1 = %s mod N\n",
 		ctx, bigint_ntoa ( u1 ) );
-	bigint_done ( u1, scalar, keysize );
-
-	/* Calculate u1 * G */
-	if ( ( rc = elliptic_multiply ( curve, curve->base, scalar,
-					point1 ) ) != 0 ) {
-		DBGC ( ctx, "ECDSA %p could not calculate u1*G: %s\n",
-		       ctx, strerror ( rc ) );
-		return rc;
-	}
+	bigint_done ( u1, scalar1, keysize );
 
 	/* Calculate u2 = (r * s^-1) mod N */
 	bigint_multiply ( r, s, product );
 	bigint_montgomery ( modulus, product, u2 );
-	bigint_done ( u2, scalar, keysize );
+	bigint_done ( u2, scalar2, keysize );
 	DBGC2 ( ctx, "ECDSA %p      u2 = %s mod N\n",
 		ctx, bigint_ntoa ( u2 ) );
 
-	/* Calculate u2 * Qa */
-	if ( ( rc = elliptic_multiply ( curve, public, scalar,
-					point2 ) ) != 0 ) {
-		DBGC ( ctx, "ECDSA %p could not calculate u2*Qa: %s\n",
-		       ctx, strerror ( rc ) );
-		return rc;
-	}
-
-	/* Calculate u1 * G + u2 * Qa */
-	if ( ( rc = elliptic_add ( curve, point1, point2, point1 ) ) != 0 ) {
+	/* Calculate u1 * G + u2 * Qa (all values are public) */
+	if ( ( rc = elliptic_multiply_add ( curve, scalar1, public, scalar2,
+					    point1 ) ) != 0 ) {
 		DBGC ( ctx, "ECDSA %p could not calculate u1*G+u2*Qa: %s\n",
 		       ctx, strerror ( rc ) );
 		return rc;
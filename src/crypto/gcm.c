@@ -110,6 +110,14 @@ static union gcm_block gcm_cached_mult[256];
  */
 static uint16_t gcm_cached_reduce[256];
 
+/**
+ * Disable hardware acceleration
+ *
+ * This may be used to force the use of the generic implementation
+ * (e.g. for self-tests).
+ */
+int gcm_accel_disabled;
+
 /** Offset of a field within GCM context */
 #define gcm_offset( field ) offsetof ( struct gcm_context, field )
 
@@ -308,6 +316,25 @@ static void gcm_multiply_key ( const union gcm_block *key,
 	memcpy ( poly, &res, sizeof ( *poly ) );
 }
 
+/**
+ * Multiply polynomial by context's hash key in situ
+ *
+ * @v context		Context
+ * @v poly		Multiplicand and result
+ */
+static void gcm_multiply ( struct gcm_context *context,
+			   union gcm_block *poly ) {
+
+	/* Use hardware accelerator, if available */
+	if ( context->accel ) {
+		context->accel->multiply ( &context->key, poly );
+		return;
+	}
+
+	/* Otherwise, use cached multiplication tables */
+	gcm_multiply_key ( &context->key, poly );
+}
+
 /**
  * Encrypt/decrypt/authenticate data
  *
@@ -323,6 +350,7 @@ static void gcm_process ( struct gcm_context *context, const void *src,
 	uint64_t *total;
 	size_t frag_len;
 	unsigned int block;
+	size_t count;
 
 	/* Calculate block number (for debugging) */
 	block = ( ( ( context->len.len.add + 8 * sizeof ( tmp ) - 1 ) /
@@ -335,6 +363,18 @@ static void gcm_process ( struct gcm_context *context, const void *src,
 		  &context->len.len.data : &context->len.len.add );
 	*total += ( len * 8 );
 
+	/* Process whole blocks using hardware accelerator, if available */
+	count = ( len / sizeof ( tmp ) );
+	if ( dst && context->accel && count ) {
+		frag_len = ( count * sizeof ( tmp ) );
+		context->accel->crypt ( context, src, dst, count,
+					( flags & GCM_FL_ENCRYPT ) );
+		src += frag_len;
+		dst += frag_len;
+		len -= frag_len;
+		block += count;
+	}
+
 	/* Process data */
 	for ( ; len ; src += frag_len, len -= frag_len, block++ ) {
 
@@ -372,7 +412,7 @@ static void gcm_process ( struct gcm_context *context, const void *src,
 		}
 
 		/* Update hash */
-		gcm_multiply_key ( &context->key, &context->hash );
+		gcm_multiply ( context, &context->hash );
 		DBGC2 ( context, "GCM %p X[%d]:\n", context, block );
 		DBGC2_HDA ( context, 0, &context->hash,
 			    sizeof ( context->hash ) );
@@ -395,7 +435,7 @@ static void gcm_hash ( struct gcm_context *context, union gcm_block *hash ) {
 
 	/* Update hash */
 	gcm_xor_block ( &context->hash, hash );
-	gcm_multiply_key ( &context->key, hash );
+	gcm_multiply ( context, hash );
 	DBGC2 ( context, "GCM %p GHASH(H,A,C):\n", context );
 	DBGC2_HDA ( context, 0, hash, sizeof ( *hash ) );
 }
@@ -428,6 +468,30 @@ void gcm_tag ( struct gcm_context *context, union gcm_block *tag ) {
 	DBGC2_HDA ( context, 0, tag, sizeof ( *tag ) );
 }
 
+/**
+ * Find usable hardware accelerator
+ *
+ * @v raw_cipher	Underlying cipher
+ * @ret accel		Hardware accelerator, or NULL
+ */
+static struct gcm_accelerator *
+gcm_accelerator ( struct cipher_algorithm *raw_cipher ) {
+	struct gcm_accelerator *accel;
+
+	/* Do nothing if hardware acceleration is disabled */
+	if ( gcm_accel_disabled )
+		return NULL;
+
+	/* Use first usable accelerator for this cipher */
+	for_each_table_entry ( accel, GCM_ACCELERATORS ) {
+		if ( ( accel->raw_cipher == raw_cipher ) &&
+		     ( accel->probe() == 0 ) )
+			return accel;
+	}
+
+	return NULL;
+}
+
 /**
  * Set key
  *
@@ -459,6 +523,14 @@ int gcm_setkey ( struct gcm_context *context, const void *key, size_t keylen,
 	/* Reset counter */
 	context->ctr.ctr.value = cpu_to_be32 ( 1 );
 
+	/* Use hardware accelerator, if available */
+	context->accel = gcm_accelerator ( raw_cipher );
+	if ( context->accel ) {
+		DBGC2 ( context, "GCM %p using %s acceleration\n",
+			context, context->accel->name );
+		return 0;
+	}
+
 	/* Construct cached tables */
 	gcm_cache ( &context->key );
 
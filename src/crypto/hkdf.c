@@ -0,0 +1,110 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+FILE_SECBOOT ( PERMITTED );
+
+/** @file
+ *
+ * HMAC-based Extract-and-Expand Key Derivation Function (HKDF)
+ *
+ * HKDF is defined in RFC 5869.
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <ipxe/crypto.h>
+#include <ipxe/hmac.h>
+#include <ipxe/hkdf.h>
+
+/**
+ * Extract pseudorandom key
+ *
+ * @v digest		Digest algorithm
+ * @v salt		Salt
+ * @v salt_len		Length of salt
+ * @v ikm		Input keying material
+ * @v ikm_len		Length of input keying material
+ * @v prk		Pseudorandom key to fill in
+ *
+ * The pseudorandom key buffer must be at least as long as the digest
+ * size.  An empty salt is treated as a string of zeroes of the
+ * digest size, as mandated by RFC 5869.
+ */
+void hkdf_extract ( struct digest_algorithm *digest, const void *salt,
+		    size_t salt_len, const void *ikm, size_t ikm_len,
+		    void *prk ) {
+	uint8_t ctx[ hmac_ctxsize ( digest ) ];
+	uint8_t zero[digest->digestsize];
+
+	/* Use default salt if applicable */
+	if ( ! salt_len ) {
+		memset ( zero, 0, sizeof ( zero ) );
+		salt = zero;
+		salt_len = sizeof ( zero );
+	}
+
+	/* Calculate PRK = HMAC-Hash ( salt, IKM ) */
+	hmac_init ( digest, ctx, salt, salt_len );
+	hmac_update ( digest, ctx, ikm, ikm_len );
+	hmac_final ( digest, ctx, prk );
+}
+
+/**
+ * Expand pseudorandom key
+ *
+ * @v digest		Digest algorithm
+ * @v prk		Pseudorandom key
+ * @v prk_len		Length of pseudorandom key
+ * @v info		Context and application specific information
+ * @v info_len		Length of information
+ * @v okm		Output keying material to fill in
+ * @v okm_len		Length of output keying material
+ *
+ * The output length must not exceed 255 times the digest size.
+ */
+void hkdf_expand ( struct digest_algorithm *digest, const void *prk,
+		   size_t prk_len, const void *info, size_t info_len,
+		   void *okm, size_t okm_len ) {
+	uint8_t ctx[ hmac_ctxsize ( digest ) ];
+	uint8_t block[digest->digestsize];
+	uint8_t counter = 0;
+	size_t frag_len;
+
+	/* Calculate T(i) = HMAC-Hash ( PRK, T(i-1) | info | i ) */
+	while ( okm_len ) {
+		hmac_init ( digest, ctx, prk, prk_len );
+		if ( counter )
+			hmac_update ( digest, ctx, block, sizeof ( block ) );
+		hmac_update ( digest, ctx, info, info_len );
+		counter++;
+		hmac_update ( digest, ctx, &counter, sizeof ( counter ) );
+		hmac_final ( digest, ctx, block );
+		frag_len = okm_len;
+		if ( frag_len > sizeof ( block ) )
+			frag_len = sizeof ( block );
+		memcpy ( okm, block, frag_len );
+		okm += frag_len;
+		okm_len -= frag_len;
+	}
+}
@@ -0,0 +1,527 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+FILE_SECBOOT ( PERMITTED );
+
+#include <string.h>
+#include <errno.h>
+#include <assert.h>
+#include <ipxe/lzma.h>
+
+/** @file
+ *
+ * LZMA2 decompression algorithm
+ *
+ * LZMA2 is the compression format used within xz files.  It consists
+ * of a sequence of chunks, each of which is either uncompressed or
+ * compressed using the LZMA algorithm.
+ *
+ * The entire decompressed output is assumed to be available in
+ * memory, and so no separate dictionary buffer is required.
+ *
+ */
+
+/**
+ * Reset LZMA state
+ *
+ * @v lzma		Decompressor
+ */
+static void lzma_reset ( struct lzma *lzma ) {
+	uint16_t *prob = ( ( uint16_t * ) &lzma->probs );
+	unsigned int count = ( sizeof ( lzma->probs ) / sizeof ( *prob ) );
+
+	/* Reset probabilities */
+	while ( count-- )
+		*(prob++) = LZMA_PROB_INIT;
+
+	/* Reset state and repeated distances */
+	lzma->state = 0;
+	memset ( lzma->rep, 0, sizeof ( lzma->rep ) );
+}
+
+/**
+ * Normalise range coder
+ *
+ * @v lzma		Decompressor
+ */
+static inline void lzma_normalise ( struct lzma *lzma ) {
+	unsigned int byte;
+
+	/* Shift in a new byte if needed.  Any overrun is detected
+	 * when checking for the end of the chunk.
+	 */
+	if ( lzma->range < LZMA_RANGE_TOP ) {
+		byte = ( ( lzma->in < lzma->end ) ? *(lzma->in) : 0 );
+		lzma->in++;
+		lzma->range <<= 8;
+		lzma->code = ( ( lzma->code << 8 ) | byte );
+	}
+}
+
+/**
+ * Decode bit
+ *
+ * @v lzma		Decompressor
+ * @v prob		Probability
+ * @ret bit		Decoded bit
+ */
+static inline unsigned int lzma_bit ( struct lzma *lzma, uint16_t *prob ) {
+	uint32_t bound;
+
+	/* Decode bit and adapt probability */
+	lzma_normalise ( lzma );
+	bound = ( ( lzma->range >> LZMA_PROB_BITS ) * ( *prob ) );
+	if ( lzma->code < bound ) {
+		lzma->range = bound;
+		*prob += ( ( ( 1 << LZMA_PROB_BITS ) - *prob ) >>
+			   LZMA_PROB_MOVE_BITS );
+		return 0;
+	} else {
+		lzma->range -= bound;
+		lzma->code -= bound;
+		*prob -= ( *prob >> LZMA_PROB_MOVE_BITS );
+		return 1;
+	}
+}
+
+/**
+ * Decode bit tree
+ *
+ * @v lzma		Decompressor
+ * @v probs		Probabilities
+ * @v bits		Number of bits
+ * @ret symbol		Decoded symbol
+ */
+static inline unsigned int lzma_tree ( struct lzma *lzma, uint16_t *probs,
+				       unsigned int bits ) {
+	unsigned int symbol = 1;
+	unsigned int bit;
+	unsigned int i;
+
+	for ( i = 0 ; i < bits ; i++ ) {
+		bit = lzma_bit ( lzma, &probs[symbol] );
+		symbol = ( ( symbol << 1 ) | bit );
+	}
+	return ( symbol - ( 1 << bits ) );
+}
+
+/**
+ * Decode reverse bit tree
+ *
+ * @v lzma		Decompressor
+ * @v probs		Probabilities
+ * @v bits		Number of bits
+ * @ret symbol		Decoded symbol
+ */
+static inline unsigned int lzma_reverse ( struct lzma *lzma,
+					  uint16_t *probs,
+					  unsigned int bits ) {
+	unsigned int symbol = 0;
+	unsigned int index = 1;
+	unsigned int bit;
+	unsigned int i;
+
+	for ( i = 0 ; i < bits ; i++ ) {
+		bit = lzma_bit ( lzma, &probs[index] );
+		index = ( ( index << 1 ) | bit );
+		symbol |= ( bit << i );
+	}
+	return symbol;
+}
+
+/**
+ * Decode direct bits
+ *
+ * @v lzma		Decompressor
+ * @v bits		Number of bits
+ * @ret value		Decoded value
+ */
+static uint32_t lzma_direct ( struct lzma *lzma, unsigned int bits ) {
+	uint32_t value = 0;
+
+	while ( bits-- ) {
+		lzma_normalise ( lzma );
+		lzma->range >>= 1;
+		value <<= 1;
+		if ( lzma->code >= lzma->range ) {
+			lzma->code -= lzma->range;
+			value |= 1;
+		}
+	}
+	return value;
+}
+
+/**
+ * Decode length
+ *
+ * @v lzma		Decompressor
+ * @v length		Length decoder
+ * @v pos_state		Position state
+ * @ret len		Decoded length (excluding minimum match length)
+ */
+static unsigned int lzma_length ( struct lzma *lzma,
+				  struct lzma_length *length,
+				  unsigned int pos_state ) {
+
+	if ( ! lzma_bit ( lzma, &length->choice ) ) {
+		return lzma_tree ( lzma, length->low[pos_state], 3 );
+	} else if ( ! lzma_bit ( lzma, &length->choice2 ) ) {
+		return ( LZMA_LEN_LOW_SYMBOLS +
+			 lzma_tree ( lzma, length->mid[pos_state], 3 ) );
+	} else {
+		return ( ( 2 * LZMA_LEN_LOW_SYMBOLS ) +
+			 lzma_tree ( lzma, length->high, 8 ) );
+	}
+}
+
+/**
+ * Decode distance
+ *
+ * @v lzma		Decompressor
+ * @v len		Decoded length (excluding minimum match length)
+ * @ret dist		Decoded distance (excluding minimum distance)
+ */
+static uint32_t lzma_distance ( struct lzma *lzma, unsigned int len ) {
+	struct lzma_probs *probs = &lzma->probs;
+	unsigned int dist_state;
+	unsigned int slot;
+	unsigned int bits;
+	uint32_t dist;
+
+	/* Decode distance slot */
+	dist_state = ( ( len < LZMA_DIST_STATES ) ?
+		       len : ( LZMA_DIST_STATES - 1 ) );
+	slot = lzma_tree ( lzma, probs->dist_slot[dist_state],
+			   LZMA_DIST_SLOT_BITS );
+	if ( slot < LZMA_DIST_MODEL_START )
+		return slot;
+
+	/* Decode remaining distance bits */
+	bits = ( ( slot >> 1 ) - 1 );
+	dist = ( ( 2 | ( slot & 1 ) ) << bits );
+	if ( slot < LZMA_DIST_MODEL_END ) {
+		dist += lzma_reverse ( lzma,
+				       &probs->dist_special[ dist - slot ],
+				       bits );
+	} else {
+		dist += ( lzma_direct ( lzma, ( bits - LZMA_ALIGN_BITS ) )
+			  << LZMA_ALIGN_BITS );
+		dist += lzma_reverse ( lzma, probs->dist_align,
+				       LZMA_ALIGN_BITS );
+	}
+
+	return dist;
+}
+
+/**
+ * Decode literal
+ *
+ * @v lzma		Decompressor
+ * @v pos		Position within dictionary
+ */
+static void lzma_literal ( struct lzma *lzma, size_t pos ) {
+	uint8_t *out = lzma->out;
+	unsigned int prev;
+	unsigned int match;
+	unsigned int match_bit;
+	unsigned int symbol;
+	unsigned int index;
+	unsigned int bit;
+	uint16_t *probs;
+
+	/* Select literal coder */
+	prev = ( pos ? out[ lzma->offset - 1 ] : 0 );
+	probs = lzma->probs.literal[ ( ( pos & ( ( 1 << lzma->lp ) - 1 ) )
+				       << lzma->lc ) +
+				     ( prev >> ( 8 - lzma->lc ) ) ];
+
+	/* Decode literal, using the byte at the most recent match
+	 * distance as context if the previous symbol was a match.
+	 */
+	symbol = 1;
+	if ( ( lzma->state >= LZMA_LITERAL_STATES ) &&
+	     ( lzma->rep[0] < pos ) ) {
+		match = out[ lzma->offset - lzma->rep[0] - 1 ];
+		do {
+			match_bit = ( ( match >> 7 ) & 1 );
+			match <<= 1;
+			index = ( ( ( 1 + match_bit ) << 8 ) + symbol );
+			bit = lzma_bit ( lzma, &probs[index] );
+			symbol = ( ( symbol << 1 ) | bit );
+			if ( bit != match_bit )
+				break;
+		} while ( symbol < 0x100 );
+	}
+	while ( symbol < 0x100 ) {
+		bit = lzma_bit ( lzma, &probs[symbol] );
+		symbol = ( ( symbol << 1 ) | bit );
+	}
+	out[ lzma->offset++ ] = symbol;
+
+	/* Update state */
+	if ( lzma->state < 4 ) {
+		lzma->state = 0;
+	} else if ( lzma->state < 10 ) {
+		lzma->state -= 3;
+	} else {
+		lzma->state -= 6;
+	}
+}
+
+/**
+ * Decompress LZMA chunk
+ *
+ * @v lzma		Decompressor
+ * @v len		Length of decompressed data
+ * @ret rc		Return status code
+ */
+static int lzma_chunk ( struct lzma *lzma, size_t len ) {
+	struct lzma_probs *probs = &lzma->probs;
+	unsigned int pos_state;
+	unsigned int state;
+	int literal;
+	size_t end = ( lzma->offset + len );
+	size_t pos;
+	unsigned int match_len;
+	uint32_t dist;
+	uint8_t *src;
+	uint8_t *dest;
+
+	/* Check that output is large enough */
+	if ( ( end > lzma->max ) || ( end < lzma->offset ) ) {
+		DBGC ( lzma, "LZMA %p output overrun\n", lzma );
+		return -EINVAL;
+	}
+
+	/* Decode symbols */
+	while ( lzma->offset < end ) {
+
+		/* Decode literal, if applicable */
+		pos = ( lzma->offset - lzma->dict );
+		pos_state = ( pos & ( ( 1 << lzma->pb ) - 1 ) );
+		state = lzma->state;
+		literal = ( state < LZMA_LITERAL_STATES );
+		if ( ! lzma_bit ( lzma, &probs->is_match[state][pos_state] ) ) {
+			lzma_literal ( lzma, pos );
+			continue;
+		}
+
+		/* Decode match */
+		if ( lzma_bit ( lzma, &probs->is_rep[state] ) ) {
+
+			/* Repeated match */
+			if ( ! lzma_bit ( lzma, &probs->is_rep0[state] ) ) {
+				if ( ! lzma_bit ( lzma, &probs->is_rep0_long
+						  [state][pos_state] ) ) {
+					/* Short repeated match */
+					if ( lzma->rep[0] >= pos )
+						return -EINVAL;
+					lzma->state = ( literal ? 9 : 11 );
+					lzma->out[lzma->offset] =
+						lzma->out[ lzma->offset -
+							   lzma->rep[0] - 1 ];
+					lzma->offset++;
+					continue;
+				}
+			} else {
+				if ( ! lzma_bit ( lzma,
+						  &probs->is_rep1[state] ) ) {
+					dist = lzma->rep[1];
+				} else {
+					if ( ! lzma_bit ( lzma,
+						&probs->is_rep2[state] ) ) {
+						dist = lzma->rep[2];
+					} else {
+						dist = lzma->rep[3];
+						lzma->rep[3] = lzma->rep[2];
+					}
+					lzma->rep[2] = lzma->rep[1];
+				}
+				lzma->rep[1] = lzma->rep[0];
+				lzma->rep[0] = dist;
+			}
+			match_len = lzma_length ( lzma, &probs->rep_len,
+						  pos_state );
+			lzma->state = ( literal ? 8 : 11 );
+
+		} else {
+
+			/* Simple match */
+			lzma->rep[3] = lzma->rep[2];
+			lzma->rep[2] = lzma->rep[1];
+			lzma->rep[1] = lzma->rep[0];
+			match_len = lzma_length ( lzma, &probs->match_len,
+						  pos_state );
+			lzma->state = ( literal ? 7 : 10 );
+			lzma->rep[0] = lzma_distance ( lzma, match_len );
+		}
+
+		/* Copy duplicated string */
+		match_len += LZMA_MATCH_MIN_LEN;
+		if ( lzma->rep[0] >= pos ) {
+			DBGC ( lzma, "LZMA %p invalid distance %#x at %#zx\n",
+			       lzma, lzma->rep[0], pos );
+			return -EINVAL;
+		}
+		if ( match_len > ( end - lzma->offset ) ) {
+			DBGC ( lzma, "LZMA %p match overruns chunk\n", lzma );
+			return -EINVAL;
+		}
+		dest = ( lzma->out + lzma->offset );
+		src = ( dest - lzma->rep[0] - 1 );
+		lzma->offset += match_len;
+		while ( match_len-- )
+			*(dest++) = *(src++);
+	}
+
+	return 0;
+}
+
+/**
+ * Decompress LZMA2 data
+ *
+ * @v lzma		Decompressor
+ * @v data		Compressed data
+ * @v len		Length of available compressed data
+ * @v used		Length of compressed data consumed
+ * @ret rc		Return status code
+ *
+ * The dictionary is reset at the start of the LZMA2 data, and the
+ * decompressed data is appended to the output buffer.
+ */
+int lzma2_decompress ( struct lzma *lzma, const void *data, size_t len,
+		       size_t *used ) {
+	const uint8_t *bytes = data;
+	const uint8_t *end = ( bytes + len );
+	unsigned int control;
+	unsigned int props;
+	int need_dict = 1;
+	int need_props = 1;
+	size_t uncompressed;
+	size_t compressed;
+	int rc;
+
+	while ( 1 ) {
+
+		/* Parse control byte */
+		if ( bytes >= end )
+			return -EINVAL;
+		control = *(bytes++);
+		if ( control == 0x00 )
+			break;
+
+		/* Handle dictionary reset */
+		if ( ( control == 0x01 ) || ( control >= 0xe0 ) ) {
+			lzma->dict = lzma->offset;
+			need_dict = 0;
+			need_props = 1;
+		} else if ( need_dict ) {
+			DBGC ( lzma, "LZMA %p missing dictionary reset\n",
+			       lzma );
+			return -EINVAL;
+		}
+
+		/* Handle uncompressed chunks */
+		if ( control < 0x80 ) {
+			if ( control > 0x02 )
+				return -EINVAL;
+			if ( ( end - bytes ) < 2 )
+				return -EINVAL;
+			uncompressed = ( ( ( bytes[0] << 8 ) | bytes[1] ) + 1 );
+			bytes += 2;
+			if ( uncompressed > ( size_t ) ( end - bytes ) )
+				return -EINVAL;
+			if ( uncompressed > ( lzma->max - lzma->offset ) )
+				return -EINVAL;
+			memcpy ( ( lzma->out + lzma->offset ), bytes,
+				 uncompressed );
+			lzma->offset += uncompressed;
+			bytes += uncompressed;
+			continue;
+		}
+
+		/* Parse LZMA chunk header */
+		if ( ( end - bytes ) < 4 )
+			return -EINVAL;
+		uncompressed = ( ( ( control & 0x1f ) << 16 ) |
+				 ( bytes[0] << 8 ) | bytes[1] );
+		uncompressed += 1;
+		compressed = ( ( ( bytes[2] << 8 ) | bytes[3] ) + 1 );
+		bytes += 4;
+
+		/* Parse properties, if present, and reset state */
+		if ( control >= 0xc0 ) {
+			if ( bytes >= end )
+				return -EINVAL;
+			props = *(bytes++);
+			if ( props > LZMA_PROPS_MAX )
+				return -EINVAL;
+			lzma->lc = ( props % 9 );
+			props /= 9;
+			lzma->lp = ( props % 5 );
+			lzma->pb = ( props / 5 );
+			if ( ( lzma->lc + lzma->lp ) > LZMA_LITERAL_BITS_MAX ) {
+				DBGC ( lzma, "LZMA %p invalid properties "
+				       "lc=%d lp=%d\n", lzma, lzma->lc,
+				       lzma->lp );
+				return -EINVAL;
+			}
+			need_props = 0;
+			lzma_reset ( lzma );
+		} else if ( need_props ) {
+			DBGC ( lzma, "LZMA %p missing properties\n", lzma );
+			return -EINVAL;
+		} else if ( control >= 0xa0 ) {
+			lzma_reset ( lzma );
+		}
+
+		/* Initialise range coder */
+		if ( compressed > ( size_t ) ( end - bytes ) )
+			return -EINVAL;
+		if ( ( compressed < LZMA_RANGE_INIT_LEN ) || ( bytes[0] != 0 ) )
+			return -EINVAL;
+		lzma->in = ( bytes + LZMA_RANGE_INIT_LEN );
+		lzma->end = ( bytes + compressed );
+		lzma->range = 0xffffffffUL;
+		lzma->code = ( ( bytes[1] << 24 ) | ( bytes[2] << 16 ) |
+			       ( bytes[3] << 8 ) | bytes[4] );
+
+		/* Decompress chunk */
+		if ( ( rc = lzma_chunk ( lzma, uncompressed ) ) != 0 )
+			return rc;
+
+		/* Check that chunk was consumed exactly (including any
+		 * final normalisation following the last decoded bit).
+		 */
+		lzma_normalise ( lzma );
+		if ( ( lzma->in != lzma->end ) || ( lzma->code != 0 ) ) {
+			DBGC ( lzma, "LZMA %p chunk length mismatch\n", lzma );
+			return -EINVAL;
+		}
+		bytes += compressed;
+	}
+
+	*used = ( bytes - ( ( const uint8_t * ) data ) );
+	return 0;
+}
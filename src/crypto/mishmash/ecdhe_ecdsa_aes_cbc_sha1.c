@@ -33,7 +33,7 @@ FILE_SECBOOT ( PERMITTED );
 
 /** TLS_ECDHE_ECDSA_WITH_AES_128_CBC_SHA cipher suite */
 struct tls_cipher_suite
-tls_ecdhe_ecdsa_with_aes_128_cbc_sha __tls_cipher_suite ( 05 ) = {
+tls_ecdhe_ecdsa_with_aes_128_cbc_sha __tls_cipher_suite ( 07 ) = {
 	.code = htons ( TLS_ECDHE_ECDSA_WITH_AES_128_CBC_SHA ),
 	.key_len = ( 128 / 8 ),
 	.fixed_iv_len = 0,
@@ -48,7 +48,7 @@ tls_ecdhe_ecdsa_with_aes_128_cbc_sha __tls_cipher_suite ( 05 ) = {
 
 /** TLS_ECDHE_ECDSA_WITH_AES_256_CBC_SHA cipher suite */
 struct tls_cipher_suite
-tls_ecdhe_ecdsa_with_aes_256_cbc_sha __tls_cipher_suite ( 06 ) = {
+tls_ecdhe_ecdsa_with_aes_256_cbc_sha __tls_cipher_suite ( 08 ) = {
 	.code = htons ( TLS_ECDHE_ECDSA_WITH_AES_256_CBC_SHA ),
 	.key_len = ( 256 / 8 ),
 	.fixed_iv_len = 0,
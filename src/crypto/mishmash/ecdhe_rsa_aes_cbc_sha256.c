@@ -32,7 +32,7 @@ FILE_SECBOOT ( PERMITTED );
 
 /** TLS_ECDHE_RSA_WITH_AES_128_CBC_SHA256 cipher suite */
 struct tls_cipher_suite
-tls_ecdhe_rsa_with_aes_128_cbc_sha256 __tls_cipher_suite ( 03 ) = {
+tls_ecdhe_rsa_with_aes_128_cbc_sha256 __tls_cipher_suite ( 05 ) = {
 	.code = htons ( TLS_ECDHE_RSA_WITH_AES_128_CBC_SHA256 ),
 	.key_len = ( 128 / 8 ),
 	.fixed_iv_len = 0,
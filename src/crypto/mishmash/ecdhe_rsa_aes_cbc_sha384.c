@@ -32,7 +32,7 @@ FILE_SECBOOT ( PERMITTED );
 
 /** TLS_ECDHE_RSA_WITH_AES_256_CBC_SHA384 cipher suite */
 struct tls_cipher_suite
-tls_ecdhe_rsa_with_aes_256_cbc_sha384 __tls_cipher_suite ( 04 ) = {
+tls_ecdhe_rsa_with_aes_256_cbc_sha384 __tls_cipher_suite ( 06 ) = {
 	.code = htons ( TLS_ECDHE_RSA_WITH_AES_256_CBC_SHA384 ),
 	.key_len = ( 256 / 8 ),
 	.fixed_iv_len = 0,
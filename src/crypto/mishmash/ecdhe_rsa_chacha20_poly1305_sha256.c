@@ -0,0 +1,47 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+FILE_SECBOOT ( PERMITTED );
+
+#include <byteswap.h>
+#include <ipxe/rsa.h>
+#include <ipxe/chacha20.h>
+#include <ipxe/sha256.h>
+#include <ipxe/tls.h>
+
+/** TLS_ECDHE_RSA_WITH_CHACHA20_POLY1305_SHA256 cipher suite */
+struct tls_cipher_suite
+tls_ecdhe_rsa_with_chacha20_poly1305_sha256
+__tls_cipher_suite ( TLS_CHACHA20_POLY1305_PREF ) = {
+	.code = htons ( TLS_ECDHE_RSA_WITH_CHACHA20_POLY1305_SHA256 ),
+	.key_len = CHACHA20_KEY_LEN,
+	.fixed_iv_len = CHACHA20_NONCE_LEN,
+	.record_iv_len = 0,
+	.mac_len = 0,
+	.exchange = &tls_ecdhe_exchange_algorithm,
+	.pubkey = &rsa_algorithm,
+	.cipher = &chacha20_poly1305_algorithm,
+	.digest = &sha256_algorithm,
+	.handshake = &sha256_algorithm,
+};
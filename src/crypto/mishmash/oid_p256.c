@@ -40,7 +40,7 @@ struct asn1_algorithm prime256v1_algorithm __asn1_algorithm = {
 };
 
 /** P-256 named curve */
-struct tls_named_curve tls_secp256r1_named_curve __tls_named_curve ( 01 ) = {
+struct tls_named_curve tls_secp256r1_named_curve __tls_named_curve ( 02 ) = {
 	.curve = &p256_curve,
 	.code = htons ( TLS_NAMED_CURVE_SECP256R1 ),
 	.format = TLS_POINT_FORMAT_UNCOMPRESSED,
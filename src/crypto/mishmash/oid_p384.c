@@ -40,7 +40,7 @@ struct asn1_algorithm secp384r1_algorithm __asn1_algorithm = {
 };
 
 /** P-384 named curve */
-struct tls_named_curve tls_secp384r1_named_curve __tls_named_curve ( 01 ) = {
+struct tls_named_curve tls_secp384r1_named_curve __tls_named_curve ( 03 ) = {
 	.curve = &p384_curve,
 	.code = htons ( TLS_NAMED_CURVE_SECP384R1 ),
 	.format = TLS_POINT_FORMAT_UNCOMPRESSED,
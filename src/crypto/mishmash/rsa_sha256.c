@@ -61,3 +61,15 @@ struct tls_signature_hash_algorithm tls_rsa_sha256 __tls_sig_hash_algorithm = {
 	.pubkey = &rsa_algorithm,
 	.digest = &sha256_algorithm,
 };
+
+/** RSA-PSS with SHA-256 signature hash algorithm */
+struct tls_signature_hash_algorithm
+tls_rsa_pss_sha256 __tls_sig_hash_algorithm = {
+	.code = {
+		.signature = TLS_RSA_PSS_RSAE_SHA256_ALGORITHM,
+		.hash = TLS_INTRINSIC_ALGORITHM,
+	},
+	.pubkey = &rsa_pss_algorithm,
+	.key = &rsa_algorithm,
+	.digest = &sha256_algorithm,
+};
@@ -944,8 +944,14 @@ int ocsp_validate ( struct ocsp_check *ocsp, time_t time ) {
 	DBGC2 ( ocsp, "OCSP %p \"%s\" response is valid (at time %lld)\n",
 		ocsp, x509_name ( ocsp->cert ), time );
 
-	/* Mark certificate as passing OCSP verification */
+	/* Mark certificate as passing OCSP verification.  This status
+	 * is recorded in the (shared) certificate, and so will be
+	 * reused by any subsequent validation until the response
+	 * becomes stale.
+	 */
 	ocsp->cert->extensions.auth_info.ocsp.good = 1;
+	ocsp->cert->extensions.auth_info.ocsp.expiry =
+		( response->next_update + TIMESTAMP_ERROR_MARGIN );
 
 	/* Validate certificate against issuer */
 	if ( ( rc = x509_validate ( ocsp->cert, ocsp->issuer, time,
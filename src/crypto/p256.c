@@ -39,6 +39,12 @@ static const uint8_t p256_prime[P256_LEN] = {
 	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff
 };
 
+/** P-256 field prime in Solinas form
+ *
+ * N = 2^256 - 2^224 + 2^192 + 2^96 - 1
+ */
+static const int8_t p256_solinas[] = { 9, -8, 7, 4, -1, 0 };
+
 /** P-256 constant "a" */
 static const uint8_t p256_a[P256_LEN] = {
 	0xff, 0xff, 0xff, 0xff, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00,
@@ -72,4 +78,5 @@ static const uint8_t p256_order[P256_LEN] = {
 
 /** P-256 elliptic curve */
 WEIERSTRASS_CURVE ( p256, p256_curve, P256_LEN,
-		    p256_prime, p256_a, p256_b, p256_base, p256_order );
+		    p256_prime, p256_a, p256_b, p256_base, p256_order,
+		    p256_solinas );
@@ -41,6 +41,12 @@ static const uint8_t p384_prime[P384_LEN] = {
 	0xff, 0xff, 0xff, 0xff
 };
 
+/** P-384 field prime in Solinas form
+ *
+ * N = 2^384 - 2^128 - 2^96 + 2^32 - 1
+ */
+static const int8_t p384_solinas[] = { 13, -5, -4, 2, -1, 0 };
+
 /** P-384 constant "a" */
 static const uint8_t p384_a[P384_LEN] = {
 	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
@@ -83,4 +89,5 @@ static const uint8_t p384_order[P384_LEN] = {
 
 /** P-384 elliptic curve */
 WEIERSTRASS_CURVE ( p384, p384_curve, P384_LEN,
-		    p384_prime, p384_a, p384_b, p384_base, p384_order );
+		    p384_prime, p384_a, p384_b, p384_base, p384_order,
+		    p384_solinas );
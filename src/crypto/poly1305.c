@@ -0,0 +1,294 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+FILE_SECBOOT ( PERMITTED );
+
+/** @file
+ *
+ * Poly1305 message authentication code
+ *
+ * This is an implementation of the Poly1305 one-time authenticator
+ * as described in RFC 8439.  Arithmetic modulo 2^130-5 is performed
+ * using five 26-bit limbs, which is efficient on 32-bit CPUs.
+ *
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <byteswap.h>
+#include <ipxe/poly1305.h>
+
+/** Mask for a 26-bit limb */
+#define POLY1305_LIMB_MASK 0x03ffffffUL
+
+/**
+ * Read little-endian 32-bit value
+ *
+ * @v data		Data
+ * @ret value		Value
+ */
+static inline __attribute__ (( always_inline )) uint32_t
+poly1305_le32 ( const void *data ) {
+	uint32_t value;
+
+	memcpy ( &value, data, sizeof ( value ) );
+	return le32_to_cpu ( value );
+}
+
+/**
+ * Initialise Poly1305 context
+ *
+ * @v poly		Poly1305 context
+ * @v key		One-time key
+ */
+void poly1305_init ( struct poly1305_context *poly, const void *key ) {
+	const uint8_t *byte = key;
+	unsigned int i;
+
+	/* Split clamped "r" into 26-bit limbs */
+	poly->r[0] = ( ( poly1305_le32 ( byte + 0 ) >> 0 ) & 0x03ffffff );
+	poly->r[1] = ( ( poly1305_le32 ( byte + 3 ) >> 2 ) & 0x03ffff03 );
+	poly->r[2] = ( ( poly1305_le32 ( byte + 6 ) >> 4 ) & 0x03ffc0ff );
+	poly->r[3] = ( ( poly1305_le32 ( byte + 9 ) >> 6 ) & 0x03f03fff );
+	poly->r[4] = ( ( poly1305_le32 ( byte + 12 ) >> 8 ) & 0x000fffff );
+
+	/* Record "s" */
+	for ( i = 0 ; i < 4 ; i++ )
+		poly->s[i] = poly1305_le32 ( byte + 16 + ( 4 * i ) );
+
+	/* Clear accumulator */
+	memset ( poly->h, 0, sizeof ( poly->h ) );
+	poly->len = 0;
+}
+
+/**
+ * Process Poly1305 block
+ *
+ * @v poly		Poly1305 context
+ * @v data		Block
+ * @v hibit		High bit to be added to block (2^128 or zero)
+ */
+static void poly1305_block ( struct poly1305_context *poly, const void *data,
+			     uint32_t hibit ) {
+	const uint8_t *byte = data;
+	uint32_t r0 = poly->r[0];
+	uint32_t r1 = poly->r[1];
+	uint32_t r2 = poly->r[2];
+	uint32_t r3 = poly->r[3];
+	uint32_t r4 = poly->r[4];
+	uint32_t s1 = ( r1 * 5 );
+	uint32_t s2 = ( r2 * 5 );
+	uint32_t s3 = ( r3 * 5 );
+	uint32_t s4 = ( r4 * 5 );
+	uint32_t h0 = poly->h[0];
+	uint32_t h1 = poly->h[1];
+	uint32_t h2 = poly->h[2];
+	uint32_t h3 = poly->h[3];
+	uint32_t h4 = poly->h[4];
+	uint64_t d0;
+	uint64_t d1;
+	uint64_t d2;
+	uint64_t d3;
+	uint64_t d4;
+	uint32_t carry;
+
+	/* Add block to accumulator */
+	h0 += ( ( poly1305_le32 ( byte + 0 ) >> 0 ) & POLY1305_LIMB_MASK );
+	h1 += ( ( poly1305_le32 ( byte + 3 ) >> 2 ) & POLY1305_LIMB_MASK );
+	h2 += ( ( poly1305_le32 ( byte + 6 ) >> 4 ) & POLY1305_LIMB_MASK );
+	h3 += ( ( poly1305_le32 ( byte + 9 ) >> 6 ) & POLY1305_LIMB_MASK );
+	h4 += ( ( poly1305_le32 ( byte + 12 ) >> 8 ) | hibit );
+
+	/* Multiply accumulator by "r" modulo 2^130-5 (using the
+	 * identity 2^130 = 5 to fold the upper partial products)
+	 */
+	d0 = ( ( ( uint64_t ) h0 * r0 ) + ( ( uint64_t ) h1 * s4 ) +
+	       ( ( uint64_t ) h2 * s3 ) + ( ( uint64_t ) h3 * s2 ) +
+	       ( ( uint64_t ) h4 * s1 ) );
+	d1 = ( ( ( uint64_t ) h0 * r1 ) + ( ( uint64_t ) h1 * r0 ) +
+	       ( ( uint64_t ) h2 * s4 ) + ( ( uint64_t ) h3 * s3 ) +
+	       ( ( uint64_t ) h4 * s2 ) );
+	d2 = ( ( ( uint64_t ) h0 * r2 ) + ( ( uint64_t ) h1 * r1 ) +
+	       ( ( uint64_t ) h2 * r0 ) + ( ( uint64_t ) h3 * s4 ) +
+	       ( ( uint64_t ) h4 * s3 ) );
+	d3 = ( ( ( uint64_t ) h0 * r3 ) + ( ( uint64_t ) h1 * r2 ) +
+	       ( ( uint64_t ) h2 * r1 ) + ( ( uint64_t ) h3 * r0 ) +
+	       ( ( uint64_t ) h4 * s4 ) );
+	d4 = ( ( ( uint64_t ) h0 * r4 ) + ( ( uint64_t ) h1 * r3 ) +
+	       ( ( uint64_t ) h2 * r2 ) + ( ( uint64_t ) h3 * r1 ) +
+	       ( ( uint64_t ) h4 * r0 ) );
+
+	/* Propagate carries (partially reducing the result) */
+	carry = ( d0 >> 26 );	h0 = ( d0 & POLY1305_LIMB_MASK );
+	d1 += carry;
+	carry = ( d1 >> 26 );	h1 = ( d1 & POLY1305_LIMB_MASK );
+	d2 += carry;
+	carry = ( d2 >> 26 );	h2 = ( d2 & POLY1305_LIMB_MASK );
+	d3 += carry;
+	carry = ( d3 >> 26 );	h3 = ( d3 & POLY1305_LIMB_MASK );
+	d4 += carry;
+	carry = ( d4 >> 26 );	h4 = ( d4 & POLY1305_LIMB_MASK );
+	h0 += ( carry * 5 );
+	carry = ( h0 >> 26 );	h0 &= POLY1305_LIMB_MASK;
+	h1 += carry;
+
+	/* Store accumulator */
+	poly->h[0] = h0;
+	poly->h[1] = h1;
+	poly->h[2] = h2;
+	poly->h[3] = h3;
+	poly->h[4] = h4;
+}
+
+/**
+ * Accumulate data
+ *
+ * @v poly		Poly1305 context
+ * @v data		Data
+ * @v len		Length of data
+ */
+void poly1305_update ( struct poly1305_context *poly, const void *data,
+		       size_t len ) {
+	const uint8_t *byte = data;
+	size_t frag_len;
+
+	/* Complete any partial block */
+	if ( poly->len ) {
+		frag_len = ( sizeof ( poly->data ) - poly->len );
+		if ( frag_len > len )
+			frag_len = len;
+		memcpy ( &poly->data[poly->len], byte, frag_len );
+		poly->len += frag_len;
+		byte += frag_len;
+		len -= frag_len;
+		if ( poly->len < sizeof ( poly->data ) )
+			return;
+		poly1305_block ( poly, poly->data, ( 1UL << 24 ) );
+		poly->len = 0;
+	}
+
+	/* Process whole blocks directly */
+	while ( len >= sizeof ( poly->data ) ) {
+		poly1305_block ( poly, byte, ( 1UL << 24 ) );
+		byte += sizeof ( poly->data );
+		len -= sizeof ( poly->data );
+	}
+
+	/* Accumulate any remaining partial block */
+	memcpy ( poly->data, byte, len );
+	poly->len = len;
+}
+
+/**
+ * Pad accumulated data with zeros to a whole number of blocks
+ *
+ * @v poly		Poly1305 context
+ *
+ * This is the padding used by the ChaCha20-Poly1305 construction
+ * described in RFC 8439.  Padding is a no-op if the accumulated data
+ * is already a whole number of blocks.
+ */
+void poly1305_pad ( struct poly1305_context *poly ) {
+
+	/* Pad and process any partial block */
+	if ( poly->len ) {
+		memset ( &poly->data[poly->len], 0,
+			 ( sizeof ( poly->data ) - poly->len ) );
+		poly1305_block ( poly, poly->data, ( 1UL << 24 ) );
+		poly->len = 0;
+	}
+}
+
+/**
+ * Generate authentication tag
+ *
+ * @v poly		Poly1305 context
+ * @v tag		Authentication tag to fill in
+ */
+void poly1305_final ( struct poly1305_context *poly, void *tag ) {
+	uint32_t *h = poly->h;
+	uint32_t g[5];
+	uint32_t out[4];
+	uint32_t carry;
+	uint32_t mask;
+	uint64_t sum;
+	unsigned int i;
+
+	/* Process any final partial block, with the high bit
+	 * appended immediately after the data
+	 */
+	if ( poly->len ) {
+		poly->data[ poly->len++ ] = 1;
+		memset ( &poly->data[poly->len], 0,
+			 ( sizeof ( poly->data ) - poly->len ) );
+		poly1305_block ( poly, poly->data, 0 );
+		poly->len = 0;
+	}
+
+	/* Fully propagate carries */
+	for ( i = 1 ; i < 5 ; i++ ) {
+		carry = ( h[ i - 1 ] >> 26 );
+		h[ i - 1 ] &= POLY1305_LIMB_MASK;
+		h[i] += carry;
+	}
+	carry = ( h[4] >> 26 );
+	h[4] &= POLY1305_LIMB_MASK;
+	h[0] += ( carry * 5 );
+	carry = ( h[0] >> 26 );
+	h[0] &= POLY1305_LIMB_MASK;
+	h[1] += carry;
+
+	/* Calculate g = h + 5 - 2^130 */
+	carry = 5;
+	for ( i = 0 ; i < 5 ; i++ ) {
+		g[i] = ( h[i] + carry );
+		carry = ( g[i] >> 26 );
+		g[i] &= POLY1305_LIMB_MASK;
+	}
+	g[4] -= ( 1UL << 26 );
+	g[4] += ( carry << 26 );
+
+	/* Select h if h < 2^130-5, otherwise select g (in constant
+	 * time).  The subtraction of 2^130 will have underflowed
+	 * (setting the top bit of g[4]) if and only if h < 2^130-5.
+	 */
+	mask = ( ( g[4] >> 31 ) - 1 );
+	for ( i = 0 ; i < 5 ; i++ )
+		h[i] = ( ( h[i] & ~mask ) | ( g[i] & mask ) );
+
+	/* Convert to 32-bit words (discarding bits above 2^128) */
+	out[0] = ( ( h[0] >> 0 ) | ( h[1] << 26 ) );
+	out[1] = ( ( h[1] >> 6 ) | ( h[2] << 20 ) );
+	out[2] = ( ( h[2] >> 12 ) | ( h[3] << 14 ) );
+	out[3] = ( ( h[3] >> 18 ) | ( h[4] << 8 ) );
+
+	/* Add "s" modulo 2^128 */
+	sum = 0;
+	for ( i = 0 ; i < 4 ; i++ ) {
+		sum += ( ( uint64_t ) out[i] + poly->s[i] );
+		out[i] = cpu_to_le32 ( ( uint32_t ) sum );
+		sum >>= 32;
+	}
+	memcpy ( tag, out, sizeof ( out ) );
+}
@@ -60,8 +60,16 @@ FILE_SECBOOT ( PERMITTED );
 #include <ipxe/drbg.h>
 #include <ipxe/rbg.h>
 
+static void rbg_step ( struct random_bit_generator *rbg );
+
+/** RBG startup process descriptor */
+static struct process_descriptor rbg_process_desc =
+	PROC_DESC_ONCE ( struct random_bit_generator, process, rbg_step );
+
 /** The RBG */
-struct random_bit_generator rbg;
+struct random_bit_generator rbg = {
+	.process = PROC_INIT ( rbg.process, &rbg_process_desc ),
+};
 
 /**
  * Start up RBG
@@ -78,6 +86,7 @@ static int rbg_startup ( void ) {
 
 	/* Record that startup has been attempted (even if unsuccessful) */
 	rbg.started = 1;
+	process_del ( &rbg.process );
 
 	/* Try to obtain system UUID for use as personalisation
 	 * string, in accordance with ANS X9.82 Part 3-2007 Section
@@ -141,21 +150,42 @@ static void rbg_shutdown ( void ) {
 	rbg.started = 0;
 }
 
-/** RBG startup function */
-static void rbg_startup_fn ( void ) {
+/**
+ * RBG startup process
+ *
+ * @v rbg		Random bit generator
+ */
+static void rbg_step ( struct random_bit_generator *rbg ) {
 
 	/* Start up RBG (if not already started on demand).  There is
 	 * no way to report an error at this stage, but a failed
 	 * startup will result in an invalid DRBG that refuses to
 	 * generate bits.
 	 */
-	if ( ! rbg.started )
+	if ( ! rbg->started )
 		rbg_startup();
 }
 
+/** RBG startup function */
+static void rbg_startup_fn ( void ) {
+
+	/* Defer startup to a background process.  Gathering entropy
+	 * from a slow source may take a significant amount of time,
+	 * which can then overlap with other activity (such as
+	 * waiting for DHCP) rather than delaying startup.  Any
+	 * earlier request for random bits will start up the RBG on
+	 * demand.
+	 */
+	if ( ! rbg.started )
+		process_add ( &rbg.process );
+}
+
 /** RBG shutdown function */
 static void rbg_shutdown_fn ( int booting __unused ) {
 
+	/* Cancel any pending startup */
+	process_del ( &rbg.process );
+
 	/* Shut down RBG */
 	rbg_shutdown();
 }
@@ -29,6 +29,7 @@ FILE_SECBOOT ( PERMITTED );
 #include <stdarg.h>
 #include <string.h>
 #include <errno.h>
+#include <byteswap.h>
 #include <ipxe/asn1.h>
 #include <ipxe/crypto.h>
 #include <ipxe/bigint.h>
@@ -39,7 +40,7 @@ FILE_SECBOOT ( PERMITTED );
  *
  * RSA public-key cryptography
  *
- * RSA is documented in RFC 3447.
+ * RSA is documented in RFC 3447.  RSA-PSS is documented in RFC 8017.
  */
 
 /* Disambiguate the various error causes */
@@ -48,6 +49,64 @@ FILE_SECBOOT ( PERMITTED );
 #define EINFO_EACCES_VERIFY \
 	__einfo_uniqify ( EINFO_EACCES, 0x01, "RSA signature incorrect" )
 
+/** Length of random exponent blinding factor
+ *
+ * Each CRT exponent is blinded by adding a random multiple of (p-1)
+ * (or (q-1)), so that repeated operations using the same key do not
+ * leak the same exponent bits through side channels.
+ */
+#define RSA_BLIND_LEN 8
+
+/** RSA Chinese Remainder Theorem key components */
+struct rsa_crt_components {
+	/** Public exponent */
+	struct asn1_cursor public;
+	/** Primes p and q */
+	struct asn1_cursor prime[2];
+	/** Exponents dP and dQ */
+	struct asn1_cursor exponent[2];
+	/** Coefficient qInv */
+	struct asn1_cursor coefficient;
+};
+
+/** RSA Chinese Remainder Theorem working storage */
+struct rsa_crt {
+	/** Allocated memory */
+	void *dynamic;
+	/** Prime size */
+	unsigned int size;
+	/** Public exponent size */
+	unsigned int public_size;
+	/** Primes p and q */
+	bigint_element_t *prime0[2];
+	/** Exponents dP and dQ */
+	bigint_element_t *exponent0[2];
+	/** Montgomery constants (R^2 mod p) and (R^2 mod q) */
+	bigint_element_t *square0[2];
+	/** Coefficient qInv */
+	bigint_element_t *coefficient0;
+	/** Public exponent */
+	bigint_element_t *public0;
+	/** Results modulo p and modulo q */
+	bigint_element_t *result0[2];
+	/** Prime-sized temporary values */
+	bigint_element_t *temp0[2];
+	/** Blinding factor */
+	bigint_element_t *blind0;
+	/** Blinded exponent */
+	bigint_element_t *blinded0;
+	/** Grown exponent */
+	bigint_element_t *grown0;
+	/** Double-prime-sized value */
+	bigint_element_t *wide0;
+	/** Double-prime-sized product */
+	bigint_element_t *product0;
+	/** Consistency check result */
+	bigint_element_t *check0;
+	/** Temporary working space for modular exponentiation */
+	void *tmp;
+};
+
 /** An RSA context */
 struct rsa_context {
 	/** Allocated memory */
@@ -62,12 +121,16 @@ struct rsa_context {
 	bigint_element_t *exponent0;
 	/** Exponent size */
 	unsigned int exponent_size;
+	/** Exponent is private */
+	int is_private;
 	/** Input buffer */
 	bigint_element_t *input0;
 	/** Output buffer */
 	bigint_element_t *output0;
 	/** Temporary working space for modular exponentiation */
 	void *tmp;
+	/** Chinese Remainder Theorem working storage (if available) */
+	struct rsa_crt crt;
 };
 
 /**
@@ -94,6 +157,7 @@ rsa_find_prefix ( struct digest_algorithm *digest ) {
  */
 static inline void rsa_free ( struct rsa_context *context ) {
 
+	free ( context->crt.dynamic );
 	free ( context->dynamic );
 }
 
@@ -103,14 +167,16 @@ static inline void rsa_free ( struct rsa_context *context ) {
  * @v context		RSA context
  * @v modulus_len	Modulus length
  * @v exponent_len	Exponent length
+ * @v is_private	Exponent is private
  * @ret rc		Return status code
  */
 static int rsa_alloc ( struct rsa_context *context, size_t modulus_len,
-		       size_t exponent_len ) {
+		       size_t exponent_len, int is_private ) {
 	unsigned int size = bigint_required_size ( modulus_len );
 	unsigned int exponent_size = bigint_required_size ( exponent_len );
 	bigint_t ( size ) *modulus;
-	size_t tmp_len = bigint_mod_exp_tmp_len ( modulus );
+	size_t tmp_len = ( is_private ? bigint_mod_exp_tmp_len ( modulus ) :
+			   bigint_mod_exp_public_tmp_len ( modulus ) );
 	struct {
 		bigint_t ( size ) modulus;
 		bigint_t ( exponent_size ) exponent;
@@ -131,6 +197,7 @@ static int rsa_alloc ( struct rsa_context *context, size_t modulus_len,
 	context->max_len = modulus_len;
 	context->exponent0 = &dynamic->exponent.element[0];
 	context->exponent_size = exponent_size;
+	context->is_private = is_private;
 	context->input0 = &dynamic->input.element[0];
 	context->output0 = &dynamic->output.element[0];
 	context->tmp = &dynamic->tmp;
@@ -138,21 +205,146 @@ static int rsa_alloc ( struct rsa_context *context, size_t modulus_len,
 	return 0;
 }
 
+/**
+ * Initialise RSA Chinese Remainder Theorem working storage
+ *
+ * @v context		RSA context
+ * @v components	CRT key components
+ * @ret rc		Return status code
+ */
+static int rsa_init_crt ( struct rsa_context *context,
+			  const struct rsa_crt_components *components ) {
+	struct rsa_crt *crt = &context->crt;
+	bigint_t ( context->size ) *modulus = ( ( void * ) context->modulus0 );
+	size_t tmp_len = bigint_mod_exp_public_tmp_len ( modulus );
+	size_t prime_len = ( ( components->prime[0].len >
+			       components->prime[1].len ) ?
+			     components->prime[0].len :
+			     components->prime[1].len );
+	unsigned int size = bigint_required_size ( prime_len );
+	unsigned int public_size =
+		bigint_required_size ( components->public.len );
+	unsigned int blind_size = bigint_required_size ( RSA_BLIND_LEN );
+	struct {
+		bigint_t ( size ) prime[2];
+		bigint_t ( size ) exponent[2];
+		bigint_t ( size ) square[2];
+		bigint_t ( size ) coefficient;
+		bigint_t ( public_size ) public;
+		bigint_t ( size ) result[2];
+		bigint_t ( size ) temp[2];
+		bigint_t ( blind_size ) blind;
+		bigint_t ( size + blind_size ) blinded;
+		bigint_t ( size + blind_size ) grown;
+		bigint_t ( size * 2 ) wide;
+		bigint_t ( size * 2 ) product;
+		bigint_t ( context->size ) check;
+		uint8_t tmp[tmp_len];
+	} __attribute__ (( packed )) *dynamic;
+	unsigned int i;
+
+	/* Check that all components are present */
+	if ( ! ( components->public.len &&
+		 components->prime[0].len && components->prime[1].len &&
+		 components->exponent[0].len && components->exponent[1].len &&
+		 components->coefficient.len ) ) {
+		return -ENOTSUP;
+	}
+
+	/* Check that all components fit within the working storage */
+	if ( ( ( 2 * size ) < context->size ) ||
+	     ( components->exponent[0].len > prime_len ) ||
+	     ( components->exponent[1].len > prime_len ) ||
+	     ( components->coefficient.len > prime_len ) ) {
+		return -ERANGE;
+	}
+
+	/* Allocate dynamic storage */
+	dynamic = malloc ( sizeof ( *dynamic ) );
+	if ( ! dynamic )
+		return -ENOMEM;
+
+	/* Construct big integers */
+	for ( i = 0 ; i < 2 ; i++ ) {
+		bigint_init ( &dynamic->prime[i], components->prime[i].data,
+			      components->prime[i].len );
+		bigint_init ( &dynamic->exponent[i],
+			      components->exponent[i].data,
+			      components->exponent[i].len );
+	}
+	bigint_init ( &dynamic->coefficient, components->coefficient.data,
+		      components->coefficient.len );
+	bigint_init ( &dynamic->public, components->public.data,
+		      components->public.len );
+
+	/* Check that the primes are odd and are factors of the modulus */
+	bigint_multiply ( &dynamic->prime[0], &dynamic->prime[1],
+			  &dynamic->wide );
+	bigint_grow ( modulus, &dynamic->product );
+	if ( ( ! bigint_bit_is_set ( &dynamic->prime[0], 0 ) ) ||
+	     ( ! bigint_bit_is_set ( &dynamic->prime[1], 0 ) ) ||
+	     ( memcmp ( &dynamic->wide, &dynamic->product,
+			sizeof ( dynamic->wide ) ) != 0 ) ) {
+		free ( dynamic );
+		return -EINVAL;
+	}
+
+	/* Precalculate Montgomery constants */
+	for ( i = 0 ; i < 2 ; i++ )
+		bigint_reduce ( &dynamic->prime[i], &dynamic->square[i] );
+
+	/* Assign dynamic storage */
+	crt->dynamic = dynamic;
+	crt->size = size;
+	crt->public_size = public_size;
+	for ( i = 0 ; i < 2 ; i++ ) {
+		crt->prime0[i] = &dynamic->prime[i].element[0];
+		crt->exponent0[i] = &dynamic->exponent[i].element[0];
+		crt->square0[i] = &dynamic->square[i].element[0];
+		crt->result0[i] = &dynamic->result[i].element[0];
+		crt->temp0[i] = &dynamic->temp[i].element[0];
+	}
+	crt->coefficient0 = &dynamic->coefficient.element[0];
+	crt->public0 = &dynamic->public.element[0];
+	crt->blind0 = &dynamic->blind.element[0];
+	crt->blinded0 = &dynamic->blinded.element[0];
+	crt->grown0 = &dynamic->grown.element[0];
+	crt->wide0 = &dynamic->wide.element[0];
+	crt->product0 = &dynamic->product.element[0];
+	crt->check0 = &dynamic->check.element[0];
+	crt->tmp = &dynamic->tmp;
+
+	return 0;
+}
+
 /**
  * Parse RSA modulus and exponent
  *
  * @v modulus		Modulus to fill in
  * @v exponent		Exponent to fill in
+ * @v is_private	Exponent is private to fill in
+ * @v crt		CRT components to fill in
  * @v raw		ASN.1 cursor
  * @ret rc		Return status code
+ *
+ * Any absent or invalid CRT components will be left with a zero
+ * length.
  */
 static int rsa_parse_mod_exp ( struct asn1_cursor *modulus,
-			       struct asn1_cursor *exponent,
+			       struct asn1_cursor *exponent, int *is_private,
+			       struct rsa_crt_components *crt,
 			       const struct asn1_cursor *raw ) {
+	struct asn1_cursor *components[] = {
+		&crt->public, &crt->prime[0], &crt->prime[1],
+		&crt->exponent[0], &crt->exponent[1], &crt->coefficient,
+	};
 	struct asn1_cursor cursor;
-	int is_private;
+	unsigned int i;
 	int rc;
 
+	/* Mark all CRT components as absent */
+	memset ( crt, 0, sizeof ( *crt ) );
+
 	/* Enter subjectPublicKeyInfo/privateKeyInfo/RSAPrivateKey */
 	memcpy ( &cursor, raw, sizeof ( cursor ) );
 	asn1_enter ( &cursor, ASN1_SEQUENCE );
@@ -161,7 +353,7 @@ static int rsa_parse_mod_exp ( struct asn1_cursor *modulus,
 	if ( asn1_type ( &cursor ) == ASN1_INTEGER ) {
 
 		/* Private key */
-		is_private = 1;
+		*is_private = 1;
 
 		/* Skip version */
 		asn1_skip_any ( &cursor );
@@ -186,7 +378,7 @@ static int rsa_parse_mod_exp ( struct asn1_cursor *modulus,
 	} else {
 
 		/* Public key */
-		is_private = 0;
+		*is_private = 0;
 
 		/* Skip algorithm */
 		asn1_skip ( &cursor, ASN1_SEQUENCE );
@@ -205,14 +397,35 @@ static int rsa_parse_mod_exp ( struct asn1_cursor *modulus,
 	asn1_skip_any ( &cursor );
 
 	/* Skip public exponent, if applicable */
-	if ( is_private )
+	if ( *is_private ) {
+		memcpy ( &crt->public, &cursor, sizeof ( crt->public ) );
 		asn1_skip ( &cursor, ASN1_INTEGER );
+	}
 
 	/* Extract publicExponent/privateExponent */
 	memcpy ( exponent, &cursor, sizeof ( *exponent ) );
 	if ( ( rc = asn1_enter_unsigned ( exponent ) ) != 0 )
 		return rc;
 
+	/* Extract CRT components, if applicable */
+	if ( *is_private ) {
+		asn1_skip_any ( &cursor );
+		for ( i = 0 ; i < 2 ; i++ ) {
+			memcpy ( &crt->prime[i], &cursor, sizeof ( cursor ) );
+			asn1_skip_any ( &cursor );
+		}
+		for ( i = 0 ; i < 2 ; i++ ) {
+			memcpy ( &crt->exponent[i], &cursor, sizeof ( cursor ) );
+			asn1_skip_any ( &cursor );
+		}
+		memcpy ( &crt->coefficient, &cursor, sizeof ( cursor ) );
+		for ( i = 0 ; i < ( sizeof ( components ) /
+				    sizeof ( components[0] ) ) ; i++ ) {
+			if ( asn1_enter_unsigned ( components[i] ) != 0 )
+				components[i]->len = 0;
+		}
+	}
+
 	return 0;
 }
 
@@ -227,13 +440,16 @@ static int rsa_init ( struct rsa_context *context,
 		      const struct asn1_cursor *key ) {
 	struct asn1_cursor modulus;
 	struct asn1_cursor exponent;
+	struct rsa_crt_components crt;
+	int is_private;
 	int rc;
 
 	/* Initialise context */
 	memset ( context, 0, sizeof ( *context ) );
 
 	/* Parse modulus and exponent */
-	if ( ( rc = rsa_parse_mod_exp ( &modulus, &exponent, key ) ) != 0 ){
+	if ( ( rc = rsa_parse_mod_exp ( &modulus, &exponent, &is_private,
+					&crt, key ) ) != 0 ) {
 		DBGC ( context, "RSA %p invalid modulus/exponent:\n", context );
 		DBGC_HDA ( context, 0, key->data, key->len );
 		goto err_parse;
@@ -245,7 +461,8 @@ static int rsa_init ( struct rsa_context *context,
 	DBGC_HDA ( context, 0, exponent.data, exponent.len );
 
 	/* Allocate dynamic storage */
-	if ( ( rc = rsa_alloc ( context, modulus.len, exponent.len ) ) != 0 )
+	if ( ( rc = rsa_alloc ( context, modulus.len, exponent.len,
+				is_private ) ) != 0 )
 		goto err_alloc;
 
 	/* Construct big integers */
@@ -254,6 +471,13 @@ static int rsa_init ( struct rsa_context *context,
 	bigint_init ( ( ( bigint_t ( context->exponent_size ) * )
 			context->exponent0 ), exponent.data, exponent.len );
 
+	/* Use Chinese Remainder Theorem, if possible */
+	if ( is_private && ( ( rc = rsa_init_crt ( context, &crt ) ) != 0 ) ) {
+		DBGC ( context, "RSA %p cannot use CRT: %s\n",
+		       context, strerror ( rc ) );
+		/* Continue using the private exponent */
+	}
+
 	return 0;
 
 	rsa_free ( context );
@@ -262,6 +486,127 @@ static int rsa_init ( struct rsa_context *context,
 	return rc;
 }
 
+/**
+ * Reduce double-prime-sized value modulo a prime
+ *
+ * @v crt		CRT working storage
+ * @v index		Prime index (0 for p, 1 for q)
+ * @v value0		Element 0 of double-prime-sized value (will be destroyed)
+ * @v result0		Element 0 of prime-sized result
+ *
+ * The value must be less than the product of the prime and R, where
+ * R=2^n and n is the number of bits in the representation of the
+ * prime.  The double-prime-sized product will be overwritten.
+ */
+static void rsa_crt_reduce ( struct rsa_crt *crt, unsigned int index,
+			     bigint_element_t *value0,
+			     bigint_element_t *result0 ) {
+	bigint_t ( crt->size ) *prime = ( ( void * ) crt->prime0[index] );
+	bigint_t ( crt->size ) *square = ( ( void * ) crt->square0[index] );
+	bigint_t ( crt->size * 2 ) *value = ( ( void * ) value0 );
+	bigint_t ( crt->size * 2 ) *product = ( ( void * ) crt->product0 );
+	bigint_t ( crt->size ) *result = ( ( void * ) result0 );
+
+	/* Calculate (value * R^-1) mod prime */
+	bigint_montgomery ( prime, value, result );
+
+	/* Multiply by R^2 and reduce again to obtain (value mod prime) */
+	bigint_multiply ( result, square, product );
+	bigint_montgomery ( prime, product, result );
+}
+
+/**
+ * Perform RSA private-key cipher operation using the CRT
+ *
+ * @v context		RSA context
+ * @ret rc		Return status code
+ *
+ * The input must already have been initialised.  The output is
+ * verified using the public exponent, to avoid disclosing the
+ * private key in the event of a faulty calculation.
+ */
+static int rsa_cipher_crt ( struct rsa_context *context ) {
+	struct rsa_crt *crt = &context->crt;
+	unsigned int size = crt->size;
+	unsigned int blind_size = bigint_required_size ( RSA_BLIND_LEN );
+	bigint_t ( context->size ) *input = ( ( void * ) context->input0 );
+	bigint_t ( context->size ) *output = ( ( void * ) context->output0 );
+	bigint_t ( context->size ) *modulus = ( ( void * ) context->modulus0 );
+	bigint_t ( context->size ) *check = ( ( void * ) crt->check0 );
+	bigint_t ( crt->public_size ) *public = ( ( void * ) crt->public0 );
+	bigint_t ( size ) *coefficient = ( ( void * ) crt->coefficient0 );
+	bigint_t ( size ) *temp[2];
+	bigint_t ( size ) *prime[2];
+	bigint_t ( size ) *exponent;
+	bigint_t ( size ) *result[2];
+	bigint_t ( blind_size ) *blind = ( ( void * ) crt->blind0 );
+	bigint_t ( size + blind_size ) *blinded = ( ( void * ) crt->blinded0 );
+	bigint_t ( size + blind_size ) *grown = ( ( void * ) crt->grown0 );
+	bigint_t ( size * 2 ) *wide = ( ( void * ) crt->wide0 );
+	bigint_t ( size * 2 ) *product = ( ( void * ) crt->product0 );
+	uint8_t random[RSA_BLIND_LEN];
+	unsigned int i;
+	int rc;
+
+	/* Refuse to process out-of-range input */
+	if ( bigint_is_geq ( input, modulus ) )
+		return -ERANGE;
+
+	/* Calculate result modulo each prime */
+	for ( i = 0 ; i < 2 ; i++ ) {
+		prime[i] = ( ( void * ) crt->prime0[i] );
+		result[i] = ( ( void * ) crt->result0[i] );
+		temp[i] = ( ( void * ) crt->temp0[i] );
+		exponent = ( ( void * ) crt->exponent0[i] );
+
+		/* Construct blinded exponent (d mod (p-1)) + k(p-1) */
+		if ( ( rc = get_random_nz ( random, sizeof ( random ) ) ) != 0 )
+			return rc;
+		bigint_init ( blind, random, sizeof ( random ) );
+		bigint_copy ( prime[i], temp[0] );
+		bigint_clear_bit ( temp[0], 0 );
+		bigint_multiply ( temp[0], blind, blinded );
+		bigint_grow ( exponent, grown );
+		bigint_add ( grown, blinded );
+
+		/* Reduce input modulo this prime */
+		bigint_grow ( input, wide );
+		rsa_crt_reduce ( crt, i, wide->element, temp[0]->element );
+
+		/* Perform modular exponentiation */
+		bigint_mod_exp ( temp[0], prime[i], blinded, result[i],
+				 crt->tmp );
+	}
+
+	/* Calculate h = qInv * ( m_p - m_q ) mod p */
+	bigint_grow ( result[1], wide );
+	rsa_crt_reduce ( crt, 0, wide->element, temp[0]->element );
+	bigint_copy ( prime[0], temp[1] );
+	bigint_subtract ( temp[0], temp[1] );
+	bigint_grow ( result[0], wide );
+	bigint_grow ( temp[1], product );
+	bigint_add ( product, wide );
+	rsa_crt_reduce ( crt, 0, wide->element, temp[0]->element );
+	bigint_multiply ( coefficient, temp[0], wide );
+	rsa_crt_reduce ( crt, 0, wide->element, temp[0]->element );
+
+	/* Calculate m = m_q + h * q */
+	bigint_multiply ( temp[0], prime[1], wide );
+	bigint_grow ( result[1], product );
+	bigint_add ( product, wide );
+	bigint_shrink ( wide, output );
+
+	/* Verify result */
+	bigint_mod_exp_public ( output, modulus, public, check, crt->tmp );
+	if ( memcmp ( check, input, sizeof ( *check ) ) != 0 ) {
+		DBGC ( context, "RSA %p CRT result verification failed\n",
+		       context );
+		return -EIO;
+	}
+
+	return 0;
+}
+
 /**
  * Perform RSA cipher operation
  *
@@ -280,8 +625,21 @@ static void rsa_cipher ( struct rsa_context *context,
 	/* Initialise big integer */
 	bigint_init ( input, in, context->max_len );
 
-	/* Perform modular exponentiation */
-	bigint_mod_exp ( input, modulus, exponent, output, context->tmp );
+	/* Perform modular exponentiation (using the faster Chinese
+	 * Remainder Theorem method if the exponent is private and
+	 * the CRT components are available, or the faster
+	 * non-constant-time method if the exponent is public)
+	 */
+	if ( context->is_private ) {
+		if ( ( ! context->crt.dynamic ) ||
+		     ( rsa_cipher_crt ( context ) != 0 ) ) {
+			bigint_mod_exp ( input, modulus, exponent, output,
+					 context->tmp );
+		}
+	} else {
+		bigint_mod_exp_public ( input, modulus, exponent, output,
+					context->tmp );
+	}
 
 	/* Copy out result */
 	bigint_done ( output, out, context->max_len );
@@ -627,6 +985,283 @@ static int rsa_verify ( const struct asn1_cursor *key,
 	return rc;
 }
 
+/**
+ * Apply RSA-PSS mask generation function
+ *
+ * @v digest		Digest algorithm
+ * @v seed		Seed (of length equal to the digest size)
+ * @v data		Data to be masked
+ * @v len		Length of data
+ *
+ * The mask is generated using MGF1 as defined in RFC 8017 Appendix
+ * B.2.1, and is exclusive-ORed into the data.
+ */
+static void rsa_pss_mask ( struct digest_algorithm *digest, const void *seed,
+			   void *data, size_t len ) {
+	uint8_t ctx[digest->ctxsize];
+	uint8_t mask[digest->digestsize];
+	uint8_t *bytes = data;
+	uint32_t counter = 0;
+	uint32_t counter_be;
+	size_t frag_len;
+	unsigned int i;
+
+	while ( len ) {
+
+		/* Calculate mask block */
+		counter_be = cpu_to_be32 ( counter++ );
+		digest_init ( digest, ctx );
+		digest_update ( digest, ctx, seed, digest->digestsize );
+		digest_update ( digest, ctx, &counter_be,
+				sizeof ( counter_be ) );
+		digest_final ( digest, ctx, mask );
+
+		/* Apply mask block */
+		frag_len = len;
+		if ( frag_len > sizeof ( mask ) )
+			frag_len = sizeof ( mask );
+		for ( i = 0 ; i < frag_len ; i++ )
+			*(bytes++) ^= mask[i];
+		len -= frag_len;
+	}
+}
+
+/**
+ * Calculate RSA-PSS encoded message length
+ *
+ * @v context		RSA context
+ * @v digest		Digest algorithm
+ * @v bits		Encoded message length in bits to fill in
+ * @ret len		Encoded message length, or negative error
+ */
+static int rsa_pss_len ( struct rsa_context *context,
+			 struct digest_algorithm *digest,
+			 unsigned int *bits ) {
+	bigint_t ( context->size ) *modulus = ( ( void * ) context->modulus0 );
+	size_t digest_len = digest->digestsize;
+	size_t len;
+
+	/* Encoded message is one bit shorter than the modulus */
+	*bits = ( bigint_max_set_bit ( modulus ) - 1 );
+	len = ( ( *bits + 7 ) / 8 );
+
+	/* Sanity check (salt length is equal to the digest length) */
+	if ( len < ( ( 2 * digest_len ) + 2 ) ) {
+		DBGC ( context, "RSA %p modulus too short for RSA-PSS with "
+		       "%s\n", context, digest->name );
+		return -ERANGE;
+	}
+	assert ( len <= context->max_len );
+
+	return len;
+}
+
+/**
+ * Encode RSA-PSS digest
+ *
+ * @v context		RSA context
+ * @v digest		Digest algorithm
+ * @v value		Digest value
+ * @v salt		Salt (of length equal to the digest size)
+ * @v encoded		Encoded digest
+ * @ret rc		Return status code
+ */
+static int rsa_pss_encode ( struct rsa_context *context,
+			    struct digest_algorithm *digest,
+			    const void *value, const void *salt,
+			    void *encoded ) {
+	static const uint8_t zero[8];
+	size_t digest_len = digest->digestsize;
+	uint8_t ctx[digest->ctxsize];
+	unsigned int bits;
+	uint8_t *db;
+	uint8_t *hash;
+	size_t db_len;
+	int len;
+
+	/* Calculate encoded message length */
+	len = rsa_pss_len ( context, digest, &bits );
+	if ( len < 0 )
+		return len;
+	db_len = ( len - digest_len - 1 );
+	DBGC ( context, "RSA %p PSS encoding %s digest:\n",
+	       context, digest->name );
+	DBGC_HDA ( context, 0, value, digest_len );
+
+	/* Construct encoded message, with any leading zero byte
+	 * required to fill the modulus length.
+	 */
+	memset ( encoded, 0, context->max_len );
+	db = ( encoded + context->max_len - len );
+	hash = ( db + db_len );
+	digest_init ( digest, ctx );
+	digest_update ( digest, ctx, zero, sizeof ( zero ) );
+	digest_update ( digest, ctx, value, digest_len );
+	digest_update ( digest, ctx, salt, digest_len );
+	digest_final ( digest, ctx, hash );
+	db[ db_len - digest_len - 1 ] = 0x01;
+	memcpy ( &db[ db_len - digest_len ], salt, digest_len );
+	rsa_pss_mask ( digest, hash, db, db_len );
+	db[0] &= ( 0xff >> ( ( 8 * len ) - bits ) );
+	hash[digest_len] = 0xbc;
+	DBGC ( context, "RSA %p PSS encoded %s digest:\n",
+	       context, digest->name );
+	DBGC_HDA ( context, 0, encoded, context->max_len );
+
+	return 0;
+}
+
+/**
+ * Sign digest value using RSA-PSS
+ *
+ * @v key		Key
+ * @v digest		Digest algorithm
+ * @v value		Digest value
+ * @v signature		Signature
+ * @ret rc		Return status code
+ */
+static int rsa_pss_sign ( const struct asn1_cursor *key,
+			  struct digest_algorithm *digest, const void *value,
+			  struct asn1_builder *signature ) {
+	struct rsa_context context;
+	uint8_t salt[digest->digestsize];
+	int rc;
+
+	DBGC ( &context, "RSA %p PSS signing %s digest:\n",
+	       &context, digest->name );
+	DBGC_HDA ( &context, 0, value, digest->digestsize );
+
+	/* Initialise context */
+	if ( ( rc = rsa_init ( &context, key ) ) != 0 )
+		goto err_init;
+
+	/* Create space for encoded digest and signature */
+	if ( ( rc = asn1_grow ( signature, context.max_len ) ) != 0 )
+		goto err_grow;
+
+	/* Generate salt */
+	if ( ( rc = get_random_nz ( salt, sizeof ( salt ) ) ) != 0 )
+		goto err_random;
+
+	/* Encode digest */
+	if ( ( rc = rsa_pss_encode ( &context, digest, value, salt,
+				     signature->data ) ) != 0 )
+		goto err_encode;
+
+	/* Encipher the encoded digest */
+	rsa_cipher ( &context, signature->data, signature->data );
+	DBGC ( &context, "RSA %p PSS signed %s digest:\n",
+	       &context, digest->name );
+	DBGC_HDA ( &context, 0, signature->data, signature->len );
+
+	/* Free context */
+	rsa_free ( &context );
+
+	return 0;
+
+ err_encode:
+ err_random:
+ err_grow:
+	rsa_free ( &context );
+ err_init:
+	return rc;
+}
+
+/**
+ * Verify signed digest value using RSA-PSS
+ *
+ * @v key		Key
+ * @v digest		Digest algorithm
+ * @v value		Digest value
+ * @v signature		Signature
+ * @ret rc		Return status code
+ */
+static int rsa_pss_verify ( const struct asn1_cursor *key,
+			    struct digest_algorithm *digest, const void *value,
+			    const struct asn1_cursor *signature ) {
+	struct rsa_context context;
+	size_t digest_len = digest->digestsize;
+	uint8_t salt[digest_len];
+	unsigned int bits;
+	uint8_t *expected;
+	uint8_t *actual;
+	uint8_t *db;
+	size_t db_len;
+	int len;
+	int rc;
+
+	DBGC ( &context, "RSA %p PSS verifying %s digest:\n",
+	       &context, digest->name );
+	DBGC_HDA ( &context, 0, value, digest_len );
+	DBGC_HDA ( &context, 0, signature->data, signature->len );
+
+	/* Initialise context */
+	if ( ( rc = rsa_init ( &context, key ) ) != 0 )
+		goto err_init;
+
+	/* Sanity checks */
+	if ( signature->len != context.max_len ) {
+		DBGC ( &context, "RSA %p signature incorrect length (%zd "
+		       "bytes, should be %zd)\n",
+		       &context, signature->len, context.max_len );
+		rc = -ERANGE;
+		goto err_sanity;
+	}
+	len = rsa_pss_len ( &context, digest, &bits );
+	if ( len < 0 ) {
+		rc = len;
+		goto err_sanity;
+	}
+	db_len = ( len - digest_len - 1 );
+
+	/* Decipher the signature (using the big integer input buffer
+	 * as temporary storage)
+	 */
+	expected = ( ( void * ) context.input0 );
+	rsa_cipher ( &context, signature->data, expected );
+	DBGC ( &context, "RSA %p deciphered signature:\n", &context );
+	DBGC_HDA ( &context, 0, expected, context.max_len );
+
+	/* Recover the salt by unmasking a copy of the data block
+	 * (using the big integer output buffer as temporary storage).
+	 * The salt is not validated here: any malformation will be
+	 * caught by the comparison against the re-encoded digest.
+	 */
+	actual = ( ( void * ) context.output0 );
+	db = ( expected + context.max_len - len );
+	memcpy ( actual, db, db_len );
+	rsa_pss_mask ( digest, ( db + db_len ), actual, db_len );
+	memcpy ( salt, ( actual + db_len - digest_len ), digest_len );
+
+	/* Encode digest (using the big integer output buffer as
+	 * temporary storage)
+	 */
+	if ( ( rc = rsa_pss_encode ( &context, digest, value, salt,
+				     actual ) ) != 0 )
+		goto err_encode;
+
+	/* Verify the signature */
+	if ( memcmp ( actual, expected, context.max_len ) != 0 ) {
+		DBGC ( &context, "RSA %p signature verification failed\n",
+		       &context );
+		rc = -EACCES_VERIFY;
+		goto err_verify;
+	}
+
+	/* Free context */
+	rsa_free ( &context );
+
+	DBGC ( &context, "RSA %p signature verified successfully\n", &context );
+	return 0;
+
+ err_verify:
+ err_encode:
+ err_sanity:
+	rsa_free ( &context );
+ err_init:
+	return rc;
+}
+
 /**
  * Check for matching RSA public/private key pair
  *
@@ -640,14 +1275,16 @@ static int rsa_match ( const struct asn1_cursor *private_key,
 	struct asn1_cursor private_exponent;
 	struct asn1_cursor public_modulus;
 	struct asn1_cursor public_exponent;
+	struct rsa_crt_components crt;
+	int is_private;
 	int rc;
 
 	/* Parse moduli and exponents */
 	if ( ( rc = rsa_parse_mod_exp ( &private_modulus, &private_exponent,
-					private_key ) ) != 0 )
+					&is_private, &crt, private_key ) ) != 0 )
 		return rc;
 	if ( ( rc = rsa_parse_mod_exp ( &public_modulus, &public_exponent,
-					public_key ) ) != 0 )
+					&is_private, &crt, public_key ) ) != 0 )
 		return rc;
 
 	/* Compare moduli */
@@ -667,6 +1304,16 @@ struct pubkey_algorithm rsa_algorithm = {
 	.match		= rsa_match,
 };
 
+/** RSA-PSS public-key algorithm */
+struct pubkey_algorithm rsa_pss_algorithm = {
+	.name		= "rsa-pss",
+	.encrypt	= rsa_encrypt,
+	.decrypt	= rsa_decrypt,
+	.sign		= rsa_pss_sign,
+	.verify		= rsa_pss_verify,
+	.match		= rsa_match,
+};
+
 /* Drag in objects via rsa_algorithm */
 REQUIRING_SYMBOL ( rsa_algorithm );
 
@@ -38,6 +38,14 @@ FILE_SECBOOT ( PERMITTED );
 #include <ipxe/crypto.h>
 #include <ipxe/sha1.h>
 
+/**
+ * Disable hardware acceleration
+ *
+ * This may be used to force the use of the generic implementation
+ * (e.g. for self-tests).
+ */
+int sha1_accel_disabled;
+
 /** SHA-1 variables */
 struct sha1_variables {
 	/* This layout matches that of struct sha1_digest_data,
@@ -106,6 +114,33 @@ static struct sha1_step sha1_steps[4] = {
 	{ .f = sha1_f_20_39_60_79,	.k = 0xca62c1d6 },
 };
 
+/**
+ * Find usable hardware accelerator
+ *
+ * @ret accel		Hardware accelerator, or NULL
+ */
+static struct sha1_accelerator * sha1_accelerator ( void ) {
+	static struct sha1_accelerator *accel;
+	static int probed;
+
+	/* Do nothing if hardware acceleration is disabled */
+	if ( sha1_accel_disabled )
+		return NULL;
+
+	/* Use first usable accelerator (probing only once) */
+	if ( ! probed ) {
+		for_each_table_entry ( accel, SHA1_ACCELERATORS ) {
+			if ( accel->probe() == 0 )
+				break;
+		}
+		if ( accel == table_end ( SHA1_ACCELERATORS ) )
+			accel = NULL;
+		probed = 1;
+	}
+
+	return accel;
+}
+
 /**
  * Initialise SHA-1 algorithm
  *
@@ -120,6 +155,7 @@ static void sha1_init ( void *ctx ) {
 	context->ddd.dd.digest.h[3] = cpu_to_be32 ( 0x10325476 );
 	context->ddd.dd.digest.h[4] = cpu_to_be32 ( 0xc3d2e1f0 );
 	context->len = 0;
+	context->accel = sha1_accelerator();
 }
 
 /**
@@ -159,6 +195,13 @@ static void sha1_digest ( struct sha1_context *context ) {
 	DBGC_HDA ( context, context->len, &context->ddd.dd.data,
 		   sizeof ( context->ddd.dd.data ) );
 
+	/* Use hardware accelerator, if available */
+	if ( context->accel ) {
+		context->accel->digest ( &context->ddd.dd.digest,
+					 &context->ddd.dd.data, 1 );
+		goto done;
+	}
+
 	/* Convert h[0..4] to host-endian, and initialise a, b, c, d,
 	 * e, and w[0..15]
 	 */
@@ -194,6 +237,7 @@ static void sha1_digest ( struct sha1_context *context ) {
 				      u.ddd.dd.digest.h[i] );
 	}
 
+ done:
 	DBGC ( context, "SHA1 digested:\n" );
 	DBGC_HDA ( context, 0, &context->ddd.dd.digest,
 		   sizeof ( context->ddd.dd.digest ) );
@@ -210,14 +254,29 @@ static void sha1_update ( void *ctx, const void *data, size_t len ) {
 	struct sha1_context *context = ctx;
 	const uint8_t *byte = data;
 	size_t offset;
+	size_t count;
+	size_t frag_len;
 
 	/* Accumulate data a byte at a time, performing the digest
-	 * whenever we fill the data buffer
+	 * whenever we fill the data buffer.  If using a hardware
+	 * accelerator, then digest any whole blocks directly from
+	 * the source data whenever the data buffer is empty.
 	 */
-	while ( len-- ) {
+	while ( len ) {
 		offset = ( context->len % sizeof ( context->ddd.dd.data ) );
+		count = ( len / sizeof ( context->ddd.dd.data ) );
+		if ( context->accel && ( offset == 0 ) && count ) {
+			context->accel->digest ( &context->ddd.dd.digest,
+						 byte, count );
+			frag_len = ( count * sizeof ( context->ddd.dd.data ) );
+			context->len += frag_len;
+			byte += frag_len;
+			len -= frag_len;
+			continue;
+		}
 		context->ddd.dd.data.byte[offset] = *(byte++);
 		context->len++;
+		len--;
 		if ( ( context->len % sizeof ( context->ddd.dd.data ) ) == 0 )
 			sha1_digest ( context );
 	}
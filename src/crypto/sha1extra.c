@@ -97,10 +97,13 @@ static void pbkdf2_sha1_f ( const void *passphrase, size_t pass_len,
 			    const void *salt, size_t salt_len,
 			    int iterations, u32 blocknr, u8 *block )
 {
-	u8 pass[pass_len];	/* modifiable passphrase */
+	struct digest_algorithm *digest = &sha1_algorithm;
 	u8 in[salt_len + 4];	/* input buffer to first round */
 	u8 last[SHA1_DIGEST_SIZE]; /* output of round N, input of N+1 */
-	u8 ctx[SHA1_CTX_SIZE + SHA1_BLOCK_SIZE];
+	u8 ctx[SHA1_CTX_SIZE + SHA1_BLOCK_SIZE]; /* HMAC-SHA1 context */
+	hmac_context_t ( digest ) *hctx = ( ( void * ) ctx );
+	u8 ictx[SHA1_CTX_SIZE];	/* inner hash state after input pad */
+	u8 octx[SHA1_CTX_SIZE];	/* outer hash state after output pad */
 	u8 *next_in = in;	/* changed to `last' after first round */
 	int next_size = sizeof ( in );
 	int i;
@@ -108,15 +111,28 @@ static void pbkdf2_sha1_f ( const void *passphrase, size_t pass_len,
 
 	blocknr = htonl ( blocknr );
 
-	memcpy ( pass, passphrase, pass_len );
 	memcpy ( in, salt, salt_len );
 	memcpy ( in + salt_len, &blocknr, 4 );
 	memset ( block, 0, sizeof ( last ) );
 
+	/* Every round uses the same HMAC key, so hash the input and
+	   output pads only once and start each round from copies of
+	   the resulting intermediate states. */
+	hmac_init ( digest, ctx, passphrase, pass_len );
+	memcpy ( ictx, hctx->ctx, sizeof ( ictx ) );
+	for ( j = 0; j < sizeof ( hctx->pad ); j++ )
+		hctx->pad[j] ^= ( 0x36 ^ 0x5c );
+	digest_init ( digest, octx );
+	digest_update ( digest, octx, hctx->pad, sizeof ( hctx->pad ) );
+	memset ( hctx->pad, 0, sizeof ( hctx->pad ) );
+
 	for ( i = 0; i < iterations; i++ ) {
-		hmac_init ( &sha1_algorithm, ctx, pass, pass_len );
-		hmac_update ( &sha1_algorithm, ctx, next_in, next_size );
-		hmac_final ( &sha1_algorithm, ctx, last );
+		memcpy ( hctx->ctx, ictx, sizeof ( ictx ) );
+		digest_update ( digest, hctx->ctx, next_in, next_size );
+		digest_final ( digest, hctx->ctx, last );
+		memcpy ( hctx->ctx, octx, sizeof ( octx ) );
+		digest_update ( digest, hctx->ctx, last, sizeof ( last ) );
+		digest_final ( digest, hctx->ctx, last );
 
 		for ( j = 0; j < sizeof ( last ); j++ ) {
 			block[j] ^= last[j];
@@ -125,6 +141,11 @@ static void pbkdf2_sha1_f ( const void *passphrase, size_t pass_len,
 		next_in = last;
 		next_size = sizeof ( last );
 	}
+
+	/* Erase intermediate states (from which the key may be
+	   derivable) */
+	memset ( ictx, 0, sizeof ( ictx ) );
+	memset ( octx, 0, sizeof ( octx ) );
 }
 
 /**
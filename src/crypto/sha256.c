@@ -38,6 +38,14 @@ FILE_SECBOOT ( PERMITTED );
 #include <ipxe/crypto.h>
 #include <ipxe/sha256.h>
 
+/**
+ * Disable hardware acceleration
+ *
+ * This may be used to force the use of the generic implementation
+ * (e.g. for self-tests).
+ */
+int sha256_accel_disabled;
+
 /** SHA-256 variables */
 struct sha256_variables {
 	/* This layout matches that of struct sha256_digest_data,
@@ -55,7 +63,7 @@ struct sha256_variables {
 } __attribute__ (( packed ));
 
 /** SHA-256 constants */
-static const uint32_t k[SHA256_ROUNDS] = {
+const uint32_t sha256_k[SHA256_ROUNDS] = {
 	0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1,
 	0x923f82a4, 0xab1c5ed5, 0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
 	0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174, 0xe49b69c1, 0xefbe4786,
@@ -83,6 +91,33 @@ static const struct sha256_digest sha256_init_digest = {
 	},
 };
 
+/**
+ * Find usable hardware accelerator
+ *
+ * @ret accel		Hardware accelerator, or NULL
+ */
+static struct sha256_accelerator * sha256_accelerator ( void ) {
+	static struct sha256_accelerator *accel;
+	static int probed;
+
+	/* Do nothing if hardware acceleration is disabled */
+	if ( sha256_accel_disabled )
+		return NULL;
+
+	/* Use first usable accelerator (probing only once) */
+	if ( ! probed ) {
+		for_each_table_entry ( accel, SHA256_ACCELERATORS ) {
+			if ( accel->probe() == 0 )
+				break;
+		}
+		if ( accel == table_end ( SHA256_ACCELERATORS ) )
+			accel = NULL;
+		probed = 1;
+	}
+
+	return accel;
+}
+
 /**
  * Initialise SHA-256 family algorithm
  *
@@ -96,6 +131,7 @@ void sha256_family_init ( struct sha256_context *context,
 
 	context->len = 0;
 	context->digestsize = digestsize;
+	context->accel = sha256_accelerator();
 	memcpy ( &context->ddd.dd.digest, init,
 		 sizeof ( context->ddd.dd.digest ) );
 }
@@ -157,6 +193,13 @@ static void sha256_digest ( struct sha256_context *context ) {
 	DBGC_HDA ( context, context->len, &context->ddd.dd.data,
 		   sizeof ( context->ddd.dd.data ) );
 
+	/* Use hardware accelerator, if available */
+	if ( context->accel ) {
+		context->accel->digest ( &context->ddd.dd.digest,
+					 &context->ddd.dd.data, 1 );
+		goto done;
+	}
+
 	/* Convert h[0..7] to host-endian, and initialise a, b, c, d,
 	 * e, f, g, h, and w[0..15]
 	 */
@@ -182,7 +225,7 @@ static void sha256_digest ( struct sha256_context *context ) {
 		t2 = ( s0 + maj );
 		s1 = ( ror32 ( *e, 6 ) ^ ror32 ( *e, 11 ) ^ ror32 ( *e, 25 ) );
 		ch = ( ( *e & *f ) ^ ( (~*e) & *g ) );
-		t1 = ( *h + s1 + ch + k[i] + w[i] );
+		t1 = ( *h + s1 + ch + sha256_k[i] + w[i] );
 		*h = *g;
 		*g = *f;
 		*f = *e;
@@ -202,6 +245,7 @@ static void sha256_digest ( struct sha256_context *context ) {
 				      u.ddd.dd.digest.h[i] );
 	}
 
+ done:
 	DBGC ( context, "SHA256 digested:\n" );
 	DBGC_HDA ( context, 0, &context->ddd.dd.digest,
 		   sizeof ( context->ddd.dd.digest ) );
@@ -218,14 +262,29 @@ void sha256_update ( void *ctx, const void *data, size_t len ) {
 	struct sha256_context *context = ctx;
 	const uint8_t *byte = data;
 	size_t offset;
+	size_t count;
+	size_t frag_len;
 
 	/* Accumulate data a byte at a time, performing the digest
-	 * whenever we fill the data buffer
+	 * whenever we fill the data buffer.  If using a hardware
+	 * accelerator, then digest any whole blocks directly from
+	 * the source data whenever the data buffer is empty.
 	 */
-	while ( len-- ) {
+	while ( len ) {
 		offset = ( context->len % sizeof ( context->ddd.dd.data ) );
+		count = ( len / sizeof ( context->ddd.dd.data ) );
+		if ( context->accel && ( offset == 0 ) && count ) {
+			context->accel->digest ( &context->ddd.dd.digest,
+						 byte, count );
+			frag_len = ( count * sizeof ( context->ddd.dd.data ) );
+			context->len += frag_len;
+			byte += frag_len;
+			len -= frag_len;
+			continue;
+		}
 		context->ddd.dd.data.byte[offset] = *(byte++);
 		context->len++;
+		len--;
 		if ( ( context->len % sizeof ( context->ddd.dd.data ) ) == 0 )
 			sha256_digest ( context );
 	}
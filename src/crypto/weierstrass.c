@@ -45,6 +45,8 @@ FILE_SECBOOT ( PERMITTED );
  * implementation of the big integer operations.
  */
 
+#include <stdlib.h>
+#include <string.h>
 #include <errno.h>
 #include <ipxe/weierstrass.h>
 
@@ -257,6 +259,123 @@ static void weierstrass_init_curve ( struct weierstrass_curve *curve ) {
 	}
 }
 
+/**
+ * Perform relaxed Montgomery reduction (REDC) using Solinas form
+ *
+ * @v curve		Weierstrass curve
+ * @v value0		Element 0 of big integer to be reduced
+ * @v result0		Element 0 of big integer to hold result
+ * @ret carry		Carry out
+ *
+ * This calculates exactly the same result as
+ * bigint_montgomery_relaxed(), but exploits the Solinas form of the
+ * field prime to avoid all multiplications.
+ *
+ * Since the field prime is congruent to -1 modulo 2^32, the multiple
+ * of the field prime required to zero each successive 32-bit digit is
+ * simply the value of the digit itself.  Adding this multiple
+ * requires only a handful of signed single-digit additions, which are
+ * accumulated without carry propagation in 64-bit signed digits.
+ *
+ * The values are held as 32-bit digits (rather than as big integer
+ * elements) since the Solinas form of the NIST primes is not aligned
+ * to 64-bit boundaries.
+ */
+static int weierstrass_montgomery_solinas ( const struct weierstrass_curve
+					    *curve, bigint_element_t *value0,
+					    bigint_element_t *result0 ) {
+	const unsigned int per = ( sizeof ( bigint_element_t ) /
+				   sizeof ( uint32_t ) );
+	unsigned int size = curve->size;
+	unsigned int digits = ( size * per );
+	bigint_t ( size * 2 ) __attribute__ (( may_alias ))
+		*value = ( ( void * ) value0 );
+	bigint_t ( size ) __attribute__ (( may_alias ))
+		*result = ( ( void * ) result0 );
+	int64_t acc[ 2 * digits ];
+	bigint_element_t element;
+	const int8_t *term;
+	uint32_t digit;
+	unsigned int i;
+	int64_t carry;
+
+	/* Split value into 32-bit digits */
+	for ( i = 0 ; i < ( 2 * digits ) ; i++ ) {
+		element = value->element[ i / per ];
+		acc[i] = ( ( uint32_t ) ( element >> ( 32 * ( i % per ) ) ) );
+	}
+
+	/* Zero each low digit by adding (digit * N) */
+	for ( i = 0 ; i < digits ; i++ ) {
+		digit = acc[i];
+		for ( term = curve->solinas ; *term ; term++ ) {
+			if ( *term > 0 ) {
+				acc[ i + *term - 1 ] += digit;
+			} else {
+				acc[ i - *term - 1 ] -= digit;
+			}
+		}
+		assert ( ( acc[i] & 0xffffffffUL ) == 0 );
+		acc[ i + 1 ] += ( acc[i] >> 32 );
+	}
+
+	/* Propagate carries through high digits */
+	memset ( result, 0, sizeof ( *result ) );
+	for ( i = digits, carry = 0 ; i < ( 2 * digits ) ; i++ ) {
+		acc[i] += carry;
+		digit = acc[i];
+		carry = ( acc[i] >> 32 );
+		element = digit;
+		result->element[ ( i - digits ) / per ] |=
+			( element << ( 32 * ( i % per ) ) );
+	}
+	assert ( ( carry == 0 ) || ( carry == 1 ) );
+
+	/* Copy to high half of value (as for generic reduction) */
+	memcpy ( &value->element[size], result, sizeof ( *result ) );
+
+	return carry;
+}
+
+/**
+ * Perform relaxed Montgomery reduction (REDC) modulo field prime
+ *
+ * @v curve		Weierstrass curve
+ * @v value0		Element 0 of big integer to be reduced
+ * @v result0		Element 0 of big integer to hold result
+ * @ret carry		Carry out
+ */
+static int weierstrass_montgomery_raw ( const struct weierstrass_curve *curve,
+					bigint_element_t *value0,
+					bigint_element_t *result0 ) {
+	unsigned int size = curve->size;
+	const bigint_t ( size ) __attribute__ (( may_alias ))
+		*prime = ( ( const void * ) curve->prime[0] );
+	bigint_t ( size * 2 ) __attribute__ (( may_alias ))
+		*value = ( ( void * ) value0 );
+	bigint_t ( size ) __attribute__ (( may_alias ))
+		*result = ( ( void * ) result0 );
+
+	/* Use Solinas form, if available */
+	if ( curve->solinas )
+		return weierstrass_montgomery_solinas ( curve, value0, result0 );
+
+	return bigint_montgomery_relaxed ( prime, value, result );
+}
+
+/**
+ * Perform relaxed Montgomery reduction (REDC) modulo field prime
+ *
+ * @v curve		Weierstrass curve
+ * @v value		Big integer to be reduced
+ * @v result		Big integer to hold result
+ * @ret carry		Carry out
+ */
+#define weierstrass_montgomery( curve, value, result ) ( {		\
+	weierstrass_montgomery_raw ( (curve), (value)->element,	\
+				     (result)->element );		\
+	} )
+
 /**
  * Execute bytecode instruction
  *
@@ -268,8 +387,6 @@ static void weierstrass_init_curve ( struct weierstrass_curve *curve ) {
 static void weierstrass_exec ( const struct weierstrass_curve *curve,
 			       void **regs, unsigned int size,
 			       unsigned int op ) {
-	const bigint_t ( size ) __attribute__ (( may_alias ))
-		*prime = ( ( const void * ) curve->prime[0] );
 	bigint_t ( size * 2 ) __attribute__ (( may_alias ))
 		*product = regs[WEIERSTRASS_Wp];
 	bigint_t ( size ) __attribute__ (( may_alias )) *dest;
@@ -299,7 +416,7 @@ static void weierstrass_exec ( const struct weierstrass_curve *curve,
 		assert ( op_left != WEIERSTRASS_Wp );
 		assert ( op_right != WEIERSTRASS_Wp );
 		bigint_multiply ( left, right, product );
-		bigint_montgomery_relaxed ( prime, product, dest );
+		weierstrass_montgomery ( curve, product, dest );
 		DBGCP ( curve, "WEIERSTRASS %s R%d := R%d x R%d = %s\n",
 			curve->name, op_dest, op_left, op_right,
 			bigint_ntoa ( dest ) );
@@ -634,28 +751,30 @@ static void weierstrass_add_raw ( const struct weierstrass_curve *curve,
 	} while ( 0 )
 
 /**
- * Add points on curve as part of a Montgomery ladder
+ * Perform modular multiplication as part of a Montgomery ladder
  *
- * @v operand		Element 0 of first input operand (may overlap result)
- * @v result		Element 0 of second input operand and result
+ * @v multiplier0	Element 0 of first input operand (may overlap result)
+ * @v result0		Element 0 of second input operand and result
  * @v size		Number of elements in operands and result
  * @v ctx		Operation context
- * @v tmp		Temporary working space (not used)
+ * @v tmp		Temporary working space
  */
-static void weierstrass_add_ladder ( const bigint_element_t *operand0,
-				     bigint_element_t *result0,
-				     unsigned int size, const void *ctx,
-				     void *tmp __unused ) {
+static void weierstrass_multiply_ladder ( const bigint_element_t *multiplier0,
+					  bigint_element_t *result0,
+					  unsigned int size, const void *ctx,
+					  void *tmp ) {
 	const struct weierstrass_curve *curve = ctx;
-	const weierstrass_t ( curve->size ) __attribute__ (( may_alias ))
-		*operand = ( ( const void * ) operand0 );
-	weierstrass_t ( curve->size ) __attribute__ (( may_alias ))
+	const bigint_t ( size ) __attribute__ (( may_alias ))
+		*multiplier = ( ( const void * ) multiplier0 );
+	bigint_t ( size ) __attribute__ (( may_alias ))
 		*result = ( ( void * ) result0 );
+	bigint_t ( size * 2 ) __attribute__ (( may_alias ))
+		*product = ( ( void * ) tmp );
 
-	/* Add curve points */
-	assert ( size == bigint_size ( &operand->all ) );
-	assert ( size == bigint_size ( &result->all ) );
-	weierstrass_add ( curve, operand, result, result );
+	/* Multiply and reduce */
+	assert ( size == curve->size );
+	bigint_multiply ( result, multiplier, product );
+	weierstrass_montgomery ( curve, product, result );
 }
 
 /**
@@ -878,7 +997,7 @@ static void weierstrass_done_raw ( struct weierstrass_curve *curve,
 	/* Invert result Z co-ordinate (via Fermat's little theorem) */
 	bigint_copy ( one, &temp->point.z );
 	bigint_ladder ( &temp->point.z, &point->z, fermat,
-			bigint_mod_exp_ladder, prime, &temp->product );
+			weierstrass_multiply_ladder, curve, &temp->product );
 
 	/* Convert result back to affine co-ordinates */
 	DBGC ( curve, "WEIERSTRASS %s result (", curve->name );
@@ -940,6 +1059,155 @@ int weierstrass_is_infinity ( struct weierstrass_curve *curve,
 	return ( ! is_finite );
 }
 
+/**
+ * Construct table of multiples of curve point
+ *
+ * @v curve		Weierstrass curve
+ * @v table0		Element 0 of table of multiples to fill in
+ * @v temp0		Element 0 of temporary point buffer
+ * @v data		Raw curve point
+ * @ret rc		Return status code
+ *
+ * The table will contain the multiples 0P, 1P, 2P, ..., 15P (for a
+ * four-bit window) of the curve point P, in projective coordinates
+ * in Montgomery form.
+ */
+static int weierstrass_tabulate_raw ( struct weierstrass_curve *curve,
+				      bigint_element_t *table0,
+				      bigint_element_t *temp0,
+				      const void *data ) {
+	unsigned int size = curve->size;
+	const bigint_t ( size ) __attribute__ (( may_alias )) *one =
+		( ( const void * ) curve->one );
+	weierstrass_t ( size ) __attribute__ (( may_alias ))
+		*table = ( ( void * ) table0 );
+	weierstrass_t ( size ) __attribute__ (( may_alias ))
+		*temp = ( ( void * ) temp0 );
+	unsigned int i;
+	int rc;
+
+	/* Convert point to projective coordinates in Montgomery form */
+	if ( ( rc = weierstrass_init ( curve, &table[1], temp, data ) ) != 0 )
+		return rc;
+
+	/* Construct identity element (the point at infinity) */
+	memset ( &table[0], 0, sizeof ( table[0] ) );
+	bigint_copy ( one, &table[0].y );
+
+	/* Construct remaining multiples */
+	for ( i = 2 ; i < WEIERSTRASS_NUM_WINDOW ; i++ )
+		weierstrass_add ( curve, &table[ i - 1 ], &table[1], &table[i] );
+
+	return 0;
+}
+
+/**
+ * Construct table of multiples of curve point
+ *
+ * @v curve		Weierstrass curve
+ * @v table		Table of multiples to fill in
+ * @v temp		Temporary point buffer
+ * @v data		Raw curve point
+ * @ret rc		Return status code
+ */
+#define weierstrass_tabulate( curve, table, temp, data ) ( {		\
+	weierstrass_tabulate_raw ( (curve), (table)->all.element,	\
+				   (temp)->all.element, (data) );	\
+	} )
+
+/**
+ * Select multiple of curve point from table
+ *
+ * @v curve		Weierstrass curve
+ * @v table0		Element 0 of table of multiples
+ * @v index		Index of multiple
+ * @v point0		Element 0 of point to fill in
+ *
+ * The selection is performed in constant time, since the index will
+ * generally be derived from a secret scalar.
+ */
+static void weierstrass_select_raw ( const struct weierstrass_curve *curve,
+				     const bigint_element_t *table0,
+				     unsigned int index,
+				     bigint_element_t *point0 ) {
+	unsigned int size = curve->size;
+	const weierstrass_t ( size ) __attribute__ (( may_alias ))
+		*table = ( ( const void * ) table0 );
+	weierstrass_t ( size ) __attribute__ (( may_alias ))
+		*point = ( ( void * ) point0 );
+	bigint_element_t mask;
+	unsigned int i;
+	unsigned int j;
+
+	/* Accumulate the masked value of every table entry */
+	memset ( point, 0, sizeof ( *point ) );
+	for ( i = 0 ; i < WEIERSTRASS_NUM_WINDOW ; i++ ) {
+		mask = ( ( bigint_element_t ) ( i != index ) - 1 );
+		for ( j = 0 ; j < bigint_size ( &point->all ) ; j++ ) {
+			point->all.element[j] |=
+				( mask & table[i].all.element[j] );
+		}
+	}
+}
+
+/**
+ * Select multiple of curve point from table
+ *
+ * @v curve		Weierstrass curve
+ * @v table		Table of multiples
+ * @v index		Index of multiple
+ * @v point		Point to fill in
+ */
+#define weierstrass_select( curve, table, index, point ) do {		\
+	weierstrass_select_raw ( (curve), (table)->all.element,	\
+				 (index), (point)->all.element );	\
+	} while ( 0 )
+
+/**
+ * Get table of multiples of curve point
+ *
+ * @v curve		Weierstrass curve
+ * @v base		Raw curve point
+ * @v temp0		Element 0 of temporary point buffer
+ * @v table0		Element 0 of table of multiples to fill in
+ * @v dynamic		Dynamically allocated table to fill in
+ * @ret rc		Return status code
+ *
+ * The cached table of multiples is used for the curve's own base
+ * point.  Any other point requires a dynamically allocated table,
+ * which the caller must free (even on failure).
+ */
+static int weierstrass_table ( struct weierstrass_curve *curve,
+			       const void *base, bigint_element_t *temp0,
+			       bigint_element_t **table0, void **dynamic ) {
+	unsigned int size = curve->size;
+	size_t len = curve->len;
+	weierstrass_t ( size ) __attribute__ (( may_alias )) *table;
+	weierstrass_t ( size ) __attribute__ (( may_alias ))
+		*temp = ( ( void * ) temp0 );
+
+	/* Use cached table of multiples for base point, if already
+	 * constructed.  The identity element in a constructed table
+	 * has a non-zero y co-ordinate.
+	 */
+	if ( memcmp ( base, curve->base, ( WEIERSTRASS_AXES * len ) ) == 0 ) {
+		table = ( ( void * ) curve->table );
+		*table0 = table->all.element;
+		if ( ! bigint_is_zero ( &table[0].y ) )
+			return 0;
+	} else {
+		*dynamic = malloc ( WEIERSTRASS_NUM_WINDOW *
+				    sizeof ( table[0] ) );
+		if ( ! *dynamic )
+			return -ENOMEM;
+		table = *dynamic;
+		*table0 = table->all.element;
+	}
+
+	/* Construct table */
+	return weierstrass_tabulate ( curve, table, temp, base );
+}
+
 /**
  * Multiply curve point by scalar
  *
@@ -948,6 +1216,13 @@ int weierstrass_is_infinity ( struct weierstrass_curve *curve,
  * @v scalar		Scalar multiple
  * @v result		Result point to fill in
  * @ret rc		Return status code
+ *
+ * The multiplication is performed in constant time using a fixed
+ * window (with the table of multiples being cached for the curve's
+ * own base point).  Each window requires four point doublings and a
+ * single point addition, compared to the two point additions per bit
+ * required by a Montgomery ladder.  The complete addition formulae
+ * allow the point at infinity to be used freely in any addition.
  */
 int weierstrass_multiply ( struct weierstrass_curve *curve, const void *base,
 			   const void *scalar, void *result ) {
@@ -960,13 +1235,19 @@ int weierstrass_multiply ( struct weierstrass_curve *curve, const void *base,
 		weierstrass_t ( size ) multiple;
 		bigint_t ( bigint_required_size ( len ) ) scalar;
 	} temp;
+	weierstrass_t ( size ) __attribute__ (( may_alias )) *table;
+	bigint_element_t *table0;
+	void *dynamic = NULL;
+	unsigned int digit;
+	unsigned int bit;
+	unsigned int i;
 	int rc;
 
-	/* Convert input to projective coordinates in Montgomery form */
-	if ( ( rc = weierstrass_init ( curve, &temp.multiple, &temp.result,
-				       base ) ) != 0 ) {
-		return rc;
-	}
+	/* Get table of multiples */
+	if ( ( rc = weierstrass_table ( curve, base, temp.result.all.element,
+					&table0, &dynamic ) ) != 0 )
+		goto err_table;
+	table = ( ( void * ) table0 );
 
 	/* Construct identity element (the point at infinity) */
 	memset ( &temp.result, 0, sizeof ( temp.result ) );
@@ -977,14 +1258,144 @@ int weierstrass_multiply ( struct weierstrass_curve *curve, const void *base,
 	DBGC ( curve, "WEIERSTRASS %s scalar %s\n",
 	       curve->name, bigint_ntoa ( &temp.scalar ) );
 
-	/* Perform multiplication via Montgomery ladder */
-	bigint_ladder ( &temp.result.all, &temp.multiple.all, &temp.scalar,
-			weierstrass_add_ladder, curve, NULL );
+	/* Perform multiplication via fixed window */
+	for ( bit = ( 8 * sizeof ( temp.scalar ) ) ; bit ; ) {
+
+		/* Shift previous windows up */
+		for ( i = 0 ; i < WEIERSTRASS_WINDOW ; i++ ) {
+			weierstrass_add ( curve, &temp.result, &temp.result,
+					  &temp.result );
+		}
+
+		/* Extract window */
+		for ( digit = 0, i = 0 ; i < WEIERSTRASS_WINDOW ; i++ ) {
+			bit--;
+			digit = ( ( digit << 1 ) |
+				  bigint_bit_is_set ( &temp.scalar, bit ) );
+		}
+
+		/* Add corresponding multiple (in constant time) */
+		weierstrass_select ( curve, table, digit, &temp.multiple );
+		weierstrass_add ( curve, &temp.multiple, &temp.result,
+				  &temp.result );
+	}
 
 	/* Convert result back to affine co-ordinates */
 	weierstrass_done ( curve, &temp.result, &temp.multiple, result );
 
-	return 0;
+	/* Success */
+	rc = 0;
+
+ err_table:
+	free ( dynamic );
+	return rc;
+}
+
+/**
+ * Multiply base point and curve point by scalars and add results
+ *
+ * @v curve		Weierstrass curve
+ * @v scalar1		Scalar multiple of generator base point
+ * @v point		Curve point
+ * @v scalar2		Scalar multiple of curve point
+ * @v result		Result point to fill in
+ * @ret rc		Return status code
+ *
+ * This is used only for public values (e.g. for signature
+ * verification), and so need not execute in constant time.  Both
+ * multiplications are interleaved (using Shamir's trick) so that
+ * they share a single sequence of point doublings, and windows with
+ * a zero digit are skipped rather than adding the point at infinity.
+ */
+int weierstrass_multiply_add ( struct weierstrass_curve *curve,
+			       const void *scalar1, const void *point,
+			       const void *scalar2, void *result ) {
+	unsigned int size = curve->size;
+	size_t len = curve->len;
+	const bigint_t ( size ) __attribute__ (( may_alias )) *one =
+		( ( const void * ) curve->one );
+	struct {
+		weierstrass_t ( size ) result;
+		weierstrass_t ( size ) temp;
+		bigint_t ( bigint_required_size ( len ) ) scalar1;
+		bigint_t ( bigint_required_size ( len ) ) scalar2;
+	} temp;
+	weierstrass_t ( size ) __attribute__ (( may_alias )) *table1;
+	weierstrass_t ( size ) __attribute__ (( may_alias )) *table2;
+	bigint_element_t *table0;
+	void *dynamic1 = NULL;
+	void *dynamic2 = NULL;
+	unsigned int digit1;
+	unsigned int digit2;
+	unsigned int bit;
+	unsigned int i;
+	int started = 0;
+	int rc;
+
+	/* Get tables of multiples */
+	if ( ( rc = weierstrass_table ( curve, curve->base,
+					temp.temp.all.element, &table0,
+					&dynamic1 ) ) != 0 )
+		goto err_table;
+	table1 = ( ( void * ) table0 );
+	if ( ( rc = weierstrass_table ( curve, point, temp.temp.all.element,
+					&table0, &dynamic2 ) ) != 0 )
+		goto err_table;
+	table2 = ( ( void * ) table0 );
+
+	/* Construct identity element (the point at infinity) */
+	memset ( &temp.result, 0, sizeof ( temp.result ) );
+	bigint_copy ( one, &temp.result.y );
+
+	/* Initialise scalars */
+	bigint_init ( &temp.scalar1, scalar1, len );
+	bigint_init ( &temp.scalar2, scalar2, len );
+	DBGC ( curve, "WEIERSTRASS %s scalars %s",
+	       curve->name, bigint_ntoa ( &temp.scalar1 ) );
+	DBGC ( curve, ", %s\n", bigint_ntoa ( &temp.scalar2 ) );
+
+	/* Perform multiplications via interleaved fixed windows */
+	for ( bit = ( 8 * sizeof ( temp.scalar1 ) ) ; bit ; ) {
+
+		/* Shift previous windows up (if any) */
+		for ( i = 0 ; started && ( i < WEIERSTRASS_WINDOW ) ; i++ ) {
+			weierstrass_add ( curve, &temp.result, &temp.result,
+					  &temp.result );
+		}
+
+		/* Extract windows */
+		for ( digit1 = 0, digit2 = 0, i = 0 ;
+		      i < WEIERSTRASS_WINDOW ; i++ ) {
+			bit--;
+			digit1 = ( ( digit1 << 1 ) |
+				   bigint_bit_is_set ( &temp.scalar1, bit ) );
+			digit2 = ( ( digit2 << 1 ) |
+				   bigint_bit_is_set ( &temp.scalar2, bit ) );
+		}
+
+		/* Add corresponding multiples (if non-zero) */
+		if ( digit1 ) {
+			weierstrass_add ( curve, &table1[digit1], &temp.result,
+					  &temp.result );
+			started = 1;
+		}
+		if ( digit2 ) {
+			weierstrass_add ( curve, &table2[digit2], &temp.result,
+					  &temp.result );
+			started = 1;
+		}
+	}
+
+	/* Convert result back to affine co-ordinates */
+	weierstrass_done ( curve, &temp.result, &temp.temp, result );
+
+	/* Success */
+	rc = 0;
+
+ err_table:
+	free ( dynamic2 );
+	free ( dynamic1 );
+	return rc;
 }
 
 /**
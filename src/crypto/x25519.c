@@ -55,6 +55,13 @@ FILE_SECBOOT ( PERMITTED );
  *
  * The implementation is constant-time (provided that the underlying
  * big integer operations are also constant-time).
+ *
+ * On 64-bit platforms where the compiler provides a 128-bit integer
+ * type, multiplication is instead performed using five 51-bit limbs
+ * (i.e. radix 2^51), which allows the reduction modulo p to be
+ * folded into the multiplication itself.  The big integer
+ * representation used for storage and for all other operations is
+ * unchanged.
  */
 
 #include <stdint.h>
@@ -417,6 +424,192 @@ x25519_subtract ( const union x25519_quad257 *minuend,
 	bigint_add ( &x25519_4p, &result->value );
 }
 
+#ifdef __SIZEOF_INT128__
+
+/** Number of bits in each radix 2^51 limb */
+#define X25519_LIMB_BITS 51
+
+/** Radix 2^51 limb mask */
+#define X25519_LIMB_MASK ( ( 1ULL << X25519_LIMB_BITS ) - 1 )
+
+/** An X25519 integer in radix 2^51 representation */
+struct x25519_limbs {
+	/** Limbs (least significant first) */
+	uint64_t limb[5];
+};
+
+/**
+ * Convert big integer to radix 2^51 representation
+ *
+ * @v value		Big integer (within the range [0,8p-1])
+ * @v limbs		Radix 2^51 representation to fill in
+ *
+ * The lowest four limbs will each be less than 2^51.  The highest
+ * limb will be less than 2^54.
+ */
+static inline __attribute__ (( always_inline )) void
+x25519_split ( const x25519_t *value, struct x25519_limbs *limbs ) {
+	const unsigned int width = ( 8 * sizeof ( value->element[0] ) );
+	uint64_t word[5] = { 0 };
+	unsigned int bit;
+	unsigned int i;
+
+	/* Construct 64-bit words from big integer elements */
+	for ( i = 0 ; i < X25519_SIZE ; i++ ) {
+		bit = ( i * width );
+		word[ bit / 64 ] |= ( ( ( uint64_t ) value->element[i] ) <<
+				      ( bit % 64 ) );
+	}
+
+	/* Partition into limbs */
+	limbs->limb[0] = ( word[0] & X25519_LIMB_MASK );
+	limbs->limb[1] = ( ( ( word[0] >> 51 ) | ( word[1] << 13 ) ) &
+			   X25519_LIMB_MASK );
+	limbs->limb[2] = ( ( ( word[1] >> 38 ) | ( word[2] << 26 ) ) &
+			   X25519_LIMB_MASK );
+	limbs->limb[3] = ( ( ( word[2] >> 25 ) | ( word[3] << 39 ) ) &
+			   X25519_LIMB_MASK );
+	limbs->limb[4] = ( ( word[3] >> 12 ) | ( word[4] << 52 ) );
+}
+
+/**
+ * Convert radix 2^51 representation to big integer
+ *
+ * @v limbs		Radix 2^51 representation
+ * @v value		Big integer to fill in
+ *
+ * Each limb may exceed 51 bits, provided that the overall value
+ * remains within the range of the big integer.
+ */
+static inline __attribute__ (( always_inline )) void
+x25519_join ( const struct x25519_limbs *limbs, x25519_t *value ) {
+	const unsigned int width = ( 8 * sizeof ( value->element[0] ) );
+	unsigned __int128 accumulator;
+	uint64_t word[5];
+	unsigned int bit;
+	unsigned int i;
+
+	/* Construct 64-bit words from limbs */
+	accumulator = ( limbs->limb[0] +
+			( ( ( unsigned __int128 ) limbs->limb[1] ) << 51 ) );
+	word[0] = accumulator;
+	accumulator = ( ( accumulator >> 64 ) +
+			( ( ( unsigned __int128 ) limbs->limb[2] ) << 38 ) );
+	word[1] = accumulator;
+	accumulator = ( ( accumulator >> 64 ) +
+			( ( ( unsigned __int128 ) limbs->limb[3] ) << 25 ) );
+	word[2] = accumulator;
+	accumulator = ( ( accumulator >> 64 ) +
+			( ( ( unsigned __int128 ) limbs->limb[4] ) << 12 ) );
+	word[3] = accumulator;
+	word[4] = ( accumulator >> 64 );
+
+	/* Construct big integer elements from 64-bit words */
+	for ( i = 0 ; i < X25519_SIZE ; i++ ) {
+		bit = ( i * width );
+		value->element[i] = ( word[ bit / 64 ] >> ( bit % 64 ) );
+	}
+}
+
+/**
+ * Multiply big integers modulo field prime
+ *
+ * @v multiplicand	Big integer to be multiplied
+ * @v multiplier	Big integer to be multiplied
+ * @v result		Big integer to hold result (may overlap either input)
+ */
+void x25519_multiply ( const union x25519_oct258 *multiplicand,
+		       const union x25519_oct258 *multiplier,
+		       union x25519_quad257 *result ) {
+	struct x25519_limbs a;
+	struct x25519_limbs b;
+	struct x25519_limbs r;
+	unsigned __int128 t[5];
+	uint64_t b19[5];
+	uint64_t carry;
+	unsigned int i;
+
+	/* Convert to radix 2^51
+	 *
+	 * Both inputs are 258-bit numbers, and so limbs 0-3 are at
+	 * most 51 bits and limb 4 is at most 258-204=54 bits.
+	 */
+	x25519_split ( &multiplicand->value, &a );
+	x25519_split ( &multiplier->value, &b );
+
+	/* Calculate multiplier limbs scaled by the reduction constant
+	 *
+	 * Since 2^255=19 (mod p), any partial product with weight
+	 * 2^(255+51k) may be folded down to weight 2^(51k) by
+	 * multiplying by 19.  The scaled limbs are at most 51+5=56
+	 * bits (or 54+5=59 bits for limb 4).
+	 */
+	for ( i = 1 ; i < 5 ; i++ )
+		b19[i] = ( b.limb[i] * 19 );
+
+	/* Calculate partial products
+	 *
+	 * Each partial product is at most 54+59=113 bits (with the
+	 * largest arising from multiplying limb 4 of each input),
+	 * and so a sum of five partial products cannot overflow 128
+	 * bits.
+	 */
+	#define X25519_MUL( x, y ) ( ( ( unsigned __int128 ) (x) ) * (y) )
+	t[0] = ( X25519_MUL ( a.limb[0], b.limb[0] ) +
+		 X25519_MUL ( a.limb[1], b19[4] ) +
+		 X25519_MUL ( a.limb[2], b19[3] ) +
+		 X25519_MUL ( a.limb[3], b19[2] ) +
+		 X25519_MUL ( a.limb[4], b19[1] ) );
+	t[1] = ( X25519_MUL ( a.limb[0], b.limb[1] ) +
+		 X25519_MUL ( a.limb[1], b.limb[0] ) +
+		 X25519_MUL ( a.limb[2], b19[4] ) +
+		 X25519_MUL ( a.limb[3], b19[3] ) +
+		 X25519_MUL ( a.limb[4], b19[2] ) );
+	t[2] = ( X25519_MUL ( a.limb[0], b.limb[2] ) +
+		 X25519_MUL ( a.limb[1], b.limb[1] ) +
+		 X25519_MUL ( a.limb[2], b.limb[0] ) +
+		 X25519_MUL ( a.limb[3], b19[4] ) +
+		 X25519_MUL ( a.limb[4], b19[3] ) );
+	t[3] = ( X25519_MUL ( a.limb[0], b.limb[3] ) +
+		 X25519_MUL ( a.limb[1], b.limb[2] ) +
+		 X25519_MUL ( a.limb[2], b.limb[1] ) +
+		 X25519_MUL ( a.limb[3], b.limb[0] ) +
+		 X25519_MUL ( a.limb[4], b19[4] ) );
+	t[4] = ( X25519_MUL ( a.limb[0], b.limb[4] ) +
+		 X25519_MUL ( a.limb[1], b.limb[3] ) +
+		 X25519_MUL ( a.limb[2], b.limb[2] ) +
+		 X25519_MUL ( a.limb[3], b.limb[1] ) +
+		 X25519_MUL ( a.limb[4], b.limb[0] ) );
+	#undef X25519_MUL
+
+	/* Propagate carries
+	 *
+	 * Each sum of partial products is less than 2^116.  After
+	 * propagating carries through all five limbs, the carry out
+	 * of limb 4 (less than 2^65) is multiplied by 19, folded
+	 * back into limb 0, and propagated once more into limb 1.
+	 */
+	for ( i = 0 ; i < 4 ; i++ ) {
+		t[ i + 1 ] += ( t[i] >> X25519_LIMB_BITS );
+		r.limb[i] = ( t[i] & X25519_LIMB_MASK );
+	}
+	r.limb[4] = ( t[4] & X25519_LIMB_MASK );
+	t[0] = ( r.limb[0] + ( ( t[4] >> X25519_LIMB_BITS ) * 19 ) );
+	r.limb[0] = ( t[0] & X25519_LIMB_MASK );
+	carry = ( t[0] >> X25519_LIMB_BITS );
+	r.limb[1] += carry;
+
+	/* Convert back to big integer
+	 *
+	 * Limbs 0 and 2-4 are at most 51 bits, and limb 1 is at most
+	 * 52 bits.  The result is therefore less than 2^256, and so
+	 * lies within the range [0,4p-1].
+	 */
+	x25519_join ( &r, &result->value );
+}
+
+#else /* __SIZEOF_INT128__ */
+
 /**
  * Multiply big integers modulo field prime
  *
@@ -520,6 +713,8 @@ void x25519_multiply ( const union x25519_oct258 *multiplicand,
 	 */
 }
 
+#endif /* __SIZEOF_INT128__ */
+
 /**
  * Compute multiplicative inverse
  *
@@ -31,6 +31,7 @@ FILE_SECBOOT ( PERMITTED );
 #include <assert.h>
 #include <ipxe/list.h>
 #include <ipxe/base16.h>
+#include <ipxe/crc32.h>
 #include <ipxe/asn1.h>
 #include <ipxe/crypto.h>
 #include <ipxe/md5.h>
@@ -355,6 +356,17 @@ static int x509_parse_common_name ( struct x509_certificate *cert,
 	return 0;
 }
 
+/**
+ * Calculate hash of raw X.509 distinguished name
+ *
+ * @v name		Raw distinguished name
+ * @ret hash		Hash value
+ */
+static uint32_t x509_name_hash ( const struct asn1_cursor *name ) {
+
+	return crc32_le ( 0, name->data, name->len );
+}
+
 /**
  * Parse X.509 certificate subject
  *
@@ -370,6 +382,7 @@ static int x509_parse_subject ( struct x509_certificate *cert,
 	/* Record raw subject */
 	memcpy ( &subject->raw, raw, sizeof ( subject->raw ) );
 	asn1_shrink_any ( &subject->raw );
+	subject->hash = x509_name_hash ( &subject->raw );
 	DBGC2 ( cert, "X509 %p subject is:\n", cert );
 	DBGC2_HDA ( cert, 0, subject->raw.data, subject->raw.len );
 
@@ -1360,8 +1373,9 @@ void x509_set_valid ( struct x509_certificate *cert,
  * The issuing certificate must have already been validated.
  *
  * Validation results are cached: if a certificate has already been
- * successfully validated then @c issuer, @c time, and @c root will be
- * ignored.
+ * successfully validated then @c issuer and @c root will be ignored.
+ * The validity period is always checked against @c time, so that a
+ * cached validation result will not outlive the certificate itself.
  */
 int x509_validate ( struct x509_certificate *cert,
 		    struct x509_certificate *issuer,
@@ -1372,14 +1386,23 @@ int x509_validate ( struct x509_certificate *cert,
 	if ( ! root )
 		root = &root_certificates;
 
-	/* Return success if certificate has already been validated */
-	if ( x509_is_valid ( cert, root ) )
-		return 0;
-
 	/* Fail if certificate is invalid at specified time */
 	if ( ( rc = x509_check_time ( cert, time ) ) != 0 )
 		return rc;
 
+	/* Discard any cached validation result that relied upon an
+	 * OCSP response that has since become stale.
+	 */
+	if ( x509_is_valid ( cert, root ) && ocsp_required ( cert, time ) ) {
+		DBGC ( cert, "X509 %p \"%s\" OCSP status has expired\n",
+		       cert, x509_name ( cert ) );
+		x509_invalidate ( cert );
+	}
+
+	/* Return success if certificate has already been validated */
+	if ( x509_is_valid ( cert, root ) )
+		return 0;
+
 	/* Succeed if certificate is a trusted root certificate */
 	if ( x509_check_root ( cert, root ) == 0 ) {
 		x509_set_valid ( cert, NULL, root );
@@ -1414,7 +1437,7 @@ int x509_validate ( struct x509_certificate *cert,
 	}
 
 	/* Fail if OCSP is required */
-	if ( ocsp_required ( cert ) ) {
+	if ( ocsp_required ( cert, time ) ) {
 		DBGC ( cert, "X509 %p \"%s\" requires an OCSP check\n",
 		       cert, x509_name ( cert ) );
 		return -EACCES_OCSP_REQUIRED;
@@ -1751,6 +1774,7 @@ struct x509_certificate * x509_find ( struct x509_chain *store,
 	/* Use default certificate store if none specified */
 	if ( ! store )
 		store = &certstore;
+	x509_populate ( store );
 
 	/* Search for certificate within store */
 	list_for_each_entry ( link, &store->links, list ) {
@@ -1776,17 +1800,23 @@ x509_find_subject ( struct x509_chain *store,
 		    const struct asn1_cursor *subject ) {
 	struct x509_link *link;
 	struct x509_certificate *cert;
+	uint32_t hash;
 
 	/* Use default certificate store if none specified */
 	if ( ! store )
 		store = &certstore;
+	x509_populate ( store );
 
-	/* Scan through certificate list */
+	/* Scan through certificate list, comparing the subject hash
+	 * before comparing the full subject.
+	 */
+	hash = x509_name_hash ( subject );
 	list_for_each_entry ( link, &store->links, list ) {
 
 		/* Check subject */
 		cert = link->cert;
-		if ( asn1_compare ( subject, &cert->subject.raw ) == 0 )
+		if ( ( cert->subject.hash == hash ) &&
+		     ( asn1_compare ( subject, &cert->subject.raw ) == 0 ) )
 			return x509_found ( store, cert );
 	}
 
@@ -1811,14 +1841,17 @@ x509_find_issuer_serial ( struct x509_chain *store,
 	/* Use default certificate store if none specified */
 	if ( ! store )
 		store = &certstore;
+	x509_populate ( store );
 
 	/* Scan through certificate list */
 	list_for_each_entry ( link, &store->links, list ) {
 
-		/* Check issuer and serial number */
+		/* Check serial number (which is usually unique) before
+		 * comparing the issuer.
+		 */
 		cert = link->cert;
-		if ( ( asn1_compare ( issuer, &cert->issuer.raw ) == 0 ) &&
-		     ( asn1_compare ( serial, &cert->serial.raw ) == 0 ) )
+		if ( ( asn1_compare ( serial, &cert->serial.raw ) == 0 ) &&
+		     ( asn1_compare ( issuer, &cert->issuer.raw ) == 0 ) )
 			return x509_found ( store, cert );
 	}
 
@@ -1840,6 +1873,7 @@ struct x509_certificate * x509_find_key ( struct x509_chain *store,
 	/* Use default certificate store if none specified */
 	if ( ! store )
 		store = &certstore;
+	x509_populate ( store );
 
 	/* Scan through certificate list */
 	list_for_each_entry ( link, &store->links, list ) {
@@ -0,0 +1,552 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+FILE_SECBOOT ( PERMITTED );
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <assert.h>
+#include <byteswap.h>
+#include <ipxe/acpi.h>
+#include <ipxe/in.h>
+#include <ipxe/device.h>
+#include <ipxe/netdevice.h>
+#include <ipxe/ethernet.h>
+#include <ipxe/vlan.h>
+#include <ipxe/tcpip.h>
+#include <ipxe/dhcp.h>
+#include <ipxe/settings.h>
+#include <ipxe/nvmetcp.h>
+#include <ipxe/nbft.h>
+
+/** @file
+ *
+ * NVMe boot firmware table
+ *
+ * The NBFT describes NVMe over Fabrics boot devices to the operating
+ * system, in the same way that the iBFT describes iSCSI boot devices.
+ * The table consists of a fixed portion (header, control descriptor,
+ * host descriptor, host fabric interface descriptors and subsystem
+ * namespace descriptors) followed by a heap holding strings and
+ * transport information descriptors.
+ *
+ */
+
+/**
+ * NBFT heap
+ *
+ * This is an internal structure that we use to keep track of the
+ * allocation of heap data.
+ */
+struct nbft_heap {
+	/** Heap data */
+	void *data;
+	/** Starting offset of heap */
+	size_t start;
+	/** Total length */
+	size_t len;
+};
+
+/**
+ * Allocate a heap object within NBFT
+ *
+ * @v heap		NBFT heap
+ * @v obj		Heap object field to fill in
+ * @v len		Length of object
+ * @v pad		Length of zero padding to follow object
+ * @ret dest		Object destination, or NULL
+ */
+static void * nbft_alloc ( struct nbft_heap *heap, struct nbft_heap_obj *obj,
+			   size_t len, size_t pad ) {
+	size_t new_len;
+	void *new_data;
+	void *dest;
+
+	/* Extend heap */
+	new_len = ( heap->len + len + pad );
+	new_data = realloc ( heap->data, new_len );
+	if ( ! new_data )
+		return NULL;
+	heap->data = new_data;
+
+	/* Fill in heap object field */
+	obj->offset = cpu_to_le32 ( heap->start + heap->len );
+	obj->len = cpu_to_le16 ( len );
+
+	/* Zero object */
+	dest = ( heap->data + heap->len );
+	memset ( dest, 0, ( len + pad ) );
+
+	/* Update allocated length */
+	heap->len = new_len;
+
+	return dest;
+}
+
+/**
+ * Fill in a string heap object within NBFT
+ *
+ * @v heap		NBFT heap
+ * @v obj		Heap object field
+ * @v data		String to fill in, or NULL
+ * @ret rc		Return status code
+ */
+static int nbft_set_string ( struct nbft_heap *heap,
+			     struct nbft_heap_obj *obj, const char *data ) {
+	size_t len;
+	char *dest;
+
+	if ( ! data )
+		return 0;
+
+	len = strlen ( data );
+	dest = nbft_alloc ( heap, obj, len, 1 /* NUL */ );
+	if ( ! dest )
+		return -ENOBUFS;
+	memcpy ( dest, data, len );
+
+	return 0;
+}
+
+/**
+ * Fill in a string heap object within NBFT from configuration setting
+ *
+ * @v settings		Parent settings block, or NULL
+ * @v heap		NBFT heap
+ * @v obj		Heap object field
+ * @v setting		Configuration setting
+ * @ret rc		Return status code
+ */
+static int nbft_set_string_setting ( struct settings *settings,
+				     struct nbft_heap *heap,
+				     struct nbft_heap_obj *obj,
+				     const struct setting *setting ) {
+	struct settings *origin;
+	struct setting fetched;
+	int len;
+	char *dest;
+
+	len = fetch_setting ( settings, setting, &origin, &fetched, NULL, 0 );
+	if ( len < 0 )
+		return 0;
+
+	dest = nbft_alloc ( heap, obj, len, 1 /* NUL */ );
+	if ( ! dest )
+		return -ENOBUFS;
+	fetch_string_setting ( origin, &fetched, dest, ( len + 1 ) );
+
+	return 0;
+}
+
+/**
+ * Fill in an IP address field within NBFT
+ *
+ * @v ipaddr		IP address field
+ * @v in		IPv4 address
+ */
+static void nbft_set_ipaddr ( struct nbft_ipaddr *ipaddr, struct in_addr in ) {
+	memset ( ipaddr, 0, sizeof ( *ipaddr ) );
+	if ( in.s_addr ) {
+		ipaddr->in = in;
+		ipaddr->ones = 0xffff;
+	}
+}
+
+/**
+ * Fill in IP addresses within NBFT from configuration setting
+ *
+ * @v settings		Parent settings block, or NULL
+ * @v ipaddr		IP address fields
+ * @v setting		Configuration setting
+ * @v count		Maximum number of IP addresses
+ */
+static void nbft_set_ipaddr_setting ( struct settings *settings,
+				      struct nbft_ipaddr **ipaddr,
+				      const struct setting *setting,
+				      unsigned int count ) {
+	struct in_addr in[count];
+	unsigned int i;
+
+	fetch_ipv4_array_setting ( settings, setting, in, count );
+	for ( i = 0 ; i < count ; i++ )
+		nbft_set_ipaddr ( ipaddr[i], in[i] );
+}
+
+/**
+ * Get network device used to reach NVMe/TCP target
+ *
+ * @v nvme		NVMe/TCP device
+ * @ret netdev		Network device, or NULL
+ */
+static struct net_device * nbft_netdev ( struct nvmetcp_device *nvme ) {
+	struct sockaddr_tcpip *st_target =
+		( struct sockaddr_tcpip * ) &nvme->target_sockaddr;
+
+	return tcpip_netdev ( st_target );
+}
+
+/**
+ * Check if network device is required for the NBFT
+ *
+ * @v netdev		Network device
+ * @ret is_required	Network device is required
+ */
+static int nbft_netdev_is_required ( struct net_device *netdev ) {
+	struct nvmetcp_device *nvme;
+
+	list_for_each_entry ( nvme, &nbft_model.descs, desc.list ) {
+		if ( nbft_netdev ( nvme ) == netdev )
+			return 1;
+	}
+
+	return 0;
+}
+
+/**
+ * Fill in host fabric interface descriptor
+ *
+ * @v hfi		Host fabric interface descriptor
+ * @v heap		NBFT heap
+ * @v netdev		Network device
+ * @ret rc		Return status code
+ */
+static int nbft_fill_hfi ( struct nbft_hfi *hfi, struct nbft_heap *heap,
+			   struct net_device *netdev ) {
+	struct ll_protocol *ll_protocol = netdev->ll_protocol;
+	struct settings *parent = netdev_settings ( netdev );
+	struct in_addr netmask_addr = { 0 };
+	unsigned int netmask_count = 0;
+	struct nbft_hfi_tcp tcp;
+	struct nbft_ipaddr *dns[2] = { &tcp.primary_dns, &tcp.secondary_dns };
+	struct nbft_ipaddr *ipaddr;
+	struct settings *origin;
+	void *dest;
+	int rc;
+
+	/* Fill in host fabric interface descriptor */
+	hfi->structure_id = NBFT_STRUCTURE_ID_HFI;
+	hfi->flags = NBFT_HFI_VALID;
+	hfi->trtype = NBFT_TRTYPE_TCP;
+	DBG ( "NBFT HFI %d is %s\n", hfi->index, netdev->name );
+
+	/* Fill in transport info descriptor */
+	memset ( &tcp, 0, sizeof ( tcp ) );
+	tcp.structure_id = NBFT_STRUCTURE_ID_HFI_TRINFO;
+	tcp.version = 1;
+	tcp.trtype = NBFT_TRTYPE_TCP;
+	tcp.trinfo_version = 1;
+	tcp.hfi_index = cpu_to_le16 ( hfi->index );
+	tcp.flags = NBFT_HFI_TCP_VALID;
+	if ( netdev->dev->desc.bus_type == BUS_TYPE_PCI )
+		tcp.pci_sbdf = cpu_to_le32 ( netdev->dev->desc.location );
+	if ( ( rc = ll_protocol->eth_addr ( netdev->ll_addr,
+					    tcp.mac ) ) != 0 ) {
+		DBG ( "NBFT could not determine %s MAC: %s\n",
+		      netdev->name, strerror ( rc ) );
+		return rc;
+	}
+	tcp.vlan = cpu_to_le16 ( vlan_tag ( netdev ) );
+
+	/* Determine origin of IP address */
+	fetch_setting ( parent, &ip_setting, &origin, NULL, NULL, 0 );
+	tcp.origin = ( ( origin == parent ) ?
+		       NBFT_ORIGIN_MANUAL : NBFT_ORIGIN_DHCP );
+
+	/* Extract values from configuration settings */
+	ipaddr = &tcp.ip_address;
+	nbft_set_ipaddr_setting ( parent, &ipaddr, &ip_setting, 1 );
+	ipaddr = &tcp.gateway;
+	nbft_set_ipaddr_setting ( parent, &ipaddr, &gateway_setting, 1 );
+	nbft_set_ipaddr_setting ( NULL, dns, &dns_setting,
+				  ( sizeof ( dns ) / sizeof ( dns[0] ) ) );
+	ipaddr = &tcp.dhcp;
+	nbft_set_ipaddr_setting ( parent, &ipaddr, &dhcp_server_setting, 1 );
+	if ( ( rc = nbft_set_string_setting ( NULL, heap, &tcp.hostname,
+					      &hostname_setting ) ) != 0 )
+		return rc;
+	DBG ( "NBFT HFI %d IP %s", hfi->index,
+	      inet_ntoa ( tcp.ip_address.in ) );
+	DBG ( " gateway %s\n", inet_ntoa ( tcp.gateway.in ) );
+
+	/* Derive subnet mask prefix from subnet mask */
+	fetch_ipv4_setting ( parent, &netmask_setting, &netmask_addr );
+	while ( netmask_addr.s_addr ) {
+		if ( netmask_addr.s_addr & 0x1 )
+			netmask_count++;
+		netmask_addr.s_addr >>= 1;
+	}
+	tcp.subnet_mask_prefix = netmask_count;
+
+	/* Append transport info descriptor to heap */
+	dest = nbft_alloc ( heap, &hfi->trinfo, sizeof ( tcp ), 0 );
+	if ( ! dest )
+		return -ENOBUFS;
+	memcpy ( dest, &tcp, sizeof ( tcp ) );
+
+	return 0;
+}
+
+/**
+ * Fill in subsystem namespace descriptor
+ *
+ * @v ssns		Subsystem namespace descriptor
+ * @v heap		NBFT heap
+ * @v nvme		NVMe/TCP device
+ * @ret rc		Return status code
+ */
+static int nbft_fill_ssns ( struct nbft_ssns *ssns, struct nbft_heap *heap,
+			    struct nvmetcp_device *nvme ) {
+	struct sockaddr_tcpip *st_target =
+		( struct sockaddr_tcpip * ) &nvme->target_sockaddr;
+	struct sockaddr_in *sin_target =
+		( struct sockaddr_in * ) &nvme->target_sockaddr;
+	struct net_device *associated;
+	struct net_device *netdev;
+	char trsvcid[6 /* "65535" + NUL */ ];
+	int rc;
+
+	/* Fill in subsystem namespace descriptor */
+	ssns->structure_id = NBFT_STRUCTURE_ID_SSNS;
+	ssns->flags = cpu_to_le16 ( NBFT_SSNS_VALID );
+	ssns->trtype = NBFT_TRTYPE_TCP;
+	ssns->trflags = cpu_to_le16 ( NBFT_SSNS_TRFLAG_VALID );
+	ssns->nsid = cpu_to_le32 ( nvme->nsid );
+	ssns->nidt = NBFT_NIDT_NGUID;
+	memcpy ( ssns->nid, nvme->nguid, sizeof ( ssns->nid ) );
+	snprintf ( trsvcid, sizeof ( trsvcid ), "%d",
+		   ntohs ( st_target->st_port ) );
+	if ( ( rc = nbft_set_string ( heap, &ssns->traddr,
+				      inet_ntoa ( sin_target->sin_addr ) ) ) !=0)
+		return rc;
+	if ( ( rc = nbft_set_string ( heap, &ssns->trsvcid, trsvcid ) ) != 0 )
+		return rc;
+	if ( ( rc = nbft_set_string ( heap, &ssns->subnqn,
+				      nvme->subnqn ) ) != 0 )
+		return rc;
+	DBG ( "NBFT SSNS %d is %s:%s %s nsid %d\n",
+	      le16_to_cpu ( ssns->index ), inet_ntoa ( sin_target->sin_addr ),
+	      trsvcid, nvme->subnqn, nvme->nsid );
+
+	/* Find network device used to reach target */
+	associated = nbft_netdev ( nvme );
+	if ( ! associated ) {
+		DBG ( "NBFT SSNS %d has no net device\n",
+		      le16_to_cpu ( ssns->index ) );
+		return -EHOSTUNREACH;
+	}
+
+	/* Calculate host fabric interface association */
+	ssns->primary_hfi = 1;
+	for_each_netdev ( netdev ) {
+		if ( netdev == associated ) {
+			DBG ( "NBFT SSNS %d uses HFI %d (%s)\n",
+			      le16_to_cpu ( ssns->index ), ssns->primary_hfi,
+			      netdev->name );
+			return 0;
+		}
+		if ( nbft_netdev_is_required ( netdev ) )
+			ssns->primary_hfi++;
+	}
+
+	DBG ( "NBFT SSNS %d has impossible net device %s\n",
+	      le16_to_cpu ( ssns->index ), associated->name );
+	return -EINVAL;
+}
+
+/**
+ * Check if NBFT descriptor is complete
+ *
+ * @v desc		ACPI descriptor
+ * @ret rc		Return status code
+ */
+static int nbft_complete ( struct acpi_descriptor *desc ) {
+	struct nvmetcp_device *nvme =
+		container_of ( desc, struct nvmetcp_device, desc );
+
+	/* Fail if we do not yet have the target address */
+	if ( ! nvme->target_sockaddr.sa_family )
+		return -EAGAIN;
+
+	return 0;
+}
+
+/**
+ * Install NBFT
+ *
+ * @v install		Installation method
+ * @ret rc		Return status code
+ */
+static int nbft_install ( int ( * install ) ( struct acpi_header *acpi ) ) {
+	struct net_device *netdev;
+	struct nvmetcp_device *nvme;
+	struct nbft_table *table;
+	struct nbft_hfi *hfi;
+	struct nbft_ssns *ssns;
+	struct nbft_heap heap;
+	struct acpi_header *acpi;
+	void *data;
+	unsigned int num_hfi = 0;
+	unsigned int num_ssns = 0;
+	size_t hfi_offset;
+	size_t ssns_offset;
+	size_t len;
+	unsigned int i;
+	int rc;
+
+	/* Calculate table sizes and offsets */
+	list_for_each_entry ( nvme, &nbft_model.descs, desc.list )
+		num_ssns++;
+	for_each_netdev ( netdev ) {
+		if ( nbft_netdev_is_required ( netdev ) )
+			num_hfi++;
+	}
+	hfi_offset = sizeof ( *table );
+	ssns_offset = ( hfi_offset + ( num_hfi * sizeof ( *hfi ) ) );
+	len = ( ssns_offset + ( num_ssns * sizeof ( *ssns ) ) );
+	heap.data = NULL;
+	heap.start = len;
+	heap.len = 0;
+
+	/* Do nothing if no subsystem namespaces exist */
+	if ( ! num_ssns ) {
+		rc = 0;
+		goto no_ssns;
+	}
+
+	/* Sanity check */
+	if ( ( num_hfi > 0xff ) || ( num_ssns > 0xff ) ) {
+		rc = -ERANGE;
+		goto err_range;
+	}
+
+	/* Allocate table */
+	data = zalloc ( len );
+	if ( ! data ) {
+		rc = -ENOMEM;
+		goto err_alloc;
+	}
+	table = data;
+
+	/* Fill in control descriptor */
+	table->control.structure_id = NBFT_STRUCTURE_ID_CONTROL;
+	table->control.major_revision = NBFT_MAJOR_REVISION;
+	table->control.minor_revision = NBFT_MINOR_REVISION;
+	table->control.len = cpu_to_le16 ( sizeof ( table->control ) );
+	table->control.flags = NBFT_CONTROL_VALID;
+	table->control.host.offset =
+		cpu_to_le32 ( offsetof ( typeof ( *table ), host ) );
+	table->control.host.len = cpu_to_le16 ( sizeof ( table->host ) );
+	table->control.host_version = 1;
+	table->control.hfi_offset = cpu_to_le32 ( hfi_offset );
+	table->control.hfi_len = cpu_to_le16 ( sizeof ( *hfi ) );
+	table->control.hfi_version = 1;
+	table->control.num_hfi = num_hfi;
+	table->control.ssns_offset = cpu_to_le32 ( ssns_offset );
+	table->control.ssns_len = cpu_to_le16 ( sizeof ( *ssns ) );
+	table->control.ssns_version = 1;
+	table->control.num_ssns = num_ssns;
+
+	/* Fill in host descriptor */
+	nvme = list_first_entry ( &nbft_model.descs, struct nvmetcp_device,
+				  desc.list );
+	table->host.structure_id = NBFT_STRUCTURE_ID_HOST;
+	table->host.flags = NBFT_HOST_VALID;
+	memcpy ( table->host.host_id, &nvme->hostid,
+		 sizeof ( table->host.host_id ) );
+	if ( ( rc = nbft_set_string ( &heap, &table->host.host_nqn,
+				      nvme->hostnqn ) ) != 0 )
+		goto err_host;
+	DBG ( "NBFT host %s\n", nvme->hostnqn );
+
+	/* Fill in host fabric interface descriptors */
+	i = 0;
+	for_each_netdev ( netdev ) {
+		if ( ! nbft_netdev_is_required ( netdev ) )
+			continue;
+		assert ( i < num_hfi );
+		hfi = ( data + hfi_offset + ( i * sizeof ( *hfi ) ) );
+		hfi->index = ++i;
+		if ( ( rc = nbft_fill_hfi ( hfi, &heap, netdev ) ) != 0 )
+			goto err_hfi;
+	}
+
+	/* Fill in subsystem namespace descriptors */
+	i = 0;
+	list_for_each_entry ( nvme, &nbft_model.descs, desc.list ) {
+		assert ( i < num_ssns );
+		ssns = ( data + ssns_offset + ( i * sizeof ( *ssns ) ) );
+		ssns->index = cpu_to_le16 ( ++i );
+		if ( ( rc = nbft_fill_ssns ( ssns, &heap, nvme ) ) != 0 )
+			goto err_ssns;
+	}
+
+	/* Reallocate table to include space for heap */
+	acpi = realloc ( data, ( len + heap.len ) );
+	if ( ! acpi ) {
+		rc = -ENOMEM;
+		goto err_realloc;
+	}
+	data = NULL;
+	table = container_of ( acpi, struct nbft_table, header.acpi );
+
+	/* Fill in header */
+	acpi->signature = cpu_to_le32 ( NBFT_SIG );
+	acpi->length = cpu_to_le32 ( len + heap.len );
+	acpi->revision = NBFT_MAJOR_REVISION;
+	table->header.heap_offset = cpu_to_le32 ( heap.start );
+	table->header.heap_len = cpu_to_le32 ( heap.len );
+	table->header.minor_revision = NBFT_MINOR_REVISION;
+
+	/* Append heap */
+	memcpy ( ( ( ( void * ) acpi ) + heap.start ), heap.data, heap.len );
+
+	/* Install ACPI table */
+	if ( ( rc = install ( acpi ) ) != 0 ) {
+		DBG ( "NBFT could not install: %s\n", strerror ( rc ) );
+		goto err_install;
+	}
+
+ err_install:
+	free ( acpi );
+ err_realloc:
+ err_ssns:
+ err_hfi:
+ err_host:
+	free ( data );
+ err_alloc:
+ err_range:
+ no_ssns:
+	free ( heap.data );
+	return rc;
+}
+
+/** NBFT model */
+struct acpi_model nbft_model __acpi_model = {
+	.descs = LIST_HEAD_INIT ( nbft_model.descs ),
+	.complete = nbft_complete,
+	.install = nbft_install,
+};
@@ -506,7 +506,8 @@ static void scsicmd_response ( struct scsi_command *scsicmd,
 static void scsicmd_read_cmd ( struct scsi_command *scsicmd,
 			       struct scsi_cmd *command ) {
 
-	if ( ( scsicmd->lba + scsicmd->count ) > SCSI_MAX_BLOCK_10 ) {
+	if ( ( ( scsicmd->lba + scsicmd->count ) > SCSI_MAX_BLOCK_10 ) ||
+	     ( scsicmd->count > SCSI_MAX_COUNT_10 ) ) {
 		/* Use READ (16) */
 		command->cdb.read16.opcode = SCSI_OPCODE_READ_16;
 		command->cdb.read16.lba = cpu_to_be64 ( scsicmd->lba );
@@ -537,7 +538,8 @@ static struct scsi_command_type scsicmd_read = {
 static void scsicmd_write_cmd ( struct scsi_command *scsicmd,
 				struct scsi_cmd *command ) {
 
-	if ( ( scsicmd->lba + scsicmd->count ) > SCSI_MAX_BLOCK_10 ) {
+	if ( ( ( scsicmd->lba + scsicmd->count ) > SCSI_MAX_BLOCK_10 ) ||
+	     ( scsicmd->count > SCSI_MAX_COUNT_10 ) ) {
 		/* Use WRITE (16) */
 		command->cdb.write16.opcode = SCSI_OPCODE_WRITE_16;
 		command->cdb.write16.lba = cpu_to_be64 ( scsicmd->lba );
@@ -563,12 +565,18 @@ static struct scsi_command_type scsicmd_write = {
 struct scsi_read_capacity_private {
 	/** Use READ CAPACITY (16) */
 	int use16;
+	/** Read Block Limits vital product data page */
+	int limits;
+	/** Block device capacity */
+	struct block_device_capacity result;
 	/** Data buffer for READ CAPACITY commands */
 	union {
 		/** Data buffer for READ CAPACITY (10) */
 		struct scsi_capacity_10 capacity10;
 		/** Data buffer for READ CAPACITY (16) */
 		struct scsi_capacity_16 capacity16;
+		/** Data buffer for Block Limits vital product data */
+		struct scsi_block_limits limits;
 	} capacity;
 };
 
@@ -585,8 +593,19 @@ static void scsicmd_read_capacity_cmd ( struct scsi_command *scsicmd,
 	struct scsi_cdb_read_capacity_10 *readcap10 = &command->cdb.readcap10;
 	struct scsi_capacity_16 *capacity16 = &priv->capacity.capacity16;
 	struct scsi_capacity_10 *capacity10 = &priv->capacity.capacity10;
-
-	if ( priv->use16 ) {
+	struct scsi_cdb_inquiry *inquiry = &command->cdb.inquiry;
+	struct scsi_block_limits *limits = &priv->capacity.limits;
+
+	if ( priv->limits ) {
+		/* Use INQUIRY for Block Limits VPD page */
+		inquiry->opcode = SCSI_OPCODE_INQUIRY;
+		inquiry->flags = SCSI_INQUIRY_EVPD;
+		inquiry->page = SCSI_VPD_BLOCK_LIMITS;
+		inquiry->len = cpu_to_be16 ( sizeof ( *limits ) );
+		memset ( limits, 0, sizeof ( *limits ) );
+		command->data_in = limits;
+		command->data_in_len = sizeof ( *limits );
+	} else if ( priv->use16 ) {
 		/* Use READ CAPACITY (16) */
 		readcap16->opcode = SCSI_OPCODE_SERVICE_ACTION_IN;
 		readcap16->service_action =
@@ -614,7 +633,33 @@ static void scsicmd_read_capacity_done ( struct scsi_command *scsicmd,
 	struct scsi_read_capacity_private *priv = scsicmd_priv ( scsicmd );
 	struct scsi_capacity_16 *capacity16 = &priv->capacity.capacity16;
 	struct scsi_capacity_10 *capacity10 = &priv->capacity.capacity10;
-	struct block_device_capacity capacity;
+	struct scsi_block_limits *limits = &priv->capacity.limits;
+	struct block_device_capacity *capacity = &priv->result;
+	unsigned int max_len;
+	unsigned int opt_len;
+
+	/* Extract transfer length limits, if applicable.  The Block
+	 * Limits page is optional, so failure is not an error.
+	 */
+	if ( priv->limits ) {
+		if ( ( rc == 0 ) &&
+		     ( limits->page == SCSI_VPD_BLOCK_LIMITS ) ) {
+			max_len = be32_to_cpu ( limits->max_len );
+			opt_len = be32_to_cpu ( limits->opt_len );
+			DBGC ( scsidev, "SCSI %p block limits max %#x opt "
+			       "%#x\n", scsidev, max_len, opt_len );
+			if ( opt_len && ( ( ! max_len ) ||
+					  ( opt_len < max_len ) ) ) {
+				max_len = opt_len;
+			}
+			if ( max_len )
+				capacity->max_count = max_len;
+		} else {
+			DBGC ( scsidev, "SCSI %p has no block limits: %s\n",
+			       scsidev, strerror ( rc ) );
+		}
+		goto done;
+	}
 
 	/* Close if command failed */
 	if ( rc != 0 ) {
@@ -624,11 +669,11 @@ static void scsicmd_read_capacity_done ( struct scsi_command *scsicmd,
 
 	/* Extract capacity */
 	if ( priv->use16 ) {
-		capacity.blocks = ( be64_to_cpu ( capacity16->lba ) + 1 );
-		capacity.blksize = be32_to_cpu ( capacity16->blksize );
+		capacity->blocks = ( be64_to_cpu ( capacity16->lba ) + 1 );
+		capacity->blksize = be32_to_cpu ( capacity16->blksize );
 	} else {
-		capacity.blocks = ( be32_to_cpu ( capacity10->lba ) + 1 );
-		capacity.blksize = be32_to_cpu ( capacity10->blksize );
+		capacity->blocks = ( be32_to_cpu ( capacity10->lba ) + 1 );
+		capacity->blksize = be32_to_cpu ( capacity10->blksize );
 
 		/* If capacity range was exceeded (i.e. capacity.lba
 		 * was 0xffffffff, meaning that blockdev->blocks is
@@ -636,7 +681,7 @@ static void scsicmd_read_capacity_done ( struct scsi_command *scsicmd,
 		 * CAPACITY (16) is not mandatory, so we can't just
 		 * use it straight off.
 		 */
-		if ( capacity.blocks == 0 ) {
+		if ( capacity->blocks == 0 ) {
 			priv->use16 = 1;
 			if ( ( rc = scsicmd_command ( scsicmd ) ) != 0 ) {
 				scsicmd_close ( scsicmd, rc );
@@ -645,13 +690,23 @@ static void scsicmd_read_capacity_done ( struct scsi_command *scsicmd,
 			return;
 		}
 	}
-	capacity.max_count = -1U;
+	capacity->max_count = -1U;
+
+	/* Read Block Limits VPD page to obtain the device's preferred
+	 * transfer length.  Using this as the maximum transfer size
+	 * allows the SAN device layer to split large reads into
+	 * fragments that may be queued concurrently.
+	 */
+	priv->limits = 1;
+	if ( scsicmd_command ( scsicmd ) == 0 )
+		return;
 
+ done:
 	/* Allow transport layer to update capacity */
-	block_capacity ( &scsidev->scsi, &capacity );
+	block_capacity ( &scsidev->scsi, capacity );
 
 	/* Return capacity to caller */
-	block_capacity ( &scsicmd->block, &capacity );
+	block_capacity ( &scsicmd->block, capacity );
 
 	/* Close command */
 	scsicmd_close ( scsicmd, 0 );
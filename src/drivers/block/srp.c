@@ -112,6 +112,13 @@ struct srp_device {
 	uint32_t memory_handle;
 	/** Login completed successfully */
 	int logged_in;
+	/** Request limit
+	 *
+	 * This is the number of SRP_CMD IUs that the target is
+	 * currently prepared to accept, as granted via the request
+	 * limit delta fields of the IUs received from the target.
+	 */
+	unsigned int request_limit;
 
 	/** List of active commands */
 	struct list_head commands;
@@ -279,6 +286,25 @@ static int srp_new_tag ( struct srp_device *srpdev ) {
 	return -EADDRINUSE;
 }
 
+/**
+ * Add to SRP request limit
+ *
+ * @v srpdev		SRP device
+ * @v delta		Request limit delta (in network byte order)
+ */
+static void srp_request_limit ( struct srp_device *srpdev, uint32_t delta ) {
+	unsigned int old_limit = srpdev->request_limit;
+
+	/* Update request limit */
+	srpdev->request_limit += ntohl ( delta );
+	DBGC2 ( srpdev, "SRP %p request limit %d\n",
+		srpdev, srpdev->request_limit );
+
+	/* Notify of window change if the window has opened */
+	if ( srpdev->logged_in && srpdev->request_limit && ( ! old_limit ) )
+		xfer_window_changed ( &srpdev->scsi );
+}
+
 /**
  * Transmit SRP login request
  *
@@ -346,9 +372,11 @@ static int srp_login_rsp ( struct srp_device *srpdev,
 	       srpdev, ntohl ( login_rsp->tag.dwords[1] ) );
 	DBGC_HDA ( srpdev, 0, data, len );
 
-	/* Mark as logged in */
+	/* Mark as logged in and record initial request limit */
 	srpdev->logged_in = 1;
-	DBGC ( srpdev, "SRP %p logged in\n", srpdev );
+	srpdev->request_limit = ntohl ( login_rsp->request_limit_delta );
+	DBGC ( srpdev, "SRP %p logged in with request limit %d\n",
+	       srpdev, srpdev->request_limit );
 
 	/* Notify of window change */
 	xfer_window_changed ( &srpdev->scsi );
@@ -408,6 +436,11 @@ static int srp_cmd ( struct srp_device *srpdev,
 		       "login completes\n", srpdev, tag );
 		return -EBUSY;
 	}
+	if ( ! srpdev->request_limit ) {
+		DBGC ( srpdev, "SRP %p tag %08x cannot send CMD beyond "
+		       "request limit\n", srpdev, tag );
+		return -EBUSY;
+	}
 
 	/* Allocate I/O buffer */
 	iobuf = xfer_alloc_iob ( &srpdev->socket, SRP_MAX_I_T_IU_LEN );
@@ -453,6 +486,9 @@ static int srp_cmd ( struct srp_device *srpdev,
 		return rc;
 	}
 
+	/* Consume request limit */
+	srpdev->request_limit--;
+
 	return 0;
 }
 
@@ -493,6 +529,9 @@ static int srp_rsp ( struct srp_device *srpdev,
 		( ( rsp->valid & SRP_RSP_VALID_SNSVALID ) ? " sns" : "" ),
 		( ( rsp->valid & SRP_RSP_VALID_RSPVALID ) ? " rsp" : "" ) );
 
+	/* Update request limit */
+	srp_request_limit ( srpdev, rsp->request_limit_delta );
+
 	/* Identify command by tag */
 	srpcmd = srp_find_tag ( srpdev, ntohl ( rsp->tag.dwords[1] ) );
 	if ( ! srpcmd ) {
@@ -533,6 +572,56 @@ static int srp_rsp ( struct srp_device *srpdev,
 	return 0;
 }
 
+/**
+ * Receive SRP credit request
+ *
+ * @v srpdev		SRP device
+ * @v data		SRP IU
+ * @v len		Length of SRP IU
+ * @ret rc		Returns status code
+ */
+static int srp_cred_req ( struct srp_device *srpdev,
+			  const void *data, size_t len ) {
+	const struct srp_cred_req *cred_req = data;
+	struct io_buffer *iobuf;
+	struct srp_cred_rsp *cred_rsp;
+	int rc;
+
+	/* Sanity check */
+	if ( len < sizeof ( *cred_req ) ) {
+		DBGC ( srpdev, "SRP %p CRED_REQ too short (%zd bytes)\n",
+		       srpdev, len );
+		return -EINVAL;
+	}
+	DBGC2 ( srpdev, "SRP %p tag %08x CRED_REQ delta %d\n",
+		srpdev, ntohl ( cred_req->tag.dwords[1] ),
+		ntohl ( cred_req->request_limit_delta ) );
+
+	/* Allocate I/O buffer */
+	iobuf = xfer_alloc_iob ( &srpdev->socket, sizeof ( *cred_rsp ) );
+	if ( ! iobuf )
+		return -ENOMEM;
+
+	/* Construct credit response IU */
+	cred_rsp = iob_put ( iobuf, sizeof ( *cred_rsp ) );
+	memset ( cred_rsp, 0, sizeof ( *cred_rsp ) );
+	cred_rsp->type = SRP_CRED_RSP;
+	memcpy ( &cred_rsp->tag, &cred_req->tag, sizeof ( cred_rsp->tag ) );
+
+	/* Send credit response IU */
+	if ( ( rc = xfer_deliver_iob ( &srpdev->socket, iobuf ) ) != 0 ) {
+		DBGC ( srpdev, "SRP %p tag %08x could not send CRED_RSP: "
+		       "%s\n", srpdev, ntohl ( cred_req->tag.dwords[1] ),
+		       strerror ( rc ) );
+		return rc;
+	}
+
+	/* Update request limit */
+	srp_request_limit ( srpdev, cred_req->request_limit_delta );
+
+	return 0;
+}
+
 /**
  * Receive SRP unrecognised response IU
  *
@@ -646,6 +735,9 @@ static int srpdev_deliver ( struct srp_device *srpdev,
 	case SRP_RSP:
 		type = srp_rsp;
 		break;
+	case SRP_CRED_REQ:
+		type = srp_cred_req;
+		break;
 	default:
 		type = srp_unrecognised;
 		break;
@@ -672,9 +764,14 @@ static int srpdev_deliver ( struct srp_device *srpdev,
  *
  * @v srpdev		SRP device
  * @ret len		Length of window
+ *
+ * The window is open whenever the target is prepared to accept a
+ * further command, allowing up to the target's request limit of
+ * commands to be outstanding concurrently.
  */
 static size_t srpdev_window ( struct srp_device *srpdev ) {
-	return ( srpdev->logged_in ? ~( ( size_t ) 0 ) : 0 );
+	return ( ( srpdev->logged_in && srpdev->request_limit ) ?
+		 ~( ( size_t ) 0 ) : 0 );
 }
 
 /** SRP device socket interface operations */
@@ -212,8 +212,12 @@ static void pci_read_bases ( struct pci_device *pci ) {
 	pci->ioaddr = 0;
 	pci->membase = 0;
 
-	/* Get first memory and I/O BAR addresses */
+	/* Get first memory and I/O BAR addresses, stopping as soon as
+	 * both have been found.
+	 */
 	for ( reg = PCI_BASE_ADDRESS_0; reg <= PCI_BASE_ADDRESS_5; reg += 4 ) {
+		if ( pci->ioaddr && pci->membase )
+			break;
 		bar = pci_bar ( pci, reg );
 		if ( bar & PCI_BASE_ADDRESS_SPACE_IO ) {
 			if ( ! pci->ioaddr )
@@ -342,14 +346,20 @@ int pci_find_next ( struct pci_device *pci, uint32_t *busdevfn ) {
 		/* Check for PCI device existence */
 		memset ( pci, 0, sizeof ( *pci ) );
 		pci_init ( pci, *busdevfn );
-		if ( ( rc = pci_read_config ( pci ) ) != 0 )
+		if ( ( rc = pci_read_config ( pci ) ) != 0 ) {
+			/* If function 0 is absent, then the whole
+			 * slot is empty; skip the remaining functions
+			 * rather than probing each of them.
+			 */
+			if ( PCI_FUNC ( *busdevfn ) == 0 )
+				*busdevfn = PCI_LAST_FUNC ( *busdevfn );
 			continue;
+		}
 
 		/* If device is a bridge, expand the PCI bus:dev.fn
 		 * address range as needed.
 		 */
-		pci_read_config_byte ( pci, PCI_HEADER_TYPE, &hdrtype );
-		hdrtype &= PCI_HEADER_TYPE_MASK;
+		hdrtype = ( pci->hdrtype & PCI_HEADER_TYPE_MASK );
 		if ( hdrtype == PCI_HEADER_TYPE_BRIDGE ) {
 			pci_read_config_byte ( pci, PCI_SUBORDINATE, &sub );
 			if ( sub <= PCI_BUS ( *busdevfn ) ) {
@@ -442,6 +452,28 @@ void pci_remove ( struct pci_device *pci ) {
 	DBGC ( pci, PCI_FMT " removed\n", PCI_ARGS ( pci ) );
 }
 
+/** Automatic probing is restricted to a single PCI device */
+static int pci_probe_restricted;
+
+/** PCI bus:dev.fn address of the only device to be probed automatically */
+static uint32_t pci_probe_busdevfn;
+
+/**
+ * Restrict automatic probing to a single PCI device
+ *
+ * @v busdevfn		PCI bus:dev.fn address
+ *
+ * This must be called before the PCI root bus is probed.
+ */
+void pci_probe_only ( uint32_t busdevfn ) {
+
+	DBGC ( &pci_probe_busdevfn, "PCI probing restricted to "
+	       PCI_FMT "\n", PCI_SEG ( busdevfn ), PCI_BUS ( busdevfn ),
+	       PCI_SLOT ( busdevfn ), PCI_FUNC ( busdevfn ) );
+	pci_probe_busdevfn = busdevfn;
+	pci_probe_restricted = 1;
+}
+
 /**
  * Probe PCI root bus
  *
@@ -472,6 +504,11 @@ static int pcibus_probe ( struct root_device *rootdev ) {
 		if ( ! pci_can_probe ( pci ) )
 			continue;
 
+		/* Skip devices excluded by a probe restriction */
+		if ( pci_probe_restricted &&
+		     ( pci->busdevfn != pci_probe_busdevfn ) )
+			continue;
+
 		/* Look for a driver */
 		if ( ( rc = pci_find_driver ( pci ) ) != 0 ) {
 			DBGC ( pci, PCI_FMT " (%04x:%04x class %06x) has no "
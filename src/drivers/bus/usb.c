@@ -34,6 +34,7 @@ FILE_SECBOOT ( PERMITTED );
 #include <byteswap.h>
 #include <ipxe/usb.h>
 #include <ipxe/cdc.h>
+#include <config/usb.h>
 
 /** @file
  *
@@ -592,6 +593,9 @@ void usb_complete_err ( struct usb_endpoint *ep, struct io_buffer *iobuf,
 	assert ( ep->fill > 0 );
 	ep->fill--;
 
+	/* Record activity */
+	process_active();
+
 	/* Schedule reset, if applicable */
 	if ( ( rc != 0 ) && ep->open ) {
 		DBGC ( usb, "USB %s %s completion failed: %s\n",
@@ -2150,8 +2154,15 @@ int register_usb_bus ( struct usb_bus *bus ) {
 	if ( ( rc = register_usb_hub ( bus->hub ) ) != 0 )
 		goto err_register_hub;
 
-	/* Attach any devices already present */
+	/* Attach any devices already present, unless this has been
+	 * deferred to the USB process.  Deferring allows startup to
+	 * proceed without waiting for hub port resets and device
+	 * enumeration, at the cost of USB devices appearing only
+	 * after the USB process has run.
+	 */
+#ifndef USB_DEFER_ATTACH
 	usb_hotplug();
+#endif
 
 	return 0;
 
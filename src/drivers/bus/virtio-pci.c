@@ -24,9 +24,11 @@
 
 static int vp_alloc_vq(struct vring_virtqueue *vq, u16 num, size_t header_size)
 {
-    size_t ring_size = PAGE_MASK + vring_size(num);
+    size_t ring_size = (vq->packed ? vring_packed_size(num) :
+                        (PAGE_MASK + vring_size(num)));
     size_t vdata_size = num * sizeof(void *);
-    size_t queue_size = ring_size + vdata_size + header_size;
+    size_t id_size = (vq->packed ? (2 * num * sizeof(u16)) : 0);
+    size_t queue_size = ring_size + vdata_size + id_size + header_size;
 
     vq->queue = dma_alloc(vq->dma, &vq->map, queue_size, queue_size);
     if (!vq->queue) {
@@ -39,8 +41,14 @@ static int vp_alloc_vq(struct vring_virtqueue *vq, u16 num, size_t header_size)
     /* vdata immediately follows the ring */
     vq->vdata = (void **)(vq->queue + ring_size);
 
-    /* empty header immediately follows vdata */
-    vq->empty_header = (struct virtio_net_hdr_modern *)(vq->queue + ring_size + vdata_size);
+    /* packed virtqueue buffer ID lists immediately follow vdata */
+    if (vq->packed) {
+        vq->id_next = (u16 *)(vq->queue + ring_size + vdata_size);
+        vq->id_num = &vq->id_next[num];
+    }
+
+    /* empty header immediately follows vdata (and buffer ID lists) */
+    vq->empty_header = (struct virtio_net_hdr_modern *)(vq->queue + ring_size + vdata_size + id_size);
 
     return 0;
 }
@@ -357,6 +365,17 @@ void vpm_notify(struct virtio_pci_modern_device *vdev,
     vpm_iowrite16(vdev, &vq->notification, (u16)vq->queue_index, 0);
 }
 
+/* Check if packed virtqueues have been negotiated */
+static int vpm_packed(struct virtio_pci_modern_device *vdev)
+{
+    u32 features_hi;
+
+    vpm_iowrite32(vdev, &vdev->common, 1, COMMON_OFFSET(guest_feature_select));
+    features_hi = vpm_ioread32(vdev, &vdev->common, COMMON_OFFSET(guest_feature));
+
+    return !!(features_hi & (1 << (VIRTIO_F_RING_PACKED - 32)));
+}
+
 int vpm_find_vqs(struct virtio_pci_modern_device *vdev,
                  unsigned nvqs, struct vring_virtqueue *vqs,
                  struct dma_device *dma_dev, size_t header_size)
@@ -365,6 +384,7 @@ int vpm_find_vqs(struct virtio_pci_modern_device *vdev,
     struct vring_virtqueue *vq;
     u16 size, off;
     u32 notify_offset_multiplier;
+    int packed;
     int err;
 
     if (nvqs > vpm_ioread16(vdev, &vdev->common, COMMON_OFFSET(num_queues))) {
@@ -377,6 +397,9 @@ int vpm_find_vqs(struct virtio_pci_modern_device *vdev,
         notify_off_multiplier),
         &notify_offset_multiplier);
 
+    /* Determine virtqueue layout */
+    packed = vpm_packed(vdev);
+
     for (i = 0; i < nvqs; i++) {
         /* Select the queue we're interested in */
         vpm_iowrite16(vdev, &vdev->common, (u16)i, COMMON_OFFSET(queue_select));
@@ -404,6 +427,7 @@ int vpm_find_vqs(struct virtio_pci_modern_device *vdev,
         vq = &vqs[i];
         vq->queue_index = i;
         vq->dma = dma_dev;
+        vq->packed = packed;
 
         /* get offset of notification word for this vq */
         off = vpm_ioread16(vdev, &vdev->common, COMMON_OFFSET(queue_notify_off));
@@ -413,21 +437,31 @@ int vpm_find_vqs(struct virtio_pci_modern_device *vdev,
             DBG("VIRTIO-PCI %p: failed to allocate queue memory\n", vdev);
             return err;
         }
-        vring_init(&vq->vring, size, vq->queue);
+        if (packed) {
+            vring_packed_init(vq, size, vq->queue);
+        } else {
+            vring_init(&vq->vring, size, vq->queue);
+        }
 
         /* activate the queue */
         vpm_iowrite16(vdev, &vdev->common, size, COMMON_OFFSET(queue_size));
 
+        /* the driver and device areas hold the event suppression
+         * structures for a packed virtqueue
+         */
         vpm_iowrite64(vdev, &vdev->common,
-                      dma(&vq->map, vq->vring.desc),
+                      (packed ? dma(&vq->map, vq->vring_packed.desc) :
+                       dma(&vq->map, vq->vring.desc)),
                       COMMON_OFFSET(queue_desc_lo),
                       COMMON_OFFSET(queue_desc_hi));
         vpm_iowrite64(vdev, &vdev->common,
-                      dma(&vq->map, vq->vring.avail),
+                      (packed ? dma(&vq->map, vq->vring_packed.driver) :
+                       dma(&vq->map, vq->vring.avail)),
                       COMMON_OFFSET(queue_avail_lo),
                       COMMON_OFFSET(queue_avail_hi));
         vpm_iowrite64(vdev, &vdev->common,
-                      dma(&vq->map, vq->vring.used),
+                      (packed ? dma(&vq->map, vq->vring_packed.device) :
+                       dma(&vq->map, vq->vring.used)),
                       COMMON_OFFSET(queue_used_lo),
                       COMMON_OFFSET(queue_used_hi));
 
@@ -52,6 +52,45 @@ void vring_detach(struct vring_virtqueue *vq, unsigned int head)
    vq->free_head = head;
 }
 
+/*
+ * vring_packed_get_buf
+ *
+ * get a buffer from a packed virtqueue
+ *
+ */
+
+static void *vring_packed_get_buf(struct vring_virtqueue *vq,
+                                  unsigned int *len)
+{
+   struct vring_packed *vr = &vq->vring_packed;
+   struct vring_packed_desc *desc;
+   unsigned int num;
+   u16 id;
+
+   /* read used descriptor only after observing its flags */
+   rmb();
+   desc = &vr->desc[vq->last_used_idx];
+   id = desc->id;
+   if (len != NULL)
+           *len = desc->len;
+   BUG_ON(id >= vr->num);
+
+   /* return buffer ID and descriptors to the free lists */
+   num = vq->id_num[id];
+   vq->id_next[id] = vq->free_id;
+   vq->free_id = id;
+   vq->num_free += num;
+
+   /* the device skips over the remainder of the descriptor chain */
+   vq->last_used_idx += num;
+   if (vq->last_used_idx >= vr->num) {
+           vq->last_used_idx -= vr->num;
+           vq->used_wrap ^= 1;
+   }
+
+   return vq->vdata[id];
+}
+
 /*
  * vring_get_buf
  *
@@ -68,6 +107,9 @@ void *vring_get_buf(struct vring_virtqueue *vq, unsigned int *len)
 
    BUG_ON(!vring_more_used(vq));
 
+   if (vq->packed)
+           return vring_packed_get_buf(vq, len);
+
    elem = &vr->used->ring[vq->last_used_idx % vr->num];
    wmb();
    id = elem->id;
@@ -83,6 +125,68 @@ void *vring_get_buf(struct vring_virtqueue *vq, unsigned int *len)
    return opaque;
 }
 
+/*
+ * vring_packed_add_buf
+ *
+ * add a buffer to a packed virtqueue
+ *
+ * The buffer is made available to the device immediately, by writing
+ * the flags of the first descriptor in the chain last.
+ */
+
+static void vring_packed_add_buf(struct vring_virtqueue *vq,
+                                 struct vring_list list[],
+                                 unsigned int out, unsigned int in,
+                                 void *opaque)
+{
+   struct vring_packed *vr = &vq->vring_packed;
+   unsigned int count = out + in;
+   unsigned int head = vq->free_head;
+   unsigned int pos = head;
+   u16 avail_flags = vq->avail_flags;
+   u16 head_flags = 0;
+   u16 flags;
+   unsigned int i;
+   u16 id;
+
+   BUG_ON(count == 0);
+   BUG_ON(count > vq->num_free);
+
+   /* allocate buffer ID */
+   id = vq->free_id;
+   vq->free_id = vq->id_next[id];
+   vq->id_num[id] = count;
+   vq->vdata[id] = opaque;
+   vq->num_free -= count;
+
+   /* fill in descriptors */
+   for (i = 0; i < count; i++, list++) {
+           flags = avail_flags;
+           if (i < (count - 1))
+                   flags |= VRING_DESC_F_NEXT;
+           if (i >= out)
+                   flags |= VRING_DESC_F_WRITE;
+           vr->desc[pos].addr = list->addr;
+           vr->desc[pos].len = list->length;
+           vr->desc[pos].id = id;
+           if (i == 0)
+                   head_flags = flags;
+           else
+                   vr->desc[pos].flags = flags;
+           if (++pos == vr->num) {
+                   pos = 0;
+                   avail_flags ^= (VRING_PACKED_DESC_F_AVAIL |
+                                   VRING_PACKED_DESC_F_USED);
+           }
+   }
+   vq->free_head = pos;
+   vq->avail_flags = avail_flags;
+
+   /* make descriptor chain available to the device */
+   wmb();
+   vr->desc[head].flags = head_flags;
+}
+
 void vring_add_buf(struct vring_virtqueue *vq,
 		   struct vring_list list[],
 		   unsigned int out, unsigned int in,
@@ -91,6 +195,11 @@ void vring_add_buf(struct vring_virtqueue *vq,
    struct vring *vr = &vq->vring;
    int i, avail, head, prev;
 
+   if (vq->packed) {
+           vring_packed_add_buf(vq, list, out, in, opaque);
+           return;
+   }
+
    BUG_ON(out + in == 0);
 
    prev = 0;
@@ -126,12 +235,24 @@ void vring_kick(struct virtio_pci_modern_device *vdev, unsigned int ioaddr,
                 struct vring_virtqueue *vq, int num_added)
 {
    struct vring *vr = &vq->vring;
+   int notify;
 
-   wmb();
-   vr->avail->idx += num_added;
+   if (vq->packed) {
+           /* buffers are already available: check device event
+            * suppression (event index is never negotiated)
+            */
+           mb();
+           notify = (vq->vring_packed.device->flags !=
+                     VRING_PACKED_EVENT_FLAG_DISABLE);
+   } else {
+           wmb();
+           vr->avail->idx += num_added;
+
+           mb();
+           notify = !(vr->used->flags & VRING_USED_F_NO_NOTIFY);
+   }
 
-   mb();
-   if (!(vr->used->flags & VRING_USED_F_NO_NOTIFY)) {
+   if (notify) {
            if (vdev) {
                    /* virtio 1.0 */
                    vpm_notify(vdev, vq);
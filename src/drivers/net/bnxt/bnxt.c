@@ -349,14 +349,14 @@ int bnxt_free_rx_iob ( struct bnxt *bp )
 }
 
 static void bnxt_set_rx_desc ( u8 *buf, struct io_buffer *iob,
-			       u16 cid, u32 idx )
+			       u16 cid, u32 idx, u16 len )
 {
 	struct rx_prod_pkt_bd *desc;
 	u16 off = cid * sizeof ( struct rx_prod_pkt_bd );
 
 	desc = ( struct rx_prod_pkt_bd * ) &buf[off];
 	desc->flags_type = RX_PROD_PKT_BD_TYPE_RX_PROD_PKT;
-	desc->len   	 = MAX_ETHERNET_PACKET_BUFFER_SIZE;
+	desc->len   	 = len;
 	desc->opaque	 = idx;
 	desc->dma        = iob_dma ( iob );
 }
@@ -365,7 +365,7 @@ static int bnxt_alloc_rx_iob ( struct bnxt *bp, u16 cons_id, u16 iob_idx )
 {
 	struct io_buffer *iob;
 
-	iob = alloc_rx_iob ( BNXT_RX_STD_DMA_SZ, bp->dma );
+	iob = alloc_rx_iob ( BNXT_RX_DMA_SZ ( bp->mtu ), bp->dma );
 	if ( !iob ) {
 		DBGP ( "- %s (  ): alloc_iob Failed\n", __func__ );
 		return -ENOMEM;
@@ -373,7 +373,7 @@ static int bnxt_alloc_rx_iob ( struct bnxt *bp, u16 cons_id, u16 iob_idx )
 
 	dbg_alloc_rx_iob ( iob, iob_idx, cons_id );
 	bnxt_set_rx_desc ( ( u8 * )bp->rx.bd_virt, iob, cons_id,
-			   ( u32 ) iob_idx );
+			   ( u32 ) iob_idx, bp->mtu );
 	bp->rx.iob[iob_idx] = iob;
 	return 0;
 }
@@ -445,6 +445,11 @@ u8 bnxt_rx_drop ( struct bnxt *bp, struct io_buffer *iob,
 
 	iob_put ( iob, rx_len );
 
+	/* Record hardware-verified transport-layer checksum */
+	if ( ( rx_cmp_hi->flags2 & RX_PKT_CMPL_FLAGS2_L4_CS_CALC ) &&
+	     ! ( rx_cmp_hi->errors_v2 & RX_PKT_CMPL_ERRORS_L4_CS_ERROR ) )
+		iob->flags |= IOB_CSUM_VALID;
+
 	bp->rx.good++;
 	return 0;
 }
@@ -519,6 +524,19 @@ void bnxt_mm_init_hwrm ( struct bnxt *bp, const char *func )
 	dbg_mem ( bp, func );
 }
 
+/**
+ * Get receive buffer size for the current MTU
+ */
+static u16 bnxt_rx_buf_size ( struct bnxt *bp )
+{
+	/* Hold a complete frame (with VLAN tag and CRC) in one buffer */
+	size_t len = ( bp->dev->mtu + ETH_HLEN + VLAN_HDR_SIZE + 4 );
+
+	if ( len < MAX_ETHERNET_PACKET_BUFFER_SIZE )
+		len = MAX_ETHERNET_PACKET_BUFFER_SIZE;
+	return ( ( len + 63 ) & ~63 );
+}
+
 void bnxt_mm_init_rings ( struct bnxt *bp, const char *func )
 {
 	DBGP ( "%s\n", __func__ );
@@ -529,7 +547,7 @@ void bnxt_mm_init_rings ( struct bnxt *bp, const char *func )
 
 	bp->link_status = STATUS_LINK_DOWN;
 	bp->wait_link_timeout = LINK_DEFAULT_TIMEOUT;
-	bp->mtu = MAX_ETHERNET_PACKET_BUFFER_SIZE;
+	bp->mtu = bnxt_rx_buf_size ( bp );
 	bp->nq.ring_cnt 	  = MAX_NQ_DESC_CNT;
 	bp->cq.ring_cnt 	  = MAX_CQ_DESC_CNT;
 	bp->tx.ring_cnt 	  = MAX_TX_DESC_CNT;
@@ -559,7 +577,7 @@ void bnxt_mm_nic ( struct bnxt *bp )
 	bp->rx.iob_cnt		= 0;
 	bp->rx.epoch		= 0;
 
-	bp->mtu 		= MAX_ETHERNET_PACKET_BUFFER_SIZE;
+	bp->mtu 		= bnxt_rx_buf_size ( bp );
 	bp->nq.ring_cnt		= MAX_NQ_DESC_CNT;
 	bp->cq.ring_cnt		= MAX_CQ_DESC_CNT;
 	bp->tx.ring_cnt		= MAX_TX_DESC_CNT;
@@ -1866,7 +1884,7 @@ static int bnxt_hwrm_ring_alloc ( struct bnxt *bp, u8 type )
 	        if ( ! ( FLAG_TEST ( bp->flags, BNXT_FLAG_IS_CHIP_P5_PLUS ) ) )
 			break;
 		req->queue_id    = ( u16 ) RX_RING_QID;
-		req->rx_buf_size = MAX_ETHERNET_PACKET_BUFFER_SIZE;
+		req->rx_buf_size = bp->mtu;
 		req->enables	 = RING_ALLOC_REQ_ENABLES_RX_BUF_SIZE_VALID;
 		break;
 	default:
@@ -2809,6 +2827,10 @@ static int bnxt_init_one ( struct pci_device *pci )
 	bp->dma = &pci->dma;
 	netdev->dma = bp->dma;
 
+	/* Allow jumbo frames, while defaulting to a standard MTU */
+	netdev->max_pkt_len = ( BNXT_MAX_MTU + ETH_HLEN );
+	netdev->mtu = ETH_MAX_MTU;
+
 	/* Enable PCI device */
 	adjust_pci_device ( pci );
 
@@ -25,6 +25,7 @@
 #define __be32  u32
 #define __be64  u64
 
+#include <config/netdev.h>
 #include "bnxt_hsi.h"
 
 #define DRV_MODULE_NAME              "bnxt"
@@ -138,15 +139,16 @@
 #define HWRM_CMD_FLASH_ERASE_MULTIPLAYER(a)     ((a) * 1000)
 #define HWRM_CMD_WAIT(b) ((bp->hwrm_cmd_timeout) * (b))
 #define MAX_ETHERNET_PACKET_BUFFER_SIZE         1536
+#define BNXT_MAX_MTU                            9500
 #define DEFAULT_NUMBER_OF_CMPL_RINGS            0x01
 #define DEFAULT_NUMBER_OF_TX_RINGS              0x01
 #define DEFAULT_NUMBER_OF_RX_RINGS              0x01
 #define DEFAULT_NUMBER_OF_RING_GRPS             0x01
 #define DEFAULT_NUMBER_OF_STAT_CTXS             0x01
-#define NUM_RX_BUFFERS                          8
-#define MAX_RX_DESC_CNT                         16
+#define NUM_RX_BUFFERS                          BNXT_NUM_RX_BUFFERS
+#define MAX_RX_DESC_CNT                         (2 * NUM_RX_BUFFERS)
 #define MAX_TX_DESC_CNT                         64
-#define MAX_CQ_DESC_CNT                         128
+#define MAX_CQ_DESC_CNT                         256
 #define TX_RING_BUFFER_SIZE (MAX_TX_DESC_CNT * sizeof(struct tx_bd_short))
 #define RX_RING_BUFFER_SIZE \
 	(MAX_RX_DESC_CNT * sizeof(struct rx_prod_pkt_bd))
@@ -157,7 +159,7 @@
 #define RESP_BUFFER_SIZE                        1024
 #define DMA_BUFFER_SIZE                         1024
 #define LM_PAGE_BITS(a)                         (a)
-#define BNXT_RX_STD_DMA_SZ                      (1536 + 64 + 2)
+#define BNXT_RX_DMA_SZ(len)                     ((len) + 64 + 2)
 #define NEXT_IDX(N, S)                          (((N) + 1) & ((S) - 1))
 #define BD_NOW(bd, entry, len) (&((u8 *)(bd))[(entry) * (len)])
 #define BNXT_CQ_INTR_MODE(vf) (\
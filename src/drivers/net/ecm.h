@@ -13,6 +13,7 @@ FILE_SECBOOT ( PERMITTED );
 #include <ipxe/usb.h>
 #include <ipxe/usbnet.h>
 #include <ipxe/cdc.h>
+#include <config/netdev.h>
 
 /** CDC-ECM subclass */
 #define USB_SUBCLASS_CDC_ECM 0x06
@@ -72,12 +73,6 @@ struct ecm_device {
  */
 #define ECM_INTR_MAX_FILL 2
 
-/** Bulk IN maximum fill level
- *
- * This is a policy decision.
- */
-#define ECM_IN_MAX_FILL 8
-
 /** Bulk IN buffer size
  *
  * This is a policy decision.
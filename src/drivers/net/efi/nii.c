@@ -29,6 +29,7 @@ FILE_SECBOOT ( PERMITTED );
 #include <stdlib.h>
 #include <unistd.h>
 #include <errno.h>
+#include <assert.h>
 #include <ipxe/netdevice.h>
 #include <ipxe/ethernet.h>
 #include <ipxe/if_ether.h>
@@ -150,6 +151,13 @@ struct nii_mapping {
 	VOID *mapping;
 };
 
+/** Maximum number of transmissions in progress
+ *
+ * The UNDI reports recycled transmit buffers via GET_STATUS, which
+ * can return at most MAX_XMIT_BUFFERS addresses at a time.
+ */
+#define NII_TX_MAX 16
+
 /** An NII NIC */
 struct nii_nic {
 	/** EFI device */
@@ -188,8 +196,12 @@ struct nii_nic {
 	/** Media status is supported */
 	int media;
 
-	/** Current transmit buffer */
-	struct io_buffer *txbuf;
+	/** Transmit buffers in progress */
+	struct io_buffer *txbuf[NII_TX_MAX];
+	/** Maximum number of transmissions in progress */
+	unsigned int tx_max;
+	/** Number of transmissions in progress */
+	unsigned int tx_count;
 	/** Current receive buffer */
 	struct io_buffer *rxbuf;
 
@@ -198,7 +210,7 @@ struct nii_nic {
 };
 
 /** Maximum number of received packets per poll */
-#define NII_RX_QUOTA 4
+#define NII_RX_QUOTA NETDEV_RX_BUDGET
 
 /**
  * Open PCI I/O protocol and identify BARs
@@ -734,6 +746,17 @@ static int nii_get_init_info ( struct nii_nic *nii,
 	netdev->max_pkt_len = nii->mtu;
 	nii->media = ( stat & PXE_STATFLAGS_GET_STATUS_NO_MEDIA_SUPPORTED );
 
+	/* Allow as many transmissions in progress as the UNDI has
+	 * transmit buffers, up to our own limit.
+	 */
+	nii->tx_max = db.TxBufCnt;
+	if ( nii->tx_max > NII_TX_MAX )
+		nii->tx_max = NII_TX_MAX;
+	if ( ! nii->tx_max )
+		nii->tx_max = 1;
+	DBGC ( nii, "NII %s allows %d transmissions in progress\n",
+	       nii->dev.name, nii->tx_max );
+
 	return 0;
 }
 
@@ -985,11 +1008,12 @@ static int nii_transmit ( struct net_device *netdev,
 	struct nii_nic *nii = netdev->priv;
 	PXE_CPB_TRANSMIT cpb;
 	unsigned int op;
+	unsigned int i;
 	int stat;
 	int rc;
 
-	/* Defer the packet if there is already a transmission in progress */
-	if ( nii->txbuf ) {
+	/* Defer the packet if too many transmissions are in progress */
+	if ( nii->tx_count >= nii->tx_max ) {
 		netdev_tx_defer ( netdev, iobuf );
 		return 0;
 	}
@@ -1010,38 +1034,98 @@ static int nii_transmit ( struct net_device *netdev,
 		      ( PXE_OPFLAGS_TRANSMIT_WHOLE |
 			PXE_OPFLAGS_TRANSMIT_DONT_BLOCK ) );
 	if ( ( stat = nii_issue_cpb ( nii, op, &cpb, sizeof ( cpb ) ) ) < 0 ) {
+
+		/* Defer the packet if the UNDI's transmit queue is
+		 * full, provided that a completion is still pending.
+		 */
+		if ( ( ( stat == -PXE_STATCODE_QUEUE_FULL ) ||
+		       ( stat == -PXE_STATCODE_BUSY ) ) && nii->tx_count ) {
+			netdev_tx_defer ( netdev, iobuf );
+			return 0;
+		}
+
 		rc = -EIO_STAT ( stat );
 		DBGC ( nii, "NII %s could not transmit: %s\n",
 		       nii->dev.name, strerror ( rc ) );
 		return rc;
 	}
-	nii->txbuf = iobuf;
+
+	/* Record transmit buffer */
+	for ( i = 0 ; i < nii->tx_max ; i++ ) {
+		if ( ! nii->txbuf[i] )
+			break;
+	}
+	assert ( i < nii->tx_max );
+	nii->txbuf[i] = iobuf;
+	nii->tx_count++;
 
 	return 0;
 }
 
+/**
+ * Complete transmission
+ *
+ * @v netdev		Network device
+ * @v i			Transmit buffer index
+ */
+static void nii_complete_tx ( struct net_device *netdev, unsigned int i ) {
+	struct nii_nic *nii = netdev->priv;
+	struct io_buffer *iobuf = nii->txbuf[i];
+
+	nii->txbuf[i] = NULL;
+	nii->tx_count--;
+	netdev_tx_complete ( netdev, iobuf );
+}
+
 /**
  * Poll for completed packets
  *
  * @v netdev		Network device
  * @v stat		Status flags
+ * @v db		Status data block
  */
-static void nii_poll_tx ( struct net_device *netdev, unsigned int stat ) {
+static void nii_poll_tx ( struct net_device *netdev, unsigned int stat,
+			  PXE_DB_GET_STATUS *db ) {
 	struct nii_nic *nii = netdev->priv;
 	struct io_buffer *iobuf;
+	UINT64 addr;
+	unsigned int i;
+	unsigned int j;
 
 	/* Do nothing unless we have a completion */
 	if ( stat & PXE_STATFLAGS_GET_STATUS_NO_TXBUFS_WRITTEN )
 		return;
 
 	/* Ignore spurious completions reported by some devices */
-	if ( ! nii->txbuf )
+	if ( ! nii->tx_count )
 		return;
 
-	/* Complete transmission */
-	iobuf = nii->txbuf;
-	nii->txbuf = NULL;
-	netdev_tx_complete ( netdev, iobuf );
+	/* With only a single transmission in progress, complete it
+	 * without checking the reported buffer address, since not
+	 * all UNDIs report this correctly.
+	 */
+	if ( nii->tx_max == 1 ) {
+		nii_complete_tx ( netdev, 0 );
+		return;
+	}
+
+	/* Complete each reported transmit buffer */
+	for ( i = 0 ; i < MAX_XMIT_BUFFERS ; i++ ) {
+		addr = db->TxBuffer[i];
+		if ( ! addr )
+			break;
+		for ( j = 0 ; j < nii->tx_max ; j++ ) {
+			iobuf = nii->txbuf[j];
+			if ( iobuf && ( addr == ( ( intptr_t ) iobuf->data ) ) )
+				break;
+		}
+		if ( j == nii->tx_max ) {
+			DBGC ( nii, "NII %s spurious TX completion %#08llx\n",
+			       nii->dev.name, ( ( unsigned long long ) addr ) );
+			continue;
+		}
+		nii_complete_tx ( netdev, j );
+	}
 }
 
 /**
@@ -1144,7 +1228,7 @@ static void nii_poll ( struct net_device *netdev ) {
 	}
 
 	/* Process any TX completions */
-	nii_poll_tx ( netdev, stat );
+	nii_poll_tx ( netdev, stat, &db );
 
 	/* Process any RX completions */
 	nii_poll_rx ( netdev );
@@ -1233,15 +1317,20 @@ static int nii_open ( struct net_device *netdev ) {
  */
 static void nii_close ( struct net_device *netdev ) {
 	struct nii_nic *nii = netdev->priv;
+	unsigned int i;
 
 	/* Shut down NIC */
 	nii_shutdown ( nii );
 
-	/* Discard transmit buffer, if applicable */
-	if ( nii->txbuf ) {
-		netdev_tx_complete_err ( netdev, nii->txbuf, -ECANCELED );
-		nii->txbuf = NULL;
+	/* Discard transmit buffers, if applicable */
+	for ( i = 0 ; i < NII_TX_MAX ; i++ ) {
+		if ( nii->txbuf[i] ) {
+			netdev_tx_complete_err ( netdev, nii->txbuf[i],
+						 -ECANCELED );
+			nii->txbuf[i] = NULL;
+		}
 	}
+	nii->tx_count = 0;
 
 	/* Discard receive buffer, if applicable */
 	if ( nii->rxbuf ) {
@@ -24,6 +24,7 @@ FILE_SECBOOT ( PERMITTED );
 #include <stdio.h>
 #include <string.h>
 #include <errno.h>
+#include <assert.h>
 #include <ipxe/iobuf.h>
 #include <ipxe/netdevice.h>
 #include <ipxe/ethernet.h>
@@ -43,6 +44,14 @@ FILE_SECBOOT ( PERMITTED );
  *
  */
 
+/** Maximum number of transmissions in progress
+ *
+ * This limit applies only to SNP implementations that report support
+ * for multiple simultaneous transmit requests.  Other implementations
+ * are limited to a single transmission in progress.
+ */
+#define SNP_TX_MAX 16
+
 /** An SNP NIC */
 struct snp_nic {
 	/** EFI device */
@@ -59,14 +68,18 @@ struct snp_nic {
 	 */
 	size_t mtu;
 
-	/** Current transmit buffer */
-	struct io_buffer *txbuf;
+	/** Transmit buffers in progress */
+	struct io_buffer *txbuf[SNP_TX_MAX];
+	/** Maximum number of transmissions in progress */
+	unsigned int tx_max;
+	/** Number of transmissions in progress */
+	unsigned int tx_count;
 	/** Current receive buffer */
 	struct io_buffer *rxbuf;
 };
 
 /** Maximum number of received packets per poll */
-#define SNP_RX_QUOTA 4
+#define SNP_RX_QUOTA NETDEV_RX_BUDGET
 
 /** Maximum initialisation retry count */
 #define SNP_INITIALIZE_RETRY_MAX 10
@@ -185,6 +198,7 @@ static void snpnet_check_link ( struct net_device *netdev ) {
 static int snpnet_transmit ( struct net_device *netdev,
 			     struct io_buffer *iobuf ) {
 	struct snp_nic *snp = netdev->priv;
+	unsigned int i;
 	EFI_STATUS efirc;
 	int rc;
 
@@ -192,8 +206,8 @@ static int snpnet_transmit ( struct net_device *netdev,
 	if ( efi_shutdown_in_progress )
 		return -ECANCELED;
 
-	/* Defer the packet if there is already a transmission in progress */
-	if ( snp->txbuf ) {
+	/* Defer the packet if too many transmissions are in progress */
+	if ( snp->tx_count >= snp->tx_max ) {
 		netdev_tx_defer ( netdev, iobuf );
 		return 0;
 	}
@@ -208,12 +222,29 @@ static int snpnet_transmit ( struct net_device *netdev,
 	if ( ( efirc = snp->snp->Transmit ( snp->snp, 0, iob_len ( iobuf ),
 					    iobuf->data, NULL, NULL,
 					    NULL ) ) != 0 ) {
+
+		/* Defer the packet if the transmit queue is full
+		 * and at least one completion is still to come.
+		 */
+		if ( ( efirc == EFI_NOT_READY ) && snp->tx_count ) {
+			netdev_tx_defer ( netdev, iobuf );
+			return 0;
+		}
+
 		rc = -EEFI ( efirc );
 		DBGC ( snp, "SNP %s could not transmit: %s\n",
 		       netdev->name, strerror ( rc ) );
 		return rc;
 	}
-	snp->txbuf = iobuf;
+
+	/* Record transmit buffer */
+	for ( i = 0 ; i < snp->tx_max ; i++ ) {
+		if ( ! snp->txbuf[i] )
+			break;
+	}
+	assert ( i < snp->tx_max );
+	snp->txbuf[i] = iobuf;
+	snp->tx_count++;
 
 	return 0;
 }
@@ -228,35 +259,55 @@ static void snpnet_poll_tx ( struct net_device *netdev ) {
 	struct io_buffer *iobuf;
 	UINT32 irq;
 	VOID *txbuf;
+	unsigned int i;
 	EFI_STATUS efirc;
 	int rc;
 
-	/* Get status */
-	txbuf = NULL;
-	if ( ( efirc = snp->snp->GetStatus ( snp->snp, &irq, &txbuf ) ) != 0 ) {
-		rc = -EEFI ( efirc );
-		DBGC ( snp, "SNP %s could not get status: %s\n",
-		       netdev->name, strerror ( rc ) );
-		netdev_rx_err ( netdev, NULL, rc );
-		return;
-	}
+	/* Collect all available completions.  Note that GetStatus()
+	 * is called at least once per poll, even with no
+	 * transmissions in progress, since some implementations rely
+	 * upon this to make progress.
+	 */
+	while ( 1 ) {
 
-	/* Do nothing unless we have a completion */
-	if ( ! txbuf )
-		return;
+		/* Get status */
+		txbuf = NULL;
+		if ( ( efirc = snp->snp->GetStatus ( snp->snp, &irq,
+						     &txbuf ) ) != 0 ) {
+			rc = -EEFI ( efirc );
+			DBGC ( snp, "SNP %s could not get status: %s\n",
+			       netdev->name, strerror ( rc ) );
+			netdev_rx_err ( netdev, NULL, rc );
+			return;
+		}
 
-	/* Sanity check */
-	if ( ! snp->txbuf ) {
-		DBGC ( snp, "SNP %s reported spurious TX completion\n",
-		       netdev->name );
-		netdev_tx_err ( netdev, NULL, -EPIPE );
-		return;
-	}
+		/* Stop when there are no further completions */
+		if ( ! txbuf )
+			return;
+
+		/* Identify transmit buffer.  Implementations that
+		 * support only a single transmission in progress are
+		 * not required to return the original buffer address.
+		 */
+		iobuf = NULL;
+		for ( i = 0 ; i < snp->tx_max ; i++ ) {
+			iobuf = snp->txbuf[i];
+			if ( iobuf && ( ( snp->tx_max == 1 ) ||
+					( txbuf == iobuf->data ) ) )
+				break;
+		}
+		if ( i == snp->tx_max ) {
+			DBGC ( snp, "SNP %s reported spurious TX completion "
+			       "%p\n", netdev->name, txbuf );
+			netdev_tx_err ( netdev, NULL, -EPIPE );
+			return;
+		}
 
-	/* Complete transmission */
-	iobuf = snp->txbuf;
-	snp->txbuf = NULL;
-	netdev_tx_complete ( netdev, iobuf );
+		/* Complete transmission */
+		snp->txbuf[i] = NULL;
+		snp->tx_count--;
+		netdev_tx_complete ( netdev, iobuf );
+	}
 }
 
 /**
@@ -266,11 +317,14 @@ static void snpnet_poll_tx ( struct net_device *netdev ) {
  */
 static void snpnet_poll_rx ( struct net_device *netdev ) {
 	struct snp_nic *snp = netdev->priv;
+	struct list_head received;
 	UINTN len;
 	unsigned int quota;
 	EFI_STATUS efirc;
 	int rc;
 
+	INIT_LIST_HEAD ( &received );
+
 	/* Retrieve up to SNP_RX_QUOTA packets */
 	for ( quota = SNP_RX_QUOTA ; quota ; quota-- ) {
 
@@ -303,11 +357,14 @@ static void snpnet_poll_rx ( struct net_device *netdev ) {
 			break;
 		}
 
-		/* Hand off to network stack */
+		/* Collect received packet */
 		iob_put ( snp->rxbuf, len );
-		netdev_rx ( netdev, snp->rxbuf );
+		list_add_tail ( &snp->rxbuf->list, &received );
 		snp->rxbuf = NULL;
 	}
+
+	/* Hand off received packets to network stack */
+	netdev_rx_batch ( netdev, &received );
 }
 
 /**
@@ -451,6 +508,10 @@ static int snpnet_open ( struct net_device *netdev ) {
 		/* Ignore error */
 	}
 
+	/* Allow multiple transmissions in progress, if supported */
+	snp->tx_max = ( mode->MultipleTxSupported ? SNP_TX_MAX : 1 );
+	snp->tx_count = 0;
+
 	/* Dump mode information (for debugging) */
 	snpnet_dump_mode ( netdev );
 
@@ -464,6 +525,7 @@ static int snpnet_open ( struct net_device *netdev ) {
  */
 static void snpnet_close ( struct net_device *netdev ) {
 	struct snp_nic *snp = netdev->priv;
+	unsigned int i;
 	EFI_STATUS efirc;
 	int rc;
 
@@ -479,11 +541,15 @@ static void snpnet_close ( struct net_device *netdev ) {
 		/* Nothing we can do about this */
 	}
 
-	/* Discard transmit buffer, if applicable */
-	if ( snp->txbuf ) {
-		netdev_tx_complete_err ( netdev, snp->txbuf, -ECANCELED );
-		snp->txbuf = NULL;
+	/* Discard transmit buffers, if applicable */
+	for ( i = 0 ; i < snp->tx_max ; i++ ) {
+		if ( snp->txbuf[i] ) {
+			netdev_tx_complete_err ( netdev, snp->txbuf[i],
+						 -ECANCELED );
+			snp->txbuf[i] = NULL;
+		}
 	}
+	snp->tx_count = 0;
 
 	/* Discard receive buffer, if applicable */
 	if ( snp->rxbuf ) {
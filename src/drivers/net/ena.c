@@ -494,6 +494,7 @@ static int ena_create_sq ( struct ena_nic *ena, struct ena_sq *sq,
 
 	/* Reset producer counter and phase */
 	sq->prod = 0;
+	sq->rung = 0;
 	sq->phase = ENA_SQE_PHASE;
 
 	/* Calculate fill level */
@@ -776,6 +777,7 @@ static int ena_llq_config ( struct ena_nic *ena ) {
 	uint16_t desc;
 	uint16_t stride;
 	uint16_t mode;
+	unsigned int burst;
 	int rc;
 
 	/* Construct request */
@@ -797,10 +799,11 @@ static int ena_llq_config ( struct ena_nic *ena ) {
 	desc = le16_to_cpu ( feature->llq.desc.supported );
 	stride = le16_to_cpu ( feature->llq.stride.supported );
 	mode = le16_to_cpu ( feature->llq.mode );
+	burst = le16_to_cpu ( feature->llq.burst );
 	DBGC ( ena, "ENA %p LLQ supports %02x:%02x:%02x:%02x:%02x with %dx%d "
-	       "entries\n", ena, header, size, desc, stride, mode,
-	       le32_to_cpu ( feature->llq.queues ),
-	       le32_to_cpu ( feature->llq.count ) );
+	       "entries (burst %d bytes)\n", ena, header, size, desc, stride,
+	       mode, le32_to_cpu ( feature->llq.queues ),
+	       le32_to_cpu ( feature->llq.count ), burst );
 
 	/* Check for a supported configuration */
 	if ( ! feature->llq.queues ) {
@@ -853,6 +856,17 @@ static int ena_llq_config ( struct ena_nic *ena ) {
 	ena->tx.sq.policy |= ENA_SQ_DEVICE_MEMORY;
 	ena->tx.sq.inlined = sizeof ( ena->tx.sq.sqe.llq->inlined );
 
+	/* Limit number of entries written per doorbell, if applicable */
+	if ( mode & ENA_LLQ_MODE_LIMIT_BURST ) {
+		burst /= sizeof ( *ena->tx.sq.sqe.llq );
+		if ( ! burst )
+			burst = 1;
+		if ( burst < ena->tx.sq.burst )
+			ena->tx.sq.burst = burst;
+		DBGC ( ena, "ENA %p LLQ limited to %d entries per doorbell\n",
+		       ena, ena->tx.sq.burst );
+	}
+
 	return 0;
 }
 
@@ -1056,6 +1070,22 @@ static void ena_close ( struct net_device *netdev ) {
 	ena_cancel_tx ( netdev );
 }
 
+/**
+ * Ring transmit doorbell for any pending submission queue entries
+ *
+ * @v ena		ENA device
+ */
+static void ena_flush_tx ( struct ena_nic *ena ) {
+
+	/* Do nothing unless entries are pending */
+	if ( ena->tx.sq.rung == ena->tx.sq.prod )
+		return;
+
+	/* Ring doorbell */
+	writel ( ena->tx.sq.prod, ( ena->regs + ena->tx.sq.doorbell ) );
+	ena->tx.sq.rung = ena->tx.sq.prod;
+}
+
 /**
  * Transmit packet
  *
@@ -1140,8 +1170,12 @@ static int ena_transmit ( struct net_device *netdev, struct io_buffer *iobuf ) {
 	assert ( ena->tx_iobuf[id] == NULL );
 	ena->tx_iobuf[id] = iobuf;
 
-	/* Ring doorbell */
-	writel ( ena->tx.sq.prod, ( ena->regs + ena->tx.sq.doorbell ) );
+	/* Ring doorbell only if a full burst is pending: any partial
+	 * burst will be flushed on the next poll, allowing several
+	 * packets to share a single doorbell write.
+	 */
+	if ( ( ena->tx.sq.prod - ena->tx.sq.rung ) >= ena->tx.sq.burst )
+		ena_flush_tx ( ena );
 
 	DBGC2 ( ena, "ENA %p TX %d at [%08llx,%08llx)\n", ena, id,
 		( ( unsigned long long ) address ),
@@ -1192,6 +1226,30 @@ static void ena_poll_tx ( struct net_device *netdev ) {
 	}
 }
 
+/**
+ * Check whether received packet has a verified transport-layer checksum
+ *
+ * @v cqe		Receive completion queue entry
+ * @ret valid		Transport-layer checksum has been verified
+ */
+static int ena_rx_csum_valid ( struct ena_rx_cqe *cqe ) {
+
+	/* Check that checksum was verified without error */
+	if ( ! ( cqe->csum & ENA_RX_CQE_CSUM_L4_CHECKED ) )
+		return 0;
+	if ( cqe->l4 & ( ENA_RX_CQE_L4_CSUM_ERR | ENA_RX_CQE_L4_IPV4_FRAG ) )
+		return 0;
+
+	/* Check that packet has a recognised transport-layer protocol */
+	switch ( ENA_RX_CQE_L4_PROTO ( cqe->l4 ) ) {
+	case ENA_RX_CQE_L4_PROTO_TCP:
+	case ENA_RX_CQE_L4_PROTO_UDP:
+		return 1;
+	default:
+		return 0;
+	}
+}
+
 /**
  * Poll for received packets
  *
@@ -1231,6 +1289,8 @@ static void ena_poll_rx ( struct net_device *netdev ) {
 		ena->rx_iobuf[id] = NULL;
 		len = le16_to_cpu ( cqe->len );
 		iob_put ( iobuf, len );
+		if ( ena_rx_csum_valid ( cqe ) )
+			iobuf->flags |= IOB_CSUM_VALID;
 
 		/* Hand off to network stack */
 		DBGC2 ( ena, "ENA %p RX %d complete (length %zd)\n",
@@ -1245,6 +1305,10 @@ static void ena_poll_rx ( struct net_device *netdev ) {
  * @v netdev		Network device
  */
 static void ena_poll ( struct net_device *netdev ) {
+	struct ena_nic *ena = netdev->priv;
+
+	/* Ring doorbell for any deferred transmissions */
+	ena_flush_tx ( ena );
 
 	/* Poll for transmit completions */
 	ena_poll_tx ( netdev );
@@ -174,7 +174,7 @@ struct ena_llq_config {
 	uint8_t reserved_a[4];
 	/** Acceleration mode */
 	uint16_t mode;
-	/** Maximum burst size */
+	/** Maximum burst size (in bytes) */
 	uint16_t burst;
 	/** Reserved */
 	uint8_t reserved_b[4];
@@ -198,6 +198,12 @@ enum ena_llq_desc {
 	ENA_LLQ_DESC_2 = 0x0002,
 };
 
+/** Low latency queue acceleration modes */
+enum ena_llq_mode {
+	/** Number of bytes written per doorbell is limited */
+	ENA_LLQ_MODE_LIMIT_BURST = 0x0002,
+};
+
 /** Async event notification queue config */
 #define ENA_AENQ_CONFIG 26
 
@@ -693,7 +699,11 @@ struct ena_tx_cqe {
 /** Receive completion queue entry */
 struct ena_rx_cqe {
 	/** Reserved */
-	uint8_t reserved_a[3];
+	uint8_t reserved_a[1];
+	/** Transport-layer protocol and checksum errors */
+	uint8_t l4;
+	/** Checksum status */
+	uint8_t csum;
 	/** Flags */
 	uint8_t flags;
 	/** Length */
@@ -704,6 +714,24 @@ struct ena_rx_cqe {
 	uint8_t reserved_b[8];
 } __attribute__ (( packed ));
 
+/** Receive completion transport-layer protocol */
+#define ENA_RX_CQE_L4_PROTO( l4 ) ( (l4) & 0x1f )
+
+/** Receive completion transport-layer protocol: TCP */
+#define ENA_RX_CQE_L4_PROTO_TCP 12
+
+/** Receive completion transport-layer protocol: UDP */
+#define ENA_RX_CQE_L4_PROTO_UDP 13
+
+/** Receive completion transport-layer checksum error */
+#define ENA_RX_CQE_L4_CSUM_ERR 0x40
+
+/** Receive completion IPv4 fragment */
+#define ENA_RX_CQE_L4_IPV4_FRAG 0x80
+
+/** Receive completion transport-layer checksum was checked */
+#define ENA_RX_CQE_CSUM_L4_CHECKED 0x01
+
 /** Completion queue ownership phase flag */
 #define ENA_CQE_PHASE 0x01
 
@@ -740,6 +768,8 @@ struct ena_sq {
 	size_t len;
 	/** Producer counter */
 	unsigned int prod;
+	/** Producer counter as last written to doorbell */
+	unsigned int rung;
 	/** Phase */
 	unsigned int phase;
 	/** Queue policy */
@@ -754,6 +784,8 @@ struct ena_sq {
 	uint8_t fill;
 	/** Maximum inline header length */
 	uint8_t inlined;
+	/** Maximum number of entries per doorbell */
+	uint8_t burst;
 };
 
 /**
@@ -773,6 +805,7 @@ ena_sq_init ( struct ena_sq *sq, unsigned int direction, unsigned int count,
 	sq->policy = ( ENA_SQ_HOST_MEMORY | ENA_SQ_CONTIGUOUS );
 	sq->direction = direction;
 	sq->count = count;
+	sq->burst = count;
 	sq->ids = ids;
 }
 
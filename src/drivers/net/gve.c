@@ -131,6 +131,23 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
  ******************************************************************************
  */
 
+/**
+ * Check whether I/O buffers are used directly for DMA
+ *
+ * @v gve		GVE device
+ * @ret direct		I/O buffers are used directly for DMA
+ *
+ * In the DQO-RDA operating mode, the device accepts arbitrary DMA
+ * addresses in both transmit and receive descriptors.  There is then
+ * no need to copy packets via the queue page list buffers, since I/O
+ * buffers may be mapped and used directly.
+ */
+static inline __attribute__ (( always_inline )) int
+gve_direct ( struct gve_nic *gve ) {
+
+	return ( gve->mode == GVE_MODE_DQO );
+}
+
 /**
  * Get buffer offset (within queue page list allocation)
  *
@@ -559,7 +576,10 @@ static int gve_describe ( struct gve_nic *gve ) {
 	DBGC ( gve, "GVE %p supports options %#08x\n", gve, gve->options );
 
 	/* Select preferred operating mode */
-	if ( gve->options & ( 1 << GVE_OPT_GQI_QPL ) ) {
+	if ( gve->options & ( 1 << GVE_OPT_DQO_RDA ) ) {
+		/* DQO-RDA: out-of-order queues, raw DMA addressing */
+		gve->mode = GVE_MODE_DQO;
+	} else if ( gve->options & ( 1 << GVE_OPT_GQI_QPL ) ) {
 		/* GQI-QPL: in-order queues, queue page list addressing */
 		gve->mode = GVE_MODE_QPL;
 	} else if ( gve->options & ( 1 << GVE_OPT_GQI_RDA ) ) {
@@ -568,9 +588,6 @@ static int gve_describe ( struct gve_nic *gve ) {
 	} else if ( gve->options & ( 1 << GVE_OPT_DQO_QPL ) ) {
 		/* DQO-QPL: out-of-order queues, queue page list addressing */
 		gve->mode = ( GVE_MODE_DQO | GVE_MODE_QPL );
-	} else if ( gve->options & ( 1 << GVE_OPT_DQO_RDA ) ) {
-		/* DQO-RDA: out-of-order queues, raw DMA addressing */
-		gve->mode = GVE_MODE_DQO;
 	} else {
 		/* No options matched: assume the original GQI-QPL mode */
 		gve->mode = GVE_MODE_QPL;
@@ -928,6 +945,14 @@ static int gve_alloc_qpl ( struct gve_nic *gve, struct gve_qpl *qpl,
 	/* Record ID */
 	qpl->id = id;
 
+	/* Do nothing if no data buffers are required */
+	if ( ! buffers ) {
+		qpl->count = 0;
+		qpl->data = NULL;
+		qpl->base = 0;
+		return 0;
+	}
+
 	/* Calculate number of pages required */
 	build_assert ( GVE_BUF_SIZE <= GVE_PAGE_SIZE );
 	qpl->count = ( ( buffers + GVE_BUF_PER_PAGE - 1 ) / GVE_BUF_PER_PAGE );
@@ -957,6 +982,10 @@ static void gve_free_qpl ( struct gve_nic *nic __unused,
 			   struct gve_qpl *qpl ) {
 	size_t len = ( qpl->count * GVE_PAGE_SIZE );
 
+	/* Do nothing if no pages were allocated */
+	if ( ! qpl->count )
+		return;
+
 	/* Free pages */
 	dma_ufree ( &qpl->map, qpl->data, len );
 }
@@ -1023,12 +1052,17 @@ static int gve_alloc_queue ( struct gve_nic *gve, struct gve_queue *queue ) {
 	queue->fill = type->fill;
 	if ( queue->fill > queue->count )
 		queue->fill = queue->count;
+	if ( ( ! gve_direct ( gve ) ) &&
+	     ( queue->fill > ( GVE_QPL_MAX * GVE_BUF_PER_PAGE ) ) ) {
+		queue->fill = ( GVE_QPL_MAX * GVE_BUF_PER_PAGE );
+	}
 	DBGC ( gve, "GVE %p %s using QPL %#08x with %d/%d descriptors\n",
 	       gve, type->name, type->qpl, queue->fill, queue->count );
 
-	/* Allocate queue page list */
+	/* Allocate queue page list, if applicable */
 	if ( ( rc = gve_alloc_qpl ( gve, &queue->qpl, type->qpl,
-				    queue->fill ) ) != 0 )
+				    ( gve_direct ( gve ) ?
+				      0 : queue->fill ) ) ) != 0 )
 		goto err_qpl;
 
 	/* Allocate descriptors */
@@ -1124,6 +1158,23 @@ static void gve_cancel_tx ( struct gve_nic *gve ) {
 	}
 }
 
+/**
+ * Discard any unused receive I/O buffers
+ *
+ * @v gve		GVE device
+ */
+static void gve_empty_rx ( struct gve_nic *gve ) {
+	unsigned int i;
+
+	/* Discard any unused receive buffers */
+	for ( i = 0 ; i < ( sizeof ( gve->rx_iobuf ) /
+			    sizeof ( gve->rx_iobuf[0] ) ) ; i++ ) {
+		if ( gve->rx_iobuf[i] )
+			free_rx_iob ( gve->rx_iobuf[i] );
+		gve->rx_iobuf[i] = NULL;
+	}
+}
+
 /**
  * Start up device
  *
@@ -1138,6 +1189,9 @@ static int gve_start ( struct gve_nic *gve ) {
 	/* Cancel any pending transmissions */
 	gve_cancel_tx ( gve );
 
+	/* Discard any unused receive buffers */
+	gve_empty_rx ( gve );
+
 	/* Reset receive sequence */
 	gve->seq = gve_next ( 0 );
 
@@ -1353,6 +1407,9 @@ static void gve_close ( struct net_device *netdev ) {
 	/* Cancel any pending transmissions */
 	gve_cancel_tx ( gve );
 
+	/* Discard any unused receive buffers */
+	gve_empty_rx ( gve );
+
 	/* Free queues */
 	gve_free_queue ( gve, rx );
 	gve_free_queue ( gve, tx );
@@ -1378,10 +1435,12 @@ static int gve_transmit ( struct net_device *netdev, struct io_buffer *iobuf ) {
 	unsigned int tag;
 	unsigned int chain;
 	uint32_t doorbell;
+	physaddr_t addr;
 	size_t frag_len;
 	size_t offset;
 	size_t next;
 	size_t len;
+	int rc;
 
 	/* Do nothing if queues are not yet set up */
 	if ( ! netdev_link_ok ( netdev ) )
@@ -1389,28 +1448,41 @@ static int gve_transmit ( struct net_device *netdev, struct io_buffer *iobuf ) {
 
 	/* Defer packet if there is no space in the transmit ring */
 	len = iob_len ( iobuf );
-	count = ( ( len + GVE_BUF_SIZE - 1 ) / GVE_BUF_SIZE );
+	count = ( gve_direct ( gve ) ?
+		  1 : ( ( len + GVE_BUF_SIZE - 1 ) / GVE_BUF_SIZE ) );
 	if ( ( ( tx->prod - tx->cons ) + count ) > tx->fill ) {
 		netdev_tx_defer ( netdev, iobuf );
 		return 0;
 	}
 
+	/* Map I/O buffer for direct use, if applicable */
+	if ( gve_direct ( gve ) && ( ! dma_mapped ( &iobuf->map ) ) ) {
+		if ( ( rc = iob_map_tx ( iobuf, gve->dma ) ) != 0 )
+			return rc;
+	}
+
 	/* Copy packet to queue pages and populate descriptors */
 	for ( offset = 0, chain = 0 ; ; offset = next, chain = tag ) {
 
 		/* Identify next available buffer */
 		index = ( tx->prod++ & ( tx->count - 1 ) );
-		tag = tx->tag[ index % GVE_TX_FILL ];
+		tag = tx->tag[ index & ( tx->fill - 1 ) ];
 
 		/* Sanity check */
 		assert ( gve->tx_iobuf[tag] == NULL );
 
-		/* Copy packet fragment */
-		frag_len = ( len - offset );
-		if ( frag_len > GVE_BUF_SIZE )
-			frag_len = GVE_BUF_SIZE;
-		memcpy ( gve_buffer ( tx, tag ),
-			 ( iobuf->data + offset ), frag_len );
+		/* Copy packet fragment, unless using I/O buffer directly */
+		if ( gve_direct ( gve ) ) {
+			frag_len = len;
+			addr = iob_dma ( iobuf );
+		} else {
+			frag_len = ( len - offset );
+			if ( frag_len > GVE_BUF_SIZE )
+				frag_len = GVE_BUF_SIZE;
+			memcpy ( gve_buffer ( tx, tag ),
+				 ( iobuf->data + offset ), frag_len );
+			addr = gve_address ( tx, tag );
+		}
 		next = ( offset + frag_len );
 
 		/* Populate descriptor */
@@ -1418,8 +1490,7 @@ static int gve_transmit ( struct net_device *netdev, struct io_buffer *iobuf ) {
 
 			/* Out-of-order descriptor */
 			dqo = &tx->desc.tx.dqo[index];
-			dqo->buf.addr =
-				cpu_to_le64 ( gve_address ( tx, tag ) );
+			dqo->buf.addr = cpu_to_le64 ( addr );
 			if ( next == len ) {
 				dqo->type = ( GVE_DQO_TX_TYPE_PACKET |
 					      GVE_DQO_TX_TYPE_LAST );
@@ -1451,7 +1522,7 @@ static int gve_transmit ( struct net_device *netdev, struct io_buffer *iobuf ) {
 		}
 		DBGC2 ( gve, "GVE %p TXD %#04x %#02x:%#02x len %#04zx/%#04zx "
 			"at %#08lx\n", gve, index, tag, count, frag_len, len,
-			gve_address ( tx, tag ) );
+			addr );
 
 		/* Record I/O buffer against final descriptor */
 		if ( next == len ) {
@@ -1528,7 +1599,7 @@ static void gve_poll_tx ( struct net_device *netdev ) {
 				DBGC2 ( gve, "GVE %p TXC %#04x %#02x:%#02x "
 					"complete\n", gve, index, tag,
 					dqo->tag.count );
-				tx->tag[ tx->cons++ % GVE_TX_FILL ] = tag;
+				tx->tag[ tx->cons++ & ( tx->fill - 1 ) ] = tag;
 				tag = gve->tx_chain[tag];
 			}
 
@@ -1546,7 +1617,7 @@ static void gve_poll_tx ( struct net_device *netdev ) {
 		while ( count != tx->cons ) {
 			DBGC2 ( gve, "GVE %p TXC %#04x complete\n",
 				gve, tx->cons );
-			tag = ( tx->cons % GVE_TX_FILL );
+			tag = ( tx->cons & ( tx->fill - 1 ) );
 			iobuf = gve->tx_iobuf[tag];
 			gve->tx_iobuf[tag] = NULL;
 			tx->cons++;
@@ -1556,6 +1627,29 @@ static void gve_poll_tx ( struct net_device *netdev ) {
 	}
 }
 
+/**
+ * Check whether received packet has a verified transport-layer checksum
+ *
+ * @v dqo		Final out-of-order receive completion for packet
+ * @ret valid		Transport-layer checksum has been verified
+ *
+ * In-order completions provide only a raw partial checksum, and so
+ * are never treated as having been verified.
+ */
+static int gve_dqo_csum_valid ( struct gve_dqo_rx_completion *dqo ) {
+
+	/* Check that headers were processed without error */
+	if ( ( dqo->flags & ( GVE_DQO_RXF_L3L4P | GVE_DQO_RXF_CSUM_ERR ) ) !=
+	     GVE_DQO_RXF_L3L4P )
+		return 0;
+
+	/* Checksums are not verified beyond IPv6 extension headers */
+	if ( dqo->status & GVE_DQO_RXS_IPV6_EXT )
+		return 0;
+
+	return 1;
+}
+
 /**
  * Poll for received packets
  *
@@ -1567,6 +1661,7 @@ static void gve_poll_rx ( struct net_device *netdev ) {
 	struct gve_gqi_rx_completion *gqi;
 	struct gve_dqo_rx_completion *dqo;
 	struct io_buffer *iobuf;
+	struct io_buffer *buf;
 	unsigned int index;
 	unsigned int gen;
 	unsigned int bit;
@@ -1574,6 +1669,8 @@ static void gve_poll_rx ( struct net_device *netdev ) {
 	unsigned int tag;
 	uint32_t done;
 	size_t total;
+	int direct;
+	int valid;
 	size_t len;
 	int rc;
 
@@ -1629,7 +1726,7 @@ static void gve_poll_rx ( struct net_device *netdev ) {
 
 			/* Parse completion */
 			len = be16_to_cpu ( gqi->len );
-			tag = ( index % GVE_RX_FILL );
+			tag = ( index & ( rx->fill - 1 ) );
 			DBGC2 ( gve, "GVE %p RXC %#04x %#02x:%#02x len %#04zx "
 				"at %#08zx\n", gve, index, gqi->seq,
 				gqi->flags, len, gve_offset ( rx, tag ) );
@@ -1646,8 +1743,13 @@ static void gve_poll_rx ( struct net_device *netdev ) {
 			gve->seq = seq;
 		}
 
-		/* Allocate and populate I/O buffer */
-		iobuf = ( total ? alloc_iob ( total ) : NULL );
+		/* Allocate I/O buffer, unless a packet received into a
+		 * single I/O buffer can be handed off directly
+		 */
+		direct = ( gve_direct ( gve ) && total &&
+			   ( ( done - rx->done ) == 1 ) );
+		iobuf = ( ( total && ! direct ) ? alloc_iob ( total ) : NULL );
+		valid = 0;
 		for ( ; rx->done != done ; rx->done++ ) {
 
 			/* Re-read completion and return tag to ring */
@@ -1657,17 +1759,33 @@ static void gve_poll_rx ( struct net_device *netdev ) {
 				tag = dqo->tag;
 				len = ( le16_to_cpu ( dqo->len ) &
 					( GVE_BUF_SIZE - 1 ) );
-				rx->tag[ rx->cons++ % GVE_RX_FILL ] = tag;
+				rx->tag[ rx->cons++ & ( rx->fill - 1 ) ] = tag;
+				valid = gve_dqo_csum_valid ( dqo );
 			} else {
 				gqi = &rx->cmplt.rx.gqi[index];
-				tag = ( index % GVE_RX_FILL );
+				tag = ( index & ( rx->fill - 1 ) );
 				len = be16_to_cpu ( gqi->len );
 				assert ( rx->cons == rx->done );
 				rx->cons++;
 			}
 
-			/* Copy data */
-			if ( iobuf ) {
+			/* Use or copy data */
+			if ( gve_direct ( gve ) ) {
+				buf = gve->rx_iobuf[tag];
+				gve->rx_iobuf[tag] = NULL;
+				assert ( buf != NULL );
+				if ( direct ) {
+					iobuf = buf;
+					iob_put ( iobuf, len );
+					continue;
+				}
+				iob_unmap ( buf );
+				if ( iobuf ) {
+					memcpy ( iob_put ( iobuf, len ),
+						 buf->data, len );
+				}
+				free_iob ( buf );
+			} else if ( iobuf ) {
 				memcpy ( iob_put ( iobuf, len ),
 					 gve_buffer ( rx, tag ), len );
 			}
@@ -1677,8 +1795,11 @@ static void gve_poll_rx ( struct net_device *netdev ) {
 
 		/* Hand off packet to network stack */
 		if ( iobuf ) {
-			if ( ! ( gve->mode & GVE_MODE_DQO ) )
+			if ( ! ( gve->mode & GVE_MODE_DQO ) ) {
 				iob_pull ( iobuf, GVE_GQI_RX_PAD );
+			} else if ( valid ) {
+				iobuf->flags |= IOB_CSUM_VALID;
+			}
 			netdev_rx ( netdev, iobuf );
 		} else {
 			netdev_rx_err ( netdev, NULL, ( rc ? rc : -ENOMEM ) );
@@ -1695,10 +1816,12 @@ static void gve_refill_rx ( struct net_device *netdev ) {
 	struct gve_nic *gve = netdev->priv;
 	struct gve_queue *rx = &gve->rx;
 	struct gve_dqo_rx_descriptor *dqo;
+	struct io_buffer *iobuf;
 	unsigned int refill;
 	unsigned int index;
 	unsigned int tag;
 	uint32_t doorbell;
+	physaddr_t addr;
 
 	/* Calculate refill quantity */
 	doorbell = ( rx->cons + rx->fill );
@@ -1710,24 +1833,37 @@ static void gve_refill_rx ( struct net_device *netdev ) {
 	if ( gve->mode & GVE_MODE_DQO ) {
 
 		/* Out-of-order descriptors */
-		while ( refill-- ) {
+		for ( ; rx->prod != doorbell ; rx->prod++ ) {
 
 			/* Identify next available buffer */
-			index = ( rx->prod++ & ( rx->count - 1 ) );
-			tag = rx->tag[ index % GVE_RX_FILL ];
+			index = ( rx->prod & ( rx->count - 1 ) );
+			tag = rx->tag[ index & ( rx->fill - 1 ) ];
+
+			/* Allocate I/O buffer for direct use, if applicable */
+			if ( gve_direct ( gve ) ) {
+				assert ( gve->rx_iobuf[tag] == NULL );
+				iobuf = alloc_rx_iob ( GVE_BUF_SIZE, gve->dma );
+				if ( ! iobuf ) {
+					/* Wait for next refill */
+					break;
+				}
+				gve->rx_iobuf[tag] = iobuf;
+				addr = iob_dma ( iobuf );
+			} else {
+				addr = gve_address ( rx, tag );
+			}
 
 			/* Populate descriptor */
 			dqo = &rx->desc.rx.dqo[index];
 			dqo->tag = tag;
-			dqo->buf.addr =
-				cpu_to_le64 ( gve_address ( rx, tag ) );
+			dqo->buf.addr = cpu_to_le64 ( addr );
 			DBGC2 ( gve, "GVE %p RXD %#04x:%#02x at %#08llx\n",
 				gve, index, dqo->tag,
 				( ( unsigned long long )
 				  le64_to_cpu ( dqo->buf.addr ) ) );
 		}
 		wmb();
-		assert ( rx->prod == doorbell );
+		doorbell = rx->prod;
 
 	} else {
 
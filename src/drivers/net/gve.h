@@ -544,9 +544,12 @@ struct gve_qpl {
 /**
  * Maximum number of transmit buffers
  *
- * This is a policy decision.
+ * This is a policy decision.  The fill level actually used is also
+ * limited by the transmit queue size reported by the device and, in
+ * operating modes that copy data via the queue page list, by the
+ * maximum number of queue pages.
  */
-#define GVE_TX_FILL 8
+#define GVE_TX_FILL 64
 
 /** Transmit queue page list ID */
 #define GVE_TX_QPL 0x18ae5458
@@ -643,9 +646,10 @@ struct gve_dqo_tx_completion {
  *
  * This is a policy decision.  Experiments suggest that using fewer
  * than 64 receive buffers leads to excessive packet drop rates on
- * some instance types.
+ * some instance types.  The fill level actually used is also limited
+ * in the same way as for transmit buffers.
  */
-#define GVE_RX_FILL 64
+#define GVE_RX_FILL 128
 
 /** Receive queue page list ID */
 #define GVE_RX_QPL 0x18ae5258
@@ -717,6 +721,9 @@ struct gve_dqo_rx_completion {
 	uint8_t reserved_e[19];
 } __attribute__ (( packed ));
 
+/** Receive packet contains IPv6 extension headers */
+#define GVE_DQO_RXS_IPV6_EXT 0x02
+
 /** Receive error */
 #define GVE_DQO_RXS_ERROR 0x04
 
@@ -726,6 +733,12 @@ struct gve_dqo_rx_completion {
 /** Last receive descriptor in a packet */
 #define GVE_DQO_RXF_LAST 0x02
 
+/** Receive L3 and L4 headers were processed */
+#define GVE_DQO_RXF_L3L4P 0x08
+
+/** Receive checksum errors */
+#define GVE_DQO_RXF_CSUM_ERR 0xf0
+
 /** Queue strides */
 struct gve_queue_stride {
 	/** Descriptor ring stride */
@@ -881,6 +894,8 @@ struct gve_nic {
 	uint8_t tx_tag[GVE_TX_FILL];
 	/** Receive tag ring */
 	uint8_t rx_tag[GVE_RX_FILL];
+	/** Receive I/O buffers (indexed by tag, if used directly) */
+	struct io_buffer *rx_iobuf[GVE_RX_FILL];
 	/** Receive sequence number */
 	unsigned int seq;
 
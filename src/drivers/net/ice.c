@@ -783,6 +783,8 @@ static int ice_probe ( struct pci_device *pci ) {
 	}
 	netdev_init ( netdev, &ice_operations );
 	netdev->max_pkt_len = INTELXL_MAX_PKT_LEN;
+	netdev->tx_offloads = ( NETDEV_TX_OFFLOAD_CSUM |
+				NETDEV_TX_OFFLOAD_VLAN );
 	intelxl = netdev->priv;
 	pci_set_drvdata ( pci, netdev );
 	netdev->dev = &pci->dev;
@@ -586,7 +586,7 @@ void intel_refill_rx ( struct intel_nic *intel ) {
 	unsigned int refilled = 0;
 
 	/* Refill ring */
-	while ( ( intel->rx.prod - intel->rx.cons ) < INTEL_RX_FILL ) {
+	while ( ( intel->rx.prod - intel->rx.cons ) < intel->rx.fill ) {
 
 		/* Allocate I/O buffer */
 		iobuf = alloc_rx_iob ( INTEL_RX_MAX_LEN, intel->dma );
@@ -596,7 +596,7 @@ void intel_refill_rx ( struct intel_nic *intel ) {
 		}
 
 		/* Get next receive descriptor */
-		rx_idx = ( intel->rx.prod++ % INTEL_NUM_RX_DESC );
+		rx_idx = ( intel->rx.prod++ % intel->rx.count );
 		rx = &intel->rx.desc[rx_idx];
 
 		/* Populate receive descriptor */
@@ -615,7 +615,7 @@ void intel_refill_rx ( struct intel_nic *intel ) {
 	/* Push descriptors to card, if applicable */
 	if ( refilled ) {
 		wmb();
-		rx_tail = ( intel->rx.prod % INTEL_NUM_RX_DESC );
+		rx_tail = ( intel->rx.prod % intel->rx.count );
 		profile_start ( &intel_vm_refill_profiler );
 		writel ( rx_tail, intel->regs + intel->rx.reg + INTEL_xDT );
 		profile_stop ( &intel_vm_refill_profiler );
@@ -632,7 +632,7 @@ void intel_empty_rx ( struct intel_nic *intel ) {
 	unsigned int i;
 
 	/* Discard unused receive buffers */
-	for ( i = 0 ; i < INTEL_NUM_RX_DESC ; i++ ) {
+	for ( i = 0 ; i < intel->rx.count ; i++ ) {
 		if ( intel->rx_iobuf[i] )
 			free_rx_iob ( intel->rx_iobuf[i] );
 		intel->rx_iobuf[i] = NULL;
@@ -694,6 +694,10 @@ static int intel_open ( struct net_device *netdev ) {
 		  INTEL_RCTL_BAM | INTEL_RCTL_BSIZE_2048 | INTEL_RCTL_SECRC );
 	writel ( rctl, intel->regs + INTEL_RCTL );
 
+	/* Enable receive checksum offload */
+	writel ( INTEL_RXCSUM_TUOFL, intel->regs + INTEL_RXCSUM );
+	intel->flags |= INTEL_RX_CSUM;
+
 	/* Fill receive ring */
 	intel_refill_rx ( intel );
 
@@ -758,12 +762,12 @@ int intel_transmit ( struct net_device *netdev, struct io_buffer *iobuf ) {
 	size_t len;
 
 	/* Get next transmit descriptor */
-	if ( ( intel->tx.prod - intel->tx.cons ) >= INTEL_TX_FILL ) {
+	if ( ( intel->tx.prod - intel->tx.cons ) >= intel->tx.fill ) {
 		DBGC ( intel, "INTEL %p out of transmit descriptors\n", intel );
 		return -ENOBUFS;
 	}
-	tx_idx = ( intel->tx.prod++ % INTEL_NUM_TX_DESC );
-	tx_tail = ( intel->tx.prod % INTEL_NUM_TX_DESC );
+	tx_idx = ( intel->tx.prod++ % intel->tx.count );
+	tx_tail = ( intel->tx.prod % intel->tx.count );
 	tx = &intel->tx.desc[tx_idx];
 
 	/* Populate transmit descriptor */
@@ -798,7 +802,7 @@ void intel_poll_tx ( struct net_device *netdev ) {
 	while ( intel->tx.cons != intel->tx.prod ) {
 
 		/* Get next transmit descriptor */
-		tx_idx = ( intel->tx.cons % INTEL_NUM_TX_DESC );
+		tx_idx = ( intel->tx.cons % intel->tx.count );
 		tx = &intel->tx.desc[tx_idx];
 
 		/* Stop if descriptor is still in use */
@@ -822,19 +826,23 @@ void intel_poll_rx ( struct net_device *netdev ) {
 	struct intel_nic *intel = netdev->priv;
 	struct intel_descriptor *rx;
 	struct io_buffer *iobuf;
+	struct list_head received;
 	unsigned int rx_idx;
+	uint32_t csum;
 	size_t len;
 
+	INIT_LIST_HEAD ( &received );
+
 	/* Check for received packets */
 	while ( intel->rx.cons != intel->rx.prod ) {
 
 		/* Get next receive descriptor */
-		rx_idx = ( intel->rx.cons % INTEL_NUM_RX_DESC );
+		rx_idx = ( intel->rx.cons % intel->rx.count );
 		rx = &intel->rx.desc[rx_idx];
 
 		/* Stop if descriptor is still in use */
 		if ( ! ( rx->status & cpu_to_le32 ( INTEL_DESC_STATUS_DD ) ) )
-			return;
+			break;
 
 		/* Populate I/O buffer */
 		iobuf = intel->rx_iobuf[rx_idx];
@@ -851,10 +859,19 @@ void intel_poll_rx ( struct net_device *netdev ) {
 		} else {
 			DBGC2 ( intel, "INTEL %p RX %d complete (length %zd)\n",
 				intel, rx_idx, len );
-			netdev_rx ( netdev, iobuf );
+			csum = ( le32_to_cpu ( rx->status ) &
+				 INTEL_DESC_STATUS_CSUM );
+			if ( ( intel->flags & INTEL_RX_CSUM ) &&
+			     ( csum == INTEL_DESC_STATUS_TCPCS ) ) {
+				iobuf->flags |= IOB_CSUM_VALID;
+			}
+			list_add_tail ( &iobuf->list, &received );
 		}
 		intel->rx.cons++;
 	}
+
+	/* Hand off received packets to network stack */
+	netdev_rx_batch ( netdev, &received );
 }
 
 /**
@@ -930,6 +947,9 @@ static struct net_device_operations intel_operations = {
 	.irq		= intel_irq,
 };
 
+/** Intel devirtualised network device operations */
+PROVIDE_NETDEV_DIRECT ( intel_operations, intel_transmit, intel_poll );
+
 /******************************************************************************
  *
  * PCI interface
@@ -961,10 +981,13 @@ static int intel_probe ( struct pci_device *pci ) {
 	memset ( intel, 0, sizeof ( *intel ) );
 	intel->port = PCI_FUNC ( pci->busdevfn );
 	intel->flags = pci->id->driver_data;
-	intel_init_ring ( &intel->tx, INTEL_NUM_TX_DESC, INTEL_TD,
+	build_assert ( INTEL_NUM_TX_DESC >= INTEL_MIN_NUM_TX_DESC );
+	build_assert ( INTEL_NUM_RX_DESC <= INTEL_MAX_NUM_RX_DESC );
+	intel_init_ring ( &intel->tx, INTEL_NUM_TX_DESC,
+			  ( INTEL_NUM_TX_DESC - 1 ), INTEL_TD,
 			  intel_describe_tx );
-	intel_init_ring ( &intel->rx, INTEL_NUM_RX_DESC, INTEL_RD,
-			  intel_describe_rx );
+	intel_init_ring ( &intel->rx, INTEL_NUM_RX_DESC, INTEL_RX_FILL,
+			  INTEL_RD, intel_describe_rx );
 
 	/* Fix up PCI device */
 	adjust_pci_device ( pci );
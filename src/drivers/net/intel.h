@@ -11,9 +11,11 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 FILE_SECBOOT ( PERMITTED );
 
 #include <stdint.h>
+#include <assert.h>
 #include <ipxe/if_ether.h>
 #include <ipxe/nvs.h>
 #include <ipxe/dma.h>
+#include <config/netdev.h>
 
 /** Intel BAR size */
 #define INTEL_BAR_SIZE ( 128 * 1024 )
@@ -51,9 +53,23 @@ struct intel_descriptor {
 /** Descriptor done */
 #define INTEL_DESC_STATUS_DD 0x00000001UL
 
+/** Ignore checksum indication */
+#define INTEL_DESC_STATUS_IXSM 0x00000004UL
+
+/** TCP/UDP checksum calculated */
+#define INTEL_DESC_STATUS_TCPCS 0x00000020UL
+
 /** Receive error */
 #define INTEL_DESC_STATUS_RXE 0x00000100UL
 
+/** TCP/UDP checksum error */
+#define INTEL_DESC_STATUS_TCPE 0x00002000UL
+
+/** Receive checksum status bits */
+#define INTEL_DESC_STATUS_CSUM \
+	( INTEL_DESC_STATUS_IXSM | INTEL_DESC_STATUS_TCPCS | \
+	  INTEL_DESC_STATUS_TCPE )
+
 /** Payload length */
 #define INTEL_DESC_STATUS_PAYLEN( len ) ( (len) << 14 )
 
@@ -122,6 +138,10 @@ struct intel_descriptor {
 #define INTEL_RCTL_BSIZE_BSEX_MASK INTEL_RCTL_BSIZE_BSEX ( 1, 3 )
 #define INTEL_RCTL_SECRC	0x04000000UL	/**< Strip CRC */
 
+/** Receive Checksum Control Register */
+#define INTEL_RXCSUM 0x05000UL
+#define INTEL_RXCSUM_TUOFL	0x00000200UL	/**< TCP/UDP checksum offload */
+
 /** Transmit Control Register */
 #define INTEL_TCTL 0x00400UL
 #define INTEL_TCTL_EN		0x00000002UL	/**< Transmit enable */
@@ -146,15 +166,14 @@ struct intel_descriptor {
 /** Receive Descriptor register block */
 #define INTEL_RD 0x02800UL
 
-/** Number of receive descriptors
+/** Maximum number of receive descriptors
  *
- * Minimum value is 8, since the descriptor ring length must be a
+ * The number of receive descriptors (as configured via
+ * INTEL_NUM_RX_DESC and INTELX_NUM_RX_DESC in config/netdev.h) must
+ * be a multiple of 8, since the descriptor ring length must be a
  * multiple of 128.
  */
-#define INTEL_NUM_RX_DESC 16
-
-/** Receive descriptor ring fill level */
-#define INTEL_RX_FILL 8
+#define INTEL_MAX_NUM_RX_DESC 256
 
 /** Receive buffer length */
 #define INTEL_RX_MAX_LEN 2048
@@ -166,15 +185,12 @@ struct intel_descriptor {
 /** Transmit Descriptor register block */
 #define INTEL_TD 0x03800UL
 
-/** Number of transmit descriptors
+/** Minimum number of transmit descriptors
  *
  * Descriptor ring length must be a multiple of 16.  ICH8/9/10
  * requires a minimum of 16 TX descriptors.
  */
-#define INTEL_NUM_TX_DESC 16
-
-/** Transmit descriptor ring maximum fill level */
-#define INTEL_TX_FILL ( INTEL_NUM_TX_DESC - 1 )
+#define INTEL_MIN_NUM_TX_DESC 16
 
 /** Receive/Transmit Descriptor Base Address Low (offset) */
 #define INTEL_xDBAL 0x00
@@ -229,6 +245,11 @@ struct intel_ring {
 	/** Consumer index */
 	unsigned int cons;
 
+	/** Number of descriptors */
+	unsigned int count;
+	/** Maximum fill level */
+	unsigned int fill;
+
 	/** Register block */
 	unsigned int reg;
 	/** Length (in bytes) */
@@ -249,14 +270,20 @@ struct intel_ring {
  *
  * @v ring		Descriptor ring
  * @v count		Number of descriptors
+ * @v fill		Maximum fill level
  * @v reg		Descriptor register block
  * @v describe		Method to populate descriptor
  */
 static inline __attribute__ (( always_inline)) void
-intel_init_ring ( struct intel_ring *ring, unsigned int count, unsigned int reg,
+intel_init_ring ( struct intel_ring *ring, unsigned int count,
+		  unsigned int fill, unsigned int reg,
 		  void ( * describe ) ( struct intel_descriptor *desc,
 					physaddr_t addr, size_t len ) ) {
 
+	build_assert ( ( count % 8 ) == 0 );
+	build_assert ( fill < count );
+	ring->count = count;
+	ring->fill = fill;
 	ring->len = ( count * sizeof ( ring->desc[0] ) );
 	ring->reg = reg;
 	ring->describe = describe;
@@ -313,7 +340,7 @@ struct intel_nic {
 	/** Receive descriptor ring */
 	struct intel_ring rx;
 	/** Receive I/O buffers */
-	struct io_buffer *rx_iobuf[INTEL_NUM_RX_DESC];
+	struct io_buffer *rx_iobuf[INTEL_MAX_NUM_RX_DESC];
 };
 
 /** Driver flags */
@@ -330,6 +357,8 @@ enum intel_flags {
 	INTEL_RST_HANG = 0x0010,
 	/** PBSIZE registers must be explicitly reset */
 	INTEL_PBSIZE_RST = 0x0020,
+	/** Receive checksum offload is enabled */
+	INTEL_RX_CSUM = 0x0040,
 };
 
 /** The i219 has a seriously broken reset mechanism */
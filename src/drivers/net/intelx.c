@@ -396,10 +396,13 @@ static int intelx_probe ( struct pci_device *pci ) {
 	netdev->dev = &pci->dev;
 	memset ( intel, 0, sizeof ( *intel ) );
 	intel->port = PCI_FUNC ( pci->busdevfn );
-	intel_init_ring ( &intel->tx, INTEL_NUM_TX_DESC, INTELX_TD,
+	build_assert ( INTELX_NUM_TX_DESC >= INTEL_MIN_NUM_TX_DESC );
+	build_assert ( INTELX_NUM_RX_DESC <= INTEL_MAX_NUM_RX_DESC );
+	intel_init_ring ( &intel->tx, INTELX_NUM_TX_DESC,
+			  ( INTELX_NUM_TX_DESC - 1 ), INTELX_TD,
 			  intel_describe_tx );
-	intel_init_ring ( &intel->rx, INTEL_NUM_RX_DESC, INTELX_RD,
-			  intel_describe_rx );
+	intel_init_ring ( &intel->rx, INTELX_NUM_RX_DESC, INTELX_RX_FILL,
+			  INTELX_RD, intel_describe_rx );
 
 	/* Fix up PCI device */
 	adjust_pci_device ( pci );
@@ -1495,6 +1495,11 @@ int intelxl_transmit ( struct net_device *netdev, struct io_buffer *iobuf ) {
 	struct intelxl_tx_data_descriptor *tx;
 	unsigned int tx_idx;
 	unsigned int tx_tail;
+	uint32_t offload = 0;
+	uint32_t tag = 0;
+	size_t maclen;
+	size_t iplen;
+	size_t l4len = 0;
 	size_t len;
 
 	/* Get next transmit descriptor */
@@ -1507,12 +1512,36 @@ int intelxl_transmit ( struct net_device *netdev, struct io_buffer *iobuf ) {
 	tx_tail = ( intelxl->tx.prod % INTELXL_TX_NUM_DESC );
 	tx = &intelxl->tx.desc.tx[tx_idx].data;
 
+	/* Request checksum offload, if applicable */
+	if ( iobuf->flags & IOB_TX_CSUM ) {
+		maclen = ( iobuf->net_hdr - iobuf->data );
+		iplen = ( iobuf->trans_hdr - iobuf->net_hdr );
+		l4len = iobuf->trans_hdr_len;
+		offload = ( ( ( iobuf->flags & IOB_TX_IPV6 ) ?
+			      INTELXL_TX_DATA_IIPT_IPV6 :
+			      INTELXL_TX_DATA_IIPT_IPV4 ) |
+			    ( ( iobuf->flags & IOB_TX_TCP ) ?
+			      INTELXL_TX_DATA_L4T_TCP :
+			      INTELXL_TX_DATA_L4T_UDP ) |
+			    INTELXL_TX_DATA_MACLEN ( maclen ) |
+			    INTELXL_TX_DATA_IPLEN ( iplen ) |
+			    INTELXL_TX_DATA_L4LEN_LO ( l4len ) );
+	}
+
+	/* Request VLAN tag insertion, if applicable */
+	if ( iobuf->flags & IOB_TX_VLAN ) {
+		offload |= INTELXL_TX_DATA_IL2TAG1;
+		tag = INTELXL_TX_DATA_L2TAG1 ( iobuf->vlan_tci );
+	}
+
 	/* Populate transmit descriptor */
 	len = iob_len ( iobuf );
 	tx->address = cpu_to_le64 ( iob_dma ( iobuf ) );
-	tx->len = cpu_to_le32 ( INTELXL_TX_DATA_LEN ( len ) );
+	tx->len = cpu_to_le32 ( INTELXL_TX_DATA_LEN ( len ) |
+				INTELXL_TX_DATA_L4LEN_HI ( l4len ) | tag );
 	tx->flags = cpu_to_le32 ( INTELXL_TX_DATA_DTYP | INTELXL_TX_DATA_EOP |
-				  INTELXL_TX_DATA_RS | INTELXL_TX_DATA_JFDI );
+				  INTELXL_TX_DATA_RS | INTELXL_TX_DATA_JFDI |
+				  offload );
 	wmb();
 
 	/* Notify card that there are packets ready to transmit */
@@ -1553,6 +1582,33 @@ static void intelxl_poll_tx ( struct net_device *netdev ) {
 	}
 }
 
+/**
+ * Check whether received packet has a verified transport-layer checksum
+ *
+ * @v rx_wb		Receive writeback descriptor
+ * @ret valid		Transport-layer checksum has been verified
+ */
+static int intelxl_rx_csum_valid ( struct intelxl_rx_writeback_descriptor
+				   *rx_wb ) {
+	uint32_t flags = le32_to_cpu ( rx_wb->flags );
+	uint32_t len = le32_to_cpu ( rx_wb->len );
+
+	/* Check that checksums were verified without error */
+	if ( ( flags & INTELXL_RX_WB_FL_CSUM ) != INTELXL_RX_WB_FL_L3L4P )
+		return 0;
+
+	/* Check that packet has a recognised transport-layer protocol */
+	switch ( INTELXL_RX_WB_PTYPE ( flags, len ) ) {
+	case INTELXL_RX_PTYPE_IPV4_UDP:
+	case INTELXL_RX_PTYPE_IPV4_TCP:
+	case INTELXL_RX_PTYPE_IPV6_UDP:
+	case INTELXL_RX_PTYPE_IPV6_TCP:
+		return 1;
+	default:
+		return 0;
+	}
+}
+
 /**
  * Poll for received packets
  *
@@ -1599,6 +1655,8 @@ static void intelxl_poll_rx ( struct net_device *netdev ) {
 		} else {
 			DBGC2 ( intelxl, "INTELXL %p RX %d complete (length "
 				"%zd)\n", intelxl, rx_idx, len );
+			if ( intelxl_rx_csum_valid ( rx_wb ) )
+				iobuf->flags |= IOB_CSUM_VALID;
 			vlan_netdev_rx ( netdev, tag, iobuf );
 		}
 		intelxl->rx.cons++;
@@ -1680,6 +1738,8 @@ static int intelxl_probe ( struct pci_device *pci ) {
 	}
 	netdev_init ( netdev, &intelxl_operations );
 	netdev->max_pkt_len = INTELXL_MAX_PKT_LEN;
+	netdev->tx_offloads = ( NETDEV_TX_OFFLOAD_CSUM |
+				NETDEV_TX_OFFLOAD_VLAN );
 	intelxl = netdev->priv;
 	pci_set_drvdata ( pci, netdev );
 	netdev->dev = &pci->dev;
@@ -1690,6 +1750,12 @@ static int intelxl_probe ( struct pci_device *pci ) {
 			     &intelxl_admin_offsets );
 	intelxl_init_admin ( &intelxl->event, INTELXL_ADMIN_EVT,
 			     &intelxl_admin_offsets );
+	build_assert ( INTELXL_TX_NUM_DESC > INTELXL_RX_FILL );
+	build_assert ( ( INTELXL_RX_NUM_DESC % 32 ) == 0 );
+	build_assert ( INTELXL_RX_NUM_DESC >= 64 );
+	build_assert ( INTELXL_RX_FILL < INTELXL_RX_NUM_DESC );
+	build_assert ( ( INTELXL_RX_FILL % 8 ) == 0 );
+	build_assert ( INTELXL_RX_FILL > 8 );
 	intelxl_init_ring ( &intelxl->tx, INTELXL_TX_NUM_DESC,
 			    sizeof ( intelxl->tx.desc.tx[0] ),
 			    intelxl_context_tx );
@@ -14,6 +14,7 @@ FILE_SECBOOT ( PERMITTED );
 #include <ipxe/if_ether.h>
 #include <ipxe/pcimsix.h>
 #include <ipxe/dma.h>
+#include <config/netdev.h>
 
 struct intelxl_nic;
 
@@ -677,9 +678,40 @@ struct intelxl_tx_data_descriptor {
  */
 #define INTELXL_TX_DATA_JFDI 0x40
 
+/** Transmit data descriptor insert VLAN tag */
+#define INTELXL_TX_DATA_IL2TAG1 0x80
+
+/** Transmit data descriptor IPv6 packet */
+#define INTELXL_TX_DATA_IIPT_IPV6 0x200
+
+/** Transmit data descriptor IPv4 packet (without IP checksum offload) */
+#define INTELXL_TX_DATA_IIPT_IPV4 0x400
+
+/** Transmit data descriptor TCP checksum offload */
+#define INTELXL_TX_DATA_L4T_TCP 0x1000
+
+/** Transmit data descriptor UDP checksum offload */
+#define INTELXL_TX_DATA_L4T_UDP 0x3000
+
+/** Transmit data descriptor MAC header length */
+#define INTELXL_TX_DATA_MACLEN( len ) ( ( (len) / 2 ) << 16 )
+
+/** Transmit data descriptor IP header length */
+#define INTELXL_TX_DATA_IPLEN( len ) ( ( (len) / 4 ) << 23 )
+
+/** Transmit data descriptor L4 header length (low bits, within flags) */
+#define INTELXL_TX_DATA_L4LEN_LO( len ) \
+	( ( ( ( (len) / 4 ) & 0x3UL ) ) << 30 )
+
+/** Transmit data descriptor L4 header length (high bits, within length) */
+#define INTELXL_TX_DATA_L4LEN_HI( len ) ( ( (len) / 4 ) >> 2 )
+
 /** Transmit data descriptor length */
 #define INTELXL_TX_DATA_LEN( len ) ( (len) << 2 )
 
+/** Transmit data descriptor VLAN tag */
+#define INTELXL_TX_DATA_L2TAG1( tci ) ( ( ( uint32_t ) (tci) ) << 16 )
+
 /** Transmit writeback descriptor */
 struct intelxl_tx_writeback_descriptor {
 	/** Reserved */
@@ -733,9 +765,39 @@ struct intelxl_rx_writeback_descriptor {
 /** Receive writeback descriptor VLAN tag present */
 #define INTELXL_RX_WB_FL_VLAN 0x00000004UL
 
+/** Receive writeback descriptor L3 and L4 integrity checks performed */
+#define INTELXL_RX_WB_FL_L3L4P 0x00000008UL
+
 /** Receive writeback descriptor error */
 #define INTELXL_RX_WB_FL_RXE 0x00080000UL
 
+/** Receive writeback descriptor IP checksum error */
+#define INTELXL_RX_WB_FL_IPE 0x00400000UL
+
+/** Receive writeback descriptor L4 checksum error */
+#define INTELXL_RX_WB_FL_L4E 0x00800000UL
+
+/** Receive writeback descriptor checksum status bits */
+#define INTELXL_RX_WB_FL_CSUM \
+	( INTELXL_RX_WB_FL_L3L4P | INTELXL_RX_WB_FL_IPE | \
+	  INTELXL_RX_WB_FL_L4E )
+
+/** Receive writeback descriptor packet type */
+#define INTELXL_RX_WB_PTYPE( flags, len ) \
+	( ( (flags) >> 30 ) | ( ( (len) & 0x3f ) << 2 ) )
+
+/** Receive writeback descriptor packet types */
+enum intelxl_rx_ptype {
+	/** IPv4 UDP */
+	INTELXL_RX_PTYPE_IPV4_UDP = 24,
+	/** IPv4 TCP */
+	INTELXL_RX_PTYPE_IPV4_TCP = 26,
+	/** IPv6 UDP */
+	INTELXL_RX_PTYPE_IPV6_UDP = 90,
+	/** IPv6 TCP */
+	INTELXL_RX_PTYPE_IPV6_TCP = 92,
+};
+
 /** Receive writeback descriptor length */
 #define INTELXL_RX_WB_LEN(len) ( ( (len) >> 6 ) & 0x3fff )
 
@@ -796,28 +858,21 @@ intelxl_init_ring ( struct intelxl_ring *ring, unsigned int count, size_t len,
 	ring->context = context;
 }
 
-/** Number of transmit descriptors
+/* Number of transmit descriptors (INTELXL_TX_NUM_DESC), number of
+ * receive descriptors (INTELXL_RX_NUM_DESC) and receive descriptor
+ * ring fill level (INTELXL_RX_FILL) are defined in config/netdev.h.
  *
- * Chosen to exceed the receive ring fill level, in order to avoid
- * running out of transmit descriptors when sending TCP ACKs.
+ * The number of transmit descriptors is chosen to exceed the receive
+ * ring fill level, in order to avoid running out of transmit
+ * descriptors when sending TCP ACKs.  The number of receive
+ * descriptors must be a multiple of 32 and greater than or equal to
+ * 64.  The receive ring fill level must be a multiple of 8 and
+ * greater than 8.
  */
-#define INTELXL_TX_NUM_DESC 64
 
 /** Transmit descriptor ring maximum fill level */
 #define INTELXL_TX_FILL ( INTELXL_TX_NUM_DESC - 1 )
 
-/** Number of receive descriptors
- *
- * Must be a multiple of 32 and greater than or equal to 64.
- */
-#define INTELXL_RX_NUM_DESC 64
-
-/** Receive descriptor ring fill level
- *
- * Must be a multiple of 8 and greater than 8.
- */
-#define INTELXL_RX_FILL 16
-
 /** Maximum packet length (excluding CRC) */
 #define INTELXL_MAX_PKT_LEN ( 9728 - 4 /* CRC */ )
 
@@ -448,10 +448,13 @@ static int intelxvf_probe ( struct pci_device *pci ) {
 	netdev->dev = &pci->dev;
 	memset ( intel, 0, sizeof ( *intel ) );
 	intel_init_mbox ( &intel->mbox, INTELXVF_MBCTRL, INTELXVF_MBMEM );
-	intel_init_ring ( &intel->tx, INTEL_NUM_TX_DESC, INTELXVF_TD(0),
+	build_assert ( INTELX_NUM_TX_DESC >= INTEL_MIN_NUM_TX_DESC );
+	build_assert ( INTELX_NUM_RX_DESC <= INTEL_MAX_NUM_RX_DESC );
+	intel_init_ring ( &intel->tx, INTELX_NUM_TX_DESC,
+			  ( INTELX_NUM_TX_DESC - 1 ), INTELXVF_TD(0),
 			  intel_describe_tx_adv );
-	intel_init_ring ( &intel->rx, INTEL_NUM_RX_DESC, INTELXVF_RD(0),
-			  intel_describe_rx );
+	intel_init_ring ( &intel->rx, INTELX_NUM_RX_DESC, INTELX_RX_FILL,
+			  INTELXVF_RD(0), intel_describe_rx );
 
 	/* Fix up PCI device */
 	adjust_pci_device ( pci );
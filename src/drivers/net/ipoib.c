@@ -42,6 +42,7 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 #include <ipxe/infiniband.h>
 #include <ipxe/ib_pathrec.h>
 #include <ipxe/ib_mcast.h>
+#include <ipxe/ib_cm.h>
 #include <ipxe/retry.h>
 #include <ipxe/ipoib.h>
 
@@ -73,6 +74,21 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 /** Number of IPoIB completion entries */
 #define IPOIB_NUM_CQES 16
 
+/** IPoIB datagram mode maximum transmission unit */
+#define IPOIB_UD_MTU ( IB_MAX_PAYLOAD_SIZE - ETH_HLEN )
+
+/** Number of IPoIB connected mode send work queue entries */
+#define IPOIB_CM_NUM_SEND_WQES 8
+
+/** Number of IPoIB connected mode receive work queue entries */
+#define IPOIB_CM_NUM_RECV_WQES 4
+
+/** Number of IPoIB connected mode completion entries */
+#define IPOIB_CM_NUM_CQES 128
+
+/** Maximum number of IPoIB connected mode connections */
+#define IPOIB_CM_MAX_CONNS 8
+
 /** An IPoIB broadcast address */
 struct ipoib_broadcast {
 	/** MAC address */
@@ -101,6 +117,41 @@ struct ipoib_device {
 	struct ipoib_broadcast broadcast;
 	/** REMAC cache */
 	struct list_head peers;
+
+	/** Connected mode completion queue, if connected mode is enabled */
+	struct ib_completion_queue *cm_cq;
+	/** Connected mode listener */
+	struct ib_listener listener;
+	/** Connected mode connections */
+	struct list_head conns;
+	/** Number of connected mode queue pairs */
+	unsigned int num_conns;
+};
+
+/** An IPoIB connected mode connection
+ *
+ * Connections are unidirectional: we transmit via connections that
+ * we initiate, and receive via connections initiated by the peer.
+ */
+struct ipoib_conn {
+	/** List of connections */
+	struct list_head list;
+	/** IPoIB device */
+	struct ipoib_device *ipoib;
+	/** Peer MAC address */
+	struct ipoib_mac mac;
+	/** Queue pair, if any */
+	struct ib_queue_pair *qp;
+	/** Communication-managed connection, if any */
+	struct ib_connection *conn;
+	/** Connection was initiated by the peer */
+	int passive;
+	/** Connection is established */
+	int connected;
+	/** Connection status code */
+	int rc;
+	/** Maximum transmit message size */
+	size_t mtu;
 };
 
 /** Broadcast IPoIB address */
@@ -124,6 +175,10 @@ struct errortab ipoib_errors[] __errortab = {
 static LIST_HEAD ( ipoib_devices );
 
 static struct net_device_operations ipoib_operations;
+static struct ipoib_conn * ipoib_cm_connection ( struct ipoib_device *ipoib,
+						 struct ipoib_mac *mac );
+static int ipoib_cm_transmit ( struct ipoib_conn *conn,
+			       struct io_buffer *iobuf );
 
 /****************************************************************************
  *
@@ -505,6 +560,7 @@ static int ipoib_transmit ( struct net_device *netdev,
 	struct ipoib_hdr *ipoib_hdr;
 	struct ipoib_remac *remac;
 	struct ipoib_mac *mac;
+	struct ipoib_conn *conn = NULL;
 	struct ib_address_vector *dest;
 	struct ib_address_vector av;
 	uint16_t net_proto;
@@ -536,6 +592,9 @@ static int ipoib_transmit ( struct net_device *netdev,
 
 	} else if ( ( mac = ipoib_find_remac ( ipoib, remac ) ) ) {
 
+		/* Use connected mode connection, if established */
+		conn = ipoib_cm_connection ( ipoib, mac );
+
 		/* Construct address vector from IPoIB MAC */
 		dest = &av;
 		memset ( dest, 0, sizeof ( *dest ) );
@@ -586,6 +645,17 @@ static int ipoib_transmit ( struct net_device *netdev,
 	ipoib_hdr->proto = net_proto;
 	ipoib_hdr->reserved = 0;
 
+	/* Transmit via connected mode, if applicable */
+	if ( conn )
+		return ipoib_cm_transmit ( conn, iobuf );
+
+	/* Check that packet fits within a datagram */
+	if ( iob_len ( iobuf ) > IB_MAX_PAYLOAD_SIZE ) {
+		DBGC ( ipoib, "IPoIB %p packet too large for datagram mode\n",
+		       ipoib );
+		return -ERANGE;
+	}
+
 	/* Transmit packet */
 	return ib_post_send ( ibdev, ipoib->qp, dest, iobuf );
 }
@@ -606,6 +676,54 @@ static void ipoib_complete_send ( struct ib_device *ibdev __unused,
 	netdev_tx_complete_err ( ipoib->netdev, iobuf, rc );
 }
 
+/**
+ * Hand off received packet to network layer
+ *
+ * @v ipoib		IPoIB device
+ * @v iobuf		I/O buffer
+ * @v remac		Remote Ethernet MAC
+ * @v multicast		Packet was received via a multicast group
+ */
+static void ipoib_rx ( struct ipoib_device *ipoib, struct io_buffer *iobuf,
+		       struct ipoib_remac *remac, int multicast ) {
+	struct net_device *netdev = ipoib->netdev;
+	struct ipoib_hdr *ipoib_hdr;
+	struct ethhdr *ethhdr;
+	uint16_t net_proto;
+	int rc;
+
+	/* Strip real IPoIB header */
+	ipoib_hdr = iobuf->data;
+	net_proto = ipoib_hdr->proto;
+	iob_pull ( iobuf, sizeof ( *ipoib_hdr ) );
+
+	/* Translate packet if applicable */
+	if ( ( rc = ipoib_translate_rx ( netdev, iobuf, remac,
+					 net_proto ) ) != 0 ) {
+		netdev_rx_err ( netdev, iobuf, rc );
+		return;
+	}
+
+	/* Prepend eIPoIB header */
+	ethhdr = iob_push ( iobuf, sizeof ( *ethhdr ) );
+	memcpy ( &ethhdr->h_source, remac, sizeof ( ethhdr->h_source ) );
+	ethhdr->h_protocol = net_proto;
+
+	/* Construct destination address */
+	if ( multicast ) {
+		/* Multicast GID: use the Ethernet broadcast address */
+		memcpy ( &ethhdr->h_dest, eth_broadcast,
+			 sizeof ( ethhdr->h_dest ) );
+	} else {
+		/* Assume destination address is local Ethernet MAC */
+		memcpy ( &ethhdr->h_dest, netdev->ll_addr,
+			 sizeof ( ethhdr->h_dest ) );
+	}
+
+	/* Hand off to network layer */
+	netdev_rx ( netdev, iobuf );
+}
+
 /**
  * Handle IPoIB receive completion
  *
@@ -623,10 +741,7 @@ static void ipoib_complete_recv ( struct ib_device *ibdev __unused,
 				  struct io_buffer *iobuf, int rc ) {
 	struct ipoib_device *ipoib = ib_qp_get_ownerdata ( qp );
 	struct net_device *netdev = ipoib->netdev;
-	struct ipoib_hdr *ipoib_hdr;
-	struct ethhdr *ethhdr;
 	struct ipoib_remac remac;
-	uint16_t net_proto;
 
 	/* Record errors */
 	if ( rc != 0 ) {
@@ -649,40 +764,13 @@ static void ipoib_complete_recv ( struct ib_device *ibdev __unused,
 		return;
 	}
 
-	/* Strip real IPoIB header */
-	ipoib_hdr = iobuf->data;
-	net_proto = ipoib_hdr->proto;
-	iob_pull ( iobuf, sizeof ( *ipoib_hdr ) );
-
 	/* Construct source address from remote QPN and LID */
 	remac.qpn = htonl ( source->qpn | EIPOIB_QPN_LA );
 	remac.lid = htons ( source->lid );
 
-	/* Translate packet if applicable */
-	if ( ( rc = ipoib_translate_rx ( netdev, iobuf, &remac,
-					 net_proto ) ) != 0 ) {
-		netdev_rx_err ( netdev, iobuf, rc );
-		return;
-	}
-
-	/* Prepend eIPoIB header */
-	ethhdr = iob_push ( iobuf, sizeof ( *ethhdr ) );
-	memcpy ( &ethhdr->h_source, &remac, sizeof ( ethhdr->h_source ) );
-	ethhdr->h_protocol = net_proto;
-
-	/* Construct destination address */
-	if ( dest->gid_present && IB_GID_MULTICAST ( &dest->gid ) ) {
-		/* Multicast GID: use the Ethernet broadcast address */
-		memcpy ( &ethhdr->h_dest, eth_broadcast,
-			 sizeof ( ethhdr->h_dest ) );
-	} else {
-		/* Assume destination address is local Ethernet MAC */
-		memcpy ( &ethhdr->h_dest, netdev->ll_addr,
-			 sizeof ( ethhdr->h_dest ) );
-	}
-
 	/* Hand off to network layer */
-	netdev_rx ( netdev, iobuf );
+	ipoib_rx ( ipoib, iobuf, &remac,
+		   ( dest->gid_present && IB_GID_MULTICAST ( &dest->gid ) ) );
 }
 
 /** IPoIB completion operations */
@@ -727,6 +815,480 @@ static struct ib_queue_pair_operations ipoib_qp_op = {
 	.alloc_iob = ipoib_alloc_iob,
 };
 
+/****************************************************************************
+ *
+ * IPoIB connected mode
+ *
+ ****************************************************************************
+ */
+
+/**
+ * Allocate IPoIB connected mode receive I/O buffer
+ *
+ * @v len		Length of buffer (ignored)
+ * @ret iobuf		I/O buffer, or NULL
+ */
+static struct io_buffer * ipoib_cm_alloc_iob ( size_t len __unused ) {
+	struct io_buffer *iobuf;
+	size_t reserve_len;
+
+	/* Calculate additional length required at start of buffer */
+	reserve_len = ( sizeof ( struct ethhdr ) -
+			sizeof ( struct ipoib_hdr ) );
+
+	/* Allocate buffer (as for ipoib_alloc_iob()) */
+	iobuf = alloc_iob_raw ( ( IPOIB_CM_BUF_SIZE + reserve_len ),
+				IB_MAX_PAYLOAD_SIZE, -reserve_len );
+	if ( iobuf ) {
+		iob_reserve ( iobuf, reserve_len );
+	}
+	return iobuf;
+}
+
+/** IPoIB connected mode receive queue pair operations */
+static struct ib_queue_pair_operations ipoib_cm_qp_op = {
+	.alloc_iob = ipoib_cm_alloc_iob,
+};
+
+/**
+ * Handle connection status change
+ *
+ * @v ibdev		Infiniband device
+ * @v qp		Queue pair
+ * @v ib_conn		Communication-managed connection
+ * @v rc		Connection status code
+ * @v private_data	Private data, if available
+ * @v private_data_len	Length of private data
+ */
+static void ipoib_cm_changed ( struct ib_device *ibdev __unused,
+			       struct ib_queue_pair *qp,
+			       struct ib_connection *ib_conn __unused,
+			       int rc, void *private_data,
+			       size_t private_data_len ) {
+	struct ipoib_conn *conn = ib_qp_get_ownerdata ( qp );
+	struct ipoib_device *ipoib = conn->ipoib;
+	struct ipoib_cm_data *data = private_data;
+
+	/* Record failures.  The connection cannot be destroyed from
+	 * within this callback, and will be reaped when next polled.
+	 */
+	if ( rc != 0 ) {
+		DBGC ( ipoib, "IPoIB %p CM %s " IB_GID_FMT " failed: %s\n",
+		       ipoib, ( conn->passive ? "from" : "to" ),
+		       IB_GID_ARGS ( &conn->mac.gid ), strerror ( rc ) );
+		if ( ! conn->rc )
+			conn->rc = rc;
+		return;
+	}
+
+	/* Record maximum transmit message size */
+	if ( ! conn->passive ) {
+		if ( ( private_data_len < sizeof ( *data ) ) ||
+		     ( ntohl ( data->mtu ) <= sizeof ( struct ipoib_hdr ) ) ) {
+			DBGC ( ipoib, "IPoIB %p CM to " IB_GID_FMT " has "
+			       "invalid MTU\n", ipoib,
+			       IB_GID_ARGS ( &conn->mac.gid ) );
+			conn->rc = -EINVAL;
+			return;
+		}
+		conn->mtu = ntohl ( data->mtu );
+	}
+
+	/* Mark connection as established */
+	DBGC ( ipoib, "IPoIB %p CM %s " IB_GID_FMT " established\n", ipoib,
+	       ( conn->passive ? "from" : "to" ),
+	       IB_GID_ARGS ( &conn->mac.gid ) );
+	conn->connected = 1;
+}
+
+/** IPoIB connected mode connection operations */
+static struct ib_connection_operations ipoib_cm_conn_op = {
+	.changed = ipoib_cm_changed,
+};
+
+/**
+ * Create connected mode queue pair
+ *
+ * @v conn		Connection
+ * @v num_recv_wqes	Number of receive work queue entries
+ * @v op		Queue pair operations
+ * @ret rc		Return status code
+ */
+static int ipoib_cm_create_qp ( struct ipoib_conn *conn,
+				unsigned int num_recv_wqes,
+				struct ib_queue_pair_operations *op ) {
+	struct ipoib_device *ipoib = conn->ipoib;
+	struct ib_device *ibdev = ipoib->ibdev;
+	int rc;
+
+	/* Limit number of connections */
+	if ( ipoib->num_conns >= IPOIB_CM_MAX_CONNS )
+		return -ENOBUFS;
+
+	/* Create queue pair */
+	if ( ( rc = ib_create_qp ( ibdev, IB_QPT_RC, IPOIB_CM_NUM_SEND_WQES,
+				   ipoib->cm_cq, num_recv_wqes, ipoib->cm_cq,
+				   op, ipoib->netdev->name,
+				   &conn->qp ) ) != 0 ) {
+		DBGC ( ipoib, "IPoIB %p could not create CM queue pair: %s\n",
+		       ipoib, strerror ( rc ) );
+		return rc;
+	}
+	ib_qp_set_ownerdata ( conn->qp, conn );
+	ipoib->num_conns++;
+
+	return 0;
+}
+
+/**
+ * Destroy connected mode queue pair
+ *
+ * @v conn		Connection
+ */
+static void ipoib_cm_destroy_qp ( struct ipoib_conn *conn ) {
+	struct ipoib_device *ipoib = conn->ipoib;
+	struct ib_device *ibdev = ipoib->ibdev;
+
+	/* Destroy connection, if applicable */
+	if ( conn->conn ) {
+		ib_destroy_conn ( ibdev, conn->qp, conn->conn );
+		conn->conn = NULL;
+	}
+
+	/* Destroy queue pair */
+	if ( conn->qp ) {
+		ib_destroy_qp ( ibdev, conn->qp );
+		conn->qp = NULL;
+		ipoib->num_conns--;
+	}
+}
+
+/**
+ * Reap failed connections
+ *
+ * @v ipoib		IPoIB device
+ *
+ * A failed connection attempt is retained (without a queue pair) in
+ * order to avoid repeatedly attempting to connect to a peer that
+ * does not support connected mode.  Other failed connections are
+ * removed, allowing a new connection to be established on demand.
+ */
+static void ipoib_cm_reap ( struct ipoib_device *ipoib ) {
+	struct ipoib_conn *conn;
+	struct ipoib_conn *tmp;
+
+	list_for_each_entry_safe ( conn, tmp, &ipoib->conns, list ) {
+		if ( ! ( conn->rc && conn->qp ) )
+			continue;
+		ipoib_cm_destroy_qp ( conn );
+		if ( conn->passive || conn->connected ) {
+			list_del ( &conn->list );
+			free ( conn );
+		}
+	}
+}
+
+/**
+ * Destroy all connections
+ *
+ * @v ipoib		IPoIB device
+ */
+static void ipoib_cm_flush ( struct ipoib_device *ipoib ) {
+	struct ipoib_conn *conn;
+	struct ipoib_conn *tmp;
+
+	list_for_each_entry_safe ( conn, tmp, &ipoib->conns, list ) {
+		ipoib_cm_destroy_qp ( conn );
+		list_del ( &conn->list );
+		free ( conn );
+	}
+}
+
+/**
+ * Find or create connection to peer
+ *
+ * @v ipoib		IPoIB device
+ * @v mac		Peer MAC address
+ * @ret conn		Established connection, or NULL
+ *
+ * If no connection exists and the peer supports connected mode, a
+ * new connection will be initiated.  Packets will be transmitted in
+ * datagram mode until the connection is established.
+ */
+static struct ipoib_conn * ipoib_cm_connection ( struct ipoib_device *ipoib,
+						 struct ipoib_mac *mac ) {
+	struct ib_device *ibdev = ipoib->ibdev;
+	struct ipoib_cm_data data;
+	union ib_guid service_id;
+	struct ipoib_conn *conn;
+	unsigned long qpn;
+
+	/* Do nothing unless both ends support connected mode */
+	if ( ! ( ipoib->cm_cq &&
+		 ( mac->flags__qpn & htonl ( IPOIB_MAC_CM ) ) ) )
+		return NULL;
+
+	/* Use existing connection, if any */
+	list_for_each_entry ( conn, &ipoib->conns, list ) {
+		if ( conn->passive ||
+		     ( memcmp ( &conn->mac, mac, sizeof ( conn->mac ) ) != 0 ) )
+			continue;
+		if ( conn->rc || ( ! conn->connected ) )
+			return NULL;
+		return conn;
+	}
+
+	/* Allocate and initialise connection */
+	conn = zalloc ( sizeof ( *conn ) );
+	if ( ! conn )
+		return NULL;
+	conn->ipoib = ipoib;
+	memcpy ( &conn->mac, mac, sizeof ( conn->mac ) );
+
+	/* Create queue pair.  We never receive via this connection,
+	 * but the queue pair requires at least one receive entry.
+	 */
+	if ( ipoib_cm_create_qp ( conn, 1, &ipoib_qp_op ) != 0 ) {
+		free ( conn );
+		return NULL;
+	}
+	list_add ( &conn->list, &ipoib->conns );
+
+	/* Initiate connection */
+	qpn = ( ntohl ( mac->flags__qpn ) & IB_QPN_MASK );
+	service_id.dwords[0] = htonl ( IPOIB_CM_SERVICE_ID );
+	service_id.dwords[1] = htonl ( qpn );
+	data.qpn = htonl ( ipoib->qp->qpn );
+	data.mtu = htonl ( IPOIB_CM_BUF_SIZE );
+	conn->conn = ib_create_conn ( ibdev, conn->qp, &mac->gid, &service_id,
+				      &data, sizeof ( data ),
+				      &ipoib_cm_conn_op );
+	if ( ! conn->conn ) {
+		conn->rc = -ENOMEM;
+		return NULL;
+	}
+	DBGC ( ipoib, "IPoIB %p CM connecting to " IB_GID_FMT " QPN %#lx\n",
+	       ipoib, IB_GID_ARGS ( &mac->gid ), qpn );
+
+	return NULL;
+}
+
+/**
+ * Transmit packet via connected mode
+ *
+ * @v conn		Connection
+ * @v iobuf		I/O buffer
+ * @ret rc		Return status code
+ */
+static int ipoib_cm_transmit ( struct ipoib_conn *conn,
+			       struct io_buffer *iobuf ) {
+	struct ipoib_device *ipoib = conn->ipoib;
+
+	/* Check that packet fits within peer's receive buffers */
+	if ( iob_len ( iobuf ) > conn->mtu ) {
+		DBGC ( ipoib, "IPoIB %p packet too large for CM to "
+		       IB_GID_FMT "\n", ipoib, IB_GID_ARGS ( &conn->mac.gid ) );
+		return -ERANGE;
+	}
+
+	/* Transmit packet */
+	return ib_post_send ( ipoib->ibdev, conn->qp, NULL, iobuf );
+}
+
+/**
+ * Handle connection request
+ *
+ * @v ibdev		Infiniband device
+ * @v listener		Listener
+ * @v ib_conn		New communication-managed connection
+ * @v av		Address vector of requester
+ * @v private_data	Request private data
+ * @v private_data_len	Length of request private data
+ * @v reply		Reply private data to fill in
+ * @v reply_len		Length of reply private data
+ * @ret rc		Return status code
+ */
+static int ipoib_cm_request ( struct ib_device *ibdev,
+			      struct ib_listener *listener,
+			      struct ib_connection *ib_conn,
+			      struct ib_address_vector *av,
+			      void *private_data, size_t private_data_len,
+			      void *reply, size_t reply_len ) {
+	struct ipoib_device *ipoib =
+		container_of ( listener, struct ipoib_device, listener );
+	struct ipoib_cm_data *data = private_data;
+	struct ipoib_cm_data *rep = reply;
+	struct ipoib_conn *conn;
+	int rc;
+
+	/* Sanity checks */
+	if ( ( private_data_len < sizeof ( *data ) ) ||
+	     ( reply_len < sizeof ( *rep ) ) )
+		return -EINVAL;
+
+	/* Allocate and initialise connection */
+	conn = zalloc ( sizeof ( *conn ) );
+	if ( ! conn ) {
+		rc = -ENOMEM;
+		goto err_alloc;
+	}
+	conn->ipoib = ipoib;
+	conn->passive = 1;
+	conn->mac.flags__qpn = htonl ( ntohl ( data->qpn ) & IB_QPN_MASK );
+	memcpy ( &conn->mac.gid, &av->gid, sizeof ( conn->mac.gid ) );
+
+	/* Create queue pair */
+	if ( ( rc = ipoib_cm_create_qp ( conn, IPOIB_CM_NUM_RECV_WQES,
+					 &ipoib_cm_qp_op ) ) != 0 )
+		goto err_create_qp;
+	ib_refill_recv ( ibdev, conn->qp );
+
+	/* Accept connection */
+	ib_conn->qp = conn->qp;
+	ib_conn->op = &ipoib_cm_conn_op;
+	conn->conn = ib_conn;
+	rep->qpn = htonl ( ipoib->qp->qpn );
+	rep->mtu = htonl ( IPOIB_CM_BUF_SIZE );
+	list_add ( &conn->list, &ipoib->conns );
+	DBGC ( ipoib, "IPoIB %p CM accepting from " IB_GID_FMT " QPN %#x\n",
+	       ipoib, IB_GID_ARGS ( &conn->mac.gid ),
+	       ntohl ( conn->mac.flags__qpn ) );
+
+	return 0;
+
+	ipoib_cm_destroy_qp ( conn );
+ err_create_qp:
+	free ( conn );
+ err_alloc:
+	return rc;
+}
+
+/** IPoIB connected mode listener operations */
+static struct ib_listener_operations ipoib_cm_listener_op = {
+	.request = ipoib_cm_request,
+};
+
+/**
+ * Handle IPoIB connected mode send completion
+ *
+ * @v ibdev		Infiniband device
+ * @v qp		Queue pair
+ * @v iobuf		I/O buffer
+ * @v rc		Completion status code
+ */
+static void ipoib_cm_complete_send ( struct ib_device *ibdev __unused,
+				     struct ib_queue_pair *qp,
+				     struct io_buffer *iobuf, int rc ) {
+	struct ipoib_conn *conn = ib_qp_get_ownerdata ( qp );
+
+	/* Treat any send failure as a broken connection */
+	if ( rc && ( ! conn->rc ) )
+		conn->rc = rc;
+
+	netdev_tx_complete_err ( conn->ipoib->netdev, iobuf, rc );
+}
+
+/**
+ * Handle IPoIB connected mode receive completion
+ *
+ * @v ibdev		Infiniband device
+ * @v qp		Queue pair
+ * @v dest		Destination address vector, or NULL
+ * @v source		Source address vector, or NULL
+ * @v iobuf		I/O buffer
+ * @v rc		Completion status code
+ */
+static void ipoib_cm_complete_recv ( struct ib_device *ibdev __unused,
+				     struct ib_queue_pair *qp,
+				     struct ib_address_vector *dest __unused,
+				     struct ib_address_vector *source __unused,
+				     struct io_buffer *iobuf, int rc ) {
+	struct ipoib_conn *conn = ib_qp_get_ownerdata ( qp );
+	struct ipoib_device *ipoib = conn->ipoib;
+	struct net_device *netdev = ipoib->netdev;
+	struct ipoib_remac remac;
+
+	/* Record errors */
+	if ( rc != 0 ) {
+		netdev_rx_err ( netdev, iobuf, rc );
+		return;
+	}
+
+	/* Sanity check */
+	if ( iob_len ( iobuf ) < sizeof ( struct ipoib_hdr ) ) {
+		DBGC ( ipoib, "IPoIB %p received CM packet too short to "
+		       "contain IPoIB header\n", ipoib );
+		netdev_rx_err ( netdev, iobuf, -EIO );
+		return;
+	}
+
+	/* Construct source address from peer's datagram QPN and LID */
+	remac.qpn = htonl ( ntohl ( conn->mac.flags__qpn ) | EIPOIB_QPN_LA );
+	remac.lid = htons ( qp->av.lid );
+
+	/* Hand off to network layer */
+	ipoib_rx ( ipoib, iobuf, &remac, 0 );
+}
+
+/** IPoIB connected mode completion operations */
+static struct ib_completion_queue_operations ipoib_cm_cq_op = {
+	.complete_send = ipoib_cm_complete_send,
+	.complete_recv = ipoib_cm_complete_recv,
+};
+
+/**
+ * Enable connected mode
+ *
+ * @v ipoib		IPoIB device
+ * @ret rc		Return status code
+ */
+static int ipoib_cm_open ( struct ipoib_device *ipoib ) {
+	struct ib_device *ibdev = ipoib->ibdev;
+	union ib_guid service_id;
+	int rc;
+
+	/* Allocate completion queue */
+	if ( ( rc = ib_create_cq ( ibdev, IPOIB_CM_NUM_CQES, &ipoib_cm_cq_op,
+				   &ipoib->cm_cq ) ) != 0 ) {
+		DBGC ( ipoib, "IPoIB %p could not create CM completion queue: "
+		       "%s\n", ipoib, strerror ( rc ) );
+		return rc;
+	}
+
+	/* Listen for incoming connections */
+	service_id.dwords[0] = htonl ( IPOIB_CM_SERVICE_ID );
+	service_id.dwords[1] = htonl ( ipoib->qp->qpn );
+	ib_listen ( ibdev, &ipoib->listener, &service_id,
+		    &ipoib_cm_listener_op );
+
+	/* Advertise connected mode support */
+	ipoib->mac.flags__qpn |= htonl ( IPOIB_MAC_CM );
+
+	return 0;
+}
+
+/**
+ * Disable connected mode
+ *
+ * @v ipoib		IPoIB device
+ */
+static void ipoib_cm_close ( struct ipoib_device *ipoib ) {
+
+	/* Do nothing unless connected mode is enabled */
+	if ( ! ipoib->cm_cq )
+		return;
+
+	/* Stop listening for incoming connections */
+	ib_unlisten ( &ipoib->listener );
+
+	/* Destroy all connections */
+	ipoib_cm_flush ( ipoib );
+
+	/* Destroy completion queue */
+	ib_destroy_cq ( ipoib->ibdev, ipoib->cm_cq );
+	ipoib->cm_cq = NULL;
+}
+
 /**
  * Poll IPoIB network device
  *
@@ -739,6 +1301,9 @@ static void ipoib_poll ( struct net_device *netdev ) {
 	/* Poll Infiniband device */
 	ib_poll_eq ( ibdev );
 
+	/* Reap any failed connected mode connections */
+	ipoib_cm_reap ( ipoib );
+
 	/* Poll the retry timers (required for IPoIB multicast join) */
 	retry_poll();
 }
@@ -875,6 +1440,11 @@ static int ipoib_open ( struct net_device *netdev ) {
 	/* Update MAC address with QPN */
 	ipoib->mac.flags__qpn = htonl ( ipoib->qp->qpn );
 
+	/* Enable connected mode, if required by MTU */
+	if ( ( netdev->mtu > IPOIB_UD_MTU ) &&
+	     ( ( rc = ipoib_cm_open ( ipoib ) ) != 0 ) )
+		goto err_cm_open;
+
 	/* Fill receive rings */
 	ib_refill_recv ( ibdev, ipoib->qp );
 
@@ -883,6 +1453,8 @@ static int ipoib_open ( struct net_device *netdev ) {
 
 	return 0;
 
+	ipoib_cm_close ( ipoib );
+ err_cm_open:
 	ib_destroy_qp ( ibdev, ipoib->qp );
  err_create_qp:
 	ib_destroy_cq ( ibdev, ipoib->cq );
@@ -907,6 +1479,9 @@ static void ipoib_close ( struct net_device *netdev ) {
 	/* Leave broadcast group */
 	ipoib_leave_broadcast_group ( ipoib );
 
+	/* Disable connected mode */
+	ipoib_cm_close ( ipoib );
+
 	/* Remove QPN from MAC address */
 	ipoib->mac.flags__qpn = 0;
 
@@ -950,6 +1525,11 @@ static int ipoib_probe ( struct ib_device *ibdev ) {
 	ipoib->netdev = netdev;
 	ipoib->ibdev = ibdev;
 	INIT_LIST_HEAD ( &ipoib->peers );
+	INIT_LIST_HEAD ( &ipoib->conns );
+
+	/* Allow for connected mode MTU, defaulting to datagram mode */
+	netdev->max_pkt_len = ( ETH_HLEN + IPOIB_CM_MTU );
+	netdev->mtu = IPOIB_UD_MTU;
 
 	/* Extract hardware address */
 	memcpy ( netdev->hw_addr, &ibdev->gid.s.guid,
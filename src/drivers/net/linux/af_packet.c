@@ -47,6 +47,7 @@
 #define LINUX_SIOCGIFHWADDR 0x8927
 
 #define RX_BUF_SIZE 1536
+#define RX_QUOTA NETDEV_RX_BUDGET
 
 /** @file
  *
@@ -157,31 +158,25 @@ static int af_packet_nic_transmit ( struct net_device *netdev,
 	return 0;
 }
 
-/** Poll for new packets */
+/**
+ * Poll for new packets
+ *
+ * The socket is nonblocking, so we simply read until it runs dry (or
+ * the quota is exhausted) without a separate poll() system call.
+ */
 static void af_packet_nic_poll ( struct net_device *netdev )
 {
 	struct af_packet_nic * nic = netdev->priv;
-	struct pollfd pfd;
 	struct io_buffer * iobuf;
+	unsigned int quota = RX_QUOTA;
 	int r;
 
-	pfd.fd = nic->fd;
-	pfd.events = POLLIN;
-	if (linux_poll(&pfd, 1, 0) == -1) {
-		DBGC(nic, "af_packet %p poll failed (%s)\n",
-		     nic, linux_strerror(linux_errno));
-		return;
-	}
-	if ((pfd.revents & POLLIN) == 0)
-		return;
-
-	/* At this point we know there is at least one new packet to be read */
-
 	iobuf = alloc_iob(RX_BUF_SIZE);
 	if (! iobuf)
 		goto allocfail;
 
-	while ((r = linux_read(nic->fd, iobuf->data, RX_BUF_SIZE)) > 0) {
+	while (quota-- &&
+	       ((r = linux_read(nic->fd, iobuf->data, RX_BUF_SIZE)) > 0)) {
 		DBGC2(nic, "af_packet %p read %d bytes\n", nic, r);
 
 		iob_put(iobuf, r);
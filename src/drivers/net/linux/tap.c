@@ -38,9 +38,11 @@
 #include <linux/if.h>
 #include <linux/if_ether.h>
 #include <linux/if_tun.h>
+#include <linux/uio.h>
+#include <linux/virtio_net.h>
 
 #define RX_BUF_SIZE 1536
-#define RX_QUOTA 4
+#define RX_QUOTA NETDEV_RX_BUDGET
 
 /** @file
  *
@@ -74,8 +76,11 @@ static int tap_open(struct net_device * netdev)
 	}
 
 	memset(&ifr, 0, sizeof(ifr));
-	/* IFF_NO_PI for no extra packet information */
-	ifr.ifr_flags = IFF_TAP | IFF_NO_PI;
+	/* IFF_NO_PI for no extra packet information, IFF_VNET_HDR to
+	 * pass checksum and segmentation offload information alongside
+	 * each packet
+	 */
+	ifr.ifr_flags = IFF_TAP | IFF_NO_PI | IFF_VNET_HDR;
 	strncpy(ifr.ifr_name, nic->interface, IFNAMSIZ);
 	DBGC(nic, "tap %p interface = '%s'\n", nic, nic->interface);
 
@@ -87,6 +92,16 @@ static int tap_open(struct net_device * netdev)
 		return ret;
 	}
 
+	/* Accept packets with partial checksums, but never large
+	 * (GSO) packets, which would not fit in our receive buffers
+	 */
+	ret = linux_ioctl(nic->fd, TUNSETOFFLOAD, TUN_F_CSUM);
+
+	if (ret != 0) {
+		DBGC(nic, "tap %p ioctl(%d, TUNSETOFFLOAD) = %d (%s)\n", nic, nic->fd, ret, linux_strerror(linux_errno));
+		/* Not fatal: the kernel will checksum packets for us */
+	}
+
 	/* Set nonblocking mode to make tap_poll easier */
 	ret = linux_fcntl(nic->fd, F_SETFL, O_NONBLOCK);
 
@@ -106,6 +121,34 @@ static void tap_close(struct net_device *netdev)
 	linux_close(nic->fd);
 }
 
+/**
+ * Construct virtio net header for a transmitted packet
+ *
+ * The TAP device uses a native-endian legacy virtio net header.
+ */
+static void tap_tx_header(struct virtio_net_hdr *hdr, struct io_buffer *iobuf)
+{
+	size_t start = (iobuf->trans_hdr - iobuf->data);
+
+	memset(hdr, 0, sizeof(*hdr));
+
+	/* Request checksum offload, if applicable */
+	if (iobuf->flags & IOB_TX_CSUM) {
+		hdr->flags = VIRTIO_NET_HDR_F_NEEDS_CSUM;
+		hdr->csum_start = start;
+		hdr->csum_offset = iobuf->csum_offset;
+	}
+
+	/* Request segmentation offload, if applicable */
+	if (iobuf->flags & IOB_TX_TSO) {
+		hdr->gso_type = ((iobuf->flags & IOB_TX_IPV6) ?
+				 VIRTIO_NET_HDR_GSO_TCPV6 :
+				 VIRTIO_NET_HDR_GSO_TCPV4);
+		hdr->hdr_len = (start + iobuf->trans_hdr_len);
+		hdr->gso_size = iobuf->mss;
+	}
+}
+
 /**
  * Transmit an ethernet packet.
  *
@@ -114,47 +157,70 @@ static void tap_close(struct net_device *netdev)
 static int tap_transmit(struct net_device *netdev, struct io_buffer *iobuf)
 {
 	struct tap_nic * nic = netdev->priv;
+	struct virtio_net_hdr hdr;
+	unsigned int count = (1 + iob_count(iobuf));
+	struct iovec iov[count];
+	struct io_buffer *frag;
+	unsigned int i;
 	int rc;
 
-	/* Pad and align packet */
-	iob_pad(iobuf, ETH_ZLEN);
-
-	rc = linux_write(nic->fd, iobuf->data, iobuf->tail - iobuf->data);
+	/* Pad and align packet (if not chained) */
+	if (! iobuf->frag)
+		iob_pad(iobuf, ETH_ZLEN);
+
+	/* Write header and packet (and any fragments) with a single
+	 * system call
+	 */
+	tap_tx_header(&hdr, iobuf);
+	iov[0].iov_base = &hdr;
+	iov[0].iov_len = sizeof(hdr);
+	for (frag = iobuf, i = 1; frag; frag = frag->frag, i++) {
+		iov[i].iov_base = frag->data;
+		iov[i].iov_len = iob_len(frag);
+	}
+	rc = linux_writev(nic->fd, iov, count);
 	DBGC2(nic, "tap %p wrote %d bytes\n", nic, rc);
 	netdev_tx_complete(netdev, iobuf);
 
 	return 0;
 }
 
-/** Poll for new packets */
+/**
+ * Poll for new packets
+ *
+ * The descriptor is nonblocking, so we simply read until it runs dry
+ * (or the quota is exhausted) without a separate poll() system call.
+ */
 static void tap_poll(struct net_device *netdev)
 {
 	struct tap_nic * nic = netdev->priv;
-	struct pollfd pfd;
+	struct virtio_net_hdr hdr;
+	struct iovec iov[2];
 	struct io_buffer * iobuf;
 	unsigned int quota = RX_QUOTA;
 	int r;
 
-	pfd.fd = nic->fd;
-	pfd.events = POLLIN;
-	if (linux_poll(&pfd, 1, 0) == -1) {
-		DBGC(nic, "tap %p poll failed (%s)\n", nic, linux_strerror(linux_errno));
-		return;
-	}
-	if ((pfd.revents & POLLIN) == 0)
-		return;
-
-	/* At this point we know there is at least one new packet to be read */
-
 	iobuf = alloc_iob(RX_BUF_SIZE);
 	if (! iobuf)
 		goto allocfail;
 
-	while (quota-- &&
-	       ((r = linux_read(nic->fd, iobuf->data, RX_BUF_SIZE)) > 0)) {
+	iov[0].iov_base = &hdr;
+	iov[0].iov_len = sizeof(hdr);
+	iov[1].iov_len = RX_BUF_SIZE;
+
+	while (quota--) {
+		iov[1].iov_base = iobuf->data;
+		r = linux_readv(nic->fd, iov, 2);
+		if (r <= (int) sizeof(hdr))
+			break;
 		DBGC2(nic, "tap %p read %d bytes\n", nic, r);
 
-		iob_put(iobuf, r);
+		/* Partial and verified checksums need no further checks */
+		if (hdr.flags & (VIRTIO_NET_HDR_F_NEEDS_CSUM |
+				 VIRTIO_NET_HDR_F_DATA_VALID))
+			iobuf->flags |= IOB_CSUM_VALID;
+
+		iob_put(iobuf, (r - sizeof(hdr)));
 		netdev_rx(netdev, iobuf);
 
 		iobuf = alloc_iob(RX_BUF_SIZE);
@@ -207,6 +273,10 @@ static int tap_probe(struct linux_device *device, struct linux_device_request *r
 	linux_set_drvdata(device, netdev);
 	netdev->dev = &device->dev;
 	memcpy ( netdev->hw_addr, tap_default_mac, ETH_ALEN );
+	netdev->tx_offloads = ( NETDEV_TX_OFFLOAD_CSUM |
+				NETDEV_TX_OFFLOAD_TSO4 |
+				NETDEV_TX_OFFLOAD_TSO6 |
+				NETDEV_TX_OFFLOAD_SG );
 	memset(nic, 0, sizeof(*nic));
 
 	/* Look for the mandatory if setting */
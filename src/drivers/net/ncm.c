@@ -26,6 +26,7 @@ FILE_SECBOOT ( PERMITTED );
 
 #include <string.h>
 #include <errno.h>
+#include <assert.h>
 #include <ipxe/netdevice.h>
 #include <ipxe/ethernet.h>
 #include <ipxe/if_ether.h>
@@ -395,6 +396,161 @@ static int ncm_out_transmit ( struct ncm_device *ncm,
 	return 0;
 }
 
+/**
+ * Calculate aggregated NTB header length
+ *
+ * @v ncm		CDC-NCM device
+ * @ret len		Header length
+ */
+static inline size_t ncm_ntb_header_len ( struct ncm_device *ncm ) {
+
+	return ( sizeof ( struct ncm_transfer_header ) +
+		 offsetof ( struct ncm_datagram_pointer, desc ) +
+		 ( ( ncm->out_max + 1 /* terminator */ ) *
+		   sizeof ( struct ncm_datagram_descriptor ) ) );
+}
+
+/**
+ * Calculate aligned offset for next datagram within aggregated NTB
+ *
+ * @v ncm		CDC-NCM device
+ * @v len		Current NTB length
+ * @ret offset		Datagram offset
+ */
+static inline size_t ncm_ntb_offset ( struct ncm_device *ncm, size_t len ) {
+
+	return ( len + ( ( ncm->remainder - ETH_HLEN - len ) &
+			 ( ncm->divisor - 1 ) ) );
+}
+
+/**
+ * Submit aggregated NTB
+ *
+ * @v ncm		CDC-NCM device
+ */
+static void ncm_out_flush ( struct ncm_device *ncm ) {
+	struct io_buffer *ntb = ncm->ntb;
+	struct ncm_transfer_header *nth;
+	int rc;
+
+	/* Do nothing unless an NTB is under construction */
+	if ( ! ntb )
+		return;
+	ncm->ntb = NULL;
+
+	/* Complete transfer header */
+	nth = ntb->data;
+	nth->sequence = cpu_to_le16 ( ncm->sequence );
+	nth->len = cpu_to_le16 ( iob_len ( ntb ) );
+
+	/* Enqueue I/O buffer.  The aggregated packets have already
+	 * been reported as complete, so any failure can be recorded
+	 * only as a transmit error against the network device.
+	 */
+	if ( ( rc = usb_stream ( &ncm->usbnet.out, ntb, 0 ) ) != 0 ) {
+		DBGC ( ncm, "NCM %p could not transmit %d-datagram NTB: %s\n",
+		       ncm, ncm->ntb_count, strerror ( rc ) );
+		free_iob ( ntb );
+		netdev_tx_err ( ncm->netdev, NULL, rc );
+		return;
+	}
+	list_add_tail ( &ntb->list, &ncm->ntbs );
+
+	/* Increment sequence number */
+	ncm->sequence++;
+}
+
+/**
+ * Check if packet may be aggregated
+ *
+ * @v ncm		CDC-NCM device
+ * @v iobuf		I/O buffer
+ * @ret aggregate	Packet may be aggregated
+ */
+static int ncm_out_aggregatable ( struct ncm_device *ncm,
+				  struct io_buffer *iobuf ) {
+	size_t offset;
+
+	/* Aggregate only while the bulk OUT endpoint is busy */
+	if ( ncm->usbnet.out.fill < NCM_OUT_MAX_FILL )
+		return 0;
+
+	/* Aggregate only if the device accepts multiple datagrams */
+	if ( ncm->out_max < 2 )
+		return 0;
+
+	/* Aggregate only if packet fits within an empty NTB */
+	offset = ncm_ntb_offset ( ncm, ncm_ntb_header_len ( ncm ) );
+	if ( ( offset + iob_len ( iobuf ) ) > ncm->out_mtu )
+		return 0;
+
+	return 1;
+}
+
+/**
+ * Add packet to aggregated NTB
+ *
+ * @v ncm		CDC-NCM device
+ * @v iobuf		I/O buffer
+ * @ret rc		Return status code
+ *
+ * The packet data is copied into the aggregated NTB, and the I/O
+ * buffer remains owned by the caller.
+ */
+static int ncm_out_aggregate ( struct ncm_device *ncm,
+			       struct io_buffer *iobuf ) {
+	struct ncm_transfer_header *nth;
+	struct ncm_datagram_pointer *ndp;
+	struct ncm_datagram_descriptor *desc;
+	struct io_buffer *ntb;
+	size_t len = iob_len ( iobuf );
+	size_t header_len;
+	size_t offset;
+
+	/* Submit current NTB if this packet will not fit */
+	if ( ncm->ntb ) {
+		offset = ncm_ntb_offset ( ncm, iob_len ( ncm->ntb ) );
+		if ( ( ncm->ntb_count >= ncm->out_max ) ||
+		     ( ( offset + len ) > ncm->out_mtu ) ) {
+			ncm_out_flush ( ncm );
+		}
+	}
+
+	/* Start a new NTB, if applicable */
+	if ( ! ncm->ntb ) {
+		ntb = alloc_iob ( ncm->out_mtu );
+		if ( ! ntb )
+			return -ENOMEM;
+		header_len = ncm_ntb_header_len ( ncm );
+		nth = iob_put ( ntb, header_len );
+		memset ( nth, 0, header_len );
+		nth->magic = cpu_to_le32 ( NCM_TRANSFER_HEADER_MAGIC );
+		nth->header_len = cpu_to_le16 ( sizeof ( *nth ) );
+		nth->offset = cpu_to_le16 ( sizeof ( *nth ) );
+		ndp = ( ( void * ) ( nth + 1 ) );
+		ndp->magic = cpu_to_le32 ( NCM_DATAGRAM_POINTER_MAGIC );
+		ndp->header_len = cpu_to_le16 ( header_len - sizeof ( *nth ) );
+		ncm->ntb = ntb;
+		ncm->ntb_count = 0;
+	}
+	ntb = ncm->ntb;
+	ndp = ( ntb->data + sizeof ( *nth ) );
+
+	/* Copy in datagram */
+	offset = ncm_ntb_offset ( ncm, iob_len ( ntb ) );
+	memset ( iob_put ( ntb, ( offset - iob_len ( ntb ) ) ), 0,
+		 ( offset - iob_len ( ntb ) ) );
+	memcpy ( iob_put ( ntb, len ), iobuf->data, len );
+	assert ( iob_len ( ntb ) <= ncm->out_mtu );
+
+	/* Populate descriptor */
+	desc = &ndp->desc[ ncm->ntb_count++ ];
+	desc->offset = cpu_to_le16 ( offset );
+	desc->len = cpu_to_le16 ( len );
+
+	return 0;
+}
+
 /**
  * Complete bulk OUT transfer
  *
@@ -407,9 +563,28 @@ static void ncm_out_complete ( struct usb_endpoint *ep, struct io_buffer *iobuf,
 	struct ncm_device *ncm = container_of ( ep, struct ncm_device,
 						usbnet.out );
 	struct net_device *netdev = ncm->netdev;
+	struct io_buffer *ntb;
 
-	/* Report TX completion */
-	netdev_tx_complete_err ( netdev, iobuf, rc );
+	/* Free aggregated NTB, or report TX completion */
+	list_for_each_entry ( ntb, &ncm->ntbs, list ) {
+		if ( ntb == iobuf )
+			break;
+	}
+	if ( ntb == iobuf ) {
+		list_del ( &ntb->list );
+		free_iob ( ntb );
+		if ( rc != 0 ) {
+			DBGC ( ncm, "NCM %p aggregated NTB failed: %s\n",
+			       ncm, strerror ( rc ) );
+			netdev_tx_err ( netdev, NULL, rc );
+		}
+	} else {
+		netdev_tx_complete_err ( netdev, iobuf, rc );
+	}
+
+	/* Submit any aggregated NTB under construction */
+	if ( ep->open )
+		ncm_out_flush ( ncm );
 }
 
 /** Bulk OUT endpoint operations */
@@ -490,6 +665,11 @@ static void ncm_close ( struct net_device *netdev ) {
 
 	/* Close USB network device */
 	usbnet_close ( &ncm->usbnet );
+
+	/* Discard any aggregated NTB under construction */
+	free_iob ( ncm->ntb );
+	ncm->ntb = NULL;
+	assert ( list_empty ( &ncm->ntbs ) );
 }
 
 /**
@@ -504,6 +684,20 @@ static int ncm_transmit ( struct net_device *netdev,
 	struct ncm_device *ncm = netdev->priv;
 	int rc;
 
+	/* Aggregate packet into a shared NTB while the bulk OUT
+	 * endpoint is busy.  The packet data is copied, and so the
+	 * packet can be reported as complete immediately.
+	 */
+	if ( ncm_out_aggregatable ( ncm, iobuf ) ) {
+		if ( ( rc = ncm_out_aggregate ( ncm, iobuf ) ) != 0 )
+			return rc;
+		netdev_tx_complete ( netdev, iobuf );
+		return 0;
+	}
+
+	/* Submit any aggregated NTB, to preserve packet ordering */
+	ncm_out_flush ( ncm );
+
 	/* Transmit packet */
 	if ( ( rc = ncm_out_transmit ( ncm, iobuf ) ) != 0 )
 		return rc;
@@ -523,6 +717,10 @@ static void ncm_poll ( struct net_device *netdev ) {
 	/* Poll USB bus */
 	usb_poll ( ncm->bus );
 
+	/* Submit any aggregated NTB once the bulk OUT endpoint is idle */
+	if ( ncm->usbnet.out.fill < NCM_OUT_MAX_FILL )
+		ncm_out_flush ( ncm );
+
 	/* Refill endpoints */
 	if ( ( rc = usbnet_refill ( &ncm->usbnet ) ) != 0 )
 		netdev_rx_err ( netdev, NULL, rc );
@@ -576,6 +774,7 @@ static int ncm_probe ( struct usb_function *func,
 	ncm->usb = usb;
 	ncm->bus = usb->port->hub->bus;
 	ncm->netdev = netdev;
+	INIT_LIST_HEAD ( &ncm->ntbs );
 	usbnet_init ( &ncm->usbnet, func, &ncm_intr_operations,
 		      &ncm_in_operations, &ncm_out_operations );
 	usb_refill_init ( &ncm->usbnet.intr, 0, 0, NCM_INTR_COUNT );
@@ -629,6 +828,18 @@ static int ncm_probe ( struct usb_function *func,
 	assert ( ( ( sizeof ( struct ncm_ntb_header ) + ncm->padding +
 		     ETH_HLEN ) % divisor ) == remainder );
 
+	/* Determine aggregated NTB limits */
+	ncm->divisor = divisor;
+	ncm->remainder = remainder;
+	ncm->out_mtu = le32_to_cpu ( params.out.mtu );
+	if ( ncm->out_mtu > NCM_OUT_MAX_SIZE )
+		ncm->out_mtu = NCM_OUT_MAX_SIZE;
+	ncm->out_max = le16_to_cpu ( params.max );
+	if ( ( ! ncm->out_max ) || ( ncm->out_max > NCM_OUT_MAX_DATAGRAMS ) )
+		ncm->out_max = NCM_OUT_MAX_DATAGRAMS;
+	DBGC2 ( ncm, "NCM %p aggregating up to %d datagrams in %zd bytes\n",
+		ncm, ncm->out_max, ncm->out_mtu );
+
 	/* Register network device */
 	if ( ( rc = register_netdev ( netdev ) ) != 0 )
 		goto err_register;
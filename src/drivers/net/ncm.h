@@ -14,6 +14,7 @@ FILE_SECBOOT ( PERMITTED );
 #include <ipxe/usb.h>
 #include <ipxe/cdc.h>
 #include <byteswap.h>
+#include <config/netdev.h>
 #include "ecm.h"
 
 /** CDC-NCM subclass */
@@ -150,25 +151,22 @@ struct ncm_device {
 	uint16_t sequence;
 	/** Alignment padding required on transmitted packets */
 	size_t padding;
-};
 
-/** Bulk IN ring minimum buffer count
- *
- * This is a policy decision.
- */
-#define NCM_IN_MIN_COUNT 3
-
-/** Bulk IN ring minimum total buffer size
- *
- * This is a policy decision.
- */
-#define NCM_IN_MIN_SIZE 16384
-
-/** Bulk IN ring maximum total buffer size
- *
- * This is a policy decision.
- */
-#define NCM_IN_MAX_SIZE 131072
+	/** Alignment divisor for transmitted datagrams */
+	unsigned int divisor;
+	/** Alignment remainder for transmitted datagrams */
+	unsigned int remainder;
+	/** Maximum aggregated NTB size */
+	size_t out_mtu;
+	/** Maximum number of datagrams per aggregated NTB */
+	unsigned int out_max;
+	/** Aggregated NTB under construction, if any */
+	struct io_buffer *ntb;
+	/** Number of datagrams in aggregated NTB under construction */
+	unsigned int ntb_count;
+	/** Aggregated NTBs in progress */
+	struct list_head ntbs;
+};
 
 /** Interrupt ring buffer count
  *
@@ -26,7 +26,9 @@ FILE_SECBOOT ( PERMITTED );
 
 #include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 #include <errno.h>
+#include <assert.h>
 #include <ipxe/netdevice.h>
 #include <ipxe/ethernet.h>
 #include <ipxe/if_ether.h>
@@ -334,6 +336,9 @@ static int netfront_create_ring ( struct netfront_nic *netfront,
 	unsigned int i;
 	int rc;
 
+	/* Sanity check */
+	assert ( ( ring->count & ( ring->count - 1 ) ) == 0 );
+
 	/* Initialise buffer ID ring */
 	for ( i = 0 ; i < ring->count ; i++ ) {
 		ring->ids[i] = i;
@@ -363,10 +368,44 @@ static int netfront_create_ring ( struct netfront_nic *netfront,
 					 ring->ref ) ) != 0 )
 		goto err_write_num;
 
-	DBGC ( netfront, "NETFRONT %s %s=\"%d\" [%08lx,%08lx)\n", xendev->key,
-	       ring->ref_key, ring->ref, addr, ( addr + PAGE_SIZE ) );
+	/* Allocate buffer pages */
+	ring->pages = malloc_phys ( ( ring->count * PAGE_SIZE ), PAGE_SIZE );
+	if ( ! ring->pages ) {
+		rc = -ENOMEM;
+		goto err_alloc_pages;
+	}
+
+	/* Grant persistent access to buffer pages.  Each buffer ID
+	 * retains its page and grant reference for the lifetime of
+	 * the ring, so that no grant table updates are required on
+	 * the data path.
+	 */
+	for ( i = 0 ; i < ring->count ; i++ ) {
+		addr = virt_to_phys ( netfront_page ( ring, i ) );
+		if ( ( rc = xengrant_permit_access ( xen, ring->refs[i],
+						     xendev->backend_id, 0,
+						     addr ) ) != 0 ) {
+			DBGC ( netfront, "NETFRONT %s could not permit access "
+			       "to %#08lx: %s\n", xendev->key, addr,
+			       strerror ( rc ) );
+			goto err_permit_access_pages;
+		}
+	}
+
+	DBGC ( netfront, "NETFRONT %s %s=\"%d\" [%08lx,%08lx) buffers "
+	       "[%08lx,%08lx)\n", xendev->key, ring->ref_key, ring->ref,
+	       virt_to_phys ( ring->sring.raw ),
+	       ( virt_to_phys ( ring->sring.raw ) + PAGE_SIZE ),
+	       virt_to_phys ( ring->pages ),
+	       ( virt_to_phys ( ring->pages ) + ( ring->count * PAGE_SIZE ) ));
 	return 0;
 
+ err_permit_access_pages:
+	while ( i-- )
+		xengrant_invalidate ( xen, ring->refs[i] );
+	free_phys ( ring->pages, ( ring->count * PAGE_SIZE ) );
+	ring->pages = NULL;
+ err_alloc_pages:
 	netfront_rm ( netfront, ring->ref_key );
  err_write_num:
 	xengrant_invalidate ( xen, ring->ref );
@@ -379,41 +418,25 @@ static int netfront_create_ring ( struct netfront_nic *netfront,
 /**
  * Add buffer to descriptor ring
  *
- * @v netfront		Netfront device
  * @v ring		Descriptor ring
- * @v addr		Physical address
  * @v iobuf		Associated I/O buffer, or NULL
  * @v id		Buffer ID to fill in
  * @v ref		Grant reference to fill in
- * @ret rc		Return status code
+ * @ret page		Buffer page
  *
  * The caller is responsible for ensuring that there is space in the
  * ring.
  */
-static int netfront_push ( struct netfront_nic *netfront,
-			   struct netfront_ring *ring, physaddr_t addr,
-			   struct io_buffer *iobuf, uint16_t *id,
-			   grant_ref_t *ref ) {
-	struct xen_device *xendev = netfront->xendev;
-	struct xen_hypervisor *xen = xendev->xen;
+static void * netfront_push ( struct netfront_ring *ring,
+			      struct io_buffer *iobuf, uint16_t *id,
+			      grant_ref_t *ref ) {
 	unsigned int next_id;
-	unsigned int next_ref;
-	int rc;
 
 	/* Sanity check */
 	assert ( ! netfront_ring_is_full ( ring ) );
 
 	/* Allocate buffer ID */
 	next_id = ring->ids[ ring->id_prod & ( ring->count - 1 ) ];
-	next_ref = ring->refs[next_id];
-
-	/* Grant access to page containing address */
-	if ( ( rc = xengrant_permit_access ( xen, next_ref, xendev->backend_id,
-					     0, addr ) ) != 0 ) {
-		DBGC ( netfront, "NETFRONT %s could not permit access to "
-		       "%#08lx: %s\n", xendev->key, addr, strerror ( rc ) );
-		return rc;
-	}
 
 	/* Store associated I/O buffer, if any */
 	assert ( ring->iobufs[next_id] == NULL );
@@ -424,32 +447,25 @@ static int netfront_push ( struct netfront_nic *netfront,
 
 	/* Return buffer ID and grant reference */
 	*id = next_id;
-	*ref = next_ref;
+	*ref = ring->refs[next_id];
 
-	return 0;
+	return netfront_page ( ring, next_id );
 }
 
 /**
  * Remove buffer from descriptor ring
  *
- * @v netfront		Netfront device
  * @v ring		Descriptor ring
  * @v id		Buffer ID
  * @ret iobuf		Associated I/O buffer, if any
  */
-static struct io_buffer * netfront_pull ( struct netfront_nic *netfront,
-					  struct netfront_ring *ring,
+static struct io_buffer * netfront_pull ( struct netfront_ring *ring,
 					  unsigned int id ) {
-	struct xen_device *xendev = netfront->xendev;
-	struct xen_hypervisor *xen = xendev->xen;
 	struct io_buffer *iobuf;
 
 	/* Sanity check */
 	assert ( id < ring->count );
 
-	/* Revoke access from I/O buffer page */
-	xengrant_invalidate ( xen, ring->refs[id] );
-
 	/* Retrieve I/O buffer */
 	iobuf = ring->iobufs[id];
 	ring->iobufs[id] = NULL;
@@ -474,15 +490,24 @@ static void netfront_destroy_ring ( struct netfront_nic *netfront,
 	struct xen_hypervisor *xen = xendev->xen;
 	struct io_buffer *iobuf;
 	unsigned int id;
+	unsigned int i;
 
 	/* Flush any outstanding buffers */
 	while ( ! netfront_ring_is_empty ( ring ) ) {
 		id = ring->ids[ ring->id_cons & ( ring->count - 1 ) ];
-		iobuf = netfront_pull ( netfront, ring, id );
-		if ( discard )
+		iobuf = netfront_pull ( ring, id );
+		if ( discard && iobuf )
 			discard ( iobuf );
 	}
 
+	/* Revoke access from buffer pages */
+	for ( i = 0 ; i < ring->count ; i++ )
+		xengrant_invalidate ( xen, ring->refs[i] );
+
+	/* Free buffer pages */
+	free_phys ( ring->pages, ( ring->count * PAGE_SIZE ) );
+	ring->pages = NULL;
+
 	/* Unpublish shared ring reference */
 	netfront_rm ( netfront, ring->ref_key );
 
@@ -525,36 +550,20 @@ static void netfront_discard ( struct netfront_nic *netfront ) {
 static void netfront_refill_rx ( struct net_device *netdev ) {
 	struct netfront_nic *netfront = netdev->priv;
 	struct xen_device *xendev = netfront->xendev;
-	struct io_buffer *iobuf;
 	struct netif_rx_request *request;
 	unsigned int refilled = 0;
-	physaddr_t addr;
 	int notify;
-	int rc;
 
-	/* Refill ring */
-	while ( netfront_ring_fill ( &netfront->rx ) < NETFRONT_RX_FILL ) {
-
-		/* Allocate I/O buffer */
-		iobuf = alloc_iob ( PAGE_SIZE );
-		if ( ! iobuf ) {
-			/* Wait for next refill */
-			break;
-		}
-		addr = virt_to_phys ( iobuf->data );
+	/* Refill ring using persistently granted buffer pages */
+	while ( ! netfront_ring_is_full ( &netfront->rx ) ) {
 
 		/* Add to descriptor ring */
 		request = RING_GET_REQUEST ( &netfront->rx_fring,
 					     netfront->rx_fring.req_prod_pvt );
-		if ( ( rc = netfront_push ( netfront, &netfront->rx, addr,
-					    iobuf, &request->id,
-					    &request->gref ) ) != 0 ) {
-			netdev_rx_err ( netdev, iobuf, rc );
-			break;
-		}
-		DBGC2 ( netfront, "NETFRONT %s RX id %d ref %d is %#08lx+%zx\n",
-			xendev->key, request->id, request->gref, addr,
-			iob_tailroom ( iobuf ) );
+		netfront_push ( &netfront->rx, NULL, &request->id,
+				&request->gref );
+		DBGC2 ( netfront, "NETFRONT %s RX id %d ref %d\n",
+			xendev->key, request->id, request->gref );
 
 		/* Move to next descriptor */
 		netfront->rx_fring.req_prod_pvt++;
@@ -730,21 +739,19 @@ static int netfront_transmit ( struct net_device *netdev,
 	struct netfront_nic *netfront = netdev->priv;
 	struct xen_device *xendev = netfront->xendev;
 	struct netif_tx_request *request;
-	physaddr_t addr;
+	const void *data;
+	void *page;
 	size_t len;
 	size_t remaining;
 	size_t frag_len;
-	unsigned int offset;
 	unsigned int count;
 	unsigned int more;
 	int notify;
-	int rc;
 
 	/* Calculate number of page buffers required */
-	addr = virt_to_phys ( iobuf->data );
+	data = iobuf->data;
 	len = iob_len ( iobuf );
-	offset = ( addr & ( PAGE_SIZE - 1 ) );
-	count = ( ( offset + len + PAGE_SIZE - 1 ) / PAGE_SIZE );
+	count = ( ( len + PAGE_SIZE - 1 ) / PAGE_SIZE );
 
 	/* Check that we have space in the ring */
 	if ( netfront_ring_space ( &netfront->tx ) < count ) {
@@ -758,7 +765,7 @@ static int netfront_transmit ( struct net_device *netdev,
 	while ( remaining ) {
 
 		/* Calculate length of this fragment */
-		frag_len = ( PAGE_SIZE - offset );
+		frag_len = PAGE_SIZE;
 		if ( frag_len >= remaining ) {
 			frag_len = remaining;
 			more = 0;
@@ -766,27 +773,23 @@ static int netfront_transmit ( struct net_device *netdev,
 			more = NETTXF_more_data;
 		}
 
-		/* Populate request */
+		/* Populate request and copy fragment to buffer page */
 		request = RING_GET_REQUEST ( &netfront->tx_fring,
 					     netfront->tx_fring.req_prod_pvt );
-		if ( ( rc = netfront_push ( netfront, &netfront->tx, addr,
-					    ( more ? NULL : iobuf ),
-					    &request->id,
-					    &request->gref ) ) != 0 ) {
-			return rc;
-		}
+		page = netfront_push ( &netfront->tx, ( more ? NULL : iobuf ),
+				       &request->id, &request->gref );
+		memcpy ( page, data, frag_len );
 		request->flags = ( NETTXF_data_validated | more );
-		request->offset = offset;
+		request->offset = 0;
 		request->size = ( ( remaining == len ) ? len : frag_len );
-		DBGC2 ( netfront, "NETFRONT %s TX id %d ref %d is "
-			"%#08lx+%zx%s\n", xendev->key, request->id,
-			request->gref, addr, frag_len, ( more ? "..." : "" ) );
+		DBGC2 ( netfront, "NETFRONT %s TX id %d ref %d is +%zx%s\n",
+			xendev->key, request->id, request->gref, frag_len,
+			( more ? "..." : "" ) );
 
 		/* Move to next descriptor */
 		netfront->tx_fring.req_prod_pvt++;
-		addr += frag_len;
+		data += frag_len;
 		remaining -= frag_len;
-		offset = 0;
 	}
 
 	/* Push new descriptors and notify backend if applicable */
@@ -818,7 +821,7 @@ static void netfront_poll_tx ( struct net_device *netdev ) {
 					       netfront->tx_fring.rsp_cons++ );
 
 		/* Retrieve from descriptor ring */
-		iobuf = netfront_pull ( netfront, &netfront->tx, response->id );
+		iobuf = netfront_pull ( &netfront->tx, response->id );
 		status = response->status;
 		if ( status >= NETIF_RSP_OKAY ) {
 			DBGC2 ( netfront, "NETFRONT %s TX id %d complete\n",
@@ -845,6 +848,7 @@ static void netfront_poll_rx ( struct net_device *netdev ) {
 	struct xen_device *xendev = netfront->xendev;
 	struct netif_rx_response *response;
 	struct io_buffer *iobuf;
+	void *page;
 	int status;
 	int more;
 	size_t len;
@@ -858,7 +862,8 @@ static void netfront_poll_rx ( struct net_device *netdev ) {
 					       netfront->rx_fring.rsp_cons++ );
 
 		/* Retrieve from descriptor ring */
-		iobuf = netfront_pull ( netfront, &netfront->rx, response->id );
+		page = netfront_page ( &netfront->rx, response->id );
+		netfront_pull ( &netfront->rx, response->id );
 		status = response->status;
 		more = ( response->flags & NETRXF_more_data );
 
@@ -869,18 +874,33 @@ static void netfront_poll_rx ( struct net_device *netdev ) {
 				xendev->key, response->id, status,
 				strerror ( rc ) );
 			netfront_discard ( netfront );
-			netdev_rx_err ( netdev, iobuf, rc );
+			netdev_rx_err ( netdev, NULL, rc );
 			continue;
 		}
 
-		/* Add to partial receive list */
+		/* Copy out of buffer page */
 		len = status;
-		iob_reserve ( iobuf, response->offset );
-		iob_put ( iobuf, len );
-		DBGC2 ( netfront, "NETFRONT %s RX id %d complete "
-			"%#08lx+%zx%s\n", xendev->key, response->id,
-			virt_to_phys ( iobuf->data ), len,
+		if ( ( response->offset + len ) > PAGE_SIZE ) {
+			DBGC ( netfront, "NETFRONT %s RX id %d invalid "
+			       "+%#x+%zx\n", xendev->key, response->id,
+			       response->offset, len );
+			netfront_discard ( netfront );
+			netdev_rx_err ( netdev, NULL, -EPROTO );
+			continue;
+		}
+		iobuf = alloc_iob ( len );
+		if ( ! iobuf ) {
+			netfront_discard ( netfront );
+			netdev_rx_err ( netdev, NULL, -ENOMEM );
+			continue;
+		}
+		memcpy ( iob_put ( iobuf, len ), ( page + response->offset ),
+			 len );
+		DBGC2 ( netfront, "NETFRONT %s RX id %d complete +%#x+%zx%s\n",
+			xendev->key, response->id, response->offset, len,
 			( more ? "..." : "" ) );
+
+		/* Add to partial receive list */
 		list_add_tail ( &iobuf->list, &netfront->rx_partial );
 
 		/* Wait until complete packet has been received */
@@ -946,6 +966,11 @@ static int netfront_probe ( struct xen_device *xendev ) {
 	struct netfront_nic *netfront;
 	int rc;
 
+	/* Sanity checks */
+	build_assert ( NETFRONT_NUM_RX_DESC >= NETFRONT_MIN_RX_DESC );
+	build_assert ( NETFRONT_NUM_RX_DESC <= 256 );
+	build_assert ( NETFRONT_NUM_TX_DESC <= 256 );
+
 	/* Allocate and initialise structure */
 	netdev = alloc_etherdev ( sizeof ( *netfront ) );
 	if ( ! netdev ) {
@@ -12,14 +12,9 @@ FILE_SECBOOT ( PERMITTED );
 
 #include <ipxe/xen.h>
 #include <xen/io/netif.h>
+#include <config/netdev.h>
 
-/** Number of transmit ring entries */
-#define NETFRONT_NUM_TX_DESC 16
-
-/** Number of receive ring entries */
-#define NETFRONT_NUM_RX_DESC 32
-
-/** Receive ring fill level
+/** Minimum number of receive ring entries
  *
  * The xen-netback driver from kernels 3.18 to 4.2 inclusive have a
  * bug (CA-163395) which prevents packet reception if fewer than 18
@@ -27,10 +22,10 @@ FILE_SECBOOT ( PERMITTED );
  * kernel commit d5d4852 ("xen-netback: require fewer guest Rx slots
  * when not using GSO").
  *
- * We provide 18 receive descriptors to avoid unpleasant silent
- * failures on these kernel versions.
+ * We always provide at least 18 receive descriptors to avoid
+ * unpleasant silent failures on these kernel versions.
  */
-#define NETFRONT_RX_FILL 18
+#define NETFRONT_MIN_RX_DESC 18
 
 /** Grant reference indices */
 enum netfront_ref_index {
@@ -68,6 +63,8 @@ struct netfront_ring {
 	struct io_buffer **iobufs;
 	/** Grant references, indexed by buffer ID */
 	grant_ref_t *refs;
+	/** Persistently granted buffer pages, indexed by buffer ID */
+	void *pages;
 
 	/** Buffer ID ring */
 	uint8_t *ids;
@@ -102,6 +99,19 @@ netfront_init_ring ( struct netfront_ring *ring, const char *ref_key,
 	ring->ids = ids;
 }
 
+/**
+ * Get persistently granted buffer page
+ *
+ * @v ring		Descriptor ring
+ * @v id		Buffer ID
+ * @ret page		Buffer page
+ */
+static inline __attribute__ (( always_inline )) void *
+netfront_page ( struct netfront_ring *ring, unsigned int id ) {
+
+	return ( ring->pages + ( id * PAGE_SIZE ) );
+}
+
 /**
  * Calculate descriptor ring fill level
  *
@@ -35,6 +35,7 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 #include <string.h>
 #include <errno.h>
 #include <unistd.h>
+#include <assert.h>
 #include <byteswap.h>
 #include <ipxe/umalloc.h>
 #include <ipxe/rndis.h>
@@ -729,7 +730,8 @@ static int netvsc_open ( struct rndis_device *rndis ) {
 
 	/* Open channel */
 	if ( ( rc = vmbus_open ( netvsc->vmdev, &netvsc_channel_operations,
-				 PAGE_SIZE, PAGE_SIZE, NETVSC_MTU ) ) != 0 ) {
+				 NETVSC_RING_LEN, NETVSC_RING_LEN,
+				 NETVSC_MTU ) ) != 0 ) {
 		DBGC ( netvsc, "NETVSC %s could not open VMBus: %s\n",
 		       netvsc->name, strerror ( rc ) );
 		goto err_vmbus_open;
@@ -804,6 +806,13 @@ static int netvsc_probe ( struct vmbus_device *vmdev ) {
 	struct rndis_device *rndis;
 	int rc;
 
+	/* Sanity checks */
+	build_assert ( ( NETVSC_TX_NUM_DESC & ( NETVSC_TX_NUM_DESC - 1 ) ) == 0 );
+	build_assert ( NETVSC_TX_NUM_DESC <= 256 );
+	build_assert ( ( NETVSC_RING_LEN & ( NETVSC_RING_LEN - 1 ) ) == 0 );
+	build_assert ( ( NETVSC_RING_LEN % PAGE_SIZE ) == 0 );
+	build_assert ( ( NETVSC_RX_BUF_LEN % PAGE_SIZE ) == 0 );
+
 	/* Allocate and initialise structure */
 	rndis = alloc_rndis ( sizeof ( *netvsc ) );
 	if ( ! rndis ) {
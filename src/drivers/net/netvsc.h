@@ -9,6 +9,8 @@
 
 FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 
+#include <config/netdev.h>
+
 /** Maximum supported NetVSC message length */
 #define NETVSC_MTU 512
 
@@ -18,26 +20,12 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
  */
 #define NETVSC_MAX_WAIT_MS 1000
 
-/** Number of transmit ring entries
- *
- * Must be a power of two.  This is a policy decision.  This value
- * must be sufficiently small to guarantee that we never run out of
- * space in the VMBus outbound ring buffer.
- */
-#define NETVSC_TX_NUM_DESC 32
-
 /** RX data buffer page set ID
  *
  * This is a policy decision.
  */
 #define NETVSC_RX_BUF_PAGESET 0xbead
 
-/** RX data buffer length
- *
- * This is a policy decision.
- */
-#define NETVSC_RX_BUF_LEN ( 16 * PAGE_SIZE )
-
 /** Base transaction ID
  *
  * This is a policy decision.
@@ -1036,6 +1036,9 @@ static struct net_device_operations realtek_operations = {
 	.irq		= realtek_irq,
 };
 
+/** Realtek devirtualised network device operations */
+PROVIDE_NETDEV_DIRECT ( realtek_operations, realtek_transmit, realtek_poll );
+
 /******************************************************************************
  *
  * PCI interface
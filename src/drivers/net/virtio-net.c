@@ -25,6 +25,8 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 #include <errno.h>
 #include <stdlib.h>
 #include <unistd.h>
+#include <string.h>
+#include <byteswap.h>
 #include <ipxe/list.h>
 #include <ipxe/iobuf.h>
 #include <ipxe/netdevice.h>
@@ -78,8 +80,32 @@ enum {
 	QUEUE_NB
 };
 
-/** Max number of pending rx packets */
-#define NUM_RX_BUF 8
+/** Max number of pending rx packets
+ *
+ * The number of pending rx packets is otherwise limited by the size
+ * of the rx virtqueue offered by the device.
+ */
+#define NUM_RX_BUF 128
+
+/** Max number of pending tx packets
+ *
+ * Each pending tx packet requires its own virtio net header, since
+ * the header fields describe the transmit offloads to be performed.
+ */
+#define NUM_TX_BUF 128
+
+/** Length of virtio net header area allocated for each virtqueue */
+#define VIRTNET_HEADERS_LEN \
+	( NUM_TX_BUF * sizeof ( struct virtio_net_hdr_modern ) )
+
+/** Features supported by this driver (in addition to transport features) */
+#define VIRTNET_FEATURES ( ( 1ULL << VIRTIO_NET_F_CSUM ) |		\
+			   ( 1ULL << VIRTIO_NET_F_MAC ) |		\
+			   ( 1ULL << VIRTIO_NET_F_MTU ) |		\
+			   ( 1ULL << VIRTIO_NET_F_GUEST_CSUM ) |	\
+			   ( 1ULL << VIRTIO_NET_F_HOST_TSO4 ) |		\
+			   ( 1ULL << VIRTIO_NET_F_HOST_TSO6 ) |		\
+			   ( 1ULL << VIRTIO_NET_F_MRG_RXBUF ) )
 
 struct virtnet_nic {
 	/** Base pio register address */
@@ -99,54 +125,131 @@ struct virtnet_nic {
 
 	/** Pending rx packet count */
 	unsigned int rx_num_iobufs;
+	/** Maximum pending rx packet count */
+	unsigned int rx_max_iobufs;
+
+	/** Pending tx packet count */
+	unsigned int tx_num_iobufs;
+	/** Maximum pending tx packet count */
+	unsigned int tx_max_iobufs;
+	/** Pending tx descriptor count */
+	unsigned int tx_num_desc;
+	/** Maximum pending tx descriptor count */
+	unsigned int tx_max_desc;
+	/** Pending tx packets, indexed by virtio net header slot */
+	struct io_buffer *tx_iobufs[NUM_TX_BUF];
+	/** Next tx header slot to try */
+	unsigned int tx_next;
+
+	/** Negotiated features */
+	u64 features;
+	/** Length of virtio net header */
+	size_t header_len;
 
 	/** DMA device */
 	struct dma_device *dma;
 
 };
 
+/** Convert virtio net header field to device byte order
+ *
+ * @v virtnet		Virtio-net device
+ * @v value		Value
+ * @ret value		Value in device byte order
+ */
+static inline uint16_t virtnet_hdr16 ( struct virtnet_nic *virtnet,
+				       uint16_t value ) {
+
+	return ( virtnet->virtio_version ? cpu_to_le16 ( value ) : value );
+}
+
+/** Construct virtio net header for a transmitted packet
+ *
+ * @v virtnet		Virtio-net device
+ * @v header		Virtio net header
+ * @v iobuf		I/O buffer
+ */
+static void virtnet_tx_header ( struct virtnet_nic *virtnet,
+				struct virtio_net_hdr_modern *header,
+				struct io_buffer *iobuf ) {
+	struct virtio_net_hdr *hdr = &header->legacy;
+	size_t start = ( iobuf->trans_hdr - iobuf->data );
+
+	memset ( header, 0, virtnet->header_len );
+
+	/* Request checksum offload, if applicable */
+	if ( iobuf->flags & IOB_TX_CSUM ) {
+		hdr->flags = VIRTIO_NET_HDR_F_NEEDS_CSUM;
+		hdr->csum_start = virtnet_hdr16 ( virtnet, start );
+		hdr->csum_offset = virtnet_hdr16 ( virtnet,
+						   iobuf->csum_offset );
+	}
+
+	/* Request segmentation offload, if applicable */
+	if ( iobuf->flags & IOB_TX_TSO ) {
+		hdr->gso_type = ( ( iobuf->flags & IOB_TX_IPV6 ) ?
+				  VIRTIO_NET_HDR_GSO_TCPV6 :
+				  VIRTIO_NET_HDR_GSO_TCPV4 );
+		hdr->hdr_len = virtnet_hdr16 ( virtnet, ( start +
+						iobuf->trans_hdr_len ) );
+		hdr->gso_size = virtnet_hdr16 ( virtnet, iobuf->mss );
+	}
+}
+
 /** Add an iobuf to a virtqueue
  *
  * @v netdev		Network device
  * @v vq_idx		Virtqueue index (RX_INDEX or TX_INDEX)
  * @v iobuf		I/O buffer
+ * @v header		Virtio net header (for transmitted packets)
+ * @v opaque		Token to be returned on completion
  *
  * The virtqueue is kicked after the iobuf has been added.
  */
 static void virtnet_enqueue_iob ( struct net_device *netdev,
-				  int vq_idx, struct io_buffer *iobuf ) {
+				  int vq_idx, struct io_buffer *iobuf,
+				  struct virtio_net_hdr_modern *header,
+				  void *opaque ) {
 	struct virtnet_nic *virtnet = netdev->priv;
 	struct vring_virtqueue *vq = &virtnet->virtqueue[vq_idx];
-	struct virtio_net_hdr_modern *header = vq->empty_header;
-	unsigned int out = ( vq_idx == TX_INDEX ) ? 2 : 0;
-	unsigned int in = ( vq_idx == TX_INDEX ) ? 0 : 2;
-	size_t header_len = ( virtnet->virtio_version ?
-			      sizeof ( *header ) : sizeof ( header->legacy ) );
-	struct vring_list list[] = {
-		{
-			/* Share a single zeroed virtio net header between all
-			 * packets in a ring.  This works because this driver
-			 * does not use any advanced features so none of the
-			 * header fields get used.
-			 *
-			 * Some host implementations (notably Google Compute
-			 * Platform) are known to unconditionally write back
-			 * to header->flags for received packets.  Work around
-			 * this by using separate RX and TX headers.
-			 */
-			.addr = dma ( &vq->map, header ),
-			.length = header_len,
-		},
-		{
-			.addr = iob_dma ( iobuf ),
-			.length = iob_len ( iobuf ),
-		},
-	};
+	unsigned int count = ( ( vq_idx == TX_INDEX ) ?
+			       ( 1 + iob_count ( iobuf ) ) : 2 );
+	unsigned int out = ( vq_idx == TX_INDEX ) ? count : 0;
+	unsigned int in = ( vq_idx == TX_INDEX ) ? 0 : count;
+	size_t header_len = virtnet->header_len;
+	struct vring_list list[count];
+	struct io_buffer *frag;
+	unsigned int i;
+
+	if ( vq_idx == TX_INDEX ) {
+		/* Transmitted packets use a header from the virtio
+		 * net header area, since the header fields describe
+		 * the transmit offloads to be performed.  Each
+		 * fragment of a chained I/O buffer occupies a
+		 * further descriptor.
+		 */
+		list[0].addr = dma ( &vq->map, header );
+		list[0].length = header_len;
+		for ( frag = iobuf, i = 1 ; frag ; frag = frag->frag, i++ ) {
+			list[i].addr = iob_dma ( frag );
+			list[i].length = iob_len ( frag );
+		}
+	} else {
+		/* Received packets use a header placed at the start
+		 * of the I/O buffer, since the header fields are
+		 * filled in by the device.
+		 */
+		list[0].addr = iob_dma ( iobuf );
+		list[0].length = header_len;
+		list[1].addr = dma ( &iobuf->map,
+				     ( iobuf->data + header_len ) );
+		list[1].length = ( iob_len ( iobuf ) - header_len );
+	}
 
 	DBGC2 ( virtnet, "VIRTIO-NET %p enqueuing iobuf %p on vq %d\n",
 		virtnet, iobuf, vq_idx );
 
-	vring_add_buf ( vq, list, out, in, iobuf, 0 );
+	vring_add_buf ( vq, list, out, in, opaque, 0 );
 	vring_kick ( virtnet->virtio_version ? &virtnet->vdev : NULL,
 		     virtnet->ioaddr, vq, 1 );
 }
@@ -157,15 +260,19 @@ static void virtnet_enqueue_iob ( struct net_device *netdev,
  */
 static void virtnet_refill_rx_virtqueue ( struct net_device *netdev ) {
 	struct virtnet_nic *virtnet = netdev->priv;
-	size_t len = ( netdev->max_pkt_len + 4 /* VLAN */ );
+	size_t len = ( virtnet->header_len + netdev->max_pkt_len +
+		       4 /* VLAN */ );
 
-	while ( virtnet->rx_num_iobufs < NUM_RX_BUF ) {
+	while ( virtnet->rx_num_iobufs < virtnet->rx_max_iobufs ) {
 		struct io_buffer *iobuf;
 
 		/* Try to allocate a buffer, stop for now if out of memory */
 		iobuf = alloc_rx_iob ( len, virtnet->dma );
-		if ( ! iobuf )
+		if ( ! iobuf ) {
+			netdev_rx_refill_err ( netdev,
+					       ( virtnet->rx_num_iobufs == 0 ) );
 			break;
+		}
 
 		/* Keep track of iobuf so close() can free it */
 		list_add ( &iobuf->list, &virtnet->rx_iobufs );
@@ -173,11 +280,79 @@ static void virtnet_refill_rx_virtqueue ( struct net_device *netdev ) {
 		/* Mark packet length until we know the actual size */
 		iob_put ( iobuf, len );
 
-		virtnet_enqueue_iob ( netdev, RX_INDEX, iobuf );
+		virtnet_enqueue_iob ( netdev, RX_INDEX, iobuf, NULL, iobuf );
 		virtnet->rx_num_iobufs++;
 	}
 }
 
+/** Record negotiated features
+ *
+ * @v netdev		Network device
+ * @v features		Negotiated features
+ */
+static void virtnet_set_features ( struct net_device *netdev, u64 features ) {
+	struct virtnet_nic *virtnet = netdev->priv;
+
+	virtnet->features = features;
+
+	/* The header includes the number of merged buffers for
+	 * virtio 1.0 devices, or if mergeable receive buffers are
+	 * in use.
+	 */
+	if ( virtnet->virtio_version ||
+	     ( features & ( 1ULL << VIRTIO_NET_F_MRG_RXBUF ) ) ) {
+		virtnet->header_len = sizeof ( struct virtio_net_hdr_modern );
+	} else {
+		virtnet->header_len = sizeof ( struct virtio_net_hdr );
+	}
+
+	/* Each fragment of a chained I/O buffer uses a descriptor */
+	netdev->tx_offloads = NETDEV_TX_OFFLOAD_SG;
+
+	/* Transmit segmentation offload requires checksum offload */
+	if ( features & ( 1ULL << VIRTIO_NET_F_CSUM ) ) {
+		netdev->tx_offloads |= NETDEV_TX_OFFLOAD_CSUM;
+		if ( features & ( 1ULL << VIRTIO_NET_F_HOST_TSO4 ) )
+			netdev->tx_offloads |= NETDEV_TX_OFFLOAD_TSO4;
+		if ( features & ( 1ULL << VIRTIO_NET_F_HOST_TSO6 ) )
+			netdev->tx_offloads |= NETDEV_TX_OFFLOAD_TSO6;
+	}
+
+	DBGC ( virtnet, "VIRTIO-NET %p features %#08llx header length %zd\n",
+	       virtnet, ( ( unsigned long long ) features ),
+	       virtnet->header_len );
+}
+
+/** Initialise rx and tx packets
+ *
+ * @v netdev		Network device
+ */
+static void virtnet_init_iobufs ( struct net_device *netdev ) {
+	struct virtnet_nic *virtnet = netdev->priv;
+
+	/* Scale packet counts to virtqueue sizes.  Each packet
+	 * occupies two descriptors.
+	 */
+	virtnet->rx_max_iobufs = ( virtnet->virtqueue[RX_INDEX].vring.num / 2 );
+	if ( virtnet->rx_max_iobufs > NUM_RX_BUF )
+		virtnet->rx_max_iobufs = NUM_RX_BUF;
+	virtnet->tx_max_iobufs = ( virtnet->virtqueue[TX_INDEX].vring.num / 2 );
+	if ( virtnet->tx_max_iobufs > NUM_TX_BUF )
+		virtnet->tx_max_iobufs = NUM_TX_BUF;
+	virtnet->tx_max_desc = virtnet->virtqueue[TX_INDEX].vring.num;
+	DBGC ( virtnet, "VIRTIO-NET %p using %d rx and %d tx packets\n",
+	       virtnet, virtnet->rx_max_iobufs, virtnet->tx_max_iobufs );
+
+	/* Initialize rx packets */
+	INIT_LIST_HEAD ( &virtnet->rx_iobufs );
+	virtnet->rx_num_iobufs = 0;
+	virtnet->tx_num_iobufs = 0;
+	virtnet->tx_num_desc = 0;
+	memset ( virtnet->tx_iobufs, 0, sizeof ( virtnet->tx_iobufs ) );
+	virtnet->tx_next = 0;
+	virtnet_refill_rx_virtqueue ( netdev );
+}
+
 /** Helper to free all virtqueue memory
  *
  * @v netdev		Network device
@@ -218,7 +393,7 @@ static int virtnet_open_legacy ( struct net_device *netdev ) {
 	/* Initialize rx/tx virtqueues */
 	for ( i = 0; i < QUEUE_NB; i++ ) {
 		if ( vp_find_vq ( ioaddr, i, &virtnet->virtqueue[i], virtnet->dma,
-                                  sizeof ( struct virtio_net_hdr_modern ) ) == -1 ) {
+                                  VIRTNET_HEADERS_LEN ) == -1 ) {
 			DBGC ( virtnet, "VIRTIO-NET %p cannot register queue %d\n",
 			       virtnet, i );
 			virtnet_free_virtqueues ( netdev );
@@ -226,18 +401,18 @@ static int virtnet_open_legacy ( struct net_device *netdev ) {
 		}
 	}
 
+	/* Negotiate features */
+	features = ( vp_get_features ( ioaddr ) & VIRTNET_FEATURES );
+	vp_set_features ( ioaddr, features );
+	virtnet_set_features ( netdev, features );
+
 	/* Initialize rx packets */
-	INIT_LIST_HEAD ( &virtnet->rx_iobufs );
-	virtnet->rx_num_iobufs = 0;
-	virtnet_refill_rx_virtqueue ( netdev );
+	virtnet_init_iobufs ( netdev );
 
 	/* Disable interrupts before starting */
 	netdev_irq ( netdev, 0 );
 
 	/* Driver is ready */
-	features = vp_get_features ( ioaddr );
-	vp_set_features ( ioaddr, features & ( ( 1 << VIRTIO_NET_F_MAC ) |
-					       ( 1 << VIRTIO_NET_F_MTU ) ) );
 	vp_set_status ( ioaddr, VIRTIO_CONFIG_S_DRIVER | VIRTIO_CONFIG_S_DRIVER_OK );
 	return 0;
 }
@@ -258,12 +433,13 @@ static int virtnet_open_modern ( struct net_device *netdev ) {
 		vpm_add_status ( &virtnet->vdev, VIRTIO_CONFIG_S_FAILED );
 		return -EINVAL;
 	}
-	vpm_set_features ( &virtnet->vdev, features & (
-		( 1ULL << VIRTIO_NET_F_MAC ) |
-		( 1ULL << VIRTIO_NET_F_MTU ) |
-		( 1ULL << VIRTIO_F_VERSION_1 ) |
-		( 1ULL << VIRTIO_F_ANY_LAYOUT ) |
-		( 1ULL << VIRTIO_F_IOMMU_PLATFORM ) ) );
+	features &= ( VIRTNET_FEATURES |
+		      ( 1ULL << VIRTIO_F_VERSION_1 ) |
+		      ( 1ULL << VIRTIO_F_ANY_LAYOUT ) |
+		      ( 1ULL << VIRTIO_F_IOMMU_PLATFORM ) |
+		      ( 1ULL << VIRTIO_F_RING_PACKED ) );
+	vpm_set_features ( &virtnet->vdev, features );
+	virtnet_set_features ( netdev, features );
 	vpm_add_status ( &virtnet->vdev, VIRTIO_CONFIG_S_FEATURES_OK );
 
 	status = vpm_get_status ( &virtnet->vdev );
@@ -284,7 +460,7 @@ static int virtnet_open_modern ( struct net_device *netdev ) {
 
 	/* Initialize rx/tx virtqueues */
 	if ( vpm_find_vqs ( &virtnet->vdev, QUEUE_NB, virtnet->virtqueue,
-                            virtnet->dma, sizeof ( struct virtio_net_hdr_modern ) ) ) {
+                            virtnet->dma, VIRTNET_HEADERS_LEN ) ) {
 		DBGC ( virtnet, "VIRTIO-NET %p cannot register queues\n",
 		       virtnet );
 		virtnet_free_virtqueues ( netdev );
@@ -298,9 +474,7 @@ static int virtnet_open_modern ( struct net_device *netdev ) {
 	vpm_add_status ( &virtnet->vdev, VIRTIO_CONFIG_S_DRIVER_OK );
 
 	/* Initialize rx packets */
-	INIT_LIST_HEAD ( &virtnet->rx_iobufs );
-	virtnet->rx_num_iobufs = 0;
-	virtnet_refill_rx_virtqueue ( netdev );
+	virtnet_init_iobufs ( netdev );
 	return 0;
 }
 
@@ -353,7 +527,42 @@ static void virtnet_close ( struct net_device *netdev ) {
  */
 static int virtnet_transmit ( struct net_device *netdev,
 			      struct io_buffer *iobuf ) {
-	virtnet_enqueue_iob ( netdev, TX_INDEX, iobuf );
+	struct virtnet_nic *virtnet = netdev->priv;
+	struct vring_virtqueue *tx_vq = &virtnet->virtqueue[TX_INDEX];
+	struct virtio_net_hdr_modern *header;
+	unsigned int count = ( 1 + iob_count ( iobuf ) );
+	unsigned int slot;
+
+	/* Fail if packet can never fit within the tx virtqueue */
+	if ( count > virtnet->tx_max_desc ) {
+		DBGC ( virtnet, "VIRTIO-NET %p cannot transmit %d "
+		       "fragments\n", virtnet, ( count - 1 ) );
+		return -ENOBUFS;
+	}
+
+	/* Defer packet if there is no space in the tx virtqueue */
+	if ( ( virtnet->tx_num_iobufs >= virtnet->tx_max_iobufs ) ||
+	     ( ( virtnet->tx_num_desc + count ) > virtnet->tx_max_desc ) ) {
+		netdev_tx_defer ( netdev, iobuf );
+		return 0;
+	}
+
+	/* Find a free virtio net header slot.  Completions normally
+	 * arrive in order, so the next slot is almost always free.
+	 */
+	slot = virtnet->tx_next;
+	while ( virtnet->tx_iobufs[slot] )
+		slot = ( ( slot + 1 ) % virtnet->tx_max_iobufs );
+	virtnet->tx_next = ( ( slot + 1 ) % virtnet->tx_max_iobufs );
+	virtnet->tx_iobufs[slot] = iobuf;
+
+	/* Construct header and enqueue packet */
+	header = &tx_vq->empty_header[slot];
+	virtnet_tx_header ( virtnet, header, iobuf );
+	virtnet_enqueue_iob ( netdev, TX_INDEX, iobuf, header,
+			      &virtnet->tx_iobufs[slot] );
+	virtnet->tx_num_iobufs++;
+	virtnet->tx_num_desc += count;
 	return 0;
 }
 
@@ -366,15 +575,95 @@ static void virtnet_process_tx_packets ( struct net_device *netdev ) {
 	struct vring_virtqueue *tx_vq = &virtnet->virtqueue[TX_INDEX];
 
 	while ( vring_more_used ( tx_vq ) ) {
-		struct io_buffer *iobuf = vring_get_buf ( tx_vq, NULL );
+		struct io_buffer **slot = vring_get_buf ( tx_vq, NULL );
+		struct io_buffer *iobuf = *slot;
+
+		*slot = NULL;
 
 		DBGC2 ( virtnet, "VIRTIO-NET %p tx complete iobuf %p\n",
 			virtnet, iobuf );
 
+		virtnet->tx_num_iobufs--;
+		virtnet->tx_num_desc -= ( 1 + iob_count ( iobuf ) );
 		netdev_tx_complete ( netdev, iobuf );
 	}
 }
 
+/** Get received packet buffer
+ *
+ * @v netdev		Network device
+ * @ret iobuf		I/O buffer (including virtio net header)
+ */
+static struct io_buffer * virtnet_dequeue_rx ( struct net_device *netdev ) {
+	struct virtnet_nic *virtnet = netdev->priv;
+	struct vring_virtqueue *rx_vq = &virtnet->virtqueue[RX_INDEX];
+	struct io_buffer *iobuf;
+	unsigned int len;
+
+	/* Get completed buffer */
+	iobuf = vring_get_buf ( rx_vq, &len );
+
+	/* Release ownership of iobuf */
+	list_del ( &iobuf->list );
+	virtnet->rx_num_iobufs--;
+
+	/* Update iobuf length */
+	iob_unput ( iobuf, iob_len ( iobuf ) );
+	iob_put ( iobuf, len );
+
+	return iobuf;
+}
+
+/** Merge received packet buffers
+ *
+ * @v netdev		Network device
+ * @v iobuf		I/O buffer to update
+ * @v count		Number of further buffers within packet
+ * @ret rc		Return status code
+ *
+ * All further buffers are consumed, even if merging fails.
+ */
+static int virtnet_merge_rx ( struct net_device *netdev,
+			      struct io_buffer **iobuf, unsigned int count ) {
+	struct virtnet_nic *virtnet = netdev->priv;
+	struct vring_virtqueue *rx_vq = &virtnet->virtqueue[RX_INDEX];
+	struct io_buffer *fragment;
+	struct io_buffer *merged;
+	int rc = 0;
+
+	while ( count-- ) {
+
+		/* Get next buffer */
+		if ( ! vring_more_used ( rx_vq ) ) {
+			DBGC ( virtnet, "VIRTIO-NET %p missing rx buffer\n",
+			       virtnet );
+			return -EPROTO;
+		}
+		fragment = virtnet_dequeue_rx ( netdev );
+
+		/* Append to packet, unless merging has already failed */
+		if ( rc == 0 ) {
+			merged = alloc_iob ( iob_len ( *iobuf ) +
+					     iob_len ( fragment ) );
+			if ( merged ) {
+				memcpy ( iob_put ( merged, iob_len ( *iobuf ) ),
+					 (*iobuf)->data, iob_len ( *iobuf ) );
+				memcpy ( iob_put ( merged,
+						   iob_len ( fragment ) ),
+					 fragment->data, iob_len ( fragment ) );
+				merged->flags = (*iobuf)->flags;
+				free_rx_iob ( *iobuf );
+				*iobuf = merged;
+			} else {
+				rc = -ENOMEM;
+			}
+		}
+		free_rx_iob ( fragment );
+	}
+
+	return rc;
+}
+
 /** Complete packet reception
  *
  * @v netdev	Network device
@@ -382,26 +671,67 @@ static void virtnet_process_tx_packets ( struct net_device *netdev ) {
 static void virtnet_process_rx_packets ( struct net_device *netdev ) {
 	struct virtnet_nic *virtnet = netdev->priv;
 	struct vring_virtqueue *rx_vq = &virtnet->virtqueue[RX_INDEX];
+	struct virtio_net_hdr_modern *header;
+	struct io_buffer *iobuf;
+	struct list_head received;
+	unsigned int num_buffers;
+	int rc;
+
+	INIT_LIST_HEAD ( &received );
 
 	while ( vring_more_used ( rx_vq ) ) {
-		unsigned int len;
-		struct io_buffer *iobuf = vring_get_buf ( rx_vq, &len );
 
-		/* Release ownership of iobuf */
-		list_del ( &iobuf->list );
-		virtnet->rx_num_iobufs--;
+		/* Get completed buffer */
+		iobuf = virtnet_dequeue_rx ( netdev );
 
-		/* Update iobuf length */
-		iob_unput ( iobuf, iob_len ( iobuf ) );
-		iob_put ( iobuf, len - sizeof ( struct virtio_net_hdr ) );
+		/* Parse virtio net header */
+		if ( iob_len ( iobuf ) < virtnet->header_len ) {
+			DBGC ( virtnet, "VIRTIO-NET %p rx underlength iobuf "
+			       "%p len %zd\n", virtnet, iobuf,
+			       iob_len ( iobuf ) );
+			netdev_rx_err ( netdev, iobuf, -EINVAL );
+			continue;
+		}
+		header = iobuf->data;
+		num_buffers = 1;
+		if ( virtnet->features & ( 1ULL << VIRTIO_NET_F_MRG_RXBUF ) ) {
+			num_buffers = ( virtnet->virtio_version ?
+					le16_to_cpu ( header->num_buffers ) :
+					header->num_buffers );
+		}
+		if ( ( virtnet->features &
+		       ( 1ULL << VIRTIO_NET_F_GUEST_CSUM ) ) &&
+		     ( header->legacy.flags &
+		       ( VIRTIO_NET_HDR_F_NEEDS_CSUM |
+			 VIRTIO_NET_HDR_F_DATA_VALID ) ) ) {
+			/* Checksum has been verified by the device, or
+			 * packet originated within the host and has not
+			 * been exposed to corruption.
+			 */
+			iobuf->flags |= IOB_CSUM_VALID;
+		}
+		iob_pull ( iobuf, virtnet->header_len );
+
+		/* Merge any further buffers */
+		if ( num_buffers > 1 ) {
+			rc = virtnet_merge_rx ( netdev, &iobuf,
+						( num_buffers - 1 ) );
+			if ( rc != 0 ) {
+				netdev_rx_err ( netdev, iobuf, rc );
+				continue;
+			}
+		}
 
 		DBGC2 ( virtnet, "VIRTIO-NET %p rx complete iobuf %p len %zd\n",
 			virtnet, iobuf, iob_len ( iobuf ) );
 
-		/* Pass completed packet to the network stack */
-		netdev_rx ( netdev, iobuf );
+		/* Collect completed packet */
+		list_add_tail ( &iobuf->list, &received );
 	}
 
+	/* Pass completed packets to the network stack */
+	netdev_rx_batch ( netdev, &received );
+
 	virtnet_refill_rx_virtqueue ( netdev );
 }
 
@@ -453,6 +783,9 @@ static struct net_device_operations virtnet_operations = {
 	.irq = virtnet_irq,
 };
 
+/** virtio-net devirtualised network device operations */
+PROVIDE_NETDEV_DIRECT ( virtnet_operations, virtnet_transmit, virtnet_poll );
+
 /**
  * Probe PCI device, legacy virtio 0.9.5
  *
@@ -97,6 +97,9 @@ static int vmxnet3_transmit ( struct net_device *netdev,
 	unsigned int fill;
 	unsigned int desc_idx;
 	unsigned int generation;
+	uint32_t offload = 0;
+	uint32_t flags = ( VMXNET3_TXF_CQ | VMXNET3_TXF_EOP );
+	size_t start;
 
 	/* Check that we have a free transmit descriptor */
 	fill = ( vmxnet->count.tx_prod - vmxnet->count.tx_cons );
@@ -118,11 +121,19 @@ static int vmxnet3_transmit ( struct net_device *netdev,
 	/* Store I/O buffer for later completion */
 	vmxnet->tx_iobuf[desc_idx] = iobuf;
 
+	/* Request checksum offload, if applicable */
+	if ( iobuf->flags & IOB_TX_CSUM ) {
+		start = ( iobuf->trans_hdr - iobuf->data );
+		offload = VMXNET3_TXF_MSSCOF ( start + iobuf->csum_offset );
+		flags |= ( VMXNET3_TXF_OM_CSUM | VMXNET3_TXF_HLEN ( start ) );
+	}
+
 	/* Populate transmit descriptor */
 	tx_desc = &vmxnet->dma->tx_desc[desc_idx];
 	tx_desc->address = cpu_to_le64 ( virt_to_bus ( iobuf->data ) );
-	tx_desc->flags[0] = ( generation | cpu_to_le32 ( iob_len ( iobuf ) ) );
-	tx_desc->flags[1] = cpu_to_le32 ( VMXNET3_TXF_CQ | VMXNET3_TXF_EOP );
+	tx_desc->flags[0] = ( generation |
+			      cpu_to_le32 ( iob_len ( iobuf ) | offload ) );
+	tx_desc->flags[1] = cpu_to_le32 ( flags );
 
 	/* Hand over descriptor to NIC */
 	wmb();
@@ -203,29 +214,40 @@ static void vmxnet3_flush_tx ( struct net_device *netdev ) {
 }
 
 /**
- * Refill receive ring
+ * Refill a receive descriptor ring
  *
- * @v netdev		Network device
+ * @v ring		Receive descriptor ring
+ * @v iobufs		Receive I/O buffers
+ * @v count		Number of descriptors in ring
+ * @v max_fill		Maximum fill level
+ * @v prod		Producer counter
+ * @v fill		Fill level
+ * @v len		Length of each receive buffer
+ * @v type		Receive buffer type flags
+ * @ret refilled	Ring was refilled
  */
-static void vmxnet3_refill_rx ( struct net_device *netdev ) {
-	struct vmxnet3_nic *vmxnet = netdev->priv;
+static int vmxnet3_refill_ring ( struct vmxnet3_rx_desc *ring,
+				 struct io_buffer **iobufs, unsigned int count,
+				 unsigned int max_fill, unsigned int *prod,
+				 unsigned int *fill, size_t len,
+				 uint32_t type ) {
 	struct vmxnet3_rx_desc *rx_desc;
 	struct io_buffer *iobuf;
-	unsigned int orig_rx_prod = vmxnet->count.rx_prod;
+	unsigned int orig_prod = *prod;
 	unsigned int desc_idx;
 	unsigned int generation;
 
 	/* Fill receive ring to specified fill level */
-	while ( vmxnet->count.rx_fill < VMXNET3_RX_FILL ) {
+	while ( *fill < max_fill ) {
 
 		/* Locate receive descriptor */
-		desc_idx = ( vmxnet->count.rx_prod % VMXNET3_NUM_RX_DESC );
-		generation = ( ( vmxnet->count.rx_prod & VMXNET3_NUM_RX_DESC ) ?
+		desc_idx = ( *prod % count );
+		generation = ( ( *prod & count ) ?
 			       0 : cpu_to_le32 ( VMXNET3_RXF_GEN ) );
-		assert ( vmxnet->rx_iobuf[desc_idx] == NULL );
+		assert ( iobufs[desc_idx] == NULL );
 
 		/* Allocate I/O buffer */
-		iobuf = alloc_iob ( VMXNET3_MTU + NET_IP_ALIGN );
+		iobuf = alloc_iob ( len + NET_IP_ALIGN );
 		if ( ! iobuf ) {
 			/* Non-fatal low memory condition */
 			break;
@@ -233,30 +255,111 @@ static void vmxnet3_refill_rx ( struct net_device *netdev ) {
 		iob_reserve ( iobuf, NET_IP_ALIGN );
 
 		/* Increment producer counter and fill level */
-		vmxnet->count.rx_prod++;
-		vmxnet->count.rx_fill++;
+		(*prod)++;
+		(*fill)++;
 
 		/* Store I/O buffer for later completion */
-		vmxnet->rx_iobuf[desc_idx] = iobuf;
+		iobufs[desc_idx] = iobuf;
 
 		/* Populate receive descriptor */
-		rx_desc = &vmxnet->dma->rx_desc[desc_idx];
+		rx_desc = &ring[desc_idx];
 		rx_desc->address = cpu_to_le64 ( virt_to_bus ( iobuf->data ) );
-		rx_desc->flags = ( generation | cpu_to_le32 ( VMXNET3_MTU ) );
-
+		rx_desc->flags = ( generation | cpu_to_le32 ( len | type ) );
 	}
 
+	return ( *prod != orig_prod );
+}
+
+/**
+ * Refill receive rings
+ *
+ * @v netdev		Network device
+ */
+static void vmxnet3_refill_rx ( struct net_device *netdev ) {
+	struct vmxnet3_nic *vmxnet = netdev->priv;
+	int refilled;
+	int refilled_body;
+
+	/* Refill head and body rings */
+	refilled = vmxnet3_refill_ring ( vmxnet->dma->rx_desc,
+					 vmxnet->rx_iobuf, VMXNET3_NUM_RX_DESC,
+					 VMXNET3_RX_FILL,
+					 &vmxnet->count.rx_prod,
+					 &vmxnet->count.rx_fill,
+					 VMXNET3_MTU, 0 );
+	refilled_body = vmxnet3_refill_ring ( vmxnet->dma->rx_body,
+					      vmxnet->rx_body_iobuf,
+					      VMXNET3_NUM_RX_BODY,
+					      VMXNET3_RX_BODY_FILL,
+					      &vmxnet->count.rx_body_prod,
+					      &vmxnet->count.rx_body_fill,
+					      VMXNET3_RX_BODY_LEN,
+					      VMXNET3_RXF_BODY );
+
 	/* Hand over any new descriptors to NIC */
-	if ( vmxnet->count.rx_prod != orig_rx_prod ) {
+	if ( refilled || refilled_body ) {
 		wmb();
 		profile_start ( &vmxnet3_vm_refill_profiler );
-		writel ( ( vmxnet->count.rx_prod % VMXNET3_NUM_RX_DESC ),
-			 ( vmxnet->pt + VMXNET3_PT_RXPROD ) );
+		if ( refilled ) {
+			writel ( ( vmxnet->count.rx_prod %
+				   VMXNET3_NUM_RX_DESC ),
+				 ( vmxnet->pt + VMXNET3_PT_RXPROD ) );
+		}
+		if ( refilled_body ) {
+			writel ( ( vmxnet->count.rx_body_prod %
+				   VMXNET3_NUM_RX_BODY ),
+				 ( vmxnet->pt + VMXNET3_PT_RXPROD2 ) );
+		}
 		profile_stop ( &vmxnet3_vm_refill_profiler );
 		profile_exclude ( &vmxnet3_vm_refill_profiler );
 	}
 }
 
+/**
+ * Check whether received packet has a verified transport-layer checksum
+ *
+ * @v rx_comp		Receive completion descriptor
+ * @ret valid		Transport-layer checksum has been verified
+ */
+static int vmxnet3_rx_csum_valid ( struct vmxnet3_rx_comp *rx_comp ) {
+	uint32_t index = le32_to_cpu ( rx_comp->index );
+	uint32_t flags = le32_to_cpu ( rx_comp->flags );
+
+	/* Check that checksum was calculated and found to be correct */
+	if ( index & VMXNET3_RXCI_CNC )
+		return 0;
+	if ( ! ( flags & VMXNET3_RXCF_TUC ) )
+		return 0;
+	if ( flags & VMXNET3_RXCF_FRG )
+		return 0;
+
+	/* Check that packet has a recognised transport-layer protocol */
+	return ( flags & ( VMXNET3_RXCF_TCP | VMXNET3_RXCF_UDP ) );
+}
+
+/**
+ * Discard any partially received packet
+ *
+ * @v netdev		Network device
+ * @v rc		Reason for discard
+ */
+static void vmxnet3_discard_rx ( struct net_device *netdev, int rc ) {
+	struct vmxnet3_nic *vmxnet = netdev->priv;
+	struct io_buffer *iobuf;
+	struct io_buffer *tmp;
+
+	/* Do nothing unless there are fragments to discard */
+	if ( list_empty ( &vmxnet->rx_frags ) )
+		return;
+
+	/* Discard all fragments */
+	list_for_each_entry_safe ( iobuf, tmp, &vmxnet->rx_frags, list ) {
+		list_del ( &iobuf->list );
+		free_iob ( iobuf );
+	}
+	netdev_rx_err ( netdev, NULL, rc );
+}
+
 /**
  * Poll for received packets
  *
@@ -266,10 +369,13 @@ static void vmxnet3_poll_rx ( struct net_device *netdev ) {
 	struct vmxnet3_nic *vmxnet = netdev->priv;
 	struct vmxnet3_rx_comp *rx_comp;
 	struct io_buffer *iobuf;
+	struct io_buffer **slot;
 	unsigned int comp_idx;
 	unsigned int desc_idx;
 	unsigned int generation;
-	size_t len;
+	uint32_t index;
+	uint32_t len;
+	int body;
 
 	while ( 1 ) {
 
@@ -287,26 +393,66 @@ static void vmxnet3_poll_rx ( struct net_device *netdev ) {
 		vmxnet->count.rx_cons++;
 
 		/* Locate corresponding receive descriptor */
-		desc_idx = ( le32_to_cpu ( rx_comp->index ) %
-			     VMXNET3_NUM_RX_DESC );
-		iobuf = vmxnet->rx_iobuf[desc_idx];
+		index = le32_to_cpu ( rx_comp->index );
+		body = ( VMXNET3_RXCI_RQID ( index ) != 0 );
+		if ( body ) {
+			desc_idx = ( index % VMXNET3_NUM_RX_BODY );
+			slot = &vmxnet->rx_body_iobuf[desc_idx];
+		} else {
+			desc_idx = ( index % VMXNET3_NUM_RX_DESC );
+			slot = &vmxnet->rx_iobuf[desc_idx];
+		}
+		iobuf = *slot;
 		if ( ! iobuf ) {
 			DBGC ( vmxnet, "VMXNET3 %p completed on empty receive "
-			       "buffer %#x/%#x\n", vmxnet, comp_idx, desc_idx );
+			       "buffer %#x/%#x%s\n", vmxnet, comp_idx, desc_idx,
+			       ( body ? " (body)" : "" ) );
 			netdev_rx_err ( netdev, NULL, -ENOTTY );
 			continue;
 		}
 
 		/* Remove I/O buffer from receive queue */
-		vmxnet->rx_iobuf[desc_idx] = NULL;
-		vmxnet->count.rx_fill--;
+		*slot = NULL;
+		if ( body ) {
+			vmxnet->count.rx_body_fill--;
+		} else {
+			vmxnet->count.rx_fill--;
+		}
+
+		/* Discard any stale fragments on start of packet */
+		if ( index & VMXNET3_RXCI_SOP )
+			vmxnet3_discard_rx ( netdev, -EPIPE );
+
+		/* Add fragment to packet */
+		len = le32_to_cpu ( rx_comp->len );
+		DBGC2 ( vmxnet, "VMXNET3 %p completed RX %#x/%#x%s (len %#x)\n",
+			vmxnet, comp_idx, desc_idx, ( body ? " (body)" : "" ),
+			( len & ( VMXNET3_MAX_PACKET_LEN - 1 ) ) );
+		iob_put ( iobuf, ( len & ( VMXNET3_MAX_PACKET_LEN - 1 ) ) );
+		list_add_tail ( &iobuf->list, &vmxnet->rx_frags );
+
+		/* Wait for end of packet */
+		if ( ! ( index & VMXNET3_RXCI_EOP ) )
+			continue;
+
+		/* Discard packet on error */
+		if ( len & VMXNET3_RXCL_ERR ) {
+			vmxnet3_discard_rx ( netdev, -EIO );
+			continue;
+		}
+
+		/* Reassemble packet, if applicable */
+		iobuf = iob_concatenate ( &vmxnet->rx_frags );
+		if ( ! iobuf ) {
+			vmxnet3_discard_rx ( netdev, -ENOMEM );
+			continue;
+		}
+
+		/* Record hardware checksum verification, if applicable */
+		if ( vmxnet3_rx_csum_valid ( rx_comp ) )
+			iobuf->flags |= IOB_CSUM_VALID;
 
 		/* Deliver packet to network layer */
-		len = ( le32_to_cpu ( rx_comp->len ) &
-			( VMXNET3_MAX_PACKET_LEN - 1 ) );
-		DBGC2 ( vmxnet, "VMXNET3 %p completed RX %#x/%#x (len %#zx)\n",
-			vmxnet, comp_idx, desc_idx, len );
-		iob_put ( iobuf, len );
 		netdev_rx ( netdev, iobuf );
 	}
 }
@@ -327,6 +473,13 @@ static void vmxnet3_flush_rx ( struct net_device *netdev ) {
 			vmxnet->rx_iobuf[i] = NULL;
 		}
 	}
+	for ( i = 0 ; i < VMXNET3_NUM_RX_BODY ; i++ ) {
+		if ( ( iobuf = vmxnet->rx_body_iobuf[i] ) != NULL ) {
+			netdev_rx_err ( netdev, iobuf, -ECANCELED );
+			vmxnet->rx_body_iobuf[i] = NULL;
+		}
+	}
+	vmxnet3_discard_rx ( netdev, -ECANCELED );
 }
 
 /**
@@ -466,6 +619,17 @@ static int vmxnet3_open ( struct net_device *netdev ) {
 	uint32_t status;
 	int rc;
 
+	/* Sanity checks */
+	build_assert ( ( VMXNET3_NUM_TX_DESC & ( VMXNET3_NUM_TX_DESC - 1 ) )
+		       == 0 );
+	build_assert ( ( VMXNET3_NUM_RX_DESC & ( VMXNET3_NUM_RX_DESC - 1 ) )
+		       == 0 );
+	build_assert ( ( VMXNET3_NUM_RX_BODY & ( VMXNET3_NUM_RX_BODY - 1 ) )
+		       == 0 );
+	build_assert ( VMXNET3_NUM_RX_BODY <= VMXNET3_NUM_RX_DESC );
+	build_assert ( VMXNET3_RX_FILL <= VMXNET3_NUM_RX_DESC );
+	build_assert ( VMXNET3_RX_BODY_FILL <= VMXNET3_NUM_RX_BODY );
+
 	/* Allocate DMA areas */
 	vmxnet->dma = malloc_phys ( sizeof ( *vmxnet->dma ),
 				    VMXNET3_DMA_ALIGN );
@@ -490,6 +654,9 @@ static int vmxnet3_open ( struct net_device *netdev ) {
 	queues->rx.cfg.comp_address =
 		cpu_to_le64 ( virt_to_bus ( &vmxnet->dma->rx_comp ) );
 	queues->rx.cfg.num_desc[0] = cpu_to_le32 ( VMXNET3_NUM_RX_DESC );
+	queues->rx.cfg.desc_address[1] =
+		cpu_to_le64 ( virt_to_bus ( &vmxnet->dma->rx_body ) );
+	queues->rx.cfg.num_desc[1] = cpu_to_le32 ( VMXNET3_NUM_RX_BODY );
 	queues->rx.cfg.num_comp = cpu_to_le32 ( VMXNET3_NUM_RX_COMP );
 	queues_bus = virt_to_bus ( queues );
 	DBGC ( vmxnet, "VMXNET3 %p queue descriptors at %08llx+%zx\n",
@@ -502,9 +669,12 @@ static int vmxnet3_open ( struct net_device *netdev ) {
 	shared->misc.version_support = cpu_to_le32 ( VMXNET3_VERSION_SELECT );
 	shared->misc.upt_version_support =
 		cpu_to_le32 ( VMXNET3_UPT_VERSION_SELECT );
+	shared->misc.upt_features =
+		cpu_to_le64 ( VMXNET3_F_RXCSUM | VMXNET3_F_LRO );
 	shared->misc.queue_desc_address = cpu_to_le64 ( queues_bus );
 	shared->misc.queue_desc_len = cpu_to_le32 ( sizeof ( *queues ) );
 	shared->misc.mtu = cpu_to_le32 ( VMXNET3_MTU );
+	shared->misc.max_num_rx_sg = cpu_to_le16 ( VMXNET3_MAX_RX_SG );
 	shared->misc.num_tx_queues = 1;
 	shared->misc.num_rx_queues = 1;
 	shared->interrupt.num_intrs = 1;
@@ -635,10 +805,12 @@ static int vmxnet3_probe ( struct pci_device *pci ) {
 		goto err_alloc_etherdev;
 	}
 	netdev_init ( netdev, &vmxnet3_operations );
+	netdev->tx_offloads = NETDEV_TX_OFFLOAD_CSUM;
 	vmxnet = netdev->priv;
 	pci_set_drvdata ( pci, netdev );
 	netdev->dev = &pci->dev;
 	memset ( vmxnet, 0, sizeof ( *vmxnet ) );
+	INIT_LIST_HEAD ( &vmxnet->rx_frags );
 
 	/* Fix up PCI device */
 	adjust_pci_device ( pci );
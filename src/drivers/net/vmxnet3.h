@@ -35,6 +35,8 @@ FILE_SECBOOT ( PERMITTED );
  */
 
 #include <ipxe/pci.h>
+#include <ipxe/list.h>
+#include <config/netdev.h>
 
 /** Maximum number of TX queues */
 #define VMXNET3_MAX_TX_QUEUES 8
@@ -170,6 +172,14 @@ struct vmxnet3_misc_config {
 /** Driver version magic */
 #define VMXNET3_VERSION_MAGIC 0x69505845
 
+/** UPT features */
+enum vmxnet3_upt_feature {
+	VMXNET3_F_RXCSUM	= 0x0001,  /**< Receive checksum offload */
+	VMXNET3_F_RSS		= 0x0002,  /**< Receive side scaling */
+	VMXNET3_F_RXVLAN	= 0x0004,  /**< Receive VLAN tag stripping */
+	VMXNET3_F_LRO		= 0x0008,  /**< Large receive offload */
+};
+
 /** Interrupt configuration */
 struct vmxnet3_interrupt_config {
 	uint8_t mask_mode;
@@ -260,6 +270,15 @@ struct vmxnet3_tx_desc {
 /** Transmit completion request flag */
 #define VMXNET3_TXF_CQ 0x000002000UL
 
+/** Transmit checksum offset */
+#define VMXNET3_TXF_MSSCOF( offset ) ( (offset) << 18 )
+
+/** Transmit header length */
+#define VMXNET3_TXF_HLEN( len ) ( (len) << 0 )
+
+/** Transmit checksum offload mode */
+#define VMXNET3_TXF_OM_CSUM 0x00000800UL
+
 /** Transmit completion descriptor */
 struct vmxnet3_tx_comp {
 	/** Index of the end-of-packet descriptor */
@@ -325,6 +344,9 @@ struct vmxnet3_rx_desc {
 /** Receive generation flag */
 #define VMXNET3_RXF_GEN 0x80000000UL
 
+/** Receive body buffer type flag */
+#define VMXNET3_RXF_BODY 0x00004000UL
+
 /** Receive completion descriptor */
 struct vmxnet3_rx_comp {
 	/** Descriptor index */
@@ -337,6 +359,33 @@ struct vmxnet3_rx_comp {
 	uint32_t flags;
 } __attribute__ (( packed ));
 
+/** Receive completion ring identifier */
+#define VMXNET3_RXCI_RQID( index ) ( ( (index) >> 16 ) & 0x3ff )
+
+/** Receive completion end-of-packet flag */
+#define VMXNET3_RXCI_EOP 0x00004000UL
+
+/** Receive completion start-of-packet flag */
+#define VMXNET3_RXCI_SOP 0x00008000UL
+
+/** Receive completion checksum not calculated flag */
+#define VMXNET3_RXCI_CNC 0x40000000UL
+
+/** Receive completion error flag */
+#define VMXNET3_RXCL_ERR 0x00004000UL
+
+/** Receive completion transport-layer checksum correct flag */
+#define VMXNET3_RXCF_TUC 0x00010000UL
+
+/** Receive completion UDP flag */
+#define VMXNET3_RXCF_UDP 0x00020000UL
+
+/** Receive completion TCP flag */
+#define VMXNET3_RXCF_TCP 0x00040000UL
+
+/** Receive completion IPv4 fragment flag */
+#define VMXNET3_RXCF_FRG 0x00400000UL
+
 /** Receive completion generation flag */
 #define VMXNET3_RXCF_GEN 0x80000000UL
 
@@ -418,17 +467,15 @@ struct vmxnet3_queues {
 /** Alignment of rings */
 #define VMXNET3_RING_ALIGN 512
 
-/** Number of TX descriptors */
-#define VMXNET3_NUM_TX_DESC 32
-
 /** Number of TX completion descriptors */
-#define VMXNET3_NUM_TX_COMP 32
-
-/** Number of RX descriptors */
-#define VMXNET3_NUM_RX_DESC 32
+#define VMXNET3_NUM_TX_COMP VMXNET3_NUM_TX_DESC
 
-/** Number of RX completion descriptors */
-#define VMXNET3_NUM_RX_COMP 32
+/** Number of RX completion descriptors
+ *
+ * The completion ring is shared between both receive rings, and so
+ * must be at least as large as their combined size.
+ */
+#define VMXNET3_NUM_RX_COMP ( 2 * VMXNET3_NUM_RX_DESC )
 
 /**
  * DMA areas
@@ -443,6 +490,8 @@ struct vmxnet3_dma {
 	struct vmxnet3_tx_comp tx_comp[VMXNET3_NUM_TX_COMP];
 	/** RX descriptor ring */
 	struct vmxnet3_rx_desc rx_desc[VMXNET3_NUM_RX_DESC];
+	/** RX body descriptor ring */
+	struct vmxnet3_rx_desc rx_body[VMXNET3_NUM_RX_BODY];
 	/** RX completion ring */
 	struct vmxnet3_rx_comp rx_comp[VMXNET3_NUM_RX_COMP];
 	/** Queue descriptors */
@@ -464,6 +513,10 @@ struct vmxnet3_counters {
 	unsigned int rx_prod;
 	/** Receive fill level */
 	unsigned int rx_fill;
+	/** Receive body producer counter */
+	unsigned int rx_body_prod;
+	/** Receive body fill level */
+	unsigned int rx_body_fill;
 	/** Receive consumer counter */
 	unsigned int rx_cons;
 };
@@ -483,6 +536,10 @@ struct vmxnet3_nic {
 	struct io_buffer *tx_iobuf[VMXNET3_NUM_TX_DESC];
 	/** Receive I/O buffers */
 	struct io_buffer *rx_iobuf[VMXNET3_NUM_RX_DESC];
+	/** Receive body I/O buffers */
+	struct io_buffer *rx_body_iobuf[VMXNET3_NUM_RX_BODY];
+	/** Partially received packet fragments */
+	struct list_head rx_frags;
 };
 
 /** vmxnet3 version that we support */
@@ -497,8 +554,15 @@ struct vmxnet3_nic {
 /** Transmit ring maximum fill level */
 #define VMXNET3_TX_FILL ( VMXNET3_NUM_TX_DESC - 1 )
 
-/** Receive ring maximum fill level */
-#define VMXNET3_RX_FILL 8
+/** Receive body buffer length */
+#define VMXNET3_RX_BODY_LEN 2048
+
+/** Maximum number of receive scatter-gather elements
+ *
+ * This allows for a maximum-length large receive offload packet.
+ */
+#define VMXNET3_MAX_RX_SG \
+	( 1 + ( ( 65536 + VMXNET3_RX_BODY_LEN - 1 ) / VMXNET3_RX_BODY_LEN ) )
 
 /** Received packet alignment padding */
 #define NET_IP_ALIGN 2
@@ -63,6 +63,21 @@ static void ns16550_transmit ( struct uart *uart, uint8_t data ) {
 	ns16550_write ( ns16550, NS16550_THR, data );
 }
 
+/**
+ * Check if transmitter is ready
+ *
+ * @v uart		UART
+ * @ret ready		Transmitter is ready
+ */
+static int ns16550_transmit_ready ( struct uart *uart ) {
+	struct ns16550_uart *ns16550 = uart->priv;
+	uint8_t lsr;
+
+	/* Check for transmitter holding register empty */
+	lsr = ns16550_read ( ns16550, NS16550_LSR );
+	return ( lsr & NS16550_LSR_THRE );
+}
+
 /**
  * Check if data is ready
  *
@@ -170,6 +185,7 @@ static int ns16550_init ( struct uart *uart ) {
 /** 16550 UART operations */
 struct uart_operations ns16550_operations = {
 	.transmit = ns16550_transmit,
+	.transmit_ready = ns16550_transmit_ready,
 	.data_ready = ns16550_data_ready,
 	.receive = ns16550_receive,
 	.init = ns16550_init,
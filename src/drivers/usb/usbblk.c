@@ -210,8 +210,8 @@ static int usbblk_out_data ( struct usbblk_device *usbblk ) {
 	assert ( cmd->scsi.data_out != NULL );
 	assert ( cmd->offset < cmd->scsi.data_out_len );
 	len = ( cmd->scsi.data_out_len - cmd->offset );
-	if ( len > USBBLK_MAX_LEN )
-		len = USBBLK_MAX_LEN;
+	if ( len > usbblk->len )
+		len = usbblk->len;
 	assert ( ( len % usbblk->out.mtu ) == 0 );
 
 	/* Allocate I/O buffer */
@@ -430,7 +430,7 @@ static int usbblk_in_refill ( struct usbblk_device *usbblk ) {
 		assert ( cmd->offset <= cmd->scsi.data_in_len );
 		remaining += ( cmd->scsi.data_in_len - cmd->offset );
 	}
-	max = ( ( remaining + USBBLK_MAX_LEN - 1 ) / USBBLK_MAX_LEN );
+	max = ( ( remaining + usbblk->len - 1 ) / usbblk->len );
 
 	/* Refill bulk IN endpoint */
 	if ( ( rc = usb_refill_limit ( &usbblk->in, max ) ) != 0 )
@@ -816,6 +816,7 @@ struct uri_opener usbblk_uri_opener __uri_opener = {
 static int usbblk_probe ( struct usb_function *func,
 			  struct usb_configuration_descriptor *config ) {
 	struct usb_device *usb = func->usb;
+	struct usb_bus *bus = usb->port->hub->bus;
 	struct usbblk_device *usbblk;
 	struct usb_interface_descriptor *desc;
 	int rc;
@@ -829,7 +830,6 @@ static int usbblk_probe ( struct usb_function *func,
 	usbblk->func = func;
 	usb_endpoint_init ( &usbblk->out, usb, &usbblk_out_operations );
 	usb_endpoint_init ( &usbblk->in, usb, &usbblk_in_operations );
-	usb_refill_init ( &usbblk->in, 0, USBBLK_MAX_LEN, USBBLK_MAX_FILL );
 	intf_init ( &usbblk->scsi, &usbblk_scsi_desc, &usbblk->refcnt );
 	intf_init ( &usbblk->data, &usbblk_data_desc, &usbblk->refcnt );
 	process_init_stopped ( &usbblk->process, &usbblk_process_desc,
@@ -858,12 +858,31 @@ static int usbblk_probe ( struct usb_function *func,
 		goto err_in;
 	}
 
+	/* Use the largest data block permitted by the bus, rounded
+	 * down to a whole number of packets on each endpoint.
+	 */
+	usbblk->len = USBBLK_MAX_LEN;
+	if ( usbblk->len > bus->mtu )
+		usbblk->len = bus->mtu;
+	usbblk->len -= ( usbblk->len % usbblk->out.mtu );
+	usbblk->len -= ( usbblk->len % usbblk->in.mtu );
+	if ( ! usbblk->len ) {
+		DBGC ( usbblk, "USBBLK %s has unusable MTUs %zd/%zd\n",
+		       usbblk->func->name, usbblk->out.mtu, usbblk->in.mtu );
+		rc = -ENOTSUP;
+		goto err_len;
+	}
+	usb_refill_init ( &usbblk->in, 0, usbblk->len, USBBLK_MAX_FILL );
+	DBGC ( usbblk, "USBBLK %s using %zd-byte data blocks\n",
+	       usbblk->func->name, usbblk->len );
+
 	/* Add to list of devices */
 	list_add_tail ( &usbblk->list, &usbblk_devices );
 
 	usb_func_set_drvdata ( func, usbblk );
 	return 0;
 
+ err_len:
  err_in:
  err_out:
  err_desc:
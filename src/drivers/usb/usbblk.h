@@ -87,6 +87,8 @@ struct usbblk_device {
 	struct usb_endpoint out;
 	/** Bulk IN endpoint */
 	struct usb_endpoint in;
+	/** Length of USB data blocks */
+	size_t len;
 
 	/** SCSI command-issuing interface */
 	struct interface scsi;
@@ -109,9 +111,12 @@ struct usbblk_device {
 
 /** Maximum length of USB data block
  *
- * This is a policy decision.
+ * This is a policy decision.  Larger data blocks allow each bulk
+ * transfer to be handled by a single transfer descriptor (where the
+ * host controller permits), substantially improving throughput on
+ * high-speed and SuperSpeed devices.
  */
-#define USBBLK_MAX_LEN 2048
+#define USBBLK_MAX_LEN 32768
 
 /** Maximum endpoint fill level
  *
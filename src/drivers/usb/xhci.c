@@ -272,6 +272,7 @@ void xhci_init ( struct xhci_device *xhci ) {
 
 	/* Set device name */
 	xhci->name = xhci->dev->name;
+	INIT_LIST_HEAD ( &xhci->doorbells );
 
 	/* Locate capability, operational, runtime, and doorbell registers */
 	xhci->cap = xhci->regs;
@@ -2481,6 +2482,7 @@ static int xhci_endpoint_open ( struct usb_endpoint *ep ) {
 	endpoint->ctx = ctx;
 	endpoint->type = type;
 	endpoint->interval = interval;
+	INIT_LIST_HEAD ( &endpoint->doorbell );
 	endpoint->context = ( ( ( void * ) slot->context ) +
 			      xhci_device_context_offset ( xhci, ctx ) );
 
@@ -2526,6 +2528,10 @@ static void xhci_endpoint_close ( struct usb_endpoint *ep ) {
 	if ( ctx != XHCI_CTX_EP0 )
 		xhci_deconfigure_endpoint ( xhci, slot, endpoint );
 
+	/* Discard any deferred doorbell */
+	if ( ! list_empty ( &endpoint->doorbell ) )
+		list_del ( &endpoint->doorbell );
+
 	/* Cancel any incomplete transfers */
 	while ( xhci_ring_fill ( &endpoint->ring ) ) {
 		iobuf = xhci_dequeue_multi ( &endpoint->ring );
@@ -2702,6 +2708,7 @@ static int xhci_endpoint_stream ( struct usb_endpoint *ep,
 	union xhci_trb *trb = trbs;
 	struct xhci_trb_normal *normal;
 	physaddr_t data;
+	unsigned int busy;
 	unsigned int i;
 	size_t trb_len;
 	int rc;
@@ -2746,12 +2753,21 @@ static int xhci_endpoint_stream ( struct usb_endpoint *ep,
 	trb[-1].normal.flags = XHCI_TRB_IOC;
 
 	/* Enqueue TRBs */
+	busy = xhci_ring_fill ( &endpoint->ring );
 	if ( ( rc = xhci_enqueue_multi ( &endpoint->ring, iobuf, trbs,
 					 count ) ) != 0 )
 		goto err_enqueue;
 
-	/* Ring the doorbell */
-	xhci_doorbell ( &endpoint->ring );
+	/* Ring the doorbell immediately if the endpoint was idle.
+	 * Otherwise, defer the doorbell until the next poll, so that
+	 * a burst of transfers (such as a refill of the receive
+	 * ring) requires only a single doorbell write.
+	 */
+	if ( ! busy ) {
+		xhci_doorbell ( &endpoint->ring );
+	} else if ( list_empty ( &endpoint->doorbell ) ) {
+		list_add_tail ( &endpoint->doorbell, &xhci->doorbells );
+	}
 
 	profile_stop ( &xhci_stream_profiler );
 	return 0;
@@ -3012,9 +3028,19 @@ static void xhci_bus_close ( struct usb_bus *bus ) {
  */
 static void xhci_bus_poll ( struct usb_bus *bus ) {
 	struct xhci_device *xhci = usb_bus_get_hostdata ( bus );
+	struct xhci_endpoint *endpoint;
+	struct xhci_endpoint *tmp;
 
 	/* Poll event ring */
 	xhci_event_poll ( xhci );
+
+	/* Ring any deferred doorbells */
+	list_for_each_entry_safe ( endpoint, tmp, &xhci->doorbells,
+				   doorbell ) {
+		list_del ( &endpoint->doorbell );
+		INIT_LIST_HEAD ( &endpoint->doorbell );
+		xhci_doorbell ( &endpoint->ring );
+	}
 }
 
 /******************************************************************************
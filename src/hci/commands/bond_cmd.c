@@ -0,0 +1,131 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+FILE_SECBOOT ( PERMITTED );
+
+#include <stdio.h>
+#include <string.h>
+#include <getopt.h>
+#include <ipxe/netdevice.h>
+#include <ipxe/command.h>
+#include <ipxe/parseopt.h>
+#include <ipxe/bond.h>
+
+/** @file
+ *
+ * Link aggregation (bonding) commands
+ *
+ */
+
+/** "bcreate" options */
+struct bcreate_options {};
+
+/** "bcreate" option list */
+static struct option_descriptor bcreate_opts[] = {};
+
+/** "bcreate" command descriptor */
+static struct command_descriptor bcreate_cmd =
+	COMMAND_DESC ( struct bcreate_options, bcreate_opts, 1, MAX_ARGUMENTS,
+		       "<member interface>..." );
+
+/**
+ * "bcreate" command
+ *
+ * @v argc		Argument count
+ * @v argv		Argument list
+ * @ret rc		Return status code
+ */
+static int bcreate_exec ( int argc, char **argv ) {
+	struct bcreate_options opts;
+	struct net_device *members[argc];
+	unsigned int count;
+	unsigned int i;
+	int rc;
+
+	/* Parse options */
+	if ( ( rc = parse_options ( argc, argv, &bcreate_cmd, &opts ) ) != 0 )
+		return rc;
+
+	/* Parse member interfaces */
+	count = ( argc - optind );
+	for ( i = 0 ; i < count ; i++ ) {
+		if ( ( rc = parse_netdev ( argv[ optind + i ],
+					   &members[i] ) ) != 0 )
+			return rc;
+	}
+
+	/* Create bonding device */
+	if ( ( rc = bond_create ( members, count ) ) != 0 ) {
+		printf ( "Could not create bonding device: %s\n",
+			 strerror ( rc ) );
+		return rc;
+	}
+
+	return 0;
+}
+
+/** "bdestroy" options */
+struct bdestroy_options {};
+
+/** "bdestroy" option list */
+static struct option_descriptor bdestroy_opts[] = {};
+
+/** "bdestroy" command descriptor */
+static struct command_descriptor bdestroy_cmd =
+	COMMAND_DESC ( struct bdestroy_options, bdestroy_opts, 1, 1,
+		       "<bonding interface>" );
+
+/**
+ * "bdestroy" command
+ *
+ * @v argc		Argument count
+ * @v argv		Argument list
+ * @ret rc		Return status code
+ */
+static int bdestroy_exec ( int argc, char **argv ) {
+	struct bdestroy_options opts;
+	struct net_device *netdev;
+	int rc;
+
+	/* Parse options */
+	if ( ( rc = parse_options ( argc, argv, &bdestroy_cmd, &opts ) ) != 0 )
+		return rc;
+
+	/* Parse bonding interface */
+	if ( ( rc = parse_netdev ( argv[optind], &netdev ) ) != 0 )
+		return rc;
+
+	/* Destroy bonding device */
+	if ( ( rc = bond_destroy ( netdev ) ) != 0 ) {
+		printf ( "Could not destroy bonding device: %s\n",
+			 strerror ( rc ) );
+		return rc;
+	}
+
+	return 0;
+}
+
+/** Bonding commands */
+COMMAND ( bcreate, bcreate_exec );
+COMMAND ( bdestroy, bdestroy_exec );
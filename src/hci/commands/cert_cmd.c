@@ -124,10 +124,11 @@ static int cert_exec ( int argc, char **argv,
 
 	/* Acquire image, if applicable */
 	if ( ( optind < argc ) &&
-	     ( ( rc = imgacquire ( argv[optind], 0, &image ) ) != 0 ) )
+	     ( ( rc = imgacquire ( argv[optind], 0, 0, &image ) ) != 0 ) )
 		goto err_acquire;
 
 	/* Get first entry in certificate store */
+	x509_populate ( &certstore );
 	tmp = list_first_entry ( &certstore.links, struct x509_certificate,
 				 store.list );
 
@@ -97,7 +97,7 @@ static int console_exec ( int argc, char **argv ) {
 	if ( opts.picture ) {
 
 		/* Acquire image */
-		if ( ( rc = imgacquire ( opts.picture, 0, &image ) ) != 0 )
+		if ( ( rc = imgacquire ( opts.picture, 0, 0, &image ) ) != 0 )
 			goto err_acquire;
 
 		/* Convert to pixel buffer */
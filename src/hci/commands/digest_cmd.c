@@ -86,13 +86,17 @@ int digest_exec ( int argc, char **argv, struct digest_algorithm *digest ) {
 	for ( i = optind ; i < argc ; i++ ) {
 
 		/* Acquire image */
-		if ( ( rc = imgacquire ( argv[i], 0, &image ) ) != 0 )
+		if ( ( rc = imgacquire ( argv[i], 0, 0, &image ) ) != 0 )
 			return rc;
 
-		/* Calculate digest */
-		digest_init ( digest, ctx );
-		digest_update ( digest, ctx, image->data, image->len );
-		digest_final ( digest, ctx, out );
+		/* Use digest accumulated during download, if available,
+		 * otherwise calculate digest.
+		 */
+		if ( image_digest_final ( image, digest, out ) != 0 ) {
+			digest_init ( digest, ctx );
+			digest_update ( digest, ctx, image->data, image->len );
+			digest_final ( digest, ctx, out );
+		}
 
 		/* Display or store digest as directed */
 		if ( opts.setting.settings ) {
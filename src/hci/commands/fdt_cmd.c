@@ -73,7 +73,7 @@ static int fdt_exec ( int argc, char **argv ) {
 	name_uri = argv[optind];
 
 	/* Acquire image, if applicable */
-	if ( name_uri && ( ( rc = imgacquire ( name_uri, opts.timeout,
+	if ( name_uri && ( ( rc = imgacquire ( name_uri, opts.timeout, 0,
 					       &image ) ) != 0 ) ) {
 		goto err_image;
 	}
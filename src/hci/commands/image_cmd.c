@@ -31,9 +31,11 @@ FILE_SECBOOT ( PERMITTED );
 #include <errno.h>
 #include <getopt.h>
 #include <ipxe/image.h>
+#include <ipxe/uri.h>
 #include <ipxe/command.h>
 #include <ipxe/parseopt.h>
 #include <ipxe/shell.h>
+#include <ipxe/downloader.h>
 #include <usr/imgmgmt.h>
 
 /** @file
@@ -52,16 +54,18 @@ struct imgsingle_options {
 	int replace;
 	/** Free image after execution */
 	int autofree;
+	/** Decompress image during download */
+	int decompress;
 };
 
 /** "img{single}" option list */
 static union {
-	/* "imgexec" takes all three options */
-	struct option_descriptor imgexec[4];
+	/* "imgexec" takes all five options */
+	struct option_descriptor imgexec[5];
 	/* Other "img{single}" commands take only --name, --timeout,
-	 * and --autofree
+	 * --autofree, and --decompress
 	 */
-	struct option_descriptor imgsingle[3];
+	struct option_descriptor imgsingle[4];
 } opts = {
 	.imgexec = {
 		OPTION_DESC ( "name", 'n', required_argument,
@@ -70,6 +74,9 @@ static union {
 			      struct imgsingle_options, timeout, parse_timeout),
 		OPTION_DESC ( "autofree", 'a', no_argument,
 			      struct imgsingle_options, autofree, parse_flag ),
+		OPTION_DESC ( "decompress", 'd', no_argument,
+			      struct imgsingle_options, decompress,
+			      parse_flag ),
 		OPTION_DESC ( "replace", 'r', no_argument,
 			      struct imgsingle_options, replace, parse_flag ),
 	},
@@ -81,7 +88,7 @@ struct imgsingle_descriptor {
 	struct command_descriptor *cmd;
 	/** Function to use to acquire the image */
 	int ( * acquire ) ( const char *name, unsigned long timeout,
-			    struct image **image );
+			    unsigned int flags, struct image **image );
 	/** Pre-action to take upon image, or NULL */
 	void ( * preaction ) ( struct image *image );
 	/** Action to take upon image, or NULL */
@@ -107,6 +114,7 @@ static int imgsingle_exec ( int argc, char **argv,
 	char *name_uri = NULL;
 	char *cmdline = NULL;
 	struct image *image;
+	unsigned int flags;
 	int rc;
 
 	/* Parse options */
@@ -127,7 +135,8 @@ static int imgsingle_exec ( int argc, char **argv,
 
 	/* Acquire the image */
 	if ( name_uri ) {
-		if ( ( rc = desc->acquire ( name_uri, opts.timeout,
+		flags = ( opts.decompress ? DOWNLOAD_DECOMPRESS : 0 );
+		if ( ( rc = desc->acquire ( name_uri, opts.timeout, flags,
 					    &image ) ) != 0 )
 			goto err_acquire;
 	} else {
@@ -394,6 +403,106 @@ static int imgfree_exec ( int argc, char **argv ) {
 	return imgmulti_exec ( argc, argv, unregister_image );
 }
 
+/** "imgprefetch" options */
+struct imgprefetch_options {
+	/** Decompress image during download */
+	int decompress;
+	/** Discard all prefetched images */
+	int discard;
+};
+
+/** "imgprefetch" option list */
+static struct option_descriptor imgprefetch_opts[] = {
+	OPTION_DESC ( "decompress", 'd', no_argument,
+		      struct imgprefetch_options, decompress, parse_flag ),
+	OPTION_DESC ( "discard", 'x', no_argument,
+		      struct imgprefetch_options, discard, parse_flag ),
+};
+
+/** "imgprefetch" command descriptor */
+static struct command_descriptor imgprefetch_cmd =
+	COMMAND_DESC ( struct imgprefetch_options, imgprefetch_opts,
+		       0, MAX_ARGUMENTS, "[<uri>...]" );
+
+/**
+ * The "imgprefetch" command
+ *
+ * @v argc		Argument count
+ * @v argv		Argument list
+ * @ret rc		Return status code
+ */
+static int imgprefetch_exec ( int argc, char **argv ) {
+	struct imgprefetch_options opts;
+	struct uri *uri;
+	unsigned int flags;
+	int i;
+	int rc;
+
+	/* Parse options */
+	if ( ( rc = parse_options ( argc, argv, &imgprefetch_cmd,
+				    &opts ) ) != 0 )
+		return rc;
+
+	/* Discard existing prefetches, if applicable */
+	if ( opts.discard )
+		imgprefetch_discard();
+
+	/* Start prefetching each specified URI */
+	flags = ( opts.decompress ? DOWNLOAD_DECOMPRESS : 0 );
+	for ( i = optind ; i < argc ; i++ ) {
+		uri = parse_uri ( argv[i] );
+		if ( ! uri )
+			return -ENOMEM;
+		rc = imgprefetch ( uri, flags );
+		uri_put ( uri );
+		if ( rc != 0 ) {
+			printf ( "Could not prefetch %s: %s\n",
+				 argv[i], strerror ( rc ) );
+			return rc;
+		}
+	}
+
+	return 0;
+}
+
+/** "imgwait" options */
+struct imgwait_options {
+	/** Download timeout */
+	unsigned long timeout;
+};
+
+/** "imgwait" option list */
+static struct option_descriptor imgwait_opts[] = {
+	OPTION_DESC ( "timeout", 't', required_argument,
+		      struct imgwait_options, timeout, parse_timeout ),
+};
+
+/** "imgwait" command descriptor */
+static struct command_descriptor imgwait_cmd =
+	COMMAND_DESC ( struct imgwait_options, imgwait_opts, 0, 0, NULL );
+
+/**
+ * The "imgwait" command
+ *
+ * @v argc		Argument count
+ * @v argv		Argument list
+ * @ret rc		Return status code
+ */
+static int imgwait_exec ( int argc, char **argv ) {
+	struct imgwait_options opts;
+	int rc;
+
+	/* Parse options */
+	if ( ( rc = parse_options ( argc, argv, &imgwait_cmd, &opts ) ) != 0 )
+		return rc;
+
+	/* Wait for and register all prefetched images */
+	if ( ( rc = imgprefetch_wait ( opts.timeout ) ) != 0 )
+		return rc;
+
+	return 0;
+}
+
 /* "imgfetch" and synonyms */
 COMMAND ( imgfetch, imgfetch_exec );
 COMMAND ( module, imgfetch_exec );
@@ -413,3 +522,5 @@ COMMAND ( boot, imgexec_exec );
 COMMAND ( imgargs, imgargs_exec );
 COMMAND ( imgstat, imgstat_exec );
 COMMAND ( imgfree, imgfree_exec );
+COMMAND ( imgprefetch, imgprefetch_exec );
+COMMAND ( imgwait, imgwait_exec );
@@ -92,6 +92,8 @@ struct imgverify_options {
 	char *signer;
 	/** Keep signature after verification */
 	int keep;
+	/** Acquire signature first and digest image during download */
+	int stream;
 	/** Download timeout */
 	unsigned long timeout;
 };
@@ -102,6 +104,8 @@ static struct option_descriptor imgverify_opts[] = {
 		      struct imgverify_options, signer, parse_string ),
 	OPTION_DESC ( "keep", 'k', no_argument,
 		      struct imgverify_options, keep, parse_flag ),
+	OPTION_DESC ( "stream", 'S', no_argument,
+		      struct imgverify_options, stream, parse_flag ),
 	OPTION_DESC ( "timeout", 't', required_argument,
 		      struct imgverify_options, timeout, parse_timeout),
 };
@@ -122,6 +126,7 @@ static int imgverify_exec ( int argc, char **argv ) {
 	struct imgverify_options opts;
 	const char *image_name_uri;
 	const char *signature_name_uri;
+	struct digest_algorithm *digest;
 	struct image *image;
 	struct image *signature;
 	int rc;
@@ -136,14 +141,26 @@ static int imgverify_exec ( int argc, char **argv ) {
 	/* Parse signature name/URI string */
 	signature_name_uri = argv[ optind + 1 ];
 
-	/* Acquire the image */
-	if ( ( rc = imgacquire ( image_name_uri, opts.timeout, &image ) ) != 0 )
-		goto err_acquire_image;
-
-	/* Acquire the signature image */
-	if ( ( rc = imgacquire ( signature_name_uri, opts.timeout,
-				 &signature ) ) != 0 )
-		goto err_acquire_signature;
+	/* Acquire the image and the signature image.  If streaming,
+	 * acquire the signature first so that the image digest can be
+	 * accumulated while the image is downloaded.
+	 */
+	if ( opts.stream ) {
+		if ( ( rc = imgacquire ( signature_name_uri, opts.timeout, 0,
+					 &signature ) ) != 0 )
+			goto err_acquire_signature;
+		digest = imgverify_digest ( signature, opts.signer );
+		if ( ( rc = imgacquire_digest ( image_name_uri, opts.timeout,
+						0, digest, &image ) ) != 0 )
+			goto err_acquire_streamed;
+	} else {
+		if ( ( rc = imgacquire ( image_name_uri, opts.timeout, 0,
+					 &image ) ) != 0 )
+			goto err_acquire_image;
+		if ( ( rc = imgacquire ( signature_name_uri, opts.timeout, 0,
+					 &signature ) ) != 0 )
+			goto err_acquire_signature;
+	}
 
 	/* Verify image */
 	if ( ( rc = imgverify ( image, signature, opts.signer ) ) != 0 ) {
@@ -155,6 +172,7 @@ static int imgverify_exec ( int argc, char **argv ) {
 	rc = 0;
 
  err_verify:
+ err_acquire_streamed:
 	/* Discard signature unless --keep was specified */
 	if ( ! opts.keep )
 		unregister_image ( signature );
@@ -66,5 +66,36 @@ static int ipstat_exec ( int argc, char **argv ) {
 	return 0;
 }
 
+/** "tcpstat" options */
+struct tcpstat_options {};
+
+/** "tcpstat" option list */
+static struct option_descriptor tcpstat_opts[] = {};
+
+/** "tcpstat" command descriptor */
+static struct command_descriptor tcpstat_cmd =
+	COMMAND_DESC ( struct tcpstat_options, tcpstat_opts, 0, 0, NULL );
+
+/**
+ * The "tcpstat" command
+ *
+ * @v argc		Argument count
+ * @v argv		Argument list
+ * @ret rc		Return status code
+ */
+static int tcpstat_exec ( int argc, char **argv ) {
+	struct tcpstat_options opts;
+	int rc;
+
+	/* Parse options */
+	if ( ( rc = parse_options ( argc, argv, &tcpstat_cmd, &opts ) ) != 0 )
+		return rc;
+
+	tcpstat();
+
+	return 0;
+}
+
 /** Routing table management commands */
 COMMAND ( ipstat, ipstat_exec );
+COMMAND ( tcpstat, tcpstat_exec );
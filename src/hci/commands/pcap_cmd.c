@@ -0,0 +1,187 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+FILE_SECBOOT ( PERMITTED );
+
+#include <stdio.h>
+#include <string.h>
+#include <getopt.h>
+#include <ipxe/netdevice.h>
+#include <ipxe/command.h>
+#include <ipxe/parseopt.h>
+#include <ipxe/pcap.h>
+
+/** @file
+ *
+ * Packet capture commands
+ *
+ */
+
+/** "pcapstart" options */
+struct pcapstart_options {
+	/** Snapshot length */
+	unsigned int snaplen;
+	/** Number of capture ring slots */
+	unsigned int slots;
+	/** Discard new packets when full */
+	int tail_drop;
+};
+
+/** "pcapstart" option list */
+static struct option_descriptor pcapstart_opts[] = {
+	OPTION_DESC ( "snaplen", 's', required_argument,
+		      struct pcapstart_options, snaplen, parse_integer ),
+	OPTION_DESC ( "count", 'c', required_argument,
+		      struct pcapstart_options, slots, parse_integer ),
+	OPTION_DESC ( "tail-drop", 't', no_argument,
+		      struct pcapstart_options, tail_drop, parse_flag ),
+};
+
+/** "pcapstart" command descriptor */
+static struct command_descriptor pcapstart_cmd =
+	COMMAND_DESC ( struct pcapstart_options, pcapstart_opts, 1, 1,
+		       "<interface>" );
+
+/**
+ * "pcapstart" command
+ *
+ * @v argc		Argument count
+ * @v argv		Argument list
+ * @ret rc		Return status code
+ */
+static int pcapstart_exec ( int argc, char **argv ) {
+	struct pcapstart_options opts;
+	struct net_device *netdev;
+	int rc;
+
+	/* Parse options */
+	opts.snaplen = PCAP_DEFAULT_SNAPLEN;
+	opts.slots = PCAP_DEFAULT_SLOTS;
+	if ( ( rc = reparse_options ( argc, argv, &pcapstart_cmd,
+				      &opts ) ) != 0 )
+		return rc;
+
+	/* Parse network device */
+	if ( ( rc = parse_netdev ( argv[optind], &netdev ) ) != 0 )
+		return rc;
+
+	/* Start capture */
+	if ( ( rc = pcap_start ( netdev, opts.snaplen, opts.slots,
+				 opts.tail_drop ) ) != 0 ) {
+		printf ( "Could not start capture on %s: %s\n",
+			 netdev->name, strerror ( rc ) );
+		return rc;
+	}
+
+	return 0;
+}
+
+/** "pcapstop" options */
+struct pcapstop_options {};
+
+/** "pcapstop" option list */
+static struct option_descriptor pcapstop_opts[] = {};
+
+/** "pcapstop" command descriptor */
+static struct command_descriptor pcapstop_cmd =
+	COMMAND_DESC ( struct pcapstop_options, pcapstop_opts, 1, 1,
+		       "<interface>" );
+
+/**
+ * "pcapstop" command
+ *
+ * @v argc		Argument count
+ * @v argv		Argument list
+ * @ret rc		Return status code
+ */
+static int pcapstop_exec ( int argc, char **argv ) {
+	struct pcapstop_options opts;
+	struct net_device *netdev;
+	int rc;
+
+	/* Parse options */
+	if ( ( rc = parse_options ( argc, argv, &pcapstop_cmd, &opts ) ) != 0 )
+		return rc;
+
+	/* Parse network device */
+	if ( ( rc = parse_netdev ( argv[optind], &netdev ) ) != 0 )
+		return rc;
+
+	/* Stop capture */
+	pcap_stop ( netdev );
+
+	return 0;
+}
+
+/** "pcapsave" options */
+struct pcapsave_options {
+	/** Image name */
+	char *name;
+};
+
+/** "pcapsave" option list */
+static struct option_descriptor pcapsave_opts[] = {
+	OPTION_DESC ( "name", 'n', required_argument,
+		      struct pcapsave_options, name, parse_string ),
+};
+
+/** "pcapsave" command descriptor */
+static struct command_descriptor pcapsave_cmd =
+	COMMAND_DESC ( struct pcapsave_options, pcapsave_opts, 1, 1,
+		       "<interface>" );
+
+/**
+ * "pcapsave" command
+ *
+ * @v argc		Argument count
+ * @v argv		Argument list
+ * @ret rc		Return status code
+ */
+static int pcapsave_exec ( int argc, char **argv ) {
+	struct pcapsave_options opts;
+	struct net_device *netdev;
+	int rc;
+
+	/* Parse options */
+	if ( ( rc = parse_options ( argc, argv, &pcapsave_cmd, &opts ) ) != 0 )
+		return rc;
+
+	/* Parse network device */
+	if ( ( rc = parse_netdev ( argv[optind], &netdev ) ) != 0 )
+		return rc;
+
+	/* Save capture */
+	if ( ( rc = pcap_save ( netdev, opts.name ) ) != 0 ) {
+		printf ( "Could not save capture from %s: %s\n",
+			 netdev->name, strerror ( rc ) );
+		return rc;
+	}
+
+	return 0;
+}
+
+/** Packet capture commands */
+COMMAND ( pcapstart, pcapstart_exec );
+COMMAND ( pcapstop, pcapstop_exec );
+COMMAND ( pcapsave, pcapsave_exec );
@@ -0,0 +1,93 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+FILE_SECBOOT ( PERMITTED );
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <getopt.h>
+#include <ipxe/uri.h>
+#include <ipxe/http.h>
+#include <ipxe/command.h>
+#include <ipxe/parseopt.h>
+
+/** @file
+ *
+ * HTTP connection pre-warming commands
+ *
+ */
+
+/** "prewarm" options */
+struct prewarm_options {};
+
+/** "prewarm" option list */
+static struct option_descriptor prewarm_opts[] = {};
+
+/** "prewarm" command descriptor */
+static struct command_descriptor prewarm_cmd =
+	COMMAND_DESC ( struct prewarm_options, prewarm_opts, 1, MAX_ARGUMENTS,
+		       "<uri> [<uri>...]" );
+
+/**
+ * "prewarm" command
+ *
+ * @v argc		Argument count
+ * @v argv		Argument list
+ * @ret rc		Return status code
+ */
+static int prewarm_exec ( int argc, char **argv ) {
+	struct prewarm_options opts;
+	struct uri *uri;
+	struct uri *resolved;
+	int i;
+	int rc;
+
+	/* Parse options */
+	if ( ( rc = parse_options ( argc, argv, &prewarm_cmd, &opts ) ) != 0 )
+		return rc;
+
+	/* Open a pooled connection to each specified server */
+	for ( i = optind ; i < argc ; i++ ) {
+		uri = parse_uri ( argv[i] );
+		if ( ! uri )
+			return -ENOMEM;
+		resolved = resolve_uri ( cwuri, uri );
+		uri_put ( uri );
+		if ( ! resolved )
+			return -ENOMEM;
+		rc = http_prewarm ( resolved );
+		uri_put ( resolved );
+		if ( rc != 0 ) {
+			printf ( "Could not prewarm %s: %s\n",
+				 argv[i], strerror ( rc ) );
+			return rc;
+		}
+	}
+
+	return 0;
+}
+
+/** HTTP connection pre-warming command */
+COMMAND ( prewarm, prewarm_exec );
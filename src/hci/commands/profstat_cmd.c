@@ -25,9 +25,11 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 FILE_SECBOOT ( PERMITTED );
 
 #include <stdio.h>
+#include <errno.h>
 #include <getopt.h>
 #include <ipxe/command.h>
 #include <ipxe/parseopt.h>
+#include <ipxe/profile.h>
 #include <usr/profstat.h>
 
 /** @file
@@ -37,14 +39,48 @@ FILE_SECBOOT ( PERMITTED );
  */
 
 /** "profstat" options */
-struct profstat_options {};
+struct profstat_options {
+	/** Enable profilers */
+	int enable;
+	/** Disable profilers */
+	int disable;
+	/** Show sample histograms */
+	int histogram;
+};
 
 /** "profstat" option list */
-static struct option_descriptor profstat_opts[] = {};
+static struct option_descriptor profstat_opts[] = {
+	OPTION_DESC ( "enable", 'e', no_argument,
+		      struct profstat_options, enable, parse_flag ),
+	OPTION_DESC ( "disable", 'd', no_argument,
+		      struct profstat_options, disable, parse_flag ),
+	OPTION_DESC ( "histogram", 'H', no_argument,
+		      struct profstat_options, histogram, parse_flag ),
+};
 
 /** "profstat" command descriptor */
 static struct command_descriptor profstat_cmd =
-	COMMAND_DESC ( struct profstat_options, profstat_opts, 0, 0, NULL );
+	COMMAND_DESC ( struct profstat_options, profstat_opts, 0, MAX_ARGUMENTS,
+		       "[<profiler>...]" );
+
+/**
+ * Process profiler
+ *
+ * @v profiler		Profiler
+ * @v opts		Command options
+ */
+static void profstat_payload ( struct profiler *profiler,
+			       struct profstat_options *opts ) {
+
+	/* Enable, disable, or show profiler as applicable */
+	if ( opts->enable ) {
+		profiler->enabled = 1;
+	} else if ( opts->disable ) {
+		profiler->enabled = 0;
+	} else {
+		profstat_profiler ( profiler, opts->histogram );
+	}
+}
 
 /**
  * The "profstat" command
@@ -55,13 +91,30 @@ static struct command_descriptor profstat_cmd =
  */
 static int profstat_exec ( int argc, char **argv ) {
 	struct profstat_options opts;
+	struct profiler *profiler;
+	int i;
 	int rc;
 
 	/* Parse options */
 	if ( ( rc = parse_options ( argc, argv, &profstat_cmd, &opts ) ) != 0 )
 		return rc;
 
-	profstat();
+	/* Process all profilers if no profilers were specified */
+	if ( optind == argc ) {
+		for_each_table_entry ( profiler, PROFILERS )
+			profstat_payload ( profiler, &opts );
+		return 0;
+	}
+
+	/* Otherwise, process specified profilers */
+	for ( i = optind ; i < argc ; i++ ) {
+		profiler = find_profiler ( argv[i] );
+		if ( ! profiler ) {
+			printf ( "\"%s\": no such profiler\n", argv[i] );
+			return -ENOENT;
+		}
+		profstat_payload ( profiler, &opts );
+	}
 
 	return 0;
 }
@@ -106,7 +106,7 @@ static int shim_exec ( int argc, char **argv ) {
 
 	/* Acquire image, if applicable */
 	if ( download && name_uri &&
-	     ( ( rc = imgacquire ( name_uri, opts.timeout,
+	     ( ( rc = imgacquire ( name_uri, opts.timeout, 0,
 				   &image ) ) != 0 ) ) {
 		goto err_image;
 	}
@@ -1,4 +1,5 @@
 #include <stdio.h>
+#include <stdlib.h>
 #include <curses.h>
 #include <ipxe/ansicol.h>
 #include <ipxe/console.h>
@@ -13,6 +14,54 @@ static void ansiscr_putc(struct _curses_screen *scr, chtype c) __nonnull;
 
 static unsigned int saved_usage;
 
+/** Maximum number of unchanged characters to reprint when moving cursor
+ *
+ * Reprinting a few unchanged characters is cheaper than moving the
+ * cursor using an ANSI escape sequence.
+ */
+#define ANSISCR_MAX_REPRINT 4
+
+/** Shadow copy of the characters currently displayed on the screen
+ *
+ * This allows us to avoid retransmitting unchanged characters (which
+ * is particularly significant for slow serial consoles).
+ */
+static chtype *shadow;
+
+/** Shadow screen width */
+static unsigned int shadow_cols;
+
+/** Shadow screen height */
+static unsigned int shadow_lines;
+
+/**
+ * Get shadow character cell
+ *
+ * @v y			Y position
+ * @v x			X position
+ * @ret cell		Shadow character cell, or NULL
+ */
+static chtype * ansiscr_shadow ( unsigned int y, unsigned int x ) {
+
+	if ( ( ! shadow ) || ( y >= shadow_lines ) || ( x >= shadow_cols ) )
+		return NULL;
+	return &shadow[ ( y * shadow_cols ) + x ];
+}
+
+/**
+ * Fill shadow screen
+ *
+ * @v c			Character rendition
+ */
+static void ansiscr_shadow_fill ( chtype c ) {
+	unsigned int i;
+
+	if ( ! shadow )
+		return;
+	for ( i = 0 ; i < ( shadow_lines * shadow_cols ) ; i++ )
+		shadow[i] = c;
+}
+
 static void ansiscr_attrs ( struct _curses_screen *scr, attr_t attrs ) {
 	int bold = ( attrs & A_BOLD );
 	attr_t cpair = PAIR_NUMBER ( attrs );
@@ -29,65 +78,133 @@ static void ansiscr_attrs ( struct _curses_screen *scr, attr_t attrs ) {
 static void ansiscr_reset ( struct _curses_screen *scr ) {
 	/* Reset terminal attributes and clear screen */
 	scr->attrs = 0;
-	scr->curs_x = 0;
-	scr->curs_y = 0;
+	scr->curs_x = scr->want_x = 0;
+	scr->curs_y = scr->want_y = 0;
 	printf ( "\0330m" );
 	ansicol_set_pair ( CPAIR_DEFAULT );
 	printf ( "\033[2J" );
+	ansiscr_shadow_fill ( ' ' );
 }
 
 static void ansiscr_init ( struct _curses_screen *scr ) {
 	saved_usage = console_set_usage ( CONSOLE_USAGE_TUI );
+	/* Allocate shadow screen (optional) */
+	shadow_cols = COLS;
+	shadow_lines = LINES;
+	shadow = malloc ( shadow_cols * shadow_lines * sizeof ( shadow[0] ) );
 	ansiscr_reset ( scr );
 }
 
 static void ansiscr_exit ( struct _curses_screen *scr ) {
 	ansiscr_reset ( scr );
 	console_set_usage ( saved_usage );
+	free ( shadow );
+	shadow = NULL;
 }
 
 static void ansiscr_erase ( struct _curses_screen *scr, attr_t attrs ) {
 	ansiscr_attrs ( scr, attrs );
 	printf ( "\033[2J" );
+	ansiscr_shadow_fill ( ' ' | attrs );
 }
 
 static void ansiscr_movetoyx ( struct _curses_screen *scr,
 			       unsigned int y, unsigned int x ) {
-	if ( ( x != scr->curs_x ) || ( y != scr->curs_y ) ) {
-		/* ANSI escape sequence to update cursor position */
+	/* Record requested position; the cursor will be moved when
+	 * a changed character is written or the screen is refreshed.
+	 */
+	scr->want_x = x;
+	scr->want_y = y;
+}
+
+static void ansiscr_refresh ( struct _curses_screen *scr ) {
+	unsigned int x = scr->want_x;
+	unsigned int y = scr->want_y;
+	chtype *cell;
+	unsigned int i;
+
+	/* Do nothing if cursor is already in position */
+	if ( ( x == scr->curs_x ) && ( y == scr->curs_y ) )
+		return;
+
+	/* Reprint a few unchanged printable characters (with the
+	 * current attributes) rather than moving the cursor, if
+	 * possible.
+	 */
+	cell = ansiscr_shadow ( y, scr->curs_x );
+	if ( cell && ( y == scr->curs_y ) && ( x > scr->curs_x ) &&
+	     ( ( x - scr->curs_x ) <= ANSISCR_MAX_REPRINT ) ) {
+		for ( i = 0 ; i < ( x - scr->curs_x ) ; i++ ) {
+			if ( ( ( cell[i] & ( A_ATTRIBUTES | A_COLOR ) ) !=
+			       scr->attrs ) ||
+			     ( ( cell[i] & A_CHARTEXT ) < ' ' ) )
+				break;
+		}
+		if ( i == ( x - scr->curs_x ) ) {
+			for ( i = 0 ; i < ( x - scr->curs_x ) ; i++ )
+				putchar ( cell[i] & A_CHARTEXT );
+			scr->curs_x = x;
+			return;
+		}
+	}
+
+	/* Otherwise, use a carriage return if sufficient, or an ANSI
+	 * escape sequence to update cursor position.
+	 */
+	if ( ( x == 0 ) && ( y == scr->curs_y ) ) {
+		putchar ( '\r' );
+	} else {
 		printf ( "\033[%d;%dH", ( y + 1 ), ( x + 1 ) );
-		scr->curs_x = x;
-		scr->curs_y = y;
 	}
+	scr->curs_x = x;
+	scr->curs_y = y;
 }
 
 static void ansiscr_putc ( struct _curses_screen *scr, chtype c ) {
 	unsigned int character = ( c & A_CHARTEXT );
 	attr_t attrs = ( c & ( A_ATTRIBUTES | A_COLOR ) );
+	chtype *cell = ansiscr_shadow ( scr->want_y, scr->want_x );
 
-	/* Update attributes if changed */
-	ansiscr_attrs ( scr, attrs );
+	/* Skip characters that are already displayed */
+	if ( ! ( cell && ( *cell == c ) ) ) {
+
+		/* Move cursor to requested position */
+		ansiscr_refresh ( scr );
 
-	/* Print the actual character */
-	putchar ( character );
+		/* Update attributes if changed */
+		ansiscr_attrs ( scr, attrs );
+
+		/* Print the actual character */
+		putchar ( character );
+		if ( cell )
+			*cell = c;
+
+		/* Update expected cursor position */
+		if ( ++(scr->curs_x) == COLS ) {
+			scr->curs_x = 0;
+			++scr->curs_y;
+		}
+	}
 
-	/* Update expected cursor position */
-	if ( ++(scr->curs_x) == COLS ) {
-		scr->curs_x = 0;
-		++scr->curs_y;
+	/* Update requested cursor position */
+	if ( ++(scr->want_x) == COLS ) {
+		scr->want_x = 0;
+		++scr->want_y;
 	}
 }
 
-static int ansiscr_getc ( struct _curses_screen *scr __unused ) {
+static int ansiscr_getc ( struct _curses_screen *scr ) {
+	ansiscr_refresh ( scr );
 	return getchar();
 }
 
-static bool ansiscr_peek ( struct _curses_screen *scr __unused ) {
+static bool ansiscr_peek ( struct _curses_screen *scr ) {
+	ansiscr_refresh ( scr );
 	return iskey();
 }
 
-static void ansiscr_cursor ( struct _curses_screen *scr __unused,
-			     int visibility ) {
+static void ansiscr_cursor ( struct _curses_screen *scr, int visibility ) {
+	ansiscr_refresh ( scr );
 	printf ( "\033[?25%c", ( visibility ? 'h' : 'l' ) );
 }
 
@@ -97,6 +214,7 @@ SCREEN _ansi_screen = {
 	.erase		= ansiscr_erase,
 	.movetoyx	= ansiscr_movetoyx,
 	.putc		= ansiscr_putc,
+	.refresh	= ansiscr_refresh,
 	.getc		= ansiscr_getc,
 	.peek		= ansiscr_peek,
 	.cursor		= ansiscr_cursor,
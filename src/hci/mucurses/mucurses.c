@@ -146,6 +146,22 @@ int wmove ( WINDOW *win, int y, int x ) {
 	return OK;
 }
 
+/**
+ * Update physical cursor position
+ *
+ * @v *win	window to be refreshed
+ * @ret rc	return status code
+ *
+ * Characters are written to the screen immediately, but the physical
+ * cursor is moved only when required.  This should be called before
+ * waiting for input with a visible cursor.
+ */
+int wrefresh ( WINDOW *win ) {
+	_wupdcurs ( win );
+	win->scr->refresh ( win->scr );
+	return OK;
+}
+
 /**
  * Set cursor visibility
  *
@@ -81,6 +81,7 @@ static void draw_editbox ( struct widget *widget ) {
 	color_set ( CPAIR_EDIT, NULL );
 	mvprintw ( widget->row, widget->col, "%s", buf );
 	move ( widget->row, ( widget->col + cursor_offset ) );
+	refresh();
 	color_set ( CPAIR_NORMAL, NULL );
 }
 
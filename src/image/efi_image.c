@@ -347,6 +347,13 @@ static int efi_image_exec ( struct image *image ) {
 	 * LoadImage() does not (allegedly) modify the image content,
 	 * but requires a non-const pointer to SourceBuffer.  We
 	 * therefore use the .rwdata field rather than .data.
+	 *
+	 * Passing the image via SourceBuffer allows the firmware to
+	 * relocate directly from our copy.  Omitting SourceBuffer
+	 * and leaving the firmware to read the image via imgpath
+	 * (using our file or load file protocols) would cause the
+	 * firmware to first read the whole image into a temporary
+	 * buffer of its own, adding an extra copy.
 	 */
 	handle = NULL;
 	if ( ( efirc = bs->LoadImage ( FALSE, efi_image_handle, imgpath,
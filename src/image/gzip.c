@@ -28,6 +28,8 @@ FILE_SECBOOT ( PERMITTED );
 #include <string.h>
 #include <errno.h>
 #include <assert.h>
+#include <byteswap.h>
+#include <ipxe/crc32.h>
 #include <ipxe/deflate.h>
 #include <ipxe/image.h>
 #include <ipxe/zlib.h>
@@ -52,6 +54,8 @@ static int gzip_extract ( struct image *image, struct image *extracted ) {
 	const struct gzip_crc_header *crc;
 	const struct gzip_footer *footer;
 	const void *data;
+	uint32_t expected;
+	uint32_t actual;
 	size_t extra_len;
 	size_t string_len;
 	size_t len;
@@ -138,6 +142,15 @@ static int gzip_extract ( struct image *image, struct image *extracted ) {
 		return rc;
 	}
 
+	/* Verify CRC */
+	expected = le32_to_cpu ( footer->crc );
+	actual = ~crc32_le ( 0xffffffffUL, extracted->data, extracted->len );
+	if ( actual != expected ) {
+		DBGC ( image, "GZIP %s CRC mismatch (expected %08x, got "
+		       "%08x)\n", image->name, expected, actual );
+		return -EIO;
+	}
+
 	return 0;
 }
 
@@ -110,92 +110,273 @@ static void initrd_reverse ( void *data, size_t len ) {
 }
 
 /**
- * Swap position of two adjacent initrds
+ * Check if initrd lies within reshuffle region
  *
- * @v low		Lower initrd
- * @v high		Higher initrd
+ * @v initrd		initrd image
+ * @v start		Start of reshuffle region
+ * @v end		End of reshuffle region
+ * @ret within		initrd lies within reshuffle region
  */
-static void initrd_swap ( struct image *low, struct image *high ) {
-	size_t low_len;
-	size_t high_len;
-	size_t len;
-	void *data;
+static int initrd_within ( struct image *initrd, physaddr_t start,
+			   physaddr_t end ) {
+	physaddr_t addr = virt_to_phys ( initrd->data );
 
-	DBGC ( &images, "INITRD swapping %s [%#08lx,%#08lx)<->[%#08lx,%#08lx) "
-	       "%s\n", low->name, virt_to_phys ( low->data ),
-	       ( virt_to_phys ( low->data ) + low->len ),
-	       virt_to_phys ( high->data ),
-	       ( virt_to_phys ( high->data ) + high->len ), high->name );
-
-	/* Calculate padded lengths */
-	low_len = initrd_align ( low->len );
-	high_len = initrd_align ( high->len );
-	len = ( low_len + high_len );
-	data = low->rwdata;
-	assert ( high->data == ( data + low_len ) );
-
-	/* Adjust data pointers */
-	high->data -= low_len;
-	low->data += high_len;
-	assert ( high->data == data );
-
-	/* Swap content via triple reversal */
-	initrd_reverse ( data, len );
-	initrd_reverse ( low->rwdata, low_len );
-	initrd_reverse ( high->rwdata, high_len );
+	return ( ( addr >= start ) && ( addr < end ) );
 }
 
 /**
- * Swap position of any two adjacent initrds not currently in the correct order
+ * Calculate final position of initrd
  *
+ * @v initrd		initrd image
  * @v start		Start of reshuffle region
  * @v end		End of reshuffle region
- * @ret swapped		A pair of initrds was swapped
+ * @ret addr		Final position
+ *
+ * The initrds within the reshuffle region are finally arranged in
+ * list order, packed as high as possible.
  */
-static int initrd_swap_any ( physaddr_t start, physaddr_t end ) {
-	struct image *low;
-	struct image *high;
-	const void *adjacent;
-	physaddr_t addr;
-
-	/* Find any pair of initrds that can be swapped */
-	for_each_image ( low ) {
+static physaddr_t initrd_final ( struct image *initrd, physaddr_t start,
+				 physaddr_t end ) {
+	struct image *other;
+	physaddr_t addr = end;
+
+	/* Allow space for this and all subsequent initrds */
+	list_for_each_entry_reverse ( other, &images, list ) {
+		if ( ! initrd_within ( other, start, end ) )
+			continue;
+		addr -= initrd_align ( other->len );
+		if ( other == initrd )
+			break;
+	}
+	return addr;
+}
 
-		/* Ignore images wholly outside the reshuffle region */
-		addr = virt_to_phys ( low->data );
-		if ( ( addr < start ) || ( addr >= end ) )
+/**
+ * Find initrd occupying a memory range
+ *
+ * @v initrd		initrd image to be written to this range
+ * @v addr		Start of range
+ * @v start		Start of reshuffle region
+ * @v end		End of reshuffle region
+ * @ret other		Other initrd occupying any part of the range, or NULL
+ */
+static struct image * initrd_occupant ( struct image *initrd,
+					physaddr_t addr, physaddr_t start,
+					physaddr_t end ) {
+	struct image *other;
+	physaddr_t other_addr;
+
+	/* Nothing can be overwritten by an empty initrd */
+	if ( ! initrd->len )
+		return NULL;
+
+	for_each_image ( other ) {
+		if ( ( other == initrd ) || ( ! other->len ) ||
+		     ( ! initrd_within ( other, start, end ) ) )
 			continue;
+		other_addr = virt_to_phys ( other->data );
+		if ( ( addr < ( other_addr + other->len ) ) &&
+		     ( other_addr < ( addr + initrd->len ) ) )
+			return other;
+	}
+	return NULL;
+}
+
+/**
+ * Move initrd
+ *
+ * @v initrd		initrd image
+ * @v addr		New position
+ */
+static void initrd_move ( struct image *initrd, physaddr_t addr ) {
+	void *data = phys_to_virt ( addr );
+
+	DBGC ( &images, "INITRD moving %s [%#08lx,%#08lx)->[%#08lx,%#08lx)\n",
+	       initrd->name, virt_to_phys ( initrd->data ),
+	       ( virt_to_phys ( initrd->data ) + initrd->len ),
+	       addr, ( addr + initrd->len ) );
+	memmove ( data, initrd->data, initrd->len );
+	initrd->data = data;
+}
+
+/**
+ * Move initrd out of the way into free space below the final layout
+ *
+ * @v initrd		initrd image
+ * @v start		Start of reshuffle region
+ * @v end		End of reshuffle region
+ * @v base		Start of final layout
+ * @ret rc		Return status code
+ */
+static int initrd_park ( struct image *initrd, physaddr_t start,
+			 physaddr_t end, physaddr_t base ) {
+	struct image *other;
+	physaddr_t addr = base;
+
+	/* Find the highest free space below the final layout */
+	while ( 1 ) {
+		if ( ( addr - start ) < initrd->len )
+			return -ENOSPC;
+		addr = ( ( addr - initrd->len ) & ~( INITRD_ALIGN - 1 ) );
+		if ( addr < start )
+			return -ENOSPC;
+		other = initrd_occupant ( initrd, addr, start, end );
+		if ( ! other )
+			break;
+		addr = virt_to_phys ( other->data );
+	}
+
+	/* Move initrd */
+	initrd_move ( initrd, addr );
+	return 0;
+}
+
+/**
+ * Place initrds directly into their final positions
+ *
+ * @v start		Start of reshuffle region
+ * @v end		End of reshuffle region
+ * @ret rc		Return status code
+ *
+ * Each initrd is moved straight to its final position as soon as
+ * that position is no longer occupied by any other initrd.  Where
+ * the initrds block each other in a cycle, one initrd is first moved
+ * out of the way into free space below the final layout.  No initrd
+ * is therefore moved more than twice, and most are moved at most
+ * once.
+ */
+static int initrd_place_all ( physaddr_t start, physaddr_t end ) {
+	struct image *initrd;
+	struct image *blocked;
+	physaddr_t base = end;
+	physaddr_t addr;
+	unsigned int remaining;
+	int moved;
+	int rc;
 
-		/* Calculate location of adjacent image (if any) */
-		adjacent = ( low->data + initrd_align ( low->len ) );
+	/* Calculate start of final layout */
+	for_each_image ( initrd ) {
+		if ( ! initrd_within ( initrd, start, end ) )
+			continue;
+		if ( ( base - start ) < initrd_align ( initrd->len ) )
+			return -ENOSPC;
+		base -= initrd_align ( initrd->len );
+	}
 
-		/* Search for adjacent image */
-		for_each_image ( high ) {
+	/* Move initrds until all are in their final positions */
+	do {
+		moved = 0;
+		remaining = 0;
+		blocked = NULL;
+		for_each_image ( initrd ) {
 
-			/* Ignore images wholly outside the reshuffle region */
-			addr = virt_to_phys ( high->data );
-			if ( ( addr < start ) || ( addr >= end ) )
+			/* Skip initrds already in their final position */
+			if ( ! initrd_within ( initrd, start, end ) )
+				continue;
+			addr = initrd_final ( initrd, start, end );
+			if ( virt_to_phys ( initrd->data ) == addr )
 				continue;
 
-			/* Stop search if all remaining potential
-			 * adjacent images are already in the correct
-			 * order.
-			 */
-			if ( high == low )
-				break;
-
-			/* If we have found the adjacent image, swap and exit */
-			if ( high->data == adjacent ) {
-				initrd_swap ( low, high );
-				return 1;
+			/* Move initrd if final position is unoccupied */
+			if ( ! initrd_occupant ( initrd, addr, start, end ) ) {
+				initrd_move ( initrd, addr );
+				moved = 1;
+				continue;
 			}
+
+			/* Record first blocked initrd within final layout */
+			remaining++;
+			if ( ( ! blocked ) &&
+			     ( virt_to_phys ( initrd->data ) >= base ) )
+				blocked = initrd;
+		}
+
+		/* Break any cycle by moving a blocked initrd out of the way */
+		if ( remaining && ( ! moved ) ) {
+			if ( ! blocked )
+				return -EINVAL;
+			if ( ( rc = initrd_park ( blocked, start, end,
+						  base ) ) != 0 )
+				return rc;
 		}
-	}
 
-	/* Nothing swapped */
+	} while ( remaining );
+
 	return 0;
 }
 
+/**
+ * Rotate squashed initrds into desired order
+ *
+ * @v start		Start of reshuffle region
+ * @v end		End of reshuffle region
+ *
+ * This is used only when there is insufficient free space to allow
+ * initrds to be placed directly.  The initrds must already have been
+ * squashed into a single contiguous block.  Each initrd in turn is
+ * rotated down into place via a triple reversal.
+ */
+static void initrd_rotate_all ( physaddr_t start, physaddr_t end ) {
+	struct image *initrd;
+	struct image *other;
+	void *pos = phys_to_virt ( end );
+	void *data;
+	size_t gap;
+	size_t len;
+
+	/* Find start of contiguous block */
+	for_each_image ( initrd ) {
+		if ( initrd->len && initrd_within ( initrd, start, end ) &&
+		     ( initrd->data < pos ) )
+			pos = initrd->rwdata;
+	}
+
+	/* Rotate each initrd down into place */
+	for_each_image ( initrd ) {
+
+		/* Skip initrds outside the reshuffle region */
+		if ( ! initrd_within ( initrd, start, end ) )
+			continue;
+
+		/* Empty initrds need no data movement */
+		if ( ! initrd->len ) {
+			initrd->data = pos;
+			continue;
+		}
+
+		/* Skip initrds already in place */
+		data = initrd->rwdata;
+		len = initrd_align ( initrd->len );
+		assert ( data >= pos );
+		gap = ( data - pos );
+		if ( gap ) {
+			DBGC ( &images, "INITRD rotating %s [%#08lx,%#08lx)->"
+			       "[%#08lx,%#08lx)\n", initrd->name,
+			       virt_to_phys ( data ),
+			       ( virt_to_phys ( data ) + initrd->len ),
+			       virt_to_phys ( pos ),
+			       ( virt_to_phys ( pos ) + initrd->len ) );
+
+			/* Adjust data pointers */
+			for_each_image ( other ) {
+				if ( other->len &&
+				     initrd_within ( other, start, end ) &&
+				     ( other->data >= pos ) &&
+				     ( other->data < data ) ) {
+					other->data += len;
+				}
+			}
+			initrd->data = pos;
+
+			/* Rotate content via triple reversal */
+			initrd_reverse ( pos, ( gap + len ) );
+			initrd_reverse ( pos, len );
+			initrd_reverse ( ( pos + len ), gap );
+		}
+		pos += len;
+	}
+}
+
 /**
  * Dump initrd locations (for debug)
  *
@@ -229,6 +410,7 @@ static void initrd_dump ( void ) {
 void initrd_reshuffle ( void ) {
 	physaddr_t start;
 	physaddr_t end;
+	int rc;
 
 	/* Calculate limits of reshuffle region */
 	start = uheap_limit;
@@ -237,11 +419,16 @@ void initrd_reshuffle ( void ) {
 	/* Debug */
 	initrd_dump();
 
-	/* Squash initrds as high as possible in memory */
-	initrd_squash_high ( start, end );
-
-	/* Bubble-sort initrds into desired order */
-	while ( initrd_swap_any ( start, end ) ) {}
+	/* Place initrds directly into their final positions, if
+	 * possible.  Otherwise, squash initrds as high as possible in
+	 * memory and rotate them into the desired order.
+	 */
+	if ( ( rc = initrd_place_all ( start, end ) ) != 0 ) {
+		DBGC ( &images, "INITRD could not place directly: %s\n",
+		       strerror ( rc ) );
+		initrd_squash_high ( start, end );
+		initrd_rotate_all ( start, end );
+	}
 
 	/* Debug */
 	initrd_dump();
@@ -277,7 +464,10 @@ static size_t initrd_load ( struct image *initrd, void *address ) {
 
 	/* Copy in initrd image body and construct any cpio headers */
 	if ( address ) {
-		memmove ( ( address + len ), initrd->data, initrd->len );
+		if ( ( address + len ) != initrd->data ) {
+			memmove ( ( address + len ), initrd->data,
+				  initrd->len );
+		}
 		memset ( address, 0, len );
 		offset = 0;
 		for ( i = 0 ; ( cpio_len = cpio_header ( initrd, i, &cpio ) ) ;
@@ -41,6 +41,24 @@ FILE_SECBOOT ( PERMITTED );
  * The PNG format is defined in RFC 2083.
  */
 
+/** A PNG interlace pass */
+struct png_interlace {
+	/** Pass number */
+	unsigned int pass;
+	/** X starting indent */
+	unsigned int x_indent;
+	/** Y starting indent */
+	unsigned int y_indent;
+	/** X stride */
+	unsigned int x_stride;
+	/** Y stride */
+	unsigned int y_stride;
+	/** Width */
+	unsigned int width;
+	/** Height */
+	unsigned int height;
+};
+
 /** PNG context */
 struct png_context {
 	/** Offset within image */
@@ -64,24 +82,21 @@ struct png_context {
 	struct deflate_chunk raw;
 	/** Decompressor */
 	struct deflate deflate;
-};
 
-/** A PNG interlace pass */
-struct png_interlace {
-	/** Pass number */
-	unsigned int pass;
-	/** X starting indent */
-	unsigned int x_indent;
-	/** Y starting indent */
-	unsigned int y_indent;
-	/** X stride */
-	unsigned int x_stride;
-	/** Y stride */
-	unsigned int y_stride;
-	/** Width */
-	unsigned int width;
-	/** Height */
-	unsigned int height;
+	/** Current interlace pass */
+	struct png_interlace interlace;
+	/** Current scanline within interlace pass */
+	unsigned int scanline;
+	/** Length of raw data already processed */
+	size_t processed;
+	/** Unfiltered scanline buffers */
+	uint8_t *rows;
+	/** Length of each unfiltered scanline buffer */
+	size_t row_len;
+	/** Current unfiltered scanline */
+	uint8_t *current;
+	/** Previous unfiltered scanline */
+	uint8_t *previous;
 };
 
 /** PNG file signature */
@@ -188,6 +203,32 @@ static size_t png_scanline_len ( struct png_context *png,
 		 ( ( interlace->width * png->channels * png->depth ) + 7 ) / 8);
 }
 
+/**
+ * Start PNG interlace pass
+ *
+ * @v png		PNG context
+ * @v pass		Pass number (0=first pass)
+ *
+ * Passes containing no scanlines are skipped.
+ */
+static void png_start_pass ( struct png_context *png, unsigned int pass ) {
+
+	/* Find next non-empty pass */
+	for ( ; pass < png->passes ; pass++ ) {
+		png_interlace ( png, pass, &png->interlace );
+		if ( png->interlace.width && png->interlace.height )
+			break;
+	}
+	png->interlace.pass = pass;
+	png->scanline = 0;
+
+	/* On the first scanline of a pass, above bytes are assumed to
+	 * be zero.
+	 */
+	if ( png->rows )
+		memset ( png->previous, 0, png->row_len );
+}
+
 /**
  * Handle PNG image header chunk
  *
@@ -200,6 +241,7 @@ static int png_image_header ( struct image *image, struct png_context *png,
 			      size_t len ) {
 	const struct png_image_header *ihdr;
 	struct png_interlace interlace;
+	size_t scanline_len;
 	unsigned int pass;
 
 	/* Sanity check */
@@ -268,13 +310,15 @@ static int png_image_header ( struct image *image, struct png_context *png,
 	/* Calculate number of interlace passes */
 	png->passes = png_interlace_passes[ihdr->interlace];
 
-	/* Calculate length of raw data buffer */
+	/* Calculate length of raw data buffer and longest scanline */
 	for ( pass = 0 ; pass < png->passes ; pass++ ) {
 		png_interlace ( png, pass, &interlace );
 		if ( interlace.width == 0 )
 			continue;
-		png->raw.len += ( interlace.height *
-				  png_scanline_len ( png, &interlace ) );
+		scanline_len = png_scanline_len ( png, &interlace );
+		png->raw.len += ( interlace.height * scanline_len );
+		if ( png->row_len < ( scanline_len - 1 /* Filter byte */ ) )
+			png->row_len = ( scanline_len - 1 /* Filter byte */ );
 	}
 
 	/* Allocate raw data buffer */
@@ -285,6 +329,19 @@ static int png_image_header ( struct image *image, struct png_context *png,
 		return -ENOMEM;
 	}
 
+	/* Allocate unfiltered scanline buffers */
+	png->rows = malloc ( 2 * png->row_len );
+	if ( ! png->rows ) {
+		DBGC ( image, "PNG %s could not allocate scanline buffers\n",
+		       image->name );
+		return -ENOMEM;
+	}
+	png->current = png->rows;
+	png->previous = ( png->rows + png->row_len );
+
+	/* Start first interlace pass */
+	png_start_pass ( png, 0 );
+
 	return 0;
 }
 
@@ -325,98 +382,6 @@ static int png_palette ( struct image *image, struct png_context *png,
 	return 0;
 }
 
-/**
- * Handle PNG image data chunk
- *
- * @v image		PNG image
- * @v png		PNG context
- * @v len		Chunk length
- * @ret rc		Return status code
- */
-static int png_image_data ( struct image *image, struct png_context *png,
-			    size_t len ) {
-	int rc;
-
-	/* Deflate this chunk */
-	if ( ( rc = deflate_inflate ( &png->deflate,
-				      ( image->data + png->offset ),
-				      len, &png->raw ) ) != 0 ) {
-		DBGC ( image, "PNG %s could not decompress: %s\n",
-		       image->name, strerror ( rc ) );
-		return rc;
-	}
-
-	return 0;
-}
-
-/**
- * Unfilter byte using the "None" filter
- *
- * @v current		Filtered current byte
- * @v left		Unfiltered left byte
- * @v above		Unfiltered above byte
- * @v above_left	Unfiltered above-left byte
- * @ret current		Unfiltered current byte
- */
-static unsigned int png_unfilter_none ( unsigned int current,
-					unsigned int left __unused,
-					unsigned int above __unused,
-					unsigned int above_left __unused ) {
-
-	return current;
-}
-
-/**
- * Unfilter byte using the "Sub" filter
- *
- * @v current		Filtered current byte
- * @v left		Unfiltered left byte
- * @v above		Unfiltered above byte
- * @v above_left	Unfiltered above-left byte
- * @ret current		Unfiltered current byte
- */
-static unsigned int png_unfilter_sub ( unsigned int current,
-				       unsigned int left,
-				       unsigned int above __unused,
-				       unsigned int above_left __unused ) {
-
-	return ( current + left );
-}
-
-/**
- * Unfilter byte using the "Up" filter
- *
- * @v current		Filtered current byte
- * @v left		Unfiltered left byte
- * @v above		Unfiltered above byte
- * @v above_left	Unfiltered above-left byte
- * @ret current		Unfiltered current byte
- */
-static unsigned int png_unfilter_up ( unsigned int current,
-				      unsigned int left __unused,
-				      unsigned int above,
-				      unsigned int above_left __unused ) {
-
-	return ( current + above );
-}
-
-/**
- * Unfilter byte using the "Average" filter
- *
- * @v current		Filtered current byte
- * @v left		Unfiltered left byte
- * @v above		Unfiltered above byte
- * @v above_left	Unfiltered above-left byte
- * @ret current		Unfiltered current byte
- */
-static unsigned int png_unfilter_average ( unsigned int current,
-					   unsigned int left,
-					   unsigned int above,
-					   unsigned int above_left __unused ) {
-
-	return ( current + ( ( above + left ) >> 1 ) );
-}
-
 /**
  * Paeth predictor function (defined in RFC 2083)
  *
@@ -447,158 +412,73 @@ static unsigned int png_paeth_predictor ( unsigned int a, unsigned int b,
 }
 
 /**
- * Unfilter byte using the "Paeth" filter
- *
- * @v current		Filtered current byte
- * @v above_left	Unfiltered above-left byte
- * @v above		Unfiltered above byte
- * @v left		Unfiltered left byte
- * @ret current		Unfiltered current byte
- */
-static unsigned int png_unfilter_paeth ( unsigned int current,
-					 unsigned int left,
-					 unsigned int above,
-					 unsigned int above_left ) {
-
-	return ( current + png_paeth_predictor ( left, above, above_left ) );
-}
-
-/** A PNG filter */
-struct png_filter {
-	/**
-	 * Unfilter byte
-	 *
-	 * @v current		Filtered current byte
-	 * @v left		Unfiltered left byte
-	 * @v above		Unfiltered above byte
-	 * @v above_left	Unfiltered above-left byte
-	 * @ret current		Unfiltered current byte
-	 */
-	unsigned int ( * unfilter ) ( unsigned int current,
-				      unsigned int left,
-				      unsigned int above,
-				      unsigned int above_left );
-};
-
-/** PNG filter types */
-static struct png_filter png_filters[] = {
-	[PNG_FILTER_BASIC_NONE] = { png_unfilter_none },
-	[PNG_FILTER_BASIC_SUB] = { png_unfilter_sub },
-	[PNG_FILTER_BASIC_UP] = { png_unfilter_up },
-	[PNG_FILTER_BASIC_AVERAGE] = { png_unfilter_average },
-	[PNG_FILTER_BASIC_PAETH] = { png_unfilter_paeth },
-};
-
-/**
- * Unfilter one interlace pass of PNG raw data
+ * Unfilter PNG scanline
  *
  * @v image		PNG image
  * @v png		PNG context
- * @v interlace		Interlace pass
+ * @v data		Filtered scanline (including filter byte)
+ * @v len		Scanline length (excluding filter byte)
  * @ret rc		Return status code
  *
- * This routine may assume that it is impossible to overrun the raw
- * data buffer, since the size is determined by the image dimensions.
+ * The unfiltered scanline is written to the current row buffer.  The
+ * filtered data is left untouched, since the decompressor may still
+ * need to refer back to it.
  */
-static int png_unfilter_pass ( struct image *image, struct png_context *png,
-			       struct png_interlace *interlace ) {
+static int png_unfilter_row ( struct image *image, struct png_context *png,
+			      const uint8_t *data, size_t len ) {
 	size_t pixel_len = png_pixel_len ( png );
-	size_t scanline_len = png_scanline_len ( png, interlace );
-	uint8_t *data = ( png->raw.data + png->raw.offset );
-	struct png_filter *filter;
-	unsigned int scanline;
-	unsigned int byte;
+	const uint8_t *above = png->previous;
+	uint8_t *row = png->current;
 	unsigned int filter_type;
-	unsigned int left;
-	unsigned int above;
-	unsigned int above_left;
+	size_t i;
 
-	/* On the first scanline of a pass, above bytes are assumed to
-	 * be zero.
+	/* Extract filter type */
+	filter_type = *(data++);
+	DBGC2 ( image, "PNG %s pass %d scanline %d filter type %d\n",
+		image->name, png->interlace.pass, png->scanline, filter_type );
+
+	/* Unfilter scanline.  The leftmost pixel has zero-valued left
+	 * and above-left bytes, which reduces each filter to a
+	 * simpler form.
 	 */
-	above = 0;
-
-	/* Iterate over each scanline in turn */
-	for ( scanline = 0 ; scanline < interlace->height ; scanline++ ) {
-
-		/* Extract filter byte and determine filter type */
-		filter_type = *(data++);
-		if ( filter_type >= ( sizeof ( png_filters ) /
-				      sizeof ( png_filters[0] ) ) ) {
-			DBGC ( image, "PNG %s unknown filter type %d\n",
-			       image->name, filter_type );
-			return -ENOTSUP;
+	switch ( filter_type ) {
+	case PNG_FILTER_BASIC_NONE:
+		memcpy ( row, data, len );
+		break;
+	case PNG_FILTER_BASIC_SUB:
+		memcpy ( row, data, pixel_len );
+		for ( i = pixel_len ; i < len ; i++ )
+			row[i] = ( data[i] + row[ i - pixel_len ] );
+		break;
+	case PNG_FILTER_BASIC_UP:
+		for ( i = 0 ; i < len ; i++ )
+			row[i] = ( data[i] + above[i] );
+		break;
+	case PNG_FILTER_BASIC_AVERAGE:
+		for ( i = 0 ; i < pixel_len ; i++ )
+			row[i] = ( data[i] + ( above[i] >> 1 ) );
+		for ( ; i < len ; i++ ) {
+			row[i] = ( data[i] +
+				   ( ( row[ i - pixel_len ] + above[i] ) >> 1 ) );
 		}
-		filter = &png_filters[filter_type];
-		assert ( filter->unfilter != NULL );
-		DBGC2 ( image, "PNG %s pass %d scanline %d filter type %d\n",
-			image->name, interlace->pass, scanline, filter_type );
-
-		/* At the start of a line, both above-left and left
-		 * bytes are taken to be zero.
-		 */
-		left = 0;
-		above_left = 0;
-
-		/* Iterate over each byte (not pixel) in turn */
-		for ( byte = 0 ; byte < ( scanline_len - 1 ) ; byte++ ) {
-
-			/* Extract predictor bytes, if applicable */
-			if ( byte >= pixel_len )
-				left = *( data - pixel_len );
-			if ( scanline > 0 )
-				above = *( data - scanline_len );
-			if ( ( scanline > 0 ) && ( byte >= pixel_len ) ) {
-				above_left = *( data - scanline_len -
-						pixel_len );
-			}
-
-			/* Unfilter current byte */
-			*data = filter->unfilter ( *data, left, above,
-						   above_left );
-			data++;
+		break;
+	case PNG_FILTER_BASIC_PAETH:
+		for ( i = 0 ; i < pixel_len ; i++ )
+			row[i] = ( data[i] + above[i] );
+		for ( ; i < len ; i++ ) {
+			row[i] = ( data[i] +
+				   png_paeth_predictor ( row[ i - pixel_len ],
+							 above[i],
+							 above[ i - pixel_len ]
+							 ) );
 		}
+		break;
+	default:
+		DBGC ( image, "PNG %s unknown filter type %d\n",
+		       image->name, filter_type );
+		return -ENOTSUP;
 	}
 
-	/* Update offset */
-	png->raw.offset = ( ( ( void * ) data ) - png->raw.data );
-
-	return 0;
-}
-
-/**
- * Unfilter PNG raw data
- *
- * @v image		PNG image
- * @v png		PNG context
- * @ret rc		Return status code
- *
- * This routine may assume that it is impossible to overrun the raw
- * data buffer, since the size is determined by the image dimensions.
- */
-static int png_unfilter ( struct image *image, struct png_context *png ) {
-	struct png_interlace interlace;
-	unsigned int pass;
-	int rc;
-
-	/* Process each interlace pass */
-	png->raw.offset = 0;
-	for ( pass = 0 ; pass < png->passes ; pass++ ) {
-
-		/* Calculate interlace pass parameters */
-		png_interlace ( png, pass, &interlace );
-
-		/* Skip zero-width rows (which have no filter bytes) */
-		if ( interlace.width == 0 )
-			continue;
-
-		/* Unfilter this pass */
-		if ( ( rc = png_unfilter_pass ( image, png,
-						&interlace ) ) != 0 )
-			return rc;
-	}
-	assert ( png->raw.offset == png->raw.len );
-
 	return 0;
 }
 
@@ -623,30 +503,24 @@ static inline unsigned int png_pixel ( unsigned int raw, unsigned int alpha,
 }
 
 /**
- * Fill one interlace pass of PNG pixels
+ * Fill PNG pixels from unfiltered scanline
  *
  * @v image		PNG image
  * @v png		PNG context
- * @v interlace		Interlace pass
  *
  * This routine may assume that it is impossible to overrun either the
- * raw data buffer or the pixel buffer, since the sizes of both are
+ * row buffer or the pixel buffer, since the sizes of both are
  * determined by the image dimensions.
  */
-static void png_pixels_pass ( struct image *image,
-			      struct png_context *png,
-			      struct png_interlace *interlace ) {
+static void png_pixels_row ( struct image *image, struct png_context *png ) {
+	struct png_interlace *interlace = &png->interlace;
 	uint8_t channel[png->channels];
 	int is_indexed = ( png->colour_type & PNG_COLOUR_TYPE_PALETTE );
 	int is_rgb = ( png->colour_type & PNG_COLOUR_TYPE_RGB );
 	int has_alpha = ( png->colour_type & PNG_COLOUR_TYPE_ALPHA );
-	const uint8_t *data = ( png->raw.data + png->raw.offset );
+	const uint8_t *data = png->current;
+	uint32_t *pixel_out;
 	size_t data_stride;
-	unsigned int pixbuf_y_index;
-	unsigned int pixbuf_index;
-	unsigned int pixbuf_x_stride;
-	unsigned int pixbuf_y_stride;
-	unsigned int y;
 	unsigned int x;
 	unsigned int c;
 	unsigned int bits;
@@ -658,6 +532,34 @@ static void png_pixels_pass ( struct image *image,
 	uint8_t current = 0;
 	uint32_t pixel;
 
+	/* Locate first output pixel */
+	pixel_out = &png->pixbuf->data[ ( ( interlace->y_indent +
+					    ( png->scanline *
+					      interlace->y_stride ) ) *
+					  png->pixbuf->width ) +
+					interlace->x_indent ];
+	if ( png->scanline == 0 ) {
+		DBGC2 ( image, "PNG %s pass %d %dx%d at (%d,%d) stride "
+			"(%d,%d)\n", image->name, interlace->pass,
+			interlace->width, interlace->height,
+			interlace->x_indent, interlace->y_indent,
+			interlace->x_stride, interlace->y_stride );
+	}
+
+	/* Handle the common case of opaque 8-bit truecolour directly,
+	 * since each component value is then equal to the raw value.
+	 */
+	if ( ( png->depth == 8 ) && is_rgb && ( ! is_indexed ) &&
+	     ( ! has_alpha ) ) {
+		for ( x = 0 ; x < interlace->width ; x++ ) {
+			*pixel_out = ( ( data[0] << 16 ) | ( data[1] << 8 ) |
+				       ( data[2] << 0 ) );
+			pixel_out += interlace->x_stride;
+			data += 3;
+		}
+		return;
+	}
+
 	/* We only ever use the top byte of 16-bit pixels.  Model this
 	 * as a bit depth of 8 with a stride of more than one.
 	 */
@@ -667,107 +569,133 @@ static void png_pixels_pass ( struct image *image,
 		depth = 8;
 	max = ( ( 1 << depth ) - 1 );
 
-	/* Calculate pixel buffer offset and strides */
-	pixbuf_y_index = ( ( ( interlace->y_indent * png->pixbuf->width ) +
-			      interlace->x_indent ) );
-	pixbuf_x_stride = interlace->x_stride;
-	pixbuf_y_stride = ( interlace->y_stride * png->pixbuf->width );
-	DBGC2 ( image, "PNG %s pass %d %dx%d at (%d,%d) stride (%d,%d)\n",
-		image->name, interlace->pass, interlace->width,
-		interlace->height, interlace->x_indent, interlace->y_indent,
-		interlace->x_stride, interlace->y_stride );
-
-	/* Iterate over each scanline in turn */
-	for ( y = 0 ; y < interlace->height ; y++ ) {
-
-		/* Skip filter byte */
-		data++;
-
-		/* Iterate over each pixel in turn */
-		bits = depth;
-		pixbuf_index = pixbuf_y_index;
-		for ( x = 0 ; x < interlace->width ; x++ ) {
+	/* Iterate over each pixel in turn */
+	bits = depth;
+	for ( x = 0 ; x < interlace->width ; x++ ) {
 
-			/* Extract sample value */
-			for ( c = 0 ; c < png->channels ; c++ ) {
-
-				/* Get sample value into high bits of current */
-				current <<= depth;
-				bits -= depth;
-				if ( ! bits ) {
-					current = *data;
-					data += data_stride;
-					bits = 8;
-				}
-
-				/* Extract sample value */
-				channel[c] = ( current >> ( 8 - depth ) );
+		/* Extract sample value */
+		for ( c = 0 ; c < png->channels ; c++ ) {
+
+			/* Get sample value into high bits of current */
+			current <<= depth;
+			bits -= depth;
+			if ( ! bits ) {
+				current = *data;
+				data += data_stride;
+				bits = 8;
 			}
 
-			/* Convert to native pixel format */
-			if ( is_indexed ) {
+			/* Extract sample value */
+			channel[c] = ( current >> ( 8 - depth ) );
+		}
 
-				/* Indexed */
-				pixel = png->palette[channel[0]];
+		/* Convert to native pixel format */
+		if ( is_indexed ) {
 
-			} else {
+			/* Indexed */
+			pixel = png->palette[channel[0]];
 
-				/* Determine alpha value */
-				alpha = ( has_alpha ?
-					  channel[ png->channels - 1 ] : max );
+		} else {
 
-				/* Convert to RGB value */
-				pixel = 0;
-				for ( c = 0 ; c < 3 ; c++ ) {
-					raw = channel[ is_rgb ? c : 0 ];
-					value = png_pixel ( raw, alpha, max );
-					assert ( value <= 255 );
-					pixel = ( ( pixel << 8 ) | value );
-				}
-			}
+			/* Determine alpha value */
+			alpha = ( has_alpha ?
+				  channel[ png->channels - 1 ] : max );
 
-			/* Store pixel */
-			png->pixbuf->data[pixbuf_index] = pixel;
-			pixbuf_index += pixbuf_x_stride;
+			/* Convert to RGB value */
+			pixel = 0;
+			for ( c = 0 ; c < 3 ; c++ ) {
+				raw = channel[ is_rgb ? c : 0 ];
+				value = png_pixel ( raw, alpha, max );
+				assert ( value <= 255 );
+				pixel = ( ( pixel << 8 ) | value );
+			}
 		}
 
-		/* Move to next output row */
-		pixbuf_y_index += pixbuf_y_stride;
+		/* Store pixel */
+		*pixel_out = pixel;
+		pixel_out += interlace->x_stride;
 	}
-
-	/* Update offset */
-	png->raw.offset = ( ( ( const void * ) data ) - png->raw.data );
 }
 
 /**
- * Fill PNG pixels
+ * Process all completely decompressed PNG scanlines
  *
  * @v image		PNG image
  * @v png		PNG context
+ * @ret rc		Return status code
  *
- * This routine may assume that it is impossible to overrun either the
- * raw data buffer or the pixel buffer, since the sizes of both are
- * determined by the image dimensions.
+ * Each scanline is unfiltered and converted to pixels as soon as it
+ * has been decompressed, while it is still hot in the cache.
  */
-static void png_pixels ( struct image *image, struct png_context *png ) {
-	struct png_interlace interlace;
-	unsigned int pass;
+static int png_scanlines ( struct image *image, struct png_context *png ) {
+	size_t available;
+	size_t scanline_len;
+	uint8_t *tmp;
+	int rc;
 
-	/* Process each interlace pass */
-	png->raw.offset = 0;
-	for ( pass = 0 ; pass < png->passes ; pass++ ) {
+	/* Calculate amount of decompressed data (which may exceed
+	 * the buffer length for a corrupt image).
+	 */
+	available = png->raw.offset;
+	if ( available > png->raw.len )
+		available = png->raw.len;
 
-		/* Calculate interlace pass parameters */
-		png_interlace ( png, pass, &interlace );
+	/* Process each complete scanline */
+	while ( png->interlace.pass < png->passes ) {
 
-		/* Skip zero-width rows (which have no filter bytes) */
-		if ( interlace.width == 0 )
-			continue;
+		/* Stop if scanline is not yet complete */
+		scanline_len = png_scanline_len ( png, &png->interlace );
+		if ( ( available - png->processed ) < scanline_len )
+			break;
+
+		/* Unfilter scanline */
+		if ( ( rc = png_unfilter_row ( image, png,
+					       ( png->raw.data +
+						 png->processed ),
+					       ( scanline_len - 1 ) ) ) != 0 )
+			return rc;
+		png->processed += scanline_len;
 
-		/* Unfilter this pass */
-		png_pixels_pass ( image, png, &interlace );
+		/* Fill pixels */
+		png_pixels_row ( image, png );
+
+		/* Move to next scanline */
+		tmp = png->previous;
+		png->previous = png->current;
+		png->current = tmp;
+		if ( ++png->scanline == png->interlace.height )
+			png_start_pass ( png, ( png->interlace.pass + 1 ) );
 	}
-	assert ( png->raw.offset == png->raw.len );
+
+	return 0;
+}
+
+/**
+ * Handle PNG image data chunk
+ *
+ * @v image		PNG image
+ * @v png		PNG context
+ * @v len		Chunk length
+ * @ret rc		Return status code
+ */
+static int png_image_data ( struct image *image, struct png_context *png,
+			    size_t len ) {
+	int rc;
+
+	/* Deflate this chunk */
+	if ( ( rc = deflate_inflate ( &png->deflate,
+				      ( image->data + png->offset ),
+				      len, &png->raw ) ) != 0 ) {
+		DBGC ( image, "PNG %s could not decompress: %s\n",
+		       image->name, strerror ( rc ) );
+		return rc;
+	}
+
+	/* Process any newly completed scanlines */
+	if ( ( rc = png_scanlines ( image, png ) ) != 0 )
+		return rc;
+
+	return 0;
 }
 
 /**
@@ -780,7 +708,6 @@ static void png_pixels ( struct image *image, struct png_context *png ) {
  */
 static int png_image_end ( struct image *image, struct png_context *png,
 			   size_t len ) {
-	int rc;
 
 	/* Sanity checks */
 	if ( len != 0 ) {
@@ -805,12 +732,9 @@ static int png_image_end ( struct image *image, struct png_context *png,
 		return -EINVAL;
 	}
 
-	/* Unfilter raw data */
-	if ( ( rc = png_unfilter ( image, png ) ) != 0 )
-		return rc;
-
-	/* Fill pixel buffer */
-	png_pixels ( image, png );
+	/* All scanlines have been processed as they were decompressed */
+	assert ( png->processed == png->raw.len );
+	assert ( png->interlace.pass == png->passes );
 
 	return 0;
 }
@@ -951,6 +875,7 @@ static int png_pixbuf ( struct image *image, struct pixel_buffer **pixbuf ) {
  err_chunk:
  err_truncated:
 	pixbuf_put ( png->pixbuf );
+	free ( png->rows );
 	ufree ( png->raw.data );
 	free ( png );
  err_alloc:
@@ -41,6 +41,10 @@ FILE_SECBOOT ( PERMITTED );
 #include <ipxe/parseopt.h>
 #include <ipxe/image.h>
 #include <ipxe/shell.h>
+#include <ipxe/settings.h>
+#include <ipxe/uri.h>
+#include <ipxe/http.h>
+#include <config/general.h>
 #include <usr/prompt.h>
 #include <ipxe/script.h>
 
@@ -167,6 +171,121 @@ static int terminate_on_exit_or_failure ( int rc ) {
 		 ( rc != 0 ) );
 }
 
+/**
+ * Never terminate script processing
+ *
+ * @v rc		Line processing status
+ * @ret terminate	Terminate script processing
+ */
+static int terminate_never ( int rc __unused ) {
+	return 0;
+}
+
+#ifdef SCRIPT_PREFETCH
+
+/**
+ * Pre-warm connection to an HTTP server (when HTTP is not present)
+ *
+ * @v uri		URI
+ * @ret rc		Return status code
+ */
+__weak int http_prewarm ( struct uri *uri __unused ) {
+	return -ENOTSUP;
+}
+
+/**
+ * Prefetch connection for script line
+ *
+ * @v image		Script
+ * @v offset		Offset within script
+ * @v label		Label, or NULL
+ * @v command		Command
+ * @ret rc		Return status code
+ *
+ * If the line is an image fetching command, then open a pooled
+ * connection to the server for the first absolute URI found within
+ * the (expanded) command line.  Any errors are ignored, since the
+ * command itself will report any failure when it is executed.
+ */
+static int script_prefetch_line ( struct image *image, size_t offset,
+				  const char *label __unused,
+				  const char *command ) {
+	static const char *commands[] = {
+		"chain", "imgexec", "kernel", "imgload", "initrd",
+		"imgfetch", "module",
+	};
+	struct uri *uri;
+	char *expanded;
+	char *word;
+	char *end;
+	size_t len;
+	unsigned int i;
+	int rc;
+
+	/* Identify image fetching commands */
+	len = 0;
+	while ( command[len] && ! isspace ( command[len] ) )
+		len++;
+	for ( i = 0 ; i < ( sizeof ( commands ) /
+			    sizeof ( commands[0] ) ) ; i++ ) {
+		if ( ( strlen ( commands[i] ) == len ) &&
+		     ( memcmp ( commands[i], command, len ) == 0 ) )
+			break;
+	}
+	if ( i == ( sizeof ( commands ) / sizeof ( commands[0] ) ) )
+		return 0;
+
+	/* Expand any settings that are already known */
+	expanded = expand_settings ( command + len );
+	if ( ! expanded )
+		return 0;
+
+	/* Pre-warm connection for first absolute URI */
+	for ( word = expanded ; *word ; word = end ) {
+
+		/* Extract word */
+		while ( isspace ( *word ) )
+			word++;
+		for ( end = word ; *end && ! isspace ( *end ) ; end++ ) {}
+		if ( *end )
+			*(end++) = '\0';
+
+		/* Ignore anything that is not an absolute URI */
+		if ( ! strstr ( word, "://" ) )
+			continue;
+		uri = parse_uri ( word );
+		if ( ! uri )
+			break;
+		if ( uri->host ) {
+			rc = http_prewarm ( uri );
+			DBGC ( image, "[%04zx] Prefetch %s://%s: %s\n", offset,
+			       uri->scheme, uri->host, strerror ( rc ) );
+		}
+		uri_put ( uri );
+		break;
+	}
+
+	free ( expanded );
+	return 0;
+}
+
+/**
+ * Prefetch connections for script
+ *
+ * @v image		Script
+ *
+ * Open pooled connections (including any DNS resolution and TLS
+ * handshake) to the servers referenced by image fetching commands
+ * within the script, so that connection setup proceeds in the
+ * background while earlier commands are executing.
+ */
+static void script_prefetch ( struct image *image ) {
+
+	process_script ( image, script_prefetch_line, terminate_never );
+}
+
+#endif /* SCRIPT_PREFETCH */
+
 /**
  * Execute script line
  *
@@ -203,6 +322,11 @@ static int script_exec ( struct image *image ) {
 	/* Preserve state of any currently-running script */
 	saved_offset = script_offset;
 
+#ifdef SCRIPT_PREFETCH
+	/* Prefetch connections */
+	script_prefetch ( image );
+#endif
+
 	/* Process script */
 	rc = process_script ( image, script_exec_line,
 			      terminate_on_exit_or_failure );
@@ -272,6 +396,235 @@ static struct command_descriptor goto_cmd =
  */
 static const char *goto_label;
 
+/** A script label index entry */
+struct script_label {
+	/** Label name */
+	const char *name;
+	/** Offset of labelled line within script */
+	size_t offset;
+	/** Next entry in hash chain (plus one), or zero */
+	unsigned int next;
+};
+
+/** A script label index */
+struct script_index {
+	/** Script (holding a reference) */
+	struct image *image;
+	/** Script data (used to detect changes to the image) */
+	const void *data;
+	/** Script length (used to detect changes to the image) */
+	size_t len;
+	/** Number of hash buckets (a power of two) */
+	unsigned int buckets;
+	/** Hash bucket chain heads (entry index plus one, or zero) */
+	unsigned int *heads;
+	/** Number of labels */
+	unsigned int count;
+	/** Labels */
+	struct script_label *labels;
+	/** Next free byte of label name storage */
+	char *names;
+};
+
+/** Label index for the most recently used script */
+static struct script_index *script_index;
+
+/**
+ * Index under construction
+ *
+ * Valid only during script_index_build().  Consider this part of a
+ * closure.  While counting labels, this is a zeroed template used
+ * only to accumulate the label count and name storage length.
+ */
+static struct script_index *script_indexing;
+
+/** Total length of label name storage required */
+static size_t script_indexing_len;
+
+/**
+ * Calculate label hash
+ *
+ * @v label		Label
+ * @ret hash		Hash value
+ */
+static unsigned int script_label_hash ( const char *label ) {
+	unsigned int hash = 0;
+
+	while ( *label )
+		hash = ( ( hash * 31 ) + *(label++) );
+	return hash;
+}
+
+/**
+ * Find label in index
+ *
+ * @v index		Label index
+ * @v label		Label
+ * @ret entry		Label index entry, or NULL if not found
+ */
+static struct script_label * script_index_find ( struct script_index *index,
+						 const char *label ) {
+	struct script_label *entry;
+	unsigned int hash = script_label_hash ( label );
+	unsigned int i;
+
+	for ( i = index->heads[ hash & ( index->buckets - 1 ) ] ; i ;
+	      i = entry->next ) {
+		entry = &index->labels[ i - 1 ];
+		if ( strcmp ( entry->name, label ) == 0 )
+			return entry;
+	}
+	return NULL;
+}
+
+/**
+ * Record label in index under construction
+ *
+ * @v image		Script
+ * @v offset		Offset within script
+ * @v label		Label, or NULL
+ * @v command		Command
+ * @ret rc		Return status code
+ */
+static int script_index_line ( struct image *image __unused, size_t offset,
+			       const char *label,
+			       const char *command __unused ) {
+	struct script_index *index = script_indexing;
+	struct script_label *entry;
+	unsigned int *head;
+	size_t len;
+
+	/* Ignore unlabelled lines */
+	if ( ! label )
+		return 0;
+	len = ( strlen ( label ) + 1 /* NUL */ );
+
+	/* Count labels, if not yet allocated */
+	if ( ! index->labels ) {
+		index->count++;
+		script_indexing_len += len;
+		return 0;
+	}
+
+	/* Ignore duplicate labels, since only the first is reachable */
+	if ( script_index_find ( index, label ) )
+		return 0;
+
+	/* Add label */
+	entry = &index->labels[ index->count++ ];
+	memcpy ( index->names, label, len );
+	entry->name = index->names;
+	index->names += len;
+	entry->offset = offset;
+	head = &index->heads[ script_label_hash ( label ) &
+			      ( index->buckets - 1 ) ];
+	entry->next = *head;
+	*head = index->count;
+
+	return 0;
+}
+
+/**
+ * Build label index for script
+ *
+ * @v image		Script
+ * @ret index		Label index, or NULL on error
+ */
+static struct script_index * script_index_build ( struct image *image ) {
+	struct script_index count;
+	struct script_index *index;
+	unsigned int buckets;
+	size_t saved_offset;
+	void *data;
+	int rc;
+
+	/* Preserve state of currently-running script */
+	saved_offset = script_offset;
+
+	/* Count labels and required name storage */
+	memset ( &count, 0, sizeof ( count ) );
+	script_indexing = &count;
+	script_indexing_len = 0;
+	if ( ( rc = process_script ( image, script_index_line,
+				     terminate_never ) ) != 0 )
+		goto err_count;
+
+	/* Allocate index */
+	for ( buckets = 1 ; buckets < count.count ; buckets <<= 1 ) {}
+	index = zalloc ( sizeof ( *index ) +
+			 ( buckets * sizeof ( index->heads[0] ) ) +
+			 ( count.count * sizeof ( index->labels[0] ) ) +
+			 script_indexing_len );
+	if ( ! index ) {
+		rc = -ENOMEM;
+		goto err_alloc;
+	}
+	data = ( ( ( void * ) index ) + sizeof ( *index ) );
+	index->labels = data;
+	data += ( count.count * sizeof ( index->labels[0] ) );
+	index->heads = data;
+	data += ( buckets * sizeof ( index->heads[0] ) );
+	index->names = data;
+	index->buckets = buckets;
+	index->data = image->data;
+	index->len = image->len;
+
+	/* Record labels */
+	script_indexing = index;
+	if ( ( rc = process_script ( image, script_index_line,
+				     terminate_never ) ) != 0 )
+		goto err_record;
+	DBGC ( image, "[%04zx] Indexed %d labels\n",
+	       saved_offset, index->count );
+
+	/* Hold a reference to the script, so that the image (and
+	 * hence its data) cannot be freed and reallocated at the same
+	 * address while the index remains in use.
+	 */
+	index->image = image_get ( image );
+
+	script_offset = saved_offset;
+	return index;
+
+ err_record:
+	free ( index );
+ err_alloc:
+ err_count:
+	script_offset = saved_offset;
+	DBGC ( image, "[%04zx] Could not index labels: %s\n",
+	       saved_offset, strerror ( rc ) );
+	return NULL;
+}
+
+/**
+ * Get label index for script
+ *
+ * @v image		Script
+ * @ret index		Label index, or NULL on error
+ *
+ * The index for the most recently used script is retained, and is
+ * rebuilt if the script image has since been modified.
+ */
+static struct script_index * script_index_get ( struct image *image ) {
+
+	/* Use existing index, if still valid */
+	if ( script_index && ( script_index->image == image ) &&
+	     ( script_index->data == image->data ) &&
+	     ( script_index->len == image->len ) ) {
+		return script_index;
+	}
+
+	/* Discard any existing index */
+	if ( script_index ) {
+		image_put ( script_index->image );
+		free ( script_index );
+	}
+
+	/* Build new index */
+	script_index = script_index_build ( image );
+	return script_index;
+}
+
 /**
  * Check for presence of label
  *
@@ -318,6 +671,8 @@ static int terminate_on_label_found ( int rc ) {
  */
 static int goto_exec ( int argc, char **argv ) {
 	struct image *image = current_image.image;
+	struct script_index *index;
+	struct script_label *entry;
 	struct goto_options opts;
 	size_t saved_offset;
 	int rc;
@@ -336,7 +691,22 @@ static int goto_exec ( int argc, char **argv ) {
 	/* Parse label */
 	goto_label = argv[optind];
 
-	/* Find label */
+	/* Find label via index, if available */
+	if ( ( index = script_index_get ( image ) ) ) {
+		entry = script_index_find ( index, goto_label );
+		if ( ! entry ) {
+			DBGC ( image, "[%04zx] No such label :%s\n",
+			       script_offset, goto_label );
+			return -ENOENT;
+		}
+		script_offset = entry->offset;
+		DBGC ( image, "[%04zx] Gone to :%s\n",
+		       script_offset, goto_label );
+		shell_stop ( SHELL_STOP_COMMAND );
+		return 0;
+	}
+
+	/* Otherwise, find label by scanning script */
 	saved_offset = script_offset;
 	if ( ( rc = process_script ( image, goto_find_label,
 				     terminate_on_label_found ) ) != 0 ) {
@@ -0,0 +1,702 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+FILE_SECBOOT ( PERMITTED );
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <assert.h>
+#include <byteswap.h>
+#include <ipxe/crc32.h>
+#include <ipxe/crypto.h>
+#include <ipxe/sha256.h>
+#include <ipxe/lzma.h>
+#include <ipxe/image.h>
+#include <ipxe/xz.h>
+
+/** @file
+ *
+ * xz compressed images
+ *
+ * Only the LZMA2 filter is supported.  Check types other than
+ * CRC-32, CRC-64 and SHA-256 are ignored, as permitted by the xz
+ * file format specification.
+ *
+ */
+
+/** An xz index summary */
+struct xz_summary {
+	/** Number of blocks */
+	uint64_t count;
+	/** Total length of blocks (including block padding) */
+	uint64_t blocks;
+	/** Total uncompressed length */
+	uint64_t uncompressed;
+};
+
+/** CRC-64 lookup table */
+static uint64_t xz_crc64_table[256];
+
+/**
+ * Calculate CRC-64
+ *
+ * @v data		Data
+ * @v len		Length of data
+ * @ret crc		CRC-64
+ */
+static uint64_t xz_crc64 ( const void *data, size_t len ) {
+	const uint8_t *bytes = data;
+	uint64_t crc;
+	unsigned int i;
+	unsigned int j;
+
+	/* Construct lookup table, if not already done */
+	if ( ! xz_crc64_table[1] ) {
+		for ( i = 0 ; i < 256 ; i++ ) {
+			crc = i;
+			for ( j = 0 ; j < 8 ; j++ ) {
+				crc = ( ( crc >> 1 ) ^
+					( ( crc & 1 ) ? XZ_CRC64_POLY : 0 ) );
+			}
+			xz_crc64_table[i] = crc;
+		}
+	}
+
+	/* Calculate CRC */
+	crc = ~0ULL;
+	while ( len-- ) {
+		crc = ( xz_crc64_table[ ( crc ^ *(bytes++) ) & 0xff ] ^
+			( crc >> 8 ) );
+	}
+	return ~crc;
+}
+
+/**
+ * Calculate CRC-32
+ *
+ * @v data		Data
+ * @v len		Length of data
+ * @ret crc		CRC-32
+ */
+static inline uint32_t xz_crc32 ( const void *data, size_t len ) {
+
+	return ~crc32_le ( 0xffffffffUL, data, len );
+}
+
+/**
+ * Read unaligned little-endian 32-bit value
+ *
+ * @v data		Data
+ * @ret value		Value
+ */
+static inline uint32_t xz_le32 ( const void *data ) {
+	uint32_t value;
+
+	memcpy ( &value, data, sizeof ( value ) );
+	return le32_to_cpu ( value );
+}
+
+/**
+ * Parse variable-length integer
+ *
+ * @v data		Data pointer to update
+ * @v end		End of data
+ * @v value		Value to fill in
+ * @ret rc		Return status code
+ */
+static int xz_vli ( const uint8_t **data, const uint8_t *end,
+		    uint64_t *value ) {
+	const uint8_t *bytes = *data;
+	unsigned int byte;
+	unsigned int i;
+
+	*value = 0;
+	for ( i = 0 ; i < XZ_VLI_MAX_LEN ; i++ ) {
+		if ( ( bytes + i ) >= end )
+			return -EINVAL;
+		byte = bytes[i];
+		*value |= ( ( ( uint64_t ) ( byte & 0x7f ) ) << ( 7 * i ) );
+		if ( ! ( byte & 0x80 ) ) {
+			/* Reject non-minimal encodings */
+			if ( ( byte == 0 ) && ( i != 0 ) )
+				return -EINVAL;
+			*data = ( bytes + i + 1 );
+			return 0;
+		}
+	}
+	return -EINVAL;
+}
+
+/**
+ * Get length of check field
+ *
+ * @v check		Check type
+ * @ret len		Length of check field
+ */
+static inline size_t xz_check_len ( unsigned int check ) {
+
+	return ( check ? ( 4 << ( ( check - 1 ) / 3 ) ) : 0 );
+}
+
+/**
+ * Verify check field
+ *
+ * @v image		Image
+ * @v check		Check type
+ * @v data		Uncompressed data
+ * @v len		Length of uncompressed data
+ * @v expected		Expected check field
+ * @ret rc		Return status code
+ */
+static int xz_verify ( struct image *image, unsigned int check,
+		       const void *data, size_t len, const void *expected ) {
+	struct digest_algorithm *digest = &sha256_algorithm;
+	uint8_t ctx[SHA256_CTX_SIZE];
+	uint8_t out[SHA256_DIGEST_SIZE];
+	union {
+		uint32_t crc32;
+		uint64_t crc64;
+	} actual;
+
+	switch ( check ) {
+	case XZ_CHECK_NONE:
+		return 0;
+	case XZ_CHECK_CRC32:
+		actual.crc32 = cpu_to_le32 ( xz_crc32 ( data, len ) );
+		if ( memcmp ( &actual.crc32, expected,
+			      sizeof ( actual.crc32 ) ) != 0 )
+			break;
+		return 0;
+	case XZ_CHECK_CRC64:
+		actual.crc64 = cpu_to_le64 ( xz_crc64 ( data, len ) );
+		if ( memcmp ( &actual.crc64, expected,
+			      sizeof ( actual.crc64 ) ) != 0 )
+			break;
+		return 0;
+	case XZ_CHECK_SHA256:
+		digest_init ( digest, ctx );
+		digest_update ( digest, ctx, data, len );
+		digest_final ( digest, ctx, out );
+		if ( memcmp ( out, expected, sizeof ( out ) ) != 0 )
+			break;
+		return 0;
+	default:
+		DBGC ( image, "XZ %s ignoring unsupported check type %d\n",
+		       image->name, check );
+		return 0;
+	}
+
+	DBGC ( image, "XZ %s check mismatch\n", image->name );
+	return -EIO;
+}
+
+/**
+ * Parse index
+ *
+ * @v image		Image
+ * @v data		Index
+ * @v len		Maximum length of index
+ * @v summary		Index summary to fill in
+ * @ret len		Length of index, or negative error
+ */
+static int xz_index ( struct image *image, const uint8_t *data, size_t len,
+		      struct xz_summary *summary ) {
+	const uint8_t *bytes = data;
+	const uint8_t *end = ( data + len );
+	uint64_t unpadded;
+	uint64_t uncompressed;
+	uint64_t count;
+	int rc;
+
+	/* Parse index indicator and number of records */
+	memset ( summary, 0, sizeof ( *summary ) );
+	if ( ( bytes >= end ) || ( *(bytes++) != XZ_INDEX_INDICATOR ) )
+		return -EINVAL;
+	if ( ( rc = xz_vli ( &bytes, end, &count ) ) != 0 )
+		return rc;
+
+	/* Parse records */
+	for ( ; summary->count < count ; summary->count++ ) {
+		if ( ( rc = xz_vli ( &bytes, end, &unpadded ) ) != 0 )
+			return rc;
+		if ( ( rc = xz_vli ( &bytes, end, &uncompressed ) ) != 0 )
+			return rc;
+		if ( ! unpadded )
+			return -EINVAL;
+		summary->blocks += ( ( unpadded + XZ_ALIGN - 1 ) &
+				     ~( ( uint64_t ) ( XZ_ALIGN - 1 ) ) );
+		summary->uncompressed += uncompressed;
+	}
+
+	/* Parse index padding */
+	while ( ( bytes - data ) % XZ_ALIGN ) {
+		if ( ( bytes >= end ) || ( *(bytes++) != 0 ) )
+			return -EINVAL;
+	}
+
+	/* Verify CRC */
+	if ( ( end - bytes ) < ( int ) sizeof ( uint32_t ) )
+		return -EINVAL;
+	if ( xz_crc32 ( data, ( bytes - data ) ) != xz_le32 ( bytes ) ) {
+		DBGC ( image, "XZ %s index CRC mismatch\n", image->name );
+		return -EINVAL;
+	}
+	bytes += sizeof ( uint32_t );
+
+	return ( bytes - data );
+}
+
+/**
+ * Verify stream header
+ *
+ * @v image		Image
+ * @v header		Stream header
+ * @ret rc		Return status code
+ */
+static int xz_header ( struct image *image, const struct xz_header *header ) {
+
+	/* Check magic ID */
+	if ( memcmp ( header->magic, XZ_HEADER_MAGIC,
+		      sizeof ( header->magic ) ) != 0 ) {
+		DBGC ( image, "XZ %s invalid header magic\n", image->name );
+		return -EINVAL;
+	}
+
+	/* Verify CRC */
+	if ( xz_crc32 ( header->flags, sizeof ( header->flags ) ) !=
+	     le32_to_cpu ( header->crc ) ) {
+		DBGC ( image, "XZ %s header CRC mismatch\n", image->name );
+		return -EINVAL;
+	}
+
+	/* Check flags */
+	if ( XZ_FLAGS_RESERVED ( header->flags ) ) {
+		DBGC ( image, "XZ %s unsupported stream flags %02x%02x\n",
+		       image->name, header->flags[0], header->flags[1] );
+		return -ENOTSUP;
+	}
+
+	return 0;
+}
+
+/**
+ * Verify stream footer
+ *
+ * @v image		Image
+ * @v footer		Stream footer
+ * @ret rc		Return status code
+ */
+static int xz_footer ( struct image *image, const struct xz_footer *footer ) {
+
+	/* Check magic ID */
+	if ( memcmp ( footer->magic, XZ_FOOTER_MAGIC,
+		      sizeof ( footer->magic ) ) != 0 ) {
+		DBGC ( image, "XZ %s invalid footer magic\n", image->name );
+		return -EINVAL;
+	}
+
+	/* Verify CRC */
+	if ( xz_crc32 ( &footer->backward,
+			( sizeof ( footer->backward ) +
+			  sizeof ( footer->flags ) ) ) !=
+	     le32_to_cpu ( footer->crc ) ) {
+		DBGC ( image, "XZ %s footer CRC mismatch\n", image->name );
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+/**
+ * Calculate total uncompressed length
+ *
+ * @v image		Image
+ * @v len		Total uncompressed length to fill in
+ * @ret rc		Return status code
+ *
+ * The total uncompressed length is obtained from the index of each
+ * stream, working backwards from the end of the image.
+ */
+static int xz_length ( struct image *image, size_t *len ) {
+	const uint8_t *data = image->data;
+	const struct xz_header *header;
+	const struct xz_footer *footer;
+	const uint8_t *index;
+	struct xz_summary summary;
+	uint64_t stream_len;
+	uint64_t total = 0;
+	size_t index_len;
+	size_t pos;
+	int rc;
+
+	/* Process each stream in turn, working backwards */
+	for ( pos = image->len ; pos ; pos -= stream_len ) {
+
+		/* Skip stream padding */
+		if ( pos % XZ_ALIGN )
+			return -EINVAL;
+		while ( ( pos >= XZ_ALIGN ) &&
+			( xz_le32 ( data + pos - XZ_ALIGN ) == 0 ) ) {
+			pos -= XZ_ALIGN;
+		}
+
+		/* Verify stream footer */
+		if ( pos < ( sizeof ( *header ) + sizeof ( *footer ) ) )
+			return -EINVAL;
+		footer = ( ( const void * )
+			   ( data + pos - sizeof ( *footer ) ) );
+		if ( ( rc = xz_footer ( image, footer ) ) != 0 )
+			return rc;
+
+		/* Parse index */
+		index_len = ( ( le32_to_cpu ( footer->backward ) + 1 ) *
+			      XZ_ALIGN );
+		if ( index_len > ( pos - sizeof ( *header ) -
+				   sizeof ( *footer ) ) ) {
+			return -EINVAL;
+		}
+		index = ( ( ( const uint8_t * ) footer ) - index_len );
+		if ( ( rc = xz_index ( image, index, index_len,
+				       &summary ) ) < 0 )
+			return rc;
+		if ( ( ( size_t ) rc ) != index_len )
+			return -EINVAL;
+
+		/* Locate and verify stream header */
+		stream_len = ( sizeof ( *header ) + summary.blocks +
+			       index_len + sizeof ( *footer ) );
+		if ( stream_len > pos )
+			return -EINVAL;
+		header = ( ( const void * ) ( data + pos - stream_len ) );
+		if ( ( rc = xz_header ( image, header ) ) != 0 )
+			return rc;
+		if ( memcmp ( header->flags, footer->flags,
+			      sizeof ( header->flags ) ) != 0 ) {
+			DBGC ( image, "XZ %s mismatched stream flags\n",
+			       image->name );
+			return -EINVAL;
+		}
+
+		/* Accumulate uncompressed length */
+		total += summary.uncompressed;
+	}
+
+	/* Check that length is representable */
+	*len = total;
+	if ( *len != total )
+		return -ERANGE;
+
+	return 0;
+}
+
+/**
+ * Decompress block
+ *
+ * @v image		Image
+ * @v lzma		Decompressor
+ * @v check		Check type
+ * @v stream		Start of stream
+ * @v data		Data pointer to update
+ * @v end		End of data
+ * @v summary		Index summary to update
+ * @ret rc		Return status code
+ */
+static int xz_block ( struct image *image, struct lzma *lzma,
+		      unsigned int check, const uint8_t *stream,
+		      const uint8_t **data, const uint8_t *end,
+		      struct xz_summary *summary ) {
+	const uint8_t *bytes = *data;
+	const uint8_t *header_end;
+	uint64_t compressed = 0;
+	uint64_t uncompressed = 0;
+	uint64_t filter;
+	uint64_t props_len;
+	size_t header_len;
+	size_t check_len;
+	size_t start;
+	size_t produced;
+	size_t used;
+	unsigned int flags;
+	int rc;
+
+	/* Verify block header */
+	header_len = ( ( bytes[0] + 1 ) * XZ_ALIGN );
+	if ( header_len > ( size_t ) ( end - bytes ) )
+		return -EINVAL;
+	header_end = ( bytes + header_len - sizeof ( uint32_t ) );
+	if ( xz_crc32 ( bytes, ( header_end - bytes ) ) !=
+	     xz_le32 ( header_end ) ) {
+		DBGC ( image, "XZ %s block header CRC mismatch\n",
+		       image->name );
+		return -EINVAL;
+	}
+
+	/* Parse block flags and sizes */
+	flags = bytes[1];
+	bytes += 2;
+	if ( flags & XZ_BLOCK_RESERVED )
+		return -ENOTSUP;
+	if ( XZ_BLOCK_FILTERS ( flags ) != 1 ) {
+		DBGC ( image, "XZ %s unsupported filter chain\n",
+		       image->name );
+		return -ENOTSUP;
+	}
+	if ( ( flags & XZ_BLOCK_COMPRESSED ) &&
+	     ( ( rc = xz_vli ( &bytes, header_end, &compressed ) ) != 0 ) )
+		return rc;
+	if ( ( flags & XZ_BLOCK_UNCOMPRESSED ) &&
+	     ( ( rc = xz_vli ( &bytes, header_end, &uncompressed ) ) != 0 ) )
+		return rc;
+
+	/* Parse filter flags */
+	if ( ( rc = xz_vli ( &bytes, header_end, &filter ) ) != 0 )
+		return rc;
+	if ( ( rc = xz_vli ( &bytes, header_end, &props_len ) ) != 0 )
+		return rc;
+	if ( filter != XZ_FILTER_LZMA2 ) {
+		DBGC ( image, "XZ %s unsupported filter %#llx\n",
+		       image->name, ( ( unsigned long long ) filter ) );
+		return -ENOTSUP;
+	}
+	if ( ( props_len != 1 ) || ( bytes >= header_end ) ||
+	     ( *(bytes++) > XZ_LZMA2_DICT_MAX ) ) {
+		return -EINVAL;
+	}
+
+	/* Check header padding */
+	while ( bytes < header_end ) {
+		if ( *(bytes++) != 0 )
+			return -EINVAL;
+	}
+	bytes += sizeof ( uint32_t );
+
+	/* Decompress data */
+	start = lzma->offset;
+	if ( ( rc = lzma2_decompress ( lzma, bytes, ( end - bytes ),
+				       &used ) ) != 0 ) {
+		DBGC ( image, "XZ %s could not decompress: %s\n",
+		       image->name, strerror ( rc ) );
+		return rc;
+	}
+	produced = ( lzma->offset - start );
+	if ( ( flags & XZ_BLOCK_COMPRESSED ) && ( used != compressed ) )
+		return -EINVAL;
+	if ( ( flags & XZ_BLOCK_UNCOMPRESSED ) &&
+	     ( produced != uncompressed ) ) {
+		return -EINVAL;
+	}
+	bytes += used;
+
+	/* Skip block padding */
+	while ( ( bytes - stream ) % XZ_ALIGN ) {
+		if ( ( bytes >= end ) || ( *(bytes++) != 0 ) )
+			return -EINVAL;
+	}
+
+	/* Verify check field */
+	check_len = xz_check_len ( check );
+	if ( check_len > ( size_t ) ( end - bytes ) )
+		return -EINVAL;
+	if ( ( rc = xz_verify ( image, check, ( lzma->out + start ),
+				produced, bytes ) ) != 0 )
+		return rc;
+	bytes += check_len;
+
+	/* Update summary */
+	summary->count++;
+	summary->blocks += ( bytes - *data );
+	summary->uncompressed += produced;
+	*data = bytes;
+
+	return 0;
+}
+
+/**
+ * Decompress stream
+ *
+ * @v image		Image
+ * @v lzma		Decompressor
+ * @v data		Data pointer to update
+ * @v end		End of data
+ * @ret rc		Return status code
+ */
+static int xz_stream ( struct image *image, struct lzma *lzma,
+		       const uint8_t **data, const uint8_t *end ) {
+	const uint8_t *stream = *data;
+	const uint8_t *bytes = stream;
+	const struct xz_header *header;
+	const struct xz_footer *footer;
+	struct xz_summary blocks;
+	struct xz_summary index;
+	unsigned int check;
+	size_t index_len;
+	int rc;
+
+	/* Verify stream header */
+	header = ( ( const void * ) bytes );
+	if ( ( size_t ) ( end - bytes ) < sizeof ( *header ) )
+		return -EINVAL;
+	if ( ( rc = xz_header ( image, header ) ) != 0 )
+		return rc;
+	check = XZ_CHECK ( header->flags );
+	bytes += sizeof ( *header );
+
+	/* Decompress blocks */
+	memset ( &blocks, 0, sizeof ( blocks ) );
+	while ( 1 ) {
+		if ( bytes >= end )
+			return -EINVAL;
+		if ( *bytes == XZ_INDEX_INDICATOR )
+			break;
+		if ( ( rc = xz_block ( image, lzma, check, stream, &bytes,
+				       end, &blocks ) ) != 0 )
+			return rc;
+	}
+
+	/* Parse index and check that it matches the blocks */
+	if ( ( rc = xz_index ( image, bytes, ( end - bytes ),
+			       &index ) ) < 0 )
+		return rc;
+	index_len = rc;
+	if ( memcmp ( &index, &blocks, sizeof ( index ) ) != 0 ) {
+		DBGC ( image, "XZ %s index does not match blocks\n",
+		       image->name );
+		return -EINVAL;
+	}
+	bytes += index_len;
+
+	/* Verify stream footer */
+	footer = ( ( const void * ) bytes );
+	if ( ( size_t ) ( end - bytes ) < sizeof ( *footer ) )
+		return -EINVAL;
+	if ( ( rc = xz_footer ( image, footer ) ) != 0 )
+		return rc;
+	if ( ( ( ( le32_to_cpu ( footer->backward ) + 1 ) * XZ_ALIGN ) !=
+	       index_len ) ||
+	     ( memcmp ( footer->flags, header->flags,
+			sizeof ( footer->flags ) ) != 0 ) ) {
+		return -EINVAL;
+	}
+	bytes += sizeof ( *footer );
+
+	/* Skip stream padding */
+	while ( ( ( end - bytes ) >= XZ_ALIGN ) && ( xz_le32 ( bytes ) == 0 ) )
+		bytes += XZ_ALIGN;
+
+	*data = bytes;
+	return 0;
+}
+
+/**
+ * Extract xz image
+ *
+ * @v image		Image
+ * @v extracted		Extracted image
+ * @ret rc		Return status code
+ */
+static int xz_extract ( struct image *image, struct image *extracted ) {
+	const uint8_t *data = image->data;
+	const uint8_t *end = ( data + image->len );
+	struct lzma *lzma;
+	size_t len;
+	int rc;
+
+	/* Calculate uncompressed length */
+	if ( ( rc = xz_length ( image, &len ) ) != 0 ) {
+		DBGC ( image, "XZ %s invalid index: %s\n",
+		       image->name, strerror ( rc ) );
+		goto err_length;
+	}
+
+	/* Presize extracted image */
+	if ( ( rc = image_set_len ( extracted, len ) ) != 0 ) {
+		DBGC ( image, "XZ %s could not presize: %s\n",
+		       image->name, strerror ( rc ) );
+		goto err_set_len;
+	}
+
+	/* Allocate and initialise decompressor */
+	lzma = zalloc ( sizeof ( *lzma ) );
+	if ( ! lzma ) {
+		rc = -ENOMEM;
+		goto err_alloc;
+	}
+	lzma_init ( lzma, extracted->rwdata, extracted->len );
+
+	/* Decompress each stream in turn */
+	while ( data < end ) {
+		if ( ( rc = xz_stream ( image, lzma, &data, end ) ) != 0 ) {
+			DBGC ( image, "XZ %s invalid stream: %s\n",
+			       image->name, strerror ( rc ) );
+			goto err_stream;
+		}
+	}
+	assert ( lzma->offset == extracted->len );
+
+	/* Success */
+	rc = 0;
+
+ err_stream:
+	free ( lzma );
+ err_alloc:
+ err_set_len:
+ err_length:
+	return rc;
+}
+
+/**
+ * Probe xz image
+ *
+ * @v image		xz image
+ * @ret rc		Return status code
+ */
+static int xz_probe ( struct image *image ) {
+	const struct xz_header *header;
+
+	/* Sanity check */
+	if ( image->len < ( sizeof ( *header ) +
+			    sizeof ( struct xz_footer ) ) ) {
+		DBGC ( image, "XZ %s image too short\n", image->name );
+		return -ENOEXEC;
+	}
+	header = image->data;
+
+	/* Check magic header */
+	if ( memcmp ( header->magic, XZ_HEADER_MAGIC,
+		      sizeof ( header->magic ) ) != 0 ) {
+		DBGC ( image, "XZ %s invalid magic\n", image->name );
+		return -ENOEXEC;
+	}
+
+	return 0;
+}
+
+/** xz image type */
+struct image_type xz_image_type __image_type ( PROBE_NORMAL ) = {
+	.name = "xz",
+	.probe = xz_probe,
+	.extract = xz_extract,
+	.exec = image_extract_exec,
+};
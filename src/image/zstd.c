@@ -0,0 +1,1486 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+FILE_SECBOOT ( PERMITTED );
+
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <errno.h>
+#include <assert.h>
+#include <byteswap.h>
+#include <ipxe/rotate.h>
+#include <ipxe/image.h>
+#include <ipxe/zstd.h>
+
+/** @file
+ *
+ * Zstandard compressed images
+ *
+ * Zstandard is defined in RFC 8878.  Dictionaries are not supported.
+ *
+ */
+
+/** A literals length or match length code */
+struct zstd_code {
+	/** Baseline value */
+	uint32_t base;
+	/** Number of extra bits */
+	uint8_t bits;
+};
+
+/** Literals length codes */
+static const struct zstd_code zstd_ll_codes[ ZSTD_LL_MAX + 1 ] = {
+	{ 0, 0 }, { 1, 0 }, { 2, 0 }, { 3, 0 }, { 4, 0 }, { 5, 0 },
+	{ 6, 0 }, { 7, 0 }, { 8, 0 }, { 9, 0 }, { 10, 0 }, { 11, 0 },
+	{ 12, 0 }, { 13, 0 }, { 14, 0 }, { 15, 0 }, { 16, 1 }, { 18, 1 },
+	{ 20, 1 }, { 22, 1 }, { 24, 2 }, { 28, 2 }, { 32, 3 }, { 40, 3 },
+	{ 48, 4 }, { 64, 6 }, { 128, 7 }, { 256, 8 }, { 512, 9 },
+	{ 1024, 10 }, { 2048, 11 }, { 4096, 12 }, { 8192, 13 },
+	{ 16384, 14 }, { 32768, 15 }, { 65536, 16 },
+};
+
+/** Match length codes */
+static const struct zstd_code zstd_ml_codes[ ZSTD_ML_MAX + 1 ] = {
+	{ 3, 0 }, { 4, 0 }, { 5, 0 }, { 6, 0 }, { 7, 0 }, { 8, 0 },
+	{ 9, 0 }, { 10, 0 }, { 11, 0 }, { 12, 0 }, { 13, 0 }, { 14, 0 },
+	{ 15, 0 }, { 16, 0 }, { 17, 0 }, { 18, 0 }, { 19, 0 }, { 20, 0 },
+	{ 21, 0 }, { 22, 0 }, { 23, 0 }, { 24, 0 }, { 25, 0 }, { 26, 0 },
+	{ 27, 0 }, { 28, 0 }, { 29, 0 }, { 30, 0 }, { 31, 0 }, { 32, 0 },
+	{ 33, 0 }, { 34, 0 }, { 35, 1 }, { 37, 1 }, { 39, 1 }, { 41, 1 },
+	{ 43, 2 }, { 47, 2 }, { 51, 3 }, { 59, 3 }, { 67, 4 }, { 83, 4 },
+	{ 99, 5 }, { 131, 7 }, { 259, 8 }, { 515, 9 }, { 1027, 10 },
+	{ 2051, 11 }, { 4099, 12 }, { 8195, 13 }, { 16387, 14 },
+	{ 32771, 15 }, { 65539, 16 },
+};
+
+/** Predefined literals length distribution */
+static const int8_t zstd_ll_predefined[] = {
+	4, 3, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 1, 1, 1, 2, 2, 2, 2,
+	2, 2, 2, 2, 2, 3, 2, 1, 1, 1, 1, 1, -1, -1, -1, -1,
+};
+
+/** Predefined match length distribution */
+static const int8_t zstd_ml_predefined[] = {
+	1, 4, 3, 2, 2, 2, 2, 2, 2, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+	1, 1, 1, 1, 1, 1, -1, -1, -1, -1, -1, -1, -1,
+};
+
+/** Predefined offset distribution */
+static const int8_t zstd_of_predefined[] = {
+	1, 1, 1, 1, 1, 1, 2, 2, 2, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+	1, 1, 1, 1, -1, -1, -1, -1, -1,
+};
+
+/** A sequence symbol type */
+struct zstd_fse_type {
+	/** Name */
+	const char *name;
+	/** Predefined distribution */
+	const int8_t *predefined;
+	/** Number of symbols in predefined distribution */
+	uint8_t count;
+	/** Accuracy log of predefined distribution */
+	uint8_t log;
+	/** Maximum symbol value */
+	uint8_t max;
+	/** Maximum accuracy log */
+	uint8_t max_log;
+};
+
+/** Literals length symbol type */
+static const struct zstd_fse_type zstd_ll_type = {
+	.name = "literals length",
+	.predefined = zstd_ll_predefined,
+	.count = ( sizeof ( zstd_ll_predefined ) /
+		   sizeof ( zstd_ll_predefined[0] ) ),
+	.log = 6,
+	.max = ZSTD_LL_MAX,
+	.max_log = ZSTD_LL_MAX_LOG,
+};
+
+/** Offset symbol type */
+static const struct zstd_fse_type zstd_of_type = {
+	.name = "offset",
+	.predefined = zstd_of_predefined,
+	.count = ( sizeof ( zstd_of_predefined ) /
+		   sizeof ( zstd_of_predefined[0] ) ),
+	.log = 5,
+	.max = ZSTD_OF_MAX,
+	.max_log = ZSTD_OF_MAX_LOG,
+};
+
+/** Match length symbol type */
+static const struct zstd_fse_type zstd_ml_type = {
+	.name = "match length",
+	.predefined = zstd_ml_predefined,
+	.count = ( sizeof ( zstd_ml_predefined ) /
+		   sizeof ( zstd_ml_predefined[0] ) ),
+	.log = 6,
+	.max = ZSTD_ML_MAX,
+	.max_log = ZSTD_ML_MAX_LOG,
+};
+
+/** Huffman weight symbol type */
+static const struct zstd_fse_type zstd_weight_type = {
+	.name = "Huffman weight",
+	.max = ZSTD_HUFFMAN_MAX_BITS,
+	.max_log = ZSTD_HUFFMAN_WEIGHT_LOG,
+};
+
+/** XXH64 prime 1 */
+#define XXH64_PRIME1 0x9e3779b185ebca87ULL
+
+/** XXH64 prime 2 */
+#define XXH64_PRIME2 0xc2b2ae3d27d4eb4fULL
+
+/** XXH64 prime 3 */
+#define XXH64_PRIME3 0x165667b19e3779f9ULL
+
+/** XXH64 prime 4 */
+#define XXH64_PRIME4 0x85ebca77c2b2ae63ULL
+
+/** XXH64 prime 5 */
+#define XXH64_PRIME5 0x27d4eb2f165667c5ULL
+
+/**
+ * Read unaligned little-endian 32-bit value
+ *
+ * @v data		Data
+ * @ret value		Value
+ */
+static inline uint32_t zstd_le32 ( const void *data ) {
+	uint32_t value;
+
+	memcpy ( &value, data, sizeof ( value ) );
+	return le32_to_cpu ( value );
+}
+
+/**
+ * Read unaligned little-endian 64-bit value
+ *
+ * @v data		Data
+ * @ret value		Value
+ */
+static inline uint64_t zstd_le64 ( const void *data ) {
+	uint64_t value;
+
+	memcpy ( &value, data, sizeof ( value ) );
+	return le64_to_cpu ( value );
+}
+
+/**
+ * Read little-endian value of arbitrary length
+ *
+ * @v data		Data
+ * @v len		Length of data (at most 8 bytes)
+ * @ret value		Value
+ */
+static uint64_t zstd_le ( const void *data, size_t len ) {
+	const uint8_t *bytes = data;
+	uint64_t value = 0;
+
+	while ( len-- )
+		value = ( ( value << 8 ) | bytes[len] );
+	return value;
+}
+
+/**
+ * Perform XXH64 accumulator round
+ *
+ * @v acc		Accumulator
+ * @v input		Input value
+ * @ret acc		Updated accumulator
+ */
+static inline uint64_t zstd_xxh64_round ( uint64_t acc, uint64_t input ) {
+
+	acc += ( input * XXH64_PRIME2 );
+	acc = rol64 ( acc, 31 );
+	return ( acc * XXH64_PRIME1 );
+}
+
+/**
+ * Merge XXH64 accumulator
+ *
+ * @v hash		Hash value
+ * @v acc		Accumulator
+ * @ret hash		Updated hash value
+ */
+static inline uint64_t zstd_xxh64_merge ( uint64_t hash, uint64_t acc ) {
+
+	hash ^= zstd_xxh64_round ( 0, acc );
+	return ( ( hash * XXH64_PRIME1 ) + XXH64_PRIME4 );
+}
+
+/**
+ * Calculate XXH64 hash (with a zero seed)
+ *
+ * @v data		Data
+ * @v len		Length of data
+ * @ret hash		Hash value
+ */
+static uint64_t zstd_xxh64 ( const void *data, size_t len ) {
+	const uint8_t *bytes = data;
+	uint64_t acc[4];
+	uint64_t hash;
+	size_t remaining = len;
+	unsigned int i;
+
+	/* Process 32-byte stripes */
+	if ( remaining >= 32 ) {
+		acc[0] = ( XXH64_PRIME1 + XXH64_PRIME2 );
+		acc[1] = XXH64_PRIME2;
+		acc[2] = 0;
+		acc[3] = -XXH64_PRIME1;
+		for ( ; remaining >= 32 ; remaining -= 32, bytes += 32 ) {
+			for ( i = 0 ; i < 4 ; i++ ) {
+				acc[i] = zstd_xxh64_round ( acc[i],
+					zstd_le64 ( bytes + ( 8 * i ) ) );
+			}
+		}
+		hash = ( rol64 ( acc[0], 1 ) + rol64 ( acc[1], 7 ) +
+			 rol64 ( acc[2], 12 ) + rol64 ( acc[3], 18 ) );
+		for ( i = 0 ; i < 4 ; i++ )
+			hash = zstd_xxh64_merge ( hash, acc[i] );
+	} else {
+		hash = XXH64_PRIME5;
+	}
+	hash += len;
+
+	/* Process remaining data */
+	for ( ; remaining >= 8 ; remaining -= 8, bytes += 8 ) {
+		hash ^= zstd_xxh64_round ( 0, zstd_le64 ( bytes ) );
+		hash = ( ( rol64 ( hash, 27 ) * XXH64_PRIME1 ) +
+			 XXH64_PRIME4 );
+	}
+	if ( remaining >= 4 ) {
+		hash ^= ( zstd_le32 ( bytes ) * XXH64_PRIME1 );
+		hash = ( ( rol64 ( hash, 23 ) * XXH64_PRIME2 ) +
+			 XXH64_PRIME3 );
+		remaining -= 4;
+		bytes += 4;
+	}
+	for ( ; remaining ; remaining--, bytes++ ) {
+		hash ^= ( *bytes * XXH64_PRIME5 );
+		hash = ( rol64 ( hash, 11 ) * XXH64_PRIME1 );
+	}
+
+	/* Avalanche */
+	hash ^= ( hash >> 33 );
+	hash *= XXH64_PRIME2;
+	hash ^= ( hash >> 29 );
+	hash *= XXH64_PRIME3;
+	hash ^= ( hash >> 32 );
+
+	return hash;
+}
+
+/**
+ * Append data to output
+ *
+ * @v zstd		Decompressor
+ * @v data		Data
+ * @v len		Length of data
+ */
+static void zstd_out_copy ( struct zstd *zstd, const void *data,
+			    size_t len ) {
+	size_t frag_len;
+
+	/* Copy as much as fits within the output buffer */
+	if ( zstd->offset < zstd->max ) {
+		frag_len = ( zstd->max - zstd->offset );
+		if ( frag_len > len )
+			frag_len = len;
+		memcpy ( ( zstd->out + zstd->offset ), data, frag_len );
+	}
+	zstd->offset += len;
+}
+
+/**
+ * Append repeated byte to output
+ *
+ * @v zstd		Decompressor
+ * @v byte		Byte
+ * @v len		Length of data
+ */
+static void zstd_out_fill ( struct zstd *zstd, unsigned int byte,
+			    size_t len ) {
+	size_t frag_len;
+
+	/* Fill as much as fits within the output buffer */
+	if ( zstd->offset < zstd->max ) {
+		frag_len = ( zstd->max - zstd->offset );
+		if ( frag_len > len )
+			frag_len = len;
+		memset ( ( zstd->out + zstd->offset ), byte, frag_len );
+	}
+	zstd->offset += len;
+}
+
+/**
+ * Append duplicated string to output
+ *
+ * @v zstd		Decompressor
+ * @v offset		Offset (backwards from current position)
+ * @v len		Length of string
+ */
+static void zstd_out_match ( struct zstd *zstd, size_t offset,
+			     size_t len ) {
+	uint8_t *out = zstd->out;
+	size_t dest = zstd->offset;
+	size_t src = ( dest - offset );
+	size_t end = ( dest + len );
+
+	/* Copy non-overlapping strings in one go, if possible */
+	if ( ( offset >= len ) && ( end <= zstd->max ) ) {
+		memcpy ( ( out + dest ), ( out + src ), len );
+	} else {
+		for ( ; ( dest < end ) && ( dest < zstd->max ) ; dest++ )
+			out[dest] = out[src++];
+	}
+	zstd->offset = end;
+}
+
+/**
+ * Initialise backward bit stream
+ *
+ * @v bits		Bit stream
+ * @v data		Data
+ * @v len		Length of data
+ * @ret rc		Return status code
+ */
+static int zstd_bits_init ( struct zstd_bits *bits, const void *data,
+			    size_t len ) {
+	const uint8_t *bytes = data;
+	unsigned int last;
+
+	/* Locate end marker within final byte */
+	if ( ! len )
+		return -EINVAL;
+	last = bytes[ len - 1 ];
+	if ( ! last )
+		return -EINVAL;
+	if ( len > ZSTD_BLOCK_MAX )
+		return -EINVAL;
+
+	/* Initialise bit stream */
+	bits->data = bytes;
+	bits->len = len;
+	bits->pos = ( ( 8 * ( len - 1 ) ) + fls ( last ) - 1 );
+
+	return 0;
+}
+
+/**
+ * Peek at bits from backward bit stream
+ *
+ * @v bits		Bit stream
+ * @v count		Number of bits (at most 32)
+ * @ret value		Value
+ */
+static inline uint32_t zstd_bits_peek ( struct zstd_bits *bits,
+					unsigned int count ) {
+	int start = ( bits->pos - count );
+	unsigned int offset;
+	uint64_t value;
+	size_t avail;
+
+	/* Read containing 64-bit little-endian value */
+	offset = ( ( start < 0 ) ? 0 : ( start / 8 ) );
+	avail = ( bits->len - offset );
+	if ( avail >= sizeof ( value ) ) {
+		value = zstd_le64 ( bits->data + offset );
+	} else {
+		value = zstd_le ( ( bits->data + offset ), avail );
+	}
+
+	/* Extract requested bits, reading zeroes beyond start of stream */
+	if ( start < 0 ) {
+		value = ( ( start > -64 ) ? ( value << -start ) : 0 );
+	} else {
+		value >>= ( start % 8 );
+	}
+	return ( value & ( ( 1ULL << count ) - 1 ) );
+}
+
+/**
+ * Read bits from backward bit stream
+ *
+ * @v bits		Bit stream
+ * @v count		Number of bits (at most 32)
+ * @ret value		Value
+ */
+static inline uint32_t zstd_bits_read ( struct zstd_bits *bits,
+					unsigned int count ) {
+	uint32_t value;
+
+	value = zstd_bits_peek ( bits, count );
+	bits->pos -= count;
+	return value;
+}
+
+/**
+ * Construct FSE decoding table
+ *
+ * @v fse		FSE table to fill in
+ * @v norm		Normalised probabilities
+ * @v count		Number of symbols
+ * @v log		Accuracy log
+ * @ret rc		Return status code
+ */
+static int zstd_fse_build ( struct zstd_fse *fse, const int16_t *norm,
+			    unsigned int count, unsigned int log ) {
+	uint16_t next[ZSTD_FSE_MAX_SYMBOLS];
+	struct zstd_fse_entry *entry;
+	unsigned int size = ( 1 << log );
+	unsigned int mask = ( size - 1 );
+	unsigned int step = ( ( size >> 1 ) + ( size >> 3 ) + 3 );
+	unsigned int high = size;
+	unsigned int pos = 0;
+	unsigned int desc;
+	unsigned int symbol;
+	unsigned int i;
+
+	/* Sanity check */
+	assert ( count <= ZSTD_FSE_MAX_SYMBOLS );
+	assert ( log <= ZSTD_FSE_MAX_LOG );
+	fse->log = log;
+	fse->valid = 0;
+
+	/* Place "less than one" probability symbols at end of table */
+	for ( symbol = 0 ; symbol < count ; symbol++ ) {
+		if ( norm[symbol] == -1 ) {
+			if ( ! high )
+				return -EINVAL;
+			fse->entry[--high].symbol = symbol;
+			next[symbol] = 1;
+		}
+	}
+
+	/* Spread remaining symbols across table */
+	for ( symbol = 0 ; symbol < count ; symbol++ ) {
+		if ( norm[symbol] <= 0 )
+			continue;
+		next[symbol] = norm[symbol];
+		for ( i = 0 ; i < ( unsigned int ) norm[symbol] ; i++ ) {
+			fse->entry[pos].symbol = symbol;
+			do {
+				pos = ( ( pos + step ) & mask );
+			} while ( pos >= high );
+		}
+	}
+	if ( pos != 0 )
+		return -EINVAL;
+
+	/* Calculate state transitions */
+	for ( i = 0 ; i < size ; i++ ) {
+		entry = &fse->entry[i];
+		desc = next[entry->symbol]++;
+		entry->bits = ( log + 1 - fls ( desc ) );
+		entry->base = ( ( desc << entry->bits ) - size );
+	}
+
+	fse->valid = 1;
+	return 0;
+}
+
+/**
+ * Construct single-symbol FSE decoding table
+ *
+ * @v fse		FSE table to fill in
+ * @v symbol		Symbol
+ */
+static void zstd_fse_rle ( struct zstd_fse *fse, unsigned int symbol ) {
+
+	fse->log = 0;
+	fse->entry[0].symbol = symbol;
+	fse->entry[0].bits = 0;
+	fse->entry[0].base = 0;
+	fse->valid = 1;
+}
+
+/**
+ * Read bits from forward bit stream
+ *
+ * @v data		Data
+ * @v len		Length of data
+ * @v pos		Bit position
+ * @v count		Number of bits (at most 16)
+ * @ret value		Value
+ */
+static unsigned int zstd_forward ( const uint8_t *data, size_t len,
+				   size_t pos, unsigned int count ) {
+	size_t offset = ( pos / 8 );
+	size_t avail = ( len - offset );
+	uint32_t value;
+
+	/* Read containing little-endian value */
+	assert ( offset <= len );
+	value = zstd_le ( ( data + offset ), ( ( avail < 3 ) ? avail : 3 ) );
+
+	return ( ( value >> ( pos % 8 ) ) & ( ( 1U << count ) - 1 ) );
+}
+
+/**
+ * Parse FSE table description
+ *
+ * @v fse		FSE table to fill in
+ * @v type		Symbol type
+ * @v data		Data pointer to update
+ * @v len		Remaining length to update
+ * @ret rc		Return status code
+ */
+static int zstd_fse_describe ( struct zstd_fse *fse,
+			       const struct zstd_fse_type *type,
+			       const void **data, size_t *len ) {
+	const uint8_t *bytes = *data;
+	int16_t norm[ZSTD_FSE_MAX_SYMBOLS];
+	unsigned int limit = ( type->max + 1 );
+	unsigned int count = 0;
+	unsigned int log;
+	unsigned int bits;
+	unsigned int mask;
+	unsigned int threshold;
+	unsigned int value;
+	unsigned int repeat;
+	size_t pos = 0;
+	size_t used;
+	int remaining;
+	int prob;
+	int rc;
+
+	/* Read accuracy log */
+	if ( ! *len )
+		return -EINVAL;
+	log = ( zstd_forward ( bytes, *len, pos, 4 ) + ZSTD_FSE_MIN_LOG );
+	pos += 4;
+	if ( log > type->max_log ) {
+		DBGC ( type, "ZSTD %s accuracy log %d too large\n",
+		       type->name, log );
+		return -EINVAL;
+	}
+
+	/* Read normalised probabilities */
+	remaining = ( 1 << log );
+	while ( remaining > 0 ) {
+
+		/* Check for overruns */
+		if ( ( pos / 8 ) >= *len )
+			return -EINVAL;
+		if ( count >= limit )
+			return -EINVAL;
+
+		/* Read variable-length value */
+		bits = fls ( remaining + 1 );
+		mask = ( ( 1 << ( bits - 1 ) ) - 1 );
+		threshold = ( ( 1 << bits ) - 1 - ( remaining + 1 ) );
+		value = zstd_forward ( bytes, *len, pos, bits );
+		if ( ( value & mask ) < threshold ) {
+			value &= mask;
+			pos += ( bits - 1 );
+		} else {
+			if ( value > mask )
+				value -= threshold;
+			pos += bits;
+		}
+
+		/* Record probability */
+		prob = ( value - 1 );
+		remaining -= ( ( prob < 0 ) ? -prob : prob );
+		norm[count++] = prob;
+
+		/* Handle repeated zero probabilities */
+		if ( prob == 0 ) {
+			do {
+				if ( ( pos / 8 ) >= *len )
+					return -EINVAL;
+				repeat = zstd_forward ( bytes, *len, pos, 2 );
+				pos += 2;
+				if ( ( count + repeat ) > limit )
+					return -EINVAL;
+				memset ( &norm[count], 0,
+					 ( repeat * sizeof ( norm[0] ) ) );
+				count += repeat;
+			} while ( repeat == 3 );
+		}
+	}
+
+	/* Check for overrun and consume bytes */
+	used = ( ( pos + 7 ) / 8 );
+	if ( ( remaining != 0 ) || ( used > *len ) )
+		return -EINVAL;
+	*data += used;
+	*len -= used;
+
+	/* Construct decoding table */
+	if ( ( rc = zstd_fse_build ( fse, norm, count, log ) ) != 0 ) {
+		DBGC ( type, "ZSTD %s invalid distribution\n", type->name );
+		return rc;
+	}
+
+	return 0;
+}
+
+/**
+ * Select FSE decoding table for sequence symbols
+ *
+ * @v fse		FSE table
+ * @v type		Symbol type
+ * @v mode		Symbol compression mode
+ * @v data		Data pointer to update
+ * @v len		Remaining length to update
+ * @ret rc		Return status code
+ */
+static int zstd_fse_select ( struct zstd_fse *fse,
+			     const struct zstd_fse_type *type,
+			     unsigned int mode, const void **data,
+			     size_t *len ) {
+	int16_t norm[ZSTD_FSE_MAX_SYMBOLS];
+	const uint8_t *bytes = *data;
+	unsigned int i;
+
+	switch ( mode ) {
+	case ZSTD_MODE_PREDEFINED:
+		for ( i = 0 ; i < type->count ; i++ )
+			norm[i] = type->predefined[i];
+		return zstd_fse_build ( fse, norm, type->count, type->log );
+	case ZSTD_MODE_RLE:
+		if ( ( ! *len ) || ( bytes[0] > type->max ) )
+			return -EINVAL;
+		zstd_fse_rle ( fse, bytes[0] );
+		*data += 1;
+		*len -= 1;
+		return 0;
+	case ZSTD_MODE_COMPRESSED:
+		return zstd_fse_describe ( fse, type, data, len );
+	case ZSTD_MODE_REPEAT:
+		if ( ! fse->valid ) {
+			DBGC ( type, "ZSTD %s table cannot be repeated\n",
+			       type->name );
+			return -EINVAL;
+		}
+		return 0;
+	default:
+		assert ( 0 );
+		return -EINVAL;
+	}
+}
+
+/**
+ * Construct Huffman decoding table
+ *
+ * @v huffman		Huffman table to fill in
+ * @v weights		Weights (with space for the implicit final weight)
+ * @v count		Number of explicit weights
+ * @ret rc		Return status code
+ */
+static int zstd_huffman_build ( struct zstd_huffman *huffman,
+				uint8_t *weights, unsigned int count ) {
+	struct zstd_huffman_entry *entry = huffman->entry;
+	unsigned int symbol;
+	unsigned int weight;
+	unsigned int bits;
+	unsigned int fill;
+	uint32_t total = 0;
+	uint32_t left;
+
+	/* Calculate sum of explicit weights */
+	for ( symbol = 0 ; symbol < count ; symbol++ ) {
+		weight = weights[symbol];
+		if ( weight > ZSTD_HUFFMAN_MAX_BITS )
+			return -EINVAL;
+		if ( weight )
+			total += ( 1 << ( weight - 1 ) );
+	}
+	if ( ! total )
+		return -EINVAL;
+
+	/* Calculate maximum code length and implicit final weight */
+	bits = fls ( total );
+	if ( bits > ZSTD_HUFFMAN_MAX_BITS )
+		return -EINVAL;
+	left = ( ( 1 << bits ) - total );
+	if ( left & ( left - 1 ) )
+		return -EINVAL;
+	weights[count++] = fls ( left );
+	huffman->bits = bits;
+
+	/* Assign codes in order of increasing weight */
+	for ( weight = 1 ; weight <= bits ; weight++ ) {
+		for ( symbol = 0 ; symbol < count ; symbol++ ) {
+			if ( weights[symbol] != weight )
+				continue;
+			for ( fill = ( 1 << ( weight - 1 ) ) ; fill ; fill-- ) {
+				entry->symbol = symbol;
+				entry->bits = ( bits + 1 - weight );
+				entry++;
+			}
+		}
+	}
+	assert ( entry == &huffman->entry[ 1 << bits ] );
+
+	return 0;
+}
+
+/**
+ * Parse Huffman tree description
+ *
+ * @v zstd		Decompressor
+ * @v data		Data pointer to update
+ * @v len		Remaining length to update
+ * @ret rc		Return status code
+ */
+static int zstd_huffman_describe ( struct zstd *zstd, const void **data,
+				   size_t *len ) {
+	uint8_t weights[ZSTD_HUFFMAN_MAX_WEIGHTS];
+	struct zstd_fse *fse = &zstd->weight;
+	const uint8_t *bytes = *data;
+	struct zstd_bits bits;
+	const void *fse_data;
+	size_t fse_len;
+	unsigned int header;
+	unsigned int count;
+	unsigned int state[2];
+	unsigned int i;
+	int rc;
+
+	/* Parse header byte */
+	if ( ! *len )
+		return -EINVAL;
+	header = bytes[0];
+	bytes++;
+
+	if ( header >= 128 ) {
+
+		/* Weights are stored directly as 4-bit values */
+		count = ( header - 127 );
+		if ( ( 1 + ( ( count + 1 ) / 2 ) ) > *len )
+			return -EINVAL;
+		for ( i = 0 ; i < count ; i++ ) {
+			weights[i] = ( ( i & 1 ) ? ( bytes[ i / 2 ] & 0x0f ) :
+				       ( bytes[ i / 2 ] >> 4 ) );
+		}
+		*data += ( 1 + ( ( count + 1 ) / 2 ) );
+		*len -= ( 1 + ( ( count + 1 ) / 2 ) );
+
+	} else {
+
+		/* Weights are FSE compressed */
+		if ( ( 1 + header ) > *len )
+			return -EINVAL;
+		fse_data = bytes;
+		fse_len = header;
+		if ( ( rc = zstd_fse_describe ( fse, &zstd_weight_type,
+						&fse_data, &fse_len ) ) != 0 )
+			return rc;
+		if ( ( rc = zstd_bits_init ( &bits, fse_data, fse_len ) ) != 0 )
+			return rc;
+
+		/* Decode using two interleaved states until the bit
+		 * stream is exhausted.
+		 */
+		state[0] = zstd_bits_read ( &bits, fse->log );
+		state[1] = zstd_bits_read ( &bits, fse->log );
+		for ( count = 0, i = 0 ; ; i ^= 1 ) {
+			if ( count >= ( ZSTD_HUFFMAN_MAX_WEIGHTS - 2 ) )
+				return -EINVAL;
+			weights[count++] = fse->entry[ state[i] ].symbol;
+			state[i] = ( fse->entry[ state[i] ].base +
+				     zstd_bits_read ( &bits,
+					fse->entry[ state[i] ].bits ) );
+			if ( bits.pos < 0 ) {
+				weights[count++] =
+					fse->entry[ state[ i ^ 1 ] ].symbol;
+				break;
+			}
+		}
+		*data += ( 1 + header );
+		*len -= ( 1 + header );
+	}
+
+	/* Construct Huffman table */
+	if ( count >= ZSTD_HUFFMAN_MAX_WEIGHTS )
+		return -EINVAL;
+	if ( ( rc = zstd_huffman_build ( &zstd->huffman, weights,
+					 count ) ) != 0 ) {
+		DBGC ( zstd, "ZSTD %p invalid Huffman weights\n", zstd );
+		return rc;
+	}
+	zstd->have_huffman = 1;
+
+	return 0;
+}
+
+/**
+ * Decode Huffman compressed literals stream
+ *
+ * @v zstd		Decompressor
+ * @v data		Compressed stream
+ * @v len		Length of compressed stream
+ * @v out		Output buffer
+ * @v count		Number of literals to decode
+ * @ret rc		Return status code
+ */
+static int zstd_huffman_stream ( struct zstd *zstd, const void *data,
+				 size_t len, uint8_t *out, size_t count ) {
+	struct zstd_huffman *huffman = &zstd->huffman;
+	const struct zstd_huffman_entry *entry;
+	struct zstd_bits bits;
+	int rc;
+
+	/* Initialise bit stream */
+	if ( ( rc = zstd_bits_init ( &bits, data, len ) ) != 0 )
+		return rc;
+
+	/* Decode literals */
+	while ( count-- ) {
+		entry = &huffman->entry[ zstd_bits_peek ( &bits,
+							  huffman->bits ) ];
+		bits.pos -= entry->bits;
+		*(out++) = entry->symbol;
+	}
+
+	/* Check that stream was consumed exactly */
+	if ( bits.pos != 0 ) {
+		DBGC ( zstd, "ZSTD %p literals stream misaligned (%d)\n",
+		       zstd, bits.pos );
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+/**
+ * Parse literals section
+ *
+ * @v zstd		Decompressor
+ * @v data		Data pointer to update
+ * @v len		Remaining length to update
+ * @ret rc		Return status code
+ */
+static int zstd_literals ( struct zstd *zstd, const void **data,
+			   size_t *len ) {
+	const uint8_t *bytes = *data;
+	const void *streams;
+	size_t streams_len;
+	size_t stream_len[4];
+	size_t regen_len[4];
+	size_t header_len;
+	size_t each;
+	uint64_t header;
+	unsigned int type;
+	unsigned int format;
+	unsigned int count;
+	unsigned int width;
+	unsigned int mask;
+	size_t regen;
+	size_t comp;
+	uint8_t *out;
+	unsigned int i;
+	int rc;
+
+	/* Parse block type and size format */
+	if ( ! *len )
+		return -EINVAL;
+	type = ( bytes[0] & 0x03 );
+	format = ( ( bytes[0] >> 2 ) & 0x03 );
+
+	/* Handle raw and run-length encoded literals */
+	if ( ( type == ZSTD_LITERALS_RAW ) || ( type == ZSTD_LITERALS_RLE ) ) {
+		header_len = ( ( format == 1 ) ? 2 : ( format == 3 ) ? 3 : 1 );
+		if ( header_len > *len )
+			return -EINVAL;
+		header = zstd_le ( bytes, header_len );
+		regen = ( header >> ( ( header_len == 1 ) ? 3 : 4 ) );
+		comp = ( ( type == ZSTD_LITERALS_RAW ) ? regen : 1 );
+		if ( ( header_len + comp ) > *len )
+			return -EINVAL;
+		if ( type == ZSTD_LITERALS_RAW ) {
+			zstd->literals = ( bytes + header_len );
+		} else {
+			if ( regen > sizeof ( zstd->buffer ) )
+				return -EINVAL;
+			memset ( zstd->buffer, bytes[header_len], regen );
+			zstd->literals = zstd->buffer;
+		}
+		zstd->literals_len = regen;
+		*data += ( header_len + comp );
+		*len -= ( header_len + comp );
+		return 0;
+	}
+
+	/* Parse compressed literals header */
+	count = ( format ? 4 : 1 );
+	header_len = ( ( format < 2 ) ? 3 : ( format + 2 ) );
+	width = ( ( format < 2 ) ? 10 : ( ( 4 * format ) + 6 ) );
+	mask = ( ( 1 << width ) - 1 );
+	if ( header_len > *len )
+		return -EINVAL;
+	header = zstd_le ( bytes, header_len );
+	regen = ( ( header >> 4 ) & mask );
+	comp = ( ( header >> ( 4 + width ) ) & mask );
+	if ( regen > sizeof ( zstd->buffer ) )
+		return -EINVAL;
+	if ( ( header_len + comp ) > *len )
+		return -EINVAL;
+	streams = ( bytes + header_len );
+	streams_len = comp;
+
+	/* Parse Huffman tree description, if applicable */
+	if ( type == ZSTD_LITERALS_COMPRESSED ) {
+		if ( ( rc = zstd_huffman_describe ( zstd, &streams,
+						    &streams_len ) ) != 0 )
+			return rc;
+	} else if ( ! zstd->have_huffman ) {
+		DBGC ( zstd, "ZSTD %p has no Huffman table to repeat\n",
+		       zstd );
+		return -EINVAL;
+	}
+
+	/* Calculate stream lengths */
+	if ( count == 1 ) {
+		stream_len[0] = streams_len;
+		regen_len[0] = regen;
+	} else {
+		if ( streams_len < ZSTD_JUMP_TABLE_LEN )
+			return -EINVAL;
+		stream_len[3] = ( streams_len - ZSTD_JUMP_TABLE_LEN );
+		each = ( ( regen + 3 ) / 4 );
+		if ( ( 3 * each ) > regen )
+			return -EINVAL;
+		for ( i = 0 ; i < 3 ; i++ ) {
+			stream_len[i] = zstd_le ( ( streams + ( 2 * i ) ), 2 );
+			if ( stream_len[i] > stream_len[3] )
+				return -EINVAL;
+			stream_len[3] -= stream_len[i];
+			regen_len[i] = each;
+		}
+		regen_len[3] = ( regen - ( 3 * each ) );
+		streams += ZSTD_JUMP_TABLE_LEN;
+	}
+
+	/* Decode streams */
+	out = zstd->buffer;
+	for ( i = 0 ; i < count ; i++ ) {
+		if ( ( rc = zstd_huffman_stream ( zstd, streams, stream_len[i],
+						  out, regen_len[i] ) ) != 0 )
+			return rc;
+		streams += stream_len[i];
+		out += regen_len[i];
+	}
+	zstd->literals = zstd->buffer;
+	zstd->literals_len = regen;
+
+	/* Consume literals section */
+	*data += ( header_len + comp );
+	*len -= ( header_len + comp );
+
+	return 0;
+}
+
+/**
+ * Decode and execute sequences
+ *
+ * @v zstd		Decompressor
+ * @v data		Data
+ * @v len		Length of data
+ * @ret rc		Return status code
+ */
+static int zstd_sequences ( struct zstd *zstd, const void *data,
+			    size_t len ) {
+	const uint8_t *bytes = data;
+	const struct zstd_code *ll_code;
+	const struct zstd_code *ml_code;
+	struct zstd_fse_entry *ll;
+	struct zstd_fse_entry *of;
+	struct zstd_fse_entry *ml;
+	struct zstd_bits bits;
+	unsigned int modes;
+	unsigned int count;
+	unsigned int ll_state;
+	unsigned int of_state;
+	unsigned int ml_state;
+	unsigned int index;
+	size_t start = zstd->offset;
+	uint32_t literals_len;
+	uint32_t match_len;
+	uint32_t offset;
+	int rc;
+
+	/* Parse number of sequences */
+	if ( ! len )
+		return -EINVAL;
+	count = bytes[0];
+	if ( count == 0 ) {
+		if ( len != 1 )
+			return -EINVAL;
+		goto done;
+	} else if ( count < 128 ) {
+		data += 1;
+		len -= 1;
+	} else if ( count < 255 ) {
+		if ( len < 2 )
+			return -EINVAL;
+		count = ( ( ( count - 128 ) << 8 ) + bytes[1] );
+		data += 2;
+		len -= 2;
+	} else {
+		if ( len < 3 )
+			return -EINVAL;
+		count = ( zstd_le ( &bytes[1], 2 ) + 0x7f00 );
+		data += 3;
+		len -= 3;
+	}
+
+	/* Parse symbol compression modes */
+	if ( ! len )
+		return -EINVAL;
+	bytes = data;
+	modes = bytes[0];
+	if ( modes & 0x03 )
+		return -EINVAL;
+	data += 1;
+	len -= 1;
+
+	/* Select decoding tables */
+	if ( ( rc = zstd_fse_select ( &zstd->ll, &zstd_ll_type,
+				      ( ( modes >> 6 ) & 0x03 ),
+				      &data, &len ) ) != 0 )
+		return rc;
+	if ( ( rc = zstd_fse_select ( &zstd->of, &zstd_of_type,
+				      ( ( modes >> 4 ) & 0x03 ),
+				      &data, &len ) ) != 0 )
+		return rc;
+	if ( ( rc = zstd_fse_select ( &zstd->ml, &zstd_ml_type,
+				      ( ( modes >> 2 ) & 0x03 ),
+				      &data, &len ) ) != 0 )
+		return rc;
+
+	/* Initialise bit stream and states */
+	if ( ( rc = zstd_bits_init ( &bits, data, len ) ) != 0 )
+		return rc;
+	ll_state = zstd_bits_read ( &bits, zstd->ll.log );
+	of_state = zstd_bits_read ( &bits, zstd->of.log );
+	ml_state = zstd_bits_read ( &bits, zstd->ml.log );
+
+	/* Decode sequences */
+	while ( count-- ) {
+
+		/* Decode symbols */
+		ll = &zstd->ll.entry[ll_state];
+		of = &zstd->of.entry[of_state];
+		ml = &zstd->ml.entry[ml_state];
+		ll_code = &zstd_ll_codes[ll->symbol];
+		ml_code = &zstd_ml_codes[ml->symbol];
+
+		/* Read values */
+		offset = ( ( 1UL << of->symbol ) +
+			   zstd_bits_read ( &bits, of->symbol ) );
+		match_len = ( ml_code->base +
+			      zstd_bits_read ( &bits, ml_code->bits ) );
+		literals_len = ( ll_code->base +
+				 zstd_bits_read ( &bits, ll_code->bits ) );
+
+		/* Resolve repeated offsets */
+		if ( offset > ZSTD_REPEATS ) {
+			offset -= ZSTD_REPEATS;
+			zstd->repeat[2] = zstd->repeat[1];
+			zstd->repeat[1] = zstd->repeat[0];
+			zstd->repeat[0] = offset;
+		} else {
+			index = ( offset - 1 + ( literals_len ? 0 : 1 ) );
+			if ( index == 0 ) {
+				offset = zstd->repeat[0];
+			} else {
+				offset = ( ( index < ZSTD_REPEATS ) ?
+					   zstd->repeat[index] :
+					   ( zstd->repeat[0] - 1 ) );
+				if ( index > 1 )
+					zstd->repeat[2] = zstd->repeat[1];
+				zstd->repeat[1] = zstd->repeat[0];
+				zstd->repeat[0] = offset;
+			}
+		}
+
+		/* Update states, unless this is the final sequence */
+		if ( count ) {
+			ll_state = ( ll->base +
+				     zstd_bits_read ( &bits, ll->bits ) );
+			ml_state = ( ml->base +
+				     zstd_bits_read ( &bits, ml->bits ) );
+			of_state = ( of->base +
+				     zstd_bits_read ( &bits, of->bits ) );
+		}
+
+		/* Check sequence validity */
+		if ( literals_len > zstd->literals_len ) {
+			DBGC ( zstd, "ZSTD %p literals overrun\n", zstd );
+			return -EINVAL;
+		}
+		if ( ( offset == 0 ) ||
+		     ( offset > ( zstd->offset + literals_len -
+				  zstd->frame ) ) ) {
+			DBGC ( zstd, "ZSTD %p invalid offset %d\n",
+			       zstd, offset );
+			return -EINVAL;
+		}
+		if ( ( zstd->offset + literals_len + match_len - start ) >
+		     ZSTD_BLOCK_MAX ) {
+			DBGC ( zstd, "ZSTD %p block overlength\n", zstd );
+			return -EINVAL;
+		}
+
+		/* Execute sequence */
+		zstd_out_copy ( zstd, zstd->literals, literals_len );
+		zstd->literals += literals_len;
+		zstd->literals_len -= literals_len;
+		zstd_out_match ( zstd, offset, match_len );
+	}
+
+	/* Check that bit stream was consumed exactly */
+	if ( bits.pos != 0 ) {
+		DBGC ( zstd, "ZSTD %p sequences stream misaligned (%d)\n",
+		       zstd, bits.pos );
+		return -EINVAL;
+	}
+
+ done:
+	/* Copy any remaining literals */
+	if ( ( zstd->offset + zstd->literals_len - start ) > ZSTD_BLOCK_MAX )
+		return -EINVAL;
+	zstd_out_copy ( zstd, zstd->literals, zstd->literals_len );
+	zstd->literals_len = 0;
+
+	return 0;
+}
+
+/**
+ * Decompress compressed block
+ *
+ * @v zstd		Decompressor
+ * @v data		Block data
+ * @v len		Length of block data
+ * @ret rc		Return status code
+ */
+static int zstd_block ( struct zstd *zstd, const void *data, size_t len ) {
+	int rc;
+
+	/* Parse literals section */
+	if ( ( rc = zstd_literals ( zstd, &data, &len ) ) != 0 ) {
+		DBGC ( zstd, "ZSTD %p invalid literals: %s\n",
+		       zstd, strerror ( rc ) );
+		return rc;
+	}
+
+	/* Decode and execute sequences */
+	if ( ( rc = zstd_sequences ( zstd, data, len ) ) != 0 ) {
+		DBGC ( zstd, "ZSTD %p invalid sequences: %s\n",
+		       zstd, strerror ( rc ) );
+		return rc;
+	}
+
+	return 0;
+}
+
+/**
+ * Decompress frame
+ *
+ * @v zstd		Decompressor
+ * @v data		Data pointer to update
+ * @v len		Remaining length to update
+ * @ret rc		Return status code
+ */
+static int zstd_frame ( struct zstd *zstd, const void **data,
+			size_t *len ) {
+	static const uint8_t dict_lens[4] = { 0, 1, 2, 4 };
+	static const uint8_t fcs_lens[4] = { 0, 2, 4, 8 };
+	const uint8_t *bytes = *data;
+	const uint8_t *end = ( bytes + *len );
+	unsigned int descriptor;
+	unsigned int dict_len;
+	unsigned int fcs_len;
+	unsigned int type;
+	uint32_t magic;
+	uint32_t header;
+	uint32_t expected;
+	uint32_t actual;
+	uint64_t fcs = 0;
+	size_t size;
+	int rc;
+
+	/* Parse magic number */
+	if ( ( end - bytes ) < 4 )
+		return -EINVAL;
+	magic = zstd_le32 ( bytes );
+	bytes += 4;
+
+	/* Skip skippable frames */
+	if ( ( magic & ZSTD_SKIPPABLE_MASK ) == ZSTD_SKIPPABLE_MAGIC ) {
+		if ( ( end - bytes ) < 4 )
+			return -EINVAL;
+		size = zstd_le32 ( bytes );
+		bytes += 4;
+		if ( size > ( size_t ) ( end - bytes ) )
+			return -EINVAL;
+		bytes += size;
+		goto done;
+	}
+	if ( magic != ZSTD_MAGIC ) {
+		DBGC ( zstd, "ZSTD %p invalid magic %#08x\n", zstd, magic );
+		return -EINVAL;
+	}
+
+	/* Parse frame header */
+	if ( ( end - bytes ) < 1 )
+		return -EINVAL;
+	descriptor = *(bytes++);
+	if ( descriptor & ZSTD_FHD_RESERVED )
+		return -EINVAL;
+	dict_len = dict_lens[ ZSTD_FHD_DICT ( descriptor ) ];
+	fcs_len = fcs_lens[ ZSTD_FHD_FCS ( descriptor ) ];
+	if ( ( descriptor & ZSTD_FHD_SINGLE ) && ( ! fcs_len ) )
+		fcs_len = 1;
+	if ( ( ( size_t ) ( end - bytes ) ) <
+	     ( ( ( descriptor & ZSTD_FHD_SINGLE ) ? 0 : 1 ) +
+	       dict_len + fcs_len ) )
+		return -EINVAL;
+	if ( ! ( descriptor & ZSTD_FHD_SINGLE ) )
+		bytes++; /* Window descriptor is irrelevant */
+	if ( zstd_le ( bytes, dict_len ) ) {
+		DBGC ( zstd, "ZSTD %p dictionaries are not supported\n",
+		       zstd );
+		return -ENOTSUP;
+	}
+	bytes += dict_len;
+	if ( fcs_len ) {
+		fcs = zstd_le ( bytes, fcs_len );
+		if ( fcs_len == 2 )
+			fcs += 256;
+	}
+	bytes += fcs_len;
+
+	/* Reset frame state */
+	zstd->frame = zstd->offset;
+	zstd->repeat[0] = 1;
+	zstd->repeat[1] = 4;
+	zstd->repeat[2] = 8;
+	zstd->have_huffman = 0;
+	zstd->ll.valid = 0;
+	zstd->of.valid = 0;
+	zstd->ml.valid = 0;
+
+	/* Decompress blocks */
+	do {
+		/* Parse block header */
+		if ( ( end - bytes ) < ZSTD_BLOCK_HEADER_LEN )
+			return -EINVAL;
+		header = zstd_le ( bytes, ZSTD_BLOCK_HEADER_LEN );
+		bytes += ZSTD_BLOCK_HEADER_LEN;
+		type = ZSTD_BLOCK_TYPE ( header );
+		size = ZSTD_BLOCK_SIZE ( header );
+		if ( size > ZSTD_BLOCK_MAX ) {
+			DBGC ( zstd, "ZSTD %p overlength block %#zx\n",
+			       zstd, size );
+			return -EINVAL;
+		}
+
+		/* Decompress block */
+		switch ( type ) {
+		case ZSTD_BLOCK_RAW:
+			if ( size > ( size_t ) ( end - bytes ) )
+				return -EINVAL;
+			zstd_out_copy ( zstd, bytes, size );
+			bytes += size;
+			break;
+		case ZSTD_BLOCK_RLE:
+			if ( ( end - bytes ) < 1 )
+				return -EINVAL;
+			zstd_out_fill ( zstd, *bytes, size );
+			bytes += 1;
+			break;
+		case ZSTD_BLOCK_COMPRESSED:
+			if ( size > ( size_t ) ( end - bytes ) )
+				return -EINVAL;
+			if ( ( rc = zstd_block ( zstd, bytes, size ) ) != 0 )
+				return rc;
+			bytes += size;
+			break;
+		default:
+			DBGC ( zstd, "ZSTD %p reserved block type\n", zstd );
+			return -EINVAL;
+		}
+
+	} while ( ! ( header & ZSTD_BLOCK_LAST ) );
+
+	/* Verify content size, if present */
+	if ( fcs_len && ( fcs != ( zstd->offset - zstd->frame ) ) ) {
+		DBGC ( zstd, "ZSTD %p content size mismatch (expected %#llx, "
+		       "got %#zx)\n", zstd, ( ( unsigned long long ) fcs ),
+		       ( zstd->offset - zstd->frame ) );
+		return -EINVAL;
+	}
+
+	/* Verify content checksum, if present */
+	if ( descriptor & ZSTD_FHD_CHECKSUM ) {
+		if ( ( end - bytes ) < 4 )
+			return -EINVAL;
+		expected = zstd_le32 ( bytes );
+		bytes += 4;
+		if ( zstd->offset <= zstd->max ) {
+			actual = zstd_xxh64 ( ( zstd->out + zstd->frame ),
+					      ( zstd->offset - zstd->frame ) );
+			if ( actual != expected ) {
+				DBGC ( zstd, "ZSTD %p checksum mismatch "
+				       "(expected %08x, got %08x)\n",
+				       zstd, expected, actual );
+				return -EIO;
+			}
+		}
+	}
+
+ done:
+	*len -= ( bytes - ( ( const uint8_t * ) *data ) );
+	*data = bytes;
+	return 0;
+}
+
+/**
+ * Decompress data
+ *
+ * @v zstd		Decompressor
+ * @v data		Compressed data
+ * @v len		Length of compressed data
+ * @v out		Output buffer
+ * @v max		Length of output buffer
+ * @ret rc		Return status code
+ *
+ * On success, the total decompressed length is recorded in @c
+ * zstd->offset.  This may exceed the length of the output buffer, in
+ * which case the output buffer contains only the initial portion of
+ * the decompressed data.
+ */
+static int zstd_decompress ( struct zstd *zstd, const void *data,
+			     size_t len, void *out, size_t max ) {
+	int rc;
+
+	/* Initialise output */
+	zstd->out = out;
+	zstd->max = max;
+	zstd->offset = 0;
+
+	/* Decompress each frame in turn */
+	while ( len ) {
+		if ( ( rc = zstd_frame ( zstd, &data, &len ) ) != 0 )
+			return rc;
+	}
+
+	return 0;
+}
+
+/**
+ * Extract Zstandard image
+ *
+ * @v image		Image
+ * @v extracted		Extracted image
+ * @ret rc		Return status code
+ */
+static int zstd_extract ( struct image *image, struct image *extracted ) {
+	struct zstd *zstd;
+	int rc;
+
+	/* Allocate decompressor */
+	zstd = zalloc ( sizeof ( *zstd ) );
+	if ( ! zstd ) {
+		rc = -ENOMEM;
+		goto err_alloc;
+	}
+
+	/* Decompress image, (re)allocating if necessary */
+	while ( 1 ) {
+
+		/* Decompress image */
+		if ( ( rc = zstd_decompress ( zstd, image->data, image->len,
+					      extracted->rwdata,
+					      extracted->len ) ) != 0 ) {
+			DBGC ( image, "ZSTD %s could not decompress: %s\n",
+			       image->name, strerror ( rc ) );
+			goto err_decompress;
+		}
+
+		/* Finish if output image size was correct */
+		if ( zstd->offset == extracted->len )
+			break;
+
+		/* Otherwise, resize output image and retry */
+		if ( ( rc = image_set_len ( extracted, zstd->offset ) ) != 0 ) {
+			DBGC ( image, "ZSTD %s could not resize: %s\n",
+			       image->name, strerror ( rc ) );
+			goto err_set_len;
+		}
+	}
+
+	/* Success */
+	rc = 0;
+
+ err_set_len:
+ err_decompress:
+	free ( zstd );
+ err_alloc:
+	return rc;
+}
+
+/**
+ * Probe Zstandard image
+ *
+ * @v image		Zstandard image
+ * @ret rc		Return status code
+ */
+static int zstd_probe ( struct image *image ) {
+	uint32_t magic;
+
+	/* Sanity check */
+	if ( image->len < sizeof ( magic ) ) {
+		DBGC ( image, "ZSTD %s image too short\n", image->name );
+		return -ENOEXEC;
+	}
+
+	/* Check magic number */
+	magic = zstd_le32 ( image->data );
+	if ( ( magic != ZSTD_MAGIC ) &&
+	     ( ( magic & ZSTD_SKIPPABLE_MASK ) != ZSTD_SKIPPABLE_MAGIC ) ) {
+		DBGC ( image, "ZSTD %s invalid magic\n", image->name );
+		return -ENOEXEC;
+	}
+
+	return 0;
+}
+
+/** Zstandard image type */
+struct image_type zstd_image_type __image_type ( PROBE_NORMAL ) = {
+	.name = "zstd",
+	.probe = zstd_probe,
+	.extract = zstd_extract,
+	.exec = image_extract_exec,
+};
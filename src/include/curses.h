@@ -32,8 +32,10 @@ typedef uint32_t attr_t;
 
 /** Curses SCREEN object */
 typedef struct _curses_screen {
-	/** Current cursor position */
+	/** Current (physical) cursor position */
 	unsigned int curs_x, curs_y;
+	/** Requested cursor position */
+	unsigned int want_x, want_y;
 	/** Current attribute */
 	attr_t attrs;
 
@@ -52,6 +54,8 @@ typedef struct _curses_screen {
 	 * @v scr	screen on which to operate
 	 * @v y		Y position
 	 * @v x		X position
+	 *
+	 * The physical cursor may not be moved until required.
 	 */
 	void ( * movetoyx ) ( struct _curses_screen *scr,
 			      unsigned int y, unsigned int x );
@@ -62,6 +66,12 @@ typedef struct _curses_screen {
 	 * @v c		character to be written
 	 */
 	void ( * putc ) ( struct _curses_screen *scr, chtype c );
+	/**
+	 * Move physical cursor to requested position
+	 *
+	 * @v scr	screen on which to operate
+	 */
+	void ( * refresh ) ( struct _curses_screen *scr );
 	/**
 	 * Pop a character from the keyboard input stream
 	 *
@@ -362,7 +372,6 @@ extern int putp ( const char * );
 extern void qiflush ( void );
 extern int raw ( void );
 //extern int redrawwin ( WINDOW * );
-//extern int refresh ( void );
 extern int reset_prog_mode ( void );
 extern int reset_shell_mode ( void );
 extern int resetty ( void );
@@ -467,7 +476,7 @@ extern int wmove ( WINDOW *, int, int );
 //extern int wnoutrefresh ( WINDOW * );
 extern int wprintw ( WINDOW *, const char *, ... ) __nonnull;
 //extern int wredrawln ( WINDOW *, int, int );
-//extern int wrefresh ( WINDOW * );
+extern int wrefresh ( WINDOW * ) __nonnull;
 //extern int wscanw ( WINDOW *, char *, ... );
 //extern int wscrl ( WINDOW *, int );
 //extern int wsetscrreg ( WINDOW *, int, int );
@@ -716,6 +725,10 @@ static inline int mvwvline ( WINDOW *win, int y, int x, chtype ch, int n ) {
 
 #define printw( fmt, ... ) wprintw(stdscr,(fmt), ## __VA_ARGS__ )
 
+static inline int refresh ( void ) {
+	return wrefresh ( stdscr );
+}
+
 static inline int slk_refresh ( void ) {
 	if ( slk_clear() == OK )
 		return slk_restore();
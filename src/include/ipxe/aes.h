@@ -10,6 +10,7 @@
 FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 FILE_SECBOOT ( PERMITTED );
 
+#include <ipxe/tables.h>
 #include <ipxe/crypto.h>
 
 /** AES blocksize */
@@ -40,11 +41,52 @@ struct aes_context {
 	struct aes_round_keys decrypt;
 	/** Number of rounds */
 	unsigned int rounds;
+	/** Hardware accelerator (if any) */
+	struct aes_accelerator *accel;
 };
 
+/** An AES hardware accelerator */
+struct aes_accelerator {
+	/** Name */
+	const char *name;
+	/**
+	 * Check if accelerator is usable
+	 *
+	 * @ret rc		Return status code
+	 */
+	int ( * probe ) ( void );
+	/**
+	 * Encrypt single block
+	 *
+	 * @v aes		AES context
+	 * @v src		Data to encrypt
+	 * @v dst		Buffer for encrypted data
+	 */
+	void ( * encrypt ) ( struct aes_context *aes, const void *src,
+			     void *dst );
+	/**
+	 * Decrypt single block
+	 *
+	 * @v aes		AES context
+	 * @v src		Data to decrypt
+	 * @v dst		Buffer for decrypted data
+	 */
+	void ( * decrypt ) ( struct aes_context *aes, const void *src,
+			     void *dst );
+};
+
+/** AES hardware accelerator table */
+#define AES_ACCELERATORS \
+	__table ( struct aes_accelerator, "aes_accelerators" )
+
+/** Declare an AES hardware accelerator */
+#define __aes_accelerator __table_entry ( AES_ACCELERATORS, 01 )
+
 /** AES context size */
 #define AES_CTX_SIZE sizeof ( struct aes_context )
 
+extern int aes_accel_disabled;
+
 extern struct cipher_algorithm aes_algorithm;
 extern struct cipher_algorithm aes_ecb_algorithm;
 extern struct cipher_algorithm aes_cbc_algorithm;
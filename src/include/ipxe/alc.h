@@ -0,0 +1,98 @@
+#ifndef _IPXE_ALC_H
+#define _IPXE_ALC_H
+
+/** @file
+ *
+ * Asynchronous Layered Coding (ALC) protocol
+ *
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+#include <stdint.h>
+
+/** Default ALC multicast port */
+#define ALC_DEFAULT_PORT 4001
+
+/** A Layered Coding Transport (LCT) header */
+struct lct_header {
+	/** Version, congestion control flag, and protocol-specific bits */
+	uint8_t version;
+	/** Field length and object status flags */
+	uint8_t flags;
+	/** Header length (in 32-bit words) */
+	uint8_t len;
+	/** Codepoint */
+	uint8_t codepoint;
+} __attribute__ (( packed ));
+
+/** LCT version number */
+#define LCT_VERSION 1
+
+/** Extract LCT version number */
+#define LCT_VERSION_NUM( version ) ( (version) >> 4 )
+
+/** Extract LCT congestion control information length (in bytes) */
+#define LCT_CCI_LEN( version ) ( 4 * ( ( ( (version) >> 2 ) & 0x3 ) + 1 ) )
+
+/** LCT transport session identifier length flag */
+#define LCT_FL_S 0x80
+
+/** Extract LCT transport object identifier length field */
+#define LCT_O( flags ) ( ( (flags) >> 5 ) & 0x3 )
+
+/** LCT half-word flag */
+#define LCT_FL_H 0x10
+
+/** Extract LCT transport session identifier length (in bytes) */
+#define LCT_TSI_LEN( flags ) \
+	( ( ( (flags) & LCT_FL_S ) ? 4 : 0 ) + \
+	  ( ( (flags) & LCT_FL_H ) ? 2 : 0 ) )
+
+/** Extract LCT transport object identifier length (in bytes) */
+#define LCT_TOI_LEN( flags ) \
+	( ( 4 * LCT_O ( flags ) ) + ( ( (flags) & LCT_FL_H ) ? 2 : 0 ) )
+
+/** Minimum header extension type with a fixed length */
+#define LCT_HET_FIXED 128
+
+/** FEC object transmission information header extension type */
+#define ALC_EXT_FTI 64
+
+/** Reed-Solomon over GF(2^8) FEC encoding ID */
+#define ALC_FEC_RS8 5
+
+/** FEC object transmission information for Reed-Solomon over GF(2^8)
+ *
+ * This is the EXT_FTI header extension as defined in RFC 5510.
+ */
+struct alc_rs8_fti {
+	/** Header extension type */
+	uint8_t het;
+	/** Header extension length (in 32-bit words) */
+	uint8_t hel;
+	/** Transfer length (high 16 bits) */
+	uint16_t len_high;
+	/** Transfer length (low 32 bits) */
+	uint32_t len_low;
+	/** Encoding symbol length */
+	uint16_t symlen;
+	/** Maximum source block length */
+	uint8_t max_k;
+	/** Maximum number of encoding symbols */
+	uint8_t max_n;
+} __attribute__ (( packed ));
+
+/** FEC payload ID for Reed-Solomon over GF(2^8) */
+struct alc_rs8_payload_id {
+	/** Source block number (high 24 bits) and encoding symbol ID */
+	uint32_t sbn_esi;
+} __attribute__ (( packed ));
+
+/** Extract source block number */
+#define ALC_RS8_SBN( sbn_esi ) ( (sbn_esi) >> 8 )
+
+/** Extract encoding symbol ID */
+#define ALC_RS8_ESI( sbn_esi ) ( (sbn_esi) & 0xff )
+
+#endif /* _IPXE_ALC_H */
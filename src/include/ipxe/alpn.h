@@ -0,0 +1,26 @@
+#ifndef _IPXE_ALPN_H
+#define _IPXE_ALPN_H
+
+/** @file
+ *
+ * Application-layer protocol negotiation
+ *
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+FILE_SECBOOT ( PERMITTED );
+
+#include <ipxe/interface.h>
+
+/** Maximum length of a negotiated application protocol name */
+#define ALPN_MAX_LEN 32
+
+extern const char * alpn_offer ( struct interface *intf );
+#define alpn_offer_TYPE( object_type ) \
+	typeof ( const char * ( object_type ) )
+
+extern const char * alpn_protocol ( struct interface *intf );
+#define alpn_protocol_TYPE( object_type ) \
+	typeof ( const char * ( object_type ) )
+
+#endif /* _IPXE_ALPN_H */
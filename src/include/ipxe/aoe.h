@@ -109,8 +109,18 @@ struct aoehdr {
 /** AoE tag magic marker */
 #define AOE_TAG_MAGIC 0x18ae0000
 
-/** Maximum number of sectors per packet */
-#define AOE_MAX_COUNT 2
+/** Maximum number of sectors per packet
+ *
+ * This is the largest count representable in the ATA sector count
+ * register.  The usable count is further limited by the network
+ * device MTU (two sectors for a standard Ethernet frame, seventeen
+ * for a 9000-byte jumbo frame) and by the count advertised by the
+ * target.
+ */
+#define AOE_MAX_COUNT 255
+
+/** Maximum number of outstanding commands per device */
+#define AOE_MAX_DEPTH 16
 
 /** An AoE device */
 struct aoe_device {
@@ -137,6 +147,13 @@ struct aoe_device {
 	/** Device is configued */
 	int configured;
 
+	/** Maximum number of sectors per command */
+	unsigned int max_count;
+	/** Maximum number of outstanding commands */
+	unsigned int depth;
+	/** Number of outstanding commands */
+	unsigned int count;
+
 	/** ACPI descriptor */
 	struct acpi_descriptor desc;
 };
@@ -0,0 +1,40 @@
+#ifndef _IPXE_BENCH_H
+#define _IPXE_BENCH_H
+
+/** @file
+ *
+ * Benchmark infrastructure
+ *
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+#include <stddef.h>
+#include <ipxe/tables.h>
+
+/** A benchmark */
+struct benchmark {
+	/** Benchmark name */
+	const char *name;
+	/**
+	 * Run benchmark
+	 *
+	 * @ret rc		Return status code
+	 */
+	int ( * exec ) ( void );
+};
+
+/** Benchmark table */
+#define BENCHMARKS __table ( struct benchmark, "benchmarks" )
+
+/** Declare a benchmark */
+#define __benchmark __table_entry ( BENCHMARKS, 01 )
+
+extern void bench_report ( const char *name, size_t len,
+			   unsigned long packets, unsigned long ticks,
+			   unsigned long long cycles );
+extern void bench_report_ops ( const char *name, size_t len,
+			       unsigned long count, unsigned long ticks,
+			       unsigned long long cycles );
+
+#endif /* _IPXE_BENCH_H */
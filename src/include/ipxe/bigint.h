@@ -10,6 +10,7 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 FILE_SECBOOT ( PERMITTED );
 
 #include <assert.h>
+#include <ipxe/tables.h>
 
 /**
  * Define a big-integer type
@@ -364,6 +365,41 @@ FILE_SECBOOT ( PERMITTED );
 		bigint_t ( size ) temp[4];				\
 	} ); } )
 
+/** Maximum window width for public-exponent modular exponentiation */
+#define BIGINT_MOD_EXP_WINDOW 4
+
+/**
+ * Perform modular exponentiation of big integers with a public exponent
+ *
+ * @v base		Big integer base
+ * @v modulus		Big integer modulus
+ * @v exponent		Big integer exponent (must not be secret)
+ * @v result		Big integer to hold result
+ * @v tmp		Temporary working space
+ */
+#define bigint_mod_exp_public( base, modulus, exponent, result, tmp ) do { \
+	unsigned int size = bigint_size (base);				\
+	unsigned int exponent_size = bigint_size (exponent);		\
+	bigint_mod_exp_public_raw ( (base)->element, (modulus)->element, \
+				    (exponent)->element, (result)->element, \
+				    size, exponent_size, tmp );		\
+	} while ( 0 )
+
+/**
+ * Calculate temporary working space required for public-exponent
+ * modular exponentiation
+ *
+ * @v modulus		Big integer modulus
+ * @ret len		Length of temporary working space
+ */
+#define bigint_mod_exp_public_tmp_len( modulus ) ( {			\
+	unsigned int size = bigint_size (modulus);			\
+	sizeof ( struct {						\
+		bigint_t ( size ) temp[4];				\
+		bigint_t ( size )					\
+			table[ ( 1 << BIGINT_MOD_EXP_WINDOW ) - 1 ];	\
+	} ); } )
+
 #include <bits/bigint.h>
 
 /**
@@ -380,6 +416,61 @@ typedef void ( bigint_ladder_op_t ) ( const bigint_element_t *operand0,
 				      unsigned int size, const void *ctx,
 				      void *tmp );
 
+/** A big integer hardware accelerator */
+struct bigint_accelerator {
+	/** Name */
+	const char *name;
+	/** Number of elements per limb
+	 *
+	 * The accelerator will be used only for big integers whose
+	 * sizes are an exact multiple of the limb size.  This must be
+	 * a power of two.
+	 */
+	unsigned int limb;
+	/**
+	 * Check if accelerator is usable
+	 *
+	 * @ret rc		Return status code
+	 */
+	int ( * probe ) ( void );
+	/**
+	 * Multiply big integers
+	 *
+	 * @v multiplicand0	Element 0 of big integer to be multiplied
+	 * @v multiplicand_size	Number of elements in multiplicand
+	 * @v multiplier0	Element 0 of big integer to be multiplied
+	 * @v multiplier_size	Number of elements in multiplier
+	 * @v result0		Element 0 of big integer to hold result
+	 */
+	void ( * multiply ) ( const bigint_element_t *multiplicand0,
+			      unsigned int multiplicand_size,
+			      const bigint_element_t *multiplier0,
+			      unsigned int multiplier_size,
+			      bigint_element_t *result0 );
+	/**
+	 * Perform relaxed Montgomery reduction (REDC) of a big integer
+	 *
+	 * @v modulus0		Element 0 of big integer odd modulus
+	 * @v value0		Element 0 of big integer to be reduced
+	 * @v result0		Element 0 of big integer to hold result
+	 * @v size		Number of elements in modulus and result
+	 * @ret carry		Carry out
+	 */
+	int ( * montgomery ) ( const bigint_element_t *modulus0,
+			       bigint_element_t *value0,
+			       bigint_element_t *result0,
+			       unsigned int size );
+};
+
+/** Big integer hardware accelerator table */
+#define BIGINT_ACCELERATORS \
+	__table ( struct bigint_accelerator, "bigint_accelerators" )
+
+/** Declare a big integer hardware accelerator */
+#define __bigint_accelerator __table_entry ( BIGINT_ACCELERATORS, 01 )
+
+extern int bigint_accel_disabled;
+
 /**
  * Set bit in big integer
  *
@@ -514,5 +605,11 @@ void bigint_mod_exp_raw ( const bigint_element_t *base0,
 			  bigint_element_t *result0,
 			  unsigned int size, unsigned int exponent_size,
 			  void *tmp );
+void bigint_mod_exp_public_raw ( const bigint_element_t *base0,
+				 const bigint_element_t *modulus0,
+				 const bigint_element_t *exponent0,
+				 bigint_element_t *result0,
+				 unsigned int size, unsigned int exponent_size,
+				 void *tmp );
 
 #endif /* _IPXE_BIGINT_H */
@@ -0,0 +1,162 @@
+#ifndef _IPXE_BLOCKCACHE_H
+#define _IPXE_BLOCKCACHE_H
+
+/** @file
+ *
+ * Block device cache
+ *
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+FILE_SECBOOT ( PERMITTED );
+
+#include <stdint.h>
+#include <ipxe/list.h>
+
+struct block_cache;
+
+/** A block cache line */
+struct block_cache_line {
+	/** List of cache lines (in order of most recent use) */
+	struct list_head list;
+	/** Starting logical block address */
+	uint64_t lba;
+	/** Number of valid blocks (or zero if line is empty) */
+	unsigned int count;
+	/** Data buffer */
+	void *data;
+};
+
+/** Block cache operations */
+struct block_cache_operations {
+	/** Read from underlying block device
+	 *
+	 * @v cache		Block cache
+	 * @v lba		Starting logical block address
+	 * @v count		Number of logical blocks
+	 * @v buffer		Data buffer
+	 * @ret rc		Return status code
+	 */
+	int ( * read ) ( struct block_cache *cache, uint64_t lba,
+			 unsigned int count, void *buffer );
+	/** Write to underlying block device
+	 *
+	 * @v cache		Block cache
+	 * @v lba		Starting logical block address
+	 * @v count		Number of logical blocks
+	 * @v buffer		Data buffer
+	 * @ret rc		Return status code
+	 */
+	int ( * write ) ( struct block_cache *cache, uint64_t lba,
+			  unsigned int count, void *buffer );
+};
+
+/** A block cache dirty extent */
+struct block_cache_extent {
+	/** List of dirty extents (in order of block address) */
+	struct list_head list;
+	/** Starting logical block address */
+	uint64_t lba;
+	/** Number of blocks */
+	unsigned int count;
+	/** Data buffer */
+	uint8_t data[0];
+};
+
+/** A block cache
+ *
+ * The cache comprises a number of lines, each holding a fixed-size
+ * aligned group of blocks.  A read smaller than a cache line will
+ * cause the whole containing line to be read from the underlying
+ * device (i.e. the line size is also the read-ahead window).  Reads
+ * of at least a whole line bypass the cache altogether.
+ *
+ * Line fills that continue sequentially from the previous line fill
+ * are treated as a sequential stream.  The read-ahead window is
+ * doubled for each consecutive sequential fill, up to a maximum of
+ * half of the cache lines, so that a series of small sequential
+ * reads is coalesced into a few large reads from the underlying
+ * device.
+ *
+ * Writes are passed straight through to the underlying device unless
+ * write-back is enabled, in which case they are held as dirty extents
+ * until explicitly flushed.  Adjacent and overlapping writes are
+ * coalesced into a single extent.
+ */
+struct block_cache {
+	/** Block cache operations */
+	struct block_cache_operations *op;
+	/** List of cache lines (in order of most recent use) */
+	struct list_head lines;
+	/** Number of blocks per cache line (or zero if disabled) */
+	unsigned int blocks;
+	/** Block size */
+	size_t blksize;
+	/** Underlying device capacity (in blocks) */
+	uint64_t capacity;
+	/** Number of reads satisfied from the cache */
+	unsigned long hits;
+	/** Number of reads requiring a cache line fill */
+	unsigned long misses;
+	/** Cache line array (and data buffers) */
+	struct block_cache_line *line;
+	/** Maximum number of lines filled by a single read */
+	unsigned int ahead;
+	/** Sequential read-ahead buffer (if applicable) */
+	void *stream;
+	/** Number of consecutive sequential line fills */
+	unsigned int streak;
+	/** Block address immediately following the most recent fill */
+	uint64_t next;
+	/** List of dirty extents (in order of block address) */
+	struct list_head dirty;
+	/** Number of dirty extents */
+	unsigned int extents;
+	/** Total length of dirty data */
+	size_t dirty_len;
+	/** Maximum length of dirty data (or zero for write-through) */
+	size_t dirty_max;
+	/** Time at which oldest dirty data was written */
+	unsigned long dirtied;
+};
+
+/**
+ * Initialise block cache
+ *
+ * @v cache		Block cache
+ * @v op		Block cache operations
+ */
+static inline __attribute__ (( always_inline )) void
+block_cache_init ( struct block_cache *cache,
+		   struct block_cache_operations *op ) {
+
+	cache->op = op;
+	INIT_LIST_HEAD ( &cache->lines );
+	INIT_LIST_HEAD ( &cache->dirty );
+}
+
+/**
+ * Check if block cache holds dirty data
+ *
+ * @v cache		Block cache
+ * @ret is_dirty	Block cache holds dirty data
+ */
+static inline __attribute__ (( always_inline )) int
+block_cache_is_dirty ( struct block_cache *cache ) {
+
+	return ( ! list_empty ( &cache->dirty ) );
+}
+
+extern int block_cache_alloc ( struct block_cache *cache, size_t blksize,
+			       uint64_t capacity, unsigned int blocks,
+			       unsigned int count );
+extern void block_cache_free ( struct block_cache *cache );
+extern int block_cache_read ( struct block_cache *cache, uint64_t lba,
+			      unsigned int count, void *buffer );
+extern void block_cache_invalidate ( struct block_cache *cache, uint64_t lba,
+				     unsigned int count );
+extern int block_cache_write ( struct block_cache *cache, uint64_t lba,
+			       unsigned int count, void *buffer );
+extern int block_cache_flush ( struct block_cache *cache );
+
+#endif /* _IPXE_BLOCKCACHE_H */
@@ -0,0 +1,20 @@
+#ifndef _IPXE_BOND_H
+#define _IPXE_BOND_H
+
+/**
+ * @file
+ *
+ * Link aggregation (bonding) devices
+ *
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+FILE_SECBOOT ( PERMITTED );
+
+#include <ipxe/netdevice.h>
+
+extern struct net_device * bond_find ( struct net_device *member );
+extern int bond_create ( struct net_device **members, unsigned int count );
+extern int bond_destroy ( struct net_device *netdev );
+
+#endif /* _IPXE_BOND_H */
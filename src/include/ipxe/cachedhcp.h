@@ -23,5 +23,6 @@ extern int cachedhcp_record ( struct cached_dhcp_packet *cache,
 			      unsigned int vlan, const void *data,
 			      size_t max_len );
 extern void cachedhcp_recycle ( struct net_device *netdev );
+extern int cachedhcp_leased ( struct net_device *netdev );
 
 #endif /* _IPXE_CACHEDHCP_H */
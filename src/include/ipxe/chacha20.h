@@ -0,0 +1,66 @@
+#ifndef _IPXE_CHACHA20_H
+#define _IPXE_CHACHA20_H
+
+/** @file
+ *
+ * ChaCha20 stream cipher
+ *
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+FILE_SECBOOT ( PERMITTED );
+
+#include <stdint.h>
+#include <ipxe/crypto.h>
+
+/** ChaCha20 key length */
+#define CHACHA20_KEY_LEN 32
+
+/** ChaCha20 nonce length */
+#define CHACHA20_NONCE_LEN 12
+
+/** Number of ChaCha20 double rounds */
+#define CHACHA20_DOUBLE_ROUNDS 10
+
+/** A ChaCha20 block */
+union chacha20_block {
+	/** Raw bytes */
+	uint8_t byte[64];
+	/** Raw dwords */
+	uint32_t dword[16];
+};
+
+/** A ChaCha20 initialisation vector
+ *
+ * This is the combination of the initial block counter and the
+ * nonce, as used by RFC 8439.
+ */
+struct chacha20_iv {
+	/** Initial block counter (in little-endian order) */
+	uint32_t counter;
+	/** Nonce */
+	uint8_t nonce[CHACHA20_NONCE_LEN];
+} __attribute__ (( packed ));
+
+/** A ChaCha20 context */
+struct chacha20_context {
+	/** Input state (in host-endian order) */
+	uint32_t state[16];
+	/** Current keystream block */
+	union chacha20_block keystream;
+	/** Offset within current keystream block */
+	unsigned int offset;
+};
+
+/** ChaCha20 context size */
+#define CHACHA20_CTX_SIZE sizeof ( struct chacha20_context )
+
+extern int chacha20_setkey ( void *ctx, const void *key, size_t keylen );
+extern void chacha20_setiv ( void *ctx, const void *iv, size_t ivlen );
+extern void chacha20_encrypt ( void *ctx, const void *src, void *dst,
+			       size_t len );
+
+extern struct cipher_algorithm chacha20_algorithm;
+extern struct cipher_algorithm chacha20_poly1305_algorithm;
+
+#endif /* _IPXE_CHACHA20_H */
@@ -86,6 +86,15 @@ struct console_driver {
 	 * will not block.
 	 */
 	int ( * iskey ) ( void );
+	/**
+	 * Check for pending output
+	 *
+	 * @ret is_pending	Output is pending
+	 *
+	 * This should return true if previously written output has
+	 * not yet been fully transmitted.
+	 */
+	int ( * pending ) ( void );
 	/**
 	 * Configure console
 	 *
@@ -205,6 +214,7 @@ console_set_size ( unsigned int width, unsigned int height ) {
 }
 
 extern int iskey ( void );
+extern int console_pending ( void );
 extern int getkey ( unsigned long timeout );
 extern int console_configure ( struct console_configuration *config );
 
@@ -1,11 +1,64 @@
 #ifndef _IPXE_CRC32_H
 #define _IPXE_CRC32_H
 
+/** @file
+ *
+ * Little-endian CRC32
+ *
+ */
+
 FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 FILE_SECBOOT ( PERMITTED );
 
 #include <stdint.h>
+#include <ipxe/tables.h>
+
+/** CRC32 polynomial (IEEE 802.3, bit-reversed) */
+#define CRC32_POLY 0xedb88320UL
+
+/** CRC32C polynomial (Castagnoli, bit-reversed) */
+#define CRC32C_POLY 0x82f63b78UL
+
+/** Number of bytes processed in parallel by the table-driven engine */
+#define CRC32_SLICES 8
+
+/** A CRC32 hardware accelerator */
+struct crc32_accelerator {
+	/** Name */
+	const char *name;
+	/** Polynomial (bit-reversed) */
+	uint32_t poly;
+	/**
+	 * Check if accelerator is usable
+	 *
+	 * @ret rc		Return status code
+	 */
+	int ( * probe ) ( void );
+	/**
+	 * Update CRC
+	 *
+	 * @v crc		CRC to update
+	 * @v data		Data to checksum
+	 * @v len		Length of data
+	 * @ret used		Length of data processed
+	 *
+	 * The accelerator may choose to process only an initial
+	 * portion of the data.  Any remaining data will be processed
+	 * by the generic table-driven engine.
+	 */
+	size_t ( * update ) ( uint32_t *crc, const void *data, size_t len );
+};
+
+/** CRC32 hardware accelerator table */
+#define CRC32_ACCELERATORS \
+	__table ( struct crc32_accelerator, "crc32_accelerators" )
+
+/** Declare a CRC32 hardware accelerator */
+#define __crc32_accelerator __table_entry ( CRC32_ACCELERATORS, 01 )
+
+extern int crc32_accel_disabled;
 
-u32 crc32_le ( u32 seed, const void *data, size_t len );
+extern u32 crc32_le ( u32 seed, const void *data, size_t len );
+extern u32 crc32c_le ( u32 seed, const void *data, size_t len );
 
 #endif
@@ -213,6 +213,20 @@ struct elliptic_curve {
 	 * @ret rc		Return status code
 	 */
 	int ( * add ) ( const void *addend, const void *augend, void *result );
+	/** Multiply scalars by base point and curve point and add results
+	 *
+	 * @v scalar1		Scalar multiple of generator base point
+	 * @v point		Curve point
+	 * @v scalar2		Scalar multiple of curve point
+	 * @v result		Result point to fill in
+	 * @ret rc		Return status code
+	 *
+	 * This calculates (scalar1 * G + scalar2 * point) for public
+	 * values (e.g. for signature verification), and need not
+	 * execute in constant time.
+	 */
+	int ( * multiply_add ) ( const void *scalar1, const void *point,
+				 const void *scalar2, void *result );
 };
 
 static inline __attribute__ (( always_inline )) void
@@ -335,6 +349,13 @@ elliptic_add ( struct elliptic_curve *curve, const void *addend,
 	return curve->add ( addend, augend, result );
 }
 
+static inline __attribute__ (( always_inline )) int
+elliptic_multiply_add ( struct elliptic_curve *curve, const void *scalar1,
+			const void *point, const void *scalar2,
+			void *result ) {
+	return curve->multiply_add ( scalar1, point, scalar2, result );
+}
+
 extern void digest_null_init ( void *ctx );
 extern void digest_null_update ( void *ctx, const void *src, size_t len );
 extern void digest_null_final ( void *ctx, void *out );
@@ -81,6 +81,45 @@ enum deflate_format {
 /** Quick lookup shift */
 #define DEFLATE_HUFFMAN_QL_SHIFT ( 16 - DEFLATE_HUFFMAN_QL_BITS )
 
+/** Fast lookup length for a Huffman symbol (in bits)
+ *
+ * This is a policy decision.  Symbols longer than this will be
+ * decoded via the canonical Huffman symbol table.
+ */
+#define DEFLATE_FAST_BITS 10
+
+/** Minimum remaining input data length for fast decoding
+ *
+ * A single literal/length and distance pair occupies at most 49 bits
+ * of input, and the bit accumulator may read up to eight bytes
+ * ahead.
+ */
+#define DEFLATE_FAST_MIN_IN 32
+
+/** Minimum remaining output buffer length for fast decoding
+ *
+ * A single duplicated string has a maximum length of 258 bytes, and
+ * the string copy may overrun by up to seven bytes.
+ */
+#define DEFLATE_FAST_MIN_OUT ( 258 + 8 )
+
+/** Fast lookup table entry extra bits mask */
+#define DEFLATE_FAST_EXTRA_MASK 0x1f
+
+/** Fast lookup table entry represents a literal value */
+#define DEFLATE_FAST_LITERAL 0x40
+
+/** Fast lookup table entry represents the end of block */
+#define DEFLATE_FAST_END 0x80
+
+/** Maximum expansion ratio
+ *
+ * A duplicated string of the maximum length (258 bytes) may be
+ * encoded using as little as a single bit for each of the
+ * literal/length and distance codes.
+ */
+#define DEFLATE_MAX_EXPANSION ( 258 * 8 / 2 )
+
 /** Literal/length end of block code */
 #define DEFLATE_LITLEN_END 256
 
@@ -130,12 +169,29 @@ struct deflate_huf_symbols {
 	uint16_t *raw;
 };
 
+/** A fast lookup table entry */
+struct deflate_fast {
+	/** Value (literal byte, base length, or base distance) */
+	uint16_t value;
+	/** Length of Huffman-coded symbol (in bits), or zero if too long */
+	uint8_t bits;
+	/** Number of extra bits, and flags */
+	uint8_t extra;
+};
+
 /** A Huffman-coded alphabet */
 struct deflate_alphabet {
 	/** Huffman-coded symbol set for each length */
 	struct deflate_huf_symbols huf[DEFLATE_HUFFMAN_BITS];
 	/** Quick lookup table */
 	uint8_t lookup[ 1 << DEFLATE_HUFFMAN_QL_BITS ];
+	/** Fast lookup table
+	 *
+	 * Indexed by the next (non-bit-reversed) input bits, and
+	 * populated only for the literal/length and distance
+	 * alphabets.
+	 */
+	struct deflate_fast fast[ 1 << DEFLATE_FAST_BITS ];
 	/** Raw symbols
 	 *
 	 * Ordered by Huffman-coded symbol length, then by symbol
@@ -279,10 +335,69 @@ static inline int deflate_finished ( struct deflate *deflate ) {
 	return ( deflate->resume == NULL );
 }
 
+/** Minimum DEFLATE compressor match length */
+#define DEFLATE_ENCODE_MIN_MATCH 3
+
+/** Maximum DEFLATE compressor match length */
+#define DEFLATE_ENCODE_MAX_MATCH 258
+
+/** Maximum DEFLATE compressor match distance */
+#define DEFLATE_ENCODE_MAX_DISTANCE 32768
+
+/** Number of bits in DEFLATE compressor match hash table index */
+#define DEFLATE_ENCODE_HASH_BITS 12
+
+/** Maximum length of a single compressed symbol (including any
+ * pending bits)
+ */
+#define DEFLATE_ENCODE_MAX_SYMBOL_LEN 8
+
+/** A DEFLATE compressor
+ *
+ * The compressor produces a single block using the static Huffman
+ * codes, finding matches directly within the (complete) input data
+ * so that no separate sliding window is required.
+ */
+struct deflate_encoder {
+	/** Input data */
+	const uint8_t *data;
+	/** Length of input data */
+	size_t len;
+	/** Current input offset */
+	size_t offset;
+	/** Pending output bits */
+	uint32_t bits;
+	/** Number of pending output bits */
+	unsigned int count;
+	/** Compression has finished */
+	int finished;
+	/** Bit-reversed static literal/length codes */
+	uint16_t codes[ DEFLATE_LITLEN_MAX_CODE + 1 ];
+	/** Most recent input offset (plus one) for each hash value */
+	uint32_t head[ 1 << DEFLATE_ENCODE_HASH_BITS ];
+};
+
+/**
+ * Check if compression has finished
+ *
+ * @v encoder		Compressor
+ * @ret finished	Compression has finished
+ */
+static inline int deflate_encode_finished ( struct deflate_encoder *encoder ) {
+	return encoder->finished;
+}
+
 extern void deflate_init ( struct deflate *deflate,
 			   enum deflate_format format );
 extern int deflate_inflate ( struct deflate *deflate,
 			     const void *data, size_t len,
 			     struct deflate_chunk *out );
+extern size_t deflate_trailer ( struct deflate *deflate, void *data,
+			       size_t len );
+
+extern void deflate_encode_init ( struct deflate_encoder *encoder,
+				  const void *data, size_t len );
+extern void deflate_encode ( struct deflate_encoder *encoder,
+			     struct deflate_chunk *out );
 
 #endif /* _IPXE_DEFLATE_H */
@@ -213,6 +213,9 @@ struct dhcp_pxe_boot_menu_item {
 /** Maximum DHCP message size */
 #define DHCP_MAX_MESSAGE_SIZE 57
 
+/** Renewal (T1) time */
+#define DHCP_RENEWAL_TIME 58
+
 /** Vendor class identifier */
 #define DHCP_VENDOR_CLASS_ID 60
 
@@ -267,6 +270,14 @@ struct dhcp_client_id {
 /** User class identifier */
 #define DHCP_USER_CLASS_ID 77
 
+/** Rapid Commit
+ *
+ * This option has no data.  A client may include it within a
+ * DHCPDISCOVER to request that the server respond immediately with a
+ * DHCPACK, omitting the DHCPOFFER and DHCPREQUEST (RFC 4039).
+ */
+#define DHCP_RAPID_COMMIT 80
+
 /** Client system architecture */
 #define DHCP_CLIENT_ARCHITECTURE 93
 
@@ -365,6 +376,9 @@ struct dhcp_client_uuid {
  */
 #define DHCP_EB_PRIORITY DHCP_ENCAP_OPT ( DHCP_EB_ENCAP, 0x01 )
 
+/** Maximum priority of an options block */
+#define DHCP_EB_PRIORITY_MAX 127
+
 /** "Your" IP address
  *
  * This option is used internally to contain the value of the "yiaddr"
@@ -62,6 +62,18 @@ struct dns_name {
  */
 #define DNS_MAX_CNAME_RECURSION 32
 
+/** Maximum number of cached DNS resolutions
+ *
+ * This is a policy decision.
+ */
+#define DNS_CACHE_MAX 16
+
+/** Maximum lifetime of a cached DNS resolution (in seconds)
+ *
+ * This is a policy decision.
+ */
+#define DNS_CACHE_MAX_TTL 86400
+
 /** A DNS packet header */
 struct dns_header {
 	/** Query identifier */
@@ -81,6 +93,17 @@ struct dns_header {
 /** Recursion desired flag */
 #define DNS_FLAG_RD 0x0100
 
+/**
+ * Extract DNS response code
+ *
+ * @v flags		Flags (in host byte order)
+ * @ret rcode		Response code
+ */
+#define DNS_RCODE( flags ) ( (flags) & 0x000f )
+
+/** DNS response code "name error" */
+#define DNS_RCODE_NXDOMAIN 3
+
 /** A DNS question */
 struct dns_question {
 	/** Query type */
@@ -135,6 +158,26 @@ struct dns_rr_cname {
 	struct dns_rr_common common;
 } __attribute__ (( packed ));
 
+/** Type of a DNS "SOA" record */
+#define DNS_TYPE_SOA 6
+
+/** Fixed fields of a DNS "SOA" record
+ *
+ * These follow the variable-length MNAME and RNAME fields.
+ */
+struct dns_soa {
+	/** Serial number */
+	uint32_t serial;
+	/** Refresh interval */
+	uint32_t refresh;
+	/** Retry interval */
+	uint32_t retry;
+	/** Expiry limit */
+	uint32_t expire;
+	/** Minimum time to live (used for negative caching) */
+	uint32_t minimum;
+} __attribute__ (( packed ));
+
 /** A DNS resource record */
 union dns_rr {
 	/** Common fields */
@@ -13,6 +13,10 @@ FILE_SECBOOT ( PERMITTED );
 struct interface;
 struct image;
 
-extern int create_downloader ( struct interface *job, struct image *image );
+/** Decompress data during download */
+#define DOWNLOAD_DECOMPRESS 0x0001
+
+extern int create_downloader ( struct interface *job, struct image *image,
+			       unsigned int flags );
 
 #endif /* _IPXE_DOWNLOADER_H */
@@ -12,6 +12,8 @@ FILE_SECBOOT ( PERMITTED );
 
 #include <ipxe/crypto.h>
 
+extern int ecdhe_shared ( struct elliptic_curve *curve, const void *partner,
+			  const void *private, void *shared );
 extern int ecdhe_key ( struct elliptic_curve *curve, const void *partner,
 		       const void *private, void *public, void *shared );
 
@@ -18,6 +18,7 @@ struct net_device;
 struct uri;
 struct iscsi_session;
 struct aoe_device;
+struct nvmetcp_device;
 struct fcp_description;
 struct ib_srp_device;
 struct usb_function;
@@ -56,6 +57,8 @@ extern EFI_DEVICE_PATH_PROTOCOL * efi_uri_path ( struct uri *uri );
 extern EFI_DEVICE_PATH_PROTOCOL *
 efi_iscsi_path ( struct iscsi_session *iscsi );
 extern EFI_DEVICE_PATH_PROTOCOL * efi_aoe_path ( struct aoe_device *aoedev );
+extern EFI_DEVICE_PATH_PROTOCOL *
+efi_nvmetcp_path ( struct nvmetcp_device *nvme );
 extern EFI_DEVICE_PATH_PROTOCOL * efi_fcp_path ( struct fcp_description *desc );
 extern EFI_DEVICE_PATH_PROTOCOL *
 efi_ib_srp_path ( struct ib_srp_device *ib_srp );
@@ -21,9 +21,7 @@ FILE_SECBOOT ( PERMITTED );
 #include <ipxe/efi/Protocol/HiiDatabase.h>
 #include <ipxe/efi/Protocol/LoadFile.h>
 #include <ipxe/efi/Protocol/VlanConfig.h>
-
-/** SNP transmit completion ring size */
-#define EFI_SNP_NUM_TX 32
+#include <config/netdev.h>
 
 /** An SNP device */
 struct efi_snp_device {
@@ -51,6 +49,8 @@ struct efi_snp_device {
 	unsigned int tx_cons;
 	/** Receive queue */
 	struct list_head rx;
+	/** Number of packets in receive queue */
+	unsigned int rx_count;
 	/** The network interface identifier */
 	EFI_NETWORK_INTERFACE_IDENTIFIER_PROTOCOL nii;
 	/** VLAN configuration protocol */
@@ -90,6 +90,12 @@ FILE_SECBOOT ( PERMITTED );
 #define ERRFILE_efi_connect	       ( ERRFILE_CORE | 0x00310000 )
 #define ERRFILE_gpio		       ( ERRFILE_CORE | 0x00320000 )
 #define ERRFILE_spcr		       ( ERRFILE_CORE | 0x00330000 )
+#define ERRFILE_blockcache	       ( ERRFILE_CORE | 0x00340000 )
+#define ERRFILE_inflate		       ( ERRFILE_CORE | 0x00350000 )
+#define ERRFILE_bench		       ( ERRFILE_CORE | 0x00360000 )
+#define ERRFILE_uheap		       ( ERRFILE_CORE | 0x00370000 )
+#define ERRFILE_imgcache	       ( ERRFILE_CORE | 0x00380000 )
+#define ERRFILE_imgblock	       ( ERRFILE_CORE | 0x00390000 )
 
 #define ERRFILE_eisa		     ( ERRFILE_DRIVER | 0x00000000 )
 #define ERRFILE_isa		     ( ERRFILE_DRIVER | 0x00010000 )
@@ -323,6 +329,21 @@ FILE_SECBOOT ( PERMITTED );
 #define ERRFILE_eap_md5			( ERRFILE_NET | 0x004d0000 )
 #define ERRFILE_eap_mschapv2		( ERRFILE_NET | 0x004e0000 )
 #define ERRFILE_syslogs			( ERRFILE_NET | 0x004f0000 )
+#define ERRFILE_httpmux			( ERRFILE_NET | 0x00500000 )
+#define ERRFILE_tcp_cubic		( ERRFILE_NET | 0x00510000 )
+#define ERRFILE_tcpreasm		( ERRFILE_NET | 0x00520000 )
+#define ERRFILE_httpblock		( ERRFILE_NET | 0x00530000 )
+#define ERRFILE_http2			( ERRFILE_NET | 0x00540000 )
+#define ERRFILE_hpack			( ERRFILE_NET | 0x00550000 )
+#define ERRFILE_rsfec			( ERRFILE_NET | 0x00560000 )
+#define ERRFILE_alc			( ERRFILE_NET | 0x00570000 )
+#define ERRFILE_fragment		( ERRFILE_NET | 0x00580000 )
+#define ERRFILE_nvmetcp		( ERRFILE_NET | 0x00590000 )
+#define ERRFILE_peerserv		( ERRFILE_NET | 0x005a0000 )
+#define ERRFILE_bond			( ERRFILE_NET | 0x005b0000 )
+#define ERRFILE_pcap			( ERRFILE_NET | 0x005c0000 )
+#define ERRFILE_httpgzip		( ERRFILE_NET | 0x005d0000 )
+#define ERRFILE_pcapreplay		( ERRFILE_NET | 0x005e0000 )
 
 #define ERRFILE_image		      ( ERRFILE_IMAGE | 0x00000000 )
 #define ERRFILE_elf		      ( ERRFILE_IMAGE | 0x00010000 )
@@ -340,6 +361,8 @@ FILE_SECBOOT ( PERMITTED );
 #define ERRFILE_efi_siglist	      ( ERRFILE_IMAGE | 0x000d0000 )
 #define ERRFILE_lkrn		      ( ERRFILE_IMAGE | 0x000e0000 )
 #define ERRFILE_initrd		      ( ERRFILE_IMAGE | 0x000f0000 )
+#define ERRFILE_zstd		      ( ERRFILE_IMAGE | 0x00100000 )
+#define ERRFILE_xz		      ( ERRFILE_IMAGE | 0x00110000 )
 
 #define ERRFILE_asn1		      ( ERRFILE_OTHER | 0x00000000 )
 #define ERRFILE_chap		      ( ERRFILE_OTHER | 0x00010000 )
@@ -447,6 +470,18 @@ FILE_SECBOOT ( PERMITTED );
 #define ERRFILE_efi_cacert	      ( ERRFILE_OTHER | 0x00670000 )
 #define ERRFILE_ecdhe		      ( ERRFILE_OTHER | 0x00680000 )
 #define ERRFILE_ecdsa		      ( ERRFILE_OTHER | 0x00690000 )
+#define ERRFILE_chacha20	      ( ERRFILE_OTHER | 0x006a0000 )
+#define ERRFILE_lzma		      ( ERRFILE_OTHER | 0x006b0000 )
+#define ERRFILE_heap_settings	      ( ERRFILE_OTHER | 0x006c0000 )
+#define ERRFILE_tcp_bench	      ( ERRFILE_OTHER | 0x006d0000 )
+#define ERRFILE_crypto_bench	      ( ERRFILE_OTHER | 0x006e0000 )
+#define ERRFILE_nbft		      ( ERRFILE_OTHER | 0x006f0000 )
+#define ERRFILE_profstat_cmd	      ( ERRFILE_OTHER | 0x00700000 )
+#define ERRFILE_prewarm_cmd	      ( ERRFILE_OTHER | 0x00710000 )
+#define ERRFILE_bond_cmd	      ( ERRFILE_OTHER | 0x00720000 )
+#define ERRFILE_pcap_cmd	      ( ERRFILE_OTHER | 0x00730000 )
+#define ERRFILE_linux_local	      ( ERRFILE_OTHER | 0x00740000 )
+#define ERRFILE_pcap_bench	      ( ERRFILE_OTHER | 0x00750000 )
 
 /** @} */
 
@@ -24,6 +24,9 @@ FILE_SECBOOT ( PERMITTED );
 /** Transparent background magic colour (raw colour value) */
 #define FBCON_TRANSPARENT 0xffffffff
 
+/** Number of colour pairs held in the glyph row cache */
+#define FBCON_GLYPH_CACHE 4
+
 /** A font glyph */
 struct fbcon_font_glyph {
 	/** Row bitmask */
@@ -103,6 +106,20 @@ struct fbcon_text {
 	struct fbcon_text_cell *cells;
 };
 
+/** A frame buffer glyph row cache entry
+ *
+ * Each entry holds a pre-rendered pixel row for every possible glyph
+ * row bitmask, for a single foreground and background colour pair.
+ */
+struct fbcon_glyph_rows {
+	/** Foreground raw colour */
+	uint32_t foreground;
+	/** Background raw colour */
+	uint32_t background;
+	/** Pre-rendered rows (indexed by glyph row bitmask) */
+	void *rows;
+};
+
 /** A frame buffer background picture */
 struct fbcon_picture {
 	/** Start address */
@@ -145,6 +162,10 @@ struct fbcon {
 	struct fbcon_text text;
 	/** Background picture */
 	struct fbcon_picture picture;
+	/** Glyph row cache */
+	struct fbcon_glyph_rows cache[FBCON_GLYPH_CACHE];
+	/** Next glyph row cache entry to be replaced */
+	unsigned int cache_next;
 	/** Display cursor */
 	int show_cursor;
 };
@@ -268,6 +268,8 @@ struct fc_port {
 	struct fc_port_id port_id;
 	/** Flags */
 	unsigned int flags;
+	/** Maximum frame data field size */
+	size_t mtu;
 
 	/** Link state monitor */
 	struct fc_link_state link;
@@ -355,6 +357,8 @@ struct fc_peer {
 	struct fc_port *port;
 	/** Peer port ID, if known */
 	struct fc_port_id port_id;
+	/** Peer receive data field size, if known */
+	size_t mtu;
 
 	/** List of upper-layer protocols */
 	struct list_head ulps;
@@ -168,6 +168,12 @@ struct fc_login_common {
 /** Fibre Channel default MTU */
 #define FC_LOGIN_DEFAULT_MTU 1452
 
+/** Fibre Channel maximum MTU */
+#define FC_LOGIN_MAX_MTU 2112
+
+/** Receive data field size portion of login MTU field */
+#define FC_LOGIN_MTU_MASK 0x0fff
+
 /** Default maximum number of concurrent sequences */
 #define FC_LOGIN_DEFAULT_MAX_SEQ 255
 
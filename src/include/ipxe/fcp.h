@@ -43,6 +43,9 @@ struct fcp_cmnd {
 /** FCP tag magic marker */
 #define FCP_TAG_MAGIC 0x18ae0000
 
+/** Maximum number of concurrent FCP exchanges per device */
+#define FCP_MAX_COMMANDS 16
+
 /** An FCP transfer ready IU */
 struct fcp_xfer_rdy {
 	/** Relative offset of data */
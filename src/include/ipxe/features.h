@@ -56,6 +56,7 @@ FILE_SECBOOT ( PERMITTED );
 #define DHCP_EB_FEATURE_MENU		0x27 /**< Menu support */
 #define DHCP_EB_FEATURE_SDI		0x28 /**< SDI image support */
 #define DHCP_EB_FEATURE_NFS		0x29 /**< NFS protocol */
+#define DHCP_EB_FEATURE_NVME_TCP	0x2a /**< NVMe/TCP protocol */
 
 /** @} */
 
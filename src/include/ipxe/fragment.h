@@ -18,24 +18,57 @@ FILE_SECBOOT ( PERMITTED );
 /** Fragment reassembly timeout */
 #define FRAGMENT_TIMEOUT ( TICKS_PER_SEC / 2 )
 
+/** Maximum number of fragments per reassembled packet */
+#define FRAGMENT_MAX_PARTS 64
+
+/** Maximum length of fragmentable portion of reassembled packet */
+#define FRAGMENT_MAX_LEN 65535
+
+/** Maximum number of concurrent fragment reassembly buffers */
+#define FRAGMENT_MAX_BUFFERS 16
+
+/** A received fragment */
+struct fragment_part {
+	/** I/O buffer */
+	struct io_buffer *iobuf;
+	/** Length of non-fragmentable portion of I/O buffer */
+	size_t hdrlen;
+	/** Offset of fragment within reassembled packet */
+	size_t offset;
+};
+
 /** A fragment reassembly buffer */
 struct fragment {
 	/* List of fragment reassembly buffers */
 	struct list_head list;
-	/** Reassembled packet */
+	/** First received fragment
+	 *
+	 * This is used to identify subsequent fragments belonging to
+	 * the same packet.
+	 */
 	struct io_buffer *iobuf;
-	/** Length of non-fragmentable portion of reassembled packet */
+	/** Length of non-fragmentable portion of first received fragment */
 	size_t hdrlen;
 	/** Reassembly timer */
 	struct retry_timer timer;
 	/** Fragment reassembler */
 	struct fragment_reassembler *fragments;
+	/** Received fragments, in order of offset */
+	struct fragment_part parts[FRAGMENT_MAX_PARTS];
+	/** Number of received fragments */
+	unsigned int count;
+	/** Length of fragmentable portion received so far */
+	size_t received;
+	/** Total length of fragmentable portion, or zero if not yet known */
+	size_t len;
 };
 
 /** A fragment reassembler */
 struct fragment_reassembler {
-	/** List of fragment reassembly buffers */
+	/** List of fragment reassembly buffers, most recently used first */
 	struct list_head list;
+	/** Number of fragment reassembly buffers */
+	unsigned int count;
 	/**
 	 * Check if fragment matches fragment reassembly buffer
 	 *
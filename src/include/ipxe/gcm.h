@@ -11,6 +11,7 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 FILE_SECBOOT ( PERMITTED );
 
 #include <stdint.h>
+#include <ipxe/tables.h>
 #include <ipxe/crypto.h>
 
 /** A GCM counter */
@@ -53,12 +54,59 @@ struct gcm_context {
 	union gcm_block ctr;
 	/** Hash key (H) */
 	union gcm_block key;
+	/** Hardware accelerator (if any) */
+	struct gcm_accelerator *accel;
 	/** Underlying block cipher */
 	struct cipher_algorithm *raw_cipher;
 	/** Underlying block cipher context */
 	uint8_t raw_ctx[0];
 };
 
+/** A GCM hardware accelerator */
+struct gcm_accelerator {
+	/** Name */
+	const char *name;
+	/** Underlying block cipher */
+	struct cipher_algorithm *raw_cipher;
+	/**
+	 * Check if accelerator is usable
+	 *
+	 * @ret rc		Return status code
+	 */
+	int ( * probe ) ( void );
+	/**
+	 * Multiply polynomial by hash key in situ
+	 *
+	 * @v key		Hash key
+	 * @v poly		Multiplicand and result
+	 */
+	void ( * multiply ) ( const union gcm_block *key,
+			      union gcm_block *poly );
+	/**
+	 * Encrypt/decrypt whole blocks and update hash
+	 *
+	 * @v context		Context
+	 * @v src		Input data
+	 * @v dst		Output data
+	 * @v count		Number of blocks
+	 * @v encrypt		Perform encryption (rather than decryption)
+	 *
+	 * The counter must be advanced by the number of blocks
+	 * processed.  Accumulated lengths are handled by the caller.
+	 */
+	void ( * crypt ) ( struct gcm_context *context, const void *src,
+			   void *dst, size_t count, int encrypt );
+};
+
+/** GCM hardware accelerator table */
+#define GCM_ACCELERATORS \
+	__table ( struct gcm_accelerator, "gcm_accelerators" )
+
+/** Declare a GCM hardware accelerator */
+#define __gcm_accelerator __table_entry ( GCM_ACCELERATORS, 01 )
+
+extern int gcm_accel_disabled;
+
 extern void gcm_tag ( struct gcm_context *context, union gcm_block *tag );
 extern int gcm_setkey ( struct gcm_context *context, const void *key,
 			size_t keylen, struct cipher_algorithm *raw_cipher );
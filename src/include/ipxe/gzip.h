@@ -47,6 +47,9 @@ struct gzip_header {
 /** File comment is present */
 #define GZIP_FL_COMMENT 0x10
 
+/** Unknown operating system */
+#define GZIP_OS_UNKNOWN 0xff
+
 /** gzip extra header */
 struct gzip_extra_header {
 	/** Extra header length (excluding this field) */
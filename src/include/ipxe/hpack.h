@@ -0,0 +1,84 @@
+#ifndef _IPXE_HPACK_H
+#define _IPXE_HPACK_H
+
+/** @file
+ *
+ * HPACK header compression
+ *
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+FILE_SECBOOT ( PERMITTED );
+
+#include <stddef.h>
+#include <ipxe/list.h>
+
+/** An HPACK header field */
+struct hpack_header {
+	/** Name */
+	const char *name;
+	/** Length of name */
+	size_t name_len;
+	/** Value */
+	const char *value;
+	/** Length of value */
+	size_t value_len;
+};
+
+/** An HPACK dynamic table entry */
+struct hpack_entry {
+	/** List of dynamic table entries */
+	struct list_head list;
+	/** Header field
+	 *
+	 * The name and value point to the data following this
+	 * structure.
+	 */
+	struct hpack_header header;
+};
+
+/** An HPACK dynamic table */
+struct hpack_table {
+	/** Entries (newest first) */
+	struct list_head entries;
+	/** Current size */
+	size_t size;
+	/** Current maximum size */
+	size_t max;
+	/** Maximum size permitted by protocol settings */
+	size_t limit;
+};
+
+/** Overhead added to the size of each dynamic table entry */
+#define HPACK_ENTRY_OVERHEAD 32
+
+/** Default dynamic table size limit */
+#define HPACK_DEFAULT_TABLE_SIZE 4096
+
+/** Number of entries in HPACK static table */
+#define HPACK_STATIC_ENTRIES 61
+
+/**
+ * Initialise HPACK dynamic table
+ *
+ * @v table		Dynamic table
+ * @v limit		Maximum size permitted by protocol settings
+ */
+static inline __attribute__ (( always_inline )) void
+hpack_init ( struct hpack_table *table, size_t limit ) {
+
+	INIT_LIST_HEAD ( &table->entries );
+	table->size = 0;
+	table->max = limit;
+	table->limit = limit;
+}
+
+extern int hpack_decode ( struct hpack_table *table, const void *data,
+			  size_t len,
+			  int ( * emit ) ( void *ctx,
+					   struct hpack_header *header ),
+			  void *ctx );
+extern size_t hpack_encode ( void *data, struct hpack_header *header );
+extern void hpack_flush ( struct hpack_table *table );
+
+#endif /* _IPXE_HPACK_H */
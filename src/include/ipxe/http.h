@@ -113,11 +113,8 @@ extern struct http_method http_post;
  ******************************************************************************
  */
 
-/** HTTP Digest authentication client nonce count
- *
- * We choose to generate a new client nonce each time.
- */
-#define HTTP_DIGEST_NC "00000001"
+/** HTTP Digest authentication nonce count length */
+#define HTTP_DIGEST_NC_LEN 8
 
 /** HTTP Digest authentication client nonce length
  *
@@ -148,8 +145,32 @@ struct http_request_content {
 	const void *data;
 	/** Content length */
 	size_t len;
+	/** Content flags */
+	unsigned int flags;
 };
 
+/** Request content should be compressed using the gzip encoding
+ *
+ * Compressed content is generated on the fly from the original
+ * content data (which must therefore remain valid for the lifetime
+ * of the transaction), and is sent using the chunked transfer
+ * encoding.
+ */
+#define HTTP_CONTENT_GZIP 0x0001
+
+/** Maximum length of generated request content in each chunk
+ *
+ * This is a policy decision.
+ */
+#define HTTP_UPLOAD_CHUNK_LEN 4096
+
+/** Length of request content chunk header (e.g. "1000\r\n") */
+#define HTTP_UPLOAD_CHUNK_HDR_LEN 6
+
+/** Length of request content chunk trailer and final empty chunk */
+#define HTTP_UPLOAD_CHUNK_TRAILER_LEN \
+	( 2 /* "\r\n" */ + 5 /* "0\r\n\r\n" */ )
+
 /** HTTP request Basic authentication descriptor */
 struct http_request_auth_basic {
 	/** Username */
@@ -168,6 +189,8 @@ struct http_request_auth_digest {
 	const char *algorithm;
 	/** Client nonce */
 	char cnonce[ HTTP_DIGEST_CNONCE_LEN + 1 /* NUL */ ];
+	/** Nonce count */
+	char nc[ HTTP_DIGEST_NC_LEN + 1 /* NUL */ ];
 	/** Response */
 	char response[ HTTP_DIGEST_RESPONSE_LEN + 1 /* NUL */ ];
 };
@@ -188,6 +211,14 @@ struct http_request_auth_ntlm {
 struct http_request_auth {
 	/** Authentication scheme (if any) */
 	struct http_authentication *auth;
+	/** Copy of cached challenge used for preemptive authentication
+	 *
+	 * This is NULL unless the request is being authenticated
+	 * preemptively, without having first received a challenge.
+	 */
+	char *preempt;
+	/** Number of times challenge has been used (or zero if unknown) */
+	unsigned int count;
 	/** Per-scheme information */
 	union {
 		/** Basic authentication descriptor */
@@ -266,6 +297,16 @@ struct http_response_content {
 	struct http_content_encoding *encoding;
 };
 
+/** HTTP response range descriptor */
+struct http_response_range {
+	/** Range start */
+	size_t start;
+	/** Range length */
+	size_t len;
+	/** Total length of complete content (or zero if unknown) */
+	size_t total;
+};
+
 /** HTTP response Basic authorization descriptor */
 struct http_response_auth_basic {
 };
@@ -339,14 +380,22 @@ struct http_response {
 	int rc;
 	/** Redirection location */
 	const char *location;
+	/** Entity tag (if any) */
+	const char *etag;
+	/** Last modification date (if any) */
+	const char *last_modified;
 	/** Transfer descriptor */
 	struct http_response_transfer transfer;
 	/** Content descriptor */
 	struct http_response_content content;
+	/** Range descriptor */
+	struct http_response_range range;
 	/** Authorization descriptor */
 	struct http_response_auth auth;
 	/** Retry delay (in seconds) */
 	unsigned int retry_after;
+	/** Maximum cacheable age (in seconds) */
+	unsigned int max_age;
 	/** Flags */
 	unsigned int flags;
 };
@@ -359,6 +408,14 @@ enum http_response_flags {
 	HTTP_RESPONSE_CONTENT_LEN = 0x0002,
 	/** Transaction may be retried on failure */
 	HTTP_RESPONSE_RETRY = 0x0004,
+	/** Server accepts byte range requests */
+	HTTP_RESPONSE_ACCEPT_RANGES = 0x0008,
+	/** Content range specified */
+	HTTP_RESPONSE_CONTENT_RANGE = 0x0010,
+	/** Maximum cacheable age specified */
+	HTTP_RESPONSE_MAX_AGE = 0x0020,
+	/** Response must not be cached */
+	HTTP_RESPONSE_NO_CACHE = 0x0040,
 };
 
 /** An HTTP response header */
@@ -412,6 +469,30 @@ struct http_state {
 	void ( * close ) ( struct http_transaction *http, int rc );
 };
 
+/** HTTP transfer resumption descriptor */
+struct http_resume {
+	/** Number of resumption attempts made */
+	unsigned int count;
+	/** Offset of current response within complete content */
+	size_t offset;
+	/** Total length of complete content (or zero if not resuming) */
+	size_t total;
+	/** Entity validator (entity tag or last modification date) */
+	char *validator;
+};
+
+/** HTTP chunked transfer encoding parser state */
+enum http_chunk_state {
+	/** Awaiting start of chunk header line */
+	HTTP_CHUNK_START = 0,
+	/** Parsing chunk length */
+	HTTP_CHUNK_LEN,
+	/** Skipping chunk extensions and line terminator */
+	HTTP_CHUNK_EXT,
+	/** Receiving chunk data */
+	HTTP_CHUNK_DATA,
+};
+
 /** An HTTP transaction */
 struct http_transaction {
 	/** Reference count */
@@ -440,12 +521,24 @@ struct http_transaction {
 	/** Temporary line buffer */
 	struct line_buffer linebuf;
 
+	/** Cached redirection location (if any) */
+	char *redirect;
+
 	/** Transaction state */
 	struct http_state *state;
 	/** Accumulated transfer-decoded length */
 	size_t len;
 	/** Chunk length remaining */
 	size_t remaining;
+	/** Chunked transfer encoding parser state */
+	enum http_chunk_state chunk;
+	/** Transfer resumption descriptor */
+	struct http_resume resume;
+	/** Request content upload state (if any) */
+	struct http_upload *upload;
+
+	/** Block device read-ahead cache (if any) */
+	struct http_block_cache *cache;
 };
 
 /******************************************************************************
@@ -541,6 +634,10 @@ struct http_authentication {
 	 */
 	int ( * format ) ( struct http_transaction *http, char *buf,
 			   size_t len );
+	/** Challenge may be reused to authenticate later requests
+	 * preemptively
+	 */
+	int preemptive;
 };
 
 /** HTTP authentication scheme table */
@@ -559,9 +656,23 @@ struct http_authentication {
 
 extern char * http_token ( char **line, char **value );
 extern int http_connect ( struct interface *xfer, struct uri *uri );
+extern int http_prewarm ( struct uri *uri );
 extern int http_open ( struct interface *xfer, struct http_method *method,
 		       struct uri *uri, struct http_request_range *range,
 		       struct http_request_content *content );
 extern int http_open_uri ( struct interface *xfer, struct uri *uri );
+extern int http_gzip_upload ( struct http_transaction *http, void *data,
+			      size_t *len );
+extern int httpmux_open ( struct interface *xfer, struct uri *uri );
+extern void http_block_close ( struct http_transaction *http, int rc );
+
+extern const char * http2_offer ( struct http_connection *conn );
+extern int http2_upgrade ( struct http_connection *conn );
+extern int http2_connect ( struct interface *xfer, struct uri *uri,
+			   struct http_scheme *scheme, unsigned int port );
+
+extern void http_accept_ranges ( struct interface *intf, size_t len );
+#define http_accept_ranges_TYPE( object_type ) \
+	typeof ( void ( object_type, size_t len ) )
 
 #endif /* _IPXE_HTTP_H */
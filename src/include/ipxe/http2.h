@@ -0,0 +1,294 @@
+#ifndef _IPXE_HTTP2_H
+#define _IPXE_HTTP2_H
+
+/** @file
+ *
+ * Hyper Text Transfer Protocol version 2 (HTTP/2)
+ *
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+FILE_SECBOOT ( PERMITTED );
+
+#include <stdint.h>
+#include <ipxe/refcnt.h>
+#include <ipxe/interface.h>
+#include <ipxe/process.h>
+#include <ipxe/retry.h>
+#include <ipxe/iobuf.h>
+#include <ipxe/list.h>
+#include <ipxe/uri.h>
+#include <ipxe/xferbuf.h>
+#include <ipxe/hpack.h>
+#include <ipxe/http.h>
+
+/** HTTP/2 application protocol name (for ALPN) */
+#define HTTP2_ALPN "h2"
+
+/** HTTP/2 connection preface */
+#define HTTP2_PREFACE "PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n"
+
+/** An HTTP/2 frame header */
+struct http2_frame_header {
+	/** Length (24 bits) and type (8 bits) */
+	uint32_t len_type;
+	/** Flags */
+	uint8_t flags;
+	/** Stream identifier */
+	uint32_t stream;
+} __attribute__ (( packed ));
+
+/** Construct HTTP/2 frame length and type field */
+#define HTTP2_LEN_TYPE( len, type ) \
+	htonl ( ( (len) << 8 ) | (type) )
+
+/** Extract length from HTTP/2 frame length and type field */
+#define HTTP2_LEN( len_type ) ( ntohl ( len_type ) >> 8 )
+
+/** Extract type from HTTP/2 frame length and type field */
+#define HTTP2_TYPE( len_type ) ( ntohl ( len_type ) & 0xff )
+
+/** Stream identifier mask (excluding reserved bit) */
+#define HTTP2_STREAM_MASK 0x7fffffffUL
+
+/** DATA frame */
+#define HTTP2_DATA 0x0
+
+/** HEADERS frame */
+#define HTTP2_HEADERS 0x1
+
+/** PRIORITY frame */
+#define HTTP2_PRIORITY 0x2
+
+/** RST_STREAM frame */
+#define HTTP2_RST_STREAM 0x3
+
+/** SETTINGS frame */
+#define HTTP2_SETTINGS 0x4
+
+/** PUSH_PROMISE frame */
+#define HTTP2_PUSH_PROMISE 0x5
+
+/** PING frame */
+#define HTTP2_PING 0x6
+
+/** GOAWAY frame */
+#define HTTP2_GOAWAY 0x7
+
+/** WINDOW_UPDATE frame */
+#define HTTP2_WINDOW_UPDATE 0x8
+
+/** CONTINUATION frame */
+#define HTTP2_CONTINUATION 0x9
+
+/** End of stream flag */
+#define HTTP2_FL_END_STREAM 0x01
+
+/** Acknowledgement flag (SETTINGS and PING frames) */
+#define HTTP2_FL_ACK 0x01
+
+/** End of headers flag */
+#define HTTP2_FL_END_HEADERS 0x04
+
+/** Padded flag */
+#define HTTP2_FL_PADDED 0x08
+
+/** Priority flag */
+#define HTTP2_FL_PRIORITY 0x20
+
+/** Length of priority fields within HEADERS frame */
+#define HTTP2_PRIORITY_LEN 5
+
+/** An HTTP/2 setting */
+struct http2_setting {
+	/** Identifier */
+	uint16_t id;
+	/** Value */
+	uint32_t value;
+} __attribute__ (( packed ));
+
+/** Header table size setting */
+#define HTTP2_SETTINGS_HEADER_TABLE_SIZE 0x1
+
+/** Enable server push setting */
+#define HTTP2_SETTINGS_ENABLE_PUSH 0x2
+
+/** Maximum concurrent streams setting */
+#define HTTP2_SETTINGS_MAX_CONCURRENT_STREAMS 0x3
+
+/** Initial window size setting */
+#define HTTP2_SETTINGS_INITIAL_WINDOW_SIZE 0x4
+
+/** Maximum frame size setting */
+#define HTTP2_SETTINGS_MAX_FRAME_SIZE 0x5
+
+/** Maximum header list size setting */
+#define HTTP2_SETTINGS_MAX_HEADER_LIST_SIZE 0x6
+
+/** A GOAWAY frame payload */
+struct http2_goaway {
+	/** Last stream identifier */
+	uint32_t last;
+	/** Error code */
+	uint32_t error;
+} __attribute__ (( packed ));
+
+/** No error */
+#define HTTP2_NO_ERROR 0x0
+
+/** Protocol error */
+#define HTTP2_PROTOCOL_ERROR 0x1
+
+/** Internal error */
+#define HTTP2_INTERNAL_ERROR 0x2
+
+/** Flow control error */
+#define HTTP2_FLOW_CONTROL_ERROR 0x3
+
+/** Frame size error */
+#define HTTP2_FRAME_SIZE_ERROR 0x6
+
+/** Stream refused before any application processing */
+#define HTTP2_REFUSED_STREAM 0x7
+
+/** Stream cancelled */
+#define HTTP2_CANCEL 0x8
+
+/** Header compression error */
+#define HTTP2_COMPRESSION_ERROR 0x9
+
+/** Default (and minimum) maximum frame size */
+#define HTTP2_DEFAULT_MAX_FRAME 16384
+
+/** Largest permitted maximum frame size */
+#define HTTP2_MAX_MAX_FRAME 0xffffff
+
+/** Default initial flow control window size */
+#define HTTP2_DEFAULT_WINDOW 65535
+
+/** Largest permitted flow control window size */
+#define HTTP2_MAX_WINDOW 0x7fffffffUL
+
+/** Receive flow control window size
+ *
+ * Received data is passed immediately to the consumer and is never
+ * buffered, so there is no reason to limit the sender other than via
+ * the underlying TCP window.
+ */
+#define HTTP2_WINDOW ( 16 * 1024 * 1024 )
+
+/** Maximum number of concurrent streams per connection
+ *
+ * This is used as a limit even if the server advertises a higher (or
+ * no) limit.
+ */
+#define HTTP2_MAX_STREAMS 100
+
+/** HTTP/2 idle connection expiry time */
+#define HTTP2_IDLE_EXPIRY ( 10 * TICKS_PER_SEC )
+
+/** HTTP/2 peer settings */
+struct http2_peer_settings {
+	/** Maximum number of concurrent streams */
+	uint32_t max_streams;
+	/** Initial stream flow control window size */
+	uint32_t window;
+	/** Maximum frame size */
+	uint32_t max_frame;
+};
+
+/** An HTTP/2 connection */
+struct http2_connection {
+	/** Reference count */
+	struct refcnt refcnt;
+	/** List of HTTP/2 connections */
+	struct list_head list;
+	/** Connection URI */
+	struct uri *uri;
+	/** HTTP scheme */
+	struct http_scheme *scheme;
+	/** Port number */
+	unsigned int port;
+	/** Transport layer interface */
+	struct interface socket;
+	/** Stream servicing process */
+	struct process process;
+	/** Idle connection expiry timer */
+	struct retry_timer timer;
+	/** Flags */
+	unsigned int flags;
+
+	/** List of streams */
+	struct list_head streams;
+	/** Number of open streams (with assigned identifiers) */
+	unsigned int open;
+	/** Next stream identifier */
+	uint32_t next_id;
+	/** Peer settings */
+	struct http2_peer_settings peer;
+	/** Transmit flow control window */
+	int32_t tx_window;
+	/** Received data not yet acknowledged by a window update */
+	uint32_t rx_unacked;
+
+	/** Received frame header */
+	struct http2_frame_header rx_hdr;
+	/** Length of received frame header */
+	size_t rx_hdr_len;
+	/** Received frame payload */
+	struct io_buffer *rx_payload;
+	/** Header block being reassembled (if any) */
+	struct xfer_buffer block;
+	/** Stream identifier of header block being reassembled */
+	uint32_t block_stream;
+	/** Flags of HEADERS frame starting header block */
+	unsigned int block_flags;
+	/** HPACK decoder dynamic table */
+	struct hpack_table hpack;
+};
+
+/** HTTP/2 connection flags */
+enum http2_connection_flags {
+	/** No new streams may be opened */
+	HTTP2_CONN_GOAWAY = 0x0001,
+	/** Connection has been closed */
+	HTTP2_CONN_CLOSED = 0x0002,
+};
+
+/** An HTTP/2 stream */
+struct http2_stream {
+	/** Reference count */
+	struct refcnt refcnt;
+	/** HTTP/2 connection */
+	struct http2_connection *h2;
+	/** List of streams within connection */
+	struct list_head list;
+	/** Data transfer interface */
+	struct interface xfer;
+	/** Stream identifier (or zero if not yet opened) */
+	uint32_t id;
+	/** Flags */
+	unsigned int flags;
+	/** Transmit flow control window */
+	int32_t tx_window;
+	/** Received data not yet acknowledged by a window update */
+	uint32_t rx_unacked;
+	/** Pending request body (if any) */
+	struct io_buffer *tx;
+};
+
+/** HTTP/2 stream flags */
+enum http2_stream_flags {
+	/** Stream was opened on an existing connection */
+	HTTP2_STREAM_REUSED = 0x0001,
+	/** Data transfer interface should be notified of window change */
+	HTTP2_STREAM_NOTIFY = 0x0002,
+	/** Pending request body may be transmittable */
+	HTTP2_STREAM_TX_READY = 0x0004,
+	/** Response headers have been received */
+	HTTP2_STREAM_RESPONSE = 0x0008,
+	/** Peer has ended stream */
+	HTTP2_STREAM_END = 0x0010,
+};
+
+#endif /* _IPXE_HTTP2_H */
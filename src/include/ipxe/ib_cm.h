@@ -54,12 +54,56 @@ struct ib_connection {
 	/** Connection request management transaction */
 	struct ib_mad_transaction *madx;
 
+	/** Connection was accepted from a remote requester */
+	int passive;
+
 	/** Length of connection request private data */
 	size_t private_data_len;
 	/** Connection request private data */
 	uint8_t private_data[0];
 };
 
+struct ib_listener;
+
+/** Infiniband connection listener operations */
+struct ib_listener_operations {
+	/** Handle connection request
+	 *
+	 * @v ibdev		Infiniband device
+	 * @v listener		Listener
+	 * @v conn		New connection
+	 * @v av		Address vector of requester
+	 * @v private_data	Request private data
+	 * @v private_data_len	Length of request private data
+	 * @v reply		Reply private data to fill in
+	 * @v reply_len		Length of reply private data
+	 * @ret rc		Return status code
+	 *
+	 * To accept the connection, the handler must fill in the
+	 * connection's queue pair and connection operations.  The
+	 * queue pair's address vector will be filled in from the
+	 * connection request.
+	 */
+	int ( * request ) ( struct ib_device *ibdev,
+			    struct ib_listener *listener,
+			    struct ib_connection *conn,
+			    struct ib_address_vector *av,
+			    void *private_data, size_t private_data_len,
+			    void *reply, size_t reply_len );
+};
+
+/** An Infiniband connection listener */
+struct ib_listener {
+	/** Infiniband device */
+	struct ib_device *ibdev;
+	/** Service ID */
+	union ib_guid service_id;
+	/** Listener operations */
+	struct ib_listener_operations *op;
+	/** List of listeners */
+	struct list_head list;
+};
+
 extern struct ib_connection *
 ib_create_conn ( struct ib_device *ibdev, struct ib_queue_pair *qp,
 		 union ib_gid *dgid, union ib_guid *service_id,
@@ -68,5 +112,9 @@ ib_create_conn ( struct ib_device *ibdev, struct ib_queue_pair *qp,
 extern void ib_destroy_conn ( struct ib_device *ibdev,
 			      struct ib_queue_pair *qp,
 			      struct ib_connection *conn );
+extern void ib_listen ( struct ib_device *ibdev, struct ib_listener *listener,
+			union ib_guid *service_id,
+			struct ib_listener_operations *op );
+extern void ib_unlisten ( struct ib_listener *listener );
 
 #endif /* _IPXE_IB_CM_H */
@@ -19,6 +19,8 @@ struct uri;
 struct pixel_buffer;
 struct asn1_cursor;
 struct image_type;
+struct image_digest;
+struct digest_algorithm;
 
 /** An executable image */
 struct image {
@@ -57,6 +59,10 @@ struct image {
 
 	/** Image type, if known */
 	struct image_type *type;
+	/** Image type owning pre-placed image data, if any */
+	struct image_type *placer;
+	/** Digests accumulated during download, if any */
+	struct image_digest *digest;
 
 	/** Replacement image
 	 *
@@ -73,6 +79,20 @@ struct image {
 	struct image *replacement;
 };
 
+/** An image digest accumulated during download */
+struct image_digest {
+	/** Next digest for the same image, if any */
+	struct image_digest *next;
+	/** Digest algorithm */
+	struct digest_algorithm *digest;
+	/** Digest context */
+	void *ctx;
+	/** Length of data digested so far */
+	size_t len;
+	/** Digest is unusable (e.g. due to out-of-order data) */
+	int broken;
+};
+
 /** Image is registered */
 #define IMAGE_REGISTERED 0x0001
 
@@ -140,6 +160,24 @@ struct image_type {
 	 * @ret rc		Return status code
 	 */
 	int ( * extract ) ( struct image *image, struct image *extracted );
+	/**
+	 * Pre-place image data during download
+	 *
+	 * @v image		Image (containing only the initial data)
+	 * @v len		Total length of image
+	 * @ret data		Pre-placed data buffer, or NULL
+	 *
+	 * An image type may choose to have the image data downloaded
+	 * directly to its final load address, to avoid the need to
+	 * copy the image data during execution.
+	 */
+	void * ( * place ) ( struct image *image, size_t len );
+	/**
+	 * Release pre-placed image data
+	 *
+	 * @v image		Image
+	 */
+	void ( * unplace ) ( struct image *image );
 };
 
 /**
@@ -211,6 +249,14 @@ extern int image_set_name ( struct image *image, const char *name );
 extern char * image_strip_suffix ( struct image *image );
 extern int image_set_cmdline ( struct image *image, const char *cmdline );
 extern int image_set_len ( struct image *image, size_t len );
+extern void * image_place ( struct image *image, size_t len );
+extern int image_digest_start ( struct image *image,
+				struct digest_algorithm *digest );
+extern void image_digest_update ( struct image *image, size_t offset,
+				  const void *data, size_t len );
+extern int image_digest_final ( struct image *image,
+				struct digest_algorithm *digest, void *out );
+extern void image_digest_discard ( struct image *image );
 extern int image_set_data ( struct image *image, const void *data,
 			    size_t len );
 extern int register_image ( struct image *image );
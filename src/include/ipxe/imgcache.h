@@ -0,0 +1,86 @@
+#ifndef _IPXE_IMGCACHE_H
+#define _IPXE_IMGCACHE_H
+
+/** @file
+ *
+ * Persistent image cache
+ *
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+FILE_SECBOOT ( PERMITTED );
+
+#include <stdint.h>
+#include <ipxe/tables.h>
+#include <ipxe/sha256.h>
+
+struct interface;
+struct image;
+struct uri;
+struct xfer_buffer;
+
+/** An image cache tag
+ *
+ * A tag file is stored for each cached URI, and identifies the
+ * cached content by its SHA-256 digest.  The entity tag supplied by
+ * the server follows the fixed portion of the tag.
+ */
+struct imgcache_tag {
+	/** Magic signature */
+	uint32_t magic;
+	/** Length of content */
+	uint64_t len;
+	/** SHA-256 digest of content */
+	uint8_t digest[SHA256_DIGEST_SIZE];
+	/** Entity tag */
+	char etag[0];
+} __attribute__ (( packed ));
+
+/** Image cache tag magic signature ("iPXc") */
+#define IMGCACHE_MAGIC 0x63585069
+
+/** An image cache backing store */
+struct imgcache_store {
+	/** Name */
+	const char *name;
+	/** Read file
+	 *
+	 * @v uri		File URI
+	 * @v buffer		Data transfer buffer to fill in
+	 * @ret rc		Return status code
+	 */
+	int ( * read ) ( struct uri *uri, struct xfer_buffer *buffer );
+	/** Write file
+	 *
+	 * @v uri		File URI
+	 * @v data		Data
+	 * @v len		Length of data
+	 * @ret rc		Return status code
+	 */
+	int ( * write ) ( struct uri *uri, const void *data, size_t len );
+};
+
+/** Image cache backing store table */
+#define IMGCACHE_STORES __table ( struct imgcache_store, "imgcache_stores" )
+
+/** Declare an image cache backing store */
+#define __imgcache_store __table_entry ( IMGCACHE_STORES, 01 )
+
+extern const char * imgcache_etag ( struct interface *intf );
+#define imgcache_etag_TYPE( object_type ) \
+	typeof ( const char * ( object_type ) )
+
+extern int imgcache_current ( struct interface *intf );
+#define imgcache_current_TYPE( object_type ) \
+	typeof ( int ( object_type ) )
+
+extern void imgcache_validator ( struct interface *intf, const char *etag );
+#define imgcache_validator_TYPE( object_type ) \
+	typeof ( void ( object_type, const char *etag ) )
+
+extern int imgcache_lookup ( struct image *image, char **etag );
+extern int imgcache_load ( struct image *image, struct xfer_buffer *buffer );
+extern int imgcache_save ( struct image *image, const char *etag,
+			   const void *data, size_t len );
+
+#endif /* _IPXE_IMGCACHE_H */
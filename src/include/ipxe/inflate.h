@@ -0,0 +1,97 @@
+#ifndef _IPXE_INFLATE_H
+#define _IPXE_INFLATE_H
+
+/** @file
+ *
+ * Decompression during download
+ *
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+FILE_SECBOOT ( PERMITTED );
+
+#include <stdint.h>
+#include <ipxe/refcnt.h>
+#include <ipxe/interface.h>
+#include <ipxe/deflate.h>
+#include <ipxe/gzip.h>
+
+/** Maximum length of compressed data to process in a single step
+ *
+ * This is a policy decision.  Sufficient space must be reserved
+ * within the data transfer buffer to hold the maximum possible
+ * decompressed length of each step.
+ */
+#define INFLATE_STEP_LEN 1024
+
+/** Decompression state */
+enum inflate_state {
+	/** Awaiting fixed header */
+	INFLATE_HEADER = 0,
+	/** Awaiting gzip extra header length */
+	INFLATE_EXTRA_LEN,
+	/** Skipping gzip extra header */
+	INFLATE_EXTRA,
+	/** Skipping gzip file name */
+	INFLATE_NAME,
+	/** Skipping gzip file comment */
+	INFLATE_COMMENT,
+	/** Skipping gzip header CRC */
+	INFLATE_HCRC,
+	/** Decompressing data */
+	INFLATE_DATA,
+	/** Awaiting gzip footer */
+	INFLATE_FOOTER,
+	/** Finished */
+	INFLATE_DONE,
+};
+
+/** A decompression filter */
+struct inflate {
+	/** Reference count */
+	struct refcnt refcnt;
+	/** Decompressed data transfer interface */
+	struct interface xfer;
+	/** Compressed data transfer interface */
+	struct interface raw;
+
+	/** Current state */
+	enum inflate_state state;
+	/** Compression format (raw for gzip, or ZLIB) */
+	enum deflate_format format;
+	/** gzip header flags */
+	unsigned int flags;
+	/** Header or footer under construction */
+	union {
+		/** gzip header */
+		struct gzip_header gzip;
+		/** gzip extra header */
+		struct gzip_extra_header extra;
+		/** gzip footer */
+		struct gzip_footer footer;
+		/** Raw bytes */
+		uint8_t bytes[ sizeof ( struct gzip_header ) ];
+	} hdr;
+	/** Length of header or footer accumulated so far */
+	size_t fill;
+	/** Remaining length to skip
+	 *
+	 * While decompressing zlib data, this instead holds the
+	 * length of the zlib header retained within the header
+	 * buffer and not yet passed to the decompressor.
+	 */
+	size_t skip;
+
+	/** Current position within compressed data */
+	size_t pos;
+	/** Length of decompressed data */
+	size_t len;
+	/** CRC32 of decompressed data */
+	uint32_t crc;
+	/** Decompressor */
+	struct deflate deflate;
+};
+
+extern int add_inflate ( struct interface *xfer );
+
+#endif /* _IPXE_INFLATE_H */
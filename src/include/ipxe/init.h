@@ -64,6 +64,7 @@ struct startup_fn {
 #define STARTUP_EARLY	01	/**< Early startup */
 #define STARTUP_NORMAL	02	/**< Normal startup */
 #define STARTUP_LATE	03	/**< Late startup */
+#define STARTUP_FINAL	04	/**< Final startup (first to shut down) */
 
 /** @} */
 
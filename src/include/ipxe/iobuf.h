@@ -28,6 +28,15 @@ FILE_SECBOOT ( PERMITTED );
  */
 #define IOB_ZLEN 128
 
+/**
+ * Maximum number of recycled receive I/O buffers
+ *
+ * Freed receive I/O buffers are retained for reuse, up to this
+ * limit, to avoid the cost of a heap allocation and free for every
+ * received packet.
+ */
+#define IOB_RECYCLE_MAX 64
+
 /**
  * A persistent I/O buffer
  *
@@ -55,8 +64,90 @@ struct io_buffer {
 	void *tail;
 	/** End of the buffer */
         void *end;
+
+	/** Requested length, if allocated as a receive buffer
+	 *
+	 * Receive buffers are recycled when freed, and may be reused
+	 * by a subsequent allocation of a receive buffer of the same
+	 * requested length.  This is zero for other buffers.
+	 */
+	size_t rx_len;
+	/** Flags */
+	unsigned int flags;
+
+	/** Network-layer header (for transmit offloads) */
+	void *net_hdr;
+	/** Transport-layer header (for transmit offloads) */
+	void *trans_hdr;
+	/** Length of transport-layer header (for transmit offloads) */
+	uint16_t trans_hdr_len;
+	/** Offset of checksum within transport-layer header
+	 *
+	 * This is valid only if @c IOB_TX_CSUM is set.
+	 */
+	uint16_t csum_offset;
+	/** Maximum segment size
+	 *
+	 * This is valid only if @c IOB_TX_TSO is set.
+	 */
+	uint16_t mss;
+	/** VLAN tag control information
+	 *
+	 * This is valid only if @c IOB_TX_VLAN is set.
+	 */
+	uint16_t vlan_tci;
+
+	/** Next fragment of a chained I/O buffer
+	 *
+	 * A chained I/O buffer consists of a head I/O buffer
+	 * (containing all protocol headers) followed by one or more
+	 * fragments containing further payload data.  The fragments
+	 * are owned by the head I/O buffer, and will be freed along
+	 * with it.  This is NULL for the final (or only) buffer.
+	 */
+	struct io_buffer *frag;
 };
 
+/** Transport-layer checksum has already been verified
+ *
+ * This may be set by a network device driver for a received packet
+ * if the hardware (or hypervisor) has already verified the TCP or
+ * UDP checksum, or if the packet is known not to have been exposed
+ * to corruption in transit.
+ */
+#define IOB_CSUM_VALID 0x0001
+
+/** Transport-layer checksum is to be completed by the hardware
+ *
+ * The checksum field has been filled in with the pseudo-header
+ * checksum.  The hardware must calculate the checksum from the start
+ * of the transport-layer header to the end of the packet, and store
+ * the result at @c csum_offset within the transport-layer header.
+ */
+#define IOB_TX_CSUM 0x0002
+
+/** TCP segmentation is to be performed by the hardware
+ *
+ * The packet may be larger than the link MTU, and must be split by
+ * the hardware into segments carrying at most @c mss bytes of
+ * payload.  The checksum field has been filled in with the
+ * pseudo-header checksum calculated over the whole packet.
+ */
+#define IOB_TX_TSO 0x0004
+
+/** Transport-layer protocol is TCP (for transmit offloads) */
+#define IOB_TX_TCP 0x0008
+
+/** Network-layer protocol is IPv6 (for transmit offloads) */
+#define IOB_TX_IPV6 0x0010
+
+/** VLAN tag is to be inserted by the hardware
+ *
+ * The packet has an untagged link-layer header.  The hardware must
+ * insert a VLAN tag with the tag control information @c vlan_tci.
+ */
+#define IOB_TX_VLAN 0x0020
+
 /**
  * Reserve space at start of I/O buffer
  *
@@ -161,6 +252,34 @@ static inline size_t iob_len ( struct io_buffer *iobuf ) {
 	return ( iobuf->tail - iobuf->data );
 }
 
+/**
+ * Calculate total length of data in a (possibly chained) I/O buffer
+ *
+ * @v iobuf	I/O buffer
+ * @ret len	Total length of data in I/O buffer and all fragments
+ */
+static inline size_t iob_total_len ( struct io_buffer *iobuf ) {
+	size_t len = 0;
+
+	for ( ; iobuf ; iobuf = iobuf->frag )
+		len += iob_len ( iobuf );
+	return len;
+}
+
+/**
+ * Count buffers in a (possibly chained) I/O buffer
+ *
+ * @v iobuf	I/O buffer
+ * @ret count	Number of buffers (including the head I/O buffer)
+ */
+static inline unsigned int iob_count ( struct io_buffer *iobuf ) {
+	unsigned int count = 0;
+
+	for ( ; iobuf ; iobuf = iobuf->frag )
+		count++;
+	return count;
+}
+
 /**
  * Calculate available space at start of an I/O buffer
  *
@@ -197,6 +316,8 @@ static inline void iob_populate ( struct io_buffer *iobuf,
 	iobuf->head = iobuf->data = data;
 	iobuf->tail = ( data + len );
 	iobuf->end = ( data + max_len );
+	iobuf->flags = 0;
+	iobuf->frag = NULL;
 }
 
 /**
@@ -291,5 +412,7 @@ extern void iob_pad ( struct io_buffer *iobuf, size_t min_len );
 extern int iob_ensure_headroom ( struct io_buffer *iobuf, size_t len );
 extern struct io_buffer * iob_concatenate ( struct list_head *list );
 extern struct io_buffer * iob_split ( struct io_buffer *iobuf, size_t len );
+extern void iob_chain ( struct io_buffer *iobuf, struct io_buffer *frag );
+extern struct io_buffer * iob_linearise ( struct io_buffer *iobuf );
 
 #endif /* _IPXE_IOBUF_H */
@@ -26,6 +26,9 @@ struct ipoib_mac {
 	union ib_gid gid;
 } __attribute__ (( packed ));
 
+/** IPoIB MAC address "connected mode" capability flag */
+#define IPOIB_MAC_CM 0x80000000UL
+
 /** IPoIB link-layer header length */
 #define IPOIB_HLEN 4
 
@@ -37,6 +40,26 @@ struct ipoib_hdr {
 	uint16_t reserved;
 } __attribute__ (( packed ));
 
+/** IPoIB connected mode service ID (upper 32 bits)
+ *
+ * The lower 32 bits of the service ID are the listener's QPN.
+ */
+#define IPOIB_CM_SERVICE_ID 0x10000000UL
+
+/** IPoIB connected mode maximum transmission unit */
+#define IPOIB_CM_MTU 65520
+
+/** IPoIB connected mode maximum message size */
+#define IPOIB_CM_BUF_SIZE ( IPOIB_CM_MTU + IPOIB_HLEN )
+
+/** IPoIB connected mode connection private data */
+struct ipoib_cm_data {
+	/** Sender's datagram mode QPN (upper 8 bits reserved) */
+	uint32_t qpn;
+	/** Maximum receive message size */
+	uint32_t mtu;
+} __attribute__ (( packed ));
+
 /** GUID mask used for constructing eIPoIB Local Ethernet MAC address (LEMAC) */
 #define IPOIB_GUID_MASK 0xe7
 
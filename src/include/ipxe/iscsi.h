@@ -23,14 +23,29 @@ FILE_SECBOOT ( PERMITTED );
 /** Default iSCSI port */
 #define ISCSI_PORT 3260
 
-/** Default iSCSI first burst length */
-#define ISCSI_FIRST_BURST_LEN 65536
+/** Offered iSCSI first burst length */
+#define ISCSI_FIRST_BURST_LEN 262144
 
-/** Default iSCSI maximum burst length */
-#define ISCSI_MAX_BURST_LEN 262144
+/** Default iSCSI first burst length (if not negotiated) */
+#define ISCSI_DEFAULT_FIRST_BURST_LEN 65536
 
-/** Default iSCSI maximum receive data segment length */
-#define ISCSI_MAX_RECV_DATA_SEG_LEN 8192
+/** Offered iSCSI maximum burst length */
+#define ISCSI_MAX_BURST_LEN 1048576
+
+/** Declared iSCSI maximum receive data segment length */
+#define ISCSI_MAX_RECV_DATA_SEG_LEN 262144
+
+/** Default target maximum receive data segment length (if not declared) */
+#define ISCSI_DEFAULT_MAX_RECV_DATA_SEG_LEN 8192
+
+/** Maximum length of a transmitted iSCSI data segment */
+#define ISCSI_MAX_SEND_DATA_SEG_LEN 65536
+
+/** Maximum number of outstanding iSCSI commands (per connection) */
+#define ISCSI_MAX_TASKS 16
+
+/** Offered iSCSI maximum number of connections per session */
+#define ISCSI_MAX_CONNECTIONS 4
 
 /**
  * iSCSI segment lengths
@@ -66,6 +81,9 @@ union iscsi_segment_lengths {
 #define ISCSI_DATA_PAD_LEN( segment_lengths ) \
 	( ( 0 - (segment_lengths).bytes.data_len[2] ) & 0x03 )
 
+/** Length of a header or data digest */
+#define ISCSI_DIGEST_LEN 4
+
 /** Set additional header and data segment lengths */
 #define ISCSI_SET_LENGTHS( segment_lengths, ahs_len, data_len ) do {	\
 	(segment_lengths).ahs_and_data_len =				\
@@ -131,8 +149,10 @@ struct iscsi_bhs_common_response {
 	uint32_t statsn;
 	/** Expected command sequence number */
 	uint32_t expcmdsn;
+	/** Maximum command sequence number */
+	uint32_t maxcmdsn;
 	/** Fields specific to the PDU type */
-	uint8_t other_d[16];
+	uint8_t other_d[12];
 };
 
 /**
@@ -535,12 +555,68 @@ enum iscsi_rx_state {
 	ISCSI_RX_BHS = 0,
 	/** Receiving the additional header segment */
 	ISCSI_RX_AHS,
+	/** Receiving the header digest */
+	ISCSI_RX_HEADER_DIGEST,
 	/** Receiving the data segment */
 	ISCSI_RX_DATA,
 	/** Receiving the data segment padding */
 	ISCSI_RX_DATA_PADDING,
+	/** Receiving the data digest */
+	ISCSI_RX_DATA_DIGEST,
 };
 
+/** An iSCSI task (i.e. an outstanding SCSI command) */
+struct iscsi_task {
+	/** Reference counter */
+	struct refcnt refcnt;
+	/** Parent iSCSI session */
+	struct iscsi_session *iscsi;
+	/** List of outstanding tasks */
+	struct list_head list;
+	/** SCSI command interface */
+	struct interface data;
+
+	/** SCSI command */
+	struct scsi_cmd command;
+	/** Initiator task tag */
+	uint32_t itt;
+	/** Pending transmissions
+	 *
+	 * This is the bitwise-OR of zero or more ISCSI_TASK_TX_XXX
+	 * constants.
+	 */
+	unsigned int pending;
+
+	/** Target transfer tag for current data-out sequence
+	 *
+	 * This is ISCSI_TAG_RESERVED for an unsolicited data-out
+	 * sequence, or the tag provided by an R2T.
+	 */
+	uint32_t ttt;
+	/** Offset of next data-out PDU within current sequence */
+	uint32_t offset;
+	/** End offset of current data-out sequence */
+	uint32_t end;
+	/** Data sequence number of next data-out PDU */
+	uint32_t datasn;
+
+	/** Target transfer tag for deferred R2T */
+	uint32_t r2t_ttt;
+	/** Buffer offset for deferred R2T */
+	uint32_t r2t_offset;
+	/** Desired data transfer length for deferred R2T */
+	uint32_t r2t_len;
+};
+
+/** iSCSI task needs to send its SCSI command PDU */
+#define ISCSI_TASK_TX_COMMAND 0x0001
+
+/** iSCSI task has a data-out sequence in progress */
+#define ISCSI_TASK_TX_DATA_OUT 0x0002
+
+/** iSCSI task has an R2T deferred until the current sequence completes */
+#define ISCSI_TASK_TX_R2T 0x0004
+
 /** An iSCSI session */
 struct iscsi_session {
 	/** Reference counter */
@@ -548,11 +624,28 @@ struct iscsi_session {
 
 	/** SCSI command-issuing interface */
 	struct interface control;
-	/** SCSI command interface */
-	struct interface data;
 	/** Transport-layer socket */
 	struct interface socket;
 
+	/** Leading connection, if this is an additional connection
+	 *
+	 * Each TCP connection within a multi-connection session is
+	 * represented by a separate iSCSI session structure.  Only the
+	 * leading connection is attached to the SCSI device, and owns
+	 * the session-wide command sequence numbers.
+	 */
+	struct iscsi_session *leader;
+	/** List of additional connections (for the leading connection) */
+	struct list_head connections;
+	/** List of additional connections (for an additional connection) */
+	struct list_head list;
+	/** Connection ID */
+	uint16_t cid;
+	/** Target session identifying handle */
+	uint16_t tsih;
+	/** Maximum number of connections */
+	unsigned int max_connections;
+
 	/** Initiator IQN */
 	char *initiator_iqn;
 	/** Target address */
@@ -589,6 +682,10 @@ struct iscsi_session {
 
 	/** Maximum burst length */
 	size_t max_burst_len;
+	/** First burst length */
+	size_t first_burst_len;
+	/** Maximum data segment length that may be sent to target */
+	size_t max_send_len;
 
 	/** Initiator session ID (IANA format) qualifier
 	 *
@@ -596,51 +693,44 @@ struct iscsi_session {
 	 * whenever a new connection is opened.
 	 */
 	uint16_t isid_iana_qual;
-	/** Initiator task tag
-	 *
-	 * This is the tag of the current command.  It is incremented
-	 * whenever a new command is started.
-	 */
+	/** Initiator task tag for login requests */
 	uint32_t itt;
-	/** Target transfer tag
-	 *
-	 * This is the tag attached to a sequence of data-out PDUs in
-	 * response to an R2T.
-	 */
-	uint32_t ttt;
-	/** Transfer offset
-	 *
-	 * This is the offset for an in-progress sequence of data-out
-	 * PDUs in response to an R2T.
-	 */
-	uint32_t transfer_offset;
-	/** Transfer length
-	 *
-	 * This is the length for an in-progress sequence of data-out
-	 * PDUs in response to an R2T.
-	 */
-	uint32_t transfer_len;
 	/** Command sequence number
 	 *
-	 * This is the sequence number of the current command, used to
+	 * This is the sequence number of the next command, used to
 	 * fill out the CmdSN field in iSCSI request PDUs.  It is
-	 * updated with the value of the ExpCmdSN field whenever we
-	 * receive an iSCSI response PDU containing such a field.
+	 * taken from the ExpCmdSN field during login, and is
+	 * incremented whenever a (non-immediate) command is sent.
 	 */
 	uint32_t cmdsn;
+	/** Maximum command sequence number
+	 *
+	 * This is the highest value present in the MaxCmdSN field of
+	 * any received iSCSI response PDU.  Commands with a CmdSN
+	 * beyond this value may not yet be sent.
+	 */
+	uint32_t maxcmdsn;
 	/** Status sequence number
 	 *
 	 * This is the most recent status sequence number present in
-	 * the StatSN field of an iSCSI response PDU containing such a
-	 * field.  Whenever we send an iSCSI request PDU, we fill out
-	 * the ExpStatSN field with this value plus one.
+	 * the StatSN field of an iSCSI response PDU carrying status.
+	 * Whenever we send an iSCSI request PDU, we fill out the
+	 * ExpStatSN field with this value plus one.
 	 */
 	uint32_t statsn;
 	
 	/** Basic header segment for current TX PDU */
 	union iscsi_bhs tx_bhs;
+	/** Task for current TX PDU, if any */
+	struct iscsi_task *tx_task;
 	/** State of the TX engine */
 	enum iscsi_tx_state tx_state;
+	/** Digests in use for current TX PDU
+	 *
+	 * This is the bitwise-OR of zero or more ISCSI_STATUS_XXX_DIGEST
+	 * constants.
+	 */
+	int tx_digests;
 	/** TX process */
 	struct process process;
 
@@ -654,9 +744,21 @@ struct iscsi_session {
 	size_t rx_len;
 	/** Buffer for received data (not always used) */
 	void *rx_buffer;
+	/** Digests in use for current RX PDU
+	 *
+	 * This is the bitwise-OR of zero or more ISCSI_STATUS_XXX_DIGEST
+	 * constants.
+	 */
+	int rx_digests;
+	/** Running CRC32C for current RX digest */
+	uint32_t rx_crc;
+	/** Received digest */
+	uint32_t rx_digest;
 
-	/** Current SCSI command, if any */
-	struct scsi_cmd *command;
+	/** List of outstanding tasks */
+	struct list_head tasks;
+	/** Number of outstanding tasks */
+	unsigned int count;
 
 	/** Target socket address (for boot firmware table) */
 	struct sockaddr target_sockaddr;
@@ -711,6 +813,26 @@ struct iscsi_session {
 /** Target authenticated itself correctly */
 #define ISCSI_STATUS_AUTH_REVERSE_OK 0x00040000
 
+/** Header digests have been negotiated */
+#define ISCSI_STATUS_HEADER_DIGEST 0x00080000
+
+/** Data digests have been negotiated */
+#define ISCSI_STATUS_DATA_DIGEST 0x00100000
+
+/** Mask for all negotiated digests */
+#define ISCSI_STATUS_DIGEST_MASK \
+	( ISCSI_STATUS_HEADER_DIGEST | ISCSI_STATUS_DATA_DIGEST )
+
+/** Initial R2T is required (i.e. no unsolicited data-out PDUs) */
+#define ISCSI_STATUS_INITIAL_R2T 0x00200000
+
+/** Immediate data has been negotiated */
+#define ISCSI_STATUS_IMMEDIATE_DATA 0x00400000
+
+/** Mask for all negotiated session-wide flags */
+#define ISCSI_STATUS_SESSION_MASK \
+	( ISCSI_STATUS_INITIAL_R2T | ISCSI_STATUS_IMMEDIATE_DATA )
+
 /** Default initiator IQN prefix */
 #define ISCSI_DEFAULT_IQN_PREFIX "iqn.2010-04.org.ipxe"
 
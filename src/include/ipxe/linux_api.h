@@ -50,6 +50,7 @@ FILE_LICENCE ( GPL2_OR_LATER );
 #endif
 
 struct sockaddr;
+struct iovec;
 struct slirp_config;
 struct slirp_callbacks;
 struct Slirp;
@@ -63,6 +64,10 @@ extern int __asmcall linux_close ( int fd );
 extern off_t __asmcall linux_lseek ( int fd, off_t offset, int whence );
 extern ssize_t __asmcall linux_read ( int fd, void *buf, size_t count );
 extern ssize_t __asmcall linux_write ( int fd, const void *buf, size_t count );
+extern ssize_t __asmcall linux_readv ( int fd, const struct iovec *iov,
+				       int iovcnt );
+extern ssize_t __asmcall linux_writev ( int fd, const struct iovec *iov,
+					int iovcnt );
 extern int __asmcall linux_fcntl ( int fd, int cmd, ... );
 extern int __asmcall linux_ioctl ( int fd, unsigned long request, ... );
 extern int __asmcall linux_fstat_size ( int fd, size_t *size );
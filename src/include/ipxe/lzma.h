@@ -0,0 +1,170 @@
+#ifndef _IPXE_LZMA_H
+#define _IPXE_LZMA_H
+
+/** @file
+ *
+ * LZMA2 decompression algorithm
+ *
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+FILE_SECBOOT ( PERMITTED );
+
+#include <stdint.h>
+
+/** Number of LZMA states */
+#define LZMA_STATES 12
+
+/** Number of literal states (i.e. states following a literal) */
+#define LZMA_LITERAL_STATES 7
+
+/** Maximum number of position bits */
+#define LZMA_POS_BITS_MAX 4
+
+/** Maximum combined number of literal context and position bits */
+#define LZMA_LITERAL_BITS_MAX 4
+
+/** Number of probabilities for each literal coder */
+#define LZMA_LITERAL_CODER_SIZE 0x300
+
+/** Number of low and middle length symbols */
+#define LZMA_LEN_LOW_SYMBOLS 8
+
+/** Number of high length symbols */
+#define LZMA_LEN_HIGH_SYMBOLS 256
+
+/** Minimum match length */
+#define LZMA_MATCH_MIN_LEN 2
+
+/** Number of length states used to select a distance slot */
+#define LZMA_DIST_STATES 4
+
+/** Number of distance slot bits */
+#define LZMA_DIST_SLOT_BITS 6
+
+/** First distance slot which uses direct bits */
+#define LZMA_DIST_MODEL_START 4
+
+/** First distance slot which uses aligned bits */
+#define LZMA_DIST_MODEL_END 14
+
+/** Number of distances encoded using distance slots alone */
+#define LZMA_FULL_DISTANCES 128
+
+/** Number of aligned distance bits */
+#define LZMA_ALIGN_BITS 4
+
+/** Number of probability bits */
+#define LZMA_PROB_BITS 11
+
+/** Initial probability value */
+#define LZMA_PROB_INIT ( 1 << ( LZMA_PROB_BITS - 1 ) )
+
+/** Number of bits by which probabilities are adapted */
+#define LZMA_PROB_MOVE_BITS 5
+
+/** Range coder normalisation threshold */
+#define LZMA_RANGE_TOP ( 1UL << 24 )
+
+/** Length of range coder initialisation data */
+#define LZMA_RANGE_INIT_LEN 5
+
+/** Maximum value of properties byte */
+#define LZMA_PROPS_MAX ( ( 4 * 5 + 4 ) * 9 + 8 )
+
+/** An LZMA length decoder */
+struct lzma_length {
+	/** First choice bit */
+	uint16_t choice;
+	/** Second choice bit */
+	uint16_t choice2;
+	/** Low length symbols */
+	uint16_t low[ 1 << LZMA_POS_BITS_MAX ][LZMA_LEN_LOW_SYMBOLS];
+	/** Middle length symbols */
+	uint16_t mid[ 1 << LZMA_POS_BITS_MAX ][LZMA_LEN_LOW_SYMBOLS];
+	/** High length symbols */
+	uint16_t high[LZMA_LEN_HIGH_SYMBOLS];
+};
+
+/** LZMA probabilities */
+struct lzma_probs {
+	/** Match flags */
+	uint16_t is_match[LZMA_STATES][ 1 << LZMA_POS_BITS_MAX ];
+	/** Repeated match flags */
+	uint16_t is_rep[LZMA_STATES];
+	/** First repeated distance flags */
+	uint16_t is_rep0[LZMA_STATES];
+	/** Second repeated distance flags */
+	uint16_t is_rep1[LZMA_STATES];
+	/** Third repeated distance flags */
+	uint16_t is_rep2[LZMA_STATES];
+	/** Long first repeated distance flags */
+	uint16_t is_rep0_long[LZMA_STATES][ 1 << LZMA_POS_BITS_MAX ];
+	/** Distance slots */
+	uint16_t dist_slot[LZMA_DIST_STATES][ 1 << LZMA_DIST_SLOT_BITS ];
+	/** Distance bits for slots without aligned bits */
+	uint16_t dist_special[ 1 + LZMA_FULL_DISTANCES -
+			       LZMA_DIST_MODEL_END ];
+	/** Aligned distance bits */
+	uint16_t dist_align[ 1 << LZMA_ALIGN_BITS ];
+	/** Match length decoder */
+	struct lzma_length match_len;
+	/** Repeated match length decoder */
+	struct lzma_length rep_len;
+	/** Literal coders */
+	uint16_t literal[ 1 << LZMA_LITERAL_BITS_MAX ]
+			[LZMA_LITERAL_CODER_SIZE];
+};
+
+/** An LZMA2 decompressor */
+struct lzma {
+	/** Output data */
+	uint8_t *out;
+	/** Length of output buffer */
+	size_t max;
+	/** Current output offset */
+	size_t offset;
+	/** Offset of start of dictionary */
+	size_t dict;
+
+	/** Current input data */
+	const uint8_t *in;
+	/** End of input data */
+	const uint8_t *end;
+	/** Range */
+	uint32_t range;
+	/** Code */
+	uint32_t code;
+
+	/** Number of literal context bits */
+	unsigned int lc;
+	/** Number of literal position bits */
+	unsigned int lp;
+	/** Number of position bits */
+	unsigned int pb;
+	/** Current state */
+	unsigned int state;
+	/** Repeated distances */
+	uint32_t rep[4];
+	/** Probabilities */
+	struct lzma_probs probs;
+};
+
+/**
+ * Initialise LZMA2 decompressor
+ *
+ * @v lzma		Decompressor
+ * @v out		Output buffer
+ * @v max		Length of output buffer
+ */
+static inline void lzma_init ( struct lzma *lzma, void *out, size_t max ) {
+
+	lzma->out = out;
+	lzma->max = max;
+	lzma->offset = 0;
+}
+
+extern int lzma2_decompress ( struct lzma *lzma, const void *data,
+			      size_t len, size_t *used );
+
+#endif /* _IPXE_LZMA_H */
@@ -41,10 +41,39 @@ FILE_SECBOOT ( PERMITTED );
  */
 #define NOWHERE ( ( void * ) ~( ( intptr_t ) 0 ) )
 
+/** Number of size-class bins for small free memory blocks */
+#define HEAP_BINS 32
+
+/** Maximum number of free memory blocks retained within each bin */
+#define HEAP_BIN_MAX 64
+
+struct binned_block;
+
+/** A size-class bin for small free memory blocks */
+struct heap_bin {
+	/** Most recently freed block, or NULL */
+	struct binned_block *first;
+	/** Number of blocks in bin */
+	unsigned int count;
+};
+
 /** A heap */
 struct heap {
+	/** Name */
+	const char *name;
 	/** List of free memory blocks */
 	struct list_head blocks;
+	/** Size-class bins for small free memory blocks
+	 *
+	 * Small freed blocks are held in a bin according to their
+	 * size (as a multiple of the free memory block alignment),
+	 * without being merged into the free block list.  They will
+	 * be merged only when an allocation would otherwise fail.
+	 *
+	 * Bins are not used for heaps that are permitted to shrink,
+	 * since a binned block would prevent the heap from shrinking.
+	 */
+	struct heap_bin bins[HEAP_BINS];
 
 	/** Alignment for free memory blocks */
 	size_t align;
@@ -57,6 +86,12 @@ struct heap {
 	size_t usedmem;
 	/** Maximum amount of used memory */
 	size_t maxusedmem;
+	/** Number of successful allocations */
+	unsigned long allocs;
+	/** Number of times the heap has grown (e.g. by discarding
+	 * cached data)
+	 */
+	unsigned long grows;
 
 	/**
 	 * Attempt to grow heap (optional)
@@ -79,8 +114,25 @@ struct heap {
 	unsigned int ( * shrink ) ( void *ptr, size_t size );
 };
 
+/** Heap table */
+#define HEAPS __table ( struct heap, "heaps" )
+
+/** Declare a heap */
+#define __heap( order ) __table_entry ( HEAPS, order )
+
+/** @defgroup heap_order Heap orders
+ *
+ * @{
+ */
+
+#define HEAP_INTERNAL	01	/**< Internal heap */
+#define HEAP_EXTERNAL	02	/**< External heap */
+
+/** @} */
+
 extern void * heap_realloc ( struct heap *heap, void *old_ptr,
 			     size_t new_size );
+extern size_t heap_largest ( struct heap *heap );
 extern void heap_dump ( struct heap *heap );
 extern void heap_populate ( struct heap *heap, void *start, size_t len );
 
@@ -88,6 +140,7 @@ extern void * __malloc malloc_phys_offset ( size_t size, size_t phys_align,
 					    size_t offset );
 extern void * __malloc malloc_phys ( size_t size, size_t phys_align );
 extern void free_phys ( void *ptr, size_t size );
+extern size_t malloc_freemem ( void );
 
 /** A cache discarder */
 struct cache_discarder {
@@ -0,0 +1,301 @@
+#ifndef _IPXE_NBFT_H
+#define _IPXE_NBFT_H
+
+/** @file
+ *
+ * NVMe boot firmware table
+ *
+ * The information in this file is derived from the "NVM Express Boot
+ * Specification", revision 1.0, as published by NVM Express, Inc.
+ *
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+FILE_SECBOOT ( PERMITTED );
+
+#include <stdint.h>
+#include <ipxe/acpi.h>
+#include <ipxe/in.h>
+
+/** NVMe Boot Firmware Table signature */
+#define NBFT_SIG ACPI_SIGNATURE ( 'N', 'B', 'F', 'T' )
+
+/** NBFT major revision */
+#define NBFT_MAJOR_REVISION 1
+
+/** NBFT minor revision */
+#define NBFT_MINOR_REVISION 0
+
+/** A heap object within the NBFT */
+struct nbft_heap_obj {
+	/** Offset from start of NBFT */
+	uint32_t offset;
+	/** Length (excluding any terminating NUL) */
+	uint16_t len;
+} __attribute__ (( packed ));
+
+/** NBFT header */
+struct nbft_header {
+	/** ACPI header */
+	struct acpi_header acpi;
+	/** Offset to heap */
+	uint32_t heap_offset;
+	/** Length of heap */
+	uint32_t heap_len;
+	/** Driver device path signature */
+	struct nbft_heap_obj driver_dev_path_sig;
+	/** Minor revision */
+	uint8_t minor_revision;
+	/** Reserved */
+	uint8_t reserved[13];
+} __attribute__ (( packed ));
+
+/** Control descriptor structure ID */
+#define NBFT_STRUCTURE_ID_CONTROL 0x01
+
+/** Host descriptor structure ID */
+#define NBFT_STRUCTURE_ID_HOST 0x02
+
+/** Host fabric interface descriptor structure ID */
+#define NBFT_STRUCTURE_ID_HFI 0x03
+
+/** Subsystem namespace descriptor structure ID */
+#define NBFT_STRUCTURE_ID_SSNS 0x04
+
+/** Host fabric interface transport info descriptor structure ID */
+#define NBFT_STRUCTURE_ID_HFI_TRINFO 0x07
+
+/** NBFT control descriptor */
+struct nbft_control {
+	/** Structure ID */
+	uint8_t structure_id;
+	/** Major revision */
+	uint8_t major_revision;
+	/** Minor revision */
+	uint8_t minor_revision;
+	/** Reserved */
+	uint8_t reserved_a;
+	/** Control structure length */
+	uint16_t len;
+	/** Flags */
+	uint8_t flags;
+	/** Reserved */
+	uint8_t reserved_b;
+	/** Host descriptor */
+	struct nbft_heap_obj host;
+	/** Host descriptor version */
+	uint8_t host_version;
+	/** Reserved */
+	uint8_t reserved_c;
+	/** Offset to host fabric interface descriptors */
+	uint32_t hfi_offset;
+	/** Length of each host fabric interface descriptor */
+	uint16_t hfi_len;
+	/** Host fabric interface descriptor version */
+	uint8_t hfi_version;
+	/** Number of host fabric interface descriptors */
+	uint8_t num_hfi;
+	/** Offset to subsystem namespace descriptors */
+	uint32_t ssns_offset;
+	/** Length of each subsystem namespace descriptor */
+	uint16_t ssns_len;
+	/** Subsystem namespace descriptor version */
+	uint8_t ssns_version;
+	/** Number of subsystem namespace descriptors */
+	uint8_t num_ssns;
+	/** Offset to security profile descriptors */
+	uint32_t sec_offset;
+	/** Length of each security profile descriptor */
+	uint16_t sec_len;
+	/** Security profile descriptor version */
+	uint8_t sec_version;
+	/** Number of security profile descriptors */
+	uint8_t num_sec;
+	/** Offset to discovery descriptors */
+	uint32_t disc_offset;
+	/** Length of each discovery descriptor */
+	uint16_t disc_len;
+	/** Discovery descriptor version */
+	uint8_t disc_version;
+	/** Number of discovery descriptors */
+	uint8_t num_disc;
+	/** Reserved */
+	uint8_t reserved_d[16];
+} __attribute__ (( packed ));
+
+/** Control descriptor is valid */
+#define NBFT_CONTROL_VALID 0x01
+
+/** NBFT host descriptor */
+struct nbft_host {
+	/** Structure ID */
+	uint8_t structure_id;
+	/** Flags */
+	uint8_t flags;
+	/** Host identifier */
+	uint8_t host_id[16];
+	/** Host NVMe qualified name */
+	struct nbft_heap_obj host_nqn;
+	/** Reserved */
+	uint8_t reserved[8];
+} __attribute__ (( packed ));
+
+/** Host descriptor is valid */
+#define NBFT_HOST_VALID 0x01
+
+/** NBFT host fabric interface descriptor */
+struct nbft_hfi {
+	/** Structure ID */
+	uint8_t structure_id;
+	/** Index */
+	uint8_t index;
+	/** Flags */
+	uint8_t flags;
+	/** Transport type */
+	uint8_t trtype;
+	/** Reserved */
+	uint8_t reserved_a[12];
+	/** Transport info descriptor */
+	struct nbft_heap_obj trinfo;
+	/** Reserved */
+	uint8_t reserved_b[10];
+} __attribute__ (( packed ));
+
+/** Host fabric interface descriptor is valid */
+#define NBFT_HFI_VALID 0x01
+
+/** NVMe/TCP transport type */
+#define NBFT_TRTYPE_TCP 0x03
+
+/** An IP address within the NBFT
+ *
+ * IPv4 addresses are represented as IPv4-mapped IPv6 addresses.
+ */
+struct nbft_ipaddr {
+	/** Reserved; must be zero */
+	uint16_t zeroes[5];
+	/** Must be 0xffff if IPv4 address is present, otherwise zero */
+	uint16_t ones;
+	/** The IPv4 address, or zero if not present */
+	struct in_addr in;
+} __attribute__ (( packed ));
+
+/** NBFT host fabric interface NVMe/TCP transport info descriptor */
+struct nbft_hfi_tcp {
+	/** Structure ID */
+	uint8_t structure_id;
+	/** Version */
+	uint8_t version;
+	/** Transport type */
+	uint8_t trtype;
+	/** Transport info version */
+	uint8_t trinfo_version;
+	/** Host fabric interface index */
+	uint16_t hfi_index;
+	/** Flags */
+	uint8_t flags;
+	/** PCI segment, bus, device, and function */
+	uint32_t pci_sbdf;
+	/** MAC address */
+	uint8_t mac[6];
+	/** VLAN */
+	uint16_t vlan;
+	/** IP address origin */
+	uint8_t origin;
+	/** IP address */
+	struct nbft_ipaddr ip_address;
+	/** Subnet mask prefix length */
+	uint8_t subnet_mask_prefix;
+	/** Gateway */
+	struct nbft_ipaddr gateway;
+	/** Reserved */
+	uint8_t reserved_a;
+	/** Route metric */
+	uint16_t route_metric;
+	/** Primary DNS server */
+	struct nbft_ipaddr primary_dns;
+	/** Secondary DNS server */
+	struct nbft_ipaddr secondary_dns;
+	/** DHCP server */
+	struct nbft_ipaddr dhcp;
+	/** Host name */
+	struct nbft_heap_obj hostname;
+	/** Reserved */
+	uint8_t reserved_b[18];
+} __attribute__ (( packed ));
+
+/** Transport info descriptor is valid */
+#define NBFT_HFI_TCP_VALID 0x01
+
+/** IP address was manually configured */
+#define NBFT_ORIGIN_MANUAL 0x01
+
+/** IP address was obtained via DHCP */
+#define NBFT_ORIGIN_DHCP 0x03
+
+/** NBFT subsystem namespace descriptor */
+struct nbft_ssns {
+	/** Structure ID */
+	uint8_t structure_id;
+	/** Index */
+	uint16_t index;
+	/** Flags */
+	uint16_t flags;
+	/** Transport type */
+	uint8_t trtype;
+	/** Transport flags */
+	uint16_t trflags;
+	/** Primary discovery controller index */
+	uint8_t primary_disc;
+	/** Reserved */
+	uint8_t reserved_a;
+	/** Transport address */
+	struct nbft_heap_obj traddr;
+	/** Transport service identifier */
+	struct nbft_heap_obj trsvcid;
+	/** Subsystem port identifier */
+	uint16_t port_id;
+	/** Namespace identifier */
+	uint32_t nsid;
+	/** Namespace identifier type */
+	uint8_t nidt;
+	/** Namespace identifier */
+	uint8_t nid[16];
+	/** Security profile descriptor index */
+	uint8_t security;
+	/** Primary host fabric interface descriptor index */
+	uint8_t primary_hfi;
+	/** Reserved */
+	uint8_t reserved_b;
+	/** Secondary host fabric interface associations */
+	struct nbft_heap_obj secondary_hfi;
+	/** Subsystem NVMe qualified name */
+	struct nbft_heap_obj subnqn;
+	/** Extended information descriptor */
+	struct nbft_heap_obj extended;
+	/** Reserved */
+	uint8_t reserved_c[62];
+} __attribute__ (( packed ));
+
+/** Subsystem namespace descriptor is valid */
+#define NBFT_SSNS_VALID 0x0001
+
+/** Transport flags are valid */
+#define NBFT_SSNS_TRFLAG_VALID 0x0001
+
+/** Namespace globally unique identifier type */
+#define NBFT_NIDT_NGUID 0x02
+
+/** Fixed portion of the NBFT */
+struct nbft_table {
+	/** Header */
+	struct nbft_header header;
+	/** Control descriptor */
+	struct nbft_control control;
+	/** Host descriptor */
+	struct nbft_host host;
+} __attribute__ (( packed ));
+
+extern struct acpi_model nbft_model __acpi_model;
+
+#endif /* _IPXE_NBFT_H */
@@ -40,6 +40,8 @@ struct neighbour {
 	struct refcnt refcnt;
 	/** List of neighbour cache entries */
 	struct list_head list;
+	/** Hash chain of neighbour cache entries */
+	struct list_head hash;
 
 	/** Network device */
 	struct net_device *netdev;
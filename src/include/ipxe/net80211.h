@@ -865,6 +865,18 @@ struct net80211_device
 	 */
 	struct net80211_wlan *associating;
 
+	/** Network with which we most recently associated
+	 *
+	 * This is retained (without its beacon frame) so that a later
+	 * association attempt can look for the same access point on
+	 * the same channel before falling back to a full scan. It
+	 * will be NULL if there is no such network.
+	 */
+	struct net80211_wlan *last;
+
+	/** Time at which @c last was recorded (in ticks) */
+	unsigned long last_ticks;
+
 	/** Context for the association process
 	 *
 	 * This is a probe_ctx if the @c PROBED flag is not set in @c
@@ -23,6 +23,7 @@ struct net_device;
 struct net_protocol;
 struct ll_protocol;
 struct device;
+struct pcap_ring;
 
 /** Maximum length of a hardware address
  *
@@ -80,6 +81,22 @@ struct net_protocol {
 	int ( * rx ) ( struct io_buffer *iobuf, struct net_device *netdev,
 		       const void *ll_dest, const void *ll_source,
 		       unsigned int flags );
+	/**
+	 * Merge received packet (optional)
+	 *
+	 * @v iobuf		I/O buffer
+	 * @v next		Subsequent I/O buffer
+	 * @ret rc		Return status code, or required tailroom
+	 *
+	 * Both I/O buffers have had their link-layer headers removed
+	 * and must have verified transport-layer checksums.  On
+	 * success, the payload of the subsequent I/O buffer will have
+	 * been appended to the first I/O buffer.  On failure, neither
+	 * I/O buffer will have been modified.  If the packets could be
+	 * merged given sufficient tailroom in the first I/O buffer,
+	 * this method should return the required tailroom.
+	 */
+	int ( * merge ) ( struct io_buffer *iobuf, struct io_buffer *next );
 	/**
 	 * Transcribe network-layer address
 	 *
@@ -260,7 +277,8 @@ struct net_device_operations {
 	 *
 	 * This method should cause the hardware to check for
 	 * completed transmissions and received packets.  Any received
-	 * packets should be delivered via netdev_rx().
+	 * packets should be delivered via netdev_rx(), or collected
+	 * into a list and delivered via netdev_rx_batch().
 	 *
 	 * This method is guaranteed to be called only when the device
 	 * is open.
@@ -277,6 +295,47 @@ struct net_device_operations {
 	void ( * irq ) ( struct net_device *netdev, int enable );
 };
 
+/** @defgroup netdevdirect Devirtualised network device operations
+ *
+ * A network driver may provide devirtualised operations, which allow
+ * its transmit and poll methods to be called directly rather than
+ * via function pointers in builds with NETDEV_DIRECT enabled.  If
+ * several linked-in drivers provide devirtualised operations, then
+ * the first to be linked is called directly and all others continue
+ * to be called via their function pointers.
+ *
+ * @{
+ */
+
+extern struct net_device_operations netdev_direct_operations
+	__attribute__ (( weak ));
+extern int netdev_direct_transmit ( struct net_device *netdev,
+				    struct io_buffer *iobuf )
+	__attribute__ (( weak ));
+extern void netdev_direct_poll ( struct net_device *netdev )
+	__attribute__ (( weak ));
+
+/**
+ * Provide devirtualised network device operations
+ *
+ * @v _operations	Network device operations
+ * @v _transmit		Transmit method
+ * @v _poll		Poll method
+ */
+#define PROVIDE_NETDEV_DIRECT( _operations, _transmit, _poll )		      \
+	/* Ensure that methods are type-compatible */			      \
+	typeof ( netdev_direct_transmit ) _transmit;			      \
+	typeof ( netdev_direct_poll ) _poll;				      \
+	/* Provide weak symbol aliases */				      \
+	extern struct net_device_operations netdev_direct_operations	      \
+		__attribute__ (( weak, alias ( #_operations ) ));	      \
+	extern typeof ( netdev_direct_transmit ) netdev_direct_transmit	      \
+		__attribute__ (( weak, alias ( #_transmit ) ));		      \
+	extern typeof ( netdev_direct_poll ) netdev_direct_poll		      \
+		__attribute__ (( weak, alias ( #_poll ) ))
+
+/** @} */
+
 /** Network device error */
 struct net_device_error {
 	/** Error status code */
@@ -298,6 +357,26 @@ struct net_device_stats {
 	struct net_device_error errors[NETDEV_MAX_UNIQUE_ERRORS];
 };
 
+/** Network device datapath statistics */
+struct net_device_datapath_stats {
+	/** Number of octets transmitted */
+	unsigned long tx_octets;
+	/** Number of octets received */
+	unsigned long rx_octets;
+	/** Number of transmissions deferred due to a full descriptor ring */
+	unsigned long tx_deferred;
+	/** Number of receive buffer refill allocation failures */
+	unsigned long rx_refill_errs;
+	/** Number of times the receive descriptor ring was left empty */
+	unsigned long rx_empty;
+	/** Number of polls */
+	unsigned long polls;
+	/** Number of polls that completed no transmissions or receptions */
+	unsigned long idle_polls;
+	/** Maximum number of packets received within a single poll */
+	unsigned int rx_max_per_poll;
+};
+
 /** A network device configuration */
 struct net_device_configuration {
 	/** Network device */
@@ -337,6 +416,22 @@ struct net_device_configurator {
 #define __net_device_configurator \
 	__table_entry ( NET_DEVICE_CONFIGURATORS, 01 )
 
+/** Maximum number of received packets processed per network device poll
+ *
+ * Any further received packets will remain on the receive queue
+ * until the next poll, so that a single busy network device cannot
+ * starve other processes (such as retry timers).
+ */
+#define NETDEV_RX_BUDGET 64
+
+/** Length of buffer used to hold merged received packets
+ *
+ * Consecutive received packets within the same flow may be merged
+ * into a single larger packet before being handed to the network
+ * layer, reducing the per-packet protocol processing overhead.
+ */
+#define NETDEV_RX_MERGE_LEN ( 16 * 1024 )
+
 /** Maximum length of a network device name */
 #define NETDEV_NAME_LEN 12
 
@@ -408,6 +503,12 @@ struct net_device {
 	 * headers) supported by the hardware.
 	 */
 	size_t max_pkt_len;
+	/** Transmit offload capabilities
+	 *
+	 * This is the bitwise-OR of zero or more NETDEV_TX_OFFLOAD_XXX
+	 * constants.
+	 */
+	unsigned int tx_offloads;
 	/** Maximum transmission unit length
 	 *
 	 * This is the maximum transmission unit length (excluding any
@@ -424,6 +525,10 @@ struct net_device {
 	struct net_device_stats tx_stats;
 	/** RX statistics */
 	struct net_device_stats rx_stats;
+	/** Datapath statistics */
+	struct net_device_datapath_stats dp_stats;
+	/** Packet capture ring, if capturing */
+	struct pcap_ring *pcap;
 
 	/** Configuration settings applicable to this device */
 	struct generic_settings settings;
@@ -464,6 +569,49 @@ struct net_device {
 /** Network device should be opened automatically */
 #define NETDEV_AUTO_OPEN 0x0080
 
+/** Network device uses devirtualised operations */
+#define NETDEV_DIRECT_OPS 0x0100
+
+/** Network device can complete TCP and UDP checksums
+ *
+ * The device must be able to complete the transport-layer checksum
+ * for any I/O buffer marked with @c IOB_TX_CSUM, for both IPv4 and
+ * IPv6.
+ */
+#define NETDEV_TX_OFFLOAD_CSUM 0x0001
+
+/** Network device can perform TCP segmentation for IPv4
+ *
+ * The device must be able to segment any IPv4 I/O buffer marked with
+ * @c IOB_TX_TSO.
+ */
+#define NETDEV_TX_OFFLOAD_TSO4 0x0002
+
+/** Network device can perform TCP segmentation for IPv6
+ *
+ * The device must be able to segment any IPv6 I/O buffer marked with
+ * @c IOB_TX_TSO.
+ */
+#define NETDEV_TX_OFFLOAD_TSO6 0x0004
+
+/** Network device can transmit chained I/O buffers
+ *
+ * The device must be able to transmit an I/O buffer consisting of a
+ * head I/O buffer followed by any number of fragments.  Chained I/O
+ * buffers will be linearised before being passed to any device
+ * without this capability.  If the device uses the DMA device
+ * provided by the network device, then every fragment will have been
+ * mapped for DMA.
+ */
+#define NETDEV_TX_OFFLOAD_SG 0x0008
+
+/** Network device can insert VLAN tags
+ *
+ * The device must be able to insert a VLAN tag into any I/O buffer
+ * marked with @c IOB_TX_VLAN.
+ */
+#define NETDEV_TX_OFFLOAD_VLAN 0x0010
+
 /** Link-layer protocol table */
 #define LL_PROTOCOLS __table ( struct ll_protocol, "ll_protocols" )
 
@@ -534,6 +682,7 @@ static inline void netdev_init ( struct net_device *netdev,
  */
 static inline void netdev_nullify ( struct net_device *netdev ) {
 	netdev->op = &null_netdev_operations;
+	netdev->state &= ~NETDEV_DIRECT_OPS;
 }
 
 /**
@@ -700,6 +849,23 @@ netdev_rx_frozen ( struct net_device *netdev ) {
 	return ( netdev->state & NETDEV_RX_FROZEN );
 }
 
+/**
+ * Record receive buffer refill allocation failure
+ *
+ * @v netdev		Network device
+ * @v empty		Receive descriptor ring has been left empty
+ *
+ * Drivers should call this when they are unable to allocate a
+ * receive buffer while refilling the receive descriptor ring.
+ */
+static inline __attribute__ (( always_inline )) void
+netdev_rx_refill_err ( struct net_device *netdev, int empty ) {
+
+	netdev->dp_stats.rx_refill_errs++;
+	if ( empty )
+		netdev->dp_stats.rx_empty++;
+}
+
 /**
  * Check whether or not network device must be polled even while closed
  *
@@ -729,6 +895,8 @@ extern void netdev_tx_complete_err ( struct net_device *netdev,
 				 struct io_buffer *iobuf, int rc );
 extern void netdev_tx_complete_next_err ( struct net_device *netdev, int rc );
 extern void netdev_rx ( struct net_device *netdev, struct io_buffer *iobuf );
+extern void netdev_rx_batch ( struct net_device *netdev,
+			     struct list_head *list );
 extern void netdev_rx_err ( struct net_device *netdev,
 			    struct io_buffer *iobuf, int rc );
 extern void netdev_poll ( struct net_device *netdev );
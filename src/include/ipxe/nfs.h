@@ -103,6 +103,23 @@ struct nfs_readlink_reply {
 };
 
 
+/**
+ * A NFS FSINFO reply
+ *
+ */
+struct nfs_fsinfo_reply {
+	/** Reply status */
+	uint32_t             status;
+	/** Object attributes are present */
+	uint32_t             attr;
+	/** File size (valid only if attributes are present) */
+	uint64_t             filesize;
+	/** Maximum READ request size */
+	uint32_t             rtmax;
+	/** Preferred READ request size */
+	uint32_t             rtpref;
+};
+
 /**
  * A NFS READ reply
  *
@@ -144,6 +161,8 @@ int nfs_lookup ( struct interface *intf, struct oncrpc_session *session,
                  const struct nfs_fh *fh, const char *filename );
 int nfs_readlink ( struct interface *intf, struct oncrpc_session *session,
                    const struct nfs_fh *fh );
+int nfs_fsinfo ( struct interface *intf, struct oncrpc_session *session,
+                 const struct nfs_fh *fh );
 int nfs_read ( struct interface *intf, struct oncrpc_session *session,
                const struct nfs_fh *fh, uint64_t offset, uint32_t count );
 
@@ -151,6 +170,8 @@ int nfs_get_lookup_reply ( struct nfs_lookup_reply *lookup_reply,
                            struct oncrpc_reply *reply );
 int nfs_get_readlink_reply ( struct nfs_readlink_reply *readlink_reply,
                              struct oncrpc_reply *reply );
+int nfs_get_fsinfo_reply ( struct nfs_fsinfo_reply *fsinfo_reply,
+                           struct oncrpc_reply *reply );
 int nfs_get_read_reply ( struct nfs_read_reply *read_reply,
                          struct oncrpc_reply *reply );
 
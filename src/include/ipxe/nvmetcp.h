@@ -0,0 +1,581 @@
+#ifndef _IPXE_NVMETCP_H
+#define _IPXE_NVMETCP_H
+
+/** @file
+ *
+ * NVMe over TCP protocol
+ *
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+FILE_SECBOOT ( PERMITTED );
+
+#include <stdint.h>
+#include <ipxe/refcnt.h>
+#include <ipxe/list.h>
+#include <ipxe/interface.h>
+#include <ipxe/socket.h>
+#include <ipxe/retry.h>
+#include <ipxe/uuid.h>
+#include <ipxe/acpi.h>
+
+/** Default NVMe/TCP port */
+#define NVMETCP_PORT 4420
+
+/** NVMe/TCP PDU common header */
+struct nvmetcp_header {
+	/** PDU type */
+	uint8_t type;
+	/** Flags */
+	uint8_t flags;
+	/** Header length */
+	uint8_t hlen;
+	/** PDU data offset */
+	uint8_t pdo;
+	/** PDU length */
+	uint32_t plen;
+} __attribute__ (( packed ));
+
+/** Initialize connection request PDU type */
+#define NVMETCP_ICREQ 0x00
+
+/** Initialize connection response PDU type */
+#define NVMETCP_ICRESP 0x01
+
+/** Host to controller terminate connection request PDU type */
+#define NVMETCP_H2CTERM 0x02
+
+/** Controller to host terminate connection request PDU type */
+#define NVMETCP_C2HTERM 0x03
+
+/** Command capsule PDU type */
+#define NVMETCP_CAPSULECMD 0x04
+
+/** Response capsule PDU type */
+#define NVMETCP_CAPSULERESP 0x05
+
+/** Host to controller data PDU type */
+#define NVMETCP_H2CDATA 0x06
+
+/** Controller to host data PDU type */
+#define NVMETCP_C2HDATA 0x07
+
+/** Ready to transfer PDU type */
+#define NVMETCP_R2T 0x09
+
+/** Header digest present */
+#define NVMETCP_FL_HDGST 0x01
+
+/** Data digest present */
+#define NVMETCP_FL_DDGST 0x02
+
+/** Last data PDU for a command */
+#define NVMETCP_FL_LAST_PDU 0x04
+
+/** Command completed successfully without a response capsule */
+#define NVMETCP_FL_SUCCESS 0x08
+
+/** NVMe/TCP initialize connection request PDU */
+struct nvmetcp_icreq {
+	/** Common header */
+	struct nvmetcp_header hdr;
+	/** PDU format version */
+	uint16_t pfv;
+	/** Host PDU data alignment */
+	uint8_t hpda;
+	/** Digest types enabled */
+	uint8_t dgst;
+	/** Maximum number of outstanding R2Ts */
+	uint32_t maxr2t;
+	/** Reserved */
+	uint8_t reserved[112];
+} __attribute__ (( packed ));
+
+/** NVMe/TCP initialize connection response PDU */
+struct nvmetcp_icresp {
+	/** Common header */
+	struct nvmetcp_header hdr;
+	/** PDU format version */
+	uint16_t pfv;
+	/** Controller PDU data alignment */
+	uint8_t cpda;
+	/** Digest types enabled */
+	uint8_t dgst;
+	/** Maximum host to controller data length */
+	uint32_t maxh2cdata;
+	/** Reserved */
+	uint8_t reserved[112];
+} __attribute__ (( packed ));
+
+/** NVMe/TCP terminate connection request PDU */
+struct nvmetcp_term {
+	/** Common header */
+	struct nvmetcp_header hdr;
+	/** Fatal error status */
+	uint16_t fes;
+	/** Fatal error information */
+	uint32_t fei;
+	/** Reserved */
+	uint8_t reserved[10];
+} __attribute__ (( packed ));
+
+/** An NVMe scatter-gather list descriptor */
+struct nvme_sgl {
+	/** Address (or offset within in-capsule data) */
+	uint64_t addr;
+	/** Length */
+	uint32_t len;
+	/** Reserved */
+	uint8_t reserved[3];
+	/** Descriptor type */
+	uint8_t type;
+} __attribute__ (( packed ));
+
+/** NVMe data block SGL descriptor with in-capsule data
+ *
+ * This is an offset-addressed data block descriptor, as required for
+ * data carried within a command capsule.
+ */
+#define NVME_SGL_DATA_OFFSET 0x01
+
+/** NVMe transport data block SGL descriptor
+ *
+ * This is a transport-specific data block descriptor, as used for
+ * data carried by separate H2CData or C2HData PDUs.
+ */
+#define NVME_SGL_TRANSPORT 0x5a
+
+/** An NVMe submission queue entry */
+struct nvme_command {
+	/** Opcode */
+	uint8_t opcode;
+	/** Flags */
+	uint8_t flags;
+	/** Command identifier */
+	uint16_t cid;
+	/** Namespace identifier */
+	uint32_t nsid;
+	/** Reserved */
+	uint8_t reserved[8];
+	/** Metadata pointer */
+	uint64_t mptr;
+	/** Data pointer */
+	struct nvme_sgl sgl;
+	/** Command dwords 10-15 */
+	uint32_t cdw[6];
+} __attribute__ (( packed ));
+
+/** NVMe command uses SGLs for data transfer */
+#define NVME_CMD_SGL 0x40
+
+/** NVMe fabrics command submission queue entry */
+struct nvme_fabrics_command {
+	/** Opcode */
+	uint8_t opcode;
+	/** Flags */
+	uint8_t flags;
+	/** Command identifier */
+	uint16_t cid;
+	/** Fabrics command type */
+	uint8_t fctype;
+	/** Reserved */
+	uint8_t reserved[19];
+	/** Data pointer */
+	struct nvme_sgl sgl;
+	/** Command-specific fields */
+	union {
+		/** Connect command */
+		struct {
+			/** Record format */
+			uint16_t recfmt;
+			/** Queue identifier */
+			uint16_t qid;
+			/** Submission queue size (zero-based) */
+			uint16_t sqsize;
+			/** Connect attributes */
+			uint8_t cattr;
+			/** Reserved */
+			uint8_t reserved;
+			/** Keep alive timeout */
+			uint32_t kato;
+		} __attribute__ (( packed )) connect;
+		/** Property Get or Property Set command */
+		struct {
+			/** Attributes */
+			uint8_t attrib;
+			/** Reserved */
+			uint8_t reserved[3];
+			/** Property offset */
+			uint32_t offset;
+			/** Property value */
+			uint64_t value;
+		} __attribute__ (( packed )) property;
+		/** Raw command dwords */
+		uint32_t cdw[6];
+	} __attribute__ (( packed ));
+} __attribute__ (( packed ));
+
+/** An NVMe submission queue entry */
+union nvme_sqe {
+	/** Standard command */
+	struct nvme_command cmd;
+	/** Fabrics command */
+	struct nvme_fabrics_command fabrics;
+};
+
+/** An NVMe completion queue entry */
+struct nvme_cqe {
+	/** Command-specific dword 0 */
+	uint32_t dw0;
+	/** Command-specific dword 1 */
+	uint32_t dw1;
+	/** Submission queue head pointer */
+	uint16_t sqhd;
+	/** Submission queue identifier */
+	uint16_t sqid;
+	/** Command identifier */
+	uint16_t cid;
+	/** Status field and phase tag */
+	uint16_t status;
+} __attribute__ (( packed ));
+
+/** Extract NVMe status code type and status code */
+#define NVME_STATUS( status ) ( ( (status) >> 1 ) & 0x7ff )
+
+/** NVMe write command opcode */
+#define NVME_WRITE 0x01
+
+/** NVMe read command opcode */
+#define NVME_READ 0x02
+
+/** NVMe identify command opcode */
+#define NVME_IDENTIFY 0x06
+
+/** NVMe set features command opcode */
+#define NVME_SET_FEATURES 0x09
+
+/** NVMe fabrics command opcode */
+#define NVME_FABRICS 0x7f
+
+/** Identify namespace */
+#define NVME_IDENTIFY_NS 0x00
+
+/** Identify controller */
+#define NVME_IDENTIFY_CTRL 0x01
+
+/** Number of queues feature identifier */
+#define NVME_FEAT_NUM_QUEUES 0x07
+
+/** Fabrics property set command type */
+#define NVME_FABRICS_PROPERTY_SET 0x00
+
+/** Fabrics connect command type */
+#define NVME_FABRICS_CONNECT 0x01
+
+/** Fabrics property get command type */
+#define NVME_FABRICS_PROPERTY_GET 0x04
+
+/** Property is eight bytes wide */
+#define NVME_PROPERTY_64BIT 0x01
+
+/** Controller capabilities property */
+#define NVME_CAP 0x00
+
+/** Extract maximum queue entries supported (zero-based) */
+#define NVME_CAP_MQES( cap ) ( (cap) & 0xffff )
+
+/** Extract controller ready timeout (in 500ms units) */
+#define NVME_CAP_TO( cap ) ( ( (cap) >> 24 ) & 0xff )
+
+/** Controller configuration property */
+#define NVME_CC 0x14
+
+/** Controller enable */
+#define NVME_CC_EN 0x00000001UL
+
+/** I/O submission queue entry size (as log2) */
+#define NVME_CC_IOSQES( log2 ) ( (log2) << 16 )
+
+/** I/O completion queue entry size (as log2) */
+#define NVME_CC_IOCQES( log2 ) ( (log2) << 20 )
+
+/** Controller status property */
+#define NVME_CSTS 0x1c
+
+/** Controller ready */
+#define NVME_CSTS_RDY 0x00000001UL
+
+/** Controller fatal status */
+#define NVME_CSTS_CFS 0x00000002UL
+
+/** Admin queue identifier */
+#define NVME_ADMIN_QID 0
+
+/** I/O queue identifier */
+#define NVME_IO_QID 1
+
+/** Dynamic controller identifier */
+#define NVME_CNTLID_DYNAMIC 0xffff
+
+/** NVMe fabrics connect command data */
+struct nvme_connect_data {
+	/** Host identifier */
+	union uuid hostid;
+	/** Controller identifier */
+	uint16_t cntlid;
+	/** Reserved */
+	uint8_t reserved_a[238];
+	/** Subsystem NVMe qualified name */
+	char subnqn[256];
+	/** Host NVMe qualified name */
+	char hostnqn[256];
+	/** Reserved */
+	uint8_t reserved_b[256];
+} __attribute__ (( packed ));
+
+/** NVMe identify data length */
+#define NVME_IDENTIFY_LEN 4096
+
+/** NVMe identify controller data (partial) */
+struct nvme_identify_ctrl {
+	/** Reserved */
+	uint8_t reserved_a[77];
+	/** Maximum data transfer size (as log2 of minimum page size) */
+	uint8_t mdts;
+} __attribute__ (( packed ));
+
+/** NVMe LBA format */
+struct nvme_lbaf {
+	/** Metadata size */
+	uint16_t ms;
+	/** LBA data size (as log2) */
+	uint8_t lbads;
+	/** Relative performance */
+	uint8_t rp;
+} __attribute__ (( packed ));
+
+/** NVMe identify namespace data (partial) */
+struct nvme_identify_ns {
+	/** Namespace size */
+	uint64_t nsze;
+	/** Namespace capacity */
+	uint64_t ncap;
+	/** Namespace utilization */
+	uint64_t nuse;
+	/** Namespace features */
+	uint8_t nsfeat;
+	/** Number of LBA formats (zero-based) */
+	uint8_t nlbaf;
+	/** Formatted LBA size */
+	uint8_t flbas;
+	/** Reserved */
+	uint8_t reserved[77];
+	/** Namespace globally unique identifier */
+	uint8_t nguid[16];
+	/** IEEE extended unique identifier */
+	uint8_t eui64[8];
+	/** LBA formats */
+	struct nvme_lbaf lbaf[16];
+} __attribute__ (( packed ));
+
+/** Namespace globally unique identifier type */
+#define NVME_NIDT_NGUID 0x02
+
+/** Extract formatted LBA format index */
+#define NVME_FLBAS_INDEX( flbas ) ( (flbas) & 0x0f )
+
+/** Minimum memory page size (as log2) */
+#define NVME_PAGE_SHIFT 12
+
+/** NVMe/TCP command capsule PDU */
+struct nvmetcp_capsule_cmd {
+	/** Common header */
+	struct nvmetcp_header hdr;
+	/** Submission queue entry */
+	union nvme_sqe sqe;
+} __attribute__ (( packed ));
+
+/** NVMe/TCP response capsule PDU */
+struct nvmetcp_capsule_resp {
+	/** Common header */
+	struct nvmetcp_header hdr;
+	/** Completion queue entry */
+	struct nvme_cqe cqe;
+} __attribute__ (( packed ));
+
+/** NVMe/TCP data PDU (H2CData or C2HData) */
+struct nvmetcp_data {
+	/** Common header */
+	struct nvmetcp_header hdr;
+	/** Command capsule command identifier */
+	uint16_t cccid;
+	/** Transfer tag */
+	uint16_t ttag;
+	/** Data offset */
+	uint32_t datao;
+	/** Data length */
+	uint32_t datal;
+	/** Reserved */
+	uint8_t reserved[4];
+} __attribute__ (( packed ));
+
+/** NVMe/TCP ready to transfer PDU */
+struct nvmetcp_r2t {
+	/** Common header */
+	struct nvmetcp_header hdr;
+	/** Command capsule command identifier */
+	uint16_t cccid;
+	/** Transfer tag */
+	uint16_t ttag;
+	/** Requested data offset */
+	uint32_t r2to;
+	/** Requested data length */
+	uint32_t r2tl;
+	/** Reserved */
+	uint8_t reserved[4];
+} __attribute__ (( packed ));
+
+/** A received NVMe/TCP PDU header */
+union nvmetcp_pdu {
+	/** Common header */
+	struct nvmetcp_header hdr;
+	/** Initialize connection response */
+	struct nvmetcp_icresp icresp;
+	/** Terminate connection request */
+	struct nvmetcp_term term;
+	/** Response capsule */
+	struct nvmetcp_capsule_resp resp;
+	/** Controller to host data */
+	struct nvmetcp_data data;
+	/** Ready to transfer */
+	struct nvmetcp_r2t r2t;
+	/** Raw bytes */
+	uint8_t bytes[ sizeof ( struct nvmetcp_icresp ) ];
+};
+
+/** NVMe/TCP receive state machine */
+enum nvmetcp_rx_state {
+	/** Receiving the common header */
+	NVMETCP_RX_COMMON = 0,
+	/** Receiving the PDU-specific header */
+	NVMETCP_RX_HEADER,
+	/** Discarding padding before the PDU data */
+	NVMETCP_RX_PAD,
+	/** Receiving the PDU data */
+	NVMETCP_RX_DATA,
+};
+
+/** An NVMe/TCP queue pair
+ *
+ * Each queue pair uses its own TCP connection.
+ */
+struct nvmetcp_queue {
+	/** NVMe/TCP device */
+	struct nvmetcp_device *nvme;
+	/** Transport-layer socket */
+	struct interface socket;
+	/** Queue identifier */
+	unsigned int qid;
+	/** Number of command slots */
+	unsigned int depth;
+	/** Number of outstanding commands */
+	unsigned int count;
+	/** Queue state flags */
+	unsigned int flags;
+	/** Maximum host to controller data PDU length */
+	size_t maxh2cdata;
+	/** Controller PDU data alignment (in dwords, zero-based) */
+	unsigned int cpda;
+
+	/** Receive state */
+	enum nvmetcp_rx_state rx_state;
+	/** Received PDU header */
+	union nvmetcp_pdu rx_pdu;
+	/** Length of current receive state */
+	size_t rx_len;
+	/** Offset within current receive state */
+	size_t rx_offset;
+};
+
+/** Initialize connection request has been sent */
+#define NVMETCP_QUEUE_ICREQ 0x0001
+
+/** Initialize connection response has been received */
+#define NVMETCP_QUEUE_ICRESP 0x0002
+
+/** Queue has been connected */
+#define NVMETCP_QUEUE_CONNECTED 0x0004
+
+/** Number of admin queue command slots
+ *
+ * This is the minimum admin queue size that may be requested via the
+ * fabrics connect command.
+ */
+#define NVMETCP_ADMIN_DEPTH 32
+
+/** Default I/O queue depth */
+#define NVMETCP_DEFAULT_DEPTH 16
+
+/** Maximum I/O queue depth */
+#define NVMETCP_MAX_DEPTH 128
+
+/** Maximum number of blocks per transfer
+ *
+ * This is the limit imposed by the 16-bit zero-based block count
+ * within a read or write command.
+ */
+#define NVMETCP_MAX_COUNT 65536
+
+/** Controller ready polling interval */
+#define NVMETCP_READY_POLL_INTERVAL ( TICKS_PER_SEC / 10 )
+
+/** An NVMe/TCP device
+ *
+ * This represents a single namespace accessed via an admin queue
+ * and a single I/O queue.
+ */
+struct nvmetcp_device {
+	/** Reference counter */
+	struct refcnt refcnt;
+	/** Block device interface */
+	struct interface block;
+	/** Admin queue */
+	struct nvmetcp_queue admin;
+	/** I/O queue */
+	struct nvmetcp_queue io;
+	/** List of active commands */
+	struct list_head commands;
+
+	/** Target address */
+	char *target_address;
+	/** Target port */
+	unsigned int target_port;
+	/** Target socket address (for boot firmware table) */
+	struct sockaddr target_sockaddr;
+	/** Subsystem NVMe qualified name */
+	char *subnqn;
+	/** Namespace identifier */
+	uint32_t nsid;
+	/** Host NVMe qualified name */
+	char *hostnqn;
+	/** Host identifier */
+	union uuid hostid;
+
+	/** Controller identifier */
+	uint16_t cntlid;
+	/** Controller ready timeout (in ticks) */
+	unsigned long ready_timeout;
+	/** Time at which controller was enabled */
+	unsigned long enabled;
+	/** Controller ready polling timer */
+	struct retry_timer timer;
+	/** Maximum number of bytes per transfer (zero for no limit) */
+	size_t max_len;
+	/** Namespace globally unique identifier */
+	uint8_t nguid[16];
+
+	/** ACPI descriptor */
+	struct acpi_descriptor desc;
+};
+
+#endif /* _IPXE_NVMETCP_H */
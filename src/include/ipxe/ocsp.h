@@ -124,19 +124,23 @@ ocsp_put ( struct ocsp_check *ocsp ) {
  * Check if X.509 certificate requires an OCSP check
  *
  * @v cert		X.509 certificate
+ * @v time		Time at which to check certificate
  * @ret ocsp_required	An OCSP check is required
  */
-static inline int ocsp_required ( struct x509_certificate *cert ) {
+static inline int ocsp_required ( struct x509_certificate *cert,
+				  time_t time ) {
+	struct x509_ocsp_responder *ocsp = &cert->extensions.auth_info.ocsp;
 
 	/* An OCSP check is never required if OCSP checks are disabled */
 	if ( ! OCSP_ENABLED )
 		return 0;
 
 	/* An OCSP check is required if an OCSP URI exists but the
-	 * OCSP status is not (yet) good.
+	 * OCSP status is not (yet) good, or if the response that
+	 * established the good status has passed its nextUpdate time.
 	 */
-	return ( cert->extensions.auth_info.ocsp.uri.len &&
-		 ( ! cert->extensions.auth_info.ocsp.good ) );
+	return ( ocsp->uri.len &&
+		 ( ( ! ocsp->good ) || ( time > ocsp->expiry ) ) );
 }
 
 extern int ocsp_check ( struct x509_certificate *cert,
@@ -0,0 +1,107 @@
+#ifndef _IPXE_PCAP_H
+#define _IPXE_PCAP_H
+
+/**
+ * @file
+ *
+ * Packet capture
+ *
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+FILE_SECBOOT ( PERMITTED );
+
+#include <stdint.h>
+#include <ipxe/netdevice.h>
+#include <ipxe/iobuf.h>
+
+/** A pcap file header */
+struct pcap_file_header {
+	/** Magic number */
+	uint32_t magic;
+	/** Major version */
+	uint16_t major;
+	/** Minor version */
+	uint16_t minor;
+	/** Time zone offset (always zero) */
+	int32_t thiszone;
+	/** Timestamp accuracy (always zero) */
+	uint32_t sigfigs;
+	/** Maximum captured length of each packet */
+	uint32_t snaplen;
+	/** Link-layer header type */
+	uint32_t linktype;
+} __attribute__ (( packed ));
+
+/** pcap file magic number (microsecond timestamps) */
+#define PCAP_MAGIC 0xa1b2c3d4UL
+
+/** pcap file major version */
+#define PCAP_VERSION_MAJOR 2
+
+/** pcap file minor version */
+#define PCAP_VERSION_MINOR 4
+
+/** Ethernet link-layer header type */
+#define PCAP_LINKTYPE_ETHERNET 1
+
+/** Private link-layer header type (used for non-Ethernet devices) */
+#define PCAP_LINKTYPE_USER0 147
+
+/** A pcap packet record header */
+struct pcap_record_header {
+	/** Timestamp (seconds) */
+	uint32_t ts_sec;
+	/** Timestamp (microseconds) */
+	uint32_t ts_usec;
+	/** Captured length */
+	uint32_t incl_len;
+	/** Original length */
+	uint32_t orig_len;
+} __attribute__ (( packed ));
+
+/** Default capture snapshot length */
+#define PCAP_DEFAULT_SNAPLEN 128
+
+/** Default number of capture ring slots */
+#define PCAP_DEFAULT_SLOTS 1024
+
+/** A packet capture ring
+ *
+ * Packets are held in a fixed number of fixed-size slots, each
+ * containing a pcap record header followed by up to @c snaplen bytes
+ * of packet data.  When the ring is full, either the oldest packet
+ * is overwritten (head drop) or the new packet is discarded (tail
+ * drop).
+ */
+struct pcap_ring {
+	/** Network device */
+	struct net_device *netdev;
+	/** Number of slots */
+	unsigned int slots;
+	/** Snapshot length */
+	size_t snaplen;
+	/** Discard new packets (rather than old packets) when full */
+	int tail_drop;
+	/** Producer index */
+	unsigned int prod;
+	/** Consumer index */
+	unsigned int cons;
+	/** Number of packets dropped */
+	unsigned long dropped;
+	/** Wall clock time at start of capture */
+	uint32_t epoch;
+	/** Timer ticks at start of capture */
+	unsigned long ticks;
+	/** Slot data */
+	void *data;
+};
+
+extern void pcap_capture ( struct net_device *netdev,
+			   struct io_buffer *iobuf );
+extern int pcap_start ( struct net_device *netdev, size_t snaplen,
+			unsigned int slots, int tail_drop );
+extern void pcap_stop ( struct net_device *netdev );
+extern int pcap_save ( struct net_device *netdev, const char *name );
+
+#endif /* _IPXE_PCAP_H */
@@ -0,0 +1,73 @@
+#ifndef _IPXE_PCAPREPLAY_H
+#define _IPXE_PCAPREPLAY_H
+
+/**
+ * @file
+ *
+ * Packet capture replay network device
+ *
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+FILE_SECBOOT ( PERMITTED );
+
+#include <stdint.h>
+#include <ipxe/netdevice.h>
+#include <ipxe/if_ether.h>
+#include <ipxe/in.h>
+
+/** Maximum number of concurrently replayed TCP connections */
+#define PCAP_REPLAY_MAX_FLOWS 8
+
+/** A replayed TCP connection */
+struct pcap_replay_flow {
+	/** Server IPv4 address */
+	struct in_addr server;
+	/** Server TCP port */
+	uint16_t server_port;
+	/** Live client TCP port (or zero if unused) */
+	uint16_t port;
+	/** Recorded client TCP port (or zero if not yet bound) */
+	uint16_t recorded_port;
+	/** Next sequence number to be sent by live client */
+	uint32_t snd_nxt;
+	/** Live client sequence number at last synchronisation point */
+	uint32_t synced;
+};
+
+/** A packet capture replay network device */
+struct pcap_replay {
+	/** Network device */
+	struct net_device *netdev;
+	/** Capture data */
+	const void *data;
+	/** Length of capture data */
+	size_t len;
+	/** Capture data is byte-swapped */
+	int swapped;
+	/** Offset of next record within capture data */
+	size_t offset;
+	/** Recorded client MAC address */
+	uint8_t client[ETH_ALEN];
+	/** TCP connections */
+	struct pcap_replay_flow flows[PCAP_REPLAY_MAX_FLOWS];
+	/** Number of packets delivered to the network stack */
+	unsigned long packets;
+	/** Number of bytes delivered to the network stack */
+	size_t bytes;
+};
+
+/**
+ * Check if replay is complete
+ *
+ * @v replay		Replay network device
+ * @ret is_finished	Replay is complete
+ */
+static inline int pcap_replay_finished ( struct pcap_replay *replay ) {
+	return ( replay->offset >= replay->len );
+}
+
+extern struct net_device * alloc_pcap_replay ( const void *data,
+					       size_t len );
+
+#endif /* _IPXE_PCAPREPLAY_H */
@@ -359,6 +359,8 @@ struct peerdist_info_segment {
 	unsigned int blocks;
 	/** Block size */
 	size_t blksize;
+	/** Offset of raw block description (version 1 only) */
+	size_t blkdesc;
 	/** Segment hash of data
 	 *
 	 * This is MS-PCCRC's "HoD".
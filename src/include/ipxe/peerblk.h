@@ -110,7 +110,7 @@ struct peerdist_block {
 
 	/** Discovery client */
 	struct peerdisc_client discovery;
-	/** Current position in discovered peer list */
+	/** Current peer (or list head for the origin server) */
 	struct peerdisc_peer *peer;
 	/** Block download queue */
 	struct peerdist_block_queue *queue;
@@ -118,6 +118,8 @@ struct peerdist_block {
 	struct list_head queued;
 	/** Retry timer */
 	struct retry_timer timer;
+	/** Number of peer attempts made within the current cycle */
+	unsigned int attempts;
 	/** Number of full attempt cycles completed */
 	unsigned int cycles;
 	/** Most recent attempt failure */
@@ -66,6 +66,8 @@ struct peerdisc_segment {
 	struct list_head clients;
 	/** Transmission timer */
 	struct retry_timer timer;
+	/** Number of discovery requests sent */
+	unsigned int probes;
 };
 
 /** A PeerDist discovery peer */
@@ -18,10 +18,14 @@ FILE_SECBOOT ( PERMITTED );
 #include <ipxe/uri.h>
 #include <ipxe/xferbuf.h>
 #include <ipxe/pccrc.h>
+#include <ipxe/peerdisc.h>
 
 /** Maximum number of concurrent block downloads */
 #define PEERMUX_MAX_BLOCKS 32
 
+/** Number of upcoming segments for which discovery is started early */
+#define PEERMUX_LOOKAHEAD 2
+
 /** PeerDist download content information cache */
 struct peerdist_info_cache {
 	/** Content information */
@@ -42,6 +46,14 @@ struct peerdist_multiplexed_block {
 	struct interface xfer;
 };
 
+/** A PeerDist upcoming segment discovery */
+struct peerdist_multiplexed_discovery {
+	/** Discovery client */
+	struct peerdisc_client client;
+	/** Segment index */
+	unsigned int index;
+};
+
 /** PeerDist statistics */
 struct peerdist_statistics {
 	/** Maximum observed number of peers */
@@ -76,6 +88,8 @@ struct peerdist_multiplexer {
 	struct list_head idle;
 	/** Block downloads */
 	struct peerdist_multiplexed_block block[PEERMUX_MAX_BLOCKS];
+	/** Upcoming segment discoveries */
+	struct peerdist_multiplexed_discovery lookahead[PEERMUX_LOOKAHEAD];
 
 	/** Statistics */
 	struct peerdist_statistics stats;
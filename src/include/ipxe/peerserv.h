@@ -0,0 +1,20 @@
+#ifndef _IPXE_PEERSERV_H
+#define _IPXE_PEERSERV_H
+
+/** @file
+ *
+ * Peer Content Caching and Retrieval (PeerDist) protocol content server
+ *
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+FILE_SECBOOT ( PERMITTED );
+
+#include <stddef.h>
+
+/** PeerDist content server retrieval port */
+#define PEERSERV_PORT 80
+
+extern void peerserv_add ( const void *data, size_t len );
+
+#endif /* _IPXE_PEERSERV_H */
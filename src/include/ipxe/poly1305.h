@@ -0,0 +1,49 @@
+#ifndef _IPXE_POLY1305_H
+#define _IPXE_POLY1305_H
+
+/** @file
+ *
+ * Poly1305 message authentication code
+ *
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+FILE_SECBOOT ( PERMITTED );
+
+#include <stdint.h>
+
+/** Poly1305 key length */
+#define POLY1305_KEY_LEN 32
+
+/** Poly1305 block length */
+#define POLY1305_BLOCK_LEN 16
+
+/** Poly1305 tag length */
+#define POLY1305_TAG_LEN 16
+
+/** A Poly1305 context
+ *
+ * The accumulator and the multiplier are held as five 26-bit limbs,
+ * allowing all products to be calculated using 64-bit arithmetic
+ * without overflow.
+ */
+struct poly1305_context {
+	/** Multiplier (clamped "r" portion of key) */
+	uint32_t r[5];
+	/** Accumulator */
+	uint32_t h[5];
+	/** Final addend ("s" portion of key) */
+	uint32_t s[4];
+	/** Accumulated partial block */
+	uint8_t data[POLY1305_BLOCK_LEN];
+	/** Length of accumulated partial block */
+	unsigned int len;
+};
+
+extern void poly1305_init ( struct poly1305_context *poly, const void *key );
+extern void poly1305_update ( struct poly1305_context *poly,
+			      const void *data, size_t len );
+extern void poly1305_pad ( struct poly1305_context *poly );
+extern void poly1305_final ( struct poly1305_context *poly, void *tag );
+
+#endif /* _IPXE_POLY1305_H */
@@ -44,8 +44,27 @@ struct process_descriptor {
 	void ( * step ) ( void *object );
 	/** Automatically reschedule the process */
 	int reschedule;
+	/** Scheduling priority */
+	unsigned int priority;
 };
 
+/** Normal priority (protocol and application processes) */
+#define PROCESS_PRIORITY_NORMAL 0
+
+/** Polling priority (device and timer polling processes)
+ *
+ * Polling processes are stepped ahead of normal processes on every
+ * call to step(), so that received packets and expired timers are
+ * handled with low latency however many other processes are
+ * runnable.  Polling processes never represent pending work in
+ * their own right, and so may be left to wait until the next
+ * interrupt via cpu_nap() when no normal processes are runnable.
+ */
+#define PROCESS_PRIORITY_POLL 1
+
+/** Number of process priorities */
+#define PROCESS_PRIORITIES 2
+
 /**
  * Define a process step() method
  *
@@ -106,6 +125,7 @@ struct process_descriptor {
  * Define a process descriptor for a pure process
  *
  * A pure process is a process that does not have a containing object.
+ * Pure processes are permanent polling processes.
  *
  * @v step		Process' step() method
  * @ret desc		Object interface descriptor
@@ -115,6 +135,7 @@ struct process_descriptor {
 		.offset = 0,						      \
 		.step = PROC_STEP ( struct process, _step ),		      \
 		.reschedule = 1,					      \
+		.priority = PROCESS_PRIORITY_POLL,			      \
 	}
 
 extern void * __attribute__ (( pure ))
@@ -122,6 +143,9 @@ process_object ( struct process *process );
 extern void process_add ( struct process *process );
 extern void process_del ( struct process *process );
 extern void step ( void );
+extern int process_runnable ( void );
+extern void process_active ( void );
+extern int process_idle ( void );
 
 /**
  * Initialise a static process
@@ -13,6 +13,14 @@ FILE_SECBOOT ( PERMITTED );
 #include <bits/profile.h>
 #include <ipxe/tables.h>
 
+/** Profilers are compiled in but must be individually enabled at runtime
+ *
+ * Building with PROFILE=2 allows profiling to be included in
+ * production builds, with each profiler enabled only when required
+ * (e.g. via the "profstat --enable" command).
+ */
+#define PROFILING_RUNTIME 2
+
 #ifndef PROFILING
 #ifdef NDEBUG
 #define PROFILING 0
@@ -21,6 +29,14 @@ FILE_SECBOOT ( PERMITTED );
 #endif
 #endif
 
+/** Number of profiler histogram buckets
+ *
+ * Bucket 0 counts zero-valued samples, and bucket N counts samples
+ * in the range [2^(N-1),2^N).  The final bucket also counts all
+ * larger samples.
+ */
+#define PROFILE_BUCKETS 32
+
 /**
  * A data structure for storing profiling information
  */
@@ -49,6 +65,10 @@ struct profiler {
 	 * (i.e. one less than would be returned by flsll(raw_accvar)).
 	 */
 	unsigned int accvar_msb;
+	/** Sample histogram (by log2 of sample value) */
+	unsigned int histogram[PROFILE_BUCKETS];
+	/** Profiler is enabled (if enabled at runtime) */
+	int enabled;
 };
 
 /** Profiler table */
@@ -69,6 +89,26 @@ extern void profile_update ( struct profiler *profiler, unsigned long sample );
 extern unsigned long profile_mean ( struct profiler *profiler );
 extern unsigned long profile_variance ( struct profiler *profiler );
 extern unsigned long profile_stddev ( struct profiler *profiler );
+extern unsigned long profile_percentile ( struct profiler *profiler,
+					  unsigned int percentile );
+extern struct profiler * find_profiler ( const char *name );
+
+/**
+ * Check if profiler is active
+ *
+ * @v profiler		Profiler
+ * @ret active		Profiler is active
+ */
+static inline __attribute__ (( always_inline )) int
+profile_active ( struct profiler *profiler ) {
+
+	/* Check runtime enable flag only if applicable */
+	if ( PROFILING == PROFILING_RUNTIME ) {
+		return profiler->enabled;
+	} else {
+		return PROFILING;
+	}
+}
 
 /**
  * Get start time
@@ -132,7 +172,7 @@ static inline __attribute__ (( always_inline )) void
 profile_start_at ( struct profiler *profiler, unsigned long started ) {
 
 	/* If profiling is active then record start timestamp */
-	if ( PROFILING )
+	if ( profile_active ( profiler ) )
 		profiler->started = ( started - profile_excluded );
 }
 
@@ -146,7 +186,7 @@ static inline __attribute__ (( always_inline )) void
 profile_stop_at ( struct profiler *profiler, unsigned long stopped ) {
 
 	/* If profiling is active then record end timestamp and update stats */
-	if ( PROFILING ) {
+	if ( profile_active ( profiler ) ) {
 		profiler->stopped = ( stopped - profile_excluded );
 		profile_update ( profiler, profile_elapsed ( profiler ) );
 	}
@@ -161,7 +201,7 @@ static inline __attribute__ (( always_inline )) void
 profile_start ( struct profiler *profiler ) {
 
 	/* If profiling is active then record start timestamp */
-	if ( PROFILING )
+	if ( profile_active ( profiler ) )
 		profile_start_at ( profiler, profile_timestamp() );
 }
 
@@ -174,7 +214,7 @@ static inline __attribute__ (( always_inline )) void
 profile_stop ( struct profiler *profiler ) {
 
 	/* If profiling is active then record end timestamp and update stats */
-	if ( PROFILING )
+	if ( profile_active ( profiler ) )
 		profile_stop_at ( profiler, profile_timestamp() );
 }
 
@@ -187,7 +227,7 @@ static inline __attribute__ (( always_inline )) void
 profile_exclude ( struct profiler *profiler ) {
 
 	/* If profiling is active then update accumulated excluded time */
-	if ( PROFILING )
+	if ( profile_active ( profiler ) )
 		profile_excluded += profile_elapsed ( profiler );
 }
 
@@ -201,7 +241,7 @@ static inline __attribute__ (( always_inline )) void
 profile_custom ( struct profiler *profiler, unsigned long sample ) {
 
 	/* If profiling is active then update stats */
-	if ( PROFILING )
+	if ( profile_active ( profiler ) )
 		profile_update ( profiler, sample );
 }
 
@@ -12,6 +12,7 @@ FILE_SECBOOT ( PERMITTED );
 
 #include <stdint.h>
 #include <ipxe/drbg.h>
+#include <ipxe/process.h>
 
 /** An RBG */
 struct random_bit_generator {
@@ -19,6 +20,8 @@ struct random_bit_generator {
 	struct drbg_state state;
 	/** Startup has been attempted */
 	int started;
+	/** Background startup process */
+	struct process process;
 };
 
 extern struct random_bit_generator rbg;
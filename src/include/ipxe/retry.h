@@ -20,7 +20,7 @@ FILE_SECBOOT ( PERMITTED );
 
 /** A retry timer */
 struct retry_timer {
-	/** List of active timers */
+	/** List of running timers within the same timer wheel slot */
 	struct list_head list;
 	/** Timer is currently running */
 	unsigned int running;
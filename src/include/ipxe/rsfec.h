@@ -0,0 +1,24 @@
+#ifndef _IPXE_RSFEC_H
+#define _IPXE_RSFEC_H
+
+/** @file
+ *
+ * Reed-Solomon forward error correction
+ *
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+FILE_SECBOOT ( PERMITTED );
+
+#include <stdint.h>
+#include <stddef.h>
+
+/** Maximum number of encoding symbols per source block */
+#define RSFEC_MAX_N 255
+
+extern int rsfec_encode ( unsigned int k, void **source, unsigned int esi,
+			  void *symbol, size_t len );
+extern int rsfec_decode ( unsigned int k, uint8_t *esi, void **symbols,
+			  size_t len );
+
+#endif /* _IPXE_RSFEC_H */
@@ -19,6 +19,7 @@ FILE_SECBOOT ( PERMITTED );
 #include <ipxe/retry.h>
 #include <ipxe/process.h>
 #include <ipxe/blockdev.h>
+#include <ipxe/blockcache.h>
 #include <ipxe/acpi.h>
 #include <ipxe/uuid.h>
 #include <config/sanboot.h>
@@ -33,6 +34,9 @@ FILE_SECBOOT ( PERMITTED );
  */
 #define SAN_DEFAULT_DRIVE 0x80
 
+/** Maximum number of concurrent read/write fragments */
+#define SAN_MAX_DEPTH 8
+
 /** A SAN path */
 struct san_path {
 	/** Containing SAN device */
@@ -55,6 +59,54 @@ struct san_path {
 	struct acpi_descriptor *desc;
 };
 
+/** A SAN device read/write request */
+struct san_request {
+	/** List of outstanding requests */
+	struct list_head list;
+	/** Starting underlying block address of unissued portion */
+	uint64_t lba;
+	/** Number of underlying blocks not yet issued */
+	unsigned int count;
+	/** Data buffer for unissued portion */
+	void *buffer;
+	/** Block read/write method */
+	int ( * block_rw ) ( struct interface *control, struct interface *data,
+			     uint64_t lba, unsigned int count,
+			     void *buffer, size_t len );
+	/** Request status (or -EINPROGRESS if not yet complete) */
+	int rc;
+	/** Completion handler (if applicable)
+	 *
+	 * @v req		Read/write request
+	 * @v rc		Completion status code
+	 */
+	void ( * complete ) ( struct san_request *req, int rc );
+};
+
+/** A SAN device read/write fragment */
+struct san_fragment {
+	/** Containing SAN device */
+	struct san_device *sandev;
+	/** Owning read/write request */
+	struct san_request *req;
+	/** Command interface */
+	struct interface command;
+	/** SAN path (if command is in progress) */
+	struct san_path *sanpath;
+	/** Starting underlying block address */
+	uint64_t lba;
+	/** Number of underlying blocks (or zero if unused) */
+	unsigned int count;
+	/** Data buffer */
+	void *buffer;
+	/** Time at which command was initiated */
+	unsigned long started;
+	/** Number of times command has been retried */
+	unsigned int retries;
+	/** Command status */
+	int rc;
+};
+
 /** A SAN device */
 struct san_device {
 	/** Reference count */
@@ -85,10 +137,17 @@ struct san_device {
 	unsigned int blksize_shift;
 	/** Drive is a CD-ROM */
 	int is_cdrom;
+	/** Block cache (operating on underlying blocks) */
+	struct block_cache cache;
 
 	/** Driver private data */
 	void *priv;
 
+	/** Concurrent read/write fragments */
+	struct san_fragment frag[SAN_MAX_DEPTH];
+	/** List of outstanding read/write requests */
+	struct list_head requests;
+
 	/** Number of paths */
 	unsigned int paths;
 	/** Current active path */
@@ -261,10 +320,19 @@ extern struct san_device * sandev_find ( unsigned int drive );
 extern struct san_device * sandev_next ( unsigned int drive );
 extern int sandev_reopen ( struct san_device *sandev );
 extern int sandev_reset ( struct san_device *sandev );
+extern int sandev_flush ( struct san_device *sandev );
 extern int sandev_read ( struct san_device *sandev, uint64_t lba,
 			 unsigned int count, void *buffer );
 extern int sandev_write ( struct san_device *sandev, uint64_t lba,
 			  unsigned int count, void *buffer );
+extern void sandev_read_async ( struct san_device *sandev,
+				struct san_request *req, uint64_t lba,
+				unsigned int count, void *buffer );
+extern void sandev_write_async ( struct san_device *sandev,
+				 struct san_request *req, uint64_t lba,
+				 unsigned int count, void *buffer );
+extern void sandev_poll ( struct san_device *sandev );
+extern void sandev_cancel ( struct san_device *sandev, int rc );
 extern struct san_device * alloc_sandev ( struct uri **uris, unsigned int count,
 					  size_t priv_size );
 extern int register_sandev ( struct san_device *sandev, unsigned int drive,
@@ -16,6 +16,9 @@ FILE_SECBOOT ( PERMITTED );
 /** Maximum block for READ/WRITE (10) commands */
 #define SCSI_MAX_BLOCK_10 0xffffffffULL
 
+/** Maximum number of blocks for READ/WRITE (10) commands */
+#define SCSI_MAX_COUNT_10 0xffffU
+
 /**
  * @defgroup scsiops SCSI operation codes
  * @{
@@ -29,6 +32,7 @@ FILE_SECBOOT ( PERMITTED );
 #define SCSI_OPCODE_SERVICE_ACTION_IN	0x9e	/**< SERVICE ACTION IN */
 #define SCSI_SERVICE_ACTION_READ_CAPACITY_16 0x10 /**< READ CAPACITY (16) */
 #define SCSI_OPCODE_TEST_UNIT_READY	0x00	/**< TEST UNIT READY */
+#define SCSI_OPCODE_INQUIRY		0x12	/**< INQUIRY */
 
 /** @} */
 
@@ -203,6 +207,57 @@ struct scsi_cdb_test_unit_ready {
 	uint8_t control;
 } __attribute__ (( packed ));
 
+/** A SCSI "INQUIRY" CDB */
+struct scsi_cdb_inquiry {
+	/** Opcode (0x12) */
+	uint8_t opcode;
+	/** Flags */
+	uint8_t flags;
+	/** Page code */
+	uint8_t page;
+	/** Allocation length
+	 *
+	 * This is the size of the data-in buffer, in bytes.
+	 */
+	uint16_t len;
+	/** Control byte */
+	uint8_t control;
+} __attribute__ (( packed ));
+
+/** Enable vital product data */
+#define SCSI_INQUIRY_EVPD 0x01
+
+/** Block Limits vital product data page */
+#define SCSI_VPD_BLOCK_LIMITS 0xb0
+
+/** SCSI "INQUIRY" Block Limits vital product data page */
+struct scsi_block_limits {
+	/** Peripheral qualifier and device type */
+	uint8_t peripheral;
+	/** Page code (0xb0) */
+	uint8_t page;
+	/** Page length */
+	uint16_t len;
+	/** Reserved */
+	uint8_t reserved;
+	/** Maximum COMPARE AND WRITE length */
+	uint8_t max_compare;
+	/** Optimal transfer length granularity */
+	uint16_t granularity;
+	/** Maximum transfer length
+	 *
+	 * This is a number of logical blocks, or zero if there is no
+	 * reported limit.
+	 */
+	uint32_t max_len;
+	/** Optimal transfer length
+	 *
+	 * This is a number of logical blocks, or zero if there is no
+	 * reported optimal length.
+	 */
+	uint32_t opt_len;
+} __attribute__ (( packed ));
+
 /** A SCSI Command Data Block */
 union scsi_cdb {
 	struct scsi_cdb_read_10 read10;
@@ -212,6 +267,7 @@ union scsi_cdb {
 	struct scsi_cdb_read_capacity_10 readcap10;
 	struct scsi_cdb_read_capacity_16 readcap16;
 	struct scsi_cdb_test_unit_ready testready;
+	struct scsi_cdb_inquiry inquiry;
 	unsigned char bytes[16];
 };
 
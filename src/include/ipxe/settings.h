@@ -292,6 +292,9 @@ extern const struct settings_scope ipv6_settings_scope;
 /** DHCPv6 setting scope */
 extern const struct settings_scope dhcpv6_scope;
 
+/** Number of hash buckets within a generic settings block */
+#define GENERIC_SETTINGS_HASH_SIZE 16
+
 /**
  * A generic settings block
  *
@@ -301,6 +304,10 @@ struct generic_settings {
 	struct settings settings;
 	/** List of generic settings */
 	struct list_head list;
+	/** Generic settings hashed by name */
+	struct generic_setting *by_name[GENERIC_SETTINGS_HASH_SIZE];
+	/** Generic settings hashed by tag */
+	struct generic_setting *by_tag[GENERIC_SETTINGS_HASH_SIZE];
 };
 
 /** A child settings block locator function */
@@ -12,6 +12,7 @@ FILE_SECBOOT ( PERMITTED );
 
 #include <stdint.h>
 #include <ipxe/crypto.h>
+#include <ipxe/tables.h>
 
 /** An SHA-1 digest */
 struct sha1_digest {
@@ -55,10 +56,40 @@ union sha1_digest_data_dwords {
 			sizeof ( uint32_t ) ];
 };
 
+/** An SHA-1 hardware accelerator */
+struct sha1_accelerator {
+	/** Name */
+	const char *name;
+	/**
+	 * Check if accelerator is usable
+	 *
+	 * @ret rc		Return status code
+	 */
+	int ( * probe ) ( void );
+	/**
+	 * Digest data blocks
+	 *
+	 * @v digest		Digest (in big-endian order)
+	 * @v data		Data blocks
+	 * @v count		Number of blocks
+	 */
+	void ( * digest ) ( struct sha1_digest *digest, const void *data,
+			    size_t count );
+};
+
+/** SHA-1 hardware accelerator table */
+#define SHA1_ACCELERATORS \
+	__table ( struct sha1_accelerator, "sha1_accelerators" )
+
+/** Declare an SHA-1 hardware accelerator */
+#define __sha1_accelerator __table_entry ( SHA1_ACCELERATORS, 01 )
+
 /** An SHA-1 context */
 struct sha1_context {
 	/** Amount of accumulated data */
 	size_t len;
+	/** Hardware accelerator, if any */
+	struct sha1_accelerator *accel;
 	/** Digest and accumulated data */
 	union sha1_digest_data_dwords ddd;
 } __attribute__ (( packed ));
@@ -72,6 +103,8 @@ struct sha1_context {
 /** SHA-1 digest size */
 #define SHA1_DIGEST_SIZE sizeof ( struct sha1_digest )
 
+extern int sha1_accel_disabled;
+
 extern struct digest_algorithm sha1_algorithm;
 
 extern void prf_sha1 ( const void *key, size_t key_len, const char *label,
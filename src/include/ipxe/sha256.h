@@ -12,6 +12,7 @@ FILE_SECBOOT ( PERMITTED );
 
 #include <stdint.h>
 #include <ipxe/crypto.h>
+#include <ipxe/tables.h>
 
 /** SHA-256 number of rounds */
 #define SHA256_ROUNDS 64
@@ -58,12 +59,42 @@ union sha256_digest_data_dwords {
 			sizeof ( uint32_t ) ];
 };
 
+/** An SHA-256 hardware accelerator */
+struct sha256_accelerator {
+	/** Name */
+	const char *name;
+	/**
+	 * Check if accelerator is usable
+	 *
+	 * @ret rc		Return status code
+	 */
+	int ( * probe ) ( void );
+	/**
+	 * Digest data blocks
+	 *
+	 * @v digest		Digest (in big-endian order)
+	 * @v data		Data blocks
+	 * @v count		Number of blocks
+	 */
+	void ( * digest ) ( struct sha256_digest *digest, const void *data,
+			    size_t count );
+};
+
+/** SHA-256 hardware accelerator table */
+#define SHA256_ACCELERATORS \
+	__table ( struct sha256_accelerator, "sha256_accelerators" )
+
+/** Declare an SHA-256 hardware accelerator */
+#define __sha256_accelerator __table_entry ( SHA256_ACCELERATORS, 01 )
+
 /** An SHA-256 context */
 struct sha256_context {
 	/** Amount of accumulated data */
 	size_t len;
 	/** Digest size */
 	size_t digestsize;
+	/** Hardware accelerator, if any */
+	struct sha256_accelerator *accel;
 	/** Digest and accumulated data */
 	union sha256_digest_data_dwords ddd;
 } __attribute__ (( packed ));
@@ -80,6 +111,9 @@ struct sha256_context {
 /** SHA-224 digest size */
 #define SHA224_DIGEST_SIZE ( SHA256_DIGEST_SIZE * 224 / 256 )
 
+extern const uint32_t sha256_k[SHA256_ROUNDS];
+extern int sha256_accel_disabled;
+
 extern void sha256_family_init ( struct sha256_context *context,
 				 const struct sha256_digest *init,
 				 size_t digestsize );
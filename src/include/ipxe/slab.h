@@ -0,0 +1,83 @@
+#ifndef _IPXE_SLAB_H
+#define _IPXE_SLAB_H
+
+/** @file
+ *
+ * Slab allocator
+ *
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+FILE_SECBOOT ( PERMITTED );
+
+#include <stddef.h>
+#include <ipxe/list.h>
+
+/** A slab cache
+ *
+ * A slab cache holds fixed-size objects of a single type, carved out
+ * of larger slabs allocated from the heap.  Freed objects are kept
+ * on a per-slab free list for reuse, and slabs that become empty are
+ * returned to the heap when memory is short.
+ */
+struct slab_cache {
+	/** Name */
+	const char *name;
+	/** Object size */
+	size_t size;
+	/** Object stride within a slab (or zero if not yet known) */
+	size_t stride;
+	/** Slab size (which is also the slab alignment) */
+	size_t slab_size;
+	/** Slabs containing at least one free object
+	 *
+	 * Completely empty slabs are kept at the tail of this list.
+	 */
+	struct list_head partial;
+	/** Slabs containing no free objects */
+	struct list_head full;
+	/** List of slab caches */
+	struct list_head list;
+	/** Number of slabs */
+	unsigned int slabs;
+	/** Number of completely empty slabs */
+	unsigned int empty;
+	/** Number of objects in use */
+	unsigned int used;
+	/** Maximum number of objects in use */
+	unsigned int maxused;
+};
+
+/**
+ * Initialise a static slab cache
+ *
+ * @v _cache		Slab cache
+ * @v _name		Name
+ * @v _size		Object size
+ */
+#define SLAB_CACHE_INIT( _cache, _name, _size ) {			\
+		.name = (_name),					\
+		.size = (_size),					\
+		.partial = LIST_HEAD_INIT ( (_cache).partial ),		\
+		.full = LIST_HEAD_INIT ( (_cache).full ),		\
+		.list = LIST_HEAD_INIT ( (_cache).list ),		\
+	}
+
+/**
+ * Declare a slab cache
+ *
+ * @v _cache		Slab cache
+ * @v _name		Name
+ * @v _size		Object size
+ */
+#define SLAB_CACHE( _cache, _name, _size )				\
+	struct slab_cache _cache = SLAB_CACHE_INIT ( _cache, _name, _size )
+
+extern struct list_head slab_caches;
+
+extern void slab_create ( struct slab_cache *cache, const char *name,
+			  size_t size );
+extern void * slab_alloc ( struct slab_cache *cache );
+extern void slab_free ( struct slab_cache *cache, void *ptr );
+
+#endif /* _IPXE_SLAB_H */
@@ -36,6 +36,8 @@ FILE_SECBOOT ( PERMITTED );
 /** Syslog priority */
 #define SYSLOG_PRIORITY( facility, severity ) ( 8 * (facility) + (severity) )
 
+extern size_t syslog_format ( char *buf, size_t len, unsigned int severity,
+			     const char *message );
 extern int syslog_send ( struct interface *xfer, unsigned int severity,
 			 const char *message, const char *terminator );
 
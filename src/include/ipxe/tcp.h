@@ -13,6 +13,9 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 FILE_SECBOOT ( PERMITTED );
 
 #include <ipxe/tcpip.h>
+#include <ipxe/tables.h>
+#include <ipxe/list.h>
+#include <ipxe/interface.h>
 
 /**
  * A TCP header
@@ -107,12 +110,29 @@ struct tcp_sack_block {
 	uint32_t right;
 } __attribute__ (( packed ));
 
+/** A TCP transmission time record */
+struct tcp_xmit_record {
+	/** Starting SEQ value (in host-endian order) */
+	uint32_t seq;
+	/** Transmission time (in ticks) */
+	unsigned long time;
+};
+
 /** Maximum number of selective acknowledgement blocks
  *
  * This allows for the presence of the TCP timestamp option.
  */
 #define TCP_SACK_MAX 3
 
+/** Maximum number of received selective acknowledgement blocks
+ *
+ * This is the number of distinct selectively acknowledged ranges
+ * that we will remember as a sender.  Forgetting a range is harmless
+ * (it merely results in the range being retransmitted
+ * unnecessarily), so we keep this small.
+ */
+#define TCP_SACK_SCOREBOARD 8
+
 /** Padded TCP selective acknowledgement option (used for sending) */
 struct tcp_sack_padded_option {
 	uint8_t nop[2];
@@ -139,6 +159,36 @@ struct tcp_timestamp_padded_option {
 /** Code for the TCP timestamp option */
 #define TCP_OPTION_TS 8
 
+/** TCP Fast Open option
+ *
+ * This is defined in RFC 7413.
+ */
+struct tcp_fastopen_option {
+	uint8_t kind;
+	uint8_t length;
+	uint8_t cookie[0];
+} __attribute__ (( packed ));
+
+/** Code for the TCP Fast Open option */
+#define TCP_OPTION_FASTOPEN 34
+
+/** Minimum length of a TCP Fast Open cookie */
+#define TCP_FASTOPEN_COOKIE_MIN 4
+
+/** Maximum length of a TCP Fast Open cookie */
+#define TCP_FASTOPEN_COOKIE_MAX 16
+
+/** Maximum length of TCP SACK permitted and Fast Open options
+ *
+ * When sending the Fast Open option, we place it immediately after
+ * an unpadded SACK permitted option, so that a maximum-length cookie
+ * still fits within the 40 bytes available for SYN options.
+ */
+#define TCP_FASTOPEN_OPTION_MAX_LEN				\
+	( sizeof ( struct tcp_sack_permitted_option ) +		\
+	  sizeof ( struct tcp_fastopen_option ) +		\
+	  TCP_FASTOPEN_COOKIE_MAX )
+
 /** Parsed TCP options */
 struct tcp_options {
 	/** Window scale option, if present */
@@ -147,6 +197,10 @@ struct tcp_options {
 	const struct tcp_sack_permitted_option *spopt;
 	/** Timestamp option, if present */
 	const struct tcp_timestamp_option *tsopt;
+	/** Selective acknowledgement option, if present */
+	const struct tcp_sack_option *sackopt;
+	/** Fast Open option, if present */
+	const struct tcp_fastopen_option *foopt;
 };
 
 /** @} */
@@ -204,8 +258,9 @@ struct tcp_options {
 
 /** LISTEN
  *
- * Not currently used as a state; we have no support for listening
- * connections.  Given a unique value to avoid compiler warnings.
+ * Not currently used as a state: listening ports are represented by
+ * a TCP listener rather than by a connection.  Given a unique value
+ * to avoid compiler warnings.
  */
 #define TCP_LISTEN 0
 
@@ -328,7 +383,46 @@ struct tcp_options {
 #define TCP_MIN_PORT 1
 
 /**
- * Maxmimum advertised TCP window size
+ * Maximum amount of unacknowledged transmitted data
+ *
+ * Transmitted data must be retained in the transmit queue until it
+ * has been acknowledged.  We limit the amount of outstanding data in
+ * order to conserve memory usage.
+ */
+#define TCP_MAX_FLIGHT_SIZE ( 256 * 1024 )
+
+/** Number of duplicate ACKs required to trigger a fast retransmission
+ *
+ * This value is taken from RFC 5681.
+ */
+#define TCP_DUPACK_THRESHOLD 3
+
+/** Minimum TCP retransmission timeout
+ *
+ * RFC 6298 suggests a minimum of one second, but this is widely
+ * regarded as excessively conservative.
+ */
+#define TCP_MIN_RTO ( TICKS_PER_SEC / 4 )
+
+/** Maximum TCP retransmission timeout
+ *
+ * The connection will be abandoned when the backed-off
+ * retransmission timeout exceeds this value.
+ */
+#define TCP_MAX_RTO ( 10 * TICKS_PER_SEC )
+
+/** Number of transmission time records
+ *
+ * Transmission times are recorded for use by RACK loss detection.
+ * Segments transmitted within the same clock tick share a single
+ * record.  Segments older than the oldest record are assumed to have
+ * been transmitted at the time of the oldest record, which is
+ * conservative (i.e. delays loss detection).
+ */
+#define TCP_RACK_RECORDS 32
+
+/**
+ * Initial maximum advertised TCP window size
  *
  * The maximum bandwidth on any link is limited by
  *
@@ -358,9 +452,26 @@ struct tcp_options {
  * bandwidth), since in the event of a lost packet the window size
  * represents the maximum amount that will need to be retransmitted.
  *
- * We therefore choose a (rounded up) maximum window size of 2048kB.
+ * We therefore choose a (rounded up) initial maximum window size of
+ * 2048kB.  Receive window autotuning may subsequently grow the
+ * window for connections that are observed to need it (such as bulk
+ * transfers over long fat networks), up to TCP_MAX_WINDOW_SIZE.
+ */
+#define TCP_INITIAL_WINDOW_SIZE	( 2048 * 1024 )
+
+/**
+ * Maximum advertised TCP window size
+ *
+ * This is the ceiling for receive window autotuning.  A window of
+ * 32MB is sufficient for around 2.5Gbps over a 100ms path, and is
+ * the largest window that can be represented using our advertised
+ * window scale of 2**9.
+ *
+ * The autotuned window is additionally limited by the amount of
+ * free heap memory, since this is where any out-of-order data will
+ * have to be held while awaiting retransmission.
  */
-#define TCP_MAX_WINDOW_SIZE	( 2048 * 1024 )
+#define TCP_MAX_WINDOW_SIZE	( 32 * 1024 * 1024 )
 
 /**
  * Path MTU
@@ -379,6 +490,40 @@ struct tcp_options {
 #define TCP_PATH_MTU							\
 	( 1280 - 40 /* IPv6 */ - 20 /* TCP */ - 12 /* TCP timestamp */ )
 
+/**
+ * Maximum length of data within a segment using segmentation offload
+ *
+ * When the transmitting network device is capable of TCP
+ * segmentation, we may construct a single segment containing many
+ * multiples of the path MTU.  This must leave space within the
+ * 64kB IPv4 total length (or IPv6 payload length) for the headers.
+ */
+#define TCP_TSO_MAX_LEN ( 48 * TCP_PATH_MTU )
+
+/**
+ * Maximum length of data within a TCP Fast Open SYN
+ *
+ * This leaves space within the path MTU for the additional options
+ * present only within a SYN.
+ */
+#define TCP_FASTOPEN_MAX_LEN					\
+	( TCP_PATH_MTU - sizeof ( struct tcp_mss_option ) -	\
+	  sizeof ( struct tcp_window_scale_padded_option ) -	\
+	  TCP_FASTOPEN_OPTION_MAX_LEN )
+
+/** Number of cached TCP Fast Open cookies */
+#define TCP_FASTOPEN_CACHE 8
+
+/**
+ * TCP Fast Open SYN delay
+ *
+ * When a Fast Open cookie is available for the peer, we delay the
+ * initial SYN very slightly to give the application an opportunity
+ * to provide data to be included within the SYN.  The SYN will be
+ * sent immediately if data is provided before this delay expires.
+ */
+#define TCP_FASTOPEN_DELAY ( ( TICKS_PER_SEC / 100 ) + 1 )
+
 /** TCP maximum segment lifetime
  *
  * Currently set to 2 minutes, as per RFC 793.
@@ -402,6 +547,7 @@ struct tcp_options {
 	  sizeof ( struct tcp_header ) +			\
 	  sizeof ( struct tcp_mss_option ) +			\
 	  sizeof ( struct tcp_window_scale_padded_option ) +	\
+	  TCP_FASTOPEN_OPTION_MAX_LEN +				\
 	  sizeof ( struct tcp_timestamp_padded_option ) )
 
 /**
@@ -453,8 +599,190 @@ struct tcp_statistics {
 	unsigned long in_octets;
 	/** Number of octets processed and passed to upper layer */
 	unsigned long in_octets_good;
+
+	/** Number of segments retransmitted */
+	unsigned long out_rtx_segs;
+	/** Number of fast retransmissions (i.e. without timeout) */
+	unsigned long fast_rtx;
+	/** Number of losses detected by RACK */
+	unsigned long rack_loss;
+
+	/** Largest autotuned maximum receive window */
+	unsigned long rcv_win_max;
+	/** Most recent smoothed round-trip time (in ticks) */
+	unsigned long rtt;
+	/** Most recent round-trip time variation (in ticks) */
+	unsigned long rttvar;
+	/** Most recent retransmission timeout (in ticks) */
+	unsigned long rto;
+
+	/** Number of duplicate ACKs received */
+	unsigned long dupacks;
+	/** Total time spent with a zero window in either direction
+	 * (in ticks, excluding any currently open interval)
+	 */
+	unsigned long zero_win;
+};
+
+/** Per-connection TCP statistics */
+struct tcp_connection_statistics {
+	/** Number of segments received */
+	unsigned long in_segs;
+	/** Number of octets received (including duplicate data) */
+	unsigned long in_octets;
+	/** Number of segments transmitted */
+	unsigned long out_segs;
+	/** Number of octets transmitted (including retransmissions) */
+	unsigned long out_octets;
+	/** Number of segments retransmitted */
+	unsigned long out_rtx_segs;
+	/** Number of duplicate ACKs received */
+	unsigned long dupacks;
+	/** Time spent advertising a zero receive window (in ticks) */
+	unsigned long rcv_zero_win;
+	/** Time spent with a zero peer window (in ticks) */
+	unsigned long snd_zero_win;
 };
 
+/** TCP connection information */
+struct tcp_info {
+	/** Remote socket address */
+	struct sockaddr_tcpip peer;
+	/** Local port */
+	unsigned int local_port;
+	/** Name of current TCP state */
+	const char *state;
+	/** Statistics */
+	struct tcp_connection_statistics stats;
+	/** Smoothed round-trip time (in ticks), or zero if unknown */
+	unsigned long srtt;
+	/** Advertised receive window */
+	uint32_t rcv_win;
+	/** Peer's send window */
+	uint32_t snd_win;
+	/** Congestion window */
+	uint32_t cwnd;
+	/** Number of out-of-order octets awaiting reassembly */
+	size_t ooo_len;
+	/** Number of out-of-order ranges awaiting reassembly */
+	unsigned int ooo_ranges;
+};
+
+/** TCP congestion control state */
+struct tcp_congestion {
+	/** Congestion control algorithm */
+	struct tcp_congestion_algorithm *algorithm;
+	/** Congestion window (in bytes) */
+	uint32_t cwnd;
+	/** Slow start threshold (in bytes) */
+	uint32_t ssthresh;
+	/** Number of bytes acknowledged but not yet applied to window */
+	uint32_t acked;
+
+	/** Start of current congestion avoidance epoch (in ticks) */
+	unsigned long epoch;
+	/** Window size prior to most recent reduction (in bytes) */
+	uint32_t wmax;
+	/** Time to reach previous window size (in ticks) */
+	unsigned long period;
+	/** Estimated window size for a standard TCP flow (in bytes) */
+	uint32_t west;
+};
+
+/** A TCP congestion control algorithm */
+struct tcp_congestion_algorithm {
+	/** Name */
+	const char *name;
+	/**
+	 * Increase congestion window during slow start
+	 *
+	 * @v cc		Congestion control state
+	 * @v len		Length of newly acknowledged data
+	 */
+	void ( * slow_start ) ( struct tcp_congestion *cc, uint32_t len );
+	/**
+	 * Increase congestion window during congestion avoidance
+	 *
+	 * @v cc		Congestion control state
+	 * @v len		Length of newly acknowledged data
+	 * @v rtt		Smoothed round-trip time (in ticks), or zero
+	 */
+	void ( * avoid ) ( struct tcp_congestion *cc, uint32_t len,
+			   unsigned long rtt );
+	/**
+	 * Respond to packet loss
+	 *
+	 * @v cc		Congestion control state
+	 * @v flight		Length of unacknowledged data
+	 * @v timeout		Loss was detected by retransmission timeout
+	 *
+	 * The algorithm must update the slow start threshold and
+	 * congestion window.
+	 */
+	void ( * loss ) ( struct tcp_congestion *cc, uint32_t flight,
+			  int timeout );
+	/**
+	 * Calculate pacing rate
+	 *
+	 * @v cc		Congestion control state
+	 * @v rtt		Smoothed round-trip time (in ticks), or zero
+	 * @ret rate		Pacing rate (in bytes per tick), or zero
+	 */
+	size_t ( * pace ) ( struct tcp_congestion *cc, unsigned long rtt );
+};
+
+/** TCP congestion control algorithm table */
+#define TCP_CONGESTION_ALGORITHMS \
+	__table ( struct tcp_congestion_algorithm, "tcp_congestion_algorithms" )
+
+/** Declare a TCP congestion control algorithm */
+#define __tcp_congestion_algorithm \
+	__table_entry ( TCP_CONGESTION_ALGORITHMS, 01 )
+
+/** TCP congestion control segment size
+ *
+ * Congestion windows are maintained in bytes, but are increased in
+ * units of this segment size.
+ */
+#define TCP_CONGESTION_MSS TCP_PATH_MTU
+
+/** Maximum TCP pacing burst (in segments) */
+#define TCP_PACING_BURST 4
+
+/** Initial TCP congestion window
+ *
+ * This value is taken from RFC 6928.
+ */
+#define TCP_INITIAL_CWND ( 10 * TCP_CONGESTION_MSS )
+
+/** A TCP listener */
+struct tcp_listener {
+	/** List of TCP listeners */
+	struct list_head list;
+	/** Local port */
+	unsigned int port;
+	/** Accept incoming connection
+	 *
+	 * @v listener		TCP listener
+	 * @v xfer		Data transfer interface for new connection
+	 * @v peer		Peer socket address
+	 * @ret rc		Return status code
+	 *
+	 * The listener must plug the new connection's data transfer
+	 * interface into its own interface before returning success.
+	 */
+	int ( * accept ) ( struct tcp_listener *listener,
+			   struct interface *xfer,
+			   struct sockaddr_tcpip *peer );
+};
+
+extern int tcp_listen ( struct tcp_listener *listener );
+extern void tcp_unlisten ( struct tcp_listener *listener );
+
+extern int tcp_info ( unsigned int index, struct tcp_info *info );
+extern void tcp_slow_start ( struct tcp_congestion *cc, uint32_t len );
+extern size_t tcp_pace ( struct tcp_congestion *cc, unsigned long rtt );
+
 extern struct tcpip_protocol tcp_protocol __tcpip_protocol;
 
 extern struct tcp_statistics tcp_stats;
@@ -120,6 +120,21 @@ struct tcpip_protocol {
         int ( * rx ) ( struct io_buffer *iobuf, struct net_device *netdev,
 		       struct sockaddr_tcpip *st_src,
 		       struct sockaddr_tcpip *st_dest, uint16_t pshdr_csum );
+	/**
+	 * Merge received packet (optional)
+	 *
+	 * @v iobuf		I/O buffer
+	 * @v next		Subsequent I/O buffer
+	 * @ret rc		Return status code, or required tailroom
+	 *
+	 * Both I/O buffers must have verified checksums.  On
+	 * success, the payload of the subsequent I/O buffer will have
+	 * been appended to the first I/O buffer.  On failure, neither
+	 * I/O buffer will have been modified.  If the packets could be
+	 * merged given sufficient tailroom in the first I/O buffer,
+	 * this method should return the required tailroom.
+	 */
+	int ( * merge ) ( struct io_buffer *iobuf, struct io_buffer *next );
 	/** Preferred zero checksum value
 	 *
 	 * The checksum is a one's complement value: zero may be
@@ -200,7 +215,14 @@ extern int tcpip_tx ( struct io_buffer *iobuf, struct tcpip_protocol *tcpip,
 extern struct tcpip_net_protocol * tcpip_net_protocol ( sa_family_t sa_family );
 extern struct net_device * tcpip_netdev ( struct sockaddr_tcpip *st_dest );
 extern size_t tcpip_mtu ( struct sockaddr_tcpip *st_dest );
+extern int tcpip_merge ( struct io_buffer *iobuf, struct io_buffer *next,
+			 uint8_t tcpip_proto );
 extern uint16_t tcpip_chksum ( const void *data, size_t len );
+extern void tcpip_defer_chksum ( struct io_buffer *iobuf, size_t hdr_len,
+				 uint16_t *csum );
+extern int tcpip_tx_chksum ( struct io_buffer *iobuf,
+			     struct net_device *netdev, void *net_hdr,
+			     uint16_t *trans_csum );
 extern int tcpip_bind ( struct sockaddr_tcpip *st_local,
 			int ( * available ) ( int port ) );
 
@@ -0,0 +1,116 @@
+#ifndef _IPXE_TCPREASM_H
+#define _IPXE_TCPREASM_H
+
+/** @file
+ *
+ * TCP reassembly queue
+ *
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+FILE_SECBOOT ( PERMITTED );
+
+#include <stdint.h>
+#include <ipxe/list.h>
+#include <ipxe/iobuf.h>
+#include <ipxe/tcp.h>
+
+/** TCP internal header
+ *
+ * This is the header that replaces the TCP header for packets
+ * enqueued on the reassembly queue.
+ */
+struct tcp_rx_queued_header {
+	/** SEQ value, in host-endian order
+	 *
+	 * This represents the SEQ value at the time the packet is
+	 * enqueued, and so excludes the SYN, if present.
+	 */
+	uint32_t seq;
+	/** Next SEQ value, in host-endian order */
+	uint32_t nxt;
+	/** Flags
+	 *
+	 * Only FIN is valid within this flags byte; all other flags
+	 * have already been processed by the time the packet is
+	 * enqueued.
+	 */
+	uint8_t flags;
+	/** Reserved */
+	uint8_t reserved[3];
+};
+
+/** Maximum number of distinct ranges in a TCP reassembly queue
+ *
+ * Each range is a contiguous run of queued packets, separated from
+ * its neighbours by a gap in the sequence space.  If a packet would
+ * require more ranges than this, then the highest range is
+ * discarded (or the packet itself, if it would form the highest
+ * range).  The sender will retransmit any discarded data.
+ */
+#define TCP_REASM_RANGES 16
+
+/** A TCP reassembly range */
+struct tcp_reasm_range {
+	/** Starting SEQ value (in host-endian order) */
+	uint32_t start;
+	/** Ending SEQ value (in host-endian order) */
+	uint32_t end;
+	/** First packet in range */
+	struct io_buffer *first;
+	/** Last packet in range */
+	struct io_buffer *last;
+};
+
+/** A TCP reassembly queue
+ *
+ * Packets are held in a single list in order of sequence number,
+ * with no overlapping data.  The list is indexed by an ordered array
+ * of ranges, so that inserting a packet requires a search only
+ * through the (small) number of gaps rather than through every
+ * queued packet.
+ */
+struct tcp_reasm {
+	/** List of queued packets */
+	struct list_head list;
+	/** Ranges (in order of sequence number) */
+	struct tcp_reasm_range range[TCP_REASM_RANGES];
+	/** Number of ranges */
+	unsigned int count;
+};
+
+/**
+ * Initialise TCP reassembly queue
+ *
+ * @v reasm		Reassembly queue
+ */
+static inline __attribute__ (( always_inline )) void
+tcp_reasm_init ( struct tcp_reasm *reasm ) {
+
+	INIT_LIST_HEAD ( &reasm->list );
+	reasm->count = 0;
+}
+
+/**
+ * Check if TCP reassembly queue is empty
+ *
+ * @v reasm		Reassembly queue
+ * @ret is_empty	Reassembly queue is empty
+ */
+static inline __attribute__ (( always_inline )) int
+tcp_reasm_empty ( struct tcp_reasm *reasm ) {
+
+	return ( reasm->count == 0 );
+}
+
+extern void tcp_reasm_add ( struct tcp_reasm *reasm, uint32_t base,
+			    uint32_t seq, unsigned int flags,
+			    struct io_buffer *iobuf );
+extern struct io_buffer * tcp_reasm_dequeue ( struct tcp_reasm *reasm,
+					      uint32_t base );
+extern int tcp_reasm_discard ( struct tcp_reasm *reasm );
+extern void tcp_reasm_flush ( struct tcp_reasm *reasm );
+extern uint32_t tcp_reasm_sack ( struct tcp_reasm *reasm, uint32_t seq,
+				 struct tcp_sack_block *sack );
+
+#endif /* _IPXE_TCPREASM_H */
@@ -14,7 +14,8 @@ FILE_SECBOOT ( PERMITTED );
 
 #define TFTP_PORT	       69 /**< Default TFTP server port */
 #define	TFTP_DEFAULT_BLKSIZE  512 /**< Default TFTP data block size */
-#define	TFTP_MAX_BLKSIZE     1432
+#define	TFTP_MAX_BLKSIZE    65464 /**< Maximum TFTP data block size */
+#define	TFTP_STD_BLKSIZE     1432 /**< Standard Ethernet data block size */
 
 #define TFTP_RRQ		1 /**< Read request opcode */
 #define TFTP_WRQ		2 /**< Write request opcode */
@@ -20,8 +20,11 @@ FILE_SECBOOT ( PERMITTED );
 #include <ipxe/x509.h>
 #include <ipxe/privkey.h>
 #include <ipxe/pending.h>
+#include <ipxe/retry.h>
 #include <ipxe/iobuf.h>
 #include <ipxe/tables.h>
+#include <ipxe/alpn.h>
+#include <config/crypto.h>
 
 struct tls_connection;
 
@@ -47,8 +50,19 @@ struct tls_header {
 /** TLS version 1.2 */
 #define TLS_VERSION_TLS_1_2 0x0303
 
+/** TLS version 1.3 */
+#define TLS_VERSION_TLS_1_3 0x0304
+
 /** Maximum supported TLS version */
-#define TLS_VERSION_MAX TLS_VERSION_TLS_1_2
+#define TLS_VERSION_MAX TLS_VERSION_TLS_1_3
+
+/** Maximum legacy TLS version
+ *
+ * TLSv1.3 and later are negotiated via the supported versions
+ * extension, and use a fixed legacy version of TLSv1.2 within the
+ * ClientHello and within record headers.
+ */
+#define TLS_VERSION_LEGACY_MAX TLS_VERSION_TLS_1_2
 
 /** Change cipher content type */
 #define TLS_TYPE_CHANGE_CIPHER 20
@@ -70,6 +84,7 @@ struct tls_header {
 #define TLS_CLIENT_HELLO 1
 #define TLS_SERVER_HELLO 2
 #define TLS_NEW_SESSION_TICKET 4
+#define TLS_ENCRYPTED_EXTENSIONS 8
 #define TLS_CERTIFICATE 11
 #define TLS_SERVER_KEY_EXCHANGE 12
 #define TLS_CERTIFICATE_REQUEST 13
@@ -77,6 +92,13 @@ struct tls_header {
 #define TLS_CERTIFICATE_VERIFY 15
 #define TLS_CLIENT_KEY_EXCHANGE 16
 #define TLS_FINISHED 20
+#define TLS_CERTIFICATE_STATUS 22
+#define TLS_KEY_UPDATE 24
+#define TLS_MESSAGE_HASH 254
+
+/* TLS key update request values */
+#define TLS_KEY_UPDATE_NOT_REQUESTED 0
+#define TLS_KEY_UPDATE_REQUESTED 1
 
 /* TLS alert levels */
 #define TLS_ALERT_WARNING 1
@@ -112,6 +134,11 @@ struct tls_header {
 #define TLS_ECDHE_ECDSA_WITH_AES_256_GCM_SHA384 0xc02c
 #define TLS_ECDHE_RSA_WITH_AES_128_GCM_SHA256 0xc02f
 #define TLS_ECDHE_RSA_WITH_AES_256_GCM_SHA384 0xc030
+#define TLS_ECDHE_RSA_WITH_CHACHA20_POLY1305_SHA256 0xcca8
+#define TLS_ECDHE_ECDSA_WITH_CHACHA20_POLY1305_SHA256 0xcca9
+#define TLS_AES_128_GCM_SHA256 0x1301
+#define TLS_AES_256_GCM_SHA384 0x1302
+#define TLS_CHACHA20_POLY1305_SHA256 0x1303
 
 /* TLS hash algorithm identifiers */
 #define TLS_MD5_ALGORITHM 1
@@ -120,10 +147,14 @@ struct tls_header {
 #define TLS_SHA256_ALGORITHM 4
 #define TLS_SHA384_ALGORITHM 5
 #define TLS_SHA512_ALGORITHM 6
+#define TLS_INTRINSIC_ALGORITHM 8
 
 /* TLS signature algorithm identifiers */
 #define TLS_RSA_ALGORITHM 1
 #define TLS_ECDSA_ALGORITHM 3
+#define TLS_RSA_PSS_RSAE_SHA256_ALGORITHM 4
+#define TLS_RSA_PSS_RSAE_SHA384_ALGORITHM 5
+#define TLS_RSA_PSS_RSAE_SHA512_ALGORITHM 6
 
 /* TLS server name extension */
 #define TLS_SERVER_NAME 0
@@ -136,6 +167,10 @@ struct tls_header {
 #define TLS_MAX_FRAGMENT_LENGTH_2048 3
 #define TLS_MAX_FRAGMENT_LENGTH_4096 4
 
+/* TLS certificate status request extension */
+#define TLS_STATUS_REQUEST 5
+#define TLS_STATUS_REQUEST_OCSP 1
+
 /* TLS named curve extension */
 #define TLS_NAMED_CURVE 10
 #define TLS_NAMED_CURVE_SECP256R1 23
@@ -145,12 +180,24 @@ struct tls_header {
 /* TLS signature algorithms extension */
 #define TLS_SIGNATURE_ALGORITHMS 13
 
+/* TLS application-layer protocol negotiation extension */
+#define TLS_ALPN 16
+
 /* TLS extended master secret extension */
 #define TLS_EXTENDED_MASTER_SECRET 23
 
 /* TLS session ticket extension */
 #define TLS_SESSION_TICKET 35
 
+/* TLS supported versions extension */
+#define TLS_SUPPORTED_VERSIONS 43
+
+/* TLS cookie extension */
+#define TLS_COOKIE 44
+
+/* TLS key share extension */
+#define TLS_KEY_SHARE 51
+
 /* TLS renegotiation information extension */
 #define TLS_RENEGOTIATION_INFO 0xff01
 
@@ -184,6 +231,7 @@ enum tls_tx_pending {
 	TLS_TX_CERTIFICATE_VERIFY = 0x0008,
 	TLS_TX_CHANGE_CIPHER = 0x0010,
 	TLS_TX_FINISHED = 0x0020,
+	TLS_TX_KEY_UPDATE = 0x0040,
 };
 
 /** A TLS key exchange algorithm */
@@ -231,6 +279,17 @@ struct tls_cipher_suite {
 #define __tls_cipher_suite( pref )					\
 	__table_entry ( TLS_CIPHER_SUITES, pref )
 
+/** Preference for ChaCha20-Poly1305 cipher suites
+ *
+ * ChaCha20-Poly1305 is significantly faster than AES-GCM in software,
+ * and so is preferred unless AES hardware acceleration is available.
+ */
+#ifdef CRYPTO_ACCEL_AESNI
+#define TLS_CHACHA20_POLY1305_PREF 04
+#else
+#define TLS_CHACHA20_POLY1305_PREF 01
+#endif
+
 /** TLS named curved type */
 #define TLS_NAMED_CURVE_TYPE 3
 
@@ -293,6 +352,8 @@ struct tls_signature_hash_algorithm {
 	struct digest_algorithm *digest;
 	/** Public-key algorithm */
 	struct pubkey_algorithm *pubkey;
+	/** Certificate public-key algorithm (if different) */
+	struct pubkey_algorithm *key;
 	/** Numeric code */
 	struct tls_signature_hash_id code;
 };
@@ -338,6 +399,13 @@ struct md5_sha1_digest {
 /** MD5+SHA1 digest size */
 #define MD5_SHA1_DIGEST_SIZE sizeof ( struct md5_sha1_digest )
 
+/** Maximum TLSv1.3 secret length
+ *
+ * TLSv1.3 secrets have the length of the handshake digest, which is
+ * at most SHA-384.
+ */
+#define TLS_SECRET_MAX_LEN 48
+
 /** A TLS session */
 struct tls_session {
 	/** Reference counter */
@@ -364,9 +432,13 @@ struct tls_session {
 	uint8_t master_secret[48];
 	/** Extended master secret flag */
 	int extended_master_secret;
+	/** At least one handshake has completed */
+	int established;
 
 	/** List of connections */
 	struct list_head conn;
+	/** Expiry timer (while no connections remain) */
+	struct retry_timer timer;
 };
 
 /** TLS transmit state */
@@ -375,8 +447,14 @@ struct tls_tx {
 	struct tls_cipherspec_pair cipherspec;
 	/** Sequence number */
 	uint64_t seq;
+	/** Traffic secret (TLSv1.3 only) */
+	uint8_t secret[TLS_SECRET_MAX_LEN];
+	/** Next traffic secret (TLSv1.3 only) */
+	uint8_t pending_secret[TLS_SECRET_MAX_LEN];
 	/** Pending transmissions */
 	unsigned int pending;
+	/** Coalesced application data (if any) */
+	struct io_buffer *coalesce;
 	/** Transmit process */
 	struct process process;
 };
@@ -387,6 +465,8 @@ struct tls_rx {
 	struct tls_cipherspec_pair cipherspec;
 	/** Sequence number */
 	uint64_t seq;
+	/** Traffic secret (TLSv1.3 only) */
+	uint8_t secret[TLS_SECRET_MAX_LEN];
 	/** State machine current state */
 	enum tls_rx_state state;
 	/** Current received record header */
@@ -395,6 +475,14 @@ struct tls_rx {
 	struct io_buffer iobuf;
 	/** List of received data buffers */
 	struct list_head data;
+	/** Length of record data not yet assigned to a data buffer */
+	size_t remaining;
+	/** Data buffer currently being filled, if any */
+	struct io_buffer *fill;
+	/** Length of record data carried over beyond the tail of the
+	 * final data buffer
+	 */
+	size_t carry;
 	/** Received handshake fragment */
 	struct io_buffer *handshake;
 };
@@ -407,6 +495,18 @@ struct tls_client {
 	struct private_key *key;
 	/** Certificate chain (if used) */
 	struct x509_chain *chain;
+	/** Key share named curve */
+	struct tls_named_curve *curve;
+	/** Key share private key */
+	void *private;
+	/** Key share public key */
+	void *public;
+	/** Length of key share public key */
+	size_t public_len;
+	/** HelloRetryRequest cookie (TLSv1.3 only) */
+	void *cookie;
+	/** Length of HelloRetryRequest cookie */
+	size_t cookie_len;
 	/** Security negotiation pending operation */
 	struct pending_operation negotiation;
 };
@@ -425,6 +525,10 @@ struct tls_server {
 	struct x509_chain *chain;
 	/** Public key (within server certificate) */
 	struct asn1_cursor key;
+	/** Stapled OCSP response (if any) */
+	void *ocsp;
+	/** Length of stapled OCSP response */
+	size_t ocsp_len;
 	/** Certificate validator */
 	struct interface validator;
 	/** Certificate validation pending operation */
@@ -446,6 +550,10 @@ struct tls_connection {
 	uint8_t session_id[32];
 	/** Length of session ID */
 	size_t session_id_len;
+	/** Session ticket */
+	void *session_ticket;
+	/** Length of session ticket */
+	size_t session_ticket_len;
 	/** New session ticket */
 	void *new_session_ticket;
 	/** Length of new session ticket */
@@ -458,7 +566,12 @@ struct tls_connection {
 
 	/** Protocol version */
 	uint16_t version;
-	/** Master secret */
+	/** Master secret
+	 *
+	 * For TLSv1.3, this holds the current secret within the key
+	 * schedule (i.e. the handshake secret, and subsequently the
+	 * master secret).
+	 */
 	uint8_t master_secret[48];
 	/** Digest algorithm used for handshake verification */
 	struct digest_algorithm *handshake_digest;
@@ -468,6 +581,14 @@ struct tls_connection {
 	int secure_renegotiation;
 	/** Extended master secret flag */
 	int extended_master_secret;
+	/** HelloRetryRequest received flag (TLSv1.3 only) */
+	int hello_retry;
+	/** False Start permitted flag (TLSv1.2 only) */
+	int false_start;
+	/** Offered application protocols (in wire format), or NULL */
+	const char *alpn_offer;
+	/** Negotiated application protocol (empty if none) */
+	char alpn[ ALPN_MAX_LEN + 1 ];
 	/** Verification data */
 	struct tls_verify_data verify;
 
@@ -516,6 +637,7 @@ struct tls_connection {
 extern struct tls_key_exchange_algorithm tls_pubkey_exchange_algorithm;
 extern struct tls_key_exchange_algorithm tls_dhe_exchange_algorithm;
 extern struct tls_key_exchange_algorithm tls_ecdhe_exchange_algorithm;
+extern struct tls_key_exchange_algorithm tls_key_share_exchange_algorithm;
 
 extern int add_tls ( struct interface *xfer, const char *name,
 		     struct x509_root *root, struct private_key *key );
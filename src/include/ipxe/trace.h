@@ -0,0 +1,38 @@
+#ifndef _IPXE_TRACE_H
+#define _IPXE_TRACE_H
+
+/** @file
+ *
+ * Boot-time event tracing
+ *
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+FILE_SECBOOT ( PERMITTED );
+
+/** A trace event */
+struct trace_event {
+	/** Profiling timestamp (e.g. TSC value) */
+	unsigned long timestamp;
+	/** Timer ticks */
+	unsigned long ticks;
+	/** Subsystem name */
+	const char *subsystem;
+	/** Event name */
+	const char *name;
+	/** Associated object (used to correlate events) */
+	const void *object;
+	/** Event-specific value (e.g. a return status code) */
+	long value;
+};
+
+/** Number of trace events retained (must be a power of two) */
+#define TRACE_EVENTS 128
+
+extern unsigned int trace_count;
+
+extern void trace ( const char *subsystem, const char *name,
+		    const void *object, long value );
+extern struct trace_event * trace_event ( unsigned int index );
+
+#endif /* _IPXE_TRACE_H */
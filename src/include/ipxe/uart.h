@@ -41,6 +41,16 @@ struct uart_operations {
 	 * @ret rc		Return status code
 	 */
 	void ( * transmit ) ( struct uart *uart, uint8_t byte );
+	/**
+	 * Check if transmitter is ready
+	 *
+	 * @v uart		UART
+	 * @ret ready		Transmitter is ready
+	 *
+	 * This should return true if a subsequent call to transmit()
+	 * will not block.
+	 */
+	int ( * transmit_ready ) ( struct uart *uart );
 	/**
 	 * Check if data is ready
 	 *
@@ -83,6 +93,18 @@ uart_transmit ( struct uart *uart, uint8_t byte ) {
 	uart->op->transmit ( uart, byte );
 }
 
+/**
+ * Check if transmitter is ready
+ *
+ * @v uart		UART
+ * @ret ready		Transmitter is ready
+ */
+static inline __attribute__ (( always_inline )) int
+uart_transmit_ready ( struct uart *uart ) {
+
+	return uart->op->transmit_ready ( uart );
+}
+
 /**
  * Check if data is ready
  *
@@ -38,6 +38,10 @@ struct udp_header {
 	uint16_t chksum;
 };
 
+/** Maximum length of headers preceding a UDP payload */
+#define UDP_MAX_HLEN \
+	( MAX_LL_NET_HEADER_LEN + sizeof ( struct udp_header ) )
+
 extern int udp_open_promisc ( struct interface *xfer );
 extern int udp_open ( struct interface *xfer, struct sockaddr *peer,
 		      struct sockaddr *local );
@@ -20,4 +20,7 @@ extern physaddr_t uheap_limit;
 extern physaddr_t uheap_start;
 extern physaddr_t uheap_end;
 
+extern int uheap_reserve ( physaddr_t start, size_t len );
+extern void uheap_release ( void );
+
 #endif /* _IPXE_UHEAP_H */
@@ -226,6 +226,8 @@ extern struct uri * resolve_uri ( const struct uri *base_uri,
 				  struct uri *relative_uri );
 extern struct uri * pxe_uri ( struct sockaddr *sa_server,
 			      const char *filename );
+extern struct uri * pxe_tftp_uri ( struct sockaddr *sa_server,
+				   const char *filename );
 extern void churi ( struct uri *uri );
 
 #endif /* _IPXE_URI_H */
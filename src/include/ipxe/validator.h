@@ -11,9 +11,11 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 FILE_SECBOOT ( PERMITTED );
 
 #include <ipxe/interface.h>
+#include <ipxe/asn1.h>
 #include <ipxe/x509.h>
 
 extern int create_validator ( struct interface *job, struct x509_chain *chain,
-			      struct x509_root *root );
+			      struct x509_root *root,
+			      const struct asn1_cursor *stapled );
 
 #endif /* _IPXE_VALIDATOR_H */
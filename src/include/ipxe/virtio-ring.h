@@ -22,6 +22,8 @@
 /* v1.0 compliant. */
 #define VIRTIO_F_VERSION_1              32
 #define VIRTIO_F_IOMMU_PLATFORM         33
+/* Packed virtqueue layout (virtio 1.1) */
+#define VIRTIO_F_RING_PACKED            34
 
 #define MAX_QUEUE_NUM      (256)
 
@@ -32,6 +34,14 @@
 
 #define VRING_USED_F_NO_NOTIFY     1
 
+/* Packed virtqueue descriptor flags */
+#define VRING_PACKED_DESC_F_AVAIL  (1 << 7)
+#define VRING_PACKED_DESC_F_USED   (1 << 15)
+
+/* Packed virtqueue event suppression flags */
+#define VRING_PACKED_EVENT_FLAG_ENABLE  0x0
+#define VRING_PACKED_EVENT_FLAG_DISABLE 0x1
+
 struct vring_desc
 {
    u64 addr;
@@ -73,6 +83,33 @@ struct vring {
          + PAGE_MASK) & ~PAGE_MASK) + \
          (sizeof(struct vring_used) + sizeof(struct vring_used_elem) * num))
 
+struct vring_packed_desc
+{
+   u64 addr;
+   u32 len;
+   u16 id;
+   u16 flags;
+};
+
+struct vring_packed_desc_event
+{
+   u16 off_wrap;
+   u16 flags;
+};
+
+struct vring_packed {
+   unsigned int num;
+   struct vring_packed_desc *desc;
+   /* Driver event suppression (driver area) */
+   struct vring_packed_desc_event *driver;
+   /* Device event suppression (device area) */
+   struct vring_packed_desc_event *device;
+};
+
+#define vring_packed_size(num) \
+   ((sizeof(struct vring_packed_desc) * num) + \
+    (2 * sizeof(struct vring_packed_desc_event)))
+
 struct vring_virtqueue {
    unsigned char *queue;
    size_t queue_size;
@@ -83,6 +120,15 @@ struct vring_virtqueue {
    u16 last_used_idx;
    void **vdata;
    struct virtio_net_hdr_modern *empty_header;
+   /* Packed virtqueue (free_head and last_used_idx are ring positions) */
+   int packed;
+   struct vring_packed vring_packed;
+   u16 avail_flags;     /* AVAIL/USED flags for current driver wrap */
+   u16 used_wrap;       /* Expected device wrap counter */
+   u16 num_free;        /* Number of free descriptors */
+   u16 free_id;         /* First free buffer ID */
+   u16 *id_next;        /* Next free buffer ID, indexed by buffer ID */
+   u16 *id_num;         /* Number of descriptors, indexed by buffer ID */
    /* PCI */
    int queue_index;
    struct virtio_pci_region notification;
@@ -120,13 +166,45 @@ static inline void vring_init(struct vring *vr,
    vr->desc[i].next = 0;
 }
 
+static inline void vring_packed_init(struct vring_virtqueue *vq,
+                                     unsigned int num, unsigned char *queue)
+{
+   struct vring_packed *vr = &vq->vring_packed;
+   unsigned int i;
+
+   vr->num = num;
+   vr->desc = (struct vring_packed_desc *)queue;
+   vr->driver = (struct vring_packed_desc_event *)&vr->desc[num];
+   vr->device = &vr->driver[1];
+
+   /* Descriptors are initially zeroed, i.e. neither available nor used */
+   vq->vring.num = num;
+   vq->free_head = 0;
+   vq->last_used_idx = 0;
+   vq->avail_flags = VRING_PACKED_DESC_F_AVAIL;
+   vq->used_wrap = 1;
+   vq->num_free = num;
+
+   vq->free_id = 0;
+   for (i = 0; i < num; i++)
+           vq->id_next[i] = i + 1;
+}
+
 static inline void vring_enable_cb(struct vring_virtqueue *vq)
 {
+   if (vq->packed) {
+           vq->vring_packed.driver->flags = VRING_PACKED_EVENT_FLAG_ENABLE;
+           return;
+   }
    vq->vring.avail->flags &= ~VRING_AVAIL_F_NO_INTERRUPT;
 }
 
 static inline void vring_disable_cb(struct vring_virtqueue *vq)
 {
+   if (vq->packed) {
+           vq->vring_packed.driver->flags = VRING_PACKED_EVENT_FLAG_DISABLE;
+           return;
+   }
    vq->vring.avail->flags |= VRING_AVAIL_F_NO_INTERRUPT;
 }
 
@@ -140,7 +218,19 @@ static inline void vring_disable_cb(struct vring_virtqueue *vq)
 
 static inline int vring_more_used(struct vring_virtqueue *vq)
 {
+   u16 flags;
+   int avail, used;
+
    wmb();
+   if (vq->packed) {
+           /* A used descriptor has both AVAIL and USED flags
+            * matching the device wrap counter.
+            */
+           flags = vq->vring_packed.desc[vq->last_used_idx].flags;
+           avail = !!(flags & VRING_PACKED_DESC_F_AVAIL);
+           used = !!(flags & VRING_PACKED_DESC_F_USED);
+           return (avail == used) && (used == vq->used_wrap);
+   }
    return vq->last_used_idx != vq->vring.used->idx;
 }
 
@@ -84,6 +84,7 @@ enum vmbus_message_type {
 	VMBUS_OPEN_CHANNEL_RESULT = 6,
 	VMBUS_CLOSE_CHANNEL = 7,
 	VMBUS_GPADL_HEADER = 8,
+	VMBUS_GPADL_BODY = 9,
 	VMBUS_GPADL_CREATED = 10,
 	VMBUS_GPADL_TEARDOWN = 11,
 	VMBUS_GPADL_TORNDOWN = 12,
@@ -177,6 +178,29 @@ struct vmbus_gpadl_header {
 	struct vmbus_gpa_range range[0];
 } __attribute__ (( packed ));
 
+/** Maximum number of page frame numbers in a "GPADL header" message */
+#define VMBUS_GPADL_HEADER_MAX_PFNS					\
+	( ( sizeof ( ( ( struct hv_post_message * ) NULL )->data ) -	\
+	    sizeof ( struct vmbus_gpadl_header ) -			\
+	    sizeof ( struct vmbus_gpa_range ) ) / sizeof ( uint64_t ) )
+
+/** VMBus "GPADL body" message */
+struct vmbus_gpadl_body {
+	/** Message header */
+	struct vmbus_message_header header;
+	/** Message number */
+	uint32_t msgnum;
+	/** GPADL ID */
+	uint32_t gpadl;
+	/** Page frame numbers */
+	uint64_t pfn[0];
+} __attribute__ (( packed ));
+
+/** Maximum number of page frame numbers in a "GPADL body" message */
+#define VMBUS_GPADL_BODY_MAX_PFNS					\
+	( ( sizeof ( ( ( struct hv_post_message * ) NULL )->data ) -	\
+	    sizeof ( struct vmbus_gpadl_body ) ) / sizeof ( uint64_t ) )
+
 /** VMBus "GPADL created" message */
 struct vmbus_gpadl_created {
 	/** Message header */
@@ -249,6 +273,8 @@ union vmbus_message {
 	struct vmbus_close_channel close;
 	/** "GPADL header" message */
 	struct vmbus_gpadl_header gpadlhdr;
+	/** "GPADL body" message */
+	struct vmbus_gpadl_body gpadlbody;
 	/** "GPADL created" message */
 	struct vmbus_gpadl_created created;
 	/** "GPADL teardown" message */
@@ -67,6 +67,12 @@ FILE_SECBOOT ( PERMITTED );
 		bigint_t ( size * 3 ) all;				\
 	}
 
+/** Window width (in bits) for scalar multiplication */
+#define WEIERSTRASS_WINDOW 4
+
+/** Number of precomputed multiples for scalar multiplication */
+#define WEIERSTRASS_NUM_WINDOW ( 1 << WEIERSTRASS_WINDOW )
+
 /** Indexes for stored multiples of the field prime */
 enum weierstrass_multiple {
 	WEIERSTRASS_N = 0,
@@ -104,6 +110,19 @@ struct weierstrass_curve {
 	const uint8_t *b_raw;
 	/** Base point */
 	const uint8_t *base;
+	/** Field prime in Solinas form (if applicable)
+	 *
+	 * A generalised Mersenne prime may be expressed as a sum of
+	 * signed powers of 2^32, which allows for Montgomery
+	 * reduction without any multiplications.  Each term is
+	 * encoded as (k+1) to represent +2^(32k), or as -(k+1) to
+	 * represent -2^(32k).  The list is terminated by a zero.
+	 *
+	 * The least significant term must be -1 (representing -2^0),
+	 * and no other term may be -1 or +1.  The field prime is
+	 * therefore congruent to -1 modulo 2^32.
+	 */
+	const int8_t *solinas;
 
 	/** Cached field prime "N" (and multiples thereof) */
 	bigint_element_t *prime[WEIERSTRASS_NUM_CACHED];
@@ -123,6 +142,8 @@ struct weierstrass_curve {
 		};
 		bigint_element_t *mont[WEIERSTRASS_NUM_MONT];
 	};
+	/** Cached multiples of the base point (for scalar multiplication) */
+	bigint_element_t *table;
 };
 
 extern int weierstrass_is_infinity ( struct weierstrass_curve *curve,
@@ -133,12 +154,17 @@ extern int weierstrass_multiply ( struct weierstrass_curve *curve,
 extern int weierstrass_add_once ( struct weierstrass_curve *curve,
 				  const void *addend, const void *augend,
 				  void *result );
+extern int weierstrass_multiply_add ( struct weierstrass_curve *curve,
+				      const void *scalar1, const void *point,
+				      const void *scalar2, void *result );
 
 /** Define a Weierstrass curve */
 #define WEIERSTRASS_CURVE( _name, _curve, _len, _prime, _a, _b, _base,	\
-			   _order )					\
+			   _order, _solinas )				\
 	static bigint_t ( weierstrass_size(_len) )			\
 		_name ## _cache[WEIERSTRASS_NUM_CACHED];		\
+	static bigint_t ( weierstrass_size(_len) * 3 )			\
+		_name ## _table[WEIERSTRASS_NUM_WINDOW];		\
 	static struct weierstrass_curve _name ## _weierstrass = {	\
 		.size = weierstrass_size(_len),				\
 		.name = #_name,						\
@@ -147,6 +173,7 @@ extern int weierstrass_add_once ( struct weierstrass_curve *curve,
 		.a_raw = (_a),						\
 		.b_raw = (_b),						\
 		.base = (_base),					\
+		.solinas = (_solinas),					\
 		.prime = {						\
 			(_name ## _cache)[0].element,			\
 			(_name ## _cache)[1].element,			\
@@ -157,6 +184,7 @@ extern int weierstrass_add_once ( struct weierstrass_curve *curve,
 		.one = (_name ## _cache)[5].element,			\
 		.a = (_name ## _cache)[6].element,			\
 		.b3 = (_name ## _cache)[7].element,			\
+		.table = (_name ## _table)[0].element,			\
 	};								\
 	static int _name ## _is_infinity ( const void *point) {		\
 		return weierstrass_is_infinity ( &_name ## _weierstrass,\
@@ -173,6 +201,14 @@ extern int weierstrass_add_once ( struct weierstrass_curve *curve,
 		return weierstrass_add_once ( &_name ## _weierstrass,	\
 					      addend, augend, result );	\
 	}								\
+	static int _name ## _multiply_add ( const void *scalar1,	\
+					    const void *point,		\
+					    const void *scalar2,	\
+					    void *result ) {		\
+		return weierstrass_multiply_add ( &_name ## _weierstrass,\
+						  scalar1, point,	\
+						  scalar2, result );	\
+	}								\
 	struct elliptic_curve _curve = {				\
 		.name = #_name,						\
 		.pointsize = ( WEIERSTRASS_AXES * (_len) ),		\
@@ -182,6 +218,7 @@ extern int weierstrass_add_once ( struct weierstrass_curve *curve,
 		.is_infinity = _name ## _is_infinity,			\
 		.multiply = _name ## _multiply,				\
 		.add = _name ## _add,					\
+		.multiply_add = _name ## _multiply_add,			\
 	}
 
 #endif /* _IPXE_WEIERSTRASS_H */
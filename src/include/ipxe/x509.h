@@ -60,6 +60,8 @@ struct x509_public_key {
 struct x509_subject {
 	/** Raw subject */
 	struct asn1_cursor raw;
+	/** Hash of raw subject (for fast comparisons) */
+	uint32_t hash;
 	/** Common name */
 	struct asn1_cursor common_name;
 	/** Public key information */
@@ -132,6 +134,8 @@ struct x509_ocsp_responder {
 	struct asn1_cursor uri;
 	/** OCSP status is good */
 	int good;
+	/** Time after which OCSP status must be rechecked */
+	time_t expiry;
 };
 
 /** X.509 certificate authority information access */
@@ -210,6 +214,11 @@ struct x509_chain {
 	 */
 	void ( * found ) ( struct x509_chain *store,
 			   struct x509_certificate *cert );
+	/** Populate certificate store (on first use)
+	 *
+	 * @v store		Certificate store
+	 */
+	void ( * populate ) ( struct x509_chain *store );
 };
 
 /** An X.509 certificate */
@@ -301,6 +310,18 @@ x509_chain_put ( struct x509_chain *chain ) {
 	ref_put ( &chain->refcnt );
 }
 
+/**
+ * Populate X.509 certificate store, if applicable
+ *
+ * @v store		Certificate store
+ */
+static inline __attribute__ (( always_inline )) void
+x509_populate ( struct x509_chain *store ) {
+
+	if ( store->populate )
+		store->populate ( store );
+}
+
 /**
  * Get first certificate in X.509 certificate chain
  *
@@ -21,6 +21,13 @@ struct xfer_buffer {
 	void *data;
 	/** Size of data */
 	size_t len;
+	/** Size of allocated buffer
+	 *
+	 * This may exceed the size of data, since the buffer is
+	 * grown geometrically in order to avoid repeated
+	 * reallocation when the final size is not known in advance.
+	 */
+	size_t capacity;
 	/** Maximum required size of data */
 	size_t max;
 	/** Current offset within data */
@@ -83,6 +90,7 @@ static inline __attribute__ (( always_inline )) void
 xferbuf_fixed_init ( struct xfer_buffer *xferbuf, void *data, size_t len ) {
 	xferbuf->data = data;
 	xferbuf->len = len;
+	xferbuf->capacity = len;
 	xferbuf->op = &xferbuf_fixed_operations;
 }
 
@@ -101,6 +109,9 @@ xferbuf_void_init ( struct xfer_buffer *xferbuf ) {
 
 extern void xferbuf_detach ( struct xfer_buffer *xferbuf );
 extern void xferbuf_free ( struct xfer_buffer *xferbuf );
+extern void xferbuf_trim ( struct xfer_buffer *xferbuf );
+extern int xferbuf_reserve ( struct xfer_buffer *xferbuf, size_t len );
+extern int xferbuf_ensure_size ( struct xfer_buffer *xferbuf, size_t len );
 extern int xferbuf_write ( struct xfer_buffer *xferbuf, size_t offset,
 			   const void *data, size_t len );
 extern int xferbuf_read ( struct xfer_buffer *xferbuf, size_t offset,
@@ -1119,6 +1119,8 @@ struct xhci_device {
 	union xhci_trb *pending;
 	/** Command mechanism has permanently failed */
 	int failed;
+	/** Endpoints with deferred doorbells */
+	struct list_head doorbells;
 
 	/** Device slots, indexed by slot ID */
 	struct xhci_slot **slot;
@@ -1176,6 +1178,8 @@ struct xhci_endpoint {
 	struct xhci_endpoint_context *context;
 	/** Transfer ring */
 	struct xhci_trb_ring ring;
+	/** List of endpoints with deferred doorbells */
+	struct list_head doorbell;
 };
 
 extern void xhci_init ( struct xhci_device *xhci );
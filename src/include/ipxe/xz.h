@@ -0,0 +1,97 @@
+#ifndef _IPXE_XZ_H
+#define _IPXE_XZ_H
+
+/** @file
+ *
+ * xz compressed images
+ *
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+FILE_SECBOOT ( PERMITTED );
+
+#include <stdint.h>
+#include <ipxe/image.h>
+
+/** xz stream header */
+struct xz_header {
+	/** Magic ID */
+	uint8_t magic[6];
+	/** Stream flags */
+	uint8_t flags[2];
+	/** CRC-32 of stream flags */
+	uint32_t crc;
+} __attribute__ (( packed ));
+
+/** xz stream header magic ID
+ *
+ * The magic ID includes the string's terminating NUL.
+ */
+#define XZ_HEADER_MAGIC "\xfd" "7zXZ"
+
+/** xz stream footer */
+struct xz_footer {
+	/** CRC-32 of backward size and stream flags */
+	uint32_t crc;
+	/** Backward size (i.e. index size), in units of 4 bytes minus one */
+	uint32_t backward;
+	/** Stream flags */
+	uint8_t flags[2];
+	/** Magic ID */
+	uint8_t magic[2];
+} __attribute__ (( packed ));
+
+/** xz stream footer magic ID */
+#define XZ_FOOTER_MAGIC "YZ"
+
+/** xz stream flags: check type */
+#define XZ_CHECK( flags ) ( (flags)[1] & 0x0f )
+
+/** xz stream flags: reserved bits */
+#define XZ_FLAGS_RESERVED( flags ) ( (flags)[0] | ( (flags)[1] & 0xf0 ) )
+
+/** xz check types */
+enum xz_check {
+	/** No check */
+	XZ_CHECK_NONE = 0x00,
+	/** CRC-32 */
+	XZ_CHECK_CRC32 = 0x01,
+	/** CRC-64 */
+	XZ_CHECK_CRC64 = 0x04,
+	/** SHA-256 */
+	XZ_CHECK_SHA256 = 0x0a,
+};
+
+/** xz CRC-64 polynomial (ECMA-182, bit-reversed) */
+#define XZ_CRC64_POLY 0xc96c5795d7870f42ULL
+
+/** xz block header flags: number of filters */
+#define XZ_BLOCK_FILTERS( flags ) ( ( (flags) & 0x03 ) + 1 )
+
+/** xz block header flags: reserved bits */
+#define XZ_BLOCK_RESERVED 0x3c
+
+/** xz block header flags: compressed size is present */
+#define XZ_BLOCK_COMPRESSED 0x40
+
+/** xz block header flags: uncompressed size is present */
+#define XZ_BLOCK_UNCOMPRESSED 0x80
+
+/** xz LZMA2 filter ID */
+#define XZ_FILTER_LZMA2 0x21
+
+/** Maximum xz LZMA2 dictionary size property value */
+#define XZ_LZMA2_DICT_MAX 40
+
+/** xz index indicator */
+#define XZ_INDEX_INDICATOR 0x00
+
+/** Maximum length of an xz variable-length integer */
+#define XZ_VLI_MAX_LEN 9
+
+/** xz field alignment */
+#define XZ_ALIGN 4
+
+extern struct image_type xz_image_type __image_type ( PROBE_NORMAL );
+
+#endif /* _IPXE_XZ_H */
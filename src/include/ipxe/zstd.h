@@ -0,0 +1,221 @@
+#ifndef _IPXE_ZSTD_H
+#define _IPXE_ZSTD_H
+
+/** @file
+ *
+ * Zstandard compressed images
+ *
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+FILE_SECBOOT ( PERMITTED );
+
+#include <stdint.h>
+#include <ipxe/image.h>
+
+/** Frame magic number */
+#define ZSTD_MAGIC 0xfd2fb528UL
+
+/** Skippable frame magic number */
+#define ZSTD_SKIPPABLE_MAGIC 0x184d2a50UL
+
+/** Skippable frame magic number mask */
+#define ZSTD_SKIPPABLE_MASK 0xfffffff0UL
+
+/** Frame header descriptor: frame content size field size flag */
+#define ZSTD_FHD_FCS( fhd ) ( (fhd) >> 6 )
+
+/** Frame header descriptor: single segment */
+#define ZSTD_FHD_SINGLE 0x20
+
+/** Frame header descriptor: reserved bit */
+#define ZSTD_FHD_RESERVED 0x08
+
+/** Frame header descriptor: content checksum is present */
+#define ZSTD_FHD_CHECKSUM 0x04
+
+/** Frame header descriptor: dictionary ID field size flag */
+#define ZSTD_FHD_DICT( fhd ) ( (fhd) & 0x03 )
+
+/** Length of a block header */
+#define ZSTD_BLOCK_HEADER_LEN 3
+
+/** Block header: last block */
+#define ZSTD_BLOCK_LAST 0x01
+
+/** Block header: block type */
+#define ZSTD_BLOCK_TYPE( header ) ( ( (header) >> 1 ) & 0x03 )
+
+/** Block header: block size */
+#define ZSTD_BLOCK_SIZE( header ) ( (header) >> 3 )
+
+/** Block types */
+enum zstd_block_type {
+	/** Raw block */
+	ZSTD_BLOCK_RAW = 0,
+	/** Run-length encoded block */
+	ZSTD_BLOCK_RLE = 1,
+	/** Compressed block */
+	ZSTD_BLOCK_COMPRESSED = 2,
+};
+
+/** Maximum block size */
+#define ZSTD_BLOCK_MAX ( 128 * 1024 )
+
+/** Literals section block types */
+enum zstd_literals_type {
+	/** Raw literals */
+	ZSTD_LITERALS_RAW = 0,
+	/** Run-length encoded literals */
+	ZSTD_LITERALS_RLE = 1,
+	/** Huffman compressed literals */
+	ZSTD_LITERALS_COMPRESSED = 2,
+	/** Huffman compressed literals using previous Huffman table */
+	ZSTD_LITERALS_TREELESS = 3,
+};
+
+/** Length of a literals jump table (for four streams) */
+#define ZSTD_JUMP_TABLE_LEN 6
+
+/** Maximum Huffman code length (in bits) */
+#define ZSTD_HUFFMAN_MAX_BITS 11
+
+/** Maximum number of Huffman weights */
+#define ZSTD_HUFFMAN_MAX_WEIGHTS 256
+
+/** Maximum accuracy log for Huffman weights */
+#define ZSTD_HUFFMAN_WEIGHT_LOG 6
+
+/** Minimum FSE accuracy log */
+#define ZSTD_FSE_MIN_LOG 5
+
+/** Maximum FSE accuracy log */
+#define ZSTD_FSE_MAX_LOG 9
+
+/** Maximum number of FSE symbols */
+#define ZSTD_FSE_MAX_SYMBOLS 53
+
+/** Sequence symbol compression modes */
+enum zstd_fse_mode {
+	/** Predefined distribution */
+	ZSTD_MODE_PREDEFINED = 0,
+	/** Run-length encoded single symbol */
+	ZSTD_MODE_RLE = 1,
+	/** FSE compressed distribution */
+	ZSTD_MODE_COMPRESSED = 2,
+	/** Repeat previous distribution */
+	ZSTD_MODE_REPEAT = 3,
+};
+
+/** Literals length code maximum value */
+#define ZSTD_LL_MAX 35
+
+/** Literals length maximum accuracy log */
+#define ZSTD_LL_MAX_LOG 9
+
+/** Match length code maximum value */
+#define ZSTD_ML_MAX 52
+
+/** Match length maximum accuracy log */
+#define ZSTD_ML_MAX_LOG 9
+
+/** Offset code maximum value */
+#define ZSTD_OF_MAX 31
+
+/** Offset maximum accuracy log */
+#define ZSTD_OF_MAX_LOG 8
+
+/** Number of repeated offsets */
+#define ZSTD_REPEATS 3
+
+/** An FSE decoding table entry */
+struct zstd_fse_entry {
+	/** Base value for next state */
+	uint16_t base;
+	/** Symbol */
+	uint8_t symbol;
+	/** Number of bits to read for next state */
+	uint8_t bits;
+};
+
+/** An FSE decoding table */
+struct zstd_fse {
+	/** Table is valid */
+	int valid;
+	/** Accuracy log */
+	unsigned int log;
+	/** Table entries */
+	struct zstd_fse_entry entry[ 1 << ZSTD_FSE_MAX_LOG ];
+};
+
+/** A Huffman decoding table entry */
+struct zstd_huffman_entry {
+	/** Symbol */
+	uint8_t symbol;
+	/** Code length (in bits) */
+	uint8_t bits;
+};
+
+/** A Huffman decoding table */
+struct zstd_huffman {
+	/** Maximum code length (in bits) */
+	unsigned int bits;
+	/** Table entries */
+	struct zstd_huffman_entry entry[ 1 << ZSTD_HUFFMAN_MAX_BITS ];
+};
+
+/** A backward bit stream */
+struct zstd_bits {
+	/** Start of stream */
+	const uint8_t *data;
+	/** Length of stream */
+	size_t len;
+	/** Number of unread bits
+	 *
+	 * This becomes negative if the stream is read beyond its
+	 * start, in which case the missing bits are read as zeroes.
+	 */
+	int pos;
+};
+
+/** A Zstandard decompressor */
+struct zstd {
+	/** Output data */
+	void *out;
+	/** Length of output buffer */
+	size_t max;
+	/** Current output offset
+	 *
+	 * This may exceed the length of the output buffer, in which
+	 * case any further output will be discarded.
+	 */
+	size_t offset;
+	/** Offset of start of current frame */
+	size_t frame;
+
+	/** Repeated offsets */
+	uint32_t repeat[ZSTD_REPEATS];
+	/** Huffman table is valid */
+	int have_huffman;
+	/** Huffman table */
+	struct zstd_huffman huffman;
+	/** Huffman weights table */
+	struct zstd_fse weight;
+	/** Literals length table */
+	struct zstd_fse ll;
+	/** Offset table */
+	struct zstd_fse of;
+	/** Match length table */
+	struct zstd_fse ml;
+
+	/** Literals */
+	const uint8_t *literals;
+	/** Length of literals */
+	size_t literals_len;
+	/** Literals buffer */
+	uint8_t buffer[ZSTD_BLOCK_MAX];
+};
+
+extern struct image_type zstd_image_type __image_type ( PROBE_NORMAL );
+
+#endif /* _IPXE_ZSTD_H */
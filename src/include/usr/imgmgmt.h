@@ -12,12 +12,22 @@ FILE_SECBOOT ( PERMITTED );
 
 #include <ipxe/image.h>
 
+extern int imgdownload_digest ( struct uri *uri, unsigned long timeout,
+				unsigned int flags, struct digest_algorithm *digest,
+				struct image **image );
 extern int imgdownload ( struct uri *uri, unsigned long timeout,
-			 struct image **image );
+			 unsigned int flags, struct image **image );
 extern int imgdownload_string ( const char *uri_string, unsigned long timeout,
-				struct image **image );
+				unsigned int flags, struct image **image );
 extern int imgacquire ( const char *name, unsigned long timeout,
-			struct image **image );
+			unsigned int flags, struct image **image );
+extern int imgacquire_digest ( const char *name_uri, unsigned long timeout,
+			       unsigned int flags,
+			       struct digest_algorithm *digest,
+			       struct image **image );
+extern int imgprefetch ( struct uri *uri, unsigned int flags );
+extern void imgprefetch_discard ( void );
+extern int imgprefetch_wait ( unsigned long timeout );
 extern void imgstat ( struct image *image );
 extern int imgmem ( const char *name, const void *data, size_t len );
 
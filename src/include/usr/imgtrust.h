@@ -12,6 +12,8 @@ FILE_SECBOOT ( PERMITTED );
 
 #include <ipxe/image.h>
 
+extern struct digest_algorithm * imgverify_digest ( struct image *signature,
+						    const char *name );
 extern int imgverify ( struct image *image, struct image *signature,
 		       const char *name );
 
@@ -11,5 +11,6 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 FILE_SECBOOT ( PERMITTED );
 
 extern void ipstat ( void );
+extern void tcpstat ( void );
 
 #endif /* _USR_IPSTAT_H */
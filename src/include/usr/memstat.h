@@ -0,0 +1,15 @@
+#ifndef _USR_MEMSTAT_H
+#define _USR_MEMSTAT_H
+
+/** @file
+ *
+ * Memory usage statistics
+ *
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+FILE_SECBOOT ( PERMITTED );
+
+extern void memstat ( void );
+
+#endif /* _USR_MEMSTAT_H */
@@ -10,6 +10,9 @@
 FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 FILE_SECBOOT ( PERMITTED );
 
+struct profiler;
+
+extern void profstat_profiler ( struct profiler *profiler, int histogram );
 extern void profstat ( void );
 
 #endif /* _USR_PROFSTAT_H */
@@ -0,0 +1,15 @@
+#ifndef _USR_TRACESTAT_H
+#define _USR_TRACESTAT_H
+
+/** @file
+ *
+ * Boot-time event tracing
+ *
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+FILE_SECBOOT ( PERMITTED );
+
+extern void tracestat ( void );
+
+#endif /* _USR_TRACESTAT_H */
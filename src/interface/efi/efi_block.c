@@ -52,6 +52,7 @@ FILE_SECBOOT ( PERMITTED );
 #include <ipxe/acpi.h>
 #include <ipxe/efi/efi.h>
 #include <ipxe/efi/Protocol/BlockIo.h>
+#include <ipxe/efi/Protocol/BlockIo2.h>
 #include <ipxe/efi/Protocol/SimpleFileSystem.h>
 #include <ipxe/efi/Protocol/AcpiTable.h>
 #include <ipxe/efi/Guid/FileSystemInfo.h>
@@ -70,6 +71,15 @@ EFI_REQUEST_PROTOCOL ( EFI_ACPI_TABLE_PROTOCOL, &acpi );
 /** Boot filename */
 static wchar_t efi_block_boot_filename[] = EFI_REMOVABLE_MEDIA_FILE_NAME;
 
+/** Interval between polls for asynchronous request completion
+ *
+ * This is measured in units of 100ns.
+ */
+#define EFI_BLOCK_POLL_INTERVAL 10000
+
+/** Maximum number of network stack steps per asynchronous poll */
+#define EFI_BLOCK_POLL_STEPS 16
+
 /** EFI SAN device private data */
 struct efi_block_data {
 	/** SAN device */
@@ -80,10 +90,24 @@ struct efi_block_data {
 	EFI_BLOCK_IO_MEDIA media;
 	/** Block I/O protocol */
 	EFI_BLOCK_IO_PROTOCOL block_io;
+	/** Block I/O 2 protocol */
+	EFI_BLOCK_IO2_PROTOCOL block_io2;
+	/** Asynchronous request poll timer event */
+	EFI_EVENT timer;
 	/** Device path protocol */
 	EFI_DEVICE_PATH_PROTOCOL *path;
 };
 
+/** An asynchronous EFI block device request */
+struct efi_block_request {
+	/** SAN device read/write request */
+	struct san_request req;
+	/** Drive number */
+	unsigned int drive;
+	/** Block I/O 2 token */
+	EFI_BLOCK_IO2_TOKEN *token;
+};
+
 /**
  * Read from or write to EFI block device
  *
@@ -122,6 +146,259 @@ static int efi_block_rw ( struct san_device *sandev, uint64_t lba,
 	return 0;
 }
 
+/**
+ * Complete asynchronous EFI block device request
+ *
+ * @v req		SAN device read/write request
+ * @v rc		Completion status code
+ */
+static void efi_block_complete ( struct san_request *req, int rc ) {
+	EFI_BOOT_SERVICES *bs = efi_systab->BootServices;
+	struct efi_block_request *ioreq =
+		container_of ( req, struct efi_block_request, req );
+	EFI_BLOCK_IO2_TOKEN *token = ioreq->token;
+
+	DBGC2 ( ioreq->drive, "EFIBLK %#02x token %p complete: %s\n",
+		ioreq->drive, token, strerror ( rc ) );
+
+	/* Record status and signal event */
+	token->TransactionStatus = EFIRC ( rc );
+	if ( ! efi_shutdown_in_progress )
+		bs->SignalEvent ( token->Event );
+
+	/* Free request */
+	free ( ioreq );
+}
+
+/**
+ * Poll asynchronous EFI block device requests (from timer event)
+ *
+ * @v event		EFI event
+ * @v context		EFI SAN device private data
+ */
+static VOID EFIAPI efi_block_poll ( EFI_EVENT event __unused,
+				    VOID *context ) {
+	EFI_BOOT_SERVICES *bs = efi_systab->BootServices;
+	struct efi_block_data *block = context;
+	struct san_device *sandev = block->sandev;
+	unsigned int i;
+
+	/* Allow requests to progress */
+	efi_snp_claim();
+	for ( i = 0 ; ( ( i < EFI_BLOCK_POLL_STEPS ) &&
+			( ! list_empty ( &sandev->requests ) ) ) ; i++ ) {
+		step();
+		sandev_poll ( sandev );
+	}
+
+	/* Stop polling once all requests are complete */
+	if ( list_empty ( &sandev->requests ) )
+		bs->SetTimer ( block->timer, TimerCancel, 0 );
+	efi_snp_release();
+}
+
+/**
+ * Read from or write to EFI block device asynchronously
+ *
+ * @v sandev		SAN device
+ * @v lba		Starting LBA
+ * @v token		Block I/O 2 token
+ * @v data		Data buffer
+ * @v len		Size of buffer
+ * @v sandev_rw		SAN device read/write method
+ * @v sandev_rw_async	SAN device asynchronous read/write method
+ * @ret rc		Return status code
+ */
+static int efi_block_rw_async ( struct san_device *sandev, uint64_t lba,
+				EFI_BLOCK_IO2_TOKEN *token,
+				void *data, size_t len,
+				int ( * sandev_rw ) ( struct san_device *sandev,
+						      uint64_t lba,
+						      unsigned int count,
+						      void *buffer ),
+				void ( * sandev_rw_async )
+					( struct san_device *sandev,
+					  struct san_request *req,
+					  uint64_t lba, unsigned int count,
+					  void *buffer ) ) {
+	EFI_BOOT_SERVICES *bs = efi_systab->BootServices;
+	struct efi_block_data *block = sandev->priv;
+	struct efi_block_request *ioreq;
+	unsigned int count;
+	EFI_STATUS efirc;
+	int rc;
+
+	/* Use blocking I/O if no event is provided */
+	if ( ( ! token ) || ( ! token->Event ) )
+		return efi_block_rw ( sandev, lba, data, len, sandev_rw );
+
+	/* Sanity check */
+	count = ( len / block->media.BlockSize );
+	if ( ( count * block->media.BlockSize ) != len ) {
+		DBGC ( sandev->drive, "EFIBLK %#02x impossible length %#zx\n",
+		       sandev->drive, len );
+		return -EINVAL;
+	}
+
+	/* Allocate request */
+	ioreq = zalloc ( sizeof ( *ioreq ) );
+	if ( ! ioreq )
+		return -ENOMEM;
+	ioreq->drive = sandev->drive;
+	ioreq->token = token;
+	ioreq->req.complete = efi_block_complete;
+
+	/* Ensure that outstanding requests will be polled */
+	if ( ( efirc = bs->SetTimer ( block->timer, TimerPeriodic,
+				      EFI_BLOCK_POLL_INTERVAL ) ) != 0 ) {
+		rc = -EEFI ( efirc );
+		DBGC ( sandev->drive, "EFIBLK %#02x could not start timer: "
+		       "%s\n", sandev->drive, strerror ( rc ) );
+		free ( ioreq );
+		return rc;
+	}
+
+	/* Start request (which may complete immediately) */
+	DBGC2 ( sandev->drive, "EFIBLK %#02x token %p queued\n",
+		sandev->drive, token );
+	sandev_rw_async ( sandev, &ioreq->req, lba, count, data );
+
+	return 0;
+}
+
+/**
+ * Wait for all outstanding asynchronous requests to complete
+ *
+ * @v sandev		SAN device
+ */
+static void efi_block_drain ( struct san_device *sandev ) {
+
+	while ( ! list_empty ( &sandev->requests ) ) {
+		step();
+		sandev_poll ( sandev );
+	}
+}
+
+/**
+ * Reset EFI block device
+ *
+ * @v block_io2		Block I/O 2 protocol
+ * @v verify		Perform extended verification
+ * @ret efirc		EFI status code
+ */
+static EFI_STATUS EFIAPI
+efi_block_io2_reset ( EFI_BLOCK_IO2_PROTOCOL *block_io2,
+		      BOOLEAN verify __unused ) {
+	struct efi_block_data *block =
+		container_of ( block_io2, struct efi_block_data, block_io2 );
+	struct san_device *sandev = block->sandev;
+	int rc;
+
+	DBGC2 ( sandev->drive, "EFIBLK %#02x reset (async)\n",
+		sandev->drive );
+	efi_snp_claim();
+	sandev_cancel ( sandev, -ECANCELED );
+	rc = sandev_reset ( sandev );
+	efi_snp_release();
+	return EFIRC ( rc );
+}
+
+/**
+ * Read from EFI block device
+ *
+ * @v block_io2		Block I/O 2 protocol
+ * @v media		Media identifier
+ * @v lba		Starting LBA
+ * @v token		Block I/O 2 token
+ * @v len		Size of buffer
+ * @v data		Data buffer
+ * @ret efirc		EFI status code
+ */
+static EFI_STATUS EFIAPI
+efi_block_io2_read ( EFI_BLOCK_IO2_PROTOCOL *block_io2,
+		     UINT32 media __unused, EFI_LBA lba,
+		     EFI_BLOCK_IO2_TOKEN *token, UINTN len, VOID *data ) {
+	struct efi_block_data *block =
+		container_of ( block_io2, struct efi_block_data, block_io2 );
+	struct san_device *sandev = block->sandev;
+	int rc;
+
+	DBGC2 ( sandev->drive, "EFIBLK %#02x read LBA %#08llx to %p+%#08zx "
+		"(token %p)\n", sandev->drive, lba, data,
+		( ( size_t ) len ), token );
+	efi_snp_claim();
+	rc = efi_block_rw_async ( sandev, lba, token, data, len,
+				  sandev_read, sandev_read_async );
+	efi_snp_release();
+	return EFIRC ( rc );
+}
+
+/**
+ * Write to EFI block device
+ *
+ * @v block_io2		Block I/O 2 protocol
+ * @v media		Media identifier
+ * @v lba		Starting LBA
+ * @v token		Block I/O 2 token
+ * @v len		Size of buffer
+ * @v data		Data buffer
+ * @ret efirc		EFI status code
+ */
+static EFI_STATUS EFIAPI
+efi_block_io2_write ( EFI_BLOCK_IO2_PROTOCOL *block_io2,
+		      UINT32 media __unused, EFI_LBA lba,
+		      EFI_BLOCK_IO2_TOKEN *token, UINTN len, VOID *data ) {
+	struct efi_block_data *block =
+		container_of ( block_io2, struct efi_block_data, block_io2 );
+	struct san_device *sandev = block->sandev;
+	int rc;
+
+	DBGC2 ( sandev->drive, "EFIBLK %#02x write LBA %#08llx from "
+		"%p+%#08zx (token %p)\n", sandev->drive, lba, data,
+		( ( size_t ) len ), token );
+	efi_snp_claim();
+	rc = efi_block_rw_async ( sandev, lba, token, data, len,
+				  sandev_write, sandev_write_async );
+	efi_snp_release();
+	return EFIRC ( rc );
+}
+
+/**
+ * Flush data to EFI block device
+ *
+ * @v block_io2		Block I/O 2 protocol
+ * @v token		Block I/O 2 token
+ * @ret efirc		EFI status code
+ */
+static EFI_STATUS EFIAPI
+efi_block_io2_flush ( EFI_BLOCK_IO2_PROTOCOL *block_io2,
+		      EFI_BLOCK_IO2_TOKEN *token ) {
+	EFI_BOOT_SERVICES *bs = efi_systab->BootServices;
+	struct efi_block_data *block =
+		container_of ( block_io2, struct efi_block_data, block_io2 );
+	struct san_device *sandev = block->sandev;
+	int rc;
+
+	DBGC2 ( sandev->drive, "EFIBLK %#02x flush (token %p)\n",
+		sandev->drive, token );
+
+	/* Wait for any outstanding writes to complete, and write back
+	 * any buffered data.
+	 */
+	efi_snp_claim();
+	efi_block_drain ( sandev );
+	rc = sandev_flush ( sandev );
+	efi_snp_release();
+
+	/* Signal completion, if applicable */
+	if ( token && token->Event ) {
+		token->TransactionStatus = EFIRC ( rc );
+		bs->SignalEvent ( token->Event );
+	}
+
+	return EFIRC ( rc );
+}
+
 /**
  * Reset EFI block device
  *
@@ -206,11 +483,19 @@ efi_block_io_flush ( EFI_BLOCK_IO_PROTOCOL *block_io ) {
 	struct efi_block_data *block =
 		container_of ( block_io, struct efi_block_data, block_io );
 	struct san_device *sandev = block->sandev;
+	int rc;
 
 	DBGC2 ( sandev->drive, "EFIBLK %#02x flush\n", sandev->drive );
 
-	/* Nothing to do */
-	return 0;
+	/* Wait for any outstanding asynchronous writes to complete,
+	 * and write back any buffered data.
+	 */
+	efi_snp_claim();
+	efi_block_drain ( sandev );
+	rc = sandev_flush ( sandev );
+	efi_snp_release();
+
+	return EFIRC ( rc );
 }
 
 /**
@@ -273,6 +558,11 @@ static int efi_block_hook ( unsigned int drive, struct uri **uris,
 	block->block_io.ReadBlocks = efi_block_io_read;
 	block->block_io.WriteBlocks = efi_block_io_write;
 	block->block_io.FlushBlocks = efi_block_io_flush;
+	block->block_io2.Media = &block->media;
+	block->block_io2.Reset = efi_block_io2_reset;
+	block->block_io2.ReadBlocksEx = efi_block_io2_read;
+	block->block_io2.WriteBlocksEx = efi_block_io2_write;
+	block->block_io2.FlushBlocksEx = efi_block_io2_flush;
 
 	/* Register SAN device */
 	if ( ( rc = register_sandev ( sandev, drive, flags ) ) != 0 ) {
@@ -303,10 +593,21 @@ static int efi_block_hook ( unsigned int drive, struct uri **uris,
 	DBGC2 ( drive, "EFIBLK %#02x has device path %s\n",
 		drive, efi_devpath_text ( block->path ) );
 
+	/* Create asynchronous request poll timer event */
+	if ( ( efirc = bs->CreateEvent ( ( EVT_TIMER | EVT_NOTIFY_SIGNAL ),
+					 TPL_CALLBACK, efi_block_poll, block,
+					 &block->timer ) ) != 0 ) {
+		rc = -EEFI ( efirc );
+		DBGC ( drive, "EFIBLK %#02x could not create event: %s\n",
+		       drive, strerror ( rc ) );
+		goto err_event;
+	}
+
 	/* Install protocols */
 	if ( ( efirc = bs->InstallMultipleProtocolInterfaces (
 			&block->handle,
 			&efi_block_io_protocol_guid, &block->block_io,
+			&efi_block_io2_protocol_guid, &block->block_io2,
 			&efi_device_path_protocol_guid, block->path,
 			NULL ) ) != 0 ) {
 		rc = -EEFI ( efirc );
@@ -325,6 +626,7 @@ static int efi_block_hook ( unsigned int drive, struct uri **uris,
 	if ( ( efirc = bs->UninstallMultipleProtocolInterfaces (
 			block->handle,
 			&efi_block_io_protocol_guid, &block->block_io,
+			&efi_block_io2_protocol_guid, &block->block_io2,
 			&efi_device_path_protocol_guid, block->path,
 			NULL ) ) != 0 ) {
 		DBGC ( drive, "EFIBLK %#02x could not uninstall protocols: "
@@ -332,7 +634,10 @@ static int efi_block_hook ( unsigned int drive, struct uri **uris,
 		leak = 1;
 	}
 	efi_nullify_block ( &block->block_io );
+	efi_nullify_block2 ( &block->block_io2 );
  err_install:
+	bs->CloseEvent ( block->timer );
+ err_event:
 	if ( ! leak )  {
 		free ( block->path );
 		block->path = NULL;
@@ -375,6 +680,7 @@ static void efi_block_unhook ( unsigned int drive ) {
 	     ( ( efirc = bs->UninstallMultipleProtocolInterfaces (
 			block->handle,
 			&efi_block_io_protocol_guid, &block->block_io,
+			&efi_block_io2_protocol_guid, &block->block_io2,
 			&efi_device_path_protocol_guid, block->path,
 			NULL ) ) != 0 ) ) {
 		DBGC ( drive, "EFIBLK %#02x could not uninstall protocols: "
@@ -382,6 +688,13 @@ static void efi_block_unhook ( unsigned int drive ) {
 		leak = 1;
 	}
 	efi_nullify_block ( &block->block_io );
+	efi_nullify_block2 ( &block->block_io2 );
+
+	/* Stop polling for asynchronous requests */
+	if ( ! efi_shutdown_in_progress ) {
+		bs->SetTimer ( block->timer, TimerCancel, 0 );
+		bs->CloseEvent ( block->timer );
+	}
 
 	/* Free device path */
 	if ( ! leak ) {
@@ -86,6 +86,16 @@ struct efi_file {
 	const char *name;
 	/** Current file position */
 	size_t pos;
+	/** Image at which to resume reading (if any)
+	 *
+	 * Files constructed from multiple images (such as the magic
+	 * initrd file) record the image containing the current file
+	 * position, so that sequential reads do not need to
+	 * reconstruct the file from the beginning.
+	 */
+	struct image *cursor;
+	/** File position of start of cursor image */
+	size_t cursor_pos;
 	/**
 	 * Read from file
 	 *
@@ -117,10 +127,28 @@ static void efi_file_free ( struct refcnt *refcnt ) {
 	struct efi_file *file =
 		container_of ( refcnt, struct efi_file, refcnt );
 
+	image_put ( file->cursor );
 	image_put ( file->image );
 	free ( file );
 }
 
+/**
+ * Set EFI file read cursor
+ *
+ * @v file		EFI file
+ * @v image		Image at which to resume reading, or NULL
+ * @v pos		File position of start of image
+ */
+static void efi_file_cursor ( struct efi_file *file, struct image *image,
+			      size_t pos ) {
+
+	if ( image != file->cursor ) {
+		image_put ( file->cursor );
+		file->cursor = image_get ( image );
+	}
+	file->cursor_pos = pos;
+}
+
 /**
  * Get EFI file name (for debugging)
  *
@@ -240,6 +268,7 @@ static size_t efi_file_read_image ( struct efi_file_reader *reader ) {
  */
 static size_t efi_file_read_initrd ( struct efi_file_reader *reader ) {
 	struct efi_file *file = reader->file;
+	struct image *cursor = file->cursor;
 	struct cpio_header cpio;
 	struct image *image;
 	const char *name;
@@ -249,14 +278,38 @@ static size_t efi_file_read_initrd ( struct efi_file_reader *reader ) {
 	size_t len;
 	unsigned int i;
 
+	/* Resume from cursor image, if applicable.  The dummy read
+	 * used to determine the file length always starts from the
+	 * beginning.
+	 */
+	if ( reader->data && cursor &&
+	     ( cursor->flags & IMAGE_REGISTERED ) &&
+	     ( ! ( cursor->flags & IMAGE_HIDDEN ) ) &&
+	     ( file->pos >= file->cursor_pos ) ) {
+		image = list_entry ( cursor->list.prev, struct image, list );
+		reader->pos = file->cursor_pos;
+	} else {
+		image = list_entry ( &images, struct image, list );
+	}
+
 	/* Read from file */
 	len = 0;
-	for_each_image ( image ) {
+	list_for_each_entry_continue ( image, &images, list ) {
 
 		/* Skip hidden images */
 		if ( image->flags & IMAGE_HIDDEN )
 			continue;
 
+		/* Stop when output buffer is full */
+		if ( reader->data && ( ! reader->len ) )
+			break;
+
+		/* Record image as cursor if it starts at or before the
+		 * current file position.
+		 */
+		if ( reader->data && ( reader->pos <= file->pos ) )
+			efi_file_cursor ( file, image, reader->pos );
+
 		/* Pad to alignment boundary */
 		pad_len = ( ( -reader->pos ) & ( INITRD_ALIGN - 1 ) );
 		if ( pad_len ) {
@@ -763,9 +816,10 @@ efi_file_load ( EFI_LOAD_FILE2_PROTOCOL *this,
 		EFI_DEVICE_PATH_PROTOCOL *path __unused,
 		BOOLEAN boot __unused, UINTN *len, VOID *data ) {
 	struct efi_file *file = container_of ( this, struct efi_file, load );
+	struct efi_file_reader reader;
+	size_t pos = file->pos;
 	size_t max_len;
 	size_t file_len;
-	EFI_STATUS efirc;
 
 	/* Calculate maximum length */
 	max_len = ( data ? *len : 0 );
@@ -779,9 +833,20 @@ efi_file_load ( EFI_LOAD_FILE2_PROTOCOL *this,
 		return EFI_BUFFER_TOO_SMALL;
 	}
 
-	/* Read from file */
-	if ( ( efirc = efi_file_read ( &file->file, len, data ) ) != 0 )
-		return efirc;
+	/* If this is the root directory, then construct a directory entry */
+	if ( ! file->read )
+		return efi_file_read_dir ( file, len, data );
+
+	/* Read entire file in a single pass, independent of (and
+	 * without disturbing) the current file position.
+	 */
+	reader.file = file;
+	reader.pos = 0;
+	reader.data = data;
+	reader.len = file_len;
+	file->pos = 0;
+	*len = file->read ( &reader );
+	file->pos = pos;
 
 	return 0;
 }
@@ -1216,6 +1281,7 @@ void efi_file_uninstall ( EFI_HANDLE handle ) {
 
 	/* Uninstall Linux initrd fixed device path file */
 	efi_file_path_uninstall ( &efi_file_initrd );
+	efi_file_cursor ( &efi_file_initrd.file, NULL, 0 );
 
 	/* Close our own disk I/O protocol */
 	efi_close_by_driver ( handle, &efi_disk_io_protocol_guid );
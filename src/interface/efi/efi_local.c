@@ -37,6 +37,8 @@ FILE_SECBOOT ( PERMITTED );
 #include <ipxe/iobuf.h>
 #include <ipxe/process.h>
 #include <ipxe/errortab.h>
+#include <ipxe/xferbuf.h>
+#include <ipxe/imgcache.h>
 #include <ipxe/efi/efi.h>
 #include <ipxe/efi/efi_strings.h>
 #include <ipxe/efi/efi_path.h>
@@ -79,6 +81,8 @@ struct efi_local {
 	const char *volume;
 	/** File path */
 	const char *path;
+	/** File open mode */
+	UINT64 mode;
 
 	/** EFI root directory */
 	EFI_FILE_PROTOCOL *root;
@@ -341,7 +345,7 @@ static int efi_local_open_resolved ( struct efi_local *local,
 
 	/* Open file */
 	if ( ( efirc = local->root->Open ( local->root, &file, name,
-					   EFI_FILE_MODE_READ, 0 ) ) != 0 ) {
+					   local->mode, 0 ) ) != 0 ) {
 		rc = -EEFI_OPEN ( efirc );
 		DBGC ( local, "LOCAL %p could not open \"%s\": %s\n",
 		       local, resolved, strerror ( rc ) );
@@ -579,6 +583,7 @@ static int efi_local_open ( struct interface *xfer, struct uri *uri ) {
 	local->uri = uri_get ( uri );
 	local->volume = ( ( uri->host && uri->host[0] ) ? uri->host : NULL );
 	local->path = ( uri->opaque ? uri->opaque : uri->path );
+	local->mode = EFI_FILE_MODE_READ;
 
 	/* Start download process */
 	process_add ( &local->process );
@@ -594,3 +599,214 @@ struct uri_opener efi_local_uri_opener __uri_opener = {
 	.scheme	= "file",
 	.open	= efi_local_open,
 };
+
+/******************************************************************************
+ *
+ * Image cache backing store
+ *
+ ******************************************************************************
+ */
+
+/**
+ * Open local file for image cache access
+ *
+ * @v local		Local file to fill in
+ * @v uri		File URI
+ * @v mode		File open mode
+ * @ret rc		Return status code
+ */
+static int efi_local_cache_open ( struct efi_local *local, struct uri *uri,
+				  UINT64 mode ) {
+	int rc;
+
+	/* Initialise structure */
+	memset ( local, 0, sizeof ( *local ) );
+	local->volume = ( ( uri->host && uri->host[0] ) ? uri->host : NULL );
+	local->path = ( uri->opaque ? uri->opaque : uri->path );
+	local->mode = mode;
+	if ( ! local->path )
+		return -ENOENT;
+
+	/* Open volume root directory */
+	if ( ( rc = efi_local_open_volume ( local ) ) != 0 )
+		return rc;
+
+	/* Open file */
+	if ( ( rc = efi_local_open_path ( local ) ) != 0 ) {
+		local->root->Close ( local->root );
+		return rc;
+	}
+
+	return 0;
+}
+
+/**
+ * Close local file used for image cache access
+ *
+ * @v local		Local file
+ */
+static void efi_local_cache_close ( struct efi_local *local ) {
+
+	local->file->Close ( local->file );
+	local->root->Close ( local->root );
+}
+
+/**
+ * Read image cache file
+ *
+ * @v uri		File URI
+ * @v buffer		Data transfer buffer to fill in
+ * @ret rc		Return status code
+ */
+static int efi_local_cache_read ( struct uri *uri,
+				  struct xfer_buffer *buffer ) {
+	struct efi_local local;
+	UINTN size;
+	EFI_STATUS efirc;
+	int rc;
+
+	/* Open file */
+	if ( ( rc = efi_local_cache_open ( &local, uri,
+					   EFI_FILE_MODE_READ ) ) != 0 )
+		goto err_open;
+
+	/* Get file length */
+	if ( ( rc = efi_local_len ( &local ) ) != 0 )
+		goto err_len;
+
+	/* Allocate buffer */
+	if ( ( rc = xferbuf_ensure_size ( buffer, local.len ) ) != 0 )
+		goto err_size;
+
+	/* Read file */
+	size = local.len;
+	if ( size && ( ( efirc = local.file->Read ( local.file, &size,
+						    buffer->data ) ) != 0 ) ) {
+		rc = -EEFI ( efirc );
+		DBGC ( &local, "LOCAL %p could not read from file: %s\n",
+		       &local, strerror ( rc ) );
+		goto err_read;
+	}
+	if ( size != local.len ) {
+		DBGC ( &local, "LOCAL %p short read\n", &local );
+		rc = -EIO;
+		goto err_read;
+	}
+
+ err_read:
+ err_size:
+ err_len:
+	efi_local_cache_close ( &local );
+ err_open:
+	return rc;
+}
+
+/**
+ * Truncate local file
+ *
+ * @v local		Local file
+ * @ret rc		Return status code
+ */
+static int efi_local_truncate ( struct efi_local *local ) {
+	EFI_FILE_PROTOCOL *file = local->file;
+	EFI_FILE_INFO *info;
+	EFI_STATUS efirc;
+	UINTN size;
+	int rc;
+
+	/* Get size of file information */
+	size = 0;
+	file->GetInfo ( file, &efi_file_info_id, &size, NULL );
+
+	/* Allocate file information */
+	info = malloc ( size );
+	if ( ! info ) {
+		rc = -ENOMEM;
+		goto err_alloc;
+	}
+
+	/* Get file information */
+	if ( ( efirc = file->GetInfo ( file, &efi_file_info_id, &size,
+				       info ) ) != 0 ) {
+		rc = -EEFI ( efirc );
+		DBGC ( local, "LOCAL %p could not get file info: %s\n",
+		       local, strerror ( rc ) );
+		goto err_get_info;
+	}
+
+	/* Truncate file, if applicable */
+	if ( info->FileSize ) {
+		info->FileSize = 0;
+		if ( ( efirc = file->SetInfo ( file, &efi_file_info_id, size,
+					       info ) ) != 0 ) {
+			rc = -EEFI ( efirc );
+			DBGC ( local, "LOCAL %p could not truncate file: %s\n",
+			       local, strerror ( rc ) );
+			goto err_set_info;
+		}
+	}
+
+	/* Success */
+	rc = 0;
+
+ err_set_info:
+ err_get_info:
+	free ( info );
+ err_alloc:
+	return rc;
+}
+
+/**
+ * Write image cache file
+ *
+ * @v uri		File URI
+ * @v data		Data
+ * @v len		Length of data
+ * @ret rc		Return status code
+ */
+static int efi_local_cache_write ( struct uri *uri, const void *data,
+				   size_t len ) {
+	struct efi_local local;
+	UINTN size;
+	EFI_STATUS efirc;
+	int rc;
+
+	/* Open file, creating if necessary */
+	if ( ( rc = efi_local_cache_open ( &local, uri,
+					   ( EFI_FILE_MODE_READ |
+					     EFI_FILE_MODE_WRITE |
+					     EFI_FILE_MODE_CREATE ) ) ) != 0 )
+		goto err_open;
+
+	/* Discard any existing content */
+	if ( ( rc = efi_local_truncate ( &local ) ) != 0 )
+		goto err_truncate;
+
+	/* Write file */
+	size = len;
+	if ( ( efirc = local.file->Write ( local.file, &size,
+					   ( ( void * ) data ) ) ) != 0 ) {
+		rc = -EEFI ( efirc );
+		DBGC ( &local, "LOCAL %p could not write to file: %s\n",
+		       &local, strerror ( rc ) );
+		goto err_write;
+	}
+	if ( size != len ) {
+		DBGC ( &local, "LOCAL %p short write\n", &local );
+		rc = -EIO;
+		goto err_write;
+	}
+
+ err_write:
+ err_truncate:
+	efi_local_cache_close ( &local );
+ err_open:
+	return rc;
+}
+
+/** EFI local file image cache backing store */
+struct imgcache_store efi_local_imgcache_store __imgcache_store = {
+	.name = "EFI",
+	.read = efi_local_cache_read,
+	.write = efi_local_cache_write,
+};
@@ -399,6 +399,59 @@ void efi_nullify_block ( EFI_BLOCK_IO_PROTOCOL *block ) {
 	memcpy ( block, &efi_null_block, sizeof ( *block ) );
 }
 
+/******************************************************************************
+ *
+ * Block I/O 2 protocol
+ *
+ ******************************************************************************
+ */
+
+static EFI_STATUS EFIAPI
+efi_null_block2_reset ( EFI_BLOCK_IO2_PROTOCOL *block2 __unused,
+			BOOLEAN verify __unused ) {
+	return EFI_UNSUPPORTED;
+}
+
+static EFI_STATUS EFIAPI
+efi_null_block2_read ( EFI_BLOCK_IO2_PROTOCOL *block2 __unused,
+		       UINT32 media __unused, EFI_LBA lba __unused,
+		       EFI_BLOCK_IO2_TOKEN *token __unused,
+		       UINTN len __unused, VOID *data __unused ) {
+	return EFI_UNSUPPORTED;
+}
+
+static EFI_STATUS EFIAPI
+efi_null_block2_write ( EFI_BLOCK_IO2_PROTOCOL *block2 __unused,
+			UINT32 media __unused, EFI_LBA lba __unused,
+			EFI_BLOCK_IO2_TOKEN *token __unused,
+			UINTN len __unused, VOID *data __unused ) {
+	return EFI_UNSUPPORTED;
+}
+
+static EFI_STATUS EFIAPI
+efi_null_block2_flush ( EFI_BLOCK_IO2_PROTOCOL *block2 __unused,
+			EFI_BLOCK_IO2_TOKEN *token __unused ) {
+	return EFI_UNSUPPORTED;
+}
+
+static EFI_BLOCK_IO2_PROTOCOL efi_null_block2 = {
+	.Media = &efi_null_block_media,
+	.Reset = efi_null_block2_reset,
+	.ReadBlocksEx = efi_null_block2_read,
+	.WriteBlocksEx = efi_null_block2_write,
+	.FlushBlocksEx = efi_null_block2_flush,
+};
+
+/**
+ * Nullify block I/O 2 protocol
+ *
+ * @v block2		Block I/O 2 protocol
+ */
+void efi_nullify_block2 ( EFI_BLOCK_IO2_PROTOCOL *block2 ) {
+
+	memcpy ( block2, &efi_null_block2, sizeof ( *block2 ) );
+}
+
 /******************************************************************************
  *
  * PXE base code protocol
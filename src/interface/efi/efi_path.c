@@ -32,6 +32,7 @@ FILE_SECBOOT ( PERMITTED );
 #include <ipxe/uri.h>
 #include <ipxe/iscsi.h>
 #include <ipxe/aoe.h>
+#include <ipxe/nvmetcp.h>
 #include <ipxe/fcp.h>
 #include <ipxe/ib_srp.h>
 #include <ipxe/usb.h>
@@ -607,6 +608,74 @@ EFI_DEVICE_PATH_PROTOCOL * efi_aoe_path ( struct aoe_device *aoedev ) {
 	return NULL;
 }
 
+/**
+ * Construct EFI device path for NVMe/TCP device
+ *
+ * @v nvme		NVMe/TCP device
+ * @ret path		EFI device path, or NULL on error
+ */
+EFI_DEVICE_PATH_PROTOCOL * efi_nvmetcp_path ( struct nvmetcp_device *nvme ) {
+	struct sockaddr_tcpip *st_target;
+	struct net_device *netdev;
+	EFI_DEVICE_PATH_PROTOCOL *netpath;
+	EFI_DEVICE_PATH_PROTOCOL *path;
+	EFI_DEVICE_PATH_PROTOCOL *end;
+	NVME_OF_NAMESPACE_DEVICE_PATH *nvmepath;
+	char *name;
+	size_t prefix_len;
+	size_t name_len;
+	size_t nvme_len;
+	size_t len;
+
+	/* Get network device associated with target address */
+	st_target = ( ( struct sockaddr_tcpip * ) &nvme->target_sockaddr );
+	netdev = tcpip_netdev ( st_target );
+	if ( ! netdev )
+		goto err_netdev;
+
+	/* Get network device path */
+	netpath = efi_netdev_path ( netdev );
+	if ( ! netpath )
+		goto err_netpath;
+
+	/* Calculate device path length */
+	prefix_len = efi_path_len ( netpath );
+	name_len = ( strlen ( nvme->subnqn ) + 1 /* NUL */ );
+	nvme_len = ( sizeof ( *nvmepath ) + name_len );
+	len = ( prefix_len + nvme_len + sizeof ( *end ) );
+
+	/* Allocate device path */
+	path = zalloc ( len );
+	if ( ! path )
+		goto err_alloc;
+
+	/* Construct device path */
+	memcpy ( path, netpath, prefix_len );
+	nvmepath = ( ( ( void * ) path ) + prefix_len );
+	nvmepath->Header.Type = MESSAGING_DEVICE_PATH;
+	nvmepath->Header.SubType = MSG_NVME_OF_NAMESPACE_DP;
+	nvmepath->Header.Length[0] = ( nvme_len & 0xff );
+	nvmepath->Header.Length[1] = ( nvme_len >> 8 );
+	nvmepath->NamespaceIdType = NVME_NIDT_NGUID;
+	memcpy ( nvmepath->NamespaceId, nvme->nguid,
+		 sizeof ( nvmepath->NamespaceId ) );
+	name = ( ( ( void * ) nvmepath ) + sizeof ( *nvmepath ) );
+	memcpy ( name, nvme->subnqn, name_len );
+	end = ( ( ( void * ) name ) + name_len );
+	efi_path_terminate ( end );
+
+	/* Free temporary paths */
+	free ( netpath );
+
+	return path;
+
+ err_alloc:
+	free ( netpath );
+ err_netpath:
+ err_netdev:
+	return NULL;
+}
+
 /**
  * Construct EFI device path for Fibre Channel device
  *
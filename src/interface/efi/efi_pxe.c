@@ -66,6 +66,9 @@ static EFI_GUID dummy_pxe_base_code_protocol_guid = {
 #define efi_pxe_base_code_protocol_guid dummy_pxe_base_code_protocol_guid
 #endif
 
+/** Maximum size of file to be read ahead into the file cache */
+#define EFI_PXE_CACHE_MAX_LEN ( 256 * 1024 * 1024 )
+
 /** A PXE base code */
 struct efi_pxe {
 	/** Reference count */
@@ -103,6 +106,21 @@ struct efi_pxe {
 	/** Overall return status */
 	int rc;
 
+	/** Read-ahead file cache
+	 *
+	 * Loaders typically determine the size of a file using
+	 * EFI_PXE_BASE_CODE_TFTP_GET_FILE_SIZE, allocate a buffer,
+	 * and then download the file using
+	 * EFI_PXE_BASE_CODE_TFTP_READ_FILE.  We download the whole
+	 * file (if not too large) when asked for its size, and serve
+	 * the subsequent read from this cache.
+	 */
+	struct xfer_buffer cache;
+	/** Server address of cached file */
+	EFI_IP_ADDRESS cache_ip;
+	/** Name of cached file (or NULL if no file is cached) */
+	char *cache_name;
+
 	/** UDP interface */
 	struct interface udp;
 	/** List of received UDP packets */
@@ -353,6 +371,16 @@ static int efi_pxe_tftp_deliver ( struct efi_pxe *pxe,
 				  struct xfer_metadata *meta ) {
 	int rc;
 
+	/* Abandon read-ahead if file is too large to cache */
+	if ( ( pxe->opcode == EFI_PXE_BASE_CODE_TFTP_GET_FILE_SIZE ) &&
+	     ( pxe->buf.op != &xferbuf_void_operations ) &&
+	     ( meta->flags & XFER_FL_ABS_OFFSET ) &&
+	     ( meta->offset > EFI_PXE_CACHE_MAX_LEN ) ) {
+		DBGC ( pxe, "PXE %s file too large to cache\n", pxe->name );
+		xferbuf_free ( &pxe->buf );
+		xferbuf_void_init ( &pxe->buf );
+	}
+
 	/* Deliver to data transfer buffer */
 	if ( ( rc = xferbuf_deliver ( &pxe->buf, iob_disown ( iobuf ),
 				      meta ) ) != 0 )
@@ -360,6 +388,7 @@ static int efi_pxe_tftp_deliver ( struct efi_pxe *pxe,
 
 	/* Stop when filesize is known, if applicable */
 	if ( ( pxe->opcode == EFI_PXE_BASE_CODE_TFTP_GET_FILE_SIZE ) &&
+	     ( pxe->buf.op == &xferbuf_void_operations ) &&
 	     ( meta->flags & XFER_FL_ABS_OFFSET ) ) {
 		goto done;
 	}
@@ -398,7 +427,7 @@ static int efi_pxe_tftp_open ( struct efi_pxe *pxe, EFI_IP_ADDRESS *ip,
 
 	/* Parse server address and filename */
 	efi_pxe_ip_sockaddr ( pxe, ip, &server );
-	uri = pxe_uri ( &server, filename );
+	uri = pxe_tftp_uri ( &server, filename );
 	if ( ! uri ) {
 		DBGC ( pxe, "PXE %s could not parse %s:%s\n", pxe->name,
 		       efi_pxe_ip_ntoa ( pxe, ip ), filename );
@@ -419,6 +448,40 @@ static int efi_pxe_tftp_open ( struct efi_pxe *pxe, EFI_IP_ADDRESS *ip,
 	return rc;
 }
 
+/**
+ * Discard read-ahead file cache
+ *
+ * @v pxe		PXE base code
+ */
+static void efi_pxe_cache_discard ( struct efi_pxe *pxe ) {
+
+	/* Do nothing unless a file is cached */
+	if ( ! pxe->cache_name )
+		return;
+
+	/* Free cached data */
+	xferbuf_free ( &pxe->cache );
+	free ( pxe->cache_name );
+	pxe->cache_name = NULL;
+}
+
+/**
+ * Check for file in read-ahead file cache
+ *
+ * @v pxe		PXE base code
+ * @v ip		EFI IP address
+ * @v filename		Filename
+ * @ret cached		File is present in cache
+ */
+static int efi_pxe_cached ( struct efi_pxe *pxe, EFI_IP_ADDRESS *ip,
+			    const char *filename ) {
+
+	return ( pxe->cache_name &&
+		 ( strcmp ( pxe->cache_name, filename ) == 0 ) &&
+		 ( memcmp ( &pxe->cache_ip, ip,
+			    sizeof ( pxe->cache_ip ) ) == 0 ) );
+}
+
 /******************************************************************************
  *
  * UDP interface
@@ -782,6 +845,9 @@ static EFI_STATUS EFIAPI efi_pxe_stop ( EFI_PXE_BASE_CODE_PROTOCOL *base ) {
 	/* Close TFTP */
 	efi_pxe_tftp_close ( pxe, 0 );
 
+	/* Discard read-ahead file cache */
+	efi_pxe_cache_discard ( pxe );
+
 	/* Close UDP */
 	efi_pxe_udp_close ( pxe, 0 );
 
@@ -924,6 +990,24 @@ efi_pxe_mtftp ( EFI_PXE_BASE_CODE_PROTOCOL *base,
 		goto err_opcode;
 	}
 
+	/* Serve file from read-ahead cache, if possible */
+	if ( ( opcode != EFI_PXE_BASE_CODE_TFTP_GET_FILE_SIZE ) &&
+	     ( ! callback ) &&
+	     efi_pxe_cached ( pxe, ip, ( ( const char * ) filename ) ) ) {
+		if ( *len < pxe->cache.max ) {
+			*len = pxe->cache.max;
+			rc = -ENOSPC;
+			goto err_cache;
+		}
+		memcpy ( data, pxe->cache.data, pxe->cache.max );
+		*len = pxe->cache.max;
+		DBGC ( pxe, "PXE %s MTFTP %d %p+%llx served from cache\n",
+		       pxe->name, opcode, data, *len );
+		efi_pxe_cache_discard ( pxe );
+		return 0;
+	}
+	efi_pxe_cache_discard ( pxe );
+
 	/* Claim network devices */
 	efi_snp_claim();
 
@@ -935,7 +1019,10 @@ efi_pxe_mtftp ( EFI_PXE_BASE_CODE_PROTOCOL *base,
 
 	/* Initialise data transfer buffer */
 	memset ( &pxe->buf, 0, sizeof ( pxe->buf ) );
-	if ( opcode == EFI_PXE_BASE_CODE_TFTP_GET_FILE_SIZE ) {
+	if ( ( opcode == EFI_PXE_BASE_CODE_TFTP_GET_FILE_SIZE ) &&
+	     ( ! callback ) ) {
+		xferbuf_umalloc_init ( &pxe->buf );
+	} else if ( opcode == EFI_PXE_BASE_CODE_TFTP_GET_FILE_SIZE ) {
 		xferbuf_void_init ( &pxe->buf );
 	} else {
 		xferbuf_fixed_init ( &pxe->buf, data, *len );
@@ -960,11 +1047,24 @@ efi_pxe_mtftp ( EFI_PXE_BASE_CODE_PROTOCOL *base,
 	DBGC ( pxe, "PXE %s MTFTP %d %p+%llx complete\n",
 	       pxe->name, opcode, data, *len );
 
+	/* Retain read-ahead data in cache, if applicable */
+	if ( pxe->buf.op == &xferbuf_umalloc_operations ) {
+		pxe->cache_name = strdup ( ( const char * ) filename );
+		if ( pxe->cache_name ) {
+			memcpy ( &pxe->cache, &pxe->buf, sizeof ( pxe->cache ) );
+			memcpy ( &pxe->cache_ip, ip, sizeof ( pxe->cache_ip ) );
+			xferbuf_detach ( &pxe->buf );
+		}
+	}
+
  err_download:
 	efi_pxe_tftp_close ( pxe, rc );
  err_open:
+	if ( pxe->buf.op == &xferbuf_umalloc_operations )
+		xferbuf_free ( &pxe->buf );
 	xferbuf_fixed_init ( &pxe->buf, NULL, 0 );
 	efi_snp_release();
+ err_cache:
  err_opcode:
 	return EFIRC ( rc );
 }
@@ -158,6 +158,7 @@ static void efi_snp_flush ( struct efi_snp_device *snpdev ) {
 		list_del ( &iobuf->list );
 		free_iob ( iobuf );
 	}
+	snpdev->rx_count = 0;
 }
 
 /**
@@ -174,7 +175,17 @@ static void efi_snp_poll ( struct efi_snp_device *snpdev ) {
 
 	/* Retrieve any received packets */
 	while ( ( iobuf = netdev_rx_dequeue ( snpdev->netdev ) ) ) {
+
+		/* Drop packet if receive queue is full */
+		if ( snpdev->rx_count >= EFI_SNP_MAX_RX ) {
+			DBGC2 ( snpdev, "SNPDEV %p RX queue full\n", snpdev );
+			free_iob ( iobuf );
+			continue;
+		}
+
+		/* Add to receive queue */
 		list_add_tail ( &iobuf->list, &snpdev->rx );
+		snpdev->rx_count++;
 		snpdev->interrupts |= EFI_SIMPLE_NETWORK_RECEIVE_INTERRUPT;
 		bs->SignalEvent ( snpdev->snp.WaitForPacket );
 	}
@@ -786,8 +797,9 @@ efi_snp_receive ( EFI_SIMPLE_NETWORK_PROTOCOL *snp,
 	/* Raise TPL */
 	efi_raise_tpl ( &tpl );
 
-	/* Poll the network device */
-	efi_snp_poll ( snpdev );
+	/* Poll the network device, unless a packet is already queued */
+	if ( list_empty ( &snpdev->rx ) )
+		efi_snp_poll ( snpdev );
 
 	/* Check for an available packet */
 	iobuf = list_first_entry ( &snpdev->rx, struct io_buffer, list );
@@ -800,6 +812,7 @@ efi_snp_receive ( EFI_SIMPLE_NETWORK_PROTOCOL *snp,
 
 	/* Dequeue packet */
 	list_del ( &iobuf->list );
+	snpdev->rx_count--;
 
 	/* Return packet to caller, truncating to buffer length */
 	copy_len = iob_len ( iobuf );
@@ -1793,6 +1806,9 @@ static int efi_snp_probe ( struct net_device *netdev, void *priv __unused ) {
 	EFI_STATUS efirc;
 	int rc;
 
+	/* Transmit completion ring counters are allowed to wrap */
+	build_assert ( ( EFI_SNP_NUM_TX & ( EFI_SNP_NUM_TX - 1 ) ) == 0 );
+
 	/* Allocate the SNP device */
 	snpdev = zalloc ( sizeof ( *snpdev ) );
 	if ( ! snpdev ) {
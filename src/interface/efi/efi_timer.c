@@ -29,7 +29,9 @@ FILE_SECBOOT ( PERMITTED );
 #include <unistd.h>
 #include <ipxe/timer.h>
 #include <ipxe/init.h>
+#include <ipxe/profile.h>
 #include <ipxe/efi/efi.h>
+#include <config/timer.h>
 
 /** @file
  *
@@ -44,9 +46,25 @@ FILE_SECBOOT ( PERMITTED );
  */
 #define EFI_JIFFIES_PER_SEC 32
 
+/** Number of timer ticks per jiffy */
+#define EFI_TICKS_PER_JIFFY ( TICKS_PER_SEC / EFI_JIFFIES_PER_SEC )
+
+/** Use CPU cycle counter to interpolate between jiffies */
+#ifdef TIMER_EFI_HIRES
+#define EFI_HIRES 1
+#else
+#define EFI_HIRES 0
+#endif
+
 /** Current tick count */
 static unsigned long efi_jiffies;
 
+/** Cycle counter value at most recent jiffy */
+static unsigned long efi_jiffy_cycles;
+
+/** Number of cycle counter increments per timer tick (or zero) */
+static unsigned long efi_cycles_per_tick;
+
 /** Timer tick event */
 static EFI_EVENT efi_tick_event;
 
@@ -78,6 +96,8 @@ static void efi_udelay ( unsigned long usecs ) {
  */
 static unsigned long efi_currticks ( void ) {
 	struct efi_dropped_tpl tpl;
+	unsigned long ticks;
+	unsigned long elapsed;
 
 	/* UEFI manages to ingeniously combine the worst aspects of
 	 * both polling and interrupt-driven designs.  There is no way
@@ -136,12 +156,28 @@ static unsigned long efi_currticks ( void ) {
 	 */
 	if ( efi_shutdown_in_progress ) {
 		efi_jiffies++;
-	} else {
-		efi_drop_tpl ( &tpl );
-		efi_undrop_tpl ( &tpl );
+		return ( efi_jiffies * EFI_TICKS_PER_JIFFY );
 	}
+	efi_drop_tpl ( &tpl );
+	efi_undrop_tpl ( &tpl );
+	ticks = ( efi_jiffies * EFI_TICKS_PER_JIFFY );
 
-	return ( efi_jiffies * ( TICKS_PER_SEC / EFI_JIFFIES_PER_SEC ) );
+	/* Jiffies are too coarse for timing retransmissions on a
+	 * low-latency network.  Where a calibrated cycle counter is
+	 * available, use it to interpolate between jiffies.  The
+	 * interpolated offset is capped to lie within the current
+	 * jiffy, so that the result remains monotonic even if the
+	 * cycle counter rate is inaccurate or varies.
+	 */
+	if ( EFI_HIRES && efi_cycles_per_tick ) {
+		elapsed = ( ( profile_timestamp() - efi_jiffy_cycles ) /
+			    efi_cycles_per_tick );
+		if ( elapsed >= EFI_TICKS_PER_JIFFY )
+			elapsed = ( EFI_TICKS_PER_JIFFY - 1 );
+		ticks += elapsed;
+	}
+
+	return ticks;
 }
 
 /**
@@ -155,6 +191,28 @@ static EFIAPI void efi_tick ( EFI_EVENT event __unused,
 
 	/* Increment tick count */
 	efi_jiffies++;
+
+	/* Record cycle counter value, if applicable */
+	if ( EFI_HIRES )
+		efi_jiffy_cycles = profile_timestamp();
+}
+
+/**
+ * Calibrate cycle counter
+ *
+ */
+static void efi_tick_calibrate ( void ) {
+	unsigned long before;
+	unsigned long after;
+
+	/* Measure cycle counter increments during one timer tick */
+	before = profile_timestamp();
+	efi_udelay ( 1000000 / TICKS_PER_SEC );
+	after = profile_timestamp();
+	efi_cycles_per_tick = ( after - before );
+	efi_jiffy_cycles = after;
+	DBGC ( colour, "EFI timer has %ld cycles per tick\n",
+	       efi_cycles_per_tick );
 }
 
 /**
@@ -166,6 +224,10 @@ static void efi_tick_startup ( void ) {
 	EFI_STATUS efirc;
 	int rc;
 
+	/* Calibrate cycle counter, if applicable */
+	if ( EFI_HIRES )
+		efi_tick_calibrate();
+
 	/* Create timer tick event */
 	if ( ( efirc = bs->CreateEvent ( ( EVT_TIMER | EVT_NOTIFY_SIGNAL ),
 					 TPL_CALLBACK, efi_tick, NULL,
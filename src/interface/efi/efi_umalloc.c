@@ -37,6 +37,63 @@ FILE_SECBOOT ( PERMITTED );
  *
  */
 
+/**
+ * Resize external memory in place
+ *
+ * @v ptr		Memory previously allocated by umalloc()
+ * @v new_size		Requested size (must be non-zero)
+ * @ret rc		Return status code
+ *
+ * Shrinking a block frees the pages beyond the new end of the
+ * block.  Growing a block attempts to allocate the pages immediately
+ * following the existing block, which avoids the need to copy the
+ * existing contents.
+ */
+static int efi_uresize ( void *ptr, size_t new_size ) {
+	EFI_BOOT_SERVICES *bs = efi_systab->BootServices;
+	EFI_PHYSICAL_ADDRESS phys_addr;
+	unsigned int new_pages, old_pages;
+	size_t *info;
+	EFI_STATUS efirc;
+	int rc;
+
+	/* Calculate old and new sizes in pages */
+	info = ( ptr - EFI_PAGE_SIZE );
+	old_pages = ( EFI_SIZE_TO_PAGES ( *info ) + 1 );
+	new_pages = ( EFI_SIZE_TO_PAGES ( new_size ) + 1 );
+	phys_addr = ( virt_to_phys ( info ) +
+		      ( ( ( new_pages < old_pages ) ?
+			  new_pages : old_pages ) * EFI_PAGE_SIZE ) );
+
+	/* Free or allocate pages beyond the end of the block */
+	if ( new_pages < old_pages ) {
+		if ( ( efirc = bs->FreePages ( phys_addr,
+					       ( old_pages -
+						 new_pages ) ) ) != 0 ) {
+			rc = -EEFI ( efirc );
+			DBG ( "EFI could not free %d pages at %llx: %s\n",
+			      ( old_pages - new_pages ), phys_addr,
+			      strerror ( rc ) );
+			/* Not fatal; we have leaked memory */
+		}
+	} else if ( new_pages > old_pages ) {
+		if ( ( efirc = bs->AllocatePages ( AllocateAddress,
+						   EfiBootServicesData,
+						   ( new_pages - old_pages ),
+						   &phys_addr ) ) != 0 ) {
+			rc = -EEFI ( efirc );
+			return rc;
+		}
+		DBG ( "EFI extended %d pages at %llx\n",
+		      ( new_pages - old_pages ), phys_addr );
+	}
+
+	/* Record new size */
+	*info = new_size;
+
+	return 0;
+}
+
 /**
  * Reallocate external memory
  *
@@ -57,6 +114,12 @@ static void * efi_urealloc ( void *old_ptr, size_t new_size ) {
 	EFI_STATUS efirc;
 	int rc;
 
+	/* Resize existing block in place, if possible */
+	if ( old_ptr && ( old_ptr != NOWHERE ) && new_size &&
+	     ( efi_uresize ( old_ptr, new_size ) == 0 ) ) {
+		return old_ptr;
+	}
+
 	/* Allocate new memory if necessary.  If allocation fails,
 	 * return without touching the old block.
 	 */
@@ -279,38 +279,78 @@ int vmbus_establish_gpadl ( struct vmbus_device *vmdev, void *data,
 	struct vmbus *vmbus = hv->vmbus;
 	physaddr_t addr = virt_to_phys ( data );
 	unsigned int pfn_count = hv_pfn_count ( addr, len );
-	struct {
-		struct vmbus_gpadl_header gpadlhdr;
-		struct vmbus_gpa_range range;
-		uint64_t pfn[pfn_count];
-	} __attribute__ (( packed )) gpadlhdr;
+	uint64_t pfn = ( addr / PAGE_SIZE );
+	union {
+		struct {
+			struct vmbus_gpadl_header gpadlhdr;
+			struct vmbus_gpa_range range;
+			uint64_t pfn[VMBUS_GPADL_HEADER_MAX_PFNS];
+		} __attribute__ (( packed )) hdr;
+		struct {
+			struct vmbus_gpadl_body gpadlbody;
+			uint64_t pfn[VMBUS_GPADL_BODY_MAX_PFNS];
+		} __attribute__ (( packed )) body;
+	} msg;
 	const struct vmbus_gpadl_created *created = &vmbus->message->created;
 	unsigned int gpadl;
+	unsigned int count;
 	unsigned int i;
+	size_t msg_len;
 	int rc;
 
 	/* Allocate GPADL ID */
 	gpadl = ++vmbus_gpadl;
 
-	/* Construct message */
-	memset ( &gpadlhdr, 0, sizeof ( gpadlhdr ) );
-	gpadlhdr.gpadlhdr.header.type = cpu_to_le32 ( VMBUS_GPADL_HEADER );
-	gpadlhdr.gpadlhdr.channel = cpu_to_le32 ( vmdev->channel );
-	gpadlhdr.gpadlhdr.gpadl = cpu_to_le32 ( gpadl );
-	gpadlhdr.gpadlhdr.range_len =
-		cpu_to_le16 ( ( sizeof ( gpadlhdr.range ) +
-				sizeof ( gpadlhdr.pfn ) ) );
-	gpadlhdr.gpadlhdr.range_count = cpu_to_le16 ( 1 );
-	gpadlhdr.range.len = cpu_to_le32 ( len );
-	gpadlhdr.range.offset = cpu_to_le32 ( addr & ( PAGE_SIZE - 1 ) );
-	for ( i = 0 ; i < pfn_count ; i++ )
-		gpadlhdr.pfn[i] = ( ( addr / PAGE_SIZE ) + i );
+	/* Construct "GPADL header" message.  The range descriptor
+	 * describes the whole buffer, but only as many page frame
+	 * numbers as will fit are included in this message.
+	 */
+	count = pfn_count;
+	if ( count > VMBUS_GPADL_HEADER_MAX_PFNS )
+		count = VMBUS_GPADL_HEADER_MAX_PFNS;
+	memset ( &msg, 0, sizeof ( msg ) );
+	msg.hdr.gpadlhdr.header.type = cpu_to_le32 ( VMBUS_GPADL_HEADER );
+	msg.hdr.gpadlhdr.channel = cpu_to_le32 ( vmdev->channel );
+	msg.hdr.gpadlhdr.gpadl = cpu_to_le32 ( gpadl );
+	msg.hdr.gpadlhdr.range_len =
+		cpu_to_le16 ( ( sizeof ( msg.hdr.range ) +
+				( pfn_count * sizeof ( msg.hdr.pfn[0] ) ) ) );
+	msg.hdr.gpadlhdr.range_count = cpu_to_le16 ( 1 );
+	msg.hdr.range.len = cpu_to_le32 ( len );
+	msg.hdr.range.offset = cpu_to_le32 ( addr & ( PAGE_SIZE - 1 ) );
+	for ( i = 0 ; i < count ; i++ )
+		msg.hdr.pfn[i] = pfn++;
+	pfn_count -= count;
 
 	/* Post message */
-	if ( ( rc = vmbus_post_message ( hv, &gpadlhdr.gpadlhdr.header,
-					 sizeof ( gpadlhdr ) ) ) != 0 )
+	msg_len = ( offsetof ( typeof ( msg.hdr ), pfn ) +
+		    ( count * sizeof ( msg.hdr.pfn[0] ) ) );
+	if ( ( rc = vmbus_post_message ( hv, &msg.hdr.gpadlhdr.header,
+					 msg_len ) ) != 0 )
 		return rc;
 
+	/* Post "GPADL body" messages for any remaining page frame
+	 * numbers.  The message number is left as zero, matching the
+	 * behaviour of the Linux driver.
+	 */
+	while ( pfn_count ) {
+		count = pfn_count;
+		if ( count > VMBUS_GPADL_BODY_MAX_PFNS )
+			count = VMBUS_GPADL_BODY_MAX_PFNS;
+		memset ( &msg, 0, sizeof ( msg ) );
+		msg.body.gpadlbody.header.type =
+			cpu_to_le32 ( VMBUS_GPADL_BODY );
+		msg.body.gpadlbody.gpadl = cpu_to_le32 ( gpadl );
+		for ( i = 0 ; i < count ; i++ )
+			msg.body.pfn[i] = pfn++;
+		pfn_count -= count;
+		msg_len = ( offsetof ( typeof ( msg.body ), pfn ) +
+			    ( count * sizeof ( msg.body.pfn[0] ) ) );
+		if ( ( rc = vmbus_post_message ( hv, &msg.body.gpadlbody.header,
+						 msg_len ) ) != 0 )
+			return rc;
+	}
+
 	/* Wait for response */
 	if ( ( rc = vmbus_wait_for_message ( hv, VMBUS_GPADL_CREATED ) ) != 0 )
 		return rc;
@@ -30,6 +30,7 @@
 #include <poll.h>
 #include <sys/ioctl.h>
 #include <sys/mman.h>
+#include <sys/uio.h>
 #include <sys/socket.h>
 #include <sys/time.h>
 #include <sys/stat.h>
@@ -163,6 +164,33 @@ ssize_t __asmcall linux_write ( int fd, const void *buf, size_t count ) {
 	return ret;
 }
 
+/**
+ * Wrap readv()
+ *
+ */
+ssize_t __asmcall linux_readv ( int fd, const struct iovec *iov, int iovcnt ) {
+	ssize_t ret;
+
+	ret = readv ( fd, iov, iovcnt );
+	if ( ret == -1 )
+		linux_errno = errno;
+	return ret;
+}
+
+/**
+ * Wrap writev()
+ *
+ */
+ssize_t __asmcall linux_writev ( int fd, const struct iovec *iov,
+				 int iovcnt ) {
+	ssize_t ret;
+
+	ret = writev ( fd, iov, iovcnt );
+	if ( ret == -1 )
+		linux_errno = errno;
+	return ret;
+}
+
 /**
  * Wrap fcntl()
  *
@@ -528,6 +556,8 @@ PROVIDE_IPXE_SYM ( linux_close );
 PROVIDE_IPXE_SYM ( linux_lseek );
 PROVIDE_IPXE_SYM ( linux_read );
 PROVIDE_IPXE_SYM ( linux_write );
+PROVIDE_IPXE_SYM ( linux_readv );
+PROVIDE_IPXE_SYM ( linux_writev );
 PROVIDE_IPXE_SYM ( linux_fcntl );
 PROVIDE_IPXE_SYM ( linux_ioctl );
 PROVIDE_IPXE_SYM ( linux_fstat_size );
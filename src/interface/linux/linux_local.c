@@ -0,0 +1,287 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+#include <string.h>
+#include <errno.h>
+#include <ipxe/refcnt.h>
+#include <ipxe/malloc.h>
+#include <ipxe/xfer.h>
+#include <ipxe/open.h>
+#include <ipxe/uri.h>
+#include <ipxe/iobuf.h>
+#include <ipxe/process.h>
+#include <ipxe/xferbuf.h>
+#include <ipxe/linux_api.h>
+#include <ipxe/linux.h>
+
+/** @file
+ *
+ * Linux local file access
+ *
+ * Local files are mapped read-only into memory rather than being
+ * read via a series of read() calls.  Where the recipient provides a
+ * data transfer buffer (as is the case when downloading an image),
+ * the whole file is copied directly from the mapping into the
+ * presized buffer; otherwise, the file contents are delivered from
+ * the mapping in blocks.
+ */
+
+/** Delivery blocksize (when no data transfer buffer is available) */
+#define LINUX_LOCAL_BLKSIZE 65536
+
+/** A Linux local file */
+struct linux_local {
+	/** Reference count */
+	struct refcnt refcnt;
+	/** Data transfer interface */
+	struct interface xfer;
+	/** Download process */
+	struct process process;
+
+	/** Download URI */
+	struct uri *uri;
+	/** File path */
+	const char *path;
+
+	/** File descriptor (or negative if not yet open) */
+	int fd;
+	/** File mapping (or NULL if not yet mapped) */
+	const void *data;
+	/** Length of file */
+	size_t len;
+	/** Current offset within file */
+	size_t offset;
+};
+
+/**
+ * Free local file
+ *
+ * @v refcnt		Reference count
+ */
+static void linux_local_free ( struct refcnt *refcnt ) {
+	struct linux_local *local =
+		container_of ( refcnt, struct linux_local, refcnt );
+
+	uri_put ( local->uri );
+	free ( local );
+}
+
+/**
+ * Close local file
+ *
+ * @v local		Local file
+ * @v rc		Reason for close
+ */
+static void linux_local_close ( struct linux_local *local, int rc ) {
+
+	/* Stop process */
+	process_del ( &local->process );
+
+	/* Shut down data transfer interface */
+	intf_shutdown ( &local->xfer, rc );
+
+	/* Unmap file */
+	if ( local->data ) {
+		linux_munmap ( ( ( void * ) local->data ), local->len );
+		local->data = NULL;
+	}
+
+	/* Close file */
+	if ( local->fd >= 0 ) {
+		linux_close ( local->fd );
+		local->fd = -1;
+	}
+}
+
+/**
+ * Open and map local file
+ *
+ * @v local		Local file
+ * @ret rc		Return status code
+ */
+static int linux_local_map ( struct linux_local *local ) {
+	void *data;
+	int rc;
+
+	/* Open file */
+	local->fd = linux_open ( local->path, O_RDONLY );
+	if ( local->fd < 0 ) {
+		rc = -ELINUX ( linux_errno );
+		DBGC ( local, "LOCAL %p could not open %s: %s\n",
+		       local, local->path, linux_strerror ( linux_errno ) );
+		return rc;
+	}
+
+	/* Get file length */
+	if ( linux_fstat_size ( local->fd, &local->len ) != 0 ) {
+		rc = -ELINUX ( linux_errno );
+		DBGC ( local, "LOCAL %p could not get size of %s: %s\n",
+		       local, local->path, linux_strerror ( linux_errno ) );
+		return rc;
+	}
+
+	/* Map file (if non-empty) */
+	if ( local->len ) {
+		data = linux_mmap ( NULL, local->len, PROT_READ, MAP_PRIVATE,
+				    local->fd, 0 );
+		if ( data == MAP_FAILED ) {
+			rc = -ELINUX ( linux_errno );
+			DBGC ( local, "LOCAL %p could not map %s: %s\n",
+			       local, local->path,
+			       linux_strerror ( linux_errno ) );
+			return rc;
+		}
+		local->data = data;
+	}
+	DBGC ( local, "LOCAL %p mapped %s (%#zx bytes)\n",
+	       local, local->path, local->len );
+
+	/* Presize receive buffer */
+	xfer_seek ( &local->xfer, local->len );
+	xfer_seek ( &local->xfer, 0 );
+
+	return 0;
+}
+
+/**
+ * Local file process
+ *
+ * @v local		Local file
+ */
+static void linux_local_step ( struct linux_local *local ) {
+	struct xfer_buffer *xferbuf;
+	struct io_buffer *iobuf;
+	size_t frag_len;
+	int rc;
+
+	/* Wait until data transfer interface is ready */
+	if ( ! xfer_window ( &local->xfer ) )
+		return;
+
+	/* Open and map file, if not yet open */
+	if ( ( local->fd < 0 ) &&
+	     ( ( rc = linux_local_map ( local ) ) != 0 ) )
+		goto err;
+
+	/* Copy directly into data transfer buffer, if available */
+	xferbuf = xfer_buffer ( &local->xfer );
+	if ( xferbuf && ( local->offset == 0 ) ) {
+		if ( ( rc = xferbuf_write ( xferbuf, 0, local->data,
+					    local->len ) ) != 0 ) {
+			DBGC ( local, "LOCAL %p could not write data: %s\n",
+			       local, strerror ( rc ) );
+			goto err;
+		}
+		local->offset = local->len;
+	}
+
+	/* Deliver remaining data in blocks, while window is open */
+	while ( ( local->offset < local->len ) &&
+		xfer_window ( &local->xfer ) ) {
+
+		/* Calculate length for this fragment */
+		frag_len = ( local->len - local->offset );
+		if ( frag_len > LINUX_LOCAL_BLKSIZE )
+			frag_len = LINUX_LOCAL_BLKSIZE;
+
+		/* Allocate I/O buffer */
+		iobuf = xfer_alloc_iob ( &local->xfer, frag_len );
+		if ( ! iobuf ) {
+			rc = -ENOMEM;
+			goto err;
+		}
+		memcpy ( iob_put ( iobuf, frag_len ),
+			 ( local->data + local->offset ), frag_len );
+
+		/* Deliver data */
+		if ( ( rc = xfer_deliver_iob ( &local->xfer, iobuf ) ) != 0 ) {
+			DBGC ( local, "LOCAL %p could not deliver data: %s\n",
+			       local, strerror ( rc ) );
+			goto err;
+		}
+		local->offset += frag_len;
+	}
+
+	/* Close download once all data has been transferred */
+	if ( local->offset == local->len )
+		linux_local_close ( local, 0 );
+
+	return;
+
+ err:
+	linux_local_close ( local, rc );
+}
+
+/** Data transfer interface operations */
+static struct interface_operation linux_local_operations[] = {
+	INTF_OP ( xfer_window_changed, struct linux_local *,
+		  linux_local_step ),
+	INTF_OP ( intf_close, struct linux_local *, linux_local_close ),
+};
+
+/** Data transfer interface descriptor */
+static struct interface_descriptor linux_local_xfer_desc =
+	INTF_DESC ( struct linux_local, xfer, linux_local_operations );
+
+/** Process descriptor */
+static struct process_descriptor linux_local_process_desc =
+	PROC_DESC_ONCE ( struct linux_local, process, linux_local_step );
+
+/**
+ * Open local file
+ *
+ * @v xfer		Data transfer interface
+ * @v uri		Request URI
+ * @ret rc		Return status code
+ */
+static int linux_local_open ( struct interface *xfer, struct uri *uri ) {
+	struct linux_local *local;
+
+	/* Allocate and initialise structure */
+	local = zalloc ( sizeof ( *local ) );
+	if ( ! local )
+		return -ENOMEM;
+	ref_init ( &local->refcnt, linux_local_free );
+	intf_init ( &local->xfer, &linux_local_xfer_desc, &local->refcnt );
+	process_init_stopped ( &local->process, &linux_local_process_desc,
+			       &local->refcnt );
+	local->uri = uri_get ( uri );
+	local->path = ( uri->opaque ? uri->opaque : uri->path );
+	local->fd = -1;
+
+	/* Start download process */
+	process_add ( &local->process );
+
+	/* Attach to parent interface, mortalise self, and return */
+	intf_plug_plug ( &local->xfer, xfer );
+	ref_put ( &local->refcnt );
+	return 0;
+}
+
+/** Linux local file URI opener */
+struct uri_opener linux_local_uri_opener __uri_opener = {
+	.scheme	= "file",
+	.open	= linux_local_open,
+};
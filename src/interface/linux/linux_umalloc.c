@@ -86,7 +86,7 @@ static void * linux_realloc(void *ptr, size_t size)
 	/* Handle deallocation or allocation of size 0 */
 	if (size == 0) {
 		if (mdptr) {
-			if (linux_munmap(mdptr, md.size))
+			if (linux_munmap(mdptr, md.size + SIZE_MD))
 				DBG("linux_realloc munmap failed: %s\n", linux_strerror(linux_errno));
 			VALGRIND_FREELIKE_BLOCK(ptr, sizeof(*mdptr));
 		}
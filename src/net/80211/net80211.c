@@ -91,6 +91,12 @@ struct net80211_probe_ctx {
 
 	/** List of best beacons for each network found so far */
 	struct list_head *beacons;
+
+	/** Network expected to be found first, or NULL */
+	struct net80211_wlan *hint;
+
+	/** Whether the expected network has been found */
+	int hint_found;
 };
 
 /** Context for the association task */
@@ -840,6 +846,7 @@ void net80211_free ( struct net80211_device *dev )
 {
 	free ( dev->hw );
 	rc80211_free ( dev->rctl );
+	net80211_free_wlan ( dev->last );
 	netdev_nullify ( dev->netdev );
 	netdev_put ( dev->netdev );
 }
@@ -1269,6 +1276,80 @@ net80211_marshal_request_info ( struct net80211_device *dev,
 /** Seconds to allow a probe to take if no network has been found */
 #define NET80211_PROBE_TIMEOUT   6
 
+/** Seconds for which the most recently associated network is used as a hint
+ *
+ * A probe for that network's SSID will start on the channel on which
+ * it was last seen, and will finish as soon as its access point is
+ * found there.
+ */
+#define NET80211_PROBE_HINT_AGE  300
+
+/**
+ * Find hint for probe of 802.11 networks
+ *
+ * @v ctx	Probe context
+ * @ret channel	Index of channel on which to start, or negative if none
+ */
+static int net80211_probe_hint ( struct net80211_probe_ctx *ctx )
+{
+	struct net80211_device *dev = ctx->dev;
+	struct net80211_wlan *last = dev->last;
+	unsigned long age = ( NET80211_PROBE_HINT_AGE * TICKS_PER_SEC );
+	int i;
+
+	/* Use only a recently associated network with the same SSID */
+	if ( ! ( last && ctx->essid[0] &&
+		 ( strcmp ( ctx->essid, last->essid ) == 0 ) &&
+		 ( ( currticks() - dev->last_ticks ) < age ) ) )
+		return -1;
+
+	/* Find the channel on which it was last seen */
+	for ( i = 0; i < dev->nr_channels; i++ ) {
+		if ( dev->channels[i].channel_nr == last->channel ) {
+			DBGC ( dev, "802.11 %p probe: trying %s (%s) on "
+			       "channel %d first\n", dev, last->essid,
+			       eth_ntoa ( last->bssid ), last->channel );
+			ctx->hint = last;
+			return i;
+		}
+	}
+
+	return -1;
+}
+
+/**
+ * Send active probe request
+ *
+ * @v ctx	Probe context
+ * @v dest	Destination address
+ * @ret rc	Return status code
+ */
+static int net80211_probe_send ( struct net80211_probe_ctx *ctx,
+				 u8 *dest )
+{
+	struct net80211_device *dev = ctx->dev;
+	struct io_buffer *siob = ctx->probe; /* to send */
+	struct io_buffer *iob;
+	int rc;
+
+	/* make a copy for future use */
+	iob = alloc_iob ( siob->tail - siob->head );
+	iob_reserve ( iob, iob_headroom ( siob ) );
+	memcpy ( iob_put ( iob, iob_len ( siob ) ),
+		 siob->data, iob_len ( siob ) );
+
+	ctx->probe = iob;
+	rc = net80211_tx_mgmt ( dev, IEEE80211_STYPE_PROBE_REQ, dest,
+				iob_disown ( siob ) );
+	if ( rc ) {
+		DBGC ( dev, "802.11 %p send probe failed: %s\n",
+		       dev, strerror ( rc ) );
+		return rc;
+	}
+
+	return 0;
+}
+
 /**
  * Begin probe of 802.11 networks
  *
@@ -1293,6 +1374,7 @@ struct net80211_probe_ctx * net80211_probe_start ( struct net80211_device *dev,
 						   int active )
 {
 	struct net80211_probe_ctx *ctx = zalloc ( sizeof ( *ctx ) );
+	int channel;
 
 	if ( ! ctx )
 		return NULL;
@@ -1338,9 +1420,19 @@ struct net80211_probe_ctx * net80211_probe_start ( struct net80211_device *dev,
 	ctx->beacons = malloc ( sizeof ( *ctx->beacons ) );
 	INIT_LIST_HEAD ( ctx->beacons );
 
-	dev->channel = 0;
+	channel = net80211_probe_hint ( ctx );
+	dev->channel = ( ( channel >= 0 ) ? channel : 0 );
 	dev->op->config ( dev, NET80211_CFG_CHANNEL );
 
+	/* Probe directly for the expected access point, if any.
+	 * Failure is not fatal, since we will fall back to a full
+	 * scan.
+	 */
+	if ( ctx->hint && ctx->probe ) {
+		udelay ( dev->hw->channel_change_time );
+		net80211_probe_send ( ctx, ctx->hint->bssid );
+	}
+
 	return ctx;
 }
 
@@ -1375,6 +1467,10 @@ int net80211_probe_step ( struct net80211_probe_ctx *ctx )
 	gather_timeout *= ( ctx->essid[0] ? NET80211_PROBE_GATHER :
 			    NET80211_PROBE_GATHER_ALL );
 
+	/* Finish immediately if we have found the expected network */
+	if ( ctx->hint_found )
+		return +1;
+
 	/* Time out if necessary */
 	if ( now >= ctx->ticks_start + start_timeout )
 		return list_empty ( ctx->beacons ) ? -ETIMEDOUT : +1;
@@ -1391,25 +1487,10 @@ int net80211_probe_step ( struct net80211_probe_ctx *ctx )
 
 		ctx->ticks_channel = now;
 
-		if ( ctx->probe ) {
-			struct io_buffer *siob = ctx->probe; /* to send */
-
-			/* make a copy for future use */
-			iob = alloc_iob ( siob->tail - siob->head );
-			iob_reserve ( iob, iob_headroom ( siob ) );
-			memcpy ( iob_put ( iob, iob_len ( siob ) ),
-				 siob->data, iob_len ( siob ) );
-
-			ctx->probe = iob;
-			rc = net80211_tx_mgmt ( dev, IEEE80211_STYPE_PROBE_REQ,
-						eth_broadcast,
-						iob_disown ( siob ) );
-			if ( rc ) {
-				DBGC ( dev, "802.11 %p send probe failed: "
-				       "%s\n", dev, strerror ( rc ) );
-				return rc;
-			}
-		}
+		if ( ctx->probe &&
+		     ( ( rc = net80211_probe_send ( ctx,
+						    eth_broadcast ) ) != 0 ) )
+			return rc;
 	}
 
 	/* Check for new management packets */
@@ -1520,6 +1601,10 @@ int net80211_probe_step ( struct net80211_probe_ctx *ctx )
 
 		ctx->ticks_beacon = now;
 
+		if ( ctx->hint && ( memcmp ( wlan->bssid, ctx->hint->bssid,
+					     ETH_ALEN ) == 0 ) )
+			ctx->hint_found = 1;
+
 		DBGC2 ( dev, "802.11 %p probe: good beacon for %s (%s)\n",
 			dev, wlan->essid, eth_ntoa ( wlan->bssid ) );
 
@@ -1841,7 +1926,12 @@ static void net80211_step_associate ( struct net80211_device *dev )
 	free ( dev->ctx.assoc );
 	dev->ctx.assoc = NULL;
 
-	net80211_free_wlan ( dev->associating );
+	/* Remember this network to speed up any reassociation */
+	free_iob ( dev->associating->beacon );
+	dev->associating->beacon = NULL;
+	net80211_free_wlan ( dev->last );
+	dev->last = dev->associating;
+	dev->last_ticks = currticks();
 	dev->associating = NULL;
 
 	dev->rctl = rc80211_init ( dev );
@@ -1871,6 +1961,11 @@ static void net80211_step_associate ( struct net80211_device *dev )
 	net80211_free_wlan ( dev->associating );
 	dev->associating = NULL;
 
+	/* Forget the most recent network, so that the next attempt
+	   performs a full scan */
+	net80211_free_wlan ( dev->last );
+	dev->last = NULL;
+
 	process_del ( &dev->proc_assoc );
 
 	DBGC ( dev, "802.11 %p association failed (state=%04x): "
@@ -31,6 +31,26 @@ FILE_SECBOOT ( FORBIDDEN );
  * Frontend for WPA using a pre-shared key.
  */
 
+/** A cached WPA-PSK pairwise master key */
+struct wpa_psk_cache {
+	/** SSID from which key was derived */
+	char essid[IEEE80211_MAX_SSID_LEN + 1];
+	/** Passphrase from which key was derived */
+	char passphrase[64 + 1];
+	/** Pairwise master key */
+	u8 pmk[WPA_PMK_LEN];
+};
+
+/**
+ * Most recently derived pairwise master key
+ *
+ * Deriving the PMK requires 4096 iterations of PBKDF2-HMAC-SHA1,
+ * which is slow enough on some machines to cause association
+ * timeouts.  Since the PMK depends only upon the SSID and the
+ * passphrase, we retain the most recent result for reassociations.
+ */
+static struct wpa_psk_cache wpa_psk_cache;
+
 /**
  * Initialise WPA-PSK state
  *
@@ -65,12 +85,28 @@ static int wpa_psk_start ( struct net80211_device *dev )
 		return -EACCES;
 	}
 
-	pbkdf2_sha1 ( passphrase, len, dev->essid, strlen ( dev->essid ),
-		      4096, pmk, WPA_PMK_LEN );
+	if ( ( strcmp ( dev->essid, wpa_psk_cache.essid ) != 0 ) ||
+	     ( strcmp ( passphrase, wpa_psk_cache.passphrase ) != 0 ) ) {
+
+		pbkdf2_sha1 ( passphrase, len, dev->essid,
+			      strlen ( dev->essid ), 4096, pmk, WPA_PMK_LEN );
+
+		DBGC ( ctx, "WPA-PSK %p: derived PMK from passphrase `%s':\n",
+		       ctx, passphrase );
+		DBGC_HD ( ctx, pmk, WPA_PMK_LEN );
 
-	DBGC ( ctx, "WPA-PSK %p: derived PMK from passphrase `%s':\n", ctx,
-	       passphrase );
-	DBGC_HD ( ctx, pmk, WPA_PMK_LEN );
+		memcpy ( wpa_psk_cache.essid, dev->essid,
+			 sizeof ( wpa_psk_cache.essid ) );
+		memcpy ( wpa_psk_cache.passphrase, passphrase,
+			 sizeof ( wpa_psk_cache.passphrase ) );
+		memcpy ( wpa_psk_cache.pmk, pmk, sizeof ( wpa_psk_cache.pmk ) );
+
+	} else {
+
+		memcpy ( pmk, wpa_psk_cache.pmk, sizeof ( pmk ) );
+		DBGC ( ctx, "WPA-PSK %p: using cached PMK for `%s'\n",
+		       ctx, dev->essid );
+	}
 
 	return wpa_start ( dev, ctx, pmk, WPA_PMK_LEN );
 }
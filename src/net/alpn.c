@@ -0,0 +1,92 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+FILE_SECBOOT ( PERMITTED );
+
+#include <stddef.h>
+#include <ipxe/interface.h>
+#include <ipxe/alpn.h>
+
+/** @file
+ *
+ * Application-layer protocol negotiation
+ *
+ * A secure transport layer (such as TLS) may ask the application
+ * layer above it which protocols it is prepared to speak, and the
+ * application layer may subsequently ask the transport layer which
+ * protocol (if any) was selected by the server.
+ *
+ */
+
+/**
+ * Get offered application protocols
+ *
+ * @v intf		Interface (towards the application layer)
+ * @ret protocols	Offered protocols in wire format, or NULL
+ *
+ * The list of protocols is in the wire format defined by RFC 7301:
+ * each protocol name is preceded by a single length byte.  The list
+ * is terminated by a NUL.
+ */
+const char * alpn_offer ( struct interface *intf ) {
+	struct interface *dest;
+	alpn_offer_TYPE ( void * ) *op =
+		intf_get_dest_op ( intf, alpn_offer, &dest );
+	void *object = intf_object ( dest );
+	const char *protocols;
+
+	if ( op ) {
+		protocols = op ( object );
+	} else {
+		/* Default is to offer no protocols */
+		protocols = NULL;
+	}
+
+	intf_put ( dest );
+	return protocols;
+}
+
+/**
+ * Get negotiated application protocol
+ *
+ * @v intf		Interface (towards the transport layer)
+ * @ret protocol	Negotiated protocol name, or NULL
+ */
+const char * alpn_protocol ( struct interface *intf ) {
+	struct interface *dest;
+	alpn_protocol_TYPE ( void * ) *op =
+		intf_get_dest_op ( intf, alpn_protocol, &dest );
+	void *object = intf_object ( dest );
+	const char *protocol;
+
+	if ( op ) {
+		protocol = op ( object );
+	} else {
+		/* Default is that no protocol was negotiated */
+		protocol = NULL;
+	}
+
+	intf_put ( dest );
+	return protocol;
+}
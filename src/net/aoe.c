@@ -215,11 +215,17 @@ static void aoecmd_close ( struct aoe_command *aoecmd, int rc ) {
 	if ( ! list_empty ( &aoecmd->list ) ) {
 		list_del ( &aoecmd->list );
 		INIT_LIST_HEAD ( &aoecmd->list );
+		assert ( aoedev->count > 0 );
+		aoedev->count--;
 		aoecmd_put ( aoecmd );
 	}
 
 	/* Shut down interfaces */
 	intf_shutdown ( &aoecmd->ata, rc );
+
+	/* Notify parent that a command slot may have become available */
+	if ( aoedev->configured )
+		xfer_window_changed ( &aoedev->ata );
 }
 
 /**
@@ -524,6 +530,21 @@ static int aoecmd_cfg_rsp ( struct aoe_command *aoecmd, const void *data,
 	       aoedev_name ( aoedev ), aoecmd->tag, ntohs ( aoecfg->bufcnt ),
 	       aoecfg->fwver, aoecfg->scnt );
 
+	/* Limit sectors per command to the count supported by the
+	 * target (which may have a smaller MTU than our own).
+	 */
+	if ( aoecfg->scnt && ( aoecfg->scnt < aoedev->max_count ) )
+		aoedev->max_count = aoecfg->scnt;
+
+	/* Allow as many outstanding commands as the target can buffer */
+	aoedev->depth = ntohs ( aoecfg->bufcnt );
+	if ( aoedev->depth > AOE_MAX_DEPTH )
+		aoedev->depth = AOE_MAX_DEPTH;
+	if ( ! aoedev->depth )
+		aoedev->depth = 1;
+	DBGC ( aoedev, "AoE %s using %d sectors per command and depth %d\n",
+	       aoedev_name ( aoedev ), aoedev->max_count, aoedev->depth );
+
 	/* Record target MAC address */
 	memcpy ( aoedev->target, ll_source, ll_protocol->ll_addr_len );
 	DBGC ( aoedev, "AoE %s has MAC address %s\n",
@@ -604,6 +625,7 @@ static struct aoe_command * aoecmd_create ( struct aoe_device *aoedev,
 		return NULL;
 	ref_init ( &aoecmd->refcnt, aoecmd_free );
 	list_add ( &aoecmd->list, &aoe_commands );
+	aoedev->count++;
 	intf_init ( &aoecmd->ata, &aoecmd_ata_desc, &aoecmd->refcnt );
 	timer_init ( &aoecmd->timer, aoecmd_expired, &aoecmd->refcnt );
 	aoecmd->aoedev = aoedev_get ( aoedev );
@@ -728,7 +750,15 @@ static void aoedev_close ( struct aoe_device *aoedev, int rc ) {
  * @ret len		Length of window
  */
 static size_t aoedev_window ( struct aoe_device *aoedev ) {
-	return ( aoedev->configured ? ~( ( size_t ) 0 ) : 0 );
+
+	/* Commands cannot be issued before configuration is complete */
+	if ( ! aoedev->configured )
+		return 0;
+
+	/* Limit number of outstanding commands */
+	if ( aoedev->count >= aoedev->depth )
+		return 0;
+	return ( aoedev->depth - aoedev->count );
 }
 
 /**
@@ -738,19 +768,38 @@ static size_t aoedev_window ( struct aoe_device *aoedev ) {
  * @v rc		Reason for completion
  */
 static void aoedev_config_done ( struct aoe_device *aoedev, int rc ) {
+	struct interface *parent;
 
 	/* Shut down interface */
 	intf_shutdown ( &aoedev->config, rc );
 
 	/* Close device on failure */
+	if ( rc != 0 )
+		goto err_config;
+
+	/* Attach ATA device between parent interface and AoE device.
+	 * This is deferred until configuration is complete, since
+	 * the maximum number of sectors per command depends upon the
+	 * configuration response.
+	 */
+	parent = intf_get ( aoedev->ata.dest );
+	rc = ata_open ( parent, &aoedev->ata, ATA_DEV_MASTER,
+			aoedev->max_count );
+	intf_put ( parent );
 	if ( rc != 0 ) {
-		aoedev_close ( aoedev, rc );
-		return;
+		DBGC ( aoedev, "AoE %s could not create ATA device: %s\n",
+		       aoedev_name ( aoedev ), strerror ( rc ) );
+		goto err_ata_open;
 	}
 
 	/* Mark device as configured */
 	aoedev->configured = 1;
 	xfer_window_changed ( &aoedev->ata );
+	return;
+
+ err_ata_open:
+ err_config:
+	aoedev_close ( aoedev, rc );
 }
 
 /**
@@ -797,6 +846,28 @@ static struct interface_operation aoedev_config_op[] = {
 static struct interface_descriptor aoedev_config_desc =
 	INTF_DESC ( struct aoe_device, config, aoedev_config_op );
 
+/**
+ * Calculate maximum number of sectors per command
+ *
+ * @v netdev		Network device
+ * @ret max_count	Maximum number of sectors per command
+ */
+static unsigned int aoedev_max_count ( struct net_device *netdev ) {
+	size_t overhead = ( sizeof ( struct aoehdr ) +
+			    sizeof ( struct aoeata ) );
+	unsigned int max_count;
+
+	/* Fit as many sectors as possible within a single frame */
+	max_count = ( ( netdev->mtu > overhead ) ?
+		      ( ( netdev->mtu - overhead ) / ATA_SECTOR_SIZE ) : 0 );
+	if ( max_count > AOE_MAX_COUNT )
+		max_count = AOE_MAX_COUNT;
+	if ( ! max_count )
+		max_count = 1;
+
+	return max_count;
+}
+
 /**
  * Open AoE device
  *
@@ -825,6 +896,8 @@ static int aoedev_open ( struct interface *parent, struct net_device *netdev,
 	aoedev->minor = minor;
 	memcpy ( aoedev->target, netdev->ll_broadcast,
 		 netdev->ll_protocol->ll_addr_len );
+	aoedev->max_count = aoedev_max_count ( netdev );
+	aoedev->depth = 1;
 	acpi_init ( &aoedev->desc, &abft_model, &aoedev->refcnt );
 
 	/* Initiate configuration */
@@ -834,19 +907,15 @@ static int aoedev_open ( struct interface *parent, struct net_device *netdev,
 		goto err_config;
 	}
 
-	/* Attach ATA device to parent interface */
-	if ( ( rc = ata_open ( parent, &aoedev->ata, ATA_DEV_MASTER,
-			       AOE_MAX_COUNT ) ) != 0 ) {
-		DBGC ( aoedev, "AoE %s could not create ATA device: %s\n",
-		       aoedev_name ( aoedev ), strerror ( rc ) );
-		goto err_ata_open;
-	}
+	/* Attach to parent interface.  The ATA device will be
+	 * inserted once configuration is complete.
+	 */
+	intf_plug_plug ( &aoedev->ata, parent );
 
 	/* Mortalise self and return */
 	ref_put ( &aoedev->refcnt );
 	return 0;
 
- err_ata_open:
  err_config:
 	aoedev_close ( aoedev, rc );
 	ref_put ( &aoedev->refcnt );
@@ -0,0 +1,598 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+FILE_SECBOOT ( PERMITTED );
+
+#include <stdint.h>
+#include <string.h>
+#include <stdio.h>
+#include <errno.h>
+#include <byteswap.h>
+#include <ipxe/if_ether.h>
+#include <ipxe/ethernet.h>
+#include <ipxe/netdevice.h>
+#include <ipxe/iobuf.h>
+#include <ipxe/in.h>
+#include <ipxe/ip.h>
+#include <ipxe/ipv6.h>
+#include <ipxe/bond.h>
+
+/** @file
+ *
+ * Link aggregation (bonding) devices
+ *
+ * A bonding device aggregates several Ethernet member devices into a
+ * single network device.  All member devices use the bonding
+ * device's link-layer address, so that the LACP responder (which
+ * identifies the system by link-layer address) presents all members
+ * as ports of the same system, allowing the switch to aggregate them
+ * into a single link.
+ *
+ * Transmitted packets are distributed across all usable members by
+ * hashing the network- and transport-layer addresses, so that each
+ * flow is carried by a single member.  Packets received on any
+ * member are delivered via the bonding device, with the exception
+ * of slow protocol packets (such as LACP) which are delivered via
+ * the member on which they were received.
+ */
+
+/** Bonding device private data */
+struct bond_device {
+	/** Number of member devices */
+	unsigned int count;
+	/** Member network devices */
+	struct net_device *member[0];
+};
+
+/**
+ * Restore member device link-layer address
+ *
+ * @v member		Member network device
+ */
+static void bond_restore ( struct net_device *member ) {
+
+	netdev_rx_unfreeze ( member );
+	netdev_close ( member );
+	member->ll_protocol->init_addr ( member->hw_addr, member->ll_addr );
+}
+
+/**
+ * Open bonding device
+ *
+ * @v netdev		Network device
+ * @ret rc		Return status code
+ */
+static int bond_open ( struct net_device *netdev ) {
+	struct bond_device *bond = netdev->priv;
+	struct net_device *member;
+	unsigned int i;
+	int rc;
+
+	/* Open member devices using the bonding device's address */
+	netdev->tx_offloads = ~0U;
+	for ( i = 0 ; i < bond->count ; i++ ) {
+		member = bond->member[i];
+		if ( memcmp ( member->ll_addr, netdev->ll_addr,
+			      ETH_ALEN ) != 0 ) {
+			netdev_close ( member );
+			memcpy ( member->ll_addr, netdev->ll_addr, ETH_ALEN );
+		}
+		if ( ( rc = netdev_open ( member ) ) != 0 ) {
+			DBGC ( netdev, "BOND %s could not open %s: %s\n",
+			       netdev->name, member->name, strerror ( rc ) );
+			goto err_open;
+		}
+		netdev_rx_freeze ( member );
+		netdev->tx_offloads &= member->tx_offloads;
+	}
+
+	return 0;
+
+ err_open:
+	bond_restore ( member );
+	while ( i-- )
+		bond_restore ( bond->member[i] );
+	return rc;
+}
+
+/**
+ * Close bonding device
+ *
+ * @v netdev		Network device
+ */
+static void bond_close ( struct net_device *netdev ) {
+	struct bond_device *bond = netdev->priv;
+	unsigned int i;
+
+	/* Close member devices and restore their addresses */
+	for ( i = 0 ; i < bond->count ; i++ )
+		bond_restore ( bond->member[i] );
+}
+
+/**
+ * Accumulate flow hash
+ *
+ * @v hash		Flow hash
+ * @v data		Data
+ * @v len		Length of data
+ * @ret hash		Updated flow hash
+ */
+static uint32_t bond_hash_data ( uint32_t hash, const void *data,
+				 size_t len ) {
+	const uint8_t *byte = data;
+
+	while ( len-- )
+		hash = ( ( hash << 5 ) + hash + *(byte++) );
+	return hash;
+}
+
+/**
+ * Calculate flow hash for a transmitted packet
+ *
+ * @v iobuf		I/O buffer
+ * @ret hash		Flow hash
+ */
+static uint32_t bond_hash ( struct io_buffer *iobuf ) {
+	const struct ethhdr *ethhdr = iobuf->data;
+	const struct iphdr *iphdr;
+	const struct ipv6_header *ip6hdr;
+	const void *data;
+	size_t len = iob_len ( iobuf );
+	size_t hdrlen;
+	unsigned int proto = 0;
+	uint32_t hash = 0;
+
+	/* Hash destination link-layer address */
+	if ( len < sizeof ( *ethhdr ) )
+		return 0;
+	hash = bond_hash_data ( hash, ethhdr->h_dest,
+				sizeof ( ethhdr->h_dest ) );
+	data = ( iobuf->data + sizeof ( *ethhdr ) );
+	len -= sizeof ( *ethhdr );
+
+	/* Hash network-layer addresses */
+	switch ( ethhdr->h_protocol ) {
+	case htons ( ETH_P_IP ) :
+		iphdr = data;
+		if ( len < sizeof ( *iphdr ) )
+			break;
+		hash = bond_hash_data ( hash, &iphdr->src,
+					sizeof ( iphdr->src ) );
+		hash = bond_hash_data ( hash, &iphdr->dest,
+					sizeof ( iphdr->dest ) );
+		hdrlen = ( ( iphdr->verhdrlen & IP_MASK_HLEN ) * 4 );
+		if ( ( hdrlen > len ) ||
+		     ( iphdr->frags & htons ( IP_MASK_OFFSET |
+					      IP_MASK_MOREFRAGS ) ) ) {
+			break;
+		}
+		proto = iphdr->protocol;
+		data += hdrlen;
+		len -= hdrlen;
+		break;
+	case htons ( ETH_P_IPV6 ) :
+		ip6hdr = data;
+		if ( len < sizeof ( *ip6hdr ) )
+			break;
+		hash = bond_hash_data ( hash, &ip6hdr->src,
+					sizeof ( ip6hdr->src ) );
+		hash = bond_hash_data ( hash, &ip6hdr->dest,
+					sizeof ( ip6hdr->dest ) );
+		proto = ip6hdr->next_header;
+		data += sizeof ( *ip6hdr );
+		len -= sizeof ( *ip6hdr );
+		break;
+	default:
+		break;
+	}
+
+	/* Hash transport-layer ports, if applicable */
+	if ( ( ( proto == IP_TCP ) || ( proto == IP_UDP ) ) &&
+	     ( len >= ( 2 * sizeof ( uint16_t ) ) ) ) {
+		hash = bond_hash_data ( hash, data,
+					( 2 * sizeof ( uint16_t ) ) );
+	}
+
+	/* Fold hash */
+	hash ^= ( hash >> 16 );
+	hash ^= ( hash >> 8 );
+
+	return hash;
+}
+
+/**
+ * Check if member device is usable for transmission
+ *
+ * @v member		Member network device
+ * @v lacp		Require member not to be blocked by LACP
+ * @ret usable		Member device is usable
+ */
+static int bond_usable ( struct net_device *member, int lacp ) {
+
+	return ( netdev_is_open ( member ) && netdev_link_ok ( member ) &&
+		 ( ! ( lacp && netdev_link_blocked ( member ) ) ) );
+}
+
+/**
+ * Choose member device for transmission
+ *
+ * @v netdev		Network device
+ * @v hash		Flow hash
+ * @ret member		Member network device, or NULL
+ */
+static struct net_device * bond_choose ( struct net_device *netdev,
+					 uint32_t hash ) {
+	struct bond_device *bond = netdev->priv;
+	struct net_device *member;
+	unsigned int count;
+	unsigned int i;
+	int lacp;
+
+	/* Use members that are not blocked by LACP, if any.  Fall
+	 * back to using any member with link up, to allow for
+	 * partners that do not use LACP.
+	 */
+	for ( lacp = 1 ; lacp >= 0 ; lacp-- ) {
+
+		/* Count usable members */
+		count = 0;
+		for ( i = 0 ; i < bond->count ; i++ ) {
+			if ( bond_usable ( bond->member[i], lacp ) )
+				count++;
+		}
+		if ( ! count )
+			continue;
+
+		/* Select usable member according to flow hash */
+		hash %= count;
+		for ( i = 0 ; i < bond->count ; i++ ) {
+			member = bond->member[i];
+			if ( ! bond_usable ( member, lacp ) )
+				continue;
+			if ( hash-- == 0 )
+				return member;
+		}
+	}
+
+	return NULL;
+}
+
+/**
+ * Transmit packet on bonding device
+ *
+ * @v netdev		Network device
+ * @v iobuf		I/O buffer
+ * @ret rc		Return status code
+ */
+static int bond_transmit ( struct net_device *netdev,
+			   struct io_buffer *iobuf ) {
+	struct net_device *member;
+
+	/* Choose member device */
+	member = bond_choose ( netdev, bond_hash ( iobuf ) );
+	if ( ! member ) {
+		DBGC2 ( netdev, "BOND %s has no usable members\n",
+			netdev->name );
+		return -ENETUNREACH;
+	}
+
+	/* Reclaim I/O buffer from bonding device's TX queue */
+	list_del ( &iobuf->list );
+
+	/* Transmit packet on member device.  We cannot return an
+	 * error status, since that would cause the I/O buffer to be
+	 * double-freed.
+	 */
+	netdev_tx ( member, iob_disown ( iobuf ) );
+
+	return 0;
+}
+
+/**
+ * Receive packet from member device
+ *
+ * @v netdev		Network device
+ * @v member		Member network device
+ * @v iobuf		I/O buffer
+ */
+static void bond_rx ( struct net_device *netdev, struct net_device *member,
+		      struct io_buffer *iobuf ) {
+	struct ethhdr *ethhdr = iobuf->data;
+	struct ll_protocol *ll_protocol = member->ll_protocol;
+	const void *ll_dest;
+	const void *ll_source;
+	uint16_t net_proto;
+	unsigned int flags;
+	int rc;
+
+	/* Deliver all packets other than slow protocol packets via
+	 * the bonding device.
+	 */
+	if ( ( iob_len ( iobuf ) < sizeof ( *ethhdr ) ) ||
+	     ( ethhdr->h_protocol != htons ( ETH_P_SLOW ) ) ) {
+		netdev_rx ( netdev, iobuf );
+		return;
+	}
+
+	/* Deliver slow protocol packets via the member device */
+	if ( ( rc = ll_protocol->pull ( member, iobuf, &ll_dest, &ll_source,
+					&net_proto, &flags ) ) != 0 ) {
+		netdev_rx_err ( member, iobuf, rc );
+		return;
+	}
+	if ( ( rc = net_rx ( iobuf, member, net_proto, ll_dest, ll_source,
+			     flags ) ) != 0 ) {
+		netdev_rx_err ( member, NULL, rc );
+		return;
+	}
+}
+
+/**
+ * Poll bonding device
+ *
+ * @v netdev		Network device
+ */
+static void bond_poll ( struct net_device *netdev ) {
+	struct bond_device *bond = netdev->priv;
+	struct net_device *member;
+	struct io_buffer *iobuf;
+	unsigned int i;
+
+	/* Poll member devices and collect received packets */
+	for ( i = 0 ; i < bond->count ; i++ ) {
+		member = bond->member[i];
+		netdev_poll ( member );
+		while ( ( iobuf = netdev_rx_dequeue ( member ) ) != NULL )
+			bond_rx ( netdev, member, iobuf );
+	}
+}
+
+/**
+ * Enable/disable interrupts on bonding device
+ *
+ * @v netdev		Network device
+ * @v enable		Interrupts should be enabled
+ */
+static void bond_irq ( struct net_device *netdev, int enable ) {
+	struct bond_device *bond = netdev->priv;
+	unsigned int i;
+
+	for ( i = 0 ; i < bond->count ; i++ )
+		netdev_irq ( bond->member[i], enable );
+}
+
+/** Bonding device operations */
+static struct net_device_operations bond_operations = {
+	.open		= bond_open,
+	.close		= bond_close,
+	.transmit	= bond_transmit,
+	.poll		= bond_poll,
+	.irq		= bond_irq,
+};
+
+/**
+ * Synchronise bonding device link state
+ *
+ * @v netdev		Network device
+ */
+static void bond_sync ( struct net_device *netdev ) {
+	struct bond_device *bond = netdev->priv;
+	unsigned int i;
+	int rc = -ENOTCONN;
+
+	/* Link is up if any member link is up */
+	for ( i = 0 ; i < bond->count ; i++ ) {
+		rc = bond->member[i]->link_rc;
+		if ( rc == 0 )
+			break;
+	}
+	if ( netdev->link_rc != rc )
+		netdev_link_err ( netdev, rc );
+}
+
+/**
+ * Identify bonding device
+ *
+ * @v member		Member network device
+ * @ret netdev		Bonding device, if any
+ */
+struct net_device * bond_find ( struct net_device *member ) {
+	struct net_device *netdev;
+	struct bond_device *bond;
+	unsigned int i;
+
+	for_each_netdev ( netdev ) {
+		if ( netdev->op != &bond_operations )
+			continue;
+		bond = netdev->priv;
+		for ( i = 0 ; i < bond->count ; i++ ) {
+			if ( bond->member[i] == member )
+				return netdev;
+		}
+	}
+	return NULL;
+}
+
+/**
+ * Create bonding device
+ *
+ * @v members		Member network devices
+ * @v count		Number of member network devices
+ * @ret rc		Return status code
+ */
+int bond_create ( struct net_device **members, unsigned int count ) {
+	struct net_device *netdev;
+	struct net_device *member;
+	struct bond_device *bond;
+	unsigned int index;
+	unsigned int i;
+	unsigned int j;
+	int rc;
+
+	/* Allocate and initialise structure */
+	netdev = alloc_etherdev ( sizeof ( *bond ) +
+				  ( count * sizeof ( bond->member[0] ) ) );
+	if ( ! netdev ) {
+		rc = -ENOMEM;
+		goto err_alloc_etherdev;
+	}
+	netdev_init ( netdev, &bond_operations );
+	bond = netdev->priv;
+
+	/* Sanity checks */
+	if ( ! count ) {
+		rc = -EINVAL;
+		goto err_sanity;
+	}
+	for ( i = 0 ; i < count ; i++ ) {
+		member = members[i];
+		if ( ( member->ll_protocol != netdev->ll_protocol ) ||
+		     ( member->op == &bond_operations ) ) {
+			DBGC ( member, "BOND cannot use %s as a member\n",
+			       member->name );
+			rc = -ENOTTY;
+			goto err_sanity;
+		}
+		if ( bond_find ( member ) ) {
+			DBGC ( member, "BOND %s is already a member\n",
+			       member->name );
+			rc = -EBUSY;
+			goto err_sanity;
+		}
+		for ( j = 0 ; j < i ; j++ ) {
+			if ( members[j] == member ) {
+				rc = -EINVAL;
+				goto err_sanity;
+			}
+		}
+	}
+
+	/* Record member devices */
+	netdev->dev = members[0]->dev;
+	memcpy ( netdev->hw_addr, members[0]->ll_addr, ETH_ALEN );
+	bond->count = count;
+	for ( i = 0 ; i < count ; i++ ) {
+		member = members[i];
+		bond->member[i] = netdev_get ( member );
+
+		/* Mark device as not supporting interrupts, if applicable */
+		if ( ! netdev_irq_supported ( member ) )
+			netdev->state |= NETDEV_IRQ_UNSUPPORTED;
+	}
+
+	/* Construct bonding device name */
+	for ( index = 0 ; ; index++ ) {
+		snprintf ( netdev->name, sizeof ( netdev->name ), "bond%d",
+			   index );
+		if ( ! find_netdev ( netdev->name ) )
+			break;
+	}
+
+	/* Register bonding device */
+	if ( ( rc = register_netdev ( netdev ) ) != 0 ) {
+		DBGC ( netdev, "BOND %s could not register: %s\n",
+		       netdev->name, strerror ( rc ) );
+		goto err_register;
+	}
+
+	/* Synchronise with member devices */
+	bond_sync ( netdev );
+
+	DBGC ( netdev, "BOND %s created with %d members\n",
+	       netdev->name, bond->count );
+
+	return 0;
+
+	unregister_netdev ( netdev );
+ err_register:
+	for ( i = 0 ; i < bond->count ; i++ )
+		netdev_put ( bond->member[i] );
+ err_sanity:
+	netdev_nullify ( netdev );
+	netdev_put ( netdev );
+ err_alloc_etherdev:
+	return rc;
+}
+
+/**
+ * Destroy bonding device
+ *
+ * @v netdev		Network device
+ * @ret rc		Return status code
+ */
+int bond_destroy ( struct net_device *netdev ) {
+	struct bond_device *bond = netdev->priv;
+	unsigned int i;
+
+	/* Sanity check */
+	if ( netdev->op != &bond_operations ) {
+		DBGC ( netdev, "BOND %s cannot destroy non-bonding device\n",
+		       netdev->name );
+		return -ENOTTY;
+	}
+
+	DBGC ( netdev, "BOND %s destroyed\n", netdev->name );
+
+	/* Remove bonding device */
+	unregister_netdev ( netdev );
+	for ( i = 0 ; i < bond->count ; i++ )
+		netdev_put ( bond->member[i] );
+	netdev_nullify ( netdev );
+	netdev_put ( netdev );
+
+	return 0;
+}
+
+/**
+ * Handle member network device state change
+ *
+ * @v member		Member network device
+ * @v priv		Private data
+ */
+static void bond_notify ( struct net_device *member, void *priv __unused ) {
+	struct net_device *netdev;
+
+	if ( ( netdev = bond_find ( member ) ) != NULL )
+		bond_sync ( netdev );
+}
+
+/**
+ * Destroy bonding device for a removed member device
+ *
+ * @v member		Member network device
+ * @v priv		Private data
+ */
+static void bond_remove ( struct net_device *member, void *priv __unused ) {
+	struct net_device *netdev;
+
+	if ( ( netdev = bond_find ( member ) ) != NULL )
+		bond_destroy ( netdev );
+}
+
+/** Bonding driver */
+struct net_driver bond_driver __net_driver = {
+	.name = "BOND",
+	.notify = bond_notify,
+	.remove = bond_remove,
+};
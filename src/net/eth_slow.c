@@ -39,12 +39,15 @@ FILE_SECBOOT ( PERMITTED );
  *
  * Ethernet slow protocols
  *
- * We implement a very simple passive LACP entity, that pretends that
- * each port is the only port on an individual system.  We avoid the
- * need for timeout logic (and retaining local state about our
- * partner) by requesting the same timeout period (1s or 30s) as our
- * partner requests, and then simply responding to every packet the
- * partner sends us.
+ * We implement a very simple passive LACP entity, that identifies
+ * the system by the port's link-layer address.  Each port is
+ * therefore an individual system, unless it is a member of a bonding
+ * device (in which case all members share the bonding device's
+ * link-layer address, and so appear as ports of a single system).
+ * We avoid the need for timeout logic (and retaining local state
+ * about our partner) by requesting the same timeout period (1s or
+ * 30s) as our partner requests, and then simply responding to every
+ * packet the partner sends us.
  */
 
 struct net_protocol eth_slow_protocol __net_protocol;
@@ -201,7 +204,7 @@ static int eth_slow_lacp_rx ( struct io_buffer *iobuf,
 		 sizeof ( lacp->actor.system ) );
 	lacp->actor.key = htons ( 1 );
 	lacp->actor.port_priority = htons ( LACP_PORT_PRIORITY_MAX );
-	lacp->actor.port = htons ( 1 );
+	lacp->actor.port = htons ( netdev->scope_id );
 	lacp->actor.state = ( LACP_STATE_AGGREGATABLE |
 			      LACP_STATE_IN_SYNC |
 			      LACP_STATE_COLLECTING |
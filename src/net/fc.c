@@ -306,6 +306,8 @@ struct fc_exchange {
 	uint8_t seq_id;
 	/** Active sequence count */
 	uint16_t seq_cnt;
+	/** Maximum frame data field size */
+	size_t mtu;
 
 	/** Timeout timer */
 	struct retry_timer timer;
@@ -420,10 +422,8 @@ static void fc_xchg_expired ( struct retry_timer *timer, int over __unused ) {
  * @v xchg		Fibre Channel exchange
  * @ret len		Length opf window
  */
-static size_t fc_xchg_window ( struct fc_exchange *xchg __unused ) {
-
-	/* We don't currently store the path MTU */
-	return FC_LOGIN_DEFAULT_MTU;
+static size_t fc_xchg_window ( struct fc_exchange *xchg ) {
+	return xchg->mtu;
 }
 
 /**
@@ -696,6 +696,7 @@ static struct fc_exchange * fc_xchg_create ( struct fc_port *port,
 					     struct fc_port_id *peer_port_id,
 					     unsigned int type ) {
 	struct fc_exchange *xchg;
+	struct fc_peer *peer;
 
 	/* Allocate and initialise structure */
 	xchg = zalloc ( sizeof ( *xchg ) );
@@ -712,6 +713,15 @@ static struct fc_exchange * fc_xchg_create ( struct fc_port *port,
 	xchg->peer_xchg_id = FC_RX_ID_UNKNOWN;
 	xchg->seq_id = fc_new_seq_id();
 
+	/* Limit frame size to that supported by both port and peer */
+	xchg->mtu = port->mtu;
+	peer = fc_peer_get_port_id ( port, peer_port_id );
+	if ( peer ) {
+		if ( peer->mtu && ( peer->mtu < xchg->mtu ) )
+			xchg->mtu = peer->mtu;
+		fc_peer_put ( peer );
+	}
+
 	/* Transfer reference to list of exchanges and return */
 	list_add ( &xchg->list, &port->xchgs );
 	return xchg;
@@ -1118,6 +1128,27 @@ static void fc_port_examine ( struct fc_link_state *link ) {
 	}
 }
 
+/**
+ * Calculate maximum frame data field size
+ *
+ * @v window		Transport layer window (maximum frame length)
+ * @ret mtu		Maximum frame data field size
+ */
+static size_t fc_port_mtu ( size_t window ) {
+	size_t mtu;
+
+	/* Allow for frame header, and round down to a whole number
+	 * of words as required for the receive data field size.
+	 */
+	if ( window < ( sizeof ( struct fc_frame_header ) +
+			FC_LOGIN_DEFAULT_MTU ) )
+		return FC_LOGIN_DEFAULT_MTU;
+	mtu = ( window - sizeof ( struct fc_frame_header ) );
+	if ( mtu > FC_LOGIN_MAX_MTU )
+		mtu = FC_LOGIN_MAX_MTU;
+	return ( mtu & ~( ( size_t ) 0x3 ) );
+}
+
 /**
  * Handle change of flow control window
  *
@@ -1131,10 +1162,13 @@ static void fc_port_window_changed ( struct fc_port *port ) {
 	if ( window > 0 ) {
 
 		/* Transport layer is ready.  Start login if the link
-		 * is not already up.
+		 * is not already up, using the largest frame size
+		 * supported by the transport layer.
 		 */
-		if ( ! fc_link_ok ( &port->link ) )
+		if ( ! fc_link_ok ( &port->link ) ) {
+			port->mtu = fc_port_mtu ( window );
 			fc_link_start ( &port->link );
+		}
 
 	} else {
 
@@ -1201,6 +1235,7 @@ int fc_port_open ( struct interface *transport, const struct fc_name *node_wwn,
 	intf_init ( &port->ns_plogi, &fc_port_ns_plogi_desc, &port->refcnt );
 	list_add_tail ( &port->list, &fc_ports );
 	INIT_LIST_HEAD ( &port->xchgs );
+	port->mtu = FC_LOGIN_DEFAULT_MTU;
 	memcpy ( &port->node_wwn, node_wwn, sizeof ( port->node_wwn ) );
 	memcpy ( &port->port_wwn, port_wwn, sizeof ( port->port_wwn ) );
 	snprintf ( port->name, sizeof ( port->name ), "%s", name );
@@ -472,7 +472,7 @@ static int fc_els_flogi_tx ( struct fc_els *els ) {
 	flogi.common.version = htons ( FC_LOGIN_VERSION );
 	flogi.common.credit = htons ( FC_LOGIN_DEFAULT_B2B );
 	flogi.common.flags = htons ( FC_LOGIN_CONTINUOUS_OFFSET );
-	flogi.common.mtu = htons ( FC_LOGIN_DEFAULT_MTU );
+	flogi.common.mtu = htons ( els->port->mtu );
 	memcpy ( &flogi.port_wwn, &els->port->port_wwn,
 		 sizeof ( flogi.port_wwn ) );
 	memcpy ( &flogi.node_wwn, &els->port->node_wwn,
@@ -494,6 +494,7 @@ static int fc_els_flogi_tx ( struct fc_els *els ) {
  */
 static int fc_els_flogi_rx ( struct fc_els *els, void *data, size_t len ) {
 	struct fc_login_frame *flogi = data;
+	size_t mtu;
 	int has_fabric;
 	int rc;
 
@@ -519,6 +520,15 @@ static int fc_els_flogi_rx ( struct fc_els *els, void *data, size_t len ) {
 		       FCELS_ARGS ( els ) );
 	}
 
+	/* Limit frame size to that supported by the fabric (or
+	 * point-to-point peer).
+	 */
+	mtu = ( ntohs ( flogi->common.mtu ) & FC_LOGIN_MTU_MASK );
+	if ( mtu && ( mtu < els->port->mtu ) )
+		els->port->mtu = mtu;
+	DBGC ( els, FCELS_FMT " using frame size %zd\n",
+	       FCELS_ARGS ( els ), els->port->mtu );
+
 	/* Log in port */
 	if ( ( rc = fc_port_login ( els->port, &els->port_id, &flogi->node_wwn,
 				    &flogi->port_wwn, has_fabric ) ) != 0 ) {
@@ -606,7 +616,7 @@ static int fc_els_plogi_tx ( struct fc_els *els ) {
 	plogi.common.version = htons ( FC_LOGIN_VERSION );
 	plogi.common.credit = htons ( FC_LOGIN_DEFAULT_B2B );
 	plogi.common.flags = htons ( FC_LOGIN_CONTINUOUS_OFFSET );
-	plogi.common.mtu = htons ( FC_LOGIN_DEFAULT_MTU );
+	plogi.common.mtu = htons ( els->port->mtu );
 	plogi.common.u.plogi.max_seq = htons ( FC_LOGIN_DEFAULT_MAX_SEQ );
 	plogi.common.u.plogi.rel_offs = htons ( FC_LOGIN_DEFAULT_REL_OFFS );
 	plogi.common.e_d_tov = htonl ( FC_LOGIN_DEFAULT_E_D_TOV );
@@ -616,7 +626,7 @@ static int fc_els_plogi_tx ( struct fc_els *els ) {
 		 sizeof ( plogi.node_wwn ) );
 	plogi.class3.flags = htons ( FC_LOGIN_CLASS_VALID |
 				     FC_LOGIN_CLASS_SEQUENTIAL );
-	plogi.class3.mtu = htons ( FC_LOGIN_DEFAULT_MTU );
+	plogi.class3.mtu = htons ( els->port->mtu );
 	plogi.class3.max_seq = htons ( FC_LOGIN_DEFAULT_MAX_SEQ );
 	plogi.class3.max_seq_per_xchg = 1;
 
@@ -635,6 +645,7 @@ static int fc_els_plogi_tx ( struct fc_els *els ) {
 static int fc_els_plogi_rx ( struct fc_els *els, void *data, size_t len ) {
 	struct fc_login_frame *plogi = data;
 	struct fc_peer *peer;
+	size_t mtu;
 	int rc;
 
 	/* Sanity checks */
@@ -668,6 +679,16 @@ static int fc_els_plogi_rx ( struct fc_els *els, void *data, size_t len ) {
 		goto err_peer_get_wwn;
 	}
 
+	/* Record peer's receive data field size */
+	if ( plogi->class3.flags & htons ( FC_LOGIN_CLASS_VALID ) ) {
+		mtu = ntohs ( plogi->class3.mtu );
+	} else {
+		mtu = ntohs ( plogi->common.mtu );
+	}
+	peer->mtu = ( mtu & FC_LOGIN_MTU_MASK );
+	DBGC ( els, FCELS_FMT " has frame size %zd\n",
+	       FCELS_ARGS ( els ), peer->mtu );
+
 	/* Record login */
 	if ( ( rc = fc_peer_login ( peer, els->port,
 				    &els->peer_port_id ) ) != 0 ) {
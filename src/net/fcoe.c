@@ -43,6 +43,7 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 #include <ipxe/retry.h>
 #include <ipxe/timer.h>
 #include <ipxe/fc.h>
+#include <ipxe/fcels.h>
 #include <ipxe/fip.h>
 #include <ipxe/fcoe.h>
 
@@ -94,6 +95,8 @@ struct fcoe_port {
 	uint8_t fcf_mac[ETH_ALEN];
 	/** Local MAC address */
 	uint8_t local_mac[ETH_ALEN];
+	/** Maximum Fibre Channel frame length */
+	size_t mtu;
 };
 
 /** FCoE flags */
@@ -150,6 +153,14 @@ static uint8_t default_fcf_mac[ETH_ALEN] =
 /** Maximum number of missing discovery advertisements */
 #define FCOE_MAX_FIP_MISSING_KEEPALIVES 4
 
+/** Default maximum Fibre Channel frame length (for a standard MTU) */
+#define FCOE_DEFAULT_FC_LEN ( ETH_MAX_MTU - sizeof ( struct fcoe_header ) - \
+			      sizeof ( struct fcoe_footer ) )
+
+/** Maximum Fibre Channel frame length */
+#define FCOE_MAX_FC_LEN \
+	( sizeof ( struct fc_frame_header ) + FC_LOGIN_MAX_MTU )
+
 /******************************************************************************
  *
  * FCoE protocol
@@ -157,6 +168,28 @@ static uint8_t default_fcf_mac[ETH_ALEN] =
  ******************************************************************************
  */
 
+/**
+ * Calculate maximum Fibre Channel frame length supported by network device
+ *
+ * @v fcoe		FCoE port
+ * @ret max_len		Maximum Fibre Channel frame length
+ */
+static size_t fcoe_max_len ( struct fcoe_port *fcoe ) {
+	size_t overhead = ( sizeof ( struct fcoe_header ) +
+			    sizeof ( struct fcoe_footer ) );
+	size_t max_len;
+
+	/* Use as much of the network device MTU as possible */
+	max_len = ( ( fcoe->netdev->mtu > overhead ) ?
+		    ( fcoe->netdev->mtu - overhead ) : 0 );
+	if ( max_len > FCOE_MAX_FC_LEN )
+		max_len = FCOE_MAX_FC_LEN;
+	if ( max_len < FCOE_DEFAULT_FC_LEN )
+		max_len = FCOE_DEFAULT_FC_LEN;
+
+	return max_len;
+}
+
 /**
  * Reset FCoE port
  *
@@ -173,6 +206,7 @@ static void fcoe_reset ( struct fcoe_port *fcoe ) {
 	fcoe->flags = 0;
 	fcoe->priority = ( FIP_LOWEST_PRIORITY + 1 );
 	fcoe->keepalive = 0;
+	fcoe->mtu = FCOE_DEFAULT_FC_LEN;
 	memcpy ( fcoe->fcf_mac, default_fcf_mac,
 		 sizeof ( fcoe->fcf_mac ) );
 	memcpy ( fcoe->local_mac, fcoe->netdev->ll_addr,
@@ -415,7 +449,7 @@ static int fcoe_rx ( struct io_buffer *iobuf, struct net_device *netdev,
  * @ret len		Length of window
  */
 static size_t fcoe_window ( struct fcoe_port *fcoe ) {
-	return ( ( fcoe->flags & FCOE_HAVE_FCF ) ? ~( ( size_t ) 0 ) : 0 );
+	return ( ( fcoe->flags & FCOE_HAVE_FCF ) ? fcoe->mtu : 0 );
 }
 
 /**
@@ -674,9 +708,7 @@ static int fcoe_fip_tx_solicitation ( struct fcoe_port *fcoe ) {
 	solicitation->max_fcoe_size.type = FIP_MAX_FCOE_SIZE;
 	solicitation->max_fcoe_size.len =
 		( sizeof ( solicitation->max_fcoe_size ) / 4 );
-	solicitation->max_fcoe_size.mtu =
-		htons ( ETH_MAX_MTU - sizeof ( struct fcoe_header ) -
-			sizeof ( struct fcoe_footer ) );
+	solicitation->max_fcoe_size.mtu = htons ( fcoe_max_len ( fcoe ) );
 
 	/* Send discovery solicitation */
 	if ( ( rc = net_tx ( iob_disown ( iobuf ), fcoe->netdev,
@@ -744,9 +776,17 @@ static int fcoe_fip_rx_advertisement ( struct fcoe_port *fcoe,
 				fcoe->flags |= FCOE_FCF_ALLOWS_SPMA;
 			memcpy ( fcoe->fcf_mac, mac_address->mac,
 				 sizeof ( fcoe->fcf_mac ) );
-			DBGC ( fcoe, "FCoE %s selected FCF %s (pri %d",
-			       fcoe->netdev->name, eth_ntoa ( fcoe->fcf_mac ),
-			       fcoe->priority );
+
+			/* A solicited advertisement is padded to the
+			 * maximum FCoE size that we requested, and so
+			 * its arrival demonstrates that this size is
+			 * supported by both the forwarder and the path.
+			 */
+			fcoe->mtu = fcoe_max_len ( fcoe );
+			DBGC ( fcoe, "FCoE %s selected FCF %s (pri %d, "
+			       "max %zd", fcoe->netdev->name,
+			       eth_ntoa ( fcoe->fcf_mac ), fcoe->priority,
+			       fcoe->mtu );
 			if ( fcoe->keepalive ) {
 				DBGC ( fcoe, ", FKA ADV %dms",
 				       fcoe->keepalive );
@@ -158,6 +158,8 @@ struct fcp_device {
 	struct interface scsi;
 	/** List of active commands */
 	struct list_head fcpcmds;
+	/** Number of active commands */
+	unsigned int count;
 
 	/** Device description (for boot firmware table) */
 	struct fcp_description desc;
@@ -269,8 +271,7 @@ static void fcpcmd_free ( struct refcnt *refcnt ) {
 	struct fcp_command *fcpcmd =
 		container_of ( refcnt, struct fcp_command, refcnt );
 
-	/* Remove from list of commands */
-	list_del ( &fcpcmd->list );
+	assert ( list_empty ( &fcpcmd->list ) );
 	fcpdev_put ( fcpcmd->fcpdev );
 
 	/* Free command */
@@ -285,6 +286,7 @@ static void fcpcmd_free ( struct refcnt *refcnt ) {
  */
 static void fcpcmd_close ( struct fcp_command *fcpcmd, int rc ) {
 	struct fcp_device *fcpdev = fcpcmd->fcpdev;
+	int active = ( ! list_empty ( &fcpcmd->list ) );
 
 	if ( rc != 0 ) {
 		DBGC ( fcpdev, "FCP %p xchg %04x closed: %s\n",
@@ -294,9 +296,21 @@ static void fcpcmd_close ( struct fcp_command *fcpcmd, int rc ) {
 	/* Stop sending */
 	fcpcmd_stop_send ( fcpcmd );
 
+	/* Remove from list of active commands */
+	if ( active ) {
+		list_del ( &fcpcmd->list );
+		INIT_LIST_HEAD ( &fcpcmd->list );
+		assert ( fcpdev->count > 0 );
+		fcpdev->count--;
+	}
+
 	/* Shut down interfaces */
 	intf_shutdown ( &fcpcmd->scsi, rc );
 	intf_shutdown ( &fcpcmd->xchg, rc );
+
+	/* Notify SCSI layer that an exchange has become available */
+	if ( active )
+		xfer_window_changed ( &fcpdev->scsi );
 }
 
 /**
@@ -773,7 +787,7 @@ static int fcpdev_scsi_command ( struct fcp_device *fcpdev,
 	process_init_stopped ( &fcpcmd->process, &fcpcmd_process_desc,
 			       &fcpcmd->refcnt );
 	fcpcmd->fcpdev = fcpdev_get ( fcpdev );
-	list_add ( &fcpcmd->list, &fcpdev->fcpcmds );
+	INIT_LIST_HEAD ( &fcpcmd->list );
 	memcpy ( &fcpcmd->command, command, sizeof ( fcpcmd->command ) );
 
 	/* Create new exchange */
@@ -788,6 +802,10 @@ static int fcpdev_scsi_command ( struct fcp_device *fcpdev,
 	}
 	fcpcmd->xchg_id = xchg_id;
 
+	/* Add to list of active commands */
+	list_add ( &fcpcmd->list, &fcpdev->fcpcmds );
+	fcpdev->count++;
+
 	/* Start sending command IU */
 	fcpcmd_start_send ( fcpcmd, fcpcmd_send_cmnd );
 
@@ -838,8 +856,15 @@ static void fcpdev_close ( struct fcp_device *fcpdev, int rc ) {
  * @ret len		Length of window
  */
 static size_t fcpdev_window ( struct fcp_device *fcpdev ) {
-	return ( fc_link_ok ( &fcpdev->user.ulp->link ) ?
-		 ~( ( size_t ) 0 ) : 0 );
+
+	/* Commands cannot be issued while the link is down */
+	if ( ! fc_link_ok ( &fcpdev->user.ulp->link ) )
+		return 0;
+
+	/* Limit number of concurrent exchanges */
+	if ( fcpdev->count >= FCP_MAX_COMMANDS )
+		return 0;
+	return ( FCP_MAX_COMMANDS - fcpdev->count );
 }
 
 /**
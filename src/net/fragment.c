@@ -27,6 +27,8 @@ FILE_SECBOOT ( PERMITTED );
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
+#include <errno.h>
+#include <assert.h>
 #include <ipxe/retry.h>
 #include <ipxe/timer.h>
 #include <ipxe/ipstat.h>
@@ -38,6 +40,33 @@ FILE_SECBOOT ( PERMITTED );
  *
  */
 
+/**
+ * Free fragment reassembly buffer
+ *
+ * @v fragment		Fragment reassembly buffer
+ */
+static void fragment_free ( struct fragment *fragment ) {
+	unsigned int i;
+
+	stop_timer ( &fragment->timer );
+	for ( i = 0 ; i < fragment->count ; i++ )
+		free_iob ( fragment->parts[i].iobuf );
+	list_del ( &fragment->list );
+	fragment->fragments->count--;
+	free ( fragment );
+}
+
+/**
+ * Discard fragment reassembly buffer
+ *
+ * @v fragment		Fragment reassembly buffer
+ */
+static void fragment_discard ( struct fragment *fragment ) {
+
+	fragment->fragments->stats->reasm_fails++;
+	fragment_free ( fragment );
+}
+
 /**
  * Expire fragment reassembly buffer
  *
@@ -49,10 +78,7 @@ static void fragment_expired ( struct retry_timer *timer, int fail __unused ) {
 		container_of ( timer, struct fragment, timer );
 
 	DBGC ( fragment, "FRAG %p expired\n", fragment );
-	free_iob ( fragment->iobuf );
-	list_del ( &fragment->list );
-	fragment->fragments->stats->reasm_fails++;
-	free ( fragment );
+	fragment_discard ( fragment );
 }
 
 /**
@@ -62,6 +88,11 @@ static void fragment_expired ( struct retry_timer *timer, int fail __unused ) {
  * @v iobuf		I/O buffer
  * @v hdrlen		Length of non-fragmentable potion of I/O buffer
  * @ret fragment	Fragment reassembly buffer, or NULL if not found
+ *
+ * The number of fragment reassembly buffers is bounded, and the
+ * matching buffer (if any) is moved to the head of the list so that
+ * fragments of a packet arriving in quick succession are found
+ * immediately.
  */
 static struct fragment * fragment_find ( struct fragment_reassembler *fragments,
 					 struct io_buffer *iobuf,
@@ -69,12 +100,192 @@ static struct fragment * fragment_find ( struct fragment_reassembler *fragments,
 	struct fragment *fragment;
 
 	list_for_each_entry ( fragment, &fragments->list, list ) {
-		if ( fragments->is_fragment ( fragment, iobuf, hdrlen ) )
+		if ( fragments->is_fragment ( fragment, iobuf, hdrlen ) ) {
+			list_del ( &fragment->list );
+			list_add ( &fragment->list, &fragments->list );
 			return fragment;
+		}
 	}
 	return NULL;
 }
 
+/**
+ * Create fragment reassembly buffer
+ *
+ * @v fragments		Fragment reassembler
+ * @v iobuf		I/O buffer
+ * @v hdrlen		Length of non-fragmentable potion of I/O buffer
+ * @ret fragment	Fragment reassembly buffer, or NULL on error
+ */
+static struct fragment *
+fragment_create ( struct fragment_reassembler *fragments,
+		  struct io_buffer *iobuf, size_t hdrlen ) {
+	struct fragment *fragment;
+
+	/* Discard least recently used buffer if limit is reached */
+	if ( fragments->count >= FRAGMENT_MAX_BUFFERS ) {
+		fragment = list_last_entry ( &fragments->list, struct fragment,
+					     list );
+		assert ( fragment != NULL );
+		DBGC ( fragment, "FRAG %p evicted\n", fragment );
+		fragment_discard ( fragment );
+	}
+
+	/* Allocate and initialise buffer */
+	fragment = zalloc ( sizeof ( *fragment ) );
+	if ( ! fragment )
+		return NULL;
+	list_add ( &fragment->list, &fragments->list );
+	fragments->count++;
+	fragment->iobuf = iobuf;
+	fragment->hdrlen = hdrlen;
+	timer_init ( &fragment->timer, fragment_expired, NULL );
+	fragment->fragments = fragments;
+
+	return fragment;
+}
+
+/**
+ * Add fragment to fragment reassembly buffer
+ *
+ * @v fragment		Fragment reassembly buffer
+ * @v iobuf		I/O buffer
+ * @v hdrlen		Length of non-fragmentable potion of I/O buffer
+ * @ret rc		Return status code
+ *
+ * This function takes ownership of the I/O buffer, even on failure.
+ * Overlapping fragments are treated as an error (as required for IPv6
+ * by RFC 5722), with the exception of exact duplicates which are
+ * silently ignored.
+ */
+static int fragment_add ( struct fragment *fragment, struct io_buffer *iobuf,
+			  size_t hdrlen ) {
+	struct fragment_reassembler *fragments = fragment->fragments;
+	struct fragment_part *part;
+	size_t offset;
+	size_t len;
+	size_t end;
+	size_t part_end;
+	unsigned int insert;
+	unsigned int i;
+	int more_frags;
+	int rc;
+
+	/* Parse fragment */
+	offset = fragments->fragment_offset ( iobuf, hdrlen );
+	len = ( iob_len ( iobuf ) - hdrlen );
+	end = ( offset + len );
+	more_frags = fragments->more_fragments ( iobuf, hdrlen );
+	DBGC ( fragment, "FRAG %p [%zd,%zd)%s\n", fragment, offset, end,
+	       ( more_frags ? "" : " final" ) );
+
+	/* Check length */
+	if ( ( end > FRAGMENT_MAX_LEN ) ||
+	     ( fragment->len && ( end > fragment->len ) ) ||
+	     ( fragment->len && ( ! more_frags ) &&
+	       ( end != fragment->len ) ) ) {
+		DBGC ( fragment, "FRAG %p fragment [%zd,%zd) exceeds length "
+		       "%zd\n", fragment, offset, end, fragment->len );
+		rc = -EINVAL;
+		goto err;
+	}
+
+	/* Check for duplicates and overlaps, and find insertion point */
+	insert = fragment->count;
+	for ( i = 0 ; i < fragment->count ; i++ ) {
+		part = &fragment->parts[i];
+		part_end = ( part->offset + iob_len ( part->iobuf ) -
+			     part->hdrlen );
+		if ( ( part->offset == offset ) && ( part_end == end ) ) {
+			DBGC ( fragment, "FRAG %p ignoring duplicate "
+			       "[%zd,%zd)\n", fragment, offset, end );
+			free_iob ( iobuf );
+			return 0;
+		}
+		if ( ( ( part->offset < end ) && ( offset < part_end ) ) ||
+		     ( ( ! more_frags ) && ( part_end > end ) ) ) {
+			DBGC ( fragment, "FRAG %p fragment [%zd,%zd) overlaps "
+			       "[%zd,%zd)\n", fragment, offset, end,
+			       part->offset, part_end );
+			rc = -EINVAL;
+			goto err;
+		}
+		if ( ( part->offset > offset ) && ( insert > i ) )
+			insert = i;
+	}
+	if ( fragment->count >= FRAGMENT_MAX_PARTS ) {
+		DBGC ( fragment, "FRAG %p too many fragments\n", fragment );
+		rc = -ENOBUFS;
+		goto err;
+	}
+
+	/* Insert fragment */
+	part = &fragment->parts[insert];
+	memmove ( ( part + 1 ), part,
+		  ( ( fragment->count - insert ) * sizeof ( *part ) ) );
+	part->iobuf = iobuf;
+	part->hdrlen = hdrlen;
+	part->offset = offset;
+	fragment->count++;
+	fragment->received += len;
+	if ( ! more_frags )
+		fragment->len = end;
+
+	return 0;
+
+ err:
+	free_iob ( iobuf );
+	return rc;
+}
+
+/**
+ * Construct reassembled packet
+ *
+ * @v fragment		Fragment reassembly buffer
+ * @v hdrlen		Length of non-fragmentable portion to fill in
+ * @ret iobuf		Reassembled packet, or NULL on error
+ */
+static struct io_buffer * fragment_assemble ( struct fragment *fragment,
+					      size_t *hdrlen ) {
+	struct fragment_part *first = &fragment->parts[0];
+	struct fragment_part *part;
+	struct io_buffer *iobuf;
+	size_t headroom;
+	size_t len;
+	unsigned int i;
+	void *data;
+
+	/* Use the non-fragmentable portion of the first fragment.
+	 * Preserve I/O buffer headroom to allow for code which
+	 * modifies and resends the buffer (e.g. ICMP echo responses).
+	 */
+	assert ( first->offset == 0 );
+	headroom = iob_headroom ( first->iobuf );
+	iobuf = alloc_iob ( headroom + first->hdrlen + fragment->len );
+	if ( ! iobuf ) {
+		DBGC ( fragment, "FRAG %p could not allocate %zd-byte "
+		       "reassembly buffer\n", fragment, fragment->len );
+		return NULL;
+	}
+	iob_reserve ( iobuf, headroom );
+	*hdrlen = first->hdrlen;
+	memcpy ( iob_put ( iobuf, *hdrlen ), first->iobuf->data, *hdrlen );
+	data = iob_put ( iobuf, fragment->len );
+
+	/* Copy in each fragment.  Fragments are known not to overlap,
+	 * and so must exactly cover the reassembled packet.
+	 */
+	for ( i = 0 ; i < fragment->count ; i++ ) {
+		part = &fragment->parts[i];
+		len = ( iob_len ( part->iobuf ) - part->hdrlen );
+		assert ( ( part->offset + len ) <= fragment->len );
+		memcpy ( ( data + part->offset ),
+			 ( part->iobuf->data + part->hdrlen ), len );
+	}
+
+	return iobuf;
+}
+
 /**
  * Reassemble packet
  *
@@ -85,101 +296,50 @@ static struct fragment * fragment_find ( struct fragment_reassembler *fragments,
  *
  * This function takes ownership of the I/O buffer.  Note that the
  * length of the non-fragmentable portion may be modified.
+ *
+ * Fragments may arrive in any order.
  */
 struct io_buffer * fragment_reassemble ( struct fragment_reassembler *fragments,
 					 struct io_buffer *iobuf,
 					 size_t *hdrlen ) {
 	struct fragment *fragment;
-	struct io_buffer *new_iobuf;
-	size_t new_len;
-	size_t offset;
-	size_t expected_offset;
-	int more_frags;
 
 	/* Update statistics */
 	fragments->stats->reasm_reqds++;
 
-	/* Find matching fragment reassembly buffer, if any */
+	/* Find or create matching fragment reassembly buffer */
 	fragment = fragment_find ( fragments, iobuf, *hdrlen );
-
-	/* Drop out-of-order fragments */
-	offset = fragments->fragment_offset ( iobuf, *hdrlen );
-	expected_offset = ( fragment ? ( iob_len ( fragment->iobuf ) -
-					 fragment->hdrlen ) : 0 );
-	if ( offset != expected_offset ) {
-		DBGC ( fragment, "FRAG %p dropping out-of-sequence fragment "
-		       "[%zd,%zd), expected [%zd,...)\n", fragment, offset,
-		       ( offset + iob_len ( iobuf ) - *hdrlen ),
-		       expected_offset );
-		goto drop;
-	}
-
-	/* Create or extend fragment reassembly buffer as applicable */
 	if ( ! fragment ) {
-
-		/* Create new fragment reassembly buffer */
-		fragment = zalloc ( sizeof ( *fragment ) );
-		if ( ! fragment )
-			goto drop;
-		list_add ( &fragment->list, &fragments->list );
-		fragment->iobuf = iobuf;
-		fragment->hdrlen = *hdrlen;
-		timer_init ( &fragment->timer, fragment_expired, NULL );
-		fragment->fragments = fragments;
-		DBGC ( fragment, "FRAG %p [0,%zd)\n", fragment,
-		       ( iob_len ( iobuf ) - *hdrlen ) );
-
-	} else {
-
-		/* Check if this is the final fragment */
-		more_frags = fragments->more_fragments ( iobuf, *hdrlen );
-		DBGC ( fragment, "FRAG %p [%zd,%zd)%s\n", fragment,
-		       offset, ( offset + iob_len ( iobuf ) - *hdrlen ),
-		       ( more_frags ? "" : " complete" ) );
-
-		/* Extend fragment reassembly buffer.  Preserve I/O
-		 * buffer headroom to allow for code which modifies
-		 * and resends the buffer (e.g. ICMP echo responses).
-		 */
-		iob_pull ( iobuf, *hdrlen );
-		new_len = ( iob_headroom ( fragment->iobuf ) +
-			    iob_len ( fragment->iobuf ) + iob_len ( iobuf ) );
-		new_iobuf = alloc_iob ( new_len );
-		if ( ! new_iobuf ) {
-			DBGC ( fragment, "FRAG %p could not extend reassembly "
-			       "buffer to %zd bytes\n", fragment, new_len );
-			goto drop;
-		}
-		iob_reserve ( new_iobuf, iob_headroom ( fragment->iobuf ) );
-		memcpy ( iob_put ( new_iobuf, iob_len ( fragment->iobuf ) ),
-			 fragment->iobuf->data, iob_len ( fragment->iobuf ) );
-		memcpy ( iob_put ( new_iobuf, iob_len ( iobuf ) ),
-			 iobuf->data, iob_len ( iobuf ) );
-		free_iob ( fragment->iobuf );
-		fragment->iobuf = new_iobuf;
-		free_iob ( iobuf );
-
-		/* Stop fragment reassembly timer */
-		stop_timer ( &fragment->timer );
-
-		/* If this is the final fragment, return it */
-		if ( ! more_frags ) {
-			iobuf = fragment->iobuf;
-			*hdrlen = fragment->hdrlen;
-			list_del ( &fragment->list );
-			free ( fragment );
-			fragments->stats->reasm_oks++;
-			return iobuf;
+		fragment = fragment_create ( fragments, iobuf, *hdrlen );
+		if ( ! fragment ) {
+			fragments->stats->reasm_fails++;
+			free_iob ( iobuf );
+			return NULL;
 		}
 	}
 
-	/* (Re)start fragment reassembly timer */
-	start_timer_fixed ( &fragment->timer, FRAGMENT_TIMEOUT );
+	/* Add fragment to reassembly buffer */
+	if ( fragment_add ( fragment, iobuf, *hdrlen ) != 0 ) {
+		fragment_discard ( fragment );
+		return NULL;
+	}
 
-	return NULL;
+	/* Wait for further fragments unless all have now arrived */
+	if ( ! ( fragment->len && ( fragment->received == fragment->len ) ) ) {
+		start_timer_fixed ( &fragment->timer, FRAGMENT_TIMEOUT );
+		return NULL;
+	}
 
- drop:
-	fragments->stats->reasm_fails++;
-	free_iob ( iobuf );
-	return NULL;
+	/* Construct reassembled packet */
+	DBGC ( fragment, "FRAG %p complete [0,%zd)\n",
+	       fragment, fragment->len );
+	iobuf = fragment_assemble ( fragment, hdrlen );
+	if ( ! iobuf ) {
+		fragment_discard ( fragment );
+		return NULL;
+	}
+	fragment_free ( fragment );
+	fragments->stats->reasm_oks++;
+
+	return iobuf;
 }
@@ -44,6 +44,9 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 /** List of connections */
 static LIST_HEAD ( ib_cm_conns );
 
+/** List of listeners */
+static LIST_HEAD ( ib_cm_listeners );
+
 /**
  * Find connection by local communication ID
  *
@@ -60,6 +63,42 @@ static struct ib_connection * ib_cm_find ( uint32_t local_id ) {
 	return NULL;
 }
 
+/**
+ * Find passive connection by remote communication ID
+ *
+ * @v remote_id		Remote communication ID
+ * @ret conn		Connection, or NULL
+ */
+static struct ib_connection * ib_cm_find_remote ( uint32_t remote_id ) {
+	struct ib_connection *conn;
+
+	list_for_each_entry ( conn, &ib_cm_conns, list ) {
+		if ( conn->passive && ( conn->remote_id == remote_id ) )
+			return conn;
+	}
+	return NULL;
+}
+
+/**
+ * Find listener by service ID
+ *
+ * @v ibdev		Infiniband device
+ * @v service_id	Service ID
+ * @ret listener	Listener, or NULL
+ */
+static struct ib_listener * ib_cm_find_listener ( struct ib_device *ibdev,
+						  union ib_guid *service_id ) {
+	struct ib_listener *listener;
+
+	list_for_each_entry ( listener, &ib_cm_listeners, list ) {
+		if ( ( listener->ibdev == ibdev ) &&
+		     ( memcmp ( &listener->service_id, service_id,
+				sizeof ( listener->service_id ) ) == 0 ) )
+			return listener;
+	}
+	return NULL;
+}
+
 /**
  * Send "ready to use" response
  *
@@ -210,6 +249,238 @@ static void ib_cm_recv_dreq ( struct ib_device *ibdev,
 	}
 };
 
+/**
+ * Send connection rejection
+ *
+ * @v ibdev		Infiniband device
+ * @v mi		Management interface
+ * @v tid		Transaction identifier
+ * @v av		Address vector
+ * @v local_id		Local communication ID
+ * @v remote_id		Remote communication ID
+ * @v reason		Rejection reason
+ * @ret rc		Return status code
+ */
+static int ib_cm_send_rej ( struct ib_device *ibdev,
+			    struct ib_mad_interface *mi,
+			    struct ib_mad_tid *tid,
+			    struct ib_address_vector *av,
+			    uint32_t local_id, uint32_t remote_id,
+			    unsigned int reason ) {
+	union ib_mad mad;
+	struct ib_cm_connect_reject *rej = &mad.cm.cm_data.connect_reject;
+	int rc;
+
+	/* Construct connection rejection */
+	memset ( &mad, 0, sizeof ( mad ) );
+	mad.hdr.mgmt_class = IB_MGMT_CLASS_CM;
+	mad.hdr.class_version = IB_CM_CLASS_VERSION;
+	mad.hdr.method = IB_MGMT_METHOD_SEND;
+	memcpy ( &mad.hdr.tid, tid, sizeof ( mad.hdr.tid ) );
+	mad.hdr.attr_id = htons ( IB_CM_ATTR_CONNECT_REJECT );
+	rej->local_id = htonl ( local_id );
+	rej->remote_id = htonl ( remote_id );
+	rej->reason = htons ( reason );
+	if ( ( rc = ib_mi_send ( ibdev, mi, &mad, av ) ) != 0 ) {
+		DBGC ( local_id, "CM %08x could not send REJ: %s\n",
+		       local_id, strerror ( rc ) );
+		return rc;
+	}
+
+	return 0;
+}
+
+/**
+ * Send connection reply
+ *
+ * @v ibdev		Infiniband device
+ * @v mi		Management interface
+ * @v tid		Transaction identifier
+ * @v av		Address vector
+ * @v conn		Connection
+ * @ret rc		Return status code
+ */
+static int ib_cm_send_rep ( struct ib_device *ibdev,
+			    struct ib_mad_interface *mi,
+			    struct ib_mad_tid *tid,
+			    struct ib_address_vector *av,
+			    struct ib_connection *conn ) {
+	union ib_mad mad;
+	struct ib_cm_connect_reply *rep = &mad.cm.cm_data.connect_reply;
+	struct ib_queue_pair *qp = conn->qp;
+	int rc;
+
+	/* Construct connection reply */
+	memset ( &mad, 0, sizeof ( mad ) );
+	mad.hdr.mgmt_class = IB_MGMT_CLASS_CM;
+	mad.hdr.class_version = IB_CM_CLASS_VERSION;
+	mad.hdr.method = IB_MGMT_METHOD_SEND;
+	memcpy ( &mad.hdr.tid, tid, sizeof ( mad.hdr.tid ) );
+	mad.hdr.attr_id = htons ( IB_CM_ATTR_CONNECT_REPLY );
+	rep->local_id = htonl ( conn->local_id );
+	rep->remote_id = htonl ( conn->remote_id );
+	rep->local_qpn = htonl ( qp->qpn << 8 );
+	rep->starting_psn = htonl ( qp->send.psn << 8 );
+	rep->responder_resources = 1;
+	rep->initiator_depth = 1;
+	rep->rnr_retry__srq = ( 0x07 << 5 );
+	memcpy ( &rep->local_ca, &ibdev->node_guid, sizeof ( rep->local_ca ) );
+	memcpy ( &rep->private_data, &conn->private_data,
+		 sizeof ( rep->private_data ) );
+	if ( ( rc = ib_mi_send ( ibdev, mi, &mad, av ) ) != 0 ) {
+		DBGC ( conn->local_id, "CM %08x could not send REP: %s\n",
+		       conn->local_id, strerror ( rc ) );
+		return rc;
+	}
+
+	return 0;
+}
+
+/**
+ * Handle connection requests
+ *
+ * @v ibdev		Infiniband device
+ * @v mi		Management interface
+ * @v mad		Received MAD
+ * @v av		Source address vector
+ */
+static void ib_cm_recv_req ( struct ib_device *ibdev,
+			     struct ib_mad_interface *mi,
+			     union ib_mad *mad,
+			     struct ib_address_vector *av ) {
+	struct ib_cm_connect_request *req = &mad->cm.cm_data.connect_request;
+	struct ib_cm_connect_reply *rep;
+	struct ib_address_vector peer;
+	struct ib_listener *listener;
+	struct ib_connection *conn;
+	struct ib_queue_pair *qp;
+	uint32_t remote_id = ntohl ( req->local_id );
+	uint32_t local_id;
+	unsigned int type;
+	uint32_t tmp;
+	int rc;
+
+	/* Resend reply to duplicate requests */
+	conn = ib_cm_find_remote ( remote_id );
+	if ( conn ) {
+		DBGC ( conn->local_id, "CM %08x duplicate REQ\n",
+		       conn->local_id );
+		ib_cm_send_rep ( ibdev, mi, &mad->hdr.tid, av, conn );
+		return;
+	}
+
+	/* Identify listener */
+	listener = ib_cm_find_listener ( ibdev, &req->service_id );
+	if ( ! listener ) {
+		DBGC ( remote_id, "CM (%08x) no listener for " IB_GUID_FMT
+		       "\n", remote_id, IB_GUID_ARGS ( &req->service_id ) );
+		ib_cm_send_rej ( ibdev, mi, &mad->hdr.tid, av, 0, remote_id,
+				 IB_CM_REJECT_BAD_SERVICE_ID );
+		return;
+	}
+
+	/* Accept only reliable connections */
+	tmp = req->remote_eecn__remote_timeout__service_type__ee_flow_ctrl;
+	type = ( ( ntohl ( tmp ) >> 1 ) & 0x03 );
+	if ( type != IB_CM_TRANSPORT_RC ) {
+		DBGC ( remote_id, "CM (%08x) unsupported transport %d\n",
+		       remote_id, type );
+		ib_cm_send_rej ( ibdev, mi, &mad->hdr.tid, av, 0, remote_id,
+				 IB_CM_REJECT_CONSUMER );
+		return;
+	}
+
+	/* Allocate and initialise connection */
+	conn = zalloc ( sizeof ( *conn ) + sizeof ( rep->private_data ) );
+	if ( ! conn )
+		return;
+	conn->ibdev = ibdev;
+	conn->local_id = local_id = random();
+	conn->remote_id = remote_id;
+	memcpy ( &conn->service_id, &req->service_id,
+		 sizeof ( conn->service_id ) );
+	conn->passive = 1;
+	conn->private_data_len = sizeof ( rep->private_data );
+
+	/* Construct address vector for requester */
+	memset ( &peer, 0, sizeof ( peer ) );
+	peer.qpn = ( ntohl ( req->local_qpn__responder_resources ) >> 8 );
+	peer.lid = ntohs ( req->primary.local_lid );
+	peer.rate = ( ntohl ( req->primary.flow_label__rate ) & 0x3f );
+	peer.sl = ( req->primary.sl__subnet_local >> 4 );
+	peer.gid_present = 1;
+	memcpy ( &peer.gid, &req->primary.local_gid, sizeof ( peer.gid ) );
+	DBGC ( local_id, "CM %08x request from " IB_GID_FMT " QPN %#lx for "
+	       IB_GUID_FMT "\n", local_id, IB_GID_ARGS ( &peer.gid ),
+	       peer.qpn, IB_GUID_ARGS ( &conn->service_id ) );
+
+	/* Offer connection to listener */
+	if ( ( rc = listener->op->request ( ibdev, listener, conn, &peer,
+					    &req->private_data,
+					    sizeof ( req->private_data ),
+					    &conn->private_data,
+					    conn->private_data_len ) ) != 0 ) {
+		DBGC ( local_id, "CM %08x rejected by listener: %s\n",
+		       local_id, strerror ( rc ) );
+		ib_cm_send_rej ( ibdev, mi, &mad->hdr.tid, av, local_id,
+				 remote_id, IB_CM_REJECT_CONSUMER );
+		free ( conn );
+		return;
+	}
+	qp = conn->qp;
+
+	/* Add to list of connections */
+	list_add ( &conn->list, &ib_cm_conns );
+
+	/* Modify queue pair */
+	memcpy ( &qp->av, &peer, sizeof ( qp->av ) );
+	tmp = ntohl ( req->starting_psn__local_timeout__retry_count );
+	qp->recv.psn = ( tmp >> 8 );
+	if ( ( rc = ib_modify_qp ( ibdev, qp ) ) != 0 ) {
+		DBGC ( local_id, "CM %08x could not modify queue pair: %s\n",
+		       local_id, strerror ( rc ) );
+		ib_cm_send_rej ( ibdev, mi, &mad->hdr.tid, av, local_id,
+				 remote_id, IB_CM_REJECT_CONSUMER );
+		conn->op->changed ( ibdev, qp, conn, rc, NULL, 0 );
+		return;
+	}
+
+	/* Send reply */
+	if ( ( rc = ib_cm_send_rep ( ibdev, mi, &mad->hdr.tid, av,
+				     conn ) ) != 0 ) {
+		/* Ignore errors; the remote end will retry */
+	}
+}
+
+/**
+ * Handle "ready to use" responses
+ *
+ * @v ibdev		Infiniband device
+ * @v mi		Management interface
+ * @v mad		Received MAD
+ * @v av		Source address vector
+ */
+static void ib_cm_recv_rtu ( struct ib_device *ibdev,
+			     struct ib_mad_interface *mi __unused,
+			     union ib_mad *mad,
+			     struct ib_address_vector *av __unused ) {
+	struct ib_cm_ready_to_use *rtu = &mad->cm.cm_data.ready_to_use;
+	struct ib_connection *conn;
+	uint32_t local_id = ntohl ( rtu->remote_id );
+
+	/* Identify connection */
+	conn = ib_cm_find ( local_id );
+	if ( conn && conn->passive ) {
+		DBGC ( local_id, "CM %08x connected\n", local_id );
+		/* Notify upper layer */
+		conn->op->changed ( ibdev, conn->qp, conn, 0,
+				    &rtu->private_data,
+				    sizeof ( rtu->private_data ) );
+	} else {
+		DBGC ( local_id, "CM %08x unexpected RTU\n", local_id );
+	}
+}
+
 /** Communication management agents */
 struct ib_mad_agent ib_cm_agent[] __ib_mad_agent = {
 	{
@@ -224,6 +495,18 @@ struct ib_mad_agent ib_cm_agent[] __ib_mad_agent = {
 		.attr_id = htons ( IB_CM_ATTR_DISCONNECT_REQUEST ),
 		.handle = ib_cm_recv_dreq,
 	},
+	{
+		.mgmt_class = IB_MGMT_CLASS_CM,
+		.class_version = IB_CM_CLASS_VERSION,
+		.attr_id = htons ( IB_CM_ATTR_CONNECT_REQUEST ),
+		.handle = ib_cm_recv_req,
+	},
+	{
+		.mgmt_class = IB_MGMT_CLASS_CM,
+		.class_version = IB_CM_CLASS_VERSION,
+		.attr_id = htons ( IB_CM_ATTR_READY_TO_USE ),
+		.handle = ib_cm_recv_rtu,
+	},
 };
 
 /**
@@ -512,3 +795,34 @@ void ib_destroy_conn ( struct ib_device *ibdev,
 		ib_destroy_path ( ibdev, conn->path );
 	free ( conn );
 }
+
+/**
+ * Listen for incoming connections
+ *
+ * @v ibdev		Infiniband device
+ * @v listener		Listener
+ * @v service_id	Service ID
+ * @v op		Listener operations
+ */
+void ib_listen ( struct ib_device *ibdev, struct ib_listener *listener,
+		 union ib_guid *service_id,
+		 struct ib_listener_operations *op ) {
+
+	listener->ibdev = ibdev;
+	memcpy ( &listener->service_id, service_id,
+		 sizeof ( listener->service_id ) );
+	listener->op = op;
+	list_add ( &listener->list, &ib_cm_listeners );
+	DBGC ( listener, "CM listening on IBDEV %s for " IB_GUID_FMT "\n",
+	       ibdev->name, IB_GUID_ARGS ( service_id ) );
+}
+
+/**
+ * Stop listening for incoming connections
+ *
+ * @v listener		Listener
+ */
+void ib_unlisten ( struct ib_listener *listener ) {
+
+	list_del ( &listener->list );
+}
@@ -57,13 +57,13 @@ FILE_LICENCE ( BSD2 );
  *
  * This is a policy decision.
  */
-#define IB_CMRC_NUM_RECV_WQES 2
+#define IB_CMRC_NUM_RECV_WQES 8
 
 /** CMRC number of completion queue entries
  *
  * This is a policy decision
  */
-#define IB_CMRC_NUM_CQES 8
+#define IB_CMRC_NUM_CQES 16
 
 /** An Infiniband Communication-Managed Reliable Connection */
 struct ib_cmrc_connection {
@@ -436,7 +436,7 @@ static uint16_t ipv4_pshdr_chksum ( struct io_buffer *iobuf, uint16_t csum ) {
 	pshdr.dest = iphdr->dest;
 	pshdr.zero_padding = 0x00;
 	pshdr.protocol = iphdr->protocol;
-	pshdr.len = htons ( iob_len ( iobuf ) - hdrlen );
+	pshdr.len = htons ( iob_total_len ( iobuf ) - hdrlen );
 
 	/* Update the checksum value */
 	return tcpip_continue_chksum ( csum, &pshdr, sizeof ( pshdr ) );
@@ -481,7 +481,7 @@ static int ipv4_tx ( struct io_buffer *iobuf,
 	memset ( iphdr, 0, sizeof ( *iphdr ) );
 	iphdr->verhdrlen = ( IP_VER | ( sizeof ( *iphdr ) / 4 ) );
 	iphdr->service = IP_TOS;
-	iphdr->len = htons ( iob_len ( iobuf ) );	
+	iphdr->len = htons ( iob_total_len ( iobuf ) );
 	iphdr->ttl = IP_TTL;
 	iphdr->protocol = tcpip_protocol->tcpip_proto;
 	iphdr->dest = sin_dest->sin_addr;
@@ -515,9 +515,16 @@ static int ipv4_tx ( struct io_buffer *iobuf,
 
 	/* Fix up checksums */
 	if ( trans_csum ) {
+		if ( ( rc = tcpip_tx_chksum ( iobuf, netdev, iphdr,
+					      trans_csum ) ) != 0 )
+			goto err;
 		*trans_csum = ipv4_pshdr_chksum ( iobuf, *trans_csum );
-		if ( ! *trans_csum )
+		if ( iobuf->flags & IOB_TX_CSUM ) {
+			/* Leave pseudo-header sum for the hardware */
+			*trans_csum = ~*trans_csum;
+		} else if ( ! *trans_csum ) {
 			*trans_csum = tcpip_protocol->zero_csum;
+		}
 	}
 	iphdr->chksum = tcpip_chksum ( iphdr, sizeof ( *iphdr ) );
 
@@ -551,7 +558,7 @@ static int ipv4_tx ( struct io_buffer *iobuf,
 
 	/* Update statistics */
 	ipv4_stats.out_transmits++;
-	ipv4_stats.out_octets += iob_len ( iobuf );
+	ipv4_stats.out_octets += iob_total_len ( iobuf );
 
 	/* Hand off to link layer (via ARP if applicable) */
 	if ( ll_dest ) {
@@ -616,6 +623,68 @@ static int ipv4_has_addr ( struct net_device *netdev, struct in_addr addr ) {
 	return 0;
 }
 
+/**
+ * Merge received IPv4 packet
+ *
+ * @v iobuf		I/O buffer
+ * @v next		Subsequent I/O buffer
+ * @ret rc		Return status code, or required tailroom
+ *
+ * Only unfragmented packets without IPv4 options may be merged.
+ */
+static int ipv4_merge ( struct io_buffer *iobuf, struct io_buffer *next ) {
+	struct iphdr *iphdr = iobuf->data;
+	struct iphdr *nexthdr = next->data;
+	size_t len;
+	int rc;
+
+	/* Sanity check headers */
+	if ( ( iob_len ( iobuf ) < sizeof ( *iphdr ) ) ||
+	     ( iob_len ( next ) < sizeof ( *nexthdr ) ) )
+		return -EINVAL;
+	if ( ( iphdr->verhdrlen != ( IP_VER | ( sizeof ( *iphdr ) / 4 ) ) ) ||
+	     ( nexthdr->verhdrlen != iphdr->verhdrlen ) )
+		return -ENOTSUP;
+	if ( ( iphdr->frags | nexthdr->frags ) &
+	     htons ( IP_MASK_OFFSET | IP_MASK_MOREFRAGS ) )
+		return -ENOTSUP;
+	if ( ( ntohs ( iphdr->len ) != iob_len ( iobuf ) ) ||
+	     ( ntohs ( nexthdr->len ) != iob_len ( next ) ) )
+		return -ENOTSUP;
+	if ( ( tcpip_chksum ( iphdr, sizeof ( *iphdr ) ) != 0 ) ||
+	     ( tcpip_chksum ( nexthdr, sizeof ( *nexthdr ) ) != 0 ) )
+		return -EINVAL;
+
+	/* Check that packets belong to the same flow */
+	if ( ( nexthdr->service != iphdr->service ) ||
+	     ( nexthdr->ttl != iphdr->ttl ) ||
+	     ( nexthdr->protocol != iphdr->protocol ) ||
+	     ( nexthdr->src.s_addr != iphdr->src.s_addr ) ||
+	     ( nexthdr->dest.s_addr != iphdr->dest.s_addr ) )
+		return -ENOTSUP;
+
+	/* Check that merged length is representable */
+	len = ( iob_len ( iobuf ) + iob_len ( next ) - sizeof ( *nexthdr ) );
+	if ( len > 0xffff )
+		return -ERANGE;
+
+	/* Merge transport-layer segments */
+	iob_pull ( iobuf, sizeof ( *iphdr ) );
+	iob_pull ( next, sizeof ( *nexthdr ) );
+	rc = tcpip_merge ( iobuf, next, iphdr->protocol );
+	iob_push ( iobuf, sizeof ( *iphdr ) );
+	iob_push ( next, sizeof ( *nexthdr ) );
+	if ( rc != 0 )
+		return rc;
+
+	/* Update header */
+	iphdr->len = htons ( iob_len ( iobuf ) );
+	iphdr->chksum = 0;
+	iphdr->chksum = tcpip_chksum ( iphdr, sizeof ( *iphdr ) );
+
+	return 0;
+}
+
 /**
  * Process incoming packets
  *
@@ -866,6 +935,7 @@ struct net_protocol ipv4_protocol __net_protocol = {
 	.net_proto = htons ( ETH_P_IP ),
 	.net_addr_len = sizeof ( struct in_addr ),
 	.rx = ipv4_rx,
+	.merge = ipv4_merge,
 	.ntoa = ipv4_ntoa,
 };
 
@@ -544,7 +544,7 @@ static int ipv6_tx ( struct io_buffer *iobuf,
 	ipv6_stats.out_requests++;
 
 	/* Fill up the IPv6 header, except source address */
-	len = iob_len ( iobuf );
+	len = iob_total_len ( iobuf );
 	iphdr = iob_push ( iobuf, sizeof ( *iphdr ) );
 	memset ( iphdr, 0, sizeof ( *iphdr ) );
 	iphdr->ver_tc_label = htonl ( IPV6_VER );
@@ -574,11 +574,19 @@ static int ipv6_tx ( struct io_buffer *iobuf,
 
 	/* Fix up checksums */
 	if ( trans_csum ) {
+		iobuf->flags |= IOB_TX_IPV6;
+		if ( ( rc = tcpip_tx_chksum ( iobuf, netdev, iphdr,
+					      trans_csum ) ) != 0 )
+			goto err;
 		*trans_csum = ipv6_pshdr_chksum ( iphdr, len,
 						  tcpip_protocol->tcpip_proto,
 						  *trans_csum );
-		if ( ! *trans_csum )
+		if ( iobuf->flags & IOB_TX_CSUM ) {
+			/* Leave pseudo-header sum for the hardware */
+			*trans_csum = ~*trans_csum;
+		} else if ( ! *trans_csum ) {
 			*trans_csum = tcpip_protocol->zero_csum;
+		}
 	}
 
 	/* Print IPv6 header for debugging */
@@ -606,7 +614,7 @@ static int ipv6_tx ( struct io_buffer *iobuf,
 
 	/* Update statistics */
 	ipv6_stats.out_transmits++;
-	ipv6_stats.out_octets += iob_len ( iobuf );
+	ipv6_stats.out_octets += iob_total_len ( iobuf );
 
 	/* Hand off to link layer (via NDP if applicable) */
 	if ( ll_dest ) {
@@ -634,6 +642,64 @@ static int ipv6_tx ( struct io_buffer *iobuf,
 	return rc;
 }
 
+/**
+ * Merge received IPv6 packet
+ *
+ * @v iobuf		I/O buffer
+ * @v next		Subsequent I/O buffer
+ * @ret rc		Return status code, or required tailroom
+ *
+ * Only packets without IPv6 extension headers may be merged.
+ */
+static int ipv6_merge ( struct io_buffer *iobuf, struct io_buffer *next ) {
+	struct ipv6_header *iphdr = iobuf->data;
+	struct ipv6_header *nexthdr = next->data;
+	size_t len;
+	int rc;
+
+	/* Sanity check headers */
+	if ( ( iob_len ( iobuf ) < sizeof ( *iphdr ) ) ||
+	     ( iob_len ( next ) < sizeof ( *nexthdr ) ) )
+		return -EINVAL;
+	if ( ( iphdr->ver_tc_label & htonl ( IPV6_MASK_VER ) ) !=
+	     htonl ( IPV6_VER ) )
+		return -ENOTSUP;
+	if ( ( ntohs ( iphdr->len ) + sizeof ( *iphdr ) != iob_len ( iobuf ) ) ||
+	     ( ntohs ( nexthdr->len ) + sizeof ( *nexthdr ) !=
+	       iob_len ( next ) ) )
+		return -ENOTSUP;
+
+	/* Check that packets belong to the same flow */
+	if ( ( nexthdr->ver_tc_label != iphdr->ver_tc_label ) ||
+	     ( nexthdr->next_header != iphdr->next_header ) ||
+	     ( nexthdr->hop_limit != iphdr->hop_limit ) ||
+	     ( memcmp ( &nexthdr->src, &iphdr->src,
+			sizeof ( iphdr->src ) ) != 0 ) ||
+	     ( memcmp ( &nexthdr->dest, &iphdr->dest,
+			sizeof ( iphdr->dest ) ) != 0 ) )
+		return -ENOTSUP;
+
+	/* Check that merged length is representable */
+	len = ( iob_len ( iobuf ) + iob_len ( next ) -
+		( 2 * sizeof ( *iphdr ) ) );
+	if ( len > 0xffff )
+		return -ERANGE;
+
+	/* Merge transport-layer segments (rejecting extension headers) */
+	iob_pull ( iobuf, sizeof ( *iphdr ) );
+	iob_pull ( next, sizeof ( *nexthdr ) );
+	rc = tcpip_merge ( iobuf, next, iphdr->next_header );
+	iob_push ( iobuf, sizeof ( *iphdr ) );
+	iob_push ( next, sizeof ( *nexthdr ) );
+	if ( rc != 0 )
+		return rc;
+
+	/* Update header */
+	iphdr->len = htons ( iob_len ( iobuf ) - sizeof ( *iphdr ) );
+
+	return 0;
+}
+
 /**
  * Process incoming IPv6 packets
  *
@@ -1051,6 +1117,7 @@ struct net_protocol ipv6_protocol __net_protocol = {
 	.net_proto = htons ( ETH_P_IPV6 ),
 	.net_addr_len = sizeof ( struct in6_addr ),
 	.rx = ipv6_rx,
+	.merge = ipv6_merge,
 	.ntoa = ipv6_ntoa,
 };
 
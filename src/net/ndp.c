@@ -1102,6 +1102,8 @@ struct ipv6conf {
 
 	/** Deferred discovery counter */
 	unsigned int deferred;
+	/** Link was up when last checked */
+	int link_ok;
 };
 
 /** List of IPv6 configurators */
@@ -1249,6 +1251,40 @@ ipv6conf_rx_router_advertisement ( struct net_device *netdev,
 	return 0;
 }
 
+/**
+ * Handle network device state change during IPv6 autoconfiguration
+ *
+ * @v netdev		Network device
+ * @v priv		Private data
+ */
+static void ipv6conf_notify ( struct net_device *netdev, void *priv __unused ) {
+	struct ipv6conf *ipv6conf;
+	int link_ok = netdev_link_ok ( netdev );
+
+	/* Identify IPv6 configurator, if any */
+	ipv6conf = ipv6conf_demux ( netdev );
+	if ( ! ipv6conf )
+		return;
+
+	/* Solicit routers immediately when the link comes up, rather
+	 * than waiting for the (possibly backed-off) retransmission
+	 * timer, if we are still awaiting a router advertisement.
+	 */
+	if ( link_ok && ( ! ipv6conf->link_ok ) &&
+	     timer_running ( &ipv6conf->timer ) ) {
+		DBGC ( netdev, "NDP %s link up; soliciting routers\n",
+		       netdev->name );
+		start_timer_nodelay ( &ipv6conf->timer );
+	}
+	ipv6conf->link_ok = link_ok;
+}
+
+/** IPv6 configurator driver (for net device notifications) */
+struct net_driver ipv6conf_net_driver __net_driver = {
+	.name = "IPv6conf",
+	.notify = ipv6conf_notify,
+};
+
 /** IPv6 configurator job interface operations */
 static struct interface_operation ipv6conf_job_op[] = {
 	INTF_OP ( intf_close, struct ipv6conf *, ipv6conf_done ),
@@ -1288,6 +1324,7 @@ int start_ipv6conf ( struct interface *job, struct net_device *netdev ) {
 	set_timer_limits ( &ipv6conf->timer, IPV6CONF_MIN_TIMEOUT,
 			   IPV6CONF_MAX_TIMEOUT );
 	ipv6conf->netdev = netdev_get ( netdev );
+	ipv6conf->link_ok = netdev_link_ok ( netdev );
 
 	/* Start timer to initiate router solicitation */
 	start_timer_nodelay ( &ipv6conf->timer );
@@ -63,9 +63,18 @@ FILE_SECBOOT ( PERMITTED );
  */
 #define NEIGHBOUR_DELAY_MAX_BURST 2
 
-/** The neighbour cache */
+/** Number of neighbour cache hash chains
+ *
+ * This must be a power of two.
+ */
+#define NEIGHBOUR_HASH_SIZE 16
+
+/** The neighbour cache (in order of most recent use) */
 struct list_head neighbours = LIST_HEAD_INIT ( neighbours );
 
+/** The neighbour cache hash chains (each in order of most recent use) */
+static struct list_head neighbour_hash[NEIGHBOUR_HASH_SIZE];
+
 /** Pending operation for delayed transmissions */
 static struct pending_operation neighbour_delayed;
 
@@ -90,6 +99,34 @@ static void neighbour_free ( struct refcnt *refcnt ) {
 	free ( neighbour );
 }
 
+/**
+ * Identify neighbour cache hash chain
+ *
+ * @v netdev		Network device
+ * @v net_protocol	Network-layer protocol
+ * @v net_dest		Destination network-layer address
+ * @ret chain		Hash chain
+ */
+static struct list_head * neighbour_chain ( struct net_device *netdev,
+					    struct net_protocol *net_protocol,
+					    const void *net_dest ) {
+	const uint8_t *byte = net_dest;
+	struct list_head *chain;
+	unsigned int hash = netdev->scope_id;
+	unsigned int i;
+
+	/* Hash network device and destination address */
+	for ( i = 0 ; i < net_protocol->net_addr_len ; i++ )
+		hash = ( ( hash * 31 ) + byte[i] );
+	chain = &neighbour_hash[ hash & ( NEIGHBOUR_HASH_SIZE - 1 ) ];
+
+	/* Initialise hash chain, if applicable */
+	if ( ! chain->next )
+		INIT_LIST_HEAD ( chain );
+
+	return chain;
+}
+
 /**
  * Create neighbour cache entry
  *
@@ -119,6 +156,8 @@ static struct neighbour * neighbour_create ( struct net_device *netdev,
 
 	/* Transfer ownership to cache */
 	list_add ( &neighbour->list, &neighbours );
+	list_add ( &neighbour->hash,
+		   neighbour_chain ( netdev, net_protocol, net_dest ) );
 
 	DBGC ( neighbour, "NEIGHBOUR %s %s %s created\n", netdev->name,
 	       net_protocol->name, net_protocol->ntoa ( net_dest ) );
@@ -136,17 +175,21 @@ static struct neighbour * neighbour_create ( struct net_device *netdev,
 static struct neighbour * neighbour_find ( struct net_device *netdev,
 					   struct net_protocol *net_protocol,
 					   const void *net_dest ) {
+	struct list_head *chain;
 	struct neighbour *neighbour;
 
-	list_for_each_entry ( neighbour, &neighbours, list ) {
+	chain = neighbour_chain ( netdev, net_protocol, net_dest );
+	list_for_each_entry ( neighbour, chain, hash ) {
 		if ( ( neighbour->netdev == netdev ) &&
 		     ( neighbour->net_protocol == net_protocol ) &&
 		     ( memcmp ( neighbour->net_dest, net_dest,
 				net_protocol->net_addr_len ) == 0 ) ) {
 
-			/* Move to start of cache */
+			/* Move to start of cache and of hash chain */
 			list_del ( &neighbour->list );
 			list_add ( &neighbour->list, &neighbours );
+			list_del ( &neighbour->hash );
+			list_add ( &neighbour->hash, chain );
 
 			return neighbour;
 		}
@@ -292,6 +335,7 @@ static void neighbour_destroy ( struct neighbour *neighbour, int rc ) {
 
 	/* Take ownership from cache */
 	list_del ( &neighbour->list );
+	list_del ( &neighbour->hash );
 
 	/* Stop timer */
 	stop_timer ( &neighbour->timer );
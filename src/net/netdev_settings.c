@@ -87,6 +87,48 @@ const struct setting mtu_setting __setting ( SETTING_NETDEV, mtu ) = {
 	.type = &setting_type_int16,
 	.tag = DHCP_MTU,
 };
+const struct setting txbytes_setting __setting ( SETTING_NETDEV_EXTRA,
+						 txbytes ) = {
+	.name = "txbytes",
+	.description = "Bytes transmitted",
+	.type = &setting_type_uint32,
+};
+const struct setting rxbytes_setting __setting ( SETTING_NETDEV_EXTRA,
+						 rxbytes ) = {
+	.name = "rxbytes",
+	.description = "Bytes received",
+	.type = &setting_type_uint32,
+};
+const struct setting txdeferred_setting __setting ( SETTING_NETDEV_EXTRA,
+						    txdeferred ) = {
+	.name = "txdeferred",
+	.description = "Deferred transmissions",
+	.type = &setting_type_uint32,
+};
+const struct setting rxrefillerrs_setting __setting ( SETTING_NETDEV_EXTRA,
+						      rxrefillerrs ) = {
+	.name = "rxrefillerrs",
+	.description = "Receive refill failures",
+	.type = &setting_type_uint32,
+};
+const struct setting rxempty_setting __setting ( SETTING_NETDEV_EXTRA,
+						 rxempty ) = {
+	.name = "rxempty",
+	.description = "Receive ring empty events",
+	.type = &setting_type_uint32,
+};
+const struct setting idlepolls_setting __setting ( SETTING_NETDEV_EXTRA,
+						   idlepolls ) = {
+	.name = "idlepolls",
+	.description = "Idle polls",
+	.type = &setting_type_uint32,
+};
+const struct setting rxpollmax_setting __setting ( SETTING_NETDEV_EXTRA,
+						   rxpollmax ) = {
+	.name = "rxpollmax",
+	.description = "Maximum packets received per poll",
+	.type = &setting_type_uint32,
+};
 
 /**
  * Store link-layer address setting
@@ -274,6 +316,122 @@ static int netdev_fetch_ifname ( struct net_device *netdev, void *data,
 	return strlen ( ifname );
 }
 
+/**
+ * Fetch datapath statistic setting
+ *
+ * @v data		Buffer to fill with setting data
+ * @v len		Length of buffer
+ * @v value		Statistic value
+ * @ret len		Length of setting data, or negative error
+ */
+static int netdev_fetch_stat ( void *data, size_t len, unsigned long value ) {
+	uint32_t content;
+
+	content = htonl ( value );
+	if ( len > sizeof ( content ) )
+		len = sizeof ( content );
+	memcpy ( data, &content, len );
+	return sizeof ( content );
+}
+
+/**
+ * Fetch transmitted byte count setting
+ *
+ * @v netdev		Network device
+ * @v data		Buffer to fill with setting data
+ * @v len		Length of buffer
+ * @ret len		Length of setting data, or negative error
+ */
+static int netdev_fetch_txbytes ( struct net_device *netdev, void *data,
+				  size_t len ) {
+
+	return netdev_fetch_stat ( data, len, netdev->dp_stats.tx_octets );
+}
+
+/**
+ * Fetch received byte count setting
+ *
+ * @v netdev		Network device
+ * @v data		Buffer to fill with setting data
+ * @v len		Length of buffer
+ * @ret len		Length of setting data, or negative error
+ */
+static int netdev_fetch_rxbytes ( struct net_device *netdev, void *data,
+				  size_t len ) {
+
+	return netdev_fetch_stat ( data, len, netdev->dp_stats.rx_octets );
+}
+
+/**
+ * Fetch deferred transmission count setting
+ *
+ * @v netdev		Network device
+ * @v data		Buffer to fill with setting data
+ * @v len		Length of buffer
+ * @ret len		Length of setting data, or negative error
+ */
+static int netdev_fetch_txdeferred ( struct net_device *netdev, void *data,
+				     size_t len ) {
+
+	return netdev_fetch_stat ( data, len, netdev->dp_stats.tx_deferred );
+}
+
+/**
+ * Fetch receive refill failure count setting
+ *
+ * @v netdev		Network device
+ * @v data		Buffer to fill with setting data
+ * @v len		Length of buffer
+ * @ret len		Length of setting data, or negative error
+ */
+static int netdev_fetch_rxrefillerrs ( struct net_device *netdev, void *data,
+				       size_t len ) {
+
+	return netdev_fetch_stat ( data, len, netdev->dp_stats.rx_refill_errs );
+}
+
+/**
+ * Fetch receive ring empty event count setting
+ *
+ * @v netdev		Network device
+ * @v data		Buffer to fill with setting data
+ * @v len		Length of buffer
+ * @ret len		Length of setting data, or negative error
+ */
+static int netdev_fetch_rxempty ( struct net_device *netdev, void *data,
+				  size_t len ) {
+
+	return netdev_fetch_stat ( data, len, netdev->dp_stats.rx_empty );
+}
+
+/**
+ * Fetch idle poll count setting
+ *
+ * @v netdev		Network device
+ * @v data		Buffer to fill with setting data
+ * @v len		Length of buffer
+ * @ret len		Length of setting data, or negative error
+ */
+static int netdev_fetch_idlepolls ( struct net_device *netdev, void *data,
+				    size_t len ) {
+
+	return netdev_fetch_stat ( data, len, netdev->dp_stats.idle_polls );
+}
+
+/**
+ * Fetch maximum packets received per poll setting
+ *
+ * @v netdev		Network device
+ * @v data		Buffer to fill with setting data
+ * @v len		Length of buffer
+ * @ret len		Length of setting data, or negative error
+ */
+static int netdev_fetch_rxpollmax ( struct net_device *netdev, void *data,
+				    size_t len ) {
+
+	return netdev_fetch_stat ( data, len, netdev->dp_stats.rx_max_per_poll );
+}
+
 /** A network device setting operation */
 struct netdev_setting_operation {
 	/** Setting */
@@ -307,6 +465,13 @@ static struct netdev_setting_operation netdev_setting_operations[] = {
 	{ &linktype_setting, NULL, netdev_fetch_linktype },
 	{ &chip_setting, NULL, netdev_fetch_chip },
 	{ &ifname_setting, NULL, netdev_fetch_ifname },
+	{ &txbytes_setting, NULL, netdev_fetch_txbytes },
+	{ &rxbytes_setting, NULL, netdev_fetch_rxbytes },
+	{ &txdeferred_setting, NULL, netdev_fetch_txdeferred },
+	{ &rxrefillerrs_setting, NULL, netdev_fetch_rxrefillerrs },
+	{ &rxempty_setting, NULL, netdev_fetch_rxempty },
+	{ &idlepolls_setting, NULL, netdev_fetch_idlepolls },
+	{ &rxpollmax_setting, NULL, netdev_fetch_rxpollmax },
 };
 
 /**
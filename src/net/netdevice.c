@@ -43,6 +43,7 @@ FILE_SECBOOT ( PERMITTED );
 #include <ipxe/fault.h>
 #include <ipxe/vlan.h>
 #include <ipxe/netdevice.h>
+#include <ipxe/pcap.h>
 
 /** @file
  *
@@ -85,6 +86,19 @@ static struct profiler net_tx_profiler __profiler = { .name = "net.tx" };
 #define EINFO_ENOTCONN_LINK_DOWN \
 	__einfo_uniqify ( EINFO_ENOTCONN, 0x01, "Down" )
 
+#ifdef NETDEV_DIRECT
+/** Devirtualised network device operations (if any)
+ *
+ * The address of a possibly undefined weak symbol must be loaded via
+ * the global offset table, which the linker may relax into an
+ * absolute relocation that cannot be represented in an EFI image.
+ * Hold the address in a variable instead, so that it is fixed up via
+ * an ordinary data relocation.  The variable is deliberately
+ * non-static, to prevent the compiler from folding it away.
+ */
+struct net_device_operations *netdev_direct = &netdev_direct_operations;
+#endif
+
 /** Human-readable message for the default link statuses */
 struct errortab netdev_errors[] __errortab = {
 	__einfo_errortab ( EINFO_EUNKNOWN_LINK_STATUS ),
@@ -93,6 +107,40 @@ struct errortab netdev_errors[] __errortab = {
 	__einfo_errortab ( EINFO_EINPROGRESS_CONFIG ),
 };
 
+/**
+ * Call network device transmit method
+ *
+ * @v netdev		Network device
+ * @v iobuf		I/O buffer
+ * @ret rc		Return status code
+ */
+static inline __attribute__ (( always_inline )) int
+netdev_op_transmit ( struct net_device *netdev, struct io_buffer *iobuf ) {
+
+#ifdef NETDEV_DIRECT
+	if ( netdev->state & NETDEV_DIRECT_OPS )
+		return netdev_direct_transmit ( netdev, iobuf );
+#endif
+	return netdev->op->transmit ( netdev, iobuf );
+}
+
+/**
+ * Call network device poll method
+ *
+ * @v netdev		Network device
+ */
+static inline __attribute__ (( always_inline )) void
+netdev_op_poll ( struct net_device *netdev ) {
+
+#ifdef NETDEV_DIRECT
+	if ( netdev->state & NETDEV_DIRECT_OPS ) {
+		netdev_direct_poll ( netdev );
+		return;
+	}
+#endif
+	netdev->op->poll ( netdev );
+}
+
 /**
  * Check whether or not network device has a link-layer address
  *
@@ -322,6 +370,50 @@ static void netdev_record_stat ( struct net_device_stats *stats, int rc ) {
 	least_common_error->count = 1;
 }
 
+/**
+ * Map I/O buffer (and any fragments) for transmit DMA
+ *
+ * @v netdev		Network device
+ * @v iobuf		I/O buffer
+ * @ret rc		Return status code
+ */
+static int netdev_map_tx ( struct net_device *netdev,
+			   struct io_buffer *iobuf ) {
+	int rc;
+
+	for ( ; iobuf ; iobuf = iobuf->frag ) {
+		if ( dma_mapped ( &iobuf->map ) )
+			continue;
+		if ( ( rc = iob_map_tx ( iobuf, netdev->dma ) ) != 0 )
+			return rc;
+	}
+	return 0;
+}
+
+/**
+ * Unmap I/O buffer (and any fragments) for transmit DMA
+ *
+ * @v iobuf		I/O buffer
+ */
+static void netdev_unmap_tx ( struct io_buffer *iobuf ) {
+
+	for ( ; iobuf ; iobuf = iobuf->frag ) {
+		if ( dma_mapped ( &iobuf->map ) )
+			iob_unmap ( iobuf );
+	}
+}
+
+/**
+ * Capture packet (when packet capture is not present)
+ *
+ * @v netdev		Network device
+ * @v iobuf		I/O buffer
+ */
+__weak void pcap_capture ( struct net_device *netdev __unused,
+			   struct io_buffer *iobuf __unused ) {
+	/* Do nothing */
+}
+
 /**
  * Transmit raw packet via network device
  *
@@ -333,12 +425,30 @@ static void netdev_record_stat ( struct net_device_stats *stats, int rc ) {
  * function takes ownership of the I/O buffer.
  */
 int netdev_tx ( struct net_device *netdev, struct io_buffer *iobuf ) {
+	struct io_buffer *linear;
+	size_t len;
 	int rc;
 
 	DBGC2 ( netdev, "NETDEV %s transmitting %p (%p+%zx)\n",
 		netdev->name, iobuf, iobuf->data, iob_len ( iobuf ) );
 	profile_start ( &net_tx_profiler );
 
+	/* Linearise chained I/O buffer, if required */
+	if ( iobuf->frag &&
+	     ( ! ( netdev->tx_offloads & NETDEV_TX_OFFLOAD_SG ) ) ) {
+		linear = iob_linearise ( iobuf );
+		if ( ! linear ) {
+			rc = -ENOMEM;
+			netdev_tx_err ( netdev, iobuf, rc );
+			return rc;
+		}
+		iobuf = linear;
+	}
+
+	/* Capture packet, if applicable */
+	if ( netdev->pcap )
+		pcap_capture ( netdev, iobuf );
+
 	/* Enqueue packet */
 	list_add_tail ( &iobuf->list, &netdev->tx_queue );
 
@@ -360,14 +470,16 @@ int netdev_tx ( struct net_device *netdev, struct io_buffer *iobuf ) {
 		goto err_fault;
 
 	/* Map for DMA, if required */
-	if ( netdev->dma && ( ! dma_mapped ( &iobuf->map ) ) ) {
-		if ( ( rc = iob_map_tx ( iobuf, netdev->dma ) ) != 0 )
+	if ( netdev->dma ) {
+		if ( ( rc = netdev_map_tx ( netdev, iobuf ) ) != 0 )
 			goto err_map;
 	}
 
-	/* Transmit packet */
-	if ( ( rc = netdev->op->transmit ( netdev, iobuf ) ) != 0 )
+	/* Transmit packet (which may complete immediately) */
+	len = iob_total_len ( iobuf );
+	if ( ( rc = netdev_op_transmit ( netdev, iobuf ) ) != 0 )
 		goto err_transmit;
+	netdev->dp_stats.tx_octets += len;
 
 	/* Clear in-progress flag */
 	netdev->state &= ~NETDEV_TX_IN_PROGRESS;
@@ -420,6 +532,7 @@ void netdev_tx_defer ( struct net_device *netdev, struct io_buffer *iobuf ) {
 
 	/* Add to deferred transmit queue */
 	list_add_tail ( &iobuf->list, &netdev->tx_deferred );
+	netdev->dp_stats.tx_deferred++;
 
 	/* Record "out of space" statistic */
 	netdev_tx_err ( netdev, NULL, -ENOBUFS );
@@ -452,8 +565,7 @@ void netdev_tx_err ( struct net_device *netdev,
 	}
 
 	/* Unmap I/O buffer, if required */
-	if ( iobuf && dma_mapped ( &iobuf->map ) )
-		iob_unmap ( iobuf );
+	netdev_unmap_tx ( iobuf );
 
 	/* Discard packet */
 	free_iob ( iobuf );
@@ -535,18 +647,18 @@ static void netdev_tx_flush ( struct net_device *netdev ) {
 }
 
 /**
- * Add packet to receive queue
+ * Accept received packet
  *
  * @v netdev		Network device
  * @v iobuf		I/O buffer
+ * @ret rc		Return status code
  *
- * The packet is added to the network device's RX queue.  This
- * function takes ownership of the I/O buffer.
- *
- * The I/O buffer will be automatically unmapped for DMA, if
- * applicable.
+ * The I/O buffer will be unmapped for DMA (if applicable) and the
+ * receive statistics updated.  If the packet is discarded then
+ * ownership of the I/O buffer is taken and an RX error is recorded.
  */
-void netdev_rx ( struct net_device *netdev, struct io_buffer *iobuf ) {
+static int netdev_rx_accept ( struct net_device *netdev,
+			      struct io_buffer *iobuf ) {
 	int rc;
 
 	DBGC2 ( netdev, "NETDEV %s received %p (%p+%zx)\n",
@@ -555,18 +667,71 @@ void netdev_rx ( struct net_device *netdev, struct io_buffer *iobuf ) {
 	/* Discard packet (for test purposes) if applicable */
 	if ( ( rc = inject_fault ( NETDEV_DISCARD_RATE ) ) != 0 ) {
 		netdev_rx_err ( netdev, iobuf, rc );
-		return;
+		return rc;
 	}
 
 	/* Unmap I/O buffer, if required */
 	if ( dma_mapped ( &iobuf->map ) )
 		iob_unmap ( iobuf );
 
-	/* Enqueue packet */
-	list_add_tail ( &iobuf->list, &netdev->rx_queue );
-
-	/* Update statistics counter */
+	/* Update statistics counters */
 	netdev_record_stat ( &netdev->rx_stats, 0 );
+	netdev->dp_stats.rx_octets += iob_len ( iobuf );
+
+	/* Capture packet, if applicable */
+	if ( netdev->pcap )
+		pcap_capture ( netdev, iobuf );
+
+	return 0;
+}
+
+/**
+ * Add packet to receive queue
+ *
+ * @v netdev		Network device
+ * @v iobuf		I/O buffer
+ *
+ * The packet is added to the network device's RX queue.  This
+ * function takes ownership of the I/O buffer.
+ *
+ * The I/O buffer will be automatically unmapped for DMA, if
+ * applicable.
+ */
+void netdev_rx ( struct net_device *netdev, struct io_buffer *iobuf ) {
+
+	/* Accept and enqueue packet */
+	if ( netdev_rx_accept ( netdev, iobuf ) == 0 )
+		list_add_tail ( &iobuf->list, &netdev->rx_queue );
+}
+
+/**
+ * Add list of packets to receive queue
+ *
+ * @v netdev		Network device
+ * @v list		List of I/O buffers
+ *
+ * The packets are added to the network device's RX queue, in order.
+ * This function takes ownership of all I/O buffers within the list,
+ * and leaves the list empty.
+ *
+ * Drivers may use this to hand over all packets received during a
+ * single poll in one operation, rather than calling netdev_rx() for
+ * each packet.
+ *
+ * The I/O buffers will be automatically unmapped for DMA, if
+ * applicable.
+ */
+void netdev_rx_batch ( struct net_device *netdev, struct list_head *list ) {
+	struct io_buffer *iobuf;
+	struct io_buffer *tmp;
+
+	/* Accept each packet, removing any discarded packets */
+	list_for_each_entry_safe ( iobuf, tmp, list, list ) {
+		list_del ( &iobuf->list );
+		if ( netdev_rx_accept ( netdev, iobuf ) == 0 )
+			list_add_tail ( &iobuf->list, &netdev->rx_queue );
+	}
+	assert ( list_empty ( list ) );
 }
 
 /**
@@ -611,6 +776,9 @@ void netdev_rx_err ( struct net_device *netdev,
  * via netdev_rx().
  */
 void netdev_poll ( struct net_device *netdev ) {
+	struct net_device_datapath_stats *dp_stats = &netdev->dp_stats;
+	unsigned int tx;
+	unsigned int rx;
 
 	/* Call poll() only on open (or insomniac) network devices */
 	if ( ! ( netdev->state & ( NETDEV_OPEN | NETDEV_INSOMNIAC ) ) )
@@ -620,10 +788,23 @@ void netdev_poll ( struct net_device *netdev ) {
 	if ( netdev->state & NETDEV_POLL_IN_PROGRESS )
 		return;
 
+	/* Record completion counts prior to poll */
+	tx = ( netdev->tx_stats.good + netdev->tx_stats.bad );
+	rx = ( netdev->rx_stats.good + netdev->rx_stats.bad );
+
 	/* Poll device */
 	netdev->state |= NETDEV_POLL_IN_PROGRESS;
-	netdev->op->poll ( netdev );
+	netdev_op_poll ( netdev );
 	netdev->state &= ~NETDEV_POLL_IN_PROGRESS;
+
+	/* Update datapath statistics */
+	tx = ( netdev->tx_stats.good + netdev->tx_stats.bad - tx );
+	rx = ( netdev->rx_stats.good + netdev->rx_stats.bad - rx );
+	dp_stats->polls++;
+	if ( ! ( tx || rx ) )
+		dp_stats->idle_polls++;
+	if ( dp_stats->rx_max_per_poll < rx )
+		dp_stats->rx_max_per_poll = rx;
 }
 
 /**
@@ -809,6 +990,12 @@ int register_netdev ( struct net_device *netdev ) {
 			  - sizeof ( seed ) ), sizeof ( seed ) );
 	srand ( rand() ^ seed );
 
+#ifdef NETDEV_DIRECT
+	/* Use devirtualised operations, if applicable */
+	if ( netdev->op == netdev_direct )
+		netdev->state |= NETDEV_DIRECT_OPS;
+#endif
+
 	/* Add to device list */
 	netdev_get ( netdev );
 	list_add_tail ( &netdev->list, &net_devices );
@@ -1107,13 +1294,26 @@ int net_tx ( struct io_buffer *iobuf, struct net_device *netdev,
 int net_rx ( struct io_buffer *iobuf, struct net_device *netdev,
 	     uint16_t net_proto, const void *ll_dest, const void *ll_source,
 	     unsigned int flags ) {
+	static struct net_protocol *cached;
 	struct net_protocol *net_protocol;
 
+	/* Hand off to most recently used network-layer protocol, if
+	 * applicable.  Received packets tend to arrive in batches
+	 * using the same protocol.
+	 */
+	net_protocol = cached;
+	if ( net_protocol && ( net_protocol->net_proto == net_proto ) ) {
+		return net_protocol->rx ( iobuf, netdev, ll_dest,
+					  ll_source, flags );
+	}
+
 	/* Hand off to network-layer protocol, if any */
 	for_each_table_entry ( net_protocol, NET_PROTOCOLS ) {
-		if ( net_protocol->net_proto == net_proto )
+		if ( net_protocol->net_proto == net_proto ) {
+			cached = net_protocol;
 			return net_protocol->rx ( iobuf, netdev, ll_dest,
 						  ll_source, flags );
+		}
 	}
 
 	DBGC ( netdev, "NETDEV %s unknown network protocol %04x\n",
@@ -1122,6 +1322,112 @@ int net_rx ( struct io_buffer *iobuf, struct net_device *netdev,
 	return -ENOTSUP;
 }
 
+/**
+ * Find network-layer protocol
+ *
+ * @v net_proto		Network-layer protocol, in network-byte order
+ * @ret net_protocol	Network-layer protocol, or NULL if not found
+ */
+static struct net_protocol * net_find_protocol ( uint16_t net_proto ) {
+	struct net_protocol *net_protocol;
+
+	for_each_table_entry ( net_protocol, NET_PROTOCOLS ) {
+		if ( net_protocol->net_proto == net_proto )
+			return net_protocol;
+	}
+	return NULL;
+}
+
+/**
+ * Merge subsequent received packets into a received packet
+ *
+ * @v netdev		Network device
+ * @v iobuf		I/O buffer (with link-layer header removed)
+ * @v ll_len		Length of removed link-layer header
+ * @v net_proto		Network-layer protocol, in network-byte order
+ * @v ll_dest		Destination link-layer address to update
+ * @v ll_source		Source link-layer address to update
+ * @ret iobuf		I/O buffer
+ *
+ * Packets waiting on the receive queue that have verified checksums
+ * and link-layer headers identical to that of the received packet
+ * are offered to the network-layer protocol for merging.  The
+ * received packet will be moved to a larger I/O buffer if necessary.
+ */
+static struct io_buffer * netdev_rx_merge ( struct net_device *netdev,
+					    struct io_buffer *iobuf,
+					    size_t ll_len, uint16_t net_proto,
+					    const void **ll_dest,
+					    const void **ll_source ) {
+	struct net_protocol *net_protocol;
+	struct io_buffer *next;
+	struct io_buffer *merged;
+	void *frame;
+	void *new_frame;
+	size_t len;
+	int rc;
+
+	/* Do nothing unless network-layer protocol supports merging */
+	net_protocol = net_find_protocol ( net_proto );
+	if ( ! ( net_protocol && net_protocol->merge ) )
+		return iobuf;
+
+	/* Merge packets until no further merging is possible */
+	while ( ( next = list_first_entry ( &netdev->rx_queue,
+					    struct io_buffer, list ) ) ) {
+
+		/* Require verified checksum and identical link-layer
+		 * header.
+		 */
+		frame = ( iobuf->data - ll_len );
+		if ( ! ( next->flags & IOB_CSUM_VALID ) )
+			break;
+		if ( ( iob_len ( next ) < ll_len ) ||
+		     ( memcmp ( next->data, frame, ll_len ) != 0 ) )
+			break;
+
+		/* Attempt merge, moving to a larger I/O buffer if needed */
+		iob_pull ( next, ll_len );
+		rc = net_protocol->merge ( iobuf, next );
+		len = iob_len ( iobuf );
+		if ( ( rc > 0 ) &&
+		     ( ( ll_len + len + rc ) <= NETDEV_RX_MERGE_LEN ) &&
+		     ( merged = alloc_iob ( NETDEV_RX_MERGE_LEN ) ) ) {
+			iob_reserve ( merged, ll_len );
+			new_frame = ( merged->data - ll_len );
+			memcpy ( new_frame, frame, ( ll_len + len ) );
+			iob_put ( merged, len );
+			merged->flags = iobuf->flags;
+			if ( ( *ll_dest >= frame ) &&
+			     ( *ll_dest < iobuf->data ) ) {
+				*ll_dest = ( new_frame +
+					     ( *ll_dest - frame ) );
+			}
+			if ( ( *ll_source >= frame ) &&
+			     ( *ll_source < iobuf->data ) ) {
+				*ll_source = ( new_frame +
+					       ( *ll_source - frame ) );
+			}
+			free_iob ( iobuf );
+			iobuf = merged;
+			rc = net_protocol->merge ( iobuf, next );
+		}
+		if ( rc != 0 ) {
+			iob_push ( next, ll_len );
+			break;
+		}
+
+		/* Discard merged packet */
+		DBGC2 ( netdev, "NETDEV %s merged %p into %p (%p+%zx)\n",
+			netdev->name, next, iobuf, iobuf->data,
+			iob_len ( iobuf ) );
+		list_del ( &next->list );
+		free_iob ( next );
+	}
+
+	return iobuf;
+}
+
 /**
  * Poll the network stack
  *
@@ -1134,8 +1440,10 @@ void net_poll ( void ) {
 	struct ll_protocol *ll_protocol;
 	const void *ll_dest;
 	const void *ll_source;
+	void *frame;
 	uint16_t net_proto;
 	unsigned int flags;
+	unsigned int budget;
 	int rc;
 
 	/* Poll and process each network device */
@@ -1146,6 +1454,12 @@ void net_poll ( void ) {
 		netdev_poll ( netdev );
 		profile_stop ( &net_poll_profiler );
 
+		/* Record activity, if applicable */
+		if ( ! ( list_empty ( &netdev->rx_queue ) &&
+			 list_empty ( &netdev->tx_queue ) ) ) {
+			process_active();
+		}
+
 		/* Leave received packets on the queue if receive
 		 * queue processing is currently frozen.  This will
 		 * happen when the raw packets are to be manually
@@ -1155,8 +1469,16 @@ void net_poll ( void ) {
 		if ( netdev_rx_frozen ( netdev ) )
 			continue;
 
-		/* Process all received packets */
-		while ( ( iobuf = netdev_rx_dequeue ( netdev ) ) ) {
+		/* Process received packets, up to the receive budget.
+		 * Any remaining packets will be left on the queue
+		 * until the next poll.
+		 */
+		for ( budget = NETDEV_RX_BUDGET ; budget ; budget-- ) {
+
+			/* Dequeue next received packet, if any */
+			iobuf = netdev_rx_dequeue ( netdev );
+			if ( ! iobuf )
+				break;
 
 			DBGC2 ( netdev, "NETDEV %s processing %p (%p+%zx)\n",
 				netdev->name, iobuf, iobuf->data,
@@ -1165,6 +1487,7 @@ void net_poll ( void ) {
 
 			/* Remove link-layer header */
 			ll_protocol = netdev->ll_protocol;
+			frame = iobuf->data;
 			if ( ( rc = ll_protocol->pull ( netdev, iobuf,
 							&ll_dest, &ll_source,
 							&net_proto,
@@ -1173,6 +1496,15 @@ void net_poll ( void ) {
 				continue;
 			}
 
+			/* Merge subsequent packets within the same flow */
+			if ( iobuf->flags & IOB_CSUM_VALID ) {
+				iobuf = netdev_rx_merge ( netdev, iobuf,
+							  ( iobuf->data -
+							    frame ),
+							  net_proto, &ll_dest,
+							  &ll_source );
+			}
+
 			/* Hand packet to network layer */
 			if ( ( rc = net_rx ( iob_disown ( iobuf ), netdev,
 					     net_proto, ll_dest,
@@ -1257,8 +1589,7 @@ static unsigned int net_discard ( void ) {
 
 			/* Discard first deferred packet */
 			list_del ( &iobuf->list );
-			if ( dma_mapped ( &iobuf->map ) )
-				iob_unmap ( iobuf );
+			netdev_unmap_tx ( iobuf );
 			free_iob ( iobuf );
 
 			/* Report discard */
@@ -50,6 +50,8 @@ FILE_SECBOOT ( FORBIDDEN );
 #define NFS_READLINK    5
 /** NFS READ procedure */
 #define NFS_READ        6
+/** NFS FSINFO procedure */
+#define NFS_FSINFO      19
 
 /**
  * Extract a file handle from the beginning of an I/O buffer
@@ -124,6 +126,24 @@ int nfs_readlink ( struct interface *intf, struct oncrpc_session *session,
 	return oncrpc_call ( intf, session, NFS_READLINK, fields );
 }
 
+/**
+ * Send a FSINFO request
+ *
+ * @v intf              Interface to send the request on
+ * @v session           ONC RPC session
+ * @v fh                The file handle
+ * @ret rc              Return status code
+ */
+int nfs_fsinfo ( struct interface *intf, struct oncrpc_session *session,
+                 const struct nfs_fh *fh ) {
+	struct oncrpc_field fields[] = {
+		ONCRPC_SUBFIELD ( array, fh->size, &fh->fh ),
+		ONCRPC_FIELD_END,
+	};
+
+	return oncrpc_call ( intf, session, NFS_FSINFO, fields );
+}
+
 /**
  * Send a READ request
  *
@@ -233,6 +253,45 @@ int nfs_get_readlink_reply ( struct nfs_readlink_reply *readlink_reply,
 	return 0;
 }
 
+/**
+ * Parse a FSINFO reply
+ *
+ * @v fsinfo_reply      A structure where the data will be saved
+ * @v reply             The ONC RPC reply to get data from
+ * @ret rc              Return status code
+ */
+int nfs_get_fsinfo_reply ( struct nfs_fsinfo_reply *fsinfo_reply,
+                           struct oncrpc_reply *reply ) {
+	if ( ! fsinfo_reply || ! reply )
+		return -EINVAL;
+
+	fsinfo_reply->status = oncrpc_iob_get_int ( reply->data );
+	switch ( fsinfo_reply->status )
+	{
+	case NFS3_OK:
+		 break;
+	case NFS3ERR_STALE:
+		return -ESTALE;
+	case NFS3ERR_BADHANDLE:
+	case NFS3ERR_SERVERFAULT:
+	default:
+		return -EPROTO;
+	}
+
+	fsinfo_reply->attr = oncrpc_iob_get_int ( reply->data );
+	if ( fsinfo_reply->attr == 1 )
+	{
+		iob_pull ( reply->data, 5 * sizeof ( uint32_t ) );
+		fsinfo_reply->filesize = oncrpc_iob_get_int64 ( reply->data );
+		iob_pull ( reply->data, 7 * sizeof ( uint64_t ) );
+	}
+
+	fsinfo_reply->rtmax  = oncrpc_iob_get_int ( reply->data );
+	fsinfo_reply->rtpref = oncrpc_iob_get_int ( reply->data );
+
+	return 0;
+}
+
 /**
  * Parse a READ reply
  *
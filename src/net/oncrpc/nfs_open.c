@@ -36,6 +36,7 @@ FILE_SECBOOT ( FORBIDDEN );
 #include <ipxe/open.h>
 #include <ipxe/uri.h>
 #include <ipxe/features.h>
+#include <ipxe/settings.h>
 #include <ipxe/nfs.h>
 #include <ipxe/nfs_open.h>
 #include <ipxe/oncrpc.h>
@@ -52,8 +53,26 @@ FILE_SECBOOT ( FORBIDDEN );
 
 FEATURE ( FEATURE_PROTOCOL, "NFS", DHCP_EB_FEATURE_NFS, 1 );
 
+/** Default READ request size */
 #define NFS_RSIZE 100000
 
+/** Maximum READ request size */
+#define NFS_MAX_RSIZE 1048576
+
+/** Default number of READ requests in flight */
+#define NFS_DEFAULT_DEPTH 4
+
+/** Maximum number of READ requests in flight */
+#define NFS_MAX_DEPTH 16
+
+/** Maximum length of a READ reply header
+ *
+ * This comprises the record marker, the RPC reply header (allowing
+ * for a maximum-length verifier), the status, the optional file
+ * attributes, and the count, EOF and data length fields.
+ */
+#define NFS_READ_HDR_MAX ( 33 * sizeof ( uint32_t ) + ONCRPC_MAX_AUTH_BYTES )
+
 enum nfs_pm_state {
 	NFS_PORTMAP_NONE = 0,
 	NFS_PORTMAP_MOUNTPORT,
@@ -74,11 +93,25 @@ enum nfs_state {
 	NFS_LOOKUP_SENT,
 	NFS_READLINK,
 	NFS_READLINK_SENT,
+	NFS_FSINFO,
+	NFS_FSINFO_SENT,
 	NFS_READ,
-	NFS_READ_SENT,
 	NFS_CLOSED,
 };
 
+/**
+ * A NFS READ request slot
+ *
+ */
+struct nfs_read {
+	/** Transaction ID, or zero if not yet sent */
+	uint32_t                xid;
+	/** File offset */
+	uint64_t                offset;
+	/** Length still to be read, or zero if slot is unused */
+	uint32_t                len;
+};
+
 /**
  * A NFS request
  *
@@ -109,11 +142,41 @@ struct nfs_request {
 	struct nfs_fh           readlink_fh;
 	struct nfs_fh           current_fh;
 	uint64_t                file_offset;
-
+	uint64_t                filesize;
+
+	/** READ request size */
+	uint32_t                rsize;
+	/** Number of READ request slots */
+	unsigned int            depth;
+	/** Number of READ request slots in use */
+	unsigned int            count;
+	/** READ request slots */
+	struct nfs_read         reads[NFS_MAX_DEPTH];
+
+	/** Partially received reply */
+	struct io_buffer        *rx;
+	/** Length of reply to be accumulated in rx */
+	size_t                  rx_len;
+	/** Length of reply record (including record marker) */
+	size_t                  rx_record;
+	/** File offset of next READ data byte */
+	uint64_t                rx_offset;
+	/** Length of READ data still to be delivered */
+	size_t                  rx_data;
+
+	/** Length of current READ reply record still to be received */
 	size_t                  remaining;
 	int                     eof;
 };
 
+/** NFS read-ahead depth setting */
+const struct setting nfs_depth_setting __setting ( SETTING_MISC,
+						   nfs-depth ) = {
+	.name = "nfs-depth",
+	.description = "NFS READ requests in flight",
+	.type = &setting_type_uint8,
+};
+
 static void nfs_step ( struct nfs_request *nfs );
 
 /**
@@ -129,6 +192,7 @@ static void nfs_free ( struct refcnt *refcnt ) {
 
 	nfs_uri_free ( &nfs->uri );
 
+	free_iob ( nfs->rx );
 	free ( nfs->hostname );
 	free ( nfs->auth_sys.hostname );
 	free ( nfs );
@@ -366,10 +430,82 @@ done:
 	return 0;
 }
 
+/**
+ * Check whether more READ requests should be started
+ *
+ * @v nfs		NFS request
+ * @ret more		More READ requests should be started
+ */
+static int nfs_read_more ( struct nfs_request *nfs ) {
+	return ( ( ! nfs->eof ) && ( nfs->file_offset < nfs->filesize ) );
+}
+
+/**
+ * Issue READ requests
+ *
+ * @v nfs		NFS request
+ */
+static void nfs_read_step ( struct nfs_request *nfs ) {
+	struct nfs_read         *read;
+	unsigned int            i;
+	int                     rc;
+
+	/* Finish once all outstanding data has been received */
+	if ( ! ( nfs->count || nfs->remaining || nfs_read_more ( nfs ) ) ) {
+		DBGC ( nfs, "NFS_OPEN %p read complete\n", nfs );
+		intf_shutdown ( &nfs->nfs_intf, 0 );
+		nfs->nfs_state = NFS_CLOSED;
+		nfs->mount_state++;
+		nfs_mount_step ( nfs );
+		return;
+	}
+
+	/* Keep as many READ requests in flight as permitted */
+	for ( i = 0 ; i < nfs->depth ; i++ ) {
+		read = &nfs->reads[i];
+
+		if ( ! xfer_window ( &nfs->nfs_intf ) )
+			return;
+
+		/* Skip requests already in flight */
+		if ( read->xid )
+			continue;
+
+		/* Start a new request if slot is unused */
+		if ( ! read->len ) {
+			if ( ! nfs_read_more ( nfs ) )
+				continue;
+			read->offset = nfs->file_offset;
+			read->len = nfs->rsize;
+			nfs->file_offset += nfs->rsize;
+			nfs->count++;
+		}
+
+		rc = nfs_read ( &nfs->nfs_intf, &nfs->nfs_session,
+		                &nfs->current_fh, read->offset, read->len );
+		if ( rc != 0 )
+			goto err;
+
+		read->xid = nfs->nfs_session.rpc_id;
+		DBGC ( nfs, "NFS_OPEN %p READ call %#08x (%llu+%u)\n", nfs,
+		       read->xid, ( ( unsigned long long ) read->offset ),
+		       read->len );
+	}
+
+	return;
+err:
+	nfs_done ( nfs, rc );
+}
+
 static void nfs_step ( struct nfs_request *nfs ) {
 	int     rc;
 	char    *path_component;
 
+	if ( nfs->nfs_state == NFS_READ ) {
+		nfs_read_step ( nfs );
+		return;
+	}
+
 	if ( ! xfer_window ( &nfs->nfs_intf ) )
 		return;
 
@@ -401,12 +537,11 @@ static void nfs_step ( struct nfs_request *nfs ) {
 		return;
 	}
 
-	if ( nfs->nfs_state == NFS_READ ) {
-		DBGC ( nfs, "NFS_OPEN %p READ call\n", nfs );
+	if ( nfs->nfs_state == NFS_FSINFO ) {
+		DBGC ( nfs, "NFS_OPEN %p FSINFO call\n", nfs );
 
-		rc = nfs_read ( &nfs->nfs_intf, &nfs->nfs_session,
-		                &nfs->current_fh, nfs->file_offset,
-		                NFS_RSIZE );
+		rc = nfs_fsinfo ( &nfs->nfs_intf, &nfs->nfs_session,
+		                  &nfs->current_fh );
 		if ( rc != 0 )
 			goto err;
 
@@ -419,20 +554,139 @@ err:
 	nfs_done ( nfs, rc );
 }
 
-static int nfs_deliver ( struct nfs_request *nfs,
-                         struct io_buffer *io_buf,
-                         struct xfer_metadata *meta __unused ) {
+/**
+ * Receive READ data
+ *
+ * @v nfs		NFS request
+ * @v io_buf		I/O buffer containing part of current READ reply
+ * @ret rc		Return status code
+ */
+static int nfs_read_data ( struct nfs_request *nfs,
+                           struct io_buffer *io_buf ) {
+	struct xfer_metadata    meta;
+	size_t                  len;
+	int                     rc;
+
+	/* Strip any XDR padding following the data */
+	len = iob_len ( io_buf );
+	assert ( len <= nfs->remaining );
+	nfs->remaining -= len;
+	if ( len > nfs->rx_data )
+		iob_unput ( io_buf, ( len - nfs->rx_data ) );
+	len = iob_len ( io_buf );
+	nfs->rx_data -= len;
+
+	/* Deliver data at its position within the file */
+	if ( len ) {
+		DBGC2 ( nfs, "NFS_OPEN %p got %zd bytes\n", nfs, len );
+		memset ( &meta, 0, sizeof ( meta ) );
+		meta.flags = XFER_FL_ABS_OFFSET;
+		meta.offset = nfs->rx_offset;
+		nfs->rx_offset += len;
+		rc = xfer_deliver ( &nfs->xfer, iob_disown ( io_buf ), &meta );
+		if ( rc != 0 )
+			return rc;
+	} else {
+		free_iob ( io_buf );
+	}
+
+	/* Issue further requests once reply is complete */
+	if ( nfs->remaining == 0 )
+		nfs_step ( nfs );
+
+	return 0;
+}
+
+/**
+ * Receive READ reply header
+ *
+ * @v nfs		NFS request
+ * @v reply		ONC RPC reply
+ * @ret rc		Return status code
+ *
+ * The reply data buffer is consumed by this function.
+ */
+static int nfs_read_reply ( struct nfs_request *nfs,
+                            struct oncrpc_reply *reply ) {
+	struct io_buffer        *io_buf = reply->data;
+	struct nfs_read_reply   read_reply;
+	struct nfs_read         *read;
+	unsigned int            i;
+	size_t                  len;
+	int                     rc;
+
+	/* Identify request */
+	for ( i = 0 ; i < nfs->depth ; i++ ) {
+		read = &nfs->reads[i];
+		if ( read->len && ( read->xid == reply->rpc_id ) )
+			break;
+	}
+	if ( i == nfs->depth ) {
+		DBGC ( nfs, "NFS_OPEN %p unexpected READ reply %#08x\n",
+		       nfs, reply->rpc_id );
+		rc = -EPROTO;
+		goto err;
+	}
+
+	DBGC ( nfs, "NFS_OPEN %p got READ reply %#08x\n", nfs, read->xid );
+
+	rc = nfs_get_read_reply ( &read_reply, reply );
+	if ( rc != 0 )
+		goto err;
+
+	/* Check reply length against requested and received lengths */
+	len = iob_len ( io_buf );
+	if ( ( len > nfs->rx_len ) || ( read_reply.count > read->len ) ||
+	     ( ( len + nfs->remaining ) !=
+	       oncrpc_align ( read_reply.data_len ) ) ||
+	     ( ( read_reply.count == 0 ) && ! read_reply.eof ) ) {
+		DBGC ( nfs, "NFS_OPEN %p malformed READ reply\n", nfs );
+		rc = -EPROTO;
+		goto err;
+	}
+	nfs->rx_offset = read->offset;
+	nfs->rx_data   = read_reply.count;
+
+	/* Update request, leaving any short read to be reissued */
+	read->xid     = 0;
+	read->offset += read_reply.count;
+	read->len    -= read_reply.count;
+	if ( read_reply.eof ) {
+		nfs->eof  = 1;
+		read->len = 0;
+	}
+	if ( ! read->len )
+		nfs->count--;
+
+	/* Deliver any data received along with the header */
+	nfs->remaining += len;
+	return nfs_read_data ( nfs, io_buf );
+
+err:
+	free_iob ( io_buf );
+	return rc;
+}
+
+/**
+ * Receive complete reply (or READ reply header)
+ *
+ * @v nfs		NFS request
+ * @v io_buf		I/O buffer
+ * @ret rc		Return status code
+ */
+static int nfs_reply ( struct nfs_request *nfs, struct io_buffer *io_buf ) {
 	int                     rc;
 	struct oncrpc_reply     reply;
 
-	if ( nfs->remaining == 0 ) {
-		oncrpc_get_reply ( &nfs->nfs_session, &reply, io_buf );
-		if ( reply.accept_state != 0 ) {
-			rc = -EPROTO;
-			goto err;
-		}
+	oncrpc_get_reply ( &nfs->nfs_session, &reply, io_buf );
+	if ( reply.accept_state != 0 ) {
+		rc = -EPROTO;
+		goto err;
 	}
 
+	if ( nfs->nfs_state == NFS_READ )
+		return nfs_read_reply ( nfs, &reply );
+
 	if ( nfs->nfs_state == NFS_LOOKUP_SENT ) {
 		struct nfs_lookup_reply lookup_reply;
 
@@ -449,7 +703,7 @@ static int nfs_deliver ( struct nfs_request *nfs,
 			nfs->current_fh = lookup_reply.fh;
 
 			if ( nfs->uri.lookup_pos[0] == '\0' )
-				nfs->nfs_state = NFS_READ;
+				nfs->nfs_state = NFS_FSINFO;
 			else
 				nfs->nfs_state--;
 		}
@@ -492,61 +746,156 @@ static int nfs_deliver ( struct nfs_request *nfs,
 		goto done;
 	}
 
-	if ( nfs->nfs_state == NFS_READ_SENT ) {
-		if ( nfs->remaining == 0 ) {
-			DBGC ( nfs, "NFS_OPEN %p got READ reply\n", nfs );
+	if ( nfs->nfs_state == NFS_FSINFO_SENT ) {
+		struct nfs_fsinfo_reply fsinfo_reply;
 
-			struct nfs_read_reply read_reply;
+		DBGC ( nfs, "NFS_OPEN %p got FSINFO reply\n", nfs );
 
-			rc = nfs_get_read_reply ( &read_reply, &reply );
-			if ( rc != 0 )
-				goto err;
+		/* Fall back to default READ size on failure */
+		rc = nfs_get_fsinfo_reply ( &fsinfo_reply, &reply );
+		if ( rc == 0 ) {
+			if ( fsinfo_reply.rtmax )
+				nfs->rsize = fsinfo_reply.rtmax;
+			if ( nfs->rsize > NFS_MAX_RSIZE )
+				nfs->rsize = NFS_MAX_RSIZE;
 
-			if ( nfs->file_offset == 0 ) {
+			if ( fsinfo_reply.attr ) {
 				DBGC2 ( nfs, "NFS_OPEN %p size: %llu bytes\n",
-				        nfs, read_reply.filesize );
+				        nfs, fsinfo_reply.filesize );
 
-				xfer_seek ( &nfs->xfer, read_reply.filesize );
+				nfs->filesize = fsinfo_reply.filesize;
+				xfer_seek ( &nfs->xfer, nfs->filesize );
 				xfer_seek ( &nfs->xfer, 0 );
 			}
+		}
+
+		DBGC ( nfs, "NFS_OPEN %p reading %d x %d bytes\n", nfs,
+		       nfs->depth, nfs->rsize );
 
-			nfs->file_offset += read_reply.count;
-			nfs->remaining    = read_reply.count;
-			nfs->eof          = read_reply.eof;
+		nfs->nfs_state = NFS_READ;
+		nfs_step ( nfs );
+		goto done;
+	}
+
+	rc = -EPROTO;
+err:
+	free_iob ( io_buf );
+	return rc;
+done:
+	free_iob ( io_buf );
+	return 0;
+}
+
+/**
+ * Accumulate reply
+ *
+ * @v nfs		NFS request
+ * @v io_buf		I/O buffer
+ * @ret rc		Return status code
+ *
+ * Replies other than READ replies are accumulated in full.  For READ
+ * replies, only the header is accumulated and the data is streamed
+ * directly to the data transfer interface.
+ */
+static int nfs_rx_header ( struct nfs_request *nfs,
+                           struct io_buffer *io_buf ) {
+	struct io_buffer        *rx;
+	uint32_t                *marker;
+	size_t                  len;
+
+	/* Allocate buffer, initially sized for a READ reply header */
+	if ( ! nfs->rx ) {
+		nfs->rx = alloc_iob ( NFS_READ_HDR_MAX );
+		if ( ! nfs->rx )
+			return -ENOMEM;
+		nfs->rx_len = sizeof ( *marker );
+	}
+
+	/* Accumulate data */
+	len = ( nfs->rx_len - iob_len ( nfs->rx ) );
+	if ( len > iob_len ( io_buf ) )
+		len = iob_len ( io_buf );
+	memcpy ( iob_put ( nfs->rx, len ), io_buf->data, len );
+	iob_pull ( io_buf, len );
+	if ( iob_len ( nfs->rx ) < nfs->rx_len )
+		return 0;
+
+	/* Determine length to be accumulated from record marker */
+	if ( nfs->rx_len == sizeof ( *marker ) ) {
+		marker = nfs->rx->data;
+		nfs->rx_record = ( GET_FRAME_SIZE ( ntohl ( *marker ) ) +
+		                   sizeof ( *marker ) );
+		if ( nfs->rx_record <= sizeof ( *marker ) )
+			return -EPROTO;
+
+		if ( nfs->nfs_state == NFS_READ ) {
+			nfs->rx_len = nfs->rx_record;
+			if ( nfs->rx_len > NFS_READ_HDR_MAX )
+				nfs->rx_len = NFS_READ_HDR_MAX;
+		} else if ( nfs->rx_record > NFS_READ_HDR_MAX ) {
+			rx = alloc_iob ( nfs->rx_record );
+			if ( ! rx )
+				return -ENOMEM;
+			memcpy ( iob_put ( rx, sizeof ( *marker ) ), marker,
+			         sizeof ( *marker ) );
+			free_iob ( nfs->rx );
+			nfs->rx = rx;
+			nfs->rx_len = nfs->rx_record;
+		} else {
+			nfs->rx_len = nfs->rx_record;
 		}
 
-		size_t len = iob_len ( io_buf );
-		if ( len > nfs->remaining )
-			iob_unput ( io_buf, len - nfs->remaining );
+		return 0;
+	}
 
-		nfs->remaining -= iob_len ( io_buf );
+	/* Process reply */
+	rx = nfs->rx;
+	nfs->rx = NULL;
+	nfs->remaining = ( nfs->rx_record - nfs->rx_len );
+	return nfs_reply ( nfs, rx );
+}
 
-		DBGC ( nfs, "NFS_OPEN %p got %zd bytes\n", nfs,
-		       iob_len ( io_buf ) );
+static int nfs_deliver ( struct nfs_request *nfs,
+                         struct io_buffer *io_buf,
+                         struct xfer_metadata *meta __unused ) {
+	int                     rc;
+	struct io_buffer        *data;
+	size_t                  len;
 
-		rc = xfer_deliver_iob ( &nfs->xfer, iob_disown ( io_buf ) );
-		if ( rc != 0 )
-			goto err;
+	while ( io_buf && ( ( len = iob_len ( io_buf ) ) != 0 ) ) {
 
-		if ( nfs->remaining == 0 ) {
-			if ( ! nfs->eof ) {
-				nfs->nfs_state--;
-				nfs_step ( nfs );
-			} else {
-				intf_shutdown ( &nfs->nfs_intf, 0 );
-				nfs->nfs_state++;
-				nfs->mount_state++;
-				nfs_mount_step ( nfs );
+		/* Accumulate reply unless within READ data */
+		if ( ! nfs->remaining ) {
+			rc = nfs_rx_header ( nfs, io_buf );
+			if ( rc != 0 )
+				goto err;
+			continue;
+		}
+
+		/* Split off any data beyond the current READ reply */
+		if ( len > nfs->remaining ) {
+			len = nfs->remaining;
+			data = alloc_iob ( len );
+			if ( ! data ) {
+				rc = -ENOMEM;
+				goto err;
 			}
+			memcpy ( iob_put ( data, len ), io_buf->data, len );
+			iob_pull ( io_buf, len );
+		} else {
+			data = iob_disown ( io_buf );
 		}
 
-		return 0;
+		rc = nfs_read_data ( nfs, data );
+		if ( rc != 0 )
+			goto err;
 	}
 
-	rc = -EPROTO;
+	free_iob ( io_buf );
+	return 0;
+
 err:
 	nfs_done ( nfs, rc );
-done:
 	free_iob ( io_buf );
 	return 0;
 }
@@ -632,6 +981,7 @@ err_hostname:
 static int nfs_open ( struct interface *xfer, struct uri *uri ) {
 	int                     rc;
 	struct nfs_request      *nfs;
+	unsigned long           depth;
 
 	nfs = zalloc ( sizeof ( *nfs ) );
 	if ( ! nfs )
@@ -655,6 +1005,16 @@ static int nfs_open ( struct interface *xfer, struct uri *uri ) {
 	mount_init_session ( &nfs->mount_session, &nfs->auth_sys.credential );
 	nfs_init_session ( &nfs->nfs_session, &nfs->auth_sys.credential );
 
+	nfs->filesize = ~( ( uint64_t ) 0 );
+	nfs->rsize = NFS_RSIZE;
+	if ( fetch_uint_setting ( NULL, &nfs_depth_setting, &depth ) < 0 )
+		depth = NFS_DEFAULT_DEPTH;
+	if ( depth == 0 )
+		depth = 1;
+	if ( depth > NFS_MAX_DEPTH )
+		depth = NFS_MAX_DEPTH;
+	nfs->depth = depth;
+
 	DBGC ( nfs, "NFS_OPEN %p connecting to port mapper (%s:%d)...\n", nfs,
 	       nfs->hostname, PORTMAP_PORT );
 
@@ -0,0 +1,279 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+FILE_SECBOOT ( PERMITTED );
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <assert.h>
+#include <time.h>
+#include <byteswap.h>
+#include <ipxe/if_arp.h>
+#include <ipxe/timer.h>
+#include <ipxe/image.h>
+#include <ipxe/netdevice.h>
+#include <ipxe/pcap.h>
+
+/** @file
+ *
+ * Packet capture
+ *
+ * Packets transmitted and received via a network device may be
+ * captured into a fixed-size in-memory ring, and later saved as an
+ * image in pcap format.  Timestamps are derived from the wall clock
+ * time at the start of capture plus elapsed timer ticks.
+ */
+
+/**
+ * Get capture ring slot length
+ *
+ * @v ring		Capture ring
+ * @ret len		Slot length
+ */
+static inline size_t pcap_slot_len ( struct pcap_ring *ring ) {
+
+	return ( sizeof ( struct pcap_record_header ) + ring->snaplen );
+}
+
+/**
+ * Get capture ring slot
+ *
+ * @v ring		Capture ring
+ * @v index		Slot index
+ * @ret record		Record header
+ */
+static inline struct pcap_record_header *
+pcap_slot ( struct pcap_ring *ring, unsigned int index ) {
+
+	return ( ring->data +
+		 ( ( index % ring->slots ) * pcap_slot_len ( ring ) ) );
+}
+
+/**
+ * Capture packet
+ *
+ * @v netdev		Network device
+ * @v iobuf		I/O buffer
+ */
+void pcap_capture ( struct net_device *netdev, struct io_buffer *iobuf ) {
+	struct pcap_ring *ring = netdev->pcap;
+	struct pcap_record_header *record;
+	unsigned long elapsed;
+	size_t len;
+
+	/* Handle full ring */
+	if ( ( ring->prod - ring->cons ) >= ring->slots ) {
+		ring->dropped++;
+		if ( ring->tail_drop )
+			return;
+		ring->cons++;
+	}
+
+	/* Construct record */
+	record = pcap_slot ( ring, ring->prod++ );
+	elapsed = ( currticks() - ring->ticks );
+	record->ts_sec = ( ring->epoch + ( elapsed / TICKS_PER_SEC ) );
+	record->ts_usec = ( ( ( elapsed % TICKS_PER_SEC ) * 1000000UL ) /
+			    TICKS_PER_SEC );
+	len = iob_len ( iobuf );
+	if ( len > ring->snaplen )
+		len = ring->snaplen;
+	record->incl_len = len;
+	record->orig_len = iob_total_len ( iobuf );
+	memcpy ( ( record + 1 ), iobuf->data, len );
+}
+
+/**
+ * Start packet capture
+ *
+ * @v netdev		Network device
+ * @v snaplen		Snapshot length
+ * @v slots		Number of capture ring slots
+ * @v tail_drop		Discard new packets (rather than old packets) when full
+ * @ret rc		Return status code
+ *
+ * Any existing capture on the network device is discarded.
+ */
+int pcap_start ( struct net_device *netdev, size_t snaplen,
+		 unsigned int slots, int tail_drop ) {
+	struct pcap_ring *ring;
+
+	/* Sanity check */
+	if ( ! ( snaplen && slots ) )
+		return -EINVAL;
+
+	/* Discard any existing capture */
+	pcap_stop ( netdev );
+
+	/* Allocate and initialise ring */
+	ring = zalloc ( sizeof ( *ring ) );
+	if ( ! ring )
+		return -ENOMEM;
+	ring->netdev = netdev;
+	ring->slots = slots;
+	ring->snaplen = snaplen;
+	ring->tail_drop = tail_drop;
+	ring->epoch = time ( NULL );
+	ring->ticks = currticks();
+	ring->data = malloc ( slots * pcap_slot_len ( ring ) );
+	if ( ! ring->data ) {
+		free ( ring );
+		return -ENOMEM;
+	}
+	DBGC ( ring, "PCAP %s capturing %d x %zd bytes (%s drop)\n",
+	       netdev->name, slots, snaplen, ( tail_drop ? "tail" : "head" ) );
+
+	/* Start capturing */
+	netdev->pcap = ring;
+
+	return 0;
+}
+
+/**
+ * Stop packet capture
+ *
+ * @v netdev		Network device
+ *
+ * Any captured packets are discarded.
+ */
+void pcap_stop ( struct net_device *netdev ) {
+	struct pcap_ring *ring = netdev->pcap;
+
+	/* Do nothing unless capturing */
+	if ( ! ring )
+		return;
+
+	/* Stop capturing and free ring */
+	DBGC ( ring, "PCAP %s stopped after %d packets (%ld dropped)\n",
+	       netdev->name, ring->prod, ring->dropped );
+	netdev->pcap = NULL;
+	free ( ring->data );
+	free ( ring );
+}
+
+/**
+ * Save captured packets as an image
+ *
+ * @v netdev		Network device
+ * @v name		Image name, or NULL to use "<interface>.pcap"
+ * @ret rc		Return status code
+ *
+ * Capture continues after the image has been created.
+ */
+int pcap_save ( struct net_device *netdev, const char *name ) {
+	struct pcap_ring *ring = netdev->pcap;
+	struct pcap_file_header *header;
+	struct pcap_record_header *record;
+	char default_name[ sizeof ( netdev->name ) + 5 /* ".pcap" */ ];
+	struct image *image;
+	unsigned int index;
+	size_t record_len;
+	size_t len;
+	void *data;
+	int rc;
+
+	/* Fail unless capturing */
+	if ( ! ring )
+		return -ENOENT;
+
+	/* Use default name if none specified */
+	if ( ! name ) {
+		snprintf ( default_name, sizeof ( default_name ), "%s.pcap",
+			   netdev->name );
+		name = default_name;
+	}
+
+	/* Calculate file length */
+	len = sizeof ( *header );
+	for ( index = ring->cons ; index != ring->prod ; index++ ) {
+		record = pcap_slot ( ring, index );
+		len += ( sizeof ( *record ) + record->incl_len );
+	}
+
+	/* Allocate image */
+	image = alloc_image ( NULL );
+	if ( ! image ) {
+		rc = -ENOMEM;
+		goto err_alloc;
+	}
+	if ( ( rc = image_set_name ( image, name ) ) != 0 )
+		goto err_set_name;
+	if ( ( rc = image_set_len ( image, len ) ) != 0 )
+		goto err_set_len;
+	data = image->rwdata;
+
+	/* Construct file header */
+	header = data;
+	header->magic = PCAP_MAGIC;
+	header->major = PCAP_VERSION_MAJOR;
+	header->minor = PCAP_VERSION_MINOR;
+	header->thiszone = 0;
+	header->sigfigs = 0;
+	header->snaplen = ring->snaplen;
+	header->linktype =
+		( ( netdev->ll_protocol->ll_proto == htons ( ARPHRD_ETHER ) ) ?
+		  PCAP_LINKTYPE_ETHERNET : PCAP_LINKTYPE_USER0 );
+	data += sizeof ( *header );
+
+	/* Copy records */
+	for ( index = ring->cons ; index != ring->prod ; index++ ) {
+		record = pcap_slot ( ring, index );
+		record_len = ( sizeof ( *record ) + record->incl_len );
+		memcpy ( data, record, record_len );
+		data += record_len;
+	}
+	assert ( data == ( image->rwdata + len ) );
+
+	/* Register image */
+	if ( ( rc = register_image ( image ) ) != 0 )
+		goto err_register;
+	DBGC ( ring, "PCAP %s saved %d packets as \"%s\"\n", netdev->name,
+	       ( ring->prod - ring->cons ), image->name );
+
+ err_register:
+ err_set_len:
+ err_set_name:
+	image_put ( image );
+ err_alloc:
+	return rc;
+}
+
+/**
+ * Stop packet capture on network device removal
+ *
+ * @v netdev		Network device
+ * @v priv		Private data
+ */
+static void pcap_remove ( struct net_device *netdev, void *priv __unused ) {
+
+	pcap_stop ( netdev );
+}
+
+/** Packet capture driver */
+struct net_driver pcap_driver __net_driver = {
+	.name = "pcap",
+	.remove = pcap_remove,
+};
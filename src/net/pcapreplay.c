@@ -0,0 +1,520 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+FILE_SECBOOT ( PERMITTED );
+
+/** @file
+ *
+ * Packet capture replay network device
+ *
+ * A replay network device feeds the frames received by the client in
+ * a recorded packet capture into the network stack as fast as the
+ * stack is able to consume them, so that the cost of protocol
+ * processing may be measured independently of any real network
+ * hardware.
+ *
+ * The recorded client is identified as the sender of the first frame
+ * in the capture.  Frames sent by the recorded client are never
+ * transmitted; instead they act as synchronisation points.  A
+ * recorded TCP SYN waits for the live network stack to open a
+ * connection to the same server address and port, and a recorded TCP
+ * segment carrying data or a FIN waits for the live network stack to
+ * transmit fresh sequence space on the same connection, so that
+ * request-response protocols remain in step.
+ *
+ * Since the live network stack will choose its own TCP ports and
+ * initial sequence numbers, received TCP segments are rewritten to
+ * carry the live destination port and to acknowledge everything that
+ * the live network stack has sent so far.  TCP checksums are updated
+ * incrementally and are left to be verified by the network stack as
+ * for any real network device.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <byteswap.h>
+#include <ipxe/iobuf.h>
+#include <ipxe/netdevice.h>
+#include <ipxe/ethernet.h>
+#include <ipxe/if_ether.h>
+#include <ipxe/ip.h>
+#include <ipxe/tcp.h>
+#include <ipxe/pcap.h>
+#include <ipxe/pcapreplay.h>
+
+/**
+ * Read value from capture data
+ *
+ * @v replay		Replay network device
+ * @v value		Value as stored in capture data
+ * @ret value		Value in host byte order
+ */
+static inline uint32_t pcap_replay_u32 ( struct pcap_replay *replay,
+					 uint32_t value ) {
+	return ( replay->swapped ? bswap_32 ( value ) : value );
+}
+
+/**
+ * Locate TCP header within Ethernet frame
+ *
+ * @v frame		Ethernet frame
+ * @v len		Length of Ethernet frame
+ * @ret tcp_len		Length of TCP header and payload
+ * @ret offset		Offset to TCP header, or zero if not a TCP segment
+ */
+static size_t pcap_replay_tcp ( const void *frame, size_t len,
+				size_t *tcp_len ) {
+	const struct ethhdr *ethhdr = frame;
+	const struct iphdr *iphdr = ( ( const void * ) ( ethhdr + 1 ) );
+	const struct tcp_header *tcphdr;
+	size_t hlen;
+	size_t ip_len;
+	size_t thlen;
+
+	/* Check for an unfragmented IPv4 TCP packet */
+	if ( len < ( sizeof ( *ethhdr ) + sizeof ( *iphdr ) ) )
+		return 0;
+	if ( ethhdr->h_protocol != htons ( ETH_P_IP ) )
+		return 0;
+	if ( iphdr->protocol != IP_TCP )
+		return 0;
+	if ( iphdr->frags & htons ( IP_MASK_OFFSET | IP_MASK_MOREFRAGS ) )
+		return 0;
+
+	/* Check lengths */
+	hlen = ( ( iphdr->verhdrlen & IP_MASK_HLEN ) * 4 );
+	ip_len = ntohs ( iphdr->len );
+	if ( ( hlen < sizeof ( *iphdr ) ) || ( hlen > ip_len ) ||
+	     ( ip_len > ( len - sizeof ( *ethhdr ) ) ) ||
+	     ( ( ip_len - hlen ) < sizeof ( *tcphdr ) ) ) {
+		return 0;
+	}
+	tcphdr = ( ( ( const void * ) iphdr ) + hlen );
+	thlen = ( ( tcphdr->hlen & TCP_MASK_HLEN ) / 16 * 4 );
+	if ( ( thlen < sizeof ( *tcphdr ) ) || ( thlen > ( ip_len - hlen ) ) )
+		return 0;
+
+	*tcp_len = ( ip_len - hlen );
+	return ( sizeof ( *ethhdr ) + hlen );
+}
+
+/**
+ * Calculate end of sequence space occupied by TCP segment
+ *
+ * @v tcphdr		TCP header
+ * @v tcp_len		Length of TCP header and payload
+ * @ret end		Sequence number following segment
+ */
+static uint32_t pcap_replay_end ( const struct tcp_header *tcphdr,
+				  size_t tcp_len ) {
+	size_t thlen = ( ( tcphdr->hlen & TCP_MASK_HLEN ) / 16 * 4 );
+	uint32_t end;
+
+	end = ( ntohl ( tcphdr->seq ) + ( tcp_len - thlen ) );
+	if ( tcphdr->flags & TCP_SYN )
+		end++;
+	if ( tcphdr->flags & TCP_FIN )
+		end++;
+	return end;
+}
+
+/**
+ * Find TCP connection by live client port
+ *
+ * @v replay		Replay network device
+ * @v port		Live client port, or zero to find an unused connection
+ * @ret flow		TCP connection, or NULL if not found
+ */
+static struct pcap_replay_flow *
+pcap_replay_flow_live ( struct pcap_replay *replay, uint16_t port ) {
+	struct pcap_replay_flow *flow;
+	unsigned int i;
+
+	for ( i = 0 ; i < PCAP_REPLAY_MAX_FLOWS ; i++ ) {
+		flow = &replay->flows[i];
+		if ( flow->port == port )
+			return flow;
+	}
+	return NULL;
+}
+
+/**
+ * Find TCP connection by recorded client port
+ *
+ * @v replay		Replay network device
+ * @v port		Recorded client port
+ * @ret flow		TCP connection, or NULL if not found
+ */
+static struct pcap_replay_flow *
+pcap_replay_flow_recorded ( struct pcap_replay *replay, uint16_t port ) {
+	struct pcap_replay_flow *flow;
+	unsigned int i;
+
+	for ( i = 0 ; i < PCAP_REPLAY_MAX_FLOWS ; i++ ) {
+		flow = &replay->flows[i];
+		if ( flow->recorded_port && ( flow->recorded_port == port ) )
+			return flow;
+	}
+	return NULL;
+}
+
+/**
+ * Update TCP checksum for a modified field
+ *
+ * @v csum		Original checksum
+ * @v old		Original field value (in network byte order)
+ * @v new		Modified field value (in network byte order)
+ * @ret csum		Updated checksum
+ */
+static uint16_t pcap_replay_fixup ( uint16_t csum, uint32_t old,
+				    uint32_t new ) {
+	uint32_t sum;
+
+	/* Incrementally update checksum as per RFC 1624 */
+	sum = ( ( uint16_t ) ~csum );
+	sum += ( ( uint16_t ) ~( old >> 16 ) );
+	sum += ( ( uint16_t ) ~old );
+	sum += ( new >> 16 );
+	sum += ( new & 0xffff );
+	sum = ( ( sum & 0xffff ) + ( sum >> 16 ) );
+	sum = ( ( sum & 0xffff ) + ( sum >> 16 ) );
+	return ( ~sum );
+}
+
+/**
+ * Process frame sent by recorded client
+ *
+ * @v replay		Replay network device
+ * @v frame		Recorded frame
+ * @v len		Length of recorded frame
+ * @ret rc		Return status code
+ */
+static int pcap_replay_sent ( struct pcap_replay *replay,
+			      const void *frame, size_t len ) {
+	const struct iphdr *iphdr = ( frame + sizeof ( struct ethhdr ) );
+	const struct tcp_header *tcphdr;
+	struct pcap_replay_flow *flow;
+	size_t tcp_len;
+	size_t offset;
+	unsigned int i;
+
+	/* Ignore anything other than TCP */
+	offset = pcap_replay_tcp ( frame, len, &tcp_len );
+	if ( ! offset )
+		return 0;
+	tcphdr = ( frame + offset );
+
+	/* Bind new connections to the live client's connection */
+	if ( ( tcphdr->flags & ( TCP_SYN | TCP_ACK ) ) == TCP_SYN ) {
+		for ( i = 0 ; i < PCAP_REPLAY_MAX_FLOWS ; i++ ) {
+			flow = &replay->flows[i];
+			if ( flow->port && ( ! flow->recorded_port ) &&
+			     ( flow->server.s_addr == iphdr->dest.s_addr ) &&
+			     ( flow->server_port == tcphdr->dest ) ) {
+				flow->recorded_port = tcphdr->src;
+				return 0;
+			}
+		}
+		return -EAGAIN;
+	}
+
+	/* Wait for live client to send fresh data or FIN */
+	flow = pcap_replay_flow_recorded ( replay, tcphdr->src );
+	if ( ! flow )
+		return 0;
+	if ( pcap_replay_end ( tcphdr, tcp_len ) == ntohl ( tcphdr->seq ) )
+		return 0;
+	if ( flow->snd_nxt == flow->synced )
+		return -EAGAIN;
+	flow->synced = flow->snd_nxt;
+
+	return 0;
+}
+
+/**
+ * Deliver frame received by recorded client
+ *
+ * @v replay		Replay network device
+ * @v frame		Recorded frame
+ * @v len		Length of recorded frame
+ * @ret rc		Return status code
+ */
+static int pcap_replay_received ( struct pcap_replay *replay,
+				  const void *frame, size_t len ) {
+	struct net_device *netdev = replay->netdev;
+	struct pcap_replay_flow *flow;
+	struct io_buffer *iobuf;
+	struct ethhdr *ethhdr;
+	struct tcp_header *tcphdr;
+	uint32_t ack;
+	size_t tcp_len;
+	size_t offset;
+
+	/* Allocate and populate I/O buffer */
+	iobuf = alloc_iob ( len );
+	if ( ! iobuf )
+		return -ENOMEM;
+	memcpy ( iob_put ( iobuf, len ), frame, len );
+
+	/* Rewrite destination MAC address */
+	ethhdr = iobuf->data;
+	if ( memcmp ( ethhdr->h_dest, replay->client, ETH_ALEN ) == 0 )
+		memcpy ( ethhdr->h_dest, netdev->ll_addr, ETH_ALEN );
+
+	/* Rewrite destination port and acknowledgement number */
+	offset = pcap_replay_tcp ( iobuf->data, len, &tcp_len );
+	if ( offset ) {
+		tcphdr = ( iobuf->data + offset );
+		flow = pcap_replay_flow_recorded ( replay, tcphdr->dest );
+		if ( flow ) {
+			tcphdr->csum = pcap_replay_fixup ( tcphdr->csum,
+							   tcphdr->dest,
+							   flow->port );
+			tcphdr->dest = flow->port;
+			if ( tcphdr->flags & TCP_ACK ) {
+				ack = htonl ( flow->snd_nxt );
+				tcphdr->csum =
+					pcap_replay_fixup ( tcphdr->csum,
+							    tcphdr->ack, ack );
+				tcphdr->ack = ack;
+			}
+		}
+	}
+
+	/* Hand off to network stack */
+	netdev_rx ( netdev, iobuf );
+	replay->packets++;
+	replay->bytes += len;
+
+	return 0;
+}
+
+/**
+ * Replay next record from capture
+ *
+ * @v replay		Replay network device
+ * @ret rc		Return status code
+ */
+static int pcap_replay_next ( struct pcap_replay *replay ) {
+	struct pcap_record_header hdr;
+	const struct ethhdr *ethhdr;
+	const void *frame;
+	size_t remaining;
+	size_t incl_len;
+	size_t orig_len;
+	int rc;
+
+	/* Parse record header */
+	remaining = ( replay->len - replay->offset );
+	if ( remaining < sizeof ( hdr ) ) {
+		DBGC ( replay, "PCAP %s truncated record header\n",
+		       replay->netdev->name );
+		replay->offset = replay->len;
+		return -EINVAL;
+	}
+	memcpy ( &hdr, ( replay->data + replay->offset ), sizeof ( hdr ) );
+	incl_len = pcap_replay_u32 ( replay, hdr.incl_len );
+	orig_len = pcap_replay_u32 ( replay, hdr.orig_len );
+	if ( incl_len > ( remaining - sizeof ( hdr ) ) ) {
+		DBGC ( replay, "PCAP %s truncated record\n",
+		       replay->netdev->name );
+		replay->offset = replay->len;
+		return -EINVAL;
+	}
+	frame = ( replay->data + replay->offset + sizeof ( hdr ) );
+	ethhdr = frame;
+
+	/* Replay frame, skipping any that were not captured in full */
+	if ( ( incl_len >= sizeof ( *ethhdr ) ) && ( incl_len >= orig_len ) ){
+		if ( memcmp ( ethhdr->h_source, replay->client,
+			      ETH_ALEN ) == 0 ) {
+			rc = pcap_replay_sent ( replay, frame, incl_len );
+		} else {
+			rc = pcap_replay_received ( replay, frame, incl_len );
+		}
+		if ( rc != 0 )
+			return rc;
+	}
+
+	/* Move to next record */
+	replay->offset += ( sizeof ( hdr ) + incl_len );
+	return 0;
+}
+
+/**
+ * Open network device
+ *
+ * @v netdev		Network device
+ * @ret rc		Return status code
+ */
+static int pcap_replay_open ( struct net_device *netdev __unused ) {
+
+	/* Do nothing, successfully */
+	return 0;
+}
+
+/**
+ * Close network device
+ *
+ * @v netdev		Network device
+ */
+static void pcap_replay_close ( struct net_device *netdev __unused ) {
+
+	/* Nothing to do */
+}
+
+/**
+ * Transmit packet
+ *
+ * @v netdev		Network device
+ * @v iobuf		I/O buffer
+ * @ret rc		Return status code
+ *
+ * Transmitted packets are discarded, after recording the state of any
+ * TCP connection required to rewrite the replayed responses.
+ */
+static int pcap_replay_transmit ( struct net_device *netdev,
+				  struct io_buffer *iobuf ) {
+	struct pcap_replay *replay = netdev->priv;
+	const struct iphdr *iphdr =
+		( iobuf->data + sizeof ( struct ethhdr ) );
+	const struct tcp_header *tcphdr;
+	struct pcap_replay_flow *flow;
+	uint32_t end;
+	size_t tcp_len;
+	size_t offset;
+
+	/* Track live TCP connections */
+	offset = pcap_replay_tcp ( iobuf->data, iob_len ( iobuf ), &tcp_len );
+	if ( offset ) {
+		tcphdr = ( iobuf->data + offset );
+		end = pcap_replay_end ( tcphdr, tcp_len );
+		flow = pcap_replay_flow_live ( replay, tcphdr->src );
+		if ( ( tcphdr->flags & ( TCP_SYN | TCP_ACK ) ) == TCP_SYN ) {
+			if ( ! flow )
+				flow = pcap_replay_flow_live ( replay, 0 );
+			if ( flow ) {
+				flow->server = iphdr->dest;
+				flow->server_port = tcphdr->dest;
+				flow->port = tcphdr->src;
+				flow->recorded_port = 0;
+				flow->snd_nxt = end;
+				flow->synced = end;
+			} else {
+				DBGC ( replay, "PCAP %s out of connection "
+				       "slots\n", netdev->name );
+			}
+		} else if ( flow &&
+			    ( ( int32_t ) ( end - flow->snd_nxt ) > 0 ) ) {
+			flow->snd_nxt = end;
+		}
+	}
+
+	/* Complete immediately */
+	netdev_tx_complete ( netdev, iobuf );
+	return 0;
+}
+
+/**
+ * Poll for completed and received packets
+ *
+ * @v netdev		Network device
+ */
+static void pcap_replay_poll ( struct net_device *netdev ) {
+	struct pcap_replay *replay = netdev->priv;
+	unsigned int budget = NETDEV_RX_BUDGET;
+
+	/* Replay records until we must wait for the live client */
+	while ( budget-- && ( ! pcap_replay_finished ( replay ) ) ) {
+		if ( pcap_replay_next ( replay ) != 0 )
+			break;
+	}
+}
+
+/** Replay network device operations */
+static struct net_device_operations pcap_replay_operations = {
+	.open		= pcap_replay_open,
+	.close		= pcap_replay_close,
+	.transmit	= pcap_replay_transmit,
+	.poll		= pcap_replay_poll,
+};
+
+/**
+ * Allocate replay network device
+ *
+ * @v data		Capture data
+ * @v len		Length of capture data
+ * @ret netdev		Network device, or NULL on error
+ *
+ * The capture data must remain valid for the lifetime of the network
+ * device.  The network device's hardware address will be set to the
+ * recorded client's MAC address.
+ */
+struct net_device * alloc_pcap_replay ( const void *data, size_t len ) {
+	const struct pcap_file_header *hdr = data;
+	const struct pcap_record_header *rec = ( data + sizeof ( *hdr ) );
+	const struct ethhdr *ethhdr = ( ( const void * ) ( rec + 1 ) );
+	struct net_device *netdev;
+	struct pcap_replay *replay;
+	int swapped;
+
+	/* Sanity checks */
+	if ( len < ( sizeof ( *hdr ) + sizeof ( *rec ) + sizeof ( *ethhdr ) ) ){
+		DBG ( "PCAP capture too short\n" );
+		return NULL;
+	}
+	if ( hdr->magic == PCAP_MAGIC ) {
+		swapped = 0;
+	} else if ( hdr->magic == bswap_32 ( PCAP_MAGIC ) ) {
+		swapped = 1;
+	} else {
+		DBG ( "PCAP capture has unsupported magic %#08x\n",
+		      hdr->magic );
+		return NULL;
+	}
+	if ( ( swapped ? bswap_32 ( hdr->linktype ) : hdr->linktype ) !=
+	     PCAP_LINKTYPE_ETHERNET ) {
+		DBG ( "PCAP capture is not an Ethernet capture\n" );
+		return NULL;
+	}
+
+	/* Allocate and initialise network device */
+	netdev = alloc_etherdev ( sizeof ( *replay ) );
+	if ( ! netdev )
+		return NULL;
+	netdev_init ( netdev, &pcap_replay_operations );
+	replay = netdev->priv;
+	memset ( replay, 0, sizeof ( *replay ) );
+	replay->netdev = netdev;
+	replay->data = data;
+	replay->len = len;
+	replay->swapped = swapped;
+	replay->offset = sizeof ( *hdr );
+	memcpy ( replay->client, ethhdr->h_source, ETH_ALEN );
+	memcpy ( netdev->hw_addr, replay->client, ETH_ALEN );
+
+	return netdev;
+}
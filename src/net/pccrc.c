@@ -68,27 +68,47 @@ peerdist_info_hash_ntoa ( const struct peerdist_info *info, const void *hash ) {
 }
 
 /**
- * Get raw data
+ * Locate raw data
  *
  * @v info		Content information
- * @v data		Data buffer
  * @v offset		Starting offset
  * @v len		Length
- * @ret rc		Return status code
+ * @ret data		Raw data, or NULL on error
  */
-static int peerdist_info_get ( const struct peerdist_info *info, void *data,
-			       size_t offset, size_t len ) {
+static const void * peerdist_info_raw ( const struct peerdist_info *info,
+					size_t offset, size_t len ) {
 
 	/* Sanity check */
 	if ( ( offset > info->raw.len ) ||
 	     ( len > ( info->raw.len - offset ) ) ) {
 		DBGC ( info, "PCCRC %p data underrun at [%zx,%zx) of %zx\n",
 		       info, offset, ( offset + len ), info->raw.len );
-		return -ERANGE;
+		return NULL;
 	}
 
+	return ( info->raw.data + offset );
+}
+
+/**
+ * Get raw data
+ *
+ * @v info		Content information
+ * @v data		Data buffer
+ * @v offset		Starting offset
+ * @v len		Length
+ * @ret rc		Return status code
+ */
+static int peerdist_info_get ( const struct peerdist_info *info, void *data,
+			       size_t offset, size_t len ) {
+	const void *raw;
+
+	/* Locate data */
+	raw = peerdist_info_raw ( info, offset, len );
+	if ( ! raw )
+		return -ERANGE;
+
 	/* Copy data */
-	memcpy ( data, ( info->raw.data + offset ), len );
+	memcpy ( data, raw, len );
 
 	return 0;
 }
@@ -280,6 +300,58 @@ static int peerdist_info_v1 ( struct peerdist_info *info ) {
 	return 0;
 }
 
+/**
+ * Verify segment hash of data
+ *
+ * @v segment		Content information segment
+ * @v hash		Segment hash of data
+ * @ret rc		Return status code
+ *
+ * The segment hash of data is the hash of the list of block hashes,
+ * and so can be verified only when the block description lists every
+ * block within the segment.  The block hashes are digested directly
+ * from the raw content information.
+ */
+static int peerdist_info_v1_verify ( struct peerdist_info_segment *segment,
+				     const void *hash ) {
+	const struct peerdist_info *info = segment->info;
+	struct digest_algorithm *digest = info->digest;
+	size_t digestsize = info->digestsize;
+	uint8_t ctx[digest->ctxsize];
+	uint8_t out[digest->digestsize];
+	const void *hashes;
+	size_t offset;
+	size_t len;
+	size_t count;
+
+	/* Do nothing unless all block hashes are present */
+	if ( ! segment->blksize )
+		return 0;
+	len = ( segment->range.end - segment->range.start );
+	count = ( ( len + segment->blksize - 1 ) / segment->blksize );
+	if ( segment->blocks != count )
+		return 0;
+
+	/* Locate block hashes */
+	offset = ( segment->blkdesc + sizeof ( struct peerdist_info_v1_block ) );
+	len = ( segment->blocks * digestsize );
+	hashes = peerdist_info_raw ( info, offset, len );
+	if ( ! hashes )
+		return -ERANGE;
+
+	/* Calculate and verify hash of block hashes */
+	digest_init ( digest, ctx );
+	digest_update ( digest, ctx, hashes, len );
+	digest_final ( digest, ctx, out );
+	if ( memcmp ( out, hash, digestsize ) != 0 ) {
+		DBGC ( info, "PCCRC %p segment %d hash of data mismatch\n",
+		       info, segment->index );
+		return -EACCES;
+	}
+
+	return 0;
+}
+
 /**
  * Populate content information segment
  *
@@ -334,6 +406,11 @@ static int peerdist_info_v1_segment ( struct peerdist_info_segment *segment ) {
 		return rc;
 	}
 	segment->blocks = blocks;
+	segment->blkdesc = raw_offset;
+
+	/* Verify segment hash of data */
+	if ( ( rc = peerdist_info_v1_verify ( segment, raw.hash ) ) != 0 )
+		return rc;
 
 	/* Calculate segment hashes */
 	peerdist_info_segment_hash ( segment, raw.hash, raw.secret );
@@ -352,7 +429,7 @@ static int peerdist_info_v1_block ( struct peerdist_info_block *block ) {
 	const struct peerdist_info *info = segment->info;
 	size_t digestsize = info->digestsize;
 	peerdist_info_v1_block_t ( digestsize, segment->blocks ) raw;
-	ssize_t raw_offset;
+	size_t raw_offset;
 	int rc;
 
 	/* Sanity checks */
@@ -367,15 +444,9 @@ static int peerdist_info_v1_block ( struct peerdist_info_block *block ) {
 	if ( block->range.end > segment->range.end )
 		block->range.end = segment->range.end;
 
-	/* Locate block description */
-	raw_offset = peerdist_info_v1_block_offset ( info, segment->index );
-	if ( raw_offset < 0 ) {
-		rc = raw_offset;
-		return rc;
-	}
-
 	/* Get block hash */
-	raw_offset += offsetof ( typeof ( raw ), hash[block->index] );
+	raw_offset = ( segment->blkdesc +
+		       offsetof ( typeof ( raw ), hash[block->index] ) );
 	if ( ( rc = peerdist_info_get ( info, block->hash, raw_offset,
 					digestsize ) ) != 0 ) {
 		DBGC ( info, "PCCRC %p segment %d block %d could not get "
@@ -63,11 +63,13 @@ FILE_SECBOOT ( PERMITTED );
  * connection to go through the full client certificate verification.
  *
  * Limit the total number of concurrent raw block downloads to
- * ameliorate these problems.
+ * ameliorate these problems, while still allowing enough parallelism
+ * that a slow or lossy origin server does not serialise the whole
+ * download.
  *
  * This is a policy decision.
  */
-#define PEERBLK_RAW_MAX 2
+#define PEERBLK_RAW_MAX 4
 
 /** PeerDist raw block download attempt initial progress timeout
  *
@@ -522,9 +524,16 @@ static void peerblk_enqueue ( struct peerdist_block *peerblk,
 	assert ( peerblk->queue == NULL );
 	assert ( list_empty ( &peerblk->queued ) );
 
-	/* Add block to queue */
+	/* Add block to queue.  The first block of the download is
+	 * placed at the head of the queue, since nothing else can be
+	 * consumed until it has arrived.
+	 */
 	peerblk->queue = queue;
-	list_add_tail ( &peerblk->queued, &queue->list );
+	if ( peerblk->offset == 0 ) {
+		list_add ( &peerblk->queued, &queue->list );
+	} else {
+		list_add_tail ( &peerblk->queued, &queue->list );
+	}
 
 	/* Schedule queue process */
 	process_add ( &queue->process );
@@ -1282,8 +1291,10 @@ static void peerblk_expired ( struct retry_timer *timer, int over __unused ) {
 		container_of ( timer, struct peerdist_block, timer );
 	struct peerdisc_segment *segment = peerblk->discovery.segment;
 	struct peerdisc_peer *head;
+	struct peerdisc_peer *peer;
 	unsigned long now = peerblk_timestamp();
-	const char *location;
+	unsigned int count;
+	unsigned int skip;
 	int rc;
 
 	/* Profile discovery timeout, if applicable */
@@ -1323,19 +1334,33 @@ static void peerblk_expired ( struct retry_timer *timer, int over __unused ) {
 		goto err;
 	}
 
-	/* If we have not yet made any download attempts, then move to
-	 * the start of the peer list.
-	 */
-	if ( peerblk->peer == NULL )
-		peerblk->peer = head;
+	/* Start a new cycle of peer attempts, if applicable */
+	if ( peerblk->peer == head )
+		peerblk->attempts = 0;
 
-	/* Attempt retrieval protocol download from next usable peer */
-	list_for_each_entry_continue ( peerblk->peer, &segment->peers, list ) {
+	/* Attempt retrieval protocol download from next usable peer.
+	 * Each block starts from a different position within the
+	 * peer list, so that concurrent block downloads are spread
+	 * across all discovered peers rather than all being directed
+	 * to the first peer.
+	 */
+	count = 0;
+	list_for_each_entry ( peer, &segment->peers, list )
+		count++;
+	while ( peerblk->attempts < count ) {
+
+		/* Identify next peer */
+		skip = ( ( peerblk->segment + peerblk->block +
+			   peerblk->attempts++ ) % count );
+		list_for_each_entry ( peer, &segment->peers, list ) {
+			if ( ! skip-- )
+				break;
+		}
+		peerblk->peer = peer;
 
 		/* Attempt retrieval protocol download from this peer */
-		location = peerblk->peer->location;
 		if ( ( rc = peerblk_retrieval_open ( peerblk,
-						     location ) ) != 0 ) {
+						     peer->location ) ) != 0 ) {
 			/* Non-fatal: continue to try next peer */
 			continue;
 		}
@@ -1345,6 +1370,7 @@ static void peerblk_expired ( struct retry_timer *timer, int over __unused ) {
 	}
 
 	/* Add to raw download queue */
+	peerblk->peer = head;
 	peerblk_enqueue ( peerblk, &peerblk_raw_queue );
 
 	return;
@@ -1489,9 +1515,14 @@ int peerblk_open ( struct interface *xfer, struct uri *uri,
 		goto err_open_discovery;
 
 	/* Schedule a retry attempt either immediately (if we already
-	 * have some peers) or after the discovery timeout.
+	 * have some peers) or after the discovery timeout.  The first
+	 * block of the download is never held back waiting for
+	 * discovery: it is fetched immediately from the origin server
+	 * (if no peers are yet known) while discovery continues in
+	 * the background on behalf of the remaining blocks.
 	 */
-	timeout = ( list_empty ( &peerblk->discovery.segment->peers ) ?
+	timeout = ( ( list_empty ( &peerblk->discovery.segment->peers ) &&
+		      ( peerblk->offset != 0 ) ) ?
 		    ( peerdisc_timeout_secs * TICKS_PER_SEC ) : 0 );
 	start_timer_fixed ( &peerblk->timer, timeout );
 
@@ -60,6 +60,26 @@ static LIST_HEAD ( peerdisc_segments );
 /** Default discovery timeout (in seconds) */
 #define PEERDISC_DEFAULT_TIMEOUT_SECS 2
 
+/** Maximum number of segment IDs included within a single request */
+#define PEERDISC_MAX_SCOPES 4
+
+/** Maximum number of idle segments retained
+ *
+ * Segments for which peers were discovered are retained after the
+ * last client has closed, so that a subsequent download of the same
+ * segment (e.g. a retried block, or the same file fetched again) can
+ * start retrieval immediately without repeating discovery.
+ *
+ * This is a policy decision.
+ */
+#define PEERDISC_CACHE_MAX 16
+
+/** Number of recently discovered peers used to seed new segments
+ *
+ * This is a policy decision.
+ */
+#define PEERDISC_RECENT_MAX 4
+
 /** Recommended discovery timeout (in seconds)
  *
  * We reduce the recommended discovery timeout whenever a segment
@@ -74,8 +94,8 @@ static LIST_HEAD ( peerdisc_segments );
  */
 unsigned int peerdisc_timeout_secs = PEERDISC_DEFAULT_TIMEOUT_SECS;
 
-/** Most recently discovered peer (for any block) */
-static char *peerdisc_recent;
+/** Most recently discovered peers (for any block), most recent first */
+static char *peerdisc_recent[PEERDISC_RECENT_MAX];
 
 /** Hosted cache server */
 static char *peerhost;
@@ -153,7 +173,7 @@ static int peerdisc_socket_open ( void ) {
  * Attempt to transmit PeerDist discovery requests on all sockets
  *
  * @v uuid		Message UUID string
- * @v id		Segment identifier string
+ * @v id		Segment identifier string(s), space-separated
  */
 static void peerdisc_socket_tx ( const char *uuid, const char *id ) {
 	struct peerdisc_socket *socket;
@@ -375,6 +395,58 @@ static struct peerdisc_segment * peerdisc_find ( const char *id ) {
 	return NULL;
 }
 
+/**
+ * Check for active PeerDist discovery segments
+ *
+ * @ret active		Some segments have active clients
+ */
+static int peerdisc_active ( void ) {
+	struct peerdisc_segment *segment;
+
+	list_for_each_entry ( segment, &peerdisc_segments, list ) {
+		if ( ! list_empty ( &segment->clients ) )
+			return 1;
+	}
+	return 0;
+}
+
+/**
+ * Record recently discovered PeerDist peer
+ *
+ * @v location		Peer location
+ */
+static void peerdisc_remember ( const char *location ) {
+	char *recent;
+	unsigned int i;
+
+	/* Ignore locations that are themselves recent peer records
+	 * (i.e. peers used to seed a new segment).
+	 */
+	for ( i = 0 ; i < PEERDISC_RECENT_MAX ; i++ ) {
+		if ( location == peerdisc_recent[i] )
+			return;
+	}
+
+	/* Find existing record, or reuse the least recent record */
+	for ( i = 0 ; i < ( PEERDISC_RECENT_MAX - 1 ) ; i++ ) {
+		if ( peerdisc_recent[i] &&
+		     ( strcmp ( peerdisc_recent[i], location ) == 0 ) )
+			break;
+	}
+	recent = peerdisc_recent[i];
+	if ( ! ( recent && ( strcmp ( recent, location ) == 0 ) ) ) {
+		recent = strdup ( location );
+		if ( ! recent )
+			return;
+		free ( peerdisc_recent[i] );
+	}
+
+	/* Move to front of list */
+	memmove ( &peerdisc_recent[1], &peerdisc_recent[0],
+		  ( i * sizeof ( peerdisc_recent[0] ) ) );
+	peerdisc_recent[0] = recent;
+}
+
 /**
  * Add discovered PeerDist peer
  *
@@ -387,7 +459,6 @@ static int peerdisc_discovered ( struct peerdisc_segment *segment,
 	struct peerdisc_peer *peer;
 	struct peerdisc_client *peerdisc;
 	struct peerdisc_client *tmp;
-	char *recent;
 
 	/* Ignore duplicate peers */
 	list_for_each_entry ( peer, &segment->peers, list ) {
@@ -409,13 +480,7 @@ static int peerdisc_discovered ( struct peerdisc_segment *segment,
 	list_add_tail ( &peer->list, &segment->peers );
 
 	/* Record as most recently discovered peer */
-	if ( location != peerdisc_recent ) {
-		recent = strdup ( location );
-		if ( recent ) {
-			free ( peerdisc_recent );
-			peerdisc_recent = recent;
-		}
-	}
+	peerdisc_remember ( location );
 
 	/* Notify all clients */
 	list_for_each_entry_safe ( peerdisc, tmp, &segment->clients, list )
@@ -433,13 +498,56 @@ static int peerdisc_discovered ( struct peerdisc_segment *segment,
 static void peerdisc_expired ( struct retry_timer *timer, int over __unused ) {
 	struct peerdisc_segment *segment =
 		container_of ( timer, struct peerdisc_segment, timer );
+	struct peerdisc_segment *batch[PEERDISC_MAX_SCOPES];
+	struct peerdisc_segment *tmp;
+	char ids[ PEERDISC_MAX_SCOPES *
+		  ( base16_encoded_len ( PEERDIST_DIGEST_MAX_SIZE ) +
+		    1 /* space or NUL */ ) ];
+	unsigned int count = 0;
+	unsigned int i;
+	size_t used = 0;
+	size_t len;
 
-	/* Attempt to transmit discovery requests */
-	peerdisc_socket_tx ( segment->uuid, segment->id );
+	/* Include all other segments still awaiting discovery within
+	 * the same request, so that the discovery of several
+	 * segments costs only a single multicast message.
+	 */
+	batch[count++] = segment;
+	list_for_each_entry ( tmp, &peerdisc_segments, list ) {
+		if ( count >= PEERDISC_MAX_SCOPES )
+			break;
+		if ( ( tmp != segment ) && timer_running ( &tmp->timer ) )
+			batch[count++] = tmp;
+	}
 
-	/* Schedule next transmission, if applicable */
-	if ( timer->count < PEERDISC_REPEAT_COUNT )
-		start_timer_fixed ( &segment->timer, PEERDISC_REPEAT_TIMEOUT );
+	/* Construct space-separated list of segment IDs */
+	for ( i = 0 ; i < count ; i++ ) {
+		len = strlen ( batch[i]->id );
+		if ( ( used + len + 1 /* space or NUL */ ) > sizeof ( ids ) ) {
+			count = i;
+			break;
+		}
+		if ( used )
+			ids[ used++ ] = ' ';
+		memcpy ( &ids[used], batch[i]->id, len );
+		used += len;
+	}
+	ids[used] = '\0';
+	assert ( count > 0 );
+
+	/* Attempt to transmit discovery requests */
+	peerdisc_socket_tx ( segment->uuid, ids );
+
+	/* Schedule next transmission for each segment, if applicable */
+	for ( i = 0 ; i < count ; i++ ) {
+		tmp = batch[i];
+		if ( ++tmp->probes < PEERDISC_REPEAT_COUNT ) {
+			start_timer_fixed ( &tmp->timer,
+					    PEERDISC_REPEAT_TIMEOUT );
+		} else {
+			stop_timer ( &tmp->timer );
+		}
+	}
 }
 
 /**
@@ -498,15 +606,19 @@ static struct peerdisc_segment * peerdisc_create ( const char *id ) {
 
 	} else {
 
-		/* Add most recently discovered peer to list of peers
+		/* Add most recently discovered peers to list of peers
 		 *
 		 * This is a performance optimisation: we assume that
-		 * the most recently discovered peer for any block has
-		 * a high probability of also having a copy of the
-		 * next block that we attempt to discover.
+		 * the peers most recently discovered for any block
+		 * have a high probability of also having a copy of
+		 * the next block that we attempt to discover.
 		 */
-		if ( peerdisc_recent )
-			peerdisc_discovered ( segment, peerdisc_recent );
+		for ( i = 0 ; i < PEERDISC_RECENT_MAX ; i++ ) {
+			if ( peerdisc_recent[i] ) {
+				peerdisc_discovered ( segment,
+						      peerdisc_recent[i] );
+			}
+		}
 
 		/* Start discovery timer */
 		start_timer_nodelay ( &segment->timer );
@@ -542,6 +654,66 @@ static void peerdisc_destroy ( struct peerdisc_segment *segment ) {
 	ref_put ( &segment->refcnt );
 }
 
+/**
+ * Retire PeerDist discovery segment
+ *
+ * @v segment		PeerDist discovery segment
+ *
+ * The segment is retained as an idle segment (if any peers were
+ * discovered), so that the discovered peers may be reused.
+ */
+static void peerdisc_retire ( struct peerdisc_segment *segment ) {
+	struct peerdisc_segment *tmp;
+	unsigned int idle = 0;
+
+	/* Sanity check */
+	assert ( list_empty ( &segment->clients ) );
+
+	/* Stop any ongoing discovery */
+	stop_timer ( &segment->timer );
+
+	/* Destroy segment immediately if no peers were discovered */
+	if ( list_empty ( &segment->peers ) ) {
+		peerdisc_destroy ( segment );
+		return;
+	}
+
+	/* Move to end of list of segments (as most recently retired) */
+	list_del ( &segment->list );
+	list_add_tail ( &segment->list, &peerdisc_segments );
+	DBGC2 ( segment, "PEERDISC %p retained %s\n", segment, segment->id );
+
+	/* Count idle segments */
+	list_for_each_entry ( tmp, &peerdisc_segments, list ) {
+		if ( list_empty ( &tmp->clients ) )
+			idle++;
+	}
+
+	/* Destroy least recently retired idle segment, if applicable */
+	if ( idle > PEERDISC_CACHE_MAX ) {
+		list_for_each_entry ( tmp, &peerdisc_segments, list ) {
+			if ( list_empty ( &tmp->clients ) ) {
+				peerdisc_destroy ( tmp );
+				break;
+			}
+		}
+	}
+}
+
+/**
+ * Destroy all idle PeerDist discovery segments
+ *
+ */
+static void peerdisc_flush ( void ) {
+	struct peerdisc_segment *segment;
+	struct peerdisc_segment *tmp;
+
+	list_for_each_entry_safe ( segment, tmp, &peerdisc_segments, list ) {
+		if ( list_empty ( &segment->clients ) )
+			peerdisc_destroy ( segment );
+	}
+}
+
 /******************************************************************************
  *
  * Discovery clients
@@ -572,8 +744,8 @@ int peerdisc_open ( struct peerdisc_client *peerdisc, const void *id,
 	/* Sanity check */
 	assert ( peerdisc->segment == NULL );
 
-	/* Open socket if this is the first segment */
-	if ( list_empty ( &peerdisc_segments ) &&
+	/* Open socket if this is the first active segment */
+	if ( ( ! peerdisc_active() ) &&
 	     ( ( rc = peerdisc_socket_open() ) != 0 ) )
 		return rc;
 
@@ -616,12 +788,12 @@ void peerdisc_close ( struct peerdisc_client *peerdisc ) {
 	list_del ( &peerdisc->list );
 	ref_put ( &segment->refcnt );
 
-	/* If this was the last clients, destroy the segment */
+	/* If this was the last client, retire the segment */
 	if ( list_empty ( &segment->clients ) )
-		peerdisc_destroy ( segment );
+		peerdisc_retire ( segment );
 
-	/* If there are no more segments, close the socket */
-	if ( list_empty ( &peerdisc_segments ) )
+	/* If there are no more active segments, close the socket */
+	if ( ! peerdisc_active() )
 		peerdisc_socket_close ( 0 );
 }
 
@@ -646,6 +818,11 @@ const struct setting peerhost_setting __setting ( SETTING_MISC, peerhost ) = {
  */
 static int apply_peerdisc_settings ( void ) {
 
+	/* Discard any idle segments, since the hosted cache server
+	 * may have changed.
+	 */
+	peerdisc_flush();
+
 	/* Free any existing hosted cache server */
 	free ( peerhost );
 	peerhost = NULL;
@@ -33,6 +33,7 @@ FILE_SECBOOT ( PERMITTED );
 #include <ipxe/job.h>
 #include <ipxe/peerblk.h>
 #include <ipxe/peermux.h>
+#include <ipxe/peerserv.h>
 
 /** @file
  *
@@ -40,6 +41,16 @@ FILE_SECBOOT ( PERMITTED );
  *
  */
 
+/**
+ * Offer downloaded content to peers (when no content server is present)
+ *
+ * @v data		Raw content information
+ * @v len		Length of raw content information
+ */
+__weak void peerserv_add ( const void *data __unused, size_t len __unused ) {
+	/* Nothing to do */
+}
+
 /**
  * Free PeerDist download multiplexer
  *
@@ -70,6 +81,10 @@ static void peermux_close ( struct peerdist_multiplexer *peermux, int rc ) {
 	for ( i = 0 ; i < PEERMUX_MAX_BLOCKS ; i++ )
 		intf_shutdown ( &peermux->block[i].xfer, rc );
 
+	/* Close all upcoming segment discoveries */
+	for ( i = 0 ; i < PEERMUX_LOOKAHEAD ; i++ )
+		peerdisc_close ( &peermux->lookahead[i].client );
+
 	/* Shut down all other interfaces (which may be connected to
 	 * the same object).
 	 */
@@ -172,6 +187,74 @@ static void peermux_info_close ( struct peerdist_multiplexer *peermux, int rc ){
 	peermux_close ( peermux, rc );
 }
 
+/**
+ * Handle discovery of peers for an upcoming segment
+ *
+ * @v discovery		PeerDist discovery client
+ */
+static void peermux_discovered ( struct peerdisc_client *discovery __unused ) {
+
+	/* Nothing to do: discovered peers will be used once block
+	 * downloads for the segment are started.
+	 */
+}
+
+/** PeerDist upcoming segment discovery operations */
+static struct peerdisc_client_operations peermux_discovery_operations = {
+	.discovered = peermux_discovered,
+};
+
+/**
+ * Start discovery for upcoming segments
+ *
+ * @v peermux		PeerDist download multiplexer
+ * @v current		Current segment index
+ *
+ * Starting discovery for the next few segments ahead of time allows
+ * their discovery requests to be combined with those for the current
+ * segment, and allows their block downloads to start immediately
+ * once the current segment is complete.
+ */
+static void peermux_lookahead ( struct peerdist_multiplexer *peermux,
+				unsigned int current ) {
+	struct peerdist_info *info = &peermux->cache.info;
+	struct peerdist_multiplexed_discovery *lookahead;
+	struct peerdist_info_segment segment;
+	unsigned int index;
+	unsigned int i;
+	int rc;
+
+	for ( i = 1 ; i <= PEERMUX_LOOKAHEAD ; i++ ) {
+
+		/* Identify slot for this segment */
+		index = ( current + i );
+		if ( index >= info->segments )
+			break;
+		lookahead = &peermux->lookahead[ index % PEERMUX_LOOKAHEAD ];
+		if ( lookahead->client.segment && ( lookahead->index == index ))
+			continue;
+		peerdisc_close ( &lookahead->client );
+
+		/* Start discovery.  Failures are non-fatal, since
+		 * discovery will be retried when the block downloads
+		 * for the segment are started.
+		 */
+		if ( ( rc = peerdist_info_segment ( info, &segment,
+						    index ) ) != 0 )
+			continue;
+		if ( segment.range.start >= info->trim.end )
+			break;
+		if ( ( rc = peerdisc_open ( &lookahead->client, segment.id,
+					    info->digestsize ) ) != 0 ) {
+			DBGC ( peermux, "PEERMUX %p could not start discovery "
+			       "for segment %d: %s\n", peermux, index,
+			       strerror ( rc ) );
+			continue;
+		}
+		lookahead->index = index;
+	}
+}
+
 /**
  * Initiate multiplexed block download
  *
@@ -211,8 +294,11 @@ static void peermux_step ( struct peerdist_multiplexer *peermux ) {
 		 */
 		if ( next_segment >= info->segments ) {
 			process_del ( &peermux->process );
-			if ( list_empty ( &peermux->busy ) )
+			if ( list_empty ( &peermux->busy ) ) {
+				peerserv_add ( peermux->buffer.data,
+					       peermux->buffer.len );
 				peermux_close ( peermux, 0 );
+			}
 			return;
 		}
 
@@ -224,6 +310,9 @@ static void peermux_step ( struct peerdist_multiplexer *peermux ) {
 			       strerror ( rc ) );
 			goto err;
 		}
+
+		/* Start discovery for upcoming segments */
+		peermux_lookahead ( peermux, next_segment );
 	}
 
 	/* Get content information block */
@@ -436,6 +525,10 @@ int peermux_filter ( struct interface *xfer, struct interface *info,
 		intf_init ( &peermblk->xfer, &peermux_block_desc,
 			    &peermux->refcnt );
 	}
+	for ( i = 0 ; i < PEERMUX_LOOKAHEAD ; i++ ) {
+		peerdisc_init ( &peermux->lookahead[i].client,
+				&peermux_discovery_operations );
+	}
 
 	/* Attach to parent interfaces, mortalise self, and return */
 	intf_plug_plug ( &peermux->xfer, xfer );
@@ -0,0 +1,1120 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+FILE_SECBOOT ( PERMITTED );
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+#include <errno.h>
+#include <byteswap.h>
+#include <ipxe/refcnt.h>
+#include <ipxe/list.h>
+#include <ipxe/iobuf.h>
+#include <ipxe/xfer.h>
+#include <ipxe/open.h>
+#include <ipxe/in.h>
+#include <ipxe/ip.h>
+#include <ipxe/tcp.h>
+#include <ipxe/uuid.h>
+#include <ipxe/base16.h>
+#include <ipxe/image.h>
+#include <ipxe/crypto.h>
+#include <ipxe/aes.h>
+#include <ipxe/init.h>
+#include <ipxe/pccrc.h>
+#include <ipxe/pccrd.h>
+#include <ipxe/pccrr.h>
+#include <ipxe/peerblk.h>
+#include <ipxe/peerserv.h>
+
+/** @file
+ *
+ * Peer Content Caching and Retrieval (PeerDist) protocol content server
+ *
+ * Content downloaded via PeerDist is offered to other peers on the
+ * local network for as long as the downloaded image remains
+ * registered.  Discovery probes are answered for any segment of
+ * served content, and retrieval requests are satisfied directly from
+ * the image data.  Each block is verified against the content
+ * information before being served, so an image that has been
+ * modified since it was downloaded will never be served.
+ *
+ * Only IPv4 is supported.
+ */
+
+/** Maximum number of content information blocks retained
+ *
+ * This is a policy decision.
+ */
+#define PEERSERV_CONTENT_MAX 4
+
+/** Maximum length of a retrieval request (including headers) */
+#define PEERSERV_REQUEST_MAX 2048
+
+/** Maximum length of a single retrieval response transmission */
+#define PEERSERV_CHUNK_MAX 4096
+
+/** A served content segment */
+struct peerserv_segment {
+	/** Segment identifier */
+	uint8_t id[PEERDIST_DIGEST_MAX_SIZE];
+	/** Number of blocks available to be served */
+	unsigned int blocks;
+};
+
+/** Served content */
+struct peerserv_content {
+	/** List of served content */
+	struct list_head list;
+	/** Content information */
+	struct peerdist_info info;
+	/** Segments */
+	struct peerserv_segment *segments;
+};
+
+/** A PeerDist content server */
+struct peerdist_server {
+	/** Discovery socket */
+	struct interface discovery;
+	/** Retrieval listener */
+	struct tcp_listener listener;
+	/** List of served content, most recent first */
+	struct list_head contents;
+	/** Number of served content information blocks */
+	unsigned int count;
+	/** Endpoint UUID string */
+	char uuid[ 36 /* "xxxxxxxx-xxxx-xxxx-xxxx-xxxxxxxxxxxx" */ + 1 ];
+};
+
+/** A PeerDist retrieval connection */
+struct peerserv_connection {
+	/** Reference count */
+	struct refcnt refcnt;
+	/** Data transfer interface */
+	struct interface xfer;
+
+	/** Received request */
+	char request[PEERSERV_REQUEST_MAX];
+	/** Length of received request */
+	size_t len;
+
+	/** Response (or NULL if no response yet constructed) */
+	void *response;
+	/** Length of response */
+	size_t response_len;
+	/** Length of response already transmitted */
+	size_t sent;
+};
+
+static struct peerdist_server peerserv;
+
+/******************************************************************************
+ *
+ * Served content
+ *
+ ******************************************************************************
+ */
+
+/**
+ * Find served content segment
+ *
+ * @v id		Segment identifier
+ * @v digestsize	Length of segment identifier
+ * @ret index		Segment index
+ * @ret content		Served content, or NULL if not found
+ */
+static struct peerserv_content * peerserv_find ( const void *id,
+						 size_t digestsize,
+						 unsigned int *index ) {
+	struct peerserv_content *content;
+	unsigned int i;
+
+	list_for_each_entry ( content, &peerserv.contents, list ) {
+		if ( content->info.digestsize != digestsize )
+			continue;
+		for ( i = 0 ; i < content->info.segments ; i++ ) {
+			if ( memcmp ( content->segments[i].id, id,
+				      digestsize ) == 0 ) {
+				*index = i;
+				return content;
+			}
+		}
+	}
+	return NULL;
+}
+
+/**
+ * Locate verified data for a content block
+ *
+ * @v content		Served content
+ * @v block		Content information block
+ * @ret data		Block data, or NULL if not available
+ */
+static const void * peerserv_data ( struct peerserv_content *content,
+				    struct peerdist_info_block *block ) {
+	struct peerdist_info *info = &content->info;
+	struct digest_algorithm *digest = info->digest;
+	uint8_t ctx[digest->ctxsize];
+	uint8_t hash[digest->digestsize];
+	struct image *image;
+	const void *data;
+	size_t offset;
+	size_t len;
+
+	/* Fail unless block lies entirely within the downloaded content */
+	if ( ( block->range.start < info->trim.start ) ||
+	     ( block->range.end > info->trim.end ) )
+		return NULL;
+	offset = ( block->range.start - info->trim.start );
+	len = ( block->range.end - block->range.start );
+
+	/* Find an image holding verifiably correct block data */
+	for_each_image ( image ) {
+
+		/* Skip images of the wrong length */
+		if ( image->len != ( info->trim.end - info->trim.start ) )
+			continue;
+
+		/* Check block hash */
+		data = ( image->data + offset );
+		digest_init ( digest, ctx );
+		digest_update ( digest, ctx, data, len );
+		digest_final ( digest, ctx, hash );
+		if ( memcmp ( hash, block->hash, info->digestsize ) != 0 )
+			continue;
+
+		DBGC2 ( &peerserv, "PEERSERV found block %d.%d in %s\n",
+			block->segment->index, block->index, image->name );
+		return data;
+	}
+
+	return NULL;
+}
+
+/******************************************************************************
+ *
+ * Discovery
+ *
+ ******************************************************************************
+ */
+
+/**
+ * Handle received discovery probe
+ *
+ * @v server		PeerDist content server
+ * @v iobuf		I/O buffer
+ * @v meta		Data transfer metadata
+ * @ret rc		Return status code
+ */
+static int peerserv_discovery_rx ( struct peerdist_server *server,
+				   struct io_buffer *iobuf,
+				   struct xfer_metadata *meta ) {
+	struct sockaddr_in *sin_src = ( ( struct sockaddr_in * ) meta->src );
+	struct peerdist_discovery_probe probe;
+	struct peerserv_content *content;
+	struct ipv4_miniroute *miniroute;
+	struct xfer_metadata reply_meta;
+	struct in_addr dest;
+	union {
+		union uuid uuid;
+		uint32_t dword[ sizeof ( union uuid ) / sizeof ( uint32_t ) ];
+	} random_uuid;
+	uint8_t raw[PEERDIST_DIGEST_MAX_SIZE];
+	char xaddrs[ 15 /* "xxx.xxx.xxx.xxx" */ + 1 /* ":" */
+		     + 5 /* "xxxxx" */ + 1 /* NUL */ ];
+	size_t ids_len;
+	size_t counts_len;
+	char *buf;
+	char *ids;
+	char *counts;
+	char *match;
+	char *id;
+	unsigned int index;
+	unsigned int i;
+	int raw_len;
+	int rc;
+
+	/* Ignore anything other than IPv4 */
+	if ( ( ! sin_src ) || ( sin_src->sin_family != AF_INET ) ) {
+		rc = -ENOTSUP;
+		goto err_family;
+	}
+
+	/* Parse probe */
+	if ( ( rc = peerdist_discovery_probe ( iobuf->data, iob_len ( iobuf ),
+					       &probe ) ) != 0 ) {
+		DBGC2 ( server, "PEERSERV ignoring probe: %s\n",
+			strerror ( rc ) );
+		goto err_probe;
+	}
+
+	/* Allocate matching segment ID and block count lists */
+	ids_len = 1 /* NUL */;
+	counts_len = 1 /* NUL */;
+	for ( id = probe.ids ; *id ; id += ( strlen ( id ) + 1 /* NUL */ ) ) {
+		ids_len += ( strlen ( id ) + 1 /* " " */ );
+		counts_len += sizeof ( struct peerdist_discovery_block_count );
+	}
+	buf = malloc ( ids_len + counts_len );
+	if ( ! buf ) {
+		rc = -ENOMEM;
+		goto err_alloc;
+	}
+	ids = buf;
+	counts = ( buf + ids_len );
+	ids[0] = '\0';
+	counts[0] = '\0';
+
+	/* Construct lists of matching segment IDs and block counts */
+	for ( id = probe.ids ; *id ; id += ( strlen ( id ) + 1 /* NUL */ ) ) {
+		if ( base16_decoded_max_len ( id ) > sizeof ( raw ) )
+			continue;
+		raw_len = base16_decode ( id, raw, sizeof ( raw ) );
+		if ( raw_len < 0 )
+			continue;
+		content = peerserv_find ( raw, raw_len, &index );
+		if ( ! content )
+			continue;
+		DBGC ( server, "PEERSERV answering probe for %s\n", id );
+		sprintf ( ( ids + strlen ( ids ) ), "%s%s",
+			  ( ids[0] ? " " : "" ), id );
+		sprintf ( ( counts + strlen ( counts ) ), "%08X",
+			  content->segments[index].blocks );
+	}
+
+	/* Ignore probes for which we have no matching segments */
+	if ( ! ids[0] ) {
+		rc = 0;
+		goto err_nomatch;
+	}
+
+	/* Identify the local address used to reach the requester */
+	dest = sin_src->sin_addr;
+	miniroute = ipv4_route ( sin_src->sin_scope_id, &dest );
+	if ( ! miniroute ) {
+		rc = -ENETUNREACH;
+		goto err_route;
+	}
+	snprintf ( xaddrs, sizeof ( xaddrs ), "%s:%d",
+		   inet_ntoa ( miniroute->address ), PEERSERV_PORT );
+
+	/* Generate a random message UUID.  This does not require high
+	 * quality randomness.
+	 */
+	for ( i = 0 ; i < ( sizeof ( random_uuid.dword ) /
+			    sizeof ( random_uuid.dword[0] ) ) ; i++ )
+		random_uuid.dword[i] = random();
+
+	/* Construct probe match */
+	match = peerdist_discovery_match ( uuid_ntoa ( &random_uuid.uuid ),
+					   probe.message, server->uuid, ids,
+					   counts, xaddrs );
+	if ( ! match ) {
+		rc = -ENOMEM;
+		goto err_match;
+	}
+
+	/* Send probe match directly to requester */
+	memset ( &reply_meta, 0, sizeof ( reply_meta ) );
+	reply_meta.dest = meta->src;
+	if ( ( rc = xfer_deliver_raw_meta ( &server->discovery, match,
+					    strlen ( match ),
+					    &reply_meta ) ) != 0 ) {
+		DBGC ( server, "PEERSERV could not send probe match: %s\n",
+		       strerror ( rc ) );
+		goto err_deliver;
+	}
+
+ err_deliver:
+	free ( match );
+ err_match:
+ err_route:
+ err_nomatch:
+	free ( buf );
+ err_alloc:
+ err_probe:
+ err_family:
+	free_iob ( iobuf );
+	return rc;
+}
+
+/** Discovery socket interface operations */
+static struct interface_operation peerserv_discovery_operations[] = {
+	INTF_OP ( xfer_deliver, struct peerdist_server *,
+		  peerserv_discovery_rx ),
+};
+
+/** Discovery socket interface descriptor */
+static struct interface_descriptor peerserv_discovery_desc =
+	INTF_DESC ( struct peerdist_server, discovery,
+		    peerserv_discovery_operations );
+
+/******************************************************************************
+ *
+ * Retrieval
+ *
+ ******************************************************************************
+ */
+
+/**
+ * Free retrieval connection
+ *
+ * @v refcnt		Reference count
+ */
+static void peerserv_free ( struct refcnt *refcnt ) {
+	struct peerserv_connection *conn =
+		container_of ( refcnt, struct peerserv_connection, refcnt );
+
+	free ( conn->response );
+	free ( conn );
+}
+
+/**
+ * Close retrieval connection
+ *
+ * @v conn		Retrieval connection
+ * @v rc		Reason for close
+ */
+static void peerserv_close ( struct peerserv_connection *conn, int rc ) {
+
+	/* Shut down interfaces */
+	intf_shutdown ( &conn->xfer, rc );
+}
+
+/**
+ * Transmit as much of the response as the window permits
+ *
+ * @v conn		Retrieval connection
+ */
+static void peerserv_send ( struct peerserv_connection *conn ) {
+	size_t remaining;
+	size_t len;
+	int rc;
+
+	/* Do nothing until a response has been constructed */
+	if ( ! conn->response )
+		return;
+
+	/* Transmit response */
+	while ( ( remaining = ( conn->response_len - conn->sent ) ) ) {
+		len = xfer_window ( &conn->xfer );
+		if ( ! len )
+			return;
+		if ( len > remaining )
+			len = remaining;
+		if ( len > PEERSERV_CHUNK_MAX )
+			len = PEERSERV_CHUNK_MAX;
+		if ( ( rc = xfer_deliver_raw ( &conn->xfer,
+					       ( conn->response + conn->sent ),
+					       len ) ) != 0 ) {
+			peerserv_close ( conn, rc );
+			return;
+		}
+		conn->sent += len;
+	}
+
+	/* Close connection once response is complete */
+	peerserv_close ( conn, 0 );
+}
+
+/**
+ * Construct HTTP response
+ *
+ * @v conn		Retrieval connection
+ * @v status		HTTP status
+ * @v body		Response body, or NULL
+ * @v len		Length of response body
+ * @ret rc		Return status code
+ */
+static int peerserv_respond ( struct peerserv_connection *conn,
+			      const char *status, const void *body,
+			      size_t len ) {
+	void *response;
+	int hdr_len;
+
+	/* Construct response header */
+	hdr_len = asprintf ( ( ( char ** ) &conn->response ),
+			     "HTTP/1.1 %s\r\n"
+			     "Content-Length: %zd\r\n"
+			     "Connection: close\r\n"
+			     "\r\n", status, len );
+	if ( hdr_len < 0 ) {
+		conn->response = NULL;
+		return -ENOMEM;
+	}
+
+	/* Append response body */
+	if ( len ) {
+		response = realloc ( conn->response, ( hdr_len + len ) );
+		if ( ! response )
+			return -ENOMEM;
+		conn->response = response;
+		memcpy ( ( conn->response + hdr_len ), body, len );
+	}
+	conn->response_len = ( hdr_len + len );
+
+	return 0;
+}
+
+/**
+ * Handle negotiation request
+ *
+ * @v conn		Retrieval connection
+ * @v data		Request message
+ * @v len		Length of request message
+ * @ret rc		Return status code
+ */
+static int peerserv_nego ( struct peerserv_connection *conn,
+			   const void *data __unused, size_t len __unused ) {
+	struct {
+		struct peerdist_msg_transport_header hdr;
+		struct peerdist_msg_nego_resp msg;
+	} __attribute__ (( packed )) rsp;
+
+	/* Construct negotiation response */
+	memset ( &rsp, 0, sizeof ( rsp ) );
+	rsp.hdr.len = htonl ( sizeof ( rsp.msg ) );
+	rsp.msg.hdr.version.raw = htonl ( PEERDIST_MSG_NEGO_RESP_VERSION );
+	rsp.msg.hdr.type = htonl ( PEERDIST_MSG_NEGO_RESP_TYPE );
+	rsp.msg.hdr.len = htonl ( sizeof ( rsp.msg ) );
+	rsp.msg.versions.min.raw = htonl ( PEERDIST_MSG_VERSION_1_0 );
+	rsp.msg.versions.max.raw = htonl ( PEERDIST_MSG_VERSION_1_0 );
+
+	return peerserv_respond ( conn, "200 OK", &rsp, sizeof ( rsp ) );
+}
+
+/**
+ * Identify segment within a block list or block fetch request
+ *
+ * @v conn		Retrieval connection
+ * @v data		Request message
+ * @v len		Length of request message
+ * @v segment		Content information segment to fill in
+ * @v first		First requested block to fill in
+ * @ret content		Served content, or NULL if not found
+ */
+static struct peerserv_content *
+peerserv_segment ( struct peerserv_connection *conn, const void *data,
+		   size_t len, struct peerdist_info_segment *segment,
+		   unsigned int *first ) {
+	const struct peerdist_msg_getblks *req = data;
+	const peerdist_msg_segment_t ( 0 ) *seg = ( ( void * ) ( req + 1 ) );
+	const struct peerdist_msg_ranges *ranges;
+	const struct peerdist_msg_range *range;
+	struct peerserv_content *content;
+	size_t digestsize;
+	unsigned int index;
+	int rc;
+
+	/* Check segment ID */
+	if ( len < ( sizeof ( *req ) + sizeof ( *seg ) ) )
+		return NULL;
+	digestsize = ntohl ( seg->segment.digestsize );
+	if ( digestsize > PEERDIST_DIGEST_MAX_SIZE )
+		return NULL;
+	ranges = ( ( ( void * ) seg->id ) + digestsize +
+		   ( ( -digestsize ) & 0x3 ) );
+	range = ( ( void * ) ( ranges + 1 ) );
+	if ( len < ( size_t ) ( ( ( void * ) ( range + 1 ) ) - data ) )
+		return NULL;
+	*first = ( ranges->count ? ntohl ( range->first ) : 0 );
+
+	/* Find served content */
+	content = peerserv_find ( seg->id, digestsize, &index );
+	if ( ! content ) {
+		DBGC ( conn, "PEERSERV %p unknown segment:\n", conn );
+		DBGC_HDA ( conn, 0, seg->id, digestsize );
+		return NULL;
+	}
+
+	/* Get content information segment */
+	if ( ( rc = peerdist_info_segment ( &content->info, segment,
+					    index ) ) != 0 ) {
+		DBGC ( conn, "PEERSERV %p could not get segment %d: %s\n",
+		       conn, index, strerror ( rc ) );
+		return NULL;
+	}
+
+	return content;
+}
+
+/**
+ * Handle block list request
+ *
+ * @v conn		Retrieval connection
+ * @v data		Request message
+ * @v len		Length of request message
+ * @ret rc		Return status code
+ */
+static int peerserv_getblklist ( struct peerserv_connection *conn,
+				 const void *data, size_t len ) {
+	struct peerdist_info_segment segment;
+	struct peerserv_content *content;
+	unsigned int first;
+	size_t digestsize;
+	int rc;
+
+	/* Identify segment */
+	content = peerserv_segment ( conn, data, len, &segment, &first );
+	if ( ! content )
+		return peerserv_respond ( conn, "404 Not Found", NULL, 0 );
+	digestsize = content->info.digestsize;
+
+	/* Construct block list response */
+	{
+		struct {
+			struct peerdist_msg_transport_header hdr;
+			peerdist_msg_blklist_t ( digestsize, 1 ) msg;
+		} __attribute__ (( packed )) *rsp;
+
+		rsp = zalloc ( sizeof ( *rsp ) );
+		if ( ! rsp )
+			return -ENOMEM;
+		rsp->hdr.len = htonl ( sizeof ( rsp->msg ) );
+		rsp->msg.blklist.hdr.version.raw =
+			htonl ( PEERDIST_MSG_BLKLIST_VERSION );
+		rsp->msg.blklist.hdr.type = htonl ( PEERDIST_MSG_BLKLIST_TYPE );
+		rsp->msg.blklist.hdr.len = htonl ( sizeof ( rsp->msg ) );
+		rsp->msg.segment.segment.digestsize = htonl ( digestsize );
+		memcpy ( rsp->msg.segment.id, segment.id, digestsize );
+		rsp->msg.ranges.ranges.count = htonl ( 1 );
+		rsp->msg.ranges.range[0].first = htonl ( 0 );
+		rsp->msg.ranges.range[0].count = htonl ( segment.blocks );
+		rc = peerserv_respond ( conn, "200 OK", rsp, sizeof ( *rsp ) );
+		free ( rsp );
+	}
+
+	return rc;
+}
+
+/**
+ * Handle block fetch request
+ *
+ * @v conn		Retrieval connection
+ * @v data		Request message
+ * @v len		Length of request message
+ * @ret rc		Return status code
+ */
+static int peerserv_getblks ( struct peerserv_connection *conn,
+			      const void *data, size_t len ) {
+	const struct peerdist_msg_getblks *req = data;
+	struct cipher_algorithm *cipher = &aes_cbc_algorithm;
+	size_t blksize = cipher->blocksize;
+	struct peerdist_info_segment segment;
+	struct peerdist_info_block block;
+	struct peerserv_content *content;
+	const void *block_data = NULL;
+	unsigned int index;
+	size_t digestsize;
+	size_t block_len = 0;
+	size_t keylen;
+	uint32_t iv[ blksize / sizeof ( uint32_t ) ];
+	void *ctx;
+	unsigned int i;
+	int rc;
+
+	/* Determine key length */
+	switch ( req->hdr.algorithm ) {
+	case htonl ( PEERDIST_MSG_AES_128_CBC ) :
+		keylen = ( 128 / 8 );
+		break;
+	case htonl ( PEERDIST_MSG_AES_192_CBC ) :
+		keylen = ( 192 / 8 );
+		break;
+	case htonl ( PEERDIST_MSG_AES_256_CBC ) :
+		keylen = ( 256 / 8 );
+		break;
+	default:
+		DBGC ( conn, "PEERSERV %p unsupported algorithm %#08x\n",
+		       conn, ntohl ( req->hdr.algorithm ) );
+		return peerserv_respond ( conn, "400 Bad Request", NULL, 0 );
+	}
+
+	/* Identify segment and block */
+	content = peerserv_segment ( conn, data, len, &segment, &index );
+	if ( ! content )
+		return peerserv_respond ( conn, "404 Not Found", NULL, 0 );
+	digestsize = content->info.digestsize;
+	if ( keylen > digestsize )
+		return peerserv_respond ( conn, "400 Bad Request", NULL, 0 );
+
+	/* Locate block data, if available */
+	if ( index < segment.blocks ) {
+		if ( ( rc = peerdist_info_block ( &segment, &block,
+						  index ) ) != 0 ) {
+			return rc;
+		}
+		block_data = peerserv_data ( content, &block );
+		if ( block_data ) {
+			block_len = ( block.range.end - block.range.start );
+			block_len = ( ( block_len + blksize - 1 ) &
+				      ~( blksize - 1 ) );
+		}
+	}
+	DBGC ( conn, "PEERSERV %p block %d.%d %s\n", conn, segment.index,
+	       index, ( block_data ? "served" : "not found" ) );
+
+	/* Generate a random initialisation vector.  The key is known
+	 * to anyone holding the content information, so this does not
+	 * require high quality randomness.
+	 */
+	for ( i = 0 ; i < ( sizeof ( iv ) / sizeof ( iv[0] ) ) ; i++ )
+		iv[i] = random();
+
+	/* Construct block fetch response */
+	{
+		peerblk_msg_blk_t ( digestsize, block_len, 0, blksize ) *rsp;
+
+		rsp = zalloc ( sizeof ( *rsp ) );
+		if ( ! rsp )
+			return -ENOMEM;
+		rsp->hdr.len = htonl ( sizeof ( rsp->msg ) );
+		rsp->msg.blk.hdr.version.raw =
+			htonl ( PEERDIST_MSG_BLK_VERSION );
+		rsp->msg.blk.hdr.type = htonl ( PEERDIST_MSG_BLK_TYPE );
+		rsp->msg.blk.hdr.len = htonl ( sizeof ( rsp->msg ) );
+		rsp->msg.blk.hdr.algorithm = req->hdr.algorithm;
+		rsp->msg.segment.segment.digestsize = htonl ( digestsize );
+		memcpy ( rsp->msg.segment.id, segment.id, digestsize );
+		rsp->msg.index = htonl ( index );
+		if ( ( index + 1 ) < segment.blocks )
+			rsp->msg.next = htonl ( index + 1 );
+		rsp->msg.block.block.len = htonl ( block_len );
+		rsp->msg.iv.iv.blksize = htonl ( blksize );
+		memcpy ( rsp->msg.iv.data, iv, blksize );
+
+		/* Encrypt block data, if present */
+		if ( block_data ) {
+			memcpy ( rsp->msg.block.data, block_data,
+				 ( block.range.end - block.range.start ) );
+			ctx = malloc ( cipher->ctxsize );
+			if ( ! ctx ) {
+				free ( rsp );
+				return -ENOMEM;
+			}
+			if ( ( rc = cipher_setkey ( cipher, ctx, segment.secret,
+						    keylen ) ) != 0 ) {
+				free ( ctx );
+				free ( rsp );
+				return rc;
+			}
+			cipher_setiv ( cipher, ctx, iv, blksize );
+			cipher_encrypt ( cipher, ctx, rsp->msg.block.data,
+					 rsp->msg.block.data, block_len );
+			free ( ctx );
+		}
+
+		rc = peerserv_respond ( conn, "200 OK", rsp, sizeof ( *rsp ) );
+		free ( rsp );
+	}
+
+	return rc;
+}
+
+/**
+ * Handle retrieval request
+ *
+ * @v conn		Retrieval connection
+ * @v data		Request message
+ * @v len		Length of request message
+ * @ret rc		Return status code
+ */
+static int peerserv_message ( struct peerserv_connection *conn,
+			      const void *data, size_t len ) {
+	const struct peerdist_msg_header *hdr = data;
+
+	/* Sanity check */
+	if ( ( len < sizeof ( *hdr ) ) || ( ntohl ( hdr->len ) > len ) ) {
+		DBGC ( conn, "PEERSERV %p malformed message:\n", conn );
+		DBGC_HDA ( conn, 0, data, len );
+		return peerserv_respond ( conn, "400 Bad Request", NULL, 0 );
+	}
+	len = ntohl ( hdr->len );
+
+	/* Handle message */
+	switch ( hdr->type ) {
+	case htonl ( PEERDIST_MSG_NEGO_REQ_TYPE ) :
+		return peerserv_nego ( conn, data, len );
+	case htonl ( PEERDIST_MSG_GETBLKLIST_TYPE ) :
+		return peerserv_getblklist ( conn, data, len );
+	case htonl ( PEERDIST_MSG_GETBLKS_TYPE ) :
+		return peerserv_getblks ( conn, data, len );
+	default:
+		DBGC ( conn, "PEERSERV %p unsupported message type %#08x\n",
+		       conn, ntohl ( hdr->type ) );
+		return peerserv_respond ( conn, "400 Bad Request", NULL, 0 );
+	}
+}
+
+/**
+ * Handle received request data
+ *
+ * @v conn		Retrieval connection
+ * @v iobuf		I/O buffer
+ * @v meta		Data transfer metadata
+ * @ret rc		Return status code
+ */
+static int peerserv_deliver ( struct peerserv_connection *conn,
+			      struct io_buffer *iobuf,
+			      struct xfer_metadata *meta __unused ) {
+	size_t len = iob_len ( iobuf );
+	size_t hdr_len;
+	size_t body_len = 0;
+	char *end;
+	char *line;
+	char *next;
+	int rc;
+
+	/* Ignore anything received after the request */
+	if ( conn->response ) {
+		rc = 0;
+		goto done;
+	}
+
+	/* Accumulate request */
+	if ( len > ( sizeof ( conn->request ) - conn->len - 1 /* NUL */ ) ) {
+		DBGC ( conn, "PEERSERV %p request too long\n", conn );
+		rc = -ERANGE;
+		goto err;
+	}
+	memcpy ( ( conn->request + conn->len ), iobuf->data, len );
+	conn->len += len;
+	conn->request[conn->len] = '\0';
+
+	/* Wait for end of headers */
+	end = strstr ( conn->request, "\r\n\r\n" );
+	if ( ! end ) {
+		rc = 0;
+		goto done;
+	}
+	hdr_len = ( end + 4 /* "\r\n\r\n" */ - conn->request );
+
+	/* Parse headers */
+	for ( line = conn->request ; line < end ; line = ( next + 2 ) ) {
+		next = strstr ( line, "\r\n" );
+		if ( strncasecmp ( line, "Content-Length:", 15 ) == 0 )
+			body_len = strtoul ( ( line + 15 ), NULL, 10 );
+	}
+
+	/* Wait for complete body */
+	if ( conn->len < ( hdr_len + body_len ) ) {
+		if ( ( hdr_len + body_len ) >= sizeof ( conn->request ) ) {
+			rc = -ERANGE;
+			goto err;
+		}
+		rc = 0;
+		goto done;
+	}
+
+	/* Check request method and path */
+	if ( strncmp ( conn->request, "POST " PEERDIST_MAGIC_PATH,
+		       ( 5 /* "POST " */ +
+			 strlen ( PEERDIST_MAGIC_PATH ) ) ) != 0 ) {
+		DBGC ( conn, "PEERSERV %p unsupported request\n", conn );
+		rc = peerserv_respond ( conn, "404 Not Found", NULL, 0 );
+	} else {
+		rc = peerserv_message ( conn, ( conn->request + hdr_len ),
+					body_len );
+	}
+	if ( rc != 0 )
+		goto err;
+
+	/* Start transmitting response */
+	peerserv_send ( conn );
+
+ done:
+	free_iob ( iobuf );
+	return 0;
+
+ err:
+	free_iob ( iobuf );
+	peerserv_close ( conn, rc );
+	return rc;
+}
+
+/** Retrieval connection interface operations */
+static struct interface_operation peerserv_xfer_operations[] = {
+	INTF_OP ( xfer_deliver, struct peerserv_connection *,
+		  peerserv_deliver ),
+	INTF_OP ( xfer_window_changed, struct peerserv_connection *,
+		  peerserv_send ),
+	INTF_OP ( intf_close, struct peerserv_connection *, peerserv_close ),
+};
+
+/** Retrieval connection interface descriptor */
+static struct interface_descriptor peerserv_xfer_desc =
+	INTF_DESC ( struct peerserv_connection, xfer,
+		    peerserv_xfer_operations );
+
+/**
+ * Accept retrieval connection
+ *
+ * @v listener		TCP listener
+ * @v xfer		Data transfer interface for new connection
+ * @v peer		Peer socket address
+ * @ret rc		Return status code
+ */
+static int peerserv_accept ( struct tcp_listener *listener __unused,
+			     struct interface *xfer,
+			     struct sockaddr_tcpip *peer ) {
+	struct peerserv_connection *conn;
+
+	/* Allocate and initialise structure */
+	conn = zalloc ( sizeof ( *conn ) );
+	if ( ! conn )
+		return -ENOMEM;
+	ref_init ( &conn->refcnt, peerserv_free );
+	intf_init ( &conn->xfer, &peerserv_xfer_desc, &conn->refcnt );
+	DBGC ( conn, "PEERSERV %p accepted from %s\n",
+	       conn, sock_ntoa ( ( struct sockaddr * ) peer ) );
+
+	/* Attach to connection and drop our reference */
+	intf_plug_plug ( &conn->xfer, xfer );
+	ref_put ( &conn->refcnt );
+
+	return 0;
+}
+
+/******************************************************************************
+ *
+ * Content registration
+ *
+ ******************************************************************************
+ */
+
+/** PeerDist content server */
+static struct peerdist_server peerserv = {
+	.discovery = INTF_INIT ( peerserv_discovery_desc ),
+	.listener = {
+		.port = PEERSERV_PORT,
+		.accept = peerserv_accept,
+	},
+	.contents = LIST_HEAD_INIT ( peerserv.contents ),
+};
+
+/**
+ * Free served content
+ *
+ * @v content		Served content
+ */
+static void peerserv_remove ( struct peerserv_content *content ) {
+
+	list_del ( &content->list );
+	peerserv.count--;
+	free ( content );
+}
+
+/**
+ * Start PeerDist content server
+ *
+ * @ret rc		Return status code
+ */
+static int peerserv_start ( void ) {
+	union {
+		struct sockaddr sa;
+		struct sockaddr_in sin;
+	} peer;
+	union {
+		struct sockaddr sa;
+		struct sockaddr_in sin;
+	} local;
+	union {
+		union uuid uuid;
+		uint32_t dword[ sizeof ( union uuid ) / sizeof ( uint32_t ) ];
+	} random_uuid;
+	unsigned int i;
+	int rc;
+
+	/* Generate a random endpoint UUID */
+	for ( i = 0 ; i < ( sizeof ( random_uuid.dword ) /
+			    sizeof ( random_uuid.dword[0] ) ) ; i++ )
+		random_uuid.dword[i] = random();
+	snprintf ( peerserv.uuid, sizeof ( peerserv.uuid ), "%s",
+		   uuid_ntoa ( &random_uuid.uuid ) );
+
+	/* Open discovery socket */
+	memset ( &peer, 0, sizeof ( peer ) );
+	peer.sin.sin_family = AF_INET;
+	peer.sin.sin_port = htons ( PEERDIST_DISCOVERY_PORT );
+	peer.sin.sin_addr.s_addr = PEERDIST_DISCOVERY_IPV4;
+	memset ( &local, 0, sizeof ( local ) );
+	local.sin.sin_family = AF_INET;
+	local.sin.sin_port = htons ( PEERDIST_DISCOVERY_PORT );
+	if ( ( rc = xfer_open_socket ( &peerserv.discovery, SOCK_DGRAM,
+				       &peer.sa, &local.sa ) ) != 0 ) {
+		DBGC ( &peerserv, "PEERSERV could not open discovery socket: "
+		       "%s\n", strerror ( rc ) );
+		goto err_socket;
+	}
+
+	/* Listen for retrieval connections */
+	if ( ( rc = tcp_listen ( &peerserv.listener ) ) != 0 ) {
+		DBGC ( &peerserv, "PEERSERV could not listen: %s\n",
+		       strerror ( rc ) );
+		goto err_listen;
+	}
+
+	DBGC ( &peerserv, "PEERSERV started as %s\n", peerserv.uuid );
+	return 0;
+
+	tcp_unlisten ( &peerserv.listener );
+ err_listen:
+	intf_restart ( &peerserv.discovery, rc );
+ err_socket:
+	return rc;
+}
+
+/**
+ * Stop PeerDist content server
+ *
+ */
+static void peerserv_stop ( void ) {
+
+	/* Stop listening and close discovery socket */
+	tcp_unlisten ( &peerserv.listener );
+	intf_restart ( &peerserv.discovery, 0 );
+	DBGC ( &peerserv, "PEERSERV stopped\n" );
+}
+
+/**
+ * Offer downloaded content to peers
+ *
+ * @v data		Raw content information
+ * @v len		Length of raw content information
+ *
+ * This is called on completion of a PeerDist download.  The content
+ * itself is located (and verified) within the registered images as
+ * and when blocks are requested.
+ */
+void peerserv_add ( const void *data, size_t len ) {
+	struct peerserv_content *content;
+	struct peerserv_content *tmp;
+	struct peerserv_segment *seg;
+	struct peerdist_info_segment segment;
+	struct peerdist_info_block block;
+	struct peerdist_info info;
+	void *raw;
+	unsigned int i;
+	unsigned int j;
+	int rc;
+
+	/* Refresh any identical content */
+	list_for_each_entry ( tmp, &peerserv.contents, list ) {
+		if ( ( tmp->info.raw.len == len ) &&
+		     ( memcmp ( tmp->info.raw.data, data, len ) == 0 ) ) {
+			list_del ( &tmp->list );
+			list_add ( &tmp->list, &peerserv.contents );
+			return;
+		}
+	}
+
+	/* Parse content information */
+	if ( ( rc = peerdist_info ( data, len, &info ) ) != 0 ) {
+		DBGC ( &peerserv, "PEERSERV could not parse content "
+		       "information: %s\n", strerror ( rc ) );
+		return;
+	}
+
+	/* Allocate and initialise structure */
+	content = zalloc ( sizeof ( *content ) +
+			   ( info.segments * sizeof ( content->segments[0] ) ) +
+			   len );
+	if ( ! content )
+		return;
+	content->segments = ( ( void * ) ( content + 1 ) );
+	raw = ( ( ( void * ) content->segments ) +
+		( info.segments * sizeof ( content->segments[0] ) ) );
+	memcpy ( raw, data, len );
+	if ( ( rc = peerdist_info ( raw, len, &content->info ) ) != 0 )
+		goto err_info;
+
+	/* Record segment identifiers and available block counts */
+	for ( i = 0 ; i < info.segments ; i++ ) {
+		seg = &content->segments[i];
+		if ( ( rc = peerdist_info_segment ( &content->info, &segment,
+						    i ) ) != 0 )
+			goto err_segment;
+		memcpy ( seg->id, segment.id, sizeof ( seg->id ) );
+		for ( j = 0 ; j < segment.blocks ; j++ ) {
+			if ( ( rc = peerdist_info_block ( &segment, &block,
+							  j ) ) != 0 )
+				goto err_block;
+			if ( ( block.range.start >= info.trim.start ) &&
+			     ( block.range.end <= info.trim.end ) )
+				seg->blocks++;
+		}
+	}
+
+	/* Start server if applicable */
+	if ( ( ! peerserv.count ) && ( ( rc = peerserv_start() ) != 0 ) )
+		goto err_start;
+
+	/* Add to list of served content, discarding oldest if needed */
+	list_add ( &content->list, &peerserv.contents );
+	if ( ++peerserv.count > PEERSERV_CONTENT_MAX ) {
+		tmp = list_last_entry ( &peerserv.contents,
+					struct peerserv_content, list );
+		peerserv_remove ( tmp );
+	}
+	DBGC ( &peerserv, "PEERSERV serving %d segments for [%08zx,%08zx)\n",
+	       info.segments, info.trim.start, info.trim.end );
+
+	return;
+
+ err_start:
+ err_block:
+ err_segment:
+ err_info:
+	free ( content );
+}
+
+/**
+ * Shut down PeerDist content server
+ *
+ * @v booting		System is shutting down for OS boot
+ */
+static void peerserv_shutdown ( int booting __unused ) {
+	struct peerserv_content *content;
+	struct peerserv_content *tmp;
+
+	/* Do nothing unless server is running */
+	if ( ! peerserv.count )
+		return;
+
+	/* Discard all served content */
+	list_for_each_entry_safe ( content, tmp, &peerserv.contents, list )
+		peerserv_remove ( content );
+
+	/* Stop server */
+	peerserv_stop();
+}
+
+/** PeerDist content server shutdown function */
+struct startup_fn peerserv_startup_fn __startup_fn ( STARTUP_NORMAL ) = {
+	.name = "peerserv",
+	.shutdown = peerserv_shutdown,
+};
@@ -40,7 +40,13 @@ FILE_SECBOOT ( PERMITTED );
  *
  * This implementation of the timer is designed to satisfy RFC 2988
  * and therefore be usable as a TCP retransmission timer.
- * 
+ *
+ * Running timers are held within a timer wheel, in the slot
+ * corresponding to their expiry time.  Each poll needs to examine
+ * only the timers within the slots that have been reached since the
+ * previous poll, rather than every running timer.  Timers that
+ * expire more than one revolution in the future will remain in their
+ * slot and will be examined once per revolution.
  */
 
 /* The theoretical minimum that the algorithm in stop_timer() can
@@ -49,8 +55,28 @@ FILE_SECBOOT ( PERMITTED );
  */
 #define MIN_TIMEOUT 7
 
-/** List of running timers */
-static LIST_HEAD ( timers );
+/** Number of timer wheel slots (must be a power of two) */
+#define RETRY_WHEEL_SIZE 128
+
+/** Timer wheel slot granularity (as a power of two number of ticks) */
+#define RETRY_WHEEL_SHIFT 5
+
+/** Timer wheel slots of running timers */
+static struct list_head retry_wheel[RETRY_WHEEL_SIZE];
+
+/** Next timer wheel slot time to be examined */
+static unsigned long retry_cursor;
+
+/**
+ * Get timer wheel slot
+ *
+ * @v slot_time		Slot time (i.e. ticks shifted by the slot granularity)
+ * @ret list		List of timers within timer wheel slot
+ */
+static inline struct list_head * retry_slot ( unsigned long slot_time ) {
+
+	return &retry_wheel[ slot_time & ( RETRY_WHEEL_SIZE - 1 ) ];
+}
 
 /**
  * Start timer with a specified timeout
@@ -64,9 +90,10 @@ static LIST_HEAD ( timers );
  */
 void start_timer_fixed ( struct retry_timer *timer, unsigned long timeout ) {
 
-	/* Add to list of running timers (if applicable) */
-	if ( ! timer->running ) {
-		list_add ( &timer->list, &timers );
+	/* Remove from current timer wheel slot (if applicable) */
+	if ( timer->running ) {
+		list_del ( &timer->list );
+	} else {
 		ref_get ( timer->refcnt );
 		timer->running = 1;
 	}
@@ -77,6 +104,11 @@ void start_timer_fixed ( struct retry_timer *timer, unsigned long timeout ) {
 	/* Record timeout */
 	timer->timeout = timeout;
 
+	/* Add to timer wheel slot corresponding to expiry time */
+	list_add_tail ( &timer->list,
+			retry_slot ( ( timer->start + timer->timeout ) >>
+				     RETRY_WHEEL_SHIFT ) );
+
 	DBGC2 ( timer, "Timer %p started at time %ld (expires at %ld)\n",
 		timer, timer->start, ( timer->start + timer->timeout ) );
 }
@@ -197,23 +229,53 @@ static void timer_expired ( struct retry_timer *timer ) {
  */
 void retry_poll ( void ) {
 	struct retry_timer *timer;
+	struct list_head *list;
 	unsigned long now = currticks();
+	unsigned long slot_time = ( now >> RETRY_WHEEL_SHIFT );
 	unsigned long used;
 
+	/* Examine no more than one full revolution of the wheel */
+	if ( ( slot_time - retry_cursor ) >= RETRY_WHEEL_SIZE )
+		retry_cursor = ( slot_time - RETRY_WHEEL_SIZE + 1 );
+
 	/* Process at most one timer expiry.  We cannot process
 	 * multiple expiries in one pass, because one timer expiring
 	 * may end up triggering another timer's deletion from the
 	 * list.
 	 */
-	list_for_each_entry ( timer, &timers, list ) {
-		used = ( now - timer->start );
-		if ( used >= timer->timeout ) {
-			timer_expired ( timer );
-			break;
+	while ( 1 ) {
+		list = retry_slot ( retry_cursor );
+		list_for_each_entry ( timer, list, list ) {
+			used = ( now - timer->start );
+			if ( used >= timer->timeout ) {
+				timer_expired ( timer );
+				return;
+			}
 		}
+		if ( retry_cursor == slot_time )
+			break;
+		retry_cursor++;
 	}
 }
 
+/**
+ * Initialise retry timers
+ *
+ */
+static void retry_init ( void ) {
+	unsigned int i;
+
+	/* Initialise timer wheel slots */
+	for ( i = 0 ; i < RETRY_WHEEL_SIZE ; i++ )
+		INIT_LIST_HEAD ( &retry_wheel[i] );
+}
+
+/** Retry timer initialisation function */
+struct init_fn retry_init_fn __init_fn ( INIT_EARLY ) = {
+	.name = "retry",
+	.initialise = retry_init,
+};
+
 /**
  * Single-step the retry timer list
  *
@@ -0,0 +1,398 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+FILE_SECBOOT ( PERMITTED );
+
+/** @file
+ *
+ * Reed-Solomon forward error correction
+ *
+ * This is an implementation of the Reed-Solomon erasure code over
+ * GF(2^8) as described in RFC 5510.  A source block of k symbols is
+ * expanded into up to n encoding symbols using the systematic
+ * generator matrix
+ *
+ *     GM = V(k,k)^-1 * V(k,n)
+ *
+ * where V(k,n) is the Vandermonde matrix with elements alpha^(i*j).
+ * The first k encoding symbols are therefore the source symbols
+ * themselves, and any k distinct encoding symbols suffice to
+ * reconstruct the source block.
+ *
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <ipxe/rsfec.h>
+
+/** Field polynomial x^8 + x^4 + x^3 + x^2 + 1 */
+#define RSFEC_POLY 0x11d
+
+/** Exponent table (duplicated to avoid reducing sums of logarithms) */
+static uint8_t rsfec_exp[ 2 * 255 ];
+
+/** Logarithm table */
+static uint8_t rsfec_log[256];
+
+/** Field tables have been constructed */
+static int rsfec_initialised;
+
+/**
+ * Construct field tables
+ *
+ */
+static void rsfec_init ( void ) {
+	unsigned int x = 1;
+	unsigned int i;
+
+	/* Construct tables only once */
+	if ( rsfec_initialised )
+		return;
+
+	/* Construct exponent and logarithm tables */
+	for ( i = 0 ; i < 255 ; i++ ) {
+		rsfec_exp[i] = rsfec_exp[ i + 255 ] = x;
+		rsfec_log[x] = i;
+		x <<= 1;
+		if ( x & 0x100 )
+			x ^= RSFEC_POLY;
+	}
+	rsfec_initialised = 1;
+}
+
+/**
+ * Multiply field elements
+ *
+ * @v a			Multiplicand
+ * @v b			Multiplier
+ * @ret product		Product
+ */
+static inline uint8_t rsfec_mul ( uint8_t a, uint8_t b ) {
+
+	if ( ! ( a && b ) )
+		return 0;
+	return rsfec_exp[ rsfec_log[a] + rsfec_log[b] ];
+}
+
+/**
+ * Calculate Vandermonde matrix element
+ *
+ * @v row		Row index
+ * @v col		Column index
+ * @ret element		alpha^(row*col)
+ */
+static inline uint8_t rsfec_vandermonde ( unsigned int row,
+					  unsigned int col ) {
+
+	return rsfec_exp[ ( row * col ) % 255 ];
+}
+
+/**
+ * Add multiple of symbol to accumulated symbol
+ *
+ * @v dst		Accumulated symbol
+ * @v src		Symbol
+ * @v coeff		Coefficient
+ * @v len		Length of symbols
+ */
+static void rsfec_addmul ( uint8_t *dst, const uint8_t *src, uint8_t coeff,
+			   size_t len ) {
+	unsigned int log_coeff;
+	size_t i;
+
+	/* Do nothing for a zero coefficient */
+	if ( ! coeff )
+		return;
+	log_coeff = rsfec_log[coeff];
+
+	/* Accumulate symbol */
+	for ( i = 0 ; i < len ; i++ ) {
+		if ( src[i] )
+			dst[i] ^= rsfec_exp[ log_coeff + rsfec_log[ src[i] ] ];
+	}
+}
+
+/**
+ * Invert square matrix
+ *
+ * @v matrix		Matrix (will be destroyed)
+ * @v inverse		Inverse matrix to fill in
+ * @v k			Dimension of matrix
+ * @ret rc		Return status code
+ */
+static int rsfec_invert ( uint8_t *matrix, uint8_t *inverse, unsigned int k ) {
+	uint8_t *pivot_row;
+	uint8_t *row;
+	uint8_t scale;
+	uint8_t tmp;
+	unsigned int col;
+	unsigned int i;
+	unsigned int j;
+
+	/* Start with identity matrix */
+	memset ( inverse, 0, ( k * k ) );
+	for ( i = 0 ; i < k ; i++ )
+		inverse[ i * k + i ] = 1;
+
+	/* Perform Gauss-Jordan elimination */
+	for ( col = 0 ; col < k ; col++ ) {
+
+		/* Find a row with a non-zero pivot */
+		for ( i = col ; i < k ; i++ ) {
+			if ( matrix[ i * k + col ] )
+				break;
+		}
+		if ( i == k )
+			return -EINVAL;
+
+		/* Swap into place */
+		if ( i != col ) {
+			for ( j = 0 ; j < k ; j++ ) {
+				tmp = matrix[ i * k + j ];
+				matrix[ i * k + j ] = matrix[ col * k + j ];
+				matrix[ col * k + j ] = tmp;
+				tmp = inverse[ i * k + j ];
+				inverse[ i * k + j ] = inverse[ col * k + j ];
+				inverse[ col * k + j ] = tmp;
+			}
+		}
+
+		/* Scale pivot row to give a unit pivot */
+		pivot_row = &matrix[ col * k ];
+		scale = rsfec_exp[ 255 - rsfec_log[ pivot_row[col] ] ];
+		for ( j = 0 ; j < k ; j++ ) {
+			pivot_row[j] = rsfec_mul ( pivot_row[j], scale );
+			inverse[ col * k + j ] =
+				rsfec_mul ( inverse[ col * k + j ], scale );
+		}
+
+		/* Eliminate column from all other rows */
+		for ( i = 0 ; i < k ; i++ ) {
+			row = &matrix[ i * k ];
+			scale = row[col];
+			if ( ( i == col ) || ( ! scale ) )
+				continue;
+			for ( j = 0 ; j < k ; j++ ) {
+				row[j] ^= rsfec_mul ( pivot_row[j], scale );
+				inverse[ i * k + j ] ^=
+					rsfec_mul ( inverse[ col * k + j ],
+						    scale );
+			}
+		}
+	}
+
+	return 0;
+}
+
+/**
+ * Construct encoding symbol
+ *
+ * @v k			Number of source symbols
+ * @v source		Source symbols
+ * @v esi		Encoding symbol ID
+ * @v symbol		Encoding symbol to fill in
+ * @v len		Length of each symbol
+ * @ret rc		Return status code
+ */
+int rsfec_encode ( unsigned int k, void **source, unsigned int esi,
+		   void *symbol, size_t len ) {
+	uint8_t *matrix;
+	uint8_t *inverse;
+	uint8_t coeff;
+	unsigned int i;
+	unsigned int j;
+	int rc;
+
+	/* Sanity check */
+	if ( ( k == 0 ) || ( esi >= RSFEC_MAX_N ) )
+		return -EINVAL;
+
+	/* Source symbols are encoded as themselves */
+	if ( esi < k ) {
+		memcpy ( symbol, source[esi], len );
+		return 0;
+	}
+
+	/* Allocate matrices */
+	matrix = malloc ( 2 * k * k );
+	if ( ! matrix )
+		return -ENOMEM;
+	inverse = ( matrix + ( k * k ) );
+	rsfec_init();
+
+	/* Invert V(k,k) */
+	for ( i = 0 ; i < k ; i++ ) {
+		for ( j = 0 ; j < k ; j++ )
+			matrix[ i * k + j ] = rsfec_vandermonde ( i, j );
+	}
+	if ( ( rc = rsfec_invert ( matrix, inverse, k ) ) != 0 )
+		goto err_invert;
+
+	/* Construct symbol using column "esi" of the generator matrix */
+	memset ( symbol, 0, len );
+	for ( i = 0 ; i < k ; i++ ) {
+		coeff = 0;
+		for ( j = 0 ; j < k ; j++ ) {
+			coeff ^= rsfec_mul ( inverse[ i * k + j ],
+					     rsfec_vandermonde ( j, esi ) );
+		}
+		rsfec_addmul ( symbol, source[i], coeff, len );
+	}
+
+ err_invert:
+	free ( matrix );
+	return rc;
+}
+
+/**
+ * Reconstruct source block
+ *
+ * @v k			Number of source symbols
+ * @v esi		Encoding symbol IDs
+ * @v symbols		Encoding symbols
+ * @v len		Length of each symbol
+ * @ret rc		Return status code
+ *
+ * On entry, @c symbols[i] holds the encoding symbol with ID @c
+ * esi[i].  On successful exit, the arrays will have been permuted
+ * (and the symbol contents overwritten as necessary) such that @c
+ * symbols[i] holds source symbol @c i.
+ */
+int rsfec_decode ( unsigned int k, uint8_t *esi, void **symbols,
+		   size_t len ) {
+	uint8_t present[ ( RSFEC_MAX_N + 7 ) / 8 ];
+	uint8_t *matrix;
+	uint8_t *inverse;
+	uint8_t *coeff;
+	uint8_t *missing;
+	uint8_t *output;
+	void *tmp_symbol;
+	uint8_t tmp_esi;
+	unsigned int num_missing;
+	unsigned int i;
+	unsigned int j;
+	unsigned int l;
+	int rc;
+
+	/* Check for duplicate or invalid symbol IDs */
+	if ( ( k == 0 ) || ( k > RSFEC_MAX_N ) )
+		return -EINVAL;
+	memset ( present, 0, sizeof ( present ) );
+	for ( i = 0 ; i < k ; i++ ) {
+		if ( ( esi[i] >= RSFEC_MAX_N ) ||
+		     ( present[ esi[i] / 8 ] & ( 1 << ( esi[i] % 8 ) ) ) )
+			return -EINVAL;
+		present[ esi[i] / 8 ] |= ( 1 << ( esi[i] % 8 ) );
+	}
+
+	/* Count missing source symbols */
+	num_missing = 0;
+	for ( i = 0 ; i < k ; i++ ) {
+		if ( ! ( present[ i / 8 ] & ( 1 << ( i % 8 ) ) ) )
+			num_missing++;
+	}
+
+	/* Reconstruct missing source symbols, if any */
+	if ( num_missing ) {
+
+		/* Allocate matrices and reconstructed symbols */
+		matrix = malloc ( ( 2 * k * k ) + k + k +
+				  ( num_missing * len ) );
+		if ( ! matrix )
+			return -ENOMEM;
+		inverse = ( matrix + ( k * k ) );
+		coeff = ( inverse + ( k * k ) );
+		missing = ( coeff + k );
+		output = ( missing + k );
+		rsfec_init();
+
+		/* The received symbols R satisfy R = S * V(k,k)^-1 * A,
+		 * where A holds the columns of V(k,n) corresponding to
+		 * the received symbol IDs.  The source symbols are
+		 * therefore given by S = R * A^-1 * V(k,k).
+		 */
+		for ( i = 0 ; i < k ; i++ ) {
+			for ( j = 0 ; j < k ; j++ ) {
+				matrix[ i * k + j ] =
+					rsfec_vandermonde ( i, esi[j] );
+			}
+		}
+		if ( ( rc = rsfec_invert ( matrix, inverse, k ) ) != 0 ) {
+			free ( matrix );
+			return rc;
+		}
+
+		/* Reconstruct each missing source symbol */
+		num_missing = 0;
+		for ( i = 0 ; i < k ; i++ ) {
+			if ( present[ i / 8 ] & ( 1 << ( i % 8 ) ) )
+				continue;
+			for ( j = 0 ; j < k ; j++ ) {
+				coeff[j] = 0;
+				for ( l = 0 ; l < k ; l++ ) {
+					coeff[j] ^= rsfec_mul (
+						inverse[ j * k + l ],
+						rsfec_vandermonde ( l, i ) );
+				}
+			}
+			memset ( output, 0, len );
+			for ( j = 0 ; j < k ; j++ ) {
+				rsfec_addmul ( output, symbols[j], coeff[j],
+					       len );
+			}
+			missing[num_missing++] = i;
+			output += len;
+		}
+
+		/* Overwrite repair symbols with reconstructed symbols */
+		output -= ( num_missing * len );
+		for ( i = 0 ; i < k ; i++ ) {
+			if ( esi[i] < k )
+				continue;
+			num_missing--;
+			memcpy ( symbols[i], ( output + ( num_missing * len ) ),
+				 len );
+			esi[i] = missing[num_missing];
+		}
+
+		free ( matrix );
+	}
+
+	/* Permute symbols into source symbol order */
+	for ( i = 0 ; i < k ; i++ ) {
+		while ( esi[i] != i ) {
+			j = esi[i];
+			tmp_esi = esi[j];
+			esi[j] = esi[i];
+			esi[i] = tmp_esi;
+			tmp_symbol = symbols[j];
+			symbols[j] = symbols[i];
+			symbols[i] = tmp_symbol;
+		}
+	}
+
+	return 0;
+}
@@ -18,8 +18,12 @@
 #include <ipxe/profile.h>
 #include <ipxe/process.h>
 #include <ipxe/job.h>
+#include <ipxe/settings.h>
+#include <ipxe/slab.h>
 #include <ipxe/tcpip.h>
 #include <ipxe/tcp.h>
+#include <ipxe/tcpreasm.h>
+#include <ipxe/trace.h>
 
 /** @file
  *
@@ -65,6 +69,7 @@ struct tcp_connection {
 	/** Unacknowledged sequence count
 	 *
 	 * Equivalent to (SND.NXT-SND.UNA) in RFC 793 terminology.
+	 * Retransmissions do not reduce this value.
 	 */
 	uint32_t snd_sent;
 	/** Send window
@@ -82,6 +87,34 @@ struct tcp_connection {
 	 * Equivalent to RCV.WND in RFC 793 terminology.
 	 */
 	uint32_t rcv_win;
+	/** Maximum receive window
+	 *
+	 * This is the ceiling on the advertised receive window, as
+	 * determined by receive window autotuning.
+	 */
+	uint32_t rcv_win_max;
+	/** Sequence number at start of current autotuning period */
+	uint32_t tune_seq;
+	/** Time at start of current autotuning period */
+	unsigned long tune_start;
+	/** Smoothed round-trip time (in ticks, scaled by 8)
+	 *
+	 * Equivalent to (8*SRTT) in RFC 6298 terminology.
+	 */
+	unsigned long srtt;
+	/** Round-trip time variation (in ticks, scaled by 4)
+	 *
+	 * Equivalent to (4*RTTVAR) in RFC 6298 terminology.
+	 */
+	unsigned long rttvar;
+	/** Number of retransmission timeouts since last RTT sample */
+	unsigned int backoff;
+	/** Congestion control state */
+	struct tcp_congestion cc;
+	/** Pacing credit (in bytes) */
+	size_t pace_credit;
+	/** Time of most recent pacing credit update */
+	unsigned long pace_time;
 	/** Received timestamp value
 	 *
 	 * Updated when a packet is received; copied to ts_recent when
@@ -106,11 +139,49 @@ struct tcp_connection {
 
 	/** Selective acknowledgement list (in host-endian order) */
 	struct tcp_sack_block sack[TCP_SACK_MAX];
+	/** Received selective acknowledgement scoreboard
+	 *
+	 * Blocks are held in host-endian order.  Empty blocks have
+	 * equal left and right edges.
+	 */
+	struct tcp_sack_block snd_sack[TCP_SACK_SCOREBOARD];
+	/** Number of consecutive duplicate ACKs received */
+	unsigned int dupacks;
+	/** Recovery point
+	 *
+	 * This is the highest sequence number sent at the point of
+	 * entering loss recovery.  Equivalent to RecoveryPoint in RFC
+	 * 6675 terminology.
+	 */
+	uint32_t recover;
+	/** Retransmission point
+	 *
+	 * This is the sequence number following the most recently
+	 * retransmitted segment.  Equivalent to (HighRxt+1) in RFC
+	 * 6675 terminology.
+	 */
+	uint32_t rtx_seq;
+	/** Time of most recent retransmission */
+	unsigned long rtx_time;
+	/** Transmission time of most recently delivered segment
+	 *
+	 * Equivalent to RACK.xmit_ts in RFC 8985 terminology.
+	 */
+	unsigned long rack_time;
+	/** Transmission time records */
+	struct tcp_xmit_record xmit[TCP_RACK_RECORDS];
+	/** Transmission time record producer index */
+	unsigned int xmit_prod;
+
+	/** Fast Open cookie */
+	uint8_t fastopen[TCP_FASTOPEN_COOKIE_MAX];
+	/** Length of Fast Open cookie (or zero if no cookie known) */
+	size_t fastopen_len;
 
 	/** Transmit queue */
 	struct list_head tx_queue;
 	/** Receive queue */
-	struct list_head rx_queue;
+	struct tcp_reasm rx_queue;
 	/** Transmission process */
 	struct process process;
 	/** Retransmission timer */
@@ -124,6 +195,13 @@ struct tcp_connection {
 	struct pending_operation pending_flags;
 	/** Pending operations for transmit queue */
 	struct pending_operation pending_data;
+
+	/** Statistics */
+	struct tcp_connection_statistics stats;
+	/** Start time of current zero receive window interval */
+	unsigned long rcv_zero_start;
+	/** Start time of current zero send window interval */
+	unsigned long snd_zero_start;
 };
 
 /** TCP flags */
@@ -136,31 +214,36 @@ enum tcp_flags {
 	TCP_ACK_PENDING = 0x0004,
 	/** TCP selective acknowledgement is enabled */
 	TCP_SACK_ENABLED = 0x0008,
+	/** TCP round-trip time has been measured */
+	TCP_RTT_VALID = 0x0010,
+	/** TCP loss recovery is in progress */
+	TCP_RECOVERY = 0x0020,
+	/** TCP loss recovery was triggered by a retransmission timeout */
+	TCP_RTO_RECOVERY = 0x0040,
+	/** TCP retransmission is pending */
+	TCP_RTX_PENDING = 0x0080,
+	/** TCP most recently delivered transmission time is known */
+	TCP_RACK_VALID = 0x0100,
+	/** TCP retransmission timer is acting as RACK reordering timer */
+	TCP_RACK_TIMER = 0x0200,
+	/** TCP connection was accepted from a listener */
+	TCP_PASSIVE = 0x0400,
+	/** TCP Fast Open option should be included within SYN */
+	TCP_FASTOPEN = 0x0800,
+	/** TCP receive window is currently advertised as zero */
+	TCP_RCV_ZERO_WIN = 0x1000,
+	/** TCP send window is currently zero */
+	TCP_SND_ZERO_WIN = 0x2000,
 };
 
-/** TCP internal header
- *
- * This is the header that replaces the TCP header for packets
- * enqueued on the receive queue.
- */
-struct tcp_rx_queued_header {
-	/** SEQ value, in host-endian order
-	 *
-	 * This represents the SEQ value at the time the packet is
-	 * enqueued, and so excludes the SYN, if present.
-	 */
-	uint32_t seq;
-	/** Next SEQ value, in host-endian order */
-	uint32_t nxt;
-	/** Flags
-	 *
-	 * Only FIN is valid within this flags byte; all other flags
-	 * have already been processed by the time the packet is
-	 * enqueued.
-	 */
-	uint8_t flags;
-	/** Reserved */
-	uint8_t reserved[3];
+/** A cached TCP Fast Open cookie */
+struct tcp_fastopen_cookie {
+	/** Remote socket address */
+	struct sockaddr_tcpip peer;
+	/** Length of cookie (or zero if entry is unused) */
+	size_t len;
+	/** Cookie */
+	uint8_t cookie[TCP_FASTOPEN_COOKIE_MAX];
 };
 
 /**
@@ -168,9 +251,21 @@ struct tcp_rx_queued_header {
  */
 static LIST_HEAD ( tcp_conns );
 
+/** List of TCP listeners */
+static LIST_HEAD ( tcp_listeners );
+
 /** TCP statistics */
 struct tcp_statistics tcp_stats;
 
+/** Cached TCP Fast Open cookies */
+static struct tcp_fastopen_cookie tcp_fastopen_cache[TCP_FASTOPEN_CACHE];
+
+/** Next TCP Fast Open cookie cache entry to be replaced */
+static unsigned int tcp_fastopen_next;
+
+/** TCP connection slab cache */
+static SLAB_CACHE ( tcp_cache, "tcp", sizeof ( struct tcp_connection ) );
+
 /** Transmit profiler */
 static struct profiler tcp_tx_profiler __profiler = { .name = "tcp.tx" };
 
@@ -180,13 +275,25 @@ static struct profiler tcp_rx_profiler __profiler = { .name = "tcp.rx" };
 /** Data transfer profiler */
 static struct profiler tcp_xfer_profiler __profiler = { .name = "tcp.xfer" };
 
+/** TCP congestion control algorithm setting */
+const struct setting tcp_congestion_setting __setting ( SETTING_MISC,
+							tcp-congestion ) = {
+	.name = "tcp-congestion",
+	.description = "TCP congestion control algorithm",
+	.type = &setting_type_string,
+};
+
 /* Forward declarations */
 static struct process_descriptor tcp_process_desc;
 static struct interface_descriptor tcp_xfer_desc;
 static void tcp_expired ( struct retry_timer *timer, int over );
 static void tcp_keepalive_expired ( struct retry_timer *timer, int over );
 static void tcp_wait_expired ( struct retry_timer *timer, int over );
-static struct tcp_connection * tcp_demux ( unsigned int local_port );
+static struct tcp_connection * tcp_demux ( unsigned int local_port,
+					   struct sockaddr_tcpip *peer );
+static struct tcp_listener * tcp_listener ( unsigned int local_port );
+static void tcp_close ( struct tcp_connection *tcp, int rc );
+static void tcp_rack ( struct tcp_connection *tcp );
 static int tcp_rx_ack ( struct tcp_connection *tcp, uint32_t ack,
 			uint32_t win );
 
@@ -225,10 +332,68 @@ tcp_dump_state ( struct tcp_connection *tcp ) {
 		DBGC ( tcp, "TCP %p transitioned from %s to %s\n", tcp,
 		       tcp_state ( tcp->prev_tcp_state ),
 		       tcp_state ( tcp->tcp_state ) );
+		if ( tcp->tcp_state == TCP_ESTABLISHED )
+			trace ( "tcp", "established", tcp, 0 );
 	}
 	tcp->prev_tcp_state = tcp->tcp_state;
 }
 
+/**
+ * Update zero window time accounting
+ *
+ * @v tcp		TCP connection
+ * @v flag		Zero window flag
+ * @v zero		Window is now zero
+ * @v start		Start time of current zero window interval
+ * @v total		Total time spent with a zero window
+ */
+static void tcp_zero_window ( struct tcp_connection *tcp, unsigned int flag,
+			      int zero, unsigned long *start,
+			      unsigned long *total ) {
+	unsigned long elapsed;
+
+	if ( zero && ! ( tcp->flags & flag ) ) {
+
+		/* Start new zero window interval */
+		tcp->flags |= flag;
+		*start = currticks();
+
+	} else if ( ( ! zero ) && ( tcp->flags & flag ) ) {
+
+		/* End current zero window interval */
+		tcp->flags &= ~flag;
+		elapsed = ( currticks() - *start );
+		*total += elapsed;
+		tcp_stats.zero_win += elapsed;
+	}
+}
+
+/**
+ * Update zero receive window time accounting
+ *
+ * @v tcp		TCP connection
+ * @v zero		Advertised receive window is now zero
+ */
+static inline void tcp_rcv_zero_window ( struct tcp_connection *tcp,
+					 int zero ) {
+
+	tcp_zero_window ( tcp, TCP_RCV_ZERO_WIN, zero, &tcp->rcv_zero_start,
+			  &tcp->stats.rcv_zero_win );
+}
+
+/**
+ * Update zero send window time accounting
+ *
+ * @v tcp		TCP connection
+ * @v zero		Send window is now zero
+ */
+static inline void tcp_snd_zero_window ( struct tcp_connection *tcp,
+					 int zero ) {
+
+	tcp_zero_window ( tcp, TCP_SND_ZERO_WIN, zero, &tcp->snd_zero_start,
+			  &tcp->stats.snd_zero_win );
+}
+
 /**
  * Dump TCP flags
  *
@@ -263,55 +428,371 @@ tcp_dump_flags ( struct tcp_connection *tcp, unsigned int flags ) {
  */
 static int tcp_port_available ( int port ) {
 
-	return ( tcp_demux ( port ) ? -EADDRINUSE : port );
+	return ( ( tcp_demux ( port, NULL ) || tcp_listener ( port ) ) ?
+		 -EADDRINUSE : port );
 }
 
+/***************************************************************************
+ *
+ * Congestion control
+ *
+ ***************************************************************************
+ */
+
 /**
- * Open a TCP connection
+ * Increase congestion window during slow start
+ *
+ * @v cc		Congestion control state
+ * @v len		Length of newly acknowledged data
+ *
+ * This is the standard slow start algorithm, using appropriate byte
+ * counting as per RFC 3465.
+ */
+void tcp_slow_start ( struct tcp_congestion *cc, uint32_t len ) {
+
+	/* Increase by acknowledged length, up to two segments per ACK */
+	if ( len > ( 2 * TCP_CONGESTION_MSS ) )
+		len = ( 2 * TCP_CONGESTION_MSS );
+	cc->cwnd += len;
+}
+
+/**
+ * Calculate pacing rate
+ *
+ * @v cc		Congestion control state
+ * @v rtt		Smoothed round-trip time (in ticks), or zero
+ * @ret rate		Pacing rate (in bytes per tick), or zero
+ *
+ * This is the standard pacing rate calculation, spreading a
+ * congestion window across the round-trip time.  The rate is
+ * increased by a factor of 2 during slow start and by a factor of
+ * 1.25 during congestion avoidance, in order to allow the window to
+ * grow.
+ */
+size_t tcp_pace ( struct tcp_congestion *cc, unsigned long rtt ) {
+	size_t rate;
+
+	/* Do not pace without a round-trip time estimate */
+	if ( ! rtt )
+		return 0;
+
+	/* Calculate rate */
+	if ( cc->cwnd < cc->ssthresh ) {
+		rate = ( ( 2 * cc->cwnd ) / rtt );
+	} else {
+		rate = ( ( cc->cwnd + ( cc->cwnd / 4 ) ) / rtt );
+	}
+	return ( rate ? rate : 1 );
+}
+
+/**
+ * Increase congestion window during congestion avoidance (Reno)
+ *
+ * @v cc		Congestion control state
+ * @v len		Length of newly acknowledged data
+ * @v rtt		Smoothed round-trip time (in ticks), or zero
+ *
+ * Increase the congestion window by one segment per window of
+ * acknowledged data, as per RFC 5681.
+ */
+static void tcp_reno_avoid ( struct tcp_congestion *cc, uint32_t len,
+			     unsigned long rtt __unused ) {
+
+	cc->acked += len;
+	if ( cc->acked >= cc->cwnd ) {
+		cc->acked -= cc->cwnd;
+		cc->cwnd += TCP_CONGESTION_MSS;
+	}
+}
+
+/**
+ * Respond to packet loss (Reno)
+ *
+ * @v cc		Congestion control state
+ * @v flight		Length of unacknowledged data
+ * @v timeout		Loss was detected by retransmission timeout
+ */
+static void tcp_reno_loss ( struct tcp_congestion *cc, uint32_t flight,
+			    int timeout ) {
+
+	/* Halve the window as per RFC 5681 */
+	cc->ssthresh = ( flight / 2 );
+	if ( cc->ssthresh < ( 2 * TCP_CONGESTION_MSS ) )
+		cc->ssthresh = ( 2 * TCP_CONGESTION_MSS );
+	cc->cwnd = ( timeout ? TCP_CONGESTION_MSS : cc->ssthresh );
+	cc->acked = 0;
+}
+
+/** Reno congestion control algorithm */
+struct tcp_congestion_algorithm tcp_reno __tcp_congestion_algorithm = {
+	.name = "reno",
+	.slow_start = tcp_slow_start,
+	.avoid = tcp_reno_avoid,
+	.loss = tcp_reno_loss,
+	.pace = tcp_pace,
+};
+
+/**
+ * Initialise congestion control
+ *
+ * @v tcp		TCP connection
+ */
+static void tcp_congestion_init ( struct tcp_connection *tcp ) {
+	struct tcp_congestion *cc = &tcp->cc;
+	struct tcp_congestion_algorithm *algorithm;
+	char name[16];
+
+	/* Identify congestion control algorithm, defaulting to Reno */
+	cc->algorithm = &tcp_reno;
+	if ( fetch_string_setting ( NULL, &tcp_congestion_setting, name,
+				    sizeof ( name ) ) > 0 ) {
+		for_each_table_entry ( algorithm, TCP_CONGESTION_ALGORITHMS ) {
+			if ( strcmp ( name, algorithm->name ) == 0 )
+				cc->algorithm = algorithm;
+		}
+		if ( strcmp ( name, cc->algorithm->name ) != 0 ) {
+			DBGC ( tcp, "TCP %p unknown congestion control "
+			       "\"%s\"\n", tcp, name );
+		}
+	}
+	DBGC ( tcp, "TCP %p using %s congestion control\n",
+	       tcp, cc->algorithm->name );
+
+	/* Start in slow start with the initial window */
+	cc->cwnd = TCP_INITIAL_CWND;
+	cc->ssthresh = ~( ( uint32_t ) 0 );
+}
+
+/**
+ * Get smoothed round-trip time for congestion control
+ *
+ * @v tcp		TCP connection
+ * @ret rtt		Smoothed round-trip time (in ticks), or zero
+ */
+static unsigned long tcp_congestion_rtt ( struct tcp_connection *tcp ) {
+
+	return ( ( tcp->flags & TCP_RTT_VALID ) ? ( tcp->srtt / 8 ) : 0 );
+}
+
+/**
+ * Update congestion window for newly acknowledged data
+ *
+ * @v tcp		TCP connection
+ * @v len		Length of newly acknowledged data
+ */
+static void tcp_congestion_ack ( struct tcp_connection *tcp, uint32_t len ) {
+	struct tcp_congestion *cc = &tcp->cc;
+
+	/* Grow window using slow start or congestion avoidance */
+	if ( cc->cwnd < cc->ssthresh ) {
+		cc->algorithm->slow_start ( cc, len );
+	} else {
+		cc->algorithm->avoid ( cc, len, tcp_congestion_rtt ( tcp ) );
+	}
+
+	/* There is no point in growing the window beyond the amount
+	 * of data that we are prepared to have outstanding.
+	 */
+	if ( cc->cwnd > TCP_MAX_FLIGHT_SIZE )
+		cc->cwnd = TCP_MAX_FLIGHT_SIZE;
+}
+
+/**
+ * Update congestion window for detected packet loss
+ *
+ * @v tcp		TCP connection
+ * @v timeout		Loss was detected by retransmission timeout
+ */
+static void tcp_congestion_loss ( struct tcp_connection *tcp, int timeout ) {
+	struct tcp_congestion *cc = &tcp->cc;
+
+	/* Leave slow start threshold unchanged on repeated timeouts */
+	if ( timeout && ( tcp->flags & TCP_RTO_RECOVERY ) ) {
+		cc->cwnd = TCP_CONGESTION_MSS;
+		return;
+	}
+
+	/* Allow algorithm to respond to loss */
+	cc->algorithm->loss ( cc, tcp->snd_sent, timeout );
+	DBGC ( tcp, "TCP %p %s congestion window %d threshold %d\n",
+	       tcp, cc->algorithm->name, cc->cwnd, cc->ssthresh );
+}
+
+/**
+ * Calculate available pacing credit
+ *
+ * @v tcp		TCP connection
+ * @ret credit		Number of bytes that may be transmitted now
+ */
+static size_t tcp_congestion_pace ( struct tcp_connection *tcp ) {
+	struct tcp_congestion *cc = &tcp->cc;
+	unsigned long now = currticks();
+	unsigned long elapsed;
+	size_t burst;
+	size_t rate;
+
+	/* Do not pace unless the algorithm provides a rate */
+	rate = cc->algorithm->pace ( cc, tcp_congestion_rtt ( tcp ) );
+	if ( ! rate )
+		return ~( ( size_t ) 0 );
+
+	/* Accumulate credit, up to the larger of one tick's worth of
+	 * data and the maximum burst size.
+	 */
+	burst = ( TCP_PACING_BURST * TCP_CONGESTION_MSS );
+	if ( burst < rate )
+		burst = rate;
+	elapsed = ( now - tcp->pace_time );
+	if ( elapsed > ( burst / rate ) ) {
+		tcp->pace_credit = burst;
+	} else {
+		tcp->pace_credit += ( elapsed * rate );
+		if ( tcp->pace_credit > burst )
+			tcp->pace_credit = burst;
+	}
+	tcp->pace_time = now;
+
+	return tcp->pace_credit;
+}
+
+/**
+ * Free a TCP connection
+ *
+ * @v refcnt		Reference counter
+ */
+static void tcp_free ( struct refcnt *refcnt ) {
+	struct tcp_connection *tcp =
+		container_of ( refcnt, struct tcp_connection, refcnt );
+
+	slab_free ( &tcp_cache, tcp );
+}
+
+/**
+ * Find cached TCP Fast Open cookie
  *
- * @v xfer		Data transfer interface
  * @v peer		Peer socket address
- * @v local		Local socket address, or NULL
+ * @ret cached		Cached cookie, or NULL if not found
+ */
+static struct tcp_fastopen_cookie *
+tcp_fastopen_find ( struct sockaddr_tcpip *peer ) {
+	struct tcp_fastopen_cookie *cached;
+	unsigned int i;
+
+	for ( i = 0 ; i < TCP_FASTOPEN_CACHE ; i++ ) {
+		cached = &tcp_fastopen_cache[i];
+		if ( cached->len &&
+		     ( memcmp ( &cached->peer, peer,
+				sizeof ( cached->peer ) ) == 0 ) ) {
+			return cached;
+		}
+	}
+	return NULL;
+}
+
+/**
+ * Record received TCP Fast Open cookie
+ *
+ * @v tcp		TCP connection
+ * @v foopt		Fast Open option
+ */
+static void tcp_fastopen_record ( struct tcp_connection *tcp,
+				  const struct tcp_fastopen_option *foopt ) {
+	struct tcp_fastopen_cookie *cached;
+	size_t len = ( foopt->length - sizeof ( *foopt ) );
+
+	/* Ignore invalid cookies */
+	if ( ( len < TCP_FASTOPEN_COOKIE_MIN ) ||
+	     ( len > TCP_FASTOPEN_COOKIE_MAX ) || ( len & 1 ) ) {
+		DBGC ( tcp, "TCP %p ignoring invalid %zd-byte Fast Open "
+		       "cookie\n", tcp, len );
+		return;
+	}
+
+	/* Reuse existing entry for this peer, or replace oldest entry */
+	cached = tcp_fastopen_find ( &tcp->peer );
+	if ( ! cached ) {
+		cached = &tcp_fastopen_cache[tcp_fastopen_next];
+		tcp_fastopen_next = ( ( tcp_fastopen_next + 1 ) %
+				      TCP_FASTOPEN_CACHE );
+		memcpy ( &cached->peer, &tcp->peer, sizeof ( cached->peer ) );
+	}
+	memcpy ( cached->cookie, foopt->cookie, len );
+	cached->len = len;
+	DBGC ( tcp, "TCP %p recorded %zd-byte Fast Open cookie\n",
+	       tcp, len );
+}
+
+/**
+ * Allocate a TCP connection
+ *
+ * @v peer		Peer socket address
+ * @ret tcp_out		TCP connection
  * @ret rc		Return status code
  */
-static int tcp_open ( struct interface *xfer, struct sockaddr *peer,
-		      struct sockaddr *local ) {
-	struct sockaddr_tcpip *st_peer = ( struct sockaddr_tcpip * ) peer;
-	struct sockaddr_tcpip *st_local = ( struct sockaddr_tcpip * ) local;
+static int tcp_alloc ( struct sockaddr_tcpip *peer,
+		       struct tcp_connection **tcp_out ) {
 	struct tcp_connection *tcp;
 	size_t mtu;
-	int port;
-	int rc;
 
 	/* Allocate and initialise structure */
-	tcp = zalloc ( sizeof ( *tcp ) );
+	tcp = slab_alloc ( &tcp_cache );
 	if ( ! tcp )
 		return -ENOMEM;
 	DBGC ( tcp, "TCP %p allocated\n", tcp );
-	ref_init ( &tcp->refcnt, NULL );
+	ref_init ( &tcp->refcnt, tcp_free );
 	intf_init ( &tcp->xfer, &tcp_xfer_desc, &tcp->refcnt );
 	process_init_stopped ( &tcp->process, &tcp_process_desc, &tcp->refcnt );
 	timer_init ( &tcp->timer, tcp_expired, &tcp->refcnt );
+	set_timer_limits ( &tcp->timer, TCP_MIN_RTO, TCP_MAX_RTO );
 	timer_init ( &tcp->keepalive, tcp_keepalive_expired, &tcp->refcnt );
 	timer_init ( &tcp->wait, tcp_wait_expired, &tcp->refcnt );
 	tcp->prev_tcp_state = TCP_CLOSED;
 	tcp->tcp_state = TCP_STATE_SENT ( TCP_SYN );
 	tcp_dump_state ( tcp );
 	tcp->snd_seq = random();
+	tcp->rcv_win_max = TCP_INITIAL_WINDOW_SIZE;
+	tcp_congestion_init ( tcp );
+	if ( tcp_stats.rcv_win_max < tcp->rcv_win_max )
+		tcp_stats.rcv_win_max = tcp->rcv_win_max;
 	INIT_LIST_HEAD ( &tcp->tx_queue );
-	INIT_LIST_HEAD ( &tcp->rx_queue );
-	memcpy ( &tcp->peer, st_peer, sizeof ( tcp->peer ) );
+	tcp_reasm_init ( &tcp->rx_queue );
+	memcpy ( &tcp->peer, peer, sizeof ( tcp->peer ) );
 
 	/* Calculate MSS */
 	mtu = tcpip_mtu ( &tcp->peer );
 	if ( ! mtu ) {
 		DBGC ( tcp, "TCP %p has no route to %s\n",
-		       tcp, sock_ntoa ( peer ) );
-		rc = -ENETUNREACH;
-		goto err;
+		       tcp, sock_ntoa ( ( struct sockaddr * ) peer ) );
+		ref_put ( &tcp->refcnt );
+		return -ENETUNREACH;
 	}
 	tcp->mss = ( mtu - sizeof ( struct tcp_header ) );
 
+	*tcp_out = tcp;
+	return 0;
+}
+
+/**
+ * Open a TCP connection
+ *
+ * @v xfer		Data transfer interface
+ * @v peer		Peer socket address
+ * @v local		Local socket address, or NULL
+ * @ret rc		Return status code
+ */
+static int tcp_open ( struct interface *xfer, struct sockaddr *peer,
+		      struct sockaddr *local ) {
+	struct sockaddr_tcpip *st_peer = ( struct sockaddr_tcpip * ) peer;
+	struct sockaddr_tcpip *st_local = ( struct sockaddr_tcpip * ) local;
+	struct tcp_fastopen_cookie *cached;
+	struct tcp_connection *tcp;
+	int port;
+	int rc;
+
+	/* Allocate connection */
+	if ( ( rc = tcp_alloc ( st_peer, &tcp ) ) != 0 )
+		return rc;
+
 	/* Bind to local port */
 	port = tcpip_bind ( st_local, tcp_port_available );
 	if ( port < 0 ) {
@@ -323,8 +804,24 @@ static int tcp_open ( struct interface *xfer, struct sockaddr *peer,
 	tcp->local_port = port;
 	DBGC ( tcp, "TCP %p bound to port %d\n", tcp, tcp->local_port );
 
-	/* Start timer to initiate SYN */
-	start_timer_nodelay ( &tcp->timer );
+	/* Request or use a Fast Open cookie */
+	tcp->flags |= TCP_FASTOPEN;
+	cached = tcp_fastopen_find ( st_peer );
+	if ( cached ) {
+		memcpy ( tcp->fastopen, cached->cookie, cached->len );
+		tcp->fastopen_len = cached->len;
+	}
+
+	/* Start timer to initiate SYN.  If we have a Fast Open
+	 * cookie, then allow a short time for data to be provided
+	 * for inclusion within the SYN.
+	 */
+	if ( tcp->fastopen_len ) {
+		start_timer_fixed ( &tcp->timer, TCP_FASTOPEN_DELAY );
+	} else {
+		start_timer_nodelay ( &tcp->timer );
+	}
+	trace ( "tcp", "connect", tcp, 0 );
 
 	/* Add a pending operation for the SYN */
 	pending_get ( &tcp->pending_flags );
@@ -341,6 +838,101 @@ static int tcp_open ( struct interface *xfer, struct sockaddr *peer,
 	return rc;
 }
 
+/**
+ * Accept an incoming TCP connection
+ *
+ * @v listener		TCP listener
+ * @v peer		Peer socket address
+ * @ret tcp		TCP connection, or NULL on error
+ *
+ * The new connection is created in the SYN_SENT state, exactly as
+ * for an active open.  Processing the received SYN will then move
+ * the connection to SYN_RCVD (as for a simultaneous open), and our
+ * first transmission will therefore be a SYN/ACK.
+ */
+static struct tcp_connection * tcp_accept ( struct tcp_listener *listener,
+					    struct sockaddr_tcpip *peer ) {
+	struct tcp_connection *tcp;
+	int rc;
+
+	/* Allocate connection */
+	if ( ( rc = tcp_alloc ( peer, &tcp ) ) != 0 )
+		return NULL;
+	tcp->local_port = listener->port;
+	tcp->flags |= TCP_PASSIVE;
+	DBGC ( tcp, "TCP %p accepted on port %d from %s:%d\n",
+	       tcp, tcp->local_port, sock_ntoa ( ( struct sockaddr * ) peer ),
+	       ntohs ( peer->st_port ) );
+
+	/* Add a pending operation for the SYN */
+	pending_get ( &tcp->pending_flags );
+
+	/* Add to connection list (transferring reference) */
+	list_add ( &tcp->list, &tcp_conns );
+
+	/* Hand connection to listener */
+	if ( ( rc = listener->accept ( listener, &tcp->xfer, peer ) ) != 0 ) {
+		DBGC ( tcp, "TCP %p rejected: %s\n", tcp, strerror ( rc ) );
+		tcp_close ( tcp, rc );
+		return NULL;
+	}
+
+	return tcp;
+}
+
+/**
+ * Identify TCP listener by local port number
+ *
+ * @v local_port	Local port
+ * @ret listener	TCP listener, or NULL
+ */
+static struct tcp_listener * tcp_listener ( unsigned int local_port ) {
+	struct tcp_listener *listener;
+
+	list_for_each_entry ( listener, &tcp_listeners, list ) {
+		if ( listener->port == local_port )
+			return listener;
+	}
+	return NULL;
+}
+
+/**
+ * Listen for incoming TCP connections
+ *
+ * @v listener		TCP listener
+ * @ret rc		Return status code
+ */
+int tcp_listen ( struct tcp_listener *listener ) {
+
+	/* Fail if port is already in use */
+	if ( tcp_listener ( listener->port ) ) {
+		DBGC ( listener, "TCP %p port %d already has a listener\n",
+		       listener, listener->port );
+		return -EADDRINUSE;
+	}
+
+	/* Add to list of listeners */
+	list_add ( &listener->list, &tcp_listeners );
+	DBGC ( listener, "TCP %p listening on port %d\n",
+	       listener, listener->port );
+
+	return 0;
+}
+
+/**
+ * Stop listening for incoming TCP connections
+ *
+ * @v listener		TCP listener
+ *
+ * Any connections already accepted are unaffected.
+ */
+void tcp_unlisten ( struct tcp_listener *listener ) {
+
+	list_del ( &listener->list );
+	DBGC ( listener, "TCP %p stopped listening on port %d\n",
+	       listener, listener->port );
+}
+
 /**
  * Close TCP connection
  *
@@ -354,6 +946,9 @@ static void tcp_close ( struct tcp_connection *tcp, int rc ) {
 	struct io_buffer *iobuf;
 	struct io_buffer *tmp;
 
+	/* Record trace event */
+	trace ( "tcp", "close", tcp, rc );
+
 	/* Close data transfer interface */
 	intf_shutdown ( &tcp->xfer, rc );
 	tcp->flags |= TCP_XFER_CLOSED;
@@ -369,10 +964,7 @@ static void tcp_close ( struct tcp_connection *tcp, int rc ) {
 		tcp_dump_state ( tcp );
 
 		/* Free any unprocessed I/O buffers */
-		list_for_each_entry_safe ( iobuf, tmp, &tcp->rx_queue, list ) {
-			list_del ( &iobuf->list );
-			free_iob ( iobuf );
-		}
+		tcp_reasm_flush ( &tcp->rx_queue );
 
 		/* Free any unsent I/O buffers */
 		list_for_each_entry_safe ( iobuf, tmp, &tcp->tx_queue, list ) {
@@ -386,6 +978,10 @@ static void tcp_close ( struct tcp_connection *tcp, int rc ) {
 		pending_put ( &tcp->pending_flags );
 		pending_put ( &tcp->pending_flags );
 
+		/* Close any open zero window intervals */
+		tcp_rcv_zero_window ( tcp, 0 );
+		tcp_snd_zero_window ( tcp, 0 );
+
 		/* Remove from list and drop reference */
 		process_del ( &tcp->process );
 		stop_timer ( &tcp->timer );
@@ -431,19 +1027,45 @@ static void tcp_close ( struct tcp_connection *tcp, int rc ) {
  * Calculate transmission window
  *
  * @v tcp		TCP connection
- * @ret len		Maximum length that can be sent in a single packet
+ * @ret len		Maximum length of unacknowledged data
  */
 static size_t tcp_xmit_win ( struct tcp_connection *tcp ) {
 	size_t len;
 
+	/* Allow data to be included within an unsent Fast Open SYN */
+	if ( ( tcp->flags & TCP_FASTOPEN ) && tcp->fastopen_len &&
+	     ( tcp->tcp_state == TCP_SYN_SENT ) && ( tcp->snd_sent == 0 ) )
+		return TCP_FASTOPEN_MAX_LEN;
+
 	/* Not ready if we're not in a suitable connection state */
 	if ( ! TCP_CAN_SEND_DATA ( tcp->tcp_state ) )
 		return 0;
 
-	/* Length is the minimum of the receiver's window and the path MTU */
+	/* Length is the minimum of the receiver's window, the
+	 * congestion window, and the maximum amount of data that we
+	 * are prepared to hold in the transmit queue.
+	 */
 	len = tcp->snd_win;
-	if ( len > TCP_PATH_MTU )
-		len = TCP_PATH_MTU;
+	if ( len > tcp->cc.cwnd )
+		len = tcp->cc.cwnd;
+	if ( len > TCP_MAX_FLIGHT_SIZE )
+		len = TCP_MAX_FLIGHT_SIZE;
+
+	return len;
+}
+
+/**
+ * Calculate length of transmit queue
+ *
+ * @v tcp		TCP connection
+ * @ret len		Length of data in transmit queue
+ */
+static size_t tcp_tx_queued ( struct tcp_connection *tcp ) {
+	struct io_buffer *iobuf;
+	size_t len = 0;
+
+	list_for_each_entry ( iobuf, &tcp->tx_queue, list )
+		len += iob_len ( iobuf );
 
 	return len;
 }
@@ -455,16 +1077,11 @@ static size_t tcp_xmit_win ( struct tcp_connection *tcp ) {
  * @ret len		Length of window
  */
 static size_t tcp_xfer_window ( struct tcp_connection *tcp ) {
+	size_t win = tcp_xmit_win ( tcp );
+	size_t queued = tcp_tx_queued ( tcp );
 
-	/* Not ready if data queue is non-empty.  This imposes a limit
-	 * of only one unACKed packet in the TX queue at any time; we
-	 * do this to conserve memory usage.
-	 */
-	if ( ! list_empty ( &tcp->tx_queue ) )
-		return 0;
-
-	/* Return TCP window length */
-	return tcp_xmit_win ( tcp );
+	/* Return remaining space within the transmission window */
+	return ( ( queued < win ) ? ( win - queued ) : 0 );
 }
 
 /**
@@ -477,31 +1094,8 @@ static size_t tcp_xfer_window ( struct tcp_connection *tcp ) {
  */
 static uint32_t tcp_sack_block ( struct tcp_connection *tcp, uint32_t seq,
 				 struct tcp_sack_block *sack ) {
-	struct io_buffer *iobuf;
-	struct tcp_rx_queued_header *tcpqhdr;
-	uint32_t left = tcp->rcv_ack;
-	uint32_t right = left;
 
-	/* Find highest block which does not start after SEQ */
-	list_for_each_entry ( iobuf, &tcp->rx_queue, list ) {
-		tcpqhdr = iobuf->data;
-		if ( tcp_cmp ( tcpqhdr->seq, right ) > 0 ) {
-			if ( tcp_cmp ( tcpqhdr->seq, seq ) > 0 )
-				break;
-			left = tcpqhdr->seq;
-		}
-		if ( tcp_cmp ( tcpqhdr->nxt, right ) > 0 )
-			right = tcpqhdr->nxt;
-	}
-
-	/* Fail if this block does not contain SEQ */
-	if ( tcp_cmp ( right, seq ) < 0 )
-		return 0;
-
-	/* Populate SACK block */
-	sack->left = left;
-	sack->right = right;
-	return ( right - left );
+	return tcp_reasm_sack ( &tcp->rx_queue, seq, sack );
 }
 
 /**
@@ -559,30 +1153,41 @@ static unsigned int tcp_sack ( struct tcp_connection *tcp, uint32_t seq ) {
  * Process TCP transmit queue
  *
  * @v tcp		TCP connection
+ * @v offset		Offset within transmit queue
  * @v max_len		Maximum length to process
  * @v dest		I/O buffer to fill with data, or NULL
  * @v remove		Remove data from queue
  * @ret len		Length of data processed
  *
  * This processes at most @c max_len bytes from the TCP connection's
- * transmit queue.  Data will be copied into the @c dest I/O buffer
- * (if provided) and, if @c remove is true, removed from the transmit
- * queue.
+ * transmit queue, starting at @c offset bytes from the start of the
+ * queue.  Data will be copied into the @c dest I/O buffer (if
+ * provided) and, if @c remove is true, removed from the transmit
+ * queue.  Data may be removed only from the start of the queue.
  */
-static size_t tcp_process_tx_queue ( struct tcp_connection *tcp, size_t max_len,
+static size_t tcp_process_tx_queue ( struct tcp_connection *tcp,
+				     size_t offset, size_t max_len,
 				     struct io_buffer *dest, int remove ) {
 	struct io_buffer *iobuf;
 	struct io_buffer *tmp;
 	size_t frag_len;
 	size_t len = 0;
 
+	/* Sanity check */
+	assert ( ( offset == 0 ) || ( ! remove ) );
+
 	list_for_each_entry_safe ( iobuf, tmp, &tcp->tx_queue, list ) {
 		frag_len = iob_len ( iobuf );
+		if ( offset >= frag_len ) {
+			offset -= frag_len;
+			continue;
+		}
+		frag_len -= offset;
 		if ( frag_len > max_len )
 			frag_len = max_len;
 		if ( dest ) {
-			memcpy ( iob_put ( dest, frag_len ), iobuf->data,
-				 frag_len );
+			memcpy ( iob_put ( dest, frag_len ),
+				 ( iobuf->data + offset ), frag_len );
 		}
 		if ( remove ) {
 			iob_pull ( iobuf, frag_len );
@@ -592,6 +1197,7 @@ static size_t tcp_process_tx_queue ( struct tcp_connection *tcp, size_t max_len,
 				pending_put ( &tcp->pending_data );
 			}
 		}
+		offset = 0;
 		len += frag_len;
 		max_len -= frag_len;
 	}
@@ -599,18 +1205,224 @@ static size_t tcp_process_tx_queue ( struct tcp_connection *tcp, size_t max_len,
 }
 
 /**
- * Transmit any outstanding data (with selective acknowledgement)
+ * Calculate retransmission timeout
+ *
+ * @v tcp		TCP connection
+ * @ret rto		Retransmission timeout (in ticks)
+ *
+ * The retransmission timeout is calculated from the smoothed
+ * round-trip time and round-trip time variation as per RFC 6298,
+ * and is backed off exponentially for each consecutive timeout.
+ */
+static unsigned long tcp_rto ( struct tcp_connection *tcp ) {
+	unsigned long rto;
+	unsigned int i;
+
+	/* Calculate timeout as per RFC 6298, with a clock
+	 * granularity of one tick.
+	 */
+	rto = ( ( tcp->srtt / 8 ) + ( tcp->rttvar ? tcp->rttvar : 1 ) );
+	if ( rto < TCP_MIN_RTO )
+		rto = TCP_MIN_RTO;
+
+	/* Apply exponential backoff */
+	for ( i = 0 ; ( i < tcp->backoff ) && ( rto < TCP_MAX_RTO ) ; i++ )
+		rto <<= 1;
+	if ( rto > TCP_MAX_RTO )
+		rto = TCP_MAX_RTO;
+
+	return rto;
+}
+
+/**
+ * Start retransmission timer
+ *
+ * @v tcp		TCP connection
+ *
+ * If a round-trip time has been measured then the timer is started
+ * using the calculated retransmission timeout, otherwise the retry
+ * timer's own timeout estimate is used.
+ */
+static void tcp_start_timer ( struct tcp_connection *tcp ) {
+
+	tcp->flags &= ~TCP_RACK_TIMER;
+	if ( tcp->flags & TCP_RTT_VALID ) {
+		start_timer_fixed ( &tcp->timer, tcp_rto ( tcp ) );
+	} else {
+		start_timer ( &tcp->timer );
+	}
+}
+
+/**
+ * Record transmission time of new data
+ *
+ * @v tcp		TCP connection
+ * @v seq		SEQ value (in host-endian order)
+ */
+static void tcp_rack_record ( struct tcp_connection *tcp, uint32_t seq ) {
+	struct tcp_xmit_record *record;
+	unsigned long now = currticks();
+
+	/* Share record with any segments transmitted in the same tick */
+	if ( tcp->xmit_prod ) {
+		record = &tcp->xmit[ ( tcp->xmit_prod - 1 ) %
+				     TCP_RACK_RECORDS ];
+		if ( record->time == now )
+			return;
+	}
+
+	/* Create new record */
+	record = &tcp->xmit[ tcp->xmit_prod++ % TCP_RACK_RECORDS ];
+	record->seq = seq;
+	record->time = now;
+}
+
+/**
+ * Find transmission time of data
+ *
+ * @v tcp		TCP connection
+ * @v seq		SEQ value (in host-endian order)
+ * @ret time		Transmission time (in ticks)
+ *
+ * Data that predates the oldest record is assumed to have been
+ * transmitted at the time of the oldest record.
+ */
+static unsigned long tcp_rack_time ( struct tcp_connection *tcp,
+				     uint32_t seq ) {
+	struct tcp_xmit_record *record = NULL;
+	unsigned int count;
+	unsigned int i;
+
+	/* Search from most recent to oldest record */
+	count = ( ( tcp->xmit_prod < TCP_RACK_RECORDS ) ?
+		  tcp->xmit_prod : TCP_RACK_RECORDS );
+	for ( i = 1 ; i <= count ; i++ ) {
+		record = &tcp->xmit[ ( tcp->xmit_prod - i ) %
+				     TCP_RACK_RECORDS ];
+		if ( tcp_cmp ( record->seq, seq ) <= 0 )
+			break;
+	}
+	return ( record ? record->time : currticks() );
+}
+
+/**
+ * Find next segment to retransmit
+ *
+ * @v tcp		TCP connection
+ * @v seq		SEQ value of segment to fill in (in host-endian order)
+ * @ret len		Length of segment, or zero if nothing to retransmit
+ *
+ * The next segment to retransmit is the first hole in the
+ * selective acknowledgement scoreboard at or beyond the
+ * retransmission point.  During fast recovery, a hole is considered
+ * to be lost (and therefore eligible for retransmission) only if it
+ * lies at the start of the unacknowledged data or if there is some
+ * selectively acknowledged data beyond it.  Following a
+ * retransmission timeout, all holes are considered to be lost.
+ */
+static size_t tcp_rtx_next ( struct tcp_connection *tcp, uint32_t *seq ) {
+	struct tcp_sack_block *sack;
+	uint32_t start;
+	uint32_t end;
+	uint32_t highest;
+	unsigned int i;
+	int moved;
+
+	/* Start from retransmission point */
+	start = tcp->rtx_seq;
+	if ( tcp_cmp ( start, tcp->snd_seq ) < 0 )
+		start = tcp->snd_seq;
+
+	/* Skip over any selectively acknowledged data */
+	do {
+		moved = 0;
+		for ( i = 0 ; i < TCP_SACK_SCOREBOARD ; i++ ) {
+			sack = &tcp->snd_sack[i];
+			if ( ( tcp_cmp ( start, sack->left ) >= 0 ) &&
+			     ( tcp_cmp ( start, sack->right ) < 0 ) ) {
+				start = sack->right;
+				moved = 1;
+			}
+		}
+	} while ( moved );
+
+	/* Find end of hole and highest selectively acknowledged data */
+	end = tcp->recover;
+	highest = tcp->snd_seq;
+	for ( i = 0 ; i < TCP_SACK_SCOREBOARD ; i++ ) {
+		sack = &tcp->snd_sack[i];
+		if ( sack->left == sack->right )
+			continue;
+		if ( ( tcp_cmp ( sack->left, start ) > 0 ) &&
+		     ( tcp_cmp ( sack->left, end ) < 0 ) )
+			end = sack->left;
+		if ( tcp_cmp ( sack->right, highest ) > 0 )
+			highest = sack->right;
+	}
+
+	/* Check that hole exists and is considered to be lost */
+	if ( tcp_cmp ( start, end ) >= 0 )
+		return 0;
+	if ( ( start != tcp->snd_seq ) &&
+	     ( ! ( tcp->flags & TCP_RTO_RECOVERY ) ) &&
+	     ( tcp_cmp ( highest, end ) < 0 ) )
+		return 0;
+
+	/* Limit to a single packet */
+	*seq = start;
+	return ( ( ( end - start ) > TCP_PATH_MTU ) ?
+		 TCP_PATH_MTU : ( end - start ) );
+}
+
+/**
+ * Construct TCP selective acknowledgement permitted and Fast Open options
  *
  * @v tcp		TCP connection
+ * @v iobuf		I/O buffer
+ *
+ * The Fast Open option is placed immediately after an unpadded
+ * selective acknowledgement permitted option, with any padding placed
+ * before both, to leave space for a maximum-length cookie within a
+ * SYN.  An empty Fast Open option is sent to request a cookie.
+ */
+static void tcp_xmit_fastopen ( struct tcp_connection *tcp,
+				struct io_buffer *iobuf ) {
+	struct tcp_sack_permitted_option *spopt;
+	struct tcp_fastopen_option *foopt;
+	size_t len;
+	size_t pad;
+	void *opts;
+
+	len = ( sizeof ( *spopt ) + sizeof ( *foopt ) + tcp->fastopen_len );
+	pad = ( ( -len ) & 0x03 );
+	opts = iob_push ( iobuf, ( pad + len ) );
+	memset ( opts, TCP_OPTION_NOP, pad );
+	spopt = ( opts + pad );
+	spopt->kind = TCP_OPTION_SACK_PERMITTED;
+	spopt->length = sizeof ( *spopt );
+	foopt = ( ( ( void * ) spopt ) + sizeof ( *spopt ) );
+	foopt->kind = TCP_OPTION_FASTOPEN;
+	foopt->length = ( sizeof ( *foopt ) + tcp->fastopen_len );
+	memcpy ( foopt->cookie, tcp->fastopen, tcp->fastopen_len );
+}
+
+/**
+ * Transmit TCP segment
+ *
+ * @v tcp		TCP connection
+ * @v offset		Offset within unacknowledged sequence space
+ * @v len		Length of data payload
+ * @v flags		TCP flags
  * @v sack_seq		SEQ for first selective acknowledgement (if any)
- * 
- * Transmits any outstanding data on the connection.
+ * @ret rc		Return status code
  *
  * Note that even if an error is returned, the retransmission timer
  * will have been started if necessary, and so the stack will
  * eventually attempt to retransmit the failed packet.
  */
-static void tcp_xmit_sack ( struct tcp_connection *tcp, uint32_t sack_seq ) {
+static int tcp_xmit_segment ( struct tcp_connection *tcp, size_t offset,
+			      size_t len, unsigned int flags,
+			      uint32_t sack_seq ) {
 	struct io_buffer *iobuf;
 	struct tcp_header *tcphdr;
 	struct tcp_mss_option *mssopt;
@@ -620,11 +1432,10 @@ static void tcp_xmit_sack ( struct tcp_connection *tcp, uint32_t sack_seq ) {
 	struct tcp_sack_padded_option *sackopt;
 	struct tcp_sack_block *sack;
 	void *payload;
-	unsigned int flags;
 	unsigned int sack_count;
 	unsigned int i;
-	size_t len = 0;
 	size_t sack_len;
+	uint32_t seq;
 	uint32_t seq_len;
 	uint32_t max_rcv_win;
 	uint32_t max_representable_win;
@@ -633,55 +1444,40 @@ static void tcp_xmit_sack ( struct tcp_connection *tcp, uint32_t sack_seq ) {
 	/* Start profiling */
 	profile_start ( &tcp_tx_profiler );
 
-	/* If retransmission timer is already running, do nothing */
-	if ( timer_running ( &tcp->timer ) )
-		return;
-
-	/* Calculate both the actual (payload) and sequence space
-	 * lengths that we wish to transmit.
-	 */
-	if ( TCP_CAN_SEND_DATA ( tcp->tcp_state ) ) {
-		len = tcp_process_tx_queue ( tcp, tcp_xmit_win ( tcp ),
-					     NULL, 0 );
-	}
+	/* Calculate sequence space length */
+	seq = ( tcp->snd_seq + offset );
 	seq_len = len;
-	flags = TCP_FLAGS_SENDING ( tcp->tcp_state );
 	if ( flags & ( TCP_SYN | TCP_FIN ) ) {
 		/* SYN or FIN consume one byte, and we can never send both */
 		assert ( ! ( ( flags & TCP_SYN ) && ( flags & TCP_FIN ) ) );
 		seq_len++;
 	}
-	tcp->snd_sent = seq_len;
-
-	/* If we have nothing to transmit, stop now */
-	if ( ( seq_len == 0 ) && ! ( tcp->flags & TCP_ACK_PENDING ) )
-		return;
 
 	/* If we are transmitting anything that requires
 	 * acknowledgement (i.e. consumes sequence space), start the
-	 * retransmission timer.  Do this before attempting to
-	 * allocate the I/O buffer, in case allocation itself fails.
+	 * retransmission timer if not already running.  Do this
+	 * before attempting to allocate the I/O buffer, in case
+	 * allocation itself fails.
 	 */
-	if ( seq_len )
-		start_timer ( &tcp->timer );
+	if ( seq_len && ( ! timer_running ( &tcp->timer ) ) )
+		tcp_start_timer ( tcp );
 
 	/* Allocate I/O buffer */
 	iobuf = alloc_iob ( len + TCP_MAX_HEADER_LEN );
 	if ( ! iobuf ) {
 		DBGC ( tcp, "TCP %p could not allocate iobuf for %08x..%08x "
-		       "%08x\n", tcp, tcp->snd_seq, ( tcp->snd_seq + seq_len ),
-		       tcp->rcv_ack );
-		return;
+		       "%08x\n", tcp, seq, ( seq + seq_len ), tcp->rcv_ack );
+		return -ENOMEM;
 	}
 	iob_reserve ( iobuf, TCP_MAX_HEADER_LEN );
 
 	/* Fill data payload from transmit queue */
-	tcp_process_tx_queue ( tcp, len, iobuf, 0 );
+	tcp_process_tx_queue ( tcp, offset, len, iobuf, 0 );
 
 	/* Expand receive window if possible */
 	max_rcv_win = xfer_window ( &tcp->xfer );
-	if ( max_rcv_win > TCP_MAX_WINDOW_SIZE )
-		max_rcv_win = TCP_MAX_WINDOW_SIZE;
+	if ( max_rcv_win > tcp->rcv_win_max )
+		max_rcv_win = tcp->rcv_win_max;
 	max_representable_win = ( 0xffff << tcp->rcv_win_scale );
 	if ( max_rcv_win > max_representable_win )
 		max_rcv_win = max_representable_win;
@@ -701,10 +1497,15 @@ static void tcp_xmit_sack ( struct tcp_connection *tcp, uint32_t sack_seq ) {
 		wsopt->wsopt.kind = TCP_OPTION_WS;
 		wsopt->wsopt.length = sizeof ( wsopt->wsopt );
 		wsopt->wsopt.scale = TCP_RX_WINDOW_SCALE;
-		spopt = iob_push ( iobuf, sizeof ( *spopt ) );
-		memset ( spopt->nop, TCP_OPTION_NOP, sizeof ( spopt->nop ) );
-		spopt->spopt.kind = TCP_OPTION_SACK_PERMITTED;
-		spopt->spopt.length = sizeof ( spopt->spopt );
+		if ( tcp->flags & TCP_FASTOPEN ) {
+			tcp_xmit_fastopen ( tcp, iobuf );
+		} else {
+			spopt = iob_push ( iobuf, sizeof ( *spopt ) );
+			memset ( spopt->nop, TCP_OPTION_NOP,
+				 sizeof ( spopt->nop ) );
+			spopt->spopt.kind = TCP_OPTION_SACK_PERMITTED;
+			spopt->spopt.length = sizeof ( spopt->spopt );
+		}
 	}
 	if ( ( flags & TCP_SYN ) || ( tcp->flags & TCP_TS_ENABLED ) ) {
 		tsopt = iob_push ( iobuf, sizeof ( *tsopt ) );
@@ -715,7 +1516,7 @@ static void tcp_xmit_sack ( struct tcp_connection *tcp, uint32_t sack_seq ) {
 		tsopt->tsopt.tsecr = htonl ( tcp->ts_recent );
 	}
 	if ( ( tcp->flags & TCP_SACK_ENABLED ) &&
-	     ( ! list_empty ( &tcp->rx_queue ) ) &&
+	     ( ! tcp_reasm_empty ( &tcp->rx_queue ) ) &&
 	     ( ( sack_count = tcp_sack ( tcp, sack_seq ) ) != 0 ) ) {
 		sack_len = ( sack_count * sizeof ( *sack ) );
 		sackopt = iob_push ( iobuf, ( sizeof ( *sackopt ) + sack_len ));
@@ -735,12 +1536,19 @@ static void tcp_xmit_sack ( struct tcp_connection *tcp, uint32_t sack_seq ) {
 	memset ( tcphdr, 0, sizeof ( *tcphdr ) );
 	tcphdr->src = htons ( tcp->local_port );
 	tcphdr->dest = tcp->peer.st_port;
-	tcphdr->seq = htonl ( tcp->snd_seq );
+	tcphdr->seq = htonl ( seq );
 	tcphdr->ack = htonl ( tcp->rcv_ack );
 	tcphdr->hlen = ( ( payload - iobuf->data ) << 2 );
 	tcphdr->flags = flags;
 	tcphdr->win = htons ( tcp->rcv_win >> tcp->rcv_win_scale );
-	tcphdr->csum = tcpip_chksum ( iobuf->data, iob_len ( iobuf ) );
+	tcpip_defer_chksum ( iobuf, ( payload - iobuf->data ), &tcphdr->csum );
+	iobuf->flags |= IOB_TX_TCP;
+
+	/* Request segmentation offload, if applicable */
+	if ( len > TCP_PATH_MTU ) {
+		iobuf->flags |= IOB_TX_TSO;
+		iobuf->mss = TCP_PATH_MTU;
+	}
 
 	/* Dump header */
 	DBGC2 ( tcp, "TCP %p TX %d->%d %08x..%08x           %08x %4zd",
@@ -754,15 +1562,147 @@ static void tcp_xmit_sack ( struct tcp_connection *tcp, uint32_t sack_seq ) {
 	if ( ( rc = tcpip_tx ( iobuf, &tcp_protocol, NULL, &tcp->peer, NULL,
 			       &tcphdr->csum ) ) != 0 ) {
 		DBGC ( tcp, "TCP %p could not transmit %08x..%08x %08x: %s\n",
-		       tcp, tcp->snd_seq, ( tcp->snd_seq + tcp->snd_sent ),
-		       tcp->rcv_ack, strerror ( rc ) );
-		return;
+		       tcp, seq, ( seq + seq_len ), tcp->rcv_ack,
+		       strerror ( rc ) );
+		return rc;
 	}
 
 	/* Clear ACK-pending flag */
 	tcp->flags &= ~TCP_ACK_PENDING;
 
-	profile_stop ( &tcp_tx_profiler );
+	/* Update statistics */
+	tcp->stats.out_segs++;
+	tcp->stats.out_octets += len;
+	tcp_rcv_zero_window ( tcp, ( tcp->rcv_win == 0 ) );
+
+	profile_stop ( &tcp_tx_profiler );
+	return 0;
+}
+
+/**
+ * Determine maximum length of data within a transmitted segment
+ *
+ * @v tcp		TCP connection
+ * @ret max_len		Maximum length of data payload
+ */
+static size_t tcp_xmit_max_len ( struct tcp_connection *tcp ) {
+	struct net_device *netdev;
+	unsigned int tso;
+
+	/* Use segmentation offload if the network device is capable */
+	tso = ( ( tcp->peer.st_family == AF_INET6 ) ?
+		NETDEV_TX_OFFLOAD_TSO6 : NETDEV_TX_OFFLOAD_TSO4 );
+	netdev = tcpip_netdev ( &tcp->peer );
+	if ( netdev && ( netdev->tx_offloads & tso ) )
+		return TCP_TSO_MAX_LEN;
+
+	return TCP_PATH_MTU;
+}
+
+/**
+ * Transmit any outstanding data (with selective acknowledgement)
+ *
+ * @v tcp		TCP connection
+ * @v sack_seq		SEQ for first selective acknowledgement (if any)
+ *
+ * Transmits any pending retransmission, followed by as much new data
+ * as the transmission window allows.  A pure ACK will be sent if an
+ * acknowledgement is pending and no other segment was transmitted.
+ */
+static void tcp_xmit_sack ( struct tcp_connection *tcp, uint32_t sack_seq ) {
+	unsigned int flags;
+	size_t max_len = 0;
+	size_t queued;
+	size_t pace;
+	size_t win;
+	size_t len;
+	uint32_t seq;
+
+	/* Determine flags to be sent */
+	flags = TCP_FLAGS_SENDING ( tcp->tcp_state );
+
+	/* Retransmit a lost segment, if applicable */
+	if ( tcp->flags & TCP_RTX_PENDING ) {
+		tcp->flags &= ~TCP_RTX_PENDING;
+		if ( flags & ( TCP_SYN | TCP_FIN ) ) {
+			/* Retransmit SYN or FIN, if already sent.  Any
+			 * data sent within a Fast Open SYN is omitted
+			 * from the retransmission (and will be sent
+			 * again once the SYN has been acknowledged),
+			 * as is the Fast Open option itself.
+			 */
+			if ( tcp->snd_sent ) {
+				tcp->flags &= ~TCP_FASTOPEN;
+				tcp_xmit_segment ( tcp, 0, 0, flags,
+						   sack_seq );
+			}
+		} else if ( ( len = tcp_rtx_next ( tcp, &seq ) ) != 0 ) {
+			/* Retransmit data segment */
+			DBGC ( tcp, "TCP %p retransmitting %08x..%08x\n",
+			       tcp, seq, ( seq + ( uint32_t ) len ) );
+			tcp->rtx_seq = ( seq + len );
+			tcp->rtx_time = currticks();
+			tcp_stats.out_rtx_segs++;
+			tcp->stats.out_rtx_segs++;
+			tcp_xmit_segment ( tcp, ( seq - tcp->snd_seq ), len,
+					   flags, sack_seq );
+		}
+	}
+
+	/* Transmit SYN or FIN, if not already sent.  A Fast Open SYN
+	 * may include data from the transmit queue.
+	 */
+	if ( ( flags & ( TCP_SYN | TCP_FIN ) ) && ( tcp->snd_sent == 0 ) ) {
+		len = 0;
+		if ( ( flags & TCP_SYN ) && ( tcp->flags & TCP_FASTOPEN ) &&
+		     tcp->fastopen_len ) {
+			len = tcp_tx_queued ( tcp );
+			if ( len > TCP_FASTOPEN_MAX_LEN )
+				len = TCP_FASTOPEN_MAX_LEN;
+			stop_timer ( &tcp->timer );
+		}
+		tcp->snd_sent = ( 1 + len );
+		tcp_xmit_segment ( tcp, 0, len, flags, sack_seq );
+	}
+
+	/* Transmit as much new data as the window allows.  Note that
+	 * we never have a SYN or FIN outstanding at the same time as
+	 * data (other than within a Fast Open SYN, which leaves no
+	 * transmission window), and so the unacknowledged sequence
+	 * count is equal to the length of data sent.
+	 */
+	win = tcp_xmit_win ( tcp );
+	queued = tcp_tx_queued ( tcp );
+	while ( ( tcp->snd_sent < win ) && ( tcp->snd_sent < queued ) ) {
+		if ( ! max_len )
+			max_len = tcp_xmit_max_len ( tcp );
+		len = ( queued - tcp->snd_sent );
+		if ( len > ( win - tcp->snd_sent ) )
+			len = ( win - tcp->snd_sent );
+		if ( len > max_len )
+			len = max_len;
+		pace = tcp_congestion_pace ( tcp );
+		if ( ( len > pace ) && ( pace >= TCP_PATH_MTU ) )
+			len = ( pace - ( pace % TCP_PATH_MTU ) );
+		if ( len > pace ) {
+			/* Try again once more credit is available */
+			process_add ( &tcp->process );
+			break;
+		}
+		tcp->pace_credit -= len;
+		tcp_rack_record ( tcp, ( tcp->snd_seq + tcp->snd_sent ) );
+		tcp->snd_sent += len;
+		if ( tcp_xmit_segment ( tcp, ( tcp->snd_sent - len ), len,
+					flags, sack_seq ) != 0 )
+			break;
+	}
+
+	/* Transmit pure ACK, if still required */
+	if ( tcp->flags & TCP_ACK_PENDING ) {
+		tcp_xmit_segment ( tcp, tcp->snd_sent, 0,
+				   ( flags & ~( TCP_SYN | TCP_FIN ) ),
+				   sack_seq );
+	}
 }
 
 /**
@@ -801,6 +1741,16 @@ static void tcp_expired ( struct retry_timer *timer, int over ) {
 		 ( tcp->tcp_state == TCP_CLOSE_WAIT ) ||
 		 ( tcp->tcp_state == TCP_CLOSING_OR_LAST_ACK ) );
 
+	/* If this was a RACK reordering timeout, then restart the
+	 * retransmission timer and perform RACK loss detection.
+	 */
+	if ( tcp->flags & TCP_RACK_TIMER ) {
+		tcp_start_timer ( tcp );
+		tcp_rack ( tcp );
+		tcp_xmit ( tcp );
+		return;
+	}
+
 	if ( over ) {
 		/* If we have finally timed out and given up,
 		 * terminate the connection
@@ -809,7 +1759,27 @@ static void tcp_expired ( struct retry_timer *timer, int over ) {
 		tcp_dump_state ( tcp );
 		tcp_close ( tcp, -ETIMEDOUT );
 	} else {
-		/* Otherwise, retransmit the packet */
+		/* Otherwise, enter loss recovery if we have
+		 * outstanding data.  As per RFC 2018, discard any
+		 * selective acknowledgement information since the
+		 * receiver may have reneged.
+		 */
+		if ( tcp->snd_sent &&
+		     ! ( TCP_FLAGS_SENDING ( tcp->tcp_state ) &
+			 ( TCP_SYN | TCP_FIN ) ) ) {
+			tcp_congestion_loss ( tcp, 1 );
+			memset ( tcp->snd_sack, 0, sizeof ( tcp->snd_sack ) );
+			tcp->recover = ( tcp->snd_seq + tcp->snd_sent );
+			tcp->rtx_seq = tcp->snd_seq;
+			tcp->dupacks = 0;
+			tcp->flags |= ( TCP_RECOVERY | TCP_RTO_RECOVERY );
+		}
+
+		/* Back off retransmission timeout */
+		tcp->backoff++;
+
+		/* Retransmit the packet */
+		tcp->flags |= TCP_RTX_PENDING;
 		tcp_xmit ( tcp );
 	}
 }
@@ -928,14 +1898,23 @@ static int tcp_xmit_reset ( struct tcp_connection *tcp,
  * Identify TCP connection by local port number
  *
  * @v local_port	Local port
+ * @v peer		Peer socket address, or NULL to match any peer
  * @ret tcp		TCP connection, or NULL
+ *
+ * Connections accepted from a listener all share the listening port,
+ * and so are further identified by the peer socket address.
  */
-static struct tcp_connection * tcp_demux ( unsigned int local_port ) {
+static struct tcp_connection * tcp_demux ( unsigned int local_port,
+					   struct sockaddr_tcpip *peer ) {
 	struct tcp_connection *tcp;
 
 	list_for_each_entry ( tcp, &tcp_conns, list ) {
-		if ( tcp->local_port == local_port )
-			return tcp;
+		if ( tcp->local_port != local_port )
+			continue;
+		if ( ( tcp->flags & TCP_PASSIVE ) && peer &&
+		     ( memcmp ( &tcp->peer, peer, sizeof ( tcp->peer ) ) != 0 ))
+			continue;
+		return tcp;
 	}
 	return NULL;
 }
@@ -993,12 +1972,17 @@ static int tcp_rx_opts ( struct tcp_connection *tcp,
 			min = sizeof ( *options->spopt );
 			break;
 		case TCP_OPTION_SACK:
-			/* Ignore received SACKs */
+			options->sackopt = data;
+			min = sizeof ( *options->sackopt );
 			break;
 		case TCP_OPTION_TS:
 			options->tsopt = data;
 			min = sizeof ( *options->tsopt );
 			break;
+		case TCP_OPTION_FASTOPEN:
+			options->foopt = data;
+			min = sizeof ( *options->foopt );
+			break;
 		default:
 			DBGC ( tcp, "TCP %p received unknown option %d\n",
 			       tcp, kind );
@@ -1064,6 +2048,105 @@ static void tcp_rx_seq ( struct tcp_connection *tcp, uint32_t seq_len ) {
 	tcp->flags |= TCP_ACK_PENDING;
 }
 
+/**
+ * Update round-trip time estimate
+ *
+ * @v tcp		TCP connection
+ * @v tsecr		Echoed timestamp value (in host-endian order)
+ *
+ * As a receiver, we can measure the round-trip time by comparing
+ * the timestamp echoed in each received data segment against the
+ * current time.
+ */
+static void tcp_rx_rtt ( struct tcp_connection *tcp, uint32_t tsecr ) {
+	uint32_t rtt;
+	long delta;
+
+	/* Calculate round-trip time, ignoring implausible samples */
+	rtt = ( currticks() - tsecr );
+	if ( ( tsecr == 0 ) || ( rtt > TCP_MSL ) )
+		return;
+
+	/* Update smoothed round-trip time and round-trip time
+	 * variation as per RFC 6298.
+	 */
+	if ( tcp->flags & TCP_RTT_VALID ) {
+		delta = ( rtt - ( tcp->srtt / 8 ) );
+		if ( delta < 0 )
+			delta = -delta;
+		tcp->rttvar += ( delta - ( tcp->rttvar / 4 ) );
+		tcp->srtt += ( rtt - ( tcp->srtt / 8 ) );
+	} else {
+		tcp->srtt = ( rtt * 8 );
+		tcp->rttvar = ( rtt * 2 );
+		tcp->flags |= TCP_RTT_VALID;
+	}
+
+	/* Timestamps are unambiguous, so any backoff may be cleared */
+	tcp->backoff = 0;
+
+	tcp_stats.rtt = ( tcp->srtt / 8 );
+	tcp_stats.rttvar = ( tcp->rttvar / 4 );
+	tcp_stats.rto = tcp_rto ( tcp );
+}
+
+/**
+ * Autotune receive window
+ *
+ * @v tcp		TCP connection
+ *
+ * Once per round-trip time, measure the amount of data delivered to
+ * the application.  If this is more than half of the current maximum
+ * window, then the sender is likely to be limited by our advertised
+ * window, and so we increase the maximum window to allow the sender
+ * to double its rate.
+ */
+static void tcp_rx_tune ( struct tcp_connection *tcp ) {
+	unsigned long elapsed;
+	uint32_t delivered;
+	size_t max_win;
+	size_t win;
+
+	/* Do nothing unless we have a round-trip time estimate */
+	if ( ! ( tcp->flags & TCP_RTT_VALID ) )
+		return;
+
+	/* Wait until at least one round-trip time has elapsed */
+	elapsed = ( currticks() - tcp->tune_start );
+	if ( elapsed <= ( tcp->srtt / 8 ) )
+		return;
+
+	/* Calculate required window */
+	delivered = ( tcp->rcv_ack - tcp->tune_seq );
+	win = ( 2 * ( ( size_t ) delivered ) );
+
+	/* Start new autotuning period */
+	tcp->tune_seq = tcp->rcv_ack;
+	tcp->tune_start = currticks();
+
+	/* Do nothing unless the window needs to grow */
+	if ( win <= tcp->rcv_win_max )
+		return;
+
+	/* Limit to configured maximum window size and to the amount
+	 * of memory available for holding out-of-order data.
+	 */
+	max_win = malloc_freemem();
+	if ( max_win > TCP_MAX_WINDOW_SIZE )
+		max_win = TCP_MAX_WINDOW_SIZE;
+	if ( win > max_win )
+		win = max_win;
+	if ( win <= tcp->rcv_win_max )
+		return;
+
+	/* Grow window */
+	DBGC ( tcp, "TCP %p RX window grown from %d to %zd bytes (RTT %ld "
+	       "ticks)\n", tcp, tcp->rcv_win_max, win, ( tcp->srtt / 8 ) );
+	tcp->rcv_win_max = win;
+	if ( tcp_stats.rcv_win_max < win )
+		tcp_stats.rcv_win_max = win;
+}
+
 /**
  * Handle TCP received SYN
  *
@@ -1078,6 +2161,8 @@ static int tcp_rx_syn ( struct tcp_connection *tcp, uint32_t seq,
 	/* Synchronise sequence numbers on first SYN */
 	if ( ! ( tcp->tcp_state & TCP_STATE_RCVD ( TCP_SYN ) ) ) {
 		tcp->rcv_ack = seq;
+		tcp->tune_seq = seq;
+		tcp->tune_start = currticks();
 		if ( options->tsopt )
 			tcp->flags |= TCP_TS_ENABLED;
 		if ( options->spopt )
@@ -1086,6 +2171,8 @@ static int tcp_rx_syn ( struct tcp_connection *tcp, uint32_t seq,
 			tcp->snd_win_scale = options->wsopt->scale;
 			tcp->rcv_win_scale = TCP_RX_WINDOW_SCALE;
 		}
+		if ( options->foopt && ! ( tcp->flags & TCP_PASSIVE ) )
+			tcp_fastopen_record ( tcp, options->foopt );
 		DBGC ( tcp, "TCP %p using %stimestamps, %sSACK, TX window "
 		       "x%d, RX window x%d\n", tcp,
 		       ( ( tcp->flags & TCP_TS_ENABLED ) ? "" : "no " ),
@@ -1119,8 +2206,10 @@ static int tcp_rx_syn ( struct tcp_connection *tcp, uint32_t seq,
 static int tcp_rx_ack ( struct tcp_connection *tcp, uint32_t ack,
 			uint32_t win ) {
 	uint32_t ack_len = ( ack - tcp->snd_seq );
+	struct tcp_sack_block *sack;
 	size_t len;
 	unsigned int acked_flags;
+	unsigned int i;
 
 	/* Check for out-of-range or old duplicate ACKs */
 	if ( ack_len > tcp->snd_sent ) {
@@ -1143,6 +2232,7 @@ static int tcp_rx_ack ( struct tcp_connection *tcp, uint32_t ack,
 
 	/* Update window size */
 	tcp->snd_win = win;
+	tcp_snd_zero_window ( tcp, ( win == 0 ) );
 
 	/* Hold off (or start) the keepalive timer, if applicable */
 	if ( ! ( tcp->tcp_state & TCP_STATE_SENT ( TCP_FIN ) ) )
@@ -1160,6 +2250,9 @@ static int tcp_rx_ack ( struct tcp_connection *tcp, uint32_t ack,
 	/* Stop the retransmission timer */
 	stop_timer ( &tcp->timer );
 
+	/* Reset duplicate ACK counter */
+	tcp->dupacks = 0;
+
 	/* Determine acknowledged flags and data length */
 	len = ack_len;
 	acked_flags = ( TCP_FLAGS_SENDING ( tcp->tcp_state ) &
@@ -1171,10 +2264,51 @@ static int tcp_rx_ack ( struct tcp_connection *tcp, uint32_t ack,
 
 	/* Update SEQ and sent counters */
 	tcp->snd_seq = ack;
-	tcp->snd_sent = 0;
+	tcp->snd_sent -= ack_len;
+
+	/* Discard any selective acknowledgements that are now covered
+	 * by the cumulative acknowledgement.
+	 */
+	for ( i = 0 ; i < TCP_SACK_SCOREBOARD ; i++ ) {
+		sack = &tcp->snd_sack[i];
+		if ( tcp_cmp ( sack->right, ack ) <= 0 ) {
+			sack->left = sack->right = ack;
+		} else if ( tcp_cmp ( sack->left, ack ) < 0 ) {
+			sack->left = ack;
+		}
+	}
 
 	/* Remove any acknowledged data from transmit queue */
-	tcp_process_tx_queue ( tcp, len, NULL, 1 );
+	tcp_process_tx_queue ( tcp, 0, len, NULL, 1 );
+
+	/* If the peer did not accept all data sent within a Fast
+	 * Open SYN, then send the remaining data again immediately.
+	 */
+	if ( ( acked_flags & TCP_SYN ) && tcp->snd_sent ) {
+		DBGC ( tcp, "TCP %p Fast Open data not accepted\n", tcp );
+		tcp->snd_sent = 0;
+	}
+
+	/* Grow congestion window, unless in fast recovery */
+	if ( len && ( ( ! ( tcp->flags & TCP_RECOVERY ) ) ||
+		      ( tcp->flags & TCP_RTO_RECOVERY ) ) )
+		tcp_congestion_ack ( tcp, len );
+
+	/* Restart the retransmission timer if data remains outstanding */
+	if ( tcp->snd_sent )
+		tcp_start_timer ( tcp );
+
+	/* Exit loss recovery once the recovery point has been
+	 * acknowledged, otherwise retransmit the next lost segment.
+	 */
+	if ( tcp->flags & TCP_RECOVERY ) {
+		if ( tcp_cmp ( ack, tcp->recover ) >= 0 ) {
+			DBGC ( tcp, "TCP %p recovered at %08x\n", tcp, ack );
+			tcp->flags &= ~( TCP_RECOVERY | TCP_RTO_RECOVERY );
+		} else {
+			tcp->flags |= TCP_RTX_PENDING;
+		}
+	}
 		
 	/* Mark SYN/FIN as acknowledged if applicable. */
 	if ( acked_flags )
@@ -1191,6 +2325,234 @@ static int tcp_rx_ack ( struct tcp_connection *tcp, uint32_t ack,
 	return 0;
 }
 
+/**
+ * Record selectively acknowledged range
+ *
+ * @v tcp		TCP connection
+ * @v left		Left edge (in host-endian order)
+ * @v right		Right edge (in host-endian order)
+ */
+static void tcp_sack_add ( struct tcp_connection *tcp, uint32_t left,
+			   uint32_t right ) {
+	struct tcp_sack_block *sack;
+	struct tcp_sack_block *lowest = NULL;
+	unsigned int i;
+	int merged;
+
+	/* Merge with any overlapping or adjacent ranges */
+	do {
+		merged = 0;
+		for ( i = 0 ; i < TCP_SACK_SCOREBOARD ; i++ ) {
+			sack = &tcp->snd_sack[i];
+			if ( sack->left == sack->right )
+				continue;
+			if ( ( tcp_cmp ( sack->left, right ) > 0 ) ||
+			     ( tcp_cmp ( sack->right, left ) < 0 ) )
+				continue;
+			if ( tcp_cmp ( sack->left, left ) < 0 )
+				left = sack->left;
+			if ( tcp_cmp ( sack->right, right ) > 0 )
+				right = sack->right;
+			sack->left = sack->right;
+			merged = 1;
+		}
+	} while ( merged );
+
+	/* Find an empty block, or the lowest block if none are empty */
+	for ( i = 0 ; i < TCP_SACK_SCOREBOARD ; i++ ) {
+		sack = &tcp->snd_sack[i];
+		if ( sack->left == sack->right ) {
+			lowest = sack;
+			break;
+		}
+		if ( ( ! lowest ) ||
+		     ( tcp_cmp ( sack->right, lowest->right ) < 0 ) )
+			lowest = sack;
+	}
+
+	/* Record range, discarding the lowest range if necessary */
+	if ( ( lowest->left != lowest->right ) &&
+	     ( tcp_cmp ( right, lowest->right ) < 0 ) )
+		return;
+	lowest->left = left;
+	lowest->right = right;
+}
+
+/**
+ * Handle TCP received selective acknowledgements
+ *
+ * @v tcp		TCP connection
+ * @v sackopt		Selective acknowledgement option
+ */
+static void tcp_rx_sack ( struct tcp_connection *tcp,
+			  const struct tcp_sack_option *sackopt ) {
+	const struct tcp_sack_block *sack =
+		( ( ( const void * ) sackopt ) + sizeof ( *sackopt ) );
+	unsigned int count;
+	uint32_t limit;
+	uint32_t left;
+	uint32_t right;
+
+	/* Record each block, ignoring any portions that lie outside
+	 * the unacknowledged sequence space.
+	 */
+	count = ( ( sackopt->length - sizeof ( *sackopt ) ) /
+		  sizeof ( *sack ) );
+	limit = ( tcp->snd_seq + tcp->snd_sent );
+	for ( ; count-- ; sack++ ) {
+		left = ntohl ( sack->left );
+		right = ntohl ( sack->right );
+		if ( tcp_cmp ( left, tcp->snd_seq ) < 0 )
+			left = tcp->snd_seq;
+		if ( tcp_cmp ( right, limit ) > 0 )
+			right = limit;
+		if ( tcp_cmp ( left, right ) >= 0 )
+			continue;
+		DBGC2 ( tcp, "TCP %p SACKed %08x..%08x\n", tcp, left, right );
+		tcp_sack_add ( tcp, left, right );
+	}
+}
+
+/**
+ * Enter fast retransmission and recovery
+ *
+ * @v tcp		TCP connection
+ */
+static void tcp_rx_loss ( struct tcp_connection *tcp ) {
+
+	DBGC ( tcp, "TCP %p fast retransmitting %08x..%08x\n",
+	       tcp, tcp->snd_seq, ( tcp->snd_seq + tcp->snd_sent ) );
+	tcp->recover = ( tcp->snd_seq + tcp->snd_sent );
+	tcp->rtx_seq = tcp->snd_seq;
+	tcp->flags |= ( TCP_RECOVERY | TCP_RTX_PENDING );
+	tcp_congestion_loss ( tcp, 0 );
+	tcp_stats.fast_rtx++;
+}
+
+/**
+ * Handle TCP received duplicate ACK
+ *
+ * @v tcp		TCP connection
+ */
+static void tcp_rx_dupack ( struct tcp_connection *tcp ) {
+
+	/* Increment duplicate ACK counter */
+	tcp->dupacks++;
+	tcp->stats.dupacks++;
+	tcp_stats.dupacks++;
+
+	/* During loss recovery, each duplicate ACK indicates that a
+	 * segment has left the network, and so allows us to
+	 * retransmit the next lost segment.
+	 */
+	if ( tcp->flags & TCP_RECOVERY ) {
+		tcp->flags |= TCP_RTX_PENDING;
+		return;
+	}
+
+	/* Enter fast retransmission and recovery if applicable */
+	if ( tcp->dupacks < TCP_DUPACK_THRESHOLD )
+		return;
+	tcp_rx_loss ( tcp );
+}
+
+/**
+ * Perform RACK loss detection
+ *
+ * @v tcp		TCP connection
+ *
+ * Detect lost segments using the transmission time of the most
+ * recently delivered (i.e. selectively acknowledged) segment, as per
+ * RFC 8985.  A segment is deemed lost if a segment transmitted after
+ * it has been delivered, and if more than a reordering window's
+ * worth of time beyond the round-trip time has elapsed since it was
+ * transmitted.  If the reordering window has not yet elapsed, the
+ * retransmission timer is used as the reordering timer.
+ *
+ * This allows us to enter recovery without waiting for three
+ * duplicate ACKs, and to detect the loss of a retransmitted segment
+ * without waiting for a retransmission timeout.
+ */
+static void tcp_rack ( struct tcp_connection *tcp ) {
+	struct tcp_sack_block *sack;
+	unsigned long now = currticks();
+	unsigned long threshold;
+	unsigned long elapsed;
+	unsigned long time;
+	uint32_t highest;
+	unsigned int i;
+
+	/* Do nothing unless we have a round-trip time estimate */
+	if ( ! ( tcp->flags & TCP_RTT_VALID ) )
+		return;
+
+	/* Find highest selectively acknowledged data */
+	highest = tcp->snd_seq;
+	for ( i = 0 ; i < TCP_SACK_SCOREBOARD ; i++ ) {
+		sack = &tcp->snd_sack[i];
+		if ( ( sack->left != sack->right ) &&
+		     ( tcp_cmp ( sack->right, highest ) > 0 ) )
+			highest = sack->right;
+	}
+	if ( highest == tcp->snd_seq )
+		return;
+
+	/* Update transmission time of most recently delivered segment */
+	time = tcp_rack_time ( tcp, ( highest - 1 ) );
+	if ( ( ! ( tcp->flags & TCP_RACK_VALID ) ) ||
+	     ( ( long ) ( time - tcp->rack_time ) > 0 ) ) {
+		tcp->rack_time = time;
+		tcp->flags |= TCP_RACK_VALID;
+	}
+
+	/* Identify the transmission time of the oldest segment that
+	 * may be lost.  Outside of recovery, this is the first
+	 * unacknowledged segment.  During recovery, this is the most
+	 * recent retransmission.  (Segments are always retransmitted
+	 * before new data, so any data transmitted in the same tick
+	 * as the retransmission was transmitted after it.)
+	 */
+	if ( ! ( tcp->flags & TCP_RECOVERY ) ) {
+		time = tcp_rack_time ( tcp, tcp->snd_seq );
+	} else if ( ( ! ( tcp->flags & TCP_RTO_RECOVERY ) ) &&
+		    ( tcp_cmp ( tcp->rtx_seq, tcp->snd_seq ) > 0 ) ) {
+		time = tcp->rtx_time;
+	} else {
+		return;
+	}
+	if ( ( long ) ( tcp->rack_time - time ) < 0 )
+		return;
+
+	/* Calculate loss threshold, using a reordering window of a
+	 * quarter of the round-trip time (and at least one tick).
+	 */
+	threshold = ( ( tcp->srtt / 8 ) + ( tcp->srtt / 32 ) + 1 );
+
+	/* Wait until reordering window has elapsed, if applicable */
+	elapsed = ( now - time );
+	if ( elapsed <= threshold ) {
+		start_timer_fixed ( &tcp->timer, ( threshold - elapsed + 1 ) );
+		tcp->flags |= TCP_RACK_TIMER;
+		return;
+	}
+
+	/* Enter recovery, or restart retransmissions if a
+	 * retransmission has been lost.
+	 */
+	tcp_stats.rack_loss++;
+	if ( ! ( tcp->flags & TCP_RECOVERY ) ) {
+		DBGC ( tcp, "TCP %p RACK detected loss at %08x\n",
+		       tcp, tcp->snd_seq );
+		tcp_rx_loss ( tcp );
+	} else {
+		DBGC ( tcp, "TCP %p RACK detected lost retransmission at "
+		       "%08x\n", tcp, tcp->snd_seq );
+		tcp->rtx_seq = tcp->snd_seq;
+		tcp->rtx_time = now;
+		tcp->flags |= TCP_RTX_PENDING;
+	}
+}
+
 /**
  * Handle TCP received data
  *
@@ -1220,6 +2582,9 @@ static int tcp_rx_data ( struct tcp_connection *tcp, uint32_t seq,
 	/* Acknowledge new data */
 	tcp_rx_seq ( tcp, len );
 
+	/* Autotune receive window */
+	tcp_rx_tune ( tcp );
+
 	/* Update statistics */
 	tcp_stats.in_octets_good += len;
 
@@ -1301,12 +2666,9 @@ static int tcp_rx_rst ( struct tcp_connection *tcp, uint32_t seq ) {
  */
 static void tcp_rx_enqueue ( struct tcp_connection *tcp, uint32_t seq,
 			     uint8_t flags, struct io_buffer *iobuf ) {
-	struct tcp_rx_queued_header *tcpqhdr;
-	struct io_buffer *queued;
 	size_t len;
 	uint32_t seq_len;
 	uint32_t nxt;
-	uint32_t gap;
 
 	/* Calculate remaining flags and sequence length.  Note that
 	 * SYN, if present, has already been processed by this point.
@@ -1331,25 +2693,12 @@ static void tcp_rx_enqueue ( struct tcp_connection *tcp, uint32_t seq,
 		return;
 	}
 
-	/* Add internal header */
-	tcpqhdr = iob_push ( iobuf, sizeof ( *tcpqhdr ) );
-	tcpqhdr->seq = seq;
-	tcpqhdr->nxt = nxt;
-	tcpqhdr->flags = flags;
-
-	/* Add to RX queue */
-	gap = tcp->rcv_ack;
-	list_for_each_entry ( queued, &tcp->rx_queue, list ) {
-		tcpqhdr = queued->data;
-		if ( tcp_cmp ( seq, tcpqhdr->seq ) < 0 )
-			break;
-		gap = tcpqhdr->nxt;
-	}
-	list_add_tail ( &iobuf->list, &queued->list );
-
 	/* Update statistics */
-	if ( seq != gap )
+	if ( tcp_cmp ( seq, tcp->rcv_ack ) > 0 )
 		tcp_stats.in_out_of_order++;
+
+	/* Add to RX queue */
+	tcp_reasm_add ( &tcp->rx_queue, tcp->rcv_ack, seq, flags, iobuf );
 }
 
 /**
@@ -1364,21 +2713,16 @@ static void tcp_process_rx_queue ( struct tcp_connection *tcp ) {
 	unsigned int flags;
 	size_t len;
 
-	/* Process all applicable received buffers.  Note that we
-	 * cannot use list_for_each_entry() to iterate over the RX
+	/* Process all applicable received buffers, stopping when we
+	 * hit the first gap.  Note that we cannot iterate over the RX
 	 * queue, since tcp_discard() may remove packets from the RX
 	 * queue while we are processing.
 	 */
-	while ( ( iobuf = list_first_entry ( &tcp->rx_queue, struct io_buffer,
-					     list ) ) ) {
+	while ( ( iobuf = tcp_reasm_dequeue ( &tcp->rx_queue,
+					      tcp->rcv_ack ) ) ) {
 
-		/* Stop processing when we hit the first gap */
+		/* Strip internal header */
 		tcpqhdr = iobuf->data;
-		if ( tcp_cmp ( tcpqhdr->seq, tcp->rcv_ack ) > 0 )
-			break;
-
-		/* Strip internal header and remove from RX queue */
-		list_del ( &iobuf->list );
 		seq = tcpqhdr->seq;
 		flags = tcpqhdr->flags;
 		iob_pull ( iobuf, sizeof ( *tcpqhdr ) );
@@ -1413,6 +2757,8 @@ static int tcp_rx ( struct io_buffer *iobuf,
 		    uint16_t pshdr_csum ) {
 	struct tcp_header *tcphdr = iobuf->data;
 	struct tcp_connection *tcp;
+	struct tcp_listener *listener;
+	struct sockaddr_tcpip peer;
 	struct tcp_options options;
 	size_t hlen;
 	uint16_t csum;
@@ -1424,6 +2770,8 @@ static int tcp_rx ( struct io_buffer *iobuf,
 	size_t len;
 	uint32_t seq_len;
 	size_t old_xfer_window;
+	int dupack;
+	int advance = 0;
 	int rc;
 
 	/* Start profiling */
@@ -1449,17 +2797,30 @@ static int tcp_rx ( struct io_buffer *iobuf,
 		rc = -EINVAL;
 		goto discard;
 	}
-	csum = tcpip_continue_chksum ( pshdr_csum, iobuf->data,
-				       iob_len ( iobuf ) );
-	if ( csum != 0 ) {
-		DBG ( "TCP checksum incorrect (is %04x including checksum "
-		      "field, should be 0000)\n", csum );
-		rc = -EINVAL;
-		goto discard;
+	if ( ! ( iobuf->flags & IOB_CSUM_VALID ) ) {
+		csum = tcpip_continue_chksum ( pshdr_csum, iobuf->data,
+					       iob_len ( iobuf ) );
+		if ( csum != 0 ) {
+			DBG ( "TCP checksum incorrect (is %04x including "
+			      "checksum field, should be 0000)\n", csum );
+			rc = -EINVAL;
+			goto discard;
+		}
 	}
 	
+	/* Identify connection, accepting a new connection if this is
+	 * an initial SYN for a listening port.
+	 */
+	memcpy ( &peer, st_src, sizeof ( peer ) );
+	peer.st_port = tcphdr->src;
+	tcp = tcp_demux ( ntohs ( tcphdr->dest ), &peer );
+	if ( ( ! tcp ) &&
+	     ( ( tcphdr->flags & ( TCP_SYN | TCP_ACK | TCP_RST ) ) == TCP_SYN )
+	     && ( listener = tcp_listener ( ntohs ( tcphdr->dest ) ) ) ) {
+		tcp = tcp_accept ( listener, &peer );
+	}
+
 	/* Parse parameters from header and strip header */
-	tcp = tcp_demux ( ntohs ( tcphdr->dest ) );
 	seq = ntohl ( tcphdr->seq );
 	ack = ntohl ( tcphdr->ack );
 	raw_win = ntohs ( tcphdr->win );
@@ -1490,6 +2851,8 @@ static int tcp_rx ( struct io_buffer *iobuf,
 		rc = -ENOTCONN;
 		goto discard;
 	}
+	tcp->stats.in_segs++;
+	tcp->stats.in_octets += len;
 
 	/* Record old data-transfer window */
 	old_xfer_window = tcp_xfer_window ( tcp );
@@ -1497,10 +2860,20 @@ static int tcp_rx ( struct io_buffer *iobuf,
 	/* Handle ACK, if present */
 	if ( flags & TCP_ACK ) {
 		win = ( raw_win << tcp->snd_win_scale );
+		dupack = ( ( ack == tcp->snd_seq ) && tcp->snd_sent &&
+			   ( len == 0 ) && ( win == tcp->snd_win ) &&
+			   ( ! ( flags & ( TCP_SYN | TCP_FIN ) ) ) );
+		advance = ( ( int32_t ) ( ack - tcp->snd_seq ) > 0 );
 		if ( ( rc = tcp_rx_ack ( tcp, ack, win ) ) != 0 ) {
 			tcp_xmit_reset ( tcp, st_src, tcphdr );
 			goto discard;
 		}
+		if ( options.sackopt && ( tcp->flags & TCP_SACK_ENABLED ) )
+			tcp_rx_sack ( tcp, options.sackopt );
+		if ( dupack )
+			tcp_rx_dupack ( tcp );
+		if ( options.sackopt && ( tcp->flags & TCP_SACK_ENABLED ) )
+			tcp_rack ( tcp );
 	}
 
 	/* Force an ACK if this packet is out of order */
@@ -1515,6 +2888,12 @@ static int tcp_rx ( struct io_buffer *iobuf,
 		seq++;
 	}
 
+	/* Update round-trip time estimate, if applicable */
+	if ( ( tcp->flags & TCP_TS_ENABLED ) && options.tsopt &&
+	     ( ( len && ( seq == tcp->rcv_ack ) ) || advance ) ) {
+		tcp_rx_rtt ( tcp, ntohl ( options.tsopt->tsecr ) );
+	}
+
 	/* Handle RST, if present */
 	if ( flags & TCP_RST ) {
 		if ( ( rc = tcp_rx_rst ( tcp, seq ) ) != 0 )
@@ -1535,7 +2914,7 @@ static int tcp_rx ( struct io_buffer *iobuf,
 	 * queue remains non-empty after processing) then send the ACK
 	 * immediately in order to trigger Fast Retransmission.
 	 */
-	if ( list_empty ( &tcp->rx_queue ) ) {
+	if ( tcp_reasm_empty ( &tcp->rx_queue ) ) {
 		process_add ( &tcp->process );
 	} else {
 		tcp_xmit_sack ( tcp, seq );
@@ -1562,10 +2941,71 @@ static int tcp_rx ( struct io_buffer *iobuf,
 	return rc;
 }
 
+/**
+ * Merge received TCP segment
+ *
+ * @v iobuf		I/O buffer
+ * @v next		Subsequent I/O buffer
+ * @ret rc		Return status code, or required tailroom
+ *
+ * Only consecutive in-order data segments within the same connection
+ * (with identical acknowledgement numbers and TCP options) may be
+ * merged.  The subsequent segment may carry the PSH flag, which will
+ * prevent any further segments from being merged.
+ */
+static int tcp_merge ( struct io_buffer *iobuf, struct io_buffer *next ) {
+	struct tcp_header *tcphdr = iobuf->data;
+	struct tcp_header *nexthdr = next->data;
+	size_t hlen;
+	size_t len;
+	size_t next_len;
+
+	/* Sanity check headers */
+	if ( ( iob_len ( iobuf ) < sizeof ( *tcphdr ) ) ||
+	     ( iob_len ( next ) < sizeof ( *nexthdr ) ) )
+		return -EINVAL;
+	hlen = ( ( tcphdr->hlen & TCP_MASK_HLEN ) / 16 ) * 4;
+	if ( ( hlen < sizeof ( *tcphdr ) ) || ( nexthdr->hlen != tcphdr->hlen ) )
+		return -ENOTSUP;
+	if ( ( hlen >= iob_len ( iobuf ) ) || ( hlen >= iob_len ( next ) ) )
+		return -ENOTSUP;
+	len = ( iob_len ( iobuf ) - hlen );
+	next_len = ( iob_len ( next ) - hlen );
+
+	/* Check that segments belong to the same connection */
+	if ( ( nexthdr->src != tcphdr->src ) ||
+	     ( nexthdr->dest != tcphdr->dest ) )
+		return -ENOTSUP;
+
+	/* Check that segments are plain consecutive data segments */
+	if ( ( tcphdr->flags != TCP_ACK ) ||
+	     ( ( nexthdr->flags & ~TCP_PSH ) != TCP_ACK ) )
+		return -ENOTSUP;
+	if ( ( nexthdr->ack != tcphdr->ack ) ||
+	     ( ( uint32_t ) ( ntohl ( nexthdr->seq ) -
+			      ntohl ( tcphdr->seq ) ) != len ) )
+		return -ENOTSUP;
+	if ( memcmp ( ( tcphdr + 1 ), ( nexthdr + 1 ),
+		      ( hlen - sizeof ( *tcphdr ) ) ) != 0 )
+		return -ENOTSUP;
+
+	/* Check for sufficient space */
+	if ( iob_tailroom ( iobuf ) < next_len )
+		return next_len;
+
+	/* Append payload and update header */
+	memcpy ( iob_put ( iobuf, next_len ), ( next->data + hlen ), next_len );
+	tcphdr->flags |= nexthdr->flags;
+	tcphdr->win = nexthdr->win;
+
+	return 0;
+}
+
 /** TCP protocol */
 struct tcpip_protocol tcp_protocol __tcpip_protocol = {
 	.name = "TCP",
 	.rx = tcp_rx,
+	.merge = tcp_merge,
 	.tcpip_proto = IP_TCP,
 };
 
@@ -1576,23 +3016,17 @@ struct tcpip_protocol tcp_protocol __tcpip_protocol = {
  */
 static unsigned int tcp_discard ( void ) {
 	struct tcp_connection *tcp;
-	struct io_buffer *iobuf;
 	unsigned int discarded = 0;
 
 	/* Try to drop one queued RX packet from each connection */
 	list_for_each_entry ( tcp, &tcp_conns, list ) {
-		list_for_each_entry_reverse ( iobuf, &tcp->rx_queue, list ) {
-
-			/* Remove packet from queue */
-			list_del ( &iobuf->list );
-			free_iob ( iobuf );
+		if ( tcp_reasm_discard ( &tcp->rx_queue ) ) {
 
 			/* Update statistics */
 			tcp_stats.in_discards++;
 
 			/* Report discard */
 			discarded++;
-			break;
 		}
 	}
 
@@ -1757,6 +3191,196 @@ static struct interface_operation tcp_xfer_operations[] = {
 static struct interface_descriptor tcp_xfer_desc =
 	INTF_DESC ( struct tcp_connection, xfer, tcp_xfer_operations );
 
+/***************************************************************************
+ *
+ * Statistics
+ *
+ ***************************************************************************
+ */
+
+/**
+ * Get TCP connection information
+ *
+ * @v index		Connection index
+ * @v info		Connection information to fill in
+ * @ret rc		Return status code
+ */
+int tcp_info ( unsigned int index, struct tcp_info *info ) {
+	struct tcp_connection *tcp;
+	struct tcp_reasm_range *range;
+	unsigned long now = currticks();
+	unsigned int i;
+
+	/* Find connection */
+	list_for_each_entry ( tcp, &tcp_conns, list ) {
+		if ( index-- == 0 )
+			break;
+	}
+	if ( &tcp->list == &tcp_conns )
+		return -ENOENT;
+
+	/* Fill in connection information */
+	memset ( info, 0, sizeof ( *info ) );
+	memcpy ( &info->peer, &tcp->peer, sizeof ( info->peer ) );
+	info->local_port = tcp->local_port;
+	info->state = tcp_state ( tcp->tcp_state );
+	memcpy ( &info->stats, &tcp->stats, sizeof ( info->stats ) );
+	if ( tcp->flags & TCP_RCV_ZERO_WIN )
+		info->stats.rcv_zero_win += ( now - tcp->rcv_zero_start );
+	if ( tcp->flags & TCP_SND_ZERO_WIN )
+		info->stats.snd_zero_win += ( now - tcp->snd_zero_start );
+	if ( tcp->flags & TCP_RTT_VALID )
+		info->srtt = ( tcp->srtt / 8 );
+	info->rcv_win = tcp->rcv_win;
+	info->snd_win = tcp->snd_win;
+	info->cwnd = tcp->cc.cwnd;
+	for ( i = 0 ; i < tcp->rx_queue.count ; i++ ) {
+		range = &tcp->rx_queue.range[i];
+		info->ooo_len += ( range->end - range->start );
+	}
+	info->ooo_ranges = tcp->rx_queue.count;
+
+	return 0;
+}
+
+/**
+ * Fetch TCP statistics setting
+ *
+ * @v data		Buffer to fill with setting data
+ * @v len		Length of buffer
+ * @v value		Statistic value
+ * @ret len		Length of setting data, or negative error
+ */
+static int tcp_stat_fetch ( void *data, size_t len, unsigned long value ) {
+	uint32_t content;
+
+	/* Return statistic value */
+	content = htonl ( value );
+	if ( len > sizeof ( content ) )
+		len = sizeof ( content );
+	memcpy ( data, &content, len );
+	return sizeof ( content );
+}
+
+/**
+ * Fetch TCP retransmitted segment count setting
+ *
+ * @v data		Buffer to fill with setting data
+ * @v len		Length of buffer
+ * @ret len		Length of setting data, or negative error
+ */
+static int tcp_rtx_fetch ( void *data, size_t len ) {
+
+	return tcp_stat_fetch ( data, len, tcp_stats.out_rtx_segs );
+}
+
+/**
+ * Fetch TCP duplicate ACK count setting
+ *
+ * @v data		Buffer to fill with setting data
+ * @v len		Length of buffer
+ * @ret len		Length of setting data, or negative error
+ */
+static int tcp_dupacks_fetch ( void *data, size_t len ) {
+
+	return tcp_stat_fetch ( data, len, tcp_stats.dupacks );
+}
+
+/**
+ * Fetch TCP round-trip time setting
+ *
+ * @v data		Buffer to fill with setting data
+ * @v len		Length of buffer
+ * @ret len		Length of setting data, or negative error
+ */
+static int tcp_rtt_fetch ( void *data, size_t len ) {
+
+	return tcp_stat_fetch ( data, len,
+				( ( tcp_stats.rtt * 1000 ) / TICKS_PER_SEC ) );
+}
+
+/**
+ * Fetch TCP zero window time setting
+ *
+ * @v data		Buffer to fill with setting data
+ * @v len		Length of buffer
+ * @ret len		Length of setting data, or negative error
+ */
+static int tcp_zero_win_fetch ( void *data, size_t len ) {
+	struct tcp_connection *tcp;
+	unsigned long now = currticks();
+	unsigned long zero_win = tcp_stats.zero_win;
+
+	/* Include currently open intervals */
+	list_for_each_entry ( tcp, &tcp_conns, list ) {
+		if ( tcp->flags & TCP_RCV_ZERO_WIN )
+			zero_win += ( now - tcp->rcv_zero_start );
+		if ( tcp->flags & TCP_SND_ZERO_WIN )
+			zero_win += ( now - tcp->snd_zero_start );
+	}
+
+	return tcp_stat_fetch ( data, len,
+				( ( zero_win * 1000 ) / TICKS_PER_SEC ) );
+}
+
+/** TCP retransmitted segment count setting */
+const struct setting tcp_rtx_setting __setting ( SETTING_MISC, tcp-rtx ) = {
+	.name = "tcp-rtx",
+	.description = "TCP retransmitted segments",
+	.type = &setting_type_uint32,
+	.scope = &builtin_scope,
+};
+
+/** TCP retransmitted segment count built-in setting */
+struct builtin_setting tcp_rtx_builtin_setting __builtin_setting = {
+	.setting = &tcp_rtx_setting,
+	.fetch = tcp_rtx_fetch,
+};
+
+/** TCP duplicate ACK count setting */
+const struct setting tcp_dupacks_setting __setting ( SETTING_MISC,
+						     tcp-dupacks ) = {
+	.name = "tcp-dupacks",
+	.description = "TCP duplicate ACKs received",
+	.type = &setting_type_uint32,
+	.scope = &builtin_scope,
+};
+
+/** TCP duplicate ACK count built-in setting */
+struct builtin_setting tcp_dupacks_builtin_setting __builtin_setting = {
+	.setting = &tcp_dupacks_setting,
+	.fetch = tcp_dupacks_fetch,
+};
+
+/** TCP round-trip time setting */
+const struct setting tcp_rtt_setting __setting ( SETTING_MISC, tcp-rtt ) = {
+	.name = "tcp-rtt",
+	.description = "TCP smoothed round-trip time (ms)",
+	.type = &setting_type_uint32,
+	.scope = &builtin_scope,
+};
+
+/** TCP round-trip time built-in setting */
+struct builtin_setting tcp_rtt_builtin_setting __builtin_setting = {
+	.setting = &tcp_rtt_setting,
+	.fetch = tcp_rtt_fetch,
+};
+
+/** TCP zero window time setting */
+const struct setting tcp_zero_win_setting __setting ( SETTING_MISC,
+						      tcp-zero-win ) = {
+	.name = "tcp-zero-win",
+	.description = "TCP time spent with a zero window (ms)",
+	.type = &setting_type_uint32,
+	.scope = &builtin_scope,
+};
+
+/** TCP zero window time built-in setting */
+struct builtin_setting tcp_zero_win_builtin_setting __builtin_setting = {
+	.setting = &tcp_zero_win_setting,
+	.fetch = tcp_zero_win_fetch,
+};
+
 /***************************************************************************
  *
  * Openers
@@ -33,21 +33,37 @@
 #include <ipxe/open.h>
 #include <ipxe/uri.h>
 #include <ipxe/features.h>
+#include <ipxe/settings.h>
 #include <ipxe/ftp.h>
 
 /** @file
  *
  * File transfer protocol
  *
+ * A file may be retrieved using several parallel sessions, each
+ * with its own control and data connections, with each session
+ * using REST to start at a different offset within the file and ABOR
+ * to stop at the end of its segment.  A failed session may likewise
+ * be resumed from the point of failure using REST.
  */
 
 FEATURE ( FEATURE_PROTOCOL, "FTP", DHCP_EB_FEATURE_FTP, 1 );
 
+/** Maximum number of parallel FTP sessions */
+#define FTP_MAX_SESSIONS 8
+
+/** Minimum segment length for parallel FTP sessions */
+#define FTP_MIN_SEGMENT_LEN ( 1024 * 1024 )
+
+/** Default maximum number of FTP resumption attempts */
+#define FTP_RESUME_MAX 3
+
 /**
  * FTP states
  *
  * These @b must be sequential, i.e. a successful FTP session must
- * pass through each of these states in order.
+ * pass through each of these states in order (though some states may
+ * be skipped).
  */
 enum ftp_state {
 	FTP_CONNECT = 0,
@@ -56,28 +72,35 @@ enum ftp_state {
 	FTP_TYPE,
 	FTP_SIZE,
 	FTP_PASV,
+	FTP_REST,
 	FTP_RETR,
 	FTP_WAIT,
 	FTP_QUIT,
 	FTP_DONE,
 };
 
+struct ftp_request;
+
 /**
- * An FTP request
+ * An FTP session
  *
+ * Each session retrieves a single segment of the file via its own
+ * control and data connections.
  */
-struct ftp_request {
-	/** Reference counter */
-	struct refcnt refcnt;
-	/** Data transfer interface */
-	struct interface xfer;
-
-	/** URI being fetched */
-	struct uri *uri;
+struct ftp_session {
+	/** Containing FTP request */
+	struct ftp_request *ftp;
 	/** FTP control channel interface */
 	struct interface control;
 	/** FTP data channel interface */
 	struct interface data;
+	/** Session is active */
+	int active;
+
+	/** Current offset within file */
+	size_t offset;
+	/** End of segment within file, or zero for end of file */
+	size_t end;
 
 	/** Current state */
 	enum ftp_state state;
@@ -91,8 +114,52 @@ struct ftp_request {
 	char passive_text[24]; /* "aaa,bbb,ccc,ddd,eee,fff" */
 	/** File size, as text */
 	char filesize[20];
+	/** Restart offset, as text */
+	char rest_text[24];
 };
 
+/**
+ * An FTP request
+ *
+ */
+struct ftp_request {
+	/** Reference counter */
+	struct refcnt refcnt;
+	/** Data transfer interface */
+	struct interface xfer;
+
+	/** URI being fetched */
+	struct uri *uri;
+	/** File size request has been answered */
+	int sized;
+	/** File size (or zero if unknown) */
+	size_t size;
+	/** Number of resumption attempts made */
+	unsigned int resumed;
+
+	/** Sessions */
+	struct ftp_session session[FTP_MAX_SESSIONS];
+};
+
+/** FTP parallel retrieval setting */
+const struct setting ftp_parallel_setting __setting ( SETTING_MISC,
+						      ftp-parallel ) = {
+	.name = "ftp-parallel",
+	.description = "FTP parallel connections",
+	.type = &setting_type_uint8,
+};
+
+/** FTP resumption setting */
+const struct setting ftp_resume_setting __setting ( SETTING_MISC,
+						    ftp-resume ) = {
+	.name = "ftp-resume",
+	.description = "FTP interrupted transfer resumption attempts",
+	.type = &setting_type_uint8,
+};
+
+static int ftp_session_open ( struct ftp_session *session, size_t offset,
+			      size_t end );
+
 /**
  * Free FTP request
  *
@@ -115,15 +182,82 @@ static void ftp_free ( struct refcnt *refcnt ) {
  * @v rc		Return status code
  */
 static void ftp_done ( struct ftp_request *ftp, int rc ) {
+	struct ftp_session *session;
+	unsigned int i;
 
 	DBGC ( ftp, "FTP %p completed (%s)\n", ftp, strerror ( rc ) );
 
 	/* Close all data transfer interfaces */
-	intf_shutdown ( &ftp->data, rc );
-	intf_shutdown ( &ftp->control, rc );
+	for ( i = 0 ; i < FTP_MAX_SESSIONS ; i++ ) {
+		session = &ftp->session[i];
+		session->active = 0;
+		intf_shutdown ( &session->data, rc );
+		intf_shutdown ( &session->control, rc );
+	}
 	intf_shutdown ( &ftp->xfer, rc );
 }
 
+/**
+ * Close FTP session
+ *
+ * @v session		FTP session
+ * @v rc		Reason for close
+ *
+ * A session that fails (or that ends before reaching the end of its
+ * segment) is resumed from its current offset, if possible.
+ */
+static void ftp_session_close ( struct ftp_session *session, int rc ) {
+	struct ftp_request *ftp = session->ftp;
+	size_t end = ( session->end ? session->end : ftp->size );
+	unsigned long max;
+	unsigned int i;
+
+	/* Close connections */
+	intf_restart ( &session->data, rc );
+	intf_restart ( &session->control, rc );
+	session->active = 0;
+
+	/* Treat premature completion as an error */
+	if ( ( rc == 0 ) && end && ( session->offset != end ) ) {
+		DBGC ( ftp, "FTP %p[%d] ended at %#zx (expected %#zx)\n",
+		       ftp, ( int ) ( session - ftp->session ),
+		       session->offset, end );
+		rc = -EPROTO;
+	}
+
+	/* Resume session, if possible */
+	if ( rc != 0 ) {
+		if ( fetch_uint_setting ( NULL, &ftp_resume_setting,
+					  &max ) < 0 ) {
+			max = FTP_RESUME_MAX;
+		}
+		if ( ftp->resumed >= max ) {
+			DBGC ( ftp, "FTP %p giving up after %d resumption "
+			       "attempts\n", ftp, ftp->resumed );
+			goto err;
+		}
+		ftp->resumed++;
+		DBGC ( ftp, "FTP %p[%d] resuming at %#zx: %s\n",
+		       ftp, ( int ) ( session - ftp->session ),
+		       session->offset, strerror ( rc ) );
+		if ( ( rc = ftp_session_open ( session, session->offset,
+					       session->end ) ) != 0 )
+			goto err;
+		return;
+	}
+
+	/* Complete request once all sessions are complete */
+	for ( i = 0 ; i < FTP_MAX_SESSIONS ; i++ ) {
+		if ( ftp->session[i].active )
+			return;
+	}
+	ftp_done ( ftp, 0 );
+	return;
+
+ err:
+	ftp_done ( ftp, rc );
+}
+
 /*****************************************************************************
  *
  * FTP control channel
@@ -136,42 +270,56 @@ struct ftp_control_string {
 	const char *literal;
 	/** Variable portion
 	 *
-	 * @v ftp	FTP request
+	 * @v session	FTP session
 	 * @ret string	Variable portion of string
 	 */
-	const char * ( *variable ) ( struct ftp_request *ftp );
+	const char * ( *variable ) ( struct ftp_session *session );
 };
 
 /**
  * Retrieve FTP pathname
  *
- * @v ftp		FTP request
+ * @v session		FTP session
  * @ret path		FTP pathname
  */
-static const char * ftp_uri_path ( struct ftp_request *ftp ) {
-	return ftp->uri->path;
+static const char * ftp_uri_path ( struct ftp_session *session ) {
+	return session->ftp->uri->path;
 }
 
 /**
  * Retrieve FTP user
  *
- * @v ftp		FTP request
+ * @v session		FTP session
  * @ret user		FTP user
  */
-static const char * ftp_user ( struct ftp_request *ftp ) {
+static const char * ftp_user ( struct ftp_session *session ) {
 	static char *ftp_default_user = "anonymous";
-	return ftp->uri->user ? ftp->uri->user : ftp_default_user;
+	struct uri *uri = session->ftp->uri;
+
+	return uri->user ? uri->user : ftp_default_user;
 }
 
 /**
  * Retrieve FTP password
  *
- * @v ftp		FTP request
+ * @v session		FTP session
  * @ret password	FTP password
  */
-static const char * ftp_password ( struct ftp_request *ftp ) {
+static const char * ftp_password ( struct ftp_session *session ) {
 	static char *ftp_default_password = "ipxe@ipxe.org";
-	return ftp->uri->password ? ftp->uri->password : ftp_default_password;
+	struct uri *uri = session->ftp->uri;
+
+	return uri->password ? uri->password : ftp_default_password;
+}
+
+/**
+ * Retrieve FTP restart offset
+ *
+ * @v session		FTP session
+ * @ret offset		FTP restart offset
+ */
+static const char * ftp_rest ( struct ftp_session *session ) {
+	return session->rest_text;
 }
 
 /** FTP control channel strings */
@@ -182,6 +330,7 @@ static struct ftp_control_string ftp_strings[] = {
 	[FTP_TYPE]	= { "TYPE I", NULL },
 	[FTP_SIZE]	= { "SIZE ", ftp_uri_path },
 	[FTP_PASV]	= { "PASV", NULL },
+	[FTP_REST]	= { "REST ", ftp_rest },
 	[FTP_RETR]	= { "RETR ", ftp_uri_path },
 	[FTP_WAIT]	= { NULL, NULL },
 	[FTP_QUIT]	= { "QUIT", NULL },
@@ -214,41 +363,100 @@ static void ftp_parse_value ( char **text, uint8_t *value, size_t len ) {
 /**
  * Move to next state and send the appropriate FTP control string
  *
- * @v ftp		FTP request
+ * @v session		FTP session
  *
  */
-static void ftp_next_state ( struct ftp_request *ftp ) {
+static void ftp_next_state ( struct ftp_session *session ) {
+	struct ftp_request *ftp = session->ftp;
 	struct ftp_control_string *ftp_string;
 	const char *literal;
 	const char *variable;
 
-	/* Move to next state */
-	if ( ftp->state < FTP_DONE )
-		ftp->state++;
+	/* Move to next state, skipping the file size request if
+	 * already answered (for an earlier session) and the restart
+	 * offset if starting at the beginning of the file.
+	 */
+	do {
+		if ( session->state < FTP_DONE )
+			session->state++;
+	} while ( ( ( session->state == FTP_SIZE ) && ftp->sized ) ||
+		  ( ( session->state == FTP_REST ) && ! session->offset ) );
 
 	/* Send control string if needed */
-	ftp_string = &ftp_strings[ftp->state];
+	ftp_string = &ftp_strings[session->state];
 	literal = ftp_string->literal;
 	variable = ( ftp_string->variable ?
-		     ftp_string->variable ( ftp ) : "" );
+		     ftp_string->variable ( session ) : "" );
 	if ( literal ) {
-		DBGC ( ftp, "FTP %p sending %s%s\n", ftp, literal, variable );
-		xfer_printf ( &ftp->control, "%s%s\r\n", literal, variable );
+		DBGC ( ftp, "FTP %p[%d] sending %s%s\n", ftp,
+		       ( int ) ( session - ftp->session ), literal, variable );
+		xfer_printf ( &session->control, "%s%s\r\n",
+			      literal, variable );
 	}
 }
 
 /**
- * Handle an FTP control channel response
+ * Start parallel sessions
  *
  * @v ftp		FTP request
+ * @ret rc		Return status code
+ *
+ * The initial session is limited to the first segment of the file,
+ * and further sessions are opened to retrieve the remaining segments.
+ */
+static int ftp_parallel ( struct ftp_request *ftp ) {
+	unsigned long count;
+	size_t segment;
+	size_t offset;
+	size_t end;
+	unsigned int i;
+	int rc;
+
+	/* Use parallel sessions only if explicitly enabled */
+	if ( ( fetch_uint_setting ( NULL, &ftp_parallel_setting,
+				    &count ) < 0 ) || ( count < 2 ) ) {
+		return 0;
+	}
+	if ( count > FTP_MAX_SESSIONS )
+		count = FTP_MAX_SESSIONS;
+	if ( count > ( ftp->size / FTP_MIN_SEGMENT_LEN ) )
+		count = ( ftp->size / FTP_MIN_SEGMENT_LEN );
+	if ( count < 2 )
+		return 0;
+	segment = ( ftp->size / count );
+	DBGC ( ftp, "FTP %p using %ld sessions of %#zx bytes\n",
+	       ftp, count, segment );
+
+	/* Limit initial session to first segment, and open remaining
+	 * sessions.
+	 */
+	ftp->session[0].end = segment;
+	for ( i = 1 ; i < count ; i++ ) {
+		offset = ( i * segment );
+		end = ( ( ( i + 1 ) < count ) ? ( offset + segment ) : 0 );
+		if ( ( rc = ftp_session_open ( &ftp->session[i], offset,
+					       end ) ) != 0 )
+			return rc;
+	}
+
+	return 0;
+}
+
+/**
+ * Handle an FTP control channel response
+ *
+ * @v session		FTP session
  *
  * This is called once we have received a complete response line.
  */
-static void ftp_reply ( struct ftp_request *ftp ) {
-	char status_major = ftp->status_text[0];
-	char separator = ftp->status_text[3];
+static void ftp_reply ( struct ftp_session *session ) {
+	struct ftp_request *ftp = session->ftp;
+	char status_major = session->status_text[0];
+	char separator = session->status_text[3];
+	int rc;
 
-	DBGC ( ftp, "FTP %p received status %s\n", ftp, ftp->status_text );
+	DBGC ( ftp, "FTP %p[%d] received status %s\n", ftp,
+	       ( int ) ( session - ftp->session ), session->status_text );
 
 	/* Ignore malformed lines */
 	if ( separator != ' ' )
@@ -261,32 +469,35 @@ static void ftp_reply ( struct ftp_request *ftp ) {
 	/* If the SIZE command is not supported by the server, we go to
 	 * the next step.
 	 */
-	if ( ( status_major == '5' ) && ( ftp->state == FTP_SIZE ) ) {
-		ftp_next_state ( ftp );
+	if ( ( status_major == '5' ) && ( session->state == FTP_SIZE ) ) {
+		ftp->sized = 1;
+		ftp_next_state ( session );
 		return;
 	}
 
 	/* Anything other than success (2xx) or, in the case of a
-	 * repsonse to a "USER" command, a password prompt (3xx), is a
-	 * fatal error.
+	 * repsonse to a "USER" or "REST" command, a further
+	 * information request (3xx), is a fatal error.
 	 */
 	if ( ! ( ( status_major == '2' ) ||
-		 ( ( status_major == '3' ) && ( ftp->state == FTP_USER ) ) ) ){
+		 ( ( status_major == '3' ) &&
+		   ( ( session->state == FTP_USER ) ||
+		     ( session->state == FTP_REST ) ) ) ) ) {
 		/* Flag protocol error and close connections */
 		ftp_done ( ftp, -EPROTO );
 		return;
 	}
 
 	/* Parse file size */
-	if ( ftp->state == FTP_SIZE ) {
+	if ( session->state == FTP_SIZE ) {
 		size_t filesize;
 		char *endptr;
 
 		/* Parse size */
-		filesize = strtoul ( ftp->filesize, &endptr, 10 );
+		filesize = strtoul ( session->filesize, &endptr, 10 );
 		if ( *endptr != '\0' ) {
 			DBGC ( ftp, "FTP %p invalid SIZE \"%s\"\n",
-			       ftp, ftp->filesize );
+			       ftp, session->filesize );
 			ftp_done ( ftp, -EPROTO );
 			return;
 		}
@@ -295,40 +506,47 @@ static void ftp_reply ( struct ftp_request *ftp ) {
 		DBGC ( ftp, "FTP %p file size is %zd bytes\n", ftp, filesize );
 		xfer_seek ( &ftp->xfer, filesize );
 		xfer_seek ( &ftp->xfer, 0 );
+		ftp->size = filesize;
+		ftp->sized = 1;
+
+		/* Start parallel sessions, if applicable */
+		if ( ( rc = ftp_parallel ( ftp ) ) != 0 ) {
+			ftp_done ( ftp, rc );
+			return;
+		}
 	}
 
 	/* Open passive connection when we get "PASV" response */
-	if ( ftp->state == FTP_PASV ) {
-		char *ptr = ftp->passive_text;
+	if ( session->state == FTP_PASV ) {
+		char *ptr = session->passive_text;
 		union {
 			struct sockaddr_in sin;
 			struct sockaddr sa;
 		} sa;
-		int rc;
 
 		sa.sin.sin_family = AF_INET;
 		ftp_parse_value ( &ptr, ( uint8_t * ) &sa.sin.sin_addr,
 				  sizeof ( sa.sin.sin_addr ) );
 		ftp_parse_value ( &ptr, ( uint8_t * ) &sa.sin.sin_port,
 				  sizeof ( sa.sin.sin_port ) );
-		if ( ( rc = xfer_open_socket ( &ftp->data, SOCK_STREAM,
+		if ( ( rc = xfer_open_socket ( &session->data, SOCK_STREAM,
 					       &sa.sa, NULL ) ) != 0 ) {
 			DBGC ( ftp, "FTP %p could not open data connection\n",
 			       ftp );
-			ftp_done ( ftp, rc );
+			ftp_session_close ( session, rc );
 			return;
 		}
 	}
 
 	/* Move to next state and send control string */
-	ftp_next_state ( ftp );
+	ftp_next_state ( session );
 	
 }
 
 /**
  * Handle new data arriving on FTP control channel
  *
- * @v ftp		FTP request
+ * @v session		FTP session
  * @v iob		I/O buffer
  * @v meta		Data transfer metadata
  * @ret rc		Return status code
@@ -336,13 +554,14 @@ static void ftp_reply ( struct ftp_request *ftp ) {
  * Data is collected until a complete line is received, at which point
  * its information is passed to ftp_reply().
  */
-static int ftp_control_deliver ( struct ftp_request *ftp,
+static int ftp_control_deliver ( struct ftp_session *session,
 				 struct io_buffer *iobuf,
 				 struct xfer_metadata *meta __unused ) {
 	char *data = iobuf->data;
 	size_t len = iob_len ( iobuf );
-	char *recvbuf = ftp->recvbuf;
-	size_t recvsize = ftp->recvsize;
+	struct interface *dest = session->control.dest;
+	char *recvbuf = session->recvbuf;
+	size_t recvsize = session->recvsize;
 	char c;
 	
 	while ( len-- ) {
@@ -352,22 +571,29 @@ static int ftp_control_deliver ( struct ftp_request *ftp,
 			 * completed reply.  Avoid calling ftp_reply()
 			 * twice if we receive both \r and \n.
 			 */
-			if ( recvbuf != ftp->status_text )
-				ftp_reply ( ftp );
+			if ( recvbuf != session->status_text )
+				ftp_reply ( session );
+			/* Stop if this control connection has been
+			 * closed (or replaced by a resumed session).
+			 */
+			if ( session->control.dest != dest ) {
+				free_iob ( iobuf );
+				return 0;
+			}
 			/* Start filling up the status code buffer */
-			recvbuf = ftp->status_text;
-			recvsize = sizeof ( ftp->status_text ) - 1;
-		} else if ( ( ftp->state == FTP_PASV ) && ( c == '(' ) ) {
+			recvbuf = session->status_text;
+			recvsize = sizeof ( session->status_text ) - 1;
+		} else if ( ( session->state == FTP_PASV ) && ( c == '(' ) ) {
 			/* Start filling up the passive parameter buffer */
-			recvbuf = ftp->passive_text;
-			recvsize = sizeof ( ftp->passive_text ) - 1;
-		} else if ( ( ftp->state == FTP_PASV ) && ( c == ')' ) ) {
+			recvbuf = session->passive_text;
+			recvsize = sizeof ( session->passive_text ) - 1;
+		} else if ( ( session->state == FTP_PASV ) && ( c == ')' ) ) {
 			/* Stop filling the passive parameter buffer */
 			recvsize = 0;
-		} else if ( ( ftp->state == FTP_SIZE ) && ( c == ' ' ) ) {
+		} else if ( ( session->state == FTP_SIZE ) && ( c == ' ' ) ) {
 			/* Start filling up the file size buffer */
-			recvbuf = ftp->filesize;
-			recvsize = sizeof ( ftp->filesize ) - 1;
+			recvbuf = session->filesize;
+			recvsize = sizeof ( session->filesize ) - 1;
 		} else {
 			/* Fill up buffer if applicable */
 			if ( recvsize > 0 ) {
@@ -378,8 +604,8 @@ static int ftp_control_deliver ( struct ftp_request *ftp,
 	}
 
 	/* Store for next invocation */
-	ftp->recvbuf = recvbuf;
-	ftp->recvsize = recvsize;
+	session->recvbuf = recvbuf;
+	session->recvsize = recvsize;
 
 	/* Free I/O buffer */
 	free_iob ( iobuf );
@@ -389,13 +615,13 @@ static int ftp_control_deliver ( struct ftp_request *ftp,
 
 /** FTP control channel interface operations */
 static struct interface_operation ftp_control_operations[] = {
-	INTF_OP ( xfer_deliver, struct ftp_request *, ftp_control_deliver ),
-	INTF_OP ( intf_close, struct ftp_request *, ftp_done ),
+	INTF_OP ( xfer_deliver, struct ftp_session *, ftp_control_deliver ),
+	INTF_OP ( intf_close, struct ftp_session *, ftp_session_close ),
 };
 
 /** FTP control channel interface descriptor */
 static struct interface_descriptor ftp_control_desc =
-	INTF_DESC ( struct ftp_request, control, ftp_control_operations );
+	INTF_DESC ( struct ftp_session, control, ftp_control_operations );
 
 /*****************************************************************************
  *
@@ -403,40 +629,106 @@ static struct interface_descriptor ftp_control_desc =
  *
  */
 
+/**
+ * Handle new data arriving on FTP data channel
+ *
+ * @v session		FTP session
+ * @v iobuf		I/O buffer
+ * @v meta		Data transfer metadata
+ * @ret rc		Return status code
+ */
+static int ftp_data_deliver ( struct ftp_session *session,
+			      struct io_buffer *iobuf,
+			      struct xfer_metadata *meta __unused ) {
+	struct ftp_request *ftp = session->ftp;
+	struct xfer_metadata data_meta;
+	size_t len = iob_len ( iobuf );
+	size_t remaining;
+	int complete = 0;
+	int rc;
+
+	/* Truncate data at end of segment, if applicable */
+	if ( session->end ) {
+		remaining = ( session->end - session->offset );
+		if ( len >= remaining ) {
+			iob_unput ( iobuf, ( len - remaining ) );
+			len = remaining;
+			complete = 1;
+		}
+	}
+
+	/* Deliver data at current offset */
+	memset ( &data_meta, 0, sizeof ( data_meta ) );
+	data_meta.flags = XFER_FL_ABS_OFFSET;
+	data_meta.offset = session->offset;
+	session->offset += len;
+	if ( ( rc = xfer_deliver ( &ftp->xfer, iob_disown ( iobuf ),
+				   &data_meta ) ) != 0 ) {
+		ftp_done ( ftp, rc );
+		return rc;
+	}
+
+	/* Abort remainder of transfer at end of segment */
+	if ( complete ) {
+		DBGC ( ftp, "FTP %p[%d] completed segment at %#zx\n",
+		       ftp, ( int ) ( session - ftp->session ),
+		       session->offset );
+		xfer_printf ( &session->control, "ABOR\r\n" );
+		ftp_session_close ( session, 0 );
+	}
+
+	return 0;
+}
+
+/**
+ * Check FTP data channel flow control window
+ *
+ * @v session		FTP session
+ * @ret len		Length of window
+ */
+static size_t ftp_data_window ( struct ftp_session *session ) {
+
+	return xfer_window ( &session->ftp->xfer );
+}
+
 /**
  * Handle FTP data channel being closed
  *
- * @v ftp		FTP request
+ * @v session		FTP session
  * @v rc		Reason for closure
  *
  * When the data channel is closed, the control channel should be left
  * alone; the server will send a completion message via the control
  * channel which we'll pick up.
  *
- * If the data channel is closed due to an error, we abort the request.
+ * If the data channel is closed due to an error, we close the
+ * session (which will then be resumed if possible).
  */
-static void ftp_data_closed ( struct ftp_request *ftp, int rc ) {
+static void ftp_data_closed ( struct ftp_session *session, int rc ) {
+	struct ftp_request *ftp = session->ftp;
 
-	DBGC ( ftp, "FTP %p data connection closed: %s\n",
-	       ftp, strerror ( rc ) );
+	DBGC ( ftp, "FTP %p[%d] data connection closed: %s\n",
+	       ftp, ( int ) ( session - ftp->session ), strerror ( rc ) );
 	
-	/* If there was an error, close control channel and record status */
+	/* If there was an error, close session */
 	if ( rc ) {
-		ftp_done ( ftp, rc );
+		ftp_session_close ( session, rc );
 	} else {
-		ftp_next_state ( ftp );
+		intf_restart ( &session->data, rc );
+		ftp_next_state ( session );
 	}
 }
 
 /** FTP data channel interface operations */
 static struct interface_operation ftp_data_operations[] = {
-	INTF_OP ( intf_close, struct ftp_request *, ftp_data_closed ),
+	INTF_OP ( xfer_deliver, struct ftp_session *, ftp_data_deliver ),
+	INTF_OP ( xfer_window, struct ftp_session *, ftp_data_window ),
+	INTF_OP ( intf_close, struct ftp_session *, ftp_data_closed ),
 };
 
 /** FTP data channel interface descriptor */
 static struct interface_descriptor ftp_data_desc =
-	INTF_DESC_PASSTHRU ( struct ftp_request, data, ftp_data_operations,
-			     xfer );
+	INTF_DESC ( struct ftp_session, data, ftp_data_operations );
 
 /*****************************************************************************
  *
@@ -451,8 +743,7 @@ static struct interface_operation ftp_xfer_operations[] = {
 
 /** FTP data transfer interface descriptor */
 static struct interface_descriptor ftp_xfer_desc =
-	INTF_DESC_PASSTHRU ( struct ftp_request, xfer, ftp_xfer_operations,
-			     data );
+	INTF_DESC ( struct ftp_request, xfer, ftp_xfer_operations );
 
 /*****************************************************************************
  *
@@ -479,6 +770,46 @@ static int ftp_check_string ( const char *string ) {
 	return 0;
 }
 
+/**
+ * Open FTP session
+ *
+ * @v session		FTP session
+ * @v offset		Starting offset within file
+ * @v end		End of segment within file, or zero for end of file
+ * @ret rc		Return status code
+ */
+static int ftp_session_open ( struct ftp_session *session, size_t offset,
+			      size_t end ) {
+	struct ftp_request *ftp = session->ftp;
+	struct uri *uri = ftp->uri;
+	struct sockaddr_tcpip server;
+	int rc;
+
+	/* Reset session state */
+	session->offset = offset;
+	session->end = end;
+	session->state = FTP_CONNECT;
+	session->recvbuf = session->status_text;
+	session->recvsize = sizeof ( session->status_text ) - 1;
+	snprintf ( session->rest_text, sizeof ( session->rest_text ),
+		   "%zd", offset );
+
+	/* Open control connection */
+	memset ( &server, 0, sizeof ( server ) );
+	server.st_port = htons ( uri_port ( uri, FTP_PORT ) );
+	if ( ( rc = xfer_open_named_socket ( &session->control, SOCK_STREAM,
+					     ( struct sockaddr * ) &server,
+					     uri->host, NULL ) ) != 0 ) {
+		DBGC ( ftp, "FTP %p[%d] could not open control connection: "
+		       "%s\n", ftp, ( int ) ( session - ftp->session ),
+		       strerror ( rc ) );
+		return rc;
+	}
+	session->active = 1;
+
+	return 0;
+}
+
 /**
  * Initiate an FTP connection
  *
@@ -488,7 +819,8 @@ static int ftp_check_string ( const char *string ) {
  */
 static int ftp_open ( struct interface *xfer, struct uri *uri ) {
 	struct ftp_request *ftp;
-	struct sockaddr_tcpip server;
+	struct ftp_session *session;
+	unsigned int i;
 	int rc;
 
 	/* Sanity checks */
@@ -510,20 +842,19 @@ static int ftp_open ( struct interface *xfer, struct uri *uri ) {
 		return -ENOMEM;
 	ref_init ( &ftp->refcnt, ftp_free );
 	intf_init ( &ftp->xfer, &ftp_xfer_desc, &ftp->refcnt );
-	intf_init ( &ftp->control, &ftp_control_desc, &ftp->refcnt );
-	intf_init ( &ftp->data, &ftp_data_desc, &ftp->refcnt );
+	for ( i = 0 ; i < FTP_MAX_SESSIONS ; i++ ) {
+		session = &ftp->session[i];
+		session->ftp = ftp;
+		intf_init ( &session->control, &ftp_control_desc,
+			    &ftp->refcnt );
+		intf_init ( &session->data, &ftp_data_desc, &ftp->refcnt );
+	}
 	ftp->uri = uri_get ( uri );
-	ftp->recvbuf = ftp->status_text;
-	ftp->recvsize = sizeof ( ftp->status_text ) - 1;
 
 	DBGC ( ftp, "FTP %p fetching %s\n", ftp, ftp->uri->path );
 
-	/* Open control connection */
-	memset ( &server, 0, sizeof ( server ) );
-	server.st_port = htons ( uri_port ( uri, FTP_PORT ) );
-	if ( ( rc = xfer_open_named_socket ( &ftp->control, SOCK_STREAM,
-					     ( struct sockaddr * ) &server,
-					     uri->host, NULL ) ) != 0 )
+	/* Open initial session */
+	if ( ( rc = ftp_session_open ( &ftp->session[0], 0, 0 ) ) != 0 )
 		goto err;
 
 	/* Attach to parent interface, mortalise self, and return */
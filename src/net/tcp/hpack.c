@@ -0,0 +1,686 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+FILE_SECBOOT ( PERMITTED );
+
+/** @file
+ *
+ * HPACK header compression
+ *
+ * This is an implementation of HPACK as described in RFC 7541.  The
+ * decoder supports the full format including Huffman-encoded strings
+ * and the dynamic table.  The encoder never adds entries to the
+ * peer's dynamic table and never uses Huffman encoding: this keeps
+ * the encoder stateless at the cost of a few bytes per request.
+ *
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <ipxe/hpack.h>
+
+/** An HPACK static table entry */
+struct hpack_static_entry {
+	/** Name */
+	const char *name;
+	/** Value */
+	const char *value;
+};
+
+/** HPACK static table (RFC 7541 Appendix A) */
+static const struct hpack_static_entry hpack_static[HPACK_STATIC_ENTRIES] = {
+	{ ":authority", "" },
+	{ ":method", "GET" },
+	{ ":method", "POST" },
+	{ ":path", "/" },
+	{ ":path", "/index.html" },
+	{ ":scheme", "http" },
+	{ ":scheme", "https" },
+	{ ":status", "200" },
+	{ ":status", "204" },
+	{ ":status", "206" },
+	{ ":status", "304" },
+	{ ":status", "400" },
+	{ ":status", "404" },
+	{ ":status", "500" },
+	{ "accept-charset", "" },
+	{ "accept-encoding", "gzip, deflate" },
+	{ "accept-language", "" },
+	{ "accept-ranges", "" },
+	{ "accept", "" },
+	{ "access-control-allow-origin", "" },
+	{ "age", "" },
+	{ "allow", "" },
+	{ "authorization", "" },
+	{ "cache-control", "" },
+	{ "content-disposition", "" },
+	{ "content-encoding", "" },
+	{ "content-language", "" },
+	{ "content-length", "" },
+	{ "content-location", "" },
+	{ "content-range", "" },
+	{ "content-type", "" },
+	{ "cookie", "" },
+	{ "date", "" },
+	{ "etag", "" },
+	{ "expect", "" },
+	{ "expires", "" },
+	{ "from", "" },
+	{ "host", "" },
+	{ "if-match", "" },
+	{ "if-modified-since", "" },
+	{ "if-none-match", "" },
+	{ "if-range", "" },
+	{ "if-unmodified-since", "" },
+	{ "last-modified", "" },
+	{ "link", "" },
+	{ "location", "" },
+	{ "max-forwards", "" },
+	{ "proxy-authenticate", "" },
+	{ "proxy-authorization", "" },
+	{ "range", "" },
+	{ "referer", "" },
+	{ "refresh", "" },
+	{ "retry-after", "" },
+	{ "server", "" },
+	{ "set-cookie", "" },
+	{ "strict-transport-security", "" },
+	{ "transfer-encoding", "" },
+	{ "user-agent", "" },
+	{ "vary", "" },
+	{ "via", "" },
+	{ "www-authenticate", "" },
+};
+
+/** Length of shortest Huffman code */
+#define HPACK_HUFFMAN_MIN_LEN 5
+
+/** Length of longest Huffman code */
+#define HPACK_HUFFMAN_MAX_LEN 30
+
+/** Number of Huffman codes of each length (RFC 7541 Appendix B)
+ *
+ * The Huffman code is canonical, and so is completely described by
+ * the number of codes of each length along with the list of symbols
+ * in order of increasing code.  The final 30-bit code is the
+ * end-of-string symbol.
+ */
+static const uint8_t hpack_huffman_count[ HPACK_HUFFMAN_MAX_LEN + 1 -
+					  HPACK_HUFFMAN_MIN_LEN ] = {
+	10, 26, 32, 6, 0, 5, 3, 2, 6, 2, 3, 0, 0,
+	0, 3, 8, 13, 26, 29, 12, 4, 15, 19, 29, 0, 4,
+};
+
+/** Huffman symbols in order of increasing code (RFC 7541 Appendix B) */
+static const uint8_t hpack_huffman_symbol[256] = {
+	0x30, 0x31, 0x32, 0x61, 0x63, 0x65, 0x69, 0x6f,
+	0x73, 0x74, 0x20, 0x25, 0x2d, 0x2e, 0x2f, 0x33,
+	0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3d, 0x41,
+	0x5f, 0x62, 0x64, 0x66, 0x67, 0x68, 0x6c, 0x6d,
+	0x6e, 0x70, 0x72, 0x75, 0x3a, 0x42, 0x43, 0x44,
+	0x45, 0x46, 0x47, 0x48, 0x49, 0x4a, 0x4b, 0x4c,
+	0x4d, 0x4e, 0x4f, 0x50, 0x51, 0x52, 0x53, 0x54,
+	0x55, 0x56, 0x57, 0x59, 0x6a, 0x6b, 0x71, 0x76,
+	0x77, 0x78, 0x79, 0x7a, 0x26, 0x2a, 0x2c, 0x3b,
+	0x58, 0x5a, 0x21, 0x22, 0x28, 0x29, 0x3f, 0x27,
+	0x2b, 0x7c, 0x23, 0x3e, 0x00, 0x24, 0x40, 0x5b,
+	0x5d, 0x7e, 0x5e, 0x7d, 0x3c, 0x60, 0x7b, 0x5c,
+	0xc3, 0xd0, 0x80, 0x82, 0x83, 0xa2, 0xb8, 0xc2,
+	0xe0, 0xe2, 0x99, 0xa1, 0xa7, 0xac, 0xb0, 0xb1,
+	0xb3, 0xd1, 0xd8, 0xd9, 0xe3, 0xe5, 0xe6, 0x81,
+	0x84, 0x85, 0x86, 0x88, 0x92, 0x9a, 0x9c, 0xa0,
+	0xa3, 0xa4, 0xa9, 0xaa, 0xad, 0xb2, 0xb5, 0xb9,
+	0xba, 0xbb, 0xbd, 0xbe, 0xc4, 0xc6, 0xe4, 0xe8,
+	0xe9, 0x01, 0x87, 0x89, 0x8a, 0x8b, 0x8c, 0x8d,
+	0x8f, 0x93, 0x95, 0x96, 0x97, 0x98, 0x9b, 0x9d,
+	0x9e, 0xa5, 0xa6, 0xa8, 0xae, 0xaf, 0xb4, 0xb6,
+	0xb7, 0xbc, 0xbf, 0xc5, 0xe7, 0xef, 0x09, 0x8e,
+	0x90, 0x91, 0x94, 0x9f, 0xab, 0xce, 0xd7, 0xe1,
+	0xec, 0xed, 0xc7, 0xcf, 0xea, 0xeb, 0xc0, 0xc1,
+	0xc8, 0xc9, 0xca, 0xcd, 0xd2, 0xd5, 0xda, 0xdb,
+	0xee, 0xf0, 0xf2, 0xf3, 0xff, 0xcb, 0xcc, 0xd3,
+	0xd4, 0xd6, 0xdd, 0xde, 0xdf, 0xf1, 0xf4, 0xf5,
+	0xf6, 0xf7, 0xf8, 0xfa, 0xfb, 0xfc, 0xfd, 0xfe,
+	0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x0b,
+	0x0c, 0x0e, 0x0f, 0x10, 0x11, 0x12, 0x13, 0x14,
+	0x15, 0x17, 0x18, 0x19, 0x1a, 0x1b, 0x1c, 0x1d,
+	0x1e, 0x1f, 0x7f, 0xdc, 0xf9, 0x0a, 0x0d, 0x16,
+};
+
+/** HPACK decoder input */
+struct hpack_input {
+	/** Remaining data */
+	const uint8_t *data;
+	/** Length of remaining data */
+	size_t len;
+	/** Scratch space for decoded strings */
+	char *scratch;
+};
+
+/**
+ * Decode integer
+ *
+ * @v in		Decoder input
+ * @v bits		Number of bits in prefix
+ * @ret value		Decoded value
+ * @ret rc		Return status code
+ */
+static int hpack_decode_integer ( struct hpack_input *in, unsigned int bits,
+				  size_t *value ) {
+	unsigned int mask = ( ( 1 << bits ) - 1 );
+	unsigned int shift = 0;
+	uint8_t byte;
+
+	/* Decode prefix */
+	if ( ! in->len )
+		return -EINVAL;
+	*value = ( *(in->data++) & mask );
+	in->len--;
+	if ( *value < mask )
+		return 0;
+
+	/* Decode continuation bytes */
+	do {
+		if ( ( ! in->len ) || ( shift > 21 ) )
+			return -EINVAL;
+		byte = *(in->data++);
+		in->len--;
+		*value += ( ( byte & 0x7f ) << shift );
+		shift += 7;
+	} while ( byte & 0x80 );
+
+	return 0;
+}
+
+/**
+ * Decode Huffman-encoded string
+ *
+ * @v data		Encoded string
+ * @v len		Length of encoded string
+ * @v out		Output buffer
+ * @ret out_len		Length of decoded string
+ * @ret rc		Return status code
+ *
+ * The output buffer must be large enough to hold ( @c len * 8 / 5 )
+ * bytes.
+ */
+static int hpack_decode_huffman ( const uint8_t *data, size_t len, char *out,
+				  size_t *out_len ) {
+	const uint8_t *count;
+	unsigned int index;
+	uint32_t first;
+	uint32_t code;
+	unsigned int bits;
+	unsigned int bit;
+
+	/* Decode one symbol at a time */
+	*out_len = 0;
+	bit = ( len * 8 );
+	while ( bit ) {
+
+		/* Find symbol by walking through each code length */
+		code = 0;
+		first = 0;
+		index = 0;
+		count = hpack_huffman_count;
+		for ( bits = 1 ; bits <= HPACK_HUFFMAN_MAX_LEN ; bits++ ) {
+
+			/* Consume next bit, allowing for padding */
+			if ( ! bit ) {
+				/* Padding must be a prefix of the
+				 * end-of-string symbol (i.e. all ones),
+				 * and must be shorter than one byte.
+				 */
+				if ( ( bits > 8 ) ||
+				     ( ( code >> 1 ) !=
+				       ( ( 1U << ( bits - 1 ) ) - 1 ) ) )
+					return -EINVAL;
+				return 0;
+			}
+			bit--;
+			code |= ( ( data[ len - 1 - ( bit / 8 ) ] >>
+				    ( bit % 8 ) ) & 1 );
+
+			/* Check for a code of this length */
+			if ( bits >= HPACK_HUFFMAN_MIN_LEN ) {
+				if ( ( code - first ) < *count )
+					break;
+				index += *count;
+				first += *(count++);
+			}
+			first <<= 1;
+			code <<= 1;
+		}
+
+		/* Reject end-of-string symbol (which is the final code) */
+		index += ( code - first );
+		if ( index >= sizeof ( hpack_huffman_symbol ) )
+			return -EINVAL;
+		out[ (*out_len)++ ] = hpack_huffman_symbol[index];
+	}
+
+	return 0;
+}
+
+/**
+ * Decode string
+ *
+ * @v in		Decoder input
+ * @ret string		Decoded string
+ * @ret string_len	Length of decoded string
+ * @ret rc		Return status code
+ */
+static int hpack_decode_string ( struct hpack_input *in, const char **string,
+				 size_t *string_len ) {
+	int huffman;
+	size_t len;
+	int rc;
+
+	/* Decode length */
+	if ( ! in->len )
+		return -EINVAL;
+	huffman = ( *in->data & 0x80 );
+	if ( ( rc = hpack_decode_integer ( in, 7, &len ) ) != 0 )
+		return rc;
+	if ( len > in->len )
+		return -EINVAL;
+
+	/* Decode string */
+	if ( huffman ) {
+		if ( ( rc = hpack_decode_huffman ( in->data, len, in->scratch,
+						   string_len ) ) != 0 )
+			return rc;
+		*string = in->scratch;
+		in->scratch += *string_len;
+	} else {
+		*string = ( ( const char * ) in->data );
+		*string_len = len;
+	}
+	in->data += len;
+	in->len -= len;
+
+	return 0;
+}
+
+/**
+ * Look up header field by index
+ *
+ * @v table		Dynamic table
+ * @v index		Index
+ * @v header		Header field to fill in
+ * @ret rc		Return status code
+ */
+static int hpack_lookup ( struct hpack_table *table, size_t index,
+			  struct hpack_header *header ) {
+	const struct hpack_static_entry *entry;
+	struct hpack_entry *dynamic;
+
+	/* Index zero is not used */
+	if ( ! index )
+		return -EINVAL;
+
+	/* Look up in static table */
+	if ( index <= HPACK_STATIC_ENTRIES ) {
+		entry = &hpack_static[ index - 1 ];
+		header->name = entry->name;
+		header->name_len = strlen ( entry->name );
+		header->value = entry->value;
+		header->value_len = strlen ( entry->value );
+		return 0;
+	}
+
+	/* Look up in dynamic table */
+	index -= HPACK_STATIC_ENTRIES;
+	list_for_each_entry ( dynamic, &table->entries, list ) {
+		if ( ! --index ) {
+			memcpy ( header, &dynamic->header, sizeof ( *header ) );
+			return 0;
+		}
+	}
+
+	return -ENOENT;
+}
+
+/**
+ * Evict entries from dynamic table
+ *
+ * @v table		Dynamic table
+ * @v max		Maximum size of remaining entries
+ */
+static void hpack_evict ( struct hpack_table *table, size_t max ) {
+	struct hpack_entry *entry;
+
+	/* Evict oldest entries until table is small enough */
+	while ( table->size > max ) {
+		entry = list_last_entry ( &table->entries, struct hpack_entry,
+					  list );
+		table->size -= ( entry->header.name_len +
+				 entry->header.value_len +
+				 HPACK_ENTRY_OVERHEAD );
+		list_del ( &entry->list );
+		free ( entry );
+	}
+}
+
+/**
+ * Decode literal header field
+ *
+ * @v table		Dynamic table
+ * @v in		Decoder input
+ * @v bits		Number of bits in name index prefix
+ * @v header		Header field to fill in
+ * @ret rc		Return status code
+ */
+static int hpack_decode_literal ( struct hpack_table *table,
+				  struct hpack_input *in, unsigned int bits,
+				  struct hpack_header *header ) {
+	size_t index;
+	int rc;
+
+	/* Decode name */
+	if ( ( rc = hpack_decode_integer ( in, bits, &index ) ) != 0 )
+		return rc;
+	if ( index ) {
+		if ( ( rc = hpack_lookup ( table, index, header ) ) != 0 )
+			return rc;
+	} else {
+		if ( ( rc = hpack_decode_string ( in, &header->name,
+						  &header->name_len ) ) != 0 )
+			return rc;
+	}
+
+	/* Decode value */
+	if ( ( rc = hpack_decode_string ( in, &header->value,
+					  &header->value_len ) ) != 0 )
+		return rc;
+
+	return 0;
+}
+
+/**
+ * Create dynamic table entry
+ *
+ * @v table		Dynamic table
+ * @v header		Header field
+ * @ret entry		Dynamic table entry, or NULL on error
+ *
+ * The header field is updated to point to the copy held within the
+ * new entry.  The entry is not yet added to the dynamic table.
+ */
+static struct hpack_entry * hpack_entry ( struct hpack_header *header ) {
+	struct hpack_entry *entry;
+	char *name;
+	char *value;
+
+	/* Allocate and populate entry */
+	entry = malloc ( sizeof ( *entry ) + header->name_len +
+			 header->value_len );
+	if ( ! entry )
+		return NULL;
+	name = ( ( ( void * ) entry ) + sizeof ( *entry ) );
+	value = ( name + header->name_len );
+	memcpy ( name, header->name, header->name_len );
+	memcpy ( value, header->value, header->value_len );
+	entry->header.name = name;
+	entry->header.name_len = header->name_len;
+	entry->header.value = value;
+	entry->header.value_len = header->value_len;
+	memcpy ( header, &entry->header, sizeof ( *header ) );
+
+	return entry;
+}
+
+/**
+ * Decode header block
+ *
+ * @v table		Dynamic table
+ * @v data		Header block
+ * @v len		Length of header block
+ * @v emit		Method to call for each decoded header field
+ * @v ctx		Context for emit method
+ * @ret rc		Return status code
+ *
+ * The decoded header field is valid only for the duration of the
+ * call to the emit method.
+ */
+int hpack_decode ( struct hpack_table *table, const void *data, size_t len,
+		   int ( * emit ) ( void *ctx, struct hpack_header *header ),
+		   void *ctx ) {
+	struct hpack_input in;
+	struct hpack_header header;
+	struct hpack_entry *entry;
+	struct hpack_entry *discard;
+	size_t index;
+	size_t size;
+	char *scratch;
+	uint8_t byte;
+	int rc;
+
+	/* Allocate scratch space for Huffman-decoded strings.  The
+	 * shortest Huffman code is five bits long.
+	 */
+	scratch = malloc ( ( len * 8 / HPACK_HUFFMAN_MIN_LEN ) + 1 );
+	if ( ! scratch ) {
+		rc = -ENOMEM;
+		goto err_alloc;
+	}
+	in.data = data;
+	in.len = len;
+
+	/* Decode each header field */
+	while ( in.len ) {
+
+		/* Reset scratch space */
+		in.scratch = scratch;
+		discard = NULL;
+		byte = *in.data;
+
+		if ( byte & 0x80 ) {
+
+			/* Indexed header field */
+			if ( ( rc = hpack_decode_integer ( &in, 7,
+							   &index ) ) != 0 )
+				goto err_decode;
+			if ( ( rc = hpack_lookup ( table, index,
+						   &header ) ) != 0 )
+				goto err_decode;
+
+		} else if ( byte & 0x40 ) {
+
+			/* Literal header field with incremental indexing */
+			if ( ( rc = hpack_decode_literal ( table, &in, 6,
+							   &header ) ) != 0 )
+				goto err_decode;
+			entry = hpack_entry ( &header );
+			if ( ! entry ) {
+				rc = -ENOMEM;
+				goto err_decode;
+			}
+			size = ( header.name_len + header.value_len +
+				 HPACK_ENTRY_OVERHEAD );
+			if ( size <= table->max ) {
+				hpack_evict ( table, ( table->max - size ) );
+				list_add ( &entry->list, &table->entries );
+				table->size += size;
+			} else {
+				hpack_evict ( table, 0 );
+				discard = entry;
+			}
+
+		} else if ( byte & 0x20 ) {
+
+			/* Dynamic table size update */
+			if ( ( rc = hpack_decode_integer ( &in, 5,
+							   &size ) ) != 0 )
+				goto err_decode;
+			if ( size > table->limit ) {
+				rc = -ERANGE;
+				goto err_decode;
+			}
+			table->max = size;
+			hpack_evict ( table, size );
+			continue;
+
+		} else {
+
+			/* Literal header field without indexing (or
+			 * never indexed)
+			 */
+			if ( ( rc = hpack_decode_literal ( table, &in, 4,
+							   &header ) ) != 0 )
+				goto err_decode;
+		}
+
+		/* Emit header field */
+		rc = emit ( ctx, &header );
+		free ( discard );
+		if ( rc != 0 )
+			goto err_emit;
+	}
+
+	/* Success */
+	rc = 0;
+
+ err_emit:
+ err_decode:
+	free ( scratch );
+ err_alloc:
+	return rc;
+}
+
+/**
+ * Encode integer
+ *
+ * @v data		Output buffer, or NULL
+ * @v bits		Number of bits in prefix
+ * @v flags		Flags in first byte
+ * @v value		Value
+ * @ret len		Length of encoded integer
+ */
+static size_t hpack_encode_integer ( uint8_t *data, unsigned int bits,
+				     uint8_t flags, size_t value ) {
+	unsigned int mask = ( ( 1 << bits ) - 1 );
+	size_t len = 1;
+
+	/* Encode prefix */
+	if ( value < mask ) {
+		if ( data )
+			*data = ( flags | value );
+		return len;
+	}
+	if ( data )
+		*(data++) = ( flags | mask );
+	value -= mask;
+
+	/* Encode continuation bytes */
+	do {
+		if ( data ) {
+			*(data++) = ( ( value & 0x7f ) |
+				      ( ( value >= 0x80 ) ? 0x80 : 0 ) );
+		}
+		value >>= 7;
+		len++;
+	} while ( value );
+
+	return len;
+}
+
+/**
+ * Encode string
+ *
+ * @v data		Output buffer, or NULL
+ * @v string		String
+ * @v string_len	Length of string
+ * @ret len		Length of encoded string
+ */
+static size_t hpack_encode_string ( uint8_t *data, const char *string,
+				    size_t string_len ) {
+	size_t len;
+
+	/* Encode length, then copy string */
+	len = hpack_encode_integer ( data, 7, 0, string_len );
+	if ( data )
+		memcpy ( ( data + len ), string, string_len );
+	return ( len + string_len );
+}
+
+/**
+ * Encode header field
+ *
+ * @v data		Output buffer, or NULL
+ * @v header		Header field (with lower-case name)
+ * @ret len		Length of encoded header field
+ *
+ * The header field is encoded using the static table where possible,
+ * and is otherwise encoded as a literal header field without
+ * indexing.  Call with a NULL output buffer to determine the required
+ * length.
+ */
+size_t hpack_encode ( void *data, struct hpack_header *header ) {
+	const struct hpack_static_entry *entry;
+	unsigned int name_index = 0;
+	unsigned int index;
+	size_t len;
+
+	/* Look for a matching static table entry */
+	for ( index = 1 ; index <= HPACK_STATIC_ENTRIES ; index++ ) {
+		entry = &hpack_static[ index - 1 ];
+		if ( ( strlen ( entry->name ) != header->name_len ) ||
+		     ( memcmp ( entry->name, header->name,
+				header->name_len ) != 0 ) )
+			continue;
+		if ( ( strlen ( entry->value ) == header->value_len ) &&
+		     ( memcmp ( entry->value, header->value,
+				header->value_len ) == 0 ) ) {
+			/* Indexed header field */
+			return hpack_encode_integer ( data, 7, 0x80, index );
+		}
+		if ( ! name_index )
+			name_index = index;
+	}
+
+	/* Encode as literal header field without indexing */
+	len = hpack_encode_integer ( data, 4, 0x00, name_index );
+	if ( ! name_index ) {
+		len += hpack_encode_string ( ( data ? ( data + len ) : NULL ),
+					     header->name, header->name_len );
+	}
+	len += hpack_encode_string ( ( data ? ( data + len ) : NULL ),
+				     header->value, header->value_len );
+
+	return len;
+}
+
+/**
+ * Empty dynamic table
+ *
+ * @v table		Dynamic table
+ */
+void hpack_flush ( struct hpack_table *table ) {
+
+	/* Evict all entries */
+	hpack_evict ( table, 0 );
+}
@@ -0,0 +1,1844 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+FILE_SECBOOT ( PERMITTED );
+
+/**
+ * @file
+ *
+ * Hyper Text Transfer Protocol version 2 (HTTP/2)
+ *
+ * HTTP/2 is negotiated via TLS application-layer protocol negotiation
+ * (ALPN).  Once negotiated, the HTTP connection is handed over to an
+ * HTTP/2 connection which may then carry multiple concurrent HTTP
+ * transactions, each as a separate stream.
+ *
+ * Each stream presents itself to the HTTP transaction exactly as an
+ * HTTP/1.1 connection would.  The request constructed by the HTTP
+ * core is translated into a HEADERS frame (and, if applicable, DATA
+ * frames), and the response headers are translated back into an
+ * equivalent HTTP/1.1 status line and headers.  The response body is
+ * passed through unmodified, and the end of the stream is indicated
+ * by closing the data transfer interface.  This allows all existing
+ * HTTP features (authentication, redirection, range requests, block
+ * device access, etc) to be used without modification.
+ *
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+#include <errno.h>
+#include <byteswap.h>
+#include <ipxe/refcnt.h>
+#include <ipxe/iobuf.h>
+#include <ipxe/xfer.h>
+#include <ipxe/xferbuf.h>
+#include <ipxe/process.h>
+#include <ipxe/retry.h>
+#include <ipxe/timer.h>
+#include <ipxe/pool.h>
+#include <ipxe/alpn.h>
+#include <ipxe/hpack.h>
+#include <ipxe/http.h>
+#include <ipxe/http2.h>
+
+/* Disambiguate the various error causes */
+#define EPROTO_FRAME __einfo_error ( EINFO_EPROTO_FRAME )
+#define EINFO_EPROTO_FRAME \
+	__einfo_uniqify ( EINFO_EPROTO, 0x01, "Invalid frame" )
+#define EPROTO_HEADERS __einfo_error ( EINFO_EPROTO_HEADERS )
+#define EINFO_EPROTO_HEADERS \
+	__einfo_uniqify ( EINFO_EPROTO, 0x02, "Invalid header block" )
+#define EPROTO_FLOW __einfo_error ( EINFO_EPROTO_FLOW )
+#define EINFO_EPROTO_FLOW \
+	__einfo_uniqify ( EINFO_EPROTO, 0x03, "Flow control error" )
+#define EPROTO_GOAWAY __einfo_error ( EINFO_EPROTO_GOAWAY )
+#define EINFO_EPROTO_GOAWAY \
+	__einfo_uniqify ( EINFO_EPROTO, 0x04, "Connection terminated by peer" )
+#define EINVAL_REQUEST __einfo_error ( EINFO_EINVAL_REQUEST )
+#define EINFO_EINVAL_REQUEST \
+	__einfo_uniqify ( EINFO_EINVAL, 0x01, "Invalid request" )
+#define ECONNRESET_STREAM __einfo_error ( EINFO_ECONNRESET_STREAM )
+#define EINFO_ECONNRESET_STREAM \
+	__einfo_uniqify ( EINFO_ECONNRESET, 0x01, "Stream reset by peer" )
+
+/** Offered application protocols (in ALPN wire format) */
+static const char http2_alpn[] = "\x02" HTTP2_ALPN "\x08" "http/1.1";
+
+/** HTTP/2 connections */
+static LIST_HEAD ( http2_connections );
+
+/** Request headers that must not be sent over HTTP/2 */
+static const char *http2_excluded[] = {
+	"host", "connection", "keep-alive", "proxy-connection",
+	"transfer-encoding", "upgrade", "te",
+};
+
+static void http2_close ( struct http2_connection *h2, int rc );
+static void http2_stream_close ( struct http2_stream *stream, int rc );
+
+/******************************************************************************
+ *
+ * Frame transmission
+ *
+ ******************************************************************************
+ */
+
+/**
+ * Transmit frame
+ *
+ * @v h2		HTTP/2 connection
+ * @v type		Frame type
+ * @v flags		Frame flags
+ * @v stream		Stream identifier
+ * @v data		Payload
+ * @v len		Length of payload
+ * @ret rc		Return status code
+ */
+static int http2_tx ( struct http2_connection *h2, unsigned int type,
+		      unsigned int flags, uint32_t stream, const void *data,
+		      size_t len ) {
+	struct http2_frame_header *hdr;
+	struct io_buffer *iobuf;
+	int rc;
+
+	/* Allocate I/O buffer */
+	iobuf = xfer_alloc_iob ( &h2->socket, ( sizeof ( *hdr ) + len ) );
+	if ( ! iobuf )
+		return -ENOMEM;
+
+	/* Construct frame */
+	hdr = iob_put ( iobuf, sizeof ( *hdr ) );
+	hdr->len_type = HTTP2_LEN_TYPE ( len, type );
+	hdr->flags = flags;
+	hdr->stream = htonl ( stream );
+	memcpy ( iob_put ( iobuf, len ), data, len );
+
+	/* Transmit frame */
+	if ( ( rc = xfer_deliver_iob ( &h2->socket,
+				       iob_disown ( iobuf ) ) ) != 0 ) {
+		DBGC ( h2, "HTTP2 %p could not transmit frame: %s\n",
+		       h2, strerror ( rc ) );
+		return rc;
+	}
+
+	return 0;
+}
+
+/**
+ * Transmit RST_STREAM frame
+ *
+ * @v h2		HTTP/2 connection
+ * @v stream		Stream identifier
+ * @v error		Error code
+ * @ret rc		Return status code
+ */
+static int http2_tx_rst_stream ( struct http2_connection *h2, uint32_t stream,
+				 uint32_t error ) {
+	uint32_t payload = htonl ( error );
+
+	return http2_tx ( h2, HTTP2_RST_STREAM, 0, stream, &payload,
+			  sizeof ( payload ) );
+}
+
+/**
+ * Transmit WINDOW_UPDATE frame
+ *
+ * @v h2		HTTP/2 connection
+ * @v stream		Stream identifier (or zero for connection)
+ * @v increment		Window size increment
+ * @ret rc		Return status code
+ */
+static int http2_tx_window_update ( struct http2_connection *h2,
+				    uint32_t stream, uint32_t increment ) {
+	uint32_t payload = htonl ( increment );
+
+	return http2_tx ( h2, HTTP2_WINDOW_UPDATE, 0, stream, &payload,
+			  sizeof ( payload ) );
+}
+
+/**
+ * Transmit GOAWAY frame
+ *
+ * @v h2		HTTP/2 connection
+ * @v error		Error code
+ * @ret rc		Return status code
+ */
+static int http2_tx_goaway ( struct http2_connection *h2, uint32_t error ) {
+	struct http2_goaway goaway;
+
+	/* We never accept any server-initiated streams */
+	goaway.last = 0;
+	goaway.error = htonl ( error );
+	return http2_tx ( h2, HTTP2_GOAWAY, 0, 0, &goaway, sizeof ( goaway ) );
+}
+
+/**
+ * Transmit connection preface and initial settings
+ *
+ * @v h2		HTTP/2 connection
+ * @ret rc		Return status code
+ */
+static int http2_tx_preface ( struct http2_connection *h2 ) {
+	struct http2_setting settings[] = {
+		{ htons ( HTTP2_SETTINGS_ENABLE_PUSH ), htonl ( 0 ) },
+		{ htons ( HTTP2_SETTINGS_INITIAL_WINDOW_SIZE ),
+		  htonl ( HTTP2_WINDOW ) },
+	};
+	int rc;
+
+	/* Transmit preface */
+	if ( ( rc = xfer_deliver_raw ( &h2->socket, HTTP2_PREFACE,
+				       ( sizeof ( HTTP2_PREFACE ) - 1 ) ) )!=0)
+		return rc;
+
+	/* Transmit settings */
+	if ( ( rc = http2_tx ( h2, HTTP2_SETTINGS, 0, 0, settings,
+			       sizeof ( settings ) ) ) != 0 )
+		return rc;
+
+	/* Enlarge connection receive window */
+	if ( ( rc = http2_tx_window_update ( h2, 0, ( HTTP2_WINDOW -
+						      HTTP2_DEFAULT_WINDOW )))!=0)
+		return rc;
+
+	return 0;
+}
+
+/******************************************************************************
+ *
+ * Streams
+ *
+ ******************************************************************************
+ */
+
+/**
+ * Free HTTP/2 stream
+ *
+ * @v refcnt		Reference count
+ */
+static void http2_stream_free ( struct refcnt *refcnt ) {
+	struct http2_stream *stream =
+		container_of ( refcnt, struct http2_stream, refcnt );
+
+	free_iob ( stream->tx );
+	ref_put ( &stream->h2->refcnt );
+	free ( stream );
+}
+
+/**
+ * Find stream by identifier
+ *
+ * @v h2		HTTP/2 connection
+ * @v id		Stream identifier
+ * @ret stream		Stream, or NULL if not found
+ */
+static struct http2_stream * http2_stream ( struct http2_connection *h2,
+					    uint32_t id ) {
+	struct http2_stream *stream;
+
+	list_for_each_entry ( stream, &h2->streams, list ) {
+		if ( stream->id == id )
+			return stream;
+	}
+	return NULL;
+}
+
+/**
+ * Check if new streams may be opened
+ *
+ * @v h2		HTTP/2 connection
+ * @ret ok		New streams may be opened
+ */
+static int http2_can_open ( struct http2_connection *h2 ) {
+
+	return ( ( ! ( h2->flags & HTTP2_CONN_GOAWAY ) ) &&
+		 ( h2->open < h2->peer.max_streams ) );
+}
+
+/**
+ * Schedule streams waiting for service
+ *
+ * @v h2		HTTP/2 connection
+ */
+static void http2_schedule ( struct http2_connection *h2 ) {
+	struct http2_stream *stream;
+
+	/* Do nothing if connection is closed */
+	if ( h2->flags & HTTP2_CONN_CLOSED )
+		return;
+
+	/* Close or start idle timer if there are no streams */
+	if ( list_empty ( &h2->streams ) ) {
+		if ( h2->flags & HTTP2_CONN_GOAWAY ) {
+			http2_close ( h2, 0 );
+		} else {
+			start_timer_fixed ( &h2->timer, HTTP2_IDLE_EXPIRY );
+		}
+		return;
+	}
+	stop_timer ( &h2->timer );
+
+	/* Notify any streams waiting to open */
+	if ( http2_can_open ( h2 ) ) {
+		list_for_each_entry ( stream, &h2->streams, list ) {
+			if ( ! stream->id ) {
+				stream->flags |= HTTP2_STREAM_NOTIFY;
+				process_add ( &h2->process );
+			}
+		}
+	}
+
+	/* Resume any streams waiting to transmit */
+	list_for_each_entry ( stream, &h2->streams, list ) {
+		if ( stream->tx ) {
+			stream->flags |= HTTP2_STREAM_TX_READY;
+			process_add ( &h2->process );
+		}
+	}
+}
+
+/**
+ * Check if stream may be reopened on a new connection
+ *
+ * @v stream		HTTP/2 stream
+ * @ret reopenable	Stream may be reopened
+ *
+ * As with pooled HTTP/1.1 connections, a stream is reopenable if it
+ * was opened on an existing connection and has received no response.
+ */
+static int http2_stream_reopenable ( struct http2_stream *stream ) {
+
+	return ( ( stream->flags & HTTP2_STREAM_REUSED ) &&
+		 ( ! ( stream->flags & HTTP2_STREAM_RESPONSE ) ) );
+}
+
+/**
+ * Close HTTP/2 stream
+ *
+ * @v stream		HTTP/2 stream
+ * @v rc		Reason for close
+ */
+static void http2_stream_close ( struct http2_stream *stream, int rc ) {
+	struct http2_connection *h2 = stream->h2;
+
+	/* Do nothing if already closed */
+	if ( list_empty ( &stream->list ) )
+		return;
+
+	/* Reset stream if it has not been ended by both sides */
+	if ( stream->id && ( ! ( h2->flags & HTTP2_CONN_CLOSED ) ) &&
+	     ( stream->tx || ! ( stream->flags & HTTP2_STREAM_END ) ) ) {
+		http2_tx_rst_stream ( h2, stream->id, HTTP2_CANCEL );
+	}
+
+	/* Remove from connection */
+	list_del ( &stream->list );
+	INIT_LIST_HEAD ( &stream->list );
+	if ( stream->id )
+		h2->open--;
+	free_iob ( stream->tx );
+	stream->tx = NULL;
+
+	/* Shut down interface */
+	intf_shutdown ( &stream->xfer, rc );
+	if ( rc == 0 ) {
+		DBGC2 ( h2, "HTTP2 %p stream %d closed\n", h2, stream->id );
+	} else {
+		DBGC ( h2, "HTTP2 %p stream %d closed: %s\n",
+		       h2, stream->id, strerror ( rc ) );
+	}
+
+	/* Drop connection's reference to stream */
+	ref_put ( &stream->refcnt );
+
+	/* Allow waiting streams to proceed */
+	http2_schedule ( h2 );
+}
+
+/**
+ * Abort HTTP/2 stream due to connection termination
+ *
+ * @v stream		HTTP/2 stream
+ * @v rc		Reason for close
+ */
+static void http2_stream_abort ( struct http2_stream *stream, int rc ) {
+
+	/* Keep stream alive while the reopen request is handled */
+	ref_get ( &stream->refcnt );
+
+	/* Suggest that the client should reopen the connection, if
+	 * applicable.  The client will typically close the stream
+	 * in response.
+	 */
+	if ( http2_stream_reopenable ( stream ) )
+		pool_reopen ( &stream->xfer );
+
+	/* Close stream.  The response is necessarily incomplete. */
+	http2_stream_close ( stream, ( rc ? rc : -ECONNRESET ) );
+	ref_put ( &stream->refcnt );
+}
+
+/**
+ * Transmit pending request body
+ *
+ * @v stream		HTTP/2 stream
+ * @ret rc		Return status code
+ */
+static int http2_stream_tx ( struct http2_stream *stream ) {
+	struct http2_connection *h2 = stream->h2;
+	struct io_buffer *iobuf;
+	unsigned int flags;
+	size_t len;
+	int rc;
+
+	/* Transmit as much as flow control will allow */
+	while ( ( iobuf = stream->tx ) ) {
+
+		/* Calculate frame length */
+		len = iob_len ( iobuf );
+		if ( len > h2->peer.max_frame )
+			len = h2->peer.max_frame;
+		if ( stream->tx_window <= 0 )
+			return 0;
+		if ( len > ( size_t ) stream->tx_window )
+			len = stream->tx_window;
+		if ( h2->tx_window <= 0 )
+			return 0;
+		if ( len > ( size_t ) h2->tx_window )
+			len = h2->tx_window;
+		if ( ! xfer_window ( &h2->socket ) )
+			return 0;
+		flags = ( ( len == iob_len ( iobuf ) ) ?
+			  HTTP2_FL_END_STREAM : 0 );
+
+		/* Transmit frame */
+		if ( ( rc = http2_tx ( h2, HTTP2_DATA, flags, stream->id,
+				       iobuf->data, len ) ) != 0 )
+			return rc;
+		stream->tx_window -= len;
+		h2->tx_window -= len;
+
+		/* Consume data */
+		iob_pull ( iobuf, len );
+		if ( ! iob_len ( iobuf ) ) {
+			free_iob ( iobuf );
+			stream->tx = NULL;
+		}
+	}
+
+	return 0;
+}
+
+/**
+ * Parse request header line
+ *
+ * @v pos		Current position within request
+ * @v end		End of request headers
+ * @v header		Header field to fill in
+ * @ret found		Header field was found (or negative error)
+ *
+ * Header names are converted to lower case in situ, as required by
+ * HTTP/2.  Parsing stops at the empty line terminating the headers.
+ */
+static int http2_request_header ( char **pos, char *end,
+				  struct hpack_header *header ) {
+	char *line = *pos;
+	char *colon = NULL;
+	char *eol;
+	char *tmp;
+
+	/* Find end of line */
+	for ( eol = line ; ( eol < end ) && ( *eol != '\r' ) ; eol++ ) {
+		if ( ( *eol == ':' ) && ! colon )
+			colon = eol;
+	}
+	if ( ( ( eol + 2 /* "\r\n" */ ) > end ) || ( eol[1] != '\n' ) )
+		return -EINVAL_REQUEST;
+	*pos = ( eol + 2 /* "\r\n" */ );
+
+	/* Stop at empty line */
+	if ( eol == line )
+		return 0;
+
+	/* Parse header */
+	if ( ( ! colon ) || ( colon == line ) )
+		return -EINVAL_REQUEST;
+	for ( tmp = line ; tmp < colon ; tmp++ )
+		*tmp = tolower ( *tmp );
+	header->name = line;
+	header->name_len = ( colon - line );
+	for ( tmp = ( colon + 1 ) ; ( tmp < eol ) && ( *tmp == ' ' ) ; tmp++ ){}
+	header->value = tmp;
+	header->value_len = ( eol - tmp );
+
+	return 1;
+}
+
+/**
+ * Check if request header must be excluded
+ *
+ * @v header		Header field
+ * @ret excluded	Header must not be sent
+ */
+static int http2_excluded_header ( struct hpack_header *header ) {
+	unsigned int i;
+
+	for ( i = 0 ; i < ( sizeof ( http2_excluded ) /
+			    sizeof ( http2_excluded[0] ) ) ; i++ ) {
+		if ( ( strlen ( http2_excluded[i] ) == header->name_len ) &&
+		     ( memcmp ( http2_excluded[i], header->name,
+				header->name_len ) == 0 ) )
+			return 1;
+	}
+	return 0;
+}
+
+/**
+ * Construct request header block
+ *
+ * @v h2		HTTP/2 connection
+ * @v request		HTTP/1.1 request headers
+ * @v end		End of HTTP/1.1 request headers
+ * @v data		Header block to fill in, or NULL
+ * @ret len		Length of header block, or negative error
+ */
+static int http2_request ( struct http2_connection *h2, char *request,
+			   char *end, void *data ) {
+	struct hpack_header header;
+	struct hpack_header method;
+	struct hpack_header path;
+	struct hpack_header authority;
+	char *pos = request;
+	char *space;
+	size_t len = 0;
+	int rc;
+
+	/* Parse request line */
+	method.name = ":method";
+	method.name_len = strlen ( method.name );
+	method.value = pos;
+	space = memchr ( pos, ' ', ( end - pos ) );
+	if ( ! space )
+		return -EINVAL_REQUEST;
+	method.value_len = ( space - pos );
+	pos = ( space + 1 );
+	path.name = ":path";
+	path.name_len = strlen ( path.name );
+	path.value = pos;
+	space = memchr ( pos, ' ', ( end - pos ) );
+	if ( ! space )
+		return -EINVAL_REQUEST;
+	path.value_len = ( space - pos );
+	pos = memchr ( space, '\n', ( end - space ) );
+	if ( ! pos )
+		return -EINVAL_REQUEST;
+	pos++;
+
+	/* Find authority (from the "Host" header) */
+	authority.name = ":authority";
+	authority.name_len = strlen ( authority.name );
+	authority.value = h2->uri->host;
+	authority.value_len = strlen ( h2->uri->host );
+	request = pos;
+	while ( ( rc = http2_request_header ( &pos, end, &header ) ) > 0 ) {
+		if ( ( header.name_len == 4 ) &&
+		     ( memcmp ( header.name, "host", 4 ) == 0 ) ) {
+			authority.value = header.value;
+			authority.value_len = header.value_len;
+		}
+		/* Request bodies generated on the fly (and sent using
+		 * the chunked transfer encoding) are not supported.
+		 */
+		if ( ( header.name_len == 17 ) &&
+		     ( memcmp ( header.name, "transfer-encoding", 17 ) == 0 )){
+			return -ENOTSUP;
+		}
+	}
+	if ( rc < 0 )
+		return rc;
+
+	/* Construct pseudo-header fields */
+	len += hpack_encode ( data, &method );
+	header.name = ":scheme";
+	header.name_len = strlen ( header.name );
+	header.value = h2->scheme->name;
+	header.value_len = strlen ( h2->scheme->name );
+	len += hpack_encode ( ( data ? ( data + len ) : NULL ), &header );
+	len += hpack_encode ( ( data ? ( data + len ) : NULL ), &path );
+	len += hpack_encode ( ( data ? ( data + len ) : NULL ), &authority );
+
+	/* Construct remaining header fields */
+	pos = request;
+	while ( ( rc = http2_request_header ( &pos, end, &header ) ) > 0 ) {
+		if ( http2_excluded_header ( &header ) )
+			continue;
+		len += hpack_encode ( ( data ? ( data + len ) : NULL ),
+				      &header );
+	}
+	if ( rc < 0 )
+		return rc;
+
+	return len;
+}
+
+/**
+ * Transmit header block
+ *
+ * @v h2		HTTP/2 connection
+ * @v id		Stream identifier
+ * @v flags		HEADERS frame flags
+ * @v data		Header block
+ * @v len		Length of header block
+ * @ret rc		Return status code
+ */
+static int http2_tx_headers ( struct http2_connection *h2, uint32_t id,
+			      unsigned int flags, const void *data,
+			      size_t len ) {
+	unsigned int type = HTTP2_HEADERS;
+	size_t frag_len;
+	int rc;
+
+	/* Split into HEADERS and CONTINUATION frames as needed */
+	do {
+		frag_len = len;
+		if ( frag_len > h2->peer.max_frame )
+			frag_len = h2->peer.max_frame;
+		if ( frag_len == len )
+			flags |= HTTP2_FL_END_HEADERS;
+		if ( ( rc = http2_tx ( h2, type, flags, id, data,
+				       frag_len ) ) != 0 )
+			return rc;
+		data += frag_len;
+		len -= frag_len;
+		type = HTTP2_CONTINUATION;
+		flags = 0;
+	} while ( len );
+
+	return 0;
+}
+
+/**
+ * Transmit request
+ *
+ * @v stream		HTTP/2 stream
+ * @v iobuf		I/O buffer
+ * @v meta		Data transfer metadata
+ * @ret rc		Return status code
+ *
+ * The request must comprise a complete HTTP/1.1 request (as
+ * constructed by the HTTP core), optionally followed by the request
+ * body.
+ */
+static int http2_stream_deliver ( struct http2_stream *stream,
+				  struct io_buffer *iobuf,
+				  struct xfer_metadata *meta __unused ) {
+	struct http2_connection *h2 = stream->h2;
+	char *request = iobuf->data;
+	char *end = ( iobuf->tail - 3 );
+	unsigned int flags;
+	void *block;
+	int len;
+	int rc;
+
+	/* Only a single request may be transmitted on each stream */
+	if ( stream->id || ( h2->flags & HTTP2_CONN_CLOSED ) ||
+	     ( h2->next_id > HTTP2_STREAM_MASK ) ) {
+		rc = -ENOTCONN;
+		goto err_state;
+	}
+
+	/* Locate end of request headers */
+	for ( ; request < end ; request++ ) {
+		if ( memcmp ( request, "\r\n\r\n", 4 ) == 0 )
+			break;
+	}
+	if ( request >= end ) {
+		DBGC ( h2, "HTTP2 %p incomplete request\n", h2 );
+		rc = -EINVAL_REQUEST;
+		goto err_end;
+	}
+	end = ( request + 4 /* "\r\n\r\n" */ );
+	request = iobuf->data;
+
+	/* Construct header block */
+	len = http2_request ( h2, request, end, NULL );
+	if ( len < 0 ) {
+		rc = len;
+		DBGC ( h2, "HTTP2 %p invalid request: %s\n",
+		       h2, strerror ( rc ) );
+		goto err_len;
+	}
+	block = malloc ( len );
+	if ( ! block ) {
+		rc = -ENOMEM;
+		goto err_alloc;
+	}
+	http2_request ( h2, request, end, block );
+	iob_pull ( iobuf, ( end - request ) );
+
+	/* Open stream */
+	stream->id = h2->next_id;
+	h2->next_id += 2;
+	h2->open++;
+	stream->tx_window = h2->peer.window;
+	DBGC2 ( h2, "HTTP2 %p stream %d opened\n", h2, stream->id );
+
+	/* Transmit header block */
+	flags = ( iob_len ( iobuf ) ? 0 : HTTP2_FL_END_STREAM );
+	if ( ( rc = http2_tx_headers ( h2, stream->id, flags, block,
+				       len ) ) != 0 )
+		goto err_tx;
+
+	/* Transmit request body, if any */
+	if ( iob_len ( iobuf ) ) {
+		stream->tx = iob_disown ( iobuf );
+		if ( ( rc = http2_stream_tx ( stream ) ) != 0 )
+			goto err_tx;
+	}
+
+ err_tx:
+	free ( block );
+ err_alloc:
+ err_len:
+ err_end:
+ err_state:
+	free_iob ( iobuf );
+	return rc;
+}
+
+/**
+ * Check flow control window
+ *
+ * @v stream		HTTP/2 stream
+ * @ret len		Length of window
+ */
+static size_t http2_stream_window ( struct http2_stream *stream ) {
+	struct http2_connection *h2 = stream->h2;
+
+	/* Allow a single request to be sent, once a stream is available */
+	if ( stream->id || ( ! http2_can_open ( h2 ) ) )
+		return 0;
+	return h2->peer.max_frame;
+}
+
+/** HTTP/2 stream data transfer interface operations */
+static struct interface_operation http2_stream_operations[] = {
+	INTF_OP ( xfer_deliver, struct http2_stream *, http2_stream_deliver ),
+	INTF_OP ( xfer_window, struct http2_stream *, http2_stream_window ),
+	INTF_OP ( intf_close, struct http2_stream *, http2_stream_close ),
+};
+
+/** HTTP/2 stream data transfer interface descriptor */
+static struct interface_descriptor http2_stream_desc =
+	INTF_DESC ( struct http2_stream, xfer, http2_stream_operations );
+
+/**
+ * Create HTTP/2 stream
+ *
+ * @v h2		HTTP/2 connection
+ * @v xfer		Data transfer interface
+ * @v flags		Initial stream flags
+ * @ret rc		Return status code
+ */
+static int http2_stream_create ( struct http2_connection *h2,
+				 struct interface *xfer, unsigned int flags ) {
+	struct http2_stream *stream;
+
+	/* Allocate and initialise structure */
+	stream = zalloc ( sizeof ( *stream ) );
+	if ( ! stream )
+		return -ENOMEM;
+	ref_init ( &stream->refcnt, http2_stream_free );
+	intf_init ( &stream->xfer, &http2_stream_desc, &stream->refcnt );
+	stream->h2 = h2;
+	ref_get ( &h2->refcnt );
+	stream->flags = flags;
+
+	/* Add to connection (which holds our reference) */
+	list_add_tail ( &stream->list, &h2->streams );
+	stop_timer ( &h2->timer );
+
+	/* Attach to parent interface and return */
+	intf_plug_plug ( &stream->xfer, xfer );
+	return 0;
+}
+
+/******************************************************************************
+ *
+ * Frame reception
+ *
+ ******************************************************************************
+ */
+
+/** An HTTP/2 response under construction */
+struct http2_response {
+	/** HTTP/2 connection */
+	struct http2_connection *h2;
+	/** Equivalent HTTP/1.1 response headers */
+	struct xfer_buffer headers;
+	/** Status code is informational */
+	int informational;
+	/** Status code has been seen */
+	int status;
+};
+
+/**
+ * Append to response headers
+ *
+ * @v response		HTTP/2 response
+ * @v data		Data
+ * @v len		Length of data
+ * @ret rc		Return status code
+ */
+static int http2_response_append ( struct http2_response *response,
+				   const void *data, size_t len ) {
+
+	return xferbuf_write ( &response->headers, response->headers.len,
+			       data, len );
+}
+
+/**
+ * Construct response header line
+ *
+ * @v ctx		HTTP/2 response
+ * @v header		Decoded header field
+ * @ret rc		Return status code
+ */
+static int http2_response_header ( void *ctx, struct hpack_header *header ) {
+	struct http2_response *response = ctx;
+	struct http2_connection *h2 = response->h2;
+	size_t i;
+	int rc;
+
+	/* Reject any header that could not be represented in HTTP/1.1 */
+	for ( i = 0 ; i < header->value_len ; i++ ) {
+		if ( ( header->value[i] == '\r' ) ||
+		     ( header->value[i] == '\n' ) ||
+		     ( header->value[i] == '\0' ) ) {
+			DBGC ( h2, "HTTP2 %p invalid header value\n", h2 );
+			return -EPROTO_HEADERS;
+		}
+	}
+
+	/* Construct status line from ":status" pseudo-header field */
+	if ( header->name_len && ( header->name[0] == ':' ) ) {
+		if ( ( header->name_len != 7 ) ||
+		     ( memcmp ( header->name, ":status", 7 ) != 0 ) ) {
+			/* Ignore any unknown pseudo-header fields */
+			return 0;
+		}
+		if ( response->status || ( header->value_len != 3 ) ) {
+			DBGC ( h2, "HTTP2 %p invalid status\n", h2 );
+			return -EPROTO_HEADERS;
+		}
+		response->status = 1;
+		response->informational = ( header->value[0] == '1' );
+		if ( ( rc = http2_response_append ( response, "HTTP/2 ",
+						    7 ) ) != 0 )
+			return rc;
+		if ( ( rc = http2_response_append ( response, header->value,
+						    header->value_len ) ) != 0 )
+			return rc;
+		return http2_response_append ( response, " \r\n", 3 );
+	}
+
+	/* Construct header line */
+	if ( ( rc = http2_response_append ( response, header->name,
+					    header->name_len ) ) != 0 )
+		return rc;
+	if ( ( rc = http2_response_append ( response, ": ", 2 ) ) != 0 )
+		return rc;
+	if ( ( rc = http2_response_append ( response, header->value,
+					    header->value_len ) ) != 0 )
+		return rc;
+	return http2_response_append ( response, "\r\n", 2 );
+}
+
+/**
+ * Handle received header block
+ *
+ * @v h2		HTTP/2 connection
+ * @v id		Stream identifier
+ * @v flags		HEADERS frame flags
+ * @v data		Header block
+ * @v len		Length of header block
+ * @ret rc		Return status code
+ */
+static int http2_rx_block ( struct http2_connection *h2, uint32_t id,
+			    unsigned int flags, const void *data,
+			    size_t len ) {
+	struct http2_response response;
+	struct http2_stream *stream;
+	struct io_buffer *iobuf;
+	int rc;
+
+	/* Decode header block.  This must be done even if the stream
+	 * no longer exists, in order to keep the dynamic table in
+	 * sync with the peer.
+	 */
+	memset ( &response, 0, sizeof ( response ) );
+	response.h2 = h2;
+	xferbuf_malloc_init ( &response.headers );
+	rc = hpack_decode ( &h2->hpack, data, len, http2_response_header,
+			    &response );
+	if ( rc == -EPROTO_HEADERS ) {
+		/* Malformed response: reset only this stream */
+		stream = http2_stream ( h2, id );
+		if ( stream )
+			http2_stream_close ( stream, rc );
+		rc = 0;
+		goto done;
+	}
+	if ( rc != 0 ) {
+		DBGC ( h2, "HTTP2 %p could not decode headers: %s\n",
+		       h2, strerror ( rc ) );
+		goto done;
+	}
+
+	/* Identify stream */
+	stream = http2_stream ( h2, id );
+	if ( ! stream )
+		goto done;
+
+	/* Record end of stream before passing on any data, so that
+	 * the stream is not reset if the consumer closes it.
+	 */
+	if ( flags & HTTP2_FL_END_STREAM )
+		stream->flags |= HTTP2_STREAM_END;
+
+	/* Pass response headers to data transfer interface.  Ignore
+	 * any informational responses and any trailing headers.
+	 */
+	if ( ( ! ( stream->flags & HTTP2_STREAM_RESPONSE ) ) &&
+	     response.status && ( ! response.informational ) ) {
+		stream->flags |= HTTP2_STREAM_RESPONSE;
+		if ( ( rc = http2_response_append ( &response, "\r\n",
+						    2 ) ) != 0 )
+			goto done;
+		iobuf = xfer_alloc_iob ( &stream->xfer, response.headers.len );
+		if ( ! iobuf ) {
+			rc = -ENOMEM;
+			goto done;
+		}
+		memcpy ( iob_put ( iobuf, response.headers.len ),
+			 response.headers.data, response.headers.len );
+		ref_get ( &stream->refcnt );
+		if ( ( rc = xfer_deliver_iob ( &stream->xfer,
+					       iob_disown ( iobuf ) ) ) != 0 ) {
+			http2_stream_close ( stream, rc );
+			rc = 0;
+		}
+		ref_put ( &stream->refcnt );
+	} else if ( ! ( stream->flags & HTTP2_STREAM_RESPONSE ) ) {
+		if ( ! response.status ) {
+			DBGC ( h2, "HTTP2 %p stream %d missing status\n",
+			       h2, id );
+			http2_stream_close ( stream, -EPROTO_HEADERS );
+			goto done;
+		}
+		/* Ignore informational response */
+		stream->flags &= ~HTTP2_STREAM_END;
+		goto done;
+	}
+
+	/* Close stream if ended */
+	if ( flags & HTTP2_FL_END_STREAM )
+		http2_stream_close ( stream, 0 );
+
+ done:
+	xferbuf_free ( &response.headers );
+	return rc;
+}
+
+/**
+ * Strip padding from frame payload
+ *
+ * @v h2		HTTP/2 connection
+ * @v flags		Frame flags
+ * @v iobuf		Frame payload
+ * @ret rc		Return status code
+ */
+static int http2_rx_padded ( struct http2_connection *h2, unsigned int flags,
+			     struct io_buffer *iobuf ) {
+	uint8_t *pad_len;
+
+	/* Do nothing unless frame is padded */
+	if ( ! ( flags & HTTP2_FL_PADDED ) )
+		return 0;
+
+	/* Strip padding */
+	if ( iob_len ( iobuf ) < sizeof ( *pad_len ) )
+		goto invalid;
+	pad_len = iobuf->data;
+	iob_pull ( iobuf, sizeof ( *pad_len ) );
+	if ( iob_len ( iobuf ) < *pad_len )
+		goto invalid;
+	iob_unput ( iobuf, *pad_len );
+
+	return 0;
+
+ invalid:
+	DBGC ( h2, "HTTP2 %p invalid padding\n", h2 );
+	return -EPROTO_FRAME;
+}
+
+/**
+ * Handle received DATA frame
+ *
+ * @v h2		HTTP/2 connection
+ * @v hdr		Frame header
+ * @v iobuf		Frame payload
+ * @ret rc		Return status code
+ */
+static int http2_rx_data ( struct http2_connection *h2,
+			   struct http2_frame_header *hdr,
+			   struct io_buffer *iobuf ) {
+	uint32_t id = ( ntohl ( hdr->stream ) & HTTP2_STREAM_MASK );
+	size_t len = iob_len ( iobuf );
+	struct http2_stream *stream;
+	int rc;
+
+	/* Sanity check */
+	if ( ! id ) {
+		rc = -EPROTO_FRAME;
+		goto err;
+	}
+
+	/* Update connection flow control window */
+	h2->rx_unacked += len;
+	if ( h2->rx_unacked >= ( HTTP2_WINDOW / 2 ) ) {
+		if ( ( rc = http2_tx_window_update ( h2, 0,
+						     h2->rx_unacked ) ) != 0 )
+			goto err;
+		h2->rx_unacked = 0;
+	}
+
+	/* Strip padding */
+	if ( ( rc = http2_rx_padded ( h2, hdr->flags, iobuf ) ) != 0 )
+		goto err;
+
+	/* Ignore data for unknown streams */
+	stream = http2_stream ( h2, id );
+	if ( ( ! stream ) || ( ! ( stream->flags & HTTP2_STREAM_RESPONSE ) ) ){
+		free_iob ( iobuf );
+		return 0;
+	}
+	ref_get ( &stream->refcnt );
+
+	/* Record end of stream, or update stream flow control window */
+	if ( hdr->flags & HTTP2_FL_END_STREAM ) {
+		stream->flags |= HTTP2_STREAM_END;
+	} else {
+		stream->rx_unacked += len;
+		if ( stream->rx_unacked >= ( HTTP2_WINDOW / 2 ) ) {
+			if ( ( rc = http2_tx_window_update ( h2, id,
+						stream->rx_unacked ) ) != 0 )
+				goto err_window;
+			stream->rx_unacked = 0;
+		}
+	}
+
+	/* Pass data to data transfer interface */
+	if ( iob_len ( iobuf ) &&
+	     ( ( rc = xfer_deliver_iob ( &stream->xfer,
+					 iob_disown ( iobuf ) ) ) != 0 ) ) {
+		http2_stream_close ( stream, rc );
+	}
+
+	/* Close stream if ended */
+	if ( hdr->flags & HTTP2_FL_END_STREAM )
+		http2_stream_close ( stream, 0 );
+
+	rc = 0;
+ err_window:
+	ref_put ( &stream->refcnt );
+ err:
+	free_iob ( iobuf );
+	return rc;
+}
+
+/**
+ * Handle received HEADERS frame
+ *
+ * @v h2		HTTP/2 connection
+ * @v hdr		Frame header
+ * @v iobuf		Frame payload
+ * @ret rc		Return status code
+ */
+static int http2_rx_headers ( struct http2_connection *h2,
+			      struct http2_frame_header *hdr,
+			      struct io_buffer *iobuf ) {
+	uint32_t id = ( ntohl ( hdr->stream ) & HTTP2_STREAM_MASK );
+	int rc;
+
+	/* Sanity check */
+	if ( ! id ) {
+		rc = -EPROTO_FRAME;
+		goto err;
+	}
+
+	/* Strip padding and priority */
+	if ( ( rc = http2_rx_padded ( h2, hdr->flags, iobuf ) ) != 0 )
+		goto err;
+	if ( hdr->flags & HTTP2_FL_PRIORITY ) {
+		if ( iob_len ( iobuf ) < HTTP2_PRIORITY_LEN ) {
+			rc = -EPROTO_FRAME;
+			goto err;
+		}
+		iob_pull ( iobuf, HTTP2_PRIORITY_LEN );
+	}
+
+	/* Handle complete header block, if applicable */
+	if ( hdr->flags & HTTP2_FL_END_HEADERS ) {
+		rc = http2_rx_block ( h2, id, hdr->flags, iobuf->data,
+				      iob_len ( iobuf ) );
+		goto err;
+	}
+
+	/* Otherwise, start reassembling header block */
+	h2->block_stream = id;
+	h2->block_flags = hdr->flags;
+	h2->block.len = 0;
+	rc = xferbuf_write ( &h2->block, 0, iobuf->data, iob_len ( iobuf ) );
+
+ err:
+	free_iob ( iobuf );
+	return rc;
+}
+
+/**
+ * Handle received CONTINUATION frame
+ *
+ * @v h2		HTTP/2 connection
+ * @v hdr		Frame header
+ * @v iobuf		Frame payload
+ * @ret rc		Return status code
+ */
+static int http2_rx_continuation ( struct http2_connection *h2,
+				   struct http2_frame_header *hdr,
+				   struct io_buffer *iobuf ) {
+	uint32_t id = ( ntohl ( hdr->stream ) & HTTP2_STREAM_MASK );
+	int rc;
+
+	/* Sanity check */
+	if ( ( ! h2->block_stream ) || ( id != h2->block_stream ) ) {
+		rc = -EPROTO_FRAME;
+		goto err;
+	}
+
+	/* Append to header block */
+	if ( ( rc = xferbuf_write ( &h2->block, h2->block.len, iobuf->data,
+				    iob_len ( iobuf ) ) ) != 0 )
+		goto err;
+
+	/* Handle complete header block, if applicable */
+	if ( hdr->flags & HTTP2_FL_END_HEADERS ) {
+		h2->block_stream = 0;
+		rc = http2_rx_block ( h2, id, h2->block_flags, h2->block.data,
+				      h2->block.len );
+		xferbuf_free ( &h2->block );
+	}
+
+ err:
+	free_iob ( iobuf );
+	return rc;
+}
+
+/**
+ * Handle received RST_STREAM frame
+ *
+ * @v h2		HTTP/2 connection
+ * @v hdr		Frame header
+ * @v iobuf		Frame payload
+ * @ret rc		Return status code
+ */
+static int http2_rx_rst_stream ( struct http2_connection *h2,
+				 struct http2_frame_header *hdr,
+				 struct io_buffer *iobuf ) {
+	uint32_t id = ( ntohl ( hdr->stream ) & HTTP2_STREAM_MASK );
+	struct http2_stream *stream;
+	uint32_t *error = iobuf->data;
+	int rc;
+
+	/* Sanity check */
+	if ( ( ! id ) || ( iob_len ( iobuf ) != sizeof ( *error ) ) ) {
+		rc = -EPROTO_FRAME;
+		goto err;
+	}
+
+	/* Close stream, if it exists */
+	stream = http2_stream ( h2, id );
+	if ( stream ) {
+		DBGC ( h2, "HTTP2 %p stream %d reset (error %d)\n",
+		       h2, id, ntohl ( *error ) );
+		stream->flags |= HTTP2_STREAM_END;
+		free_iob ( stream->tx );
+		stream->tx = NULL;
+		if ( ntohl ( *error ) == HTTP2_REFUSED_STREAM ) {
+			http2_stream_abort ( stream, -ECONNRESET_STREAM );
+		} else {
+			http2_stream_close ( stream, -ECONNRESET_STREAM );
+		}
+	}
+	rc = 0;
+
+ err:
+	free_iob ( iobuf );
+	return rc;
+}
+
+/**
+ * Handle received SETTINGS frame
+ *
+ * @v h2		HTTP/2 connection
+ * @v hdr		Frame header
+ * @v iobuf		Frame payload
+ * @ret rc		Return status code
+ */
+static int http2_rx_settings ( struct http2_connection *h2,
+			       struct http2_frame_header *hdr,
+			       struct io_buffer *iobuf ) {
+	const struct http2_setting *setting = iobuf->data;
+	struct http2_stream *stream;
+	size_t len = iob_len ( iobuf );
+	uint32_t value;
+	int32_t delta;
+	int rc;
+
+	/* Sanity check */
+	if ( hdr->stream || ( len % sizeof ( *setting ) ) ) {
+		rc = -EPROTO_FRAME;
+		goto err;
+	}
+
+	/* Ignore acknowledgements of our own settings */
+	if ( hdr->flags & HTTP2_FL_ACK ) {
+		rc = ( len ? -EPROTO_FRAME : 0 );
+		goto err;
+	}
+
+	/* Apply settings */
+	for ( ; len ; setting++, len -= sizeof ( *setting ) ) {
+		value = ntohl ( setting->value );
+		switch ( ntohs ( setting->id ) ) {
+		case HTTP2_SETTINGS_MAX_CONCURRENT_STREAMS :
+			if ( value > HTTP2_MAX_STREAMS )
+				value = HTTP2_MAX_STREAMS;
+			h2->peer.max_streams = value;
+			break;
+		case HTTP2_SETTINGS_INITIAL_WINDOW_SIZE :
+			if ( value > HTTP2_MAX_WINDOW ) {
+				rc = -EPROTO_FLOW;
+				goto err;
+			}
+			delta = ( value - h2->peer.window );
+			list_for_each_entry ( stream, &h2->streams, list )
+				stream->tx_window += delta;
+			h2->peer.window = value;
+			break;
+		case HTTP2_SETTINGS_MAX_FRAME_SIZE :
+			if ( ( value < HTTP2_DEFAULT_MAX_FRAME ) ||
+			     ( value > HTTP2_MAX_MAX_FRAME ) ) {
+				rc = -EPROTO_FRAME;
+				goto err;
+			}
+			h2->peer.max_frame = value;
+			break;
+		default:
+			/* Ignore other settings */
+			break;
+		}
+	}
+	DBGC2 ( h2, "HTTP2 %p peer allows %d streams, window %d, frame %d\n",
+		h2, h2->peer.max_streams, h2->peer.window,
+		h2->peer.max_frame );
+
+	/* Acknowledge settings */
+	if ( ( rc = http2_tx ( h2, HTTP2_SETTINGS, HTTP2_FL_ACK, 0,
+			       NULL, 0 ) ) != 0 )
+		goto err;
+
+	/* Allow waiting streams to proceed */
+	http2_schedule ( h2 );
+
+ err:
+	free_iob ( iobuf );
+	return rc;
+}
+
+/**
+ * Handle received PING frame
+ *
+ * @v h2		HTTP/2 connection
+ * @v hdr		Frame header
+ * @v iobuf		Frame payload
+ * @ret rc		Return status code
+ */
+static int http2_rx_ping ( struct http2_connection *h2,
+			   struct http2_frame_header *hdr,
+			   struct io_buffer *iobuf ) {
+	int rc;
+
+	/* Sanity check */
+	if ( hdr->stream || ( iob_len ( iobuf ) != 8 ) ) {
+		rc = -EPROTO_FRAME;
+		goto err;
+	}
+
+	/* Respond to ping, if applicable */
+	rc = 0;
+	if ( ! ( hdr->flags & HTTP2_FL_ACK ) ) {
+		rc = http2_tx ( h2, HTTP2_PING, HTTP2_FL_ACK, 0, iobuf->data,
+				iob_len ( iobuf ) );
+	}
+
+ err:
+	free_iob ( iobuf );
+	return rc;
+}
+
+/**
+ * Handle received GOAWAY frame
+ *
+ * @v h2		HTTP/2 connection
+ * @v hdr		Frame header
+ * @v iobuf		Frame payload
+ * @ret rc		Return status code
+ */
+static int http2_rx_goaway ( struct http2_connection *h2,
+			     struct http2_frame_header *hdr,
+			     struct io_buffer *iobuf ) {
+	struct http2_goaway *goaway = iobuf->data;
+	struct http2_stream *stream;
+	struct http2_stream *tmp;
+	uint32_t last;
+	int rc;
+
+	/* Sanity check */
+	if ( hdr->stream || ( iob_len ( iobuf ) < sizeof ( *goaway ) ) ) {
+		rc = -EPROTO_FRAME;
+		goto err;
+	}
+	last = ( ntohl ( goaway->last ) & HTTP2_STREAM_MASK );
+	DBGC ( h2, "HTTP2 %p going away after stream %d (error %d)\n",
+	       h2, last, ntohl ( goaway->error ) );
+
+	/* Prevent any new streams from using this connection */
+	h2->flags |= HTTP2_CONN_GOAWAY;
+	list_del ( &h2->list );
+	INIT_LIST_HEAD ( &h2->list );
+
+	/* Abort any streams that will never be processed.  Each is
+	 * removed from the list as it is aborted, so restart the
+	 * search after each abort.
+	 */
+	do {
+		list_for_each_entry_safe ( stream, tmp, &h2->streams, list ) {
+			if ( ( ! stream->id ) || ( stream->id > last ) )
+				break;
+		}
+		if ( &stream->list == &h2->streams )
+			break;
+		http2_stream_abort ( stream, -EPROTO_GOAWAY );
+	} while ( ! ( h2->flags & HTTP2_CONN_CLOSED ) );
+
+	/* Close connection if idle */
+	http2_schedule ( h2 );
+	rc = 0;
+
+ err:
+	free_iob ( iobuf );
+	return rc;
+}
+
+/**
+ * Handle received WINDOW_UPDATE frame
+ *
+ * @v h2		HTTP/2 connection
+ * @v hdr		Frame header
+ * @v iobuf		Frame payload
+ * @ret rc		Return status code
+ */
+static int http2_rx_window_update ( struct http2_connection *h2,
+				    struct http2_frame_header *hdr,
+				    struct io_buffer *iobuf ) {
+	uint32_t id = ( ntohl ( hdr->stream ) & HTTP2_STREAM_MASK );
+	uint32_t *payload = iobuf->data;
+	struct http2_stream *stream;
+	uint32_t increment;
+	int32_t *window;
+	int rc;
+
+	/* Sanity check */
+	if ( iob_len ( iobuf ) != sizeof ( *payload ) ) {
+		rc = -EPROTO_FRAME;
+		goto err;
+	}
+	increment = ( ntohl ( *payload ) & HTTP2_STREAM_MASK );
+
+	/* Identify window */
+	if ( id ) {
+		stream = http2_stream ( h2, id );
+		if ( ! stream ) {
+			rc = 0;
+			goto err;
+		}
+		window = &stream->tx_window;
+	} else {
+		window = &h2->tx_window;
+	}
+
+	/* Update window */
+	if ( ( ! increment ) ||
+	     ( ( *window > 0 ) &&
+	       ( increment > ( HTTP2_MAX_WINDOW - *window ) ) ) ) {
+		rc = -EPROTO_FLOW;
+		goto err;
+	}
+	*window += increment;
+
+	/* Allow waiting streams to proceed */
+	http2_schedule ( h2 );
+	rc = 0;
+
+ err:
+	free_iob ( iobuf );
+	return rc;
+}
+
+/**
+ * Handle received frame
+ *
+ * @v h2		HTTP/2 connection
+ * @v hdr		Frame header
+ * @v iobuf		Frame payload
+ * @ret rc		Return status code
+ */
+static int http2_rx_frame ( struct http2_connection *h2,
+			    struct http2_frame_header *hdr,
+			    struct io_buffer *iobuf ) {
+	unsigned int type = HTTP2_TYPE ( hdr->len_type );
+
+	/* A header block must not be interrupted by any other frame */
+	if ( h2->block_stream && ( type != HTTP2_CONTINUATION ) ) {
+		free_iob ( iobuf );
+		return -EPROTO_FRAME;
+	}
+
+	/* Handle frame */
+	switch ( type ) {
+	case HTTP2_DATA :
+		return http2_rx_data ( h2, hdr, iobuf );
+	case HTTP2_HEADERS :
+		return http2_rx_headers ( h2, hdr, iobuf );
+	case HTTP2_RST_STREAM :
+		return http2_rx_rst_stream ( h2, hdr, iobuf );
+	case HTTP2_SETTINGS :
+		return http2_rx_settings ( h2, hdr, iobuf );
+	case HTTP2_PING :
+		return http2_rx_ping ( h2, hdr, iobuf );
+	case HTTP2_GOAWAY :
+		return http2_rx_goaway ( h2, hdr, iobuf );
+	case HTTP2_WINDOW_UPDATE :
+		return http2_rx_window_update ( h2, hdr, iobuf );
+	case HTTP2_CONTINUATION :
+		return http2_rx_continuation ( h2, hdr, iobuf );
+	case HTTP2_PUSH_PROMISE :
+		/* Server push is disabled in our settings */
+		free_iob ( iobuf );
+		return -EPROTO_FRAME;
+	default:
+		/* Ignore PRIORITY and any unknown frames */
+		free_iob ( iobuf );
+		return 0;
+	}
+}
+
+/******************************************************************************
+ *
+ * Connections
+ *
+ ******************************************************************************
+ */
+
+/**
+ * Free HTTP/2 connection
+ *
+ * @v refcnt		Reference count
+ */
+static void http2_free ( struct refcnt *refcnt ) {
+	struct http2_connection *h2 =
+		container_of ( refcnt, struct http2_connection, refcnt );
+
+	free_iob ( h2->rx_payload );
+	xferbuf_free ( &h2->block );
+	hpack_flush ( &h2->hpack );
+	uri_put ( h2->uri );
+	free ( h2 );
+}
+
+/**
+ * Close HTTP/2 connection
+ *
+ * @v h2		HTTP/2 connection
+ * @v rc		Reason for close
+ */
+static void http2_close ( struct http2_connection *h2, int rc ) {
+	struct http2_stream *stream;
+
+	/* Do nothing if already closed */
+	if ( h2->flags & HTTP2_CONN_CLOSED )
+		return;
+	h2->flags |= ( HTTP2_CONN_CLOSED | HTTP2_CONN_GOAWAY );
+
+	/* Remove from list of connections */
+	list_del ( &h2->list );
+	INIT_LIST_HEAD ( &h2->list );
+
+	/* Stop timer and process */
+	stop_timer ( &h2->timer );
+	process_del ( &h2->process );
+
+	/* Shut down transport layer interface */
+	intf_shutdown ( &h2->socket, rc );
+
+	/* Abort all streams */
+	while ( ( stream = list_first_entry ( &h2->streams,
+					      struct http2_stream,
+					      list ) ) != NULL ) {
+		http2_stream_abort ( stream, rc );
+	}
+
+	if ( rc == 0 ) {
+		DBGC2 ( h2, "HTTP2 %p closed %s://%s\n",
+			h2, h2->scheme->name, h2->uri->host );
+	} else {
+		DBGC ( h2, "HTTP2 %p closed %s://%s: %s\n",
+		       h2, h2->scheme->name, h2->uri->host, strerror ( rc ) );
+	}
+}
+
+/**
+ * Terminate HTTP/2 connection due to an error
+ *
+ * @v h2		HTTP/2 connection
+ * @v rc		Reason for termination
+ */
+static void http2_terminate ( struct http2_connection *h2, int rc ) {
+	uint32_t error;
+
+	/* Notify peer, if possible */
+	if ( ! ( h2->flags & HTTP2_CONN_CLOSED ) ) {
+		error = ( ( rc == -EPROTO_FLOW ) ? HTTP2_FLOW_CONTROL_ERROR :
+			  ( rc == -EPROTO_FRAME ) ? HTTP2_PROTOCOL_ERROR :
+			  HTTP2_INTERNAL_ERROR );
+		http2_tx_goaway ( h2, error );
+	}
+
+	/* Close connection */
+	http2_close ( h2, rc );
+}
+
+/**
+ * Handle idle connection expiry
+ *
+ * @v timer		Idle connection expiry timer
+ * @v over		Failure indicator
+ */
+static void http2_expired ( struct retry_timer *timer, int over __unused ) {
+	struct http2_connection *h2 =
+		container_of ( timer, struct http2_connection, timer );
+
+	/* Close connection gracefully */
+	http2_tx_goaway ( h2, HTTP2_NO_ERROR );
+	http2_close ( h2, 0 );
+}
+
+/**
+ * Service HTTP/2 streams
+ *
+ * @v h2		HTTP/2 connection
+ */
+static void http2_step ( struct http2_connection *h2 ) {
+	struct http2_stream *stream;
+	int rc;
+
+	/* Service a single stream at a time, since servicing a
+	 * stream may modify the list of streams.
+	 */
+	list_for_each_entry ( stream, &h2->streams, list ) {
+
+		/* Notify stream that it may now be opened */
+		if ( stream->flags & HTTP2_STREAM_NOTIFY ) {
+			stream->flags &= ~HTTP2_STREAM_NOTIFY;
+			xfer_window_changed ( &stream->xfer );
+			return;
+		}
+
+		/* Transmit any pending request body */
+		if ( stream->flags & HTTP2_STREAM_TX_READY ) {
+			stream->flags &= ~HTTP2_STREAM_TX_READY;
+			if ( ( rc = http2_stream_tx ( stream ) ) != 0 )
+				http2_stream_close ( stream, rc );
+			return;
+		}
+	}
+
+	/* Nothing left to do */
+	process_del ( &h2->process );
+}
+
+/**
+ * Handle received data
+ *
+ * @v h2		HTTP/2 connection
+ * @v iobuf		I/O buffer
+ * @v meta		Data transfer metadata
+ * @ret rc		Return status code
+ */
+static int http2_socket_deliver ( struct http2_connection *h2,
+				  struct io_buffer *iobuf,
+				  struct xfer_metadata *meta __unused ) {
+	struct http2_frame_header *hdr = &h2->rx_hdr;
+	struct io_buffer *payload;
+	size_t frame_len;
+	size_t len;
+	int rc;
+
+	/* Process each (possibly partial) frame in turn */
+	while ( iob_len ( iobuf ) &&
+		! ( h2->flags & HTTP2_CONN_CLOSED ) ) {
+
+		/* Accumulate frame header */
+		if ( h2->rx_hdr_len < sizeof ( *hdr ) ) {
+			len = ( sizeof ( *hdr ) - h2->rx_hdr_len );
+			if ( len > iob_len ( iobuf ) )
+				len = iob_len ( iobuf );
+			memcpy ( ( ( ( void * ) hdr ) + h2->rx_hdr_len ),
+				 iobuf->data, len );
+			iob_pull ( iobuf, len );
+			h2->rx_hdr_len += len;
+			if ( h2->rx_hdr_len < sizeof ( *hdr ) )
+				break;
+
+			/* Allocate payload buffer */
+			frame_len = HTTP2_LEN ( hdr->len_type );
+			if ( frame_len > HTTP2_DEFAULT_MAX_FRAME ) {
+				DBGC ( h2, "HTTP2 %p oversized frame\n", h2 );
+				rc = -EPROTO_FRAME;
+				goto err;
+			}
+			assert ( h2->rx_payload == NULL );
+			h2->rx_payload = alloc_iob ( frame_len );
+			if ( ! h2->rx_payload ) {
+				rc = -ENOMEM;
+				goto err;
+			}
+		}
+
+		/* Accumulate frame payload */
+		payload = h2->rx_payload;
+		len = ( HTTP2_LEN ( hdr->len_type ) - iob_len ( payload ) );
+		if ( len > iob_len ( iobuf ) )
+			len = iob_len ( iobuf );
+		memcpy ( iob_put ( payload, len ), iobuf->data, len );
+		iob_pull ( iobuf, len );
+		if ( iob_len ( payload ) < HTTP2_LEN ( hdr->len_type ) )
+			break;
+
+		/* Handle complete frame */
+		h2->rx_payload = NULL;
+		h2->rx_hdr_len = 0;
+		if ( ( rc = http2_rx_frame ( h2, hdr, payload ) ) != 0 ) {
+			DBGC ( h2, "HTTP2 %p could not handle frame type %d: "
+			       "%s\n", h2, HTTP2_TYPE ( hdr->len_type ),
+			       strerror ( rc ) );
+			goto err;
+		}
+	}
+	free_iob ( iobuf );
+	return 0;
+
+ err:
+	free_iob ( iobuf );
+	http2_terminate ( h2, rc );
+	return rc;
+}
+
+/**
+ * Handle transport layer window change
+ *
+ * @v h2		HTTP/2 connection
+ */
+static void http2_socket_window_changed ( struct http2_connection *h2 ) {
+
+	/* Resume any streams waiting to transmit */
+	http2_schedule ( h2 );
+}
+
+/** HTTP/2 transport layer interface operations */
+static struct interface_operation http2_socket_operations[] = {
+	INTF_OP ( xfer_deliver, struct http2_connection *,
+		  http2_socket_deliver ),
+	INTF_OP ( xfer_window_changed, struct http2_connection *,
+		  http2_socket_window_changed ),
+	INTF_OP ( intf_close, struct http2_connection *, http2_close ),
+};
+
+/** HTTP/2 transport layer interface descriptor */
+static struct interface_descriptor http2_socket_desc =
+	INTF_DESC ( struct http2_connection, socket, http2_socket_operations );
+
+/** HTTP/2 stream servicing process descriptor */
+static struct process_descriptor http2_process_desc =
+	PROC_DESC ( struct http2_connection, process, http2_step );
+
+/**
+ * Get offered application protocols
+ *
+ * @v conn		HTTP connection
+ * @ret protocols	Offered protocols in wire format, or NULL
+ */
+const char * http2_offer ( struct http_connection *conn __unused ) {
+
+	return http2_alpn;
+}
+
+/**
+ * Upgrade connection to HTTP/2
+ *
+ * @v conn		HTTP connection
+ * @ret upgraded	Connection has been upgraded (or closed)
+ */
+int http2_upgrade ( struct http_connection *conn ) {
+	struct http2_connection *h2;
+	const char *protocol;
+	int rc;
+
+	/* Do nothing until the transport layer is ready */
+	if ( ! xfer_window ( &conn->socket ) )
+		return 0;
+
+	/* Do nothing unless HTTP/2 has been negotiated */
+	protocol = alpn_protocol ( &conn->socket );
+	if ( ( ! protocol ) || ( strcmp ( protocol, HTTP2_ALPN ) != 0 ) )
+		return 0;
+
+	/* Allocate and initialise structure */
+	h2 = zalloc ( sizeof ( *h2 ) );
+	if ( ! h2 ) {
+		rc = -ENOMEM;
+		goto err_alloc;
+	}
+	ref_init ( &h2->refcnt, http2_free );
+	h2->uri = uri_get ( conn->uri );
+	h2->scheme = conn->scheme;
+	h2->port = uri_port ( conn->uri, conn->scheme->port );
+	intf_init ( &h2->socket, &http2_socket_desc, &h2->refcnt );
+	process_init_stopped ( &h2->process, &http2_process_desc,
+			       &h2->refcnt );
+	timer_init ( &h2->timer, http2_expired, &h2->refcnt );
+	INIT_LIST_HEAD ( &h2->streams );
+	h2->next_id = 1;
+	h2->peer.max_streams = HTTP2_MAX_STREAMS;
+	h2->peer.window = HTTP2_DEFAULT_WINDOW;
+	h2->peer.max_frame = HTTP2_DEFAULT_MAX_FRAME;
+	h2->tx_window = HTTP2_DEFAULT_WINDOW;
+	xferbuf_malloc_init ( &h2->block );
+	hpack_init ( &h2->hpack, HPACK_DEFAULT_TABLE_SIZE );
+
+	/* Take over transport layer interface */
+	intf_plug_plug ( &h2->socket, conn->socket.dest );
+	intf_unplug ( &conn->socket );
+
+	/* Create stream for the waiting HTTP transaction */
+	if ( ( rc = http2_stream_create ( h2, conn->xfer.dest, 0 ) ) != 0 )
+		goto err_stream;
+	intf_unplug ( &conn->xfer );
+
+	/* Transmit connection preface */
+	if ( ( rc = http2_tx_preface ( h2 ) ) != 0 )
+		goto err_preface;
+
+	/* Add to list of connections, schedule stream, and return */
+	list_add ( &h2->list, &http2_connections );
+	http2_schedule ( h2 );
+	DBGC2 ( h2, "HTTP2 %p created %s://%s:%d\n",
+		h2, h2->scheme->name, h2->uri->host, h2->port );
+	ref_put ( &h2->refcnt );
+	return 1;
+
+ err_preface:
+ err_stream:
+	INIT_LIST_HEAD ( &h2->list );
+	http2_close ( h2, rc );
+	ref_put ( &h2->refcnt );
+ err_alloc:
+	DBGC ( conn, "HTTPCONN %p could not upgrade to HTTP/2: %s\n",
+	       conn, strerror ( rc ) );
+	intf_shutdown ( &conn->socket, rc );
+	intf_shutdown ( &conn->xfer, rc );
+	return 1;
+}
+
+/**
+ * Open stream on existing HTTP/2 connection
+ *
+ * @v xfer		Data transfer interface
+ * @v uri		Connection URI
+ * @v scheme		HTTP scheme
+ * @v port		Port number
+ * @ret rc		Return status code
+ */
+int http2_connect ( struct interface *xfer, struct uri *uri,
+		    struct http_scheme *scheme, unsigned int port ) {
+	struct http2_connection *h2;
+	int rc;
+
+	/* Look for a usable connection */
+	list_for_each_entry ( h2, &http2_connections, list ) {
+
+		/* Sanity check */
+		assert ( ! ( h2->flags & HTTP2_CONN_GOAWAY ) );
+
+		/* Use connection, if possible */
+		if ( ( scheme == h2->scheme ) &&
+		     ( strcmp ( uri->host, h2->uri->host ) == 0 ) &&
+		     ( port == h2->port ) &&
+		     ( h2->next_id <= HTTP2_STREAM_MASK ) ) {
+			if ( ( rc = http2_stream_create ( h2, xfer,
+						HTTP2_STREAM_REUSED ) ) != 0 )
+				return rc;
+			DBGC2 ( h2, "HTTP2 %p reused %s://%s:%d\n", h2,
+				h2->scheme->name, h2->uri->host, port );
+			return 0;
+		}
+	}
+
+	return -ENOTCONN;
+}
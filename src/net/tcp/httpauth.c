@@ -32,10 +32,233 @@ FILE_SECBOOT ( PERMITTED );
  */
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <strings.h>
 #include <errno.h>
+#include <ipxe/list.h>
+#include <ipxe/uri.h>
 #include <ipxe/http.h>
 
+/** Maximum number of cached authentication challenges */
+#define HTTP_AUTH_CACHE_MAX 8
+
+/** A cached HTTP authentication challenge
+ *
+ * Servers requiring authentication will typically challenge every
+ * request that does not include an "Authorization" header.  We
+ * record the most recent challenge for each origin, so that
+ * subsequent requests to the same origin can be authenticated
+ * preemptively without first incurring a failed request.
+ *
+ * Only the challenge is recorded.  Credentials are always obtained
+ * from the request URI.
+ */
+struct http_auth_cache {
+	/** List of cached challenges */
+	struct list_head list;
+	/** Authentication scheme */
+	struct http_authentication *auth;
+	/** Number of times challenge has been used */
+	unsigned int count;
+	/** Origin (URI scheme, host and port) */
+	char *origin;
+	/** Remaining "WWW-Authenticate" header line */
+	char *line;
+};
+
+/** Cached authentication challenges (most recently used first) */
+static LIST_HEAD ( http_auth_cache );
+
+/** Number of cached authentication challenges */
+static unsigned int http_auth_cache_count;
+
+/**
+ * Construct origin for authentication challenge cache
+ *
+ * @v http		HTTP transaction
+ * @v buf		Buffer
+ * @v len		Length of buffer
+ * @ret len		Length of origin
+ */
+static size_t http_auth_origin ( struct http_transaction *http, char *buf,
+				 size_t len ) {
+
+	return snprintf ( buf, len, "%s://%s", http->uri->scheme,
+			  http->request.host );
+}
+
+/**
+ * Find cached authentication challenge
+ *
+ * @v http		HTTP transaction
+ * @ret cache		Cached challenge, or NULL
+ */
+static struct http_auth_cache *
+http_auth_cache_find ( struct http_transaction *http ) {
+	struct http_auth_cache *cache;
+	char origin[ http_auth_origin ( http, NULL, 0 ) + 1 /* NUL */ ];
+
+	/* Construct origin */
+	http_auth_origin ( http, origin, sizeof ( origin ) );
+
+	/* Find matching cache entry */
+	list_for_each_entry ( cache, &http_auth_cache, list ) {
+		if ( strcmp ( cache->origin, origin ) == 0 ) {
+			/* Move to front of list */
+			list_del ( &cache->list );
+			list_add ( &cache->list, &http_auth_cache );
+			return cache;
+		}
+	}
+
+	return NULL;
+}
+
+/**
+ * Discard cached authentication challenge
+ *
+ * @v cache		Cached challenge
+ */
+static void http_auth_cache_free ( struct http_auth_cache *cache ) {
+
+	list_del ( &cache->list );
+	http_auth_cache_count--;
+	free ( cache );
+}
+
+/**
+ * Discard cached authentication challenge for an origin, if any
+ *
+ * @v http		HTTP transaction
+ */
+static void http_auth_forget ( struct http_transaction *http ) {
+	struct http_auth_cache *cache;
+
+	if ( ( cache = http_auth_cache_find ( http ) ) )
+		http_auth_cache_free ( cache );
+}
+
+/**
+ * Record authentication challenge
+ *
+ * @v http		HTTP transaction
+ * @v auth		Authentication scheme
+ * @v line		Remaining "WWW-Authenticate" header line
+ */
+static void http_auth_remember ( struct http_transaction *http,
+				 struct http_authentication *auth,
+				 const char *line ) {
+	struct http_auth_cache *cache;
+	size_t origin_len;
+	size_t line_len;
+
+	/* Discard any existing challenge for this origin */
+	http_auth_forget ( http );
+
+	/* Discard least recently used challenge, if necessary */
+	if ( http_auth_cache_count >= HTTP_AUTH_CACHE_MAX ) {
+		cache = list_last_entry ( &http_auth_cache,
+					  struct http_auth_cache, list );
+		http_auth_cache_free ( cache );
+	}
+
+	/* Allocate and populate cache entry */
+	origin_len = ( http_auth_origin ( http, NULL, 0 ) + 1 /* NUL */ );
+	line_len = ( strlen ( line ) + 1 /* NUL */ );
+	cache = zalloc ( sizeof ( *cache ) + origin_len + line_len );
+	if ( ! cache )
+		return;
+	cache->origin = ( ( ( void * ) cache ) + sizeof ( *cache ) );
+	cache->line = ( cache->origin + origin_len );
+	http_auth_origin ( http, cache->origin, origin_len );
+	memcpy ( cache->line, line, line_len );
+	cache->auth = auth;
+	cache->count = 1;
+
+	/* Add to cache */
+	list_add ( &cache->list, &http_auth_cache );
+	http_auth_cache_count++;
+	DBGC2 ( http, "HTTP %p cached %s challenge for %s\n",
+		http, auth->name, cache->origin );
+}
+
+/**
+ * Parse cached challenge used for preemptive authentication
+ *
+ * @v http		HTTP transaction
+ * @ret rc		Return status code
+ *
+ * The response authentication descriptor is reset whenever a request
+ * is sent, so the (unmodified) cached challenge is copied and parsed
+ * afresh whenever the "Authorization" header is constructed.
+ */
+static int http_auth_preempt_parse ( struct http_transaction *http ) {
+	struct http_request_auth *req = &http->request.auth;
+	size_t len = ( strlen ( req->preempt ) + 1 /* NUL */ );
+	char *line = ( req->preempt + len );
+
+	/* Parse scratch copy of challenge */
+	memcpy ( line, req->preempt, len );
+	http->response.auth.auth = req->auth;
+	return req->auth->parse ( http, line );
+}
+
+/**
+ * Authenticate preemptively using a cached challenge, if available
+ *
+ * @v http		HTTP transaction
+ */
+static void http_auth_preempt ( struct http_transaction *http ) {
+	struct http_request_auth *req = &http->request.auth;
+	struct http_authentication *auth;
+	struct http_auth_cache *cache;
+	size_t len;
+	int rc;
+
+	/* Find cached challenge, if any */
+	cache = http_auth_cache_find ( http );
+	if ( ! cache )
+		return;
+	auth = cache->auth;
+
+	/* Take a private copy of the cached challenge, with space
+	 * for a scratch copy to be parsed.  Recording the scheme
+	 * before parsing ensures that the parser does not mark the
+	 * (not yet received) response as retryable.
+	 */
+	len = ( strlen ( cache->line ) + 1 /* NUL */ );
+	req->preempt = malloc ( len * 2 );
+	if ( ! req->preempt )
+		goto err_alloc;
+	memcpy ( req->preempt, cache->line, len );
+	req->auth = auth;
+	req->count = ( cache->count + 1 );
+	if ( ( rc = http_auth_preempt_parse ( http ) ) != 0 )
+		goto err_parse;
+
+	/* Perform authentication */
+	if ( ( rc = auth->authenticate ( http ) ) != 0 )
+		goto err_authenticate;
+
+	/* Record use of challenge */
+	cache->count = req->count;
+	DBGC2 ( http, "HTTP %p performing preemptive %s authentication\n",
+		http, auth->name );
+
+	return;
+
+ err_authenticate:
+ err_parse:
+	memset ( &http->response.auth, 0, sizeof ( http->response.auth ) );
+	free ( req->preempt );
+	req->preempt = NULL;
+	req->auth = NULL;
+	req->count = 0;
+ err_alloc:
+	return;
+}
+
 /**
  * Identify authentication scheme
  *
@@ -64,10 +287,26 @@ static struct http_authentication * http_authentication ( const char *name ) {
  */
 static int http_parse_www_authenticate ( struct http_transaction *http,
 					 char *line ) {
+	struct http_request_auth *req = &http->request.auth;
 	struct http_authentication *auth;
 	char *name;
 	int rc;
 
+	/* A challenge in response to preemptive authentication
+	 * indicates that the cached challenge is no longer valid
+	 * (e.g. an expired Digest nonce).  Discard it, and treat
+	 * this as a fresh challenge.
+	 */
+	if ( req->preempt ) {
+		DBGC ( http, "HTTP %p preemptive %s authentication "
+		       "rejected\n", http, req->auth->name );
+		http_auth_forget ( http );
+		free ( req->preempt );
+		req->preempt = NULL;
+		req->auth = NULL;
+		req->count = 0;
+	}
+
 	/* Get scheme name */
 	name = http_token ( &line, NULL );
 	if ( ! name ) {
@@ -90,6 +329,13 @@ static int http_parse_www_authenticate ( struct http_transaction *http,
 		return 0;
 	http->response.auth.auth = auth;
 
+	/* Record challenge for use by subsequent requests, if
+	 * applicable.  This must happen before parsing, since the
+	 * parser may modify the header line.
+	 */
+	if ( auth->preemptive )
+		http_auth_remember ( http, auth, line );
+
 	/* Parse remaining header line */
 	if ( ( rc = auth->parse ( http, line ) ) != 0 ) {
 		DBGC ( http, "HTTP %p could not parse %s WWW-Authenticate "
@@ -122,6 +368,16 @@ static int http_format_authorization ( struct http_transaction *http,
 	int auth_len;
 	int rc;
 
+	/* Authenticate preemptively, if applicable */
+	if ( ! auth ) {
+		http_auth_preempt ( http );
+		auth = http->request.auth.auth;
+	} else if ( http->request.auth.preempt &&
+		    ( ! http->response.auth.auth ) &&
+		    ( ( rc = http_auth_preempt_parse ( http ) ) != 0 ) ) {
+		return rc;
+	}
+
 	/* Do nothing unless we have an authentication scheme */
 	if ( ! auth )
 		return 0;
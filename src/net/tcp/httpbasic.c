@@ -116,6 +116,7 @@ struct http_authentication http_basic_auth __http_authentication = {
 	.parse = http_parse_basic_auth,
 	.authenticate = http_basic_authenticate,
 	.format = http_format_basic_auth,
+	.preemptive = 1,
 };
 
 /* Drag in HTTP authentication support */
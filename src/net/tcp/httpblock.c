@@ -29,20 +29,579 @@ FILE_SECBOOT ( PERMITTED );
  *
  * Hyper Text Transfer Protocol (HTTP) block device
  *
+ * Each block read is satisfied by a range request.  Individual range
+ * requests are inherently sequential (since the SAN device issues
+ * only a single command at a time), and so would otherwise incur a
+ * full round trip per read.  Sequential reads are therefore
+ * satisfied from a small number of large read-ahead windows, with
+ * the window following the one currently being read being fetched
+ * concurrently (via a separate pooled connection) in order to keep
+ * the network pipe full.  Non-sequential reads bypass the read-ahead
+ * windows, to avoid fetching unwanted data.
+ *
+ * If the "san-mirror" setting is enabled, the whole image is also
+ * fetched sequentially into memory in the background.  Reads that
+ * fall within the region fetched so far are satisfied from memory,
+ * and all other reads proceed as above.
+ *
  */
 
 #include <stdint.h>
+#include <stdlib.h>
 #include <string.h>
+#include <errno.h>
+#include <ipxe/uri.h>
+#include <ipxe/xfer.h>
+#include <ipxe/xferbuf.h>
+#include <ipxe/umalloc.h>
+#include <ipxe/process.h>
 #include <ipxe/blocktrans.h>
 #include <ipxe/blockdev.h>
 #include <ipxe/acpi.h>
+#include <ipxe/settings.h>
 #include <ipxe/http.h>
 
 /** Block size used for HTTP block device requests */
 #define HTTP_BLKSIZE 512
 
+/** Number of read-ahead windows */
+#define HTTP_READAHEAD_WINDOWS 2
+
+/** Number of blocks within each read-ahead window */
+#define HTTP_READAHEAD_BLOCKS 512
+
+/** An HTTP block device read-ahead window */
+struct http_block_window {
+	/** Read-ahead cache */
+	struct http_block_cache *cache;
+	/** Data transfer interface */
+	struct interface xfer;
+	/** Data transfer buffer */
+	struct xfer_buffer xferbuf;
+	/** Data buffer */
+	void *data;
+	/** Starting logical block address */
+	uint64_t lba;
+	/** Number of logical blocks (or zero if unused) */
+	unsigned int count;
+	/** Window status (or -EINPROGRESS while being fetched) */
+	int rc;
+};
+
+/** An HTTP block device background mirror */
+struct http_block_mirror {
+	/** Read-ahead cache */
+	struct http_block_cache *cache;
+	/** Data transfer interface */
+	struct interface xfer;
+	/** Data transfer buffer
+	 *
+	 * The buffer position marks the end of the contiguous region
+	 * fetched so far.
+	 */
+	struct xfer_buffer xferbuf;
+};
+
+/** An HTTP block device read-ahead cache */
+struct http_block_cache {
+	/** Reference count */
+	struct refcnt refcnt;
+	/** Request URI */
+	struct uri *uri;
+	/** Block data interface for pending read */
+	struct interface block;
+	/** Read completion process */
+	struct process process;
+	/** Window satisfying pending read, or NULL if idle */
+	struct http_block_window *window;
+	/** Starting logical block address of pending read */
+	uint64_t lba;
+	/** Number of logical blocks in pending read */
+	unsigned int count;
+	/** Data buffer for pending read */
+	void *buffer;
+	/** Pending read has been satisfied from background mirror */
+	int mirrored;
+	/** Logical block address following most recent read */
+	uint64_t next;
+	/** Read-ahead windows */
+	struct http_block_window windows[HTTP_READAHEAD_WINDOWS];
+	/** Background mirror */
+	struct http_block_mirror mirror;
+};
+
+/** The "san-mirror" setting */
+const struct setting san_mirror_setting __setting ( SETTING_SANBOOT_EXTRA,
+						    san-mirror ) = {
+	.name = "san-mirror",
+	.description = "Fetch whole HTTP SAN image in background",
+	.type = &setting_type_int8,
+};
+
 /**
- * Read from block device
+ * Free read-ahead cache
+ *
+ * @v refcnt		Reference count
+ */
+static void http_block_free ( struct refcnt *refcnt ) {
+	struct http_block_cache *cache =
+		container_of ( refcnt, struct http_block_cache, refcnt );
+	unsigned int i;
+
+	for ( i = 0 ; i < HTTP_READAHEAD_WINDOWS ; i++ )
+		ufree ( cache->windows[i].data );
+	xferbuf_free ( &cache->mirror.xferbuf );
+	uri_put ( cache->uri );
+	free ( cache );
+}
+
+/**
+ * Check if read-ahead window contains a block range
+ *
+ * @v window		Read-ahead window
+ * @v lba		Starting logical block address
+ * @v count		Number of logical blocks
+ * @ret contains	Window contains (or will contain) the block range
+ */
+static int http_block_contains ( struct http_block_window *window,
+				 uint64_t lba, unsigned int count ) {
+
+	return ( ( ( window->rc == 0 ) || ( window->rc == -EINPROGRESS ) ) &&
+		 ( lba >= window->lba ) &&
+		 ( ( lba + count ) <= ( window->lba + window->count ) ) );
+}
+
+/**
+ * Check if background mirror contains a block range
+ *
+ * @v mirror		Background mirror
+ * @v lba		Starting logical block address
+ * @v count		Number of logical blocks
+ * @ret contains	Mirror contains the block range
+ */
+static int http_block_mirrored ( struct http_block_mirror *mirror,
+				 uint64_t lba, unsigned int count ) {
+
+	return ( ( lba + count ) <= ( mirror->xferbuf.pos / HTTP_BLKSIZE ) );
+}
+
+/**
+ * Complete pending read
+ *
+ * @v cache		Read-ahead cache
+ */
+static void http_block_complete ( struct http_block_cache *cache ) {
+	struct http_block_window *window = cache->window;
+	int rc = window->rc;
+
+	/* Copy out data, if available */
+	if ( rc == 0 ) {
+		if ( http_block_contains ( window, cache->lba, cache->count ) ){
+			memcpy ( cache->buffer,
+				 ( window->data + ( ( cache->lba - window->lba )
+						    * HTTP_BLKSIZE ) ),
+				 ( cache->count * HTTP_BLKSIZE ) );
+		} else {
+			DBGC ( cache, "HTTP %p short window [%#llx,%#llx) "
+			       "for read [%#llx,%#llx)\n", cache,
+			       ( ( unsigned long long ) window->lba ),
+			       ( ( unsigned long long )
+				 ( window->lba + window->count ) ),
+			       ( ( unsigned long long ) cache->lba ),
+			       ( ( unsigned long long )
+				 ( cache->lba + cache->count ) ) );
+			rc = -ERANGE;
+		}
+	}
+
+	/* Complete read */
+	process_del ( &cache->process );
+	cache->window = NULL;
+	intf_restart ( &cache->block, rc );
+}
+
+/**
+ * Abort pending read
+ *
+ * @v cache		Read-ahead cache
+ * @v rc		Reason for close
+ */
+static void http_block_abort ( struct http_block_cache *cache, int rc ) {
+
+	/* Abandon pending read (leaving window fetch in progress) */
+	process_del ( &cache->process );
+	cache->window = NULL;
+	cache->mirrored = 0;
+	intf_restart ( &cache->block, rc );
+}
+
+/**
+ * Read completion process
+ *
+ * @v cache		Read-ahead cache
+ */
+static void http_block_step ( struct http_block_cache *cache ) {
+
+	/* Complete pending read, if already satisfied from mirror */
+	if ( cache->mirrored ) {
+		process_del ( &cache->process );
+		cache->mirrored = 0;
+		intf_restart ( &cache->block, 0 );
+		return;
+	}
+
+	/* Complete pending read, if window is no longer being fetched */
+	if ( cache->window && ( cache->window->rc != -EINPROGRESS ) )
+		http_block_complete ( cache );
+}
+
+/**
+ * Start fetching read-ahead window
+ *
+ * @v window		Read-ahead window
+ * @v lba		Starting logical block address
+ * @ret rc		Return status code
+ */
+static int http_block_fetch ( struct http_block_window *window,
+			      uint64_t lba ) {
+	struct http_block_cache *cache = window->cache;
+	struct http_request_range range;
+	size_t len = ( HTTP_READAHEAD_BLOCKS * HTTP_BLKSIZE );
+	int rc;
+
+	/* Allocate data buffer, if applicable */
+	if ( ! window->data ) {
+		window->data = umalloc ( len );
+		if ( ! window->data )
+			return -ENOMEM;
+	}
+
+	/* Start a range request to retrieve the window */
+	range.start = ( lba * HTTP_BLKSIZE );
+	range.len = len;
+	if ( ( rc = http_open ( &window->xfer, &http_get, cache->uri, &range,
+				NULL ) ) != 0 ) {
+		DBGC ( cache, "HTTP %p could not fetch window: %s\n",
+		       cache, strerror ( rc ) );
+		return rc;
+	}
+	DBGC2 ( cache, "HTTP %p window %d fetching [%#llx,%#llx)\n",
+		cache, ( ( unsigned int ) ( window - cache->windows ) ),
+		( ( unsigned long long ) lba ),
+		( ( unsigned long long ) ( lba + HTTP_READAHEAD_BLOCKS ) ) );
+
+	/* Record window */
+	xferbuf_fixed_init ( &window->xferbuf, window->data, len );
+	window->xferbuf.pos = 0;
+	window->lba = lba;
+	window->count = HTTP_READAHEAD_BLOCKS;
+	window->rc = -EINPROGRESS;
+
+	return 0;
+}
+
+/**
+ * Prefetch read-ahead window following a window being read
+ *
+ * @v window		Read-ahead window being read
+ */
+static void http_block_prefetch ( struct http_block_window *window ) {
+	struct http_block_cache *cache = window->cache;
+	struct http_block_window *other;
+	struct http_block_window *victim = NULL;
+	uint64_t next = ( window->lba + window->count );
+	unsigned int i;
+
+	/* Do nothing if window ends short (i.e. at the end of the disk) */
+	if ( window->count < HTTP_READAHEAD_BLOCKS )
+		return;
+
+	/* Do nothing if following window is already present (or has
+	 * already failed), otherwise choose an idle window to reuse.
+	 */
+	for ( i = 0 ; i < HTTP_READAHEAD_WINDOWS ; i++ ) {
+		other = &cache->windows[i];
+		if ( other->count && ( other->lba == next ) )
+			return;
+		if ( ( other != window ) && ( other->rc != -EINPROGRESS ) )
+			victim = other;
+	}
+	if ( ! victim )
+		return;
+
+	/* Start fetching following window (ignoring errors, since
+	 * this is only speculative).
+	 */
+	http_block_fetch ( victim, next );
+}
+
+/**
+ * Close read-ahead window data transfer interface
+ *
+ * @v window		Read-ahead window
+ * @v rc		Reason for close
+ */
+static void http_block_window_close ( struct http_block_window *window,
+				      int rc ) {
+	struct http_block_cache *cache = window->cache;
+
+	/* Restart data transfer interface */
+	intf_restart ( &window->xfer, rc );
+
+	/* Record window status and length */
+	if ( rc == 0 ) {
+		window->count = ( window->xferbuf.pos / HTTP_BLKSIZE );
+	} else {
+		DBGC ( cache, "HTTP %p window [%#llx,%#llx) failed: %s\n",
+		       cache, ( ( unsigned long long ) window->lba ),
+		       ( ( unsigned long long )
+			 ( window->lba + window->count ) ), strerror ( rc ) );
+	}
+	window->rc = rc;
+
+	/* Complete pending read, if applicable */
+	if ( cache->window == window )
+		http_block_complete ( cache );
+}
+
+/**
+ * Receive read-ahead window data
+ *
+ * @v window		Read-ahead window
+ * @v iobuf		I/O buffer
+ * @v meta		Data transfer metadata
+ * @ret rc		Return status code
+ */
+static int http_block_window_deliver ( struct http_block_window *window,
+				       struct io_buffer *iobuf,
+				       struct xfer_metadata *meta ) {
+	int rc;
+
+	/* Deliver to buffer */
+	if ( ( rc = xferbuf_deliver ( &window->xferbuf, iob_disown ( iobuf ),
+				      meta ) ) != 0 ) {
+		http_block_window_close ( window, rc );
+		return rc;
+	}
+
+	return 0;
+}
+
+/**
+ * Get read-ahead window data transfer buffer
+ *
+ * @v window		Read-ahead window
+ * @ret xferbuf		Data transfer buffer
+ */
+static struct xfer_buffer *
+http_block_window_buffer ( struct http_block_window *window ) {
+
+	return &window->xferbuf;
+}
+
+/** Read-ahead window data transfer interface operations */
+static struct interface_operation http_block_window_operations[] = {
+	INTF_OP ( xfer_deliver, struct http_block_window *,
+		  http_block_window_deliver ),
+	INTF_OP ( xfer_buffer, struct http_block_window *,
+		  http_block_window_buffer ),
+	INTF_OP ( intf_close, struct http_block_window *,
+		  http_block_window_close ),
+};
+
+/** Read-ahead window data transfer interface descriptor */
+static struct interface_descriptor http_block_window_desc =
+	INTF_DESC ( struct http_block_window, xfer,
+		    http_block_window_operations );
+
+/**
+ * Close background mirror data transfer interface
+ *
+ * @v mirror		Background mirror
+ * @v rc		Reason for close
+ */
+static void http_block_mirror_close ( struct http_block_mirror *mirror,
+				      int rc ) {
+	struct http_block_cache *cache = mirror->cache;
+
+	/* Restart data transfer interface */
+	intf_restart ( &mirror->xfer, rc );
+
+	/* Record status.  Any data already fetched remains usable. */
+	if ( rc == 0 ) {
+		DBGC ( cache, "HTTP %p mirror complete (%#zx bytes)\n",
+		       cache, mirror->xferbuf.pos );
+	} else {
+		DBGC ( cache, "HTTP %p mirror failed after %#zx bytes: %s\n",
+		       cache, mirror->xferbuf.pos, strerror ( rc ) );
+	}
+}
+
+/**
+ * Receive background mirror data
+ *
+ * @v mirror		Background mirror
+ * @v iobuf		I/O buffer
+ * @v meta		Data transfer metadata
+ * @ret rc		Return status code
+ */
+static int http_block_mirror_deliver ( struct http_block_mirror *mirror,
+				       struct io_buffer *iobuf,
+				       struct xfer_metadata *meta ) {
+	int rc;
+
+	/* Deliver to buffer */
+	if ( ( rc = xferbuf_deliver ( &mirror->xferbuf, iob_disown ( iobuf ),
+				      meta ) ) != 0 ) {
+		http_block_mirror_close ( mirror, rc );
+		return rc;
+	}
+
+	return 0;
+}
+
+/**
+ * Get background mirror data transfer buffer
+ *
+ * @v mirror		Background mirror
+ * @ret xferbuf		Data transfer buffer
+ */
+static struct xfer_buffer *
+http_block_mirror_buffer ( struct http_block_mirror *mirror ) {
+
+	return &mirror->xferbuf;
+}
+
+/** Background mirror data transfer interface operations */
+static struct interface_operation http_block_mirror_operations[] = {
+	INTF_OP ( xfer_deliver, struct http_block_mirror *,
+		  http_block_mirror_deliver ),
+	INTF_OP ( xfer_buffer, struct http_block_mirror *,
+		  http_block_mirror_buffer ),
+	INTF_OP ( intf_close, struct http_block_mirror *,
+		  http_block_mirror_close ),
+};
+
+/** Background mirror data transfer interface descriptor */
+static struct interface_descriptor http_block_mirror_desc =
+	INTF_DESC ( struct http_block_mirror, xfer,
+		    http_block_mirror_operations );
+
+/**
+ * Start background mirror, if enabled
+ *
+ * @v cache		Read-ahead cache
+ */
+static void http_block_mirror_start ( struct http_block_cache *cache ) {
+	struct http_block_mirror *mirror = &cache->mirror;
+	int rc;
+
+	/* Do nothing unless explicitly enabled */
+	if ( fetch_intz_setting ( NULL, &san_mirror_setting ) <= 0 )
+		return;
+
+	/* Start a request for the whole image.  Failure is not an
+	 * error, since all reads can still be satisfied from the
+	 * network.
+	 */
+	if ( ( rc = http_open ( &mirror->xfer, &http_get, cache->uri, NULL,
+				NULL ) ) != 0 ) {
+		DBGC ( cache, "HTTP %p could not start mirror: %s\n",
+		       cache, strerror ( rc ) );
+		return;
+	}
+	DBGC ( cache, "HTTP %p mirroring in background\n", cache );
+}
+
+/** Read-ahead cache block data interface operations */
+static struct interface_operation http_block_cache_operations[] = {
+	INTF_OP ( intf_close, struct http_block_cache *, http_block_abort ),
+};
+
+/** Read-ahead cache block data interface descriptor */
+static struct interface_descriptor http_block_cache_desc =
+	INTF_DESC ( struct http_block_cache, block,
+		    http_block_cache_operations );
+
+/** Read completion process descriptor */
+static struct process_descriptor http_block_process_desc =
+	PROC_DESC_ONCE ( struct http_block_cache, process, http_block_step );
+
+/**
+ * Get read-ahead cache
+ *
+ * @v http		HTTP transaction
+ * @ret cache		Read-ahead cache, or NULL on error
+ */
+static struct http_block_cache *
+http_block_cache ( struct http_transaction *http ) {
+	struct http_block_cache *cache;
+	struct http_block_window *window;
+	unsigned int i;
+
+	/* Use existing cache, if any */
+	if ( http->cache )
+		return http->cache;
+
+	/* Allocate and initialise structure */
+	cache = zalloc ( sizeof ( *cache ) );
+	if ( ! cache )
+		return NULL;
+	ref_init ( &cache->refcnt, http_block_free );
+	intf_init ( &cache->block, &http_block_cache_desc, &cache->refcnt );
+	process_init_stopped ( &cache->process, &http_block_process_desc,
+			       &cache->refcnt );
+	cache->uri = uri_get ( http->uri );
+	for ( i = 0 ; i < HTTP_READAHEAD_WINDOWS ; i++ ) {
+		window = &cache->windows[i];
+		window->cache = cache;
+		intf_init ( &window->xfer, &http_block_window_desc,
+			    &cache->refcnt );
+	}
+	cache->mirror.cache = cache;
+	intf_init ( &cache->mirror.xfer, &http_block_mirror_desc,
+		    &cache->refcnt );
+	xferbuf_umalloc_init ( &cache->mirror.xferbuf );
+
+	/* Start background mirror, if enabled */
+	http_block_mirror_start ( cache );
+
+	/* Attach to HTTP transaction (which holds our reference) */
+	http->cache = cache;
+	return cache;
+}
+
+/**
+ * Close read-ahead cache
+ *
+ * @v http		HTTP transaction
+ * @v rc		Reason for close
+ */
+void http_block_close ( struct http_transaction *http, int rc ) {
+	struct http_block_cache *cache = http->cache;
+	unsigned int i;
+
+	/* Do nothing unless a cache exists */
+	if ( ! cache )
+		return;
+
+	/* Shut down pending read, all read-ahead windows, and mirror */
+	process_del ( &cache->process );
+	cache->window = NULL;
+	cache->mirrored = 0;
+	intf_shutdown ( &cache->block, rc );
+	for ( i = 0 ; i < HTTP_READAHEAD_WINDOWS ; i++ )
+		intf_shutdown ( &cache->windows[i].xfer, rc );
+	intf_shutdown ( &cache->mirror.xfer, rc );
+
+	/* Detach from HTTP transaction */
+	http->cache = NULL;
+	ref_put ( &cache->refcnt );
+}
+
+
+/**
+ * Read from block device without read-ahead
  *
  * @v http		HTTP transaction
  * @v data		Data interface
@@ -52,9 +611,10 @@ FILE_SECBOOT ( PERMITTED );
  * @v len		Length of data buffer
  * @ret rc		Return status code
  */
-int http_block_read ( struct http_transaction *http, struct interface *data,
-		      uint64_t lba, unsigned int count, void *buffer,
-		      size_t len ) {
+static int http_block_read_direct ( struct http_transaction *http,
+				   struct interface *data, uint64_t lba,
+				   unsigned int count, void *buffer,
+				   size_t len ) {
 	struct http_request_range range;
 	int rc;
 
@@ -85,6 +645,99 @@ int http_block_read ( struct http_transaction *http, struct interface *data,
 	return rc;
 }
 
+/**
+ * Read from block device
+ *
+ * @v http		HTTP transaction
+ * @v data		Data interface
+ * @v lba		Starting logical block address
+ * @v count		Number of logical blocks
+ * @v buffer		Data buffer
+ * @v len		Length of data buffer
+ * @ret rc		Return status code
+ */
+int http_block_read ( struct http_transaction *http, struct interface *data,
+		      uint64_t lba, unsigned int count, void *buffer,
+		      size_t len ) {
+	struct http_block_cache *cache;
+	struct http_block_window *window = NULL;
+	struct http_block_window *candidate;
+	int sequential;
+	unsigned int i;
+
+	/* Sanity check */
+	assert ( len == ( count * HTTP_BLKSIZE ) );
+
+	/* Bypass cache if no cache is available, or if a read is
+	 * already pending.
+	 */
+	cache = http_block_cache ( http );
+	if ( ( ! cache ) || cache->window || cache->mirrored )
+		goto direct;
+
+	/* Satisfy read from background mirror, if possible */
+	if ( http_block_mirrored ( &cache->mirror, lba, count ) ) {
+		memcpy ( buffer, ( cache->mirror.xferbuf.data +
+				   ( lba * HTTP_BLKSIZE ) ), len );
+		cache->next = ( lba + count );
+		cache->mirrored = 1;
+		intf_plug_plug ( &cache->block, data );
+		process_add ( &cache->process );
+		return 0;
+	}
+
+	/* Bypass read-ahead if the read is too large */
+	if ( count > HTTP_READAHEAD_BLOCKS )
+		goto direct;
+
+	/* Track sequential reads */
+	sequential = ( lba == cache->next );
+	cache->next = ( lba + count );
+
+	/* Find a window containing the requested blocks */
+	for ( i = 0 ; i < HTTP_READAHEAD_WINDOWS ; i++ ) {
+		candidate = &cache->windows[i];
+		if ( http_block_contains ( candidate, lba, count ) ) {
+			window = candidate;
+			break;
+		}
+	}
+
+	/* Start a new window for a sequential read, reusing any idle
+	 * window.  Bypass read-ahead for non-sequential reads.
+	 */
+	if ( ! window ) {
+		if ( ! sequential )
+			goto direct;
+		for ( i = 0 ; i < HTTP_READAHEAD_WINDOWS ; i++ ) {
+			candidate = &cache->windows[i];
+			if ( candidate->rc != -EINPROGRESS )
+				window = candidate;
+		}
+		if ( ( ! window ) || ( http_block_fetch ( window, lba ) != 0 ) )
+			goto direct;
+	}
+
+	/* Record pending read */
+	cache->window = window;
+	cache->lba = lba;
+	cache->count = count;
+	cache->buffer = buffer;
+	intf_plug_plug ( &cache->block, data );
+
+	/* Complete read immediately if window is already present */
+	if ( window->rc != -EINPROGRESS )
+		process_add ( &cache->process );
+
+	/* Prefetch the following window */
+	http_block_prefetch ( window );
+
+	return 0;
+
+ direct:
+	return http_block_read_direct ( http, data, lba, count, buffer, len );
+}
+
 /**
  * Read block device capacity
  *
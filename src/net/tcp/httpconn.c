@@ -42,11 +42,15 @@ FILE_SECBOOT ( PERMITTED );
 #include <ipxe/xfer.h>
 #include <ipxe/open.h>
 #include <ipxe/pool.h>
+#include <ipxe/alpn.h>
 #include <ipxe/http.h>
 
 /** HTTP pooled connection expiry time */
 #define HTTP_CONN_EXPIRY ( 10 * TICKS_PER_SEC )
 
+/** Maximum number of pooled connections per origin */
+#define HTTP_CONN_MAX_POOLED 4
+
 /** HTTP connection pool */
 static LIST_HEAD ( http_connection_pool );
 
@@ -72,6 +76,28 @@ static struct http_scheme * http_scheme ( struct uri *uri ) {
 	return NULL;
 }
 
+/**
+ * Check if HTTP connection is to a specified origin
+ *
+ * @v conn		HTTP connection
+ * @v scheme		HTTP scheme
+ * @v host		Server host name
+ * @v port		Port number
+ * @ret match		Connection is to the specified origin
+ */
+static int http_conn_is_origin ( struct http_connection *conn,
+				 struct http_scheme *scheme, const char *host,
+				 unsigned int port ) {
+
+	/* Sanity checks */
+	assert ( conn->uri != NULL );
+	assert ( conn->uri->host != NULL );
+
+	return ( ( scheme == conn->scheme ) &&
+		 ( strcmp ( host, conn->uri->host ) == 0 ) &&
+		 ( port == uri_port ( conn->uri, scheme->port ) ) );
+}
+
 /**
  * Free HTTP connection
  *
@@ -142,6 +168,40 @@ static int http_conn_socket_deliver ( struct http_connection *conn,
 	return xfer_deliver ( &conn->xfer, iobuf, meta );
 }
 
+/**
+ * Get offered application protocols
+ *
+ * @v conn		HTTP connection
+ * @ret protocols	Offered protocols in wire format, or NULL
+ */
+static const char * http_conn_socket_alpn ( struct http_connection *conn ) {
+
+	/* Offer HTTP/2, if supported */
+	return http2_offer ( conn );
+}
+
+/**
+ * Handle transport layer window change
+ *
+ * @v conn		HTTP connection
+ */
+static void http_conn_socket_window_changed ( struct http_connection *conn ) {
+
+	/* Do nothing while connection is idle in the pool */
+	if ( ! list_empty ( &conn->pool.list ) )
+		return;
+
+	/* Hand over connection to HTTP/2, if negotiated.  The
+	 * connection will no longer be attached to either interface
+	 * after a successful upgrade.
+	 */
+	if ( http2_upgrade ( conn ) )
+		return;
+
+	/* Pass on to data transfer interface */
+	xfer_window_changed ( &conn->xfer );
+}
+
 /**
  * Close HTTP connection transport layer interface
  *
@@ -174,6 +234,44 @@ static void http_conn_xfer_recycle ( struct http_connection *conn ) {
 	DBGC2 ( conn, "HTTPCONN %p keepalive enabled\n", conn );
 }
 
+/**
+ * Add HTTP connection to connection pool
+ *
+ * @v conn		HTTP connection
+ *
+ * The number of pooled connections to each origin is limited, with
+ * the oldest pooled connection being closed if necessary.
+ */
+static void http_conn_pool ( struct http_connection *conn ) {
+	struct http_scheme *scheme = conn->scheme;
+	const char *host = conn->uri->host;
+	unsigned int port = uri_port ( conn->uri, scheme->port );
+	struct http_connection *oldest = NULL;
+	struct http_connection *tmp;
+	unsigned int count = 0;
+
+	/* Count existing pooled connections to this origin */
+	list_for_each_entry ( tmp, &http_connection_pool, pool.list ) {
+		if ( http_conn_is_origin ( tmp, scheme, host, port ) ) {
+			if ( ! oldest )
+				oldest = tmp;
+			count++;
+		}
+	}
+
+	/* Close oldest pooled connection, if applicable */
+	if ( count >= HTTP_CONN_MAX_POOLED ) {
+		DBGC2 ( oldest, "HTTPCONN %p evicted from pool\n", oldest );
+		pool_del ( &oldest->pool );
+		http_conn_close ( oldest, 0 );
+	}
+
+	/* Add to connection pool */
+	pool_add ( &conn->pool, &http_connection_pool, HTTP_CONN_EXPIRY );
+	DBGC2 ( conn, "HTTPCONN %p pooled %s://%s\n",
+		conn, conn->scheme->name, conn->uri->host );
+}
+
 /**
  * Close HTTP connection data transfer interface
  *
@@ -187,10 +285,7 @@ static void http_conn_xfer_close ( struct http_connection *conn, int rc ) {
 	 */
 	if ( ( rc == 0 ) && pool_is_recyclable ( &conn->pool ) ) {
 		intf_restart ( &conn->xfer, rc );
-		pool_add ( &conn->pool, &http_connection_pool,
-			   HTTP_CONN_EXPIRY );
-		DBGC2 ( conn, "HTTPCONN %p pooled %s://%s\n",
-			conn, conn->scheme->name, conn->uri->host );
+		http_conn_pool ( conn );
 		return;
 	}
 
@@ -202,6 +297,10 @@ static void http_conn_xfer_close ( struct http_connection *conn, int rc ) {
 static struct interface_operation http_conn_socket_operations[] = {
 	INTF_OP ( xfer_deliver, struct http_connection *,
 		  http_conn_socket_deliver ),
+	INTF_OP ( xfer_window_changed, struct http_connection *,
+		  http_conn_socket_window_changed ),
+	INTF_OP ( alpn_offer, struct http_connection *,
+		  http_conn_socket_alpn ),
 	INTF_OP ( intf_close, struct http_connection *,
 		  http_conn_socket_close ),
 };
@@ -224,6 +323,105 @@ static struct interface_descriptor http_conn_xfer_desc =
 	INTF_DESC_PASSTHRU ( struct http_connection, xfer,
 			     http_conn_xfer_operations, socket );
 
+/**
+ * Get offered application protocols (when HTTP/2 support is not present)
+ *
+ * @v conn		HTTP connection
+ * @ret protocols	Offered protocols in wire format, or NULL
+ */
+__weak const char * http2_offer ( struct http_connection *conn __unused ) {
+
+	return NULL;
+}
+
+/**
+ * Upgrade connection to HTTP/2 (when HTTP/2 support is not present)
+ *
+ * @v conn		HTTP connection
+ * @ret upgraded	Connection has been upgraded
+ */
+__weak int http2_upgrade ( struct http_connection *conn __unused ) {
+
+	return 0;
+}
+
+/**
+ * Open stream on existing HTTP/2 connection (when HTTP/2 support is
+ * not present)
+ *
+ * @v xfer		Data transfer interface
+ * @v uri		Connection URI
+ * @v scheme		HTTP scheme
+ * @v port		Port number
+ * @ret rc		Return status code
+ */
+__weak int http2_connect ( struct interface *xfer __unused,
+			   struct uri *uri __unused,
+			   struct http_scheme *scheme __unused,
+			   unsigned int port __unused ) {
+
+	return -ENOTCONN;
+}
+
+/**
+ * Open new HTTP connection
+ *
+ * @v uri		Connection URI
+ * @v scheme		HTTP scheme
+ * @v port		Port number
+ * @ret conn		HTTP connection
+ * @ret rc		Return status code
+ *
+ * The caller is responsible for attaching the connection and then
+ * dropping the returned reference.
+ */
+static int http_conn_open ( struct uri *uri, struct http_scheme *scheme,
+			    unsigned int port,
+			    struct http_connection **connp ) {
+	struct http_connection *conn;
+	struct sockaddr_tcpip server;
+	int rc;
+
+	/* Allocate and initialise structure */
+	conn = zalloc ( sizeof ( *conn ) );
+	if ( ! conn ) {
+		rc = -ENOMEM;
+		goto err_alloc;
+	}
+	ref_init ( &conn->refcnt, http_conn_free );
+	conn->uri = uri_get ( uri );
+	conn->scheme = scheme;
+	intf_init ( &conn->socket, &http_conn_socket_desc, &conn->refcnt );
+	intf_init ( &conn->xfer, &http_conn_xfer_desc, &conn->refcnt );
+	pool_init ( &conn->pool, http_conn_expired, &conn->refcnt );
+
+	/* Open socket */
+	memset ( &server, 0, sizeof ( server ) );
+	server.st_port = htons ( port );
+	if ( ( rc = xfer_open_named_socket ( &conn->socket, SOCK_STREAM,
+					     ( struct sockaddr * ) &server,
+					     uri->host, NULL ) ) != 0 )
+		goto err_open;
+
+	/* Add filter, if any */
+	if ( scheme->filter && ( ( rc = scheme->filter ( conn ) ) != 0 ) )
+		goto err_filter;
+
+	DBGC2 ( conn, "HTTPCONN %p created %s://%s:%d\n", conn,
+		conn->scheme->name, conn->uri->host, port );
+	*connp = conn;
+	return 0;
+
+ err_filter:
+ err_open:
+	DBGC2 ( conn, "HTTPCONN %p could not create %s://%s:%d: %s\n", conn,
+		conn->scheme->name, conn->uri->host, port, strerror ( rc ) );
+	http_conn_close ( conn, rc );
+	ref_put ( &conn->refcnt );
+ err_alloc:
+	return rc;
+}
+
 /**
  * Connect to an HTTP server
  *
@@ -237,7 +435,6 @@ static struct interface_descriptor http_conn_xfer_desc =
 int http_connect ( struct interface *xfer, struct uri *uri ) {
 	struct http_connection *conn;
 	struct http_scheme *scheme;
-	struct sockaddr_tcpip server;
 	unsigned int port;
 	int rc;
 
@@ -253,6 +450,10 @@ int http_connect ( struct interface *xfer, struct uri *uri ) {
 	/* Identify port */
 	port = uri_port ( uri, scheme->port );
 
+	/* Use an existing HTTP/2 connection, if possible */
+	if ( ( rc = http2_connect ( xfer, uri, scheme, port ) ) == 0 )
+		return 0;
+
 	/* Look for a reusable connection in the pool.  Reuse the most
 	 * recent connection in order to accommodate authentication
 	 * schemes that break the stateless nature of HTTP and rely on
@@ -261,14 +462,8 @@ int http_connect ( struct interface *xfer, struct uri *uri ) {
 	 */
 	list_for_each_entry_reverse ( conn, &http_connection_pool, pool.list ) {
 
-		/* Sanity checks */
-		assert ( conn->uri != NULL );
-		assert ( conn->uri->host != NULL );
-
 		/* Reuse connection, if possible */
-		if ( ( scheme == conn->scheme ) &&
-		     ( strcmp ( uri->host, conn->uri->host ) == 0 ) &&
-		     ( port == uri_port ( conn->uri, scheme->port ) ) ) {
+		if ( http_conn_is_origin ( conn, scheme, uri->host, port ) ) {
 
 			/* Remove from connection pool, stop timer,
 			 * attach to parent interface, and return.
@@ -277,49 +472,70 @@ int http_connect ( struct interface *xfer, struct uri *uri ) {
 			intf_plug_plug ( &conn->xfer, xfer );
 			DBGC2 ( conn, "HTTPCONN %p reused %s://%s:%d\n", conn,
 				conn->scheme->name, conn->uri->host, port );
+
+			/* Hand over to HTTP/2, if negotiated while
+			 * the connection was pooled (e.g. for a
+			 * pre-warmed connection).
+			 */
+			http2_upgrade ( conn );
 			return 0;
 		}
 	}
 
-	/* Allocate and initialise structure */
-	conn = zalloc ( sizeof ( *conn ) );
-	if ( ! conn ) {
-		rc = -ENOMEM;
-		goto err_alloc;
-	}
-	ref_init ( &conn->refcnt, http_conn_free );
-	conn->uri = uri_get ( uri );
-	conn->scheme = scheme;
-	intf_init ( &conn->socket, &http_conn_socket_desc, &conn->refcnt );
-	intf_init ( &conn->xfer, &http_conn_xfer_desc, &conn->refcnt );
-	pool_init ( &conn->pool, http_conn_expired, &conn->refcnt );
-
-	/* Open socket */
-	memset ( &server, 0, sizeof ( server ) );
-	server.st_port = htons ( port );
-	if ( ( rc = xfer_open_named_socket ( &conn->socket, SOCK_STREAM,
-					     ( struct sockaddr * ) &server,
-					     uri->host, NULL ) ) != 0 )
-		goto err_open;
-
-	/* Add filter, if any */
-	if ( scheme->filter && ( ( rc = scheme->filter ( conn ) ) != 0 ) )
-		goto err_filter;
+	/* Open new connection */
+	if ( ( rc = http_conn_open ( uri, scheme, port, &conn ) ) != 0 )
+		return rc;
 
 	/* Attach to parent interface, mortalise self, and return */
 	intf_plug_plug ( &conn->xfer, xfer );
 	ref_put ( &conn->refcnt );
-
-	DBGC2 ( conn, "HTTPCONN %p created %s://%s:%d\n", conn,
-		conn->scheme->name, conn->uri->host, port );
 	return 0;
+}
 
- err_filter:
- err_open:
-	DBGC2 ( conn, "HTTPCONN %p could not create %s://%s:%d: %s\n", conn,
-		conn->scheme->name, conn->uri->host, port, strerror ( rc ) );
-	http_conn_close ( conn, rc );
+/**
+ * Pre-warm a connection to an HTTP server
+ *
+ * @v uri		URI
+ * @ret rc		Return status code
+ *
+ * Open a new connection (including any TLS handshake) and place it
+ * directly into the connection pool, ready to be used by a
+ * subsequent request to the same origin.  Nothing is done if a
+ * pooled connection to the origin already exists.
+ */
+int http_prewarm ( struct uri *uri ) {
+	struct http_connection *conn;
+	struct http_scheme *scheme;
+	unsigned int port;
+	int rc;
+
+	/* Identify scheme */
+	scheme = http_scheme ( uri );
+	if ( ! scheme )
+		return -ENOTSUP;
+
+	/* Sanity check */
+	if ( ! uri->host )
+		return -EINVAL;
+
+	/* Identify port */
+	port = uri_port ( uri, scheme->port );
+
+	/* Do nothing if a pooled connection already exists */
+	list_for_each_entry ( conn, &http_connection_pool, pool.list ) {
+		if ( http_conn_is_origin ( conn, scheme, uri->host, port ) )
+			return 0;
+	}
+
+	/* Open new connection */
+	if ( ( rc = http_conn_open ( uri, scheme, port, &conn ) ) != 0 )
+		return rc;
+
+	/* Add to connection pool (which holds a reference via the
+	 * expiry timer), and drop our reference.
+	 */
+	pool_recyclable ( &conn->pool );
+	http_conn_pool ( conn );
 	ref_put ( &conn->refcnt );
- err_alloc:
-	return rc;
+	return 0;
 }
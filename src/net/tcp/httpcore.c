@@ -39,7 +39,9 @@ FILE_SECBOOT ( PERMITTED );
 #include <byteswap.h>
 #include <errno.h>
 #include <ctype.h>
+#include <limits.h>
 #include <assert.h>
+#include <ipxe/list.h>
 #include <ipxe/uri.h>
 #include <ipxe/refcnt.h>
 #include <ipxe/iobuf.h>
@@ -57,8 +59,11 @@ FILE_SECBOOT ( PERMITTED );
 #include <ipxe/profile.h>
 #include <ipxe/vsprintf.h>
 #include <ipxe/errortab.h>
+#include <ipxe/settings.h>
 #include <ipxe/efi/efi_path.h>
 #include <ipxe/http.h>
+#include <ipxe/trace.h>
+#include <ipxe/imgcache.h>
 
 /* Disambiguate the various error causes */
 #define EACCES_401 __einfo_error ( EINFO_EACCES_401 )
@@ -76,6 +81,9 @@ FILE_SECBOOT ( PERMITTED );
 #define EINVAL_CHUNK_LENGTH __einfo_error ( EINFO_EINVAL_CHUNK_LENGTH )
 #define EINFO_EINVAL_CHUNK_LENGTH \
 	__einfo_uniqify ( EINFO_EINVAL, 0x04, "Invalid chunk length" )
+#define EINVAL_CONTENT_RANGE __einfo_error ( EINFO_EINVAL_CONTENT_RANGE )
+#define EINFO_EINVAL_CONTENT_RANGE \
+	__einfo_uniqify ( EINFO_EINVAL, 0x05, "Invalid content range" )
 #define EIO_OTHER __einfo_error ( EINFO_EIO_OTHER )
 #define EINFO_EIO_OTHER \
 	__einfo_uniqify ( EINFO_EIO, 0x01, "Unrecognised HTTP response code" )
@@ -88,6 +96,9 @@ FILE_SECBOOT ( PERMITTED );
 #define EIO_5XX __einfo_error ( EINFO_EIO_5XX )
 #define EINFO_EIO_5XX \
 	__einfo_uniqify ( EINFO_EIO, 0x05, "HTTP 5xx Server Error" )
+#define EIO_RANGE __einfo_error ( EINFO_EIO_RANGE )
+#define EINFO_EIO_RANGE \
+	__einfo_uniqify ( EINFO_EIO, 0x06, "Range request not honoured" )
 #define ENOENT_404 __einfo_error ( EINFO_ENOENT_404 )
 #define EINFO_ENOENT_404 \
 	__einfo_uniqify ( EINFO_ENOENT, 0x01, "Not found" )
@@ -110,6 +121,15 @@ FILE_SECBOOT ( PERMITTED );
 /** Idle connection watchdog timeout */
 #define HTTP_WATCHDOG_SECONDS 120
 
+/** Default maximum number of attempts to resume an interrupted transfer */
+#define HTTP_RESUME_MAX 3
+
+/** Delay before resuming an interrupted transfer */
+#define HTTP_RESUME_SECONDS 1
+
+/** Maximum number of cached redirections */
+#define HTTP_REDIRECT_CACHE_MAX 16
+
 /** Receive profiler */
 static struct profiler http_rx_profiler __profiler = { .name = "http.rx" };
 
@@ -124,9 +144,32 @@ struct errortab http_errors[] __errortab = {
 };
 
 static struct http_state http_request;
+static struct http_state http_request_body;
 static struct http_state http_headers;
 static struct http_state http_trailers;
 static struct http_transfer_encoding http_transfer_identity;
+static int http_redirect ( struct http_transaction *http,
+			   const char *location );
+
+/** A cached HTTP redirection */
+struct http_redirect_cache {
+	/** List of cached redirections */
+	struct list_head list;
+	/** Time at which redirection was cached */
+	unsigned long created;
+	/** Lifetime (in ticks), or zero if redirection is permanent */
+	unsigned long lifetime;
+	/** Redirection location */
+	char *location;
+	/** Original request (scheme, host, and path) */
+	char key[0];
+};
+
+/** Cached redirections, most recently used first */
+static LIST_HEAD ( http_redirects );
+
+/** Number of cached redirections */
+static unsigned int http_redirects_count;
 
 /******************************************************************************
  *
@@ -252,6 +295,185 @@ char * http_token ( char **line, char **value ) {
 	return token;
 }
 
+/******************************************************************************
+ *
+ * Redirection cache
+ *
+ ******************************************************************************
+ */
+
+/**
+ * Construct redirection cache key
+ *
+ * @v http		HTTP transaction
+ * @v buf		Buffer
+ * @v len		Length of buffer
+ * @ret len		Length of key
+ */
+static size_t http_redirect_key ( struct http_transaction *http, char *buf,
+				  size_t len ) {
+
+	return snprintf ( buf, len, "%s://%s%s", http->uri->scheme,
+			  http->request.host, http->request.uri );
+}
+
+/**
+ * Free cached redirection
+ *
+ * @v cache		Cached redirection
+ */
+static void http_redirect_forget ( struct http_redirect_cache *cache ) {
+
+	list_del ( &cache->list );
+	http_redirects_count--;
+	free ( cache );
+}
+
+/**
+ * Find cached redirection
+ *
+ * @v http		HTTP transaction
+ * @ret cache		Cached redirection, or NULL if not found
+ */
+static struct http_redirect_cache *
+http_redirect_find ( struct http_transaction *http ) {
+	struct http_redirect_cache *cache;
+	struct http_redirect_cache *tmp;
+	size_t len = ( http_redirect_key ( http, NULL, 0 ) + 1 /* NUL */ );
+	char key[len];
+
+	/* Construct key */
+	http_redirect_key ( http, key, sizeof ( key ) );
+
+	/* Find matching redirection */
+	list_for_each_entry_safe ( cache, tmp, &http_redirects, list ) {
+
+		/* Discard any expired redirections */
+		if ( cache->lifetime &&
+		     ( ( currticks() - cache->created ) >= cache->lifetime ) ) {
+			http_redirect_forget ( cache );
+			continue;
+		}
+
+		/* Check for a matching request */
+		if ( strcmp ( cache->key, key ) == 0 )
+			return cache;
+	}
+	return NULL;
+}
+
+/**
+ * Look up cached redirection for HTTP transaction
+ *
+ * @v http		HTTP transaction
+ *
+ * If a cached redirection is found, the redirection location will be
+ * recorded in the transaction.  Failure to find (or to record) a
+ * cached redirection is not an error, since the request can always
+ * be sent to the original location.
+ */
+static void http_redirect_lookup ( struct http_transaction *http ) {
+	struct http_redirect_cache *cache;
+
+	/* Only GET requests are ever cached */
+	if ( http->request.method != &http_get )
+		return;
+
+	/* Find cached redirection */
+	cache = http_redirect_find ( http );
+	if ( ! cache )
+		return;
+
+	/* Mark as most recently used */
+	list_del ( &cache->list );
+	list_add ( &cache->list, &http_redirects );
+
+	/* Record location */
+	http->redirect = strdup ( cache->location );
+	DBGC2 ( http, "HTTP %p using cached redirection to \"%s\"\n",
+		http, cache->location );
+}
+
+/**
+ * Record redirection in cache, if applicable
+ *
+ * @v http		HTTP transaction
+ * @v location		New location
+ *
+ * Permanent redirections (301 and 308) are cached until expiry of any
+ * specified maximum age.  Temporary redirections (302 and 307) are
+ * cached only if a maximum age is explicitly specified.
+ */
+static void http_redirect_remember ( struct http_transaction *http,
+				     const char *location ) {
+	struct http_response *response = &http->response;
+	struct http_redirect_cache *cache;
+	struct http_redirect_cache *oldest;
+	unsigned long max_age;
+	unsigned long lifetime;
+	size_t key_len;
+	size_t location_len;
+
+	/* Only GET requests are ever cached */
+	if ( http->request.method != &http_get )
+		return;
+
+	/* Determine lifetime, if cacheable */
+	if ( response->flags & HTTP_RESPONSE_NO_CACHE )
+		return;
+	if ( response->flags & HTTP_RESPONSE_MAX_AGE ) {
+		if ( ! response->max_age )
+			return;
+		max_age = response->max_age;
+		if ( max_age > ( ULONG_MAX / TICKS_PER_SEC ) )
+			max_age = ( ULONG_MAX / TICKS_PER_SEC );
+		lifetime = ( max_age * TICKS_PER_SEC );
+	} else {
+		lifetime = 0;
+	}
+	switch ( response->status ) {
+	case 301:
+	case 308:
+		break;
+	case 302:
+	case 307:
+		if ( lifetime )
+			break;
+		/* Fall through */
+	default:
+		return;
+	}
+
+	/* Discard any existing redirection for this request */
+	if ( ( cache = http_redirect_find ( http ) ) )
+		http_redirect_forget ( cache );
+
+	/* Allocate and initialise cached redirection */
+	key_len = ( http_redirect_key ( http, NULL, 0 ) + 1 /* NUL */ );
+	location_len = ( strlen ( location ) + 1 /* NUL */ );
+	cache = malloc ( sizeof ( *cache ) + key_len + location_len );
+	if ( ! cache )
+		return;
+	http_redirect_key ( http, cache->key, key_len );
+	cache->location = ( cache->key + key_len );
+	memcpy ( cache->location, location, location_len );
+	cache->created = currticks();
+	cache->lifetime = lifetime;
+
+	/* Discard least recently used redirection, if applicable */
+	if ( http_redirects_count >= HTTP_REDIRECT_CACHE_MAX ) {
+		oldest = list_last_entry ( &http_redirects,
+					   struct http_redirect_cache, list );
+		http_redirect_forget ( oldest );
+	}
+
+	/* Add to cache */
+	list_add ( &cache->list, &http_redirects );
+	http_redirects_count++;
+	DBGC2 ( http, "HTTP %p cached redirection to \"%s\"\n",
+		http, location );
+}
+
 /******************************************************************************
  *
  * Transactions
@@ -271,6 +493,10 @@ static void http_free ( struct refcnt *refcnt ) {
 	empty_line_buffer ( &http->response.headers );
 	empty_line_buffer ( &http->linebuf );
 	uri_put ( http->uri );
+	free ( http->resume.validator );
+	free ( http->request.auth.preempt );
+	free ( http->redirect );
+	free ( http->upload );
 	free ( http );
 }
 
@@ -282,6 +508,9 @@ static void http_free ( struct refcnt *refcnt ) {
  */
 static void http_close ( struct http_transaction *http, int rc ) {
 
+	/* Record trace event */
+	trace ( "http", "close", http, rc );
+
 	/* Stop process */
 	process_del ( &http->process );
 
@@ -289,6 +518,9 @@ static void http_close ( struct http_transaction *http, int rc ) {
 	stop_timer ( &http->retry );
 	stop_timer ( &http->watchdog );
 
+	/* Close block device read-ahead cache, if any */
+	http_block_close ( http, rc );
+
 	/* Close all interfaces */
 	intfs_shutdown ( rc, &http->conn, &http->transfer, &http->content,
 			 &http->xfer, NULL );
@@ -351,6 +583,92 @@ static void http_reopen ( struct http_transaction *http ) {
 	http_close ( http, rc );
 }
 
+/** HTTP transfer resumption setting */
+const struct setting http_resume_setting __setting ( SETTING_MISC,
+						     http-resume ) = {
+	.name = "http-resume",
+	.description = "HTTP interrupted transfer resumption attempts",
+	.type = &setting_type_uint8,
+};
+
+/**
+ * Resume interrupted HTTP transfer
+ *
+ * @v http		HTTP transaction
+ * @v rc		Reason for interruption
+ * @ret rc		Return status code
+ *
+ * A successful GET request of known length which is interrupted
+ * (e.g. by a connection reset) may be resumed by requesting the
+ * remaining content via a range request, provided that the server
+ * supplied an entity validator which can be used to ensure that the
+ * content has not changed in the meantime.
+ */
+static int http_resume ( struct http_transaction *http, int rc ) {
+	struct http_response *response = &http->response;
+	unsigned long max;
+	const char *validator;
+
+	/* Check that transfer is resumable */
+	if ( ( http->request.method != &http_get ) ||
+	     ( http->state != &http_transfer_identity.state ) ||
+	     ( response->rc != 0 ) ||
+	     ( ! ( response->flags & HTTP_RESPONSE_CONTENT_LEN ) ) ||
+	     ( response->content.encoding != NULL ) ||
+	     ( http->request.range.len && ( ! http->resume.total ) ) ) {
+		return rc;
+	}
+
+	/* Check number of resumption attempts */
+	if ( fetch_uint_setting ( NULL, &http_resume_setting, &max ) < 0 )
+		max = HTTP_RESUME_MAX;
+	if ( http->resume.count >= max ) {
+		DBGC ( http, "HTTP %p giving up after %d resumption "
+		       "attempts\n", http, http->resume.count );
+		return rc;
+	}
+
+	/* Record validator from original response.  Weak entity tags
+	 * cannot be used with range requests.
+	 */
+	if ( ! http->resume.validator ) {
+		validator = response->etag;
+		if ( validator && ( strncmp ( validator, "W/", 2 ) == 0 ) )
+			validator = NULL;
+		if ( ! validator )
+			validator = response->last_modified;
+		if ( ! validator ) {
+			DBGC ( http, "HTTP %p cannot resume without a "
+			       "validator\n", http );
+			return rc;
+		}
+		http->resume.validator = strdup ( validator );
+		if ( ! http->resume.validator )
+			return rc;
+		http->resume.total = response->content.len;
+	}
+
+	/* Request remaining content */
+	http->resume.count++;
+	http->resume.offset += http->len;
+	http->len = 0;
+	http->request.range.start = http->resume.offset;
+	http->request.range.len = ( http->resume.total - http->resume.offset );
+	DBGC ( http, "HTTP %p resuming at %#zx/%#zx after error: %s\n",
+	       http, http->resume.offset, http->resume.total,
+	       strerror ( rc ) );
+
+	/* Close existing connection */
+	intf_restart ( &http->conn, rc );
+	http->state = NULL;
+
+	/* Start timer to initiate resumption */
+	start_timer_fixed ( &http->retry,
+			    ( HTTP_RESUME_SECONDS * TICKS_PER_SEC ) );
+	stop_timer ( &http->watchdog );
+	return 0;
+}
+
 /**
  * Handle connection retry timer expiry
  *
@@ -379,7 +697,10 @@ static void http_watchdog_expired ( struct retry_timer *watchdog,
 
 	/* Abort connection */
 	DBGC ( http, "HTTP %p aborting idle connection\n", http );
-	http_close ( http, -ETIMEDOUT );
+
+	/* Resume transfer if applicable, otherwise fail */
+	if ( http_resume ( http, -ETIMEDOUT ) != 0 )
+		http_close ( http, -ETIMEDOUT );
 }
 
 /**
@@ -390,6 +711,13 @@ static void http_watchdog_expired ( struct retry_timer *watchdog,
 static void http_step ( struct http_transaction *http ) {
 	int rc;
 
+	/* Follow cached redirection, if applicable */
+	if ( http->redirect ) {
+		rc = http_redirect ( http, http->redirect );
+		http_close ( http, rc );
+		return;
+	}
+
 	/* Do nothing if we have nothing to transmit */
 	if ( ! http->state->tx )
 		return;
@@ -561,6 +889,52 @@ __weak int http_block_read_capacity ( struct http_transaction *http __unused,
 	return -ENOTSUP;
 }
 
+/**
+ * Close block device read-ahead cache (when HTTP block device support
+ * is not present)
+ *
+ * @v http		HTTP transaction
+ * @v rc		Reason for close
+ */
+__weak void http_block_close ( struct http_transaction *http __unused,
+			       int rc __unused ) {
+
+	/* Nothing to do */
+}
+
+/**
+ * Open HTTP GET download (when parallel download support is not present)
+ *
+ * @v xfer		Data transfer interface
+ * @v uri		Request URI
+ * @ret rc		Return status code
+ */
+__weak int httpmux_open ( struct interface *xfer, struct uri *uri ) {
+
+	return http_open ( xfer, &http_get, uri, NULL, NULL );
+}
+
+/**
+ * Report that server accepts byte range requests
+ *
+ * @v intf		Data transfer interface
+ * @v len		Total content length
+ */
+void http_accept_ranges ( struct interface *intf, size_t len ) {
+	struct interface *dest;
+	http_accept_ranges_TYPE ( void * ) *op =
+		intf_get_dest_op ( intf, http_accept_ranges, &dest );
+	void *object = intf_object ( dest );
+
+	if ( op ) {
+		op ( object, len );
+	} else {
+		/* Default is to ignore the notification */
+	}
+
+	intf_put ( dest );
+}
+
 /**
  * Describe as an EFI device path
  *
@@ -638,6 +1012,10 @@ static struct process_descriptor http_process_desc =
  * @v range		Content range (if any)
  * @v content		Request content (if any)
  * @ret rc		Return status code
+ *
+ * Request content is copied, unless it is to be compressed on the
+ * fly (in which case the caller's content data must remain valid
+ * until the transaction is complete).
  */
 int http_open ( struct interface *xfer, struct http_method *method,
 		struct uri *uri, struct http_request_range *range,
@@ -667,8 +1045,9 @@ int http_open ( struct interface *xfer, struct http_method *method,
 	request_host_len =
 		( format_uri ( &request_host, NULL, 0 ) + 1 /* NUL */ );
 
-	/* Calculate request content length */
-	content_len = ( content ? content->len : 0 );
+	/* Calculate length of request content to be copied */
+	content_len = ( ( content && ! ( content->flags & HTTP_CONTENT_GZIP ) ) ?
+			content->len : 0 );
 
 	/* Allocate and initialise structure */
 	http = zalloc ( sizeof ( *http ) + request_uri_len + request_host_len +
@@ -703,14 +1082,22 @@ int http_open ( struct interface *xfer, struct http_method *method,
 		http->request.content.type = content->type;
 		http->request.content.data = content_data;
 		http->request.content.len = content_len;
+		http->request.content.flags = content->flags;
 		memcpy ( content_data, content->data, content_len );
+		if ( content->flags & HTTP_CONTENT_GZIP ) {
+			http->request.content.data = content->data;
+			http->request.content.len = content->len;
+		}
 	}
 	http->state = &http_request;
 	DBGC2 ( http, "HTTP %p %s://%s%s\n", http, http->uri->scheme,
 		http->request.host, http->request.uri );
 
-	/* Open connection */
-	if ( ( rc = http_connect ( &http->conn, uri ) ) != 0 ) {
+	/* Follow cached redirection without connecting, if applicable */
+	http_redirect_lookup ( http );
+	if ( http->redirect ) {
+		process_add ( &http->process );
+	} else if ( ( rc = http_connect ( &http->conn, uri ) ) != 0 ) {
 		DBGC ( http, "HTTP %p could not connect: %s\n",
 		       http, strerror ( rc ) );
 		goto err_connect;
@@ -809,6 +1196,7 @@ static int http_transfer_complete ( struct http_transaction *http ) {
 
 	/* Perform redirection, if applicable */
 	if ( ( location = http->response.location ) ) {
+		http_redirect_remember ( http, location );
 		if ( ( rc = http_redirect ( http, location ) ) != 0 )
 			return rc;
 		http_close ( http, 0 );
@@ -1031,6 +1419,59 @@ struct http_request_header http_request_range __http_request_header = {
 	.format = http_format_range,
 };
 
+/**
+ * Construct HTTP "If-Range" header
+ *
+ * @v http		HTTP transaction
+ * @v buf		Buffer
+ * @v len		Length of buffer
+ * @ret len		Length of header value, or negative error
+ */
+static int http_format_if_range ( struct http_transaction *http,
+				  char *buf, size_t len ) {
+
+	/* Construct validator, if resuming an interrupted transfer */
+	if ( http->resume.validator ) {
+		return snprintf ( buf, len, "%s", http->resume.validator );
+	} else {
+		return 0;
+	}
+}
+
+/** HTTP "If-Range" header */
+struct http_request_header http_request_if_range __http_request_header = {
+	.name = "If-Range",
+	.format = http_format_if_range,
+};
+
+/**
+ * Construct HTTP "If-None-Match" header
+ *
+ * @v http		HTTP transaction
+ * @v buf		Buffer
+ * @v len		Length of buffer
+ * @ret len		Length of header value, or negative error
+ */
+static int http_format_if_none_match ( struct http_transaction *http,
+				       char *buf, size_t len ) {
+	const char *etag;
+
+	/* Revalidate cached content, if applicable */
+	if ( ( http->request.method != &http_get ) ||
+	     http->request.range.len )
+		return 0;
+	etag = imgcache_etag ( &http->xfer );
+	if ( ! etag )
+		return 0;
+	return snprintf ( buf, len, "%s", etag );
+}
+
+/** HTTP "If-None-Match" header */
+struct http_request_header http_request_if_none_match __http_request_header = {
+	.name = "If-None-Match",
+	.format = http_format_if_none_match,
+};
+
 /**
  * Construct HTTP "Content-Type" header
  *
@@ -1067,8 +1508,11 @@ struct http_request_header http_request_content_type __http_request_header = {
 static int http_format_content_length ( struct http_transaction *http,
 					char *buf, size_t len ) {
 
-	/* Construct content length, if applicable */
-	if ( http->request.content.len ) {
+	/* Construct content length, if applicable (and not using
+	 * the chunked transfer encoding).
+	 */
+	if ( http->request.content.len &&
+	     ! ( http->request.content.flags & HTTP_CONTENT_GZIP ) ) {
 		return snprintf ( buf, len, "%zd", http->request.content.len );
 	} else {
 		return 0;
@@ -1081,6 +1525,58 @@ struct http_request_header http_request_content_length __http_request_header = {
 	.format = http_format_content_length,
 };
 
+/**
+ * Construct HTTP "Content-Encoding" header
+ *
+ * @v http		HTTP transaction
+ * @v buf		Buffer
+ * @v len		Length of buffer
+ * @ret len		Length of header value, or negative error
+ */
+static int http_format_content_encoding ( struct http_transaction *http,
+					  char *buf, size_t len ) {
+
+	/* Construct content encoding, if applicable */
+	if ( http->request.content.flags & HTTP_CONTENT_GZIP ) {
+		return snprintf ( buf, len, "gzip" );
+	} else {
+		return 0;
+	}
+}
+
+/** HTTP "Content-Encoding" header */
+struct http_request_header http_request_content_encoding
+__http_request_header = {
+	.name = "Content-Encoding",
+	.format = http_format_content_encoding,
+};
+
+/**
+ * Construct HTTP "Transfer-Encoding" header
+ *
+ * @v http		HTTP transaction
+ * @v buf		Buffer
+ * @v len		Length of buffer
+ * @ret len		Length of header value, or negative error
+ */
+static int http_format_transfer_encoding ( struct http_transaction *http,
+					   char *buf, size_t len ) {
+
+	/* Use chunked encoding for content generated on the fly */
+	if ( http->request.content.flags & HTTP_CONTENT_GZIP ) {
+		return snprintf ( buf, len, "chunked" );
+	} else {
+		return 0;
+	}
+}
+
+/** HTTP "Transfer-Encoding" header */
+struct http_request_header http_request_transfer_encoding
+__http_request_header = {
+	.name = "Transfer-Encoding",
+	.format = http_format_transfer_encoding,
+};
+
 /**
  * Construct HTTP "Accept-Encoding" header
  *
@@ -1121,10 +1617,15 @@ struct http_request_header http_request_accept_encoding __http_request_header ={
  */
 static int http_tx_request ( struct http_transaction *http ) {
 	struct io_buffer *iobuf;
+	size_t content_len;
 	int len;
 	int check_len;
 	int rc;
 
+	/* Calculate length of content to be sent along with request */
+	content_len = ( ( http->request.content.flags & HTTP_CONTENT_GZIP ) ?
+			0 : http->request.content.len );
+
 	/* Calculate request length */
 	len = http_format_headers ( http, NULL, 0 );
 	if ( len < 0 ) {
@@ -1135,8 +1636,8 @@ static int http_tx_request ( struct http_transaction *http ) {
 	}
 
 	/* Allocate I/O buffer */
-	iobuf = xfer_alloc_iob ( &http->conn, ( len + 1 /* NUL */ +
-						http->request.content.len ) );
+	iobuf = xfer_alloc_iob ( &http->conn,
+				 ( len + 1 /* NUL */ + content_len ) );
 	if ( ! iobuf ) {
 		rc = -ENOMEM;
 		goto err_alloc;
@@ -1146,8 +1647,8 @@ static int http_tx_request ( struct http_transaction *http ) {
 	check_len = http_format_headers ( http, iob_put ( iobuf, len ),
 					  ( len + 1 /* NUL */ ) );
 	assert ( check_len == len );
-	memcpy ( iob_put ( iobuf, http->request.content.len ),
-		 http->request.content.data, http->request.content.len );
+	memcpy ( iob_put ( iobuf, content_len ), http->request.content.data,
+		 content_len );
 
 	/* Deliver request */
 	if ( ( rc = xfer_deliver_iob ( &http->conn,
@@ -1161,8 +1662,18 @@ static int http_tx_request ( struct http_transaction *http ) {
 	empty_line_buffer ( &http->response.headers );
 	memset ( &http->response, 0, sizeof ( http->response ) );
 
+	/* Move to request body state, if applicable */
+	if ( http->request.content.flags & HTTP_CONTENT_GZIP ) {
+		free ( http->upload );
+		http->upload = NULL;
+		http->state = &http_request_body;
+		process_add ( &http->process );
+		return 0;
+	}
+
 	/* Move to response headers state */
 	http->state = &http_headers;
+	trace ( "http", "request", http, 0 );
 
 	return 0;
 
@@ -1179,6 +1690,97 @@ static struct http_state http_request = {
 	.close = http_close_error,
 };
 
+/**
+ * Generate compressed request content (when not present)
+ *
+ * @v http		HTTP transaction
+ * @v data		Buffer to fill in
+ * @v len		Length of buffer, updated to length used
+ * @ret rc		Return status code
+ */
+__weak int http_gzip_upload ( struct http_transaction *http __unused,
+			      void *data __unused, size_t *len __unused ) {
+	return -ENOTSUP;
+}
+
+/**
+ * Transmit request body
+ *
+ * @v http		HTTP transaction
+ * @ret rc		Return status code
+ *
+ * The request body is generated on the fly and sent using the
+ * chunked transfer encoding, one chunk at a time as the connection's
+ * transmit window allows.
+ */
+static int http_tx_request_body ( struct http_transaction *http ) {
+	char hdr[ HTTP_UPLOAD_CHUNK_HDR_LEN + 1 /* NUL */ ];
+	struct io_buffer *iobuf;
+	size_t len = HTTP_UPLOAD_CHUNK_LEN;
+	int complete;
+	int rc;
+
+	/* Allocate I/O buffer */
+	iobuf = xfer_alloc_iob ( &http->conn,
+				 ( HTTP_UPLOAD_CHUNK_HDR_LEN + len +
+				   HTTP_UPLOAD_CHUNK_TRAILER_LEN ) );
+	if ( ! iobuf ) {
+		rc = -ENOMEM;
+		goto err_alloc;
+	}
+	iob_reserve ( iobuf, HTTP_UPLOAD_CHUNK_HDR_LEN );
+
+	/* Generate chunk data */
+	rc = http_gzip_upload ( http, iobuf->data, &len );
+	if ( ( rc != 0 ) && ( rc != -EINPROGRESS ) ) {
+		DBGC ( http, "HTTP %p could not generate content: %s\n",
+		       http, strerror ( rc ) );
+		goto err_generate;
+	}
+	complete = ( rc == 0 );
+
+	/* Construct chunk */
+	if ( len ) {
+		iob_put ( iobuf, len );
+		snprintf ( hdr, sizeof ( hdr ), "%04zx\r\n", len );
+		memcpy ( iob_push ( iobuf, HTTP_UPLOAD_CHUNK_HDR_LEN ), hdr,
+			 HTTP_UPLOAD_CHUNK_HDR_LEN );
+		memcpy ( iob_put ( iobuf, 2 ), "\r\n", 2 );
+	}
+	if ( complete )
+		memcpy ( iob_put ( iobuf, 5 ), "0\r\n\r\n", 5 );
+
+	/* Deliver chunk */
+	if ( ( rc = xfer_deliver_iob ( &http->conn,
+				       iob_disown ( iobuf ) ) ) != 0 ) {
+		DBGC ( http, "HTTP %p could not deliver content: %s\n",
+		       http, strerror ( rc ) );
+		goto err_deliver;
+	}
+
+	/* Move to response headers state, or schedule next chunk */
+	if ( complete ) {
+		http->state = &http_headers;
+		trace ( "http", "request", http, 0 );
+	} else {
+		process_add ( &http->process );
+	}
+
+	return 0;
+
+ err_deliver:
+ err_generate:
+	free_iob ( iobuf );
+ err_alloc:
+	return rc;
+}
+
+/** HTTP request body state */
+static struct http_state http_request_body = {
+	.tx = http_tx_request_body,
+	.close = http_close_error,
+};
+
 /******************************************************************************
  *
  * Response headers
@@ -1336,6 +1938,48 @@ static int http_parse_headers ( struct http_transaction *http ) {
 	}
 }
 
+/**
+ * Parse HTTP "ETag" header
+ *
+ * @v http		HTTP transaction
+ * @v line		Remaining header line
+ * @ret rc		Return status code
+ */
+static int http_parse_etag ( struct http_transaction *http, char *line ) {
+
+	/* Store entity tag */
+	http->response.etag = line;
+	return 0;
+}
+
+/** HTTP "ETag" header */
+struct http_response_header http_response_etag __http_response_header = {
+	.name = "ETag",
+	.parse = http_parse_etag,
+};
+
+/**
+ * Parse HTTP "Last-Modified" header
+ *
+ * @v http		HTTP transaction
+ * @v line		Remaining header line
+ * @ret rc		Return status code
+ */
+static int http_parse_last_modified ( struct http_transaction *http,
+				      char *line ) {
+
+	/* Store last modification date */
+	http->response.last_modified = line;
+	return 0;
+}
+
+/** HTTP "Last-Modified" header */
+struct http_response_header
+http_response_last_modified __http_response_header = {
+	.name = "Last-Modified",
+	.parse = http_parse_last_modified,
+};
+
 /**
  * Parse HTTP "Location" header
  *
@@ -1446,6 +2090,92 @@ http_response_content_length __http_response_header = {
 	.parse = http_parse_content_length,
 };
 
+/**
+ * Parse HTTP "Accept-Ranges" header
+ *
+ * @v http		HTTP transaction
+ * @v line		Remaining header line
+ * @ret rc		Return status code
+ */
+static int http_parse_accept_ranges ( struct http_transaction *http,
+				      char *line ) {
+	char *token;
+
+	/* Check for byte range support */
+	while ( ( token = http_token ( &line, NULL ) ) ) {
+		if ( strcasecmp ( token, "bytes" ) == 0 )
+			http->response.flags |= HTTP_RESPONSE_ACCEPT_RANGES;
+	}
+
+	return 0;
+}
+
+/** HTTP "Accept-Ranges" header */
+struct http_response_header
+http_response_accept_ranges __http_response_header = {
+	.name = "Accept-Ranges",
+	.parse = http_parse_accept_ranges,
+};
+
+/**
+ * Parse HTTP "Content-Range" header
+ *
+ * @v http		HTTP transaction
+ * @v line		Remaining header line
+ * @ret rc		Return status code
+ */
+static int http_parse_content_range ( struct http_transaction *http,
+				      char *line ) {
+	struct http_response_range *range = &http->response.range;
+	char *unit;
+	char *endp;
+	size_t last;
+
+	/* Check units */
+	unit = http_token ( &line, NULL );
+	if ( ( ! unit ) || ( strcasecmp ( unit, "bytes" ) != 0 ) )
+		goto err;
+
+	/* Ignore unsatisfied range responses */
+	if ( *line == '*' )
+		return 0;
+
+	/* Parse range */
+	range->start = strtoul ( line, &endp, 10 );
+	if ( *endp != '-' )
+		goto err;
+	last = strtoul ( ( endp + 1 ), &endp, 10 );
+	if ( ( *endp != '/' ) || ( last < range->start ) )
+		goto err;
+	range->len = ( last - range->start + 1 );
+
+	/* Parse total length, if known */
+	line = ( endp + 1 );
+	if ( strcmp ( line, "*" ) == 0 ) {
+		range->total = 0;
+	} else {
+		range->total = strtoul ( line, &endp, 10 );
+		if ( ( *endp != '\0' ) || ( range->total <= last ) )
+			goto err;
+	}
+
+	/* Record that we have a content range */
+	http->response.flags |= HTTP_RESPONSE_CONTENT_RANGE;
+
+	return 0;
+
+ err:
+	DBGC ( http, "HTTP %p invalid Content-Range \"%s\"\n", http, line );
+	return -EINVAL_CONTENT_RANGE;
+}
+
+/** HTTP "Content-Range" header */
+struct http_response_header
+http_response_content_range __http_response_header = {
+	.name = "Content-Range",
+	.parse = http_parse_content_range,
+};
+
 /**
  * Parse HTTP "Content-Encoding" header
  *
@@ -1517,6 +2247,41 @@ static int http_parse_retry_after ( struct http_transaction *http,
 	return 0;
 }
 
+/**
+ * Parse HTTP "Cache-Control" header
+ *
+ * @v http		HTTP transaction
+ * @v line		Remaining header line
+ * @ret rc		Return status code
+ */
+static int http_parse_cache_control ( struct http_transaction *http,
+				      char *line ) {
+	char *token;
+	char *value;
+	char *endp;
+
+	/* Check for known cache directives */
+	while ( ( token = http_token ( &line, &value ) ) ) {
+		if ( ( strcasecmp ( token, "no-store" ) == 0 ) ||
+		     ( strcasecmp ( token, "no-cache" ) == 0 ) ) {
+			http->response.flags |= HTTP_RESPONSE_NO_CACHE;
+		} else if ( ( strcasecmp ( token, "max-age" ) == 0 ) &&
+			    value ) {
+			http->response.max_age = strtoul ( value, &endp, 10 );
+			if ( *endp == '\0' )
+				http->response.flags |= HTTP_RESPONSE_MAX_AGE;
+		}
+	}
+
+	return 0;
+}
+
+/** HTTP "Cache-Control" header */
+struct http_response_header http_response_cache_control __http_response_header = {
+	.name = "Cache-Control",
+	.parse = http_parse_cache_control,
+};
+
 /** HTTP "Retry-After" header */
 struct http_response_header http_response_retry_after __http_response_header = {
 	.name = "Retry-After",
@@ -1550,6 +2315,51 @@ static int http_rx_headers ( struct http_transaction *http,
 	/* Process headers */
 	if ( ( rc = http_parse_headers ( http ) ) != 0 )
 		return rc;
+	trace ( "http", "response", http, http->response.status );
+
+	/* Use cached content if not modified */
+	if ( ( http->response.status == 304 ) &&
+	     ( http->request.method == &http_get ) &&
+	     ( ! http->request.range.len ) &&
+	     ( imgcache_current ( &http->xfer ) == 0 ) ) {
+		DBGC ( http, "HTTP %p using cached content\n", http );
+		http->response.rc = 0;
+		return http_transfer_complete ( http );
+	}
+
+	/* Report entity tag for caching, if applicable */
+	if ( ( http->response.rc == 0 ) && ( ! http->request.range.len ) &&
+	     http->response.etag && ( http->request.method == &http_get ) ) {
+		imgcache_validator ( &http->xfer, http->response.etag );
+	}
+
+	/* Check that any range request was honoured */
+	if ( ( http->response.rc == 0 ) && http->request.range.len &&
+	     ( ( ! ( http->response.flags & HTTP_RESPONSE_CONTENT_RANGE ) ) ||
+	       ( http->response.range.start != http->request.range.start ) )){
+		DBGC ( http, "HTTP %p range request not honoured\n", http );
+		return -EIO_RANGE;
+	}
+
+	/* Check that any resumed content is unchanged in length (the
+	 * "If-Range" header will already have ensured that the
+	 * content is otherwise unchanged).
+	 */
+	if ( ( http->response.rc == 0 ) && http->resume.total &&
+	     ( http->response.range.total != http->resume.total ) ) {
+		DBGC ( http, "HTTP %p resumed content length changed\n",
+		       http );
+		return -EIO_RANGE;
+	}
+
+	/* Report range request support, if applicable */
+	if ( ( http->response.rc == 0 ) && ( ! http->request.range.len ) &&
+	     ( http->response.flags & HTTP_RESPONSE_ACCEPT_RANGES ) &&
+	     ( http->response.flags & HTTP_RESPONSE_CONTENT_LEN ) &&
+	     ( ! http->response.content.encoding ) &&
+	     ( http->request.method == &http_get ) ) {
+		http_accept_ranges ( &http->xfer, http->response.content.len );
+	}
 
 	/* Initialise content encoding, if applicable */
 	if ( ( content = http->response.content.encoding ) &&
@@ -1561,8 +2371,9 @@ static int http_rx_headers ( struct http_transaction *http,
 
 	/* Presize receive buffer, if we have a content length */
 	if ( http->response.content.len ) {
-		xfer_seek ( &http->transfer, http->response.content.len );
-		xfer_seek ( &http->transfer, 0 );
+		xfer_seek ( &http->transfer, ( http->resume.offset +
+					       http->response.content.len ) );
+		xfer_seek ( &http->transfer, http->resume.offset );
 	}
 
 	/* Complete transfer if this is a HEAD request */
@@ -1680,7 +2491,7 @@ static void http_close_transfer_identity ( struct http_transaction *http,
 	 */
 	if ( http->response.flags & HTTP_RESPONSE_CONTENT_LEN ) {
 		DBGC ( http, "HTTP %p content length underrun\n", http );
-		rc = EIO_CONTENT_LENGTH;
+		rc = -EIO_CONTENT_LENGTH;
 		goto err;
 	}
 
@@ -1691,7 +2502,9 @@ static void http_close_transfer_identity ( struct http_transaction *http,
 	return;
 
  err:
-	http_close ( http, rc );
+	/* Resume transfer if applicable, otherwise fail */
+	if ( ( rc = http_resume ( http, rc ) ) != 0 )
+		http_close ( http, rc );
 }
 
 /** Identity transfer encoding */
@@ -1723,136 +2536,164 @@ static int http_init_transfer_chunked ( struct http_transaction *http ) {
 	assert ( http->remaining == 0 );
 	assert ( http->linebuf.len == 0 );
 
+	/* Await first chunk header */
+	http->chunk = HTTP_CHUNK_START;
+
 	return 0;
 }
 
 /**
- * Handle received chunk length
+ * Parse chunk header character
  *
  * @v http		HTTP transaction
- * @v iobuf		I/O buffer (may be claimed)
+ * @v c			Character
  * @ret rc		Return status code
  */
-static int http_rx_chunk_len ( struct http_transaction *http,
-			       struct io_buffer **iobuf ) {
-	char *line;
-	char *endp;
-	size_t len;
-	int rc;
+static int http_rx_chunk_header ( struct http_transaction *http, uint8_t c ) {
+	unsigned int digit;
 
-	/* Receive into temporary line buffer */
-	if ( ( rc = http_rx_linebuf ( http, *iobuf, &http->linebuf ) ) != 0 )
-		return rc;
+	switch ( http->chunk ) {
 
-	/* Wait until we receive a non-empty line */
-	line = buffered_line ( &http->linebuf );
-	if ( ( line == NULL ) || ( line[0] == '\0' ) )
+	case HTTP_CHUNK_START:
+		/* Ignore the empty line following each chunk's data */
+		if ( ( c == '\r' ) || ( c == '\n' ) )
+			return 0;
+		http->remaining = 0;
+		http->chunk = HTTP_CHUNK_LEN;
+		if ( ! isxdigit ( c ) )
+			goto err_invalid;
+		/* Fall through */
+
+	case HTTP_CHUNK_LEN:
+		/* Accumulate chunk length */
+		if ( isxdigit ( c ) ) {
+			digit = ( isdigit ( c ) ? ( c - '0' ) :
+				  ( ( c | 0x20 ) - 'a' + 10 ) );
+			if ( http->remaining > ( ( ~( ( size_t ) 0 ) ) >> 4 ) )
+				goto err_invalid;
+			http->remaining = ( ( http->remaining << 4 ) | digit );
+			return 0;
+		}
+		http->chunk = HTTP_CHUNK_EXT;
+		/* Fall through */
+
+	case HTTP_CHUNK_EXT:
+		/* Skip chunk extensions up to end of line */
+		if ( c != '\n' )
+			return 0;
+		http->chunk = HTTP_CHUNK_DATA;
 		return 0;
 
-	/* Parse chunk length */
-	http->remaining = strtoul ( line, &endp, 16 );
-	if ( *endp != '\0' ) {
-		DBGC ( http, "HTTP %p invalid chunk length \"%s\"\n",
-		       http, line );
-		return -EINVAL_CHUNK_LENGTH;
+	default:
+		assert ( 0 );
+		return -EINVAL;
 	}
 
-	/* Empty line buffer */
-	empty_line_buffer ( &http->linebuf );
-
-	/* Update expected length */
-	len = ( http->len + http->remaining );
-	xfer_seek ( &http->transfer, len );
-	xfer_seek ( &http->transfer, http->len );
-
-	/* If chunk length is zero, then move to response trailers state */
-	if ( ! http->remaining )
-		http->state = &http_trailers;
-
-	return 0;
+ err_invalid:
+	DBGC ( http, "HTTP %p invalid chunk length character %#02x\n",
+	       http, c );
+	return -EINVAL_CHUNK_LENGTH;
 }
 
 /**
- * Handle received chunk data
+ * Handle received chunked data
  *
  * @v http		HTTP transaction
  * @v iobuf		I/O buffer (may be claimed)
  * @ret rc		Return status code
+ *
+ * Chunk framing is stripped in place: chunk data is delivered using
+ * the original I/O buffer, with any data following an embedded chunk
+ * header being moved down to abut the preceding chunk data.
  */
-static int http_rx_chunk_data ( struct http_transaction *http,
-				struct io_buffer **iobuf ) {
-	struct io_buffer *payload;
-	uint8_t *crlf;
-	size_t len;
+static int http_rx_transfer_chunked ( struct http_transaction *http,
+				      struct io_buffer **iobuf ) {
+	struct io_buffer *payload = *iobuf;
+	struct io_buffer *trailers = NULL;
+	uint8_t *data = payload->data;
+	uint8_t *end = payload->tail;
+	uint8_t *base = data;
+	size_t kept = 0;
+	size_t frag_len;
+	int presize = 0;
 	int rc;
 
-	/* In the common case of a final chunk in a packet which also
-	 * includes the terminating CRLF, strip the terminating CRLF
-	 * (which we would ignore anyway) and hence avoid
-	 * unnecessarily copying the data.
-	 */
-	if ( iob_len ( *iobuf ) == ( http->remaining + 2 /* CRLF */ ) ) {
-		crlf = ( (*iobuf)->data + http->remaining );
-		if ( ( crlf[0] == '\r' ) && ( crlf[1] == '\n' ) )
-			iob_unput ( (*iobuf), 2 /* CRLF */ );
-	}
-	len = iob_len ( *iobuf );
+	/* Process received data */
+	while ( data < end ) {
 
-	/* Use whole/partial buffer as applicable */
-	if ( len <= http->remaining ) {
-
-		/* Whole buffer is to be consumed: decrease remaining
-		 * length and use original I/O buffer as payload.
-		 */
-		payload = iob_disown ( *iobuf );
-		http->len += len;
-		http->remaining -= len;
+		/* Parse chunk header, if applicable */
+		if ( http->chunk != HTTP_CHUNK_DATA ) {
+			if ( ( rc = http_rx_chunk_header ( http,
+							   *(data++) ) ) != 0 )
+				return rc;
+			if ( http->chunk != HTTP_CHUNK_DATA )
+				continue;
 
-	} else {
+			/* Move to trailers after final (empty) chunk */
+			if ( ! http->remaining ) {
+				http->chunk = HTTP_CHUNK_START;
+				http->state = &http_trailers;
+				break;
+			}
+			presize = 1;
+			continue;
+		}
 
-		/* Partial buffer is to be consumed: copy data to a
-		 * temporary I/O buffer.
+		/* Retain chunk data, moving down to abut any
+		 * preceding chunk data within this I/O buffer.
 		 */
-		payload = alloc_iob ( http->remaining );
-		if ( ! payload ) {
-			rc = -ENOMEM;
-			goto err;
+		frag_len = ( end - data );
+		if ( frag_len > http->remaining )
+			frag_len = http->remaining;
+		if ( ! kept ) {
+			base = data;
+		} else if ( data != ( base + kept ) ) {
+			memmove ( ( base + kept ), data, frag_len );
 		}
-		memcpy ( iob_put ( payload, http->remaining ), (*iobuf)->data,
-			 http->remaining );
-		iob_pull ( *iobuf, http->remaining );
-		http->len += http->remaining;
-		http->remaining = 0;
+		kept += frag_len;
+		data += frag_len;
+		http->len += frag_len;
+		http->remaining -= frag_len;
+		if ( ! http->remaining )
+			http->chunk = HTTP_CHUNK_START;
 	}
 
-	/* Hand off to content encoding */
-	if ( ( rc = xfer_deliver_iob ( &http->transfer,
-				       iob_disown ( payload ) ) ) != 0 )
-		goto err;
-
-	return 0;
-
- err:
-	assert ( payload == NULL );
-	return rc;
-}
-
-/**
- * Handle received chunked data
- *
- * @v http		HTTP transaction
- * @v iobuf		I/O buffer (may be claimed)
- * @ret rc		Return status code
- */
-static int http_rx_transfer_chunked ( struct http_transaction *http,
-				      struct io_buffer **iobuf ) {
-
-	/* Handle as chunk length or chunk data as appropriate */
-	if ( http->remaining ) {
-		return http_rx_chunk_data ( http, iobuf );
+	/* Retain any data following the final chunk for the trailers
+	 * state.  This is copied only if the I/O buffer is also
+	 * required for chunk data.
+	 */
+	if ( data < end ) {
+		if ( kept ) {
+			trailers = alloc_iob ( end - data );
+			if ( ! trailers )
+				return -ENOMEM;
+			memcpy ( iob_put ( trailers, ( end - data ) ), data,
+				 ( end - data ) );
+		} else {
+			iob_pull ( payload, ( ( ( void * ) data ) - payload->data ) );
+			return 0;
+		}
+	}
+	*iobuf = trailers;
+
+	/* Hand off chunk data (if any) to content encoding */
+	if ( kept ) {
+		iob_pull ( payload, ( ( ( void * ) base ) - payload->data ) );
+		iob_unput ( payload, ( iob_len ( payload ) - kept ) );
+		if ( ( rc = xfer_deliver_iob ( &http->transfer,
+					       payload ) ) != 0 )
+			return rc;
 	} else {
-		return http_rx_chunk_len ( http, iobuf );
+		free_iob ( payload );
+	}
+
+	/* Update expected length, if a new chunk has started */
+	if ( presize && http->remaining ) {
+		xfer_seek ( &http->transfer, ( http->len + http->remaining ) );
+		xfer_seek ( &http->transfer, http->len );
 	}
+
+	return 0;
 }
 
 /** Chunked transfer encoding */
@@ -2025,9 +2866,17 @@ int http_open_uri ( struct interface *xfer, struct uri *uri ) {
 	content.type = type;
 	content.data = data;
 	content.len = len;
+	content.flags = 0;
 
-	/* Open HTTP transaction */
-	if ( ( rc = http_open ( xfer, method, uri, NULL, &content ) ) != 0 )
+	/* Open HTTP transaction, using parallel range requests for
+	 * GET if applicable.
+	 */
+	if ( method == &http_get ) {
+		rc = httpmux_open ( xfer, uri );
+	} else {
+		rc = http_open ( xfer, method, uri, NULL, &content );
+	}
+	if ( rc != 0 )
 		goto err_open;
 
  err_open:
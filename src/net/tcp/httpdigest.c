@@ -209,6 +209,11 @@ static int http_digest_authenticate ( struct http_transaction *http ) {
 		snprintf ( req->cnonce, sizeof ( req->cnonce ),
 			   "%08lx", random() );
 
+		/* Construct nonce count */
+		snprintf ( req->nc, sizeof ( req->nc ), "%08x",
+			   ( http->request.auth.count ?
+			     http->request.auth.count : 1 ) );
+
 		/* Determine algorithm */
 		req->algorithm = md5;
 		if ( rsp->algorithm &&
@@ -242,7 +247,7 @@ static int http_digest_authenticate ( struct http_transaction *http ) {
 	http_digest_update ( &ctx, ha1 );
 	http_digest_update ( &ctx, rsp->nonce );
 	if ( req->qop ) {
-		http_digest_update ( &ctx, HTTP_DIGEST_NC );
+		http_digest_update ( &ctx, req->nc );
 		http_digest_update ( &ctx, req->cnonce );
 		http_digest_update ( &ctx, req->qop );
 	}
@@ -288,8 +293,8 @@ static int http_format_digest_auth ( struct http_transaction *http,
 	if ( req->qop ) {
 		used += ssnprintf ( ( buf + used ), ( len - used ),
 				    ", qop=%s, algorithm=%s, cnonce=\"%s\", "
-				    "nc=" HTTP_DIGEST_NC, req->qop,
-				    req->algorithm, req->cnonce );
+				    "nc=%s", req->qop, req->algorithm,
+				    req->cnonce, req->nc );
 	}
 	used += ssnprintf ( ( buf + used ), ( len - used ),
 			    ", response=\"%s\"", req->response );
@@ -303,6 +308,7 @@ struct http_authentication http_digest_auth __http_authentication = {
 	.parse = http_parse_digest_auth,
 	.authenticate = http_digest_authenticate,
 	.format = http_format_digest_auth,
+	.preemptive = 1,
 };
 
 /* Drag in HTTP authentication support */
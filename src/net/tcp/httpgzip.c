@@ -0,0 +1,222 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+FILE_SECBOOT ( PERMITTED );
+
+/**
+ * @file
+ *
+ * Hyper Text Transfer Protocol (HTTP) gzip and deflate content encodings
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <byteswap.h>
+#include <ipxe/http.h>
+#include <ipxe/xferbuf.h>
+#include <ipxe/settings.h>
+#include <ipxe/inflate.h>
+#include <ipxe/deflate.h>
+#include <ipxe/gzip.h>
+#include <ipxe/crc32.h>
+
+/** Request content upload stages */
+enum http_upload_stage {
+	/** Sending gzip header */
+	HTTP_UPLOAD_HEADER = 0,
+	/** Sending compressed data */
+	HTTP_UPLOAD_DATA,
+	/** Sending gzip footer */
+	HTTP_UPLOAD_FOOTER,
+	/** Upload complete */
+	HTTP_UPLOAD_DONE,
+};
+
+/** Compressed request content upload state */
+struct http_upload {
+	/** Compressor */
+	struct deflate_encoder encoder;
+	/** CRC-32 of content compressed so far */
+	uint32_t crc;
+	/** Upload stage */
+	enum http_upload_stage stage;
+};
+
+/** Compressed content encodings are globally enabled */
+static long http_gzip_enabled;
+
+/**
+ * Check whether or not to support compressed encodings for this request
+ *
+ * @v http		HTTP transaction
+ * @ret supported	Compressed encodings are supported for this request
+ */
+static int http_gzip_supported ( struct http_transaction *http ) {
+
+	/* Compressed encodings must be explicitly enabled */
+	if ( ! http_gzip_enabled )
+		return 0;
+
+	/* Range requests (e.g. for HTTP block devices or parallel
+	 * downloads) must retrieve the original unencoded content.
+	 */
+	if ( http->request.range.len )
+		return 0;
+
+	/* The decompressor writes directly into the underlying data
+	 * transfer buffer, since it requires access to previously
+	 * decompressed data.
+	 */
+	return ( xfer_buffer ( &http->xfer ) != NULL );
+}
+
+/**
+ * Initialise compressed content encoding
+ *
+ * @v http		HTTP transaction
+ * @ret rc		Return status code
+ */
+static int http_gzip_init ( struct http_transaction *http ) {
+
+	return add_inflate ( &http->content );
+}
+
+/** gzip HTTP content encoding */
+struct http_content_encoding http_gzip_encoding __http_content_encoding = {
+	.name = "gzip",
+	.supported = http_gzip_supported,
+	.init = http_gzip_init,
+};
+
+/** deflate (i.e. zlib) HTTP content encoding */
+struct http_content_encoding http_deflate_encoding __http_content_encoding = {
+	.name = "deflate",
+	.supported = http_gzip_supported,
+	.init = http_gzip_init,
+};
+
+/** Compressed content encodings enabled setting */
+const struct setting http_gzip_setting __setting ( SETTING_MISC,
+						   http-gzip ) = {
+	.name = "http-gzip",
+	.description = "HTTP compressed content encodings enabled",
+	.type = &setting_type_int8,
+};
+
+/**
+ * Apply compressed content encoding settings
+ *
+ * @ret rc		Return status code
+ */
+static int apply_http_gzip_settings ( void ) {
+
+	/* Fetch global enabled setting */
+	if ( fetch_int_setting ( NULL, &http_gzip_setting,
+				 &http_gzip_enabled ) < 0 ) {
+		http_gzip_enabled = 0;
+	}
+	DBGC ( &http_gzip_enabled, "HTTPGZIP is %s\n",
+	       ( http_gzip_enabled ? "enabled" : "disabled" ) );
+
+	return 0;
+}
+
+/** Compressed content encoding settings applicator */
+struct settings_applicator http_gzip_applicator __settings_applicator = {
+	.apply = apply_http_gzip_settings,
+};
+
+/* Drag in decompression filter */
+REQUIRING_SYMBOL ( http_gzip_encoding );
+REQUIRE_OBJECT ( inflate );
+
+/**
+ * Generate compressed request content
+ *
+ * @v http		HTTP transaction
+ * @v data		Buffer to fill in
+ * @v len		Length of buffer, updated to length used
+ * @ret rc		Return status code
+ *
+ * Returns -EINPROGRESS if more content remains to be generated.
+ */
+int http_gzip_upload ( struct http_transaction *http, void *data,
+		       size_t *len ) {
+	struct http_request_content *content = &http->request.content;
+	struct http_upload *upload = http->upload;
+	struct gzip_header *header;
+	struct gzip_footer *footer;
+	struct deflate_chunk out;
+	size_t offset;
+
+	/* Allocate and initialise upload state, if applicable */
+	if ( ! upload ) {
+		upload = malloc ( sizeof ( *upload ) );
+		if ( ! upload )
+			return -ENOMEM;
+		deflate_encode_init ( &upload->encoder, content->data,
+				      content->len );
+		upload->crc = 0xffffffffUL;
+		upload->stage = HTTP_UPLOAD_HEADER;
+		http->upload = upload;
+	}
+	deflate_chunk_init ( &out, data, 0, *len );
+
+	/* Construct header */
+	if ( ( upload->stage == HTTP_UPLOAD_HEADER ) &&
+	     ( ( out.len - out.offset ) >= sizeof ( *header ) ) ) {
+		header = ( data + out.offset );
+		memset ( header, 0, sizeof ( *header ) );
+		header->magic = cpu_to_be16 ( GZIP_MAGIC );
+		header->method = GZIP_METHOD_DEFLATE;
+		header->os = GZIP_OS_UNKNOWN;
+		out.offset += sizeof ( *header );
+		upload->stage = HTTP_UPLOAD_DATA;
+	}
+
+	/* Compress as much data as will fit */
+	if ( upload->stage == HTTP_UPLOAD_DATA ) {
+		offset = upload->encoder.offset;
+		deflate_encode ( &upload->encoder, &out );
+		upload->crc = crc32_le ( upload->crc, ( content->data + offset ),
+					 ( upload->encoder.offset - offset ) );
+		if ( deflate_encode_finished ( &upload->encoder ) )
+			upload->stage = HTTP_UPLOAD_FOOTER;
+	}
+
+	/* Construct footer */
+	if ( ( upload->stage == HTTP_UPLOAD_FOOTER ) &&
+	     ( ( out.len - out.offset ) >= sizeof ( *footer ) ) ) {
+		footer = ( data + out.offset );
+		footer->crc = cpu_to_le32 ( ~upload->crc );
+		footer->len = cpu_to_le32 ( content->len );
+		out.offset += sizeof ( *footer );
+		upload->stage = HTTP_UPLOAD_DONE;
+	}
+
+	*len = out.offset;
+	return ( ( upload->stage == HTTP_UPLOAD_DONE ) ? 0 : -EINPROGRESS );
+}
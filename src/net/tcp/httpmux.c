@@ -0,0 +1,518 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+FILE_SECBOOT ( PERMITTED );
+
+/**
+ * @file
+ *
+ * Hyper Text Transfer Protocol (HTTP) parallel range downloads
+ *
+ * A large download may be split into several concurrent range
+ * requests, each carried over its own (pooled) HTTP connection.  The
+ * initial request is an ordinary GET for the whole resource.  If the
+ * server indicates that it accepts byte range requests, then the
+ * initial request is truncated after the first chunk and the
+ * remaining chunks are retrieved using concurrent range requests.
+ * All received data is delivered using absolute offsets, and so the
+ * recipient must provide an underlying data transfer buffer.
+ *
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <ipxe/list.h>
+#include <ipxe/uri.h>
+#include <ipxe/iobuf.h>
+#include <ipxe/xfer.h>
+#include <ipxe/open.h>
+#include <ipxe/process.h>
+#include <ipxe/timer.h>
+#include <ipxe/job.h>
+#include <ipxe/xferbuf.h>
+#include <ipxe/settings.h>
+#include <ipxe/http.h>
+
+/** Maximum number of concurrent range requests */
+#define HTTPMUX_MAX_RANGES 16
+
+/** Length of each range request */
+#define HTTPMUX_CHUNK_LEN ( 4 * 1024 * 1024 )
+
+/* Disambiguate the various error causes */
+#define EPROTO_OVERRUN __einfo_error ( EINFO_EPROTO_OVERRUN )
+#define EINFO_EPROTO_OVERRUN \
+	__einfo_uniqify ( EINFO_EPROTO, 0x01, "Range overrun" )
+
+/** An HTTP multiplexed range request */
+struct http_multiplexed_range {
+	/** HTTP download multiplexer */
+	struct http_multiplexer *httpmux;
+	/** List of multiplexed range requests */
+	struct list_head list;
+	/** Data transfer interface */
+	struct interface xfer;
+	/** Starting offset of range */
+	size_t start;
+	/** Ending offset of range (or zero if unlimited) */
+	size_t end;
+	/** Current offset within range */
+	size_t pos;
+};
+
+/** An HTTP download multiplexer */
+struct http_multiplexer {
+	/** Reference count */
+	struct refcnt refcnt;
+	/** Data transfer interface */
+	struct interface xfer;
+	/** Request URI */
+	struct uri *uri;
+
+	/** Maximum number of concurrent range requests */
+	unsigned int count;
+	/** Total content length (or zero if not yet split) */
+	size_t len;
+	/** Offset of next range to be requested */
+	size_t offset;
+	/** Total length of data received */
+	size_t received;
+	/** Download start time (in ticks) */
+	unsigned long started;
+
+	/** Range request initiation process */
+	struct process process;
+	/** List of busy range requests */
+	struct list_head busy;
+	/** List of idle range requests */
+	struct list_head idle;
+	/** Range requests */
+	struct http_multiplexed_range range[HTTPMUX_MAX_RANGES];
+};
+
+/** HTTP parallel download setting */
+const struct setting http_parallel_setting __setting ( SETTING_MISC,
+						       http-parallel ) = {
+	.name = "http-parallel",
+	.description = "HTTP parallel connections",
+	.type = &setting_type_uint8,
+};
+
+/**
+ * Free HTTP download multiplexer
+ *
+ * @v refcnt		Reference count
+ */
+static void httpmux_free ( struct refcnt *refcnt ) {
+	struct http_multiplexer *httpmux =
+		container_of ( refcnt, struct http_multiplexer, refcnt );
+
+	uri_put ( httpmux->uri );
+	free ( httpmux );
+}
+
+/**
+ * Close HTTP download multiplexer
+ *
+ * @v httpmux		HTTP download multiplexer
+ * @v rc		Reason for close
+ */
+static void httpmux_close ( struct http_multiplexer *httpmux, int rc ) {
+	unsigned int i;
+
+	/* Stop range request initiation process */
+	process_del ( &httpmux->process );
+
+	/* Shut down all range requests */
+	for ( i = 0 ; i < HTTPMUX_MAX_RANGES ; i++ )
+		intf_shutdown ( &httpmux->range[i].xfer, rc );
+
+	/* Shut down data transfer interface */
+	intf_shutdown ( &httpmux->xfer, rc );
+}
+
+/**
+ * Report progress of HTTP parallel download
+ *
+ * @v httpmux		HTTP download multiplexer
+ * @v progress		Progress report to fill in
+ * @ret ongoing_rc	Ongoing job status code (if known)
+ */
+static int httpmux_progress ( struct http_multiplexer *httpmux,
+			      struct job_progress *progress ) {
+	struct http_multiplexed_range *mrange;
+	unsigned long elapsed;
+	unsigned long rate;
+	unsigned int active = 0;
+
+	/* Leave progress to the downloader until the download is split */
+	if ( ! httpmux->len )
+		return 0;
+
+	/* Report aggregate progress across all range requests */
+	progress->completed = httpmux->received;
+	progress->total = httpmux->len;
+
+	/* Report aggregate throughput */
+	list_for_each_entry ( mrange, &httpmux->busy, list )
+		active++;
+	elapsed = ( currticks() - httpmux->started );
+	if ( elapsed ) {
+		rate = ( ( ( ( uint64_t ) httpmux->received ) * TICKS_PER_SEC )
+			 / ( elapsed * 1024 ) );
+		snprintf ( progress->message, sizeof ( progress->message ),
+			   "%d conns %ldkB/s", active, rate );
+	}
+
+	return 0;
+}
+
+/**
+ * Initiate multiplexed range request
+ *
+ * @v httpmux		HTTP download multiplexer
+ */
+static void httpmux_step ( struct http_multiplexer *httpmux ) {
+	struct http_multiplexed_range *mrange;
+	struct http_request_range range;
+	int rc;
+
+	/* If all ranges have been requested and there are no
+	 * remaining range requests in progress, then we are finished.
+	 */
+	if ( httpmux->offset >= httpmux->len ) {
+		process_del ( &httpmux->process );
+		if ( list_empty ( &httpmux->busy ) )
+			httpmux_close ( httpmux, 0 );
+		return;
+	}
+
+	/* Stop initiation process if all range requests are busy */
+	mrange = list_first_entry ( &httpmux->idle,
+				    struct http_multiplexed_range, list );
+	if ( ! mrange ) {
+		process_del ( &httpmux->process );
+		return;
+	}
+
+	/* Construct next range */
+	range.start = httpmux->offset;
+	range.len = ( httpmux->len - httpmux->offset );
+	if ( range.len > HTTPMUX_CHUNK_LEN )
+		range.len = HTTPMUX_CHUNK_LEN;
+
+	/* Start range request */
+	if ( ( rc = http_open ( &mrange->xfer, &http_get, httpmux->uri,
+				&range, NULL ) ) != 0 ) {
+		DBGC ( httpmux, "HTTPMUX %p could not request range "
+		       "[%#zx,%#zx): %s\n", httpmux, range.start,
+		       ( range.start + range.len ), strerror ( rc ) );
+		goto err;
+	}
+	mrange->start = range.start;
+	mrange->end = ( range.start + range.len );
+	mrange->pos = 0;
+	httpmux->offset = mrange->end;
+	DBGC2 ( httpmux, "HTTPMUX %p range %d requesting [%#zx,%#zx)\n",
+		httpmux, ( ( unsigned int ) ( mrange - httpmux->range ) ),
+		mrange->start, mrange->end );
+
+	/* Move to list of busy range requests */
+	list_del ( &mrange->list );
+	list_add_tail ( &mrange->list, &httpmux->busy );
+
+	return;
+
+ err:
+	httpmux_close ( httpmux, rc );
+}
+
+/**
+ * Complete multiplexed range request
+ *
+ * @v mrange		HTTP multiplexed range request
+ * @v rc		Reason for close
+ */
+static void httpmux_range_close ( struct http_multiplexed_range *mrange,
+				  int rc ) {
+	struct http_multiplexer *httpmux = mrange->httpmux;
+
+	/* Move to list of idle range requests */
+	list_del ( &mrange->list );
+	list_add_tail ( &mrange->list, &httpmux->idle );
+
+	/* If any error occurred, or if the download was never split,
+	 * then terminate the whole multiplexer.
+	 */
+	if ( ( rc != 0 ) || ( ! httpmux->len ) ) {
+		httpmux_close ( httpmux, rc );
+		return;
+	}
+
+	/* Fail if range was not fully received */
+	if ( ( mrange->start + mrange->pos ) < mrange->end ) {
+		DBGC ( httpmux, "HTTPMUX %p range [%#zx,%#zx) underrun at "
+		       "%#zx\n", httpmux, mrange->start, mrange->end,
+		       ( mrange->start + mrange->pos ) );
+		httpmux_close ( httpmux, -EPIPE );
+		return;
+	}
+
+	/* Restart data transfer interface */
+	intf_restart ( &mrange->xfer, rc );
+
+	/* Restart range request initiation process */
+	process_add ( &httpmux->process );
+}
+
+/**
+ * Receive data from multiplexed range request
+ *
+ * @v mrange		HTTP multiplexed range request
+ * @v iobuf		I/O buffer
+ * @v meta		Data transfer metadata
+ * @ret rc		Return status code
+ */
+static int httpmux_range_deliver ( struct http_multiplexed_range *mrange,
+				   struct io_buffer *iobuf,
+				   struct xfer_metadata *meta ) {
+	struct http_multiplexer *httpmux = mrange->httpmux;
+	struct xfer_metadata abs_meta;
+	size_t len = iob_len ( iobuf );
+	size_t pos;
+	int complete = 0;
+	int rc;
+
+	/* Calculate position within range */
+	pos = ( ( meta->flags & XFER_FL_ABS_OFFSET ) ? 0 : mrange->pos );
+	pos += meta->offset;
+
+	/* Truncate data at end of range, if applicable */
+	if ( mrange->end && len &&
+	     ( ( mrange->start + pos + len ) >= mrange->end ) ) {
+		if ( ( mrange->start + pos ) >= mrange->end ) {
+			/* Data lies entirely beyond range */
+			len = 0;
+		} else {
+			len = ( mrange->end - mrange->start - pos );
+		}
+		if ( mrange->start ) {
+			/* Only the initial request may be truncated */
+			if ( len < iob_len ( iobuf ) ) {
+				DBGC ( httpmux, "HTTPMUX %p range [%#zx,%#zx) "
+				       "overrun\n", httpmux, mrange->start,
+				       mrange->end );
+				rc = -EPROTO_OVERRUN;
+				goto err;
+			}
+		}
+		iob_unput ( iobuf, ( iob_len ( iobuf ) - len ) );
+		complete = 1;
+	}
+
+	/* Update positions */
+	mrange->pos = ( pos + len );
+	httpmux->received += len;
+
+	/* Deliver data using absolute offset */
+	memset ( &abs_meta, 0, sizeof ( abs_meta ) );
+	abs_meta.flags = XFER_FL_ABS_OFFSET;
+	abs_meta.offset = ( mrange->start + pos );
+	if ( ( rc = xfer_deliver ( &httpmux->xfer, iob_disown ( iobuf ),
+				   &abs_meta ) ) != 0 )
+		goto err;
+
+	/* Terminate initial request once it reaches the end of its
+	 * truncated range.
+	 */
+	if ( complete && ( ! mrange->start ) &&
+	     ( mrange->pos == mrange->end ) ) {
+		DBGC2 ( httpmux, "HTTPMUX %p initial request truncated at "
+			"%#zx\n", httpmux, mrange->end );
+		intf_restart ( &mrange->xfer, 0 );
+		httpmux_range_close ( mrange, 0 );
+	}
+
+	return 0;
+
+ err:
+	free_iob ( iobuf );
+	httpmux_close ( httpmux, rc );
+	return rc;
+}
+
+/**
+ * Handle server acceptance of byte range requests
+ *
+ * @v mrange		HTTP multiplexed range request
+ * @v len		Total content length
+ */
+static void httpmux_range_accept ( struct http_multiplexed_range *mrange,
+				   size_t len ) {
+	struct http_multiplexer *httpmux = mrange->httpmux;
+
+	/* Ignore unless this is the initial request (which is the
+	 * only request to start at offset zero).
+	 */
+	if ( httpmux->len || mrange->start )
+		return;
+
+	/* Do not split small downloads */
+	if ( len <= HTTPMUX_CHUNK_LEN )
+		return;
+
+	/* Do not split downloads unless the recipient can accept
+	 * data out of order.
+	 */
+	if ( ! xfer_buffer ( &httpmux->xfer ) ) {
+		DBGC ( httpmux, "HTTPMUX %p has no underlying buffer\n",
+		       httpmux );
+		return;
+	}
+
+	/* Truncate initial request after the first chunk and start
+	 * range requests for the remainder.
+	 */
+	DBGC ( httpmux, "HTTPMUX %p splitting %#zx bytes across %d "
+	       "connections\n", httpmux, len, httpmux->count );
+	httpmux->len = len;
+	mrange->end = HTTPMUX_CHUNK_LEN;
+	httpmux->offset = mrange->end;
+	process_add ( &httpmux->process );
+}
+
+/**
+ * Redirect multiplexed range request
+ *
+ * @v mrange		HTTP multiplexed range request
+ * @v type		New location type
+ * @v args		Remaining arguments depend upon location type
+ * @ret rc		Return status code
+ */
+static int httpmux_range_vredirect ( struct http_multiplexed_range *mrange,
+				     int type, va_list args ) {
+	struct http_multiplexer *httpmux = mrange->httpmux;
+
+	/* Redirect the whole download */
+	return xfer_vredirect ( &httpmux->xfer, type, args );
+}
+
+/** Data transfer interface operations */
+static struct interface_operation httpmux_xfer_operations[] = {
+	INTF_OP ( job_progress, struct http_multiplexer *, httpmux_progress ),
+	INTF_OP ( intf_close, struct http_multiplexer *, httpmux_close ),
+};
+
+/** Data transfer interface descriptor */
+static struct interface_descriptor httpmux_xfer_desc =
+	INTF_DESC ( struct http_multiplexer, xfer, httpmux_xfer_operations );
+
+/** Range request data transfer interface operations */
+static struct interface_operation httpmux_range_operations[] = {
+	INTF_OP ( xfer_deliver, struct http_multiplexed_range *,
+		  httpmux_range_deliver ),
+	INTF_OP ( xfer_vredirect, struct http_multiplexed_range *,
+		  httpmux_range_vredirect ),
+	INTF_OP ( http_accept_ranges, struct http_multiplexed_range *,
+		  httpmux_range_accept ),
+	INTF_OP ( intf_close, struct http_multiplexed_range *,
+		  httpmux_range_close ),
+};
+
+/** Range request data transfer interface descriptor */
+static struct interface_descriptor httpmux_range_desc =
+	INTF_DESC ( struct http_multiplexed_range, xfer,
+		    httpmux_range_operations );
+
+/** Range request initiation process descriptor */
+static struct process_descriptor httpmux_process_desc =
+	PROC_DESC ( struct http_multiplexer, process, httpmux_step );
+
+/**
+ * Open HTTP GET download, using parallel range requests if enabled
+ *
+ * @v xfer		Data transfer interface
+ * @v uri		Request URI
+ * @ret rc		Return status code
+ */
+int httpmux_open ( struct interface *xfer, struct uri *uri ) {
+	struct http_multiplexer *httpmux;
+	struct http_multiplexed_range *mrange;
+	unsigned long count;
+	unsigned int i;
+	int rc;
+
+	/* Use parallel downloads only if explicitly enabled */
+	if ( ( fetch_uint_setting ( NULL, &http_parallel_setting,
+				    &count ) < 0 ) || ( count < 2 ) ) {
+		return http_open ( xfer, &http_get, uri, NULL, NULL );
+	}
+	if ( count > HTTPMUX_MAX_RANGES )
+		count = HTTPMUX_MAX_RANGES;
+
+	/* Allocate and initialise structure */
+	httpmux = zalloc ( sizeof ( *httpmux ) );
+	if ( ! httpmux ) {
+		rc = -ENOMEM;
+		goto err_alloc;
+	}
+	ref_init ( &httpmux->refcnt, httpmux_free );
+	intf_init ( &httpmux->xfer, &httpmux_xfer_desc, &httpmux->refcnt );
+	httpmux->uri = uri_get ( uri );
+	httpmux->count = count;
+	httpmux->started = currticks();
+	process_init_stopped ( &httpmux->process, &httpmux_process_desc,
+			       &httpmux->refcnt );
+	INIT_LIST_HEAD ( &httpmux->busy );
+	INIT_LIST_HEAD ( &httpmux->idle );
+	for ( i = 0 ; i < HTTPMUX_MAX_RANGES ; i++ ) {
+		mrange = &httpmux->range[i];
+		mrange->httpmux = httpmux;
+		intf_init ( &mrange->xfer, &httpmux_range_desc,
+			    &httpmux->refcnt );
+		if ( i < count )
+			list_add_tail ( &mrange->list, &httpmux->idle );
+	}
+
+	/* Start initial request for the whole resource */
+	mrange = &httpmux->range[0];
+	if ( ( rc = http_open ( &mrange->xfer, &http_get, uri, NULL,
+				NULL ) ) != 0 )
+		goto err_open;
+	list_del ( &mrange->list );
+	list_add_tail ( &mrange->list, &httpmux->busy );
+
+	/* Attach to parent interface, mortalise self, and return */
+	intf_plug_plug ( &httpmux->xfer, xfer );
+	ref_put ( &httpmux->refcnt );
+	return 0;
+
+ err_open:
+	httpmux_close ( httpmux, rc );
+	ref_put ( &httpmux->refcnt );
+ err_alloc:
+	return rc;
+}
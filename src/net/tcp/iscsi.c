@@ -47,6 +47,7 @@ FILE_SECBOOT ( PERMITTED );
 #include <ipxe/base64.h>
 #include <ipxe/ibft.h>
 #include <ipxe/blockdev.h>
+#include <ipxe/crc32.h>
 #include <ipxe/efi/efi_path.h>
 #include <ipxe/iscsi.h>
 
@@ -91,6 +92,23 @@ FEATURE ( FEATURE_PROTOCOL, "iSCSI", DHCP_EB_FEATURE_ISCSI, 1 );
 	__einfo_error ( EINFO_EINVAL_MAXBURSTLENGTH )
 #define EINFO_EINVAL_MAXBURSTLENGTH \
 	__einfo_uniqify ( EINFO_EINVAL, 0x06, "Invalid MaxBurstLength" )
+#define EINVAL_FIRSTBURSTLENGTH				\
+	__einfo_error ( EINFO_EINVAL_FIRSTBURSTLENGTH )
+#define EINFO_EINVAL_FIRSTBURSTLENGTH \
+	__einfo_uniqify ( EINFO_EINVAL, 0x07, "Invalid FirstBurstLength" )
+#define EINVAL_MAXRECVDATASEGMENTLENGTH			\
+	__einfo_error ( EINFO_EINVAL_MAXRECVDATASEGMENTLENGTH )
+#define EINFO_EINVAL_MAXRECVDATASEGMENTLENGTH				\
+	__einfo_uniqify ( EINFO_EINVAL, 0x08,				\
+			  "Invalid MaxRecvDataSegmentLength" )
+#define EINVAL_BOOLEAN					\
+	__einfo_error ( EINFO_EINVAL_BOOLEAN )
+#define EINFO_EINVAL_BOOLEAN \
+	__einfo_uniqify ( EINFO_EINVAL, 0x09, "Invalid boolean value" )
+#define EINVAL_MAXCONNECTIONS				\
+	__einfo_error ( EINFO_EINVAL_MAXCONNECTIONS )
+#define EINFO_EINVAL_MAXCONNECTIONS \
+	__einfo_uniqify ( EINFO_EINVAL, 0x0a, "Invalid MaxConnections" )
 #define EIO_TARGET_UNAVAILABLE \
 	__einfo_error ( EINFO_EIO_TARGET_UNAVAILABLE )
 #define EINFO_EIO_TARGET_UNAVAILABLE \
@@ -99,6 +117,10 @@ FEATURE ( FEATURE_PROTOCOL, "iSCSI", DHCP_EB_FEATURE_ISCSI, 1 );
 	__einfo_error ( EINFO_EIO_TARGET_NO_RESOURCES )
 #define EINFO_EIO_TARGET_NO_RESOURCES \
 	__einfo_uniqify ( EINFO_EIO, 0x02, "Target out of resources" )
+#define EIO_DIGEST \
+	__einfo_error ( EINFO_EIO_DIGEST )
+#define EINFO_EIO_DIGEST \
+	__einfo_uniqify ( EINFO_EIO, 0x03, "Digest mismatch" )
 #define ENOTSUP_INITIATOR_STATUS \
 	__einfo_error ( EINFO_ENOTSUP_INITIATOR_STATUS )
 #define EINFO_ENOTSUP_INITIATOR_STATUS \
@@ -147,11 +169,56 @@ FEATURE ( FEATURE_PROTOCOL, "iSCSI", DHCP_EB_FEATURE_ISCSI, 1 );
 	__einfo_error ( EINFO_EPROTO_VALUE_REJECTED )
 #define EINFO_EPROTO_VALUE_REJECTED					\
 	__einfo_uniqify ( EINFO_EPROTO, 0x06, "Parameter rejected" )
+#define EPROTO_INVALID_DIGEST \
+	__einfo_error ( EINFO_EPROTO_INVALID_DIGEST )
+#define EINFO_EPROTO_INVALID_DIGEST \
+	__einfo_uniqify ( EINFO_EPROTO, 0x07, "Invalid digest" )
 
 static void iscsi_start_tx ( struct iscsi_session *iscsi );
 static void iscsi_start_login ( struct iscsi_session *iscsi );
-static void iscsi_start_data_out ( struct iscsi_session *iscsi,
-				   unsigned int datasn );
+static void iscsi_tx_resume ( struct iscsi_session *iscsi );
+static void iscsi_open_connections ( struct iscsi_session *leader );
+
+/**
+ * Get leading connection
+ *
+ * @v iscsi		iSCSI session
+ * @ret leader		Leading connection
+ */
+static inline __attribute__ (( always_inline )) struct iscsi_session *
+iscsi_leader ( struct iscsi_session *iscsi ) {
+
+	return ( iscsi->leader ? iscsi->leader : iscsi );
+}
+
+/**
+ * Calculate header or data digest
+ *
+ * @v data		Data
+ * @v len		Length of data
+ * @ret digest		Digest (in wire byte order)
+ */
+static uint32_t iscsi_digest ( const void *data, size_t len ) {
+
+	return cpu_to_le32 ( ~crc32c_le ( 0xffffffffUL, data, len ) );
+}
+
+/**
+ * Get digests in use
+ *
+ * @v iscsi		iSCSI session
+ * @ret digests		Digests in use (as ISCSI_STATUS_XXX_DIGEST flags)
+ *
+ * Negotiated digests apply only to PDUs within the full feature
+ * phase.
+ */
+static int iscsi_digests ( struct iscsi_session *iscsi ) {
+
+	if ( ( iscsi->status & ISCSI_STATUS_PHASE_MASK ) !=
+	     ISCSI_STATUS_FULL_FEATURE_PHASE )
+		return 0;
+	return ( iscsi->status & ISCSI_STATUS_DIGEST_MASK );
+}
 
 /**
  * Finish receiving PDU data into buffer
@@ -193,6 +260,78 @@ static int iscsi_rx_buffered_data ( struct iscsi_session *iscsi,
 	return 0;
 }
 
+/**
+ * Get reference to iSCSI task
+ *
+ * @v task		iSCSI task
+ * @ret task		iSCSI task
+ */
+static inline __attribute__ (( always_inline )) struct iscsi_task *
+iscsi_task_get ( struct iscsi_task *task ) {
+	ref_get ( &task->refcnt );
+	return task;
+}
+
+/**
+ * Drop reference to iSCSI task
+ *
+ * @v task		iSCSI task
+ */
+static inline __attribute__ (( always_inline )) void
+iscsi_task_put ( struct iscsi_task *task ) {
+	ref_put ( &task->refcnt );
+}
+
+/**
+ * Free iSCSI task
+ *
+ * @v refcnt		Reference counter
+ */
+static void iscsi_task_free ( struct refcnt *refcnt ) {
+	struct iscsi_task *task =
+		container_of ( refcnt, struct iscsi_task, refcnt );
+
+	assert ( list_empty ( &task->list ) );
+
+	ref_put ( &task->iscsi->refcnt );
+	free ( task );
+}
+
+/**
+ * Mark iSCSI task as complete
+ *
+ * @v task		iSCSI task
+ * @v rc		Return status code
+ * @v rsp		SCSI response, if any
+ *
+ * Note that iscsi_task_done() will not close the connection, and
+ * leaves any partially-transmitted PDU for this task intact.
+ */
+static void iscsi_task_done ( struct iscsi_task *task, int rc,
+			      struct scsi_rsp *rsp ) {
+	struct iscsi_session *iscsi = task->iscsi;
+
+	/* Keep task alive until we have finished with it */
+	iscsi_task_get ( task );
+
+	/* Remove from list of outstanding tasks */
+	if ( ! list_empty ( &task->list ) ) {
+		list_del ( &task->list );
+		INIT_LIST_HEAD ( &task->list );
+		iscsi->count--;
+		iscsi_task_put ( task );
+	}
+
+	/* Send SCSI response, if any */
+	if ( rsp )
+		scsi_response ( &task->data, rsp );
+
+	/* Close SCSI command */
+	intf_shutdown ( &task->data, rc );
+
+	iscsi_task_put ( task );
+}
+
 /**
  * Free iSCSI session
  *
@@ -211,7 +350,11 @@ static void iscsi_free ( struct refcnt *refcnt ) {
 	free ( iscsi->target_password );
 	chap_finish ( &iscsi->chap );
 	iscsi_rx_buffered_data_done ( iscsi );
-	free ( iscsi->command );
+	assert ( list_empty ( &iscsi->tasks ) );
+	assert ( list_empty ( &iscsi->connections ) );
+	assert ( iscsi->tx_task == NULL );
+	if ( iscsi->leader )
+		ref_put ( &iscsi->leader->refcnt );
 	free ( iscsi );
 }
 
@@ -222,6 +365,10 @@ static void iscsi_free ( struct refcnt *refcnt ) {
  * @v rc		Reason for close
  */
 static void iscsi_close ( struct iscsi_session *iscsi, int rc ) {
+	struct iscsi_session *leader = iscsi->leader;
+	struct iscsi_session *conn;
+	struct iscsi_task *task;
+	int active;
 
 	/* A TCP graceful close is still an error from our point of view */
 	if ( rc == 0 )
@@ -232,20 +379,58 @@ static void iscsi_close ( struct iscsi_session *iscsi, int rc ) {
 	/* Stop transmission process */
 	process_del ( &iscsi->process );
 
+	/* Prevent any further commands from being issued */
+	active = ( ( iscsi->status & ISCSI_STATUS_PHASE_MASK ) ==
+		   ISCSI_STATUS_FULL_FEATURE_PHASE );
+	iscsi->status &= ~ISCSI_STATUS_PHASE_MASK;
+
+	/* Abandon any partially-transmitted PDU */
+	iscsi_task_put ( iscsi->tx_task );
+	iscsi->tx_task = NULL;
+
+	/* Fail any outstanding tasks */
+	while ( ( task = list_first_entry ( &iscsi->tasks, struct iscsi_task,
+					    list ) ) != NULL ) {
+		iscsi_task_done ( task, rc, NULL );
+	}
+
+	/* Close any additional connections */
+	while ( ( conn = list_first_entry ( &iscsi->connections,
+					    struct iscsi_session,
+					    list ) ) != NULL ) {
+		iscsi_close ( conn, rc );
+	}
+
 	/* Shut down interfaces */
-	intfs_shutdown ( rc, &iscsi->socket, &iscsi->control, &iscsi->data,
-			 NULL );
+	intfs_shutdown ( rc, &iscsi->socket, &iscsi->control, NULL );
+
+	/* Detach additional connection from leading connection */
+	if ( leader && ( ! list_empty ( &iscsi->list ) ) ) {
+		list_del ( &iscsi->list );
+		INIT_LIST_HEAD ( &iscsi->list );
+
+		/* We do not support connection recovery, so failure of
+		 * a connection that was in use is fatal to the whole
+		 * session.  (A connection that fails to log in is
+		 * simply abandoned.)
+		 */
+		if ( active && ( ( leader->status & ISCSI_STATUS_PHASE_MASK )
+				 == ISCSI_STATUS_FULL_FEATURE_PHASE ) ) {
+			iscsi_close ( leader, rc );
+		}
+		ref_put ( &iscsi->refcnt );
+	}
 }
 
 /**
  * Assign new iSCSI initiator task tag
  *
- * @v iscsi		iSCSI session
+ * @ret itt		Initiator task tag
  */
-static void iscsi_new_itt ( struct iscsi_session *iscsi ) {
+static uint32_t iscsi_new_itt ( void ) {
 	static uint16_t itt_idx;
 
-	iscsi->itt = ( ISCSI_TAG_MAGIC | (++itt_idx) );
+	return ( ISCSI_TAG_MAGIC | (++itt_idx) );
 }
 
 /**
@@ -280,14 +465,26 @@ static int iscsi_open_connection ( struct iscsi_session *iscsi ) {
 	if ( iscsi->target_username )
 		iscsi->status |= ISCSI_STATUS_AUTH_REVERSE_REQUIRED;
 
-	/* Assign new ISID */
-	iscsi->isid_iana_qual = ( random() & 0xffff );
-
 	/* Assign fresh initiator task tag */
-	iscsi_new_itt ( iscsi );
+	iscsi->itt = iscsi_new_itt();
 
 	/* Set default operational parameters */
-	iscsi->max_burst_len = ISCSI_MAX_BURST_LEN;
+	iscsi->max_send_len = ISCSI_DEFAULT_MAX_RECV_DATA_SEG_LEN;
+	if ( iscsi->leader ) {
+		/* Join existing session */
+		iscsi->isid_iana_qual = iscsi->leader->isid_iana_qual;
+		iscsi->status |= ( iscsi->leader->status &
+				   ISCSI_STATUS_SESSION_MASK );
+		iscsi->max_burst_len = iscsi->leader->max_burst_len;
+		iscsi->first_burst_len = iscsi->leader->first_burst_len;
+	} else {
+		/* Assign new ISID */
+		iscsi->isid_iana_qual = ( random() & 0xffff );
+		iscsi->status |= ISCSI_STATUS_INITIAL_R2T;
+		iscsi->max_burst_len = ISCSI_MAX_BURST_LEN;
+		iscsi->first_burst_len = ISCSI_DEFAULT_FIRST_BURST_LEN;
+		iscsi->max_connections = 1;
+	}
 
 	/* Initiate login */
 	iscsi_start_login ( iscsi );
@@ -314,6 +511,8 @@ static void iscsi_close_connection ( struct iscsi_session *iscsi, int rc ) {
 
 	/* Reset TX and RX state machines */
 	iscsi->tx_state = ISCSI_TX_IDLE;
+	iscsi_task_put ( iscsi->tx_task );
+	iscsi->tx_task = NULL;
 	iscsi->rx_state = ISCSI_RX_BHS;
 	iscsi->rx_offset = 0;
 
@@ -323,39 +522,21 @@ static void iscsi_close_connection ( struct iscsi_session *iscsi, int rc ) {
 }
 
 /**
- * Mark iSCSI SCSI operation as complete
+ * Find outstanding iSCSI task
  *
  * @v iscsi		iSCSI session
- * @v rc		Return status code
- * @v rsp		SCSI response, if any
- *
- * Note that iscsi_scsi_done() will not close the connection, and must
- * therefore be called only when the internal state machines are in an
- * appropriate state, otherwise bad things may happen on the next call
- * to iscsi_scsi_command().  The general rule is to call
- * iscsi_scsi_done() only at the end of receiving a PDU; at this point
- * the TX and RX engines should both be idle.
+ * @v itt		Initiator task tag
+ * @ret task		iSCSI task, or NULL if not found
  */
-static void iscsi_scsi_done ( struct iscsi_session *iscsi, int rc,
-			      struct scsi_rsp *rsp ) {
-	uint32_t itt = iscsi->itt;
-
-	assert ( iscsi->tx_state == ISCSI_TX_IDLE );
-
-	/* Clear command */
-	free ( iscsi->command );
-	iscsi->command = NULL;
-
-	/* Send SCSI response, if any */
-	if ( rsp )
-		scsi_response ( &iscsi->data, rsp );
+static struct iscsi_task * iscsi_find_task ( struct iscsi_session *iscsi,
+					     uint32_t itt ) {
+	struct iscsi_task *task;
 
-	/* Close SCSI command, if this is still the same command.  (It
-	 * is possible that the command interface has already been
-	 * closed as a result of the SCSI response we sent.)
-	 */
-	if ( iscsi->itt == itt )
-		intf_restart ( &iscsi->data, rc );
+	list_for_each_entry ( task, &iscsi->tasks, list ) {
+		if ( task->itt == itt )
+			return task;
+	}
+	return NULL;
 }
 
 /****************************************************************************
@@ -368,41 +549,77 @@ static void iscsi_scsi_done ( struct iscsi_session *iscsi, int rc,
  * Build iSCSI SCSI command BHS
  *
  * @v iscsi		iSCSI session
+ * @v task		iSCSI task
  *
  * We don't currently support bidirectional commands (i.e. with both
  * Data-In and Data-Out segments); these would require providing code
  * to generate an AHS, and there doesn't seem to be any need for it at
  * the moment.
+ *
+ * For write commands, as much data as permitted by the negotiated
+ * ImmediateData and FirstBurstLength is sent within the command PDU
+ * itself, and any further unsolicited data is queued as a data-out
+ * sequence (if permitted by the negotiated InitialR2T).
  */
-static void iscsi_start_command ( struct iscsi_session *iscsi ) {
+static void iscsi_start_command ( struct iscsi_session *iscsi,
+				  struct iscsi_task *task ) {
 	struct iscsi_bhs_scsi_command *command = &iscsi->tx_bhs.scsi_command;
-
-	assert ( ! ( iscsi->command->data_in && iscsi->command->data_out ) );
+	struct iscsi_session *leader = iscsi_leader ( iscsi );
+	struct scsi_cmd *cmd = &task->command;
+	size_t burst_len;
+	size_t immediate_len = 0;
+
+	assert ( ! ( cmd->data_in && cmd->data_out ) );
+
+	/* Calculate immediate and unsolicited data lengths */
+	if ( cmd->data_out ) {
+		burst_len = cmd->data_out_len;
+		if ( burst_len > iscsi->first_burst_len )
+			burst_len = iscsi->first_burst_len;
+		if ( iscsi->status & ISCSI_STATUS_IMMEDIATE_DATA ) {
+			immediate_len = burst_len;
+			if ( immediate_len > iscsi->max_send_len )
+				immediate_len = iscsi->max_send_len;
+			if ( immediate_len > ISCSI_MAX_SEND_DATA_SEG_LEN )
+				immediate_len = ISCSI_MAX_SEND_DATA_SEG_LEN;
+		}
+		if ( ( ! ( iscsi->status & ISCSI_STATUS_INITIAL_R2T ) ) &&
+		     ( immediate_len < burst_len ) ) {
+			task->ttt = ISCSI_TAG_RESERVED;
+			task->offset = immediate_len;
+			task->end = burst_len;
+			task->datasn = 0;
+			task->pending |= ISCSI_TASK_TX_DATA_OUT;
+		}
+	}
 
 	/* Construct BHS and initiate transmission */
 	iscsi_start_tx ( iscsi );
+	iscsi->tx_task = iscsi_task_get ( task );
 	command->opcode = ISCSI_OPCODE_SCSI_COMMAND;
-	command->flags = ( ISCSI_FLAG_FINAL |
-			   ISCSI_COMMAND_ATTR_SIMPLE );
-	if ( iscsi->command->data_in )
+	command->flags = ISCSI_COMMAND_ATTR_SIMPLE;
+	if ( ! ( task->pending & ISCSI_TASK_TX_DATA_OUT ) )
+		command->flags |= ISCSI_FLAG_FINAL;
+	if ( cmd->data_in )
 		command->flags |= ISCSI_COMMAND_FLAG_READ;
-	if ( iscsi->command->data_out )
+	if ( cmd->data_out )
 		command->flags |= ISCSI_COMMAND_FLAG_WRITE;
-	/* lengths left as zero */
-	memcpy ( &command->lun, &iscsi->command->lun,
-		 sizeof ( command->lun ) );
-	command->itt = htonl ( iscsi->itt );
-	command->exp_len = htonl ( iscsi->command->data_in_len |
-				   iscsi->command->data_out_len );
-	command->cmdsn = htonl ( iscsi->cmdsn );
+	ISCSI_SET_LENGTHS ( command->lengths, 0, immediate_len );
+	memcpy ( &command->lun, &cmd->lun, sizeof ( command->lun ) );
+	command->itt = htonl ( task->itt );
+	command->exp_len = htonl ( cmd->data_in_len | cmd->data_out_len );
+	command->cmdsn = htonl ( leader->cmdsn );
 	command->expstatsn = htonl ( iscsi->statsn + 1 );
-	memcpy ( &command->cdb, &iscsi->command->cdb, sizeof ( command->cdb ));
-	DBGC2 ( iscsi, "iSCSI %p start " SCSI_CDB_FORMAT " %s %#zx\n",
-		iscsi, SCSI_CDB_DATA ( command->cdb ),
-		( iscsi->command->data_in ? "in" : "out" ),
-		( iscsi->command->data_in ?
-		  iscsi->command->data_in_len :
-		  iscsi->command->data_out_len ) );
+	memcpy ( &command->cdb, &cmd->cdb, sizeof ( command->cdb ));
+	DBGC2 ( iscsi, "iSCSI %p tag %08x CmdSN %#x start " SCSI_CDB_FORMAT
+		" %s %#zx\n", iscsi, task->itt, leader->cmdsn,
+		SCSI_CDB_DATA ( command->cdb ),
+		( cmd->data_in ? "in" : "out" ),
+		( cmd->data_in ? cmd->data_in_len : cmd->data_out_len ) );
+
+	/* Consume (session-wide) command sequence number */
+	leader->cmdsn++;
+	task->pending &= ~ISCSI_TASK_TX_COMMAND;
 }
 
 /**
@@ -419,6 +636,7 @@ static int iscsi_rx_scsi_response ( struct iscsi_session *iscsi,
 				    size_t remaining ) {
 	struct iscsi_bhs_scsi_response *response
 		= &iscsi->rx_bhs.scsi_response;
+	struct iscsi_task *task;
 	struct scsi_rsp rsp;
 	uint32_t residual_count;
 	size_t data_len;
@@ -453,8 +671,16 @@ static int iscsi_rx_scsi_response ( struct iscsi_session *iscsi,
 	if ( response->response != ISCSI_RESPONSE_COMMAND_COMPLETE )
 		return -EIO;
 
+	/* Identify task */
+	task = iscsi_find_task ( iscsi, ntohl ( response->itt ) );
+	if ( ! task ) {
+		DBGC ( iscsi, "iSCSI %p response for unknown tag %08x\n",
+		       iscsi, ntohl ( response->itt ) );
+		return -EPROTO;
+	}
+
 	/* Mark as completed */
-	iscsi_scsi_done ( iscsi, 0, &rsp );
+	iscsi_task_done ( task, 0, &rsp );
 	return 0;
 }
 
@@ -471,14 +697,26 @@ static int iscsi_rx_data_in ( struct iscsi_session *iscsi,
 			      const void *data, size_t len,
 			      size_t remaining ) {
 	struct iscsi_bhs_data_in *data_in = &iscsi->rx_bhs.data_in;
+	struct iscsi_task *task;
 	unsigned long offset;
 
+	/* Identify task */
+	task = iscsi_find_task ( iscsi, ntohl ( data_in->itt ) );
+	if ( ! task ) {
+		DBGC ( iscsi, "iSCSI %p data-in for unknown tag %08x\n",
+		       iscsi, ntohl ( data_in->itt ) );
+		return -EPROTO;
+	}
+
 	/* Copy data to data-in buffer */
 	offset = ntohl ( data_in->offset ) + iscsi->rx_offset;
-	assert ( iscsi->command != NULL );
-	assert ( iscsi->command->data_in );
-	assert ( ( offset + len ) <= iscsi->command->data_in_len );
-	memcpy ( ( iscsi->command->data_in + offset ), data, len );
+	if ( ( task->command.data_in == NULL ) ||
+	     ( ( offset + len ) > task->command.data_in_len ) ) {
+		DBGC ( iscsi, "iSCSI %p tag %08x data-in overrun\n",
+		       iscsi, task->itt );
+		return -EPROTO;
+	}
+	memcpy ( ( task->command.data_in + offset ), data, len );
 
 	/* Wait for whole SCSI response to arrive */
 	if ( remaining )
@@ -486,15 +724,31 @@ static int iscsi_rx_data_in ( struct iscsi_session *iscsi,
 
 	/* Mark as completed if status is present */
 	if ( data_in->flags & ISCSI_DATA_FLAG_STATUS ) {
-		assert ( ( offset + len ) == iscsi->command->data_in_len );
+		assert ( ( offset + len ) == task->command.data_in_len );
 		assert ( data_in->flags & ISCSI_FLAG_FINAL );
 		/* iSCSI cannot return an error status via a data-in */
-		iscsi_scsi_done ( iscsi, 0, NULL );
+		iscsi_task_done ( task, 0, NULL );
 	}
 
 	return 0;
 }
 
+/**
+ * Start iSCSI data-out sequence for a deferred R2T
+ *
+ * @v task		iSCSI task
+ */
+static void iscsi_task_r2t ( struct iscsi_task *task ) {
+
+	/* Move deferred R2T to current data-out sequence */
+	task->ttt = task->r2t_ttt;
+	task->offset = task->r2t_offset;
+	task->end = ( task->r2t_offset + task->r2t_len );
+	task->datasn = 0;
+	task->pending &= ~ISCSI_TASK_TX_R2T;
+	task->pending |= ISCSI_TASK_TX_DATA_OUT;
+}
+
 /**
  * Receive data segment of an iSCSI R2T PDU
  *
@@ -508,12 +762,44 @@ static int iscsi_rx_r2t ( struct iscsi_session *iscsi,
 			  const void *data __unused, size_t len __unused,
 			  size_t remaining __unused ) {
 	struct iscsi_bhs_r2t *r2t = &iscsi->rx_bhs.r2t;
+	struct iscsi_task *task;
+	uint32_t offset;
+	uint32_t xfer_len;
+
+	/* Identify task */
+	task = iscsi_find_task ( iscsi, ntohl ( r2t->itt ) );
+	if ( ! task ) {
+		DBGC ( iscsi, "iSCSI %p R2T for unknown tag %08x\n",
+		       iscsi, ntohl ( r2t->itt ) );
+		return -EPROTO;
+	}
 
-	/* Record transfer parameters and trigger first data-out */
-	iscsi->ttt = ntohl ( r2t->ttt );
-	iscsi->transfer_offset = ntohl ( r2t->offset );
-	iscsi->transfer_len = ntohl ( r2t->len );
-	iscsi_start_data_out ( iscsi, 0 );
+	/* Sanity check */
+	offset = ntohl ( r2t->offset );
+	xfer_len = ntohl ( r2t->len );
+	if ( ( task->command.data_out == NULL ) ||
+	     ( offset > task->command.data_out_len ) ||
+	     ( xfer_len > ( task->command.data_out_len - offset ) ) ||
+	     ( task->pending & ISCSI_TASK_TX_R2T ) ) {
+		DBGC ( iscsi, "iSCSI %p tag %08x invalid R2T %#x+%#x\n",
+		       iscsi, task->itt, offset, xfer_len );
+		return -EPROTO;
+	}
+
+	/* Record transfer parameters.  The R2T is deferred if an
+	 * unsolicited data-out sequence is still in progress.
+	 */
+	task->r2t_ttt = ntohl ( r2t->ttt );
+	task->r2t_offset = offset;
+	task->r2t_len = xfer_len;
+	task->pending |= ISCSI_TASK_TX_R2T;
+	if ( ! ( task->pending & ( ISCSI_TASK_TX_COMMAND |
+				   ISCSI_TASK_TX_DATA_OUT ) ) ) {
+		iscsi_task_r2t ( task );
+	}
+
+	/* Trigger transmission */
+	iscsi_tx_resume ( iscsi );
 
 	return 0;
 }
@@ -522,55 +808,48 @@ static int iscsi_rx_r2t ( struct iscsi_session *iscsi,
  * Build iSCSI data-out BHS
  *
  * @v iscsi		iSCSI session
- * @v datasn		Data sequence number within the transfer
- *
+ * @v task		iSCSI task
  */
 static void iscsi_start_data_out ( struct iscsi_session *iscsi,
-				   unsigned int datasn ) {
+				   struct iscsi_task *task ) {
 	struct iscsi_bhs_data_out *data_out = &iscsi->tx_bhs.data_out;
-	unsigned long offset;
 	unsigned long remaining;
 	unsigned long len;
 
-	/* We always send 512-byte Data-Out PDUs; this removes the
-	 * need to worry about the target's MaxRecvDataSegmentLength.
-	 */
-	offset = datasn * 512;
-	remaining = iscsi->transfer_len - offset;
+	/* Limit PDU to the target's MaxRecvDataSegmentLength */
+	remaining = ( task->end - task->offset );
 	len = remaining;
-	if ( len > 512 )
-		len = 512;
+	if ( len > iscsi->max_send_len )
+		len = iscsi->max_send_len;
+	if ( len > ISCSI_MAX_SEND_DATA_SEG_LEN )
+		len = ISCSI_MAX_SEND_DATA_SEG_LEN;
 
 	/* Construct BHS and initiate transmission */
 	iscsi_start_tx ( iscsi );
+	iscsi->tx_task = iscsi_task_get ( task );
 	data_out->opcode = ISCSI_OPCODE_DATA_OUT;
 	if ( len == remaining )
 		data_out->flags = ( ISCSI_FLAG_FINAL );
 	ISCSI_SET_LENGTHS ( data_out->lengths, 0, len );
-	data_out->lun = iscsi->command->lun;
-	data_out->itt = htonl ( iscsi->itt );
-	data_out->ttt = htonl ( iscsi->ttt );
+	data_out->lun = task->command.lun;
+	data_out->itt = htonl ( task->itt );
+	data_out->ttt = htonl ( task->ttt );
 	data_out->expstatsn = htonl ( iscsi->statsn + 1 );
-	data_out->datasn = htonl ( datasn );
-	data_out->offset = htonl ( iscsi->transfer_offset + offset );
-	DBGC ( iscsi, "iSCSI %p start data out DataSN %#x len %#lx\n",
-	       iscsi, datasn, len );
-}
+	data_out->datasn = htonl ( task->datasn );
+	data_out->offset = htonl ( task->offset );
+	DBGC ( iscsi, "iSCSI %p tag %08x start data out DataSN %#x len "
+	       "%#lx\n", iscsi, task->itt, task->datasn, len );
 
-/**
- * Complete iSCSI data-out PDU transmission
- *
- * @v iscsi		iSCSI session
- *
- */
-static void iscsi_data_out_done ( struct iscsi_session *iscsi ) {
-	struct iscsi_bhs_data_out *data_out = &iscsi->tx_bhs.data_out;
+	/* Move to next PDU within sequence */
+	task->offset += len;
+	task->datasn++;
 
-	/* If we haven't reached the end of the sequence, start
-	 * sending the next data-out PDU.
-	 */
-	if ( ! ( data_out->flags & ISCSI_FLAG_FINAL ) )
-		iscsi_start_data_out ( iscsi, ntohl ( data_out->datasn ) + 1 );
+	/* Start any deferred R2T once this sequence is complete */
+	if ( len == remaining ) {
+		task->pending &= ~ISCSI_TASK_TX_DATA_OUT;
+		if ( task->pending & ISCSI_TASK_TX_R2T )
+			iscsi_task_r2t ( task );
+	}
 }
 
 /**
@@ -578,33 +857,89 @@ static void iscsi_data_out_done ( struct iscsi_session *iscsi ) {
  *
  * @v iscsi		iSCSI session
  * @ret rc		Return status code
+ *
+ * This handles both data-out PDUs and the immediate data within a
+ * SCSI command PDU.
  */
 static int iscsi_tx_data_out ( struct iscsi_session *iscsi ) {
+	struct iscsi_bhs_common *common = &iscsi->tx_bhs.common;
 	struct iscsi_bhs_data_out *data_out = &iscsi->tx_bhs.data_out;
+	struct scsi_cmd *command;
 	struct io_buffer *iobuf;
 	unsigned long offset;
+	uint32_t digest;
 	size_t len;
 	size_t pad_len;
+	size_t digest_len;
 
-	offset = ntohl ( data_out->offset );
-	len = ISCSI_DATA_LEN ( data_out->lengths );
-	pad_len = ISCSI_DATA_PAD_LEN ( data_out->lengths );
+	offset = ( ( ( common->opcode & ISCSI_OPCODE_MASK ) ==
+		     ISCSI_OPCODE_DATA_OUT ) ? ntohl ( data_out->offset ) : 0 );
+	len = ISCSI_DATA_LEN ( common->lengths );
+	pad_len = ISCSI_DATA_PAD_LEN ( common->lengths );
+	digest_len = ( ( iscsi->tx_digests & ISCSI_STATUS_DATA_DIGEST ) ?
+		       ISCSI_DIGEST_LEN : 0 );
 
-	assert ( iscsi->command != NULL );
-	assert ( iscsi->command->data_out );
-	assert ( ( offset + len ) <= iscsi->command->data_out_len );
+	/* Nothing to send for a command without immediate data */
+	if ( ! len )
+		return 0;
 
-	iobuf = xfer_alloc_iob ( &iscsi->socket, ( len + pad_len ) );
+	assert ( iscsi->tx_task != NULL );
+	command = &iscsi->tx_task->command;
+	assert ( command->data_out );
+	assert ( ( offset + len ) <= command->data_out_len );
+
+	iobuf = xfer_alloc_iob ( &iscsi->socket,
+				 ( len + pad_len + digest_len ) );
 	if ( ! iobuf )
 		return -ENOMEM;
 	
-	memcpy ( iob_put ( iobuf, len ),
-		 ( iscsi->command->data_out + offset ), len );
+	memcpy ( iob_put ( iobuf, len ), ( command->data_out + offset ), len );
 	memset ( iob_put ( iobuf, pad_len ), 0, pad_len );
+	if ( digest_len ) {
+		digest = iscsi_digest ( iobuf->data, iob_len ( iobuf ) );
+		memcpy ( iob_put ( iobuf, sizeof ( digest ) ), &digest,
+			 sizeof ( digest ) );
+	}
 
 	return xfer_deliver_iob ( &iscsi->socket, iobuf );
 }
 
+/**
+ * Start transmitting next pending task PDU, if any
+ *
+ * @v iscsi		iSCSI session
+ *
+ * Data-out PDUs for commands already in progress take priority over
+ * new commands.  New commands are sent in the order in which they
+ * were issued, subject to the command window granted by the target.
+ */
+static void iscsi_tx_next ( struct iscsi_session *iscsi ) {
+	struct iscsi_session *leader = iscsi_leader ( iscsi );
+	struct iscsi_task *task;
+
+	/* Send data-out PDU, if any */
+	list_for_each_entry ( task, &iscsi->tasks, list ) {
+		if ( task->pending & ISCSI_TASK_TX_DATA_OUT ) {
+			iscsi_start_data_out ( iscsi, task );
+			return;
+		}
+	}
+
+	/* Send next command, if permitted by the command window */
+	list_for_each_entry ( task, &iscsi->tasks, list ) {
+		if ( task->pending & ISCSI_TASK_TX_COMMAND ) {
+			if ( ( int32_t ) ( leader->cmdsn -
+					   leader->maxcmdsn ) > 0 ) {
+				DBGC2 ( iscsi, "iSCSI %p waiting for command "
+					"window\n", iscsi );
+				return;
+			}
+			iscsi_start_command ( iscsi, task );
+			return;
+		}
+	}
+}
+
 /**
  * Receive data segment of an iSCSI NOP-In
  *
@@ -651,14 +986,14 @@ static int iscsi_rx_nop_in ( struct iscsi_session *iscsi,
  * These are the initial set of strings sent in the first login
  * request PDU.  We want the following settings:
  *
- *     HeaderDigest=None
- *     DataDigest=None
- *     MaxConnections=1 (irrelevant; we make only one connection anyway) [4]
- *     InitialR2T=Yes [1]
- *     ImmediateData=No (irrelevant; we never send immediate data) [4]
- *     MaxRecvDataSegmentLength=8192 (default; we don't care) [3]
- *     MaxBurstLength=262144 (default; we don't care) [3]
- *     FirstBurstLength=65536 (irrelevant due to other settings) [5]
+ *     HeaderDigest=None,CRC32C [6]
+ *     DataDigest=None,CRC32C [6]
+ *     MaxConnections=4 [7]
+ *     InitialR2T=No [1]
+ *     ImmediateData=Yes [1]
+ *     MaxRecvDataSegmentLength=262144 [3]
+ *     MaxBurstLength=1048576 [3]
+ *     FirstBurstLength=262144 [5]
  *     DefaultTime2Wait=0 [2]
  *     DefaultTime2Retain=0 [2]
  *     MaxOutstandingR2T=1
@@ -666,28 +1001,41 @@ static int iscsi_rx_nop_in ( struct iscsi_session *iscsi,
  *     DataSequenceInOrder=Yes
  *     ErrorRecoveryLevel=0
  *
- * [1] InitialR2T has an OR resolution function, so the target may
- * force us to use it.  We therefore simplify our logic by always
- * using it.
+ * [1] These allow write data to be sent without waiting for an R2T.
+ * InitialR2T has an OR resolution function and ImmediateData has an
+ * AND resolution function, so the target may force us to wait for an
+ * R2T anyway.  We assume the most restrictive values unless the
+ * target explicitly responds otherwise.
  *
  * [2] These ensure that we can safely start a new task once we have
  * reconnected after a failure, without having to manually tidy up
  * after the old one.
  *
- * [3] We are quite happy to use the RFC-defined default values for
- * these parameters, but some targets (notably OpenSolaris)
- * incorrectly assume a default value of zero, so we explicitly
- * specify the default values.
+ * [3] Larger values than the RFC-defined defaults allow each read
+ * command to be satisfied with fewer PDUs.  Some targets (notably
+ * OpenSolaris) incorrectly assume a default value of zero, so these
+ * must always be specified explicitly in any case.
  *
  * [4] We are quite happy to use the RFC-defined default values for
  * these parameters, but some targets (notably a QNAP TS-639Pro) fail
  * unless they are supplied, so we explicitly specify the default
  * values.
  *
- * [5] FirstBurstLength is defined to be irrelevant since we already
- * force InitialR2T=Yes and ImmediateData=No, but some targets
- * (notably LIO as of kernel 4.11) fail unless it is specified, so we
- * explicitly specify the default value.
+ * [5] FirstBurstLength limits the amount of unsolicited (immediate
+ * or data-out) write data.  Some targets (notably LIO as of kernel
+ * 4.11) fail unless it is specified even when it is irrelevant, so
+ * we always specify it explicitly.
+ *
+ * [6] TCP already provides a checksum, so we prefer to avoid the
+ * overhead of digests.  The target will select the first value that
+ * it supports, and so CRC32C digests will be used only if the target
+ * requires them.
+ *
+ * [7] If the target agrees, we open additional connections once the
+ * leading connection reaches the full feature phase, and distribute
+ * commands across all connections.  Additional connections send
+ * only the connection-specific HeaderDigest, DataDigest and
+ * MaxRecvDataSegmentLength keys, and omit SessionType.
  */
 static int iscsi_build_login_request_strings ( struct iscsi_session *iscsi,
 					       void *data, size_t len ) {
@@ -705,12 +1053,15 @@ static int iscsi_build_login_request_strings ( struct iscsi_session *iscsi,
 			auth_method = "CHAP";
 		used += ssnprintf ( data + used, len - used,
 				    "InitiatorName=%s%c"
-				    "TargetName=%s%c"
-				    "SessionType=Normal%c"
-				    "AuthMethod=%s%c",
+				    "TargetName=%s%c",
 				    iscsi->initiator_iqn, 0,
-				    iscsi->target_iqn, 0, 0,
-				    auth_method, 0 );
+				    iscsi->target_iqn, 0 );
+		if ( ! iscsi->leader ) {
+			used += ssnprintf ( data + used, len - used,
+					    "SessionType=Normal%c", 0 );
+		}
+		used += ssnprintf ( data + used, len - used,
+				    "AuthMethod=%s%c", auth_method, 0 );
 	}
 
 	if ( iscsi->status & ISCSI_STATUS_STRINGS_CHAP_ALGORITHM ) {
@@ -737,13 +1088,23 @@ static int iscsi_build_login_request_strings ( struct iscsi_session *iscsi,
 				    iscsi->chap_challenge[0], 0, buf, 0 );
 	}
 
-	if ( iscsi->status & ISCSI_STATUS_STRINGS_OPERATIONAL ) {
+	if ( ( iscsi->status & ISCSI_STATUS_STRINGS_OPERATIONAL ) &&
+	     iscsi->leader ) {
+		/* Additional connections may negotiate only
+		 * connection-specific parameters.
+		 */
+		used += ssnprintf ( data + used, len - used,
+				    "HeaderDigest=None,CRC32C%c"
+				    "DataDigest=None,CRC32C%c"
+				    "MaxRecvDataSegmentLength=%d%c",
+				    0, 0, ISCSI_MAX_RECV_DATA_SEG_LEN, 0 );
+	} else if ( iscsi->status & ISCSI_STATUS_STRINGS_OPERATIONAL ) {
 		used += ssnprintf ( data + used, len - used,
-				    "HeaderDigest=None%c"
-				    "DataDigest=None%c"
-				    "MaxConnections=1%c"
-				    "InitialR2T=Yes%c"
-				    "ImmediateData=No%c"
+				    "HeaderDigest=None,CRC32C%c"
+				    "DataDigest=None,CRC32C%c"
+				    "MaxConnections=%d%c"
+				    "InitialR2T=No%c"
+				    "ImmediateData=Yes%c"
 				    "MaxRecvDataSegmentLength=%d%c"
 				    "MaxBurstLength=%d%c"
 				    "FirstBurstLength=%d%c"
@@ -753,7 +1114,7 @@ static int iscsi_build_login_request_strings ( struct iscsi_session *iscsi,
 				    "DataPDUInOrder=Yes%c"
 				    "DataSequenceInOrder=Yes%c"
 				    "ErrorRecoveryLevel=0%c",
-				    0, 0, 0, 0, 0,
+				    0, 0, ISCSI_MAX_CONNECTIONS, 0, 0, 0,
 				    ISCSI_MAX_RECV_DATA_SEG_LEN, 0,
 				    ISCSI_MAX_BURST_LEN, 0,
 				    ISCSI_FIRST_BURST_LEN, 0,
@@ -797,10 +1158,10 @@ static void iscsi_start_login ( struct iscsi_session *iscsi ) {
 	request->isid_iana_en = htonl ( ISCSI_ISID_IANA |
 					IANA_EN_FEN_SYSTEMS );
 	request->isid_iana_qual = htons ( iscsi->isid_iana_qual );
-	/* tsih left as zero */
+	request->tsih = htons ( iscsi_leader ( iscsi )->tsih );
 	request->itt = htonl ( iscsi->itt );
-	/* cid left as zero */
-	request->cmdsn = htonl ( iscsi->cmdsn );
+	request->cid = htons ( iscsi->cid );
+	request->cmdsn = htonl ( iscsi_leader ( iscsi )->cmdsn );
 	request->expstatsn = htonl ( iscsi->statsn + 1 );
 }
 
@@ -945,6 +1306,194 @@ static int iscsi_handle_maxburstlength_value ( struct iscsi_session *iscsi,
 	return 0;
 }
 
+/**
+ * Handle iSCSI FirstBurstLength text value
+ *
+ * @v iscsi		iSCSI session
+ * @v value		FirstBurstLength value
+ * @ret rc		Return status code
+ */
+static int iscsi_handle_firstburstlength_value ( struct iscsi_session *iscsi,
+						 const char *value ) {
+	unsigned long first_burst_len;
+	char *end;
+
+	/* Update first burst length (using the minimum of the
+	 * offered and responded values).
+	 */
+	first_burst_len = strtoul ( value, &end, 0 );
+	if ( *end ) {
+		DBGC ( iscsi, "iSCSI %p invalid FirstBurstLength \"%s\"\n",
+		       iscsi, value );
+		return -EINVAL_FIRSTBURSTLENGTH;
+	}
+	if ( first_burst_len > ISCSI_FIRST_BURST_LEN )
+		first_burst_len = ISCSI_FIRST_BURST_LEN;
+	iscsi->first_burst_len = first_burst_len;
+
+	return 0;
+}
+
+/**
+ * Handle iSCSI MaxConnections text value
+ *
+ * @v iscsi		iSCSI session
+ * @v value		MaxConnections value
+ * @ret rc		Return status code
+ */
+static int iscsi_handle_maxconnections_value ( struct iscsi_session *iscsi,
+					       const char *value ) {
+	unsigned long max_connections;
+	char *end;
+
+	/* Update maximum number of connections */
+	max_connections = strtoul ( value, &end, 0 );
+	if ( *end || ( max_connections == 0 ) ) {
+		DBGC ( iscsi, "iSCSI %p invalid MaxConnections \"%s\"\n",
+		       iscsi, value );
+		return -EINVAL_MAXCONNECTIONS;
+	}
+	if ( max_connections > ISCSI_MAX_CONNECTIONS )
+		max_connections = ISCSI_MAX_CONNECTIONS;
+	iscsi->max_connections = max_connections;
+
+	return 0;
+}
+
+/**
+ * Handle iSCSI MaxRecvDataSegmentLength text value
+ *
+ * @v iscsi		iSCSI session
+ * @v value		MaxRecvDataSegmentLength value
+ * @ret rc		Return status code
+ *
+ * This is a declarative value, specifying the largest data segment
+ * that the target is prepared to receive.
+ */
+static int
+iscsi_handle_maxrecvdatasegmentlength_value ( struct iscsi_session *iscsi,
+					      const char *value ) {
+	unsigned long max_send_len;
+	char *end;
+
+	/* Record target's maximum receive data segment length */
+	max_send_len = strtoul ( value, &end, 0 );
+	if ( *end || ( max_send_len < 512 ) ) {
+		DBGC ( iscsi, "iSCSI %p invalid MaxRecvDataSegmentLength "
+		       "\"%s\"\n", iscsi, value );
+		return -EINVAL_MAXRECVDATASEGMENTLENGTH;
+	}
+	iscsi->max_send_len = max_send_len;
+
+	return 0;
+}
+
+/**
+ * Handle iSCSI boolean text value
+ *
+ * @v iscsi		iSCSI session
+ * @v value		Boolean value
+ * @v flag		Status flag representing a "Yes" value
+ * @ret rc		Return status code
+ */
+static int iscsi_handle_boolean_value ( struct iscsi_session *iscsi,
+					const char *value, int flag ) {
+
+	/* Record negotiated value */
+	if ( strcmp ( value, "Yes" ) == 0 ) {
+		iscsi->status |= flag;
+	} else if ( strcmp ( value, "No" ) == 0 ) {
+		iscsi->status &= ~flag;
+	} else {
+		DBGC ( iscsi, "iSCSI %p invalid boolean \"%s\"\n",
+		       iscsi, value );
+		return -EINVAL_BOOLEAN;
+	}
+
+	return 0;
+}
+
+/**
+ * Handle iSCSI InitialR2T text value
+ *
+ * @v iscsi		iSCSI session
+ * @v value		InitialR2T value
+ * @ret rc		Return status code
+ */
+static int iscsi_handle_initialr2t_value ( struct iscsi_session *iscsi,
+					   const char *value ) {
+
+	return iscsi_handle_boolean_value ( iscsi, value,
+					    ISCSI_STATUS_INITIAL_R2T );
+}
+
+/**
+ * Handle iSCSI ImmediateData text value
+ *
+ * @v iscsi		iSCSI session
+ * @v value		ImmediateData value
+ * @ret rc		Return status code
+ */
+static int iscsi_handle_immediatedata_value ( struct iscsi_session *iscsi,
+					      const char *value ) {
+
+	return iscsi_handle_boolean_value ( iscsi, value,
+					    ISCSI_STATUS_IMMEDIATE_DATA );
+}
+
+/**
+ * Handle iSCSI HeaderDigest or DataDigest text value
+ *
+ * @v iscsi		iSCSI session
+ * @v value		Digest value
+ * @v digest		Digest flag
+ * @ret rc		Return status code
+ */
+static int iscsi_handle_digest_value ( struct iscsi_session *iscsi,
+				       const char *value, int digest ) {
+
+	/* Record negotiated digest */
+	if ( strcmp ( value, "CRC32C" ) == 0 ) {
+		iscsi->status |= digest;
+	} else if ( strcmp ( value, "None" ) == 0 ) {
+		iscsi->status &= ~digest;
+	} else {
+		DBGC ( iscsi, "iSCSI %p invalid digest \"%s\"\n",
+		       iscsi, value );
+		return -EPROTO_INVALID_DIGEST;
+	}
+
+	return 0;
+}
+
+/**
+ * Handle iSCSI HeaderDigest text value
+ *
+ * @v iscsi		iSCSI session
+ * @v value		HeaderDigest value
+ * @ret rc		Return status code
+ */
+static int iscsi_handle_headerdigest_value ( struct iscsi_session *iscsi,
+					     const char *value ) {
+
+	return iscsi_handle_digest_value ( iscsi, value,
+					   ISCSI_STATUS_HEADER_DIGEST );
+}
+
+/**
+ * Handle iSCSI DataDigest text value
+ *
+ * @v iscsi		iSCSI session
+ * @v value		DataDigest value
+ * @ret rc		Return status code
+ */
+static int iscsi_handle_datadigest_value ( struct iscsi_session *iscsi,
+					   const char *value ) {
+
+	return iscsi_handle_digest_value ( iscsi, value,
+					   ISCSI_STATUS_DATA_DIGEST );
+}
+
 /**
  * Handle iSCSI CHAP_A text value
  *
@@ -1186,6 +1735,14 @@ struct iscsi_string_type {
 static struct iscsi_string_type iscsi_string_types[] = {
 	{ "TargetAddress", iscsi_handle_targetaddress_value },
 	{ "MaxBurstLength", iscsi_handle_maxburstlength_value },
+	{ "FirstBurstLength", iscsi_handle_firstburstlength_value },
+	{ "MaxConnections", iscsi_handle_maxconnections_value },
+	{ "MaxRecvDataSegmentLength",
+	  iscsi_handle_maxrecvdatasegmentlength_value },
+	{ "InitialR2T", iscsi_handle_initialr2t_value },
+	{ "ImmediateData", iscsi_handle_immediatedata_value },
+	{ "HeaderDigest", iscsi_handle_headerdigest_value },
+	{ "DataDigest", iscsi_handle_datadigest_value },
 	{ "AuthMethod", iscsi_handle_authmethod_value },
 	{ "CHAP_A", iscsi_handle_chap_a_value },
 	{ "CHAP_I", iscsi_handle_chap_i_value },
@@ -1397,9 +1954,17 @@ static int iscsi_rx_login_response ( struct iscsi_session *iscsi,
 		return -EPROTO;
 	}
 
-	/* Notify SCSI layer of window change */
+	/* Record target session identifying handle and open any
+	 * additional connections
+	 */
 	DBGC ( iscsi, "iSCSI %p entering full feature phase\n", iscsi );
-	xfer_window_changed ( &iscsi->control );
+	if ( ! iscsi->leader ) {
+		iscsi->tsih = ntohs ( response->tsih );
+		iscsi_open_connections ( iscsi );
+	}
+
+	/* Notify SCSI layer of window change */
+	xfer_window_changed ( &iscsi_leader ( iscsi )->control );
 
 	return 0;
 }
@@ -1443,6 +2008,9 @@ static void iscsi_start_tx ( struct iscsi_session *iscsi ) {
 	/* Initialise TX BHS */
 	memset ( &iscsi->tx_bhs, 0, sizeof ( iscsi->tx_bhs ) );
 
+	/* Record digests in use for this PDU */
+	iscsi->tx_digests = iscsi_digests ( iscsi );
+
 	/* Flag TX engine to start transmitting */
 	iscsi->tx_state = ISCSI_TX_BHS;
 
@@ -1467,8 +2035,21 @@ static int iscsi_tx_nothing ( struct iscsi_session *iscsi __unused ) {
  * @ret rc		Return status code
  */
 static int iscsi_tx_bhs ( struct iscsi_session *iscsi ) {
-	return xfer_deliver_raw ( &iscsi->socket,  &iscsi->tx_bhs,
-				  sizeof ( iscsi->tx_bhs ) );
+	struct {
+		union iscsi_bhs bhs;
+		uint32_t digest;
+	} __attribute__ (( packed )) pdu;
+	size_t len;
+
+	/* Append header digest, if applicable */
+	memcpy ( &pdu.bhs, &iscsi->tx_bhs, sizeof ( pdu.bhs ) );
+	len = sizeof ( pdu.bhs );
+	if ( iscsi->tx_digests & ISCSI_STATUS_HEADER_DIGEST ) {
+		pdu.digest = iscsi_digest ( &pdu.bhs, sizeof ( pdu.bhs ) );
+		len += sizeof ( pdu.digest );
+	}
+
+	return xfer_deliver_raw ( &iscsi->socket, &pdu, len );
 }
 
 /**
@@ -1484,6 +2065,7 @@ static int iscsi_tx_data ( struct iscsi_session *iscsi ) {
 	struct iscsi_bhs_common *common = &iscsi->tx_bhs.common;
 
 	switch ( common->opcode & ISCSI_OPCODE_MASK ) {
+	case ISCSI_OPCODE_SCSI_COMMAND:
 	case ISCSI_OPCODE_DATA_OUT:
 		return iscsi_tx_data_out ( iscsi );
 	case ISCSI_OPCODE_LOGIN_REQUEST:
@@ -1509,10 +2091,11 @@ static void iscsi_tx_done ( struct iscsi_session *iscsi ) {
 	/* Stop transmission process */
 	iscsi_tx_pause ( iscsi );
 
+	/* Release task, if any */
+	iscsi_task_put ( iscsi->tx_task );
+	iscsi->tx_task = NULL;
+
 	switch ( common->opcode & ISCSI_OPCODE_MASK ) {
-	case ISCSI_OPCODE_DATA_OUT:
-		iscsi_data_out_done ( iscsi );
-		break;
 	case ISCSI_OPCODE_LOGIN_REQUEST:
 		iscsi_login_request_done ( iscsi );
 		break;
@@ -1557,6 +2140,10 @@ static void iscsi_tx_step ( struct iscsi_session *iscsi ) {
 			next_state = ISCSI_TX_IDLE;
 			break;
 		case ISCSI_TX_IDLE:
+			/* Start next pending task PDU, if any */
+			iscsi_tx_next ( iscsi );
+			if ( iscsi->tx_state != ISCSI_TX_IDLE )
+				continue;
 			/* Nothing to do; pause processing */
 			iscsi_tx_pause ( iscsi );
 			return;
@@ -1639,6 +2226,42 @@ static int iscsi_rx_discard ( struct iscsi_session *iscsi __unused,
 	return 0;
 }
 
+/**
+ * Receive header or data digest of an iSCSI PDU
+ *
+ * @v iscsi		iSCSI session
+ * @v data		Received data
+ * @v len		Length of received data
+ * @v remaining		Data remaining after this data
+ * @ret rc		Return status code
+ *
+ * The received digest is compared against the CRC32C accumulated
+ * over the preceding portion of the PDU.
+ */
+static int iscsi_rx_digest ( struct iscsi_session *iscsi, const void *data,
+			     size_t len, size_t remaining ) {
+	uint32_t expected;
+
+	/* Accumulate digest */
+	memcpy ( ( ( ( void * ) &iscsi->rx_digest ) + iscsi->rx_offset ),
+		 data, len );
+	if ( remaining || ( ! iscsi->rx_len ) )
+		return 0;
+
+	/* Verify digest */
+	expected = cpu_to_le32 ( ~iscsi->rx_crc );
+	if ( iscsi->rx_digest != expected ) {
+		DBGC ( iscsi, "iSCSI %p %s digest mismatch (expected %08x, "
+		       "got %08x)\n", iscsi,
+		       ( ( iscsi->rx_state == ISCSI_RX_HEADER_DIGEST ) ?
+			 "header" : "data" ), le32_to_cpu ( expected ),
+		       le32_to_cpu ( iscsi->rx_digest ) );
+		return -EIO_DIGEST;
+	}
+
+	return 0;
+}
+
 /**
  * Receive data segment of an iSCSI PDU
  *
@@ -1655,10 +2278,39 @@ static int iscsi_rx_data ( struct iscsi_session *iscsi, const void *data,
 			   size_t len, size_t remaining ) {
 	struct iscsi_bhs_common_response *response
 		= &iscsi->rx_bhs.common_response;
+	struct iscsi_session *leader = iscsi_leader ( iscsi );
+	struct iscsi_session *conn;
+	uint32_t maxcmdsn = ntohl ( response->maxcmdsn );
+
+	/* Update (session-wide) command window.  Commands may be
+	 * outstanding once the leading connection reaches the full
+	 * feature phase, so CmdSN is then maintained locally rather
+	 * than being taken from ExpCmdSN.
+	 */
+	if ( ( leader->status & ISCSI_STATUS_PHASE_MASK ) !=
+	     ISCSI_STATUS_FULL_FEATURE_PHASE ) {
+		leader->cmdsn = ntohl ( response->expcmdsn );
+		leader->maxcmdsn = maxcmdsn;
+	} else if ( ( int32_t ) ( maxcmdsn - leader->maxcmdsn ) > 0 ) {
+		leader->maxcmdsn = maxcmdsn;
+		iscsi_tx_resume ( leader );
+		list_for_each_entry ( conn, &leader->connections, list )
+			iscsi_tx_resume ( conn );
+	}
 
-	/* Update cmdsn and statsn */
-	iscsi->cmdsn = ntohl ( response->expcmdsn );
-	iscsi->statsn = ntohl ( response->statsn );
+	/* Update statsn, if this PDU carries status */
+	switch ( response->opcode & ISCSI_OPCODE_MASK ) {
+	case ISCSI_OPCODE_DATA_IN:
+		if ( ! ( response->flags & ISCSI_DATA_FLAG_STATUS ) )
+			break;
+		/* Fall through */
+	case ISCSI_OPCODE_LOGIN_RESPONSE:
+	case ISCSI_OPCODE_SCSI_RESPONSE:
+		iscsi->statsn = ntohl ( response->statsn );
+		break;
+	default:
+		break;
+	}
 
 	switch ( response->opcode & ISCSI_OPCODE_MASK ) {
 	case ISCSI_OPCODE_LOGIN_RESPONSE:
@@ -1694,6 +2346,9 @@ static int iscsi_rx_data ( struct iscsi_session *iscsi, const void *data,
  * portion as it arrives.  The data processing routine therefore
  * always has a full copy of the BHS available, even for portions of
  * the data in different packets to the BHS.
+ *
+ * Any header or data digests are accumulated as the data arrives,
+ * and verified when the digest itself is received.
  */
 static int iscsi_socket_deliver ( struct iscsi_session *iscsi,
 				  struct io_buffer *iobuf,
@@ -1704,28 +2359,63 @@ static int iscsi_socket_deliver ( struct iscsi_session *iscsi,
 	enum iscsi_rx_state next_state;
 	size_t frag_len;
 	size_t remaining;
+	int header_digest;
+	int data_digest;
+	int digest;
+	int defer;
 	int rc;
 
 	while ( 1 ) {
+		defer = 0;
+		header_digest = ( iscsi->rx_digests &
+				  ISCSI_STATUS_HEADER_DIGEST );
+		data_digest = ( iscsi->rx_digests & ISCSI_STATUS_DATA_DIGEST );
 		switch ( iscsi->rx_state ) {
 		case ISCSI_RX_BHS:
+			if ( ! iscsi->rx_offset ) {
+				iscsi->rx_digests = iscsi_digests ( iscsi );
+				header_digest = ( iscsi->rx_digests &
+						  ISCSI_STATUS_HEADER_DIGEST );
+				iscsi->rx_crc = 0xffffffffUL;
+			}
 			rx = iscsi_rx_bhs;
 			iscsi->rx_len = sizeof ( iscsi->rx_bhs );
+			digest = header_digest;
 			next_state = ISCSI_RX_AHS;			
 			break;
 		case ISCSI_RX_AHS:
 			rx = iscsi_rx_discard;
 			iscsi->rx_len = 4 * ISCSI_AHS_LEN ( common->lengths );
+			digest = header_digest;
+			next_state = ISCSI_RX_HEADER_DIGEST;
+			break;
+		case ISCSI_RX_HEADER_DIGEST:
+			rx = iscsi_rx_digest;
+			iscsi->rx_len = ( header_digest ? ISCSI_DIGEST_LEN : 0 );
+			digest = 0;
 			next_state = ISCSI_RX_DATA;
 			break;
 		case ISCSI_RX_DATA:
+			if ( ! iscsi->rx_offset )
+				iscsi->rx_crc = 0xffffffffUL;
 			rx = iscsi_rx_data;
 			iscsi->rx_len = ISCSI_DATA_LEN ( common->lengths );
+			digest = data_digest;
+			defer = ( data_digest && iscsi->rx_len );
 			next_state = ISCSI_RX_DATA_PADDING;
 			break;
 		case ISCSI_RX_DATA_PADDING:
 			rx = iscsi_rx_discard;
 			iscsi->rx_len = ISCSI_DATA_PAD_LEN ( common->lengths );
+			digest = data_digest;
+			next_state = ISCSI_RX_DATA_DIGEST;
+			break;
+		case ISCSI_RX_DATA_DIGEST:
+			rx = iscsi_rx_digest;
+			iscsi->rx_len = ( ( data_digest &&
+					    ISCSI_DATA_LEN ( common->lengths ) ) ?
+					  ISCSI_DIGEST_LEN : 0 );
+			digest = 0;
 			next_state = ISCSI_RX_BHS;
 			break;
 		default:
@@ -1738,12 +2428,21 @@ static int iscsi_socket_deliver ( struct iscsi_session *iscsi,
 		if ( frag_len > iob_len ( iobuf ) )
 			frag_len = iob_len ( iobuf );
 		remaining = iscsi->rx_len - iscsi->rx_offset - frag_len;
+		/* Defer completion of the data segment until after the
+		 * data digest has been verified.
+		 */
+		if ( defer )
+			remaining++;
 		if ( ( rc = rx ( iscsi, iobuf->data, frag_len,
 				 remaining ) ) != 0 ) {
 			DBGC ( iscsi, "iSCSI %p could not process received "
 			       "data: %s\n", iscsi, strerror ( rc ) );
 			goto done;
 		}
+		if ( digest ) {
+			iscsi->rx_crc = crc32c_le ( iscsi->rx_crc, iobuf->data,
+						    frag_len );
+		}
 
 		iscsi->rx_offset += frag_len;
 		iob_pull ( iobuf, frag_len );
@@ -1756,6 +2455,20 @@ static int iscsi_socket_deliver ( struct iscsi_session *iscsi,
 			goto done;
 		}
 
+		/* Complete any deferred data segment processing */
+		if ( ( iscsi->rx_state == ISCSI_RX_DATA_DIGEST ) &&
+		     iscsi->rx_len ) {
+			iscsi->rx_len = ISCSI_DATA_LEN ( common->lengths );
+			iscsi->rx_offset = iscsi->rx_len;
+			if ( ( rc = iscsi_rx_data ( iscsi, iobuf->data, 0,
+						    0 ) ) != 0 ) {
+				DBGC ( iscsi, "iSCSI %p could not process "
+				       "received data: %s\n",
+				       iscsi, strerror ( rc ) );
+				goto done;
+			}
+		}
+
 		iscsi->rx_state = next_state;
 		iscsi->rx_offset = 0;
 	}
@@ -1829,6 +2542,23 @@ static struct interface_descriptor iscsi_socket_desc =
  *
  */
 
+/**
+ * Check iSCSI connection flow-control window
+ *
+ * @v iscsi		iSCSI session
+ * @ret len		Length of window
+ */
+static size_t iscsi_connection_window ( struct iscsi_session *iscsi ) {
+
+	/* Commands cannot be issued before login is complete */
+	if ( ( iscsi->status & ISCSI_STATUS_PHASE_MASK ) !=
+	     ISCSI_STATUS_FULL_FEATURE_PHASE )
+		return 0;
+
+	/* Limit number of outstanding commands */
+	return ( ISCSI_MAX_TASKS - iscsi->count );
+}
+
 /**
  * Check iSCSI flow-control window
  *
@@ -1836,17 +2566,47 @@ static struct interface_descriptor iscsi_socket_desc =
  * @ret len		Length of window
  */
 static size_t iscsi_scsi_window ( struct iscsi_session *iscsi ) {
+	struct iscsi_session *conn;
+	size_t window;
 
-	if ( ( ( iscsi->status & ISCSI_STATUS_PHASE_MASK ) ==
-	       ISCSI_STATUS_FULL_FEATURE_PHASE ) &&
-	     ( iscsi->command == NULL ) ) {
-		/* We cannot handle concurrent commands */
-		return 1;
-	} else {
-		return 0;
+	/* Sum windows across all connections */
+	window = iscsi_connection_window ( iscsi );
+	list_for_each_entry ( conn, &iscsi->connections, list )
+		window += iscsi_connection_window ( conn );
+
+	return window;
+}
+
+/**
+ * Close iSCSI task
+ *
+ * @v task		iSCSI task
+ * @v rc		Reason for close
+ */
+static void iscsi_task_close ( struct iscsi_task *task, int rc ) {
+	struct iscsi_session *iscsi = task->iscsi;
+
+	/* Treat unsolicited command closures mid-command as fatal,
+	 * because we have no code to handle partially-completed PDUs.
+	 */
+	if ( ! list_empty ( &task->list ) ) {
+		iscsi_close ( iscsi, ( ( rc == 0 ) ? -ECANCELED : rc ) );
+		return;
 	}
+
+	/* Restart interface */
+	intf_restart ( &task->data, rc );
 }
 
+/** iSCSI SCSI command interface operations */
+static struct interface_operation iscsi_task_data_op[] = {
+	INTF_OP ( intf_close, struct iscsi_task *, iscsi_task_close ),
+};
+
+/** iSCSI SCSI command interface descriptor */
+static struct interface_descriptor iscsi_task_data_desc =
+	INTF_DESC ( struct iscsi_task, data, iscsi_task_data_op );
+
 /**
  * Issue iSCSI SCSI command
  *
@@ -1858,31 +2618,53 @@ static size_t iscsi_scsi_window ( struct iscsi_session *iscsi ) {
 static int iscsi_scsi_command ( struct iscsi_session *iscsi,
 				struct interface *parent,
 				struct scsi_cmd *command ) {
+	struct iscsi_session *conn;
+	struct iscsi_session *best;
+	struct iscsi_task *task;
+
+	/* Use the connection with the fewest outstanding commands */
+	best = iscsi;
+	list_for_each_entry ( conn, &iscsi->connections, list ) {
+		if ( iscsi_connection_window ( conn ) >
+		     iscsi_connection_window ( best ) )
+			best = conn;
+	}
 
-	/* This iSCSI implementation cannot handle multiple concurrent
-	 * commands or commands arriving before login is complete.
+	/* This iSCSI implementation cannot handle commands arriving
+	 * before login is complete, or more than ISCSI_MAX_TASKS
+	 * concurrent commands per connection.
 	 */
-	if ( iscsi_scsi_window ( iscsi ) == 0 ) {
-		DBGC ( iscsi, "iSCSI %p cannot handle concurrent commands\n",
+	if ( iscsi_connection_window ( best ) == 0 ) {
+		DBGC ( iscsi, "iSCSI %p cannot accept further commands\n",
 		       iscsi );
 		return -EOPNOTSUPP;
 	}
+	conn = best;
 
-	/* Store command */
-	iscsi->command = malloc ( sizeof ( *command ) );
-	if ( ! iscsi->command )
+	/* Allocate and initialise task */
+	task = zalloc ( sizeof ( *task ) );
+	if ( ! task )
 		return -ENOMEM;
-	memcpy ( iscsi->command, command, sizeof ( *command ) );
-
-	/* Assign new ITT */
-	iscsi_new_itt ( iscsi );
+	ref_init ( &task->refcnt, iscsi_task_free );
+	intf_init ( &task->data, &iscsi_task_data_desc, &task->refcnt );
+	task->iscsi = conn;
+	ref_get ( &conn->refcnt );
+	memcpy ( &task->command, command, sizeof ( task->command ) );
+	task->itt = iscsi_new_itt();
+	task->pending = ISCSI_TASK_TX_COMMAND;
+
+	/* Add to connection's list of outstanding tasks (transferring
+	 * reference)
+	 */
+	list_add_tail ( &task->list, &conn->tasks );
+	conn->count++;
 
 	/* Start sending command */
-	iscsi_start_command ( iscsi );
+	iscsi_tx_resume ( conn );
 
 	/* Attach to parent interface and return */
-	intf_plug_plug ( &iscsi->data, parent );
-	return iscsi->itt;
+	intf_plug_plug ( &task->data, parent );
+	return task->itt;
 }
 
 /**
@@ -1928,33 +2710,6 @@ static struct interface_operation iscsi_control_op[] = {
 static struct interface_descriptor iscsi_control_desc =
 	INTF_DESC ( struct iscsi_session, control, iscsi_control_op );
 
-/**
- * Close iSCSI command
- *
- * @v iscsi		iSCSI session
- * @v rc		Reason for close
- */
-static void iscsi_command_close ( struct iscsi_session *iscsi, int rc ) {
-
-	/* Restart interface */
-	intf_restart ( &iscsi->data, rc );
-
-	/* Treat unsolicited command closures mid-command as fatal,
-	 * because we have no code to handle partially-completed PDUs.
-	 */
-	if ( iscsi->command != NULL )
-		iscsi_close ( iscsi, ( ( rc == 0 ) ? -ECANCELED : rc ) );
-}
-
-/** iSCSI SCSI command interface operations */
-static struct interface_operation iscsi_data_op[] = {
-	INTF_OP ( intf_close, struct iscsi_session *, iscsi_command_close ),
-};
-
-/** iSCSI SCSI command interface descriptor */
-static struct interface_descriptor iscsi_data_desc =
-	INTF_DESC ( struct iscsi_session, data, iscsi_data_op );
-
 /****************************************************************************
  *
  * Instantiator
@@ -2164,6 +2919,108 @@ static int iscsi_check_auth ( struct iscsi_session *iscsi ) {
 	return 0;
 }
 
+/**
+ * Copy string for additional iSCSI connection
+ *
+ * @v dest		Destination string to fill in
+ * @v src		Source string, or NULL
+ * @ret rc		Return status code
+ */
+static int iscsi_copy_string ( char **dest, const char *src ) {
+
+	if ( src && ( ! ( *dest = strdup ( src ) ) ) )
+		return -ENOMEM;
+	return 0;
+}
+
+/**
+ * Open additional iSCSI connection
+ *
+ * @v leader		Leading connection
+ * @v cid		Connection ID
+ * @ret rc		Return status code
+ */
+static int iscsi_add_connection ( struct iscsi_session *leader,
+				  unsigned int cid ) {
+	struct iscsi_session *iscsi;
+	int rc;
+
+	/* Allocate and initialise structure */
+	iscsi = zalloc ( sizeof ( *iscsi ) );
+	if ( ! iscsi ) {
+		rc = -ENOMEM;
+		goto err_zalloc;
+	}
+	ref_init ( &iscsi->refcnt, iscsi_free );
+	intf_init ( &iscsi->control, &iscsi_control_desc, &iscsi->refcnt );
+	intf_init ( &iscsi->socket, &iscsi_socket_desc, &iscsi->refcnt );
+	process_init_stopped ( &iscsi->process, &iscsi_process_desc,
+			       &iscsi->refcnt );
+	INIT_LIST_HEAD ( &iscsi->tasks );
+	INIT_LIST_HEAD ( &iscsi->connections );
+	INIT_LIST_HEAD ( &iscsi->list );
+	iscsi->leader = leader;
+	ref_get ( &leader->refcnt );
+	iscsi->cid = cid;
+
+	/* Copy target address and credentials */
+	if ( ( ( rc = iscsi_copy_string ( &iscsi->initiator_iqn,
+					  leader->initiator_iqn ) ) != 0 ) ||
+	     ( ( rc = iscsi_copy_string ( &iscsi->target_address,
+					  leader->target_address ) ) != 0 ) ||
+	     ( ( rc = iscsi_copy_string ( &iscsi->target_iqn,
+					  leader->target_iqn ) ) != 0 ) ||
+	     ( ( rc = iscsi_copy_string ( &iscsi->initiator_username,
+					  leader->initiator_username ) ) != 0 ) ||
+	     ( ( rc = iscsi_copy_string ( &iscsi->initiator_password,
+					  leader->initiator_password ) ) != 0 ) ||
+	     ( ( rc = iscsi_copy_string ( &iscsi->target_username,
+					  leader->target_username ) ) != 0 ) ||
+	     ( ( rc = iscsi_copy_string ( &iscsi->target_password,
+					  leader->target_password ) ) != 0 ) ) {
+		goto err_copy;
+	}
+	iscsi->target_port = leader->target_port;
+
+	/* Open socket */
+	if ( ( rc = iscsi_open_connection ( iscsi ) ) != 0 )
+		goto err_open_connection;
+
+	/* Add to list of additional connections (transferring reference) */
+	DBGC ( leader, "iSCSI %p opening connection %d as %p\n",
+	       leader, cid, iscsi );
+	list_add_tail ( &iscsi->list, &leader->connections );
+	return 0;
+
+ err_open_connection:
+ err_copy:
+	iscsi_close ( iscsi, rc );
+	ref_put ( &iscsi->refcnt );
+ err_zalloc:
+	return rc;
+}
+
+/**
+ * Open all additional iSCSI connections
+ *
+ * @v leader		Leading connection
+ *
+ * Failure to open an additional connection is not fatal, since
+ * commands can continue to be issued via the existing connections.
+ */
+static void iscsi_open_connections ( struct iscsi_session *leader ) {
+	unsigned int cid;
+	int rc;
+
+	for ( cid = 1 ; cid < leader->max_connections ; cid++ ) {
+		if ( ( rc = iscsi_add_connection ( leader, cid ) ) != 0 ) {
+			DBGC ( leader, "iSCSI %p could not open connection "
+			       "%d: %s\n", leader, cid, strerror ( rc ) );
+			break;
+		}
+	}
+}
+
 /**
  * Open iSCSI URI
  *
@@ -2189,11 +3046,13 @@ static int iscsi_open ( struct interface *parent, struct uri *uri ) {
 	}
 	ref_init ( &iscsi->refcnt, iscsi_free );
 	intf_init ( &iscsi->control, &iscsi_control_desc, &iscsi->refcnt );
-	intf_init ( &iscsi->data, &iscsi_data_desc, &iscsi->refcnt );
 	intf_init ( &iscsi->socket, &iscsi_socket_desc, &iscsi->refcnt );
 	process_init_stopped ( &iscsi->process, &iscsi_process_desc,
 			       &iscsi->refcnt );
 	acpi_init ( &iscsi->desc, &ibft_model, &iscsi->refcnt );
+	INIT_LIST_HEAD ( &iscsi->tasks );
+	INIT_LIST_HEAD ( &iscsi->connections );
+	INIT_LIST_HEAD ( &iscsi->list );
 
 	/* Parse root path */
 	if ( ( rc = iscsi_parse_root_path ( iscsi, uri->opaque ) ) != 0 )
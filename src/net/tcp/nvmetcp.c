@@ -0,0 +1,1895 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+FILE_SECBOOT ( PERMITTED );
+
+#include <stddef.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <errno.h>
+#include <assert.h>
+#include <byteswap.h>
+#include <ipxe/list.h>
+#include <ipxe/iobuf.h>
+#include <ipxe/features.h>
+#include <ipxe/interface.h>
+#include <ipxe/xfer.h>
+#include <ipxe/uri.h>
+#include <ipxe/open.h>
+#include <ipxe/tcpip.h>
+#include <ipxe/timer.h>
+#include <ipxe/settings.h>
+#include <ipxe/blockdev.h>
+#include <ipxe/efi/efi_path.h>
+#include <ipxe/nbft.h>
+#include <ipxe/nvmetcp.h>
+
+/** @file
+ *
+ * NVMe over TCP protocol
+ *
+ * This implements an NVMe/TCP host (as defined in the NVM Express
+ * TCP Transport Specification) providing access to a single
+ * namespace via an admin queue and a single I/O queue.  Header and
+ * data digests are not used, and all write data is transferred in
+ * response to R2T PDUs from the controller.
+ *
+ */
+
+FEATURE ( FEATURE_PROTOCOL, "NVMe/TCP", DHCP_EB_FEATURE_NVME_TCP, 1 );
+
+/** Default host NQN prefix */
+#define NVMETCP_DEFAULT_HOSTNQN_PREFIX "nqn.2014-08.org.nvmexpress:uuid:"
+
+/** An NVMe/TCP command */
+struct nvmetcp_command {
+	/** Reference count */
+	struct refcnt refcnt;
+	/** NVMe/TCP device */
+	struct nvmetcp_device *nvme;
+	/** Queue */
+	struct nvmetcp_queue *queue;
+	/** List of active commands */
+	struct list_head list;
+
+	/** Block data interface */
+	struct interface block;
+
+	/** Command type */
+	struct nvmetcp_command_type *type;
+	/** Submission queue entry */
+	union nvme_sqe sqe;
+	/** Data buffer */
+	void *buffer;
+	/** Length of data buffer */
+	size_t len;
+};
+
+/** An NVMe/TCP command type */
+struct nvmetcp_command_type {
+	/** Name */
+	const char *name;
+	/** Length of private data */
+	size_t priv_len;
+	/**
+	 * Handle command completion
+	 *
+	 * @v cmd		NVMe/TCP command
+	 * @v cqe		Completion queue entry, or NULL
+	 * @v rc		Reason for completion
+	 *
+	 * The completion queue entry will be NULL if the command
+	 * was completed without a response capsule.
+	 */
+	void ( * done ) ( struct nvmetcp_command *cmd,
+			  const struct nvme_cqe *cqe, int rc );
+};
+
+static void nvmetcp_close ( struct nvmetcp_device *nvme, int rc );
+static int nvmetcp_connect ( struct nvmetcp_queue *queue );
+
+/******************************************************************************
+ *
+ * Commands
+ *
+ ******************************************************************************
+ */
+
+/**
+ * Get reference to NVMe/TCP command
+ *
+ * @v cmd		NVMe/TCP command
+ * @ret cmd		NVMe/TCP command
+ */
+static inline __attribute__ (( always_inline )) struct nvmetcp_command *
+nvmetcp_command_get ( struct nvmetcp_command *cmd ) {
+	ref_get ( &cmd->refcnt );
+	return cmd;
+}
+
+/**
+ * Drop reference to NVMe/TCP command
+ *
+ * @v cmd		NVMe/TCP command
+ */
+static inline __attribute__ (( always_inline )) void
+nvmetcp_command_put ( struct nvmetcp_command *cmd ) {
+	ref_put ( &cmd->refcnt );
+}
+
+/**
+ * Get NVMe/TCP command private data
+ *
+ * @v cmd		NVMe/TCP command
+ * @ret priv		Private data
+ */
+static inline __attribute__ (( always_inline )) void *
+nvmetcp_command_priv ( struct nvmetcp_command *cmd ) {
+	return ( ( ( void * ) cmd ) + sizeof ( *cmd ) );
+}
+
+/**
+ * Free NVMe/TCP command
+ *
+ * @v refcnt		Reference count
+ */
+static void nvmetcp_command_free ( struct refcnt *refcnt ) {
+	struct nvmetcp_command *cmd =
+		container_of ( refcnt, struct nvmetcp_command, refcnt );
+
+	/* Sanity check */
+	assert ( list_empty ( &cmd->list ) );
+
+	/* Drop reference to device */
+	ref_put ( &cmd->nvme->refcnt );
+
+	/* Free command */
+	free ( cmd );
+}
+
+/**
+ * Complete NVMe/TCP command
+ *
+ * @v cmd		NVMe/TCP command
+ * @v cqe		Completion queue entry, or NULL
+ * @v rc		Reason for completion
+ */
+static void nvmetcp_command_done ( struct nvmetcp_command *cmd,
+				   const struct nvme_cqe *cqe, int rc ) {
+	struct nvmetcp_device *nvme = cmd->nvme;
+
+	/* Ignore if command has already completed */
+	if ( list_empty ( &cmd->list ) )
+		return;
+
+	DBGC2 ( nvme, "NVMeTCP %p qid %d cid %d %s complete: %s\n",
+		nvme, cmd->queue->qid, cmd->sqe.cmd.cid, cmd->type->name,
+		strerror ( rc ) );
+
+	/* Remove from list of active commands.  The reference held by
+	 * the list is retained until we have finished with the command.
+	 */
+	list_del ( &cmd->list );
+	INIT_LIST_HEAD ( &cmd->list );
+	cmd->queue->count--;
+
+	/* Hand off to command type */
+	cmd->type->done ( cmd, cqe, rc );
+
+	/* Shut down block interface and drop list's reference */
+	intf_shutdown ( &cmd->block, rc );
+	nvmetcp_command_put ( cmd );
+}
+
+/**
+ * Close NVMe/TCP command
+ *
+ * @v cmd		NVMe/TCP command
+ * @v rc		Reason for close
+ */
+static void nvmetcp_command_close ( struct nvmetcp_command *cmd, int rc ) {
+
+	nvmetcp_command_get ( cmd );
+	nvmetcp_command_done ( cmd, NULL, rc );
+	nvmetcp_command_put ( cmd );
+}
+
+/**
+ * Find NVMe/TCP command by command identifier
+ *
+ * @v queue		NVMe/TCP queue
+ * @v cid		Command identifier
+ * @ret cmd		NVMe/TCP command, or NULL if not found
+ */
+static struct nvmetcp_command * nvmetcp_find ( struct nvmetcp_queue *queue,
+					       unsigned int cid ) {
+	struct nvmetcp_command *cmd;
+
+	list_for_each_entry ( cmd, &queue->nvme->commands, list ) {
+		if ( ( cmd->queue == queue ) && ( cmd->sqe.cmd.cid == cid ) )
+			return cmd;
+	}
+	return NULL;
+}
+
+/** NVMe/TCP command block interface operations */
+static struct interface_operation nvmetcp_command_block_op[] = {
+	INTF_OP ( intf_close, struct nvmetcp_command *,
+		  nvmetcp_command_close ),
+};
+
+/** NVMe/TCP command block interface descriptor */
+static struct interface_descriptor nvmetcp_command_block_desc =
+	INTF_DESC ( struct nvmetcp_command, block, nvmetcp_command_block_op );
+
+/**
+ * Create NVMe/TCP command
+ *
+ * @v queue		NVMe/TCP queue
+ * @v type		Command type
+ * @v opcode		Opcode
+ * @v buffer		Data buffer, or NULL to use private data
+ * @v len		Length of data buffer
+ * @ret cmd		NVMe/TCP command
+ * @ret rc		Return status code
+ *
+ * The command is returned with its identifier and data pointer
+ * filled in, ready for the caller to fill in any command-specific
+ * fields.  The caller must either issue the command using
+ * nvmetcp_command_issue() or complete it using nvmetcp_command_done().
+ */
+static int nvmetcp_command_create ( struct nvmetcp_queue *queue,
+				    struct nvmetcp_command_type *type,
+				    unsigned int opcode, void *buffer,
+				    size_t len,
+				    struct nvmetcp_command **cmd ) {
+	struct nvmetcp_device *nvme = queue->nvme;
+	struct nvme_command *sqe;
+	unsigned int cid;
+
+	/* Fail if queue is full */
+	if ( queue->count >= queue->depth ) {
+		DBGC ( nvme, "NVMeTCP %p qid %d is full\n", nvme, queue->qid );
+		return -ENOBUFS;
+	}
+
+	/* Choose an unused command identifier.  There must be at
+	 * least one, since the queue is not yet full.
+	 */
+	for ( cid = 0 ; nvmetcp_find ( queue, cid ) ; cid++ ) {}
+	assert ( cid < queue->depth );
+
+	/* Allocate and initialise structure */
+	*cmd = zalloc ( sizeof ( **cmd ) + type->priv_len );
+	if ( ! *cmd )
+		return -ENOMEM;
+	ref_init ( &(*cmd)->refcnt, nvmetcp_command_free );
+	intf_init ( &(*cmd)->block, &nvmetcp_command_block_desc,
+		    &(*cmd)->refcnt );
+	ref_get ( &nvme->refcnt );
+	(*cmd)->nvme = nvme;
+	(*cmd)->queue = queue;
+	(*cmd)->type = type;
+	(*cmd)->buffer = ( buffer ? buffer : nvmetcp_command_priv ( *cmd ) );
+	(*cmd)->len = len;
+
+	/* Fill in common submission queue entry fields */
+	sqe = &(*cmd)->sqe.cmd;
+	sqe->opcode = opcode;
+	sqe->flags = NVME_CMD_SGL;
+	sqe->cid = cid;
+	sqe->sgl.len = cpu_to_le32 ( len );
+	sqe->sgl.type = NVME_SGL_TRANSPORT;
+
+	/* Add to list of active commands.  (Reference is held by
+	 * command list.)
+	 */
+	list_add_tail ( &(*cmd)->list, &nvme->commands );
+	queue->count++;
+
+	return 0;
+}
+
+/**
+ * Issue NVMe/TCP command
+ *
+ * @v cmd		NVMe/TCP command
+ * @v parent		Parent interface, or NULL
+ * @ret rc		Return status code
+ *
+ * The command capsule is transmitted, along with any in-capsule
+ * data.  The command is completed on failure.
+ */
+static int nvmetcp_command_issue ( struct nvmetcp_command *cmd,
+				   struct interface *parent ) {
+	struct nvmetcp_device *nvme = cmd->nvme;
+	struct nvmetcp_queue *queue = cmd->queue;
+	struct nvmetcp_capsule_cmd *capsule;
+	struct io_buffer *iobuf;
+	size_t data_len;
+	size_t len;
+	int rc;
+
+	/* Calculate length of in-capsule data, if any */
+	data_len = ( ( cmd->sqe.cmd.sgl.type == NVME_SGL_DATA_OFFSET ) ?
+		     cmd->len : 0 );
+	len = ( sizeof ( *capsule ) + data_len );
+
+	/* Allocate I/O buffer */
+	iobuf = xfer_alloc_iob ( &queue->socket, len );
+	if ( ! iobuf ) {
+		rc = -ENOMEM;
+		goto err_alloc;
+	}
+
+	/* Construct command capsule */
+	capsule = iob_put ( iobuf, sizeof ( *capsule ) );
+	memset ( &capsule->hdr, 0, sizeof ( capsule->hdr ) );
+	capsule->hdr.type = NVMETCP_CAPSULECMD;
+	capsule->hdr.hlen = sizeof ( *capsule );
+	if ( data_len )
+		capsule->hdr.pdo = sizeof ( *capsule );
+	capsule->hdr.plen = cpu_to_le32 ( len );
+	memcpy ( &capsule->sqe, &cmd->sqe, sizeof ( capsule->sqe ) );
+	capsule->sqe.cmd.cid = cpu_to_le16 ( cmd->sqe.cmd.cid );
+	memcpy ( iob_put ( iobuf, data_len ), cmd->buffer, data_len );
+
+	/* Transmit command capsule */
+	if ( ( rc = xfer_deliver_iob ( &queue->socket, iobuf ) ) != 0 )
+		goto err_deliver;
+
+	DBGC2 ( nvme, "NVMeTCP %p qid %d cid %d %s opcode %#02x len %#zx\n",
+		nvme, queue->qid, cmd->sqe.cmd.cid, cmd->type->name,
+		cmd->sqe.cmd.opcode, cmd->len );
+
+	/* Attach to parent interface, if applicable */
+	if ( parent )
+		intf_plug_plug ( &cmd->block, parent );
+
+	return 0;
+
+ err_deliver:
+ err_alloc:
+	DBGC ( nvme, "NVMeTCP %p qid %d cid %d %s could not transmit: %s\n",
+	       nvme, queue->qid, cmd->sqe.cmd.cid, cmd->type->name,
+	       strerror ( rc ) );
+	nvmetcp_command_close ( cmd, rc );
+	return rc;
+}
+
+/**
+ * Transmit NVMe/TCP host to controller data
+ *
+ * @v cmd		NVMe/TCP command
+ * @v ttag		Transfer tag
+ * @v offset		Data offset
+ * @v len		Data length
+ * @ret rc		Return status code
+ *
+ * The requested data is split into H2CData PDUs no larger than the
+ * controller's maximum host to controller data length.
+ */
+static int nvmetcp_tx_h2c ( struct nvmetcp_command *cmd, unsigned int ttag,
+			    size_t offset, size_t len ) {
+	struct nvmetcp_queue *queue = cmd->queue;
+	struct nvmetcp_data *data;
+	struct io_buffer *iobuf;
+	size_t align = ( 4 * ( queue->cpda + 1 ) );
+	size_t pdo = ( ( sizeof ( *data ) + align - 1 ) & ~( align - 1 ) );
+	size_t frag_len;
+	int rc;
+
+	while ( len ) {
+
+		/* Calculate fragment length */
+		frag_len = len;
+		if ( frag_len > queue->maxh2cdata )
+			frag_len = queue->maxh2cdata;
+
+		/* Allocate I/O buffer */
+		iobuf = xfer_alloc_iob ( &queue->socket, ( pdo + frag_len ) );
+		if ( ! iobuf )
+			return -ENOMEM;
+
+		/* Construct data PDU */
+		data = iob_put ( iobuf, pdo );
+		memset ( data, 0, pdo );
+		data->hdr.type = NVMETCP_H2CDATA;
+		if ( frag_len == len )
+			data->hdr.flags = NVMETCP_FL_LAST_PDU;
+		data->hdr.hlen = sizeof ( *data );
+		data->hdr.pdo = pdo;
+		data->hdr.plen = cpu_to_le32 ( pdo + frag_len );
+		data->cccid = cpu_to_le16 ( cmd->sqe.cmd.cid );
+		data->ttag = cpu_to_le16 ( ttag );
+		data->datao = cpu_to_le32 ( offset );
+		data->datal = cpu_to_le32 ( frag_len );
+		memcpy ( iob_put ( iobuf, frag_len ), ( cmd->buffer + offset ),
+			 frag_len );
+
+		/* Transmit data PDU */
+		if ( ( rc = xfer_deliver_iob ( &queue->socket, iobuf ) ) != 0 )
+			return rc;
+
+		/* Move to next fragment */
+		offset += frag_len;
+		len -= frag_len;
+	}
+
+	return 0;
+}
+
+/******************************************************************************
+ *
+ * Controller initialisation
+ *
+ ******************************************************************************
+ */
+
+/**
+ * Issue NVMe/TCP property get command
+ *
+ * @v nvme		NVMe/TCP device
+ * @v type		Command type
+ * @v offset		Property offset
+ * @v attrib		Property attributes
+ * @ret rc		Return status code
+ */
+static int nvmetcp_property_get ( struct nvmetcp_device *nvme,
+				  struct nvmetcp_command_type *type,
+				  unsigned int offset, unsigned int attrib ) {
+	struct nvmetcp_command *cmd;
+	int rc;
+
+	/* Create command */
+	if ( ( rc = nvmetcp_command_create ( &nvme->admin, type, NVME_FABRICS,
+					     NULL, 0, &cmd ) ) != 0 )
+		return rc;
+	cmd->sqe.fabrics.fctype = NVME_FABRICS_PROPERTY_GET;
+	cmd->sqe.fabrics.property.attrib = attrib;
+	cmd->sqe.fabrics.property.offset = cpu_to_le32 ( offset );
+
+	/* Issue command */
+	return nvmetcp_command_issue ( cmd, NULL );
+}
+
+/**
+ * Issue NVMe/TCP admin command
+ *
+ * @v nvme		NVMe/TCP device
+ * @v type		Command type
+ * @v opcode		Opcode
+ * @v nsid		Namespace identifier
+ * @v cdw10		Command dword 10
+ * @v cdw11		Command dword 11
+ * @v len		Length of data to be returned
+ * @v parent		Parent interface, or NULL
+ * @ret rc		Return status code
+ */
+static int nvmetcp_admin ( struct nvmetcp_device *nvme,
+			   struct nvmetcp_command_type *type,
+			   unsigned int opcode, uint32_t nsid, uint32_t cdw10,
+			   uint32_t cdw11, size_t len,
+			   struct interface *parent ) {
+	struct nvmetcp_command *cmd;
+	int rc;
+
+	/* Create command */
+	if ( ( rc = nvmetcp_command_create ( &nvme->admin, type, opcode,
+					     NULL, len, &cmd ) ) != 0 )
+		return rc;
+	cmd->sqe.cmd.nsid = cpu_to_le32 ( nsid );
+	cmd->sqe.cmd.cdw[0] = cpu_to_le32 ( cdw10 );
+	cmd->sqe.cmd.cdw[1] = cpu_to_le32 ( cdw11 );
+
+	/* Issue command */
+	return nvmetcp_command_issue ( cmd, parent );
+}
+
+/**
+ * Open NVMe/TCP queue transport-layer connection
+ *
+ * @v queue		NVMe/TCP queue
+ * @ret rc		Return status code
+ */
+static int nvmetcp_open_queue ( struct nvmetcp_queue *queue ) {
+	struct nvmetcp_device *nvme = queue->nvme;
+	struct sockaddr_tcpip target;
+	int rc;
+
+	/* Open socket */
+	memset ( &target, 0, sizeof ( target ) );
+	target.st_port = htons ( nvme->target_port );
+	if ( ( rc = xfer_open_named_socket ( &queue->socket, SOCK_STREAM,
+					     ( struct sockaddr * ) &target,
+					     nvme->target_address,
+					     NULL ) ) != 0 ) {
+		DBGC ( nvme, "NVMeTCP %p qid %d could not open socket: %s\n",
+		       nvme, queue->qid, strerror ( rc ) );
+		return rc;
+	}
+
+	return 0;
+}
+
+/**
+ * Handle completion of set features (number of queues) command
+ *
+ * @v cmd		NVMe/TCP command
+ * @v cqe		Completion queue entry, or NULL
+ * @v rc		Reason for completion
+ */
+static void nvmetcp_queues_done ( struct nvmetcp_command *cmd,
+				  const struct nvme_cqe *cqe __unused,
+				  int rc ) {
+	struct nvmetcp_device *nvme = cmd->nvme;
+
+	/* Open I/O queue */
+	if ( ( rc != 0 ) ||
+	     ( ( rc = nvmetcp_open_queue ( &nvme->io ) ) != 0 ) ) {
+		nvmetcp_close ( nvme, rc );
+		return;
+	}
+}
+
+/** NVMe/TCP set features (number of queues) command type */
+static struct nvmetcp_command_type nvmetcp_queues_type = {
+	.name = "queues",
+	.done = nvmetcp_queues_done,
+};
+
+/**
+ * Handle completion of identify controller command
+ *
+ * @v cmd		NVMe/TCP command
+ * @v cqe		Completion queue entry, or NULL
+ * @v rc		Reason for completion
+ */
+static void nvmetcp_identify_done ( struct nvmetcp_command *cmd,
+				    const struct nvme_cqe *cqe __unused,
+				    int rc ) {
+	struct nvmetcp_device *nvme = cmd->nvme;
+	struct nvme_identify_ctrl *ctrl = cmd->buffer;
+
+	/* Check status */
+	if ( rc != 0 )
+		goto err;
+
+	/* Record maximum data transfer size */
+	if ( ctrl->mdts ) {
+		nvme->max_len = ( 1UL << ( ctrl->mdts + NVME_PAGE_SHIFT ) );
+		DBGC ( nvme, "NVMeTCP %p maximum transfer size %#zx\n",
+		       nvme, nvme->max_len );
+	}
+
+	/* Request a single I/O queue pair (using zero-based counts) */
+	if ( ( rc = nvmetcp_admin ( nvme, &nvmetcp_queues_type,
+				    NVME_SET_FEATURES, 0, NVME_FEAT_NUM_QUEUES,
+				    0, 0, NULL ) ) != 0 )
+		goto err;
+
+	return;
+
+ err:
+	nvmetcp_close ( nvme, rc );
+}
+
+/** NVMe/TCP identify controller command type */
+static struct nvmetcp_command_type nvmetcp_identify_type = {
+	.name = "identify",
+	.priv_len = NVME_IDENTIFY_LEN,
+	.done = nvmetcp_identify_done,
+};
+
+/** NVMe/TCP controller status command type */
+static struct nvmetcp_command_type nvmetcp_csts_type;
+
+/**
+ * Handle completion of controller status property get command
+ *
+ * @v cmd		NVMe/TCP command
+ * @v cqe		Completion queue entry, or NULL
+ * @v rc		Reason for completion
+ */
+static void nvmetcp_csts_done ( struct nvmetcp_command *cmd,
+				const struct nvme_cqe *cqe, int rc ) {
+	struct nvmetcp_device *nvme = cmd->nvme;
+	unsigned long elapsed;
+	uint32_t csts;
+
+	/* Check status */
+	if ( rc != 0 )
+		goto err;
+	assert ( cqe != NULL );
+	csts = le32_to_cpu ( cqe->dw0 );
+
+	/* Check for controller fatal status */
+	if ( csts & NVME_CSTS_CFS ) {
+		DBGC ( nvme, "NVMeTCP %p controller fatal status\n", nvme );
+		rc = -EIO;
+		goto err;
+	}
+
+	/* Wait for controller to become ready */
+	if ( ! ( csts & NVME_CSTS_RDY ) ) {
+		elapsed = ( currticks() - nvme->enabled );
+		if ( elapsed > nvme->ready_timeout ) {
+			DBGC ( nvme, "NVMeTCP %p timed out waiting for "
+			       "controller\n", nvme );
+			rc = -ETIMEDOUT;
+			goto err;
+		}
+		start_timer_fixed ( &nvme->timer,
+				    NVMETCP_READY_POLL_INTERVAL );
+		return;
+	}
+	DBGC ( nvme, "NVMeTCP %p controller is ready\n", nvme );
+
+	/* Identify controller */
+	if ( ( rc = nvmetcp_admin ( nvme, &nvmetcp_identify_type,
+				    NVME_IDENTIFY, 0, NVME_IDENTIFY_CTRL, 0,
+				    NVME_IDENTIFY_LEN, NULL ) ) != 0 )
+		goto err;
+
+	return;
+
+ err:
+	nvmetcp_close ( nvme, rc );
+}
+
+/** NVMe/TCP controller status command type */
+static struct nvmetcp_command_type nvmetcp_csts_type = {
+	.name = "csts",
+	.done = nvmetcp_csts_done,
+};
+
+/**
+ * Handle controller ready polling timer expiry
+ *
+ * @v timer		Controller ready polling timer
+ * @v over		Failure indicator
+ */
+static void nvmetcp_expired ( struct retry_timer *timer, int over __unused ) {
+	struct nvmetcp_device *nvme =
+		container_of ( timer, struct nvmetcp_device, timer );
+	int rc;
+
+	/* Poll controller status */
+	if ( ( rc = nvmetcp_property_get ( nvme, &nvmetcp_csts_type,
+					   NVME_CSTS, 0 ) ) != 0 )
+		nvmetcp_close ( nvme, rc );
+}
+
+/**
+ * Handle completion of controller configuration property set command
+ *
+ * @v cmd		NVMe/TCP command
+ * @v cqe		Completion queue entry, or NULL
+ * @v rc		Reason for completion
+ */
+static void nvmetcp_cc_done ( struct nvmetcp_command *cmd,
+			      const struct nvme_cqe *cqe __unused, int rc ) {
+	struct nvmetcp_device *nvme = cmd->nvme;
+
+	/* Poll controller status */
+	nvme->enabled = currticks();
+	if ( ( rc != 0 ) ||
+	     ( ( rc = nvmetcp_property_get ( nvme, &nvmetcp_csts_type,
+					     NVME_CSTS, 0 ) ) != 0 ) ) {
+		nvmetcp_close ( nvme, rc );
+		return;
+	}
+}
+
+/** NVMe/TCP controller configuration command type */
+static struct nvmetcp_command_type nvmetcp_cc_type = {
+	.name = "cc",
+	.done = nvmetcp_cc_done,
+};
+
+/**
+ * Handle completion of controller capabilities property get command
+ *
+ * @v cmd		NVMe/TCP command
+ * @v cqe		Completion queue entry, or NULL
+ * @v rc		Reason for completion
+ */
+static void nvmetcp_cap_done ( struct nvmetcp_command *cmd,
+			       const struct nvme_cqe *cqe, int rc ) {
+	struct nvmetcp_device *nvme = cmd->nvme;
+	struct nvmetcp_command *cc;
+	uint64_t cap;
+
+	/* Check status */
+	if ( rc != 0 )
+		goto err;
+	assert ( cqe != NULL );
+	cap = ( ( ( ( uint64_t ) le32_to_cpu ( cqe->dw1 ) ) << 32 ) |
+		le32_to_cpu ( cqe->dw0 ) );
+	DBGC ( nvme, "NVMeTCP %p capabilities %#016llx\n",
+	       nvme, ( ( unsigned long long ) cap ) );
+
+	/* Record controller ready timeout */
+	nvme->ready_timeout = ( ( NVME_CAP_TO ( cap ) * TICKS_PER_SEC ) / 2 );
+
+	/* Limit I/O queue depth to maximum supported */
+	if ( nvme->io.depth > ( NVME_CAP_MQES ( cap ) + 1 ) ) {
+		nvme->io.depth = ( NVME_CAP_MQES ( cap ) + 1 );
+		DBGC ( nvme, "NVMeTCP %p limited to queue depth %d\n",
+		       nvme, nvme->io.depth );
+	}
+
+	/* Enable controller */
+	if ( ( rc = nvmetcp_command_create ( &nvme->admin, &nvmetcp_cc_type,
+					     NVME_FABRICS, NULL, 0,
+					     &cc ) ) != 0 )
+		goto err;
+	cc->sqe.fabrics.fctype = NVME_FABRICS_PROPERTY_SET;
+	cc->sqe.fabrics.property.offset = cpu_to_le32 ( NVME_CC );
+	cc->sqe.fabrics.property.value =
+		cpu_to_le64 ( NVME_CC_EN | NVME_CC_IOSQES ( 6 ) |
+			      NVME_CC_IOCQES ( 4 ) );
+	if ( ( rc = nvmetcp_command_issue ( cc, NULL ) ) != 0 )
+		goto err;
+
+	return;
+
+ err:
+	nvmetcp_close ( nvme, rc );
+}
+
+/** NVMe/TCP controller capabilities command type */
+static struct nvmetcp_command_type nvmetcp_cap_type = {
+	.name = "cap",
+	.done = nvmetcp_cap_done,
+};
+
+/**
+ * Handle completion of connect command
+ *
+ * @v cmd		NVMe/TCP command
+ * @v cqe		Completion queue entry, or NULL
+ * @v rc		Reason for completion
+ */
+static void nvmetcp_connect_done ( struct nvmetcp_command *cmd,
+				   const struct nvme_cqe *cqe, int rc ) {
+	struct nvmetcp_device *nvme = cmd->nvme;
+	struct nvmetcp_queue *queue = cmd->queue;
+
+	/* Check status */
+	if ( rc != 0 )
+		goto err;
+	assert ( cqe != NULL );
+	queue->flags |= NVMETCP_QUEUE_CONNECTED;
+
+	/* Signal readiness once I/O queue is connected */
+	if ( queue == &nvme->io ) {
+		DBGC ( nvme, "NVMeTCP %p ready with queue depth %d\n",
+		       nvme, queue->depth );
+		xfer_window_changed ( &nvme->block );
+		return;
+	}
+
+	/* Record controller identifier and read controller capabilities */
+	nvme->cntlid = ( le32_to_cpu ( cqe->dw0 ) & 0xffff );
+	DBGC ( nvme, "NVMeTCP %p connected to controller %#04x\n",
+	       nvme, nvme->cntlid );
+	if ( ( rc = nvmetcp_property_get ( nvme, &nvmetcp_cap_type, NVME_CAP,
+					   NVME_PROPERTY_64BIT ) ) != 0 )
+		goto err;
+
+	return;
+
+ err:
+	nvmetcp_close ( nvme, rc );
+}
+
+/** NVMe/TCP connect command type */
+static struct nvmetcp_command_type nvmetcp_connect_type = {
+	.name = "connect",
+	.priv_len = sizeof ( struct nvme_connect_data ),
+	.done = nvmetcp_connect_done,
+};
+
+/**
+ * Connect NVMe/TCP queue
+ *
+ * @v queue		NVMe/TCP queue
+ * @ret rc		Return status code
+ */
+static int nvmetcp_connect ( struct nvmetcp_queue *queue ) {
+	struct nvmetcp_device *nvme = queue->nvme;
+	struct nvme_connect_data *data;
+	struct nvmetcp_command *cmd;
+	int rc;
+
+	/* Create command */
+	if ( ( rc = nvmetcp_command_create ( queue, &nvmetcp_connect_type,
+					     NVME_FABRICS, NULL,
+					     sizeof ( *data ), &cmd ) ) != 0 )
+		return rc;
+	cmd->sqe.fabrics.fctype = NVME_FABRICS_CONNECT;
+	cmd->sqe.fabrics.sgl.type = NVME_SGL_DATA_OFFSET;
+	cmd->sqe.fabrics.connect.qid = cpu_to_le16 ( queue->qid );
+	cmd->sqe.fabrics.connect.sqsize = cpu_to_le16 ( queue->depth - 1 );
+
+	/* Construct connect data */
+	data = cmd->buffer;
+	memcpy ( &data->hostid, &nvme->hostid, sizeof ( data->hostid ) );
+	data->cntlid = cpu_to_le16 ( ( queue == &nvme->admin ) ?
+				     NVME_CNTLID_DYNAMIC : nvme->cntlid );
+	snprintf ( data->subnqn, sizeof ( data->subnqn ), "%s", nvme->subnqn );
+	snprintf ( data->hostnqn, sizeof ( data->hostnqn ), "%s",
+		   nvme->hostnqn );
+
+	/* Issue command */
+	return nvmetcp_command_issue ( cmd, NULL );
+}
+
+/******************************************************************************
+ *
+ * Receive data path
+ *
+ ******************************************************************************
+ */
+
+/**
+ * Receive NVMe/TCP initialize connection response
+ *
+ * @v queue		NVMe/TCP queue
+ * @ret rc		Return status code
+ */
+static int nvmetcp_rx_icresp ( struct nvmetcp_queue *queue ) {
+	struct nvmetcp_device *nvme = queue->nvme;
+	struct nvmetcp_icresp *icresp = &queue->rx_pdu.icresp;
+
+	/* Sanity checks */
+	if ( queue->flags & NVMETCP_QUEUE_ICRESP ) {
+		DBGC ( nvme, "NVMeTCP %p qid %d duplicate ICResp\n",
+		       nvme, queue->qid );
+		return -EPROTO;
+	}
+	if ( icresp->pfv != 0 ) {
+		DBGC ( nvme, "NVMeTCP %p qid %d unsupported PDU format "
+		       "version %d\n", nvme, queue->qid,
+		       le16_to_cpu ( icresp->pfv ) );
+		return -ENOTSUP;
+	}
+	if ( icresp->dgst != 0 ) {
+		DBGC ( nvme, "NVMeTCP %p qid %d unrequested digests %#02x\n",
+		       nvme, queue->qid, icresp->dgst );
+		return -EPROTO;
+	}
+
+	/* Record connection parameters */
+	queue->maxh2cdata = le32_to_cpu ( icresp->maxh2cdata );
+	queue->cpda = icresp->cpda;
+	if ( ! queue->maxh2cdata ) {
+		DBGC ( nvme, "NVMeTCP %p qid %d invalid MAXH2CDATA\n",
+		       nvme, queue->qid );
+		return -EPROTO;
+	}
+	queue->flags |= NVMETCP_QUEUE_ICRESP;
+	DBGC ( nvme, "NVMeTCP %p qid %d initialised with MAXH2CDATA %#zx "
+	       "CPDA %d\n", nvme, queue->qid, queue->maxh2cdata, queue->cpda );
+
+	/* Connect queue */
+	return nvmetcp_connect ( queue );
+}
+
+/**
+ * Receive NVMe/TCP response capsule
+ *
+ * @v queue		NVMe/TCP queue
+ * @ret rc		Return status code
+ */
+static int nvmetcp_rx_resp ( struct nvmetcp_queue *queue ) {
+	struct nvmetcp_device *nvme = queue->nvme;
+	struct nvme_cqe *cqe = &queue->rx_pdu.resp.cqe;
+	struct nvmetcp_command *cmd;
+	unsigned int status;
+	int rc;
+
+	/* Identify command */
+	cmd = nvmetcp_find ( queue, le16_to_cpu ( cqe->cid ) );
+	if ( ! cmd ) {
+		DBGC ( nvme, "NVMeTCP %p qid %d response for unknown cid %d\n",
+		       nvme, queue->qid, le16_to_cpu ( cqe->cid ) );
+		return 0;
+	}
+
+	/* Check status */
+	status = NVME_STATUS ( le16_to_cpu ( cqe->status ) );
+	if ( status ) {
+		DBGC ( nvme, "NVMeTCP %p qid %d cid %d %s failed with status "
+		       "%#03x\n", nvme, queue->qid, cmd->sqe.cmd.cid,
+		       cmd->type->name, status );
+		rc = -EIO;
+	} else {
+		rc = 0;
+	}
+
+	/* Complete command */
+	nvmetcp_command_get ( cmd );
+	nvmetcp_command_done ( cmd, cqe, rc );
+	nvmetcp_command_put ( cmd );
+
+	return 0;
+}
+
+/**
+ * Receive NVMe/TCP controller to host data PDU header
+ *
+ * @v queue		NVMe/TCP queue
+ * @ret rc		Return status code
+ */
+static int nvmetcp_rx_c2h ( struct nvmetcp_queue *queue ) {
+	struct nvmetcp_device *nvme = queue->nvme;
+	struct nvmetcp_data *data = &queue->rx_pdu.data;
+	size_t datao = le32_to_cpu ( data->datao );
+	size_t datal = le32_to_cpu ( data->datal );
+	size_t len = ( le32_to_cpu ( data->hdr.plen ) - data->hdr.pdo );
+
+	/* Sanity check */
+	if ( datal != len ) {
+		DBGC ( nvme, "NVMeTCP %p qid %d C2HData length %#zx does not "
+		       "match PDU length %#zx\n", nvme, queue->qid, datal,
+		       len );
+		return -EPROTO;
+	}
+
+	DBGC2 ( nvme, "NVMeTCP %p qid %d cid %d C2HData %#zx+%#zx\n",
+		nvme, queue->qid, le16_to_cpu ( data->cccid ), datao, datal );
+	return 0;
+}
+
+/**
+ * Receive NVMe/TCP controller to host data
+ *
+ * @v queue		NVMe/TCP queue
+ * @v data		Received data
+ * @v offset		Offset within PDU data
+ * @v len		Length of received data
+ * @ret rc		Return status code
+ */
+static int nvmetcp_rx_c2h_data ( struct nvmetcp_queue *queue,
+				 const void *data, size_t offset,
+				 size_t len ) {
+	struct nvmetcp_device *nvme = queue->nvme;
+	struct nvmetcp_data *c2h = &queue->rx_pdu.data;
+	struct nvmetcp_command *cmd;
+
+	/* Identify command, ignoring data for aborted commands */
+	cmd = nvmetcp_find ( queue, le16_to_cpu ( c2h->cccid ) );
+	if ( ! cmd )
+		return 0;
+
+	/* Copy data to command buffer */
+	offset += le32_to_cpu ( c2h->datao );
+	if ( ( cmd->sqe.cmd.opcode == NVME_WRITE ) ||
+	     ( offset > cmd->len ) || ( len > ( cmd->len - offset ) ) ) {
+		DBGC ( nvme, "NVMeTCP %p qid %d cid %d invalid C2HData "
+		       "%#zx+%#zx\n", nvme, queue->qid, cmd->sqe.cmd.cid,
+		       offset, len );
+		return -EPROTO;
+	}
+	memcpy ( ( cmd->buffer + offset ), data, len );
+
+	return 0;
+}
+
+/**
+ * Complete NVMe/TCP controller to host data PDU
+ *
+ * @v queue		NVMe/TCP queue
+ * @ret rc		Return status code
+ */
+static int nvmetcp_rx_c2h_done ( struct nvmetcp_queue *queue ) {
+	struct nvmetcp_data *data = &queue->rx_pdu.data;
+	unsigned int flags = ( NVMETCP_FL_LAST_PDU | NVMETCP_FL_SUCCESS );
+	struct nvmetcp_command *cmd;
+
+	/* Complete command if no response capsule will follow */
+	if ( ( data->hdr.flags & flags ) != flags )
+		return 0;
+	cmd = nvmetcp_find ( queue, le16_to_cpu ( data->cccid ) );
+	if ( cmd ) {
+		nvmetcp_command_get ( cmd );
+		nvmetcp_command_done ( cmd, NULL, 0 );
+		nvmetcp_command_put ( cmd );
+	}
+
+	return 0;
+}
+
+/**
+ * Receive NVMe/TCP ready to transfer PDU
+ *
+ * @v queue		NVMe/TCP queue
+ * @ret rc		Return status code
+ */
+static int nvmetcp_rx_r2t ( struct nvmetcp_queue *queue ) {
+	struct nvmetcp_device *nvme = queue->nvme;
+	struct nvmetcp_r2t *r2t = &queue->rx_pdu.r2t;
+	size_t offset = le32_to_cpu ( r2t->r2to );
+	size_t len = le32_to_cpu ( r2t->r2tl );
+	struct nvmetcp_command *cmd;
+	int rc;
+
+	/* Identify command */
+	cmd = nvmetcp_find ( queue, le16_to_cpu ( r2t->cccid ) );
+	if ( ! cmd ) {
+		DBGC ( nvme, "NVMeTCP %p qid %d R2T for unknown cid %d\n",
+		       nvme, queue->qid, le16_to_cpu ( r2t->cccid ) );
+		return -EPROTO;
+	}
+	DBGC2 ( nvme, "NVMeTCP %p qid %d cid %d R2T %#zx+%#zx\n",
+		nvme, queue->qid, cmd->sqe.cmd.cid, offset, len );
+
+	/* Sanity check */
+	if ( ( cmd->sqe.cmd.opcode != NVME_WRITE ) || ( offset > cmd->len ) ||
+	     ( len > ( cmd->len - offset ) ) ) {
+		DBGC ( nvme, "NVMeTCP %p qid %d cid %d invalid R2T "
+		       "%#zx+%#zx\n", nvme, queue->qid, cmd->sqe.cmd.cid,
+		       offset, len );
+		return -EPROTO;
+	}
+
+	/* Transmit requested data */
+	if ( ( rc = nvmetcp_tx_h2c ( cmd, le16_to_cpu ( r2t->ttag ), offset,
+				     len ) ) != 0 ) {
+		DBGC ( nvme, "NVMeTCP %p qid %d cid %d could not transmit "
+		       "data: %s\n", nvme, queue->qid, cmd->sqe.cmd.cid,
+		       strerror ( rc ) );
+		return rc;
+	}
+
+	return 0;
+}
+
+/**
+ * Receive NVMe/TCP controller to host terminate connection request
+ *
+ * @v queue		NVMe/TCP queue
+ * @ret rc		Return status code
+ */
+static int nvmetcp_rx_term ( struct nvmetcp_queue *queue ) {
+	struct nvmetcp_device *nvme = queue->nvme;
+	struct nvmetcp_term *term = &queue->rx_pdu.term;
+
+	DBGC ( nvme, "NVMeTCP %p qid %d terminated with status %#04x info "
+	       "%#08x\n", nvme, queue->qid, le16_to_cpu ( term->fes ),
+	       le32_to_cpu ( term->fei ) );
+	return -ECONNRESET;
+}
+
+/**
+ * Receive NVMe/TCP PDU header
+ *
+ * @v queue		NVMe/TCP queue
+ * @ret rc		Return status code
+ */
+static int nvmetcp_rx_header ( struct nvmetcp_queue *queue ) {
+	struct nvmetcp_device *nvme = queue->nvme;
+	struct nvmetcp_header *hdr = &queue->rx_pdu.hdr;
+	int ( * rx ) ( struct nvmetcp_queue *queue );
+	size_t hlen;
+
+	/* Identify PDU type */
+	switch ( hdr->type ) {
+	case NVMETCP_ICRESP:
+		rx = nvmetcp_rx_icresp;
+		hlen = sizeof ( queue->rx_pdu.icresp );
+		break;
+	case NVMETCP_CAPSULERESP:
+		rx = nvmetcp_rx_resp;
+		hlen = sizeof ( queue->rx_pdu.resp );
+		break;
+	case NVMETCP_C2HDATA:
+		rx = nvmetcp_rx_c2h;
+		hlen = sizeof ( queue->rx_pdu.data );
+		break;
+	case NVMETCP_R2T:
+		rx = nvmetcp_rx_r2t;
+		hlen = sizeof ( queue->rx_pdu.r2t );
+		break;
+	case NVMETCP_C2HTERM:
+		rx = nvmetcp_rx_term;
+		hlen = sizeof ( queue->rx_pdu.term );
+		break;
+	default:
+		DBGC ( nvme, "NVMeTCP %p qid %d unsupported PDU type %#02x\n",
+		       nvme, queue->qid, hdr->type );
+		return -ENOTSUP;
+	}
+
+	/* Sanity checks */
+	if ( hdr->hlen != hlen ) {
+		DBGC ( nvme, "NVMeTCP %p qid %d PDU type %#02x has invalid "
+		       "header length %d\n", nvme, queue->qid, hdr->type,
+		       hdr->hlen );
+		return -EPROTO;
+	}
+	if ( ( hdr->type != NVMETCP_ICRESP ) && ( hdr->type != NVMETCP_C2HTERM )
+	     && ! ( queue->flags & NVMETCP_QUEUE_ICRESP ) ) {
+		DBGC ( nvme, "NVMeTCP %p qid %d PDU type %#02x before ICResp\n",
+		       nvme, queue->qid, hdr->type );
+		return -EPROTO;
+	}
+
+	return rx ( queue );
+}
+
+/**
+ * Move to next NVMe/TCP receive state
+ *
+ * @v queue		NVMe/TCP queue
+ * @ret rc		Return status code
+ */
+static int nvmetcp_rx_step ( struct nvmetcp_queue *queue ) {
+	struct nvmetcp_device *nvme = queue->nvme;
+	struct nvmetcp_header *hdr = &queue->rx_pdu.hdr;
+	size_t plen = le32_to_cpu ( hdr->plen );
+	int rc;
+
+	switch ( queue->rx_state ) {
+	case NVMETCP_RX_COMMON:
+		if ( ( hdr->hlen < sizeof ( *hdr ) ) ||
+		     ( hdr->hlen > sizeof ( queue->rx_pdu ) ) ||
+		     ( plen < hdr->hlen ) ) {
+			DBGC ( nvme, "NVMeTCP %p qid %d invalid PDU lengths "
+			       "%d/%d/%#zx\n", nvme, queue->qid, hdr->hlen,
+			       hdr->pdo, plen );
+			return -EPROTO;
+		}
+		queue->rx_state = NVMETCP_RX_HEADER;
+		return 0;
+	case NVMETCP_RX_HEADER:
+		/* Treat a zero data offset as indicating that any
+		 * data immediately follows the header.
+		 */
+		if ( hdr->pdo < hdr->hlen )
+			hdr->pdo = hdr->hlen;
+		if ( hdr->pdo > plen ) {
+			DBGC ( nvme, "NVMeTCP %p qid %d invalid PDU data "
+			       "offset %d\n", nvme, queue->qid, hdr->pdo );
+			return -EPROTO;
+		}
+		if ( ( rc = nvmetcp_rx_header ( queue ) ) != 0 )
+			return rc;
+		if ( plen > hdr->hlen ) {
+			queue->rx_state = NVMETCP_RX_PAD;
+			return 0;
+		}
+		break;
+	case NVMETCP_RX_PAD:
+		queue->rx_state = NVMETCP_RX_DATA;
+		return 0;
+	case NVMETCP_RX_DATA:
+		if ( ( hdr->type == NVMETCP_C2HDATA ) &&
+		     ( ( rc = nvmetcp_rx_c2h_done ( queue ) ) != 0 ) )
+			return rc;
+		break;
+	default:
+		assert ( 0 );
+		return -EINVAL;
+	}
+
+	/* Move to next PDU */
+	queue->rx_state = NVMETCP_RX_COMMON;
+	queue->rx_offset = 0;
+	return 0;
+}
+
+/**
+ * Receive new data
+ *
+ * @v queue		NVMe/TCP queue
+ * @v iobuf		I/O buffer
+ * @v meta		Data transfer metadata
+ * @ret rc		Return status code
+ *
+ * The receive state machine tracks the offset within the current
+ * PDU.  Each state continues until the offset reaches the end of the
+ * common header, the PDU-specific header, the padding before the
+ * data, or the data itself.
+ */
+static int nvmetcp_socket_deliver ( struct nvmetcp_queue *queue,
+				    struct io_buffer *iobuf,
+				    struct xfer_metadata *meta __unused ) {
+	struct nvmetcp_device *nvme = queue->nvme;
+	struct nvmetcp_header *hdr = &queue->rx_pdu.hdr;
+	size_t frag_len;
+	size_t end;
+	int rc;
+
+	/* Process data until exhausted, or until the queue is closed */
+	while ( iob_len ( iobuf ) && queue->flags ) {
+
+		/* Determine end of current state */
+		switch ( queue->rx_state ) {
+		case NVMETCP_RX_COMMON:
+			end = sizeof ( *hdr );
+			break;
+		case NVMETCP_RX_HEADER:
+			end = hdr->hlen;
+			break;
+		case NVMETCP_RX_PAD:
+			end = hdr->pdo;
+			break;
+		case NVMETCP_RX_DATA:
+			end = le32_to_cpu ( hdr->plen );
+			break;
+		default:
+			assert ( 0 );
+			rc = -EINVAL;
+			goto err;
+		}
+		assert ( queue->rx_offset <= end );
+
+		/* Consume data */
+		frag_len = ( end - queue->rx_offset );
+		if ( frag_len > iob_len ( iobuf ) )
+			frag_len = iob_len ( iobuf );
+		if ( queue->rx_state <= NVMETCP_RX_HEADER ) {
+			memcpy ( &queue->rx_pdu.bytes[queue->rx_offset],
+				 iobuf->data, frag_len );
+		} else if ( ( queue->rx_state == NVMETCP_RX_DATA ) &&
+			    ( hdr->type == NVMETCP_C2HDATA ) &&
+			    ( ( rc = nvmetcp_rx_c2h_data ( queue, iobuf->data,
+						 ( queue->rx_offset - hdr->pdo ),
+						 frag_len ) ) != 0 ) ) {
+			goto err;
+		}
+		queue->rx_offset += frag_len;
+		iob_pull ( iobuf, frag_len );
+
+		/* Move to next state, if applicable */
+		if ( ( queue->rx_offset == end ) &&
+		     ( ( rc = nvmetcp_rx_step ( queue ) ) != 0 ) )
+			goto err;
+	}
+
+	free_iob ( iobuf );
+	return 0;
+
+ err:
+	DBGC ( nvme, "NVMeTCP %p qid %d could not process received data: "
+	       "%s\n", nvme, queue->qid, strerror ( rc ) );
+	free_iob ( iobuf );
+	nvmetcp_close ( nvme, rc );
+	return rc;
+}
+
+/******************************************************************************
+ *
+ * Transport-layer connections
+ *
+ ******************************************************************************
+ */
+
+/**
+ * Handle transport-layer window change
+ *
+ * @v queue		NVMe/TCP queue
+ *
+ * The initialize connection request is sent as soon as the
+ * transport-layer connection is able to accept data.
+ */
+static void nvmetcp_socket_window_changed ( struct nvmetcp_queue *queue ) {
+	struct nvmetcp_device *nvme = queue->nvme;
+	struct nvmetcp_icreq *icreq;
+	struct io_buffer *iobuf;
+	int rc;
+
+	/* Do nothing unless we need to send a connection request */
+	if ( ( queue->flags & NVMETCP_QUEUE_ICREQ ) ||
+	     ( ! xfer_window ( &queue->socket ) ) )
+		return;
+
+	/* Allocate I/O buffer */
+	iobuf = xfer_alloc_iob ( &queue->socket, sizeof ( *icreq ) );
+	if ( ! iobuf ) {
+		rc = -ENOMEM;
+		goto err_alloc;
+	}
+
+	/* Construct initialize connection request */
+	icreq = iob_put ( iobuf, sizeof ( *icreq ) );
+	memset ( icreq, 0, sizeof ( *icreq ) );
+	icreq->hdr.type = NVMETCP_ICREQ;
+	icreq->hdr.hlen = sizeof ( *icreq );
+	icreq->hdr.plen = cpu_to_le32 ( sizeof ( *icreq ) );
+
+	/* Transmit initialize connection request */
+	if ( ( rc = xfer_deliver_iob ( &queue->socket, iobuf ) ) != 0 )
+		goto err_deliver;
+	queue->flags |= NVMETCP_QUEUE_ICREQ;
+	DBGC ( nvme, "NVMeTCP %p qid %d sent ICReq\n", nvme, queue->qid );
+
+	return;
+
+ err_deliver:
+ err_alloc:
+	DBGC ( nvme, "NVMeTCP %p qid %d could not send ICReq: %s\n",
+	       nvme, queue->qid, strerror ( rc ) );
+	nvmetcp_close ( nvme, rc );
+}
+
+/**
+ * Handle transport-layer connection closure
+ *
+ * @v queue		NVMe/TCP queue
+ * @v rc		Reason for close
+ */
+static void nvmetcp_socket_close ( struct nvmetcp_queue *queue, int rc ) {
+	struct nvmetcp_device *nvme = queue->nvme;
+
+	DBGC ( nvme, "NVMeTCP %p qid %d connection closed: %s\n",
+	       nvme, queue->qid, strerror ( rc ) );
+
+	/* Treat any closure as an error */
+	if ( rc == 0 )
+		rc = -ECONNRESET;
+	nvmetcp_close ( nvme, rc );
+}
+
+/**
+ * Handle redirection event
+ *
+ * @v queue		NVMe/TCP queue
+ * @v type		Location type
+ * @v args		Remaining arguments depend upon location type
+ * @ret rc		Return status code
+ */
+static int nvmetcp_vredirect ( struct nvmetcp_queue *queue, int type,
+			       va_list args ) {
+	struct nvmetcp_device *nvme = queue->nvme;
+	struct sockaddr *peer;
+	va_list tmp;
+	int rc;
+
+	/* Intercept redirects to a LOCATION_SOCKET and record the
+	 * address for the boot firmware table, as for iSCSI.
+	 */
+	if ( type == LOCATION_SOCKET ) {
+		va_copy ( tmp, args );
+		( void ) va_arg ( tmp, int ); /* Discard "semantics" */
+		peer = va_arg ( tmp, struct sockaddr * );
+		memcpy ( &nvme->target_sockaddr, peer,
+			 sizeof ( nvme->target_sockaddr ) );
+		va_end ( tmp );
+	}
+
+	/* Redirect to new location */
+	if ( ( rc = xfer_vreopen ( &queue->socket, type, args ) ) != 0 )
+		goto err;
+
+	return 0;
+
+ err:
+	nvmetcp_close ( nvme, rc );
+	return rc;
+}
+
+/** NVMe/TCP socket interface operations */
+static struct interface_operation nvmetcp_socket_op[] = {
+	INTF_OP ( xfer_deliver, struct nvmetcp_queue *,
+		  nvmetcp_socket_deliver ),
+	INTF_OP ( xfer_window_changed, struct nvmetcp_queue *,
+		  nvmetcp_socket_window_changed ),
+	INTF_OP ( xfer_vredirect, struct nvmetcp_queue *,
+		  nvmetcp_vredirect ),
+	INTF_OP ( intf_close, struct nvmetcp_queue *, nvmetcp_socket_close ),
+};
+
+/** NVMe/TCP socket interface descriptor */
+static struct interface_descriptor nvmetcp_socket_desc =
+	INTF_DESC ( struct nvmetcp_queue, socket, nvmetcp_socket_op );
+
+/**
+ * Initialise NVMe/TCP queue
+ *
+ * @v queue		NVMe/TCP queue
+ * @v nvme		NVMe/TCP device
+ * @v qid		Queue identifier
+ * @v depth		Number of command slots
+ */
+static void nvmetcp_queue_init ( struct nvmetcp_queue *queue,
+				 struct nvmetcp_device *nvme,
+				 unsigned int qid, unsigned int depth ) {
+
+	queue->nvme = nvme;
+	intf_init ( &queue->socket, &nvmetcp_socket_desc, &nvme->refcnt );
+	queue->qid = qid;
+	queue->depth = depth;
+}
+
+/**
+ * Close NVMe/TCP queue
+ *
+ * @v queue		NVMe/TCP queue
+ * @v rc		Reason for close
+ */
+static void nvmetcp_queue_close ( struct nvmetcp_queue *queue, int rc ) {
+
+	/* Shut down socket */
+	intf_shutdown ( &queue->socket, rc );
+
+	/* Reset connection and receive state */
+	queue->flags = 0;
+	queue->rx_state = NVMETCP_RX_COMMON;
+	queue->rx_offset = 0;
+}
+
+/******************************************************************************
+ *
+ * Block device interface
+ *
+ ******************************************************************************
+ */
+
+/**
+ * Free NVMe/TCP device
+ *
+ * @v refcnt		Reference count
+ */
+static void nvmetcp_free ( struct refcnt *refcnt ) {
+	struct nvmetcp_device *nvme =
+		container_of ( refcnt, struct nvmetcp_device, refcnt );
+
+	assert ( list_empty ( &nvme->commands ) );
+	free ( nvme->target_address );
+	free ( nvme->subnqn );
+	free ( nvme->hostnqn );
+	free ( nvme );
+}
+
+/**
+ * Close NVMe/TCP device
+ *
+ * @v nvme		NVMe/TCP device
+ * @v rc		Reason for close
+ */
+static void nvmetcp_close ( struct nvmetcp_device *nvme, int rc ) {
+	struct nvmetcp_command *cmd;
+
+	/* Stop controller ready polling */
+	stop_timer ( &nvme->timer );
+
+	/* Shut down interfaces */
+	intf_shutdown ( &nvme->block, rc );
+	nvmetcp_queue_close ( &nvme->io, rc );
+	nvmetcp_queue_close ( &nvme->admin, rc );
+
+	/* Shut down any active commands.  Completing a command may
+	 * cause this function to be called recursively, so we cannot
+	 * safely iterate over the list.
+	 */
+	while ( ( cmd = list_first_entry ( &nvme->commands,
+					   struct nvmetcp_command,
+					   list ) ) ) {
+		nvmetcp_command_close ( cmd, rc );
+	}
+}
+
+/**
+ * Handle completion of read or write command
+ *
+ * @v cmd		NVMe/TCP command
+ * @v cqe		Completion queue entry, or NULL
+ * @v rc		Reason for completion
+ */
+static void nvmetcp_rw_done ( struct nvmetcp_command *cmd __unused,
+			      const struct nvme_cqe *cqe __unused,
+			      int rc __unused ) {
+
+	/* Nothing to do */
+}
+
+/** NVMe/TCP read or write command type */
+static struct nvmetcp_command_type nvmetcp_rw_type = {
+	.name = "rw",
+	.done = nvmetcp_rw_done,
+};
+
+/**
+ * Issue NVMe/TCP read or write command
+ *
+ * @v nvme		NVMe/TCP device
+ * @v data		Data interface
+ * @v opcode		Opcode
+ * @v lba		Starting logical block address
+ * @v count		Number of logical blocks
+ * @v buffer		Data buffer
+ * @v len		Length of data buffer
+ * @ret rc		Return status code
+ */
+static int nvmetcp_rw ( struct nvmetcp_device *nvme, struct interface *data,
+			unsigned int opcode, uint64_t lba, unsigned int count,
+			void *buffer, size_t len ) {
+	struct nvmetcp_command *cmd;
+	int rc;
+
+	/* Fail unless I/O queue is connected */
+	if ( ! ( nvme->io.flags & NVMETCP_QUEUE_CONNECTED ) )
+		return -ENOTCONN;
+
+	/* Sanity check */
+	if ( ( count == 0 ) || ( count > NVMETCP_MAX_COUNT ) )
+		return -EINVAL;
+
+	/* Create command */
+	if ( ( rc = nvmetcp_command_create ( &nvme->io, &nvmetcp_rw_type,
+					     opcode, buffer, len,
+					     &cmd ) ) != 0 )
+		return rc;
+	cmd->sqe.cmd.nsid = cpu_to_le32 ( nvme->nsid );
+	cmd->sqe.cmd.cdw[0] = cpu_to_le32 ( lba & 0xffffffffUL );
+	cmd->sqe.cmd.cdw[1] = cpu_to_le32 ( lba >> 32 );
+	cmd->sqe.cmd.cdw[2] = cpu_to_le32 ( count - 1 );
+
+	/* Issue command */
+	return nvmetcp_command_issue ( cmd, data );
+}
+
+/**
+ * Read from NVMe/TCP device
+ *
+ * @v nvme		NVMe/TCP device
+ * @v data		Data interface
+ * @v lba		Starting logical block address
+ * @v count		Number of logical blocks
+ * @v buffer		Data buffer
+ * @v len		Length of data buffer
+ * @ret rc		Return status code
+ */
+static int nvmetcp_read ( struct nvmetcp_device *nvme, struct interface *data,
+			  uint64_t lba, unsigned int count, void *buffer,
+			  size_t len ) {
+	return nvmetcp_rw ( nvme, data, NVME_READ, lba, count, buffer, len );
+}
+
+/**
+ * Write to NVMe/TCP device
+ *
+ * @v nvme		NVMe/TCP device
+ * @v data		Data interface
+ * @v lba		Starting logical block address
+ * @v count		Number of logical blocks
+ * @v buffer		Data buffer
+ * @v len		Length of data buffer
+ * @ret rc		Return status code
+ */
+static int nvmetcp_write ( struct nvmetcp_device *nvme,
+			   struct interface *data, uint64_t lba,
+			   unsigned int count, void *buffer, size_t len ) {
+	return nvmetcp_rw ( nvme, data, NVME_WRITE, lba, count, buffer, len );
+}
+
+/**
+ * Handle completion of identify namespace command
+ *
+ * @v cmd		NVMe/TCP command
+ * @v cqe		Completion queue entry, or NULL
+ * @v rc		Reason for completion
+ */
+static void nvmetcp_capacity_done ( struct nvmetcp_command *cmd,
+				    const struct nvme_cqe *cqe __unused,
+				    int rc ) {
+	struct nvmetcp_device *nvme = cmd->nvme;
+	struct nvme_identify_ns *ns = cmd->buffer;
+	struct block_device_capacity capacity;
+	unsigned int lbads;
+
+	/* Do nothing on error */
+	if ( rc != 0 )
+		return;
+
+	/* Record namespace identifier for EFI device path */
+	memcpy ( nvme->nguid, ns->nguid, sizeof ( nvme->nguid ) );
+
+	/* Construct capacity */
+	lbads = ns->lbaf[ NVME_FLBAS_INDEX ( ns->flbas ) ].lbads;
+	capacity.blocks = le64_to_cpu ( ns->nsze );
+	capacity.blksize = ( 1UL << lbads );
+	capacity.max_count = NVMETCP_MAX_COUNT;
+	if ( nvme->max_len &&
+	     ( capacity.max_count > ( nvme->max_len >> lbads ) ) ) {
+		capacity.max_count = ( nvme->max_len >> lbads );
+	}
+	DBGC ( nvme, "NVMeTCP %p nsid %d has %#llx blocks of %#zx bytes\n",
+	       nvme, nvme->nsid, ( ( unsigned long long ) capacity.blocks ),
+	       capacity.blksize );
+
+	/* Return capacity to caller */
+	block_capacity ( &cmd->block, &capacity );
+}
+
+/** NVMe/TCP identify namespace command type */
+static struct nvmetcp_command_type nvmetcp_capacity_type = {
+	.name = "capacity",
+	.priv_len = NVME_IDENTIFY_LEN,
+	.done = nvmetcp_capacity_done,
+};
+
+/**
+ * Read NVMe/TCP device capacity
+ *
+ * @v nvme		NVMe/TCP device
+ * @v data		Data interface
+ * @ret rc		Return status code
+ */
+static int nvmetcp_read_capacity ( struct nvmetcp_device *nvme,
+				   struct interface *data ) {
+
+	/* Fail unless I/O queue is connected */
+	if ( ! ( nvme->io.flags & NVMETCP_QUEUE_CONNECTED ) )
+		return -ENOTCONN;
+
+	/* Identify namespace */
+	return nvmetcp_admin ( nvme, &nvmetcp_capacity_type, NVME_IDENTIFY,
+			       nvme->nsid, NVME_IDENTIFY_NS, 0,
+			       NVME_IDENTIFY_LEN, data );
+}
+
+/**
+ * Check NVMe/TCP device flow-control window
+ *
+ * @v nvme		NVMe/TCP device
+ * @ret len		Length of window
+ */
+static size_t nvmetcp_window ( struct nvmetcp_device *nvme ) {
+	struct nvmetcp_queue *io = &nvme->io;
+
+	return ( ( io->flags & NVMETCP_QUEUE_CONNECTED ) ?
+		 ( io->depth - io->count ) : 0 );
+}
+
+/**
+ * Get NVMe/TCP ACPI descriptor
+ *
+ * @v nvme		NVMe/TCP device
+ * @ret desc		ACPI descriptor
+ */
+static struct acpi_descriptor *
+nvmetcp_describe ( struct nvmetcp_device *nvme ) {
+	return &nvme->desc;
+}
+
+/** NVMe/TCP block interface operations */
+static struct interface_operation nvmetcp_block_op[] = {
+	INTF_OP ( block_read, struct nvmetcp_device *, nvmetcp_read ),
+	INTF_OP ( block_write, struct nvmetcp_device *, nvmetcp_write ),
+	INTF_OP ( block_read_capacity, struct nvmetcp_device *,
+		  nvmetcp_read_capacity ),
+	INTF_OP ( xfer_window, struct nvmetcp_device *, nvmetcp_window ),
+	INTF_OP ( intf_close, struct nvmetcp_device *, nvmetcp_close ),
+	INTF_OP ( acpi_describe, struct nvmetcp_device *, nvmetcp_describe ),
+	EFI_INTF_OP ( efi_describe, struct nvmetcp_device *,
+		      efi_nvmetcp_path ),
+};
+
+/** NVMe/TCP block interface descriptor */
+static struct interface_descriptor nvmetcp_block_desc =
+	INTF_DESC ( struct nvmetcp_device, block, nvmetcp_block_op );
+
+/******************************************************************************
+ *
+ * Settings
+ *
+ ******************************************************************************
+ */
+
+/** NVMe host NQN setting */
+const struct setting nvme_host_nqn_setting __setting ( SETTING_SANBOOT_EXTRA,
+						       nvme-host-nqn ) = {
+	.name = "nvme-host-nqn",
+	.description = "NVMe host name",
+	.type = &setting_type_string,
+};
+
+/** NVMe/TCP queue depth setting */
+const struct setting nvme_depth_setting __setting ( SETTING_SANBOOT_EXTRA,
+						    nvme-depth ) = {
+	.name = "nvme-depth",
+	.description = "NVMe/TCP I/O queue depth",
+	.type = &setting_type_uint16,
+};
+
+/**
+ * Fetch NVMe/TCP settings
+ *
+ * @v nvme		NVMe/TCP device
+ * @ret rc		Return status code
+ */
+static int nvmetcp_fetch_settings ( struct nvmetcp_device *nvme ) {
+	unsigned long depth;
+	unsigned int i;
+
+	/* Use system UUID as host identifier, if available */
+	if ( fetch_uuid_setting ( NULL, &uuid_setting, &nvme->hostid ) < 0 ) {
+		for ( i = 0 ; i < sizeof ( nvme->hostid.raw ) ; i++ )
+			nvme->hostid.raw[i] = random();
+	}
+
+	/* Use explicit host NQN if provided, otherwise construct a
+	 * host NQN from the host identifier.
+	 */
+	fetch_string_setting_copy ( NULL, &nvme_host_nqn_setting,
+				    &nvme->hostnqn );
+	if ( ( ! nvme->hostnqn ) &&
+	     ( asprintf ( &nvme->hostnqn,
+			  NVMETCP_DEFAULT_HOSTNQN_PREFIX "%s",
+			  uuid_ntoa ( &nvme->hostid ) ) < 0 ) ) {
+		return -ENOMEM;
+	}
+	if ( strlen ( nvme->hostnqn ) >=
+	     sizeof ( ( ( struct nvme_connect_data * ) NULL )->hostnqn ) ) {
+		DBGC ( nvme, "NVMeTCP %p host NQN too long\n", nvme );
+		return -EINVAL;
+	}
+
+	/* Use explicit queue depth if provided */
+	if ( fetch_uint_setting ( NULL, &nvme_depth_setting, &depth ) >= 0 ) {
+		if ( ( depth == 0 ) || ( depth > NVMETCP_MAX_DEPTH ) ) {
+			DBGC ( nvme, "NVMeTCP %p invalid queue depth %ld\n",
+			       nvme, depth );
+			return -EINVAL;
+		}
+		nvme->io.depth = depth;
+	}
+
+	return 0;
+}
+
+/******************************************************************************
+ *
+ * NVMe/TCP URIs
+ *
+ ******************************************************************************
+ */
+
+/**
+ * Parse NVMe/TCP URI
+ *
+ * @v nvme		NVMe/TCP device
+ * @v uri		URI
+ * @ret rc		Return status code
+ *
+ * An NVMe/TCP URI has the form
+ * "nvme-tcp://<host>[:<port>]/<subsystem NQN>[/<namespace ID>]".
+ * The namespace identifier defaults to 1 if not specified.
+ */
+static int nvmetcp_parse_uri ( struct nvmetcp_device *nvme,
+			       struct uri *uri ) {
+	const char *path;
+	const char *sep;
+	char *end;
+	size_t len;
+
+	/* Parse target address and port */
+	if ( ! uri->host ) {
+		DBGC ( nvme, "NVMeTCP %p has no target address\n", nvme );
+		return -EINVAL;
+	}
+	nvme->target_address = strdup ( uri->host );
+	if ( ! nvme->target_address )
+		return -ENOMEM;
+	nvme->target_port = uri_port ( uri, NVMETCP_PORT );
+
+	/* Parse subsystem NQN and namespace identifier */
+	path = uri->path;
+	if ( ( ! path ) || ( *(path++) != '/' ) || ( ! *path ) ) {
+		DBGC ( nvme, "NVMeTCP %p has no subsystem NQN\n", nvme );
+		return -EINVAL;
+	}
+	sep = strchr ( path, '/' );
+	if ( sep ) {
+		len = ( sep - path );
+		nvme->nsid = strtoul ( ( sep + 1 ), &end, 0 );
+		if ( *end || ( ! nvme->nsid ) ) {
+			DBGC ( nvme, "NVMeTCP %p invalid namespace \"%s\"\n",
+			       nvme, ( sep + 1 ) );
+			return -EINVAL;
+		}
+	} else {
+		len = strlen ( path );
+		nvme->nsid = 1;
+	}
+	if ( len >= sizeof ( ( ( struct nvme_connect_data * ) NULL )->subnqn ) ){
+		DBGC ( nvme, "NVMeTCP %p subsystem NQN too long\n", nvme );
+		return -EINVAL;
+	}
+	nvme->subnqn = strndup ( path, len );
+	if ( ! nvme->subnqn )
+		return -ENOMEM;
+
+	return 0;
+}
+
+/**
+ * Open NVMe/TCP URI
+ *
+ * @v parent		Parent interface
+ * @v uri		URI
+ * @ret rc		Return status code
+ */
+static int nvmetcp_open ( struct interface *parent, struct uri *uri ) {
+	struct nvmetcp_device *nvme;
+	int rc;
+
+	/* Allocate and initialise structure */
+	nvme = zalloc ( sizeof ( *nvme ) );
+	if ( ! nvme ) {
+		rc = -ENOMEM;
+		goto err_zalloc;
+	}
+	ref_init ( &nvme->refcnt, nvmetcp_free );
+	intf_init ( &nvme->block, &nvmetcp_block_desc, &nvme->refcnt );
+	nvmetcp_queue_init ( &nvme->admin, nvme, NVME_ADMIN_QID,
+			     NVMETCP_ADMIN_DEPTH );
+	nvmetcp_queue_init ( &nvme->io, nvme, NVME_IO_QID,
+			     NVMETCP_DEFAULT_DEPTH );
+	INIT_LIST_HEAD ( &nvme->commands );
+	timer_init ( &nvme->timer, nvmetcp_expired, &nvme->refcnt );
+	acpi_init ( &nvme->desc, &nbft_model, &nvme->refcnt );
+
+	/* Parse URI */
+	if ( ( rc = nvmetcp_parse_uri ( nvme, uri ) ) != 0 )
+		goto err_parse_uri;
+
+	/* Fetch settings */
+	if ( ( rc = nvmetcp_fetch_settings ( nvme ) ) != 0 )
+		goto err_fetch_settings;
+	DBGC ( nvme, "NVMeTCP %p host %s\n", nvme, nvme->hostnqn );
+	DBGC ( nvme, "NVMeTCP %p target %s:%d %s nsid %d\n",
+	       nvme, nvme->target_address, nvme->target_port, nvme->subnqn,
+	       nvme->nsid );
+
+	/* Open admin queue */
+	if ( ( rc = nvmetcp_open_queue ( &nvme->admin ) ) != 0 )
+		goto err_open_queue;
+
+	/* Attach to parent interface, mortalise self, and return */
+	intf_plug_plug ( &nvme->block, parent );
+	ref_put ( &nvme->refcnt );
+	return 0;
+
+ err_open_queue:
+ err_fetch_settings:
+ err_parse_uri:
+	nvmetcp_close ( nvme, rc );
+	ref_put ( &nvme->refcnt );
+ err_zalloc:
+	return rc;
+}
+
+/** NVMe/TCP URI opener */
+struct uri_opener nvmetcp_uri_opener __uri_opener = {
+	.scheme = "nvme-tcp",
+	.open = nvmetcp_open,
+};
@@ -45,10 +45,6 @@
  *
  */
 
-/** Set most significant bit to 1. */
-#define SET_LAST_FRAME( x ) ( (x) | 1 << 31 )
-#define GET_FRAME_SIZE( x ) ( (x) & ~( 1 << 31 ) )
-
 #define ONCRPC_CALL     0
 #define ONCRPC_REPLY    1
 
@@ -32,10 +32,14 @@ FILE_SECBOOT ( PERMITTED );
 
 #include <stdint.h>
 #include <stdlib.h>
+#include <stdio.h>
 #include <string.h>
 #include <errno.h>
 #include <byteswap.h>
 #include <ipxe/xfer.h>
+#include <ipxe/retry.h>
+#include <ipxe/timer.h>
+#include <ipxe/init.h>
 #include <ipxe/open.h>
 #include <ipxe/tcpip.h>
 #include <ipxe/dhcp.h>
@@ -54,9 +58,149 @@ FILE_SECBOOT ( PERMITTED );
 
 struct console_driver syslogs_console __console_driver;
 
+/** Encrypted syslog log buffer size
+ *
+ * This is a policy decision
+ */
+#define SYSLOGS_LOG_SIZE 4096
+
+/** Encrypted syslog log buffer fill level at which to flush immediately
+ *
+ * This is a policy decision
+ */
+#define SYSLOGS_FLUSH_THRESHOLD ( SYSLOGS_LOG_SIZE / 2 )
+
+/** Encrypted syslog maximum delay before flushing log buffer
+ *
+ * This is a policy decision
+ */
+#define SYSLOGS_FLUSH_DELAY ( TICKS_PER_SEC / 10 )
+
 /** The encrypted syslog server */
 static struct sockaddr_tcpip logserver;
 
+/** Encrypted syslog log buffer
+ *
+ * Messages are accumulated using octet-counting framing (RFC 6587)
+ * and written out in batches.  The final byte is used only as a
+ * potential terminating NUL.
+ */
+static char syslogs_log[ SYSLOGS_LOG_SIZE + 1 /* NUL */ ];
+
+/** Encrypted syslog log buffer fill level */
+static size_t syslogs_fill;
+
+/** Number of encrypted syslog messages dropped */
+static unsigned long syslogs_dropped;
+
+/** Encrypted syslog recursion marker */
+static int syslogs_entered;
+
+static struct interface syslogs;
+static struct retry_timer syslogs_timer;
+
+/**
+ * Add message to encrypted syslog log buffer
+ *
+ * @v severity		Severity
+ * @v message		Message
+ * @ret rc		Return status code
+ */
+static int syslogs_queue ( unsigned int severity, const char *message ) {
+	char *buf = ( syslogs_log + syslogs_fill );
+	size_t remaining = ( SYSLOGS_LOG_SIZE - syslogs_fill );
+	size_t prefix_len;
+	size_t msg_len;
+
+	/* Calculate framed message length */
+	msg_len = syslog_format ( NULL, 0, severity, message );
+	prefix_len = snprintf ( NULL, 0, "%zd ", msg_len );
+	if ( ( prefix_len + msg_len ) > remaining )
+		return -ENOBUFS;
+
+	/* Construct framed message */
+	sprintf ( buf, "%zd ", msg_len );
+	syslog_format ( ( buf + prefix_len ), ( msg_len + 1 /* NUL */ ),
+			severity, message );
+	syslogs_fill += ( prefix_len + msg_len );
+
+	return 0;
+}
+
+/**
+ * Flush encrypted syslog log buffer
+ *
+ * @v force		Ignore transmit window
+ *
+ * Unless @c force is specified, only as much data as will fit within
+ * the current transmit window is sent, so that console output is
+ * never stalled waiting for the log server.
+ */
+static void syslogs_flush ( int force ) {
+	size_t window;
+	size_t len;
+	int rc;
+
+	/* Do nothing unless connected and data is present */
+	if ( syslogs_entered || syslogs_console.disabled || ( ! syslogs_fill ) )
+		return;
+
+	/* Limit to transmit window, if applicable */
+	len = syslogs_fill;
+	if ( ! force ) {
+		window = xfer_window ( &syslogs );
+		if ( len > window )
+			len = window;
+		if ( ! len )
+			return;
+	}
+
+	/* Guard against re-entry */
+	syslogs_entered = 1;
+
+	/* Send data and remove from log buffer (unless the buffer was
+	 * discarded due to the connection closing in the meantime)
+	 */
+	if ( ( rc = xfer_deliver_raw ( &syslogs, syslogs_log, len ) ) != 0 ) {
+		DBG ( "SYSLOGS could not send log messages: %s\n",
+		      strerror ( rc ) );
+	} else if ( syslogs_fill ) {
+		syslogs_fill -= len;
+		memmove ( syslogs_log, ( syslogs_log + len ), syslogs_fill );
+	}
+
+	/* Clear re-entry flag */
+	syslogs_entered = 0;
+}
+
+/**
+ * Handle encrypted syslog flush timer expiry
+ *
+ * @v timer		Retry timer
+ * @v over		Failure indicator
+ */
+static void syslogs_expired ( struct retry_timer *timer, int over __unused ) {
+
+	/* Flush log buffer, retrying later if window is closed */
+	syslogs_flush ( 0 );
+	if ( syslogs_fill )
+		start_timer_fixed ( timer, SYSLOGS_FLUSH_DELAY );
+}
+
+/** Encrypted syslog flush timer */
+static struct retry_timer syslogs_timer = TIMER_INIT ( syslogs_expired );
+
+/**
+ * Discard encrypted syslog log buffer
+ *
+ */
+static void syslogs_discard ( void ) {
+
+	stop_timer ( &syslogs_timer );
+	syslogs_fill = 0;
+	syslogs_dropped = 0;
+}
+
 /**
  * Handle encrypted syslog TLS interface close
  *
@@ -66,6 +210,8 @@ static struct sockaddr_tcpip logserver;
 static void syslogs_close ( struct interface *intf, int rc ) {
 
 	DBG ( "SYSLOGS console disconnected: %s\n", strerror ( rc ) );
+	syslogs_console.disabled = CONSOLE_DISABLED;
+	syslogs_discard();
 	intf_restart ( intf, rc );
 }
 
@@ -85,6 +231,7 @@ static void syslogs_window_changed ( struct interface *intf ) {
 		if ( syslogs_console.disabled )
 			DBG ( "SYSLOGS console connected\n" );
 		syslogs_console.disabled = 0;
+		syslogs_flush ( 0 );
 	}
 }
 
@@ -147,16 +294,13 @@ static struct line_console syslogs_line = {
 	},
 };
 
-/** Encrypted syslog recursion marker */
-static int syslogs_entered;
-
 /**
  * Print a character to encrypted syslog console
  *
  * @v character		Character to be printed
  */
 static void syslogs_putchar ( int character ) {
-	int rc;
+	char notice[48];
 
 	/* Ignore if we are already mid-logging */
 	if ( syslogs_entered )
@@ -166,18 +310,27 @@ static void syslogs_putchar ( int character ) {
 	if ( line_putchar ( &syslogs_line, character ) == 0 )
 		return;
 
-	/* Guard against re-entry */
-	syslogs_entered = 1;
+	/* Report any previously dropped messages, if space permits */
+	if ( syslogs_dropped ) {
+		snprintf ( notice, sizeof ( notice ), "%ld log messages "
+			   "dropped", syslogs_dropped );
+		if ( syslogs_queue ( LOG_WARNING, notice ) == 0 )
+			syslogs_dropped = 0;
+	}
 
-	/* Send log message */
-	if ( ( rc = syslog_send ( &syslogs, syslogs_severity,
-				  syslogs_buffer, "\n" ) ) != 0 ) {
-		DBG ( "SYSLOGS could not send log message: %s\n",
-		      strerror ( rc ) );
+	/* Add log message to log buffer, dropping it if full */
+	if ( syslogs_dropped ||
+	     ( syslogs_queue ( syslogs_severity, syslogs_buffer ) != 0 ) ) {
+		syslogs_dropped++;
 	}
 
-	/* Clear re-entry flag */
-	syslogs_entered = 0;
+	/* Flush immediately if buffer is filling up, otherwise
+	 * schedule a flush to batch up subsequent messages.
+	 */
+	if ( syslogs_fill >= SYSLOGS_FLUSH_THRESHOLD )
+		syslogs_flush ( 0 );
+	if ( syslogs_fill && ! timer_running ( &syslogs_timer ) )
+		start_timer_fixed ( &syslogs_timer, SYSLOGS_FLUSH_DELAY );
 }
 
 /** Encrypted syslog console driver */
@@ -230,6 +383,7 @@ static int apply_syslogs_settings ( void ) {
 
 	/* Reset encrypted syslog connection */
 	syslogs_console.disabled = CONSOLE_DISABLED;
+	syslogs_discard();
 	intf_restart ( &syslogs, 0 );
 
 	/* Do nothing unless we have a log server */
@@ -292,3 +446,23 @@ static int apply_syslogs_settings ( void ) {
 struct settings_applicator syslogs_applicator __settings_applicator = {
 	.apply = apply_syslogs_settings,
 };
+
+/**
+ * Flush encrypted syslog log buffer on shutdown
+ *
+ * @v booting		System is shutting down for OS boot
+ */
+static void syslogs_shutdown ( int booting __unused ) {
+
+	/* Hand all remaining data to TCP, which will transmit it as
+	 * part of closing the connection gracefully.
+	 */
+	stop_timer ( &syslogs_timer );
+	syslogs_flush ( 1 );
+}
+
+/** Encrypted syslog shutdown function */
+struct startup_fn syslogs_startup_fn __startup_fn ( STARTUP_FINAL ) = {
+	.name = "syslogs",
+	.shutdown = syslogs_shutdown,
+};
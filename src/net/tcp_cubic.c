@@ -0,0 +1,192 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+FILE_SECBOOT ( PERMITTED );
+
+/** @file
+ *
+ * CUBIC TCP congestion control
+ *
+ * This is an implementation of the CUBIC congestion control
+ * algorithm as described in RFC 9438.  All calculations are
+ * performed using integer arithmetic, with windows measured in bytes
+ * and times measured in timer ticks.
+ *
+ */
+
+#include <stdint.h>
+#include <ipxe/timer.h>
+#include <ipxe/tcp.h>
+
+/** Multiplicative decrease factor (scaled by 1024)
+ *
+ * RFC 9438 specifies a value of 0.7.
+ */
+#define CUBIC_BETA 717
+
+/** Cubic scaling constant (scaled by 1024)
+ *
+ * RFC 9438 specifies a value of 0.4.
+ */
+#define CUBIC_C 410
+
+/** Additive increase factor for Reno-friendly region (scaled by 1024)
+ *
+ * This is 3 * ( 1 - beta ) / ( 1 + beta ), as per RFC 9438.
+ */
+#define CUBIC_ALPHA 542
+
+/** Maximum time offset used in cubic function (in ticks)
+ *
+ * This limits the size of intermediate values and avoids overflow.
+ */
+#define CUBIC_MAX_OFFSET ( 16 * TICKS_PER_SEC )
+
+/**
+ * Calculate integer cube root
+ *
+ * @v x			Value
+ * @ret root		Cube root (rounded down)
+ */
+static uint32_t cubic_cbrt ( uint64_t x ) {
+	uint64_t root = 0;
+	uint64_t bit;
+	int shift;
+
+	/* Calculate one bit of the root at a time */
+	for ( shift = 63 ; shift >= 0 ; shift -= 3 ) {
+		root <<= 1;
+		bit = ( ( 3 * root * ( root + 1 ) ) + 1 );
+		if ( ( x >> shift ) >= bit ) {
+			x -= ( bit << shift );
+			root++;
+		}
+	}
+	return root;
+}
+
+/**
+ * Increase congestion window during congestion avoidance
+ *
+ * @v cc		Congestion control state
+ * @v len		Length of newly acknowledged data
+ * @v rtt		Smoothed round-trip time (in ticks), or zero
+ */
+static void cubic_avoid ( struct tcp_congestion *cc, uint32_t len,
+			  unsigned long rtt ) {
+	unsigned long now = currticks();
+	unsigned long elapsed;
+	unsigned long offset;
+	uint64_t delta;
+	uint32_t target;
+	uint32_t max;
+
+	/* Start a new epoch, if applicable */
+	if ( ! cc->epoch ) {
+		cc->epoch = ( now ? now : 1 );
+		cc->west = cc->cwnd;
+		if ( cc->cwnd < cc->wmax ) {
+			cc->period = cubic_cbrt ( ( ( uint64_t )
+						    ( cc->wmax - cc->cwnd ) *
+						    1024ULL * TICKS_PER_SEC *
+						    TICKS_PER_SEC *
+						    TICKS_PER_SEC ) /
+						  ( CUBIC_C *
+						    TCP_CONGESTION_MSS ) );
+		} else {
+			cc->period = 0;
+			cc->wmax = cc->cwnd;
+		}
+	}
+
+	/* Calculate target window one round-trip time from now */
+	elapsed = ( now - cc->epoch + rtt );
+	offset = ( ( elapsed > cc->period ) ?
+		   ( elapsed - cc->period ) : ( cc->period - elapsed ) );
+	if ( offset > CUBIC_MAX_OFFSET )
+		offset = CUBIC_MAX_OFFSET;
+	delta = ( ( ( uint64_t ) offset * offset * offset *
+		    CUBIC_C * TCP_CONGESTION_MSS ) /
+		  ( 1024ULL * TICKS_PER_SEC * TICKS_PER_SEC * TICKS_PER_SEC ) );
+	if ( elapsed > cc->period ) {
+		target = ( ( delta < ( ~( ( uint32_t ) 0 ) - cc->wmax ) ) ?
+			   ( cc->wmax + delta ) : ~( ( uint32_t ) 0 ) );
+	} else {
+		target = ( ( delta < cc->wmax ) ? ( cc->wmax - delta ) : 0 );
+	}
+
+	/* Do not grow more slowly than a standard TCP flow would */
+	cc->west += ( ( ( uint64_t ) len * CUBIC_ALPHA * TCP_CONGESTION_MSS ) /
+		      ( 1024ULL * cc->cwnd ) );
+	if ( target < cc->west )
+		target = cc->west;
+
+	/* Do not grow by more than 50% per round-trip time */
+	max = ( cc->cwnd + ( cc->cwnd / 2 ) );
+	if ( target > max )
+		target = max;
+
+	/* Move towards target window */
+	if ( target > cc->cwnd ) {
+		cc->cwnd += ( ( ( uint64_t ) ( target - cc->cwnd ) * len ) /
+			      cc->cwnd );
+	}
+}
+
+/**
+ * Respond to packet loss
+ *
+ * @v cc		Congestion control state
+ * @v flight		Length of unacknowledged data
+ * @v timeout		Loss was detected by retransmission timeout
+ */
+static void cubic_loss ( struct tcp_congestion *cc, uint32_t flight __unused,
+			 int timeout ) {
+
+	/* Record window prior to reduction, applying fast convergence */
+	if ( cc->cwnd < cc->wmax ) {
+		cc->wmax = ( ( ( uint64_t ) cc->cwnd *
+			       ( 1024 + CUBIC_BETA ) ) / 2048 );
+	} else {
+		cc->wmax = cc->cwnd;
+	}
+
+	/* Reduce window */
+	cc->ssthresh = ( ( ( uint64_t ) cc->cwnd * CUBIC_BETA ) / 1024 );
+	if ( cc->ssthresh < ( 2 * TCP_CONGESTION_MSS ) )
+		cc->ssthresh = ( 2 * TCP_CONGESTION_MSS );
+	cc->cwnd = ( timeout ? TCP_CONGESTION_MSS : cc->ssthresh );
+
+	/* Start a new epoch on the next congestion avoidance increase */
+	cc->epoch = 0;
+}
+
+/** CUBIC congestion control algorithm */
+struct tcp_congestion_algorithm tcp_cubic __tcp_congestion_algorithm = {
+	.name = "cubic",
+	.slow_start = tcp_slow_start,
+	.avoid = cubic_avoid,
+	.loss = cubic_loss,
+	.pace = tcp_pace,
+};
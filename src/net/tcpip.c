@@ -60,6 +60,33 @@ int tcpip_rx ( struct io_buffer *iobuf, struct net_device *netdev,
 	return -EPROTONOSUPPORT;
 }
 
+/**
+ * Merge a received TCP/IP packet
+ *
+ * @v iobuf		I/O buffer
+ * @v next		Subsequent I/O buffer
+ * @v tcpip_proto	Transport-layer protocol number
+ * @ret rc		Return status code, or required tailroom
+ *
+ * Both I/O buffers must contain transport-layer segments with
+ * verified checksums.
+ */
+int tcpip_merge ( struct io_buffer *iobuf, struct io_buffer *next,
+		  uint8_t tcpip_proto ) {
+	struct tcpip_protocol *tcpip;
+
+	/* Hand off to the appropriate transport-layer protocol */
+	for_each_table_entry ( tcpip, TCPIP_PROTOCOLS ) {
+		if ( tcpip->tcpip_proto == tcpip_proto ) {
+			if ( ! tcpip->merge )
+				return -ENOTSUP;
+			return tcpip->merge ( iobuf, next );
+		}
+	}
+
+	return -EPROTONOSUPPORT;
+}
+
 /**
  * Find TCP/IP network-layer protocol
  *
@@ -106,6 +133,86 @@ int tcpip_tx ( struct io_buffer *iobuf, struct tcpip_protocol *tcpip_protocol,
 	return -EAFNOSUPPORT;
 }
 
+/**
+ * Defer calculation of transport-layer checksum
+ *
+ * @v iobuf		I/O buffer (starting at transport-layer header)
+ * @v hdr_len		Length of transport-layer header
+ * @v csum		Transport-layer checksum field
+ *
+ * The checksum will be calculated by tcpip_tx_chksum() once the
+ * transmitting network device is known, and may be offloaded to the
+ * hardware if the network device is capable.
+ */
+void tcpip_defer_chksum ( struct io_buffer *iobuf, size_t hdr_len,
+			  uint16_t *csum ) {
+
+	*csum = 0;
+	iobuf->trans_hdr = iobuf->data;
+	iobuf->trans_hdr_len = hdr_len;
+	iobuf->csum_offset = ( ( ( void * ) csum ) - iobuf->data );
+	iobuf->flags |= IOB_TX_CSUM;
+}
+
+/**
+ * Prepare transport-layer checksum for transmission
+ *
+ * @v iobuf		I/O buffer
+ * @v netdev		Transmitting network device
+ * @v net_hdr		Network-layer header
+ * @v trans_csum	Transport-layer checksum to complete
+ * @ret rc		Return status code
+ *
+ * If the transport-layer checksum has been deferred, then either
+ * leave it for the network device to complete (if the network device
+ * is capable) or calculate it now.  In either case, the network-layer
+ * protocol must add in the pseudo-header checksum.  If the checksum
+ * is left for the network device to complete, then @c IOB_TX_CSUM
+ * will remain set.
+ */
+int tcpip_tx_chksum ( struct io_buffer *iobuf, struct net_device *netdev,
+		      void *net_hdr, uint16_t *trans_csum ) {
+	struct io_buffer *frag;
+	unsigned int tso;
+	uint16_t csum;
+	size_t len;
+
+	/* Do nothing unless checksum calculation was deferred */
+	if ( ! ( iobuf->flags & IOB_TX_CSUM ) )
+		return 0;
+	iobuf->net_hdr = net_hdr;
+
+	/* Leave segmentation to the network device, if applicable */
+	if ( iobuf->flags & IOB_TX_TSO ) {
+		tso = ( ( iobuf->flags & IOB_TX_IPV6 ) ?
+			NETDEV_TX_OFFLOAD_TSO6 : NETDEV_TX_OFFLOAD_TSO4 );
+		if ( ! ( netdev->tx_offloads & tso ) ) {
+			DBGC ( netdev, "TCP/IP %s cannot segment packet\n",
+			       netdev->name );
+			return -ENOTSUP;
+		}
+		*trans_csum = TCPIP_EMPTY_CSUM;
+		return 0;
+	}
+
+	/* Leave checksum to the network device, if applicable */
+	if ( netdev->tx_offloads & NETDEV_TX_OFFLOAD_CSUM ) {
+		*trans_csum = TCPIP_EMPTY_CSUM;
+		return 0;
+	}
+
+	/* Otherwise, calculate checksum now (including any fragments) */
+	len = ( iobuf->tail - iobuf->trans_hdr );
+	csum = tcpip_chksum ( iobuf->trans_hdr, len );
+	for ( frag = iobuf->frag ; frag ; frag = frag->frag ) {
+		csum = tcpip_continue_chksum ( csum, frag->data,
+					       iob_len ( frag ) );
+	}
+	*trans_csum = csum;
+	iobuf->flags &= ~IOB_TX_CSUM;
+	return 0;
+}
+
 /**
  * Determine transmitting network device
  *
@@ -0,0 +1,299 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+FILE_SECBOOT ( PERMITTED );
+
+#include <string.h>
+#include <ipxe/iobuf.h>
+#include <ipxe/tcp.h>
+#include <ipxe/tcpreasm.h>
+
+/** @file
+ *
+ * TCP reassembly queue
+ *
+ */
+
+/**
+ * Get queued header
+ *
+ * @v iobuf		I/O buffer
+ * @ret tcpqhdr		Queued header
+ */
+static inline struct tcp_rx_queued_header *
+tcp_reasm_header ( struct io_buffer *iobuf ) {
+
+	return iobuf->data;
+}
+
+/**
+ * Remove range
+ *
+ * @v reasm		Reassembly queue
+ * @v index		Range index
+ *
+ * The packets within the range are not affected.
+ */
+static void tcp_reasm_remove ( struct tcp_reasm *reasm,
+			       unsigned int index ) {
+
+	reasm->count--;
+	memmove ( &reasm->range[index], &reasm->range[ index + 1 ],
+		  ( ( reasm->count - index ) *
+		    sizeof ( reasm->range[0] ) ) );
+}
+
+/**
+ * Add packet to reassembly queue
+ *
+ * @v reasm		Reassembly queue
+ * @v base		First SEQ value not yet received (in host-endian order)
+ * @v seq		SEQ value (in host-endian order)
+ * @v flags		TCP flags (only FIN is relevant)
+ * @v iobuf		I/O buffer
+ *
+ * Any data within the packet that has already been received, or that
+ * is already present within the queue, will be trimmed.  The packet
+ * may be discarded entirely if it contains no new data.
+ */
+void tcp_reasm_add ( struct tcp_reasm *reasm, uint32_t base, uint32_t seq,
+		     unsigned int flags, struct io_buffer *iobuf ) {
+	struct tcp_rx_queued_header *tcpqhdr;
+	struct tcp_reasm_range *prev = NULL;
+	struct tcp_reasm_range *next = NULL;
+	struct tcp_reasm_range *range;
+	struct io_buffer *victim;
+	struct io_buffer *tmp;
+	unsigned int index;
+	size_t len;
+	uint32_t nxt;
+
+	/* Calculate sequence length */
+	flags &= TCP_FIN;
+	len = iob_len ( iobuf );
+	nxt = ( seq + len + ( flags ? 1 : 0 ) );
+
+	/* Discard if there is no new data */
+	if ( tcp_cmp ( nxt, base ) <= 0 )
+		goto discard;
+
+	/* Trim any data that has already been received */
+	if ( tcp_cmp ( seq, base ) < 0 ) {
+		iob_pull ( iobuf, ( base - seq ) );
+		len -= ( base - seq );
+		seq = base;
+	}
+
+	/* Find first range that does not end before this packet */
+	for ( index = 0 ; index < reasm->count ; index++ ) {
+		range = &reasm->range[index];
+		if ( tcp_cmp ( range->end, seq ) >= 0 )
+			break;
+	}
+
+	/* Trim any data already present in the preceding range */
+	if ( ( index < reasm->count ) &&
+	     ( tcp_cmp ( reasm->range[index].start, seq ) <= 0 ) ) {
+		prev = &reasm->range[index++];
+		if ( tcp_cmp ( nxt, prev->end ) <= 0 )
+			goto discard;
+		iob_pull ( iobuf, ( prev->end - seq ) );
+		len -= ( prev->end - seq );
+		seq = prev->end;
+	}
+
+	/* Trim any data already present in the following range */
+	if ( index < reasm->count ) {
+		next = &reasm->range[index];
+		if ( tcp_cmp ( nxt, next->start ) > 0 ) {
+			iob_unput ( iobuf, ( len - ( next->start - seq ) ) );
+			len = ( next->start - seq );
+			flags = 0;
+			nxt = next->start;
+		}
+	}
+
+	/* Add internal header */
+	tcpqhdr = iob_push ( iobuf, sizeof ( *tcpqhdr ) );
+	tcpqhdr->seq = seq;
+	tcpqhdr->nxt = nxt;
+	tcpqhdr->flags = flags;
+
+	/* Append to preceding range, if applicable */
+	if ( prev ) {
+		list_add ( &iobuf->list, &prev->last->list );
+		prev->last = iobuf;
+		prev->end = nxt;
+		if ( next && ( nxt == next->start ) ) {
+			prev->last = next->last;
+			prev->end = next->end;
+			tcp_reasm_remove ( reasm, index );
+		}
+		return;
+	}
+
+	/* Prepend to following range, if applicable */
+	if ( next && ( nxt == next->start ) ) {
+		list_add_tail ( &iobuf->list, &next->first->list );
+		next->first = iobuf;
+		next->start = seq;
+		return;
+	}
+
+	/* Create a new range, discarding the highest range if necessary */
+	if ( reasm->count == TCP_REASM_RANGES ) {
+		if ( index == reasm->count )
+			goto discard;
+		range = &reasm->range[ reasm->count - 1 ];
+		for ( victim = range->first ; victim ; victim = tmp ) {
+			tmp = ( ( victim == range->last ) ? NULL :
+				list_next_entry ( victim, &reasm->list, list ));
+			list_del ( &victim->list );
+			free_iob ( victim );
+		}
+		reasm->count--;
+	}
+	memmove ( &reasm->range[ index + 1 ], &reasm->range[index],
+		  ( ( reasm->count - index ) * sizeof ( reasm->range[0] ) ) );
+	reasm->count++;
+	range = &reasm->range[index];
+	range->start = seq;
+	range->end = nxt;
+	range->first = iobuf;
+	range->last = iobuf;
+	if ( ( index + 1 ) < reasm->count ) {
+		list_add_tail ( &iobuf->list,
+				&reasm->range[ index + 1 ].first->list );
+	} else {
+		list_add_tail ( &iobuf->list, &reasm->list );
+	}
+	return;
+
+ discard:
+	free_iob ( iobuf );
+}
+
+/**
+ * Remove next in-order packet from reassembly queue
+ *
+ * @v reasm		Reassembly queue
+ * @v base		First SEQ value not yet received (in host-endian order)
+ * @ret iobuf		I/O buffer (with internal header), or NULL
+ */
+struct io_buffer * tcp_reasm_dequeue ( struct tcp_reasm *reasm,
+				       uint32_t base ) {
+	struct tcp_reasm_range *range = &reasm->range[0];
+	struct io_buffer *iobuf;
+
+	/* Do nothing unless the first range is contiguous with the
+	 * received data.
+	 */
+	if ( ( ! reasm->count ) || ( tcp_cmp ( range->start, base ) > 0 ) )
+		return NULL;
+
+	/* Remove first packet from first range */
+	iobuf = range->first;
+	if ( iobuf == range->last ) {
+		tcp_reasm_remove ( reasm, 0 );
+	} else {
+		range->first = list_next_entry ( iobuf, &reasm->list, list );
+		range->start = tcp_reasm_header ( range->first )->seq;
+	}
+	list_del ( &iobuf->list );
+
+	return iobuf;
+}
+
+/**
+ * Discard highest packet from reassembly queue
+ *
+ * @v reasm		Reassembly queue
+ * @ret discarded	A packet was discarded
+ */
+int tcp_reasm_discard ( struct tcp_reasm *reasm ) {
+	struct tcp_reasm_range *range;
+	struct io_buffer *iobuf;
+
+	/* Do nothing if queue is empty */
+	if ( ! reasm->count )
+		return 0;
+
+	/* Remove last packet from last range */
+	range = &reasm->range[ reasm->count - 1 ];
+	iobuf = range->last;
+	if ( iobuf == range->first ) {
+		reasm->count--;
+	} else {
+		range->last = list_prev_entry ( iobuf, &reasm->list, list );
+		range->end = tcp_reasm_header ( range->last )->nxt;
+	}
+	list_del ( &iobuf->list );
+	free_iob ( iobuf );
+
+	return 1;
+}
+
+/**
+ * Discard all packets from reassembly queue
+ *
+ * @v reasm		Reassembly queue
+ */
+void tcp_reasm_flush ( struct tcp_reasm *reasm ) {
+	struct io_buffer *iobuf;
+	struct io_buffer *tmp;
+
+	list_for_each_entry_safe ( iobuf, tmp, &reasm->list, list ) {
+		list_del ( &iobuf->list );
+		free_iob ( iobuf );
+	}
+	reasm->count = 0;
+}
+
+/**
+ * Find selective acknowledgement block
+ *
+ * @v reasm		Reassembly queue
+ * @v seq		SEQ value in SACK block (in host-endian order)
+ * @v sack		SACK block to fill in (in host-endian order)
+ * @ret len		Length of SACK block, or zero if not found
+ */
+uint32_t tcp_reasm_sack ( struct tcp_reasm *reasm, uint32_t seq,
+			  struct tcp_sack_block *sack ) {
+	struct tcp_reasm_range *range;
+	unsigned int index;
+
+	/* Find range containing SEQ */
+	for ( index = 0 ; index < reasm->count ; index++ ) {
+		range = &reasm->range[index];
+		if ( tcp_cmp ( range->start, seq ) > 0 )
+			break;
+		if ( tcp_cmp ( range->end, seq ) >= 0 ) {
+			sack->left = range->start;
+			sack->right = range->end;
+			return ( range->end - range->start );
+		}
+	}
+
+	return 0;
+}
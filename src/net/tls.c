@@ -34,6 +34,7 @@ FILE_SECBOOT ( PERMITTED );
 #include <byteswap.h>
 #include <ipxe/pending.h>
 #include <ipxe/hmac.h>
+#include <ipxe/hkdf.h>
 #include <ipxe/md5.h>
 #include <ipxe/sha1.h>
 #include <ipxe/sha256.h>
@@ -48,10 +49,13 @@ FILE_SECBOOT ( PERMITTED );
 #include <ipxe/rootcert.h>
 #include <ipxe/rbg.h>
 #include <ipxe/validator.h>
+#include <ipxe/ocsp.h>
 #include <ipxe/job.h>
+#include <ipxe/timer.h>
 #include <ipxe/dhe.h>
 #include <ipxe/ecdhe.h>
 #include <ipxe/tls.h>
+#include <ipxe/trace.h>
 #include <config/crypto.h>
 
 /* Disambiguate the various error causes */
@@ -87,6 +91,10 @@ FILE_SECBOOT ( PERMITTED );
 #define EINFO_EINVAL_HANDSHAKE						\
 	__einfo_uniqify ( EINFO_EINVAL, 0x08,				\
 			  "Invalid Handshake record" )
+#define EINVAL_KEY_SHARE __einfo_error ( EINFO_EINVAL_KEY_SHARE )
+#define EINFO_EINVAL_KEY_SHARE						\
+	__einfo_uniqify ( EINFO_EINVAL, 0x09,				\
+			  "Invalid key share" )
 #define EINVAL_IV __einfo_error ( EINFO_EINVAL_IV )
 #define EINFO_EINVAL_IV							\
 	__einfo_uniqify ( EINFO_EINVAL, 0x0a,				\
@@ -111,6 +119,28 @@ FILE_SECBOOT ( PERMITTED );
 #define EINFO_EINVAL_KEY_EXCHANGE					\
 	__einfo_uniqify ( EINFO_EINVAL, 0x0f,				\
 			  "Invalid Server Key Exchange record" )
+#define EINVAL_EXTENSIONS __einfo_error ( EINFO_EINVAL_EXTENSIONS )
+#define EINFO_EINVAL_EXTENSIONS						\
+	__einfo_uniqify ( EINFO_EINVAL, 0x10,				\
+			  "Invalid Encrypted Extensions record" )
+#define EINVAL_CERTIFICATE_VERIFY \
+	__einfo_error ( EINFO_EINVAL_CERTIFICATE_VERIFY )
+#define EINFO_EINVAL_CERTIFICATE_VERIFY					\
+	__einfo_uniqify ( EINFO_EINVAL, 0x11,				\
+			  "Invalid Certificate Verify record" )
+#define EINVAL_KEY_UPDATE __einfo_error ( EINFO_EINVAL_KEY_UPDATE )
+#define EINFO_EINVAL_KEY_UPDATE						\
+	__einfo_uniqify ( EINFO_EINVAL, 0x12,				\
+			  "Invalid Key Update record" )
+#define EINVAL_CONTENT_TYPE __einfo_error ( EINFO_EINVAL_CONTENT_TYPE )
+#define EINFO_EINVAL_CONTENT_TYPE					\
+	__einfo_uniqify ( EINFO_EINVAL, 0x13,				\
+			  "Missing inner content type" )
+#define EINVAL_CERTIFICATE_STATUS \
+	__einfo_error ( EINFO_EINVAL_CERTIFICATE_STATUS )
+#define EINFO_EINVAL_CERTIFICATE_STATUS					\
+	__einfo_uniqify ( EINFO_EINVAL, 0x14,				\
+			  "Invalid Certificate Status record" )
 #define EIO_ALERT __einfo_error ( EINFO_EIO_ALERT )
 #define EINFO_EIO_ALERT							\
 	__einfo_uniqify ( EINFO_EIO, 0x01,				\
@@ -143,6 +173,18 @@ FILE_SECBOOT ( PERMITTED );
 #define EINFO_ENOMEM_RX_CONCAT						\
 	__einfo_uniqify ( EINFO_ENOMEM, 0x08,				\
 			  "Not enough space to concatenate received data" )
+#define ENOMEM_KEY_SHARE __einfo_error ( EINFO_ENOMEM_KEY_SHARE )
+#define EINFO_ENOMEM_KEY_SHARE						\
+	__einfo_uniqify ( EINFO_ENOMEM, 0x09,				\
+			  "Not enough space for key share" )
+#define ENOMEM_COOKIE __einfo_error ( EINFO_ENOMEM_COOKIE )
+#define EINFO_ENOMEM_COOKIE						\
+	__einfo_uniqify ( EINFO_ENOMEM, 0x0a,				\
+			  "Not enough space for cookie" )
+#define ENOMEM_TX_COALESCE __einfo_error ( EINFO_ENOMEM_TX_COALESCE )
+#define EINFO_ENOMEM_TX_COALESCE					\
+	__einfo_uniqify ( EINFO_ENOMEM, 0x0b,				\
+			  "Not enough space for coalesced data" )
 #define ENOTSUP_CIPHER __einfo_error ( EINFO_ENOTSUP_CIPHER )
 #define EINFO_ENOTSUP_CIPHER						\
 	__einfo_uniqify ( EINFO_ENOTSUP, 0x01,				\
@@ -187,10 +229,27 @@ FILE_SECBOOT ( PERMITTED );
 #define EINFO_EPERM_EMS							\
 	__einfo_uniqify ( EINFO_EPERM, 0x07,				\
 			  "Extended master secret extension mismatch" )
+#define EPERM_ALPN __einfo_error ( EINFO_EPERM_ALPN )
+#define EINFO_EPERM_ALPN						\
+	__einfo_uniqify ( EINFO_EPERM, 0x08,				\
+			  "Unoffered application protocol selected" )
+#define EPERM_DOWNGRADE __einfo_error ( EINFO_EPERM_DOWNGRADE )
+#define EINFO_EPERM_DOWNGRADE						\
+	__einfo_uniqify ( EINFO_EPERM, 0x09,				\
+			  "Protocol version downgrade detected" )
+#define EPERM_CERTIFICATE_VERIFY \
+	__einfo_error ( EINFO_EPERM_CERTIFICATE_VERIFY )
+#define EINFO_EPERM_CERTIFICATE_VERIFY					\
+	__einfo_uniqify ( EINFO_EPERM, 0x0a,				\
+			  "Certificate Verify verification failed" )
 #define EPROTO_VERSION __einfo_error ( EINFO_EPROTO_VERSION )
 #define EINFO_EPROTO_VERSION						\
 	__einfo_uniqify ( EINFO_EPROTO, 0x01,				\
 			  "Illegal protocol version upgrade" )
+#define EPROTO_HELLO_RETRY __einfo_error ( EINFO_EPROTO_HELLO_RETRY )
+#define EINFO_EPROTO_HELLO_RETRY					\
+	__einfo_uniqify ( EINFO_EPROTO, 0x02,				\
+			  "Illegal HelloRetryRequest" )
 
 /** List of TLS session */
 static LIST_HEAD ( tls_sessions );
@@ -263,6 +322,19 @@ static int tls_ready ( struct tls_connection *tls ) {
 		 ( ! is_pending ( &tls->server.negotiation ) ) );
 }
 
+/**
+ * Determine if TLS connection is ready to transmit application data
+ *
+ * @v tls		TLS connection
+ * @ret is_ready	TLS connection is ready to transmit
+ *
+ * Application data may be transmitted before the server Finished
+ * has been received, if False Start is permitted.
+ */
+static int tls_tx_ready ( struct tls_connection *tls ) {
+	return ( tls_ready ( tls ) || tls->false_start );
+}
+
 /**
  * Check for TLS version
  *
@@ -280,6 +352,9 @@ tls_version ( struct tls_connection *tls, unsigned int version ) {
 		 ( tls->version >= version ) );
 }
 
+/** Number of supported protocol versions */
+#define TLS_NUM_VERSIONS ( TLS_VERSION_MAX - TLS_VERSION_MIN + 1 )
+
 /******************************************************************************
  *
  * Hybrid MD5+SHA1 hash as used by TLSv1.1 and earlier
@@ -376,6 +451,45 @@ static void free_tls_session ( struct refcnt *refcnt ) {
 	free ( session );
 }
 
+/**
+ * Handle TLS session expiry
+ *
+ * @v timer		Expiry timer
+ * @v over		Failure indicator
+ */
+static void tls_session_expired ( struct retry_timer *timer,
+				  int over __unused ) {
+	struct tls_session *session =
+		container_of ( timer, struct tls_session, timer );
+
+	/* Reference held by the timer will be dropped automatically */
+	DBGC ( session, "TLS session %s expired\n", session->name );
+}
+
+/**
+ * Retain TLS session after last connection has closed
+ *
+ * @v session		TLS session
+ *
+ * The session will be kept alive (via the reference held by the
+ * running expiry timer) so that subsequent connections to the same
+ * server may resume the session.
+ */
+static void tls_session_retain ( struct tls_session *session ) {
+
+	/* Do nothing unless this was the last connection */
+	if ( ! list_empty ( &session->conn ) )
+		return;
+
+	/* Do nothing unless there is anything worth retaining */
+	if ( ! ( session->id_len || session->ticket_len ) )
+		return;
+
+	/* Start expiry timer */
+	start_timer_fixed ( &session->timer,
+			    ( TLS_SESSION_TIMEOUT * TICKS_PER_SEC ) );
+}
+
 /**
  * Free TLS connection
  *
@@ -389,6 +503,7 @@ static void free_tls ( struct refcnt *refcnt ) {
 	struct io_buffer *tmp;
 
 	/* Free dynamically-allocated resources */
+	free ( tls->session_ticket );
 	free ( tls->new_session_ticket );
 	tls_clear_cipher ( tls, &tls->tx.cipherspec.active );
 	tls_clear_cipher ( tls, &tls->tx.cipherspec.pending );
@@ -396,6 +511,7 @@ static void free_tls ( struct refcnt *refcnt ) {
 	tls_clear_cipher ( tls, &tls->rx.cipherspec.pending );
 	free ( tls->server.exchange );
 	free ( tls->handshake_ctx );
+	free_iob ( tls->tx.coalesce );
 	list_for_each_entry_safe ( iobuf, tmp, &tls->rx.data, list ) {
 		list_del ( &iobuf->list );
 		free_iob ( iobuf );
@@ -403,8 +519,11 @@ static void free_tls ( struct refcnt *refcnt ) {
 	free_iob ( tls->rx.handshake );
 	privkey_put ( tls->client.key );
 	x509_chain_put ( tls->client.chain );
+	free ( tls->client.private );
+	free ( tls->client.cookie );
 	x509_chain_put ( tls->server.chain );
 	x509_root_put ( tls->server.root );
+	free ( tls->server.ocsp );
 
 	/* Drop reference to session */
 	assert ( list_empty ( &tls->list ) );
@@ -442,6 +561,9 @@ static void tls_close ( struct tls_connection *tls, int rc ) {
 	list_del ( &tls->list );
 	INIT_LIST_HEAD ( &tls->list );
 
+	/* Retain session state for future connections, if applicable */
+	tls_session_retain ( tls->session );
+
 	/* Resume all other connections, in case we were the lead connection */
 	tls_tx_resume_all ( tls->session );
 }
@@ -844,6 +966,33 @@ static void tls_verify_handshake ( struct tls_connection *tls, void *out ) {
 	digest_final ( digest, ctx, out );
 }
 
+/**
+ * Calculate handshake verification hash including current record
+ *
+ * @v tls		TLS connection
+ * @v type		Handshake record type
+ * @v data		Plaintext handshake record
+ * @v len		Length of plaintext handshake record
+ * @v out		Output buffer
+ *
+ * Calculates the digest over all handshake messages seen so far,
+ * followed by the handshake record currently being processed (which
+ * is not added to the handshake digest until processing completes).
+ */
+static void tls_verify_handshake_record ( struct tls_connection *tls,
+					  unsigned int type, const void *data,
+					  size_t len, void *out ) {
+	struct digest_algorithm *digest = tls->handshake_digest;
+	uint8_t ctx[ digest->ctxsize ];
+	uint32_t type_length;
+
+	type_length = ( cpu_to_le32 ( type ) | htonl ( len ) );
+	memcpy ( ctx, tls->handshake_ctx, sizeof ( ctx ) );
+	digest_update ( digest, ctx, &type_length, sizeof ( type_length ) );
+	digest_update ( digest, ctx, data, len );
+	digest_final ( digest, ctx, out );
+}
+
 /******************************************************************************
  *
  * Cipher suite management
@@ -955,6 +1104,15 @@ static int tls_select_cipher ( struct tls_connection *tls,
 		return -ENOTSUP_CIPHER;
 	}
 
+	/* Check that cipher suite matches protocol version */
+	if ( ( suite->exchange == &tls_key_share_exchange_algorithm ) !=
+	     ( !! tls_version ( tls, TLS_VERSION_TLS_1_3 ) ) ) {
+		DBGC ( tls, "TLS %p cannot use cipher %04x with protocol "
+		       "version %d.%d\n", tls, ntohs ( cipher_suite ),
+		       ( tls->version >> 8 ), ( tls->version & 0xff ) );
+		return -ENOTSUP_CIPHER;
+	}
+
 	/* Set handshake digest algorithm */
 	digest = ( tls_version ( tls, TLS_VERSION_TLS_1_2 ) ?
 		   suite->handshake : &md5_sha1_algorithm );
@@ -1010,61 +1168,80 @@ static int tls_change_cipher ( struct tls_connection *tls,
 	table_num_entries ( TLS_SIG_HASH_ALGORITHMS )
 
 /**
- * Find TLS signature and hash algorithm
+ * Check if TLS signature and hash algorithm is permitted
  *
- * @v pubkey		Public-key algorithm
- * @v digest		Digest algorithm
- * @ret sig_hash	Signature and hash algorithm, or NULL
+ * @v tls		TLS connection
+ * @v sig_hash		Signature and hash algorithm
+ * @ret is_permitted	Signature and hash algorithm is permitted
+ *
+ * TLSv1.3 prohibits the use of PKCS#1 v1.5 signatures and of hash
+ * algorithms weaker than SHA-256 for handshake signatures.
  */
-static struct tls_signature_hash_algorithm *
-tls_signature_hash_algorithm ( struct pubkey_algorithm *pubkey,
-			       struct digest_algorithm *digest ) {
-	struct tls_signature_hash_algorithm *sig_hash;
+static int
+tls_signature_hash_permitted ( struct tls_connection *tls,
+			       struct tls_signature_hash_algorithm *sig_hash ) {
 
-	/* Identify signature and hash algorithm */
-	for_each_table_entry ( sig_hash, TLS_SIG_HASH_ALGORITHMS ) {
-		if ( ( sig_hash->pubkey == pubkey ) &&
-		     ( sig_hash->digest == digest ) ) {
-			return sig_hash;
-		}
+	if ( tls_version ( tls, TLS_VERSION_TLS_1_3 ) &&
+	     ( ( sig_hash->code.signature == TLS_RSA_ALGORITHM ) ||
+	       ( sig_hash->code.hash < TLS_SHA256_ALGORITHM ) ) ) {
+		return 0;
 	}
 
-	return NULL;
+	return 1;
 }
 
 /**
- * Find TLS signature algorithm
+ * Find TLS signature and hash algorithm
  *
- * @v code		Signature and hash algorithm identifier
- * @ret pubkey		Public key algorithm, or NULL
+ * @v tls		TLS connection
+ * @v pubkey		Certificate public-key algorithm
+ * @v digest		Digest algorithm
+ * @ret sig_hash	Signature and hash algorithm, or NULL
+ *
+ * TLSv1.3 may select a signature algorithm (e.g. RSA-PSS) that
+ * differs from the certificate public-key algorithm.
  */
-static struct pubkey_algorithm *
-tls_signature_hash_pubkey ( struct tls_signature_hash_id code ) {
+static struct tls_signature_hash_algorithm *
+tls_signature_hash_algorithm ( struct tls_connection *tls,
+			       struct pubkey_algorithm *pubkey,
+			       struct digest_algorithm *digest ) {
 	struct tls_signature_hash_algorithm *sig_hash;
+	struct pubkey_algorithm *key;
 
 	/* Identify signature and hash algorithm */
 	for_each_table_entry ( sig_hash, TLS_SIG_HASH_ALGORITHMS ) {
-		if ( sig_hash->code.signature == code.signature )
-			return sig_hash->pubkey;
+		key = ( ( sig_hash->key &&
+			  tls_version ( tls, TLS_VERSION_TLS_1_3 ) ) ?
+			sig_hash->key : sig_hash->pubkey );
+		if ( ( key == pubkey ) &&
+		     ( sig_hash->digest == digest ) &&
+		     tls_signature_hash_permitted ( tls, sig_hash ) ) {
+			return sig_hash;
+		}
 	}
 
 	return NULL;
 }
 
 /**
- * Find TLS hash algorithm
+ * Identify TLS signature and hash algorithm
  *
+ * @v tls		TLS connection
  * @v code		Signature and hash algorithm identifier
- * @ret digest		Digest algorithm, or NULL
+ * @ret sig_hash	Signature and hash algorithm, or NULL
  */
-static struct digest_algorithm *
-tls_signature_hash_digest ( struct tls_signature_hash_id code ) {
+static struct tls_signature_hash_algorithm *
+tls_signature_hash ( struct tls_connection *tls,
+		     struct tls_signature_hash_id code ) {
 	struct tls_signature_hash_algorithm *sig_hash;
 
 	/* Identify signature and hash algorithm */
 	for_each_table_entry ( sig_hash, TLS_SIG_HASH_ALGORITHMS ) {
-		if ( sig_hash->code.hash == code.hash )
-			return sig_hash->digest;
+		if ( ( sig_hash->code.signature == code.signature ) &&
+		     ( sig_hash->code.hash == code.hash ) &&
+		     tls_signature_hash_permitted ( tls, sig_hash ) ) {
+			return sig_hash;
+		}
 	}
 
 	return NULL;
@@ -1099,6 +1276,331 @@ tls_find_named_curve ( unsigned int named_curve ) {
 	return NULL;
 }
 
+/******************************************************************************
+ *
+ * TLSv1.3 key schedule
+ *
+ ******************************************************************************
+ */
+
+/**
+ * Expand TLSv1.3 labelled secret
+ *
+ * @v tls		TLS connection
+ * @v secret		Secret
+ * @v label		Label (without "tls13 " prefix)
+ * @v context		Context
+ * @v context_len	Length of context
+ * @v out		Output buffer
+ * @v len		Length of output buffer
+ */
+static void tls13_expand_label ( struct tls_connection *tls,
+				 const void *secret, const char *label,
+				 const void *context, size_t context_len,
+				 void *out, size_t len ) {
+	struct digest_algorithm *digest = tls->handshake_digest;
+	static const char prefix[] = "tls13 ";
+	size_t label_len = strlen ( label );
+	struct {
+		uint16_t len;
+		uint8_t label_len;
+		char prefix[ sizeof ( prefix ) - 1 /* NUL */ ];
+		char label[label_len];
+		uint8_t context_len;
+		uint8_t context[context_len];
+	} __attribute__ (( packed )) info;
+
+	/* Construct HkdfLabel */
+	info.len = htons ( len );
+	info.label_len = ( sizeof ( info.prefix ) + sizeof ( info.label ) );
+	memcpy ( info.prefix, prefix, sizeof ( info.prefix ) );
+	memcpy ( info.label, label, sizeof ( info.label ) );
+	info.context_len = sizeof ( info.context );
+	memcpy ( info.context, context, sizeof ( info.context ) );
+
+	/* Expand secret */
+	hkdf_expand ( digest, secret, digest->digestsize, &info,
+		      sizeof ( info ), out, len );
+}
+
+/**
+ * Derive TLSv1.3 secret
+ *
+ * @v tls		TLS connection
+ * @v secret		Secret
+ * @v label		Label (without "tls13 " prefix)
+ * @v hash		Transcript hash
+ * @v out		Output secret
+ */
+static void tls13_derive_secret ( struct tls_connection *tls,
+				  const void *secret, const char *label,
+				  const void *hash, void *out ) {
+	struct digest_algorithm *digest = tls->handshake_digest;
+
+	tls13_expand_label ( tls, secret, label, hash, digest->digestsize,
+			     out, digest->digestsize );
+}
+
+/**
+ * Generate TLSv1.3 early secret
+ *
+ * @v tls		TLS connection
+ *
+ * Pre-shared keys are not supported, and so the early secret is
+ * always derived from an all-zero input keying material.
+ */
+static void tls13_early_secret ( struct tls_connection *tls ) {
+	struct digest_algorithm *digest = tls->handshake_digest;
+	uint8_t zero[ digest->digestsize ];
+
+	memset ( zero, 0, sizeof ( zero ) );
+	hkdf_extract ( digest, NULL, 0, zero, sizeof ( zero ),
+		       tls->master_secret );
+}
+
+/**
+ * Advance TLSv1.3 key schedule
+ *
+ * @v tls		TLS connection
+ * @v ikm		Input keying material, or NULL for all zeroes
+ * @v ikm_len		Length of input keying material
+ *
+ * Replace the current secret within the key schedule (i.e. the early
+ * secret or the handshake secret) with the next secret.
+ */
+static void tls13_extract ( struct tls_connection *tls, const void *ikm,
+			    size_t ikm_len ) {
+	struct digest_algorithm *digest = tls->handshake_digest;
+	uint8_t ctx[ digest->ctxsize ];
+	uint8_t hash[ digest->digestsize ];
+	uint8_t salt[ digest->digestsize ];
+	uint8_t zero[ digest->digestsize ];
+
+	/* Derive salt from current secret */
+	digest_init ( digest, ctx );
+	digest_final ( digest, ctx, hash );
+	tls13_derive_secret ( tls, tls->master_secret, "derived", hash, salt );
+
+	/* Use all-zero input keying material if applicable */
+	if ( ! ikm ) {
+		memset ( zero, 0, sizeof ( zero ) );
+		ikm = zero;
+		ikm_len = sizeof ( zero );
+	}
+
+	/* Extract next secret */
+	hkdf_extract ( digest, salt, sizeof ( salt ), ikm, ikm_len,
+		       tls->master_secret );
+	DBGC ( tls, "TLS %p key schedule secret:\n", tls );
+	DBGC_HD ( tls, tls->master_secret, digest->digestsize );
+}
+
+/**
+ * Set TLSv1.3 traffic keys
+ *
+ * @v tls		TLS connection
+ * @v cipherspec	TLS cipher specification
+ * @v suite		Cipher suite
+ * @v secret		Traffic secret
+ * @ret rc		Return status code
+ */
+static int tls13_set_cipher ( struct tls_connection *tls,
+			      struct tls_cipherspec *cipherspec,
+			      struct tls_cipher_suite *suite,
+			      const void *secret ) {
+	uint8_t key[ suite->key_len ];
+	int rc;
+
+	/* Set cipher suite */
+	if ( ( rc = tls_set_cipher ( tls, cipherspec, suite ) ) != 0 )
+		return rc;
+
+	/* Set key */
+	tls13_expand_label ( tls, secret, "key", NULL, 0, key,
+			     sizeof ( key ) );
+	if ( ( rc = cipher_setkey ( suite->cipher, cipherspec->cipher_ctx,
+				    key, sizeof ( key ) ) ) != 0 ) {
+		DBGC ( tls, "TLS %p could not set key: %s\n",
+		       tls, strerror ( rc ) );
+		return rc;
+	}
+
+	/* Set initialisation vector */
+	tls13_expand_label ( tls, secret, "iv", NULL, 0, cipherspec->fixed_iv,
+			     suite->fixed_iv_len );
+
+	return 0;
+}
+
+/**
+ * Update TLSv1.3 traffic keys
+ *
+ * @v tls		TLS connection
+ * @v pair		Cipher specification pair
+ * @v secret		Traffic secret to update
+ * @ret rc		Return status code
+ */
+static int tls13_update_cipher ( struct tls_connection *tls,
+				 struct tls_cipherspec_pair *pair,
+				 void *secret ) {
+	struct digest_algorithm *digest = tls->handshake_digest;
+	uint8_t next[ digest->digestsize ];
+	int rc;
+
+	/* Derive next traffic secret */
+	tls13_expand_label ( tls, secret, "traffic upd", NULL, 0, next,
+			     sizeof ( next ) );
+	memcpy ( secret, next, sizeof ( next ) );
+
+	/* Activate new traffic keys */
+	if ( ( rc = tls13_set_cipher ( tls, &pair->pending, pair->active.suite,
+				       secret ) ) != 0 )
+		return rc;
+	if ( ( rc = tls_change_cipher ( tls, pair ) ) != 0 )
+		return rc;
+
+	return 0;
+}
+
+/**
+ * Calculate TLSv1.3 Finished verification data
+ *
+ * @v tls		TLS connection
+ * @v secret		Handshake traffic secret
+ * @v hash		Transcript hash
+ * @v out		Output verification data
+ */
+static void tls13_finished ( struct tls_connection *tls, const void *secret,
+			     const void *hash, void *out ) {
+	struct digest_algorithm *digest = tls->handshake_digest;
+	uint8_t ctx[ hmac_ctxsize ( digest ) ];
+	uint8_t key[ digest->digestsize ];
+
+	/* Derive finished key */
+	tls13_expand_label ( tls, secret, "finished", NULL, 0, key,
+			     sizeof ( key ) );
+
+	/* Calculate verification data */
+	hmac_init ( digest, ctx, key, sizeof ( key ) );
+	hmac_update ( digest, ctx, hash, digest->digestsize );
+	hmac_final ( digest, ctx, out );
+}
+
+/** TLSv1.3 server Certificate Verify context string */
+#define TLS13_SERVER_VERIFY "TLS 1.3, server CertificateVerify"
+
+/** TLSv1.3 client Certificate Verify context string */
+#define TLS13_CLIENT_VERIFY "TLS 1.3, client CertificateVerify"
+
+/**
+ * Calculate TLSv1.3 Certificate Verify digest
+ *
+ * @v digest		Signature digest algorithm
+ * @v context		Context string
+ * @v hash		Transcript hash
+ * @v hash_len		Length of transcript hash
+ * @v out		Output digest
+ */
+static void tls13_certificate_verify_digest ( struct digest_algorithm *digest,
+					      const char *context,
+					      const void *hash,
+					      size_t hash_len, void *out ) {
+	uint8_t ctx[ digest->ctxsize ];
+	uint8_t pad[64];
+
+	/* Calculate digest over padding, context string (including
+	 * the NUL separator byte), and transcript hash.
+	 */
+	memset ( pad, ' ', sizeof ( pad ) );
+	digest_init ( digest, ctx );
+	digest_update ( digest, ctx, pad, sizeof ( pad ) );
+	digest_update ( digest, ctx, context, ( strlen ( context ) + 1 ) );
+	digest_update ( digest, ctx, hash, hash_len );
+	digest_final ( digest, ctx, out );
+}
+
+/**
+ * Discard TLSv1.3 key share
+ *
+ * @v tls		TLS connection
+ */
+static void tls13_discard_key_share ( struct tls_connection *tls ) {
+
+	free ( tls->client.private );
+	tls->client.private = NULL;
+	tls->client.public = NULL;
+	tls->client.public_len = 0;
+	tls->client.curve = NULL;
+}
+
+/**
+ * Generate TLSv1.3 key share
+ *
+ * @v tls		TLS connection
+ * @v curve		Named curve
+ * @ret rc		Return status code
+ */
+static int tls13_generate_key_share ( struct tls_connection *tls,
+				      struct tls_named_curve *curve ) {
+	struct elliptic_curve *elliptic = curve->curve;
+	size_t offset = ( curve->format ? 1 : 0 );
+	size_t len = ( elliptic->keysize + offset + elliptic->pointsize );
+	uint8_t *private;
+	uint8_t *public;
+	int rc;
+
+	/* Discard any existing key share */
+	tls13_discard_key_share ( tls );
+
+	/* Allocate key share */
+	private = malloc ( len );
+	if ( ! private ) {
+		rc = -ENOMEM_KEY_SHARE;
+		goto err_alloc;
+	}
+	public = ( private + elliptic->keysize );
+
+	/* Generate ephemeral private key */
+	if ( ( rc = tls_generate_random ( tls, private,
+					  elliptic->keysize ) ) != 0 ) {
+		goto err_random;
+	}
+
+	/* Construct public key */
+	if ( curve->format )
+		public[0] = curve->format;
+	if ( ( rc = elliptic_multiply ( elliptic, elliptic->base, private,
+					( public + offset ) ) ) != 0 ) {
+		DBGC ( tls, "TLS %p could not generate %s key share: %s\n",
+		       tls, elliptic->name, strerror ( rc ) );
+		goto err_multiply;
+	}
+
+	/* Record key share */
+	tls->client.curve = curve;
+	tls->client.private = private;
+	tls->client.public = public;
+	tls->client.public_len = ( offset + elliptic->pointsize );
+	DBGC ( tls, "TLS %p generated %s key share\n", tls, elliptic->name );
+
+	return 0;
+
+ err_multiply:
+ err_random:
+	free ( private );
+ err_alloc:
+	return rc;
+}
+
+/** TLSv1.3 key share exchange algorithm
+ *
+ * TLSv1.3 key exchange takes place entirely within the Client Hello
+ * and Server Hello, and so there is no Client Key Exchange record.
+ */
+struct tls_key_exchange_algorithm tls_key_share_exchange_algorithm = {
+	.name = "keyshare",
+};
+
 /******************************************************************************
  *
  * Record handling
@@ -1127,6 +1629,54 @@ static void tls_tx_resume_all ( struct tls_session *session ) {
 		tls_tx_resume ( tls );
 }
 
+/**
+ * Record session ID and session ticket for Client Hello
+ *
+ * @v tls		TLS connection
+ * @ret rc		Return status code
+ */
+static int tls_resume_session ( struct tls_connection *tls ) {
+	struct tls_session *session = tls->session;
+
+	/* Record or generate session ID and associated master secret */
+	if ( session->id_len ) {
+		/* Attempt to resume an existing session */
+		memcpy ( tls->session_id, session->id,
+			 sizeof ( tls->session_id ) );
+		tls->session_id_len = session->id_len;
+		memcpy ( tls->master_secret, session->master_secret,
+			 sizeof ( tls->master_secret ) );
+	} else {
+		/* No existing session: use a random session ID */
+		assert ( sizeof ( tls->session_id ) ==
+			 sizeof ( tls->client.random ) );
+		memcpy ( tls->session_id, &tls->client.random,
+			 sizeof ( tls->session_id ) );
+		tls->session_id_len = sizeof ( tls->session_id );
+	}
+
+	/* Free any existing copy of the session ticket */
+	free ( tls->session_ticket );
+	tls->session_ticket = NULL;
+	tls->session_ticket_len = 0;
+
+	/* Record a copy of the session ticket.  The session's ticket
+	 * may be replaced by a concurrent connection before this
+	 * connection's Client Hello has been added to the handshake
+	 * digest.
+	 */
+	if ( session->ticket_len ) {
+		tls->session_ticket = malloc ( session->ticket_len );
+		if ( ! tls->session_ticket )
+			return -ENOMEM;
+		memcpy ( tls->session_ticket, session->ticket,
+			 session->ticket_len );
+		tls->session_ticket_len = session->ticket_len;
+	}
+
+	return 0;
+}
+
 /**
  * Restart negotiation
  *
@@ -1141,6 +1691,8 @@ static void tls_restart ( struct tls_connection *tls ) {
 	assert ( ! is_pending ( &tls->server.validation ) );
 
 	/* (Re)start negotiation */
+	trace ( "tls", "handshake", tls, 0 );
+	tls->false_start = 0;
 	tls->tx.pending = TLS_TX_CLIENT_HELLO;
 	tls_tx_resume ( tls );
 	pending_get ( &tls->client.negotiation );
@@ -1175,6 +1727,8 @@ static int tls_client_hello ( struct tls_connection *tls,
 						 size_t len ) ) {
 	struct tls_session *session = tls->session;
 	size_t name_len = strlen ( session->name );
+	size_t alpn_len = ( tls->alpn_offer ? strlen ( tls->alpn_offer ) : 0 );
+	int tls13 = ( tls->client.curve ? 1 : 0 );
 	struct {
 		uint16_t type;
 		uint16_t len;
@@ -1216,7 +1770,7 @@ static int tls_client_hello ( struct tls_connection *tls,
 		uint16_t type;
 		uint16_t len;
 		struct {
-			uint8_t data[session->ticket_len];
+			uint8_t data[tls->session_ticket_len];
 		} __attribute__ (( packed )) data;
 	} __attribute__ (( packed )) *session_ticket_ext;
 	struct {
@@ -1232,31 +1786,83 @@ static int tls_client_hello ( struct tls_connection *tls,
 		uint16_t len;
 	} __attribute__ (( packed )) *extended_master_secret_ext;
 	struct {
-		typeof ( *server_name_ext ) server_name;
-		typeof ( *max_fragment_length_ext ) max_fragment_length;
-		typeof ( *signature_algorithms_ext ) signature_algorithms;
-		typeof ( *renegotiation_info_ext ) renegotiation_info;
-		typeof ( *session_ticket_ext ) session_ticket;
-		typeof ( *extended_master_secret_ext ) extended_master_secret;
-		typeof ( *named_curve_ext )
-			named_curve[TLS_NUM_NAMED_CURVES ? 1 : 0];
-	} __attribute__ (( packed )) *extensions;
+		uint16_t type;
+		uint16_t len;
+		struct {
+			uint16_t len;
+			uint8_t list[alpn_len];
+		} __attribute__ (( packed )) data;
+	} __attribute__ (( packed )) *alpn_ext;
 	struct {
-		uint32_t type_length;
-		uint16_t version;
-		uint8_t random[32];
-		uint8_t session_id_len;
-		uint8_t session_id[tls->session_id_len];
-		uint16_t cipher_suite_len;
-		uint16_t cipher_suites[TLS_NUM_CIPHER_SUITES];
-		uint8_t compression_methods_len;
-		uint8_t compression_methods[1];
-		uint16_t extensions_len;
-		typeof ( *extensions ) extensions;
+		uint16_t type;
+		uint16_t len;
+		struct {
+			uint8_t len;
+			uint16_t version[TLS_NUM_VERSIONS];
+		} __attribute__ (( packed )) data;
+	} __attribute__ (( packed )) *supported_versions_ext;
+	struct {
+		uint16_t type;
+		uint16_t len;
+		struct {
+			uint16_t len;
+			struct {
+				uint16_t group;
+				uint16_t len;
+				uint8_t key[tls->client.public_len];
+			} __attribute__ (( packed )) share[1];
+		} __attribute__ (( packed )) data;
+	} __attribute__ (( packed )) *key_share_ext;
+	struct {
+		uint16_t type;
+		uint16_t len;
+		struct {
+			uint16_t len;
+			uint8_t data[tls->client.cookie_len];
+		} __attribute__ (( packed )) data;
+	} __attribute__ (( packed )) *cookie_ext;
+	struct {
+		uint16_t type;
+		uint16_t len;
+		struct {
+			uint8_t type;
+			uint16_t responder_id_list_len;
+			uint16_t request_extensions_len;
+		} __attribute__ (( packed )) data;
+	} __attribute__ (( packed )) *status_request_ext;
+	struct {
+		typeof ( *server_name_ext ) server_name;
+		typeof ( *max_fragment_length_ext ) max_fragment_length;
+		typeof ( *signature_algorithms_ext ) signature_algorithms;
+		typeof ( *renegotiation_info_ext ) renegotiation_info;
+		typeof ( *session_ticket_ext ) session_ticket;
+		typeof ( *extended_master_secret_ext ) extended_master_secret;
+		typeof ( *named_curve_ext )
+			named_curve[TLS_NUM_NAMED_CURVES ? 1 : 0];
+		typeof ( *alpn_ext ) alpn[ alpn_len ? 1 : 0 ];
+		typeof ( *supported_versions_ext ) supported_versions[tls13];
+		typeof ( *key_share_ext ) key_share[tls13];
+		typeof ( *cookie_ext ) cookie[ tls->client.cookie_len ? 1 : 0 ];
+		typeof ( *status_request_ext )
+			status_request[ OCSP_ENABLED ? 1 : 0 ];
+	} __attribute__ (( packed )) *extensions;
+	struct {
+		uint32_t type_length;
+		uint16_t version;
+		uint8_t random[32];
+		uint8_t session_id_len;
+		uint8_t session_id[tls->session_id_len];
+		uint16_t cipher_suite_len;
+		uint16_t cipher_suites[TLS_NUM_CIPHER_SUITES];
+		uint8_t compression_methods_len;
+		uint8_t compression_methods[1];
+		uint16_t extensions_len;
+		typeof ( *extensions ) extensions;
 	} __attribute__ (( packed )) hello;
 	struct tls_cipher_suite *suite;
 	struct tls_signature_hash_algorithm *sighash;
 	struct tls_named_curve *curve;
+	unsigned int version;
 	unsigned int i;
 
 	/* Construct record */
@@ -1264,7 +1870,7 @@ static int tls_client_hello ( struct tls_connection *tls,
 	hello.type_length = ( cpu_to_le32 ( TLS_CLIENT_HELLO ) |
 			      htonl ( sizeof ( hello ) -
 				      sizeof ( hello.type_length ) ) );
-	hello.version = htons ( TLS_VERSION_MAX );
+	hello.version = htons ( TLS_VERSION_LEGACY_MAX );
 	memcpy ( &hello.random, &tls->client.random, sizeof ( hello.random ) );
 	hello.session_id_len = tls->session_id_len;
 	memcpy ( hello.session_id, tls->session_id,
@@ -1320,7 +1926,7 @@ static int tls_client_hello ( struct tls_connection *tls,
 	session_ticket_ext->type = htons ( TLS_SESSION_TICKET );
 	session_ticket_ext->len
 		= htons ( sizeof ( session_ticket_ext->data ) );
-	memcpy ( session_ticket_ext->data.data, session->ticket,
+	memcpy ( session_ticket_ext->data.data, tls->session_ticket,
 		 sizeof ( session_ticket_ext->data.data ) );
 
 	/* Construct extended master secret extension */
@@ -1341,6 +1947,69 @@ static int tls_client_hello ( struct tls_connection *tls,
 			named_curve_ext->data.code[i++] = curve->code;
 	}
 
+	/* Construct application-layer protocol negotiation
+	 * extension, if applicable
+	 */
+	if ( sizeof ( extensions->alpn ) ) {
+		alpn_ext = &extensions->alpn[0];
+		alpn_ext->type = htons ( TLS_ALPN );
+		alpn_ext->len = htons ( sizeof ( alpn_ext->data ) );
+		alpn_ext->data.len = htons ( sizeof ( alpn_ext->data.list ) );
+		memcpy ( alpn_ext->data.list, tls->alpn_offer,
+			 sizeof ( alpn_ext->data.list ) );
+	}
+
+	/* Construct supported versions extension, if applicable */
+	if ( sizeof ( extensions->supported_versions ) ) {
+		supported_versions_ext = &extensions->supported_versions[0];
+		supported_versions_ext->type = htons ( TLS_SUPPORTED_VERSIONS );
+		supported_versions_ext->len
+			= htons ( sizeof ( supported_versions_ext->data ) );
+		supported_versions_ext->data.len
+			= sizeof ( supported_versions_ext->data.version );
+		i = 0 ; for ( version = TLS_VERSION_MAX ;
+			      version >= TLS_VERSION_MIN ; version-- ) {
+			supported_versions_ext->data.version[i++]
+				= htons ( version );
+		}
+	}
+
+	/* Construct key share extension, if applicable */
+	if ( sizeof ( extensions->key_share ) ) {
+		key_share_ext = &extensions->key_share[0];
+		key_share_ext->type = htons ( TLS_KEY_SHARE );
+		key_share_ext->len = htons ( sizeof ( key_share_ext->data ) );
+		key_share_ext->data.len
+			= htons ( sizeof ( key_share_ext->data.share ) );
+		key_share_ext->data.share[0].group = tls->client.curve->code;
+		key_share_ext->data.share[0].len
+			= htons ( sizeof ( key_share_ext->data.share[0].key ) );
+		memcpy ( key_share_ext->data.share[0].key, tls->client.public,
+			 sizeof ( key_share_ext->data.share[0].key ) );
+	}
+
+	/* Construct cookie extension, if applicable */
+	if ( sizeof ( extensions->cookie ) ) {
+		cookie_ext = &extensions->cookie[0];
+		cookie_ext->type = htons ( TLS_COOKIE );
+		cookie_ext->len = htons ( sizeof ( cookie_ext->data ) );
+		cookie_ext->data.len = htons ( sizeof ( cookie_ext->data.data ) );
+		memcpy ( cookie_ext->data.data, tls->client.cookie,
+			 sizeof ( cookie_ext->data.data ) );
+	}
+
+	/* Construct certificate status request extension, if
+	 * applicable.  There is no point in requesting a stapled
+	 * OCSP response if OCSP checks are disabled.
+	 */
+	if ( sizeof ( extensions->status_request ) ) {
+		status_request_ext = &extensions->status_request[0];
+		status_request_ext->type = htons ( TLS_STATUS_REQUEST );
+		status_request_ext->len
+			= htons ( sizeof ( status_request_ext->data ) );
+		status_request_ext->data.type = TLS_STATUS_REQUEST_OCSP;
+	}
+
 	return action ( tls, &hello, sizeof ( hello ) );
 }
 
@@ -1351,6 +2020,29 @@ static int tls_client_hello ( struct tls_connection *tls,
  * @ret rc		Return status code
  */
 static int tls_send_client_hello ( struct tls_connection *tls ) {
+	struct tls_named_curve *curve;
+	int rc;
+
+	/* Record offered application protocols, so that the Client
+	 * Hello may be reconstructed identically when it is added to
+	 * the handshake digest.
+	 */
+	tls->alpn_offer = alpn_offer ( &tls->plainstream );
+
+	/* Generate a key share using the most preferred named curve
+	 * (if any), unless we are already retrying with a key share
+	 * requested by the server.  TLSv1.3 will be offered only if a
+	 * key share exists.  A renegotiation (which must remain at
+	 * the previously negotiated version) will never offer TLSv1.3.
+	 */
+	if ( ! tls_version ( tls, TLS_VERSION_TLS_1_3 ) ) {
+		tls13_discard_key_share ( tls );
+	} else if ( ! tls->client.curve ) {
+		curve = table_start ( TLS_NAMED_CURVES );
+		if ( TLS_NUM_NAMED_CURVES &&
+		     ( ( rc = tls13_generate_key_share ( tls, curve ) ) != 0 ) )
+			return rc;
+	}
 
 	return tls_client_hello ( tls, tls_send_handshake );
 }
@@ -1362,12 +2054,17 @@ static int tls_send_client_hello ( struct tls_connection *tls ) {
  * @ret rc		Return status code
  */
 static int tls_send_certificate ( struct tls_connection *tls ) {
+	int tls13 = tls_version ( tls, TLS_VERSION_TLS_1_3 );
 	struct {
 		tls24_t length;
 		uint8_t data[0];
 	} __attribute__ (( packed )) *certificate;
+	struct {
+		uint16_t len[tls13];
+	} __attribute__ (( packed )) *extensions;
 	struct {
 		uint32_t type_length;
+		uint8_t context_len[tls13];
 		tls24_t length;
 		typeof ( *certificate ) certificates[0];
 	} __attribute__ (( packed )) *certificates;
@@ -1380,7 +2077,8 @@ static int tls_send_certificate ( struct tls_connection *tls ) {
 	len = 0;
 	list_for_each_entry ( link, &tls->client.chain->links, list ) {
 		cert = link->cert;
-		len += ( sizeof ( *certificate ) + cert->raw.len );
+		len += ( sizeof ( *certificate ) + cert->raw.len +
+			 sizeof ( *extensions ) );
 		DBGC ( tls, "TLS %p sending client certificate %s\n",
 		       tls, x509_name ( cert ) );
 	}
@@ -1398,6 +2096,8 @@ static int tls_send_certificate ( struct tls_connection *tls ) {
 		( cpu_to_le32 ( TLS_CERTIFICATE ) |
 		  htonl ( sizeof ( *certificates ) + len -
 			  sizeof ( certificates->type_length ) ) );
+	memset ( certificates->context_len, 0,
+		 sizeof ( certificates->context_len ) );
 	tls_set_uint24 ( &certificates->length, len );
 	list_for_each_entry ( link, &tls->client.chain->links, list ) {
 		cert = link->cert;
@@ -1405,6 +2105,8 @@ static int tls_send_certificate ( struct tls_connection *tls ) {
 		tls_set_uint24 ( &certificate->length, cert->raw.len );
 		memcpy ( iob_put ( iobuf, cert->raw.len ), cert->raw.data,
 			 cert->raw.len );
+		extensions = iob_put ( iobuf, sizeof ( *extensions ) );
+		memset ( extensions, 0, sizeof ( *extensions ) );
 	}
 
 	/* Transmit record */
@@ -1433,7 +2135,7 @@ static int tls_send_client_key_exchange_pubkey ( struct tls_connection *tls ) {
 	int rc;
 
 	/* Generate pre-master secret */
-	pre_master_secret.version = htons ( TLS_VERSION_MAX );
+	pre_master_secret.version = htons ( TLS_VERSION_LEGACY_MAX );
 	if ( ( rc = tls_generate_random ( tls, &pre_master_secret.random,
 			  ( sizeof ( pre_master_secret.random ) ) ) ) != 0 ) {
 		goto err_random;
@@ -1502,7 +2204,9 @@ struct tls_key_exchange_algorithm tls_pubkey_exchange_algorithm = {
 static int tls_verify_dh_params ( struct tls_connection *tls,
 				  size_t param_len ) {
 	struct tls_cipherspec *cipherspec = &tls->tx.cipherspec.pending;
+	struct tls_signature_hash_algorithm *sig_hash;
 	struct pubkey_algorithm *pubkey;
+	struct pubkey_algorithm *key;
 	struct digest_algorithm *digest;
 	int use_sig_hash = tls_version ( tls, TLS_VERSION_TLS_1_2 );
 	const struct {
@@ -1536,14 +2240,16 @@ static int tls_verify_dh_params ( struct tls_connection *tls,
 
 	/* Identify signature and hash algorithm */
 	if ( use_sig_hash ) {
-		pubkey = tls_signature_hash_pubkey ( sig->sig_hash[0] );
-		digest = tls_signature_hash_digest ( sig->sig_hash[0] );
-		if ( ( ! pubkey ) || ( ! digest ) ) {
+		sig_hash = tls_signature_hash ( tls, sig->sig_hash[0] );
+		if ( ! sig_hash ) {
 			DBGC ( tls, "TLS %p ServerKeyExchange unsupported "
 			       "signature and hash algorithm\n", tls );
 			return -ENOTSUP_SIG_HASH;
 		}
-		if ( pubkey != cipherspec->suite->pubkey ) {
+		pubkey = sig_hash->pubkey;
+		digest = sig_hash->digest;
+		key = ( sig_hash->key ? sig_hash->key : pubkey );
+		if ( key != cipherspec->suite->pubkey ) {
 			DBGC ( tls, "TLS %p ServerKeyExchange incorrect "
 			       "signature algorithm %s (expected %s)\n", tls,
 			       pubkey->name, cipherspec->suite->pubkey->name );
@@ -1793,16 +2499,34 @@ static int tls_send_client_key_exchange_ecdhe ( struct tls_connection *tls ) {
 			uint8_t public[ecdh->public_len];
 		} __attribute__ (( packed )) key_xchg;
 
-		/* Generate ephemeral private key */
-		if ( ( rc = tls_generate_random ( tls, private,
-						  sizeof ( private ) ) ) != 0){
-			return rc;
+		/* Exchange keys, using the pre-generated key share if
+		 * it is for the same curve (thereby avoiding one
+		 * scalar multiplication on the critical path).
+		 */
+		if ( tls->client.curve == curve ) {
+			DBGC ( tls, "TLS %p using pre-generated %s key\n",
+			       tls, curve->curve->name );
+			assert ( tls->client.public_len ==
+				 sizeof ( key_xchg.public ) );
+			memcpy ( key_xchg.public, tls->client.public,
+				 sizeof ( key_xchg.public ) );
+			rc = ecdhe_shared ( curve->curve,
+					    ( ecdh->public + offset ),
+					    tls->client.private,
+					    pre_master_secret );
+		} else {
+			/* Generate ephemeral private key */
+			if ( ( rc = tls_generate_random ( tls, private,
+						sizeof ( private ) ) ) != 0 ) {
+				return rc;
+			}
+			rc = ecdhe_key ( curve->curve,
+					 ( ecdh->public + offset ), private,
+					 ( key_xchg.public + offset ),
+					 pre_master_secret );
 		}
-
-		/* Exchange keys */
-		if ( ( rc = ecdhe_key ( curve->curve, ( ecdh->public + offset ),
-					private, ( key_xchg.public + offset ),
-					pre_master_secret ) ) != 0 ) {
+		tls13_discard_key_share ( tls );
+		if ( rc != 0 ) {
 			DBGC ( tls, "TLS %p could not exchange ECDHE key: %s\n",
 			       tls, strerror ( rc ) );
 			return rc;
@@ -1886,7 +2610,7 @@ static int tls_send_certificate_verify ( struct tls_connection *tls ) {
 
 	/* TLSv1.2 and later use explicit algorithm identifiers */
 	if ( tls_version ( tls, TLS_VERSION_TLS_1_2 ) ) {
-		sig_hash = tls_signature_hash_algorithm ( pubkey, digest );
+		sig_hash = tls_signature_hash_algorithm ( tls, pubkey, digest );
 		if ( ! sig_hash ) {
 			DBGC ( tls, "TLS %p could not identify (%s,%s) "
 			       "signature and hash algorithm\n", tls,
@@ -1894,6 +2618,15 @@ static int tls_send_certificate_verify ( struct tls_connection *tls ) {
 			rc = -ENOTSUP_SIG_HASH;
 			goto err_sig_hash;
 		}
+		pubkey = sig_hash->pubkey;
+	}
+
+	/* TLSv1.3 signs a digest of the handshake digest */
+	if ( tls_version ( tls, TLS_VERSION_TLS_1_3 ) ) {
+		tls13_certificate_verify_digest ( digest, TLS13_CLIENT_VERIFY,
+						  digest_out,
+						  sizeof ( digest_out ),
+						  digest_out );
 	}
 
 	/* Sign digest */
@@ -1963,6 +2696,88 @@ static int tls_send_change_cipher ( struct tls_connection *tls ) {
 				    &change_cipher, sizeof ( change_cipher ) );
 }
 
+/**
+ * Transmit TLSv1.3 Finished record
+ *
+ * @v tls		TLS connection
+ * @ret rc		Return status code
+ */
+static int tls13_send_finished ( struct tls_connection *tls ) {
+	struct digest_algorithm *digest = tls->handshake_digest;
+	struct {
+		uint32_t type_length;
+		uint8_t verify_data[ digest->digestsize ];
+	} __attribute__ (( packed )) finished;
+	uint8_t digest_out[ digest->digestsize ];
+	int rc;
+
+	/* Construct record */
+	finished.type_length = ( cpu_to_le32 ( TLS_FINISHED ) |
+				 htonl ( sizeof ( finished ) -
+					 sizeof ( finished.type_length ) ) );
+	tls_verify_handshake ( tls, digest_out );
+	tls13_finished ( tls, tls->tx.secret, digest_out,
+			 finished.verify_data );
+
+	/* Transmit record */
+	if ( ( rc = tls_send_handshake ( tls, &finished,
+					 sizeof ( finished ) ) ) != 0 )
+		return rc;
+
+	/* Activate application traffic keys */
+	if ( ( rc = tls_change_cipher ( tls, &tls->tx.cipherspec ) ) != 0 ) {
+		DBGC ( tls, "TLS %p could not activate TX cipher: %s\n",
+		       tls, strerror ( rc ) );
+		return rc;
+	}
+	tls->tx.seq = 0;
+	memcpy ( tls->tx.secret, tls->tx.pending_secret,
+		 sizeof ( tls->tx.secret ) );
+
+	/* Mark client as finished */
+	pending_put ( &tls->client.negotiation );
+
+	return 0;
+}
+
+/**
+ * Check whether or not False Start is permitted
+ *
+ * @v tls		TLS connection
+ * @ret permitted	False Start is permitted
+ *
+ * False Start (RFC 7918) allows application data to be transmitted
+ * immediately after the client Finished, without waiting for the
+ * server Finished.  This is permitted only for a full handshake
+ * using a forward-secret key exchange and an authenticated
+ * encryption cipher, and only once the server certificate has been
+ * validated.
+ */
+static int tls_false_start_permitted ( struct tls_connection *tls ) {
+	struct tls_cipher_suite *suite = tls->tx.cipherspec.active.suite;
+
+	/* Do not use for abbreviated (resumed) handshakes, where the
+	 * server Finished has already been received.
+	 */
+	if ( ! is_pending ( &tls->server.negotiation ) )
+		return 0;
+
+	/* Require a forward-secret key exchange */
+	if ( ( suite->exchange != &tls_ecdhe_exchange_algorithm ) &&
+	     ( suite->exchange != &tls_dhe_exchange_algorithm ) )
+		return 0;
+
+	/* Require an authenticated encryption cipher */
+	if ( ! is_auth_cipher ( suite->cipher ) )
+		return 0;
+
+	/* Require server certificate to have been validated */
+	if ( is_pending ( &tls->server.validation ) )
+		return 0;
+
+	return 1;
+}
+
 /**
  * Transmit Finished record
  *
@@ -1978,6 +2793,10 @@ static int tls_send_finished ( struct tls_connection *tls ) {
 	uint8_t digest_out[ digest->digestsize ];
 	int rc;
 
+	/* Use TLSv1.3 construction if applicable */
+	if ( tls_version ( tls, TLS_VERSION_TLS_1_3 ) )
+		return tls13_send_finished ( tls );
+
 	/* Construct client verification data */
 	tls_verify_handshake ( tls, digest_out );
 	tls_prf_label ( tls, &tls->master_secret, sizeof ( tls->master_secret ),
@@ -2000,6 +2819,48 @@ static int tls_send_finished ( struct tls_connection *tls ) {
 	/* Mark client as finished */
 	pending_put ( &tls->client.negotiation );
 
+	/* Allow application data to be sent immediately, if permitted */
+	tls->false_start = tls_false_start_permitted ( tls );
+	if ( tls->false_start )
+		DBGC ( tls, "TLS %p using False Start\n", tls );
+
+	return 0;
+}
+
+/**
+ * Transmit Key Update record
+ *
+ * @v tls		TLS connection
+ * @ret rc		Return status code
+ */
+static int tls_send_key_update ( struct tls_connection *tls ) {
+	struct {
+		uint32_t type_length;
+		uint8_t request_update;
+	} __attribute__ (( packed )) key_update;
+	int rc;
+
+	/* Construct record */
+	key_update.type_length = ( cpu_to_le32 ( TLS_KEY_UPDATE ) |
+				   htonl ( sizeof ( key_update ) -
+					   sizeof ( key_update.type_length )));
+	key_update.request_update = TLS_KEY_UPDATE_NOT_REQUESTED;
+
+	/* Transmit record */
+	if ( ( rc = tls_send_handshake ( tls, &key_update,
+					 sizeof ( key_update ) ) ) != 0 )
+		return rc;
+
+	/* Update transmit traffic keys */
+	if ( ( rc = tls13_update_cipher ( tls, &tls->tx.cipherspec,
+					  tls->tx.secret ) ) != 0 ) {
+		DBGC ( tls, "TLS %p could not update TX cipher: %s\n",
+		       tls, strerror ( rc ) );
+		return rc;
+	}
+	tls->tx.seq = 0;
+	DBGC ( tls, "TLS %p updated TX traffic keys\n", tls );
+
 	return 0;
 }
 
@@ -2050,13 +2911,19 @@ static int tls_new_change_cipher ( struct tls_connection *tls,
 	}
 	iob_pull ( iobuf, sizeof ( *change_cipher ) );
 
+	/* Ignore Change Cipher in TLSv1.3, where it may be sent only
+	 * for middlebox compatibility.
+	 */
+	if ( tls_version ( tls, TLS_VERSION_TLS_1_3 ) )
+		return 0;
+
 	/* Change receive cipher spec */
 	if ( ( rc = tls_change_cipher ( tls, &tls->rx.cipherspec ) ) != 0 ) {
 		DBGC ( tls, "TLS %p could not activate RX cipher: %s\n",
 		       tls, strerror ( rc ) );
 		return rc;
 	}
-	tls->rx.seq = ~( ( uint64_t ) 0 );
+	tls->rx.seq = 0;
 
 	return 0;
 }
@@ -2141,6 +3008,260 @@ static int tls_new_hello_request ( struct tls_connection *tls,
 	return 0;
 }
 
+/**
+ * Record negotiated application protocol
+ *
+ * @v tls		TLS connection
+ * @v name		Application protocol name, or NULL
+ * @v len		Length of application protocol name
+ * @ret rc		Return status code
+ */
+static int tls_select_alpn ( struct tls_connection *tls, const char *name,
+			     size_t len ) {
+	const uint8_t *offer;
+
+	/* Clear any existing application protocol */
+	tls->alpn[0] = '\0';
+
+	/* Do nothing further unless a protocol was selected */
+	if ( ! name )
+		return 0;
+
+	/* Check that protocol was offered */
+	for ( offer = ( ( const void * ) tls->alpn_offer ) ;
+	      offer && *offer ;
+	      offer += ( 1 /* length */ + *offer ) ) {
+		if ( ( *offer == len ) &&
+		     ( memcmp ( ( offer + 1 /* length */ ), name, len ) == 0 ))
+			break;
+	}
+	if ( ( ! offer ) || ( ! *offer ) || ( len >= sizeof ( tls->alpn ) ) ) {
+		DBGC ( tls, "TLS %p server selected unoffered application "
+		       "protocol:\n", tls );
+		DBGC_HDA ( tls, 0, name, len );
+		return -EPERM_ALPN;
+	}
+
+	/* Record protocol */
+	memcpy ( tls->alpn, name, len );
+	tls->alpn[len] = '\0';
+	DBGC ( tls, "TLS %p using application protocol \"%s\"\n",
+	       tls, tls->alpn );
+
+	return 0;
+}
+
+/** Hello Retry Request random value
+ *
+ * This is the SHA-256 hash of the string "HelloRetryRequest".
+ */
+static const uint8_t tls13_hello_retry_random[32] = {
+	0xcf, 0x21, 0xad, 0x74, 0xe5, 0x9a, 0x61, 0x11, 0xbe, 0x1d, 0x8c,
+	0x02, 0x1e, 0x65, 0xb8, 0x91, 0xc2, 0xa2, 0x11, 0x16, 0x7a, 0xbb,
+	0x8c, 0x5e, 0x07, 0x9e, 0x09, 0xe2, 0xc8, 0xa8, 0x33, 0x9c,
+};
+
+/** Server random downgrade protection sentinel
+ *
+ * A TLSv1.3 server that negotiates an earlier protocol version will
+ * set the final eight bytes of the server random to this value,
+ * followed by 0x01 (for TLSv1.2) or 0x00 (for TLSv1.1 and earlier).
+ */
+static const uint8_t tls13_downgrade[7] = {
+	'D', 'O', 'W', 'N', 'G', 'R', 'D',
+};
+
+/**
+ * Receive new Hello Retry Request
+ *
+ * @v tls		TLS connection
+ * @v cipher_suite	Cipher suite specification
+ * @v group		Requested named curve, or NULL
+ * @v cookie		Cookie, or NULL
+ * @v cookie_len	Length of cookie
+ * @ret rc		Return status code
+ */
+static int tls_new_hello_retry_request ( struct tls_connection *tls,
+					 unsigned int cipher_suite,
+					 const uint16_t *group,
+					 const void *cookie,
+					 size_t cookie_len ) {
+	struct digest_algorithm *digest;
+	struct tls_named_curve *curve;
+	int rc;
+
+	/* Allow only a single Hello Retry Request, which must request
+	 * a change to the Client Hello.
+	 */
+	if ( tls->hello_retry ) {
+		DBGC ( tls, "TLS %p received second Hello Retry Request\n",
+		       tls );
+		return -EPROTO_HELLO_RETRY;
+	}
+	if ( ! ( group || cookie ) ) {
+		DBGC ( tls, "TLS %p received Hello Retry Request with no "
+		       "changes\n", tls );
+		return -EPROTO_HELLO_RETRY;
+	}
+	tls->hello_retry = 1;
+	DBGC ( tls, "TLS %p received Hello Retry Request\n", tls );
+
+	/* Select cipher suite */
+	if ( ( rc = tls_select_cipher ( tls, cipher_suite ) ) != 0 )
+		return rc;
+	digest = tls->handshake_digest;
+
+	/* Replace initial Client Hello with a synthetic message hash */
+	{
+		struct {
+			uint32_t type_length;
+			uint8_t hash[ digest->digestsize ];
+		} __attribute__ (( packed )) message_hash;
+
+		/* Calculate digest of initial Client Hello */
+		if ( ( rc = tls_client_hello ( tls, tls_add_handshake ) ) != 0 )
+			return rc;
+		tls_verify_handshake ( tls, message_hash.hash );
+		message_hash.type_length =
+			( cpu_to_le32 ( TLS_MESSAGE_HASH ) |
+			  htonl ( sizeof ( message_hash.hash ) ) );
+
+		/* Restart handshake digest */
+		if ( ( rc = tls_select_handshake ( tls, digest ) ) != 0 )
+			return rc;
+		tls_add_handshake ( tls, &message_hash,
+				    sizeof ( message_hash ) );
+	}
+
+	/* Generate key share for requested named curve, if applicable */
+	if ( group ) {
+		curve = tls_find_named_curve ( *group );
+		if ( ( ! curve ) || ( curve == tls->client.curve ) ) {
+			DBGC ( tls, "TLS %p Hello Retry Request selected "
+			       "invalid named curve %d\n",
+			       tls, ntohs ( *group ) );
+			return -EPROTO_HELLO_RETRY;
+		}
+		if ( ( rc = tls13_generate_key_share ( tls, curve ) ) != 0 )
+			return rc;
+	}
+
+	/* Record cookie, if applicable */
+	if ( cookie ) {
+		free ( tls->client.cookie );
+		tls->client.cookie_len = 0;
+		tls->client.cookie = malloc ( cookie_len );
+		if ( ! tls->client.cookie )
+			return -ENOMEM_COOKIE;
+		memcpy ( tls->client.cookie, cookie, cookie_len );
+		tls->client.cookie_len = cookie_len;
+	}
+
+	/* Retransmit Client Hello */
+	tls->tx.pending |= TLS_TX_CLIENT_HELLO;
+	tls_tx_resume ( tls );
+
+	return 0;
+}
+
+/**
+ * Handle TLSv1.3 Server Hello key share
+ *
+ * @v tls		TLS connection
+ * @v data		Plaintext handshake record
+ * @v len		Length of plaintext handshake record
+ * @v ext		Key share extension, or NULL
+ * @v ext_len		Length of key share extension
+ * @ret rc		Return status code
+ */
+static int tls13_new_key_share ( struct tls_connection *tls,
+				 const void *data, size_t len,
+				 const void *ext, size_t ext_len ) {
+	struct tls_named_curve *curve = tls->client.curve;
+	struct tls_cipher_suite *suite = tls->tx.cipherspec.pending.suite;
+	struct digest_algorithm *digest = tls->handshake_digest;
+	struct elliptic_curve *elliptic;
+	const struct {
+		uint16_t group;
+		uint16_t len;
+		uint8_t key[0];
+	} __attribute__ (( packed )) *key_share = ext;
+	uint8_t hash[ digest->digestsize ];
+	size_t offset;
+	int rc;
+
+	/* Parse key share */
+	assert ( curve != NULL );
+	elliptic = curve->curve;
+	offset = ( curve->format ? 1 : 0 );
+	if ( ( ! key_share ) || ( sizeof ( *key_share ) > ext_len ) ||
+	     ( ntohs ( key_share->len ) !=
+	       ( ext_len - sizeof ( *key_share ) ) ) ) {
+		DBGC ( tls, "TLS %p received invalid key share\n", tls );
+		DBGC_HD ( tls, data, len );
+		return -EINVAL_KEY_SHARE;
+	}
+	if ( ( key_share->group != curve->code ) ||
+	     ( ntohs ( key_share->len ) != ( offset + elliptic->pointsize ) ) ||
+	     ( curve->format && ( key_share->key[0] != curve->format ) ) ) {
+		DBGC ( tls, "TLS %p received invalid %s key share\n",
+		       tls, elliptic->name );
+		DBGC_HD ( tls, data, len );
+		return -EINVAL_KEY_SHARE;
+	}
+
+	/* Generate handshake secret */
+	{
+		uint8_t shared[ elliptic->pointsize ];
+
+		/* Calculate shared secret */
+		if ( ( rc = elliptic_multiply ( elliptic,
+						( key_share->key + offset ),
+						tls->client.private,
+						shared ) ) != 0 ) {
+			DBGC ( tls, "TLS %p could not calculate %s shared "
+			       "secret: %s\n", tls, elliptic->name,
+			       strerror ( rc ) );
+			return rc;
+		}
+		if ( elliptic_is_infinity ( elliptic, shared ) ) {
+			DBGC ( tls, "TLS %p %s shared secret is point at "
+			       "infinity\n", tls, elliptic->name );
+			return -EINVAL_KEY_SHARE;
+		}
+
+		/* Advance key schedule */
+		tls13_early_secret ( tls );
+		tls13_extract ( tls, shared, curve->pre_master_secret_len );
+	}
+
+	/* Discard key share, which is no longer required */
+	tls13_discard_key_share ( tls );
+
+	/* Derive handshake traffic secrets */
+	tls_verify_handshake_record ( tls, TLS_SERVER_HELLO, data, len, hash );
+	tls13_derive_secret ( tls, tls->master_secret, "c hs traffic", hash,
+			      tls->tx.secret );
+	tls13_derive_secret ( tls, tls->master_secret, "s hs traffic", hash,
+			      tls->rx.secret );
+
+	/* Activate handshake traffic keys */
+	if ( ( rc = tls13_set_cipher ( tls, &tls->tx.cipherspec.pending, suite,
+				       tls->tx.secret ) ) != 0 )
+		return rc;
+	if ( ( rc = tls13_set_cipher ( tls, &tls->rx.cipherspec.pending, suite,
+				       tls->rx.secret ) ) != 0 )
+		return rc;
+	if ( ( rc = tls_change_cipher ( tls, &tls->tx.cipherspec ) ) != 0 )
+		return rc;
+	if ( ( rc = tls_change_cipher ( tls, &tls->rx.cipherspec ) ) != 0 )
+		return rc;
+	tls->tx.seq = 0;
+	tls->rx.seq = 0;
+
+	return 0;
+}
+
 /**
  * Receive new Server Hello handshake record
  *
@@ -2179,8 +3300,25 @@ static int tls_new_server_hello ( struct tls_connection *tls,
 	const struct {
 		uint8_t data[0];
 	} __attribute__ (( packed )) *ems = NULL;
-	uint16_t version;
-	size_t exts_len;
+	const struct {
+		uint16_t len;
+		uint8_t name_len;
+		char name[0];
+	} __attribute__ (( packed )) *alpn = NULL;
+	const struct {
+		uint16_t version;
+	} __attribute__ (( packed )) *supported_version = NULL;
+	const struct {
+		uint16_t group;
+		uint8_t next[0];
+	} __attribute__ (( packed )) *key_share = NULL;
+	const struct {
+		uint16_t len;
+		uint8_t data[0];
+	} __attribute__ (( packed )) *cookie = NULL;
+	size_t key_share_len = 0;
+	uint16_t version;
+	size_t exts_len;
 	size_t ext_len;
 	size_t remaining;
 	int rc;
@@ -2246,42 +3384,158 @@ static int tls_new_server_hello ( struct tls_connection *tls,
 			case htons ( TLS_EXTENDED_MASTER_SECRET ) :
 				ems = ( ( void * ) ext->data );
 				break;
+			case htons ( TLS_ALPN ) :
+				alpn = ( ( void * ) ext->data );
+				if ( ( sizeof ( *alpn ) >= ext_len ) ||
+				     ( ntohs ( alpn->len ) !=
+				       ( ext_len - sizeof ( alpn->len ) ) ) ||
+				     ( alpn->name_len !=
+				       ( ext_len - sizeof ( *alpn ) ) ) ) {
+					DBGC ( tls, "TLS %p received invalid "
+					       "application protocol\n", tls );
+					DBGC_HD ( tls, data, len );
+					return -EINVAL_HELLO;
+				}
+				break;
+			case htons ( TLS_SUPPORTED_VERSIONS ) :
+				supported_version = ( ( void * ) ext->data );
+				if ( sizeof ( *supported_version ) != ext_len ){
+					DBGC ( tls, "TLS %p received invalid "
+					       "supported version\n", tls );
+					DBGC_HD ( tls, data, len );
+					return -EINVAL_HELLO;
+				}
+				break;
+			case htons ( TLS_KEY_SHARE ) :
+				key_share = ( ( void * ) ext->data );
+				key_share_len = ext_len;
+				if ( sizeof ( *key_share ) > ext_len ) {
+					DBGC ( tls, "TLS %p received "
+					       "underlength key share\n", tls );
+					DBGC_HD ( tls, data, len );
+					return -EINVAL_HELLO;
+				}
+				break;
+			case htons ( TLS_COOKIE ) :
+				cookie = ( ( void * ) ext->data );
+				if ( ( sizeof ( *cookie ) > ext_len ) ||
+				     ( ntohs ( cookie->len ) !=
+				       ( ext_len - sizeof ( *cookie ) ) ) ) {
+					DBGC ( tls, "TLS %p received invalid "
+					       "cookie\n", tls );
+					DBGC_HD ( tls, data, len );
+					return -EINVAL_HELLO;
+				}
+				break;
 			}
 		}
 	}
 
 	/* Check and store protocol version */
 	version = ntohs ( hello_a->version );
+	if ( supported_version ) {
+		version = ntohs ( supported_version->version );
+		if ( version < TLS_VERSION_TLS_1_3 ) {
+			DBGC ( tls, "TLS %p received invalid supported "
+			       "version %d.%d\n", tls,
+			       ( version >> 8 ), ( version & 0xff ) );
+			return -EINVAL_HELLO;
+		}
+	}
 	if ( version < TLS_VERSION_MIN ) {
 		DBGC ( tls, "TLS %p does not support protocol version %d.%d\n",
 		       tls, ( version >> 8 ), ( version & 0xff ) );
 		return -ENOTSUP_VERSION;
 	}
-	if ( version > tls->version ) {
+	if ( ( version > tls->version ) ||
+	     ( ( version > TLS_VERSION_LEGACY_MAX ) && ! tls->client.curve ) ) {
 		DBGC ( tls, "TLS %p server attempted to illegally upgrade to "
 		       "protocol version %d.%d\n",
 		       tls, ( version >> 8 ), ( version & 0xff ) );
 		return -EPROTO_VERSION;
 	}
+
+	/* Check for downgrade attack, if applicable */
+	if ( tls->client.curve && ( version < TLS_VERSION_TLS_1_3 ) &&
+	     ( memcmp ( &hello_a->random[24], tls13_downgrade,
+			sizeof ( tls13_downgrade ) ) == 0 ) &&
+	     ( hello_a->random[31] <= 0x01 ) ) {
+		DBGC ( tls, "TLS %p server attempted to downgrade to protocol "
+		       "version %d.%d\n",
+		       tls, ( version >> 8 ), ( version & 0xff ) );
+		return -EPERM_DOWNGRADE;
+	}
 	tls->version = version;
 	DBGC ( tls, "TLS %p using protocol version %d.%d\n",
 	       tls, ( version >> 8 ), ( version & 0xff ) );
 
-	/* Select cipher suite */
-	if ( ( rc = tls_select_cipher ( tls, hello_b->cipher_suite ) ) != 0 )
-		return rc;
+	/* Handle Hello Retry Request, if applicable */
+	if ( memcmp ( hello_a->random, tls13_hello_retry_random,
+		      sizeof ( tls13_hello_retry_random ) ) == 0 ) {
+		if ( ! supported_version ) {
+			DBGC ( tls, "TLS %p received Hello Retry Request "
+			       "without supported version\n", tls );
+			return -EINVAL_HELLO;
+		}
+		if ( key_share && ( key_share_len != sizeof ( *key_share ) ) ){
+			DBGC ( tls, "TLS %p received invalid Hello Retry "
+			       "Request key share\n", tls );
+			DBGC_HD ( tls, data, len );
+			return -EINVAL_HELLO;
+		}
+		return tls_new_hello_retry_request ( tls, hello_b->cipher_suite,
+						     ( key_share ?
+						       &key_share->group :
+						       NULL ),
+						     ( cookie ?
+						       cookie->data : NULL ),
+						     ( cookie ?
+						       ntohs ( cookie->len ) :
+						       0 ) );
+	}
 
-	/* Add preceding Client Hello to handshake digest */
-	if ( ( rc = tls_client_hello ( tls, tls_add_handshake ) ) != 0 )
-		return rc;
+	/* Select cipher suite and add preceding Client Hello to
+	 * handshake digest, unless this has already been done by a
+	 * preceding Hello Retry Request.
+	 */
+	if ( tls->hello_retry ) {
+		if ( ( version < TLS_VERSION_TLS_1_3 ) ||
+		     ( hello_b->cipher_suite !=
+		       tls->tx.cipherspec.pending.suite->code ) ) {
+			DBGC ( tls, "TLS %p Server Hello does not match Hello "
+			       "Retry Request\n", tls );
+			return -EPROTO_HELLO_RETRY;
+		}
+	} else {
+		if ( ( rc = tls_select_cipher ( tls,
+						hello_b->cipher_suite ) ) != 0 )
+			return rc;
+		if ( ( rc = tls_client_hello ( tls, tls_add_handshake ) ) != 0 )
+			return rc;
+	}
 
 	/* Copy out server random bytes */
 	memcpy ( &tls->server.random, &hello_a->random,
 		 sizeof ( tls->server.random ) );
 
+	/* Handle TLSv1.3 key exchange, if applicable */
+	if ( tls_version ( tls, TLS_VERSION_TLS_1_3 ) ) {
+		return tls13_new_key_share ( tls, data, len, key_share,
+					     key_share_len );
+	}
+
+	/* Retain the (unused) TLSv1.3 key share, since it may be
+	 * reused for an ECDHE key exchange using the same curve.
+	 */
+
 	/* Handle extended master secret */
 	tls->extended_master_secret = ( !! ems );
 
+	/* Record negotiated application protocol, if any */
+	if ( ( rc = tls_select_alpn ( tls, ( alpn ? alpn->name : NULL ),
+				      ( alpn ? alpn->name_len : 0 ) ) ) != 0 )
+		return rc;
+
 	/* Check session ID */
 	if ( hello_a->session_id_len &&
 	     ( hello_a->session_id_len == tls->session_id_len ) &&
@@ -2360,6 +3614,14 @@ static int tls_new_session_ticket ( struct tls_connection *tls,
 	} __attribute__ (( packed )) *new_session_ticket = data;
 	size_t ticket_len;
 
+	/* Ignore TLSv1.3 session tickets, since pre-shared keys are
+	 * not supported.
+	 */
+	if ( tls_version ( tls, TLS_VERSION_TLS_1_3 ) ) {
+		DBGC ( tls, "TLS %p ignoring New Session Ticket\n", tls );
+		return 0;
+	}
+
 	/* Parse header */
 	if ( sizeof ( *new_session_ticket ) > len ) {
 		DBGC ( tls, "TLS %p received underlength New Session Ticket\n",
@@ -2394,6 +3656,185 @@ static int tls_new_session_ticket ( struct tls_connection *tls,
 	return 0;
 }
 
+/**
+ * Receive new Encrypted Extensions handshake record
+ *
+ * @v tls		TLS connection
+ * @v data		Plaintext handshake record
+ * @v len		Length of plaintext handshake record
+ * @ret rc		Return status code
+ */
+static int tls_new_encrypted_extensions ( struct tls_connection *tls,
+					  const void *data, size_t len ) {
+	const struct {
+		uint16_t len;
+		uint8_t data[0];
+	} __attribute__ (( packed )) *exts = data;
+	const struct {
+		uint16_t type;
+		uint16_t len;
+		uint8_t data[0];
+	} __attribute__ (( packed )) *ext;
+	const struct {
+		uint16_t len;
+		uint8_t name_len;
+		char name[0];
+	} __attribute__ (( packed )) *alpn = NULL;
+	size_t exts_len;
+	size_t ext_len;
+	size_t remaining;
+	int rc;
+
+	/* Sanity check */
+	if ( ! tls_version ( tls, TLS_VERSION_TLS_1_3 ) ) {
+		DBGC ( tls, "TLS %p received unexpected Encrypted "
+		       "Extensions\n", tls );
+		return -EINVAL_EXTENSIONS;
+	}
+
+	/* Parse extensions length */
+	if ( ( sizeof ( *exts ) > len ) ||
+	     ( ( exts_len = ntohs ( exts->len ) ) !=
+	       ( len - sizeof ( *exts ) ) ) ) {
+		DBGC ( tls, "TLS %p received invalid Encrypted Extensions\n",
+		       tls );
+		DBGC_HD ( tls, data, len );
+		return -EINVAL_EXTENSIONS;
+	}
+
+	/* Parse extensions */
+	for ( ext = ( ( void * ) exts->data ), remaining = exts_len ;
+	      remaining ;
+	      ext = ( ( ( void * ) ext ) + sizeof ( *ext ) + ext_len ),
+		      remaining -= ( sizeof ( *ext ) + ext_len ) ) {
+
+		/* Parse extension length */
+		if ( ( sizeof ( *ext ) > remaining ) ||
+		     ( ( ext_len = ntohs ( ext->len ) ) >
+		       ( remaining - sizeof ( *ext ) ) ) ) {
+			DBGC ( tls, "TLS %p received underlength extension\n",
+			       tls );
+			DBGC_HD ( tls, data, len );
+			return -EINVAL_EXTENSIONS;
+		}
+
+		/* Record known extensions */
+		switch ( ext->type ) {
+		case htons ( TLS_ALPN ) :
+			alpn = ( ( void * ) ext->data );
+			if ( ( sizeof ( *alpn ) >= ext_len ) ||
+			     ( ntohs ( alpn->len ) !=
+			       ( ext_len - sizeof ( alpn->len ) ) ) ||
+			     ( alpn->name_len !=
+			       ( ext_len - sizeof ( *alpn ) ) ) ) {
+				DBGC ( tls, "TLS %p received invalid "
+				       "application protocol\n", tls );
+				DBGC_HD ( tls, data, len );
+				return -EINVAL_EXTENSIONS;
+			}
+			break;
+		}
+	}
+
+	/* Record negotiated application protocol, if any */
+	if ( ( rc = tls_select_alpn ( tls, ( alpn ? alpn->name : NULL ),
+				      ( alpn ? alpn->name_len : 0 ) ) ) != 0 )
+		return rc;
+
+	return 0;
+}
+
+/**
+ * Parse certificate status
+ *
+ * @v tls		TLS connection
+ * @v data		Certificate status
+ * @v len		Length of certificate status
+ * @ret rc		Return status code
+ */
+static int tls_parse_certificate_status ( struct tls_connection *tls,
+					  const void *data, size_t len ) {
+	const struct {
+		uint8_t type;
+		tls24_t length;
+		uint8_t response[0];
+	} __attribute__ (( packed )) *status = data;
+	size_t response_len;
+
+	/* Parse header */
+	if ( ( sizeof ( *status ) > len ) ||
+	     ( status->type != TLS_STATUS_REQUEST_OCSP ) ||
+	     ( ( response_len = tls_uint24 ( &status->length ) ) !=
+	       ( len - sizeof ( *status ) ) ) ) {
+		DBGC ( tls, "TLS %p received invalid certificate status\n",
+		       tls );
+		DBGC_HD ( tls, data, len );
+		return -EINVAL_CERTIFICATE_STATUS;
+	}
+
+	/* Free any existing stapled OCSP response */
+	free ( tls->server.ocsp );
+	tls->server.ocsp_len = 0;
+
+	/* Record stapled OCSP response */
+	tls->server.ocsp = malloc ( response_len );
+	if ( ! tls->server.ocsp )
+		return -ENOMEM;
+	memcpy ( tls->server.ocsp, status->response, response_len );
+	tls->server.ocsp_len = response_len;
+	DBGC ( tls, "TLS %p received stapled OCSP response\n", tls );
+
+	return 0;
+}
+
+/**
+ * Parse TLSv1.3 server certificate extensions
+ *
+ * @v tls		TLS connection
+ * @v data		Certificate extensions
+ * @v len		Length of certificate extensions
+ * @ret rc		Return status code
+ */
+static int tls13_parse_certificate_extensions ( struct tls_connection *tls,
+						const void *data,
+						size_t len ) {
+	const struct {
+		uint16_t type;
+		uint16_t len;
+		uint8_t data[0];
+	} __attribute__ (( packed )) *ext;
+	size_t ext_len;
+	size_t remaining;
+	int rc;
+
+	/* Parse extensions */
+	for ( ext = data, remaining = len ; remaining ;
+	      ext = ( ( ( void * ) ext ) + sizeof ( *ext ) + ext_len ),
+		      remaining -= ( sizeof ( *ext ) + ext_len ) ) {
+
+		/* Parse extension length */
+		if ( ( sizeof ( *ext ) > remaining ) ||
+		     ( ( ext_len = ntohs ( ext->len ) ) >
+		       ( remaining - sizeof ( *ext ) ) ) ) {
+			DBGC ( tls, "TLS %p received underlength certificate "
+			       "extension\n", tls );
+			DBGC_HD ( tls, data, len );
+			return -EINVAL_CERTIFICATE;
+		}
+
+		/* Handle known extensions */
+		switch ( ext->type ) {
+		case htons ( TLS_STATUS_REQUEST ) :
+			if ( ( rc = tls_parse_certificate_status ( tls,
+				    ext->data, ext_len ) ) != 0 )
+				return rc;
+			break;
+		}
+	}
+
+	return 0;
+}
+
 /**
  * Parse certificate chain
  *
@@ -2404,13 +3845,17 @@ static int tls_new_session_ticket ( struct tls_connection *tls,
  */
 static int tls_parse_chain ( struct tls_connection *tls,
 			     const void *data, size_t len ) {
+	int tls13 = tls_version ( tls, TLS_VERSION_TLS_1_3 );
 	size_t remaining = len;
 	int rc;
 
-	/* Free any existing certificate chain */
+	/* Free any existing certificate chain and stapled OCSP response */
 	memset ( &tls->server.key, 0, sizeof ( tls->server.key ) );
 	x509_chain_put ( tls->server.chain );
 	tls->server.chain = NULL;
+	free ( tls->server.ocsp );
+	tls->server.ocsp = NULL;
+	tls->server.ocsp_len = 0;
 
 	/* Create certificate chain */
 	tls->server.chain = x509_alloc_chain();
@@ -2425,7 +3870,11 @@ static int tls_parse_chain ( struct tls_connection *tls,
 			tls24_t length;
 			uint8_t data[0];
 		} __attribute__ (( packed )) *certificate = data;
+		const struct {
+			uint16_t len[tls13];
+		} __attribute__ (( packed )) *extensions;
 		size_t certificate_len;
+		size_t extensions_len;
 		size_t record_len;
 		struct x509_certificate *cert;
 
@@ -2445,6 +3894,36 @@ static int tls_parse_chain ( struct tls_connection *tls,
 		}
 		record_len = ( sizeof ( *certificate ) + certificate_len );
 
+		/* Skip certificate extensions, if applicable */
+		extensions = ( data + record_len );
+		if ( sizeof ( *extensions ) > ( remaining - record_len ) ) {
+			DBGC ( tls, "TLS %p underlength certificate "
+			       "extensions:\n", tls );
+			DBGC_HDA ( tls, 0, data, remaining );
+			rc = -EINVAL_CERTIFICATE;
+			goto err_underlength;
+		}
+		record_len += sizeof ( *extensions );
+		extensions_len = ( tls13 ? ntohs ( extensions->len[0] ) : 0 );
+		if ( extensions_len > ( remaining - record_len ) ) {
+			DBGC ( tls, "TLS %p overlength certificate "
+			       "extensions:\n", tls );
+			DBGC_HDA ( tls, 0, data, remaining );
+			rc = -EINVAL_CERTIFICATE;
+			goto err_overlength;
+		}
+
+		/* Parse extensions for the server certificate (which
+		 * is always the first certificate in the list).
+		 */
+		if ( extensions_len && ( remaining == len ) &&
+		     ( ( rc = tls13_parse_certificate_extensions ( tls,
+				( data + record_len ),
+				extensions_len ) ) != 0 ) ) {
+			goto err_extensions;
+		}
+		record_len += extensions_len;
+
 		/* Add certificate to chain */
 		if ( ( rc = x509_append_raw ( tls->server.chain,
 					      certificate->data,
@@ -2466,6 +3945,7 @@ static int tls_parse_chain ( struct tls_connection *tls,
 	return 0;
 
  err_parse:
+ err_extensions:
  err_overlength:
  err_underlength:
 	memset ( &tls->server.key, 0, sizeof ( tls->server.key ) );
@@ -2485,7 +3965,9 @@ static int tls_parse_chain ( struct tls_connection *tls,
  */
 static int tls_new_certificate ( struct tls_connection *tls,
 				 const void *data, size_t len ) {
+	int tls13 = tls_version ( tls, TLS_VERSION_TLS_1_3 );
 	const struct {
+		uint8_t context_len[tls13];
 		tls24_t length;
 		uint8_t certificates[0];
 	} __attribute__ (( packed )) *certificate = data;
@@ -2506,6 +3988,12 @@ static int tls_new_certificate ( struct tls_connection *tls,
 		DBGC_HD ( tls, data, len );
 		return -EINVAL_CERTIFICATES;
 	}
+	if ( tls13 && certificate->context_len[0] ) {
+		DBGC ( tls, "TLS %p received Server Certificate with "
+		       "non-empty context\n", tls );
+		DBGC_HD ( tls, data, len );
+		return -EINVAL_CERTIFICATES;
+	}
 
 	/* Parse certificate chain */
 	if ( ( rc = tls_parse_chain ( tls, certificate->certificates,
@@ -2515,6 +4003,28 @@ static int tls_new_certificate ( struct tls_connection *tls,
 	return 0;
 }
 
+/**
+ * Receive new Certificate Status handshake record
+ *
+ * @v tls		TLS connection
+ * @v data		Plaintext handshake record
+ * @v len		Length of plaintext handshake record
+ * @ret rc		Return status code
+ */
+static int tls_new_certificate_status ( struct tls_connection *tls,
+					const void *data, size_t len ) {
+
+	/* Sanity check */
+	if ( tls_version ( tls, TLS_VERSION_TLS_1_3 ) ) {
+		DBGC ( tls, "TLS %p received unexpected Certificate Status\n",
+		       tls );
+		return -EINVAL_CERTIFICATE_STATUS;
+	}
+
+	/* Parse certificate status */
+	return tls_parse_certificate_status ( tls, data, len );
+}
+
 /**
  * Receive new Server Key Exchange handshake record
  *
@@ -2606,6 +4116,33 @@ static int tls_new_certificate_request ( struct tls_connection *tls,
 	return rc;
 }
 
+/**
+ * Begin server certificate validation
+ *
+ * @v tls		TLS connection
+ * @ret rc		Return status code
+ */
+static int tls_validate ( struct tls_connection *tls ) {
+	struct asn1_cursor stapled;
+	int rc;
+
+	/* Identify stapled OCSP response, if any */
+	stapled.data = tls->server.ocsp;
+	stapled.len = tls->server.ocsp_len;
+
+	/* Begin certificate validation */
+	if ( ( rc = create_validator ( &tls->server.validator,
+				       tls->server.chain, tls->server.root,
+				       &stapled ) ) != 0 ) {
+		DBGC ( tls, "TLS %p could not start certificate validation: "
+		       "%s\n", tls, strerror ( rc ) );
+		return rc;
+	}
+	pending_get ( &tls->server.validation );
+
+	return 0;
+}
+
 /**
  * Receive new Server Hello Done handshake record
  *
@@ -2619,7 +4156,6 @@ static int tls_new_server_hello_done ( struct tls_connection *tls,
 	const struct {
 		char next[0];
 	} __attribute__ (( packed )) *hello_done = data;
-	int rc;
 
 	/* Sanity check */
 	if ( sizeof ( *hello_done ) != len ) {
@@ -2630,14 +4166,198 @@ static int tls_new_server_hello_done ( struct tls_connection *tls,
 	}
 
 	/* Begin certificate validation */
-	if ( ( rc = create_validator ( &tls->server.validator,
-				       tls->server.chain,
-				       tls->server.root ) ) != 0 ) {
-		DBGC ( tls, "TLS %p could not start certificate validation: "
-		       "%s\n", tls, strerror ( rc ) );
-		return rc;
+	return tls_validate ( tls );
+}
+
+/**
+ * Receive new Certificate Verify handshake record
+ *
+ * @v tls		TLS connection
+ * @v data		Plaintext handshake record
+ * @v len		Length of plaintext handshake record
+ * @ret rc		Return status code
+ */
+static int tls_new_certificate_verify ( struct tls_connection *tls,
+					const void *data, size_t len ) {
+	struct digest_algorithm *digest = tls->handshake_digest;
+
+	/* Sanity check */
+	if ( ! tls_version ( tls, TLS_VERSION_TLS_1_3 ) ) {
+		DBGC ( tls, "TLS %p received unexpected Certificate Verify\n",
+		       tls );
+		return -EINVAL_CERTIFICATE_VERIFY;
 	}
-	pending_get ( &tls->server.validation );
+
+	/* Free any existing server key exchange record */
+	free ( tls->server.exchange );
+	tls->server.exchange_len = 0;
+
+	/* Allocate copy of handshake digest and Certificate Verify
+	 * record
+	 */
+	tls->server.exchange = malloc ( digest->digestsize + len );
+	if ( ! tls->server.exchange )
+		return -ENOMEM;
+
+	/* Store copy of handshake digest (excluding this record) and
+	 * Certificate Verify record for later processing.  We cannot
+	 * verify the signature at this point since the certificate
+	 * validation will not yet have completed.
+	 */
+	tls_verify_handshake ( tls, tls->server.exchange );
+	memcpy ( ( tls->server.exchange + digest->digestsize ), data, len );
+	tls->server.exchange_len = ( digest->digestsize + len );
+
+	/* Begin certificate validation */
+	return tls_validate ( tls );
+}
+
+/**
+ * Verify TLSv1.3 server Certificate Verify signature
+ *
+ * @v tls		TLS connection
+ * @ret rc		Return status code
+ */
+static int tls13_verify_certificate_verify ( struct tls_connection *tls ) {
+	struct digest_algorithm *handshake = tls->handshake_digest;
+	struct tls_signature_hash_algorithm *sig_hash;
+	struct digest_algorithm *digest;
+	const struct {
+		struct tls_signature_hash_id sig_hash;
+		uint16_t signature_len;
+		uint8_t signature[0];
+	} __attribute__ (( packed )) *verify;
+	struct asn1_cursor signature;
+	size_t remaining;
+	int rc;
+
+	/* Parse Certificate Verify record */
+	assert ( tls->server.exchange_len >= handshake->digestsize );
+	verify = ( tls->server.exchange + handshake->digestsize );
+	remaining = ( tls->server.exchange_len - handshake->digestsize );
+	if ( ( sizeof ( *verify ) > remaining ) ||
+	     ( ntohs ( verify->signature_len ) !=
+	       ( remaining - sizeof ( *verify ) ) ) ) {
+		DBGC ( tls, "TLS %p received invalid Certificate Verify\n",
+		       tls );
+		DBGC_HDA ( tls, 0, verify, remaining );
+		return -EINVAL_CERTIFICATE_VERIFY;
+	}
+	signature.data = verify->signature;
+	signature.len = ntohs ( verify->signature_len );
+
+	/* Identify signature and hash algorithm */
+	sig_hash = tls_signature_hash ( tls, verify->sig_hash );
+	if ( ! sig_hash ) {
+		DBGC ( tls, "TLS %p Certificate Verify unsupported signature "
+		       "and hash algorithm\n", tls );
+		return -ENOTSUP_SIG_HASH;
+	}
+	digest = sig_hash->digest;
+
+	/* Verify signature */
+	{
+		uint8_t hash[ digest->digestsize ];
+
+		/* Calculate digest */
+		tls13_certificate_verify_digest ( digest, TLS13_SERVER_VERIFY,
+						  tls->server.exchange,
+						  handshake->digestsize, hash );
+
+		/* Verify signature */
+		if ( ( rc = pubkey_verify ( sig_hash->pubkey, &tls->server.key,
+					    digest, hash,
+					    &signature ) ) != 0 ) {
+			DBGC ( tls, "TLS %p Certificate Verify failed "
+			       "verification\n", tls );
+			return -EPERM_CERTIFICATE_VERIFY;
+		}
+	}
+
+	return 0;
+}
+
+/**
+ * Receive new TLSv1.3 Finished handshake record
+ *
+ * @v tls		TLS connection
+ * @v data		Plaintext handshake record
+ * @v len		Length of plaintext handshake record
+ * @ret rc		Return status code
+ */
+static int tls13_new_finished ( struct tls_connection *tls,
+				const void *data, size_t len ) {
+	struct tls_session *session = tls->session;
+	struct digest_algorithm *digest = tls->handshake_digest;
+	struct tls_cipher_suite *suite = tls->rx.cipherspec.active.suite;
+	const struct {
+		uint8_t verify_data[ digest->digestsize ];
+		char next[0];
+	} __attribute__ (( packed )) *finished = data;
+	uint8_t digest_out[ digest->digestsize ];
+	uint8_t verify_data[ digest->digestsize ];
+	int rc;
+
+	/* Sanity check */
+	if ( sizeof ( *finished ) != len ) {
+		DBGC ( tls, "TLS %p received overlength Finished\n", tls );
+		DBGC_HD ( tls, data, len );
+		return -EINVAL_FINISHED;
+	}
+
+	/* Check that server has authenticated itself */
+	if ( ! tls->server.exchange ) {
+		DBGC ( tls, "TLS %p received Finished without Certificate "
+		       "Verify\n", tls );
+		return -EPERM_CERTIFICATE_VERIFY;
+	}
+
+	/* Verify data */
+	tls_verify_handshake ( tls, digest_out );
+	tls13_finished ( tls, tls->rx.secret, digest_out, verify_data );
+	if ( memcmp ( verify_data, finished->verify_data,
+		      sizeof ( verify_data ) ) != 0 ) {
+		DBGC ( tls, "TLS %p verification failed\n", tls );
+		return -EPERM_VERIFY;
+	}
+
+	/* Mark server as finished */
+	pending_put ( &tls->server.negotiation );
+	trace ( "tls", "finished", tls, 0 );
+
+	/* Generate master secret */
+	tls13_extract ( tls, NULL, 0 );
+
+	/* Derive application traffic secrets */
+	tls_verify_handshake_record ( tls, TLS_FINISHED, data, len,
+				      digest_out );
+	tls13_derive_secret ( tls, tls->master_secret, "c ap traffic",
+			      digest_out, tls->tx.pending_secret );
+	tls13_derive_secret ( tls, tls->master_secret, "s ap traffic",
+			      digest_out, tls->rx.secret );
+
+	/* Activate receive application traffic keys */
+	if ( ( rc = tls13_set_cipher ( tls, &tls->rx.cipherspec.pending, suite,
+				       tls->rx.secret ) ) != 0 )
+		return rc;
+	if ( ( rc = tls_change_cipher ( tls, &tls->rx.cipherspec ) ) != 0 )
+		return rc;
+	tls->rx.seq = 0;
+
+	/* Prepare transmit application traffic keys, to be activated
+	 * once the client Finished has been sent.
+	 */
+	if ( ( rc = tls13_set_cipher ( tls, &tls->tx.cipherspec.pending, suite,
+				       tls->tx.pending_secret ) ) != 0 )
+		return rc;
+	session->established = 1;
+
+	/* Move to end of session's connection list and allow other
+	 * connections to start making progress.
+	 */
+	list_del ( &tls->list );
+	list_add_tail ( &tls->list, &session->conn );
+	tls_tx_resume_all ( session );
 
 	return 0;
 }
@@ -2660,6 +4380,10 @@ static int tls_new_finished ( struct tls_connection *tls,
 	} __attribute__ (( packed )) *finished = data;
 	uint8_t digest_out[ digest->digestsize ];
 
+	/* Use TLSv1.3 construction if applicable */
+	if ( tls_version ( tls, TLS_VERSION_TLS_1_3 ) )
+		return tls13_new_finished ( tls, data, len );
+
 	/* Sanity check */
 	if ( sizeof ( *finished ) != len ) {
 		DBGC ( tls, "TLS %p received overlength Finished\n", tls );
@@ -2680,6 +4404,7 @@ static int tls_new_finished ( struct tls_connection *tls,
 
 	/* Mark server as finished */
 	pending_put ( &tls->server.negotiation );
+	trace ( "tls", "finished", tls, 0 );
 
 	/* If we are resuming a session (i.e. if the server Finished
 	 * arrives before the client Finished is sent), then schedule
@@ -2707,6 +4432,7 @@ static int tls_new_finished ( struct tls_connection *tls,
 		tls->new_session_ticket = NULL;
 		tls->new_session_ticket_len = 0;
 	}
+	session->established = 1;
 
 	/* Move to end of session's connection list and allow other
 	 * connections to start making progress.
@@ -2721,6 +4447,50 @@ static int tls_new_finished ( struct tls_connection *tls,
 	return 0;
 }
 
+/**
+ * Receive new Key Update handshake record
+ *
+ * @v tls		TLS connection
+ * @v data		Plaintext handshake record
+ * @v len		Length of plaintext handshake record
+ * @ret rc		Return status code
+ */
+static int tls_new_key_update ( struct tls_connection *tls,
+				const void *data, size_t len ) {
+	const struct {
+		uint8_t request_update;
+	} __attribute__ (( packed )) *key_update = data;
+	int rc;
+
+	/* Sanity check */
+	if ( ( ! tls_version ( tls, TLS_VERSION_TLS_1_3 ) ) ||
+	     ( ! tls_ready ( tls ) ) ||
+	     ( sizeof ( *key_update ) != len ) ||
+	     ( key_update->request_update > TLS_KEY_UPDATE_REQUESTED ) ) {
+		DBGC ( tls, "TLS %p received invalid Key Update\n", tls );
+		DBGC_HD ( tls, data, len );
+		return -EINVAL_KEY_UPDATE;
+	}
+
+	/* Update receive traffic keys */
+	if ( ( rc = tls13_update_cipher ( tls, &tls->rx.cipherspec,
+					  tls->rx.secret ) ) != 0 ) {
+		DBGC ( tls, "TLS %p could not update RX cipher: %s\n",
+		       tls, strerror ( rc ) );
+		return rc;
+	}
+	tls->rx.seq = 0;
+	DBGC ( tls, "TLS %p updated RX traffic keys\n", tls );
+
+	/* Schedule transmission of Key Update, if requested */
+	if ( key_update->request_update == TLS_KEY_UPDATE_REQUESTED ) {
+		tls->tx.pending |= TLS_TX_KEY_UPDATE;
+		tls_tx_resume ( tls );
+	}
+
+	return 0;
+}
+
 /**
  * Receive new Handshake record
  *
@@ -2769,6 +4539,10 @@ static int tls_new_handshake ( struct tls_connection *tls,
 			rc = tls_new_session_ticket ( tls, payload,
 						      payload_len );
 			break;
+		case TLS_ENCRYPTED_EXTENSIONS:
+			rc = tls_new_encrypted_extensions ( tls, payload,
+							    payload_len );
+			break;
 		case TLS_CERTIFICATE:
 			rc = tls_new_certificate ( tls, payload, payload_len );
 			break;
@@ -2784,9 +4558,20 @@ static int tls_new_handshake ( struct tls_connection *tls,
 			rc = tls_new_server_hello_done ( tls, payload,
 							 payload_len );
 			break;
+		case TLS_CERTIFICATE_VERIFY:
+			rc = tls_new_certificate_verify ( tls, payload,
+							  payload_len );
+			break;
+		case TLS_CERTIFICATE_STATUS:
+			rc = tls_new_certificate_status ( tls, payload,
+							  payload_len );
+			break;
 		case TLS_FINISHED:
 			rc = tls_new_finished ( tls, payload, payload_len );
 			break;
+		case TLS_KEY_UPDATE:
+			rc = tls_new_key_update ( tls, payload, payload_len );
+			break;
 		default:
 			DBGC ( tls, "TLS %p ignoring handshake type %d\n",
 			       tls, handshake->type );
@@ -3024,6 +4809,55 @@ static void tls_hmac_list ( struct tls_cipherspec *cipherspec,
 	tls_hmac_final ( cipherspec, ctx, hmac );
 }
 
+/**
+ * Construct implicit per-record initialisation vector
+ *
+ * @v cipherspec	Cipher specification
+ * @v iv		Fixed portion of initialisation vector to update
+ * @v seq		Record sequence number
+ *
+ * Cipher suites with no explicit per-record initialisation vector
+ * (such as ChaCha20-Poly1305) construct the per-record nonce by
+ * XORing the padded sequence number into the fixed initialisation
+ * vector, as described in RFC 7905.  This is a no-op for cipher
+ * suites with an explicit per-record initialisation vector.
+ */
+static void tls_implicit_iv ( struct tls_cipherspec *cipherspec, void *iv,
+			      uint64_t seq ) {
+	struct tls_cipher_suite *suite = cipherspec->suite;
+	uint8_t *bytes = iv;
+	size_t len = suite->fixed_iv_len;
+	unsigned int i;
+
+	/* Do nothing unless the initialisation vector is implicit */
+	if ( suite->record_iv_len )
+		return;
+
+	/* XOR sequence number into trailing bytes */
+	for ( i = 0 ; ( i < sizeof ( seq ) ) && ( i < len ) ; i++ ) {
+		bytes[ len - 1 - i ] ^= ( seq & 0xff );
+		seq >>= 8;
+	}
+}
+
+/**
+ * Check for TLSv1.3 protected record format
+ *
+ * @v tls		TLS connection
+ * @v cipherspec	Cipher specification
+ * @ret protected	Records use the TLSv1.3 protected record format
+ *
+ * TLSv1.3 protected records carry the true content type as a
+ * trailing byte within the encrypted plaintext, and use the record
+ * header as the additional authenticated data.
+ */
+static inline __attribute__ (( always_inline )) int
+tls13_protected ( struct tls_connection *tls,
+		  struct tls_cipherspec *cipherspec ) {
+	return ( tls_version ( tls, TLS_VERSION_TLS_1_3 ) &&
+		 ( cipherspec->suite != &tls_cipher_suite_null ) );
+}
+
 /**
  * Calculate maximum additional length required for transmitted record(s)
  *
@@ -3045,6 +4879,7 @@ static size_t tls_iob_reserved ( struct tls_connection *tls, size_t len ) {
 	/* Calculate maximum additional length per record */
 	each = ( sizeof ( *tlshdr ) + suite->record_iv_len + suite->mac_len +
 		 ( is_block_cipher ( cipher ) ? cipher->blocksize : 0 ) +
+		 ( tls13_protected ( tls, cipherspec ) ? 1 : 0 ) +
 		 cipher->authsize );
 
 	/* Calculate maximum total additional length */
@@ -3077,6 +4912,24 @@ static struct io_buffer * tls_alloc_iob ( struct tls_connection *tls,
 	return iobuf;
 }
 
+/**
+ * Send coalesced application data record, if any
+ *
+ * @v tls		TLS connection
+ * @ret rc		Return status code
+ */
+static int tls_send_coalesced ( struct tls_connection *tls ) {
+	struct io_buffer *iobuf = tls->tx.coalesce;
+
+	/* Do nothing unless we have coalesced data */
+	if ( ! iobuf )
+		return 0;
+	tls->tx.coalesce = NULL;
+
+	/* Send data record */
+	return tls_send_record ( tls, TLS_TYPE_DATA, iobuf );
+}
+
 /**
  * Send plaintext record(s)
  *
@@ -3095,22 +4948,40 @@ static int tls_send_record ( struct tls_connection *tls, unsigned int type,
 		uint8_t fixed[suite->fixed_iv_len];
 		uint8_t rec[suite->record_iv_len];
 	} __attribute__ (( packed )) iv;
+	int protected = tls13_protected ( tls, cipherspec );
+	struct {
+		uint8_t type[protected];
+	} __attribute__ (( packed )) *inner;
 	struct tls_auth_header authhdr;
 	struct tls_header *tlshdr;
 	uint8_t mac[digest->digestsize];
 	const void *plaintext;
 	const void *encrypt;
+	const void *aad;
 	void *ciphertext;
+	unsigned int version;
 	size_t record_len;
 	size_t encrypt_len;
+	size_t aad_len;
 	size_t pad_len;
 	size_t len;
 	int rc;
 
+	/* Send any coalesced data first, to preserve record ordering */
+	if ( ( type != TLS_TYPE_DATA ) &&
+	     ( ( rc = tls_send_coalesced ( tls ) ) != 0 ) ) {
+		goto err_coalesced;
+	}
+
 	/* Record plaintext pointer and length */
 	plaintext = iobuf->data;
 	len = iob_len ( iobuf );
 
+	/* Identify record version (which is frozen at TLSv1.2) */
+	version = tls->version;
+	if ( version > TLS_VERSION_LEGACY_MAX )
+		version = TLS_VERSION_LEGACY_MAX;
+
 	/* Add to handshake digest if applicable */
 	if ( type == TLS_TYPE_HANDSHAKE )
 		tls_add_handshake ( tls, plaintext, len );
@@ -3128,6 +4999,7 @@ static int tls_send_record ( struct tls_connection *tls, unsigned int type,
 
 		/* Construct and set initialisation vector */
 		memcpy ( iv.fixed, cipherspec->fixed_iv, sizeof ( iv.fixed ) );
+		tls_implicit_iv ( cipherspec, iv.fixed, tls->tx.seq );
 		if ( ( rc = tls_generate_random ( tls, iv.rec,
 						  sizeof ( iv.rec ) ) ) != 0 ) {
 			goto err_random;
@@ -3135,22 +5007,9 @@ static int tls_send_record ( struct tls_connection *tls, unsigned int type,
 		cipher_setiv ( cipher, cipherspec->cipher_ctx, &iv,
 			       sizeof ( iv ) );
 
-		/* Construct and process authentication data */
-		authhdr.seq = cpu_to_be64 ( tls->tx.seq );
-		authhdr.header.type = type;
-		authhdr.header.version = htons ( tls->version );
-		authhdr.header.length = htons ( record_len );
-		if ( suite->mac_len ) {
-			tls_hmac ( cipherspec, &authhdr, plaintext, record_len,
-				   mac );
-		}
-		if ( is_auth_cipher ( cipher ) ) {
-			cipher_encrypt ( cipher, cipherspec->cipher_ctx,
-					 &authhdr, NULL, sizeof ( authhdr ) );
-		}
-
 		/* Calculate encryption length */
-		encrypt_len = ( record_len + suite->mac_len );
+		encrypt_len = ( record_len + sizeof ( *inner ) +
+				suite->mac_len );
 		if ( is_block_cipher ( cipher ) ) {
 			pad_len = ( ( ( cipher->blocksize - 1 ) &
 				      -( encrypt_len + 1 ) ) + 1 );
@@ -3161,11 +5020,32 @@ static int tls_send_record ( struct tls_connection *tls, unsigned int type,
 
 		/* Add record header */
 		tlshdr = iob_put ( iobuf, sizeof ( *tlshdr ) );
-		tlshdr->type = type;
-		tlshdr->version = htons ( tls->version );
+		tlshdr->type = ( protected ? TLS_TYPE_DATA : type );
+		tlshdr->version = htons ( version );
 		tlshdr->length = htons ( sizeof ( iv.rec ) + encrypt_len +
 					 cipher->authsize );
 
+		/* Construct and process authentication data */
+		authhdr.seq = cpu_to_be64 ( tls->tx.seq );
+		authhdr.header.type = type;
+		authhdr.header.version = htons ( version );
+		authhdr.header.length = htons ( record_len );
+		if ( suite->mac_len ) {
+			tls_hmac ( cipherspec, &authhdr, plaintext, record_len,
+				   mac );
+		}
+		if ( protected ) {
+			aad = tlshdr;
+			aad_len = sizeof ( *tlshdr );
+		} else {
+			aad = &authhdr;
+			aad_len = sizeof ( authhdr );
+		}
+		if ( is_auth_cipher ( cipher ) ) {
+			cipher_encrypt ( cipher, cipherspec->cipher_ctx,
+					 aad, NULL, aad_len );
+		}
+
 		/* Add record initialisation vector, if applicable */
 		memcpy ( iob_put ( iobuf, sizeof ( iv.rec ) ), iv.rec,
 			 sizeof ( iv.rec ) );
@@ -3180,6 +5060,10 @@ static int tls_send_record ( struct tls_connection *tls, unsigned int type,
 			encrypt = plaintext;
 		}
 
+		/* Add inner content type, if applicable */
+		inner = iob_put ( iobuf, sizeof ( *inner ) );
+		memset ( inner, type, sizeof ( *inner ) );
+
 		/* Add MAC, if applicable */
 		memcpy ( iob_put ( iobuf, suite->mac_len ), mac,
 			 suite->mac_len );
@@ -3215,6 +5099,7 @@ static int tls_send_record ( struct tls_connection *tls, unsigned int type,
 
  err_deliver:
  err_random:
+ err_coalesced:
 	free_iob ( iobuf );
 	return rc;
 }
@@ -3301,18 +5186,29 @@ static int tls_new_ciphertext ( struct tls_connection *tls,
 		uint8_t fixed[suite->fixed_iv_len];
 		uint8_t record[suite->record_iv_len];
 	} __attribute__ (( packed )) iv;
+	int protected = tls13_protected ( tls, cipherspec );
 	struct tls_auth_header authhdr;
 	uint8_t verify_mac[digest->digestsize];
 	uint8_t verify_auth[cipher->authsize];
 	struct io_buffer *first;
 	struct io_buffer *last;
 	struct io_buffer *iobuf;
+	unsigned int type;
+	const void *aad;
+	uint8_t *inner;
 	void *mac;
 	void *auth;
 	size_t check_len;
+	size_t aad_len;
 	int pad_len;
 	int rc;
 
+	/* Process TLSv1.3 plaintext Change Cipher records as-is */
+	if ( ( tlshdr->type == TLS_TYPE_CHANGE_CIPHER ) &&
+	     tls_version ( tls, TLS_VERSION_TLS_1_3 ) ) {
+		return tls_new_record ( tls, tlshdr->type, rx_data );
+	}
+
 	/* Locate first and last data buffers */
 	assert ( ! list_empty ( rx_data ) );
 	first = list_first_entry ( rx_data, struct io_buffer, list );
@@ -3325,6 +5221,7 @@ static int tls_new_ciphertext ( struct tls_connection *tls,
 		return -EINVAL_IV;
 	}
 	memcpy ( iv.fixed, cipherspec->fixed_iv, sizeof ( iv.fixed ) );
+	tls_implicit_iv ( cipherspec, iv.fixed, tls->rx.seq );
 	memcpy ( iv.record, first->data, sizeof ( iv.record ) );
 	iob_pull ( first, sizeof ( iv.record ) );
 	len -= sizeof ( iv.record );
@@ -3345,14 +5242,21 @@ static int tls_new_ciphertext ( struct tls_connection *tls,
 	authhdr.header.type = tlshdr->type;
 	authhdr.header.version = tlshdr->version;
 	authhdr.header.length = htons ( len );
+	if ( protected ) {
+		aad = tlshdr;
+		aad_len = sizeof ( *tlshdr );
+	} else {
+		aad = &authhdr;
+		aad_len = sizeof ( authhdr );
+	}
 
 	/* Set initialisation vector */
 	cipher_setiv ( cipher, cipherspec->cipher_ctx, &iv, sizeof ( iv ) );
 
 	/* Process authentication data, if applicable */
 	if ( is_auth_cipher ( cipher ) ) {
-		cipher_decrypt ( cipher, cipherspec->cipher_ctx, &authhdr,
-				 NULL, sizeof ( authhdr ) );
+		cipher_decrypt ( cipher, cipherspec->cipher_ctx, aad,
+				 NULL, aad_len );
 	}
 
 	/* Decrypt the received data */
@@ -3415,8 +5319,33 @@ static int tls_new_ciphertext ( struct tls_connection *tls,
 		return -EINVAL_MAC;
 	}
 
+	/* Extract inner content type (following any zero padding),
+	 * if applicable.
+	 */
+	type = tlshdr->type;
+	if ( protected ) {
+		type = 0;
+		list_for_each_entry_reverse ( iobuf, rx_data, list ) {
+			while ( iob_len ( iobuf ) && ( ! type ) ) {
+				inner = ( iobuf->tail - 1 );
+				type = *inner;
+				iob_unput ( iobuf, sizeof ( *inner ) );
+			}
+			if ( type )
+				break;
+		}
+		if ( ! type ) {
+			DBGC ( tls, "TLS %p received record with no content "
+			       "type\n", tls );
+			return -EINVAL_CONTENT_TYPE;
+		}
+	}
+
+	/* Increment RX sequence number */
+	tls->rx.seq += 1;
+
 	/* Process plaintext record */
-	if ( ( rc = tls_new_record ( tls, tlshdr->type, rx_data ) ) != 0 )
+	if ( ( rc = tls_new_record ( tls, type, rx_data ) ) != 0 )
 		return rc;
 
 	return 0;
@@ -3438,12 +5367,23 @@ static int tls_new_ciphertext ( struct tls_connection *tls,
 static size_t tls_plainstream_window ( struct tls_connection *tls ) {
 
 	/* Block window unless we are ready to accept data */
-	if ( ! tls_ready ( tls ) )
+	if ( ! tls_tx_ready ( tls ) )
 		return 0;
 
 	return xfer_window ( &tls->cipherstream );
 }
 
+/**
+ * Get negotiated application protocol
+ *
+ * @v tls		TLS connection
+ * @ret protocol	Negotiated protocol name, or NULL
+ */
+static const char * tls_alpn_protocol ( struct tls_connection *tls ) {
+
+	return ( tls->alpn[0] ? tls->alpn : NULL );
+}
+
 /**
  * Deliver datagram as raw data
  *
@@ -3451,22 +5391,49 @@ static size_t tls_plainstream_window ( struct tls_connection *tls ) {
  * @v iobuf		I/O buffer
  * @v meta		Data transfer metadata
  * @ret rc		Return status code
+ *
+ * Small writes are coalesced into a single record, which will be
+ * transmitted when full or when the transmit process next runs.
  */
 static int tls_plainstream_deliver ( struct tls_connection *tls,
 				     struct io_buffer *iobuf,
 				     struct xfer_metadata *meta __unused ) {
+	size_t len = iob_len ( iobuf );
 	int rc;
 	
 	/* Refuse unless we are ready to accept data */
-	if ( ! tls_ready ( tls ) ) {
+	if ( ! tls_tx_ready ( tls ) ) {
 		rc = -ENOTCONN;
 		goto done;
 	}
 
-	/* Send data record */
-	if ( ( rc = tls_send_record ( tls, TLS_TYPE_DATA,
-				      iob_disown ( iobuf ) ) ) != 0 )
+	/* Send any coalesced data if this data will not fit */
+	if ( tls->tx.coalesce &&
+	     ( ( iob_len ( tls->tx.coalesce ) + len ) > TLS_TX_BUFSIZE ) &&
+	     ( ( rc = tls_send_coalesced ( tls ) ) != 0 ) ) {
+		goto done;
+	}
+
+	/* Send large writes immediately */
+	if ( len >= TLS_TX_BUFSIZE ) {
+		rc = tls_send_record ( tls, TLS_TYPE_DATA,
+				       iob_disown ( iobuf ) );
 		goto done;
+	}
+
+	/* Allocate coalescing buffer, if applicable */
+	if ( ! tls->tx.coalesce ) {
+		tls->tx.coalesce = tls_alloc_iob ( tls, TLS_TX_BUFSIZE );
+		if ( ! tls->tx.coalesce ) {
+			rc = -ENOMEM_TX_COALESCE;
+			goto done;
+		}
+	}
+
+	/* Coalesce data, and schedule transmission */
+	memcpy ( iob_put ( tls->tx.coalesce, len ), iobuf->data, len );
+	tls_tx_resume ( tls );
+	rc = 0;
 
  done:
 	free_iob ( iobuf );
@@ -3499,6 +5466,7 @@ static struct interface_operation tls_plainstream_ops[] = {
 	INTF_OP ( xfer_window, struct tls_connection *,
 		  tls_plainstream_window ),
 	INTF_OP ( job_progress, struct tls_connection *, tls_progress ),
+	INTF_OP ( alpn_protocol, struct tls_connection *, tls_alpn_protocol ),
 	INTF_OP ( intf_close, struct tls_connection *, tls_close ),
 };
 
@@ -3523,78 +5491,163 @@ static struct interface_descriptor tls_plainstream_desc =
 static int tls_newdata_process_header ( struct tls_connection *tls ) {
 	struct tls_cipherspec *cipherspec = &tls->rx.cipherspec.active;
 	struct cipher_algorithm *cipher = cipherspec->suite->cipher;
-	size_t iv_len = cipherspec->suite->record_iv_len;
-	size_t data_len = ntohs ( tls->rx.header.length );
-	size_t remaining = data_len;
-	size_t frag_len;
-	size_t reserve;
-	struct io_buffer *iobuf;
-	struct io_buffer *tmp;
-	int rc;
 
 	/* Sanity check */
 	assert ( ( TLS_RX_BUFSIZE % cipher->alignsize ) == 0 );
 
-	/* Calculate alignment reservation at start of first data buffer */
-	reserve = ( ( -iv_len ) & ( cipher->alignsize - 1 ) );
-	remaining += reserve;
-
-	/* Allocate data buffers now that we know the length */
+	/* Data buffers will be assigned as the record data arrives */
 	assert ( list_empty ( &tls->rx.data ) );
-	while ( remaining ) {
+	tls->rx.remaining = ntohs ( tls->rx.header.length );
+	tls->rx.fill = NULL;
+	tls->rx.carry = 0;
 
-		/* Calculate fragment length.  Ensure that no block is
-		 * smaller than TLS_RX_MIN_BUFSIZE (by increasing the
-		 * allocation length if necessary).
-		 */
+	/* Move to data state */
+	tls->rx.state = TLS_RX_DATA;
+
+	return 0;
+}
+
+/**
+ * Allocate data buffer for received ciphertext
+ *
+ * @v tls		TLS connection
+ * @ret iobuf		I/O buffer, or NULL on allocation failure
+ */
+static struct io_buffer * tls_newdata_alloc ( struct tls_connection *tls ) {
+	struct tls_cipherspec *cipherspec = &tls->rx.cipherspec.active;
+	struct cipher_algorithm *cipher = cipherspec->suite->cipher;
+	size_t iv_len = cipherspec->suite->record_iv_len;
+	size_t offset = ( ntohs ( tls->rx.header.length ) - tls->rx.remaining );
+	size_t remaining = tls->rx.remaining;
+	size_t frag_len;
+	struct io_buffer *iobuf;
+
+	/* Calculate fragment length.  Ensure that each non-final
+	 * buffer ends at a multiple of the cipher alignment size
+	 * after stripping the record IV, and that no buffer is
+	 * smaller than TLS_RX_MIN_BUFSIZE (by increasing the
+	 * allocation length if necessary).
+	 */
+	frag_len = remaining;
+	if ( frag_len > TLS_RX_BUFSIZE ) {
+		frag_len = ( TLS_RX_BUFSIZE - ( ( offset - iv_len ) &
+						( cipher->alignsize - 1 ) ) );
+	}
+	if ( ( remaining - frag_len ) < TLS_RX_MIN_BUFSIZE )
 		frag_len = remaining;
-		if ( frag_len > TLS_RX_BUFSIZE )
-			frag_len = TLS_RX_BUFSIZE;
-		remaining -= frag_len;
-		if ( remaining < TLS_RX_MIN_BUFSIZE ) {
-			frag_len += remaining;
-			remaining = 0;
-		}
-
-		/* Allocate buffer */
-		iobuf = alloc_iob_raw ( frag_len, TLS_RX_ALIGN, 0 );
-		if ( ! iobuf ) {
-			DBGC ( tls, "TLS %p could not allocate %zd of %zd "
-			       "bytes for receive buffer\n", tls,
-			       remaining, data_len );
-			rc = -ENOMEM_RX_DATA;
-			goto err;
-		}
 
-		/* Ensure tailroom is exactly what we asked for.  This
-		 * will result in unaligned I/O buffers when the
-		 * fragment length is unaligned, which can happen only
-		 * before we switch to using a block cipher.
-		 */
-		iob_reserve ( iobuf, ( iob_tailroom ( iobuf ) - frag_len ) );
+	/* Allocate buffer */
+	iobuf = alloc_iob_raw ( frag_len, TLS_RX_ALIGN, 0 );
+	if ( ! iobuf ) {
+		DBGC ( tls, "TLS %p could not allocate %zd of %zd bytes for "
+		       "receive buffer\n", tls, frag_len,
+		       ( size_t ) ntohs ( tls->rx.header.length ) );
+		return NULL;
+	}
 
-		/* Ensure first buffer length will be aligned to a
-		 * multiple of the cipher alignment size after
-		 * stripping the record IV.
-		 */
-		iob_reserve ( iobuf, reserve );
-		reserve = 0;
+	/* Ensure tailroom is exactly what we asked for.  This will
+	 * result in unaligned I/O buffers when the fragment length is
+	 * unaligned, which can happen only before we switch to using
+	 * a block cipher.
+	 */
+	iob_reserve ( iobuf, ( iob_tailroom ( iobuf ) - frag_len ) );
+
+	/* Add I/O buffer to list */
+	list_add_tail ( &iobuf->list, &tls->rx.data );
+	tls->rx.remaining -= frag_len;
+
+	return iobuf;
+}
 
-		/* Add I/O buffer to list */
-		list_add_tail ( &iobuf->list, &tls->rx.data );
+/**
+ * Check if received ciphertext may be used directly as a data buffer
+ *
+ * @v tls		TLS connection
+ * @v iobuf		I/O buffer
+ * @ret len		Length that may be used directly, or zero
+ *
+ * Decryption takes place in situ, and so an I/O buffer containing
+ * only record data may be added directly to the list of data buffers
+ * without being copied, provided that this does not violate any of
+ * the constraints on data buffer lengths.  Any excess data beyond an
+ * aligned boundary must be carried over into the next data buffer.
+ */
+static size_t tls_newdata_adoptable ( struct tls_connection *tls,
+				      struct io_buffer *iobuf ) {
+	struct tls_cipherspec *cipherspec = &tls->rx.cipherspec.active;
+	struct cipher_algorithm *cipher = cipherspec->suite->cipher;
+	size_t iv_len = cipherspec->suite->record_iv_len;
+	size_t offset = ( ntohs ( tls->rx.header.length ) - tls->rx.remaining );
+	size_t len = iob_len ( iobuf );
+	size_t excess;
+
+	/* Cannot use while another data buffer is partially filled */
+	if ( tls->rx.fill )
+		return 0;
+
+	/* Must not extend beyond the end of the record */
+	if ( len > tls->rx.remaining )
+		return 0;
+
+	/* Final data buffer must be large enough to contain the MAC
+	 * and padding.
+	 */
+	if ( len == tls->rx.remaining ) {
+		if ( ( offset == 0 ) || ( len >= TLS_RX_MIN_BUFSIZE ) )
+			return len;
+		return 0;
 	}
 
-	/* Move to data state */
-	tls->rx.state = TLS_RX_DATA;
+	/* Non-final data buffers must end at a multiple of the cipher
+	 * alignment size after stripping the record IV.
+	 */
+	excess = ( ( offset + len - iv_len ) & ( cipher->alignsize - 1 ) );
+	if ( ( excess >= len ) ||
+	     ( ( tls->rx.remaining - len + excess ) < TLS_RX_MIN_BUFSIZE ) )
+		return 0;
+	len -= excess;
 
-	return 0;
+	/* First data buffer must contain the whole record IV */
+	if ( ( offset == 0 ) && ( len < iv_len ) )
+		return 0;
 
- err:
-	list_for_each_entry_safe ( iobuf, tmp, &tls->rx.data, list ) {
-		list_del ( &iobuf->list );
-		free_iob ( iobuf );
+	return len;
+}
+
+/**
+ * Carry over excess data from the final data buffer
+ *
+ * @v tls		TLS connection
+ * @v iobuf		Received I/O buffer
+ * @ret rc		Return status code
+ *
+ * The excess data is prepended to the received I/O buffer if there
+ * is sufficient headroom, otherwise it is copied into a newly
+ * allocated data buffer.
+ */
+static int tls_newdata_carry ( struct tls_connection *tls,
+			       struct io_buffer *iobuf ) {
+	struct io_buffer *last;
+	size_t carry = tls->rx.carry;
+
+	/* Locate excess data */
+	last = list_last_entry ( &tls->rx.data, struct io_buffer, list );
+	assert ( last != NULL );
+	assert ( iob_tailroom ( last ) >= carry );
+
+	/* Prepend to received data or copy to new data buffer */
+	if ( iob_headroom ( iobuf ) >= carry ) {
+		memcpy ( iob_push ( iobuf, carry ), last->tail, carry );
+	} else {
+		assert ( tls->rx.fill == NULL );
+		tls->rx.fill = tls_newdata_alloc ( tls );
+		if ( ! tls->rx.fill )
+			return -ENOMEM_RX_DATA;
+		memcpy ( iob_put ( tls->rx.fill, carry ), last->tail, carry );
 	}
-	return rc;
+	tls->rx.carry = 0;
+
+	return 0;
 }
 
 /**
@@ -3604,17 +5657,13 @@ static int tls_newdata_process_header ( struct tls_connection *tls ) {
  * @ret rc		Returned status code
  */
 static int tls_newdata_process_data ( struct tls_connection *tls ) {
-	struct io_buffer *iobuf;
 	int rc;
 
-	/* Move current buffer to end of list */
-	iobuf = list_first_entry ( &tls->rx.data, struct io_buffer, list );
-	list_del ( &iobuf->list );
-	list_add_tail ( &iobuf->list, &tls->rx.data );
+	/* Current data buffer (if any) is now full */
+	tls->rx.fill = NULL;
 
-	/* Continue receiving data if any space remains */
-	iobuf = list_first_entry ( &tls->rx.data, struct io_buffer, list );
-	if ( iob_tailroom ( iobuf ) )
+	/* Continue receiving data if any of the record remains */
+	if ( tls->rx.remaining )
 		return 0;
 
 	/* Process record */
@@ -3622,9 +5671,6 @@ static int tls_newdata_process_data ( struct tls_connection *tls ) {
 					 &tls->rx.data ) ) != 0 )
 		return rc;
 
-	/* Increment RX sequence number */
-	tls->rx.seq += 1;
-
 	/* Return to header state */
 	assert ( list_empty ( &tls->rx.data ) );
 	tls->rx.state = TLS_RX_HEADER;
@@ -3660,6 +5706,7 @@ static int tls_cipherstream_deliver ( struct tls_connection *tls,
 				      struct io_buffer *iobuf,
 				      struct xfer_metadata *xfer __unused ) {
 	size_t frag_len;
+	size_t len;
 	int ( * process ) ( struct tls_connection *tls );
 	struct io_buffer *dest;
 	int rc;
@@ -3673,9 +5720,38 @@ static int tls_cipherstream_deliver ( struct tls_connection *tls,
 			process = tls_newdata_process_header;
 			break;
 		case TLS_RX_DATA:
-			dest = list_first_entry ( &tls->rx.data,
-						  struct io_buffer, list );
-			assert ( dest != NULL );
+
+			/* Carry over any excess data */
+			if ( tls->rx.carry &&
+			     ( ( rc = tls_newdata_carry ( tls,
+							  iobuf ) ) != 0 ) ) {
+				tls_close ( tls, rc );
+				goto done;
+			}
+
+			/* Use received buffer directly, if possible */
+			len = tls_newdata_adoptable ( tls, iobuf );
+			if ( len ) {
+				tls->rx.carry = ( iob_len ( iobuf ) - len );
+				iob_unput ( iobuf, tls->rx.carry );
+				list_add_tail ( &iobuf->list, &tls->rx.data );
+				tls->rx.remaining -= len;
+				rc = tls_newdata_process_data ( tls );
+				if ( rc != 0 )
+					tls_close ( tls, rc );
+				return rc;
+			}
+
+			/* Otherwise, copy into a data buffer */
+			if ( ! tls->rx.fill ) {
+				tls->rx.fill = tls_newdata_alloc ( tls );
+				if ( ! tls->rx.fill ) {
+					rc = -ENOMEM_RX_DATA;
+					tls_close ( tls, rc );
+					goto done;
+				}
+			}
+			dest = tls->rx.fill;
 			process = tls_newdata_process_data;
 			break;
 		default:
@@ -3769,9 +5845,15 @@ static void tls_validator_done ( struct tls_connection *tls, int rc ) {
 		 sizeof ( tls->server.key ) );
 
 	/* Schedule transmission of applicable handshake messages */
-	tls->tx.pending |= ( TLS_TX_CLIENT_KEY_EXCHANGE |
-			     TLS_TX_CHANGE_CIPHER |
-			     TLS_TX_FINISHED );
+	if ( tls_version ( tls, TLS_VERSION_TLS_1_3 ) ) {
+		if ( ( rc = tls13_verify_certificate_verify ( tls ) ) != 0 )
+			goto err;
+		tls->tx.pending |= TLS_TX_FINISHED;
+	} else {
+		tls->tx.pending |= ( TLS_TX_CLIENT_KEY_EXCHANGE |
+				     TLS_TX_CHANGE_CIPHER |
+				     TLS_TX_FINISHED );
+	}
 	if ( tls->client.chain ) {
 		tls->tx.pending |= TLS_TX_CERTIFICATE;
 		if ( ! list_empty ( &tls->client.chain->links ) )
@@ -3811,39 +5893,57 @@ static struct interface_descriptor tls_validator_desc =
 static void tls_tx_step ( struct tls_connection *tls ) {
 	struct tls_session *session = tls->session;
 	struct tls_connection *conn;
+	struct tls_named_curve *curve;
 	int rc;
 
+	/* Pre-generate a key share using the most preferred named
+	 * curve (if any) before the Client Hello is due, so that the
+	 * scalar multiplication overlaps with the cipherstream
+	 * connection setup rather than delaying the handshake.
+	 * Failure is not fatal at this point: generation will be
+	 * retried when the Client Hello is sent.
+	 */
+	if ( ( tls->tx.pending & TLS_TX_CLIENT_HELLO ) &&
+	     tls_version ( tls, TLS_VERSION_TLS_1_3 ) &&
+	     TLS_NUM_NAMED_CURVES && ( ! tls->client.curve ) ) {
+		curve = table_start ( TLS_NAMED_CURVES );
+		tls13_generate_key_share ( tls, curve );
+	}
+
 	/* Wait for cipherstream to become ready */
 	if ( ! xfer_window ( &tls->cipherstream ) )
 		return;
 
+	/* Send any coalesced data */
+	if ( ( rc = tls_send_coalesced ( tls ) ) != 0 ) {
+		DBGC ( tls, "TLS %p could not send data: %s\n",
+		       tls, strerror ( rc ) );
+		goto err;
+	}
+
 	/* Send first pending transmission */
 	if ( tls->tx.pending & TLS_TX_CLIENT_HELLO ) {
-		/* Serialise server negotiations within a session, to
-		 * provide a consistent view of session IDs and
-		 * session tickets.
+		/* Serialise server negotiations within a session
+		 * until the first handshake has completed, to allow
+		 * subsequent connections to resume the session.
+		 * Once the session is established, connections may
+		 * resume in parallel.
 		 */
-		list_for_each_entry ( conn, &session->conn, list ) {
-			if ( conn == tls )
-				break;
-			if ( is_pending ( &conn->server.negotiation ) )
-				return;
-		}
-		/* Record or generate session ID and associated master secret */
-		if ( session->id_len ) {
-			/* Attempt to resume an existing session */
-			memcpy ( tls->session_id, session->id,
-				 sizeof ( tls->session_id ) );
-			tls->session_id_len = session->id_len;
-			memcpy ( tls->master_secret, session->master_secret,
-				 sizeof ( tls->master_secret ) );
-		} else {
-			/* No existing session: use a random session ID */
-			assert ( sizeof ( tls->session_id ) ==
-				 sizeof ( tls->client.random ) );
-			memcpy ( tls->session_id, &tls->client.random,
-				 sizeof ( tls->session_id ) );
-			tls->session_id_len = sizeof ( tls->session_id );
+		if ( ! session->established ) {
+			list_for_each_entry ( conn, &session->conn, list ) {
+				if ( conn == tls )
+					break;
+				if ( is_pending ( &conn->server.negotiation ) )
+					return;
+			}
+		}
+		/* Record session ID and session ticket */
+		if ( tls->hello_retry ) {
+			/* Retain session state from initial Client Hello */
+		} else if ( ( rc = tls_resume_session ( tls ) ) != 0 ) {
+			DBGC ( tls, "TLS %p could not resume session: %s\n",
+			       tls, strerror ( rc ) );
+			goto err;
 		}
 		/* Send Client Hello */
 		if ( ( rc = tls_send_client_hello ( tls ) ) != 0 ) {
@@ -3852,6 +5952,10 @@ static void tls_tx_step ( struct tls_connection *tls ) {
 			goto err;
 		}
 		tls->tx.pending &= ~TLS_TX_CLIENT_HELLO;
+	} else if ( tls_version ( tls, TLS_VERSION_TLS_1_3 ) &&
+		    is_pending ( &tls->server.negotiation ) ) {
+		/* Wait for server Finished before completing handshake */
+		return;
 	} else if ( tls->tx.pending & TLS_TX_CERTIFICATE ) {
 		/* Send Certificate */
 		if ( ( rc = tls_send_certificate ( tls ) ) != 0 ) {
@@ -3899,6 +6003,14 @@ static void tls_tx_step ( struct tls_connection *tls ) {
 			goto err;
 		}
 		tls->tx.pending &= ~TLS_TX_FINISHED;
+	} else if ( tls->tx.pending & TLS_TX_KEY_UPDATE ) {
+		/* Send Key Update, and then update the keys in use */
+		if ( ( rc = tls_send_key_update ( tls ) ) != 0 ) {
+			DBGC ( tls, "TLS %p could not send Key Update: %s\n",
+			       tls, strerror ( rc ) );
+			goto err;
+		}
+		tls->tx.pending &= ~TLS_TX_KEY_UPDATE;
 	}
 
 	/* Reschedule process if pending transmissions remain,
@@ -3945,6 +6057,7 @@ static int tls_session ( struct tls_connection *tls, const char *name ) {
 		     ( tls->server.root == session->root ) &&
 		     ( tls->client.key == session->key ) ) {
 			ref_get ( &session->refcnt );
+			stop_timer ( &session->timer );
 			tls->session = session;
 			DBGC ( tls, "TLS %p joining session %s\n", tls, name );
 			return 0;
@@ -3965,6 +6078,7 @@ static int tls_session ( struct tls_connection *tls, const char *name ) {
 	session->root = x509_root_get ( tls->server.root );
 	session->key = privkey_get ( tls->client.key );
 	INIT_LIST_HEAD ( &session->conn );
+	timer_init ( &session->timer, tls_session_expired, &session->refcnt );
 	list_add ( &session->list, &tls_sessions );
 
 	/* Record session */
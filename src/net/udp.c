@@ -181,9 +181,8 @@ static int udp_tx ( struct udp_connection *udp, struct io_buffer *iobuf,
 	size_t len;
 	int rc;
 
-	/* Check we can accommodate the header */
-	if ( ( rc = iob_ensure_headroom ( iobuf,
-					  MAX_LL_NET_HEADER_LEN ) ) != 0 ) {
+	/* Check we can accommodate the headers */
+	if ( ( rc = iob_ensure_headroom ( iobuf, UDP_MAX_HLEN ) ) != 0 ) {
 		free_iob ( iobuf );
 		return rc;
 	}
@@ -196,12 +195,11 @@ static int udp_tx ( struct udp_connection *udp, struct io_buffer *iobuf,
 
 	/* Add the UDP header */
 	udphdr = iob_push ( iobuf, sizeof ( *udphdr ) );
-	len = iob_len ( iobuf );
+	len = iob_total_len ( iobuf );
 	udphdr->dest = dest->st_port;
 	udphdr->src = src->st_port;
 	udphdr->len = htons ( len );
-	udphdr->chksum = 0;
-	udphdr->chksum = tcpip_chksum ( udphdr, len );
+	tcpip_defer_chksum ( iobuf, sizeof ( *udphdr ), &udphdr->chksum );
 
 	/* Dump debugging information */
 	DBGC2 ( udp, "UDP %p TX %d->%d len %d\n", udp,
@@ -286,7 +284,7 @@ static int udp_rx ( struct io_buffer *iobuf,
 		rc = -EINVAL;
 		goto done;
 	}
-	if ( udphdr->chksum ) {
+	if ( udphdr->chksum && ! ( iobuf->flags & IOB_CSUM_VALID ) ) {
 		csum = tcpip_continue_chksum ( pshdr_csum, iobuf->data, ulen );
 		if ( csum != 0 ) {
 			DBG ( "UDP checksum incorrect (is %04x including "
@@ -351,13 +349,13 @@ static struct io_buffer * udp_xfer_alloc_iob ( struct udp_connection *udp,
 					       size_t len ) {
 	struct io_buffer *iobuf;
 
-	iobuf = alloc_iob ( MAX_LL_NET_HEADER_LEN + len );
+	iobuf = alloc_iob ( UDP_MAX_HLEN + len );
 	if ( ! iobuf ) {
 		DBGC ( udp, "UDP %p cannot allocate buffer of length %zd\n",
 		       udp, len );
 		return NULL;
 	}
-	iob_reserve ( iobuf, MAX_LL_NET_HEADER_LEN );
+	iob_reserve ( iobuf, UDP_MAX_HLEN );
 	return iobuf;
 }
 
@@ -379,10 +377,31 @@ static int udp_xfer_deliver ( struct udp_connection *udp,
 			meta->netdev );
 }
 
+/**
+ * Check flow control window
+ *
+ * @v udp		UDP connection
+ * @ret len		Length of window
+ *
+ * The window is reported as the largest datagram payload that can be
+ * transmitted to the peer without fragmentation, if known.
+ */
+static size_t udp_xfer_window ( struct udp_connection *udp ) {
+	size_t mtu;
+
+	/* Use path MTU, if a route to the peer exists */
+	mtu = tcpip_mtu ( &udp->peer );
+	if ( mtu <= sizeof ( struct udp_header ) )
+		return ~( ( size_t ) 0 );
+
+	return ( mtu - sizeof ( struct udp_header ) );
+}
+
 /** UDP data transfer interface operations */
 static struct interface_operation udp_xfer_operations[] = {
 	INTF_OP ( xfer_deliver, struct udp_connection *, udp_xfer_deliver ),
 	INTF_OP ( xfer_alloc_iob, struct udp_connection *, udp_xfer_alloc_iob ),
+	INTF_OP ( xfer_window, struct udp_connection *, udp_xfer_window ),
 	INTF_OP ( intf_close, struct udp_connection *, udp_close ),
 };
 
@@ -0,0 +1,770 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <byteswap.h>
+#include <ipxe/iobuf.h>
+#include <ipxe/bitmap.h>
+#include <ipxe/list.h>
+#include <ipxe/xfer.h>
+#include <ipxe/open.h>
+#include <ipxe/uri.h>
+#include <ipxe/tcpip.h>
+#include <ipxe/timer.h>
+#include <ipxe/retry.h>
+#include <ipxe/umalloc.h>
+#include <ipxe/rsfec.h>
+#include <ipxe/alc.h>
+
+/** @file
+ *
+ * Asynchronous Layered Coding (ALC) protocol
+ *
+ * This is a receive-only implementation of ALC (RFC 5775) using the
+ * Reed-Solomon over GF(2^8) FEC scheme (RFC 5510).  A single
+ * transport object is received from a multicast group: source
+ * symbols are written directly into the data transfer buffer as they
+ * arrive (in any order), and any source symbols that are lost are
+ * reconstructed from repair symbols once sufficient symbols for a
+ * source block have been received.  No packets are ever transmitted
+ * by the receiver, so a single transmission can serve an arbitrary
+ * number of clients.
+ *
+ * The object to be received is specified using a URI of the form
+ *
+ *     x-alc://<multicast address>[:<port>]/[<toi>]
+ *
+ * If no transport object identifier is specified, the first object
+ * seen (other than a FLUTE file delivery table) will be received.
+ *
+ */
+
+/** Receive timeout
+ *
+ * The download is abandoned if no usable packets are received within
+ * this time.
+ */
+#define ALC_TIMEOUT ( 10 * TICKS_PER_SEC )
+
+/** Maximum number of partially received source blocks
+ *
+ * Each partially received source block requires a buffer large
+ * enough to hold the whole source block.  If this limit is reached,
+ * the least recently started source block will be discarded; its
+ * symbols will be collected again on the next carousel pass.
+ */
+#define ALC_MAX_BLOCKS 16
+
+/** A partially received source block */
+struct alc_block {
+	/** List of partially received source blocks */
+	struct list_head list;
+	/** Source block number */
+	unsigned int sbn;
+	/** Number of source symbols */
+	unsigned int k;
+	/** Number of received encoding symbols */
+	unsigned int count;
+	/** Received encoding symbol bitmap */
+	uint8_t present[ ( RSFEC_MAX_N + 7 ) / 8 ];
+	/** Received encoding symbol IDs */
+	uint8_t esi[RSFEC_MAX_N];
+	/** Received encoding symbols */
+	void *symbols[RSFEC_MAX_N];
+	/** Encoding symbol data */
+	void *data;
+};
+
+/** An ALC request */
+struct alc_request {
+	/** Reference counter */
+	struct refcnt refcnt;
+	/** Data transfer interface */
+	struct interface xfer;
+	/** Multicast socket */
+	struct interface socket;
+	/** Receive timeout timer */
+	struct retry_timer timer;
+
+	/** Request flags */
+	unsigned int flags;
+	/** Transport session identifier */
+	uint64_t tsi;
+	/** Transport object identifier */
+	uint64_t toi;
+
+	/** Transfer length */
+	size_t len;
+	/** Encoding symbol length */
+	size_t symlen;
+	/** Maximum source block length */
+	unsigned int max_k;
+	/** Maximum number of encoding symbols */
+	unsigned int max_n;
+	/** Number of source blocks */
+	unsigned int num_blocks;
+	/** Number of larger source blocks */
+	unsigned int num_large;
+	/** Length of larger source blocks */
+	unsigned int large_k;
+	/** Length of smaller source blocks */
+	unsigned int small_k;
+
+	/** Completed source block bitmap */
+	struct bitmap bitmap;
+	/** Partially received source blocks */
+	struct list_head blocks;
+	/** Number of partially received source blocks */
+	unsigned int num_partial;
+};
+
+/** ALC request flags */
+enum {
+	/** Transport session identifier is known */
+	ALC_FL_TSI = 0x0001,
+	/** Transport object identifier is known */
+	ALC_FL_TOI = 0x0002,
+	/** Object transmission information is known */
+	ALC_FL_FTI = 0x0004,
+};
+
+/**
+ * Free partially received source block
+ *
+ * @v alc		ALC request
+ * @v block		Source block
+ */
+static void alc_free_block ( struct alc_request *alc,
+			     struct alc_block *block ) {
+
+	list_del ( &block->list );
+	alc->num_partial--;
+	ufree ( block->data );
+	free ( block );
+}
+
+/**
+ * Free ALC request
+ *
+ * @v refcnt		Reference counter
+ */
+static void alc_free ( struct refcnt *refcnt ) {
+	struct alc_request *alc =
+		container_of ( refcnt, struct alc_request, refcnt );
+	struct alc_block *block;
+	struct alc_block *tmp;
+
+	list_for_each_entry_safe ( block, tmp, &alc->blocks, list )
+		alc_free_block ( alc, block );
+	bitmap_free ( &alc->bitmap );
+	free ( alc );
+}
+
+/**
+ * Mark ALC request as complete
+ *
+ * @v alc		ALC request
+ * @v rc		Return status code
+ */
+static void alc_finished ( struct alc_request *alc, int rc ) {
+	struct alc_block *block;
+	struct alc_block *tmp;
+
+	DBGC ( alc, "ALC %p finished with status code %d (%s)\n",
+	       alc, rc, strerror ( rc ) );
+
+	/* Stop the timer */
+	stop_timer ( &alc->timer );
+
+	/* Discard any partially received source blocks */
+	list_for_each_entry_safe ( block, tmp, &alc->blocks, list )
+		alc_free_block ( alc, block );
+
+	/* Close all data transfer interfaces */
+	intf_shutdown ( &alc->socket, rc );
+	intf_shutdown ( &alc->xfer, rc );
+}
+
+/**
+ * Handle receive timeout
+ *
+ * @v timer		Receive timeout timer
+ * @v fail		Failure indicator
+ */
+static void alc_timer_expired ( struct retry_timer *timer, int fail __unused ){
+	struct alc_request *alc =
+		container_of ( timer, struct alc_request, timer );
+
+	DBGC ( alc, "ALC %p timed out\n", alc );
+	alc_finished ( alc, -ETIMEDOUT );
+}
+
+/**
+ * Calculate number of source symbols in a source block
+ *
+ * @v alc		ALC request
+ * @v sbn		Source block number
+ * @ret k		Number of source symbols
+ */
+static unsigned int alc_block_k ( struct alc_request *alc, unsigned int sbn ) {
+
+	return ( ( sbn < alc->num_large ) ? alc->large_k : alc->small_k );
+}
+
+/**
+ * Calculate offset of a source symbol within the transport object
+ *
+ * @v alc		ALC request
+ * @v sbn		Source block number
+ * @v esi		Encoding symbol ID
+ * @ret offset		Offset within transport object
+ */
+static size_t alc_offset ( struct alc_request *alc, unsigned int sbn,
+			   unsigned int esi ) {
+	size_t symbol;
+
+	if ( sbn < alc->num_large ) {
+		symbol = ( sbn * alc->large_k );
+	} else {
+		symbol = ( ( alc->num_large * alc->large_k ) +
+			   ( ( sbn - alc->num_large ) * alc->small_k ) );
+	}
+	return ( ( symbol + esi ) * alc->symlen );
+}
+
+/**
+ * Deliver source symbol
+ *
+ * @v alc		ALC request
+ * @v sbn		Source block number
+ * @v esi		Encoding symbol ID
+ * @v iobuf		I/O buffer, or NULL
+ * @v data		Symbol data (if no I/O buffer is provided)
+ * @ret rc		Return status code
+ */
+static int alc_deliver ( struct alc_request *alc, unsigned int sbn,
+			 unsigned int esi, struct io_buffer *iobuf,
+			 const void *data ) {
+	struct xfer_metadata meta;
+	size_t offset;
+	size_t len;
+
+	/* Calculate offset and length, truncating the final symbol */
+	offset = alc_offset ( alc, sbn, esi );
+	len = ( alc->len - offset );
+	if ( len > alc->symlen )
+		len = alc->symlen;
+
+	/* Deliver symbol */
+	memset ( &meta, 0, sizeof ( meta ) );
+	meta.flags = XFER_FL_ABS_OFFSET;
+	meta.offset = offset;
+	if ( iobuf ) {
+		if ( iob_len ( iobuf ) > len )
+			iob_unput ( iobuf, ( iob_len ( iobuf ) - len ) );
+		return xfer_deliver ( &alc->xfer, iobuf, &meta );
+	} else {
+		return xfer_deliver_raw_meta ( &alc->xfer, data, len, &meta );
+	}
+}
+
+/**
+ * Complete source block
+ *
+ * @v alc		ALC request
+ * @v block		Source block
+ * @ret rc		Return status code
+ */
+static int alc_complete ( struct alc_request *alc, struct alc_block *block ) {
+	uint8_t present[ sizeof ( block->present ) ];
+	unsigned int i;
+	int rc;
+
+	/* Reconstruct any missing source symbols */
+	memcpy ( present, block->present, sizeof ( present ) );
+	if ( ( rc = rsfec_decode ( block->k, block->esi, block->symbols,
+				   alc->symlen ) ) != 0 ) {
+		DBGC ( alc, "ALC %p could not decode block %d: %s\n",
+		       alc, block->sbn, strerror ( rc ) );
+		return rc;
+	}
+
+	/* Deliver reconstructed source symbols */
+	for ( i = 0 ; i < block->k ; i++ ) {
+		if ( present[ i / 8 ] & ( 1 << ( i % 8 ) ) )
+			continue;
+		DBGC2 ( alc, "ALC %p reconstructed block %d symbol %d\n",
+			alc, block->sbn, i );
+		if ( ( rc = alc_deliver ( alc, block->sbn, i, NULL,
+					  block->symbols[i] ) ) != 0 )
+			return rc;
+	}
+
+	/* Mark block as complete */
+	bitmap_set ( &alc->bitmap, block->sbn );
+	alc_free_block ( alc, block );
+
+	return 0;
+}
+
+/**
+ * Find or create partially received source block
+ *
+ * @v alc		ALC request
+ * @v sbn		Source block number
+ * @ret block		Source block, or NULL
+ */
+static struct alc_block * alc_block ( struct alc_request *alc,
+				      unsigned int sbn ) {
+	struct alc_block *block;
+
+	/* Find existing block, if any */
+	list_for_each_entry ( block, &alc->blocks, list ) {
+		if ( block->sbn == sbn )
+			return block;
+	}
+
+	/* Discard least recently started block, if applicable */
+	if ( alc->num_partial >= ALC_MAX_BLOCKS ) {
+		block = list_last_entry ( &alc->blocks, struct alc_block,
+					  list );
+		DBGC ( alc, "ALC %p discarding partial block %d\n",
+		       alc, block->sbn );
+		alc_free_block ( alc, block );
+	}
+
+	/* Create new block */
+	block = zalloc ( sizeof ( *block ) );
+	if ( ! block )
+		return NULL;
+	block->sbn = sbn;
+	block->k = alc_block_k ( alc, sbn );
+	block->data = umalloc ( block->k * alc->symlen );
+	if ( ! block->data ) {
+		free ( block );
+		return NULL;
+	}
+	list_add ( &block->list, &alc->blocks );
+	alc->num_partial++;
+
+	return block;
+}
+
+/**
+ * Receive encoding symbol
+ *
+ * @v alc		ALC request
+ * @v sbn		Source block number
+ * @v esi		Encoding symbol ID
+ * @v iobuf		I/O buffer
+ * @ret rc		Return status code
+ */
+static int alc_rx_symbol ( struct alc_request *alc, unsigned int sbn,
+			   unsigned int esi, struct io_buffer *iobuf ) {
+	struct alc_block *block;
+	unsigned int k;
+	size_t len = iob_len ( iobuf );
+	void *symbol;
+	int rc;
+
+	/* Ignore symbols for completed or nonexistent blocks */
+	if ( ( sbn >= alc->num_blocks ) ||
+	     bitmap_test ( &alc->bitmap, sbn ) ) {
+		rc = 0;
+		goto discard;
+	}
+
+	/* Sanity check */
+	k = alc_block_k ( alc, sbn );
+	if ( ( esi >= ( ( k * alc->max_n ) / alc->max_k ) ) ||
+	     ( len > alc->symlen ) ) {
+		DBGC ( alc, "ALC %p invalid block %d symbol %d length %zd\n",
+		       alc, sbn, esi, len );
+		rc = -EINVAL;
+		goto discard;
+	}
+
+	/* Find source block */
+	block = alc_block ( alc, sbn );
+	if ( ! block ) {
+		rc = -ENOMEM;
+		goto discard;
+	}
+
+	/* Ignore duplicate symbols */
+	if ( block->present[ esi / 8 ] & ( 1 << ( esi % 8 ) ) ) {
+		rc = 0;
+		goto discard;
+	}
+
+	/* Record symbol, padding with zeros if necessary */
+	symbol = ( block->data + ( block->count * alc->symlen ) );
+	memcpy ( symbol, iobuf->data, len );
+	memset ( ( symbol + len ), 0, ( alc->symlen - len ) );
+	block->present[ esi / 8 ] |= ( 1 << ( esi % 8 ) );
+	block->esi[block->count] = esi;
+	block->symbols[block->count] = symbol;
+	block->count++;
+
+	/* Deliver source symbols immediately */
+	if ( esi < k ) {
+		if ( ( rc = alc_deliver ( alc, sbn, esi, iob_disown ( iobuf ),
+					  NULL ) ) != 0 )
+			return rc;
+	} else {
+		free_iob ( iobuf );
+	}
+
+	/* Complete block once sufficient symbols have been received */
+	if ( block->count == k ) {
+		if ( ( rc = alc_complete ( alc, block ) ) != 0 )
+			return rc;
+	}
+
+	/* Finish when all blocks are complete */
+	if ( bitmap_full ( &alc->bitmap ) )
+		alc_finished ( alc, 0 );
+
+	return 0;
+
+ discard:
+	free_iob ( iobuf );
+	return rc;
+}
+
+/**
+ * Process object transmission information
+ *
+ * @v alc		ALC request
+ * @v fti		Object transmission information
+ * @ret rc		Return status code
+ */
+static int alc_rx_fti ( struct alc_request *alc,
+			const struct alc_rs8_fti *fti ) {
+	unsigned long long len;
+	unsigned long num_symbols;
+	unsigned long num_blocks;
+	int rc;
+
+	/* Parse transfer parameters */
+	len = ( ( ( ( unsigned long long ) ntohs ( fti->len_high ) ) << 32 ) |
+		ntohl ( fti->len_low ) );
+	alc->symlen = ntohs ( fti->symlen );
+	alc->max_k = fti->max_k;
+	alc->max_n = fti->max_n;
+	if ( ( len == 0 ) || ( len != ( ( size_t ) len ) ) ||
+	     ( alc->symlen == 0 ) || ( alc->max_k == 0 ) ||
+	     ( alc->max_n < alc->max_k ) || ( alc->max_n > RSFEC_MAX_N ) ) {
+		DBGC ( alc, "ALC %p invalid FTI length %lld symbol length "
+		       "%zd B %d max_n %d\n", alc, len, alc->symlen,
+		       alc->max_k, alc->max_n );
+		return -EINVAL;
+	}
+	alc->len = len;
+
+	/* Partition object into source blocks as per RFC 5052 */
+	num_symbols = ( ( alc->len + alc->symlen - 1 ) / alc->symlen );
+	num_blocks = ( ( num_symbols + alc->max_k - 1 ) / alc->max_k );
+	if ( num_blocks > ALC_RS8_SBN ( 0xffffffffUL ) ) {
+		DBGC ( alc, "ALC %p too many source blocks (%ld)\n",
+		       alc, num_blocks );
+		return -EINVAL;
+	}
+	alc->num_blocks = num_blocks;
+	alc->large_k = ( ( num_symbols + num_blocks - 1 ) / num_blocks );
+	alc->small_k = ( num_symbols / num_blocks );
+	alc->num_large = ( num_symbols - ( alc->small_k * num_blocks ) );
+	DBGC ( alc, "ALC %p length %zd symbol length %zd blocks %d (%d x %d, "
+	       "%d x %d) max_n %d\n", alc, alc->len, alc->symlen,
+	       alc->num_blocks, alc->num_large, alc->large_k,
+	       ( alc->num_blocks - alc->num_large ), alc->small_k,
+	       alc->max_n );
+
+	/* Allocate completed block bitmap */
+	if ( ( rc = bitmap_resize ( &alc->bitmap, alc->num_blocks ) ) != 0 ) {
+		DBGC ( alc, "ALC %p could not allocate bitmap: %s\n",
+		       alc, strerror ( rc ) );
+		return rc;
+	}
+
+	/* Notify recipient of file size */
+	xfer_seek ( &alc->xfer, alc->len );
+	xfer_seek ( &alc->xfer, 0 );
+
+	alc->flags |= ALC_FL_FTI;
+	return 0;
+}
+
+/**
+ * Read variable-length LCT identifier
+ *
+ * @v data		Identifier
+ * @v len		Length of identifier
+ * @ret id		Identifier value
+ */
+static uint64_t alc_identifier ( const uint8_t *data, size_t len ) {
+	uint64_t id = 0;
+
+	while ( len-- )
+		id = ( ( id << 8 ) | *(data++) );
+	return id;
+}
+
+/**
+ * Receive ALC packet
+ *
+ * @v alc		ALC request
+ * @v iobuf		I/O buffer
+ * @v meta		Data transfer metadata
+ * @ret rc		Return status code
+ */
+static int alc_socket_deliver ( struct alc_request *alc,
+				struct io_buffer *iobuf,
+				struct xfer_metadata *meta __unused ) {
+	const struct lct_header *lct = iobuf->data;
+	const struct alc_rs8_payload_id *payload_id;
+	const uint8_t *ext;
+	const uint8_t *end;
+	const uint8_t *pos;
+	uint32_t sbn_esi;
+	uint64_t tsi;
+	uint64_t toi;
+	size_t tsi_len;
+	size_t toi_len;
+	size_t hdr_len;
+	size_t ext_len;
+	int rc;
+
+	/* Parse LCT header */
+	if ( ( iob_len ( iobuf ) < sizeof ( *lct ) ) ||
+	     ( LCT_VERSION_NUM ( lct->version ) != LCT_VERSION ) ) {
+		DBGC ( alc, "ALC %p received malformed packet\n", alc );
+		rc = -EINVAL;
+		goto discard;
+	}
+	hdr_len = ( 4 * lct->len );
+	tsi_len = LCT_TSI_LEN ( lct->flags );
+	toi_len = LCT_TOI_LEN ( lct->flags );
+	pos = ( iobuf->data + sizeof ( *lct ) +
+		LCT_CCI_LEN ( lct->version ) );
+	end = ( iobuf->data + hdr_len );
+	if ( ( hdr_len > iob_len ( iobuf ) ) ||
+	     ( toi_len > sizeof ( toi ) ) ||
+	     ( ( pos + tsi_len + toi_len ) > end ) ) {
+		DBGC ( alc, "ALC %p received malformed LCT header\n", alc );
+		rc = -EINVAL;
+		goto discard;
+	}
+	tsi = alc_identifier ( pos, tsi_len );
+	pos += tsi_len;
+	toi = alc_identifier ( pos, toi_len );
+	pos += toi_len;
+
+	/* Ignore unsupported FEC schemes */
+	if ( lct->codepoint != ALC_FEC_RS8 ) {
+		DBGC ( alc, "ALC %p ignoring unsupported codepoint %d\n",
+		       alc, lct->codepoint );
+		rc = -ENOTSUP;
+		goto discard;
+	}
+
+	/* Ignore file delivery tables and unwanted objects */
+	if ( ( toi == 0 ) ||
+	     ( ( alc->flags & ALC_FL_TSI ) && ( tsi != alc->tsi ) ) ||
+	     ( ( alc->flags & ALC_FL_TOI ) && ( toi != alc->toi ) ) ) {
+		rc = 0;
+		goto discard;
+	}
+	if ( ! ( alc->flags & ALC_FL_TSI ) ) {
+		DBGC ( alc, "ALC %p receiving TSI %#llx TOI %#llx\n",
+		       alc, ( ( unsigned long long ) tsi ),
+		       ( ( unsigned long long ) toi ) );
+	}
+	alc->tsi = tsi;
+	alc->toi = toi;
+	alc->flags |= ( ALC_FL_TSI | ALC_FL_TOI );
+
+	/* Parse header extensions */
+	for ( ext = pos ; ext < end ; ext += ext_len ) {
+		ext_len = ( ( ext[0] >= LCT_HET_FIXED ) ? 4 :
+			    ( ( ( ext + 1 ) < end ) ? ( 4 * ext[1] ) : 0 ) );
+		if ( ( ext_len == 0 ) || ( ( ext + ext_len ) > end ) ) {
+			DBGC ( alc, "ALC %p received malformed header "
+			       "extension\n", alc );
+			rc = -EINVAL;
+			goto discard;
+		}
+		if ( ( ext[0] == ALC_EXT_FTI ) &&
+		     ( ext_len >= sizeof ( struct alc_rs8_fti ) ) &&
+		     ! ( alc->flags & ALC_FL_FTI ) ) {
+			if ( ( rc = alc_rx_fti ( alc, ( const void * ) ext ) )
+			     != 0 )
+				goto discard;
+		}
+	}
+
+	/* Wait until object transmission information is known */
+	if ( ! ( alc->flags & ALC_FL_FTI ) ) {
+		rc = 0;
+		goto discard;
+	}
+
+	/* Parse FEC payload ID */
+	iob_pull ( iobuf, hdr_len );
+	payload_id = iobuf->data;
+	if ( iob_len ( iobuf ) < sizeof ( *payload_id ) ) {
+		DBGC ( alc, "ALC %p received underlength packet\n", alc );
+		rc = -EINVAL;
+		goto discard;
+	}
+	sbn_esi = ntohl ( payload_id->sbn_esi );
+	iob_pull ( iobuf, sizeof ( *payload_id ) );
+
+	/* Restart receive timeout timer */
+	stop_timer ( &alc->timer );
+	start_timer_fixed ( &alc->timer, ALC_TIMEOUT );
+
+	/* Process encoding symbol */
+	if ( ( rc = alc_rx_symbol ( alc, ALC_RS8_SBN ( sbn_esi ),
+				    ALC_RS8_ESI ( sbn_esi ),
+				    iob_disown ( iobuf ) ) ) != 0 ) {
+		/* Invalid symbols are ignored; any other error
+		 * (e.g. a failure to deliver data) is fatal.
+		 */
+		if ( rc != -EINVAL )
+			alc_finished ( alc, rc );
+		return rc;
+	}
+
+	return 0;
+
+ discard:
+	free_iob ( iobuf );
+	return rc;
+}
+
+/** ALC multicast socket interface operations */
+static struct interface_operation alc_socket_operations[] = {
+	INTF_OP ( xfer_deliver, struct alc_request *, alc_socket_deliver ),
+	INTF_OP ( intf_close, struct alc_request *, alc_finished ),
+};
+
+/** ALC multicast socket interface descriptor */
+static struct interface_descriptor alc_socket_desc =
+	INTF_DESC ( struct alc_request, socket, alc_socket_operations );
+
+/** ALC data transfer interface operations */
+static struct interface_operation alc_xfer_operations[] = {
+	INTF_OP ( intf_close, struct alc_request *, alc_finished ),
+};
+
+/** ALC data transfer interface descriptor */
+static struct interface_descriptor alc_xfer_desc =
+	INTF_DESC ( struct alc_request, xfer, alc_xfer_operations );
+
+/**
+ * Initiate an ALC request
+ *
+ * @v xfer		Data transfer interface
+ * @v uri		Uniform Resource Identifier
+ * @ret rc		Return status code
+ */
+static int alc_open ( struct interface *xfer, struct uri *uri ) {
+	struct alc_request *alc;
+	struct sockaddr_tcpip multicast;
+	const char *path;
+	char *end;
+	int rc;
+
+	/* Sanity checks */
+	if ( ! uri->host )
+		return -EINVAL;
+
+	/* Allocate and populate structure */
+	alc = zalloc ( sizeof ( *alc ) );
+	if ( ! alc )
+		return -ENOMEM;
+	ref_init ( &alc->refcnt, alc_free );
+	intf_init ( &alc->xfer, &alc_xfer_desc, &alc->refcnt );
+	intf_init ( &alc->socket, &alc_socket_desc, &alc->refcnt );
+	timer_init ( &alc->timer, alc_timer_expired, &alc->refcnt );
+	INIT_LIST_HEAD ( &alc->blocks );
+
+	/* Parse transport object identifier, if present */
+	path = uri->path;
+	if ( path && ( *path == '/' ) )
+		path++;
+	if ( path && *path ) {
+		alc->toi = strtoull ( path, &end, 0 );
+		if ( *end || ( alc->toi == 0 ) ) {
+			DBGC ( alc, "ALC %p invalid TOI \"%s\"\n", alc, path );
+			rc = -EINVAL;
+			goto err;
+		}
+		alc->flags |= ALC_FL_TOI;
+	}
+
+	/* Parse multicast address */
+	memset ( &multicast, 0, sizeof ( multicast ) );
+	if ( sock_aton ( uri->host, ( ( struct sockaddr * ) &multicast ) )
+	     == 0 ) {
+		DBGC ( alc, "ALC %p invalid multicast address \"%s\"\n",
+		       alc, uri->host );
+		rc = -EINVAL;
+		goto err;
+	}
+	multicast.st_port = htons ( uri_port ( uri, ALC_DEFAULT_PORT ) );
+
+	/* Open multicast socket */
+	if ( ( rc = xfer_open_socket ( &alc->socket, SOCK_DGRAM,
+				 ( struct sockaddr * ) &multicast,
+				 ( struct sockaddr * ) &multicast ) ) != 0 ) {
+		DBGC ( alc, "ALC %p could not open multicast socket: %s\n",
+		       alc, strerror ( rc ) );
+		goto err;
+	}
+
+	/* Start receive timeout timer */
+	start_timer_fixed ( &alc->timer, ALC_TIMEOUT );
+
+	/* Attach to parent interface, mortalise self, and return */
+	intf_plug_plug ( &alc->xfer, xfer );
+	ref_put ( &alc->refcnt );
+	return 0;
+
+ err:
+	alc_finished ( alc, rc );
+	ref_put ( &alc->refcnt );
+	return rc;
+}
+
+/** ALC URI opener */
+struct uri_opener alc_uri_opener __uri_opener = {
+	.scheme	= "x-alc",
+	.open	= alc_open,
+};
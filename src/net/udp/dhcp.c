@@ -49,6 +49,8 @@ FILE_SECBOOT ( PERMITTED );
 #include <ipxe/dhcppkt.h>
 #include <ipxe/dhcparch.h>
 #include <ipxe/features.h>
+#include <ipxe/cachedhcp.h>
+#include <ipxe/trace.h>
 #include <config/dhcp.h>
 
 /** @file
@@ -194,8 +196,10 @@ struct dhcp_session_state {
 
 static struct dhcp_session_state dhcp_state_discover;
 static struct dhcp_session_state dhcp_state_request;
+static struct dhcp_session_state dhcp_state_proxydisc;
 static struct dhcp_session_state dhcp_state_proxy;
 static struct dhcp_session_state dhcp_state_pxebs;
+static struct dhcp_session_state dhcp_state_cached;
 
 /** A DHCP session */
 struct dhcp_session {
@@ -244,6 +248,8 @@ struct dhcp_session {
 	unsigned int count;
 	/** Start time of the current state (in ticks) */
 	unsigned long start;
+	/** Start time of DHCP discovery (in ticks) */
+	unsigned long discovery;
 };
 
 /**
@@ -268,6 +274,9 @@ static void dhcp_free ( struct refcnt *refcnt ) {
  */
 static void dhcp_finished ( struct dhcp_session *dhcp, int rc ) {
 
+	/* Record trace event */
+	trace ( "dhcp", "finished", dhcp, rc );
+
 	/* Stop retry timer */
 	stop_timer ( &dhcp->timer );
 
@@ -286,8 +295,11 @@ static void dhcp_set_state ( struct dhcp_session *dhcp,
 			     struct dhcp_session_state *state ) {
 
 	DBGC ( dhcp, "DHCP %p entering %s state\n", dhcp, state->name );
+	trace ( "dhcp", state->name, dhcp, 0 );
 	dhcp->state = state;
 	dhcp->start = currticks();
+	if ( state == &dhcp_state_discover )
+		dhcp->discovery = dhcp->start;
 	stop_timer ( &dhcp->timer );
 	set_timer_limits ( &dhcp->timer,
 			   ( state->min_timeout_sec * TICKS_PER_SEC ),
@@ -318,12 +330,165 @@ static int dhcp_has_pxeopts ( struct dhcp_packet *dhcppkt ) {
 	return 0;
 }
 
+/**
+ * Check if DHCP packet contains the "PXEClient" vendor class
+ *
+ * @v dhcppkt		DHCP packet
+ * @ret has_pxeclient	DHCP packet contains "PXEClient" vendor class
+ */
+static int dhcp_has_pxeclient ( struct dhcp_packet *dhcppkt ) {
+	char vci[9]; /* "PXEClient" */
+	int vci_len;
+
+	vci_len = dhcppkt_fetch ( dhcppkt, DHCP_VENDOR_CLASS_ID,
+				  vci, sizeof ( vci ) );
+	return ( ( vci_len >= ( int ) sizeof ( vci ) ) &&
+		 ( strncmp ( "PXEClient", vci, sizeof ( vci ) ) == 0 ) );
+}
+
+/**
+ * Select ProxyDHCP offer, if applicable
+ *
+ * @v dhcp		DHCP session
+ * @v dhcppkt		DHCP packet
+ * @v pseudo_id		DHCP server pseudo-ID
+ * @v priority		DHCP offer priority
+ */
+static void dhcp_select_proxy ( struct dhcp_session *dhcp,
+				struct dhcp_packet *dhcppkt,
+				struct in_addr pseudo_id, int priority ) {
+
+	/* Select as ProxyDHCP offer, if applicable */
+	if ( pseudo_id.s_addr && dhcp_has_pxeclient ( dhcppkt ) &&
+	     ( priority >= dhcp->proxy_priority ) ) {
+		dhcppkt_put ( dhcp->proxy_offer );
+		dhcp->proxy_server = pseudo_id;
+		dhcp->proxy_offer = dhcppkt_get ( dhcppkt );
+		dhcp->proxy_priority = priority;
+	}
+}
+
+/**
+ * Continue to ProxyDHCP, if applicable
+ *
+ * @v dhcp		DHCP session
+ */
+static void dhcp_proxy_continue ( struct dhcp_session *dhcp ) {
+	struct settings *settings;
+	int rc;
+
+	/* Perform ProxyDHCP if applicable */
+	if ( dhcp->proxy_offer /* Have ProxyDHCP offer */ &&
+	     ( ! dhcp->no_pxedhcp ) /* ProxyDHCP not disabled */ ) {
+		if ( dhcp_has_pxeopts ( dhcp->proxy_offer ) ) {
+			/* PXE options already present; register settings
+			 * without performing a ProxyDHCPREQUEST
+			 */
+			settings = &dhcp->proxy_offer->settings;
+			if ( ( rc = register_settings ( settings, NULL,
+					   PROXYDHCP_SETTINGS_NAME ) ) != 0 ) {
+				DBGC ( dhcp, "DHCP %p could not register "
+				       "proxy settings: %s\n",
+				       dhcp, strerror ( rc ) );
+				dhcp_finished ( dhcp, rc );
+				return;
+			}
+		} else {
+			/* PXE options not present; use a ProxyDHCPREQUEST */
+			dhcp_set_state ( dhcp, &dhcp_state_proxy );
+			return;
+		}
+	}
+
+	/* Terminate DHCP */
+	dhcp_finished ( dhcp, 0 );
+}
+
+/**
+ * Handle acquisition of DHCP lease
+ *
+ * @v dhcp		DHCP session
+ * @v dhcppkt		DHCP acknowledgement packet
+ */
+static void dhcp_leased ( struct dhcp_session *dhcp,
+			  struct dhcp_packet *dhcppkt ) {
+	struct settings *parent;
+	struct settings *settings;
+	unsigned long elapsed;
+	int rc;
+
+	/* Record assigned address */
+	dhcp->local.sin_addr = dhcp->offer;
+
+	/* Register settings */
+	parent = netdev_settings ( dhcp->netdev );
+	settings = &dhcppkt->settings;
+	if ( ( rc = register_settings ( settings, parent,
+					DHCP_SETTINGS_NAME ) ) != 0 ) {
+		DBGC ( dhcp, "DHCP %p could not register settings: %s\n",
+		       dhcp, strerror ( rc ) );
+		dhcp_finished ( dhcp, rc );
+		return;
+	}
+
+	/* Unregister any existing ProxyDHCP or PXEBS settings */
+	if ( ( settings = find_settings ( PROXYDHCP_SETTINGS_NAME ) ) != NULL )
+		unregister_settings ( settings );
+	if ( ( settings = find_settings ( PXEBS_SETTINGS_NAME ) ) != NULL )
+		unregister_settings ( settings );
+
+	/* Continue waiting for ProxyDHCP offers, if applicable.  The
+	 * ProxyDHCP wait runs alongside the lease exchange, rather
+	 * than delaying it, and so only whatever remains of the wait
+	 * is spent here.
+	 */
+	elapsed = ( currticks() - dhcp->discovery );
+	if ( ! ( dhcp->no_pxedhcp || dhcp->proxy_offer ||
+		 ( elapsed > DHCP_DISC_PROXY_TIMEOUT_SEC * TICKS_PER_SEC ) ) ) {
+		dhcp_set_state ( dhcp, &dhcp_state_proxydisc );
+		return;
+	}
+
+	/* Perform ProxyDHCP if applicable */
+	dhcp_proxy_continue ( dhcp );
+}
+
 /****************************************************************************
  *
  * DHCP state machine
  *
  */
 
+/**
+ * Check if DHCP discovery is complete
+ *
+ * @v dhcp		DHCP session
+ * @ret is_complete	DHCP discovery is complete
+ *
+ * We can exit the discovery state when we have a valid DHCPOFFER,
+ * and either:
+ *
+ *  o  The DHCPOFFER instructs us to ignore ProxyDHCPOFFERs, or
+ *  o  We have a valid ProxyDHCPOFFER, or
+ *  o  The DHCPOFFER has the maximum possible priority, or
+ *  o  We have allowed sufficient time for ProxyDHCPOFFERs.
+ *
+ * A DHCPOFFER with the maximum possible priority cannot be displaced
+ * by any later DHCPOFFER.  Any ProxyDHCPOFFERs that have not yet
+ * arrived will continue to be collected during the DHCPREQUEST.
+ */
+static int dhcp_discovery_complete ( struct dhcp_session *dhcp ) {
+	unsigned long elapsed = ( currticks() - dhcp->start );
+
+	/* If we don't yet have a DHCPOFFER, we are not complete */
+	if ( ! dhcp->offer.s_addr )
+		return 0;
+
+	return ( dhcp->no_pxedhcp || dhcp->proxy_offer ||
+		 ( dhcp->priority >= DHCP_EB_PRIORITY_MAX ) ||
+		 ( elapsed > DHCP_DISC_PROXY_TIMEOUT_SEC * TICKS_PER_SEC ) );
+}
+
 /**
  * Construct transmitted packet for DHCP discovery
  *
@@ -332,11 +497,26 @@ static int dhcp_has_pxeopts ( struct dhcp_packet *dhcppkt ) {
  * @v peer		Destination address
  */
 static int dhcp_discovery_tx ( struct dhcp_session *dhcp,
-			       struct dhcp_packet *dhcppkt __unused,
+			       struct dhcp_packet *dhcppkt,
 			       struct sockaddr_in *peer ) {
+	struct dhcp_options *options = &dhcppkt->options;
+	uint8_t *end;
 
 	DBGC ( dhcp, "DHCP %p DHCPDISCOVER\n", dhcp );
 
+	/* Request Rapid Commit.  This option has no data, and so
+	 * cannot be constructed using dhcppkt_store(); insert it
+	 * directly before the end marker.
+	 */
+	if ( ( options->used_len + 2 ) > options->alloc_len )
+		return -ENOSPC;
+	end = ( options->data + options->used_len - 1 );
+	assert ( *end == DHCP_END );
+	end[0] = DHCP_RAPID_COMMIT;
+	end[1] = 0;
+	end[2] = DHCP_END;
+	options->used_len += 2;
+
 	/* Set server address */
 	peer->sin_addr.s_addr = INADDR_BROADCAST;
 	peer->sin_port = htons ( BOOTPS_PORT );
@@ -360,12 +540,9 @@ static void dhcp_discovery_rx ( struct dhcp_session *dhcp,
 				struct in_addr server_id,
 				struct in_addr pseudo_id ) {
 	struct in_addr ip;
-	char vci[9]; /* "PXEClient" */
-	int vci_len;
-	int has_pxeclient;
 	int8_t priority = 0;
 	uint8_t no_pxedhcp = 0;
-	unsigned long elapsed;
+	int rapid_commit;
 
 	DBGC ( dhcp, "DHCP %p %s from %s:%d", dhcp,
 	       dhcp_msgtype_name ( msgtype ), inet_ntoa ( peer->sin_addr ),
@@ -382,11 +559,7 @@ static void dhcp_discovery_rx ( struct dhcp_session *dhcp,
 		DBGC ( dhcp, " for %s", inet_ntoa ( ip ) );
 
 	/* Identify "PXEClient" vendor class */
-	vci_len = dhcppkt_fetch ( dhcppkt, DHCP_VENDOR_CLASS_ID,
-				  vci, sizeof ( vci ) );
-	has_pxeclient = ( ( vci_len >= ( int ) sizeof ( vci ) ) &&
-			  ( strncmp ( "PXEClient", vci, sizeof (vci) ) == 0 ));
-	if ( has_pxeclient ) {
+	if ( dhcp_has_pxeclient ( dhcppkt ) ) {
 		DBGC ( dhcp, "%s",
 		       ( dhcp_has_pxeopts ( dhcppkt ) ? " pxe" : " proxy" ) );
 	}
@@ -402,44 +575,45 @@ static void dhcp_discovery_rx ( struct dhcp_session *dhcp,
 			sizeof ( no_pxedhcp ) );
 	if ( no_pxedhcp )
 		DBGC ( dhcp, " nopxe" );
+
+	/* Identify Rapid Commit */
+	rapid_commit = ( ( msgtype == DHCPACK ) &&
+			 ( dhcppkt_fetch ( dhcppkt, DHCP_RAPID_COMMIT,
+					   NULL, 0 ) >= 0 ) );
+	if ( rapid_commit )
+		DBGC ( dhcp, " rapid" );
 	DBGC ( dhcp, "\n" );
 
 	/* Select as DHCP offer, if applicable */
 	if ( ip.s_addr && ( peer->sin_port == htons ( BOOTPS_PORT ) ) &&
-	     ( ( msgtype == DHCPOFFER ) || ( ! msgtype /* BOOTP */ ) ) &&
+	     ( ( msgtype == DHCPOFFER ) || ( ! msgtype /* BOOTP */ ) ||
+	       rapid_commit ) &&
 	     ( priority >= dhcp->priority ) ) {
 		dhcp->offer = ip;
 		dhcp->server = server_id;
 		dhcp->priority = priority;
 		dhcp->no_pxedhcp = no_pxedhcp;
+	} else {
+		rapid_commit = 0;
 	}
 
 	/* Select as ProxyDHCP offer, if applicable */
-	if ( pseudo_id.s_addr && has_pxeclient &&
-	     ( priority >= dhcp->proxy_priority ) ) {
-		dhcppkt_put ( dhcp->proxy_offer );
-		dhcp->proxy_server = pseudo_id;
-		dhcp->proxy_offer = dhcppkt_get ( dhcppkt );
-		dhcp->proxy_priority = priority;
-	}
-
-	/* We can exit the discovery state when we have a valid
-	 * DHCPOFFER, and either:
-	 *
-	 *  o  The DHCPOFFER instructs us to ignore ProxyDHCPOFFERs, or
-	 *  o  We have a valid ProxyDHCPOFFER, or
-	 *  o  We have allowed sufficient time for ProxyDHCPOFFERs.
-	 */
+	dhcp_select_proxy ( dhcp, dhcppkt, pseudo_id, priority );
 
-	/* If we don't yet have a DHCPOFFER, do nothing */
-	if ( ! dhcp->offer.s_addr )
+	/* If we can't yet exit the discovery state, do nothing */
+	if ( ! dhcp_discovery_complete ( dhcp ) )
 		return;
 
-	/* If we can't yet transition to DHCPREQUEST, do nothing */
-	elapsed = ( currticks() - dhcp->start );
-	if ( ! ( dhcp->no_pxedhcp || dhcp->proxy_offer ||
-		 ( elapsed > DHCP_DISC_PROXY_TIMEOUT_SEC * TICKS_PER_SEC ) ) )
+	/* A Rapid Commit acknowledgement completes the lease without
+	 * a DHCPREQUEST (as per RFC 4039).  A Rapid Commit
+	 * acknowledgement received while we are still collecting
+	 * offers is treated as an ordinary DHCPOFFER, and will be
+	 * confirmed via a DHCPREQUEST if it remains selected.
+	 */
+	if ( rapid_commit ) {
+		dhcp_leased ( dhcp, dhcppkt );
 		return;
+	}
 
 	/* Transition to DHCPREQUEST */
 	dhcp_set_state ( dhcp, &dhcp_state_request );
@@ -471,11 +645,9 @@ static void dhcp_defer ( struct dhcp_session *dhcp ) {
  * @v dhcp		DHCP session
  */
 static void dhcp_discovery_expired ( struct dhcp_session *dhcp ) {
-	unsigned long elapsed = ( currticks() - dhcp->start );
 
 	/* Give up waiting for ProxyDHCP before we reach the failure point */
-	if ( dhcp->offer.s_addr &&
-	     ( elapsed > DHCP_DISC_PROXY_TIMEOUT_SEC * TICKS_PER_SEC ) ) {
+	if ( dhcp_discovery_complete ( dhcp ) ) {
 		dhcp_set_state ( dhcp, &dhcp_state_request );
 		return;
 	}
@@ -550,9 +722,7 @@ static void dhcp_request_rx ( struct dhcp_session *dhcp,
 			      struct in_addr server_id,
 			      struct in_addr pseudo_id ) {
 	struct in_addr ip;
-	struct settings *parent;
-	struct settings *settings;
-	int rc;
+	int8_t priority = 0;
 
 	DBGC ( dhcp, "DHCP %p %s from %s:%d", dhcp,
 	       dhcp_msgtype_name ( msgtype ), inet_ntoa ( peer->sin_addr ),
@@ -569,6 +739,14 @@ static void dhcp_request_rx ( struct dhcp_session *dhcp,
 		DBGC ( dhcp, " for %s", inet_ntoa ( ip ) );
 	DBGC ( dhcp, "\n" );
 
+	/* Collect any late ProxyDHCP offers */
+	if ( msgtype == DHCPOFFER ) {
+		dhcppkt_fetch ( dhcppkt, DHCP_EB_PRIORITY, &priority,
+				sizeof ( priority ) );
+		dhcp_select_proxy ( dhcp, dhcppkt, pseudo_id, priority );
+		return;
+	}
+
 	/* Filter out invalid port */
 	if ( peer->sin_port != htons ( BOOTPS_PORT ) )
 		return;
@@ -589,51 +767,8 @@ static void dhcp_request_rx ( struct dhcp_session *dhcp,
 	if ( ip.s_addr != dhcp->offer.s_addr )
 		return;
 
-	/* Record assigned address */
-	dhcp->local.sin_addr = ip;
-
-	/* Register settings */
-	parent = netdev_settings ( dhcp->netdev );
-	settings = &dhcppkt->settings;
-	if ( ( rc = register_settings ( settings, parent,
-					DHCP_SETTINGS_NAME ) ) != 0 ) {
-		DBGC ( dhcp, "DHCP %p could not register settings: %s\n",
-		       dhcp, strerror ( rc ) );
-		dhcp_finished ( dhcp, rc );
-		return;
-	}
-
-	/* Unregister any existing ProxyDHCP or PXEBS settings */
-	if ( ( settings = find_settings ( PROXYDHCP_SETTINGS_NAME ) ) != NULL )
-		unregister_settings ( settings );
-	if ( ( settings = find_settings ( PXEBS_SETTINGS_NAME ) ) != NULL )
-		unregister_settings ( settings );
-
-	/* Perform ProxyDHCP if applicable */
-	if ( dhcp->proxy_offer /* Have ProxyDHCP offer */ &&
-	     ( ! dhcp->no_pxedhcp ) /* ProxyDHCP not disabled */ ) {
-		if ( dhcp_has_pxeopts ( dhcp->proxy_offer ) ) {
-			/* PXE options already present; register settings
-			 * without performing a ProxyDHCPREQUEST
-			 */
-			settings = &dhcp->proxy_offer->settings;
-			if ( ( rc = register_settings ( settings, NULL,
-					   PROXYDHCP_SETTINGS_NAME ) ) != 0 ) {
-				DBGC ( dhcp, "DHCP %p could not register "
-				       "proxy settings: %s\n",
-				       dhcp, strerror ( rc ) );
-				dhcp_finished ( dhcp, rc );
-				return;
-			}
-		} else {
-			/* PXE options not present; use a ProxyDHCPREQUEST */
-			dhcp_set_state ( dhcp, &dhcp_state_proxy );
-			return;
-		}
-	}
-
-	/* Terminate DHCP */
-	dhcp_finished ( dhcp, 0 );
+	/* Handle lease */
+	dhcp_leased ( dhcp, dhcppkt );
 }
 
 /**
@@ -658,6 +793,74 @@ static struct dhcp_session_state dhcp_state_request = {
 	.max_timeout_sec	= DHCP_REQ_END_TIMEOUT_SEC,
 };
 
+/**
+ * Handle received packet while awaiting ProxyDHCP offers
+ *
+ * @v dhcp		DHCP session
+ * @v dhcppkt		DHCP packet
+ * @v peer		DHCP server address
+ * @v msgtype		DHCP message type
+ * @v server_id		DHCP server ID
+ * @v pseudo_id		DHCP server pseudo-ID
+ */
+static void dhcp_proxydisc_rx ( struct dhcp_session *dhcp,
+				struct dhcp_packet *dhcppkt,
+				struct sockaddr_in *peer, uint8_t msgtype,
+				struct in_addr server_id __unused,
+				struct in_addr pseudo_id ) {
+	int8_t priority = 0;
+
+	DBGC ( dhcp, "DHCP %p %s from %s:%d\n", dhcp,
+	       dhcp_msgtype_name ( msgtype ), inet_ntoa ( peer->sin_addr ),
+	       ntohs ( peer->sin_port ) );
+
+	/* Filter out unacceptable responses */
+	if ( msgtype != DHCPOFFER )
+		return;
+
+	/* Select as ProxyDHCP offer, if applicable */
+	dhcppkt_fetch ( dhcppkt, DHCP_EB_PRIORITY, &priority,
+			sizeof ( priority ) );
+	dhcp_select_proxy ( dhcp, dhcppkt, pseudo_id, priority );
+	if ( ! dhcp->proxy_offer )
+		return;
+
+	/* Perform ProxyDHCP */
+	dhcp_proxy_continue ( dhcp );
+}
+
+/**
+ * Handle timer expiry while awaiting ProxyDHCP offers
+ *
+ * @v dhcp		DHCP session
+ */
+static void dhcp_proxydisc_expired ( struct dhcp_session *dhcp ) {
+	unsigned long elapsed = ( currticks() - dhcp->discovery );
+	unsigned long timeout = ( DHCP_DISC_PROXY_TIMEOUT_SEC * TICKS_PER_SEC );
+
+	/* Give up waiting for ProxyDHCP */
+	if ( elapsed > timeout ) {
+		dhcp_finished ( dhcp, 0 );
+		return;
+	}
+
+	/* Wait for remainder of ProxyDHCP timeout */
+	start_timer_fixed ( &dhcp->timer, ( timeout - elapsed + 1 ) );
+}
+
+/** ProxyDHCP discovery state operations
+ *
+ * No packets are transmitted in this state: ProxyDHCP offers are
+ * responses to the DHCPDISCOVER already sent.
+ */
+static struct dhcp_session_state dhcp_state_proxydisc = {
+	.name			= "ProxyDHCP discovery",
+	.rx			= dhcp_proxydisc_rx,
+	.expired		= dhcp_proxydisc_expired,
+	.min_timeout_sec	= DHCP_DISC_START_TIMEOUT_SEC,
+	.max_timeout_sec	= DHCP_DISC_END_TIMEOUT_SEC,
+};
+
 /**
  * Construct transmitted packet for ProxyDHCP request
  *
@@ -920,6 +1123,29 @@ static struct dhcp_session_state dhcp_state_pxebs = {
 	.max_timeout_sec	= PXEBS_END_TIMEOUT_SEC,
 };
 
+/**
+ * Handle timer expiry during cached lease
+ *
+ * @v dhcp		DHCP session
+ */
+static void dhcp_cached_expired ( struct dhcp_session *dhcp ) {
+
+	/* Cached DHCPACK is already registered as our settings */
+	DBGC ( dhcp, "DHCP %p using cached lease on %s\n",
+	       dhcp, dhcp->netdev->name );
+	dhcp_finished ( dhcp, 0 );
+}
+
+/** Cached lease state operations
+ *
+ * No socket is opened in this state: the DHCPACK inherited from the
+ * loading PXE stack is still an authoritative lease.
+ */
+static struct dhcp_session_state dhcp_state_cached = {
+	.name			= "cached",
+	.expired		= dhcp_cached_expired,
+};
+
 /****************************************************************************
  *
  * Packet construction
@@ -1344,6 +1570,16 @@ static struct sockaddr dhcp_peer = {
 	.sa_family = AF_INET,
 };
 
+/**
+ * Check if cached DHCPACK is an authoritative lease (when not present)
+ *
+ * @v netdev		Network device
+ * @ret leased		Cached DHCPACK is an authoritative lease
+ */
+__weak int cachedhcp_leased ( struct net_device *netdev __unused ) {
+	return 0;
+}
+
 /**
  * Start DHCP state machine on a network device
  *
@@ -1375,6 +1611,12 @@ int start_dhcp ( struct interface *job, struct net_device *netdev ) {
 	/* Store DHCP transaction ID for fakedhcp code */
 	dhcp_last_xid = dhcp->xid;
 
+	/* Use cached lease, if still authoritative */
+	if ( cachedhcp_leased ( netdev ) ) {
+		dhcp_set_state ( dhcp, &dhcp_state_cached );
+		goto attach;
+	}
+
 	/* Instantiate child objects and attach to our interfaces */
 	if ( ( rc = xfer_open_socket ( &dhcp->xfer, SOCK_DGRAM, &dhcp_peer,
 				  ( struct sockaddr * ) &dhcp->local ) ) != 0 )
@@ -1383,6 +1625,8 @@ int start_dhcp ( struct interface *job, struct net_device *netdev ) {
 	/* Enter DHCPDISCOVER state */
 	dhcp_set_state ( dhcp, &dhcp_state_discover );
 
+ attach:
+
 	/* Attach parent interface, mortalise self, and return */
 	intf_plug_plug ( &dhcp->job, job );
 	ref_put ( &dhcp->refcnt );
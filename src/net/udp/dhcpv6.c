@@ -538,6 +538,8 @@ enum dhcpv6_session_state_flags {
 	DHCPV6_RX_RECORD_SERVER_ID = 0x04,
 	/** Record received IPv6 address */
 	DHCPV6_RX_RECORD_IAADDR = 0x08,
+	/** Request rapid commit (RFC 8415 section 18.2.1) */
+	DHCPV6_TX_RAPID_COMMIT = 0x10,
 };
 
 /** DHCPv6 request state */
@@ -554,7 +556,7 @@ static struct dhcpv6_session_state dhcpv6_solicit = {
 	.tx_type = DHCPV6_SOLICIT,
 	.rx_type = DHCPV6_ADVERTISE,
 	.flags = ( DHCPV6_TX_IA_NA | DHCPV6_RX_RECORD_SERVER_ID |
-		   DHCPV6_RX_RECORD_IAADDR ),
+		   DHCPV6_RX_RECORD_IAADDR | DHCPV6_TX_RAPID_COMMIT ),
 	.next = &dhcpv6_request,
 };
 
@@ -691,12 +693,14 @@ static int dhcpv6_tx ( struct dhcpv6_session *dhcpv6 ) {
 	struct dhcpv6_iaaddr_option *iaaddr;
 	struct dhcpv6_user_class_option *user_class;
 	struct dhcpv6_elapsed_time_option *elapsed;
+	struct dhcpv6_option *rapid_commit;
 	struct dhcpv6_header *dhcphdr;
 	struct io_buffer *iobuf;
 	void *options;
 	size_t client_id_len;
 	size_t server_id_len;
 	size_t ia_na_len;
+	size_t rapid_commit_len;
 	size_t user_class_string_len;
 	size_t user_class_len;
 	size_t elapsed_len;
@@ -720,9 +724,11 @@ static int dhcpv6_tx ( struct dhcpv6_session *dhcpv6 ) {
 			   sizeof ( user_class->user_class[0] ) +
 			   user_class_string_len );
 	elapsed_len = sizeof ( *elapsed );
+	rapid_commit_len = ( ( dhcpv6->state->flags & DHCPV6_TX_RAPID_COMMIT ) ?
+			     sizeof ( *rapid_commit ) : 0 );
 	total_len = ( sizeof ( *dhcphdr ) + client_id_len + server_id_len +
 		      ia_na_len + sizeof ( dhcpv6_request_options_data ) +
-		      user_class_len + elapsed_len );
+		      user_class_len + elapsed_len + rapid_commit_len );
 
 	/* Allocate packet */
 	iobuf = xfer_alloc_iob ( &dhcpv6->xfer, total_len );
@@ -795,6 +801,13 @@ static int dhcpv6_tx ( struct dhcpv6_session *dhcpv6 ) {
 	elapsed->elapsed = htons ( ( ( currticks() - dhcpv6->start ) * 100 ) /
 				   TICKS_PER_SEC );
 
+	/* Construct rapid commit, if applicable */
+	if ( rapid_commit_len ) {
+		rapid_commit = iob_put ( iobuf, rapid_commit_len );
+		rapid_commit->code = htons ( DHCPV6_RAPID_COMMIT );
+		rapid_commit->len = htons ( 0 );
+	}
+
 	/* Sanity check */
 	assert ( iob_len ( iobuf ) == total_len );
 
@@ -847,6 +860,7 @@ static int dhcpv6_rx ( struct dhcpv6_session *dhcpv6,
 	struct dhcpv6_header *dhcphdr = iobuf->data;
 	struct dhcpv6_option_list options;
 	const union dhcpv6_any_option *option;
+	int rapid_commit;
 	int rc;
 
 	/* Sanity checks */
@@ -889,8 +903,20 @@ static int dhcpv6_rx ( struct dhcpv6_session *dhcpv6,
 		goto done;
 	}
 
+	/* Accept a rapid commit reply in place of an advertisement,
+	 * if we requested rapid commit.
+	 */
+	rapid_commit = ( ( dhcpv6->state->flags & DHCPV6_TX_RAPID_COMMIT ) &&
+			 ( dhcphdr->type == DHCPV6_REPLY ) &&
+			 dhcpv6_option ( &options, DHCPV6_RAPID_COMMIT ) );
+	if ( rapid_commit ) {
+		DBGC ( dhcpv6, "DHCPv6 %s received rapid commit %s\n",
+		       dhcpv6->netdev->name,
+		       dhcpv6_type_name ( dhcphdr->type ) );
+	}
+
 	/* Check message type */
-	if ( dhcphdr->type != dhcpv6->state->rx_type ) {
+	if ( ( dhcphdr->type != dhcpv6->state->rx_type ) && ! rapid_commit ) {
 		DBGC ( dhcpv6, "DHCPv6 %s received %s while expecting %s\n",
 		       dhcpv6->netdev->name, dhcpv6_type_name ( dhcphdr->type ),
 		       dhcpv6_type_name ( dhcpv6->state->rx_type ) );
@@ -947,7 +973,7 @@ static int dhcpv6_rx ( struct dhcpv6_session *dhcpv6,
 	}
 
 	/* Transition to next state, if applicable */
-	if ( dhcpv6->state->next ) {
+	if ( dhcpv6->state->next && ! rapid_commit ) {
 		dhcpv6_set_state ( dhcpv6, dhcpv6->state->next );
 		rc = 0;
 		goto done;
@@ -44,9 +44,14 @@ FILE_SECBOOT ( PERMITTED );
 #include <ipxe/settings.h>
 #include <ipxe/features.h>
 #include <ipxe/job.h>
+#include <ipxe/list.h>
+#include <ipxe/malloc.h>
+#include <ipxe/process.h>
+#include <ipxe/timer.h>
 #include <ipxe/dhcp.h>
 #include <ipxe/dhcpv6.h>
 #include <ipxe/dns.h>
+#include <ipxe/trace.h>
 
 /** @file
  *
@@ -56,6 +61,15 @@ FILE_SECBOOT ( PERMITTED );
 
 FEATURE ( FEATURE_PROTOCOL, "DNS", DHCP_EB_FEATURE_DNS, 1 );
 
+/** Resolution delay
+ *
+ * When an address is found before the parallel query for the other
+ * address family has completed, wait this long for the other address
+ * before completing the resolution (as recommended by RFC 8305
+ * section 3).
+ */
+#define DNS_RESOLUTION_DELAY ( 50 * TICKS_PER_MS )
+
 /* Disambiguate the various error causes */
 #define ENXIO_NO_RECORD __einfo_error ( EINFO_ENXIO_NO_RECORD )
 #define EINFO_ENXIO_NO_RECORD \
@@ -91,6 +105,36 @@ static unsigned int dns_count;
 /** The DNS search list */
 static struct dns_name dns_search;
 
+/** A cached DNS resolution */
+struct dns_cache_entry {
+	/** List of cached resolutions */
+	struct list_head list;
+	/** Time at which resolution was cached */
+	unsigned long created;
+	/** Lifetime (in ticks) */
+	unsigned long lifetime;
+	/** Initial query type (in network byte order) */
+	uint16_t qtype;
+	/** Resolution status code */
+	int rc;
+	/** Resolved address (if successful) */
+	union {
+		struct sockaddr sa;
+		struct sockaddr_in sin;
+		struct sockaddr_in6 sin6;
+	} address;
+	/** IPv4 address found in addition to an IPv6 address (if any) */
+	struct sockaddr_in ipv4;
+	/** Name as originally requested */
+	char name[0];
+};
+
+/** Cached DNS resolutions (most recently used first) */
+static LIST_HEAD ( dns_cache );
+
+/** Number of cached DNS resolutions */
+static unsigned int dns_cache_count;
+
 /**
  * Encode a DNS name using RFC1035 encoding
  *
@@ -449,6 +493,98 @@ static const char * dns_type ( uint16_t type ) {
 	}
 }
 
+/**
+ * Remove cached DNS resolution
+ *
+ * @v entry		Cached resolution
+ */
+static void dns_cache_del ( struct dns_cache_entry *entry ) {
+
+	list_del ( &entry->list );
+	dns_cache_count--;
+	free ( entry );
+}
+
+/**
+ * Remove all cached DNS resolutions
+ *
+ */
+static void dns_cache_flush ( void ) {
+	struct dns_cache_entry *entry;
+	struct dns_cache_entry *tmp;
+
+	list_for_each_entry_safe ( entry, tmp, &dns_cache, list )
+		dns_cache_del ( entry );
+}
+
+/**
+ * Find cached DNS resolution
+ *
+ * @v name		Name as originally requested
+ * @v qtype		Initial query type (in network byte order)
+ * @ret entry		Cached resolution, or NULL
+ */
+static struct dns_cache_entry * dns_cache_find ( const char *name,
+						 uint16_t qtype ) {
+	struct dns_cache_entry *entry;
+	struct dns_cache_entry *tmp;
+	unsigned long now = currticks();
+
+	list_for_each_entry_safe ( entry, tmp, &dns_cache, list ) {
+
+		/* Discard expired entries */
+		if ( ( now - entry->created ) >= entry->lifetime ) {
+			dns_cache_del ( entry );
+			continue;
+		}
+
+		/* Move matching entry to head of list */
+		if ( ( entry->qtype == qtype ) &&
+		     ( strcmp ( entry->name, name ) == 0 ) ) {
+			list_del ( &entry->list );
+			list_add ( &entry->list, &dns_cache );
+			return entry;
+		}
+	}
+
+	return NULL;
+}
+
+/**
+ * Discard some cached DNS resolutions
+ *
+ * @ret discarded	Number of cached items discarded
+ */
+static unsigned int dns_cache_discard ( void ) {
+	struct dns_cache_entry *entry;
+
+	/* Discard least recently used entry */
+	entry = list_last_entry ( &dns_cache, struct dns_cache_entry, list );
+	if ( ! entry )
+		return 0;
+	dns_cache_del ( entry );
+
+	return 1;
+}
+
+/** DNS cache discarder */
+struct cache_discarder dns_discarder __cache_discarder ( CACHE_NORMAL ) = {
+	.discard = dns_cache_discard,
+};
+
+/** Query types that may be outstanding */
+static const uint16_t dns_qtypes[] = {
+	DNS_TYPE_AAAA, DNS_TYPE_A, DNS_TYPE_CNAME,
+};
+
+/**
+ * Construct outstanding query type bitmask
+ *
+ * @v qtype		Query type (in network byte order)
+ * @ret pending		Outstanding query type bitmask
+ */
+#define DNS_PENDING( qtype ) ( 1UL << ( ntohs ( qtype ) & 0x1f ) )
+
 /** A DNS request */
 struct dns_request {
 	/** Reference counter */
@@ -459,6 +595,8 @@ struct dns_request {
 	struct interface socket;
 	/** Retry timer */
 	struct retry_timer timer;
+	/** Cached resolution process */
+	struct process process;
 
 	/** Socket address to fill in with resolved address */
 	union {
@@ -487,12 +625,88 @@ struct dns_request {
 	size_t offset;
 	/** Search list */
 	struct dns_name search;
-	/** Server index */
-	unsigned int index;
+	/** Outstanding query types */
+	unsigned long pending;
+	/** Number of failure responses received for each query type */
+	unsigned int failures[ sizeof ( dns_qtypes ) /
+			       sizeof ( dns_qtypes[0] ) ];
+	/** Address record types found */
+	unsigned long found;
+	/** IPv4 address found in addition to an IPv6 address */
+	struct sockaddr_in ipv4;
+	/** Resolution delay timer */
+	struct retry_timer delay;
 	/** Recursion counter */
 	unsigned int recursion;
+	/** Name as originally requested */
+	char *requested;
+	/** Cached resolution status code */
+	int rc;
+	/** Minimum time to live of records used in resolution */
+	unsigned long ttl;
+	/** Time to live of a negative resolution */
+	unsigned long neg_ttl;
 };
 
+/**
+ * Check if both IPv6 and IPv4 addresses were found
+ *
+ * @v dns		DNS request
+ * @ret found_both	Both IPv6 and IPv4 addresses were found
+ */
+static inline int dns_found_both ( struct dns_request *dns ) {
+	unsigned long both = ( DNS_PENDING ( htons ( DNS_TYPE_AAAA ) ) |
+			       DNS_PENDING ( htons ( DNS_TYPE_A ) ) );
+
+	return ( ( dns->found & both ) == both );
+}
+
+/**
+ * Cache DNS resolution
+ *
+ * @v dns		DNS request
+ * @v rc		Resolution status code
+ * @v ttl		Time to live (in seconds)
+ */
+static void dns_cache_add ( struct dns_request *dns, int rc,
+			    unsigned long ttl ) {
+	struct dns_cache_entry *entry;
+	size_t name_len;
+
+	/* Do not cache uncacheable resolutions */
+	if ( ! ttl )
+		return;
+	if ( ttl > DNS_CACHE_MAX_TTL )
+		ttl = DNS_CACHE_MAX_TTL;
+
+	/* Remove any existing entry and make room for a new entry */
+	entry = dns_cache_find ( dns->requested, dns->qtype );
+	if ( entry )
+		dns_cache_del ( entry );
+	if ( dns_cache_count >= DNS_CACHE_MAX )
+		dns_cache_discard();
+
+	/* Allocate and populate entry */
+	name_len = ( strlen ( dns->requested ) + 1 /* NUL */ );
+	entry = zalloc ( sizeof ( *entry ) + name_len );
+	if ( ! entry )
+		return;
+	entry->created = currticks();
+	entry->lifetime = ( ttl * TICKS_PER_SEC );
+	entry->qtype = dns->qtype;
+	entry->rc = rc;
+	memcpy ( &entry->address, &dns->address, sizeof ( entry->address ) );
+	if ( dns_found_both ( dns ) )
+		memcpy ( &entry->ipv4, &dns->ipv4, sizeof ( entry->ipv4 ) );
+	memcpy ( entry->name, dns->requested, name_len );
+	list_add ( &entry->list, &dns_cache );
+	dns_cache_count++;
+
+	DBGC ( dns, "DNS %p caching %s for %lus\n", dns,
+	       ( rc ? strerror ( rc ) : sock_ntoa ( &dns->address.sa ) ),
+	       ttl );
+}
+
 /**
  * Mark DNS request as complete
  *
@@ -501,8 +715,12 @@ struct dns_request {
  */
 static void dns_done ( struct dns_request *dns, int rc ) {
 
-	/* Stop the retry timer */
+	/* Record trace event */
+	trace ( "dns", "done", dns, rc );
+
+	/* Stop the retry timers */
 	stop_timer ( &dns->timer );
+	stop_timer ( &dns->delay );
 
 	/* Shut down interfaces */
 	intf_shutdown ( &dns->socket, rc );
@@ -520,13 +738,85 @@ static void dns_resolved ( struct dns_request *dns ) {
 	DBGC ( dns, "DNS %p found address %s\n",
 	       dns, sock_ntoa ( &dns->address.sa ) );
 
+	/* Cache resolved address */
+	dns_cache_add ( dns, 0, dns->ttl );
+
 	/* Return resolved address */
 	resolv_done ( &dns->resolv, &dns->address.sa );
 
+	/* Return any additional IPv4 address, to allow the caller to
+	 * race connection attempts across both address families.
+	 */
+	if ( dns_found_both ( dns ) ) {
+		DBGC ( dns, "DNS %p also found address %s\n",
+		       dns, sock_ntoa ( ( struct sockaddr * ) &dns->ipv4 ) );
+		resolv_done ( &dns->resolv,
+			      ( ( struct sockaddr * ) &dns->ipv4 ) );
+	}
+
 	/* Mark operation as complete */
 	dns_done ( dns, 0 );
 }
 
+/**
+ * Complete cached DNS resolution
+ *
+ * @v dns		DNS request
+ */
+static void dns_cached ( struct dns_request *dns ) {
+
+	DBGC ( dns, "DNS %p using cached resolution\n", dns );
+	if ( dns->rc == 0 ) {
+		dns_resolved ( dns );
+	} else {
+		dns_done ( dns, dns->rc );
+	}
+}
+
+/** Cached DNS resolution process descriptor */
+static struct process_descriptor dns_cached_process_desc =
+	PROC_DESC_ONCE ( struct dns_request, process, dns_cached );
+
+/**
+ * Calculate negative caching lifetime from DNS "SOA" record
+ *
+ * @v buf		DNS response
+ * @v offset		Offset of resource record
+ * @v next_offset	Offset of next resource record
+ * @ret ttl		Negative caching lifetime (in seconds), or zero
+ *
+ * As per RFC 2308 section 5, the lifetime of a negative response is
+ * the lower of the SOA record's own time to live and its MINIMUM
+ * field.
+ */
+static unsigned long dns_soa_ttl ( struct dns_name *buf, size_t offset,
+				   size_t next_offset ) {
+	union dns_rr *rr = ( buf->data + offset );
+	const struct dns_soa *soa;
+	struct dns_name rdata;
+	unsigned long ttl;
+	unsigned long minimum;
+	int pos;
+
+	/* Skip MNAME and RNAME */
+	rdata.data = buf->data;
+	rdata.offset = ( offset + sizeof ( rr->common ) );
+	rdata.len = next_offset;
+	pos = dns_skip ( &rdata );
+	if ( pos < 0 )
+		return 0;
+	rdata.offset = pos;
+	pos = dns_skip ( &rdata );
+	if ( ( pos < 0 ) || ( ( pos + sizeof ( *soa ) ) > next_offset ) )
+		return 0;
+	soa = ( buf->data + pos );
+
+	/* Use lower of record time to live and minimum time to live */
+	ttl = ntohl ( rr->common.ttl );
+	minimum = ntohl ( soa->minimum );
+	return ( ( minimum < ttl ) ? minimum : ttl );
+}
+
 /**
  * Construct DNS question
  *
@@ -570,8 +860,9 @@ static int dns_question ( struct dns_request *dns ) {
 	/* Restore name */
 	dns->name.offset = offsetof ( typeof ( dns->buf ), name );
 
-	/* Reset query ID */
+	/* Reset query ID and outstanding query types */
 	dns->buf.query.id = 0;
+	dns->pending = 0;
 
 	DBGC2 ( dns, "DNS %p question is %s type %s\n", dns,
 		dns_name ( &dns->name ), dns_type ( dns->question->qtype ) );
@@ -579,14 +870,35 @@ static int dns_question ( struct dns_request *dns ) {
 	return 0;
 }
 
+/**
+ * Get index of DNS query type within list of query types
+ *
+ * @v qtype		Query type (in network byte order)
+ * @ret index		Index, or negative error
+ */
+static int dns_qtype_index ( uint16_t qtype ) {
+	unsigned int i;
+
+	for ( i = 0 ; i < ( sizeof ( dns_qtypes ) /
+			    sizeof ( dns_qtypes[0] ) ) ; i++ ) {
+		if ( qtype == htons ( dns_qtypes[i] ) )
+			return i;
+	}
+	return -ENOTSUP;
+}
+
 /**
  * Send DNS query
  *
  * @v dns		DNS request
  * @ret rc		Return status code
+ *
+ * Each outstanding query type is sent to every configured server.
+ * An AAAA query is always accompanied by a parallel A query.
  */
 static int dns_send_packet ( struct dns_request *dns ) {
 	struct dns_header *query = &dns->buf.query;
+	uint16_t qtype = dns->question->qtype;
 	union {
 		struct sockaddr sa;
 		struct sockaddr_tcpip st;
@@ -595,42 +907,93 @@ static int dns_send_packet ( struct dns_request *dns ) {
 	} nameserver;
 	struct xfer_metadata meta;
 	unsigned int index;
+	unsigned int i;
+	int rc = 0;
 
 	/* Start retransmission timer */
 	start_timer ( &dns->timer );
 
-	/* Construct DNS server address */
-	memset ( &nameserver, 0, sizeof ( nameserver ) );
-	nameserver.st.st_port = htons ( DNS_PORT );
+	/* Sanity check */
 	if ( ! dns_count ) {
 		DBGC ( dns, "DNS %p lost DNS servers mid query\n", dns );
 		return -EINVAL;
 	}
-	index = ( dns->index % dns_count );
-	if ( index < dns6.count ) {
-		nameserver.sin6.sin6_family = AF_INET6;
-		memcpy ( &nameserver.sin6.sin6_addr, &dns6.in6[index],
-			 sizeof ( nameserver.sin6.sin6_addr ) );
-	} else {
-		nameserver.sin.sin_family = AF_INET;
-		nameserver.sin.sin_addr = dns4.in[index - dns6.count];
-	}
 
-	/* Construct metadata */
-	memset ( &meta, 0, sizeof ( meta ) );
-	meta.dest = &nameserver.sa;
+	/* Determine outstanding query types, if not already known */
+	if ( ! dns->pending ) {
+		dns->pending = DNS_PENDING ( qtype );
+		if ( qtype == htons ( DNS_TYPE_AAAA ) )
+			dns->pending |= DNS_PENDING ( htons ( DNS_TYPE_A ) );
+	}
 
 	/* Generate query identifier if applicable */
-	if ( ! query->id )
+	if ( ! query->id ) {
 		query->id = random();
+		memset ( dns->failures, 0, sizeof ( dns->failures ) );
+	}
+
+	/* Send each outstanding query type to each server */
+	for ( i = 0 ; i < ( sizeof ( dns_qtypes ) /
+			    sizeof ( dns_qtypes[0] ) ) ; i++ ) {
 
-	/* Send query */
-	DBGC ( dns, "DNS %p sending %s query ID %#04x for %s type %s\n", dns,
-	       sock_ntoa ( &nameserver.sa ), ntohs ( query->id ),
-	       dns_name ( &dns->name ), dns_type ( dns->question->qtype ) );
+		/* Skip query types that are not outstanding */
+		dns->question->qtype = htons ( dns_qtypes[i] );
+		if ( ! ( dns->pending & DNS_PENDING ( dns->question->qtype ) ))
+			continue;
+
+		for ( index = 0 ; index < dns_count ; index++ ) {
+
+			/* Construct DNS server address */
+			memset ( &nameserver, 0, sizeof ( nameserver ) );
+			nameserver.st.st_port = htons ( DNS_PORT );
+			if ( index < dns6.count ) {
+				nameserver.sin6.sin6_family = AF_INET6;
+				memcpy ( &nameserver.sin6.sin6_addr,
+					 &dns6.in6[index],
+					 sizeof ( nameserver.sin6.sin6_addr ) );
+			} else {
+				nameserver.sin.sin_family = AF_INET;
+				nameserver.sin.sin_addr =
+					dns4.in[index - dns6.count];
+			}
+
+			/* Construct metadata */
+			memset ( &meta, 0, sizeof ( meta ) );
+			meta.dest = &nameserver.sa;
+
+			/* Send query */
+			DBGC ( dns, "DNS %p sending %s query ID %#04x for %s "
+			       "type %s\n", dns, sock_ntoa ( &nameserver.sa ),
+			       ntohs ( query->id ), dns_name ( &dns->name ),
+			       dns_type ( dns->question->qtype ) );
+			if ( ( rc = xfer_deliver_raw_meta ( &dns->socket,
+							    query, dns->len,
+							    &meta ) ) != 0 ) {
+				DBGC ( dns, "DNS %p could not send query: "
+				       "%s\n", dns, strerror ( rc ) );
+				/* Continue with remaining servers */
+			}
+		}
+	}
 
-	/* Send the data */
-	return xfer_deliver_raw_meta ( &dns->socket, query, dns->len, &meta );
+	/* Restore current question */
+	dns->question->qtype = qtype;
+
+	return rc;
+}
+
+/**
+ * Send DNS query for a different record type
+ *
+ * @v dns		DNS request
+ * @v qtype		Query type (in network byte order)
+ */
+static void dns_requery ( struct dns_request *dns, uint16_t qtype ) {
+
+	dns->question->qtype = qtype;
+	dns->buf.query.id = 0;
+	dns->pending = 0;
+	dns_send_packet ( dns );
 }
 
 /**
@@ -649,14 +1012,26 @@ static void dns_timer_expired ( struct retry_timer *timer, int fail ) {
 		return;
 	}
 
-	/* Move to next DNS server if this is a retransmission */
-	if ( dns->buf.query.id )
-		dns->index++;
-
-	/* Send DNS query */
+	/* Send (or resend) DNS query */
 	dns_send_packet ( dns );
 }
 
+/**
+ * Handle DNS resolution delay timer expiry
+ *
+ * @v timer		Resolution delay timer
+ * @v fail		Failure indicator
+ */
+static void dns_delay_expired ( struct retry_timer *timer,
+				int fail __unused ) {
+	struct dns_request *dns =
+		container_of ( timer, struct dns_request, delay );
+
+	/* Give up waiting for the parallel query */
+	DBGC ( dns, "DNS %p gave up waiting for parallel query\n", dns );
+	dns_resolved ( dns );
+}
+
 /**
  * Receive new data
  *
@@ -670,14 +1045,20 @@ static int dns_xfer_deliver ( struct dns_request *dns,
 			      struct xfer_metadata *meta __unused ) {
 	struct dns_header *response = iobuf->data;
 	struct dns_header *query = &dns->buf.query;
-	unsigned int qtype = dns->question->qtype;
+	struct dns_question *question;
 	struct dns_name buf;
 	union dns_rr *rr;
+	uint16_t qtype;
+	unsigned int rcode;
 	int offset;
+	int index;
 	size_t answer_offset;
 	size_t next_offset;
 	size_t rdlength;
 	size_t name_len;
+	unsigned long neg_ttl = 0;
+	unsigned long ttl;
+	int cname = 0;
 	int rc;
 
 	/* Sanity check */
@@ -696,8 +1077,6 @@ static int dns_xfer_deliver ( struct dns_request *dns,
 		rc = -EINVAL;
 		goto done;
 	}
-	DBGC ( dns, "DNS %p received response ID %#04x\n",
-	       dns, ntohs ( response->id ) );
 
 	/* Check that we have exactly one question */
 	if ( response->qdcount != htons ( 1 ) ) {
@@ -718,7 +1097,38 @@ static int dns_xfer_deliver ( struct dns_request *dns,
 		       "question: %s\n", dns, strerror ( rc ) );
 		goto done;
 	}
-	answer_offset = ( offset + sizeof ( struct dns_question ) );
+	answer_offset = ( offset + sizeof ( *question ) );
+	if ( answer_offset > buf.len ) {
+		DBGC ( dns, "DNS %p received response with underlength "
+		       "question\n", dns );
+		rc = -EINVAL;
+		goto done;
+	}
+	question = ( buf.data + offset );
+	qtype = question->qtype;
+	DBGC ( dns, "DNS %p received response ID %#04x type %s\n",
+	       dns, ntohs ( response->id ), dns_type ( qtype ) );
+
+	/* Ignore responses to queries that are no longer outstanding
+	 * (e.g. duplicate responses from slower servers).
+	 */
+	index = dns_qtype_index ( qtype );
+	if ( ( index < 0 ) || ! ( dns->pending & DNS_PENDING ( qtype ) ) ) {
+		DBGC2 ( dns, "DNS %p ignoring duplicate response\n", dns );
+		rc = 0;
+		goto done;
+	}
+
+	/* Ignore server failures unless all servers have failed */
+	rcode = DNS_RCODE ( ntohs ( response->flags ) );
+	if ( ( rcode != 0 ) && ( rcode != DNS_RCODE_NXDOMAIN ) ) {
+		DBGC ( dns, "DNS %p received response code %d\n",
+		       dns, rcode );
+		if ( ++dns->failures[index] < dns_count ) {
+			rc = 0;
+			goto done;
+		}
+	}
 
 	/* Search through response for useful answers.  Do this
 	 * multiple times, to take advantage of useful nameservers
@@ -754,6 +1164,10 @@ static int dns_xfer_deliver ( struct dns_request *dns,
 			goto done;
 		}
 
+		/* Record negative caching lifetime from any SOA record */
+		if ( rr->common.type == htons ( DNS_TYPE_SOA ) )
+			neg_ttl = dns_soa_ttl ( &buf, offset, next_offset );
+
 		/* Skip non-matching names */
 		if ( dns_compare ( &buf, &dns->name ) != 0 ) {
 			DBGC2 ( dns, "DNS %p ignoring response for %s type "
@@ -762,6 +1176,9 @@ static int dns_xfer_deliver ( struct dns_request *dns,
 			continue;
 		}
 
+		/* Track minimum time to live of records used */
+		ttl = ntohl ( rr->common.ttl );
+
 		/* Handle answer */
 		switch ( rr->common.type ) {
 
@@ -774,13 +1191,18 @@ static int dns_xfer_deliver ( struct dns_request *dns,
 				rc = -EINVAL;
 				goto done;
 			}
+			if ( dns->found & DNS_PENDING ( rr->common.type ) )
+				break;
+			if ( dns->found ) {
+				/* Retain IPv4 address found previously */
+				memcpy ( &dns->ipv4, &dns->address.sin,
+					 sizeof ( dns->ipv4 ) );
+			}
 			dns->address.sin6.sin6_family = AF_INET6;
 			memcpy ( &dns->address.sin6.sin6_addr,
 				 &rr->aaaa.in6_addr,
 				 sizeof ( dns->address.sin6.sin6_addr ) );
-			dns_resolved ( dns );
-			rc = 0;
-			goto done;
+			goto found;
 
 		case htons ( DNS_TYPE_A ):
 
@@ -791,8 +1213,42 @@ static int dns_xfer_deliver ( struct dns_request *dns,
 				rc = -EINVAL;
 				goto done;
 			}
-			dns->address.sin.sin_family = AF_INET;
-			dns->address.sin.sin_addr = rr->a.in_addr;
+			if ( dns->found & DNS_PENDING ( rr->common.type ) )
+				break;
+			if ( dns->found ) {
+				/* Keep IPv6 address as the primary address */
+				dns->ipv4.sin_family = AF_INET;
+				dns->ipv4.sin_addr = rr->a.in_addr;
+			} else {
+				dns->address.sin.sin_family = AF_INET;
+				dns->address.sin.sin_addr = rr->a.in_addr;
+			}
+			goto found;
+
+		found:
+			/* Found an address record */
+			if ( ttl < dns->ttl )
+				dns->ttl = ttl;
+			dns->found |= DNS_PENDING ( rr->common.type );
+			dns->pending &= ~DNS_PENDING ( rr->common.type );
+
+			/* If the parallel query is still outstanding, then
+			 * wait a short time for it to complete.  This
+			 * allows an IPv6 address to be preferred (as per
+			 * RFC 8305 section 3), and allows both addresses
+			 * to be offered for connection racing.
+			 */
+			if ( dns->pending ) {
+				DBGC ( dns, "DNS %p found %s record; waiting "
+				       "for parallel query\n", dns,
+				       dns_type ( rr->common.type ) );
+				if ( ! timer_running ( &dns->delay ) ) {
+					start_timer_fixed ( &dns->delay,
+							DNS_RESOLUTION_DELAY );
+				}
+				rc = 0;
+				goto done;
+			}
 			dns_resolved ( dns );
 			rc = 0;
 			goto done;
@@ -809,6 +1265,9 @@ static int dns_xfer_deliver ( struct dns_request *dns,
 			}
 
 			/* Found a CNAME record; update query and recurse */
+			if ( ttl < dns->ttl )
+				dns->ttl = ttl;
+			cname = 1;
 			buf.offset = ( offset + sizeof ( rr->cname ) );
 			DBGC ( dns, "DNS %p found CNAME %s\n",
 			       dns, dns_name ( &buf ) );
@@ -830,6 +1289,46 @@ static int dns_xfer_deliver ( struct dns_request *dns,
 		}
 	}
 
+	/* Record negative caching lifetime.  A response with no SOA
+	 * record may not be cached (RFC 2308 section 5).
+	 */
+	if ( neg_ttl < dns->neg_ttl )
+		dns->neg_ttl = neg_ttl;
+
+	/* If we followed a CNAME, then query the new name */
+	if ( cname ) {
+		stop_timer ( &dns->timer );
+		dns_send_packet ( dns );
+		rc = 0;
+		goto done;
+	}
+
+	/* Mark this query type as complete */
+	dns->pending &= ~DNS_PENDING ( qtype );
+
+	/* If the name does not exist, then there is no point in
+	 * waiting for or asking for any other record types: proceed
+	 * directly to the next entry in the search list.
+	 */
+	if ( rcode == DNS_RCODE_NXDOMAIN ) {
+		DBGC ( dns, "DNS %p name does not exist\n", dns );
+		dns->pending = 0;
+		qtype = htons ( DNS_TYPE_CNAME );
+	}
+
+	/* Use any address found by a parallel query */
+	if ( dns->found ) {
+		dns_resolved ( dns );
+		rc = 0;
+		goto done;
+	}
+
+	/* Wait for any parallel queries to complete */
+	if ( dns->pending ) {
+		rc = 0;
+		goto done;
+	}
+
 	/* Stop the retry timer.  After this point, each code path
 	 * must either restart the timer by calling dns_send_packet(),
 	 * or mark the DNS operation as complete by calling
@@ -843,42 +1342,24 @@ static int dns_xfer_deliver ( struct dns_request *dns,
 	switch ( qtype ) {
 
 	case htons ( DNS_TYPE_AAAA ):
-		/* We asked for an AAAA record and got nothing; try
-		 * the A.
-		 */
-		DBGC ( dns, "DNS %p found no AAAA record; trying A\n", dns );
-		dns->question->qtype = htons ( DNS_TYPE_A );
-		dns_send_packet ( dns );
-		rc = 0;
-		goto done;
-
 	case htons ( DNS_TYPE_A ):
-		/* We asked for an A record and got nothing;
+		/* We asked for address records and got nothing;
 		 * try the CNAME.
 		 */
-		DBGC ( dns, "DNS %p found no A record; trying CNAME\n", dns );
-		dns->question->qtype = htons ( DNS_TYPE_CNAME );
-		dns_send_packet ( dns );
+		DBGC ( dns, "DNS %p found no address record; trying CNAME\n",
+		       dns );
+		dns_requery ( dns, htons ( DNS_TYPE_CNAME ) );
 		rc = 0;
 		goto done;
 
 	case htons ( DNS_TYPE_CNAME ):
-		/* We asked for a CNAME record.  If we got a response
-		 * (i.e. if the next AAAA/A query is already set up),
-		 * then issue it.
-		 */
-		if ( qtype == dns->qtype ) {
-			dns_send_packet ( dns );
-			rc = 0;
-			goto done;
-		}
-
 		/* If we have already reached the end of the search list,
 		 * then terminate lookup.
 		 */
 		if ( dns->search.offset == dns->search.len ) {
 			DBGC ( dns, "DNS %p found no CNAME record\n", dns );
 			rc = -ENXIO_NO_RECORD;
+			dns_cache_add ( dns, rc, dns->neg_ttl );
 			dns_done ( dns, rc );
 			goto done;
 		}
@@ -977,7 +1458,9 @@ static int dns_resolv ( struct interface *resolv,
 			const char *name, struct sockaddr *sa ) {
 	struct dns_request *dns;
 	struct dns_header *query;
+	struct dns_cache_entry *entry;
 	size_t search_len;
+	size_t requested_len;
 	int name_len;
 	int rc;
 
@@ -993,7 +1476,8 @@ static int dns_resolv ( struct interface *resolv,
 	search_len = ( strchr ( name, '.' ) ? 0 : dns_search.len );
 
 	/* Allocate DNS structure */
-	dns = zalloc ( sizeof ( *dns ) + search_len );
+	requested_len = ( strlen ( name ) + 1 /* NUL */ );
+	dns = zalloc ( sizeof ( *dns ) + search_len + requested_len );
 	if ( ! dns ) {
 		rc = -ENOMEM;
 		goto err_alloc_dns;
@@ -1002,15 +1486,53 @@ static int dns_resolv ( struct interface *resolv,
 	intf_init ( &dns->resolv, &dns_resolv_desc, &dns->refcnt );
 	intf_init ( &dns->socket, &dns_socket_desc, &dns->refcnt );
 	timer_init ( &dns->timer, dns_timer_expired, &dns->refcnt );
+	timer_init ( &dns->delay, dns_delay_expired, &dns->refcnt );
 	memcpy ( &dns->address.sa, sa, sizeof ( dns->address.sa ) );
+	memcpy ( &dns->ipv4, sa, sizeof ( dns->ipv4 ) );
 	dns->search.data = ( ( ( void * ) dns ) + sizeof ( *dns ) );
 	dns->search.len = search_len;
 	memcpy ( dns->search.data, dns_search.data, search_len );
+	dns->requested = ( dns->search.data + search_len );
+	memcpy ( dns->requested, name, requested_len );
+	dns->ttl = DNS_CACHE_MAX_TTL;
+	dns->neg_ttl = DNS_CACHE_MAX_TTL;
+	trace ( "dns", "resolve", dns, 0 );
 
 	/* Determine initial query type */
 	dns->qtype = ( ( dns6.count != 0 ) ?
 		       htons ( DNS_TYPE_AAAA ) : htons ( DNS_TYPE_A ) );
 
+	/* Use cached resolution, if available */
+	entry = dns_cache_find ( name, dns->qtype );
+	if ( entry ) {
+		dns->rc = entry->rc;
+		dns->ttl = 0;
+		if ( entry->rc != 0 ) {
+			/* Negative resolution: no address to copy */
+		} else if ( entry->address.sa.sa_family == AF_INET6 ) {
+			dns->address.sin6.sin6_family = AF_INET6;
+			memcpy ( &dns->address.sin6.sin6_addr,
+				 &entry->address.sin6.sin6_addr,
+				 sizeof ( dns->address.sin6.sin6_addr ) );
+			dns->found |= DNS_PENDING ( htons ( DNS_TYPE_AAAA ) );
+		} else {
+			dns->address.sin.sin_family = AF_INET;
+			dns->address.sin.sin_addr = entry->address.sin.sin_addr;
+			dns->found |= DNS_PENDING ( htons ( DNS_TYPE_A ) );
+		}
+		if ( entry->ipv4.sin_family == AF_INET ) {
+			/* Restore additional IPv4 address */
+			dns->ipv4.sin_family = AF_INET;
+			dns->ipv4.sin_addr = entry->ipv4.sin_addr;
+			dns->found |= DNS_PENDING ( htons ( DNS_TYPE_A ) );
+		}
+		process_init ( &dns->process, &dns_cached_process_desc,
+			       &dns->refcnt );
+		intf_plug_plug ( &dns->resolv, resolv );
+		ref_put ( &dns->refcnt );
+		return 0;
+	}
+
 	/* Construct query */
 	query = &dns->buf.query;
 	query->flags = htons ( DNS_FLAG_RD );
@@ -1146,17 +1668,13 @@ const struct setting dnssl_setting __setting ( SETTING_IP_EXTRA, dnssl ) = {
  *
  */
 static void apply_dns_servers ( void ) {
+	struct dns_server old4 = dns4;
+	struct dns_server old6 = dns6;
 	int len;
 
-	/* Free existing server addresses */
-	free ( dns4.data );
-	free ( dns6.data );
-	dns4.data = NULL;
-	dns6.data = NULL;
-	dns4.count = 0;
-	dns6.count = 0;
-
 	/* Fetch DNS server addresses */
+	memset ( &dns4, 0, sizeof ( dns4 ) );
+	memset ( &dns6, 0, sizeof ( dns6 ) );
 	len = fetch_raw_setting_copy ( NULL, &dns_setting, &dns4.data );
 	if ( len >= 0 )
 		dns4.count = ( len / sizeof ( dns4.in[0] ) );
@@ -1164,6 +1682,19 @@ static void apply_dns_servers ( void ) {
 	if ( len >= 0 )
 		dns6.count = ( len / sizeof ( dns6.in6[0] ) );
 	dns_count = ( dns4.count + dns6.count );
+
+	/* Discard cached resolutions if the server list has changed */
+	if ( ( dns4.count != old4.count ) || ( dns6.count != old6.count ) ||
+	     ( memcmp ( dns4.data, old4.data,
+			( dns4.count * sizeof ( dns4.in[0] ) ) ) != 0 ) ||
+	     ( memcmp ( dns6.data, old6.data,
+			( dns6.count * sizeof ( dns6.in6[0] ) ) ) != 0 ) ) {
+		dns_cache_flush();
+	}
+
+	/* Free old server addresses */
+	free ( old4.data );
+	free ( old6.data );
 }
 
 /**
@@ -1171,18 +1702,16 @@ static void apply_dns_servers ( void ) {
  *
  */
 static void apply_dns_search ( void ) {
+	struct dns_name old = dns_search;
 	char *localdomain;
 	int len;
 
-	/* Free existing search list */
-	free ( dns_search.data );
-	memset ( &dns_search, 0, sizeof ( dns_search ) );
-
 	/* Fetch DNS search list */
+	memset ( &dns_search, 0, sizeof ( dns_search ) );
 	len = fetch_raw_setting_copy ( NULL, &dnssl_setting, &dns_search.data );
 	if ( len >= 0 ) {
 		dns_search.len = len;
-		return;
+		goto done;
 	}
 
 	/* If no DNS search list exists, try to fetch the local domain */
@@ -1197,8 +1726,17 @@ static void apply_dns_search ( void ) {
 			}
 		}
 		free ( localdomain );
-		return;
 	}
+
+ done:
+	/* Discard cached resolutions if the search list has changed */
+	if ( ( dns_search.len != old.len ) ||
+	     ( memcmp ( dns_search.data, old.data, old.len ) != 0 ) ) {
+		dns_cache_flush();
+	}
+
+	/* Free old search list */
+	free ( old.data );
 }
 
 /**
@@ -32,6 +32,7 @@ FILE_SECBOOT ( PERMITTED );
 
 #include <stdint.h>
 #include <stdlib.h>
+#include <stdio.h>
 #include <string.h>
 #include <ctype.h>
 #include <byteswap.h>
@@ -87,6 +88,28 @@ static char *syslog_hostname;
 /** Domain name (for log messages) */
 static char *syslog_domain;
 
+/**
+ * Format syslog message
+ *
+ * @v buf		Buffer to fill in
+ * @v len		Length of buffer
+ * @v severity		Severity
+ * @v message		Message
+ * @ret len		Length of formatted message
+ */
+size_t syslog_format ( char *buf, size_t len, unsigned int severity,
+		       const char *message ) {
+	const char *hostname = ( syslog_hostname ? syslog_hostname : "" );
+	const char *domain = ( ( hostname[0] && syslog_domain ) ?
+			       syslog_domain : "" );
+
+	return snprintf ( buf, len, "<%d>%s%s%s%sipxe: %s",
+			  SYSLOG_PRIORITY ( SYSLOG_DEFAULT_FACILITY,
+					    severity ), hostname,
+			  ( domain[0] ? "." : "" ), domain,
+			  ( hostname[0] ? " " : "" ), message );
+}
+
 /**
  * Transmit formatted syslog message
  *
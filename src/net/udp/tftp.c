@@ -47,6 +47,7 @@ FILE_SECBOOT ( PERMITTED );
 #include <ipxe/profile.h>
 #include <ipxe/errortab.h>
 #include <ipxe/tftp.h>
+#include <config/general.h>
 
 /** @file
  *
@@ -78,6 +79,9 @@ FEATURE ( FEATURE_PROTOCOL, "TFTP", DHCP_EB_FEATURE_TFTP, 1 );
 #define EINVAL_MC_INVALID_PORT __einfo_error ( EINFO_EINVAL_MC_INVALID_PORT )
 #define EINFO_EINVAL_MC_INVALID_PORT __einfo_uniqify \
 	( EINFO_EINVAL, 0x07, "Invalid multicast port" )
+#define EINVAL_WINDOWSIZE __einfo_error ( EINFO_EINVAL_WINDOWSIZE )
+#define EINFO_EINVAL_WINDOWSIZE __einfo_uniqify \
+	( EINFO_EINVAL, 0x08, "Invalid windowsize" )
 #define ENOENT_NOT_FOUND __einfo_error ( EINFO_ENOENT_NOT_FOUND )
 #define EINFO_ENOENT_NOT_FOUND __einfo_uniqify \
 	( EINFO_ENOENT, 0x01, "Not found" )
@@ -114,6 +118,17 @@ struct tftp_request {
 	 * "tsize" option, this value will be zero.
 	 */
 	unsigned long tsize;
+	/** Window size
+	 *
+	 * This is the "windowsize" option negotiated with the TFTP
+	 * server.  (If the TFTP server does not support the
+	 * "windowsize" option, this will default to 1).
+	 */
+	unsigned int windowsize;
+	/** Last acknowledged block number */
+	unsigned int acked;
+	/** Block number at which the last window rollback occurred */
+	unsigned int rollback;
 	
 	/** Server port
 	 *
@@ -159,6 +174,10 @@ enum {
 	TFTP_FL_RRQ_MULTICAST = 0x0004,
 	/** Perform MTFTP recovery on timeout */
 	TFTP_FL_MTFTP_RECOVERY = 0x0008,
+	/** Jumbo block size requested */
+	TFTP_FL_RRQ_JUMBO = 0x0010,
+	/** Jumbo block size rejected by server */
+	TFTP_FL_NO_JUMBO = 0x0020,
 };
 
 /** Maximum number of MTFTP open requests before falling back to TFTP */
@@ -230,6 +249,11 @@ static int tftp_reopen ( struct tftp_request *tftp ) {
 	/* Reset peer address */
 	memset ( &tftp->peer, 0, sizeof ( tftp->peer ) );
 
+	/* Reset window state */
+	tftp->windowsize = 1;
+	tftp->acked = 0;
+	tftp->rollback = ~0U;
+
 	/* Open socket */
 	memset ( &server, 0, sizeof ( server ) );
 	server.st_port = htons ( tftp->port );
@@ -351,6 +375,7 @@ static int tftp_send_rrq ( struct tftp_request *tftp ) {
 	size_t len;
 	struct io_buffer *iobuf;
 	size_t blksize;
+	size_t mtu;
 
 	DBGC ( tftp, "TFTP %p requesting \"%s\"\n", tftp, path );
 
@@ -359,15 +384,31 @@ static int tftp_send_rrq ( struct tftp_request *tftp ) {
 		+ 5 + 1 /* "octet" + NUL */
 		+ 7 + 1 + 5 + 1 /* "blksize" + NUL + ddddd + NUL */
 		+ 5 + 1 + 1 + 1 /* "tsize" + NUL + "0" + NUL */ 
+		+ 10 + 1 + 5 + 1 /* "windowsize" + NUL + ddddd + NUL */
 		+ 9 + 1 + 1 /* "multicast" + NUL + NUL */ );
 	iobuf = xfer_alloc_iob ( &tftp->socket, len );
 	if ( ! iobuf )
 		return -ENOMEM;
 
-	/* Determine block size */
+	/* Determine block size.  Use the largest block that fits
+	 * within the path MTU if this exceeds the standard Ethernet
+	 * block size, unless the server has already rejected a
+	 * jumbo block size.
+	 */
 	blksize = xfer_window ( &tftp->xfer );
-	if ( blksize > TFTP_MAX_BLKSIZE )
-		blksize = TFTP_MAX_BLKSIZE;
+	mtu = xfer_window ( &tftp->socket );
+	tftp->flags &= ~TFTP_FL_RRQ_JUMBO;
+	if ( ( blksize > TFTP_STD_BLKSIZE ) &&
+	     ( mtu > ( TFTP_STD_BLKSIZE + sizeof ( struct tftp_data ) ) ) &&
+	     ! ( tftp->flags & TFTP_FL_NO_JUMBO ) ) {
+		if ( blksize > ( mtu - sizeof ( struct tftp_data ) ) )
+			blksize = ( mtu - sizeof ( struct tftp_data ) );
+		if ( blksize > TFTP_MAX_BLKSIZE )
+			blksize = TFTP_MAX_BLKSIZE;
+		tftp->flags |= TFTP_FL_RRQ_JUMBO;
+	} else if ( blksize > TFTP_STD_BLKSIZE ) {
+		blksize = TFTP_STD_BLKSIZE;
+	}
 
 	/* Build request */
 	rrq = iob_put ( iobuf, sizeof ( *rrq ) );
@@ -380,6 +421,14 @@ static int tftp_send_rrq ( struct tftp_request *tftp ) {
 					    "blksize%c%zd%ctsize%c0",
 					    0, blksize, 0, 0 ) + 1 );
 	}
+	if ( ( tftp->flags & TFTP_FL_RRQ_SIZES ) &&
+	     ( ! ( tftp->flags & TFTP_FL_RRQ_MULTICAST ) ) &&
+	     ( TFTP_WINDOWSIZE > 1 ) ) {
+		iob_put ( iobuf, snprintf ( iobuf->tail,
+					    iob_tailroom ( iobuf ),
+					    "windowsize%c%d", 0,
+					    TFTP_WINDOWSIZE ) + 1 );
+	}
 	if ( tftp->flags & TFTP_FL_RRQ_MULTICAST ) {
 		iob_put ( iobuf, snprintf ( iobuf->tail,
 					    iob_tailroom ( iobuf ),
@@ -409,6 +458,7 @@ static int tftp_send_ack ( struct tftp_request *tftp ) {
 	/* Determine next required block number */
 	block = bitmap_first_gap ( &tftp->bitmap );
 	DBGC2 ( tftp, "TFTP %p sending ACK for block %d\n", tftp, block );
+	tftp->acked = block;
 
 	/* Allocate buffer */
 	iobuf = xfer_alloc_iob ( &tftp->socket, sizeof ( *ack ) );
@@ -679,11 +729,36 @@ struct tftp_option {
 	int ( * process ) ( struct tftp_request *tftp, char *value );
 };
 
+/**
+ * Process TFTP "windowsize" option
+ *
+ * @v tftp		TFTP connection
+ * @v value		Option value
+ * @ret rc		Return status code
+ */
+static int tftp_process_windowsize ( struct tftp_request *tftp,
+				     char *value ) {
+	char *end;
+
+	tftp->windowsize = strtoul ( value, &end, 10 );
+	if ( *end || ( tftp->windowsize == 0 ) ||
+	     ( tftp->windowsize > TFTP_WINDOWSIZE ) ) {
+		DBGC ( tftp, "TFTP %p got invalid windowsize \"%s\"\n",
+		       tftp, value );
+		tftp->windowsize = 1;
+		return -EINVAL_WINDOWSIZE;
+	}
+	DBGC ( tftp, "TFTP %p windowsize=%d\n", tftp, tftp->windowsize );
+
+	return 0;
+}
+
 /** Recognised TFTP options */
 static struct tftp_option tftp_options[] = {
 	{ "blksize", tftp_process_blksize },
 	{ "tsize", tftp_process_tsize },
 	{ "multicast", tftp_process_multicast },
+	{ "windowsize", tftp_process_windowsize },
 	{ NULL, NULL }
 };
 
@@ -800,6 +875,7 @@ static int tftp_rx_data ( struct tftp_request *tftp,
 	struct tftp_data *data = iobuf->data;
 	struct xfer_metadata meta;
 	unsigned int block;
+	unsigned int first_gap;
 	off_t offset;
 	size_t data_len;
 	int rc;
@@ -853,9 +929,27 @@ static int tftp_rx_data ( struct tftp_request *tftp,
 
 	/* Mark block as received */
 	bitmap_set ( &tftp->bitmap, block );
+	first_gap = bitmap_first_gap ( &tftp->bitmap );
 
-	/* Acknowledge block */
-	tftp_send_packet ( tftp );
+	/* Acknowledge block.  When a window size has been negotiated,
+	 * acknowledge only at the end of each window, at the end of
+	 * the file, or (once per gap) when a block arrives out of
+	 * order so that the server can roll back to the first
+	 * missing block.
+	 */
+	if ( ( tftp->windowsize <= 1 ) ||
+	     bitmap_full ( &tftp->bitmap ) ||
+	     ( ( first_gap - tftp->acked ) >= tftp->windowsize ) ) {
+		tftp_send_packet ( tftp );
+	} else if ( ( block > first_gap ) &&
+		    ( first_gap != tftp->rollback ) ) {
+		DBGC ( tftp, "TFTP %p missing block %d\n", tftp, first_gap );
+		tftp->rollback = first_gap;
+		tftp_send_packet ( tftp );
+	} else {
+		stop_timer ( &tftp->timer );
+		start_timer ( &tftp->timer );
+	}
 
 	/* Stop profiling client turnaround */
 	profile_stop ( &tftp_client_profiler );
@@ -899,6 +993,7 @@ static int tftp_errcode_to_rc ( unsigned int errcode ) {
  */
 static int tftp_rx_error ( struct tftp_request *tftp, void *buf, size_t len ) {
 	struct tftp_error *error = buf;
+	unsigned int errcode;
 	int rc;
 
 	/* Sanity check */
@@ -911,9 +1006,27 @@ static int tftp_rx_error ( struct tftp_request *tftp, void *buf, size_t len ) {
 	DBGC ( tftp, "TFTP %p received ERROR packet with code %d, message "
 	       "\"%s\"\n", tftp, ntohs ( error->errcode ), error->errmsg );
 	
+	/* Retry with the standard block size if the server rejected
+	 * a jumbo block size.
+	 */
+	errcode = ntohs ( error->errcode );
+	if ( ( errcode == TFTP_ERR_BAD_OPTS ) &&
+	     ( tftp->flags & TFTP_FL_RRQ_JUMBO ) &&
+	     ( tftp->flags & TFTP_FL_RRQ_SIZES ) &&
+	     ( ! tftp->bitmap.length ) ) {
+		DBGC ( tftp, "TFTP %p retrying without jumbo blksize\n",
+		       tftp );
+		tftp->flags |= TFTP_FL_NO_JUMBO;
+		if ( ( rc = tftp_reopen ( tftp ) ) != 0 )
+			goto done;
+		start_timer_nodelay ( &tftp->timer );
+		return 0;
+	}
+
 	/* Determine final operation result */
-	rc = tftp_errcode_to_rc ( ntohs ( error->errcode ) );
+	rc = tftp_errcode_to_rc ( errcode );
 
+ done:
 	/* Close TFTP request */
 	tftp_done ( tftp, rc );
 
@@ -113,6 +113,8 @@ struct validator {
 	struct x509_chain *chain;
 	/** OCSP check */
 	struct ocsp_check *ocsp;
+	/** Stapled OCSP response for first certificate (if any) */
+	struct asn1_cursor stapled;
 	/** Data buffer */
 	struct xfer_buffer buffer;
 
@@ -492,6 +494,68 @@ static const struct validator_action validator_ocsp = {
 	.done = validator_ocsp_validate,
 };
 
+/**
+ * Check stapled OCSP response
+ *
+ * @v validator		Certificate validator
+ * @v cert		Certificate to check
+ * @v issuer		Issuing certificate
+ * @ret rc		Return status code
+ */
+static int validator_stapled_ocsp ( struct validator *validator,
+				    struct x509_certificate *cert,
+				    struct x509_certificate *issuer ) {
+	struct ocsp_check *ocsp;
+	time_t now;
+	int rc;
+
+	/* A stapled response is applicable only to the first
+	 * certificate in the chain.
+	 */
+	if ( ( ! validator->stapled.len ) ||
+	     ( cert != x509_first ( validator->chain ) ) ) {
+		return -ENOENT;
+	}
+
+	/* Create OCSP check */
+	if ( ( rc = ocsp_check ( cert, issuer, &ocsp ) ) != 0 ) {
+		DBGC ( validator, "VALIDATOR %p \"%s\" could not create OCSP "
+		       "check: %s\n", validator, validator_name ( validator ),
+		       strerror ( rc ) );
+		goto err_check;
+	}
+
+	/* Record stapled OCSP response */
+	if ( ( rc = ocsp_response ( ocsp, validator->stapled.data,
+				    validator->stapled.len ) ) != 0 ) {
+		DBGC ( validator, "VALIDATOR %p \"%s\" could not record "
+		       "stapled OCSP response: %s\n", validator,
+		       validator_name ( validator ), strerror ( rc ) );
+		goto err_response;
+	}
+
+	/* Validate stapled OCSP response */
+	now = time ( NULL );
+	if ( ( rc = ocsp_validate ( ocsp, now ) ) != 0 ) {
+		DBGC ( validator, "VALIDATOR %p \"%s\" could not validate "
+		       "stapled OCSP response: %s\n", validator,
+		       validator_name ( validator ), strerror ( rc ) );
+		goto err_validate;
+	}
+
+	/* Success */
+	DBGC ( validator, "VALIDATOR %p \"%s\" checked ",
+	       validator, validator_name ( validator ) );
+	DBGC ( validator, "\"%s\" via stapled OCSP\n", x509_name ( cert ) );
+
+ err_validate:
+ err_response:
+	ocsp_put ( ocsp );
+ err_check:
+	validator->rc = rc;
+	return rc;
+}
+
 /**
  * Start OCSP check
  *
@@ -665,7 +729,8 @@ static void validator_step ( struct validator *validator ) {
 		       validator, validator_name ( validator ) );
 		DBGC ( validator, "\"%s\"%s%s%s%s%s\n",
 		       x509_name ( link->cert ),
-		       ( ocsp_required ( link->cert ) ? " [NEEDOCSP]" : "" ),
+		       ( ocsp_required ( link->cert, now ) ?
+			 " [NEEDOCSP]" : "" ),
 		       ( ( link->flags & X509_LINK_FL_OCSPED ) ?
 			 " [OCSPED]" : "" ),
 		       ( ( link->flags & X509_LINK_FL_CROSSED ) ?
@@ -692,11 +757,19 @@ static void validator_step ( struct validator *validator ) {
 	 */
 	if ( ( ! list_is_head_entry ( link, &chain->links, list ) ) &&
 	     ( ! ( link->flags & X509_LINK_FL_OCSPED ) ) &&
-	     ( prev != NULL ) && ocsp_required ( prev->cert ) ) {
+	     ( prev != NULL ) && ocsp_required ( prev->cert, now ) ) {
 
 		/* Mark OCSP as attempted with this issuer */
 		link->flags |= X509_LINK_FL_OCSPED;
 
+		/* Use stapled OCSP response, if available */
+		if ( ( rc = validator_stapled_ocsp ( validator, prev->cert,
+						     link->cert ) ) == 0 ) {
+			/* Retry validation */
+			process_add ( &validator->process );
+			return;
+		}
+
 		/* Start OCSP */
 		if ( ( rc = validator_start_ocsp ( validator, prev->cert,
 						   link->cert ) ) == 0 ) {
@@ -755,11 +828,15 @@ static struct process_descriptor validator_process_desc =
  * @v job		Job control interface
  * @v chain		X.509 certificate chain
  * @v root		Root of trust, or NULL to use default
+ * @v stapled		Stapled OCSP response for first certificate, or NULL
  * @ret rc		Return status code
  */
 int create_validator ( struct interface *job, struct x509_chain *chain,
-		       struct x509_root *root ) {
+		       struct x509_root *root,
+		       const struct asn1_cursor *stapled ) {
 	struct validator *validator;
+	size_t stapled_len = ( stapled ? stapled->len : 0 );
+	void *stapled_copy;
 	int rc;
 
 	/* Sanity check */
@@ -769,7 +846,7 @@ int create_validator ( struct interface *job, struct x509_chain *chain,
 	}
 
 	/* Allocate and initialise structure */
-	validator = zalloc ( sizeof ( *validator ) );
+	validator = zalloc ( sizeof ( *validator ) + stapled_len );
 	if ( ! validator ) {
 		rc = -ENOMEM;
 		goto err_alloc;
@@ -785,6 +862,15 @@ int create_validator ( struct interface *job, struct x509_chain *chain,
 	validator->chain = x509_chain_get ( chain );
 	xferbuf_malloc_init ( &validator->buffer );
 
+	/* Record stapled OCSP response, if any */
+	if ( stapled_len ) {
+		stapled_copy = ( ( ( void * ) validator ) +
+				 sizeof ( *validator ) );
+		memcpy ( stapled_copy, stapled->data, stapled_len );
+		validator->stapled.data = stapled_copy;
+		validator->stapled.len = stapled_len;
+	}
+
 	/* Attach parent interface, mortalise self, and return */
 	intf_plug_plug ( &validator->job, job );
 	ref_put ( &validator->refcnt );
@@ -70,8 +70,17 @@ static unsigned int vlan_auto_tag;
  */
 static int vlan_open ( struct net_device *netdev ) {
 	struct vlan_device *vlan = netdev->priv;
+	int rc;
+
+	/* Open trunk device */
+	if ( ( rc = netdev_open ( vlan->trunk ) ) != 0 )
+		return rc;
 
-	return netdev_open ( vlan->trunk );
+	/* Inherit transmit offload capabilities from trunk device */
+	netdev->tx_offloads = ( vlan->trunk->tx_offloads &
+				~NETDEV_TX_OFFLOAD_VLAN );
+
+	return 0;
 }
 
 /**
@@ -106,6 +115,24 @@ static int vlan_transmit ( struct net_device *netdev,
 	unsigned int flags;
 	int rc;
 
+	/* Use hardware tag insertion, if supported by the trunk device */
+	if ( trunk->tx_offloads & NETDEV_TX_OFFLOAD_VLAN ) {
+
+		/* Mark for tag insertion */
+		iobuf->flags |= IOB_TX_VLAN;
+		iobuf->vlan_tci = VLAN_TCI ( vlan->tag, vlan->priority );
+
+		/* Reclaim I/O buffer from VLAN device's TX queue */
+		list_del ( &iobuf->list );
+
+		/* Transmit packet on trunk device.  Cannot return an
+		 * error status, since that would cause the I/O buffer
+		 * to be double-freed.
+		 */
+		netdev_tx ( trunk, iob_disown ( iobuf ) );
+		return 0;
+	}
+
 	/* Strip link-layer header and preserve link-layer header fields */
 	ll_protocol = netdev->ll_protocol;
 	if ( ( rc = ll_protocol->pull ( netdev, iobuf, &ll_dest, &ll_source,
@@ -152,10 +152,11 @@ CIPHER_TEST ( aes_256_cbc, &aes_cbc_algorithm,
 		     0xda, 0x6c, 0x19, 0x07, 0x8c, 0x6a, 0x9d, 0x1b ), AUTH() );
 
 /**
- * Perform AES self-test
+ * Perform AES self-test using current implementation
  *
+ * @v impl		Implementation description
  */
-static void aes_test_exec ( void ) {
+static void aes_test_impl ( const char *impl ) {
 	struct cipher_algorithm *ecb = &aes_ecb_algorithm;
 	struct cipher_algorithm *cbc = &aes_cbc_algorithm;
 	unsigned int keylen;
@@ -170,17 +171,36 @@ static void aes_test_exec ( void ) {
 
 	/* Speed tests */
 	for ( keylen = 128 ; keylen <= 256 ; keylen += 64 ) {
-		DBG ( "AES-%d-ECB encryption required %ld cycles per byte\n",
-		      keylen, cipher_cost_encrypt ( ecb, ( keylen / 8 ) ) );
-		DBG ( "AES-%d-ECB decryption required %ld cycles per byte\n",
-		      keylen, cipher_cost_decrypt ( ecb, ( keylen / 8 ) ) );
-		DBG ( "AES-%d-CBC encryption required %ld cycles per byte\n",
-		      keylen, cipher_cost_encrypt ( cbc, ( keylen / 8 ) ) );
-		DBG ( "AES-%d-CBC decryption required %ld cycles per byte\n",
-		      keylen, cipher_cost_decrypt ( cbc, ( keylen / 8 ) ) );
+		DBG ( "AES-%d-ECB encryption (%s) required %ld cycles per "
+		      "byte\n", keylen, impl,
+		      cipher_cost_encrypt ( ecb, ( keylen / 8 ) ) );
+		DBG ( "AES-%d-ECB decryption (%s) required %ld cycles per "
+		      "byte\n", keylen, impl,
+		      cipher_cost_decrypt ( ecb, ( keylen / 8 ) ) );
+		DBG ( "AES-%d-CBC encryption (%s) required %ld cycles per "
+		      "byte\n", keylen, impl,
+		      cipher_cost_encrypt ( cbc, ( keylen / 8 ) ) );
+		DBG ( "AES-%d-CBC decryption (%s) required %ld cycles per "
+		      "byte\n", keylen, impl,
+		      cipher_cost_decrypt ( cbc, ( keylen / 8 ) ) );
 	}
 }
 
+/**
+ * Perform AES self-test
+ *
+ */
+static void aes_test_exec ( void ) {
+
+	/* Test default implementation (which may be accelerated) */
+	aes_test_impl ( "default" );
+
+	/* Test generic implementation */
+	aes_accel_disabled = 1;
+	aes_test_impl ( "generic" );
+	aes_accel_disabled = 0;
+}
+
 /** AES self-test */
 struct self_test aes_test __self_test = {
 	.name = "aes",
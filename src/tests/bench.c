@@ -0,0 +1,180 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+/** @file
+ *
+ * Benchmark infrastructure
+ *
+ * Benchmarks are built in the same way as self-tests, but are
+ * collected into a separate image (e.g. "bin-x86_64-linux/benchmarks.linux")
+ * since they are intended to be run on demand to detect performance
+ * regressions rather than to verify correctness.
+ *
+ */
+
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <ipxe/bench.h>
+#include <ipxe/timer.h>
+#include <ipxe/init.h>
+#include <ipxe/image.h>
+#include <usr/profstat.h>
+
+/**
+ * Report benchmark result
+ *
+ * @v name		Scenario name
+ * @v len		Number of payload bytes transferred
+ * @v packets		Number of packets received
+ * @v ticks		Elapsed time (in timer ticks)
+ * @v cycles		Elapsed time (in profiling timestamp units)
+ */
+void bench_report ( const char *name, size_t len, unsigned long packets,
+		    unsigned long ticks, unsigned long long cycles ) {
+	unsigned long long ms;
+	unsigned long rate;
+	unsigned long pps;
+	unsigned long cost; /* in tenths of a cycle per byte */
+
+	/* Avoid division by zero for implausibly fast runs */
+	ms = ( ( ticks * 1000ULL ) / TICKS_PER_SEC );
+	if ( ! ms )
+		ms = 1;
+
+	/* Calculate throughput, packet rate and per-byte cost */
+	rate = ( ( len * 1000ULL ) / ( ms * 1000000ULL ) );
+	pps = ( ( packets * 1000ULL ) / ms );
+	cost = ( len ? ( ( cycles * 10 ) / len ) : 0 );
+	printf ( "%s: %zd bytes in %ldms: %ld MB/s, %ld packets/s, "
+		 "%ld.%ld cycles/byte\n", name, len, ( ( unsigned long ) ms ),
+		 rate, pps, ( cost / 10 ), ( cost % 10 ) );
+}
+
+/**
+ * Report operation benchmark result
+ *
+ * @v name		Operation name
+ * @v len		Length of data processed by each operation, or zero
+ * @v count		Number of operations performed
+ * @v ticks		Elapsed time (in timer ticks)
+ * @v cycles		Elapsed time (in profiling timestamp units)
+ */
+void bench_report_ops ( const char *name, size_t len, unsigned long count,
+			unsigned long ticks, unsigned long long cycles ) {
+	unsigned long long total_len = ( ( ( unsigned long long ) len ) *
+					 count );
+	unsigned long ops;
+	unsigned long cost; /* in tenths of a cycle per byte */
+
+	/* Avoid division by zero for implausibly fast runs */
+	if ( ! ticks )
+		ticks = 1;
+	if ( ! count )
+		count = 1;
+
+	/* Calculate operation rate and cost */
+	ops = ( ( count * ( ( unsigned long long ) TICKS_PER_SEC ) ) / ticks );
+	if ( len ) {
+		cost = ( ( cycles * 10 ) / total_len );
+		printf ( "%s (%zd bytes): %ld.%ld cycles/byte, %ld ops/s\n",
+			 name, len, ( cost / 10 ), ( cost % 10 ), ops );
+	} else {
+		printf ( "%s: %lld cycles/op, %ld ops/s\n",
+			 name, ( cycles / count ), ops );
+	}
+}
+
+/**
+ * Run all benchmarks
+ *
+ * @ret rc		Return status code
+ */
+static int run_all_benchmarks ( void ) {
+	struct benchmark *bench;
+	unsigned int failures = 0;
+	int rc;
+
+	/* Run all compiled-in benchmarks */
+	printf ( "Starting %s benchmarks\n", _S2 ( ARCH ) );
+	for_each_table_entry ( bench, BENCHMARKS ) {
+		if ( ( rc = bench->exec() ) != 0 ) {
+			printf ( "FAILURE: \"%s\" benchmark failed: %s\n",
+				 bench->name, strerror ( rc ) );
+			failures++;
+		}
+	}
+
+	/* Print overall summary */
+	if ( failures ) {
+		printf ( "FAILURE: %d benchmarks failed\n", failures );
+		return -EINPROGRESS;
+	} else {
+		printf ( "OK: all benchmarks completed\n" );
+		profstat();
+		return 0;
+	}
+}
+
+static int bench_image_probe ( struct image *image __unused ) {
+	return -ENOTTY;
+}
+
+static int bench_image_exec ( struct image *image __unused ) {
+	return run_all_benchmarks();
+}
+
+static struct image_type bench_image_type = {
+	.name = "benchmarks",
+	.probe = bench_image_probe,
+	.exec = bench_image_exec,
+};
+
+static struct image bench_image = {
+	.refcnt = REF_INIT ( ref_no_free ),
+	.name = "<BENCH>",
+	.flags = ( IMAGE_STATIC | IMAGE_STATIC_NAME ),
+	.type = &bench_image_type,
+};
+
+static void bench_init ( void ) {
+	int rc;
+
+	/* Register benchmarks image */
+	if ( ( rc = register_image ( &bench_image ) ) != 0 ) {
+		DBG ( "Could not register benchmark image: %s\n",
+		      strerror ( rc ) );
+		/* No way to report failure */
+		return;
+	}
+}
+
+/** Benchmark initialisation function */
+struct init_fn bench_init_fn __init_fn ( INIT_EARLY ) = {
+	.name = "bench",
+	.initialise = bench_init,
+};
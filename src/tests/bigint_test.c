@@ -633,6 +633,15 @@ static void bigint_multiply_okx ( struct bigint_test *multiplicand,
 	DBG ( " = 0x%s\n", bigint_ntoa ( &result_temp ) );
 	bigint_done ( &result_temp, result_raw, sizeof ( result_raw ) );
 
+	okx ( memcmp ( result_raw, expected->raw, sizeof ( result_raw ) ) == 0,
+	      file, line );
+
+	/* Repeat using generic implementation */
+	bigint_accel_disabled = 1;
+	bigint_multiply ( &multiplicand_temp, &multiplier_temp, &result_temp );
+	bigint_accel_disabled = 0;
+	bigint_done ( &result_temp, result_raw, sizeof ( result_raw ) );
+
 	okx ( memcmp ( result_raw, expected->raw, sizeof ( result_raw ) ) == 0,
 	      file, line );
 }
@@ -759,6 +768,16 @@ static void bigint_montgomery_okx ( struct bigint_test *modulus,
 	DBG ( " (mod 0x%s)\n", bigint_ntoa ( &modulus_temp ) );
 	bigint_done ( &result_temp, result_raw, sizeof ( result_raw ) );
 
+	okx ( memcmp ( result_raw, expected->raw, sizeof ( result_raw ) ) == 0,
+	      file, line );
+
+	/* Repeat using generic implementation */
+	bigint_init ( &mont_temp, mont->raw, mont->len );
+	bigint_accel_disabled = 1;
+	bigint_montgomery ( &modulus_temp, &mont_temp, &result_temp );
+	bigint_accel_disabled = 0;
+	bigint_done ( &result_temp, result_raw, sizeof ( result_raw ) );
+
 	okx ( memcmp ( result_raw, expected->raw, sizeof ( result_raw ) ) == 0,
 	      file, line );
 }
@@ -798,7 +817,7 @@ static void bigint_mod_exp_okx ( struct bigint_test *base,
 	bigint_t ( size ) modulus_temp;
 	bigint_t ( exponent_size ) exponent_temp;
 	bigint_t ( size ) result_temp;
-	size_t tmp_len = bigint_mod_exp_tmp_len ( &modulus_temp );
+	size_t tmp_len = bigint_mod_exp_public_tmp_len ( &modulus_temp );
 	uint8_t tmp[tmp_len];
 
 	assert ( bigint_size ( &modulus_temp ) == bigint_size ( &base_temp ) );
@@ -815,6 +834,24 @@ static void bigint_mod_exp_okx ( struct bigint_test *base,
 	DBG ( " (mod 0x%s)\n", bigint_ntoa ( &modulus_temp ) );
 	bigint_done ( &result_temp, result_raw, sizeof ( result_raw ) );
 
+	okx ( memcmp ( result_raw, expected->raw, sizeof ( result_raw ) ) == 0,
+	      file, line );
+
+	/* Repeat using generic implementation */
+	bigint_accel_disabled = 1;
+	bigint_mod_exp ( &base_temp, &modulus_temp, &exponent_temp,
+			 &result_temp, tmp );
+	bigint_accel_disabled = 0;
+	bigint_done ( &result_temp, result_raw, sizeof ( result_raw ) );
+
+	okx ( memcmp ( result_raw, expected->raw, sizeof ( result_raw ) ) == 0,
+	      file, line );
+
+	/* Repeat using public exponent */
+	bigint_mod_exp_public ( &base_temp, &modulus_temp, &exponent_temp,
+				&result_temp, tmp );
+	bigint_done ( &result_temp, result_raw, sizeof ( result_raw ) );
+
 	okx ( memcmp ( result_raw, expected->raw, sizeof ( result_raw ) ) == 0,
 	      file, line );
 }
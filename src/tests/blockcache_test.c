@@ -0,0 +1,414 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+/** @file
+ *
+ * Block device cache tests
+ *
+ */
+
+/* Forcibly enable assertions */
+#undef NDEBUG
+
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+#include <ipxe/blockcache.h>
+#include <ipxe/test.h>
+
+/** Block size used for tests */
+#define BLOCKCACHE_BLKSIZE 16
+
+/** Device capacity used for tests (in blocks) */
+#define BLOCKCACHE_CAPACITY 100
+
+/** Number of blocks per cache line used for tests */
+#define BLOCKCACHE_LINE 8
+
+/** Number of cache lines used for tests */
+#define BLOCKCACHE_LINES 3
+
+/** Number of blocks per cache line used for read-ahead tests */
+#define BLOCKCACHE_STREAM_LINE 4
+
+/** Number of cache lines used for read-ahead tests */
+#define BLOCKCACHE_STREAM_LINES 8
+
+/** A block cache test device */
+struct blockcache_test_device {
+	/** Block cache */
+	struct block_cache cache;
+	/** Device contents */
+	uint8_t data[ BLOCKCACHE_CAPACITY * BLOCKCACHE_BLKSIZE ];
+	/** Number of underlying reads */
+	unsigned int reads;
+	/** Number of underlying writes */
+	unsigned int writes;
+	/** Starting LBA of most recent underlying read or write */
+	uint64_t lba;
+	/** Block count of most recent underlying read or write */
+	unsigned int count;
+	/** Fail underlying reads and writes */
+	int fail;
+};
+
+/**
+ * Read from test device
+ *
+ * @v cache		Block cache
+ * @v lba		Starting logical block address
+ * @v count		Number of logical blocks
+ * @v buffer		Data buffer
+ * @ret rc		Return status code
+ */
+static int blockcache_test_read ( struct block_cache *cache, uint64_t lba,
+				  unsigned int count, void *buffer ) {
+	struct blockcache_test_device *dev =
+		container_of ( cache, struct blockcache_test_device, cache );
+
+	dev->reads++;
+	dev->lba = lba;
+	dev->count = count;
+	if ( dev->fail || ( ( lba + count ) > BLOCKCACHE_CAPACITY ) )
+		return -1;
+	memcpy ( buffer, &dev->data[ lba * BLOCKCACHE_BLKSIZE ],
+		 ( count * BLOCKCACHE_BLKSIZE ) );
+	return 0;
+}
+
+/**
+ * Write to test device
+ *
+ * @v cache		Block cache
+ * @v lba		Starting logical block address
+ * @v count		Number of logical blocks
+ * @v buffer		Data buffer
+ * @ret rc		Return status code
+ */
+static int blockcache_test_write ( struct block_cache *cache, uint64_t lba,
+				   unsigned int count, void *buffer ) {
+	struct blockcache_test_device *dev =
+		container_of ( cache, struct blockcache_test_device, cache );
+
+	dev->writes++;
+	dev->lba = lba;
+	dev->count = count;
+	if ( dev->fail || ( ( lba + count ) > BLOCKCACHE_CAPACITY ) )
+		return -1;
+	memcpy ( &dev->data[ lba * BLOCKCACHE_BLKSIZE ], buffer,
+		 ( count * BLOCKCACHE_BLKSIZE ) );
+	return 0;
+}
+
+/** Test device block cache operations */
+static struct block_cache_operations blockcache_test_op = {
+	.read = blockcache_test_read,
+	.write = blockcache_test_write,
+};
+
+/** Test device */
+static struct blockcache_test_device blockcache_dev;
+
+/**
+ * Report block cache read test result
+ *
+ * @v lba		Starting logical block address
+ * @v count		Number of logical blocks
+ * @v reads		Expected number of underlying reads
+ * @v file		Test code file
+ * @v line		Test code line
+ */
+static void blockcache_read_okx ( uint64_t lba, unsigned int count,
+				  unsigned int reads, const char *file,
+				  unsigned int line ) {
+	struct blockcache_test_device *dev = &blockcache_dev;
+	uint8_t buf[ count * BLOCKCACHE_BLKSIZE ];
+	unsigned int before = dev->reads;
+
+	memset ( buf, 0, sizeof ( buf ) );
+	okx ( block_cache_read ( &dev->cache, lba, count, buf ) == 0,
+	      file, line );
+	okx ( memcmp ( buf, &dev->data[ lba * BLOCKCACHE_BLKSIZE ],
+		       sizeof ( buf ) ) == 0, file, line );
+	okx ( ( dev->reads - before ) == reads, file, line );
+}
+#define blockcache_read_ok( lba, count, reads ) \
+	blockcache_read_okx ( lba, count, reads, __FILE__, __LINE__ )
+
+/**
+ * Report block cache write test result
+ *
+ * @v lba		Starting logical block address
+ * @v count		Number of logical blocks
+ * @v fill		Data fill byte
+ * @v writes		Expected number of underlying writes
+ * @v file		Test code file
+ * @v line		Test code line
+ */
+static void blockcache_write_okx ( uint64_t lba, unsigned int count,
+				   uint8_t fill, unsigned int writes,
+				   const char *file, unsigned int line ) {
+	struct blockcache_test_device *dev = &blockcache_dev;
+	uint8_t buf[ count * BLOCKCACHE_BLKSIZE ];
+	unsigned int before = dev->writes;
+
+	memset ( buf, fill, sizeof ( buf ) );
+	okx ( block_cache_write ( &dev->cache, lba, count, buf ) == 0,
+	      file, line );
+	okx ( ( dev->writes - before ) == writes, file, line );
+}
+#define blockcache_write_ok( lba, count, fill, writes ) \
+	blockcache_write_okx ( lba, count, fill, writes, __FILE__, __LINE__ )
+
+/**
+ * Report block cache written data test result
+ *
+ * @v lba		Starting logical block address
+ * @v count		Number of logical blocks
+ * @v fill		Expected data fill byte
+ * @v file		Test code file
+ * @v line		Test code line
+ */
+static void blockcache_fill_okx ( uint64_t lba, unsigned int count,
+				  uint8_t fill, const char *file,
+				  unsigned int line ) {
+	struct blockcache_test_device *dev = &blockcache_dev;
+	uint8_t buf[ count * BLOCKCACHE_BLKSIZE ];
+	uint8_t expected[ count * BLOCKCACHE_BLKSIZE ];
+
+	memset ( buf, 0, sizeof ( buf ) );
+	memset ( expected, fill, sizeof ( expected ) );
+	okx ( block_cache_read ( &dev->cache, lba, count, buf ) == 0,
+	      file, line );
+	okx ( memcmp ( buf, expected, sizeof ( buf ) ) == 0, file, line );
+}
+#define blockcache_fill_ok( lba, count, fill ) \
+	blockcache_fill_okx ( lba, count, fill, __FILE__, __LINE__ )
+
+/**
+ * Perform block cache self-tests
+ *
+ */
+static void blockcache_test_exec ( void ) {
+	struct blockcache_test_device *dev = &blockcache_dev;
+	struct block_cache *cache = &dev->cache;
+	uint8_t buf[ BLOCKCACHE_BLKSIZE ];
+	unsigned int i;
+
+	/* Initialise test device */
+	for ( i = 0 ; i < sizeof ( dev->data ) ; i++ )
+		dev->data[i] = ( ( i * 7 ) ^ ( i >> 4 ) );
+	block_cache_init ( cache, &blockcache_test_op );
+
+	/* Disabled cache passes reads straight through */
+	ok ( block_cache_alloc ( cache, BLOCKCACHE_BLKSIZE,
+				 BLOCKCACHE_CAPACITY, 0, 0 ) == 0 );
+	blockcache_read_ok ( 3, 1, 1 );
+	ok ( dev->lba == 3 );
+	ok ( dev->count == 1 );
+
+	/* Allocate cache */
+	ok ( block_cache_alloc ( cache, BLOCKCACHE_BLKSIZE,
+				 BLOCKCACHE_CAPACITY, BLOCKCACHE_LINE,
+				 BLOCKCACHE_LINES ) == 0 );
+	ok ( cache->blocks == BLOCKCACHE_LINE );
+
+	/* Small reads fill a whole aligned line */
+	blockcache_read_ok ( 3, 1, 1 );
+	ok ( dev->lba == 0 );
+	ok ( dev->count == BLOCKCACHE_LINE );
+	blockcache_read_ok ( 0, 7, 0 );
+	blockcache_read_ok ( 5, 3, 0 );
+	ok ( cache->hits == 2 );
+	ok ( cache->misses == 1 );
+
+	/* Reads spanning lines fill each line */
+	blockcache_read_ok ( 6, 4, 1 );
+	ok ( dev->lba == 8 );
+	blockcache_read_ok ( 7, 2, 0 );
+
+	/* Whole-line reads bypass the cache */
+	blockcache_read_ok ( 16, 8, 1 );
+	ok ( dev->lba == 16 );
+	ok ( dev->count == 8 );
+	blockcache_read_ok ( 17, 1, 1 );
+	ok ( dev->lba == 16 );
+
+	/* Least recently used line is evicted */
+	blockcache_read_ok ( 2, 1, 0 );
+	blockcache_read_ok ( 24, 1, 1 );
+	blockcache_read_ok ( 1, 1, 0 );
+	blockcache_read_ok ( 9, 1, 1 );
+	blockcache_read_ok ( 18, 1, 1 );
+
+	/* Final line is truncated at end of device */
+	blockcache_read_ok ( 97, 3, 1 );
+	ok ( dev->lba == 96 );
+	ok ( dev->count == 4 );
+	blockcache_read_ok ( 96, 1, 0 );
+
+	/* Reads beyond end of device are passed through */
+	ok ( block_cache_read ( cache, 100, 1, buf ) != 0 );
+	ok ( dev->lba == 100 );
+	ok ( block_cache_read ( cache, 99, 2, buf ) != 0 );
+	ok ( dev->lba == 100 );
+
+	/* Invalidated lines are refilled */
+	dev->data[ 97 * BLOCKCACHE_BLKSIZE ] ^= 0xff;
+	block_cache_invalidate ( cache, 90, 8 );
+	blockcache_read_ok ( 97, 1, 1 );
+	block_cache_invalidate ( cache, 0, 96 );
+	blockcache_read_ok ( 97, 1, 0 );
+
+	/* Failed line fills are not cached */
+	dev->fail = 1;
+	ok ( block_cache_read ( cache, 40, 1, buf ) != 0 );
+	ok ( block_cache_read ( cache, 97, 1, buf ) == 0 );
+	dev->fail = 0;
+	blockcache_read_ok ( 40, 1, 1 );
+
+	/* Reallocate cache with room for sequential read-ahead */
+	ok ( block_cache_alloc ( cache, BLOCKCACHE_BLKSIZE,
+				 BLOCKCACHE_CAPACITY, BLOCKCACHE_STREAM_LINE,
+				 BLOCKCACHE_STREAM_LINES ) == 0 );
+	ok ( cache->ahead == ( BLOCKCACHE_STREAM_LINES / 2 ) );
+	blockcache_read_ok ( 40, 1, 1 );
+	ok ( dev->count == 4 );
+
+	/* Sequential fills double the read-ahead window */
+	blockcache_read_ok ( 0, 1, 1 );
+	ok ( dev->lba == 0 );
+	ok ( dev->count == 4 );
+	blockcache_read_ok ( 4, 1, 1 );
+	ok ( dev->lba == 4 );
+	ok ( dev->count == 8 );
+	blockcache_read_ok ( 8, 1, 0 );
+	blockcache_read_ok ( 12, 1, 1 );
+	ok ( dev->lba == 12 );
+	ok ( dev->count == 16 );
+	blockcache_read_ok ( 19, 3, 0 );
+	blockcache_read_ok ( 26, 1, 0 );
+
+	/* Read-ahead stops at the first line already present */
+	blockcache_read_ok ( 28, 1, 1 );
+	ok ( dev->lba == 28 );
+	ok ( dev->count == 12 );
+
+	/* Read-ahead window is limited to half of the cache */
+	blockcache_read_ok ( 41, 1, 1 );
+	ok ( dev->lba == 40 );
+	ok ( dev->count == 16 );
+	blockcache_read_ok ( 47, 3, 0 );
+	blockcache_read_ok ( 54, 1, 0 );
+
+	/* Non-sequential fills reset the read-ahead window */
+	blockcache_read_ok ( 80, 1, 1 );
+	ok ( dev->count == 4 );
+	blockcache_read_ok ( 84, 1, 1 );
+	ok ( dev->count == 8 );
+
+	/* Read-ahead is truncated at end of device */
+	blockcache_read_ok ( 92, 1, 1 );
+	ok ( dev->lba == 92 );
+	ok ( dev->count == 8 );
+	blockcache_read_ok ( 99, 1, 0 );
+
+	/* Failed read-ahead fills are not cached */
+	dev->fail = 1;
+	ok ( block_cache_read ( cache, 60, 1, buf ) != 0 );
+	dev->fail = 0;
+	blockcache_read_ok ( 60, 1, 1 );
+	ok ( dev->count == 4 );
+
+	/* Free cache */
+	block_cache_free ( cache );
+	blockcache_read_ok ( 40, 1, 1 );
+
+	/* Writes pass straight through unless write-back is enabled */
+	ok ( block_cache_alloc ( cache, BLOCKCACHE_BLKSIZE,
+				 BLOCKCACHE_CAPACITY, BLOCKCACHE_LINE,
+				 BLOCKCACHE_LINES ) == 0 );
+	blockcache_read_ok ( 10, 1, 1 );
+	blockcache_write_ok ( 10, 2, 0x11, 1 );
+	ok ( dev->lba == 10 );
+	ok ( dev->count == 2 );
+	ok ( dev->data[ 11 * BLOCKCACHE_BLKSIZE ] == 0x11 );
+	blockcache_fill_ok ( 10, 2, 0x11 );
+
+	/* Adjacent and overlapping writes are coalesced */
+	cache->dirty_max = ( 8 * BLOCKCACHE_BLKSIZE );
+	blockcache_write_ok ( 20, 2, 0x22, 0 );
+	blockcache_write_ok ( 22, 2, 0x33, 0 );
+	blockcache_write_ok ( 19, 2, 0x44, 0 );
+	ok ( cache->extents == 1 );
+	ok ( cache->dirty_len == ( 5 * BLOCKCACHE_BLKSIZE ) );
+	blockcache_fill_ok ( 19, 2, 0x44 );
+	blockcache_fill_ok ( 21, 1, 0x22 );
+	blockcache_fill_ok ( 22, 2, 0x33 );
+
+	/* Separate extents are flushed in order of block address */
+	blockcache_write_ok ( 5, 1, 0x55, 0 );
+	ok ( cache->extents == 2 );
+	blockcache_fill_ok ( 5, 1, 0x55 );
+	i = dev->writes;
+	ok ( block_cache_flush ( cache ) == 0 );
+	ok ( ( dev->writes - i ) == 2 );
+	ok ( dev->lba == 19 );
+	ok ( dev->count == 5 );
+	ok ( ! block_cache_is_dirty ( cache ) );
+	ok ( dev->data[ 5 * BLOCKCACHE_BLKSIZE ] == 0x55 );
+	ok ( dev->data[ 23 * BLOCKCACHE_BLKSIZE ] == 0x33 );
+
+	/* Exceeding the limit flushes existing dirty data */
+	blockcache_write_ok ( 30, 6, 0x66, 0 );
+	blockcache_write_ok ( 40, 4, 0x77, 1 );
+	ok ( dev->lba == 30 );
+	ok ( cache->extents == 1 );
+
+	/* Writes larger than the limit pass straight through */
+	blockcache_write_ok ( 50, 9, 0x88, 2 );
+	ok ( dev->lba == 50 );
+	ok ( ! block_cache_is_dirty ( cache ) );
+	blockcache_fill_ok ( 40, 4, 0x77 );
+	blockcache_fill_ok ( 50, 9, 0x88 );
+
+	/* Failed flushes leave data dirty */
+	blockcache_write_ok ( 60, 1, 0x99, 0 );
+	dev->fail = 1;
+	ok ( block_cache_flush ( cache ) != 0 );
+	dev->fail = 0;
+	ok ( block_cache_is_dirty ( cache ) );
+	ok ( block_cache_flush ( cache ) == 0 );
+	ok ( dev->data[ 60 * BLOCKCACHE_BLKSIZE ] == 0x99 );
+
+	/* Free cache */
+	block_cache_free ( cache );
+}
+
+/** Block device cache self-test */
+struct self_test blockcache_test __self_test = {
+	.name = "blockcache",
+	.exec = blockcache_test_exec,
+};
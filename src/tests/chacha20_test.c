@@ -0,0 +1,168 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+/** @file
+ *
+ * ChaCha20 and ChaCha20-Poly1305 tests
+ *
+ * These test vectors are taken from RFC 8439.
+ *
+ */
+
+/* Forcibly enable assertions */
+#undef NDEBUG
+
+#include <ipxe/chacha20.h>
+#include <ipxe/test.h>
+#include "cipher_test.h"
+
+/** "Sunscreen" plaintext (from RFC 8439 section 2.4.2) */
+#define CHACHA20_PLAINTEXT_SUNSCREEN					\
+	PLAINTEXT ( 0x4c, 0x61, 0x64, 0x69, 0x65, 0x73, 0x20, 0x61,	\
+		    0x6e, 0x64, 0x20, 0x47, 0x65, 0x6e, 0x74, 0x6c,	\
+		    0x65, 0x6d, 0x65, 0x6e, 0x20, 0x6f, 0x66, 0x20,	\
+		    0x74, 0x68, 0x65, 0x20, 0x63, 0x6c, 0x61, 0x73,	\
+		    0x73, 0x20, 0x6f, 0x66, 0x20, 0x27, 0x39, 0x39,	\
+		    0x3a, 0x20, 0x49, 0x66, 0x20, 0x49, 0x20, 0x63,	\
+		    0x6f, 0x75, 0x6c, 0x64, 0x20, 0x6f, 0x66, 0x66,	\
+		    0x65, 0x72, 0x20, 0x79, 0x6f, 0x75, 0x20, 0x6f,	\
+		    0x6e, 0x6c, 0x79, 0x20, 0x6f, 0x6e, 0x65, 0x20,	\
+		    0x74, 0x69, 0x70, 0x20, 0x66, 0x6f, 0x72, 0x20,	\
+		    0x74, 0x68, 0x65, 0x20, 0x66, 0x75, 0x74, 0x75,	\
+		    0x72, 0x65, 0x2c, 0x20, 0x73, 0x75, 0x6e, 0x73,	\
+		    0x63, 0x72, 0x65, 0x65, 0x6e, 0x20, 0x77, 0x6f,	\
+		    0x75, 0x6c, 0x64, 0x20, 0x62, 0x65, 0x20, 0x69,	\
+		    0x74, 0x2e )
+
+/** All-zero key and nonce (from RFC 8439 appendix A.1) */
+CIPHER_TEST ( chacha20_zero, &chacha20_algorithm,
+	      KEY ( 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+		    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+		    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+		    0x00, 0x00, 0x00, 0x00, 0x00 ),
+	      IV ( 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+		   0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 ),
+	      ADDITIONAL(),
+	      PLAINTEXT ( 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+			  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+			  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+			  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+			  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+			  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+			  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+			  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 ),
+	      CIPHERTEXT ( 0x76, 0xb8, 0xe0, 0xad, 0xa0, 0xf1, 0x3d, 0x90,
+			   0x40, 0x5d, 0x6a, 0xe5, 0x53, 0x86, 0xbd, 0x28,
+			   0xbd, 0xd2, 0x19, 0xb8, 0xa0, 0x8d, 0xed, 0x1a,
+			   0xa8, 0x36, 0xef, 0xcc, 0x8b, 0x77, 0x0d, 0xc7,
+			   0xda, 0x41, 0x59, 0x7c, 0x51, 0x57, 0x48, 0x8d,
+			   0x77, 0x24, 0xe0, 0x3f, 0xb8, 0xd8, 0x4a, 0x37,
+			   0x6a, 0x43, 0xb8, 0xf4, 0x15, 0x18, 0xa1, 0x1c,
+			   0xc3, 0x87, 0xb6, 0x69, 0xb2, 0xee, 0x65, 0x86 ),
+	      AUTH() );
+
+/** Sunscreen (from RFC 8439 section 2.4.2) */
+CIPHER_TEST ( chacha20_sunscreen, &chacha20_algorithm,
+	      KEY ( 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08,
+		    0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f, 0x10, 0x11,
+		    0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0x1a,
+		    0x1b, 0x1c, 0x1d, 0x1e, 0x1f ),
+	      IV ( 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+		   0x00, 0x00, 0x4a, 0x00, 0x00, 0x00, 0x00 ),
+	      ADDITIONAL(),
+	      CHACHA20_PLAINTEXT_SUNSCREEN,
+	      CIPHERTEXT ( 0x6e, 0x2e, 0x35, 0x9a, 0x25, 0x68, 0xf9, 0x80,
+			   0x41, 0xba, 0x07, 0x28, 0xdd, 0x0d, 0x69, 0x81,
+			   0xe9, 0x7e, 0x7a, 0xec, 0x1d, 0x43, 0x60, 0xc2,
+			   0x0a, 0x27, 0xaf, 0xcc, 0xfd, 0x9f, 0xae, 0x0b,
+			   0xf9, 0x1b, 0x65, 0xc5, 0x52, 0x47, 0x33, 0xab,
+			   0x8f, 0x59, 0x3d, 0xab, 0xcd, 0x62, 0xb3, 0x57,
+			   0x16, 0x39, 0xd6, 0x24, 0xe6, 0x51, 0x52, 0xab,
+			   0x8f, 0x53, 0x0c, 0x35, 0x9f, 0x08, 0x61, 0xd8,
+			   0x07, 0xca, 0x0d, 0xbf, 0x50, 0x0d, 0x6a, 0x61,
+			   0x56, 0xa3, 0x8e, 0x08, 0x8a, 0x22, 0xb6, 0x5e,
+			   0x52, 0xbc, 0x51, 0x4d, 0x16, 0xcc, 0xf8, 0x06,
+			   0x81, 0x8c, 0xe9, 0x1a, 0xb7, 0x79, 0x37, 0x36,
+			   0x5a, 0xf9, 0x0b, 0xbf, 0x74, 0xa3, 0x5b, 0xe6,
+			   0xb4, 0x0b, 0x8e, 0xed, 0xf2, 0x78, 0x5e, 0x42,
+			   0x87, 0x4d ),
+	      AUTH() );
+
+/** Sunscreen AEAD (from RFC 8439 section 2.8.2) */
+CIPHER_TEST ( chacha20_poly1305_sunscreen, &chacha20_poly1305_algorithm,
+	      KEY ( 0x80, 0x81, 0x82, 0x83, 0x84, 0x85, 0x86, 0x87, 0x88,
+		    0x89, 0x8a, 0x8b, 0x8c, 0x8d, 0x8e, 0x8f, 0x90, 0x91,
+		    0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9a,
+		    0x9b, 0x9c, 0x9d, 0x9e, 0x9f ),
+	      IV ( 0x07, 0x00, 0x00, 0x00, 0x40, 0x41, 0x42, 0x43, 0x44,
+		   0x45, 0x46, 0x47 ),
+	      ADDITIONAL ( 0x50, 0x51, 0x52, 0x53, 0xc0, 0xc1, 0xc2, 0xc3,
+			   0xc4, 0xc5, 0xc6, 0xc7 ),
+	      CHACHA20_PLAINTEXT_SUNSCREEN,
+	      CIPHERTEXT ( 0xd3, 0x1a, 0x8d, 0x34, 0x64, 0x8e, 0x60, 0xdb,
+			   0x7b, 0x86, 0xaf, 0xbc, 0x53, 0xef, 0x7e, 0xc2,
+			   0xa4, 0xad, 0xed, 0x51, 0x29, 0x6e, 0x08, 0xfe,
+			   0xa9, 0xe2, 0xb5, 0xa7, 0x36, 0xee, 0x62, 0xd6,
+			   0x3d, 0xbe, 0xa4, 0x5e, 0x8c, 0xa9, 0x67, 0x12,
+			   0x82, 0xfa, 0xfb, 0x69, 0xda, 0x92, 0x72, 0x8b,
+			   0x1a, 0x71, 0xde, 0x0a, 0x9e, 0x06, 0x0b, 0x29,
+			   0x05, 0xd6, 0xa5, 0xb6, 0x7e, 0xcd, 0x3b, 0x36,
+			   0x92, 0xdd, 0xbd, 0x7f, 0x2d, 0x77, 0x8b, 0x8c,
+			   0x98, 0x03, 0xae, 0xe3, 0x28, 0x09, 0x1b, 0x58,
+			   0xfa, 0xb3, 0x24, 0xe4, 0xfa, 0xd6, 0x75, 0x94,
+			   0x55, 0x85, 0x80, 0x8b, 0x48, 0x31, 0xd7, 0xbc,
+			   0x3f, 0xf4, 0xde, 0xf0, 0x8e, 0x4b, 0x7a, 0x9d,
+			   0xe5, 0x76, 0xd2, 0x65, 0x86, 0xce, 0xc6, 0x4b,
+			   0x61, 0x16 ),
+	      AUTH ( 0x1a, 0xe1, 0x0b, 0x59, 0x4f, 0x09, 0xe2, 0x6a, 0x7e,
+		     0x90, 0x2e, 0xcb, 0xd0, 0x60, 0x06, 0x91 ) );
+
+/**
+ * Perform ChaCha20 self-tests
+ *
+ */
+static void chacha20_test_exec ( void ) {
+
+	/* Correctness tests */
+	cipher_ok ( &chacha20_zero );
+	cipher_ok ( &chacha20_sunscreen );
+	cipher_ok ( &chacha20_poly1305_sunscreen );
+
+	/* Speed tests */
+	DBG ( "ChaCha20 encryption required %ld cycles per byte\n",
+	      cipher_cost_encrypt ( &chacha20_algorithm, CHACHA20_KEY_LEN ) );
+	DBG ( "ChaCha20-Poly1305 encryption required %ld cycles per byte\n",
+	      cipher_cost_encrypt ( &chacha20_poly1305_algorithm,
+				    CHACHA20_KEY_LEN ) );
+	DBG ( "ChaCha20-Poly1305 decryption required %ld cycles per byte\n",
+	      cipher_cost_decrypt ( &chacha20_poly1305_algorithm,
+				    CHACHA20_KEY_LEN ) );
+}
+
+/** ChaCha20 self-test */
+struct self_test chacha20_test __self_test = {
+	.name = "chacha20",
+	.exec = chacha20_test_exec,
+};
@@ -1740,6 +1740,65 @@ static void cms_verify_fail_okx ( struct cms_test_message *msg,
 	cms_verify_fail_okx ( msg, img, name, time, store, root,	\
 			      __FILE__, __LINE__ )
 
+/**
+ * Report signature verification using accumulated digest test result
+ *
+ * @v msg		Test signature message
+ * @v img		Test signed image
+ * @v split		Offset at which to split accumulated data
+ * @v reorder		Accumulate data out of order
+ * @v corrupt		Corrupt accumulated data
+ * @v expected		Expected verification result
+ * @v file		Test code file
+ * @v line		Test code line
+ */
+static void cms_verify_digest_okx ( struct cms_test_message *msg,
+				    struct cms_test_image *img, size_t split,
+				    int reorder, int corrupt, int expected,
+				    const char *file, unsigned int line ) {
+	struct cms_participant *part =
+		list_first_entry ( &msg->cms->participants,
+				   struct cms_participant, list );
+	const uint8_t *data = img->image.data;
+	size_t len = img->image.len;
+	uint8_t first;
+	int rc;
+
+	/* Invalidate any certificates from previous tests */
+	x509_invalidate_chain ( msg->cms->certificates );
+
+	/* Accumulate digest as though downloading */
+	okx ( part != NULL, file, line );
+	okx ( split < len, file, line );
+	okx ( image_digest_start ( &img->image, part->digest ) == 0,
+	      file, line );
+	first = ( data[0] ^ ( corrupt ? 0xff : 0x00 ) );
+	if ( reorder ) {
+		image_digest_update ( &img->image, split, ( data + split ),
+				      ( len - split ) );
+	}
+	image_digest_update ( &img->image, 0, &first, sizeof ( first ) );
+	image_digest_update ( &img->image, sizeof ( first ),
+			      ( data + sizeof ( first ) ),
+			      ( split - sizeof ( first ) ) );
+	if ( ! reorder ) {
+		image_digest_update ( &img->image, split, ( data + split ),
+				      ( len - split ) );
+	}
+
+	/* Check verification result */
+	rc = cms_verify ( msg->cms, &img->image, NULL, test_time,
+			  &empty_store, &test_root );
+	okx ( ( rc == 0 ) == expected, file, line );
+
+	/* Discard accumulated digest */
+	image_digest_discard ( &img->image );
+}
+#define cms_verify_digest_ok( msg, img, split, reorder, corrupt,	\
+			      expected )				\
+	cms_verify_digest_okx ( msg, img, split, reorder, corrupt,	\
+				expected, __FILE__, __LINE__ )
+
 /**
  * Report decryption test result
  *
@@ -1821,6 +1880,15 @@ static void cms_test_exec ( void ) {
 	cms_verify_fail_ok ( &codesigned_sig, &test_code,
 			     NULL, test_expired, &empty_store, &test_root );
 
+	/* Check signature using digest accumulated during download */
+	cms_verify_digest_ok ( &codesigned_sig, &test_code, 7, 0, 0, 1 );
+
+	/* Check that accumulated digest is used in preference */
+	cms_verify_digest_ok ( &codesigned_sig, &test_code, 7, 0, 1, 0 );
+
+	/* Check that out-of-order digest is ignored */
+	cms_verify_digest_ok ( &codesigned_sig, &test_code, 7, 1, 1, 1 );
+
 	/* Check CBC decryption (with padding) */
 	cms_decrypt_ok ( &hidden_code_cbc_dat, &hidden_code_cbc_env,
 			 &client_keypair, &hidden_code );
@@ -34,12 +34,18 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
  *
  *    printf "%#08x", crc ( $data, 32, $seed, 0, 1, 0x04c11db7, 1 );
  *
+ * CRC32C test vectors are taken from RFC 3720 Appendix B.4 (with the
+ * final inversion removed).
+ *
  */
 
 /* Forcibly enable assertions */
 #undef NDEBUG
 
 #include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
 #include <ipxe/crc32.h>
 #include <ipxe/test.h>
 
@@ -48,6 +54,8 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 
 /** A CRC32 test */
 struct crc32_test {
+	/** CRC function */
+	u32 ( * crc ) ( u32 seed, const void *data, size_t len );
 	/** Test data */
 	const void *data;
 	/** Length of test data */
@@ -70,22 +78,153 @@ struct crc32_test {
 #define CRC32_TEST( name, DATA, SEED, CRC32 )				\
 	static const uint8_t name ## _data[] = DATA;			\
 	static struct crc32_test name = {				\
+		.crc = crc32_le,					\
 		.data = name ## _data,					\
 		.len = sizeof ( name ## _data ),			\
 		.seed = SEED,						\
 		.crc32 = CRC32,						\
 	};
 
+/**
+ * Define a CRC32C test
+ *
+ * @v name		Test name
+ * @v DATA		Test data
+ * @v SEED		Seed
+ * @v CRC32		Expected CRC32C
+ * @ret test		CRC32C test
+ */
+#define CRC32C_TEST( name, DATA, SEED, CRC32 )				\
+	static const uint8_t name ## _data[] = DATA;			\
+	static struct crc32_test name = {				\
+		.crc = crc32c_le,					\
+		.data = name ## _data,					\
+		.len = sizeof ( name ## _data ),			\
+		.seed = SEED,						\
+		.crc32 = CRC32,						\
+	};
+
+/** A CRC32 pattern test */
+struct crc32_pattern_test {
+	/** CRC function */
+	u32 ( * crc ) ( u32 seed, const void *data, size_t len );
+	/** Length of test data */
+	size_t len;
+	/** Seed */
+	uint32_t seed;
+	/** Expected CRC32 */
+	uint32_t crc32;
+};
+
+/** Maximum length of pattern test data */
+#define CRC32_PATTERN_MAX_LEN 4099
+
+/**
+ * Define a CRC32 pattern test
+ *
+ * @v name		Test name
+ * @v CRC		CRC function
+ * @v LEN		Length of test data
+ * @v SEED		Seed
+ * @v CRC32		Expected CRC32
+ * @ret test		CRC32 pattern test
+ */
+#define CRC32_PATTERN_TEST( name, CRC, LEN, SEED, CRC32 )		\
+	static struct crc32_pattern_test name = {			\
+		.crc = CRC,						\
+		.len = LEN,						\
+		.seed = SEED,						\
+		.crc32 = CRC32,						\
+	};
+
 /**
  * Report a CRC32 test result
  *
  * @v test		CRC32 test
+ * @v file		Test code file
+ * @v line		Test code line
+ */
+static void crc32_okx ( struct crc32_test *test, const char *file,
+			unsigned int line ) {
+	uint32_t crc32;
+
+	/* Calculate with hardware acceleration (if available) */
+	crc32 = test->crc ( test->seed, test->data, test->len );
+	okx ( crc32 == test->crc32, file, line );
+
+	/* Calculate without hardware acceleration */
+	crc32_accel_disabled = 1;
+	crc32 = test->crc ( test->seed, test->data, test->len );
+	okx ( crc32 == test->crc32, file, line );
+	crc32_accel_disabled = 0;
+}
+#define crc32_ok( test ) crc32_okx ( test, __FILE__, __LINE__ )
+
+/**
+ * Generate pattern test data
+ *
+ * @v data		Data buffer
+ * @v len		Length of data
+ */
+static void crc32_pattern ( uint8_t *data, size_t len ) {
+	unsigned int i;
+
+	for ( i = 0 ; i < len ; i++ )
+		data[i] = ( ( ( i * 37 ) + 11 ) ^ ( i >> 8 ) );
+}
+
+/**
+ * Report a CRC32 pattern test result
+ *
+ * @v test		CRC32 pattern test
+ * @v file		Test code file
+ * @v line		Test code line
  */
-#define crc32_ok( test ) do {						\
-	uint32_t crc32;							\
-	crc32 = crc32_le ( (test)->seed, (test)->data, (test)->len );	\
-	ok ( crc32 == (test)->crc32 );					\
-	} while ( 0 )
+static void crc32_pattern_okx ( struct crc32_pattern_test *test,
+				const char *file, unsigned int line ) {
+	uint8_t *buf;
+	uint8_t *data;
+	uint32_t expected;
+	uint32_t crc32;
+	unsigned int offset;
+	size_t len;
+
+	/* Allocate buffer (allowing for misalignment) */
+	assert ( test->len <= CRC32_PATTERN_MAX_LEN );
+	buf = malloc ( test->len + sizeof ( uint64_t ) );
+	okx ( buf != NULL, file, line );
+	if ( ! buf )
+		return;
+
+	/* Check full length with and without hardware acceleration */
+	crc32_pattern ( buf, test->len );
+	crc32 = test->crc ( test->seed, buf, test->len );
+	okx ( crc32 == test->crc32, file, line );
+	crc32_accel_disabled = 1;
+	crc32 = test->crc ( test->seed, buf, test->len );
+	okx ( crc32 == test->crc32, file, line );
+	crc32_accel_disabled = 0;
+
+	/* Check that accelerated and generic calculations agree for
+	 * a range of lengths and alignments.
+	 */
+	for ( offset = 0 ; offset < sizeof ( uint64_t ) ; offset++ ) {
+		data = ( buf + offset );
+		crc32_pattern ( data, test->len );
+		for ( len = 0 ; len <= test->len ; len += ( len / 4 ) + 1 ) {
+			crc32_accel_disabled = 1;
+			expected = test->crc ( test->seed, data, len );
+			crc32_accel_disabled = 0;
+			crc32 = test->crc ( test->seed, data, len );
+			okx ( crc32 == expected, file, line );
+		}
+	}
+
+	/* Free buffer */
+	free ( buf );
+}
+#define crc32_pattern_ok( test ) \
+	crc32_pattern_okx ( test, __FILE__, __LINE__ )
 
 /* CRC32 tests */
 CRC32_TEST ( empty_test,
@@ -101,6 +240,48 @@ CRC32_TEST ( hw_split_part2_test,
 	     DATA ( ' ', 'w', 'o', 'r', 'l', 'd' ),
 	     0xc9ef5979UL, 0xf2b5ee7aUL );
 
+/* CRC32C tests */
+CRC32C_TEST ( crc32c_empty_test,
+	      DATA ( ),
+	      0x12345678UL, 0x12345678UL );
+CRC32C_TEST ( crc32c_digits_test,
+	      DATA ( '1', '2', '3', '4', '5', '6', '7', '8', '9' ),
+	      0xffffffffUL, 0x1cf96d7cUL );
+CRC32C_TEST ( crc32c_zeroes_test,
+	      DATA ( 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+		     0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+		     0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+		     0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 ),
+	      0xffffffffUL, 0x756ec955UL );
+CRC32C_TEST ( crc32c_ones_test,
+	      DATA ( 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+		     0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+		     0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+		     0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff ),
+	      0xffffffffUL, 0x9d5754bcUL );
+CRC32C_TEST ( crc32c_incrementing_test,
+	      DATA ( 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+		     0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f,
+		     0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17,
+		     0x18, 0x19, 0x1a, 0x1b, 0x1c, 0x1d, 0x1e, 0x1f ),
+	      0xffffffffUL, 0xb92286b1UL );
+CRC32C_TEST ( crc32c_decrementing_test,
+	      DATA ( 0x1f, 0x1e, 0x1d, 0x1c, 0x1b, 0x1a, 0x19, 0x18,
+		     0x17, 0x16, 0x15, 0x14, 0x13, 0x12, 0x11, 0x10,
+		     0x0f, 0x0e, 0x0d, 0x0c, 0x0b, 0x0a, 0x09, 0x08,
+		     0x07, 0x06, 0x05, 0x04, 0x03, 0x02, 0x01, 0x00 ),
+	      0xffffffffUL, 0xeec024a3UL );
+
+/* Pattern tests */
+CRC32_PATTERN_TEST ( crc32_pattern_test, crc32_le,
+		     CRC32_PATTERN_MAX_LEN, 0xffffffffUL, 0xe3caae8bUL );
+CRC32_PATTERN_TEST ( crc32_pattern_zero_test, crc32_le,
+		     CRC32_PATTERN_MAX_LEN, 0, 0xea911da9UL );
+CRC32_PATTERN_TEST ( crc32c_pattern_test, crc32c_le,
+		     CRC32_PATTERN_MAX_LEN, 0xffffffffUL, 0x9d65e305UL );
+CRC32_PATTERN_TEST ( crc32c_pattern_zero_test, crc32c_le,
+		     CRC32_PATTERN_MAX_LEN, 0, 0x73a08e2aUL );
+
 /**
  * Perform CRC32 self-tests
  *
@@ -111,6 +292,16 @@ static void crc32_test_exec ( void ) {
 	crc32_ok ( &hw_test );
 	crc32_ok ( &hw_split_part1_test );
 	crc32_ok ( &hw_split_part2_test );
+	crc32_ok ( &crc32c_empty_test );
+	crc32_ok ( &crc32c_digits_test );
+	crc32_ok ( &crc32c_zeroes_test );
+	crc32_ok ( &crc32c_ones_test );
+	crc32_ok ( &crc32c_incrementing_test );
+	crc32_ok ( &crc32c_decrementing_test );
+	crc32_pattern_ok ( &crc32_pattern_test );
+	crc32_pattern_ok ( &crc32_pattern_zero_test );
+	crc32_pattern_ok ( &crc32c_pattern_test );
+	crc32_pattern_ok ( &crc32c_pattern_zero_test );
 }
 
 /** CRC32 self-test */
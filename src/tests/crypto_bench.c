@@ -0,0 +1,492 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+/** @file
+ *
+ * Cryptographic algorithm benchmarks
+ *
+ * These benchmarks report the cost of each digest and cipher
+ * algorithm over a range of data lengths, and the cost of the
+ * public-key and key exchange primitives used by TLS.  Since the
+ * benchmarks call through the generic algorithm descriptors, the
+ * results reflect whichever implementation (e.g. generic or
+ * architecture-specific) has been built into the image.
+ */
+
+/* Forcibly enable profiling */
+#undef NDEBUG
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <ipxe/crypto.h>
+#include <ipxe/bigint.h>
+#include <ipxe/md5.h>
+#include <ipxe/sha1.h>
+#include <ipxe/sha256.h>
+#include <ipxe/sha512.h>
+#include <ipxe/aes.h>
+#include <ipxe/chacha20.h>
+#include <ipxe/p256.h>
+#include <ipxe/p384.h>
+#include <ipxe/x25519.h>
+#include <ipxe/timer.h>
+#include <ipxe/profile.h>
+#include <ipxe/bench.h>
+
+/** Minimum time spent measuring each operation */
+#define CRYPTO_BENCH_TICKS ( TICKS_PER_SEC / 4 )
+
+/** Number of bulk operations per profiling sample */
+#define CRYPTO_BENCH_BATCH 16
+
+/** Maximum data length */
+#define CRYPTO_BENCH_MAX_LEN 8192
+
+/** RSA modulus length */
+#define CRYPTO_BENCH_RSA_LEN ( 2048 / 8 )
+
+/** Data lengths used for digest and cipher benchmarks
+ *
+ * Each length must be a multiple of the largest cipher block size.
+ */
+static const size_t crypto_bench_lens[] = { 16, 64, 256, 1024, 8192 };
+
+/** Benchmark input data */
+static uint8_t crypto_bench_data[CRYPTO_BENCH_MAX_LEN];
+
+/** A benchmarked cipher */
+struct crypto_bench_cipher {
+	/** Name */
+	const char *name;
+	/** Cipher algorithm */
+	struct cipher_algorithm *cipher;
+	/** Key length */
+	size_t key_len;
+	/** Cipher context (while benchmark is running) */
+	void *ctx;
+};
+
+/** An RSA-equivalent modular exponentiation */
+struct crypto_bench_rsa {
+	/** Modulus */
+	bigint_element_t *modulus0;
+	/** Modulus size */
+	unsigned int size;
+	/** Exponent */
+	bigint_element_t *exponent0;
+	/** Exponent size */
+	unsigned int exponent_size;
+	/** Base */
+	bigint_element_t *base0;
+	/** Result */
+	bigint_element_t *result0;
+	/** Temporary working space */
+	void *tmp;
+	/** Exponent is private */
+	int is_private;
+};
+
+/** Benchmarked digest algorithms */
+static struct digest_algorithm *crypto_bench_digests[] = {
+	&md5_algorithm,
+	&sha1_algorithm,
+	&sha256_algorithm,
+	&sha512_algorithm,
+};
+
+/** Benchmarked ciphers */
+static struct crypto_bench_cipher crypto_bench_ciphers[] = {
+	{
+		.name = "aes128-cbc",
+		.cipher = &aes_cbc_algorithm,
+		.key_len = ( 128 / 8 ),
+	},
+	{
+		.name = "aes256-cbc",
+		.cipher = &aes_cbc_algorithm,
+		.key_len = ( 256 / 8 ),
+	},
+	{
+		.name = "aes128-gcm",
+		.cipher = &aes_gcm_algorithm,
+		.key_len = ( 128 / 8 ),
+	},
+	{
+		.name = "aes256-gcm",
+		.cipher = &aes_gcm_algorithm,
+		.key_len = ( 256 / 8 ),
+	},
+	{
+		.name = "chacha20-poly1305",
+		.cipher = &chacha20_poly1305_algorithm,
+		.key_len = CHACHA20_KEY_LEN,
+	},
+};
+
+/** Benchmarked elliptic curves */
+static struct elliptic_curve *crypto_bench_curves[] = {
+	&x25519_curve,
+	&p256_curve,
+	&p384_curve,
+};
+
+/** Operation profiler */
+static struct profiler crypto_bench_profiler __profiler =
+	{ .name = "cryptobench.op" };
+
+/**
+ * Fill buffer with pseudo-random data
+ *
+ * @v data		Buffer
+ * @v len		Length of buffer
+ */
+static void crypto_bench_random ( void *data, size_t len ) {
+	uint8_t *bytes = data;
+
+	while ( len-- )
+		*(bytes++) = rand();
+}
+
+/**
+ * Time an operation
+ *
+ * @v name		Operation name
+ * @v len		Length of data processed by each operation, or zero
+ * @v batch		Number of operations per profiling sample
+ * @v op		Operation
+ * @v opaque		Operation context
+ * @ret rc		Return status code
+ */
+static int crypto_bench_time ( const char *name, size_t len,
+			       unsigned int batch,
+			       int ( * op ) ( void *opaque, size_t len ),
+			       void *opaque ) {
+	struct profiler *profiler = &crypto_bench_profiler;
+	unsigned long long cycles = 0;
+	unsigned long count = 0;
+	unsigned long start;
+	unsigned long elapsed;
+	unsigned int i;
+	int rc;
+
+	/* Repeat operation for at least the minimum measurement time */
+	start = currticks();
+	do {
+		profile_start ( profiler );
+		for ( i = 0 ; i < batch ; i++ ) {
+			if ( ( rc = op ( opaque, len ) ) != 0 )
+				return rc;
+		}
+		profile_stop ( profiler );
+		cycles += profile_elapsed ( profiler );
+		count += batch;
+		elapsed = ( currticks() - start );
+	} while ( elapsed < CRYPTO_BENCH_TICKS );
+
+	/* Report result */
+	bench_report_ops ( name, len, count, elapsed, cycles );
+	return 0;
+}
+
+/**
+ * Calculate digest
+ *
+ * @v opaque		Digest algorithm
+ * @v len		Length of data
+ * @ret rc		Return status code
+ */
+static int crypto_bench_digest_op ( void *opaque, size_t len ) {
+	struct digest_algorithm *digest = opaque;
+	uint8_t ctx[digest->ctxsize];
+	uint8_t out[digest->digestsize];
+
+	digest_init ( digest, ctx );
+	digest_update ( digest, ctx, crypto_bench_data, len );
+	digest_final ( digest, ctx, out );
+	return 0;
+}
+
+/**
+ * Run digest algorithm benchmarks
+ *
+ * @ret rc		Return status code
+ */
+static int crypto_bench_digest_exec ( void ) {
+	struct digest_algorithm *digest;
+	unsigned int i;
+	unsigned int j;
+	int rc;
+
+	srand ( 0x1234568 );
+	crypto_bench_random ( crypto_bench_data, sizeof ( crypto_bench_data ) );
+	for ( i = 0 ; i < ( sizeof ( crypto_bench_digests ) /
+			    sizeof ( crypto_bench_digests[0] ) ) ; i++ ) {
+		digest = crypto_bench_digests[i];
+		for ( j = 0 ; j < ( sizeof ( crypto_bench_lens ) /
+				    sizeof ( crypto_bench_lens[0] ) ) ; j++ ) {
+			if ( ( rc = crypto_bench_time ( digest->name,
+							crypto_bench_lens[j],
+							CRYPTO_BENCH_BATCH,
+							crypto_bench_digest_op,
+							digest ) ) != 0 )
+				return rc;
+		}
+	}
+	return 0;
+}
+
+/**
+ * Encrypt data
+ *
+ * @v opaque		Benchmarked cipher
+ * @v len		Length of data
+ * @ret rc		Return status code
+ */
+static int crypto_bench_cipher_op ( void *opaque, size_t len ) {
+	struct crypto_bench_cipher *bench = opaque;
+
+	cipher_encrypt ( bench->cipher, bench->ctx, crypto_bench_data,
+			 crypto_bench_data, len );
+	return 0;
+}
+
+/**
+ * Run cipher algorithm benchmarks
+ *
+ * @ret rc		Return status code
+ */
+static int crypto_bench_cipher_exec ( void ) {
+	struct crypto_bench_cipher *bench;
+	unsigned int i;
+	unsigned int j;
+	int rc;
+
+	srand ( 0x1234568 );
+	crypto_bench_random ( crypto_bench_data, sizeof ( crypto_bench_data ) );
+	for ( i = 0 ; i < ( sizeof ( crypto_bench_ciphers ) /
+			    sizeof ( crypto_bench_ciphers[0] ) ) ; i++ ) {
+		bench = &crypto_bench_ciphers[i];
+		{
+			uint8_t key[bench->key_len];
+			uint8_t iv[bench->cipher->blocksize];
+
+			/* Allocate and initialise cipher context */
+			bench->ctx = malloc ( bench->cipher->ctxsize );
+			if ( ! bench->ctx )
+				return -ENOMEM;
+			crypto_bench_random ( key, sizeof ( key ) );
+			crypto_bench_random ( iv, sizeof ( iv ) );
+			if ( ( rc = cipher_setkey ( bench->cipher, bench->ctx,
+						    key, sizeof ( key ) ) ) != 0 ){
+				free ( bench->ctx );
+				return rc;
+			}
+			cipher_setiv ( bench->cipher, bench->ctx,
+				       iv, sizeof ( iv ) );
+		}
+
+		/* Time encryption */
+		for ( j = 0 ; j < ( sizeof ( crypto_bench_lens ) /
+				    sizeof ( crypto_bench_lens[0] ) ) ; j++ ) {
+			if ( ( rc = crypto_bench_time ( bench->name,
+							crypto_bench_lens[j],
+							CRYPTO_BENCH_BATCH,
+							crypto_bench_cipher_op,
+							bench ) ) != 0 )
+				break;
+		}
+		free ( bench->ctx );
+		bench->ctx = NULL;
+		if ( rc != 0 )
+			return rc;
+	}
+	return 0;
+}
+
+/**
+ * Perform elliptic curve scalar multiplication of the generator
+ *
+ * @v opaque		Elliptic curve
+ * @v len		Unused
+ * @ret rc		Return status code
+ */
+static int crypto_bench_curve_op ( void *opaque, size_t len __unused ) {
+	struct elliptic_curve *curve = opaque;
+	uint8_t result[curve->pointsize];
+
+	return elliptic_multiply ( curve, curve->base, crypto_bench_data,
+				   result );
+}
+
+/**
+ * Perform modular exponentiation
+ *
+ * @v opaque		Modular exponentiation context
+ * @v len		Unused
+ * @ret rc		Return status code
+ */
+static int crypto_bench_rsa_op ( void *opaque, size_t len __unused ) {
+	struct crypto_bench_rsa *rsa = opaque;
+	bigint_t ( rsa->size ) *modulus = ( ( void * ) rsa->modulus0 );
+	bigint_t ( rsa->size ) *base = ( ( void * ) rsa->base0 );
+	bigint_t ( rsa->size ) *result = ( ( void * ) rsa->result0 );
+	bigint_t ( rsa->exponent_size ) *exponent =
+		( ( void * ) rsa->exponent0 );
+
+	if ( rsa->is_private ) {
+		bigint_mod_exp ( base, modulus, exponent, result, rsa->tmp );
+	} else {
+		bigint_mod_exp_public ( base, modulus, exponent, result,
+					rsa->tmp );
+	}
+	return 0;
+}
+
+/**
+ * Time RSA-equivalent modular exponentiation
+ *
+ * @v name		Operation name
+ * @v exponent_len	Exponent length
+ * @v is_private	Exponent is private
+ * @ret rc		Return status code
+ *
+ * An RSA operation is dominated by a single modular exponentiation,
+ * which can be benchmarked without needing a genuine key pair.
+ */
+static int crypto_bench_rsa ( const char *name, size_t exponent_len,
+			      int is_private ) {
+	unsigned int size = bigint_required_size ( CRYPTO_BENCH_RSA_LEN );
+	unsigned int exponent_size = bigint_required_size ( exponent_len );
+	bigint_t ( size ) *modulus;
+	size_t tmp_len = ( is_private ? bigint_mod_exp_tmp_len ( modulus ) :
+			   bigint_mod_exp_public_tmp_len ( modulus ) );
+	struct {
+		bigint_t ( size ) modulus;
+		bigint_t ( exponent_size ) exponent;
+		bigint_t ( size ) base;
+		bigint_t ( size ) result;
+		uint8_t tmp[tmp_len];
+	} __attribute__ (( packed )) *dynamic;
+	struct crypto_bench_rsa rsa;
+	uint8_t raw[CRYPTO_BENCH_RSA_LEN];
+	int rc;
+
+	/* Allocate dynamic storage */
+	dynamic = malloc ( sizeof ( *dynamic ) );
+	if ( ! dynamic )
+		return -ENOMEM;
+
+	/* Construct an odd full-length modulus */
+	crypto_bench_random ( raw, sizeof ( raw ) );
+	raw[0] |= 0x80;
+	raw[ sizeof ( raw ) - 1 ] |= 0x01;
+	bigint_init ( &dynamic->modulus, raw, sizeof ( raw ) );
+
+	/* Construct a base smaller than the modulus */
+	crypto_bench_random ( raw, sizeof ( raw ) );
+	raw[0] &= 0x7f;
+	bigint_init ( &dynamic->base, raw, sizeof ( raw ) );
+
+	/* Construct exponent (using F4 for public exponents) */
+	if ( is_private ) {
+		crypto_bench_random ( raw, exponent_len );
+		raw[0] |= 0x80;
+	} else {
+		memset ( raw, 0, exponent_len );
+		raw[ exponent_len - 3 ] = 0x01;
+		raw[ exponent_len - 1 ] = 0x01;
+	}
+	bigint_init ( &dynamic->exponent, raw, exponent_len );
+
+	/* Time modular exponentiation */
+	rsa.modulus0 = &dynamic->modulus.element[0];
+	rsa.size = size;
+	rsa.exponent0 = &dynamic->exponent.element[0];
+	rsa.exponent_size = exponent_size;
+	rsa.base0 = &dynamic->base.element[0];
+	rsa.result0 = &dynamic->result.element[0];
+	rsa.tmp = &dynamic->tmp;
+	rsa.is_private = is_private;
+	rc = crypto_bench_time ( name, 0, 1, crypto_bench_rsa_op, &rsa );
+
+	free ( dynamic );
+	return rc;
+}
+
+/**
+ * Run public-key and key exchange benchmarks
+ *
+ * @ret rc		Return status code
+ */
+static int crypto_bench_pubkey_exec ( void ) {
+	struct elliptic_curve *curve;
+	unsigned int i;
+	int rc;
+
+	/* RSA private and public key operations */
+	srand ( 0x1234568 );
+	if ( ( rc = crypto_bench_rsa ( "rsa2048-private",
+				       CRYPTO_BENCH_RSA_LEN, 1 ) ) != 0 )
+		return rc;
+	if ( ( rc = crypto_bench_rsa ( "rsa2048-public", 3, 0 ) ) != 0 )
+		return rc;
+
+	/* Elliptic curve key exchange.  The scalar's most significant
+	 * byte is cleared to ensure that it is smaller than the order
+	 * of the generator for each of the NIST curves.
+	 */
+	for ( i = 0 ; i < ( sizeof ( crypto_bench_curves ) /
+			    sizeof ( crypto_bench_curves[0] ) ) ; i++ ) {
+		curve = crypto_bench_curves[i];
+		crypto_bench_random ( crypto_bench_data, curve->keysize );
+		crypto_bench_data[0] = 0;
+		if ( ( rc = crypto_bench_time ( curve->name, 0, 1,
+						crypto_bench_curve_op,
+						curve ) ) != 0 )
+			return rc;
+	}
+	return 0;
+}
+
+/** Digest algorithm benchmarks */
+struct benchmark crypto_digest_bench __benchmark = {
+	.name = "digest",
+	.exec = crypto_bench_digest_exec,
+};
+
+/** Cipher algorithm benchmarks */
+struct benchmark crypto_cipher_bench __benchmark = {
+	.name = "cipher",
+	.exec = crypto_bench_cipher_exec,
+};
+
+/** Public-key and key exchange benchmarks */
+struct benchmark crypto_pubkey_bench __benchmark = {
+	.name = "pubkey",
+	.exec = crypto_bench_pubkey_exec,
+};
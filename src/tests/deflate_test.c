@@ -133,6 +133,148 @@ DEFLATE ( zlib, DEFLATE_ZLIB,
 		 0x65, 0x63, 0x69, 0x66, 0x69, 0x63, 0x61, 0x74, 0x69, 0x6f,
 		 0x6e ) );
 
+/* Dynamic alphabets with symbol lengths of up to 15 bits */
+DEFLATE ( long_codes, DEFLATE_RAW,
+	  DATA ( 0xed, 0xef, 0x01, 0x90, 0x24, 0x49, 0x92, 0x24, 0x49, 0x02,
+		 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x40, 0x03, 0x40,
+		 0x02, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+		 0x00, 0x00, 0x00, 0xc0, 0x03, 0x00, 0x00, 0x00, 0x00, 0x00,
+		 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+		 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+		 0x00, 0x00, 0x00, 0x80, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+		 0x00, 0x00, 0x00, 0x00, 0x14, 0x00, 0x00, 0x00, 0x00, 0x00,
+		 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x18, 0x00, 0x00,
+		 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+		 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00,
+		 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xc0, 0x02, 0x00,
+		 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+		 0x38, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x3c, 0x2b, 0x00,
+		 0x00, 0xc0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+		 0x00, 0x5c, 0xbc, 0x91, 0x04, 0x26, 0x97, 0xb6, 0xcf, 0xde,
+		 0xff, 0xff, 0xfe, 0x7f, 0xdf, 0xff, 0xef, 0xfe, 0x5f, 0xfd,
+		 0xfb, 0xfe, 0x7f, 0x75, 0xfa, 0xfe, 0xdf, 0xff, 0xfe, 0xf7,
+		 0x3f, 0xff, 0xfd, 0xef, 0xfd, 0xe9, 0xdd, 0xbf, 0xff, 0xdf,
+		 0xff, 0xfb, 0xf7, 0xbf, 0xff, 0xfd, 0xef, 0xff, 0xf5, 0xf3,
+		 0xff, 0xfb, 0xee, 0xf7, 0xf3, 0x9e, 0xda, 0xfc, 0xff, 0xbd,
+		 0xdc, 0xd7, 0xef, 0x3d, 0xde, 0x7f, 0xef, 0xe5, 0xfe, 0xf7,
+		 0xfd, 0xf3, 0xef, 0xea, 0xff, 0x67, 0xff, 0x47, 0xff, 0x9f,
+		 0xff, 0xd3, 0xff, 0xf9, 0x7f, 0xe1, 0xfb, 0xdf, 0x7f, 0xbf,
+		 0xfb, 0xe7, 0xf7, 0xff, 0xfe, 0x5f, 0xf5, 0xdd, 0xef, 0xbf,
+		 0xef, 0xff, 0xce, 0xdb, 0x9f, 0x7f, 0xff, 0xbf, 0xff, 0x7d,
+		 0xff, 0xfb, 0x7f, 0xfb, 0xf7, 0xff, 0x6f, 0xbf, 0xfe, 0xd7,
+		 0xff, 0xfc, 0xd4, 0xdc, 0xff, 0x97, 0xfe, 0xbf, 0xdf, 0xff,
+		 0xfb, 0xff, 0xdd, 0xff, 0xef, 0xff, 0xf9, 0xcf, 0xbf, 0xeb,
+		 0xf7, 0xfe, 0xf9, 0xdf, 0xff, 0xcf, 0xff, 0xaf, 0xbf, 0xff,
+		 0xc5, 0xfe, 0xf9, 0xbf, 0xff, 0xf3, 0x7f, 0xe1, 0xff, 0xfc,
+		 0xed, 0xdf, 0xbf, 0xfe, 0x7f, 0xfd, 0xdf, 0x1f, 0xfd, 0xbf,
+		 0xfd, 0x9f, 0xfc, 0xed, 0xff, 0xbb, 0xff, 0x7f, 0xff, 0xfe,
+		 0x7f, 0xff, 0x7e, 0xfe, 0xbd, 0xff, 0xd7, 0xfe, 0x7f, 0xea,
+		 0xff, 0xf7, 0x6f, 0x7f, 0x7f, 0xf7, 0xef, 0xfd, 0xfd, 0xfe,
+		 0x7f, 0xfd, 0xfb, 0xef, 0x7f, 0xff, 0xbf, 0xf7, 0xff, 0xfb,
+		 0xde, 0xff, 0x2b, 0xfb, 0xff, 0x8e, 0xff, 0xf7, 0xdf, 0xfb,
+		 0xdd, 0xbf, 0xfd, 0xe3, 0xde, 0xff, 0xe4, 0x7f, 0xff, 0xdd,
+		 0xff, 0x7b, 0xff, 0x93, 0xef, 0xff, 0xfc, 0xf9, 0x7f, 0xff,
+		 0xbf, 0xfd, 0xdf, 0xb2, 0x7e, 0xe7, 0xff, 0xf7, 0xff, 0xfb,
+		 0xdd, 0xff, 0xfb, 0xfd, 0xff, 0xde, 0xeb, 0xff, 0xfe, 0xdf,
+		 0xfd, 0xbf, 0x9f, 0xf7, 0x3f, 0xbd, 0xff, 0xf7, 0xff, 0x1d,
+		 0xfe, 0xf7, 0xcf, 0xff, 0xfb, 0xf7, 0xfe, 0xf9, 0xfd, 0xde,
+		 0xff, 0xb9, 0xff, 0xdf, 0xff, 0x1f ),
+	  DATA ( 0x31, 0x31, 0x9c, 0x31, 0x6d, 0xd9, 0x07, 0x07, 0x15, 0x9c,
+		 0x31, 0x07, 0x07, 0x6d, 0xc1, 0x07, 0x9c, 0xd9, 0x11, 0x11,
+		 0x11, 0xc1, 0x82, 0x11, 0x11, 0x11, 0xc1, 0x82, 0x07, 0x11,
+		 0xc1, 0x82, 0x07, 0x15, 0x31, 0xd9, 0x15, 0x11, 0x11, 0x11,
+		 0xd9, 0x07, 0xf2, 0xc1, 0x31, 0x9c, 0x6d, 0xf2, 0xf2, 0xc1,
+		 0x11, 0x11, 0x11, 0xc1, 0x07, 0xd9, 0x07, 0xf2, 0x31, 0x07,
+		 0xf2, 0x31, 0x07, 0xc1, 0x6d, 0x9c, 0x07, 0xf2, 0x11, 0xd9,
+		 0x07, 0xf2, 0x6d, 0x82, 0xf2, 0xc1, 0x11, 0x11, 0x6d, 0x11,
+		 0x9c, 0x15, 0xc1, 0x15, 0x6d, 0x07, 0x07, 0x31, 0xc1, 0x6d,
+		 0xd9, 0x07, 0xd9, 0xc1, 0x07, 0xd9, 0xc1, 0x07, 0xd9, 0xc1,
+		 0x07, 0xd9, 0xc1, 0x07, 0xd9, 0x07, 0x15, 0x9c, 0x31, 0x07,
+		 0x07, 0x6d, 0xc1, 0x07, 0x9c, 0xd9, 0x9c, 0x11, 0x82, 0xf2,
+		 0x6d, 0x15, 0xc1, 0xf2, 0xd9, 0xd9, 0x07, 0x07, 0x07, 0x9c,
+		 0x6d, 0xf2, 0x82, 0x9c, 0xf2, 0x6d, 0x15, 0xc1, 0xf2, 0xd9,
+		 0xd9, 0x07, 0x07, 0x07, 0x9c, 0x6d, 0x6d, 0x07, 0x07, 0x9c,
+		 0x15, 0x31, 0x11, 0x9c, 0x11, 0xd9, 0x9c, 0x6d, 0x6d, 0x31,
+		 0xd9, 0xc1, 0x07, 0x15, 0x07, 0x11, 0xc1, 0xf2, 0xc1, 0x07,
+		 0x07, 0x15, 0x07, 0x11, 0x6d, 0xd9, 0x07, 0xd9, 0xf2, 0xd9,
+		 0x31, 0x6d, 0x31, 0xd9, 0xc1, 0x82, 0xc1, 0x15, 0x6d, 0x07,
+		 0xf2, 0x31, 0x6d, 0x31, 0xd9, 0x82, 0x31, 0xc1, 0x31, 0x07,
+		 0xc1, 0xf2, 0xc1, 0x07, 0x07, 0x15, 0x07, 0x11, 0x6d, 0xd9,
+		 0x07, 0xd9, 0xf2, 0xd9, 0x31, 0x6d, 0x31, 0xd9, 0xc1, 0x82,
+		 0xc1, 0x15, 0x6d, 0x07, 0xf2, 0x31, 0x6d, 0x31, 0xd9, 0x82,
+		 0x31, 0xc1, 0x31, 0x07, 0xc1, 0xf2, 0xc1, 0x07, 0x07, 0x15,
+		 0x07, 0x11, 0x6d, 0xd9, 0x07, 0xd9, 0xf2, 0xd9, 0x31, 0x6d,
+		 0x31, 0xd9, 0xc1, 0x82, 0xc1, 0x15, 0x6d, 0x07, 0xf2, 0x31,
+		 0x6d, 0x31, 0xd9, 0x82, 0x31, 0xc1, 0x31, 0x07, 0xc1, 0xf2,
+		 0xc1, 0x07, 0x07, 0x15, 0x07, 0x11, 0x6d, 0xd9, 0x07, 0xd9,
+		 0xf2, 0xd9, 0x31, 0x6d, 0x31, 0xd9, 0xc1, 0x82, 0xc1, 0x15,
+		 0x6d, 0x07, 0xf2, 0x31, 0x6d, 0x31, 0xd9, 0x82, 0x31, 0xc1,
+		 0x31, 0x07, 0xc1, 0xf2, 0xc1, 0x07, 0x07, 0x15, 0x07, 0x11,
+		 0x6d, 0xd9, 0x07, 0xd9, 0xf2, 0xd9, 0x31, 0x6d, 0x31, 0xd9,
+		 0xc1, 0x82, 0xc1, 0x15, 0x6d, 0x07, 0xf2, 0x31, 0x6d, 0x31,
+		 0xd9, 0x82, 0x31, 0xc1, 0x31, 0x07, 0xc1, 0xf2, 0xc1, 0x07,
+		 0x07, 0x15, 0x07, 0x11, 0x6d, 0xd9, 0x07, 0xd9, 0xf2, 0xd9,
+		 0x31, 0x6d, 0x31, 0xd9, 0xc1, 0x82, 0xc1, 0x15, 0x6d, 0x07,
+		 0xf2, 0x31, 0x6d, 0x31, 0xd9, 0x82, 0x31, 0xc1, 0x31, 0x07,
+		 0xc1, 0xf2, 0xc1, 0x07, 0x07, 0x15, 0x07, 0x11, 0x6d, 0xd9,
+		 0x07, 0xd9, 0xf2, 0xd9, 0x31, 0x6d, 0x31, 0xd9, 0xc1, 0x82,
+		 0xc1, 0x15, 0x6d, 0x07, 0xf2, 0x31, 0x6d, 0x31, 0xd9, 0x82,
+		 0x31, 0xc1, 0x31, 0x07, 0xc1, 0xf2, 0xc1, 0x07, 0x07, 0x15,
+		 0x07, 0x11, 0x6d, 0xd9, 0x07, 0xd9, 0xf2, 0xd9, 0x31, 0x6d,
+		 0x31, 0xd9, 0xc1, 0x82, 0xc1, 0x15, 0x6d, 0x07, 0xf2, 0x31,
+		 0x6d, 0x31, 0xd9, 0x82, 0x31, 0xc1, 0x31, 0x07, 0xc1, 0xf2,
+		 0xc1, 0x07, 0x07, 0x15, 0x07, 0x11, 0x6d, 0xd9, 0x07, 0xd9,
+		 0xf2, 0xd9, 0x31, 0x6d, 0x31, 0xd9, 0xc1, 0x82, 0xd9, 0x07,
+		 0xd9, 0x11, 0x6d, 0x31, 0xd9, 0x82, 0x31, 0xc1, 0x31, 0x07,
+		 0xc1, 0xf2, 0xc1, 0xc1, 0x31, 0x07, 0xc1, 0xf2, 0xc1, 0xc1,
+		 0x31, 0x07, 0xc1, 0xf2, 0x07, 0x15, 0x15, 0x07, 0x31, 0x07,
+		 0x07, 0xc1, 0xf2, 0xc1, 0x07, 0x07, 0x15, 0x07, 0x11, 0x6d,
+		 0xd9, 0x07, 0xd9, 0x31, 0xd9, 0xc1, 0xf2, 0x15, 0x6d, 0x07,
+		 0x31, 0x15, 0x31, 0x15, 0xf2, 0xc1, 0x15, 0x07, 0x07, 0x15,
+		 0x07, 0x31, 0xc1, 0x07, 0x07, 0x31, 0x15, 0x31, 0xc1, 0x07,
+		 0xf2, 0x6d, 0x15, 0x31, 0xc1, 0x07, 0xf2, 0x9c, 0x31, 0x07,
+		 0x15, 0x82, 0x11, 0x31, 0x31, 0x31, 0x31, 0x31, 0x9c, 0xd9,
+		 0x07, 0xd9, 0xf2, 0xd9, 0x31, 0x6d, 0xd9, 0x82, 0xd9, 0x31,
+		 0xd9, 0xc1, 0x15, 0x31, 0x6d, 0xd9, 0x6d, 0x15, 0x31, 0xc1,
+		 0x07, 0x11, 0x82, 0x6d, 0xd9, 0x15, 0x82, 0x11, 0x31, 0x9c,
+		 0x15, 0x82, 0x11, 0x31, 0x9c, 0x15, 0x82, 0x11, 0x31, 0x9c,
+		 0x15, 0xd9, 0x31, 0x07, 0x07, 0x15, 0xc1, 0x07, 0x15, 0xc1,
+		 0xf2, 0x6d, 0xc1, 0x31, 0x31, 0xf2, 0x6d, 0xd9, 0xf2, 0x31,
+		 0x15, 0x82, 0x11, 0x31, 0x11, 0xd9, 0x6d, 0xd9, 0xf2, 0xc1,
+		 0x11, 0x31, 0x9c, 0x15, 0x6d, 0xd9, 0xc1, 0x11, 0x31, 0x9c,
+		 0x15, 0x6d, 0xd9, 0xc1, 0x11, 0x31, 0x9c, 0x15, 0x6d, 0xd9,
+		 0xc1, 0x11, 0x31, 0x9c, 0x15, 0x6d, 0xd9, 0xc1, 0x11, 0x31,
+		 0x9c, 0x15, 0x6d, 0xd9, 0xc1, 0x11, 0x31, 0x9c, 0x15, 0x6d,
+		 0xd9, 0xc1, 0x11, 0x31, 0x9c, 0x15, 0x6d, 0xd9, 0xc1, 0x11,
+		 0x31, 0x9c, 0x15, 0x6d, 0xd9, 0xc1, 0x11, 0x31, 0x9c, 0x15,
+		 0x6d, 0xd9, 0xc1, 0x11, 0x31, 0x9c, 0x15, 0x6d, 0xd9, 0xc1,
+		 0x11, 0x31, 0x9c, 0x15, 0x6d, 0xd9, 0xc1, 0x11, 0x31, 0x9c,
+		 0x15, 0x6d, 0xd9, 0xc1, 0x11, 0x31, 0x9c, 0x15, 0x6d, 0xd9,
+		 0xc1, 0x11, 0x31, 0x9c, 0x15, 0x6d, 0xd9, 0xc1, 0x11, 0x31,
+		 0x9c, 0x15, 0x6d, 0xd9, 0xc1, 0x11, 0x31, 0x9c, 0x15, 0x6d,
+		 0xd9, 0xc1, 0x11, 0x31, 0x9c, 0x15, 0x6d, 0xd9, 0xc1, 0x11,
+		 0x31, 0x9c, 0x15, 0x6d, 0xd9, 0xc1, 0x11, 0x31, 0x9c, 0x15,
+		 0x6d, 0xd9, 0xc1, 0x11, 0x31, 0x9c, 0x15, 0x6d, 0xd9, 0xc1,
+		 0x11, 0x31, 0x9c, 0x15, 0x6d, 0xd9, 0xc1, 0x11, 0x31, 0x9c,
+		 0x15, 0x6d, 0xd9, 0xc1, 0x11, 0x31, 0x9c, 0x15, 0x6d, 0xd9,
+		 0xc1, 0x11, 0x31, 0x9c, 0x15, 0x6d, 0xd9, 0xc1, 0x11, 0x31,
+		 0x9c, 0x15, 0x6d, 0xd9, 0xc1, 0x11, 0x31, 0x9c, 0x15, 0x6d,
+		 0xd9, 0xc1, 0x11, 0x31, 0x9c, 0x15, 0x6d, 0xd9, 0xc1, 0x11,
+		 0x31, 0x9c, 0x15, 0x6d, 0xd9, 0xc1, 0x11, 0x31, 0x9c, 0x15,
+		 0x6d, 0xd9, 0xc1, 0x11, 0x31, 0x9c, 0x15, 0x6d, 0xd9, 0xc1,
+		 0x11, 0x31, 0x9c, 0x15, 0x6d, 0xd9, 0xc1, 0x11, 0x31, 0x9c,
+		 0x15, 0x6d, 0xd9, 0xc1, 0x11, 0x31, 0x9c, 0x15, 0x6d, 0xd9,
+		 0xc1, 0x11, 0x31, 0x9c, 0x15, 0x6d, 0xd9, 0xc1, 0x11, 0x31,
+		 0x11, 0x15, 0xc1, 0xd9, 0x15, 0x15, 0x6d, 0xd9, 0xc1, 0x9c,
+		 0xf2, 0x6d, 0xd9, 0xc1, 0x11, 0x31 ) );
+
+/* Dynamic alphabets with symbol lengths of up to 15 bits fragment list */
+static struct deflate_test_fragments long_codes_fragments[] = {
+	{ { 100, 1, 200, -1UL } },
+	{ { 31, 32, 33, 34, -1UL } },
+	{ { 250, 1, 1, 1, 1, 1, -1UL } },
+};
+
 /* "ZLIB Compressed Data Format Specification" fragment list */
 static struct deflate_test_fragments zlib_fragments[] = {
 	{ { -1UL, } },
@@ -209,6 +351,108 @@ static void deflate_okx ( struct deflate *deflate,
 #define deflate_ok( deflate, test, frags ) \
 	deflate_okx ( deflate, test, frags, __FILE__, __LINE__ )
 
+/**
+ * Report DEFLATE compression test result
+ *
+ * @v deflate		Decompressor
+ * @v data		Uncompressed data
+ * @v len		Length of uncompressed data
+ * @v frag_len		Output fragment length
+ * @v max_len		Maximum expected compressed length
+ * @v file		Test code file
+ * @v line		Test code line
+ */
+static void deflate_encode_okx ( struct deflate *deflate, const void *data,
+				 size_t len, size_t frag_len, size_t max_len,
+				 const char *file, unsigned int line ) {
+	struct deflate_encoder *encoder;
+	struct deflate_chunk compressed;
+	struct deflate_chunk out;
+	uint8_t *buf;
+	size_t limit;
+
+	/* Allocate compressor and buffers */
+	encoder = malloc ( sizeof ( *encoder ) );
+	okx ( encoder != NULL, file, line );
+	buf = malloc ( max_len + len );
+	okx ( buf != NULL, file, line );
+	if ( ! ( encoder && buf ) )
+		goto done;
+
+	/* Compress data in fragments */
+	deflate_encode_init ( encoder, data, len );
+	deflate_chunk_init ( &compressed, buf, 0, 0 );
+	while ( ! deflate_encode_finished ( encoder ) ) {
+		limit = ( compressed.offset + frag_len );
+		okx ( limit <= max_len, file, line );
+		if ( limit > max_len )
+			goto done;
+		compressed.len = limit;
+		deflate_encode ( encoder, &compressed );
+		okx ( compressed.offset <= limit, file, line );
+	}
+	okx ( encoder->offset == len, file, line );
+
+	/* Decompress and verify data */
+	deflate_init ( deflate, DEFLATE_RAW );
+	deflate_chunk_init ( &out, ( buf + max_len ), 0, len );
+	okx ( deflate_inflate ( deflate, buf, compressed.offset,
+				&out ) == 0, file, line );
+	okx ( deflate_finished ( deflate ), file, line );
+	okx ( out.offset == len, file, line );
+	okx ( memcmp ( out.data, data, len ) == 0, file, line );
+
+ done:
+	free ( buf );
+	free ( encoder );
+}
+#define deflate_encode_ok( deflate, data, len, frag_len, max_len )	\
+	deflate_encode_okx ( deflate, data, len, frag_len, max_len,	\
+			     __FILE__, __LINE__ )
+
+/**
+ * Perform DEFLATE compression self-tests
+ *
+ * @v deflate		Decompressor
+ */
+static void deflate_encode_test ( struct deflate *deflate ) {
+	static const char hello[] = "Hello world, hello hello world";
+	uint32_t seed = 0x12345678UL;
+	uint8_t *data;
+	size_t len = 65536;
+	unsigned int i;
+
+	/* Empty input */
+	deflate_encode_ok ( deflate, NULL, 0, 16, 16 );
+
+	/* Short string with repetitions */
+	deflate_encode_ok ( deflate, hello, strlen ( hello ), 8, 64 );
+
+	/* Allocate test data */
+	data = zalloc ( len );
+	ok ( data != NULL );
+	if ( ! data )
+		return;
+
+	/* All zeros (must compress extremely well) */
+	deflate_encode_ok ( deflate, data, len, 64, ( len / 64 ) );
+
+	/* Mostly zeros, with scattered values */
+	for ( i = 0 ; i < len ; i += 997 )
+		data[i] = i;
+	deflate_encode_ok ( deflate, data, len, 37, ( len / 16 ) );
+
+	/* Pseudo-random data (must not expand excessively) */
+	for ( i = 0 ; i < len ; i++ ) {
+		seed = ( ( seed * 1103515245UL ) + 12345 );
+		data[i] = ( seed >> 16 );
+	}
+	deflate_encode_ok ( deflate, data, len, 1024,
+			    ( len + ( len / 8 ) + 16 ) );
+
+	free ( data );
+}
+
 /**
  * Perform DEFLATE self-test
  *
@@ -233,12 +477,21 @@ static void deflate_test_exec ( void ) {
 		deflate_ok ( deflate, &hello_hello_world, NULL );
 		deflate_ok ( deflate, &rfc_sentence, NULL );
 		deflate_ok ( deflate, &zlib, NULL );
+		deflate_ok ( deflate, &long_codes, NULL );
 
 		/* Test fragmentation */
 		for ( i = 0 ; i < ( sizeof ( zlib_fragments ) /
 				    sizeof ( zlib_fragments[0] ) ) ; i++ ) {
 			deflate_ok ( deflate, &zlib, &zlib_fragments[i] );
 		}
+		for ( i = 0 ; i < ( sizeof ( long_codes_fragments ) /
+				    sizeof ( long_codes_fragments[0] ) ) ; i++ ) {
+			deflate_ok ( deflate, &long_codes,
+				     &long_codes_fragments[i] );
+		}
+
+		/* Test compression */
+		deflate_encode_test ( deflate );
 	}
 
 	/* Free shared structure */
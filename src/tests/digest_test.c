@@ -54,6 +54,14 @@ static struct digest_test_fragments digest_test_fragments[] = {
 	{ { 2, 0, 23, 4, 6, 1, 0 } },
 };
 
+/** Length of data used for implementation consistency tests */
+#define DIGEST_CONSISTENCY_LEN 1027
+
+/** Digest consistency test fragment list */
+static struct digest_test_fragments digest_consistency_fragments = {
+	{ 1, 64, 130, 7, 0 }
+};
+
 /** Number of sample iterations for profiling */
 #define PROFILE_COUNT 16
 
@@ -122,6 +130,78 @@ void digest_okx ( struct digest_test *test, const char *file,
 	}
 }
 
+/**
+ * Calculate digest of implementation consistency test data
+ *
+ * @v digest		Digest algorithm
+ * @v data		Data
+ * @v fragments		Fragment list, or NULL
+ * @v out		Output buffer
+ */
+static void digest_consistency_calculate ( struct digest_algorithm *digest,
+					   const void *data,
+					   struct digest_test_fragments
+					   *fragments, void *out ) {
+	uint8_t ctx[digest->ctxsize];
+	size_t len = DIGEST_CONSISTENCY_LEN;
+	size_t frag_len = 0;
+	unsigned int i;
+
+	/* Calculate digest fragment-by-fragment */
+	digest_init ( digest, ctx );
+	for ( i = 0 ; len && ( i < ( sizeof ( fragments->len ) /
+				     sizeof ( fragments->len[0] ) ) ) ; i++ ) {
+		if ( fragments )
+			frag_len = fragments->len[i];
+		if ( ( frag_len == 0 ) || ( frag_len > len ) )
+			frag_len = len;
+		digest_update ( digest, ctx, data, frag_len );
+		data += frag_len;
+		len -= frag_len;
+	}
+	digest_final ( digest, ctx, out );
+}
+
+/**
+ * Report a digest implementation consistency test result
+ *
+ * @v digest		Digest algorithm
+ * @v disabled		Hardware acceleration disable flag
+ * @v file		Test code file
+ * @v line		Test code line
+ *
+ * Verify that the default (possibly hardware accelerated)
+ * implementation produces the same result as the generic
+ * implementation, for data spanning many blocks.
+ */
+void digest_consistency_okx ( struct digest_algorithm *digest, int *disabled,
+			      const char *file, unsigned int line ) {
+	uint8_t data[DIGEST_CONSISTENCY_LEN];
+	uint8_t expected[digest->digestsize];
+	uint8_t actual[digest->digestsize];
+	unsigned int i;
+
+	/* Construct arbitrary input data */
+	for ( i = 0 ; i < sizeof ( data ) ; i++ )
+		data[i] = ( i * 17 + ( i >> 8 ) );
+
+	/* Calculate digest using generic implementation */
+	*disabled = 1;
+	digest_consistency_calculate ( digest, data, NULL, expected );
+	*disabled = 0;
+
+	/* Calculate digest using default implementation */
+	digest_consistency_calculate ( digest, data, NULL, actual );
+	okx ( memcmp ( actual, expected, sizeof ( actual ) ) == 0,
+	      file, line );
+
+	/* Calculate fragmented digest using default implementation */
+	digest_consistency_calculate ( digest, data,
+				       &digest_consistency_fragments, actual );
+	okx ( memcmp ( actual, expected, sizeof ( actual ) ) == 0,
+	      file, line );
+}
+
 /**
  * Calculate digest algorithm cost
  *
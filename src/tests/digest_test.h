@@ -108,8 +108,20 @@ struct digest_test {
  */
 #define digest_ok(test) digest_okx ( test, __FILE__, __LINE__ )
 
+/**
+ * Report a digest implementation consistency test result
+ *
+ * @v digest		Digest algorithm
+ * @v disabled		Hardware acceleration disable flag
+ */
+#define digest_consistency_ok( digest, disabled ) \
+	digest_consistency_okx ( digest, disabled, __FILE__, __LINE__ )
+
 extern void digest_okx ( struct digest_test *test, const char *file,
 			 unsigned int line );
+extern void digest_consistency_okx ( struct digest_algorithm *digest,
+				     int *disabled, const char *file,
+				     unsigned int line );
 extern unsigned long digest_cost ( struct digest_algorithm *digest );
 
 #endif /* _DIGEST_TEST_H */
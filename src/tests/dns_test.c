@@ -34,8 +34,21 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 
 #include <string.h>
 #include <assert.h>
+#include <byteswap.h>
 #include <ipxe/dns.h>
+#include <ipxe/iobuf.h>
+#include <ipxe/netdevice.h>
+#include <ipxe/if_ether.h>
+#include <ipxe/ip.h>
+#include <ipxe/udp.h>
+#include <ipxe/tcpip.h>
+#include <ipxe/neighbour.h>
+#include <ipxe/socket.h>
+#include <ipxe/interface.h>
+#include <ipxe/resolv.h>
+#include <ipxe/process.h>
 #include <ipxe/test.h>
+#include "netdev_test.h"
 
 /** Define inline data */
 #define DATA(...) { __VA_ARGS__ }
@@ -556,6 +569,287 @@ DNS_LIST ( search,
 	   DATA ( "ipxe.org", "boot.ipxe.org", "dev.boot.ipxe.org",
 		  "networkboot.org" ) );
 
+/** Emulated DNS server MAC address */
+static const uint8_t dns_server_mac[ETH_ALEN] =
+	{ 0x52, 0x54, 0x00, 0x7c, 0x3e, 0x01 };
+
+/** Emulated DNS server IPv4 address */
+#define DNS_SERVER_IP "192.168.0.1"
+
+/** Emulated DNS server TTL */
+#define DNS_SERVER_TTL 60
+
+/** A DNS resolution test */
+struct dns_resolv_test {
+	/** Name to resolve */
+	const char *name;
+	/** IPv6 address returned by emulated DNS server */
+	const char *ipv6;
+	/** IPv4 address returned by emulated DNS server */
+	const char *ipv4;
+	/** Name resolution interface */
+	struct interface resolv;
+	/** Resolved addresses */
+	struct sockaddr sa[2];
+	/** Number of resolved addresses */
+	unsigned int count;
+	/** Number of queries answered by emulated DNS server */
+	unsigned int queries;
+	/** Resolution status code */
+	int rc;
+	/** Resolution has completed */
+	int done;
+};
+
+/** Emulated DNS server responses awaiting delivery */
+static LIST_HEAD ( dns_server_responses );
+
+/** Current DNS resolution test */
+static struct dns_resolv_test *dns_resolv_current;
+
+/**
+ * Emulate DNS server
+ *
+ * @v testnet		Test network device
+ * @v iobuf		I/O buffer
+ */
+static void dns_server_transmit ( struct testnet *testnet __unused,
+				  struct io_buffer *iobuf ) {
+	struct dns_resolv_test *test = dns_resolv_current;
+	struct ethhdr *ethhdr = iobuf->data;
+	struct iphdr *iphdr = ( ( void * ) ( ethhdr + 1 ) );
+	struct udp_header *udphdr = ( ( void * ) ( iphdr + 1 ) );
+	struct dns_header *query = ( ( void * ) ( udphdr + 1 ) );
+	struct dns_question *question;
+	struct io_buffer *response;
+	struct ethhdr *rsp_ethhdr;
+	struct iphdr *rsp_iphdr;
+	struct udp_header *rsp_udphdr;
+	struct dns_header *rsp_dnshdr;
+	uint16_t *ptr;
+	union dns_rr *rr;
+	size_t rr_len;
+	size_t len;
+
+	/* Ignore anything other than IPv4 DNS queries */
+	if ( ( ! test ) ||
+	     ( iob_len ( iobuf ) < ( sizeof ( *ethhdr ) + sizeof ( *iphdr ) +
+				     sizeof ( *udphdr ) ) ) ||
+	     ( ethhdr->h_protocol != htons ( ETH_P_IP ) ) ||
+	     ( iphdr->verhdrlen != ( IP_VER | ( sizeof ( *iphdr ) / 4 ) ) ) ||
+	     ( iphdr->protocol != IP_UDP ) ||
+	     ( udphdr->dest != htons ( DNS_PORT ) ) ) {
+		return;
+	}
+	len = ( ntohs ( udphdr->len ) - sizeof ( *udphdr ) );
+	assert ( len >= ( sizeof ( *query ) + sizeof ( *question ) ) );
+	question = ( ( ( void * ) query ) + len - sizeof ( *question ) );
+
+	/* Answer only address queries */
+	if ( question->qtype == htons ( DNS_TYPE_AAAA ) ) {
+		rr_len = sizeof ( rr->aaaa );
+	} else if ( question->qtype == htons ( DNS_TYPE_A ) ) {
+		rr_len = sizeof ( rr->a );
+	} else {
+		return;
+	}
+	test->queries++;
+
+	/* Allocate response */
+	response = alloc_iob ( sizeof ( *rsp_ethhdr ) + sizeof ( *rsp_iphdr ) +
+			       sizeof ( *rsp_udphdr ) + len + sizeof ( *ptr ) +
+			       rr_len );
+	assert ( response != NULL );
+
+	/* Construct Ethernet header */
+	rsp_ethhdr = iob_put ( response, sizeof ( *rsp_ethhdr ) );
+	memcpy ( rsp_ethhdr->h_dest, ethhdr->h_source, ETH_ALEN );
+	memcpy ( rsp_ethhdr->h_source, dns_server_mac, ETH_ALEN );
+	rsp_ethhdr->h_protocol = htons ( ETH_P_IP );
+
+	/* Construct IPv4 header */
+	rsp_iphdr = iob_put ( response, sizeof ( *rsp_iphdr ) );
+	memset ( rsp_iphdr, 0, sizeof ( *rsp_iphdr ) );
+	rsp_iphdr->verhdrlen = ( IP_VER | ( sizeof ( *rsp_iphdr ) / 4 ) );
+	rsp_iphdr->len = htons ( sizeof ( *rsp_iphdr ) + sizeof ( *rsp_udphdr ) +
+				 len + sizeof ( *ptr ) + rr_len );
+	rsp_iphdr->ttl = IP_TTL;
+	rsp_iphdr->protocol = IP_UDP;
+	rsp_iphdr->src = iphdr->dest;
+	rsp_iphdr->dest = iphdr->src;
+	rsp_iphdr->chksum = tcpip_chksum ( rsp_iphdr, sizeof ( *rsp_iphdr ) );
+
+	/* Construct UDP header (without checksum) */
+	rsp_udphdr = iob_put ( response, sizeof ( *rsp_udphdr ) );
+	rsp_udphdr->src = udphdr->dest;
+	rsp_udphdr->dest = udphdr->src;
+	rsp_udphdr->len = htons ( sizeof ( *rsp_udphdr ) + len +
+				  sizeof ( *ptr ) + rr_len );
+	rsp_udphdr->chksum = 0;
+
+	/* Construct DNS header and question by copying query */
+	rsp_dnshdr = iob_put ( response, len );
+	memcpy ( rsp_dnshdr, query, len );
+	rsp_dnshdr->ancount = htons ( 1 );
+
+	/* Construct answer, using a pointer to the question name */
+	ptr = iob_put ( response, sizeof ( *ptr ) );
+	*ptr = htons ( 0xc000 | sizeof ( *rsp_dnshdr ) );
+	rr = iob_put ( response, rr_len );
+	rr->common.type = question->qtype;
+	rr->common.class = htons ( DNS_CLASS_IN );
+	rr->common.ttl = htonl ( DNS_SERVER_TTL );
+	rr->common.rdlength = htons ( rr_len - sizeof ( rr->common ) );
+	if ( question->qtype == htons ( DNS_TYPE_AAAA ) ) {
+		inet6_aton ( test->ipv6, &rr->aaaa.in6_addr );
+	} else {
+		inet_aton ( test->ipv4, &rr->a.in_addr );
+	}
+
+	/* Queue response for delivery */
+	list_add_tail ( &response->list, &dns_server_responses );
+}
+
+/**
+ * Record resolved address
+ *
+ * @v test		DNS resolution test
+ * @v sa		Resolved socket address
+ */
+static void dns_resolv_test_done ( struct dns_resolv_test *test,
+				   struct sockaddr *sa ) {
+
+	if ( test->count < ( sizeof ( test->sa ) / sizeof ( test->sa[0] ) ) )
+		memcpy ( &test->sa[test->count], sa, sizeof ( test->sa[0] ) );
+	test->count++;
+}
+
+/**
+ * Record resolution completion
+ *
+ * @v test		DNS resolution test
+ * @v rc		Reason for close
+ */
+static void dns_resolv_test_close ( struct dns_resolv_test *test, int rc ) {
+
+	intf_restart ( &test->resolv, rc );
+	test->rc = rc;
+	test->done = 1;
+}
+
+/** DNS resolution test interface operations */
+static struct interface_operation dns_resolv_test_op[] = {
+	INTF_OP ( resolv_done, struct dns_resolv_test *, dns_resolv_test_done ),
+	INTF_OP ( intf_close, struct dns_resolv_test *, dns_resolv_test_close ),
+};
+
+/** DNS resolution test interface descriptor */
+static struct interface_descriptor dns_resolv_test_desc =
+	INTF_DESC ( struct dns_resolv_test, resolv, dns_resolv_test_op );
+
+/**
+ * Define a DNS resolution test
+ *
+ * @v _name		Test name
+ * @v _hostname		Name to resolve
+ * @v _ipv6		IPv6 address returned by emulated DNS server
+ * @v _ipv4		IPv4 address returned by emulated DNS server
+ * @ret test		DNS resolution test
+ */
+#define DNS_RESOLV( _name, _hostname, _ipv6, _ipv4 )			\
+	static struct dns_resolv_test _name = {				\
+		.name = _hostname,					\
+		.ipv6 = _ipv6,						\
+		.ipv4 = _ipv4,						\
+		.resolv = INTF_INIT ( dns_resolv_test_desc ),		\
+	}
+
+/**
+ * Report DNS resolution test result
+ *
+ * @v test		DNS resolution test
+ * @v testnet		Test network device
+ * @v queries		Expected number of queries answered
+ * @v file		Test code file
+ * @v line		Test code line
+ */
+static void dns_resolv_okx ( struct dns_resolv_test *test,
+			     struct testnet *testnet, unsigned int queries,
+			     const char *file, unsigned int line ) {
+	struct io_buffer *iobuf;
+	struct sockaddr sa;
+	unsigned int i;
+
+	/* Start resolution */
+	memset ( &sa, 0, sizeof ( sa ) );
+	test->count = 0;
+	test->queries = 0;
+	test->done = 0;
+	dns_resolv_current = test;
+	okx ( resolv ( &test->resolv, test->name, &sa ) == 0, file, line );
+
+	/* Run until resolution completes, delivering any responses */
+	for ( i = 0 ; ( ( i < 1000 ) && ( ! test->done ) ) ; i++ ) {
+		step();
+		while ( ( iobuf = list_first_entry ( &dns_server_responses,
+						     struct io_buffer,
+						     list ) ) != NULL ) {
+			list_del ( &iobuf->list );
+			netdev_rx ( testnet->netdev, iobuf );
+		}
+	}
+	dns_resolv_current = NULL;
+
+	/* Check result: IPv6 address first, then IPv4 address */
+	okx ( test->done, file, line );
+	okx ( test->rc == 0, file, line );
+	okx ( test->queries == queries, file, line );
+	okx ( test->count == 2, file, line );
+	okx ( test->sa[0].sa_family == AF_INET6, file, line );
+	okx ( strcmp ( sock_ntoa ( &test->sa[0] ), test->ipv6 ) == 0,
+	      file, line );
+	okx ( test->sa[1].sa_family == AF_INET, file, line );
+	okx ( strcmp ( sock_ntoa ( &test->sa[1] ), test->ipv4 ) == 0,
+	      file, line );
+}
+#define dns_resolv_ok( test, testnet, queries ) \
+	dns_resolv_okx ( test, testnet, queries, __FILE__, __LINE__ )
+
+/** Dual-stack test network device */
+TESTNET ( dnsnet, "52:54:00:7c:3e:02",
+	  { "ip", "192.168.0.2" },
+	  { "netmask", "255.255.255.0" },
+	  { "dns", DNS_SERVER_IP },
+	  { "dns6", "2001:db8::1" } );
+
+/** Dual-stack name resolution */
+DNS_RESOLV ( resolv_dual, "dual.example.com", "2001:db8::80",
+	     "192.168.0.80" );
+
+/**
+ * Perform DNS resolution tests
+ *
+ */
+static void dns_resolv_test_exec ( void ) {
+	struct in_addr server;
+
+	/* Create test network device with emulated DNS server */
+	dnsnet.transmit = dns_server_transmit;
+	testnet_ok ( &dnsnet );
+	inet_aton ( DNS_SERVER_IP, &server );
+	ok ( neighbour_define ( dnsnet.netdev, &ipv4_protocol, &server,
+				dns_server_mac ) == 0 );
+
+	/* Resolve dual-stack name: expect AAAA and A queries */
+	dns_resolv_ok ( &resolv_dual, &dnsnet, 2 );
+
+	/* Resolve again: expect both addresses from cache */
+	dns_resolv_ok ( &resolv_dual, &dnsnet, 0 );
+
+	/* Remove test network device */
+	testnet_remove_ok ( &dnsnet );
+}
+
 /**
  * Perform DNS self-test
  *
@@ -600,6 +894,9 @@ static void dns_test_exec ( void ) {
 
 	/* Search list tets */
 	dns_list_ok ( &search );
+
+	/* Resolution tests */
+	dns_resolv_test_exec();
 }
 
 /** DNS self-test */
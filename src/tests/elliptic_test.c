@@ -53,6 +53,7 @@ void elliptic_curve_okx ( struct elliptic_curve *curve, const char *file,
 	size_t pointsize = curve->pointsize;
 	size_t keysize = curve->keysize;
 	uint8_t point[pointsize];
+	uint8_t twice[pointsize];
 	uint8_t scalar[keysize];
 	struct {
 		bigint_t ( bigint_required_size ( keysize ) ) scalar;
@@ -81,6 +82,21 @@ void elliptic_curve_okx ( struct elliptic_curve *curve, const char *file,
 	okx ( elliptic_multiply ( curve, curve->base, scalar, point ) == 0,
 	      file, line );
 	okx ( memcmp ( point, curve->base, pointsize ) == 0, file, line );
+
+	/* Test combined multiplication and addition, if supported */
+	if ( curve->multiply_add ) {
+		okx ( elliptic_multiply_add ( curve, scalar, curve->base,
+					      curve->order, point ) == 0,
+		      file, line );
+		okx ( memcmp ( point, curve->base, pointsize ) == 0,
+		      file, line );
+		okx ( elliptic_add ( curve, curve->base, curve->base,
+				     twice ) == 0, file, line );
+		okx ( elliptic_multiply_add ( curve, curve->order, twice,
+					      scalar, point ) == 0,
+		      file, line );
+		okx ( memcmp ( point, twice, pointsize ) == 0, file, line );
+	}
 }
 
 /**
@@ -0,0 +1,288 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+/** @file
+ *
+ * Fragment reassembly tests
+ *
+ */
+
+/* Forcibly enable assertions */
+#undef NDEBUG
+
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+#include <ipxe/iobuf.h>
+#include <ipxe/ipstat.h>
+#include <ipxe/fragment.h>
+#include <ipxe/test.h>
+
+/** A test fragment header */
+struct fragment_test_header {
+	/** Packet identifier */
+	uint32_t ident;
+	/** Fragment offset and more-fragments flag */
+	uint32_t offset_more;
+} __attribute__ (( packed ));
+
+/** More fragments flag */
+#define FRAGMENT_TEST_MORE 0x80000000UL
+
+/** Fragment offset mask */
+#define FRAGMENT_TEST_OFFSET 0x7fffffffUL
+
+/** Headroom used for test fragments */
+#define FRAGMENT_TEST_HEADROOM 16
+
+/** Test statistics */
+static struct ip_statistics fragment_test_stats;
+
+/**
+ * Check if fragment matches fragment reassembly buffer
+ *
+ * @v fragment		Fragment reassembly buffer
+ * @v iobuf		I/O buffer
+ * @v hdrlen		Length of non-fragmentable potion of I/O buffer
+ * @ret is_fragment	Fragment matches this reassembly buffer
+ */
+static int fragment_test_is_fragment ( struct fragment *fragment,
+				       struct io_buffer *iobuf,
+				       size_t hdrlen __unused ) {
+	struct fragment_test_header *frag_hdr = fragment->iobuf->data;
+	struct fragment_test_header *hdr = iobuf->data;
+
+	return ( hdr->ident == frag_hdr->ident );
+}
+
+/**
+ * Get fragment offset
+ *
+ * @v iobuf		I/O buffer
+ * @v hdrlen		Length of non-fragmentable potion of I/O buffer
+ * @ret offset		Offset
+ */
+static size_t fragment_test_offset ( struct io_buffer *iobuf,
+				     size_t hdrlen __unused ) {
+	struct fragment_test_header *hdr = iobuf->data;
+
+	return ( hdr->offset_more & FRAGMENT_TEST_OFFSET );
+}
+
+/**
+ * Check if more fragments exist
+ *
+ * @v iobuf		I/O buffer
+ * @v hdrlen		Length of non-fragmentable potion of I/O buffer
+ * @ret more_frags	More fragments exist
+ */
+static int fragment_test_more ( struct io_buffer *iobuf,
+				size_t hdrlen __unused ) {
+	struct fragment_test_header *hdr = iobuf->data;
+
+	return ( hdr->offset_more & FRAGMENT_TEST_MORE );
+}
+
+/** Test fragment reassembler */
+static struct fragment_reassembler fragment_test_reassembler = {
+	.list = LIST_HEAD_INIT ( fragment_test_reassembler.list ),
+	.is_fragment = fragment_test_is_fragment,
+	.fragment_offset = fragment_test_offset,
+	.more_fragments = fragment_test_more,
+	.stats = &fragment_test_stats,
+};
+
+/**
+ * Calculate expected test data byte
+ *
+ * @v ident		Packet identifier
+ * @v offset		Offset within packet
+ * @ret byte		Test data byte
+ */
+static inline uint8_t fragment_test_byte ( unsigned int ident,
+					   size_t offset ) {
+	return ( ( offset * 7 ) ^ ( offset >> 8 ) ^ ident );
+}
+
+/**
+ * Add test fragment
+ *
+ * @v ident		Packet identifier
+ * @v offset		Fragment offset
+ * @v len		Fragment length
+ * @v more		More fragments exist
+ * @ret iobuf		Reassembled packet, or NULL
+ */
+static struct io_buffer * fragment_test_add ( unsigned int ident,
+					      size_t offset, size_t len,
+					      int more ) {
+	struct fragment_test_header *hdr;
+	struct io_buffer *iobuf;
+	size_t hdrlen = sizeof ( *hdr );
+	uint8_t *data;
+	size_t i;
+
+	/* Construct fragment */
+	iobuf = alloc_iob ( FRAGMENT_TEST_HEADROOM + hdrlen + len );
+	assert ( iobuf != NULL );
+	iob_reserve ( iobuf, FRAGMENT_TEST_HEADROOM );
+	hdr = iob_put ( iobuf, hdrlen );
+	hdr->ident = ident;
+	hdr->offset_more = ( offset | ( more ? FRAGMENT_TEST_MORE : 0 ) );
+	data = iob_put ( iobuf, len );
+	for ( i = 0 ; i < len ; i++ )
+		data[i] = fragment_test_byte ( ident, ( offset + i ) );
+
+	/* Reassemble */
+	iobuf = fragment_reassemble ( &fragment_test_reassembler, iobuf,
+				      &hdrlen );
+	if ( iobuf ) {
+		assert ( hdrlen == sizeof ( *hdr ) );
+		assert ( iob_headroom ( iobuf ) == FRAGMENT_TEST_HEADROOM );
+	}
+	return iobuf;
+}
+
+/**
+ * Check reassembled packet
+ *
+ * @v iobuf		Reassembled packet, or NULL
+ * @v ident		Expected packet identifier
+ * @v len		Expected length
+ * @v file		Test code file
+ * @v line		Test code line
+ */
+static void fragment_test_okx ( struct io_buffer *iobuf, unsigned int ident,
+				size_t len, const char *file,
+				unsigned int line ) {
+	struct fragment_test_header *hdr;
+	uint8_t *data;
+	size_t i;
+	int intact = 1;
+
+	okx ( iobuf != NULL, file, line );
+	if ( ! iobuf )
+		return;
+	hdr = iobuf->data;
+	okx ( hdr->ident == ident, file, line );
+	okx ( ( hdr->offset_more & FRAGMENT_TEST_OFFSET ) == 0, file, line );
+	okx ( iob_len ( iobuf ) == ( sizeof ( *hdr ) + len ), file, line );
+	data = ( iobuf->data + sizeof ( *hdr ) );
+	for ( i = 0 ; i < len ; i++ ) {
+		if ( data[i] != fragment_test_byte ( ident, i ) )
+			intact = 0;
+	}
+	okx ( intact, file, line );
+	free_iob ( iobuf );
+}
+#define fragment_test_ok( iobuf, ident, len ) \
+	fragment_test_okx ( iobuf, ident, len, __FILE__, __LINE__ )
+
+/**
+ * Perform fragment reassembly self-tests
+ *
+ */
+static void fragment_test_exec ( void ) {
+	unsigned long fails;
+	unsigned int i;
+
+	/* In-order fragments */
+	ok ( fragment_test_add ( 1, 0, 64, 1 ) == NULL );
+	ok ( fragment_test_add ( 1, 64, 64, 1 ) == NULL );
+	fragment_test_ok ( fragment_test_add ( 1, 128, 10, 0 ), 1, 138 );
+
+	/* Reverse-order fragments */
+	ok ( fragment_test_add ( 2, 128, 10, 0 ) == NULL );
+	ok ( fragment_test_add ( 2, 64, 64, 1 ) == NULL );
+	fragment_test_ok ( fragment_test_add ( 2, 0, 64, 1 ), 2, 138 );
+
+	/* Out-of-order fragments with duplicates */
+	ok ( fragment_test_add ( 3, 64, 64, 1 ) == NULL );
+	ok ( fragment_test_add ( 3, 192, 8, 0 ) == NULL );
+	ok ( fragment_test_add ( 3, 64, 64, 1 ) == NULL );
+	ok ( fragment_test_add ( 3, 0, 64, 1 ) == NULL );
+	ok ( fragment_test_add ( 3, 192, 8, 0 ) == NULL );
+	fragment_test_ok ( fragment_test_add ( 3, 128, 64, 1 ), 3, 200 );
+
+	/* Interleaved packets */
+	ok ( fragment_test_add ( 4, 32, 32, 0 ) == NULL );
+	ok ( fragment_test_add ( 5, 0, 32, 1 ) == NULL );
+	ok ( fragment_test_add ( 6, 32, 16, 0 ) == NULL );
+	ok ( fragment_test_add ( 5, 32, 32, 1 ) == NULL );
+	fragment_test_ok ( fragment_test_add ( 6, 0, 32, 1 ), 6, 48 );
+	fragment_test_ok ( fragment_test_add ( 4, 0, 32, 1 ), 4, 64 );
+	fragment_test_ok ( fragment_test_add ( 5, 64, 1, 0 ), 5, 65 );
+
+	/* Overlapping fragments */
+	fails = fragment_test_stats.reasm_fails;
+	ok ( fragment_test_add ( 7, 0, 64, 1 ) == NULL );
+	ok ( fragment_test_add ( 7, 32, 64, 0 ) == NULL );
+	ok ( fragment_test_stats.reasm_fails == ( fails + 1 ) );
+	ok ( list_empty ( &fragment_test_reassembler.list ) );
+
+	/* Inconsistent final fragments */
+	fails = fragment_test_stats.reasm_fails;
+	ok ( fragment_test_add ( 8, 64, 64, 0 ) == NULL );
+	ok ( fragment_test_add ( 8, 0, 32, 0 ) == NULL );
+	ok ( fragment_test_stats.reasm_fails == ( fails + 1 ) );
+	ok ( fragment_test_add ( 9, 64, 64, 1 ) == NULL );
+	ok ( fragment_test_add ( 9, 0, 32, 0 ) == NULL );
+	ok ( fragment_test_stats.reasm_fails == ( fails + 2 ) );
+	ok ( list_empty ( &fragment_test_reassembler.list ) );
+
+	/* Excessive length */
+	fails = fragment_test_stats.reasm_fails;
+	ok ( fragment_test_add ( 10, ( FRAGMENT_MAX_LEN - 32 ), 64,
+				 0 ) == NULL );
+	ok ( fragment_test_stats.reasm_fails == ( fails + 1 ) );
+	ok ( list_empty ( &fragment_test_reassembler.list ) );
+
+	/* Excessive number of fragments */
+	fails = fragment_test_stats.reasm_fails;
+	for ( i = 0 ; i <= FRAGMENT_MAX_PARTS ; i++ )
+		ok ( fragment_test_add ( 11, ( 8 * i ), 8, 1 ) == NULL );
+	ok ( fragment_test_stats.reasm_fails == ( fails + 1 ) );
+	ok ( list_empty ( &fragment_test_reassembler.list ) );
+
+	/* Excessive number of concurrent packets */
+	fails = fragment_test_stats.reasm_fails;
+	for ( i = 0 ; i <= FRAGMENT_MAX_BUFFERS ; i++ )
+		ok ( fragment_test_add ( ( 100 + i ), 8, 8, 0 ) == NULL );
+	ok ( fragment_test_stats.reasm_fails == ( fails + 1 ) );
+	ok ( fragment_test_add ( 100, 0, 8, 1 ) == NULL );
+	ok ( fragment_test_stats.reasm_fails == ( fails + 2 ) );
+	for ( i = 2 ; i <= FRAGMENT_MAX_BUFFERS ; i++ ) {
+		fragment_test_ok ( fragment_test_add ( ( 100 + i ), 0, 8, 1 ),
+				   ( 100 + i ), 16 );
+	}
+	fragment_test_ok ( fragment_test_add ( 100, 8, 8, 0 ), 100, 16 );
+	ok ( list_empty ( &fragment_test_reassembler.list ) );
+}
+
+/** Fragment reassembly self-test */
+struct self_test fragment_test __self_test = {
+	.name = "fragment",
+	.exec = fragment_test_exec,
+};
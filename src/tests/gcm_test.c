@@ -357,11 +357,116 @@ CIPHER_TEST ( gcm_test_18, &aes_gcm_algorithm, GCM_KEY_256,
 	      AUTH ( 0xa4, 0x4a, 0x82, 0x66, 0xee, 0x1c, 0x8e, 0xb0, 0xc8,
 		     0xb5, 0xd4, 0xcf, 0x5a, 0xe9, 0xf1, 0x9a ) );
 
+/** Length of data used for implementation consistency tests */
+#define GCM_CONSISTENCY_LEN 1027
+
+/** Length of additional data used for implementation consistency tests */
+#define GCM_CONSISTENCY_ADDITIONAL_LEN 37
+
 /**
- * Perform Galois/Counter Mode self-test
+ * Encrypt data for implementation consistency test
  *
+ * @v key		Key
+ * @v key_len		Length of key
+ * @v iv		Initialisation vector
+ * @v iv_len		Length of initialisation vector
+ * @v additional	Additional data
+ * @v plaintext		Plaintext
+ * @v ciphertext	Ciphertext to fill in
+ * @v auth		Authentication tag to fill in
  */
-static void gcm_test_exec ( void ) {
+static void gcm_consistency_encrypt ( const void *key, size_t key_len,
+				      const void *iv, size_t iv_len,
+				      const void *additional,
+				      const void *plaintext, void *ciphertext,
+				      void *auth ) {
+	struct cipher_algorithm *gcm = &aes_gcm_algorithm;
+	uint8_t ctx[gcm->ctxsize];
+
+	ok ( cipher_setkey ( gcm, ctx, key, key_len ) == 0 );
+	cipher_setiv ( gcm, ctx, iv, iv_len );
+	cipher_encrypt ( gcm, ctx, additional, NULL,
+			 GCM_CONSISTENCY_ADDITIONAL_LEN );
+	cipher_encrypt ( gcm, ctx, plaintext, ciphertext,
+			 GCM_CONSISTENCY_LEN );
+	cipher_auth ( gcm, ctx, auth );
+}
+
+/**
+ * Report a GCM implementation consistency test result
+ *
+ * @v key_len		Length of key
+ * @v iv_len		Length of initialisation vector
+ * @v file		Test code file
+ * @v line		Test code line
+ *
+ * Verify that the default (possibly hardware accelerated)
+ * implementation produces the same result as the generic
+ * implementation, for data spanning many blocks.
+ */
+static void gcm_consistency_okx ( size_t key_len, size_t iv_len,
+				  const char *file, unsigned int line ) {
+	struct cipher_algorithm *gcm = &aes_gcm_algorithm;
+	uint8_t ctx[gcm->ctxsize];
+	uint8_t key[key_len];
+	uint8_t iv[iv_len];
+	uint8_t additional[GCM_CONSISTENCY_ADDITIONAL_LEN];
+	uint8_t plaintext[GCM_CONSISTENCY_LEN];
+	uint8_t expected[GCM_CONSISTENCY_LEN];
+	uint8_t actual[GCM_CONSISTENCY_LEN];
+	union gcm_block expected_auth;
+	union gcm_block actual_auth;
+	unsigned int i;
+
+	/* Construct arbitrary input data */
+	for ( i = 0 ; i < sizeof ( key ) ; i++ )
+		key[i] = ( i * 13 + 1 );
+	for ( i = 0 ; i < sizeof ( iv ) ; i++ )
+		iv[i] = ( i * 29 + 7 );
+	for ( i = 0 ; i < sizeof ( additional ) ; i++ )
+		additional[i] = ( i * 3 + 5 );
+	for ( i = 0 ; i < sizeof ( plaintext ) ; i++ )
+		plaintext[i] = ( i * 17 + ( i >> 8 ) );
+
+	/* Encrypt using generic implementation */
+	aes_accel_disabled = 1;
+	gcm_accel_disabled = 1;
+	gcm_consistency_encrypt ( key, sizeof ( key ), iv, sizeof ( iv ),
+				  additional, plaintext, expected,
+				  &expected_auth );
+	aes_accel_disabled = 0;
+	gcm_accel_disabled = 0;
+
+	/* Encrypt using default implementation */
+	gcm_consistency_encrypt ( key, sizeof ( key ), iv, sizeof ( iv ),
+				  additional, plaintext, actual,
+				  &actual_auth );
+	okx ( memcmp ( actual, expected, sizeof ( actual ) ) == 0,
+	      file, line );
+	okx ( memcmp ( &actual_auth, &expected_auth,
+		       sizeof ( actual_auth ) ) == 0, file, line );
+
+	/* Decrypt in situ using default implementation */
+	okx ( cipher_setkey ( gcm, ctx, key, sizeof ( key ) ) == 0,
+	      file, line );
+	cipher_setiv ( gcm, ctx, iv, sizeof ( iv ) );
+	cipher_decrypt ( gcm, ctx, additional, NULL, sizeof ( additional ) );
+	cipher_decrypt ( gcm, ctx, actual, actual, sizeof ( actual ) );
+	cipher_auth ( gcm, ctx, &actual_auth );
+	okx ( memcmp ( actual, plaintext, sizeof ( actual ) ) == 0,
+	      file, line );
+	okx ( memcmp ( &actual_auth, &expected_auth,
+		       sizeof ( actual_auth ) ) == 0, file, line );
+}
+#define gcm_consistency_ok( key_len, iv_len ) \
+	gcm_consistency_okx ( key_len, iv_len, __FILE__, __LINE__ )
+
+/**
+ * Perform Galois/Counter Mode self-test using current implementation
+ *
+ * @v impl		Implementation description
+ */
+static void gcm_test_impl ( const char *impl ) {
 	struct cipher_algorithm *gcm = &aes_gcm_algorithm;
 	unsigned int keylen;
 
@@ -387,13 +492,38 @@ static void gcm_test_exec ( void ) {
 
 	/* Speed tests */
 	for ( keylen = 128 ; keylen <= 256 ; keylen += 64 ) {
-		DBG ( "AES-%d-GCM encryption required %ld cycles per byte\n",
-		      keylen, cipher_cost_encrypt ( gcm, ( keylen / 8 ) ) );
-		DBG ( "AES-%d-GCM decryption required %ld cycles per byte\n",
-		      keylen, cipher_cost_decrypt ( gcm, ( keylen / 8 ) ) );
+		DBG ( "AES-%d-GCM encryption (%s) required %ld cycles per "
+		      "byte\n", keylen, impl,
+		      cipher_cost_encrypt ( gcm, ( keylen / 8 ) ) );
+		DBG ( "AES-%d-GCM decryption (%s) required %ld cycles per "
+		      "byte\n", keylen, impl,
+		      cipher_cost_decrypt ( gcm, ( keylen / 8 ) ) );
 	}
 }
 
+/**
+ * Perform Galois/Counter Mode self-test
+ *
+ */
+static void gcm_test_exec ( void ) {
+
+	/* Test default implementation (which may be accelerated) */
+	gcm_test_impl ( "default" );
+
+	/* Test generic implementation */
+	aes_accel_disabled = 1;
+	gcm_accel_disabled = 1;
+	gcm_test_impl ( "generic" );
+	aes_accel_disabled = 0;
+	gcm_accel_disabled = 0;
+
+	/* Implementation consistency tests */
+	gcm_consistency_ok ( ( 128 / 8 ), 12 );
+	gcm_consistency_ok ( ( 192 / 8 ), 12 );
+	gcm_consistency_ok ( ( 256 / 8 ), 12 );
+	gcm_consistency_ok ( ( 128 / 8 ), 61 );
+}
+
 /** Galois/Counter Mode self-test */
 struct self_test gcm_test __self_test = {
 	.name = "gcm",
@@ -79,6 +79,15 @@ GZIP ( hello_world,
        DATA ( 0x48, 0x65, 0x6c, 0x6c, 0x6f, 0x20, 0x77, 0x6f, 0x72, 0x6c,
 	      0x64 ) );
 
+/** "Hello world" with corrupted CRC */
+GZIP ( hello_corrupt,
+       DATA ( 0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x03,
+	      0xf3, 0x48, 0xcd, 0xc9, 0xc9, 0x57, 0x28, 0xcf, 0x2f, 0xca,
+	      0x49, 0x01, 0x00, 0x52, 0x9e, 0xd6, 0x8c, 0x0b, 0x00, 0x00,
+	      0x00 ),
+       DATA ( 0x48, 0x65, 0x6c, 0x6c, 0x6f, 0x20, 0x77, 0x6f, 0x72, 0x6c,
+	      0x64 ) );
+
 /** "Hello filename" */
 GZIP ( hello_filename,
        DATA ( 0x1f, 0x8b, 0x08, 0x08, 0xeb, 0x5b, 0x96, 0x60, 0x00, 0x03,
@@ -141,6 +150,32 @@ static void gzip_okx ( struct gzip_test *test, const char *file,
 }
 #define gzip_ok( test ) gzip_okx ( test, __FILE__, __LINE__ )
 
+/**
+ * Report gzip failure test result
+ *
+ * @v test		gzip test
+ * @v file		Test code file
+ * @v line		Test code line
+ */
+static void gzip_fail_okx ( struct gzip_test *test, const char *file,
+			    unsigned int line ) {
+	struct image *image;
+	struct image *extracted;
+
+	/* Construct compressed image */
+	image = image_memory ( test->compressed_name, test->compressed,
+			       test->compressed_len );
+	okx ( image != NULL, file, line );
+	okx ( image->type == &gzip_image_type, file, line );
+
+	/* Check that extraction fails */
+	okx ( image_extract ( image, NULL, &extracted ) != 0, file, line );
+
+	/* Unregister image */
+	unregister_image ( image );
+}
+#define gzip_fail_ok( test ) gzip_fail_okx ( test, __FILE__, __LINE__ )
+
 /**
  * Perform gzip self-test
  *
@@ -150,6 +185,7 @@ static void gzip_test_exec ( void ) {
 	gzip_ok ( &hello_world );
 	gzip_ok ( &hello_filename );
 	gzip_ok ( &hello_headers );
+	gzip_fail_ok ( &hello_corrupt );
 }
 
 /** gzip self-test */
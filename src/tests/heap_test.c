@@ -0,0 +1,273 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+FILE_SECBOOT ( PERMITTED );
+
+/** @file
+ *
+ * Heap allocator self-tests
+ *
+ */
+
+/* Forcibly enable assertions */
+#undef NDEBUG
+
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+#include <ipxe/malloc.h>
+#include <ipxe/io.h>
+#include <ipxe/profile.h>
+#include <ipxe/test.h>
+
+/** Heap test area size */
+#define HEAP_TEST_SIZE ( 64 * 1024 )
+
+/** Heap test free block alignment */
+#define HEAP_TEST_ALIGN ( 4 * sizeof ( void * ) )
+
+/** Number of blocks used to fragment the heap for profiling */
+#define HEAP_PROFILE_FRAGMENTS 256
+
+/** Number of allocations to profile */
+#define HEAP_PROFILE_COUNT 1024
+
+/** Heap test area */
+static char __attribute__ (( aligned ( HEAP_TEST_ALIGN ) ))
+	heap_test_area[HEAP_TEST_SIZE];
+
+/** Heap under test */
+static struct heap test_heap = {
+	.blocks = LIST_HEAD_INIT ( test_heap.blocks ),
+	.align = HEAP_TEST_ALIGN,
+	.ptr_align = sizeof ( void * ),
+};
+
+/**
+ * Report heap reallocation test result
+ *
+ * @v old_len		Original length
+ * @v new_len		New length
+ * @v file		Test code file
+ * @v line		Test code line
+ */
+static void heap_realloc_okx ( size_t old_len, size_t new_len,
+			       const char *file, unsigned int line ) {
+	size_t freemem = test_heap.freemem;
+	size_t len = ( ( old_len < new_len ) ? old_len : new_len );
+	uint8_t *old;
+	uint8_t *new;
+	size_t i;
+
+	/* Allocate and fill original block */
+	old = heap_realloc ( &test_heap, NULL, old_len );
+	okx ( old != NULL, file, line );
+	if ( ! old )
+		return;
+	okx ( ( ( ( intptr_t ) old ) & ( sizeof ( void * ) - 1 ) ) == 0,
+	      file, line );
+	for ( i = 0 ; i < old_len ; i++ )
+		old[i] = i;
+
+	/* Reallocate and check preserved contents */
+	new = heap_realloc ( &test_heap, old, new_len );
+	okx ( new != NULL, file, line );
+	if ( ! new )
+		return;
+	for ( i = 0 ; i < len ; i++ )
+		okx ( new[i] == ( i & 0xff ), file, line );
+
+	/* Free block and check that free memory is restored */
+	heap_realloc ( &test_heap, new, 0 );
+	okx ( test_heap.freemem == freemem, file, line );
+}
+#define heap_realloc_ok( old_len, new_len ) \
+	heap_realloc_okx ( old_len, new_len, __FILE__, __LINE__ )
+
+/**
+ * Report aligned allocation test result
+ *
+ * @v len		Length
+ * @v align		Physical alignment
+ * @v offset		Offset from physical alignment
+ * @v file		Test code file
+ * @v line		Test code line
+ */
+static void malloc_phys_offset_okx ( size_t len, size_t align,
+				     size_t offset, const char *file,
+				     unsigned int line ) {
+	void *ptr;
+
+	/* Allocate block */
+	ptr = malloc_phys_offset ( len, align, offset );
+	okx ( ptr != NULL, file, line );
+	if ( ! ptr )
+		return;
+
+	/* Check alignment */
+	okx ( ( virt_to_phys ( ptr ) & ( align - 1 ) ) == offset, file, line );
+
+	/* Free block */
+	free_phys ( ptr, len );
+}
+#define malloc_phys_offset_ok( len, align, offset ) \
+	malloc_phys_offset_okx ( len, align, offset, __FILE__, __LINE__ )
+
+/**
+ * Check reuse of recently freed blocks
+ *
+ */
+static void heap_reuse_ok ( void ) {
+	void *first;
+	void *second;
+
+	/* Check that a freed small block is reused */
+	first = heap_realloc ( &test_heap, NULL, 48 );
+	ok ( first != NULL );
+	heap_realloc ( &test_heap, first, 0 );
+	second = heap_realloc ( &test_heap, NULL, 48 );
+	ok ( second == first );
+	heap_realloc ( &test_heap, second, 0 );
+}
+
+/**
+ * Check exhaustion by small blocks
+ *
+ */
+static void heap_exhaust_ok ( void ) {
+	size_t freemem = test_heap.freemem;
+	void **ptrs = NULL;
+	void **next;
+	void *large;
+
+	/* Fill heap with small blocks, chained via their contents */
+	while ( ( next = heap_realloc ( &test_heap, NULL, 40 ) ) ) {
+		*next = ptrs;
+		ptrs = next;
+	}
+	ok ( ptrs != NULL );
+	ok ( test_heap.freemem < ( HEAP_TEST_SIZE / 64 ) );
+
+	/* Free all blocks */
+	while ( ( next = ptrs ) ) {
+		ptrs = *next;
+		heap_realloc ( &test_heap, next, 0 );
+	}
+	ok ( test_heap.freemem == freemem );
+
+	/* Check that binned blocks are merged to satisfy a large
+	 * allocation.
+	 */
+	large = heap_realloc ( &test_heap, NULL, ( HEAP_TEST_SIZE / 2 ) );
+	ok ( large != NULL );
+	heap_realloc ( &test_heap, large, 0 );
+	ok ( test_heap.freemem == freemem );
+}
+
+/**
+ * Profile allocation within a fragmented heap
+ *
+ * @v len		Allocation length
+ */
+static void heap_profile ( size_t len ) {
+	struct profiler profiler;
+	void *fragments[HEAP_PROFILE_FRAGMENTS];
+	size_t freemem = test_heap.freemem;
+	void *ptr;
+	unsigned int i;
+
+	/* Fragment heap by freeing alternate blocks of varying sizes */
+	for ( i = 0 ; i < HEAP_PROFILE_FRAGMENTS ; i++ ) {
+		fragments[i] = heap_realloc ( &test_heap, NULL,
+					      ( 16 + ( ( i * 37 ) % 200 ) ) );
+		ok ( fragments[i] != NULL );
+	}
+	for ( i = 0 ; i < HEAP_PROFILE_FRAGMENTS ; i += 2 ) {
+		heap_realloc ( &test_heap, fragments[i], 0 );
+		fragments[i] = NULL;
+	}
+
+	/* Profile allocation and free */
+	memset ( &profiler, 0, sizeof ( profiler ) );
+	for ( i = 0 ; i < HEAP_PROFILE_COUNT ; i++ ) {
+		profile_start ( &profiler );
+		ptr = heap_realloc ( &test_heap, NULL, len );
+		heap_realloc ( &test_heap, ptr, 0 );
+		profile_stop ( &profiler );
+		ok ( ptr != NULL );
+	}
+
+	/* Free remaining fragments */
+	for ( i = 0 ; i < HEAP_PROFILE_FRAGMENTS ; i++ )
+		heap_realloc ( &test_heap, fragments[i], 0 );
+	ok ( test_heap.freemem == freemem );
+
+	DBG ( "HEAP allocated and freed %zd bytes in %ld +/- %ld ticks\n",
+	      len, profile_mean ( &profiler ), profile_stddev ( &profiler ) );
+}
+
+/**
+ * Perform heap allocator self-tests
+ *
+ */
+static void heap_test_exec ( void ) {
+
+	/* Populate heap under test */
+	heap_populate ( &test_heap, heap_test_area,
+			sizeof ( heap_test_area ) );
+	ok ( test_heap.freemem == sizeof ( heap_test_area ) );
+
+	/* Reallocation */
+	heap_realloc_ok ( 1, 1 );
+	heap_realloc_ok ( 10, 100 );
+	heap_realloc_ok ( 100, 10 );
+	heap_realloc_ok ( 200, 2000 );
+	heap_realloc_ok ( 4000, 40 );
+
+	/* Reuse of recently freed blocks */
+	heap_reuse_ok();
+
+	/* Exhaustion */
+	heap_exhaust_ok();
+
+	/* Aligned allocations */
+	malloc_phys_offset_ok ( 64, 64, 0 );
+	malloc_phys_offset_ok ( 64, 64, 8 );
+	malloc_phys_offset_ok ( 64, 64, 16 );
+	malloc_phys_offset_ok ( 100, 128, 36 );
+	malloc_phys_offset_ok ( 100, 128, 36 );
+	malloc_phys_offset_ok ( 1500, 4096, 2 );
+
+	/* Profiling */
+	heap_profile ( 32 );
+	heap_profile ( 256 );
+	heap_profile ( 1024 );
+	heap_profile ( 4096 );
+}
+
+/** Heap allocator self-test */
+struct self_test heap_test __self_test = {
+	.name = "heap",
+	.exec = heap_test_exec,
+};
@@ -0,0 +1,429 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+/** @file
+ *
+ * HPACK header compression tests
+ *
+ * Decoding test vectors are taken from RFC 7541 Appendix C.
+ *
+ */
+
+/* Forcibly enable assertions */
+#undef NDEBUG
+
+#include <stdint.h>
+#include <string.h>
+#include <ipxe/hpack.h>
+#include <ipxe/test.h>
+
+/** An HPACK decoding test */
+struct hpack_test {
+	/** Header block */
+	const void *data;
+	/** Length of header block */
+	size_t len;
+	/** Expected header fields (as "name: value" lines) */
+	const char *expected;
+	/** Expected dynamic table size after decoding */
+	size_t size;
+};
+
+/** An HPACK encoding test */
+struct hpack_encode_test {
+	/** Header field */
+	struct hpack_header header;
+	/** Expected encoding */
+	const void *data;
+	/** Length of expected encoding */
+	size_t len;
+};
+
+/** Define inline data */
+#define DATA(...) { __VA_ARGS__ }
+
+/** Define an HPACK decoding test */
+#define HPACK( name, DATA, EXPECTED, SIZE )				\
+	static const uint8_t name ## _data[] = DATA;			\
+	static struct hpack_test name = {				\
+		.data = name ## _data,					\
+		.len = sizeof ( name ## _data ),			\
+		.expected = EXPECTED,					\
+		.size = SIZE,						\
+	}
+
+/** Define an HPACK encoding test */
+#define HPACK_ENCODE( test, NAME, VALUE, DATA )				\
+	static const uint8_t test ## _data[] = DATA;			\
+	static struct hpack_encode_test test = {			\
+		.header = {						\
+			.name = NAME,					\
+			.name_len = ( sizeof ( NAME ) - 1 ),		\
+			.value = VALUE,					\
+			.value_len = ( sizeof ( VALUE ) - 1 ),		\
+		},							\
+		.data = test ## _data,					\
+		.len = sizeof ( test ## _data ),			\
+	}
+
+/** Expected request header fields (first request) */
+#define REQUEST_1							\
+	":method: GET\n:scheme: http\n:path: /\n"			\
+	":authority: www.example.com\n"
+
+/** Expected request header fields (second request) */
+#define REQUEST_2 REQUEST_1 "cache-control: no-cache\n"
+
+/** Expected request header fields (third request) */
+#define REQUEST_3							\
+	":method: GET\n:scheme: https\n:path: /index.html\n"		\
+	":authority: www.example.com\ncustom-key: custom-value\n"
+
+/** Expected response header fields (first response) */
+#define RESPONSE_1							\
+	":status: 302\ncache-control: private\n"			\
+	"date: Mon, 21 Oct 2013 20:13:21 GMT\n"				\
+	"location: https://www.example.com\n"
+
+/** Expected response header fields (second response) */
+#define RESPONSE_2							\
+	":status: 307\ncache-control: private\n"			\
+	"date: Mon, 21 Oct 2013 20:13:21 GMT\n"				\
+	"location: https://www.example.com\n"
+
+/** Expected response header fields (third response) */
+#define RESPONSE_3							\
+	":status: 200\ncache-control: private\n"			\
+	"date: Mon, 21 Oct 2013 20:13:22 GMT\n"				\
+	"location: https://www.example.com\ncontent-encoding: gzip\n"	\
+	"set-cookie: foo=ASDJKHQKBZXOQWEOPIUAXQWEOIU; max-age=3600; "	\
+	"version=1\n"
+
+/** RFC 7541 C.3.1 */
+HPACK ( c3_1, DATA ( 0x82, 0x86, 0x84, 0x41, 0x0f, 0x77, 0x77, 0x77, 0x2e,
+		     0x65, 0x78, 0x61, 0x6d, 0x70, 0x6c, 0x65, 0x2e, 0x63,
+		     0x6f, 0x6d ),
+	REQUEST_1, 57 );
+
+/** RFC 7541 C.3.2 */
+HPACK ( c3_2, DATA ( 0x82, 0x86, 0x84, 0xbe, 0x58, 0x08, 0x6e, 0x6f, 0x2d,
+		     0x63, 0x61, 0x63, 0x68, 0x65 ),
+	REQUEST_2, 110 );
+
+/** RFC 7541 C.3.3 */
+HPACK ( c3_3, DATA ( 0x82, 0x87, 0x85, 0xbf, 0x40, 0x0a, 0x63, 0x75, 0x73,
+		     0x74, 0x6f, 0x6d, 0x2d, 0x6b, 0x65, 0x79, 0x0c, 0x63,
+		     0x75, 0x73, 0x74, 0x6f, 0x6d, 0x2d, 0x76, 0x61, 0x6c,
+		     0x75, 0x65 ),
+	REQUEST_3, 164 );
+
+/** RFC 7541 C.4.1 */
+HPACK ( c4_1, DATA ( 0x82, 0x86, 0x84, 0x41, 0x8c, 0xf1, 0xe3, 0xc2, 0xe5,
+		     0xf2, 0x3a, 0x6b, 0xa0, 0xab, 0x90, 0xf4, 0xff ),
+	REQUEST_1, 57 );
+
+/** RFC 7541 C.4.2 */
+HPACK ( c4_2, DATA ( 0x82, 0x86, 0x84, 0xbe, 0x58, 0x86, 0xa8, 0xeb, 0x10,
+		     0x64, 0x9c, 0xbf ),
+	REQUEST_2, 110 );
+
+/** RFC 7541 C.4.3 */
+HPACK ( c4_3, DATA ( 0x82, 0x87, 0x85, 0xbf, 0x40, 0x88, 0x25, 0xa8, 0x49,
+		     0xe9, 0x5b, 0xa9, 0x7d, 0x7f, 0x89, 0x25, 0xa8, 0x49,
+		     0xe9, 0x5b, 0xb8, 0xe8, 0xb4, 0xbf ),
+	REQUEST_3, 164 );
+
+/** RFC 7541 C.5.1 */
+HPACK ( c5_1, DATA ( 0x48, 0x03, 0x33, 0x30, 0x32, 0x58, 0x07, 0x70, 0x72,
+		     0x69, 0x76, 0x61, 0x74, 0x65, 0x61, 0x1d, 0x4d, 0x6f,
+		     0x6e, 0x2c, 0x20, 0x32, 0x31, 0x20, 0x4f, 0x63, 0x74,
+		     0x20, 0x32, 0x30, 0x31, 0x33, 0x20, 0x32, 0x30, 0x3a,
+		     0x31, 0x33, 0x3a, 0x32, 0x31, 0x20, 0x47, 0x4d, 0x54,
+		     0x6e, 0x17, 0x68, 0x74, 0x74, 0x70, 0x73, 0x3a, 0x2f,
+		     0x2f, 0x77, 0x77, 0x77, 0x2e, 0x65, 0x78, 0x61, 0x6d,
+		     0x70, 0x6c, 0x65, 0x2e, 0x63, 0x6f, 0x6d ),
+	RESPONSE_1, 222 );
+
+/** RFC 7541 C.5.2 */
+HPACK ( c5_2, DATA ( 0x48, 0x03, 0x33, 0x30, 0x37, 0xc1, 0xc0, 0xbf ),
+	RESPONSE_2, 222 );
+
+/** RFC 7541 C.5.3 */
+HPACK ( c5_3, DATA ( 0x88, 0xc1, 0x61, 0x1d, 0x4d, 0x6f, 0x6e, 0x2c, 0x20,
+		     0x32, 0x31, 0x20, 0x4f, 0x63, 0x74, 0x20, 0x32, 0x30,
+		     0x31, 0x33, 0x20, 0x32, 0x30, 0x3a, 0x31, 0x33, 0x3a,
+		     0x32, 0x32, 0x20, 0x47, 0x4d, 0x54, 0xc0, 0x5a, 0x04,
+		     0x67, 0x7a, 0x69, 0x70, 0x77, 0x38, 0x66, 0x6f, 0x6f,
+		     0x3d, 0x41, 0x53, 0x44, 0x4a, 0x4b, 0x48, 0x51, 0x4b,
+		     0x42, 0x5a, 0x58, 0x4f, 0x51, 0x57, 0x45, 0x4f, 0x50,
+		     0x49, 0x55, 0x41, 0x58, 0x51, 0x57, 0x45, 0x4f, 0x49,
+		     0x55, 0x3b, 0x20, 0x6d, 0x61, 0x78, 0x2d, 0x61, 0x67,
+		     0x65, 0x3d, 0x33, 0x36, 0x30, 0x30, 0x3b, 0x20, 0x76,
+		     0x65, 0x72, 0x73, 0x69, 0x6f, 0x6e, 0x3d, 0x31 ),
+	RESPONSE_3, 215 );
+
+/** RFC 7541 C.6.1 */
+HPACK ( c6_1, DATA ( 0x48, 0x82, 0x64, 0x02, 0x58, 0x85, 0xae, 0xc3, 0x77,
+		     0x1a, 0x4b, 0x61, 0x96, 0xd0, 0x7a, 0xbe, 0x94, 0x10,
+		     0x54, 0xd4, 0x44, 0xa8, 0x20, 0x05, 0x95, 0x04, 0x0b,
+		     0x81, 0x66, 0xe0, 0x82, 0xa6, 0x2d, 0x1b, 0xff, 0x6e,
+		     0x91, 0x9d, 0x29, 0xad, 0x17, 0x18, 0x63, 0xc7, 0x8f,
+		     0x0b, 0x97, 0xc8, 0xe9, 0xae, 0x82, 0xae, 0x43, 0xd3 ),
+	RESPONSE_1, 222 );
+
+/** RFC 7541 C.6.2 */
+HPACK ( c6_2, DATA ( 0x48, 0x83, 0x64, 0x0e, 0xff, 0xc1, 0xc0, 0xbf ),
+	RESPONSE_2, 222 );
+
+/** RFC 7541 C.6.3 */
+HPACK ( c6_3, DATA ( 0x88, 0xc1, 0x61, 0x96, 0xd0, 0x7a, 0xbe, 0x94, 0x10,
+		     0x54, 0xd4, 0x44, 0xa8, 0x20, 0x05, 0x95, 0x04, 0x0b,
+		     0x81, 0x66, 0xe0, 0x84, 0xa6, 0x2d, 0x1b, 0xff, 0xc0,
+		     0x5a, 0x83, 0x9b, 0xd9, 0xab, 0x77, 0xad, 0x94, 0xe7,
+		     0x82, 0x1d, 0xd7, 0xf2, 0xe6, 0xc7, 0xb3, 0x35, 0xdf,
+		     0xdf, 0xcd, 0x5b, 0x39, 0x60, 0xd5, 0xaf, 0x27, 0x08,
+		     0x7f, 0x36, 0x72, 0xc1, 0xab, 0x27, 0x0f, 0xb5, 0x29,
+		     0x1f, 0x95, 0x87, 0x31, 0x60, 0x65, 0xc0, 0x03, 0xed,
+		     0x4e, 0xe5, 0xb1, 0x06, 0x3d, 0x50, 0x07 ),
+	RESPONSE_3, 215 );
+
+/** Index zero */
+HPACK ( bad_zero, DATA ( 0x80 ), NULL, 0 );
+
+/** Index beyond end of (empty) dynamic table */
+HPACK ( bad_index, DATA ( 0xbe ), NULL, 0 );
+
+/** Truncated integer */
+HPACK ( bad_integer, DATA ( 0x0f ), NULL, 0 );
+
+/** Truncated string */
+HPACK ( bad_string, DATA ( 0x04, 0x05, 0x2f ), NULL, 0 );
+
+/** Huffman padding that is not a prefix of the end-of-string symbol */
+HPACK ( bad_padding, DATA ( 0x04, 0x81, 0x00 ), NULL, 0 );
+
+/** Huffman padding longer than seven bits */
+HPACK ( bad_long_padding, DATA ( 0x04, 0x82, 0x07, 0xff ), NULL, 0 );
+
+/** Dynamic table size update exceeding protocol limit */
+HPACK ( bad_update, DATA ( 0x3f, 0xe2, 0x1f ), NULL, 0 );
+
+/** Indexed header field */
+HPACK_ENCODE ( enc_indexed, ":method", "GET", DATA ( 0x82 ) );
+
+/** Literal header field with indexed name (RFC 7541 C.2.2) */
+HPACK_ENCODE ( enc_name, ":path", "/sample/path",
+	       DATA ( 0x04, 0x0c, 0x2f, 0x73, 0x61, 0x6d, 0x70, 0x6c, 0x65,
+		      0x2f, 0x70, 0x61, 0x74, 0x68 ) );
+
+/** Literal header field with multi-byte name index */
+HPACK_ENCODE ( enc_range, "range", "bytes=0-",
+	       DATA ( 0x0f, 0x23, 0x08, 0x62, 0x79, 0x74, 0x65, 0x73, 0x3d,
+		      0x30, 0x2d ) );
+
+/** Literal header field with new name */
+HPACK_ENCODE ( enc_literal, "custom-key", "custom-header",
+	       DATA ( 0x00, 0x0a, 0x63, 0x75, 0x73, 0x74, 0x6f, 0x6d, 0x2d,
+		      0x6b, 0x65, 0x79, 0x0d, 0x63, 0x75, 0x73, 0x74, 0x6f,
+		      0x6d, 0x2d, 0x68, 0x65, 0x61, 0x64, 0x65, 0x72 ) );
+
+/** Decoded header fields */
+static char hpack_decoded[256];
+
+/** Length of decoded header fields */
+static size_t hpack_decoded_len;
+
+/**
+ * Record decoded header field
+ *
+ * @v ctx		Context
+ * @v header		Header field
+ * @ret rc		Return status code
+ */
+static int hpack_test_emit ( void *ctx __unused, struct hpack_header *header ) {
+	char *line = ( hpack_decoded + hpack_decoded_len );
+	size_t len;
+
+	len = ( header->name_len + 2 /* ": " */ + header->value_len +
+		1 /* "\n" */ );
+	if ( ( hpack_decoded_len + len ) >= sizeof ( hpack_decoded ) )
+		return -1;
+	memcpy ( line, header->name, header->name_len );
+	line += header->name_len;
+	*(line++) = ':';
+	*(line++) = ' ';
+	memcpy ( line, header->value, header->value_len );
+	line += header->value_len;
+	*(line++) = '\n';
+	*line = '\0';
+	hpack_decoded_len += len;
+	return 0;
+}
+
+/**
+ * Report an HPACK decoding test result
+ *
+ * @v test		HPACK decoding test
+ * @v table		Dynamic table
+ * @v file		Test code file
+ * @v line		Test code line
+ */
+static void hpack_decode_okx ( struct hpack_test *test,
+			       struct hpack_table *table, const char *file,
+			       unsigned int line ) {
+	int rc;
+
+	hpack_decoded_len = 0;
+	hpack_decoded[0] = '\0';
+	rc = hpack_decode ( table, test->data, test->len, hpack_test_emit,
+			    NULL );
+	if ( test->expected ) {
+		okx ( rc == 0, file, line );
+		okx ( strcmp ( hpack_decoded, test->expected ) == 0,
+		      file, line );
+		okx ( table->size == test->size, file, line );
+	} else {
+		okx ( rc != 0, file, line );
+	}
+}
+#define hpack_decode_ok( test, table ) \
+	hpack_decode_okx ( test, table, __FILE__, __LINE__ )
+
+/**
+ * Report an HPACK encoding test result
+ *
+ * @v test		HPACK encoding test
+ * @v file		Test code file
+ * @v line		Test code line
+ */
+static void hpack_encode_okx ( struct hpack_encode_test *test,
+			       const char *file, unsigned int line ) {
+	struct hpack_table table;
+	uint8_t buf[ test->len ];
+	size_t len;
+
+	/* Check encoding */
+	len = hpack_encode ( NULL, &test->header );
+	okx ( len == test->len, file, line );
+	len = hpack_encode ( buf, &test->header );
+	okx ( len == test->len, file, line );
+	okx ( memcmp ( buf, test->data, test->len ) == 0, file, line );
+
+	/* Check that encoding is decodable */
+	hpack_init ( &table, HPACK_DEFAULT_TABLE_SIZE );
+	hpack_decoded_len = 0;
+	okx ( hpack_decode ( &table, buf, len, hpack_test_emit, NULL ) == 0,
+	      file, line );
+	okx ( hpack_decoded_len == ( test->header.name_len + 2 /* ": " */ +
+				     test->header.value_len + 1 /* "\n" */ ),
+	      file, line );
+	okx ( memcmp ( hpack_decoded, test->header.name,
+		       test->header.name_len ) == 0, file, line );
+	okx ( table.size == 0, file, line );
+}
+#define hpack_encode_ok( test ) \
+	hpack_encode_okx ( test, __FILE__, __LINE__ )
+
+/**
+ * Perform HPACK self-tests
+ *
+ */
+static void hpack_test_exec ( void ) {
+	struct hpack_table table;
+	struct hpack_header header;
+	char value[200];
+	uint8_t buf[ 2 /* index */ + 2 /* length */ + sizeof ( value ) ];
+	size_t len;
+
+	/* Requests without Huffman coding */
+	hpack_init ( &table, HPACK_DEFAULT_TABLE_SIZE );
+	hpack_decode_ok ( &c3_1, &table );
+	hpack_decode_ok ( &c3_2, &table );
+	hpack_decode_ok ( &c3_3, &table );
+	hpack_flush ( &table );
+	ok ( table.size == 0 );
+
+	/* Requests with Huffman coding */
+	hpack_init ( &table, HPACK_DEFAULT_TABLE_SIZE );
+	hpack_decode_ok ( &c4_1, &table );
+	hpack_decode_ok ( &c4_2, &table );
+	hpack_decode_ok ( &c4_3, &table );
+	hpack_flush ( &table );
+
+	/* Responses without Huffman coding (with eviction) */
+	hpack_init ( &table, 256 );
+	hpack_decode_ok ( &c5_1, &table );
+	hpack_decode_ok ( &c5_2, &table );
+	hpack_decode_ok ( &c5_3, &table );
+	hpack_flush ( &table );
+
+	/* Responses with Huffman coding (with eviction) */
+	hpack_init ( &table, 256 );
+	hpack_decode_ok ( &c6_1, &table );
+	hpack_decode_ok ( &c6_2, &table );
+	hpack_decode_ok ( &c6_3, &table );
+	hpack_flush ( &table );
+
+	/* Malformed header blocks */
+	hpack_init ( &table, HPACK_DEFAULT_TABLE_SIZE );
+	hpack_decode_ok ( &bad_zero, &table );
+	hpack_decode_ok ( &bad_index, &table );
+	hpack_decode_ok ( &bad_integer, &table );
+	hpack_decode_ok ( &bad_string, &table );
+	hpack_decode_ok ( &bad_padding, &table );
+	hpack_decode_ok ( &bad_long_padding, &table );
+	hpack_decode_ok ( &bad_update, &table );
+	hpack_flush ( &table );
+
+	/* Encoding */
+	hpack_encode_ok ( &enc_indexed );
+	hpack_encode_ok ( &enc_name );
+	hpack_encode_ok ( &enc_range );
+	hpack_encode_ok ( &enc_literal );
+
+	/* Encoding of long values */
+	memset ( value, 'x', sizeof ( value ) );
+	header.name = "user-agent";
+	header.name_len = strlen ( header.name );
+	header.value = value;
+	header.value_len = sizeof ( value );
+	len = hpack_encode ( buf, &header );
+	ok ( len == sizeof ( buf ) );
+	ok ( buf[0] == 0x0f );
+	ok ( buf[1] == 0x2b );
+	ok ( buf[2] == 0x7f );
+	ok ( buf[3] == 0x49 );
+	hpack_init ( &table, HPACK_DEFAULT_TABLE_SIZE );
+	hpack_decoded_len = 0;
+	ok ( hpack_decode ( &table, buf, len, hpack_test_emit, NULL ) == 0 );
+	ok ( hpack_decoded_len == ( header.name_len + 2 /* ": " */ +
+				    header.value_len + 1 /* "\n" */ ) );
+}
+
+/** HPACK self-test */
+struct self_test hpack_test __self_test = {
+	.name = "hpack",
+	.exec = hpack_test_exec,
+};
@@ -0,0 +1,362 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+/** @file
+ *
+ * Decompression during download tests
+ *
+ */
+
+/* Forcibly enable assertions */
+#undef NDEBUG
+
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+#include <ipxe/interface.h>
+#include <ipxe/xfer.h>
+#include <ipxe/xferbuf.h>
+#include <ipxe/inflate.h>
+#include <ipxe/test.h>
+
+/** An inflate test */
+struct inflate_test {
+	/** Compressed data */
+	const void *compressed;
+	/** Length of compressed data */
+	size_t compressed_len;
+	/** Expected decompressed data */
+	const void *expected;
+	/** Length of expected decompressed data */
+	size_t expected_len;
+};
+
+/** An inflate test data sink */
+struct inflate_test_sink {
+	/** Data transfer interface */
+	struct interface xfer;
+	/** Data source interface */
+	struct interface source;
+	/** Data transfer buffer */
+	struct xfer_buffer buffer;
+	/** Close status */
+	int rc;
+	/** Interface has been closed */
+	int closed;
+};
+
+/** Define inline data */
+#define DATA(...) { __VA_ARGS__ }
+
+/** Define an inflate test */
+#define INFLATE( name, COMPRESSED, EXPECTED )				\
+	static const uint8_t name ## _compressed[] = COMPRESSED;	\
+	static const uint8_t name ## _expected[] = EXPECTED;		\
+	static struct inflate_test name = {				\
+		.compressed = name ## _compressed,			\
+		.compressed_len = sizeof ( name ## _compressed ),	\
+		.expected = name ## _expected,				\
+		.expected_len = sizeof ( name ## _expected ),		\
+	};
+
+/** Number of runs in generated test data */
+#define INFLATE_TEST_RUNS 2000
+
+/** Length of generated test data */
+#define INFLATE_TEST_RUNS_LEN 6000
+
+/** "Hello world" (gzip) */
+INFLATE ( hello_gzip,
+	  DATA ( 0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x03,
+		 0xf3, 0x48, 0xcd, 0xc9, 0xc9, 0x57, 0x28, 0xcf, 0x2f, 0xca,
+		 0x49, 0x01, 0x00, 0x52, 0x9e, 0xd6, 0x8b, 0x0b, 0x00, 0x00,
+		 0x00 ),
+	  DATA ( 0x48, 0x65, 0x6c, 0x6c, 0x6f, 0x20, 0x77, 0x6f, 0x72, 0x6c,
+		 0x64 ) );
+
+/** "Hello world" (gzip) with corrupted CRC */
+INFLATE ( hello_corrupt,
+	  DATA ( 0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x03,
+		 0xf3, 0x48, 0xcd, 0xc9, 0xc9, 0x57, 0x28, 0xcf, 0x2f, 0xca,
+		 0x49, 0x01, 0x00, 0x52, 0x9e, 0xd6, 0x8c, 0x0b, 0x00, 0x00,
+		 0x00 ),
+	  DATA ( 0x48, 0x65, 0x6c, 0x6c, 0x6f, 0x20, 0x77, 0x6f, 0x72, 0x6c,
+		 0x64 ) );
+
+/** "Hello assorted headers" (gzip) */
+INFLATE ( hello_headers,
+	  DATA ( 0x1f, 0x8b, 0x08, 0x1c, 0x11, 0x5c, 0x96, 0x60, 0x00, 0x03,
+		 0x05, 0x00, 0x41, 0x70, 0x01, 0x00, 0x0d, 0x68, 0x77, 0x2e,
+		 0x74, 0x78, 0x74, 0x00, 0x2f, 0x2f, 0x77, 0x68, 0x79, 0x3f,
+		 0x00, 0xf3, 0x48, 0xcd, 0xc9, 0xc9, 0x57, 0x48, 0x2c, 0x2e,
+		 0xce, 0x2f, 0x2a, 0x49, 0x4d, 0x51, 0xc8, 0x48, 0x4d, 0x4c,
+		 0x49, 0x2d, 0x2a, 0x06, 0x00, 0x59, 0xa4, 0x19, 0x61, 0x16,
+		 0x00, 0x00, 0x00 ),
+	  DATA ( 0x48, 0x65, 0x6c, 0x6c, 0x6f, 0x20, 0x61, 0x73, 0x73, 0x6f,
+		 0x72, 0x74, 0x65, 0x64, 0x20, 0x68, 0x65, 0x61, 0x64, 0x65,
+		 0x72, 0x73 ) );
+
+/** "Hello world" (zlib) */
+INFLATE ( hello_zlib,
+	  DATA ( 0x78, 0x9c, 0xf3, 0x48, 0xcd, 0xc9, 0xc9, 0x57, 0x28, 0xcf,
+		 0x2f, 0xca, 0x49, 0x01, 0x00, 0x18, 0xab, 0x04, 0x3d ),
+	  DATA ( 0x48, 0x65, 0x6c, 0x6c, 0x6f, 0x20, 0x77, 0x6f, 0x72, 0x6c,
+		 0x64 ) );
+
+/** Uncompressed data */
+INFLATE ( not_compressed,
+	  DATA ( 0x48, 0x65, 0x6c, 0x6c, 0x6f, 0x20, 0x77, 0x6f, 0x72, 0x6c,
+		 0x64 ),
+	  DATA ( 0x48, 0x65, 0x6c, 0x6c, 0x6f, 0x20, 0x77, 0x6f, 0x72, 0x6c,
+		 0x64 ) );
+
+/** Highly compressible generated data (gzip) */
+static const uint8_t runs_compressed[] = {
+	0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03,
+	0xed, 0xd1, 0x81, 0xad, 0xc3, 0x20, 0x0c, 0x84, 0xe1, 0xd9,
+	0x80, 0x86, 0xd0, 0x10, 0x1a, 0x42, 0x43, 0x68, 0xd8, 0x7f,
+	0x90, 0x67, 0x9f, 0xbc, 0xc4, 0x93, 0xce, 0x03, 0x7c, 0xf2,
+	0xe9, 0x77, 0xde, 0x87, 0x10, 0x5e, 0x72, 0x8b, 0x5e, 0x5c,
+	0xd7, 0x94, 0xd2, 0x5b, 0x6e, 0xd3, 0xcb, 0xfb, 0x5e, 0x4a,
+	0xf9, 0xc8, 0x1d, 0x7a, 0xf5, 0x3c, 0x5b, 0x6b, 0x5f, 0xb9,
+	0x4b, 0xaf, 0xdf, 0xf7, 0x18, 0xe3, 0x27, 0xf7, 0xe8, 0x4d,
+	0xe7, 0x3c, 0x34, 0x70, 0xaf, 0x25, 0x0a, 0xa6, 0x1a, 0xb8,
+	0xf7, 0x96, 0x05, 0x53, 0x0d, 0xdc, 0xe7, 0xa8, 0x82, 0xa9,
+	0x06, 0xee, 0x7b, 0x75, 0xc1, 0x54, 0x03, 0xf7, 0x7b, 0xa6,
+	0x60, 0xaa, 0x81, 0x0b, 0xf2, 0x5b, 0x84, 0x06, 0x2e, 0xc9,
+	0x6f, 0x19, 0x1a, 0xb8, 0x22, 0xbf, 0x55, 0x68, 0xe0, 0x9a,
+	0xfc, 0xd6, 0xa1, 0x81, 0x1b, 0xf2, 0xdb, 0x84, 0x06, 0xce,
+	0x07, 0x0c, 0x8d, 0xc6, 0xad, 0x09, 0x43, 0xb3, 0x71, 0x7b,
+	0xc1, 0xd0, 0x6a, 0xdc, 0xd9, 0x30, 0xb4, 0x1b, 0x77, 0x0f,
+	0x0c, 0x9d, 0xc6, 0x39, 0x8f, 0xa1, 0x8b, 0x71, 0x71, 0xc5,
+	0xd0, 0xcd, 0xb8, 0xbc, 0x63, 0xe8, 0x61, 0x5c, 0x3d, 0x31,
+	0xf4, 0x32, 0xae, 0xdf, 0x18, 0xfa, 0x18, 0x37, 0x1d, 0x2b,
+	0xb0, 0x02, 0x2b, 0xb0, 0x02, 0x2b, 0xb0, 0x02, 0x2b, 0xb0,
+	0x02, 0x2b, 0xb0, 0x02, 0x2b, 0xb0, 0x02, 0x2b, 0xb0, 0x02,
+	0x2b, 0xb0, 0x02, 0x2b, 0xb0, 0x02, 0x2b, 0xb0, 0x02, 0x2b,
+	0xfc, 0xf3, 0x0a, 0x7f, 0x0a, 0x16, 0xf9, 0x0f, 0x70, 0x17,
+	0x00, 0x00
+};
+
+/** Buffer for expected generated data */
+static uint8_t runs_expected[INFLATE_TEST_RUNS_LEN];
+
+/** Highly compressible generated data (gzip) */
+static struct inflate_test runs = {
+	.compressed = runs_compressed,
+	.compressed_len = sizeof ( runs_compressed ),
+	.expected = runs_expected,
+	.expected_len = sizeof ( runs_expected ),
+};
+
+/**
+ * Receive data
+ *
+ * @v sink		Data sink
+ * @v iobuf		I/O buffer
+ * @v meta		Data transfer metadata
+ * @ret rc		Return status code
+ */
+static int inflate_test_deliver ( struct inflate_test_sink *sink,
+				  struct io_buffer *iobuf,
+				  struct xfer_metadata *meta ) {
+
+	return xferbuf_deliver ( &sink->buffer, iobuf, meta );
+}
+
+/**
+ * Get underlying data transfer buffer
+ *
+ * @v sink		Data sink
+ * @ret xferbuf		Data transfer buffer
+ */
+static struct xfer_buffer *
+inflate_test_buffer ( struct inflate_test_sink *sink ) {
+
+	return &sink->buffer;
+}
+
+/**
+ * Close data sink
+ *
+ * @v sink		Data sink
+ * @v rc		Reason for close
+ */
+static void inflate_test_close ( struct inflate_test_sink *sink, int rc ) {
+
+	intf_restart ( &sink->xfer, rc );
+	sink->rc = rc;
+	sink->closed = 1;
+}
+
+/** Data sink interface operations */
+static struct interface_operation inflate_test_operations[] = {
+	INTF_OP ( xfer_deliver, struct inflate_test_sink *,
+		  inflate_test_deliver ),
+	INTF_OP ( xfer_buffer, struct inflate_test_sink *,
+		  inflate_test_buffer ),
+	INTF_OP ( intf_close, struct inflate_test_sink *,
+		  inflate_test_close ),
+};
+
+/** Data sink interface descriptor */
+static struct interface_descriptor inflate_test_desc =
+	INTF_DESC ( struct inflate_test_sink, xfer, inflate_test_operations );
+
+/**
+ * Decompress test data via filter
+ *
+ * @v test		Inflate test
+ * @v len		Length of compressed data to deliver
+ * @v frag_len		Maximum length of each delivered fragment
+ * @v sink		Data sink to fill in
+ * @v file		Test code file
+ * @v line		Test code line
+ */
+static void inflate_test_run ( struct inflate_test *test, size_t len,
+			       size_t frag_len, struct inflate_test_sink *sink,
+			       const char *file, unsigned int line ) {
+	const uint8_t *data = test->compressed;
+	size_t offset;
+	size_t remaining;
+
+	/* Construct data sink */
+	memset ( sink, 0, sizeof ( *sink ) );
+	intf_init ( &sink->xfer, &inflate_test_desc, NULL );
+	intf_init ( &sink->source, &null_intf_desc, NULL );
+	xferbuf_malloc_init ( &sink->buffer );
+	intf_plug_plug ( &sink->xfer, &sink->source );
+
+	/* Add decompression filter */
+	okx ( add_inflate ( &sink->xfer ) == 0, file, line );
+
+	/* Deliver compressed data in fragments */
+	for ( offset = 0 ; offset < len ; offset += remaining ) {
+		remaining = ( len - offset );
+		if ( remaining > frag_len )
+			remaining = frag_len;
+		xfer_deliver_raw ( &sink->source, ( data + offset ),
+				   remaining );
+	}
+
+	/* Close data source */
+	intf_shutdown ( &sink->source, 0 );
+	okx ( sink->closed, file, line );
+}
+
+/**
+ * Report inflate test result
+ *
+ * @v test		Inflate test
+ * @v frag_len		Maximum length of each delivered fragment
+ * @v file		Test code file
+ * @v line		Test code line
+ */
+static void inflate_okx ( struct inflate_test *test, size_t frag_len,
+			  const char *file, unsigned int line ) {
+	struct inflate_test_sink sink;
+
+	/* Decompress data */
+	inflate_test_run ( test, test->compressed_len, frag_len, &sink,
+			   file, line );
+	okx ( sink.rc == 0, file, line );
+
+	/* Verify decompressed data */
+	okx ( sink.buffer.len == test->expected_len, file, line );
+	okx ( memcmp ( sink.buffer.data, test->expected,
+		       test->expected_len ) == 0, file, line );
+
+	/* Free buffer */
+	xferbuf_free ( &sink.buffer );
+}
+#define inflate_ok( test, frag_len ) \
+	inflate_okx ( test, frag_len, __FILE__, __LINE__ )
+
+/**
+ * Report inflate failure test result
+ *
+ * @v test		Inflate test
+ * @v len		Length of compressed data to deliver
+ * @v file		Test code file
+ * @v line		Test code line
+ */
+static void inflate_fail_okx ( struct inflate_test *test, size_t len,
+			       const char *file, unsigned int line ) {
+	struct inflate_test_sink sink;
+
+	/* Check that decompression fails */
+	inflate_test_run ( test, len, len, &sink, file, line );
+	okx ( sink.rc != 0, file, line );
+
+	/* Free buffer */
+	xferbuf_free ( &sink.buffer );
+}
+#define inflate_fail_ok( test, len ) \
+	inflate_fail_okx ( test, len, __FILE__, __LINE__ )
+
+/**
+ * Perform inflate self-test
+ *
+ */
+static void inflate_test_exec ( void ) {
+	unsigned int run;
+	unsigned int i;
+	size_t offset;
+
+	/* Construct generated test data */
+	offset = 0;
+	for ( run = 0 ; run < INFLATE_TEST_RUNS ; run++ ) {
+		for ( i = 0 ; i < ( ( run % 5 ) + 1 ) ; i++ )
+			runs_expected[offset++] = ( 'A' + ( run % 26 ) );
+	}
+	assert ( offset == sizeof ( runs_expected ) );
+
+	/* Check single and fragmented delivery */
+	inflate_ok ( &hello_gzip, -1UL );
+	inflate_ok ( &hello_gzip, 1 );
+	inflate_ok ( &hello_headers, -1UL );
+	inflate_ok ( &hello_headers, 1 );
+	inflate_ok ( &hello_zlib, -1UL );
+	inflate_ok ( &hello_zlib, 1 );
+	inflate_ok ( &runs, -1UL );
+	inflate_ok ( &runs, 7 );
+
+	/* Check failure cases */
+	inflate_fail_ok ( &hello_corrupt, hello_corrupt.compressed_len );
+	inflate_fail_ok ( &hello_gzip, ( hello_gzip.compressed_len - 1 ) );
+	inflate_fail_ok ( &hello_gzip, 5 );
+	inflate_fail_ok ( &hello_zlib, ( hello_zlib.compressed_len - 1 ) );
+	inflate_fail_ok ( &not_compressed, not_compressed.compressed_len );
+}
+
+/** Inflate self-test */
+struct self_test inflate_test __self_test = {
+	.name = "inflate",
+	.exec = inflate_test_exec,
+};
+
+/* Drag in decompression filter */
+REQUIRING_SYMBOL ( inflate_test );
+REQUIRE_OBJECT ( inflate );
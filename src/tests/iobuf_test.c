@@ -105,6 +105,130 @@ static inline void alloc_iob_fail_okx ( size_t len, size_t align, size_t offset,
 #define alloc_iob_fail_ok( len, align, offset ) \
 	alloc_iob_fail_okx ( len, align, offset, __FILE__, __LINE__ )
 
+/**
+ * Report receive I/O buffer recycling test result
+ *
+ * @v len		Required length of buffer
+ * @v file		Test code file
+ * @v line		Test code line
+ */
+static void alloc_rx_iob_okx ( size_t len, const char *file,
+			       unsigned int line ) {
+	static struct dma_device dma;
+	struct io_buffer *iobuf;
+	struct io_buffer *reused;
+	struct io_buffer *other;
+
+	/* Allocate receive I/O buffer and consume it */
+	iobuf = alloc_rx_iob ( len, &dma );
+	okx ( iobuf != NULL, file, line );
+	okx ( iob_tailroom ( iobuf ) >= len, file, line );
+	memset ( iob_put ( iobuf, len ), 0xaa, len );
+	iob_pull ( iobuf, ( len / 2 ) );
+
+	/* Check that a freed buffer is reused */
+	free_rx_iob ( iobuf );
+	reused = alloc_rx_iob ( len, &dma );
+	okx ( reused == iobuf, file, line );
+	okx ( iob_len ( reused ) == 0, file, line );
+	okx ( iob_headroom ( reused ) == 0, file, line );
+	okx ( iob_tailroom ( reused ) >= len, file, line );
+
+	/* Check that a buffer of a different length is not reused */
+	free_rx_iob ( reused );
+	other = alloc_rx_iob ( ( len + 1 ), &dma );
+	okx ( other != NULL, file, line );
+	okx ( other != iobuf, file, line );
+	okx ( iob_tailroom ( other ) >= ( len + 1 ), file, line );
+
+	/* Check that a stack-freed (unmapped) buffer is also reused */
+	iob_unmap ( other );
+	free_iob ( other );
+	reused = alloc_rx_iob ( ( len + 1 ), &dma );
+	okx ( reused == other, file, line );
+	free_rx_iob ( reused );
+
+	/* Check that buffers allocated via alloc_iob() are not reused */
+	other = alloc_iob ( len );
+	okx ( other != NULL, file, line );
+	okx ( other->rx_len == 0, file, line );
+	free_iob ( other );
+}
+#define alloc_rx_iob_ok( len ) alloc_rx_iob_okx ( len, __FILE__, __LINE__ )
+
+/**
+ * Report chained I/O buffer linearisation test result
+ *
+ * @v head_len		Length of data in head I/O buffer
+ * @v tailroom		Minimum tailroom in head I/O buffer
+ * @v frag_len		Length of each fragment
+ * @v count		Number of fragments
+ * @v in_place		Head I/O buffer is expected to be reused
+ * @v file		Test code file
+ * @v line		Test code line
+ */
+static void iob_linearise_okx ( size_t head_len, size_t tailroom,
+				size_t frag_len, unsigned int count,
+				int in_place, const char *file,
+				unsigned int line ) {
+	static const size_t headroom = 16;
+	size_t len = ( head_len + ( count * frag_len ) );
+	struct io_buffer *iobuf;
+	struct io_buffer *frag;
+	struct io_buffer *linear;
+	uint8_t *data;
+	size_t offset;
+	unsigned int i;
+
+	/* Construct head I/O buffer */
+	iobuf = alloc_iob ( headroom + head_len + tailroom );
+	okx ( iobuf != NULL, file, line );
+	if ( ! iobuf )
+		return;
+	iob_reserve ( iobuf, headroom );
+	data = iob_put ( iobuf, head_len );
+	for ( offset = 0 ; offset < head_len ; offset++ )
+		data[offset] = offset;
+
+	/* Construct and append fragments */
+	for ( i = 0 ; i < count ; i++ ) {
+		frag = alloc_iob ( frag_len );
+		okx ( frag != NULL, file, line );
+		if ( ! frag )
+			break;
+		data = iob_put ( frag, frag_len );
+		for ( ; offset < ( head_len + ( ( i + 1 ) * frag_len ) ) ;
+		      offset++ ) {
+			*(data++) = offset;
+		}
+		iob_chain ( iobuf, frag );
+	}
+	okx ( iob_count ( iobuf ) == ( 1 + count ), file, line );
+	okx ( iob_total_len ( iobuf ) == len, file, line );
+
+	/* Linearise I/O buffer */
+	linear = iob_linearise ( iobuf );
+	okx ( linear != NULL, file, line );
+	if ( ! linear ) {
+		free_iob ( iobuf );
+		return;
+	}
+	okx ( ( linear == iobuf ) == in_place, file, line );
+	okx ( linear->frag == NULL, file, line );
+	okx ( iob_headroom ( linear ) == headroom, file, line );
+	okx ( iob_len ( linear ) == len, file, line );
+	data = linear->data;
+	for ( offset = 0 ; offset < len ; offset++ ) {
+		if ( data[offset] != ( offset & 0xff ) )
+			break;
+	}
+	okx ( offset == len, file, line );
+	free_iob ( linear );
+}
+#define iob_linearise_ok( head_len, tailroom, frag_len, count, in_place ) \
+	iob_linearise_okx ( head_len, tailroom, frag_len, count, in_place, \
+			    __FILE__, __LINE__ )
+
 /**
  * Perform I/O buffer self-tests
  *
@@ -133,6 +257,17 @@ static void iobuf_test_exec ( void ) {
 	alloc_iob_fail_ok ( -1UL, 1024, 0 );
 	alloc_iob_fail_ok ( 0, -1UL, 0 );
 	alloc_iob_fail_ok ( 1024, -1UL, 0 );
+
+	/* Check receive I/O buffer recycling */
+	alloc_rx_iob_ok ( 64 );
+	alloc_rx_iob_ok ( 1536 );
+	alloc_rx_iob_ok ( 2048 );
+
+	/* Check chained I/O buffer linearisation */
+	iob_linearise_ok ( 54, 0, 0, 0, 1 );
+	iob_linearise_ok ( 54, 4096, 1024, 3, 1 );
+	iob_linearise_ok ( 54, 0, 1024, 3, 0 );
+	iob_linearise_ok ( 0, 0, 1460, 8, 0 );
 }
 
 /** I/O buffer self-test */
@@ -118,6 +118,52 @@ __attribute__ (( noinline )) void * memcpy_var ( void *dest, const void *src,
 			      ( sizeof ( dest_var ) - 2 ) ) == 0 );	\
 	} while ( 0 )
 
+/**
+ * Perform a variable-length memcpy(), memmove() and memset() test
+ *
+ * @v len		Length of data to copy
+ * @v file		Test code file
+ * @v line		Test code line
+ */
+static void memcpy_var_okx ( size_t len, const char *file,
+			     unsigned int line ) {
+	uint8_t src[ len ];
+	uint8_t dest[ 1 + len + 1 ];
+	uint8_t buf[ len + 7 ];
+	unsigned int shift;
+	unsigned int i;
+
+	/* Generate source data */
+	for ( i = 0 ; i < len ; i++ )
+		src[i] = random();
+
+	/* Check copy does not overrun destination */
+	dest[0] = 0x77;
+	dest[ sizeof ( dest ) - 1 ] = 0x88;
+	memcpy_var ( ( dest + 1 ), src, len );
+	okx ( dest[0] == 0x77, file, line );
+	okx ( dest[ sizeof ( dest ) - 1 ] == 0x88, file, line );
+	okx ( memcmp ( ( dest + 1 ), src, len ) == 0, file, line );
+
+	/* Check overlapping forward and backward moves */
+	for ( shift = 1 ; shift < 8 ; shift++ ) {
+		memset ( buf, 0, sizeof ( buf ) );
+		memcpy ( ( buf + shift ), src, len );
+		memmove ( buf, ( buf + shift ), len );
+		okx ( memcmp ( buf, src, len ) == 0, file, line );
+		memmove ( ( buf + shift ), buf, len );
+		okx ( memcmp ( ( buf + shift ), src, len ) == 0, file, line );
+	}
+
+	/* Check fill does not overrun destination */
+	memset ( ( dest + 1 ), 0xa5, len );
+	okx ( dest[0] == 0x77, file, line );
+	okx ( dest[ sizeof ( dest ) - 1 ] == 0x88, file, line );
+	for ( i = 0 ; ( i < len ) && ( dest[ 1 + i ] == 0xa5 ) ; i++ ) {}
+	okx ( i == len, file, line );
+}
+#define memcpy_var_ok( len ) memcpy_var_okx ( len, __FILE__, __LINE__ )
+
 /**
  * Test memcpy() speed
  *
@@ -171,6 +217,7 @@ static void memcpy_test_speed ( unsigned int dest_offset,
 static void memcpy_test_exec ( void ) {
 	unsigned int dest_offset;
 	unsigned int src_offset;
+	size_t len;
 
 	/* Constant-length tests */
 	MEMCPY_TEST_CONSTANT ( );
@@ -255,15 +302,29 @@ static void memcpy_test_exec ( void ) {
 			       0x10, 0xb9, 0x5d, 0x05, 0xad, 0x50, 0xed, 0x35,
 			       0x32, 0x9c, 0xe6, 0x3b, 0x73, 0xe0, 0x7d );
 
+	/* Variable-length tests */
+	for ( len = 0 ; len <= 160 ; len++ )
+		memcpy_var_ok ( len );
+	memcpy_var_ok ( 1000 );
+	memcpy_var_ok ( 4093 );
+
 	/* Speed tests */
-	memcpy_test_speed ( 0, 0, 64 );
-	memcpy_test_speed ( 0, 0, 128 );
+	for ( len = 1 ; len <= 128 ; len <<= 1 )
+		memcpy_test_speed ( 0, 0, len );
+	memcpy_test_speed ( 0, 0, 14 );
+	memcpy_test_speed ( 0, 0, 20 );
+	memcpy_test_speed ( 0, 0, 40 );
+	memcpy_test_speed ( 0, 0, 54 );
 	memcpy_test_speed ( 0, 0, 256 );
+	memcpy_test_speed ( 0, 0, 1514 );
 	for ( dest_offset = 0 ; dest_offset < 4 ; dest_offset++ ) {
 		for ( src_offset = 0 ; src_offset < 4 ; src_offset++ ) {
 			memcpy_test_speed ( dest_offset, src_offset, 4096 );
 		}
 	}
+	memcpy_test_speed ( 0, 0, 65536 );
+	memcpy_test_speed ( 0, 8, 65536 );
+	memcpy_test_speed ( 0, 0, 1048576 );
 }
 
 /** memcpy() self-test */
@@ -72,6 +72,12 @@ static void testnet_close ( struct net_device *netdev __unused ) {
  */
 static int testnet_transmit ( struct net_device *netdev,
 			      struct io_buffer *iobuf ) {
+	struct testnet *testnet =
+		container_of ( netdev->dev, struct testnet, dev );
+
+	/* Pass packet to handler, if any */
+	if ( testnet->transmit )
+		testnet->transmit ( testnet, iobuf );
 
 	/* Complete immediately */
 	netdev_tx_complete ( netdev, iobuf );
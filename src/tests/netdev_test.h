@@ -32,6 +32,13 @@ struct testnet {
 	struct testnet_setting *testset;
 	/** Number of initial settings */
 	unsigned int count;
+	/** Transmitted packet handler (if any)
+	 *
+	 * @v testnet		Test network device
+	 * @v iobuf		I/O buffer
+	 */
+	void ( * transmit ) ( struct testnet *testnet,
+			      struct io_buffer *iobuf );
 };
 
 /**
@@ -0,0 +1,472 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+/** @file
+ *
+ * Packet capture replay benchmarks
+ *
+ * These benchmarks measure the cost of receiving an HTTP download
+ * through the complete network stack by replaying a packet capture
+ * via a replay network device.  The capture is synthesised at run
+ * time (using deliberately different TCP ports and initial sequence
+ * numbers from those that the live network stack will choose), so
+ * that no capture file is required and results are reproducible.
+ *
+ * Unlike the TCP throughput benchmarks, replayed packets do not
+ * claim to have had their checksums verified by the hardware, and so
+ * the cost of checksum verification is included in the results.
+ */
+
+/* Forcibly enable profiling */
+#undef NDEBUG
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <byteswap.h>
+#include <ipxe/device.h>
+#include <ipxe/netdevice.h>
+#include <ipxe/ethernet.h>
+#include <ipxe/if_ether.h>
+#include <ipxe/ip.h>
+#include <ipxe/tcp.h>
+#include <ipxe/tcpip.h>
+#include <ipxe/neighbour.h>
+#include <ipxe/settings.h>
+#include <ipxe/in.h>
+#include <ipxe/open.h>
+#include <ipxe/xfer.h>
+#include <ipxe/interface.h>
+#include <ipxe/process.h>
+#include <ipxe/timer.h>
+#include <ipxe/umalloc.h>
+#include <ipxe/profile.h>
+#include <ipxe/pcap.h>
+#include <ipxe/pcapreplay.h>
+#include <ipxe/bench.h>
+
+/** Amount of payload data in the synthesised capture */
+#define PCAP_BENCH_LEN ( 32 * 1024 * 1024 )
+
+/** Maximum time allowed for each benchmark */
+#define PCAP_BENCH_TIMEOUT ( 60 * TICKS_PER_SEC )
+
+/** Recorded server maximum segment size */
+#define PCAP_BENCH_MSS 1460
+
+/** Number of data segments acknowledged by each recorded client ACK */
+#define PCAP_BENCH_ACK_EVERY 2
+
+/** Number of non-data frames in the synthesised capture */
+#define PCAP_BENCH_CONTROL_FRAMES 8
+
+/** Recorded client initial sequence number */
+#define PCAP_BENCH_CLIENT_ISS 0x20000000UL
+
+/** Recorded server initial sequence number */
+#define PCAP_BENCH_SERVER_ISS 0x30000000UL
+
+/** Recorded client TCP port */
+#define PCAP_BENCH_CLIENT_PORT 49152
+
+/** Recorded server TCP port */
+#define PCAP_BENCH_SERVER_PORT 80
+
+/** Recorded client IPv4 address */
+#define PCAP_BENCH_CLIENT_IP "192.168.0.1"
+
+/** Recorded server IPv4 address */
+#define PCAP_BENCH_SERVER_IP "192.168.0.2"
+
+/** Recorded client MAC address */
+static const uint8_t pcap_bench_client_mac[ETH_ALEN] =
+	{ 0x52, 0x54, 0x00, 0x00, 0x00, 0x01 };
+
+/** Recorded server MAC address */
+static const uint8_t pcap_bench_server_mac[ETH_ALEN] =
+	{ 0x52, 0x54, 0x00, 0x00, 0x00, 0x02 };
+
+/** Recorded HTTP request */
+static const char pcap_bench_request[] =
+	"GET /bench HTTP/1.1\r\nHost: " PCAP_BENCH_SERVER_IP "\r\n\r\n";
+
+/** A synthesised packet capture */
+struct pcap_bench_capture {
+	/** Capture data */
+	void *data;
+	/** Length of capture data */
+	size_t len;
+	/** Client IPv4 address */
+	struct in_addr client;
+	/** Server IPv4 address */
+	struct in_addr server;
+	/** Response header */
+	const char *header;
+	/** Length of response header */
+	size_t header_len;
+};
+
+/** A benchmark data sink */
+struct pcap_bench_sink {
+	/** Data transfer interface */
+	struct interface xfer;
+	/** Amount of data received */
+	size_t len;
+	/** Transfer is complete */
+	int done;
+	/** Final status code */
+	int rc;
+};
+
+/** Dummy physical device */
+static struct device pcap_bench_dev = {
+	.name = "pcapbench",
+	.driver_name = "pcapbench",
+	.siblings = LIST_HEAD_INIT ( pcap_bench_dev.siblings ),
+	.children = LIST_HEAD_INIT ( pcap_bench_dev.children ),
+};
+
+/** Benchmark step profiler */
+static struct profiler pcap_bench_step_profiler __profiler =
+	{ .name = "pcapbench.step" };
+
+/**
+ * Append TCP segment to synthesised capture
+ *
+ * @v capture		Synthesised capture
+ * @v from_client	Segment is sent by the client
+ * @v flags		TCP flags
+ * @v seq		Sequence number
+ * @v ack		Acknowledgement number
+ * @v data		Payload, or NULL for an all-zero payload
+ * @v len		Length of payload
+ */
+static void pcap_bench_append ( struct pcap_bench_capture *capture,
+				int from_client, unsigned int flags,
+				uint32_t seq, uint32_t ack, const void *data,
+				size_t len ) {
+	struct pcap_record_header *rec;
+	struct ipv4_pseudo_header pshdr;
+	struct ethhdr *ethhdr;
+	struct iphdr *iphdr;
+	struct tcp_header *tcphdr;
+	size_t frame_len;
+	uint16_t csum;
+
+	/* Construct record header */
+	rec = ( capture->data + capture->len );
+	frame_len = ( sizeof ( *ethhdr ) + sizeof ( *iphdr ) +
+		      sizeof ( *tcphdr ) + len );
+	memset ( rec, 0, sizeof ( *rec ) );
+	rec->incl_len = frame_len;
+	rec->orig_len = frame_len;
+	capture->len += ( sizeof ( *rec ) + frame_len );
+
+	/* Construct Ethernet header */
+	ethhdr = ( ( void * ) ( rec + 1 ) );
+	memcpy ( ethhdr->h_dest, ( from_client ? pcap_bench_server_mac :
+				   pcap_bench_client_mac ), ETH_ALEN );
+	memcpy ( ethhdr->h_source, ( from_client ? pcap_bench_client_mac :
+				     pcap_bench_server_mac ), ETH_ALEN );
+	ethhdr->h_protocol = htons ( ETH_P_IP );
+
+	/* Construct IPv4 header */
+	iphdr = ( ( void * ) ( ethhdr + 1 ) );
+	memset ( iphdr, 0, sizeof ( *iphdr ) );
+	iphdr->verhdrlen = ( IP_VER | ( sizeof ( *iphdr ) / 4 ) );
+	iphdr->len = htons ( sizeof ( *iphdr ) + sizeof ( *tcphdr ) + len );
+	iphdr->ttl = IP_TTL;
+	iphdr->protocol = IP_TCP;
+	iphdr->src = ( from_client ? capture->client : capture->server );
+	iphdr->dest = ( from_client ? capture->server : capture->client );
+	iphdr->chksum = tcpip_chksum ( iphdr, sizeof ( *iphdr ) );
+
+	/* Construct TCP header and payload */
+	tcphdr = ( ( void * ) ( iphdr + 1 ) );
+	memset ( tcphdr, 0, sizeof ( *tcphdr ) );
+	tcphdr->src = htons ( from_client ? PCAP_BENCH_CLIENT_PORT :
+			      PCAP_BENCH_SERVER_PORT );
+	tcphdr->dest = htons ( from_client ? PCAP_BENCH_SERVER_PORT :
+			       PCAP_BENCH_CLIENT_PORT );
+	tcphdr->seq = htonl ( seq );
+	tcphdr->ack = htonl ( ack );
+	tcphdr->hlen = ( ( sizeof ( *tcphdr ) / 4 ) << 4 );
+	tcphdr->flags = flags;
+	tcphdr->win = htons ( 0xffff );
+	if ( data ) {
+		memcpy ( ( tcphdr + 1 ), data, len );
+	} else {
+		memset ( ( tcphdr + 1 ), 0, len );
+	}
+
+	/* Calculate TCP checksum */
+	pshdr.src = iphdr->src;
+	pshdr.dest = iphdr->dest;
+	pshdr.zero_padding = 0;
+	pshdr.protocol = IP_TCP;
+	pshdr.len = htons ( sizeof ( *tcphdr ) + len );
+	csum = tcpip_chksum ( tcphdr, ( sizeof ( *tcphdr ) + len ) );
+	tcphdr->csum = tcpip_continue_chksum ( csum, &pshdr,
+					       sizeof ( pshdr ) );
+}
+
+/**
+ * Synthesise packet capture of an HTTP download
+ *
+ * @v capture		Synthesised capture to fill in
+ * @ret rc		Return status code
+ */
+static int pcap_bench_synthesise ( struct pcap_bench_capture *capture ) {
+	struct pcap_file_header *hdr;
+	uint32_t cseq = ( PCAP_BENCH_CLIENT_ISS + 1 );
+	uint32_t sseq = ( PCAP_BENCH_SERVER_ISS + 1 );
+	size_t request_len = ( sizeof ( pcap_bench_request ) - 1 /* NUL */ );
+	size_t total = ( capture->header_len + PCAP_BENCH_LEN );
+	size_t segments;
+	size_t frame_len;
+	size_t max_len;
+	size_t offset;
+	size_t len;
+	unsigned int i;
+
+	/* Allocate capture buffer */
+	segments = ( ( total + PCAP_BENCH_MSS - 1 ) / PCAP_BENCH_MSS );
+	frame_len = ( sizeof ( struct pcap_record_header ) +
+		      sizeof ( struct ethhdr ) + sizeof ( struct iphdr ) +
+		      sizeof ( struct tcp_header ) + PCAP_BENCH_MSS );
+	max_len = ( sizeof ( *hdr ) +
+		    ( ( segments + ( segments / PCAP_BENCH_ACK_EVERY ) +
+			PCAP_BENCH_CONTROL_FRAMES ) * frame_len ) );
+	capture->data = umalloc ( max_len );
+	if ( ! capture->data )
+		return -ENOMEM;
+
+	/* Construct file header */
+	hdr = capture->data;
+	memset ( hdr, 0, sizeof ( *hdr ) );
+	hdr->magic = PCAP_MAGIC;
+	hdr->major = PCAP_VERSION_MAJOR;
+	hdr->minor = PCAP_VERSION_MINOR;
+	hdr->snaplen = ETH_FRAME_LEN;
+	hdr->linktype = PCAP_LINKTYPE_ETHERNET;
+	capture->len = sizeof ( *hdr );
+
+	/* Construct connection setup and request */
+	pcap_bench_append ( capture, 1, TCP_SYN, ( cseq - 1 ), 0, NULL, 0 );
+	pcap_bench_append ( capture, 0, ( TCP_SYN | TCP_ACK ), ( sseq - 1 ),
+			    cseq, NULL, 0 );
+	pcap_bench_append ( capture, 1, TCP_ACK, cseq, sseq, NULL, 0 );
+	pcap_bench_append ( capture, 1, ( TCP_PSH | TCP_ACK ), cseq, sseq,
+			    pcap_bench_request, request_len );
+	cseq += request_len;
+
+	/* Construct response, acknowledging every few segments */
+	for ( offset = 0, i = 0 ; offset < total ; offset += len, i++ ) {
+		len = ( total - offset );
+		if ( len > PCAP_BENCH_MSS )
+			len = PCAP_BENCH_MSS;
+		pcap_bench_append ( capture, 0, TCP_ACK, ( sseq + offset ),
+				    cseq, ( ( offset < capture->header_len ) ?
+					    capture->header : NULL ), len );
+		if ( ( i % PCAP_BENCH_ACK_EVERY ) ==
+		     ( PCAP_BENCH_ACK_EVERY - 1 ) ) {
+			pcap_bench_append ( capture, 1, TCP_ACK, cseq,
+					    ( sseq + offset + len ), NULL, 0 );
+		}
+	}
+	sseq += total;
+
+	/* Construct connection teardown */
+	pcap_bench_append ( capture, 0, ( TCP_FIN | TCP_ACK ), sseq, cseq,
+			    NULL, 0 );
+	sseq++;
+	pcap_bench_append ( capture, 1, ( TCP_FIN | TCP_ACK ), cseq, sseq,
+			    NULL, 0 );
+	cseq++;
+	pcap_bench_append ( capture, 0, TCP_ACK, sseq, cseq, NULL, 0 );
+
+	return 0;
+}
+
+/**
+ * Receive data
+ *
+ * @v sink		Benchmark data sink
+ * @v iobuf		I/O buffer
+ * @v meta		Data transfer metadata
+ * @ret rc		Return status code
+ */
+static int pcap_bench_deliver ( struct pcap_bench_sink *sink,
+				struct io_buffer *iobuf,
+				struct xfer_metadata *meta __unused ) {
+
+	/* Discard data */
+	sink->len += iob_len ( iobuf );
+	free_iob ( iobuf );
+	return 0;
+}
+
+/**
+ * Close data sink
+ *
+ * @v sink		Benchmark data sink
+ * @v rc		Reason for close
+ */
+static void pcap_bench_sink_close ( struct pcap_bench_sink *sink, int rc ) {
+
+	sink->rc = rc;
+	sink->done = 1;
+	intf_restart ( &sink->xfer, rc );
+}
+
+/** Benchmark data sink interface operations */
+static struct interface_operation pcap_bench_sink_operations[] = {
+	INTF_OP ( xfer_deliver, struct pcap_bench_sink *, pcap_bench_deliver ),
+	INTF_OP ( intf_close, struct pcap_bench_sink *, pcap_bench_sink_close ),
+};
+
+/** Benchmark data sink interface descriptor */
+static struct interface_descriptor pcap_bench_sink_desc =
+	INTF_DESC ( struct pcap_bench_sink, xfer, pcap_bench_sink_operations );
+
+/**
+ * Run HTTP download replay benchmark
+ *
+ * @ret rc		Return status code
+ */
+static int pcap_bench_exec ( void ) {
+	struct profiler *profiler = &pcap_bench_step_profiler;
+	struct pcap_bench_capture capture;
+	struct pcap_bench_sink sink;
+	struct pcap_replay *replay;
+	struct net_device *netdev;
+	struct in_addr netmask;
+	unsigned long long cycles = 0;
+	unsigned long start;
+	unsigned long elapsed;
+	char header[128];
+	char uri[32 /* "http://xxx.xxx.xxx.xxx/bench" */ + 1];
+	int rc;
+
+	/* Synthesise capture */
+	memset ( &capture, 0, sizeof ( capture ) );
+	inet_aton ( PCAP_BENCH_CLIENT_IP, &capture.client );
+	inet_aton ( PCAP_BENCH_SERVER_IP, &capture.server );
+	snprintf ( header, sizeof ( header ), "HTTP/1.1 200 OK\r\n"
+		   "Content-Length: %d\r\nConnection: close\r\n\r\n",
+		   PCAP_BENCH_LEN );
+	capture.header = header;
+	capture.header_len = strlen ( header );
+	if ( ( rc = pcap_bench_synthesise ( &capture ) ) != 0 )
+		goto err_synthesise;
+
+	/* Create replay network device */
+	netdev = alloc_pcap_replay ( capture.data, capture.len );
+	if ( ! netdev ) {
+		rc = -ENOMEM;
+		goto err_alloc;
+	}
+	netdev->dev = &pcap_bench_dev;
+	replay = netdev->priv;
+	if ( ( rc = register_netdev ( netdev ) ) != 0 )
+		goto err_register;
+	if ( ( rc = netdev_open ( netdev ) ) != 0 )
+		goto err_open;
+	netdev_link_up ( netdev );
+
+	/* Configure recorded client address and server neighbour entry */
+	netmask.s_addr = htonl ( 0xffffff00UL );
+	if ( ( rc = store_setting ( netdev_settings ( netdev ), &ip_setting,
+				    &capture.client,
+				    sizeof ( capture.client ) ) ) != 0 )
+		goto err_settings;
+	if ( ( rc = store_setting ( netdev_settings ( netdev ),
+				    &netmask_setting, &netmask,
+				    sizeof ( netmask ) ) ) != 0 )
+		goto err_settings;
+	if ( ( rc = neighbour_define ( netdev, &ipv4_protocol,
+				       &capture.server,
+				       pcap_bench_server_mac ) ) != 0 )
+		goto err_neighbour;
+
+	/* Open HTTP download */
+	memset ( &sink, 0, sizeof ( sink ) );
+	intf_init ( &sink.xfer, &pcap_bench_sink_desc, NULL );
+	snprintf ( uri, sizeof ( uri ), "http://%s/bench",
+		   inet_ntoa ( capture.server ) );
+	start = currticks();
+	if ( ( rc = xfer_open_uri_string ( &sink.xfer, uri ) ) != 0 )
+		goto err_xfer;
+
+	/* Run until download is complete and the capture is exhausted */
+	while ( ! ( sink.done && pcap_replay_finished ( replay ) &&
+		    list_empty ( &netdev->rx_queue ) ) ) {
+		profile_start ( profiler );
+		step();
+		profile_stop ( profiler );
+		cycles += profile_elapsed ( profiler );
+		if ( ( currticks() - start ) > PCAP_BENCH_TIMEOUT ) {
+			rc = -ETIMEDOUT;
+			goto err_timeout;
+		}
+	}
+	elapsed = ( currticks() - start );
+
+	/* Check result */
+	if ( ( rc = sink.rc ) != 0 )
+		goto err_transfer;
+	if ( sink.len != PCAP_BENCH_LEN ) {
+		rc = -EIO;
+		goto err_len;
+	}
+
+	/* Report result */
+	bench_report ( "pcap-http", sink.len, replay->packets, elapsed,
+		       cycles );
+
+ err_len:
+ err_transfer:
+ err_timeout:
+ err_xfer:
+	intf_shutdown ( &sink.xfer, rc );
+ err_neighbour:
+ err_settings:
+ err_open:
+	unregister_netdev ( netdev );
+ err_register:
+	netdev_nullify ( netdev );
+	netdev_put ( netdev );
+ err_alloc:
+	ufree ( capture.data );
+ err_synthesise:
+	return rc;
+}
+
+/** HTTP download replay benchmark */
+struct benchmark pcap_bench __benchmark = {
+	.name = "pcap-http",
+	.exec = pcap_bench_exec,
+};
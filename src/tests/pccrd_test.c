@@ -0,0 +1,171 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+/** @file
+ *
+ * Peer Content Caching and Retrieval: Discovery Protocol [MS-PCCRD] tests
+ *
+ */
+
+/* Forcibly enable assertions */
+#undef NDEBUG
+
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <ipxe/pccrd.h>
+#include <ipxe/test.h>
+
+/** Message UUID used for tests */
+#define TEST_UUID "7a5a4ca6-6a8c-4a1f-9c1c-3c0fe0b6c8a1"
+
+/** Endpoint UUID used for tests */
+#define TEST_ENDPOINT "0e7b3d1c-2b9a-4c55-8d53-1d1bb4c6a7f2"
+
+/** First segment ID used for tests */
+#define TEST_ID_A \
+	"A7D2AE1A6F6E6C4A1F0BDBB44B2EEE6D0F38E7F0C6D7A4D27E6C1DC4E5A5D2A1"
+
+/** Second segment ID used for tests */
+#define TEST_ID_B \
+	"04DFA0ADB1A4F7EA5DA0C1C4E3F2B4D6D0F1A2B3C4D5E6F708192A3B4C5D6E7F"
+
+/** A probe for something other than PeerDist data */
+static const char pccrd_other_probe[] =
+	"<?xml version=\"1.0\" encoding=\"utf-8\"?>"
+	"<soap:Envelope "
+	    "xmlns:soap=\"http://www.w3.org/2003/05/soap-envelope\" "
+	    "xmlns:wsa=\"http://schemas.xmlsoap.org/ws/2004/08/addressing\" "
+	    "xmlns:wsd=\"http://schemas.xmlsoap.org/ws/2005/04/discovery\">"
+	  "<soap:Header>"
+	    "<wsa:MessageID>urn:uuid:" TEST_UUID "</wsa:MessageID>"
+	  "</soap:Header>"
+	  "<soap:Body>"
+	    "<wsd:Probe>"
+	      "<wsd:Types>wsdp:Device</wsd:Types>"
+	      "<wsd:Scopes></wsd:Scopes>"
+	    "</wsd:Probe>"
+	  "</soap:Body>"
+	"</soap:Envelope>";
+
+/**
+ * Report discovery probe parsing test result
+ *
+ * @v request		Discovery request
+ * @v ids		Expected segment ID list (space-separated)
+ * @v file		Test code file
+ * @v line		Test code line
+ */
+static void peerdist_discovery_probe_okx ( const char *request,
+					   const char *ids, const char *file,
+					   unsigned int line ) {
+	struct peerdist_discovery_probe probe;
+	size_t len = strlen ( request );
+	char data[ len + 1 /* NUL */ ];
+	const char *expected = ids;
+	char *id;
+	size_t id_len;
+
+	/* Parse probe (which modifies the data) */
+	memcpy ( data, request, sizeof ( data ) );
+	okx ( peerdist_discovery_probe ( data, len, &probe ) == 0,
+	      file, line );
+	okx ( strcmp ( probe.message, ( "urn:uuid:" TEST_UUID ) ) == 0,
+	      file, line );
+
+	/* Check segment ID list */
+	for ( id = probe.ids ; *id ; id += ( id_len + 1 /* NUL */ ) ) {
+		id_len = strlen ( id );
+		okx ( strncmp ( id, expected, id_len ) == 0, file, line );
+		expected += id_len;
+		if ( *expected == ' ' )
+			expected++;
+	}
+	okx ( *expected == '\0', file, line );
+}
+#define peerdist_discovery_probe_ok( request, ids )			\
+	peerdist_discovery_probe_okx ( request, ids, __FILE__, __LINE__ )
+
+/**
+ * Perform PeerDist discovery self-tests
+ *
+ */
+static void peerdist_discovery_test_exec ( void ) {
+	struct peerdist_discovery_probe probe;
+	struct peerdist_discovery_reply reply;
+	char data[ sizeof ( pccrd_other_probe ) ];
+	char *request;
+	char *match;
+	char *id;
+
+	/* Parse a single-segment probe */
+	request = peerdist_discovery_request ( TEST_UUID, TEST_ID_A );
+	ok ( request != NULL );
+	if ( request ) {
+		peerdist_discovery_probe_ok ( request, TEST_ID_A );
+		free ( request );
+	}
+
+	/* Parse a multiple-segment probe */
+	request = peerdist_discovery_request ( TEST_UUID,
+					       ( TEST_ID_A " " TEST_ID_B ) );
+	ok ( request != NULL );
+	if ( request ) {
+		peerdist_discovery_probe_ok ( request,
+					      ( TEST_ID_A " " TEST_ID_B ) );
+		free ( request );
+	}
+
+	/* Ignore probes for other types */
+	memcpy ( data, pccrd_other_probe, sizeof ( data ) );
+	ok ( peerdist_discovery_probe ( data, strlen ( data ),
+					&probe ) != 0 );
+
+	/* Construct a probe match and parse it as a discovery reply,
+	 * omitting the segment with a zero block count.
+	 */
+	match = peerdist_discovery_match ( TEST_UUID, ( "urn:uuid:" TEST_UUID ),
+					   TEST_ENDPOINT,
+					   ( TEST_ID_A " " TEST_ID_B ),
+					   "0000000400000000",
+					   "192.168.0.1:80" );
+	ok ( match != NULL );
+	if ( match ) {
+		ok ( peerdist_discovery_reply ( match, strlen ( match ),
+						&reply ) == 0 );
+		id = reply.ids;
+		ok ( strcmp ( id, TEST_ID_A ) == 0 );
+		id += ( strlen ( id ) + 1 /* NUL */ );
+		ok ( *id == '\0' );
+		ok ( strcmp ( reply.locations, "192.168.0.1:80" ) == 0 );
+		free ( match );
+	}
+}
+
+/** PeerDist discovery self-test */
+struct self_test peerdist_discovery_test __self_test = {
+	.name = "pccrd",
+	.exec = peerdist_discovery_test_exec,
+};
@@ -0,0 +1,234 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+/** @file
+ *
+ * Poly1305 tests
+ *
+ * These test vectors are taken from RFC 8439.
+ *
+ */
+
+/* Forcibly enable assertions */
+#undef NDEBUG
+
+#include <string.h>
+#include <ipxe/poly1305.h>
+#include <ipxe/test.h>
+
+/** Define inline key */
+#define KEY(...) { __VA_ARGS__ }
+
+/** Define inline data */
+#define DATA(...) { __VA_ARGS__ }
+
+/** Define inline expected tag */
+#define EXPECTED(...) { __VA_ARGS__ }
+
+/** A Poly1305 test */
+struct poly1305_test {
+	/** Key */
+	const void *key;
+	/** Data */
+	const void *data;
+	/** Length of data */
+	size_t len;
+	/** Expected tag */
+	const void *expected;
+};
+
+/**
+ * Define a Poly1305 test
+ *
+ * @v name		Test name
+ * @v KEY		Key
+ * @v DATA		Data
+ * @v EXPECTED		Expected tag
+ * @ret test		Poly1305 test
+ */
+#define POLY1305_TEST( name, KEY, DATA, EXPECTED )			\
+	static const uint8_t name ## _key[POLY1305_KEY_LEN] = KEY;	\
+	static const uint8_t name ## _data[] = DATA;			\
+	static const uint8_t name ## _expected[POLY1305_TAG_LEN] =	\
+		EXPECTED;						\
+	static struct poly1305_test name = {				\
+		.key = name ## _key,					\
+		.data = name ## _data,					\
+		.len = sizeof ( name ## _data ),			\
+		.expected = name ## _expected,				\
+	}
+
+/**
+ * Report a Poly1305 test result
+ *
+ * @v test		Poly1305 test
+ * @v file		Test code file
+ * @v line		Test code line
+ */
+static void poly1305_okx ( struct poly1305_test *test, const char *file,
+			   unsigned int line ) {
+	struct poly1305_context poly;
+	uint8_t tag[POLY1305_TAG_LEN];
+	const uint8_t *data = test->data;
+	size_t offset;
+	size_t frag_len;
+	unsigned int step;
+
+	/* Calculate tag in a single update */
+	poly1305_init ( &poly, test->key );
+	poly1305_update ( &poly, test->data, test->len );
+	poly1305_final ( &poly, tag );
+	okx ( memcmp ( tag, test->expected, sizeof ( tag ) ) == 0,
+	      file, line );
+
+	/* Calculate tag using fragmented updates of various sizes */
+	for ( step = 1 ; step <= 17 ; step += 3 ) {
+		poly1305_init ( &poly, test->key );
+		for ( offset = 0 ; offset < test->len ; offset += frag_len ) {
+			frag_len = ( test->len - offset );
+			if ( frag_len > step )
+				frag_len = step;
+			poly1305_update ( &poly, &data[offset], frag_len );
+		}
+		poly1305_final ( &poly, tag );
+		okx ( memcmp ( tag, test->expected, sizeof ( tag ) ) == 0,
+		      file, line );
+	}
+}
+#define poly1305_ok( test ) poly1305_okx ( test, __FILE__, __LINE__ )
+
+/** CFRG (from RFC 8439 section 2.5.2) */
+POLY1305_TEST ( poly1305_cfrg,
+		KEY ( 0x85, 0xd6, 0xbe, 0x78, 0x57, 0x55, 0x6d, 0x33, 0x7f,
+		      0x44, 0x52, 0xfe, 0x42, 0xd5, 0x06, 0xa8, 0x01, 0x03,
+		      0x80, 0x8a, 0xfb, 0x0d, 0xb2, 0xfd, 0x4a, 0xbf, 0xf6,
+		      0xaf, 0x41, 0x49, 0xf5, 0x1b ),
+		DATA ( 0x43, 0x72, 0x79, 0x70, 0x74, 0x6f, 0x67, 0x72, 0x61,
+		       0x70, 0x68, 0x69, 0x63, 0x20, 0x46, 0x6f, 0x72, 0x75,
+		       0x6d, 0x20, 0x52, 0x65, 0x73, 0x65, 0x61, 0x72, 0x63,
+		       0x68, 0x20, 0x47, 0x72, 0x6f, 0x75, 0x70 ),
+		EXPECTED ( 0xa8, 0x06, 0x1d, 0xc1, 0x30, 0x51, 0x36, 0xc6,
+			   0xc2, 0x2b, 0x8b, 0xaf, 0x0c, 0x01, 0x27, 0xa9 ) );
+
+/** All-zero key and data (from RFC 8439 appendix A.3 #1) */
+POLY1305_TEST ( poly1305_zero,
+		KEY ( 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+		      0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+		      0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+		      0x00, 0x00, 0x00, 0x00, 0x00 ),
+		DATA ( 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+		       0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+		       0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+		       0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+		       0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+		       0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+		       0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+		       0x00 ),
+		EXPECTED ( 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+			   0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 ) );
+
+/** Accumulator wraps past 2^130-5 (from RFC 8439 appendix A.3 #5) */
+POLY1305_TEST ( poly1305_wrap_h,
+		KEY ( 0x02, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+		      0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+		      0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+		      0x00, 0x00, 0x00, 0x00, 0x00 ),
+		DATA ( 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+		       0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff ),
+		EXPECTED ( 0x03, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+			   0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 ) );
+
+/** Final addition wraps past 2^128 (from RFC 8439 appendix A.3 #6) */
+POLY1305_TEST ( poly1305_wrap_s,
+		KEY ( 0x02, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+		      0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0xff,
+		      0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+		      0xff, 0xff, 0xff, 0xff, 0xff ),
+		DATA ( 0x02, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+		       0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 ),
+		EXPECTED ( 0x03, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+			   0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 ) );
+
+/** Carry propagation (from RFC 8439 appendix A.3 #7) */
+POLY1305_TEST ( poly1305_carry,
+		KEY ( 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+		      0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+		      0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+		      0x00, 0x00, 0x00, 0x00, 0x00 ),
+		DATA ( 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+		       0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xf0, 0xff,
+		       0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+		       0xff, 0xff, 0xff, 0xff, 0xff, 0x11, 0x00, 0x00, 0x00,
+		       0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+		       0x00, 0x00, 0x00 ),
+		EXPECTED ( 0x05, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+			   0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 ) );
+
+/** Result equal to modulus (from RFC 8439 appendix A.3 #8) */
+POLY1305_TEST ( poly1305_mod,
+		KEY ( 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+		      0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+		      0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+		      0x00, 0x00, 0x00, 0x00, 0x00 ),
+		DATA ( 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+		       0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xfb, 0xfe,
+		       0xfe, 0xfe, 0xfe, 0xfe, 0xfe, 0xfe, 0xfe, 0xfe, 0xfe,
+		       0xfe, 0xfe, 0xfe, 0xfe, 0xfe, 0x01, 0x01, 0x01, 0x01,
+		       0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01,
+		       0x01, 0x01, 0x01 ),
+		EXPECTED ( 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+			   0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 ) );
+
+/** Result just below modulus (from RFC 8439 appendix A.3 #9) */
+POLY1305_TEST ( poly1305_limb,
+		KEY ( 0x02, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+		      0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+		      0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+		      0x00, 0x00, 0x00, 0x00, 0x00 ),
+		DATA ( 0xfd, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+		       0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff ),
+		EXPECTED ( 0xfa, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+			   0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff ) );
+
+/**
+ * Perform Poly1305 self-tests
+ *
+ */
+static void poly1305_test_exec ( void ) {
+
+	poly1305_ok ( &poly1305_cfrg );
+	poly1305_ok ( &poly1305_zero );
+	poly1305_ok ( &poly1305_wrap_h );
+	poly1305_ok ( &poly1305_wrap_s );
+	poly1305_ok ( &poly1305_carry );
+	poly1305_ok ( &poly1305_mod );
+	poly1305_ok ( &poly1305_limb );
+}
+
+/** Poly1305 self-test */
+struct self_test poly1305_test __self_test = {
+	.name = "poly1305",
+	.exec = poly1305_test_exec,
+};
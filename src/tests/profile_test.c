@@ -47,13 +47,17 @@ struct profile_test {
 	unsigned long mean;
 	/** Expected standard deviation */
 	unsigned long stddev;
+	/** Expected 50th percentile (histogram bucket upper bound) */
+	unsigned long p50;
+	/** Expected 99th percentile (histogram bucket upper bound) */
+	unsigned long p99;
 };
 
 /** Define inline data */
 #define DATA(...) { __VA_ARGS__ }
 
 /** Define a profiling test */
-#define PROFILE_TEST( name, MEAN, STDDEV, SAMPLES )			\
+#define PROFILE_TEST( name, MEAN, STDDEV, P50, P99, SAMPLES )		\
 	static const unsigned long name ## _samples[] = SAMPLES;	\
 	static struct profile_test name = {				\
 		.samples = name ## _samples,				\
@@ -61,31 +65,34 @@ struct profile_test {
 			   sizeof ( name ## _samples [0] ) ),		\
 		.mean = MEAN,						\
 		.stddev = STDDEV,					\
+		.p50 = P50,						\
+		.p99 = P99,						\
 	}
 
 /** Empty data set */
-PROFILE_TEST ( empty, 0, 0, DATA() );
+PROFILE_TEST ( empty, 0, 0, 0, 0, DATA() );
 
 /** Single-element data set (zero) */
-PROFILE_TEST ( zero, 0, 0, DATA ( 0 ) );
+PROFILE_TEST ( zero, 0, 0, 0, 0, DATA ( 0 ) );
 
 /** Single-element data set (non-zero) */
-PROFILE_TEST ( single, 42, 0, DATA ( 42 ) );
+PROFILE_TEST ( single, 42, 0, 63, 63, DATA ( 42 ) );
 
 /** Multiple identical element data set */
-PROFILE_TEST ( identical, 69, 0, DATA ( 69, 69, 69, 69, 69, 69, 69 ) );
+PROFILE_TEST ( identical, 69, 0, 127, 127,
+	       DATA ( 69, 69, 69, 69, 69, 69, 69 ) );
 
 /** Small element data set */
-PROFILE_TEST ( small, 5, 2, DATA ( 3, 5, 9, 4, 3, 2, 5, 7 ) );
+PROFILE_TEST ( small, 5, 2, 7, 15, DATA ( 3, 5, 9, 4, 3, 2, 5, 7 ) );
 
 /** Random data set */
-PROFILE_TEST ( random, 70198, 394,
+PROFILE_TEST ( random, 70198, 394, 131071, 131071,
 	       DATA ( 69772, 70068, 70769, 69653, 70663, 71078, 70101, 70341,
 		      70215, 69600, 70020, 70456, 70421, 69972, 70267, 69999,
 		      69972 ) );
 
 /** Large-valued random data set */
-PROFILE_TEST ( large, 93533894UL, 25538UL,
+PROFILE_TEST ( large, 93533894UL, 25538UL, 134217727UL, 134217727UL,
 	       DATA ( 93510333UL, 93561169UL, 93492361UL, 93528647UL,
 		      93557566UL, 93503465UL, 93540126UL, 93549020UL,
 		      93502307UL, 93527320UL, 93537152UL, 93540125UL,
@@ -118,6 +125,8 @@ static void profile_okx ( struct profile_test *test, const char *file,
 	DBGC ( test, "PROFILE calculated mean %ld stddev %ld\n", mean, stddev );
 	okx ( mean == test->mean, file, line );
 	okx ( stddev == test->stddev, file, line );
+	okx ( profile_percentile ( &profiler, 50 ) == test->p50, file, line );
+	okx ( profile_percentile ( &profiler, 99 ) == test->p99, file, line );
 }
 #define profile_ok( test ) profile_okx ( test, __FILE__, __LINE__ )
 
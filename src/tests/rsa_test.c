@@ -34,6 +34,7 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 /* Forcibly enable assertions */
 #undef NDEBUG
 
+#include <stdlib.h>
 #include <string.h>
 #include <ipxe/crypto.h>
 #include <ipxe/rsa.h>
@@ -373,6 +374,182 @@ PUBKEY_SIGN_TEST ( sha256_test, &rsa_algorithm,
 		    0x7d, 0x38, 0x37, 0xc4, 0xea, 0xdd, 0x3a, 0x6f, 0xa8, 0x65,
 		    0x60, 0x73, 0x77, 0x3c ) );
 
+/** Random message SHA-256 RSA-PSS signature test */
+PUBKEY_SIGN_TEST ( sha256_pss_test, &rsa_pss_algorithm,
+	PRIVATE ( 0x30, 0x82, 0x02, 0x5d, 0x02, 0x01, 0x00, 0x02, 0x81, 0x81,
+		  0x00, 0xe9, 0x96, 0xdb, 0x67, 0xcf, 0x85, 0xfc, 0x86, 0xe8,
+		  0x06, 0x22, 0x6d, 0x7d, 0xdd, 0xac, 0x7d, 0xe0, 0x98, 0x4d,
+		  0x32, 0x79, 0xcd, 0x1f, 0x8e, 0x25, 0x58, 0xa1, 0xd8, 0x81,
+		  0xfe, 0x0b, 0x6c, 0xff, 0x67, 0x20, 0x68, 0x02, 0xee, 0xb7,
+		  0x1b, 0x5f, 0xc3, 0xd7, 0xe8, 0x70, 0x78, 0x77, 0x60, 0x7d,
+		  0x6e, 0x3e, 0xab, 0x8c, 0xbf, 0x0e, 0x50, 0x77, 0xb3, 0x60,
+		  0x7b, 0xb5, 0xbd, 0xca, 0xa0, 0x53, 0xd4, 0x9c, 0x2f, 0xb2,
+		  0xb4, 0xd6, 0xb8, 0x2f, 0x97, 0x5b, 0x7d, 0x02, 0xc5, 0x8c,
+		  0xb2, 0x4e, 0x0b, 0xdf, 0xbd, 0x7f, 0x79, 0x16, 0xb5, 0x52,
+		  0xe5, 0xda, 0xfd, 0xa6, 0x41, 0x58, 0xca, 0xbc, 0x89, 0xbd,
+		  0x2d, 0x93, 0x5a, 0x5c, 0xb2, 0x21, 0x79, 0x07, 0x4f, 0xd0,
+		  0xaa, 0xe1, 0x8f, 0x2e, 0x19, 0xb3, 0xdf, 0x92, 0xb6, 0x9e,
+		  0x3d, 0x58, 0x21, 0x70, 0x5f, 0x70, 0x77, 0x4c, 0x53, 0x02,
+		  0x03, 0x01, 0x00, 0x01, 0x02, 0x81, 0x80, 0x6c, 0x46, 0x3b,
+		  0x09, 0x51, 0x8e, 0x3f, 0xd1, 0xa0, 0xb7, 0x47, 0x3a, 0x0d,
+		  0x7f, 0xb5, 0x36, 0xdb, 0xe6, 0x7c, 0xd2, 0x0a, 0xd7, 0x63,
+		  0xeb, 0x15, 0xb0, 0x91, 0xc4, 0xb3, 0xec, 0xb8, 0x0b, 0x1c,
+		  0x10, 0x07, 0x5b, 0x6f, 0x10, 0x8b, 0xdb, 0xaa, 0x76, 0x33,
+		  0x1c, 0x51, 0x15, 0xe5, 0xef, 0xd9, 0xf4, 0x42, 0x24, 0x6e,
+		  0xa7, 0x18, 0xd1, 0x7f, 0xca, 0xab, 0xcc, 0x6c, 0x1f, 0xbf,
+		  0x4d, 0xd3, 0x0f, 0x34, 0x5d, 0x69, 0xa6, 0xef, 0xe3, 0x1e,
+		  0x25, 0x2b, 0xfe, 0x82, 0xb9, 0x85, 0xba, 0x66, 0x7a, 0x14,
+		  0xc3, 0x53, 0x32, 0x95, 0xff, 0xdc, 0x3c, 0x2e, 0x83, 0xc4,
+		  0x61, 0xb7, 0x3f, 0xab, 0x9f, 0xd5, 0x35, 0xee, 0x1b, 0x09,
+		  0x5c, 0x91, 0x51, 0xb0, 0xd1, 0x21, 0x26, 0x21, 0xec, 0x68,
+		  0x9e, 0x6a, 0xa7, 0xb1, 0xd9, 0xdf, 0xef, 0x64, 0xbb, 0x39,
+		  0x46, 0x9c, 0x08, 0xed, 0x41, 0x02, 0x41, 0x00, 0xf9, 0x51,
+		  0xe5, 0x6a, 0x02, 0x33, 0xfd, 0x1e, 0x80, 0x06, 0xe1, 0x9f,
+		  0x61, 0x6f, 0x07, 0x40, 0x49, 0x56, 0xd5, 0x2a, 0x75, 0xa8,
+		  0x90, 0x0c, 0x31, 0xe4, 0x12, 0x00, 0x55, 0xd0, 0x6c, 0x06,
+		  0x2b, 0x03, 0x9a, 0x7f, 0x3d, 0xa4, 0x45, 0x36, 0xec, 0x9b,
+		  0x41, 0x38, 0x2a, 0x10, 0x18, 0xef, 0xa5, 0x44, 0x29, 0x4e,
+		  0xc2, 0x99, 0x32, 0x26, 0x62, 0x22, 0xe0, 0x56, 0x28, 0x57,
+		  0x6b, 0x23, 0x02, 0x41, 0x00, 0xef, 0xd9, 0x10, 0x3a, 0xcb,
+		  0x03, 0x1e, 0xeb, 0xef, 0x3c, 0xcb, 0x12, 0x8b, 0xf3, 0x18,
+		  0x0b, 0x75, 0x4e, 0x85, 0xe2, 0xac, 0xdd, 0x23, 0xca, 0x20,
+		  0xaf, 0xb7, 0x17, 0x36, 0x34, 0x0c, 0xdd, 0x15, 0x87, 0xf2,
+		  0xde, 0x09, 0xca, 0x97, 0x4e, 0xc1, 0x87, 0xb6, 0xee, 0xf6,
+		  0xfd, 0x2f, 0xd9, 0xe9, 0xca, 0x3c, 0xf7, 0xaf, 0xf5, 0xe6,
+		  0x93, 0x79, 0x92, 0x1a, 0xea, 0xc8, 0x00, 0x85, 0x11, 0x02,
+		  0x41, 0x00, 0xba, 0x35, 0x0b, 0x45, 0xc0, 0x7d, 0x79, 0xb7,
+		  0xb4, 0xe0, 0xee, 0xd3, 0xed, 0x9e, 0x51, 0xe9, 0x16, 0x9d,
+		  0x4e, 0xb9, 0xd6, 0x84, 0x5d, 0x89, 0x6e, 0x1d, 0xab, 0xc0,
+		  0x2a, 0x57, 0x6e, 0xc6, 0xb0, 0x8b, 0x91, 0x71, 0x24, 0xe5,
+		  0xb2, 0x78, 0x12, 0x00, 0xe6, 0x95, 0xfe, 0xfc, 0x64, 0xd3,
+		  0x5f, 0x38, 0x68, 0x2d, 0x95, 0xb3, 0x7b, 0x3c, 0x25, 0xa1,
+		  0x6c, 0xb1, 0x8c, 0x91, 0xb5, 0xc7, 0x02, 0x41, 0x00, 0xa4,
+		  0xe8, 0x55, 0xa4, 0x56, 0xd8, 0xfa, 0x75, 0xb5, 0xb3, 0xd2,
+		  0xdc, 0x19, 0xa5, 0x36, 0xaf, 0x0a, 0x24, 0xc7, 0x21, 0x27,
+		  0x41, 0x94, 0xcd, 0xf0, 0xd3, 0x5f, 0xcb, 0x71, 0xd5, 0x2f,
+		  0xd3, 0x02, 0x6e, 0xca, 0xa9, 0xa7, 0x89, 0xc7, 0xa6, 0xba,
+		  0xa1, 0x99, 0x41, 0x8c, 0x48, 0x60, 0x92, 0x2f, 0x90, 0x81,
+		  0x82, 0xbb, 0x55, 0x13, 0x07, 0xea, 0xda, 0x6d, 0xef, 0x67,
+		  0x3c, 0x14, 0x41, 0x02, 0x40, 0x0e, 0x5b, 0xaf, 0x48, 0x7f,
+		  0x23, 0x38, 0xad, 0xe4, 0x00, 0xee, 0x95, 0x6a, 0xcc, 0x7a,
+		  0x9b, 0x6b, 0xff, 0x17, 0xcd, 0x82, 0x12, 0x83, 0x0a, 0x51,
+		  0x0f, 0xba, 0xa7, 0x3f, 0x71, 0xd6, 0x8c, 0x6c, 0x32, 0x48,
+		  0xab, 0xcd, 0x5a, 0x5c, 0x0f, 0xae, 0x89, 0x03, 0xa4, 0x03,
+		  0xde, 0x6d, 0xe9, 0x70, 0xff, 0x0c, 0x04, 0xf0, 0x7a, 0x83,
+		  0x85, 0xbf, 0x4c, 0xab, 0x15, 0x38, 0x90, 0xe1, 0xd0 ),
+	PUBLIC ( 0x30, 0x81, 0x9f, 0x30, 0x0d, 0x06, 0x09, 0x2a, 0x86, 0x48,
+		 0x86, 0xf7, 0x0d, 0x01, 0x01, 0x01, 0x05, 0x00, 0x03, 0x81,
+		 0x8d, 0x00, 0x30, 0x81, 0x89, 0x02, 0x81, 0x81, 0x00, 0xe9,
+		 0x96, 0xdb, 0x67, 0xcf, 0x85, 0xfc, 0x86, 0xe8, 0x06, 0x22,
+		 0x6d, 0x7d, 0xdd, 0xac, 0x7d, 0xe0, 0x98, 0x4d, 0x32, 0x79,
+		 0xcd, 0x1f, 0x8e, 0x25, 0x58, 0xa1, 0xd8, 0x81, 0xfe, 0x0b,
+		 0x6c, 0xff, 0x67, 0x20, 0x68, 0x02, 0xee, 0xb7, 0x1b, 0x5f,
+		 0xc3, 0xd7, 0xe8, 0x70, 0x78, 0x77, 0x60, 0x7d, 0x6e, 0x3e,
+		 0xab, 0x8c, 0xbf, 0x0e, 0x50, 0x77, 0xb3, 0x60, 0x7b, 0xb5,
+		 0xbd, 0xca, 0xa0, 0x53, 0xd4, 0x9c, 0x2f, 0xb2, 0xb4, 0xd6,
+		 0xb8, 0x2f, 0x97, 0x5b, 0x7d, 0x02, 0xc5, 0x8c, 0xb2, 0x4e,
+		 0x0b, 0xdf, 0xbd, 0x7f, 0x79, 0x16, 0xb5, 0x52, 0xe5, 0xda,
+		 0xfd, 0xa6, 0x41, 0x58, 0xca, 0xbc, 0x89, 0xbd, 0x2d, 0x93,
+		 0x5a, 0x5c, 0xb2, 0x21, 0x79, 0x07, 0x4f, 0xd0, 0xaa, 0xe1,
+		 0x8f, 0x2e, 0x19, 0xb3, 0xdf, 0x92, 0xb6, 0x9e, 0x3d, 0x58,
+		 0x21, 0x70, 0x5f, 0x70, 0x77, 0x4c, 0x53, 0x02, 0x03, 0x01,
+		 0x00, 0x01 ),
+	PLAINTEXT ( 0x7d, 0xef, 0x38, 0xb7, 0xb5, 0x84, 0xb0, 0x72, 0x36, 0xf3,
+		    0x63, 0xf3, 0xbd, 0xc8, 0x73, 0x58, 0x32, 0x77, 0xc1, 0x28,
+		    0x28, 0x77, 0x51, 0x23, 0x5e, 0x5e, 0x34, 0x17, 0xb2, 0xcd,
+		    0x77, 0xda, 0x14, 0xde, 0x34, 0x14, 0x14, 0xd4, 0x68, 0x21,
+		    0xf2, 0x4f, 0x19, 0x33, 0xeb, 0x70, 0x50, 0x86, 0x14, 0xcf,
+		    0x8a, 0x5c, 0xb4, 0xaa, 0xe6, 0x94, 0x7f, 0xcc, 0x19, 0x49,
+		    0x0e, 0x2f, 0xac, 0x72, 0x3d, 0x0b, 0xcd, 0x8b, 0x1d, 0x33,
+		    0x58, 0xb6, 0xd6, 0x93, 0xba, 0x84, 0x96, 0x45, 0xf0, 0x6c,
+		    0xa3, 0xc5, 0x24, 0xa9, 0x9e, 0xc0, 0xdd, 0xa9, 0x2d, 0x1e,
+		    0x88, 0x72, 0x59, 0xc1, 0x7a, 0x28, 0x02, 0x1a, 0x18, 0x56 ),
+	&sha256_algorithm,
+	SIGNATURE ( 0x9f, 0x37, 0x89, 0x7c, 0x4f, 0xb0, 0x50, 0x1f, 0xb9, 0x57,
+		    0xf4, 0x97, 0x5d, 0x36, 0xee, 0x53, 0x46, 0x77, 0x74, 0x5c,
+		    0x65, 0xeb, 0xbd, 0xc9, 0x8b, 0x17, 0xf9, 0xf2, 0xb5, 0x1a,
+		    0x86, 0xa5, 0x78, 0x7f, 0x61, 0x9f, 0x1b, 0x9e, 0xc0, 0xec,
+		    0xb5, 0x09, 0x32, 0x03, 0x6b, 0x20, 0x30, 0xbf, 0xe7, 0x1f,
+		    0xf8, 0x4d, 0xb3, 0xb4, 0xc7, 0xeb, 0xa1, 0xca, 0x74, 0x04,
+		    0xe3, 0xf3, 0x5a, 0x74, 0xf3, 0xe0, 0x8c, 0xc7, 0x1d, 0x22,
+		    0x27, 0xcd, 0x47, 0x83, 0x95, 0x83, 0x1d, 0xc4, 0x2f, 0x9c,
+		    0x6b, 0x56, 0x8a, 0xea, 0x98, 0x92, 0xa2, 0xee, 0xf2, 0x27,
+		    0xe5, 0x5a, 0xda, 0x73, 0x7b, 0x1e, 0x2b, 0x60, 0xf3, 0xc1,
+		    0x73, 0x3d, 0x13, 0x05, 0xe6, 0x0b, 0xf5, 0x38, 0x82, 0x16,
+		    0x2a, 0x8f, 0x08, 0x59, 0xab, 0xe7, 0x3d, 0xe9, 0x56, 0xb4,
+		    0xca, 0x29, 0x08, 0x46, 0x5e, 0x9a, 0x1f, 0x24 ) );
+
+/**
+ * Report RSA-PSS signature test result
+ *
+ * @v test		Public key signature test
+ * @v file		Test code file
+ * @v line		Test code line
+ *
+ * RSA-PSS signatures include a random salt, and so a constructed
+ * signature can be verified but cannot be compared against the
+ * expected signature.
+ */
+static void rsa_pss_okx ( struct pubkey_sign_test *test, const char *file,
+			  unsigned int line ) {
+	struct pubkey_algorithm *pubkey = test->pubkey;
+	struct digest_algorithm *digest = test->digest;
+	uint8_t digestctx[digest->ctxsize];
+	uint8_t digestout[digest->digestsize];
+	uint8_t signature[test->signature.len];
+	struct asn1_cursor cursor = { signature, sizeof ( signature ) };
+	struct asn1_builder builder = { NULL, 0 };
+	uint8_t *bad;
+
+	/* Test key matching */
+	okx ( pubkey_match ( pubkey, &test->private, &test->public ) == 0,
+	      file, line );
+
+	/* Construct digest over plaintext */
+	digest_init ( digest, digestctx );
+	digest_update ( digest, digestctx, test->plaintext,
+			test->plaintext_len );
+	digest_final ( digest, digestctx, digestout );
+
+	/* Test verification using public key */
+	okx ( pubkey_verify ( pubkey, &test->public, digest, digestout,
+			      &test->signature ) == 0, file, line );
+
+	/* Test verification failure of modified signature */
+	memcpy ( signature, test->signature.data, sizeof ( signature ) );
+	bad = ( signature + ( sizeof ( signature ) / 2 ) );
+	*bad ^= 0x40;
+	okx ( pubkey_verify ( pubkey, &test->public, digest, digestout,
+			      &cursor ) != 0, file, line );
+	*bad ^= 0x40;
+	okx ( pubkey_verify ( pubkey, &test->public, digest, digestout,
+			      &cursor ) == 0, file, line );
+
+	/* Test verification failure of modified digest */
+	digestout[0] ^= 0x01;
+	okx ( pubkey_verify ( pubkey, &test->public, digest, digestout,
+			      &test->signature ) != 0, file, line );
+	digestout[0] ^= 0x01;
+
+	/* Test signing using private key */
+	okx ( pubkey_sign ( pubkey, &test->private, digest, digestout,
+			    &builder ) == 0, file, line );
+	okx ( builder.len == test->signature.len, file, line );
+
+	/* Test verification of constructed signature */
+	okx ( pubkey_verify ( pubkey, &test->public, digest, digestout,
+			      asn1_built ( &builder ) ) == 0, file, line );
+
+	/* Test that signature is not verifiable as PKCS#1 v1.5 */
+	okx ( pubkey_verify ( &rsa_algorithm, &test->public, digest,
+			      digestout, asn1_built ( &builder ) ) != 0,
+	      file, line );
+
+	/* Free signature */
+	free ( builder.data );
+}
+#define rsa_pss_ok( test ) rsa_pss_okx ( test, __FILE__, __LINE__ )
+
 /**
  * Perform RSA self-tests
  *
@@ -384,6 +561,7 @@ static void rsa_test_exec ( void ) {
 	pubkey_sign_ok ( &md5_test );
 	pubkey_sign_ok ( &sha1_test );
 	pubkey_sign_ok ( &sha256_test );
+	rsa_pss_ok ( &sha256_pss_test );
 }
 
 /** RSA self-test */
@@ -0,0 +1,182 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+/** @file
+ *
+ * Reed-Solomon forward error correction tests
+ *
+ */
+
+/* Forcibly enable assertions */
+#undef NDEBUG
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ipxe/rsfec.h>
+#include <ipxe/test.h>
+
+/** Maximum number of source symbols used in tests */
+#define RSFEC_TEST_MAX_K 128
+
+/** Symbol length used in tests */
+#define RSFEC_TEST_LEN 61
+
+/** A Reed-Solomon FEC test */
+struct rsfec_test {
+	/** Received encoding symbol IDs */
+	const uint8_t *esi;
+	/** Number of source symbols */
+	unsigned int k;
+};
+
+/** Define a Reed-Solomon FEC test */
+#define RSFEC( name, ... )						\
+	static const uint8_t name ## _esi[] = { __VA_ARGS__ };		\
+	static struct rsfec_test name = {				\
+		.esi = name ## _esi,					\
+		.k = sizeof ( name ## _esi ),				\
+	}
+
+/** All source symbols received, out of order */
+RSFEC ( no_loss, 2, 0, 3, 1 );
+
+/** Single source symbol lost */
+RSFEC ( single_loss, 0, 1, 3, 4 );
+
+/** All source symbols lost */
+RSFEC ( all_loss, 7, 4, 6, 5 );
+
+/** Single-symbol source block */
+RSFEC ( single_symbol, 200 );
+
+/** Mixture of source and repair symbols */
+RSFEC ( mixed, 107, 0, 100, 1, 101, 2, 102, 3, 103, 4, 104, 5, 105, 6,
+	106, 7 );
+
+/** Highest encoding symbol IDs */
+RSFEC ( highest, 254, 253, 252, 251, 250, 249, 248, 247 );
+
+/**
+ * Calculate test source symbol byte
+ *
+ * @v index		Source symbol index
+ * @v offset		Offset within symbol
+ * @ret byte		Test data byte
+ */
+static inline uint8_t rsfec_byte ( unsigned int index, unsigned int offset ) {
+	return ( ( index * 29 ) ^ ( offset * 13 ) ^ ( index >> 1 ) );
+}
+
+/**
+ * Report Reed-Solomon FEC test result
+ *
+ * @v k			Number of source symbols
+ * @v esi		Received encoding symbol IDs
+ * @v file		Test code file
+ * @v line		Test code line
+ */
+static void rsfec_okx ( unsigned int k, const uint8_t *esi, const char *file,
+			unsigned int line ) {
+	static uint8_t source[RSFEC_TEST_MAX_K][RSFEC_TEST_LEN];
+	static uint8_t received[RSFEC_TEST_MAX_K][RSFEC_TEST_LEN];
+	void *source_ptrs[RSFEC_TEST_MAX_K];
+	void *symbols[RSFEC_TEST_MAX_K];
+	uint8_t ids[RSFEC_TEST_MAX_K];
+	unsigned int i;
+	unsigned int j;
+
+	/* Sanity check */
+	okx ( k <= RSFEC_TEST_MAX_K, file, line );
+
+	/* Construct source block */
+	for ( i = 0 ; i < k ; i++ ) {
+		for ( j = 0 ; j < RSFEC_TEST_LEN ; j++ )
+			source[i][j] = rsfec_byte ( i, j );
+		source_ptrs[i] = source[i];
+	}
+
+	/* Construct received encoding symbols */
+	for ( i = 0 ; i < k ; i++ ) {
+		okx ( rsfec_encode ( k, source_ptrs, esi[i], received[i],
+				     RSFEC_TEST_LEN ) == 0, file, line );
+		symbols[i] = received[i];
+		ids[i] = esi[i];
+	}
+
+	/* Reconstruct and verify source block */
+	okx ( rsfec_decode ( k, ids, symbols, RSFEC_TEST_LEN ) == 0,
+	      file, line );
+	for ( i = 0 ; i < k ; i++ ) {
+		okx ( ids[i] == i, file, line );
+		okx ( memcmp ( symbols[i], source[i], RSFEC_TEST_LEN ) == 0,
+		      file, line );
+	}
+}
+#define rsfec_ok( test ) \
+	rsfec_okx ( (test)->k, (test)->esi, __FILE__, __LINE__ )
+
+/**
+ * Perform Reed-Solomon FEC self-tests
+ *
+ */
+static void rsfec_test_exec ( void ) {
+	uint8_t source[2][RSFEC_TEST_LEN];
+	uint8_t symbol[RSFEC_TEST_LEN];
+	void *source_ptrs[2] = { source[0], source[1] };
+	void *symbols[2] = { source[0], source[1] };
+	uint8_t esi[RSFEC_TEST_MAX_K];
+	unsigned int i;
+
+	/* Fixed tests */
+	rsfec_ok ( &no_loss );
+	rsfec_ok ( &single_loss );
+	rsfec_ok ( &all_loss );
+	rsfec_ok ( &single_symbol );
+	rsfec_ok ( &mixed );
+	rsfec_ok ( &highest );
+
+	/* Large block with half of the source symbols lost */
+	for ( i = 0 ; i < RSFEC_TEST_MAX_K ; i++ )
+		esi[i] = ( ( i & 1 ) ? i : ( RSFEC_TEST_MAX_K + ( i / 2 ) ) );
+	rsfec_okx ( RSFEC_TEST_MAX_K, esi, __FILE__, __LINE__ );
+
+	/* Invalid parameters */
+	ok ( rsfec_encode ( 0, source_ptrs, 0, symbol,
+			    sizeof ( symbol ) ) != 0 );
+	ok ( rsfec_encode ( 2, source_ptrs, RSFEC_MAX_N, symbol,
+			    sizeof ( symbol ) ) != 0 );
+	esi[0] = 1;
+	esi[1] = 1;
+	ok ( rsfec_decode ( 2, esi, symbols, sizeof ( symbol ) ) != 0 );
+	esi[1] = RSFEC_MAX_N;
+	ok ( rsfec_decode ( 2, esi, symbols, sizeof ( symbol ) ) != 0 );
+}
+
+/** Reed-Solomon FEC self-test */
+struct self_test rsfec_test __self_test = {
+	.name = "rsfec",
+	.exec = rsfec_test_exec,
+};
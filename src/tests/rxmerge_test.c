@@ -0,0 +1,204 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+/** @file
+ *
+ * Received packet merging tests
+ *
+ */
+
+/* Forcibly enable assertions */
+#undef NDEBUG
+
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+#include <byteswap.h>
+#include <ipxe/iobuf.h>
+#include <ipxe/ip.h>
+#include <ipxe/tcp.h>
+#include <ipxe/tcpip.h>
+#include <ipxe/test.h>
+
+/** Initial sequence number used for tests
+ *
+ * This is chosen to exercise sequence number wraparound.
+ */
+#define RXMERGE_BASE 0xffffff00UL
+
+/**
+ * Calculate expected test data byte
+ *
+ * @v seq		SEQ value
+ * @ret byte		Test data byte
+ */
+static inline uint8_t rxmerge_byte ( uint32_t seq ) {
+	return ( ( seq * 7 ) ^ ( seq >> 8 ) );
+}
+
+/**
+ * Construct test IPv4 TCP packet
+ *
+ * @v seq		Offset of SEQ value from test base
+ * @v len		Length of data
+ * @v flags		TCP flags
+ * @v size		Size of I/O buffer
+ * @ret iobuf		I/O buffer
+ */
+static struct io_buffer * rxmerge_packet ( uint32_t seq, size_t len,
+					   unsigned int flags, size_t size ) {
+	struct io_buffer *iobuf;
+	struct iphdr *iphdr;
+	struct tcp_header *tcphdr;
+	uint8_t *data;
+	size_t i;
+
+	iobuf = alloc_iob ( size );
+	assert ( iobuf != NULL );
+	iphdr = iob_put ( iobuf, sizeof ( *iphdr ) );
+	tcphdr = iob_put ( iobuf, sizeof ( *tcphdr ) );
+	data = iob_put ( iobuf, len );
+
+	seq += RXMERGE_BASE;
+	memset ( iphdr, 0, sizeof ( *iphdr ) );
+	iphdr->verhdrlen = ( IP_VER | ( sizeof ( *iphdr ) / 4 ) );
+	iphdr->len = htons ( iob_len ( iobuf ) );
+	iphdr->ttl = IP_TTL;
+	iphdr->protocol = IP_TCP;
+	iphdr->src.s_addr = htonl ( 0xc0a80001UL );
+	iphdr->dest.s_addr = htonl ( 0xc0a80002UL );
+	iphdr->chksum = tcpip_chksum ( iphdr, sizeof ( *iphdr ) );
+
+	memset ( tcphdr, 0, sizeof ( *tcphdr ) );
+	tcphdr->src = htons ( 80 );
+	tcphdr->dest = htons ( 49152 );
+	tcphdr->seq = htonl ( seq );
+	tcphdr->ack = htonl ( 0x12345678UL );
+	tcphdr->hlen = ( ( sizeof ( *tcphdr ) / 4 ) << 4 );
+	tcphdr->flags = flags;
+	tcphdr->win = htons ( 65535 );
+
+	for ( i = 0 ; i < len ; i++ )
+		data[i] = rxmerge_byte ( seq + i );
+	iobuf->flags |= IOB_CSUM_VALID;
+	return iobuf;
+}
+
+/**
+ * Check merged test IPv4 TCP packet
+ *
+ * @v iobuf		I/O buffer
+ * @v seq		Offset of SEQ value from test base
+ * @v len		Expected length of data
+ * @v flags		Expected TCP flags
+ * @v file		Test code file
+ * @v line		Test code line
+ */
+static void rxmerge_okx ( struct io_buffer *iobuf, uint32_t seq, size_t len,
+			  unsigned int flags, const char *file,
+			  unsigned int line ) {
+	struct iphdr *iphdr = iobuf->data;
+	struct tcp_header *tcphdr = ( ( void * ) ( iphdr + 1 ) );
+	uint8_t *data = ( ( void * ) ( tcphdr + 1 ) );
+	size_t i;
+	int intact = 1;
+
+	seq += RXMERGE_BASE;
+	okx ( iob_len ( iobuf ) ==
+	      ( sizeof ( *iphdr ) + sizeof ( *tcphdr ) + len ), file, line );
+	okx ( ntohs ( iphdr->len ) == iob_len ( iobuf ), file, line );
+	okx ( tcpip_chksum ( iphdr, sizeof ( *iphdr ) ) == 0, file, line );
+	okx ( ntohl ( tcphdr->seq ) == seq, file, line );
+	okx ( tcphdr->flags == flags, file, line );
+	for ( i = 0 ; i < len ; i++ ) {
+		if ( data[i] != rxmerge_byte ( seq + i ) )
+			intact = 0;
+	}
+	okx ( intact, file, line );
+}
+#define rxmerge_ok( iobuf, seq, len, flags ) \
+	rxmerge_okx ( iobuf, seq, len, flags, __FILE__, __LINE__ )
+
+/**
+ * Perform received packet merging self-tests
+ *
+ */
+static void rxmerge_test_exec ( void ) {
+	struct io_buffer *iobuf;
+	struct io_buffer *next;
+
+	/* Consecutive segments are merged */
+	iobuf = rxmerge_packet ( 0, 100, TCP_ACK, 1024 );
+	next = rxmerge_packet ( 100, 200, TCP_ACK, 1024 );
+	ok ( ipv4_protocol.merge ( iobuf, next ) == 0 );
+	free_iob ( next );
+	next = rxmerge_packet ( 300, 50, ( TCP_ACK | TCP_PSH ), 1024 );
+	ok ( ipv4_protocol.merge ( iobuf, next ) == 0 );
+	free_iob ( next );
+	rxmerge_ok ( iobuf, 0, 350, ( TCP_ACK | TCP_PSH ) );
+
+	/* No further segments are merged after PSH */
+	next = rxmerge_packet ( 350, 50, TCP_ACK, 1024 );
+	ok ( ipv4_protocol.merge ( iobuf, next ) != 0 );
+	free_iob ( next );
+	free_iob ( iobuf );
+
+	/* Non-consecutive segments are not merged */
+	iobuf = rxmerge_packet ( 0, 100, TCP_ACK, 1024 );
+	next = rxmerge_packet ( 200, 100, TCP_ACK, 1024 );
+	ok ( ipv4_protocol.merge ( iobuf, next ) != 0 );
+	rxmerge_ok ( iobuf, 0, 100, TCP_ACK );
+	free_iob ( next );
+	free_iob ( iobuf );
+
+	/* Control segments are not merged */
+	iobuf = rxmerge_packet ( 0, 100, TCP_ACK, 1024 );
+	next = rxmerge_packet ( 100, 100, ( TCP_ACK | TCP_FIN ), 1024 );
+	ok ( ipv4_protocol.merge ( iobuf, next ) != 0 );
+	free_iob ( next );
+	free_iob ( iobuf );
+
+	/* Segments from different flows are not merged */
+	iobuf = rxmerge_packet ( 0, 100, TCP_ACK, 1024 );
+	next = rxmerge_packet ( 100, 100, TCP_ACK, 1024 );
+	( ( struct iphdr * ) next->data )->src.s_addr ^= htonl ( 1 );
+	ok ( ipv4_protocol.merge ( iobuf, next ) != 0 );
+	free_iob ( next );
+	free_iob ( iobuf );
+
+	/* Required tailroom is reported */
+	iobuf = rxmerge_packet ( 0, 100, TCP_ACK, 1024 );
+	next = rxmerge_packet ( 100, 2000, TCP_ACK, 4096 );
+	ok ( ipv4_protocol.merge ( iobuf, next ) == 2000 );
+	rxmerge_ok ( iobuf, 0, 100, TCP_ACK );
+	free_iob ( next );
+	free_iob ( iobuf );
+}
+
+/** Received packet merging self-test */
+struct self_test rxmerge_test __self_test = {
+	.name = "rxmerge",
+	.exec = rxmerge_test_exec,
+};
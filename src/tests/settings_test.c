@@ -33,6 +33,7 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 #undef NDEBUG
 
 #include <string.h>
+#include <stdio.h>
 #include <ipxe/settings.h>
 #include <ipxe/test.h>
 
@@ -262,6 +263,66 @@ static struct setting test_busdevfn_setting = {
 	.type = &setting_type_busdevfn,
 };
 
+/** Test tagged setting */
+static struct setting test_tagged_setting = {
+	.name = "test_tagged",
+	.type = &setting_type_string,
+	.tag = 0x1234eb,
+};
+
+/** Test tagged setting (identified only by tag) */
+static struct setting test_tag_only_setting = {
+	.name = "",
+	.type = &setting_type_string,
+	.tag = 0x1234eb,
+};
+
+/** Number of settings used for lookup tests */
+#define TEST_MANY_COUNT 32
+
+/**
+ * Perform lookup tests with many settings
+ *
+ */
+static void settings_many_test ( void ) {
+	struct setting setting;
+	char name[16];
+	unsigned int value;
+	unsigned int i;
+
+	/* Store many settings */
+	memset ( &setting, 0, sizeof ( setting ) );
+	setting.name = name;
+	for ( i = 0 ; i < TEST_MANY_COUNT ; i++ ) {
+		snprintf ( name, sizeof ( name ), "test_many%d", i );
+		value = ( i * 3 );
+		ok ( store_setting ( &test_settings, &setting, &value,
+				     sizeof ( value ) ) == 0 );
+	}
+
+	/* Delete every other setting */
+	for ( i = 0 ; i < TEST_MANY_COUNT ; i += 2 ) {
+		snprintf ( name, sizeof ( name ), "test_many%d", i );
+		ok ( delete_setting ( &test_settings, &setting ) == 0 );
+	}
+
+	/* Check remaining settings */
+	for ( i = 0 ; i < TEST_MANY_COUNT ; i++ ) {
+		snprintf ( name, sizeof ( name ), "test_many%d", i );
+		value = 0;
+		if ( i & 1 ) {
+			ok ( fetch_raw_setting ( &test_settings, &setting,
+						 &value, sizeof ( value ) )
+			     == sizeof ( value ) );
+			ok ( value == ( i * 3 ) );
+		} else {
+			ok ( fetch_raw_setting ( &test_settings, &setting,
+						 &value, sizeof ( value ) )
+			     < 0 );
+		}
+	}
+}
+
 /**
  * Perform settings self-tests
  *
@@ -444,6 +505,20 @@ static void settings_test_exec ( void ) {
 	fetchf_ok ( &test_settings, &test_busdevfn_setting,
 		    RAW ( 0x00, 0x02, 0x0a, 0x21 ), "0002:0a:04.1" );
 
+	/* Lookup by tag or by name */
+	storef_ok ( &test_settings, &test_tagged_setting, "tagged",
+		    RAW ( 't', 'a', 'g', 'g', 'e', 'd' ) );
+	fetchf_ok ( &test_settings, &test_tag_only_setting,
+		    RAW ( 't', 'a', 'g', 'g', 'e', 'd' ), "tagged" );
+	storef_ok ( &test_settings, &test_tag_only_setting, "retagged",
+		    RAW ( 'r', 'e', 't', 'a', 'g', 'g', 'e', 'd' ) );
+	fetchf_ok ( &test_settings, &test_tagged_setting,
+		    RAW ( 'r', 'e', 't', 'a', 'g', 'g', 'e', 'd' ),
+		    "retagged" );
+
+	/* Lookup within a large settings block */
+	settings_many_test();
+
 	/* Clear and unregister test settings block */
 	clear_settings ( &test_settings );
 	unregister_settings ( &test_settings );
@@ -59,10 +59,11 @@ DIGEST_TEST ( sha1_nist_abc_opq, &sha1_algorithm, DIGEST_NIST_ABC_OPQ,
 		       0x70, 0xf1 ) );
 
 /**
- * Perform SHA-1 self-test
+ * Perform SHA-1 self-test using current implementation
  *
+ * @v impl		Implementation description
  */
-static void sha1_test_exec ( void ) {
+static void sha1_test_impl ( const char *impl ) {
 
 	/* Correctness tests */
 	digest_ok ( &sha1_empty );
@@ -70,8 +71,26 @@ static void sha1_test_exec ( void ) {
 	digest_ok ( &sha1_nist_abc_opq );
 
 	/* Speed tests */
-	DBG ( "SHA1 required %ld cycles per byte\n",
-	      digest_cost ( &sha1_algorithm ) );
+	DBG ( "SHA1 (%s) required %ld cycles per byte\n",
+	      impl, digest_cost ( &sha1_algorithm ) );
+}
+
+/**
+ * Perform SHA-1 self-test
+ *
+ */
+static void sha1_test_exec ( void ) {
+
+	/* Test default implementation (which may be accelerated) */
+	sha1_test_impl ( "default" );
+
+	/* Test generic implementation */
+	sha1_accel_disabled = 1;
+	sha1_test_impl ( "generic" );
+	sha1_accel_disabled = 0;
+
+	/* Implementation consistency test */
+	digest_consistency_ok ( &sha1_algorithm, &sha1_accel_disabled );
 }
 
 /** SHA-1 self-test */
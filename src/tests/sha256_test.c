@@ -84,10 +84,11 @@ DIGEST_TEST ( sha224_nist_abc_opq, &sha224_algorithm, DIGEST_NIST_ABC_OPQ,
 		       0x25 ) );
 
 /**
- * Perform SHA-256 family self-test
+ * Perform SHA-256 family self-test using current implementation
  *
+ * @v impl		Implementation description
  */
-static void sha256_test_exec ( void ) {
+static void sha256_test_impl ( const char *impl ) {
 
 	/* Correctness tests */
 	digest_ok ( &sha256_empty );
@@ -98,10 +99,29 @@ static void sha256_test_exec ( void ) {
 	digest_ok ( &sha224_nist_abc_opq );
 
 	/* Speed tests */
-	DBG ( "SHA256 required %ld cycles per byte\n",
-	      digest_cost ( &sha256_algorithm ) );
-	DBG ( "SHA224 required %ld cycles per byte\n",
-	      digest_cost ( &sha224_algorithm ) );
+	DBG ( "SHA256 (%s) required %ld cycles per byte\n",
+	      impl, digest_cost ( &sha256_algorithm ) );
+	DBG ( "SHA224 (%s) required %ld cycles per byte\n",
+	      impl, digest_cost ( &sha224_algorithm ) );
+}
+
+/**
+ * Perform SHA-256 family self-test
+ *
+ */
+static void sha256_test_exec ( void ) {
+
+	/* Test default implementation (which may be accelerated) */
+	sha256_test_impl ( "default" );
+
+	/* Test generic implementation */
+	sha256_accel_disabled = 1;
+	sha256_test_impl ( "generic" );
+	sha256_accel_disabled = 0;
+
+	/* Implementation consistency tests */
+	digest_consistency_ok ( &sha256_algorithm, &sha256_accel_disabled );
+	digest_consistency_ok ( &sha224_algorithm, &sha256_accel_disabled );
 }
 
 /** SHA-256 family self-test */
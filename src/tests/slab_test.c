@@ -0,0 +1,155 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+FILE_SECBOOT ( PERMITTED );
+
+/** @file
+ *
+ * Slab allocator self-tests
+ *
+ */
+
+/* Forcibly enable assertions */
+#undef NDEBUG
+
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+#include <ipxe/malloc.h>
+#include <ipxe/slab.h>
+#include <ipxe/test.h>
+
+/** Number of objects to allocate */
+#define SLAB_TEST_COUNT 64
+
+/** A slab test object */
+struct slab_test_object {
+	/** Contents */
+	uint8_t data[72];
+};
+
+/** Statically declared slab cache */
+static SLAB_CACHE ( slab_test_static, "test.static",
+		    sizeof ( struct slab_test_object ) );
+
+/** Slab cache discarder */
+extern struct cache_discarder slab_discarder;
+
+/** Dynamically initialised slab cache */
+static struct slab_cache slab_test_dynamic;
+
+/**
+ * Report slab cache test result
+ *
+ * @v cache		Slab cache
+ * @v file		Test code file
+ * @v line		Test code line
+ */
+static void slab_okx ( struct slab_cache *cache, const char *file,
+		       unsigned int line ) {
+	struct slab_test_object *objs[SLAB_TEST_COUNT];
+	struct slab_test_object *obj;
+	unsigned int diff = 0;
+	unsigned int i;
+	unsigned int j;
+
+	/* Allocate objects and check that they are zeroed, aligned,
+	 * and distinct.
+	 */
+	for ( i = 0 ; i < SLAB_TEST_COUNT ; i++ ) {
+		obj = slab_alloc ( cache );
+		objs[i] = obj;
+		okx ( obj != NULL, file, line );
+		if ( ! obj )
+			return;
+		okx ( ( ( ( intptr_t ) obj ) & ( sizeof ( void * ) - 1 ) ) == 0,
+		      file, line );
+		for ( j = 0 ; j < sizeof ( obj->data ) ; j++ )
+			diff |= obj->data[j];
+		memset ( obj->data, ( i + 1 ), sizeof ( obj->data ) );
+	}
+	okx ( diff == 0, file, line );
+	okx ( cache->used == SLAB_TEST_COUNT, file, line );
+	okx ( cache->maxused >= SLAB_TEST_COUNT, file, line );
+	okx ( cache->slabs > 1, file, line );
+
+	/* Check that contents were not overwritten */
+	for ( i = 0 ; i < SLAB_TEST_COUNT ; i++ ) {
+		for ( j = 0 ; j < sizeof ( objs[i]->data ) ; j++ )
+			diff |= ( objs[i]->data[j] ^ ( i + 1 ) );
+	}
+	okx ( diff == 0, file, line );
+
+	/* Check that a freed object is reused */
+	obj = objs[ SLAB_TEST_COUNT / 2 ];
+	slab_free ( cache, obj );
+	objs[ SLAB_TEST_COUNT / 2 ] = slab_alloc ( cache );
+	okx ( objs[ SLAB_TEST_COUNT / 2 ] == obj, file, line );
+
+	/* Free all objects, and check that at most one empty slab
+	 * is retained.
+	 */
+	for ( i = 0 ; i < SLAB_TEST_COUNT ; i++ )
+		slab_free ( cache, objs[i] );
+	okx ( cache->used == 0, file, line );
+	okx ( cache->slabs <= 1, file, line );
+	okx ( cache->empty == cache->slabs, file, line );
+
+	/* Freeing NULL should have no effect */
+	slab_free ( cache, NULL );
+	okx ( cache->used == 0, file, line );
+}
+#define slab_ok( cache ) slab_okx ( cache, __FILE__, __LINE__ )
+
+/**
+ * Perform slab allocator self-tests
+ *
+ */
+static void slab_test_exec ( void ) {
+	struct slab_cache *cache;
+	unsigned int discarded;
+
+	/* Test statically declared cache */
+	slab_ok ( &slab_test_static );
+
+	/* Test dynamically initialised cache */
+	slab_create ( &slab_test_dynamic, "test.dynamic",
+		      sizeof ( struct slab_test_object ) );
+	slab_ok ( &slab_test_dynamic );
+
+	/* Check that empty slabs are released under memory pressure */
+	do {
+		discarded = slab_discarder.discard();
+	} while ( discarded );
+	list_for_each_entry ( cache, &slab_caches, list )
+		ok ( cache->empty == 0 );
+	ok ( slab_test_static.slabs == 0 );
+	ok ( slab_test_dynamic.slabs == 0 );
+}
+
+/** Slab allocator self-test */
+struct self_test slab_test __self_test = {
+	.name = "slab",
+	.exec = slab_test_exec,
+};
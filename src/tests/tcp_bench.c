@@ -0,0 +1,791 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+/** @file
+ *
+ * TCP throughput benchmarks
+ *
+ * These benchmarks measure the cost of receiving a bulk transfer
+ * through the complete network stack (network device, IPv4, TCP and
+ * optionally HTTP) from an emulated peer.  The peer is a loopback
+ * network device which answers the client's transmissions directly
+ * from within its transmit method, so that no external network or
+ * host configuration is required and results are reproducible.
+ *
+ * The emulated peer implements only as much TCP as is needed to
+ * stream data to a well-behaved receiver: it honours the advertised
+ * receive window and falls back to go-back-N on triple duplicate
+ * acknowledgements, but never retransmits on a timer.
+ */
+
+/* Forcibly enable profiling */
+#undef NDEBUG
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <byteswap.h>
+#include <ipxe/device.h>
+#include <ipxe/iobuf.h>
+#include <ipxe/netdevice.h>
+#include <ipxe/ethernet.h>
+#include <ipxe/if_ether.h>
+#include <ipxe/ip.h>
+#include <ipxe/tcp.h>
+#include <ipxe/tcpip.h>
+#include <ipxe/neighbour.h>
+#include <ipxe/settings.h>
+#include <ipxe/socket.h>
+#include <ipxe/in.h>
+#include <ipxe/open.h>
+#include <ipxe/xfer.h>
+#include <ipxe/interface.h>
+#include <ipxe/process.h>
+#include <ipxe/timer.h>
+#include <ipxe/profile.h>
+#include <ipxe/bench.h>
+
+/** Amount of payload data to transfer in each benchmark */
+#define TCP_BENCH_LEN ( 256 * 1024 * 1024 )
+
+/** Maximum time allowed for each benchmark */
+#define TCP_BENCH_TIMEOUT ( 60 * TICKS_PER_SEC )
+
+/** Emulated peer maximum segment size */
+#define TCP_BENCH_MSS 1460
+
+/** Emulated peer maximum amount of unacknowledged data */
+#define TCP_BENCH_MAX_INFLIGHT ( 512 * 1024 )
+
+/** Emulated peer initial sequence number */
+#define TCP_BENCH_ISS 0x10000000UL
+
+/** Emulated peer TCP port */
+#define TCP_BENCH_PORT 5001
+
+/** Emulated peer IPv4 address */
+#define TCP_BENCH_PEER_IP "192.168.0.2"
+
+/** Emulated peer MAC address */
+static const uint8_t tcp_bench_peer_mac[ETH_ALEN] =
+	{ 0x52, 0x54, 0x00, 0x00, 0x00, 0x02 };
+
+/** Client MAC address */
+static const uint8_t tcp_bench_client_mac[ETH_ALEN] =
+	{ 0x52, 0x54, 0x00, 0x00, 0x00, 0x01 };
+
+/** An emulated TCP peer */
+struct tcp_bench_peer {
+	/** Network device */
+	struct net_device *netdev;
+	/** Packets awaiting delivery to the client */
+	struct list_head rx;
+	/** Number of packets delivered to the client */
+	unsigned long packets;
+
+	/** Client IPv4 address */
+	struct in_addr client;
+	/** Peer IPv4 address */
+	struct in_addr peer;
+	/** Client TCP port (or zero if not connected) */
+	uint16_t port;
+	/** Peer TCP port */
+	uint16_t peer_port;
+	/** Oldest unacknowledged sequence number */
+	uint32_t snd_una;
+	/** Next sequence number to send */
+	uint32_t snd_nxt;
+	/** Client's receive window */
+	uint32_t snd_win;
+	/** Client's window scale */
+	unsigned int snd_win_scale;
+	/** Next sequence number expected from client */
+	uint32_t rcv_nxt;
+	/** Number of consecutive duplicate acknowledgements */
+	unsigned int dupacks;
+	/** Data transmission has started */
+	int started;
+	/** Client has closed the connection */
+	int closed;
+
+	/** Response header (if any) */
+	const char *header;
+	/** Length of response header */
+	size_t header_len;
+	/** Total length of response (including header) */
+	size_t len;
+	/** Wait for a request before sending response */
+	int on_request;
+};
+
+/** A benchmark data sink */
+struct tcp_bench_sink {
+	/** Data transfer interface */
+	struct interface xfer;
+	/** Amount of data received */
+	size_t len;
+	/** Transfer is complete */
+	int done;
+	/** Final status code */
+	int rc;
+};
+
+/** Dummy physical device */
+static struct device tcp_bench_dev = {
+	.name = "bench",
+	.driver_name = "bench",
+	.siblings = LIST_HEAD_INIT ( tcp_bench_dev.siblings ),
+	.children = LIST_HEAD_INIT ( tcp_bench_dev.children ),
+};
+
+/** Benchmark step profiler */
+static struct profiler tcp_bench_step_profiler __profiler =
+	{ .name = "tcpbench.step" };
+
+/**
+ * Calculate sequence number of end of response data
+ *
+ * @v peer		Emulated peer
+ * @ret seq		Sequence number
+ */
+static inline uint32_t tcp_bench_end ( struct tcp_bench_peer *peer ) {
+	return ( TCP_BENCH_ISS + 1 + peer->len );
+}
+
+/**
+ * Queue packet from emulated peer to client
+ *
+ * @v peer		Emulated peer
+ * @v flags		TCP flags
+ * @v seq		Sequence number
+ * @v len		Length of payload
+ * @ret rc		Return status code
+ */
+static int tcp_bench_tx ( struct tcp_bench_peer *peer, unsigned int flags,
+			  uint32_t seq, size_t len ) {
+	struct net_device *netdev = peer->netdev;
+	struct io_buffer *iobuf;
+	struct ethhdr *ethhdr;
+	struct iphdr *iphdr;
+	struct tcp_header *tcphdr;
+	struct tcp_mss_option *mssopt;
+	struct tcp_window_scale_padded_option *wsopt;
+	size_t opts_len;
+	size_t offset;
+	size_t frag_len;
+	uint8_t *data;
+
+	/* Allocate packet */
+	opts_len = ( ( flags & TCP_SYN ) ?
+		     ( sizeof ( *mssopt ) + sizeof ( *wsopt ) ) : 0 );
+	iobuf = alloc_iob ( sizeof ( *ethhdr ) + sizeof ( *iphdr ) +
+			    sizeof ( *tcphdr ) + opts_len + len );
+	if ( ! iobuf )
+		return -ENOMEM;
+
+	/* Construct Ethernet header */
+	ethhdr = iob_put ( iobuf, sizeof ( *ethhdr ) );
+	memcpy ( ethhdr->h_dest, netdev->ll_addr, ETH_ALEN );
+	memcpy ( ethhdr->h_source, tcp_bench_peer_mac, ETH_ALEN );
+	ethhdr->h_protocol = htons ( ETH_P_IP );
+
+	/* Construct IPv4 header */
+	iphdr = iob_put ( iobuf, sizeof ( *iphdr ) );
+	memset ( iphdr, 0, sizeof ( *iphdr ) );
+	iphdr->verhdrlen = ( IP_VER | ( sizeof ( *iphdr ) / 4 ) );
+	iphdr->len = htons ( sizeof ( *iphdr ) + sizeof ( *tcphdr ) +
+			     opts_len + len );
+	iphdr->ttl = IP_TTL;
+	iphdr->protocol = IP_TCP;
+	iphdr->src = peer->peer;
+	iphdr->dest = peer->client;
+	iphdr->chksum = tcpip_chksum ( iphdr, sizeof ( *iphdr ) );
+
+	/* Construct TCP header */
+	tcphdr = iob_put ( iobuf, sizeof ( *tcphdr ) );
+	memset ( tcphdr, 0, sizeof ( *tcphdr ) );
+	tcphdr->src = htons ( peer->peer_port );
+	tcphdr->dest = peer->port;
+	tcphdr->seq = htonl ( seq );
+	tcphdr->ack = htonl ( peer->rcv_nxt );
+	tcphdr->hlen = ( ( ( sizeof ( *tcphdr ) + opts_len ) / 4 ) << 4 );
+	tcphdr->flags = flags;
+	tcphdr->win = htons ( 0xffff );
+
+	/* Construct TCP options, if applicable */
+	if ( flags & TCP_SYN ) {
+		mssopt = iob_put ( iobuf, sizeof ( *mssopt ) );
+		mssopt->kind = TCP_OPTION_MSS;
+		mssopt->length = sizeof ( *mssopt );
+		mssopt->mss = htons ( TCP_BENCH_MSS );
+		wsopt = iob_put ( iobuf, sizeof ( *wsopt ) );
+		wsopt->nop = TCP_OPTION_NOP;
+		wsopt->wsopt.kind = TCP_OPTION_WS;
+		wsopt->wsopt.length = sizeof ( wsopt->wsopt );
+		wsopt->wsopt.scale = 0;
+	}
+
+	/* Construct payload, copying in any portion of the header */
+	data = iob_put ( iobuf, len );
+	offset = ( seq - ( TCP_BENCH_ISS + 1 ) );
+	if ( len && ( offset < peer->header_len ) ) {
+		frag_len = ( peer->header_len - offset );
+		if ( frag_len > len )
+			frag_len = len;
+		memcpy ( data, ( peer->header + offset ), frag_len );
+	}
+
+	/* Emulate receive checksum offload */
+	iobuf->flags |= IOB_CSUM_VALID;
+
+	/* Queue for delivery */
+	list_add_tail ( &iobuf->list, &peer->rx );
+	return 0;
+}
+
+/**
+ * Send as much response data as the client's window allows
+ *
+ * @v peer		Emulated peer
+ * @v need_ack		Acknowledgement is required
+ */
+static void tcp_bench_send ( struct tcp_bench_peer *peer, int need_ack ) {
+	uint32_t end = tcp_bench_end ( peer );
+	uint32_t inflight;
+	uint32_t win;
+	size_t len;
+	unsigned int flags;
+
+	/* Send data segments */
+	while ( peer->started &&
+		( ( int32_t ) ( end - peer->snd_nxt ) > 0 ) ) {
+		inflight = ( peer->snd_nxt - peer->snd_una );
+		win = peer->snd_win;
+		if ( win > TCP_BENCH_MAX_INFLIGHT )
+			win = TCP_BENCH_MAX_INFLIGHT;
+		if ( inflight >= win )
+			break;
+		len = ( end - peer->snd_nxt );
+		if ( len > ( win - inflight ) )
+			len = ( win - inflight );
+		if ( len > TCP_BENCH_MSS )
+			len = TCP_BENCH_MSS;
+		flags = ( TCP_ACK | ( ( len == ( end - peer->snd_nxt ) ) ?
+				      TCP_PSH : 0 ) );
+		if ( tcp_bench_tx ( peer, flags, peer->snd_nxt, len ) != 0 )
+			return;
+		peer->snd_nxt += len;
+		need_ack = 0;
+	}
+
+	/* Send FIN once all data has been sent */
+	if ( peer->started && ( peer->snd_nxt == end ) ) {
+		if ( tcp_bench_tx ( peer, ( TCP_FIN | TCP_ACK ),
+				    peer->snd_nxt, 0 ) != 0 )
+			return;
+		peer->snd_nxt++;
+		need_ack = 0;
+	}
+
+	/* Send pure acknowledgement, if required */
+	if ( need_ack )
+		tcp_bench_tx ( peer, TCP_ACK, peer->snd_nxt, 0 );
+}
+
+/**
+ * Handle SYN from client
+ *
+ * @v peer		Emulated peer
+ * @v tcphdr		TCP header
+ */
+static void tcp_bench_rx_syn ( struct tcp_bench_peer *peer,
+			       struct tcp_header *tcphdr ) {
+	size_t hlen = ( ( tcphdr->hlen & TCP_MASK_HLEN ) / 16 * 4 );
+	const uint8_t *opt = ( ( ( void * ) tcphdr ) + sizeof ( *tcphdr ) );
+	const uint8_t *end = ( ( ( void * ) tcphdr ) + hlen );
+	const struct tcp_window_scale_option *wsopt;
+
+	/* Reset connection state */
+	peer->port = tcphdr->src;
+	peer->rcv_nxt = ( ntohl ( tcphdr->seq ) + 1 );
+	peer->snd_una = TCP_BENCH_ISS;
+	peer->snd_nxt = TCP_BENCH_ISS;
+	peer->snd_win = ntohs ( tcphdr->win );
+	peer->snd_win_scale = 0;
+	peer->dupacks = 0;
+	peer->started = ( ! peer->on_request );
+	peer->closed = 0;
+
+	/* Parse window scale option, if present */
+	while ( ( opt < end ) && ( *opt != TCP_OPTION_END ) ) {
+		if ( *opt == TCP_OPTION_NOP ) {
+			opt++;
+			continue;
+		}
+		if ( ( opt + 2 ) > end )
+			break;
+		if ( *opt == TCP_OPTION_WS ) {
+			wsopt = ( ( const void * ) opt );
+			peer->snd_win_scale = wsopt->scale;
+		}
+		if ( opt[1] < 2 )
+			break;
+		opt += opt[1];
+	}
+
+	/* Send SYN-ACK */
+	if ( tcp_bench_tx ( peer, ( TCP_SYN | TCP_ACK ),
+			    peer->snd_nxt, 0 ) == 0 ) {
+		peer->snd_nxt++;
+	}
+}
+
+/**
+ * Handle TCP packet from client
+ *
+ * @v peer		Emulated peer
+ * @v tcphdr		TCP header
+ * @v len		Length of TCP header and payload
+ */
+static void tcp_bench_rx ( struct tcp_bench_peer *peer,
+			   struct tcp_header *tcphdr, size_t len ) {
+	size_t hlen = ( ( tcphdr->hlen & TCP_MASK_HLEN ) / 16 * 4 );
+	uint32_t seq = ntohl ( tcphdr->seq );
+	uint32_t ack = ntohl ( tcphdr->ack );
+	uint32_t acked;
+	size_t data_len;
+	int need_ack = 0;
+
+	/* Sanity check */
+	if ( ( hlen < sizeof ( *tcphdr ) ) || ( hlen > len ) )
+		return;
+	data_len = ( len - hlen );
+
+	/* Handle new connections */
+	if ( tcphdr->flags & TCP_SYN ) {
+		tcp_bench_rx_syn ( peer, tcphdr );
+		return;
+	}
+
+	/* Ignore packets for any other connection */
+	if ( tcphdr->src != peer->port )
+		return;
+
+	/* Handle reset */
+	if ( tcphdr->flags & TCP_RST ) {
+		peer->port = 0;
+		return;
+	}
+
+	/* Handle acknowledgement and window update */
+	if ( tcphdr->flags & TCP_ACK ) {
+		acked = ( ack - peer->snd_una );
+		if ( acked && ( acked <= ( peer->snd_nxt - peer->snd_una ) ) ){
+			peer->snd_una = ack;
+			peer->dupacks = 0;
+		} else if ( ( ! acked ) && ( ! data_len ) &&
+			    ( peer->snd_nxt != peer->snd_una ) &&
+			    ( ++peer->dupacks == 3 ) ) {
+			/* Go back N */
+			peer->snd_nxt = peer->snd_una;
+			peer->dupacks = 0;
+		}
+		peer->snd_win = ( ntohs ( tcphdr->win ) <<
+				  peer->snd_win_scale );
+	}
+
+	/* Consume data and FIN */
+	if ( data_len || ( tcphdr->flags & TCP_FIN ) ) {
+		if ( seq == peer->rcv_nxt ) {
+			peer->rcv_nxt += data_len;
+			if ( data_len )
+				peer->started = 1;
+			if ( tcphdr->flags & TCP_FIN ) {
+				peer->rcv_nxt++;
+				peer->closed = 1;
+			}
+		}
+		need_ack = 1;
+	}
+
+	/* Send response */
+	tcp_bench_send ( peer, need_ack );
+}
+
+/**
+ * Open network device
+ *
+ * @v netdev		Network device
+ * @ret rc		Return status code
+ */
+static int tcp_bench_open ( struct net_device *netdev __unused ) {
+
+	/* Do nothing, successfully */
+	return 0;
+}
+
+/**
+ * Close network device
+ *
+ * @v netdev		Network device
+ */
+static void tcp_bench_close ( struct net_device *netdev ) {
+	struct tcp_bench_peer *peer = netdev->priv;
+	struct io_buffer *iobuf;
+	struct io_buffer *tmp;
+
+	/* Discard any undelivered packets */
+	list_for_each_entry_safe ( iobuf, tmp, &peer->rx, list ) {
+		list_del ( &iobuf->list );
+		free_iob ( iobuf );
+	}
+}
+
+/**
+ * Transmit packet
+ *
+ * @v netdev		Network device
+ * @v iobuf		I/O buffer
+ * @ret rc		Return status code
+ *
+ * The emulated peer processes the packet immediately, queueing any
+ * response packets for delivery on the next poll.
+ */
+static int tcp_bench_transmit ( struct net_device *netdev,
+				struct io_buffer *iobuf ) {
+	struct tcp_bench_peer *peer = netdev->priv;
+	struct ethhdr *ethhdr = iobuf->data;
+	struct iphdr *iphdr = ( ( void * ) ( ethhdr + 1 ) );
+	size_t len = iob_len ( iobuf );
+	size_t hlen;
+	size_t ip_len;
+
+	/* Hand TCP packets to the emulated peer */
+	if ( ( len >= ( sizeof ( *ethhdr ) + sizeof ( *iphdr ) ) ) &&
+	     ( ethhdr->h_protocol == htons ( ETH_P_IP ) ) &&
+	     ( iphdr->protocol == IP_TCP ) ) {
+		hlen = ( ( iphdr->verhdrlen & IP_MASK_HLEN ) * 4 );
+		ip_len = ntohs ( iphdr->len );
+		if ( ( hlen >= sizeof ( *iphdr ) ) && ( hlen <= ip_len ) &&
+		     ( ip_len <= ( len - sizeof ( *ethhdr ) ) ) &&
+		     ( ( ip_len - hlen ) >= sizeof ( struct tcp_header ) ) ) {
+			tcp_bench_rx ( peer, ( ( ( void * ) iphdr ) + hlen ),
+				       ( ip_len - hlen ) );
+		}
+	}
+
+	/* Complete immediately */
+	netdev_tx_complete ( netdev, iobuf );
+	return 0;
+}
+
+/**
+ * Poll for completed and received packets
+ *
+ * @v netdev		Network device
+ */
+static void tcp_bench_poll ( struct net_device *netdev ) {
+	struct tcp_bench_peer *peer = netdev->priv;
+	struct io_buffer *iobuf;
+	unsigned int budget = NETDEV_RX_BUDGET;
+
+	/* Deliver queued packets */
+	while ( budget-- &&
+		( ( iobuf = list_first_entry ( &peer->rx, struct io_buffer,
+					       list ) ) != NULL ) ) {
+		list_del ( &iobuf->list );
+		netdev_rx ( netdev, iobuf );
+		peer->packets++;
+	}
+}
+
+/** Emulated peer network device operations */
+static struct net_device_operations tcp_bench_operations = {
+	.open		= tcp_bench_open,
+	.close		= tcp_bench_close,
+	.transmit	= tcp_bench_transmit,
+	.poll		= tcp_bench_poll,
+};
+
+/**
+ * Create emulated peer
+ *
+ * @v header		Response header, or NULL
+ * @v len		Total length of response
+ * @v on_request	Wait for a request before sending response
+ * @ret peer		Emulated peer, or NULL on error
+ */
+static struct tcp_bench_peer * tcp_bench_create ( const char *header,
+						  size_t len, int on_request ) {
+	struct net_device *netdev;
+	struct tcp_bench_peer *peer;
+	struct in_addr netmask;
+
+	/* Allocate and initialise network device */
+	netdev = alloc_etherdev ( sizeof ( *peer ) );
+	if ( ! netdev )
+		goto err_alloc;
+	netdev_init ( netdev, &tcp_bench_operations );
+	netdev->dev = &tcp_bench_dev;
+	memcpy ( netdev->hw_addr, tcp_bench_client_mac, ETH_ALEN );
+	peer = netdev->priv;
+	memset ( peer, 0, sizeof ( *peer ) );
+	peer->netdev = netdev;
+	INIT_LIST_HEAD ( &peer->rx );
+	inet_aton ( TCP_BENCH_PEER_IP, &peer->peer );
+	peer->client.s_addr = ( peer->peer.s_addr ^ htonl ( 0x03 ) );
+	peer->peer_port = TCP_BENCH_PORT;
+	peer->header = header;
+	peer->header_len = ( header ? strlen ( header ) : 0 );
+	peer->len = ( peer->header_len + len );
+	peer->on_request = on_request;
+
+	/* Register and open network device */
+	if ( register_netdev ( netdev ) != 0 )
+		goto err_register;
+	if ( netdev_open ( netdev ) != 0 )
+		goto err_open;
+	netdev_link_up ( netdev );
+
+	/* Configure client address and peer neighbour entry */
+	netmask.s_addr = htonl ( 0xffffff00UL );
+	if ( store_setting ( netdev_settings ( netdev ), &ip_setting,
+			     &peer->client, sizeof ( peer->client ) ) != 0 )
+		goto err_settings;
+	if ( store_setting ( netdev_settings ( netdev ), &netmask_setting,
+			     &netmask, sizeof ( netmask ) ) != 0 )
+		goto err_settings;
+	if ( neighbour_define ( netdev, &ipv4_protocol, &peer->peer,
+				tcp_bench_peer_mac ) != 0 )
+		goto err_neighbour;
+
+	return peer;
+
+ err_neighbour:
+ err_settings:
+ err_open:
+	unregister_netdev ( netdev );
+ err_register:
+	netdev_nullify ( netdev );
+	netdev_put ( netdev );
+ err_alloc:
+	return NULL;
+}
+
+/**
+ * Remove emulated peer
+ *
+ * @v peer		Emulated peer
+ */
+static void tcp_bench_remove ( struct tcp_bench_peer *peer ) {
+	struct net_device *netdev = peer->netdev;
+
+	unregister_netdev ( netdev );
+	netdev_nullify ( netdev );
+	netdev_put ( netdev );
+}
+
+/**
+ * Receive data
+ *
+ * @v sink		Benchmark data sink
+ * @v iobuf		I/O buffer
+ * @v meta		Data transfer metadata
+ * @ret rc		Return status code
+ */
+static int tcp_bench_deliver ( struct tcp_bench_sink *sink,
+			       struct io_buffer *iobuf,
+			       struct xfer_metadata *meta __unused ) {
+
+	/* Discard data */
+	sink->len += iob_len ( iobuf );
+	free_iob ( iobuf );
+	return 0;
+}
+
+/**
+ * Close data sink
+ *
+ * @v sink		Benchmark data sink
+ * @v rc		Reason for close
+ */
+static void tcp_bench_sink_close ( struct tcp_bench_sink *sink, int rc ) {
+
+	sink->rc = rc;
+	sink->done = 1;
+	intf_restart ( &sink->xfer, rc );
+}
+
+/** Benchmark data sink interface operations */
+static struct interface_operation tcp_bench_sink_operations[] = {
+	INTF_OP ( xfer_deliver, struct tcp_bench_sink *, tcp_bench_deliver ),
+	INTF_OP ( intf_close, struct tcp_bench_sink *, tcp_bench_sink_close ),
+};
+
+/** Benchmark data sink interface descriptor */
+static struct interface_descriptor tcp_bench_sink_desc =
+	INTF_DESC ( struct tcp_bench_sink, xfer, tcp_bench_sink_operations );
+
+/**
+ * Run benchmark
+ *
+ * @v name		Scenario name
+ * @v header		Response header, or NULL
+ * @v on_request	Wait for a request before sending response
+ * @v open		Open data transfer
+ * @ret rc		Return status code
+ */
+static int tcp_bench_run ( const char *name, const char *header,
+			   int on_request,
+			   int ( * open ) ( struct tcp_bench_sink *sink,
+					    struct tcp_bench_peer *peer ) ) {
+	struct profiler *profiler = &tcp_bench_step_profiler;
+	struct tcp_bench_sink sink;
+	struct tcp_bench_peer *peer;
+	unsigned long long cycles = 0;
+	unsigned long start;
+	unsigned long elapsed;
+	int rc;
+
+	/* Create emulated peer */
+	peer = tcp_bench_create ( header, TCP_BENCH_LEN, on_request );
+	if ( ! peer ) {
+		rc = -ENOMEM;
+		goto err_create;
+	}
+
+	/* Open data transfer */
+	memset ( &sink, 0, sizeof ( sink ) );
+	intf_init ( &sink.xfer, &tcp_bench_sink_desc, NULL );
+	start = currticks();
+	if ( ( rc = open ( &sink, peer ) ) != 0 )
+		goto err_open;
+
+	/* Run until transfer is complete and the connection is closed */
+	while ( ! ( sink.done && peer->closed && list_empty ( &peer->rx ) ) ){
+		profile_start ( profiler );
+		step();
+		profile_stop ( profiler );
+		cycles += profile_elapsed ( profiler );
+		if ( ( currticks() - start ) > TCP_BENCH_TIMEOUT ) {
+			rc = -ETIMEDOUT;
+			goto err_timeout;
+		}
+	}
+	elapsed = ( currticks() - start );
+
+	/* Check result */
+	if ( ( rc = sink.rc ) != 0 )
+		goto err_transfer;
+	if ( sink.len != TCP_BENCH_LEN ) {
+		rc = -EIO;
+		goto err_len;
+	}
+
+	/* Report result */
+	bench_report ( name, sink.len, peer->packets, elapsed, cycles );
+
+ err_len:
+ err_transfer:
+ err_timeout:
+ err_open:
+	intf_shutdown ( &sink.xfer, rc );
+	tcp_bench_remove ( peer );
+ err_create:
+	return rc;
+}
+
+/**
+ * Open raw TCP connection
+ *
+ * @v sink		Benchmark data sink
+ * @v peer		Emulated peer
+ * @ret rc		Return status code
+ */
+static int tcp_bench_open_tcp ( struct tcp_bench_sink *sink,
+				struct tcp_bench_peer *peer ) {
+	struct sockaddr_in sin;
+
+	memset ( &sin, 0, sizeof ( sin ) );
+	sin.sin_family = AF_INET;
+	sin.sin_port = htons ( peer->peer_port );
+	sin.sin_addr = peer->peer;
+	return xfer_open_socket ( &sink->xfer, SOCK_STREAM,
+				  ( struct sockaddr * ) &sin, NULL );
+}
+
+/**
+ * Open HTTP download
+ *
+ * @v sink		Benchmark data sink
+ * @v peer		Emulated peer
+ * @ret rc		Return status code
+ */
+static int tcp_bench_open_http ( struct tcp_bench_sink *sink,
+				 struct tcp_bench_peer *peer ) {
+	char uri[32 /* "http://xxx.xxx.xxx.xxx:nnnnn/bench" */ + 1];
+
+	snprintf ( uri, sizeof ( uri ), "http://%s:%d/bench",
+		   inet_ntoa ( peer->peer ), peer->peer_port );
+	return xfer_open_uri_string ( &sink->xfer, uri );
+}
+
+/**
+ * Run TCP bulk transfer benchmark
+ *
+ * @ret rc		Return status code
+ */
+static int tcp_bench_exec ( void ) {
+
+	return tcp_bench_run ( "tcp", NULL, 0, tcp_bench_open_tcp );
+}
+
+/**
+ * Run HTTP download benchmark
+ *
+ * @ret rc		Return status code
+ */
+static int http_bench_exec ( void ) {
+	static char header[128];
+
+	snprintf ( header, sizeof ( header ), "HTTP/1.1 200 OK\r\n"
+		   "Content-Length: %d\r\nConnection: close\r\n\r\n",
+		   TCP_BENCH_LEN );
+	return tcp_bench_run ( "http", header, 1, tcp_bench_open_http );
+}
+
+/** TCP bulk transfer benchmark */
+struct benchmark tcp_bench __benchmark = {
+	.name = "tcp",
+	.exec = tcp_bench_exec,
+};
+
+/** HTTP download benchmark */
+struct benchmark http_bench __benchmark = {
+	.name = "http",
+	.exec = http_bench_exec,
+};
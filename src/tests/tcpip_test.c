@@ -123,6 +123,18 @@ TCPIP_RANDOM_TEST ( random_aligned_truncated, 0x12345678UL, 4095, 0 );
 /** Random data (unaligned start and finish) */
 TCPIP_RANDOM_TEST ( partial, 0xcafebabe, 121, 5 );
 
+/** Random data (single large block) */
+TCPIP_RANDOM_TEST ( block, 0xdeadbeef, 64, 0 );
+
+/** Random data (large blocks with unaligned start and finish) */
+TCPIP_RANDOM_TEST ( blocks_partial, 0x0badf00d, 191, 7 );
+
+/** Random data (Ethernet frame payload) */
+TCPIP_RANDOM_TEST ( frame, 0x5eed5eed, 1500, 14 );
+
+/** Random data (many blocks with unaligned start and partial block) */
+TCPIP_RANDOM_TEST ( blocks_many, 0xfeedface, 4000, 3 );
+
 /**
  * Calculate TCP/IP checksum
  *
@@ -251,6 +263,10 @@ static void tcpip_test_exec ( void ) {
 	tcpip_random_ok ( &random_unaligned_2 );
 	tcpip_random_ok ( &random_aligned_truncated );
 	tcpip_random_ok ( &partial );
+	tcpip_random_ok ( &block );
+	tcpip_random_ok ( &blocks_partial );
+	tcpip_random_ok ( &frame );
+	tcpip_random_ok ( &blocks_many );
 }
 
 /** TCP/IP self-test */
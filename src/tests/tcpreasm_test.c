@@ -0,0 +1,327 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+/** @file
+ *
+ * TCP reassembly queue tests
+ *
+ */
+
+/* Forcibly enable assertions */
+#undef NDEBUG
+
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+#include <ipxe/iobuf.h>
+#include <ipxe/tcp.h>
+#include <ipxe/tcpreasm.h>
+#include <ipxe/profile.h>
+#include <ipxe/test.h>
+
+/** Initial sequence number used for tests
+ *
+ * This is chosen to exercise sequence number wraparound.
+ */
+#define TCPREASM_BASE 0xfffff000UL
+
+/** Segment length used for profiling */
+#define TCPREASM_PROFILE_LEN 1460
+
+/** Number of segments used for profiling */
+#define TCPREASM_PROFILE_COUNT 256
+
+/**
+ * Calculate expected test data byte
+ *
+ * @v seq		SEQ value
+ * @ret byte		Test data byte
+ */
+static inline uint8_t tcpreasm_byte ( uint32_t seq ) {
+	return ( ( seq * 13 ) ^ ( seq >> 8 ) );
+}
+
+/**
+ * Allocate test segment
+ *
+ * @v seq		SEQ value
+ * @v len		Length of data
+ * @ret iobuf		I/O buffer
+ */
+static struct io_buffer * tcpreasm_segment ( uint32_t seq, size_t len ) {
+	struct io_buffer *iobuf;
+	uint8_t *data;
+	size_t i;
+
+	iobuf = alloc_iob ( sizeof ( struct tcp_rx_queued_header ) + len );
+	assert ( iobuf != NULL );
+	iob_reserve ( iobuf, sizeof ( struct tcp_rx_queued_header ) );
+	data = iob_put ( iobuf, len );
+	for ( i = 0 ; i < len ; i++ )
+		data[i] = tcpreasm_byte ( seq + i );
+	return iobuf;
+}
+
+/**
+ * Add test segment to reassembly queue
+ *
+ * @v reasm		Reassembly queue
+ * @v base		First SEQ value not yet received
+ * @v seq		Offset of SEQ value from test base
+ * @v len		Length of data
+ * @v flags		TCP flags
+ */
+static void tcpreasm_add ( struct tcp_reasm *reasm, uint32_t base,
+			   uint32_t seq, size_t len, unsigned int flags ) {
+
+	seq += TCPREASM_BASE;
+	tcp_reasm_add ( reasm, ( base + TCPREASM_BASE ), seq, flags,
+			tcpreasm_segment ( seq, len ) );
+}
+
+/**
+ * Drain and check reassembly queue
+ *
+ * @v reasm		Reassembly queue
+ * @v base		Offset of first SEQ value not yet received
+ * @v end		Offset of expected SEQ value following received data
+ * @v fin		Expected FIN flag
+ * @v file		Test code file
+ * @v line		Test code line
+ */
+static void tcpreasm_drain_okx ( struct tcp_reasm *reasm, uint32_t base,
+				 uint32_t end, unsigned int fin,
+				 const char *file, unsigned int line ) {
+	struct tcp_rx_queued_header *tcpqhdr;
+	struct io_buffer *iobuf;
+	unsigned int flags = 0;
+	uint8_t *data;
+	size_t len;
+	size_t i;
+	int intact = 1;
+
+	/* Dequeue all contiguous packets */
+	base += TCPREASM_BASE;
+	end += TCPREASM_BASE;
+	while ( ( iobuf = tcp_reasm_dequeue ( reasm, base ) ) != NULL ) {
+		tcpqhdr = iobuf->data;
+		okx ( tcpqhdr->seq == base, file, line );
+		okx ( ! ( flags & TCP_FIN ), file, line );
+		flags = tcpqhdr->flags;
+		iob_pull ( iobuf, sizeof ( *tcpqhdr ) );
+		data = iobuf->data;
+		len = iob_len ( iobuf );
+		okx ( tcpqhdr->nxt == ( uint32_t ) ( base + len +
+						     ( ( flags & TCP_FIN ) ?
+						       1 : 0 ) ), file, line );
+		for ( i = 0 ; i < len ; i++ ) {
+			if ( data[i] != tcpreasm_byte ( base + i ) )
+				intact = 0;
+		}
+		base = tcpqhdr->nxt;
+		free_iob ( iobuf );
+	}
+
+	/* Check received data */
+	okx ( intact, file, line );
+	okx ( base == end, file, line );
+	okx ( ( flags & TCP_FIN ) == fin, file, line );
+	okx ( tcp_reasm_empty ( reasm ), file, line );
+	okx ( list_empty ( &reasm->list ), file, line );
+}
+#define tcpreasm_drain_ok( reasm, base, end, fin ) \
+	tcpreasm_drain_okx ( reasm, base, end, fin, __FILE__, __LINE__ )
+
+/**
+ * Check selective acknowledgement block
+ *
+ * @v reasm		Reassembly queue
+ * @v seq		Offset of SEQ value within block
+ * @v left		Offset of expected left edge, or zero if none
+ * @v right		Offset of expected right edge, or zero if none
+ * @v file		Test code file
+ * @v line		Test code line
+ */
+static void tcpreasm_sack_okx ( struct tcp_reasm *reasm, uint32_t seq,
+				uint32_t left, uint32_t right,
+				const char *file, unsigned int line ) {
+	struct tcp_sack_block sack;
+	uint32_t len;
+
+	len = tcp_reasm_sack ( reasm, ( seq + TCPREASM_BASE ), &sack );
+	okx ( len == ( right - left ), file, line );
+	if ( len ) {
+		okx ( sack.left == ( left + TCPREASM_BASE ), file, line );
+		okx ( sack.right == ( right + TCPREASM_BASE ), file, line );
+	}
+}
+#define tcpreasm_sack_ok( reasm, seq, left, right ) \
+	tcpreasm_sack_okx ( reasm, seq, left, right, __FILE__, __LINE__ )
+
+/**
+ * Profile insertion of reordered segments
+ *
+ * @v reorder		Reordering mask
+ */
+static void tcpreasm_profile ( unsigned int reorder ) {
+	struct tcp_reasm reasm;
+	struct profiler profiler;
+	struct io_buffer *iobuf;
+	unsigned int i;
+	uint32_t seq;
+
+	/* Add segments, reordering within groups */
+	tcp_reasm_init ( &reasm );
+	memset ( &profiler, 0, sizeof ( profiler ) );
+	for ( i = 0 ; i < TCPREASM_PROFILE_COUNT ; i++ ) {
+		seq = ( ( i ^ reorder ) * TCPREASM_PROFILE_LEN );
+		iobuf = tcpreasm_segment ( ( seq + TCPREASM_BASE ),
+					   TCPREASM_PROFILE_LEN );
+		profile_start ( &profiler );
+		tcp_reasm_add ( &reasm, TCPREASM_BASE,
+				( seq + TCPREASM_BASE ), 0, iobuf );
+		profile_stop ( &profiler );
+		ok ( reasm.count <= TCP_REASM_RANGES );
+	}
+
+	/* Check that all segments are merged into a single range */
+	ok ( reasm.count == 1 );
+	tcpreasm_drain_ok ( &reasm, 0,
+			    ( TCPREASM_PROFILE_COUNT * TCPREASM_PROFILE_LEN ),
+			    0 );
+
+	DBG ( "TCPREASM inserted %d segments (reorder %#x) in %ld +/- %ld "
+	      "ticks\n", TCPREASM_PROFILE_COUNT, reorder,
+	      profile_mean ( &profiler ), profile_stddev ( &profiler ) );
+}
+
+/**
+ * Perform TCP reassembly queue self-tests
+ *
+ */
+static void tcpreasm_test_exec ( void ) {
+	struct tcp_reasm reasm;
+	unsigned int i;
+
+	/* In-order segments */
+	tcp_reasm_init ( &reasm );
+	tcpreasm_add ( &reasm, 0, 0, 100, 0 );
+	tcpreasm_add ( &reasm, 0, 100, 100, 0 );
+	tcpreasm_add ( &reasm, 0, 200, 50, TCP_FIN );
+	ok ( reasm.count == 1 );
+	tcpreasm_drain_ok ( &reasm, 0, 251, TCP_FIN );
+
+	/* Reversed segments are merged into a single range */
+	tcp_reasm_init ( &reasm );
+	tcpreasm_add ( &reasm, 0, 200, 100, 0 );
+	tcpreasm_add ( &reasm, 0, 100, 100, 0 );
+	tcpreasm_add ( &reasm, 0, 0, 100, 0 );
+	ok ( reasm.count == 1 );
+	tcpreasm_drain_ok ( &reasm, 0, 300, 0 );
+
+	/* Filling a gap merges adjacent ranges */
+	tcp_reasm_init ( &reasm );
+	tcpreasm_add ( &reasm, 0, 100, 100, 0 );
+	tcpreasm_add ( &reasm, 0, 300, 100, 0 );
+	ok ( reasm.count == 2 );
+	tcpreasm_sack_ok ( &reasm, 100, 100, 200 );
+	tcpreasm_sack_ok ( &reasm, 200, 100, 200 );
+	tcpreasm_sack_ok ( &reasm, 250, 0, 0 );
+	tcpreasm_sack_ok ( &reasm, 350, 300, 400 );
+	tcpreasm_add ( &reasm, 0, 200, 100, 0 );
+	ok ( reasm.count == 1 );
+	tcpreasm_sack_ok ( &reasm, 250, 100, 400 );
+	tcpreasm_add ( &reasm, 0, 0, 100, 0 );
+	tcpreasm_drain_ok ( &reasm, 0, 400, 0 );
+
+	/* Overlapping and duplicate segments are trimmed */
+	tcp_reasm_init ( &reasm );
+	tcpreasm_add ( &reasm, 0, 100, 100, 0 );
+	tcpreasm_add ( &reasm, 0, 150, 100, 0 );
+	tcpreasm_add ( &reasm, 0, 120, 50, 0 );
+	tcpreasm_add ( &reasm, 0, 50, 300, TCP_FIN );
+	ok ( reasm.count == 1 );
+	tcpreasm_sack_ok ( &reasm, 50, 50, 250 );
+	tcpreasm_add ( &reasm, 0, 200, 100, TCP_FIN );
+	tcpreasm_sack_ok ( &reasm, 50, 50, 301 );
+	tcpreasm_add ( &reasm, 0, 0, 10, 0 );
+	ok ( reasm.count == 2 );
+	tcpreasm_add ( &reasm, 0, 5, 50, 0 );
+	ok ( reasm.count == 1 );
+	tcpreasm_drain_ok ( &reasm, 0, 301, TCP_FIN );
+
+	/* Already-received data is trimmed */
+	tcp_reasm_init ( &reasm );
+	tcpreasm_add ( &reasm, 100, 0, 50, 0 );
+	ok ( reasm.count == 0 );
+	tcpreasm_add ( &reasm, 100, 50, 100, 0 );
+	tcpreasm_sack_ok ( &reasm, 120, 100, 150 );
+	tcpreasm_drain_ok ( &reasm, 100, 150, 0 );
+
+	/* Number of ranges is limited */
+	tcp_reasm_init ( &reasm );
+	for ( i = 0 ; i <= TCP_REASM_RANGES ; i++ )
+		tcpreasm_add ( &reasm, 0, ( ( i + 1 ) * 100 ), 50, 0 );
+	ok ( reasm.count == TCP_REASM_RANGES );
+	tcpreasm_sack_ok ( &reasm, ( TCP_REASM_RANGES * 100 ),
+			   ( TCP_REASM_RANGES * 100 ),
+			   ( ( TCP_REASM_RANGES * 100 ) + 50 ) );
+	tcpreasm_sack_ok ( &reasm, ( ( TCP_REASM_RANGES + 1 ) * 100 ), 0, 0 );
+	tcpreasm_add ( &reasm, 0, 20, 10, 0 );
+	ok ( reasm.count == TCP_REASM_RANGES );
+	tcpreasm_sack_ok ( &reasm, ( TCP_REASM_RANGES * 100 ), 0, 0 );
+	tcpreasm_sack_ok ( &reasm, 20, 20, 30 );
+
+	/* Highest packets are discarded first */
+	ok ( tcp_reasm_discard ( &reasm ) );
+	ok ( reasm.count == ( TCP_REASM_RANGES - 1 ) );
+	tcpreasm_add ( &reasm, 0, 0, 20, 0 );
+	tcpreasm_add ( &reasm, 0, 30, 70, 0 );
+	tcpreasm_add ( &reasm, 0, 150, 50, 0 );
+	ok ( reasm.count == ( TCP_REASM_RANGES - 3 ) );
+	for ( i = 0 ; i < ( TCP_REASM_RANGES - 4 ) ; i++ )
+		ok ( tcp_reasm_discard ( &reasm ) );
+	ok ( reasm.count == 1 );
+	tcpreasm_sack_ok ( &reasm, 0, 0, 250 );
+	ok ( tcp_reasm_discard ( &reasm ) );
+	tcpreasm_sack_ok ( &reasm, 0, 0, 200 );
+	tcpreasm_drain_ok ( &reasm, 0, 200, 0 );
+	tcpreasm_add ( &reasm, 0, 100, 100, 0 );
+	tcp_reasm_flush ( &reasm );
+	ok ( reasm.count == 0 );
+	ok ( list_empty ( &reasm.list ) );
+	ok ( ! tcp_reasm_discard ( &reasm ) );
+
+	/* Profile insertion of reordered segments */
+	tcpreasm_profile ( 0x00 );
+	tcpreasm_profile ( 0x07 );
+	tcpreasm_profile ( 0xff );
+}
+
+/** TCP reassembly queue self-test */
+struct self_test tcpreasm_test __self_test = {
+	.name = "tcpreasm",
+	.exec = tcpreasm_test_exec,
+};
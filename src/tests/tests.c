@@ -43,6 +43,8 @@ REQUIRE_OBJECT ( base16_test );
 REQUIRE_OBJECT ( settings_test );
 REQUIRE_OBJECT ( time_test );
 REQUIRE_OBJECT ( tcpip_test );
+REQUIRE_OBJECT ( tcpreasm_test );
+REQUIRE_OBJECT ( rxmerge_test );
 REQUIRE_OBJECT ( ipv4_test );
 REQUIRE_OBJECT ( ipv6_test );
 REQUIRE_OBJECT ( crc32_test );
@@ -67,19 +69,30 @@ REQUIRE_OBJECT ( uri_test );
 REQUIRE_OBJECT ( profile_test );
 REQUIRE_OBJECT ( setjmp_test );
 REQUIRE_OBJECT ( pccrc_test );
+REQUIRE_OBJECT ( pccrd_test );
 REQUIRE_OBJECT ( linebuf_test );
 REQUIRE_OBJECT ( iobuf_test );
+REQUIRE_OBJECT ( heap_test );
+REQUIRE_OBJECT ( slab_test );
+REQUIRE_OBJECT ( xferbuf_test );
 REQUIRE_OBJECT ( bitops_test );
 REQUIRE_OBJECT ( der_test );
 REQUIRE_OBJECT ( pem_test );
 REQUIRE_OBJECT ( ntlm_test );
 REQUIRE_OBJECT ( zlib_test );
 REQUIRE_OBJECT ( gzip_test );
+REQUIRE_OBJECT ( inflate_test );
+REQUIRE_OBJECT ( zstd_test );
+REQUIRE_OBJECT ( xz_test );
 REQUIRE_OBJECT ( utf8_test );
 REQUIRE_OBJECT ( acpi_test );
 REQUIRE_OBJECT ( hmac_test );
+REQUIRE_OBJECT ( hkdf_test );
+REQUIRE_OBJECT ( pbkdf2_test );
 REQUIRE_OBJECT ( dhe_test );
 REQUIRE_OBJECT ( gcm_test );
+REQUIRE_OBJECT ( chacha20_test );
+REQUIRE_OBJECT ( poly1305_test );
 REQUIRE_OBJECT ( nap_test );
 REQUIRE_OBJECT ( x25519_test );
 REQUIRE_OBJECT ( des_test );
@@ -92,3 +105,7 @@ REQUIRE_OBJECT ( efi_siglist_test );
 REQUIRE_OBJECT ( cpio_test );
 REQUIRE_OBJECT ( fdt_test );
 REQUIRE_OBJECT ( ecdsa_test );
+REQUIRE_OBJECT ( blockcache_test );
+REQUIRE_OBJECT ( hpack_test );
+REQUIRE_OBJECT ( rsfec_test );
+REQUIRE_OBJECT ( fragment_test );
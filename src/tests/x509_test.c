@@ -1354,6 +1354,15 @@ static void x509_test_exec ( void ) {
 	x509_validate_chain_fail_ok ( &useless_chain, test_ca_expired,
 				      &empty_store, &test_root );
 
+	/* Check that cached validation results honour expiry times */
+	x509_validate_chain_ok ( &server_chain, test_time,
+				 &empty_store, &test_root );
+	ok ( x509_validate_chain ( server_chain.chain, test_time,
+				   &empty_store, &test_root ) == 0 );
+	ok ( x509_validate_chain ( server_chain.chain, test_expired,
+				   &empty_store, &test_root ) != 0 );
+	ok ( x509_is_valid ( server_crt.cert, &test_root ) );
+
 	/* Check chain truncation */
 	link = list_last_entry ( &server_chain.chain->links,
 				 struct x509_link, list );
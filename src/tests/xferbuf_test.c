@@ -0,0 +1,144 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+/** @file
+ *
+ * Data transfer buffer tests
+ *
+ */
+
+/* Forcibly enable assertions */
+#undef NDEBUG
+
+#include <stdint.h>
+#include <string.h>
+#include <ipxe/xferbuf.h>
+#include <ipxe/test.h>
+
+/** Number of bytes to write in growth test */
+#define XFERBUF_TEST_LEN 65536
+
+/** Size of each write in growth test */
+#define XFERBUF_TEST_STEP 1000
+
+/**
+ * Calculate expected test data byte
+ *
+ * @v offset		Offset
+ * @ret byte		Test data byte
+ */
+static inline uint8_t xferbuf_test_byte ( size_t offset ) {
+	return ( ( offset * 7 ) ^ ( offset >> 8 ) );
+}
+
+/**
+ * Perform growth test
+ *
+ * @v xferbuf		Data transfer buffer
+ */
+static void xferbuf_grow_test ( struct xfer_buffer *xferbuf ) {
+	uint8_t data[XFERBUF_TEST_STEP];
+	unsigned int reallocs = 0;
+	size_t capacity = 0;
+	size_t offset;
+	size_t len;
+	size_t i;
+	int intact;
+
+	/* Write data in small sequential pieces */
+	for ( offset = 0 ; offset < XFERBUF_TEST_LEN ; offset += len ) {
+		len = ( XFERBUF_TEST_LEN - offset );
+		if ( len > sizeof ( data ) )
+			len = sizeof ( data );
+		for ( i = 0 ; i < len ; i++ )
+			data[i] = xferbuf_test_byte ( offset + i );
+		ok ( xferbuf_write ( xferbuf, offset, data, len ) == 0 );
+		ok ( xferbuf->len == ( offset + len ) );
+		ok ( xferbuf->capacity >= xferbuf->len );
+		if ( xferbuf->capacity != capacity ) {
+			capacity = xferbuf->capacity;
+			reallocs++;
+		}
+	}
+
+	/* Check that buffer was grown geometrically */
+	ok ( reallocs < ( XFERBUF_TEST_LEN / XFERBUF_TEST_STEP / 4 ) );
+
+	/* Trim buffer and check that data is intact */
+	xferbuf_trim ( xferbuf );
+	ok ( xferbuf->len == XFERBUF_TEST_LEN );
+	ok ( xferbuf->capacity == XFERBUF_TEST_LEN );
+	intact = 1;
+	for ( offset = 0 ; offset < XFERBUF_TEST_LEN ; offset++ ) {
+		if ( ( ( uint8_t * ) xferbuf->data )[offset] !=
+		     xferbuf_test_byte ( offset ) )
+			intact = 0;
+	}
+	ok ( intact );
+
+	/* Free buffer */
+	xferbuf_free ( xferbuf );
+	ok ( xferbuf->data == NULL );
+	ok ( xferbuf->len == 0 );
+	ok ( xferbuf->capacity == 0 );
+}
+
+/**
+ * Perform data transfer buffer self-tests
+ *
+ */
+static void xferbuf_test_exec ( void ) {
+	struct xfer_buffer xferbuf;
+	uint8_t fixed[16];
+	uint8_t data[8];
+
+	/* Check growth of malloc()-based buffer */
+	memset ( &xferbuf, 0, sizeof ( xferbuf ) );
+	xferbuf_malloc_init ( &xferbuf );
+	xferbuf_grow_test ( &xferbuf );
+
+	/* Check growth of umalloc()-based buffer */
+	memset ( &xferbuf, 0, sizeof ( xferbuf ) );
+	xferbuf_umalloc_init ( &xferbuf );
+	xferbuf_grow_test ( &xferbuf );
+
+	/* Check fixed-size buffer does not grow */
+	memset ( data, 0xa5, sizeof ( data ) );
+	memset ( &xferbuf, 0, sizeof ( xferbuf ) );
+	xferbuf_fixed_init ( &xferbuf, fixed, sizeof ( fixed ) );
+	ok ( xferbuf.capacity == sizeof ( fixed ) );
+	ok ( xferbuf_write ( &xferbuf, 8, data, sizeof ( data ) ) == 0 );
+	ok ( xferbuf.len == sizeof ( fixed ) );
+	ok ( xferbuf_write ( &xferbuf, 9, data, sizeof ( data ) ) != 0 );
+	ok ( xferbuf.max == ( 9 + sizeof ( data ) ) );
+	xferbuf_trim ( &xferbuf );
+	ok ( xferbuf.capacity == sizeof ( fixed ) );
+}
+
+/** Data transfer buffer self-test */
+struct self_test xferbuf_test __self_test = {
+	.name = "xferbuf",
+	.exec = xferbuf_test_exec,
+};
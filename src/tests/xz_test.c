@@ -0,0 +1,551 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+/** @file
+ *
+ * xz image tests
+ *
+ */
+
+/* Forcibly enable assertions */
+#undef NDEBUG
+
+#include <stdint.h>
+#include <string.h>
+#include <ipxe/image.h>
+#include <ipxe/xz.h>
+#include <ipxe/test.h>
+
+/** An xz test */
+struct xz_test {
+	/** Compressed filename */
+	const char *compressed_name;
+	/** Compressed data */
+	const void *compressed;
+	/** Length of compressed data */
+	size_t compressed_len;
+	/** Expected uncompressed name */
+	const char *expected_name;
+	/** Expected uncompressed data */
+	const void *expected;
+	/** Length of expected uncompressed data */
+	size_t expected_len;
+};
+
+/** Define inline data */
+#define DATA(...) { __VA_ARGS__ }
+
+/** Define an xz test */
+#define XZ( name, COMPRESSED, EXPECTED )				\
+	static const uint8_t name ## _compressed[] = COMPRESSED;	\
+	static const uint8_t name ## _expected[] = EXPECTED;		\
+	static struct xz_test name = {					\
+		.compressed_name = #name ".xz",				\
+		.compressed = name ## _compressed,			\
+		.compressed_len = sizeof ( name ## _compressed ),	\
+		.expected_name = #name,					\
+		.expected = name ## _expected,				\
+		.expected_len = sizeof ( name ## _expected ),		\
+		};
+
+/** Length of generated text */
+#define XZ_TEST_TEXT_LEN 4000
+
+/** "Hello world" with CRC-64 check */
+XZ ( hello_crc64,
+     DATA ( 0xfd, 0x37, 0x7a, 0x58, 0x5a, 0x00, 0x00, 0x04, 0xe6, 0xd6,
+	    0xb4, 0x46, 0x04, 0xc0, 0x0f, 0x0b, 0x21, 0x01, 0x16, 0x00,
+	    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xb9, 0x3e,
+	    0x01, 0x65, 0x01, 0x00, 0x0a, 0x48, 0x65, 0x6c, 0x6c, 0x6f,
+	    0x20, 0x77, 0x6f, 0x72, 0x6c, 0x64, 0x00, 0x00, 0xbf, 0x56,
+	    0x77, 0xd4, 0xb9, 0xf2, 0xa5, 0xf4, 0x00, 0x01, 0x2b, 0x0b,
+	    0xca, 0x91, 0x24, 0xc1, 0x1f, 0xb6, 0xf3, 0x7d, 0x01, 0x00,
+	    0x00, 0x00, 0x00, 0x04, 0x59, 0x5a ),
+     DATA ( 0x48, 0x65, 0x6c, 0x6c, 0x6f, 0x20, 0x77, 0x6f, 0x72, 0x6c,
+	    0x64 ) );
+
+/** "Hello world" with CRC-32 check */
+XZ ( hello_crc32,
+     DATA ( 0xfd, 0x37, 0x7a, 0x58, 0x5a, 0x00, 0x00, 0x01, 0x69, 0x22,
+	    0xde, 0x36, 0x04, 0xc0, 0x0f, 0x0b, 0x21, 0x01, 0x16, 0x00,
+	    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xb9, 0x3e,
+	    0x01, 0x65, 0x01, 0x00, 0x0a, 0x48, 0x65, 0x6c, 0x6c, 0x6f,
+	    0x20, 0x77, 0x6f, 0x72, 0x6c, 0x64, 0x00, 0x00, 0x52, 0x9e,
+	    0xd6, 0x8b, 0x00, 0x01, 0x27, 0x0b, 0xc6, 0xde, 0x91, 0x6d,
+	    0x90, 0x42, 0x99, 0x0d, 0x01, 0x00, 0x00, 0x00, 0x00, 0x01,
+	    0x59, 0x5a ),
+     DATA ( 0x48, 0x65, 0x6c, 0x6c, 0x6f, 0x20, 0x77, 0x6f, 0x72, 0x6c,
+	    0x64 ) );
+
+/** "Hello world" with no check */
+XZ ( hello_none,
+     DATA ( 0xfd, 0x37, 0x7a, 0x58, 0x5a, 0x00, 0x00, 0x00, 0xff, 0x12,
+	    0xd9, 0x41, 0x04, 0xc0, 0x0f, 0x0b, 0x21, 0x01, 0x16, 0x00,
+	    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xb9, 0x3e,
+	    0x01, 0x65, 0x01, 0x00, 0x0a, 0x48, 0x65, 0x6c, 0x6c, 0x6f,
+	    0x20, 0x77, 0x6f, 0x72, 0x6c, 0x64, 0x00, 0x00, 0x00, 0x01,
+	    0x23, 0x0b, 0xc2, 0x1b, 0xfd, 0x09, 0x06, 0x72, 0x9e, 0x7a,
+	    0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x59, 0x5a ),
+     DATA ( 0x48, 0x65, 0x6c, 0x6c, 0x6f, 0x20, 0x77, 0x6f, 0x72, 0x6c,
+	    0x64 ) );
+
+/** "Hello world" with SHA-256 check */
+XZ ( hello_sha256,
+     DATA ( 0xfd, 0x37, 0x7a, 0x58, 0x5a, 0x00, 0x00, 0x0a, 0xe1, 0xfb,
+	    0x0c, 0xa1, 0x04, 0xc0, 0x0f, 0x0b, 0x21, 0x01, 0x16, 0x00,
+	    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xb9, 0x3e,
+	    0x01, 0x65, 0x01, 0x00, 0x0a, 0x48, 0x65, 0x6c, 0x6c, 0x6f,
+	    0x20, 0x77, 0x6f, 0x72, 0x6c, 0x64, 0x00, 0x00, 0x64, 0xec,
+	    0x88, 0xca, 0x00, 0xb2, 0x68, 0xe5, 0xba, 0x1a, 0x35, 0x67,
+	    0x8a, 0x1b, 0x53, 0x16, 0xd2, 0x12, 0xf4, 0xf3, 0x66, 0xb2,
+	    0x47, 0x72, 0x32, 0x53, 0x4a, 0x8a, 0xec, 0xa3, 0x7f, 0x3c,
+	    0x00, 0x01, 0x43, 0x0b, 0x65, 0x70, 0x00, 0x6c, 0x18, 0x9b,
+	    0x4b, 0x9a, 0x01, 0x00, 0x00, 0x00, 0x00, 0x0a, 0x59, 0x5a ),
+     DATA ( 0x48, 0x65, 0x6c, 0x6c, 0x6f, 0x20, 0x77, 0x6f, 0x72, 0x6c,
+	    0x64 ) );
+
+/** "Hello world" with corrupted data */
+XZ ( hello_corrupt,
+     DATA ( 0xfd, 0x37, 0x7a, 0x58, 0x5a, 0x00, 0x00, 0x04, 0xe6, 0xd6,
+	    0xb4, 0x46, 0x04, 0xc0, 0x0f, 0x0b, 0x21, 0x01, 0x16, 0x00,
+	    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xb9, 0x3e,
+	    0x01, 0x65, 0x01, 0x00, 0x0a, 0x4a, 0x65, 0x6c, 0x6c, 0x6f,
+	    0x20, 0x77, 0x6f, 0x72, 0x6c, 0x64, 0x00, 0x00, 0xbf, 0x56,
+	    0x77, 0xd4, 0xb9, 0xf2, 0xa5, 0xf4, 0x00, 0x01, 0x2b, 0x0b,
+	    0xca, 0x91, 0x24, 0xc1, 0x1f, 0xb6, 0xf3, 0x7d, 0x01, 0x00,
+	    0x00, 0x00, 0x00, 0x04, 0x59, 0x5a ),
+     DATA ( 0x48, 0x65, 0x6c, 0x6c, 0x6f, 0x20, 0x77, 0x6f, 0x72, 0x6c,
+	    0x64 ) );
+
+/** "Hello world" split across padded streams */
+XZ ( hello_streams,
+     DATA ( 0xfd, 0x37, 0x7a, 0x58, 0x5a, 0x00, 0x00, 0x01, 0x69, 0x22,
+	    0xde, 0x36, 0x04, 0xc0, 0x09, 0x05, 0x21, 0x01, 0x16, 0x00,
+	    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xbf, 0x79,
+	    0x25, 0x67, 0x01, 0x00, 0x04, 0x48, 0x65, 0x6c, 0x6c, 0x6f,
+	    0x00, 0x00, 0x00, 0x00, 0x82, 0x89, 0xd1, 0xf7, 0x00, 0x01,
+	    0x21, 0x05, 0x47, 0x54, 0x73, 0xdc, 0x90, 0x42, 0x99, 0x0d,
+	    0x01, 0x00, 0x00, 0x00, 0x00, 0x01, 0x59, 0x5a, 0x00, 0x00,
+	    0x00, 0x00, 0xfd, 0x37, 0x7a, 0x58, 0x5a, 0x00, 0x00, 0x00,
+	    0xff, 0x12, 0xd9, 0x41, 0x04, 0xc0, 0x0a, 0x06, 0x21, 0x01,
+	    0x16, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	    0xaa, 0x30, 0x8e, 0xa6, 0x01, 0x00, 0x05, 0x20, 0x77, 0x6f,
+	    0x72, 0x6c, 0x64, 0x00, 0x00, 0x00, 0x00, 0x01, 0x1e, 0x06,
+	    0xc1, 0x2f, 0xa4, 0x1d, 0x06, 0x72, 0x9e, 0x7a, 0x01, 0x00,
+	    0x00, 0x00, 0x00, 0x00, 0x59, 0x5a, 0x00, 0x00, 0x00, 0x00,
+	    0x00, 0x00, 0x00, 0x00 ),
+     DATA ( 0x48, 0x65, 0x6c, 0x6c, 0x6f, 0x20, 0x77, 0x6f, 0x72, 0x6c,
+	    0x64 ) );
+
+/** Generated text (maximum compression) */
+static const uint8_t text_compressed[] = {
+	0xfd, 0x37, 0x7a, 0x58, 0x5a, 0x00, 0x00, 0x04, 0xe6, 0xd6,
+	0xb4, 0x46, 0x04, 0xc0, 0x86, 0x07, 0xa0, 0x1f, 0x21, 0x01,
+	0x1c, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xc4, 0xf2,
+	0x3c, 0x63, 0xe0, 0x0f, 0x9f, 0x03, 0x7e, 0x5d, 0x00, 0x36,
+	0x18, 0x4b, 0xbc, 0x72, 0x20, 0x91, 0x1c, 0xf1, 0xed, 0x09,
+	0xec, 0x48, 0xa2, 0xa1, 0x0c, 0x74, 0xab, 0xb4, 0x87, 0xac,
+	0x53, 0xa3, 0x00, 0xae, 0x21, 0x2f, 0x5c, 0x85, 0xbd, 0x62,
+	0x46, 0xd2, 0x78, 0xfc, 0xee, 0x3f, 0x60, 0xb4, 0x71, 0x4d,
+	0xf3, 0x43, 0x94, 0x7a, 0x0b, 0x46, 0x02, 0x75, 0x59, 0x83,
+	0x1b, 0x71, 0xeb, 0xd4, 0xbf, 0xae, 0x69, 0xac, 0x2c, 0xce,
+	0x94, 0xaf, 0xc7, 0x33, 0x32, 0xa8, 0x17, 0x0e, 0xa1, 0xe1,
+	0xb1, 0xe2, 0x60, 0x13, 0x75, 0x20, 0xae, 0xf9, 0x40, 0x62,
+	0x87, 0x38, 0x00, 0x82, 0xc2, 0xa1, 0x2d, 0x35, 0xd4, 0xe5,
+	0x65, 0x97, 0x5b, 0x54, 0x2b, 0xf0, 0x64, 0x32, 0xaa, 0xf3,
+	0xc9, 0xdd, 0x94, 0xa4, 0x28, 0xd3, 0xd3, 0xd5, 0xc6, 0x86,
+	0xf5, 0x00, 0x7e, 0x29, 0xa9, 0xbd, 0xbc, 0x64, 0xe4, 0xc3,
+	0x4b, 0xd8, 0x87, 0x6f, 0xfd, 0xbf, 0x98, 0x58, 0x9a, 0x38,
+	0x47, 0x3c, 0x87, 0xd4, 0xd7, 0x0f, 0xbd, 0x26, 0xf8, 0x20,
+	0x77, 0x4d, 0x97, 0x35, 0x5c, 0x0d, 0x41, 0x5c, 0x1d, 0x70,
+	0x90, 0x9b, 0x21, 0x5e, 0x9f, 0x0b, 0x62, 0xee, 0x68, 0x1e,
+	0xbf, 0xd3, 0xbe, 0x05, 0xb8, 0x4f, 0x28, 0x75, 0xd5, 0x01,
+	0x17, 0xb0, 0x90, 0xde, 0x32, 0x51, 0x05, 0x83, 0x68, 0x17,
+	0x08, 0xaa, 0xbf, 0x69, 0xb5, 0xcc, 0x2c, 0x4d, 0x37, 0xfe,
+	0x59, 0xc4, 0xac, 0x7f, 0x9e, 0x2b, 0x43, 0x70, 0x4c, 0x04,
+	0x72, 0xef, 0x06, 0x9c, 0x2c, 0x01, 0xd9, 0xe6, 0x16, 0x89,
+	0x23, 0xac, 0xcc, 0x35, 0x17, 0xe6, 0x82, 0x27, 0xb1, 0x9e,
+	0x60, 0x84, 0x8b, 0xb3, 0xc9, 0x60, 0x3c, 0x78, 0x0f, 0x00,
+	0x5a, 0xd0, 0x14, 0xe4, 0x70, 0xcf, 0x6f, 0xc2, 0xb5, 0x18,
+	0xf8, 0x7e, 0xe8, 0xa9, 0x7c, 0x25, 0x7d, 0xa8, 0xca, 0xcc,
+	0xf0, 0x97, 0x68, 0x6e, 0x21, 0xe4, 0x10, 0x15, 0x3a, 0xd7,
+	0xdd, 0x1f, 0x21, 0x4d, 0x1d, 0x95, 0x25, 0x1d, 0xbc, 0x78,
+	0xf8, 0x1e, 0x5d, 0x75, 0x74, 0x73, 0x60, 0x7f, 0x40, 0x91,
+	0xa5, 0x25, 0xaf, 0xc6, 0x01, 0x67, 0x5e, 0x0a, 0x25, 0xd4,
+	0x4c, 0x21, 0xf0, 0xd1, 0xb6, 0x62, 0xc8, 0x39, 0xad, 0x3f,
+	0x7e, 0xac, 0xe7, 0x50, 0x77, 0x7a, 0x8e, 0xb0, 0x68, 0x3f,
+	0x16, 0x65, 0x7c, 0x1b, 0xc9, 0x63, 0x20, 0xcf, 0x95, 0x61,
+	0x18, 0xde, 0x6b, 0x0b, 0xde, 0xe9, 0x20, 0xd4, 0xaa, 0x41,
+	0xe0, 0xf3, 0x2a, 0x2b, 0xdd, 0x3f, 0x43, 0x7e, 0x66, 0xce,
+	0xac, 0xc4, 0xa9, 0x04, 0x9c, 0x22, 0x7e, 0x8a, 0x58, 0xca,
+	0x24, 0xa1, 0xbd, 0x21, 0x5d, 0xd7, 0x6f, 0xe0, 0x3d, 0x56,
+	0xca, 0x25, 0xbe, 0x9b, 0x96, 0xbb, 0x15, 0xd2, 0xa9, 0x3a,
+	0x0c, 0xf0, 0x9a, 0x34, 0xc3, 0x11, 0x6f, 0x5e, 0x22, 0x0e,
+	0xcc, 0x55, 0xff, 0x3c, 0x7f, 0xf3, 0xd6, 0xe8, 0x5c, 0x8f,
+	0xe1, 0x82, 0x35, 0x36, 0xfe, 0x66, 0xfd, 0xfc, 0x94, 0xd5,
+	0x40, 0x1c, 0x4c, 0x31, 0xf3, 0xcc, 0xa0, 0xc6, 0x35, 0x70,
+	0x1a, 0xf9, 0x15, 0x05, 0x9f, 0x40, 0x88, 0x52, 0x5a, 0xb2,
+	0x7d, 0x92, 0x52, 0x3f, 0x6e, 0x04, 0x1a, 0x0a, 0xb7, 0x12,
+	0x01, 0x84, 0xa9, 0x4b, 0x04, 0xc1, 0x95, 0x72, 0x93, 0x8a,
+	0x35, 0xa0, 0x0e, 0xf5, 0x25, 0xa4, 0xc6, 0x38, 0x7a, 0xe0,
+	0xb1, 0x73, 0x1b, 0x20, 0x33, 0x03, 0x3a, 0x2f, 0xdd, 0xbc,
+	0xf9, 0xf1, 0x9b, 0x65, 0x55, 0xf8, 0xb9, 0x83, 0x83, 0x40,
+	0x86, 0xfa, 0x5e, 0xeb, 0x4b, 0xfc, 0xf1, 0x45, 0x87, 0x1b,
+	0x04, 0xcb, 0x77, 0xea, 0x14, 0xd0, 0x59, 0xfb, 0xca, 0x91,
+	0x0a, 0x31, 0x30, 0xff, 0x8c, 0x8e, 0xd2, 0x62, 0xdb, 0xb2,
+	0x27, 0x17, 0x90, 0x25, 0x72, 0x8d, 0xc3, 0x44, 0xd5, 0xe4,
+	0x7d, 0x64, 0xe3, 0x62, 0xf5, 0x2b, 0xea, 0x85, 0x79, 0x4c,
+	0x27, 0xd4, 0xe6, 0x93, 0x83, 0xbf, 0x9f, 0x7d, 0x50, 0xcc,
+	0xb4, 0x9f, 0xe8, 0x2a, 0xd8, 0x87, 0xdb, 0x19, 0x63, 0x57,
+	0x09, 0x98, 0xeb, 0x34, 0xb5, 0xfb, 0xdf, 0x9c, 0x2c, 0x05,
+	0xeb, 0x46, 0xd6, 0xb9, 0x60, 0x0c, 0xaa, 0x65, 0x2e, 0x70,
+	0x7d, 0x2b, 0x58, 0x0f, 0x6c, 0x27, 0x6b, 0x5a, 0xed, 0xd3,
+	0x24, 0xd6, 0x36, 0x1d, 0x82, 0x37, 0xc0, 0x02, 0xac, 0x44,
+	0xe1, 0x64, 0x63, 0xfb, 0xc0, 0x40, 0x7e, 0x3f, 0x41, 0xbb,
+	0x9c, 0xa2, 0x8a, 0x3c, 0x67, 0xc0, 0x39, 0x6d, 0x86, 0x37,
+	0x28, 0x48, 0x6a, 0x30, 0xb5, 0x93, 0x42, 0xd0, 0xc4, 0x19,
+	0xda, 0x04, 0x63, 0x66, 0xef, 0x92, 0xad, 0xe0, 0xbb, 0x9d,
+	0x33, 0xf0, 0xf4, 0x89, 0x1a, 0xc5, 0xa6, 0xb3, 0x92, 0x8d,
+	0xe2, 0xb7, 0xb9, 0x00, 0x25, 0x04, 0x6d, 0xd9, 0xd1, 0x46,
+	0x08, 0x14, 0xba, 0x76, 0x32, 0xfa, 0x23, 0x14, 0xb7, 0xcd,
+	0x5d, 0x19, 0xa5, 0xfd, 0x1f, 0x26, 0x1b, 0xae, 0x36, 0xbc,
+	0xc9, 0x7b, 0x6a, 0xb0, 0xd7, 0xc9, 0x20, 0x19, 0xa4, 0x5a,
+	0x33, 0xcf, 0x8e, 0xde, 0xc9, 0x14, 0xd4, 0x70, 0x7e, 0x1b,
+	0x32, 0x22, 0x48, 0xb2, 0xf8, 0xcf, 0x6e, 0x80, 0x1b, 0xf5,
+	0x16, 0x44, 0x95, 0x2b, 0x24, 0xf8, 0x03, 0xfd, 0xc0, 0x44,
+	0xe5, 0xd5, 0x05, 0xe8, 0x08, 0x2a, 0x94, 0xca, 0x25, 0x6e,
+	0x82, 0x90, 0x89, 0x14, 0xa1, 0xb5, 0xd8, 0xc1, 0x7a, 0x4d,
+	0xba, 0x37, 0x3b, 0xae, 0xc8, 0x7a, 0xc3, 0x80, 0x31, 0x1f,
+	0xb1, 0xc2, 0x49, 0x6f, 0x80, 0xe6, 0x41, 0x26, 0x1a, 0xcd,
+	0x84, 0x96, 0x67, 0xe0, 0xcc, 0x49, 0x3d, 0x2c, 0x05, 0x5d,
+	0x2c, 0xad, 0xc6, 0xe7, 0xde, 0xb2, 0x32, 0xf1, 0xa8, 0x51,
+	0x93, 0x74, 0x00, 0x4d, 0xd9, 0xbb, 0x90, 0xee, 0x84, 0xb6,
+	0x24, 0x8b, 0xfc, 0x92, 0xb4, 0x2e, 0xde, 0x2b, 0x54, 0x73,
+	0x24, 0x22, 0xc4, 0xb7, 0x92, 0x1b, 0x86, 0xfa, 0xc7, 0x90,
+	0x73, 0xc7, 0x44, 0x4d, 0xb6, 0x03, 0x0e, 0x53, 0xc8, 0x5f,
+	0xd8, 0x3c, 0x5e, 0xb4, 0x73, 0x86, 0xda, 0x10, 0x81, 0xbd,
+	0x82, 0x62, 0x19, 0xa9, 0xb2, 0xbb, 0x79, 0x5b, 0x93, 0x81,
+	0xcf, 0x05, 0xc7, 0x57, 0x2a, 0xd3, 0xdf, 0x12, 0x99, 0xce,
+	0x2e, 0xfb, 0x27, 0x4c, 0x02, 0x8a, 0xec, 0x5f, 0xd8, 0x22,
+	0xc9, 0x8a, 0x72, 0xff, 0x44, 0xc4, 0xeb, 0xff, 0xfe, 0x9a,
+	0xb8, 0x28, 0x58, 0x49, 0x62, 0x04, 0xb0, 0x8e, 0xe3, 0x6a,
+	0xc1, 0x84, 0xbf, 0xec, 0x3b, 0xb5, 0x07, 0x60, 0x03, 0x15,
+	0x3e, 0xc5, 0xb4, 0x7e, 0x0f, 0x02, 0xeb, 0x96, 0xd4, 0x31,
+	0x21, 0x9a, 0x08, 0x9f, 0xdd, 0xb6, 0xeb, 0x7a, 0x44, 0x0e,
+	0xd1, 0xfa, 0xf2, 0x00, 0x00, 0x00, 0xad, 0x7f, 0x90, 0x0c,
+	0x66, 0x8a, 0xc3, 0x31, 0x00, 0x01, 0xa2, 0x07, 0xa0, 0x1f,
+	0x00, 0x00, 0x60, 0x45, 0xb0, 0x7f, 0xb1, 0xc4, 0x67, 0xfb,
+	0x02, 0x00, 0x00, 0x00, 0x00, 0x04, 0x59, 0x5a
+};
+
+/** Generated text (fast compression, multiple blocks) */
+static const uint8_t text_blocks_compressed[] = {
+	0xfd, 0x37, 0x7a, 0x58, 0x5a, 0x00, 0x00, 0x04, 0xe6, 0xd6,
+	0xb4, 0x46, 0x03, 0xc0, 0xcc, 0x03, 0xdc, 0x0b, 0x21, 0x01,
+	0x0c, 0x00, 0x00, 0x00, 0x37, 0x9d, 0x1f, 0x1e, 0xe0, 0x05,
+	0xdb, 0x01, 0xc4, 0x5d, 0x00, 0x36, 0x18, 0x4b, 0xbc, 0x72,
+	0x20, 0x91, 0x1c, 0xf1, 0xed, 0x09, 0xec, 0x48, 0xa2, 0xa1,
+	0x0c, 0x74, 0xab, 0xb4, 0x87, 0xac, 0x53, 0xa3, 0x00, 0xae,
+	0x21, 0x2f, 0x5c, 0x85, 0xbd, 0x62, 0x46, 0xd2, 0x78, 0xfc,
+	0xd8, 0xa5, 0x5e, 0x38, 0xe8, 0x82, 0x45, 0x6e, 0xa8, 0xc0,
+	0x26, 0x61, 0x9c, 0xff, 0x58, 0xfa, 0x43, 0xbb, 0xaf, 0x43,
+	0x82, 0x1d, 0x69, 0x32, 0xdf, 0xbd, 0x30, 0x83, 0xb5, 0x69,
+	0xba, 0x71, 0x2a, 0x83, 0x57, 0x87, 0xbc, 0x2e, 0x7a, 0x5b,
+	0xe6, 0x83, 0xf3, 0xa5, 0x31, 0x77, 0xaf, 0x4a, 0x42, 0x87,
+	0xfa, 0xc3, 0x67, 0xe8, 0xd7, 0x9f, 0x07, 0x7b, 0x55, 0x87,
+	0x66, 0x59, 0x19, 0x81, 0xe9, 0x16, 0xd5, 0x01, 0x69, 0xae,
+	0xb3, 0xd4, 0xaf, 0xc0, 0x0b, 0x7d, 0xd4, 0xa7, 0xa2, 0x0e,
+	0x0c, 0xc3, 0x11, 0x04, 0xe0, 0xdd, 0xbe, 0xb7, 0x29, 0x4b,
+	0x94, 0x50, 0x95, 0xcb, 0xfa, 0x18, 0x3b, 0x32, 0x3c, 0x17,
+	0x83, 0xc0, 0xaa, 0x68, 0x94, 0x9e, 0xb1, 0x7a, 0x7f, 0xec,
+	0xf9, 0xb6, 0xdb, 0x5e, 0x1f, 0xf4, 0xdb, 0xa8, 0x65, 0x5b,
+	0x74, 0x34, 0xa9, 0x65, 0xc8, 0x52, 0x5d, 0x54, 0xf3, 0xe7,
+	0x5d, 0xee, 0xa0, 0x53, 0x9f, 0xfa, 0x97, 0xc4, 0x6c, 0x37,
+	0x4a, 0x3f, 0x96, 0x76, 0x48, 0x94, 0x40, 0x83, 0x87, 0xda,
+	0x71, 0x47, 0x30, 0x9f, 0x97, 0xb7, 0x04, 0xc6, 0xee, 0x80,
+	0x9d, 0x01, 0xb1, 0xb4, 0x3b, 0x39, 0xb4, 0x9e, 0xf1, 0x5f,
+	0x54, 0xce, 0xa1, 0xa5, 0xb1, 0x0d, 0x9b, 0xeb, 0x54, 0x63,
+	0xbe, 0x5f, 0xd3, 0x85, 0xba, 0x7a, 0xb6, 0xf3, 0xbe, 0x69,
+	0x58, 0x93, 0x62, 0xa3, 0xc4, 0x5b, 0x76, 0xb3, 0x46, 0xec,
+	0x24, 0x0e, 0x6f, 0x41, 0xba, 0x45, 0x14, 0xa6, 0x8d, 0xc3,
+	0x47, 0x1e, 0x17, 0xb0, 0xcc, 0x64, 0xa8, 0x72, 0xdb, 0x79,
+	0x14, 0xe8, 0x57, 0x66, 0x86, 0x85, 0x49, 0xf7, 0x3e, 0xed,
+	0x54, 0x8d, 0xd3, 0xa2, 0x32, 0x92, 0x3f, 0x61, 0xe6, 0xd4,
+	0x1c, 0xe5, 0xeb, 0xa0, 0xdf, 0x6c, 0xce, 0xdb, 0x59, 0x4f,
+	0x37, 0xc4, 0xc9, 0x69, 0x25, 0xf8, 0x17, 0xce, 0x70, 0x72,
+	0x0d, 0x72, 0xa7, 0x81, 0xbc, 0x63, 0x77, 0x5d, 0x23, 0x65,
+	0xa8, 0xbc, 0x6a, 0xe2, 0x65, 0x0e, 0xa7, 0x69, 0x0d, 0x17,
+	0x41, 0xdf, 0x69, 0x2a, 0xe8, 0x8a, 0xd3, 0xfe, 0x38, 0xd8,
+	0x95, 0x53, 0xe9, 0x5e, 0x14, 0x95, 0x3e, 0xd4, 0x2a, 0x9a,
+	0x3a, 0xbb, 0xfb, 0xe5, 0xa3, 0xe2, 0x25, 0x24, 0xae, 0x08,
+	0x1f, 0x62, 0xaf, 0x7f, 0xdf, 0x1e, 0xa3, 0xb8, 0xf9, 0xbf,
+	0x90, 0xdb, 0x79, 0x4a, 0x98, 0xac, 0x1d, 0x55, 0x64, 0x1b,
+	0xdb, 0x47, 0xa5, 0x37, 0xd7, 0x32, 0xfb, 0xff, 0x0c, 0xe7,
+	0xe6, 0xa5, 0xd7, 0x47, 0xab, 0xb5, 0x0d, 0xeb, 0x18, 0x3c,
+	0x4f, 0xa0, 0x1d, 0xed, 0x0e, 0xcf, 0x60, 0xe2, 0xa4, 0x43,
+	0xde, 0x1e, 0xd1, 0xbb, 0xf8, 0x8e, 0x41, 0x56, 0x08, 0x02,
+	0x93, 0xb0, 0x09, 0x68, 0x08, 0xdd, 0x83, 0x12, 0xb7, 0xe2,
+	0xb5, 0x54, 0x23, 0xdb, 0x52, 0xed, 0x88, 0xa0, 0x9c, 0xe3,
+	0x89, 0x96, 0xbd, 0x40, 0x6a, 0x5c, 0x21, 0xeb, 0x03, 0xac,
+	0x8d, 0xe7, 0x64, 0xb3, 0x75, 0x2f, 0xdf, 0x87, 0x36, 0xc8,
+	0xb0, 0xc0, 0x10, 0xa8, 0x85, 0xbc, 0x00, 0x00, 0xdc, 0xc2,
+	0xcd, 0xf0, 0xa6, 0xa6, 0x99, 0x66, 0x03, 0xc0, 0xc9, 0x03,
+	0xdc, 0x0b, 0x21, 0x01, 0x0c, 0x00, 0x00, 0x00, 0x73, 0x56,
+	0x36, 0xf8, 0xe0, 0x05, 0xdb, 0x01, 0xc1, 0x5d, 0x00, 0x3b,
+	0x98, 0x4a, 0xaa, 0xed, 0x15, 0x30, 0x87, 0x27, 0x8f, 0x0c,
+	0x82, 0x79, 0xad, 0xef, 0xf8, 0x62, 0xd0, 0x20, 0x9d, 0xdb,
+	0xbb, 0xde, 0xde, 0x5b, 0x4e, 0xce, 0x43, 0x63, 0x23, 0x53,
+	0x47, 0xc9, 0x3a, 0x0d, 0xc2, 0x84, 0xf5, 0xae, 0x86, 0x1d,
+	0x4b, 0x73, 0x18, 0x76, 0xcb, 0xb9, 0xa2, 0xe1, 0x48, 0xff,
+	0x67, 0xcf, 0xea, 0xca, 0xa9, 0x18, 0xba, 0x6a, 0xe6, 0x58,
+	0xdd, 0x95, 0x34, 0x2b, 0x10, 0xb4, 0x35, 0xea, 0x48, 0x58,
+	0x15, 0xf1, 0x3b, 0x82, 0xde, 0x6b, 0x7f, 0xf0, 0x04, 0x7a,
+	0x11, 0xab, 0x6f, 0x81, 0xdc, 0x1d, 0xbe, 0x28, 0x02, 0x01,
+	0xbd, 0xda, 0x06, 0x72, 0x71, 0xac, 0xf8, 0x5f, 0x52, 0x28,
+	0xcd, 0x17, 0xce, 0x78, 0xe0, 0xcc, 0x34, 0x99, 0xa0, 0x82,
+	0x2a, 0x87, 0xd8, 0x7f, 0xcb, 0x00, 0x3e, 0xad, 0x1e, 0xc5,
+	0xa7, 0x39, 0x97, 0x06, 0xf2, 0x4e, 0xb2, 0x8c, 0x42, 0x41,
+	0x3a, 0x93, 0x06, 0x5e, 0x93, 0xec, 0x45, 0xcc, 0xd1, 0x77,
+	0xc8, 0xd7, 0x7a, 0xf6, 0x18, 0x71, 0x4c, 0xbc, 0xb1, 0xc1,
+	0x63, 0x6d, 0x09, 0x75, 0xa9, 0x37, 0x43, 0x1b, 0xd2, 0xce,
+	0x0c, 0x16, 0x1c, 0xd3, 0x28, 0x0e, 0x2d, 0x3a, 0x4e, 0xc9,
+	0xb9, 0x58, 0xd2, 0x37, 0xfe, 0x34, 0x9b, 0x63, 0x8b, 0xd1,
+	0xc9, 0xc8, 0x88, 0x79, 0x81, 0xa2, 0x18, 0x8f, 0x69, 0x51,
+	0xd8, 0xca, 0x93, 0x3b, 0x0a, 0x13, 0xff, 0xf6, 0xab, 0xec,
+	0x07, 0x0a, 0xd9, 0x06, 0x6c, 0x2d, 0x96, 0x56, 0xeb, 0xff,
+	0x60, 0x61, 0xf9, 0xcc, 0xab, 0x97, 0xc2, 0x8e, 0x20, 0x09,
+	0x31, 0xe6, 0x1f, 0xac, 0x97, 0x81, 0xae, 0x53, 0x5d, 0x7d,
+	0x52, 0x5e, 0x26, 0x3a, 0xe5, 0xec, 0x14, 0x05, 0x6a, 0x0e,
+	0xea, 0xba, 0x29, 0x5e, 0x16, 0x3b, 0x2b, 0x5b, 0x3d, 0xc3,
+	0x8d, 0xde, 0xf3, 0x7e, 0x8a, 0x2d, 0xf6, 0x65, 0x60, 0x98,
+	0xfb, 0x10, 0xf6, 0xed, 0x82, 0x74, 0xa4, 0x80, 0x7c, 0xce,
+	0x9e, 0x41, 0xf9, 0xdd, 0xad, 0x92, 0x59, 0xa8, 0xf5, 0x8f,
+	0xe4, 0x67, 0xc1, 0xe7, 0x88, 0x33, 0x4f, 0xb8, 0x47, 0x2b,
+	0xf3, 0x98, 0x83, 0x37, 0x16, 0xb9, 0x46, 0x1a, 0xba, 0x9d,
+	0x30, 0xa7, 0xdb, 0xe6, 0xc9, 0x6a, 0xc9, 0xbd, 0x7b, 0xa7,
+	0x3c, 0x56, 0x81, 0x72, 0x7b, 0xe1, 0xd8, 0xba, 0x29, 0x73,
+	0x17, 0x63, 0x67, 0xeb, 0x30, 0x65, 0xde, 0xcd, 0x33, 0x0e,
+	0xfa, 0x10, 0x0a, 0xc4, 0xe6, 0xf3, 0xd8, 0x93, 0x2b, 0xd7,
+	0xad, 0x6a, 0x8f, 0xbd, 0xf4, 0x75, 0x2d, 0x4f, 0xc7, 0x42,
+	0xaa, 0xef, 0x6b, 0x07, 0x12, 0x87, 0xd9, 0xd1, 0xe0, 0xc3,
+	0x98, 0x0b, 0x9d, 0x68, 0x07, 0x96, 0x51, 0xec, 0xab, 0x32,
+	0x4d, 0x7e, 0x90, 0x6d, 0x9f, 0x1d, 0x64, 0x73, 0xd3, 0x75,
+	0x7c, 0xee, 0xf7, 0x0d, 0xb6, 0x07, 0xb5, 0x7b, 0x11, 0x8b,
+	0x21, 0x23, 0x29, 0x3e, 0xe3, 0xfc, 0x5d, 0x79, 0xb8, 0x28,
+	0x0a, 0x3d, 0x85, 0x9c, 0xde, 0x17, 0x5b, 0x7e, 0x12, 0x7b,
+	0x44, 0x07, 0x85, 0x4d, 0x32, 0xf8, 0x79, 0xbd, 0xa1, 0xc7,
+	0xf3, 0x2c, 0x6e, 0x91, 0x50, 0x11, 0x28, 0xb7, 0xdb, 0xdc,
+	0xe3, 0x60, 0x6c, 0xa8, 0x9b, 0xa3, 0xae, 0x84, 0x4b, 0x5e,
+	0x01, 0x17, 0x60, 0x11, 0xc7, 0x3c, 0x06, 0xcc, 0x00, 0x00,
+	0x00, 0x00, 0xe6, 0xc7, 0x9a, 0x2d, 0xbf, 0xe9, 0x34, 0x11,
+	0x03, 0xc0, 0xc6, 0x02, 0xe8, 0x07, 0x21, 0x01, 0x0c, 0x00,
+	0x00, 0x00, 0x4e, 0x2e, 0x61, 0xd8, 0xe0, 0x03, 0xe7, 0x01,
+	0x3e, 0x5d, 0x00, 0x3a, 0x08, 0x08, 0xc7, 0x34, 0x5e, 0x74,
+	0x14, 0x7b, 0x46, 0x0c, 0x14, 0x78, 0x2f, 0x70, 0x28, 0x28,
+	0x72, 0x04, 0xf7, 0xd8, 0xf3, 0x0f, 0x7f, 0x2f, 0xf8, 0x9c,
+	0x16, 0x9f, 0xa3, 0x3d, 0x6e, 0x14, 0xf2, 0x01, 0x45, 0xee,
+	0x94, 0xeb, 0x89, 0x67, 0x8a, 0x70, 0x5f, 0x46, 0xde, 0x5c,
+	0x13, 0xc2, 0x1a, 0x15, 0x99, 0x00, 0xd6, 0xb8, 0xf0, 0x4d,
+	0x52, 0xc2, 0xe7, 0xcb, 0x6d, 0x9f, 0x1f, 0xf2, 0x19, 0x58,
+	0x52, 0xd7, 0xec, 0x0c, 0xda, 0xde, 0x95, 0xb8, 0x7f, 0xaa,
+	0x72, 0x33, 0xfa, 0x96, 0xe9, 0x17, 0xa5, 0x9e, 0x49, 0x01,
+	0x25, 0xf2, 0xc8, 0x50, 0x27, 0x50, 0x25, 0x71, 0xe1, 0xfd,
+	0x04, 0x10, 0x4e, 0x74, 0xef, 0x73, 0x62, 0x1c, 0x78, 0xea,
+	0xd8, 0x6f, 0xc2, 0x66, 0x74, 0x60, 0xf5, 0xc9, 0xc4, 0xa6,
+	0x6d, 0xd1, 0x9c, 0xaa, 0xa8, 0xdf, 0x94, 0x82, 0x62, 0x89,
+	0x5f, 0xb4, 0xb4, 0x16, 0xa8, 0x84, 0x43, 0x23, 0xfc, 0xc9,
+	0x06, 0x39, 0xbc, 0x49, 0x90, 0xc1, 0x9f, 0x04, 0x9e, 0x02,
+	0xe2, 0x6d, 0x5b, 0x9b, 0x5c, 0xe5, 0x69, 0x60, 0x82, 0x40,
+	0x5b, 0xcd, 0xa6, 0xaa, 0xa9, 0x2f, 0x5b, 0xe7, 0x8b, 0xaa,
+	0xa3, 0x97, 0x78, 0xf3, 0xa6, 0xbe, 0x75, 0xed, 0x12, 0x19,
+	0x0a, 0xde, 0x97, 0xa0, 0xad, 0x32, 0x51, 0xbf, 0x33, 0xa1,
+	0x31, 0xb3, 0x85, 0xc2, 0xe6, 0x60, 0xfd, 0x25, 0x36, 0x79,
+	0xc1, 0xfa, 0xbe, 0xe8, 0xe5, 0xe3, 0x23, 0x9e, 0x1f, 0x62,
+	0x47, 0x8b, 0x5e, 0x5f, 0x29, 0xfd, 0x7e, 0x82, 0xf9, 0xc3,
+	0x44, 0xa7, 0xb9, 0xb9, 0x8f, 0x70, 0x01, 0x11, 0x98, 0xa4,
+	0x4c, 0x86, 0x08, 0x04, 0x8c, 0xdd, 0x77, 0x06, 0xcf, 0x02,
+	0x51, 0x5b, 0x8c, 0x77, 0x17, 0x94, 0x1e, 0x98, 0x86, 0xb2,
+	0x72, 0x30, 0x5e, 0x8b, 0xfa, 0xfd, 0xfe, 0x66, 0x52, 0x40,
+	0xc8, 0xbc, 0x32, 0x3f, 0xdb, 0x74, 0x11, 0x4a, 0x92, 0x34,
+	0x4f, 0x73, 0x46, 0x74, 0x58, 0x4d, 0x56, 0x56, 0xf0, 0x06,
+	0x16, 0xad, 0x9d, 0x91, 0xb5, 0xc8, 0x52, 0x27, 0x1b, 0xf9,
+	0xf3, 0xf3, 0xa9, 0x1d, 0xbd, 0x93, 0xd8, 0xaa, 0xd3, 0x3f,
+	0x1c, 0x95, 0x48, 0x6f, 0xf1, 0x3c, 0x79, 0xec, 0xbc, 0x47,
+	0x92, 0x1d, 0xff, 0xe7, 0x45, 0x4b, 0x82, 0xab, 0x93, 0xb0,
+	0x00, 0x00, 0x00, 0x00, 0xc5, 0xe2, 0x19, 0x14, 0xd7, 0x69,
+	0x7f, 0x5f, 0x00, 0x03, 0xe4, 0x03, 0xdc, 0x0b, 0xe1, 0x03,
+	0xdc, 0x0b, 0xde, 0x02, 0xe8, 0x07, 0x00, 0x00, 0x55, 0x61,
+	0xf1, 0xda, 0xac, 0x27, 0x3e, 0x2d, 0x04, 0x00, 0x00, 0x00,
+	0x00, 0x04, 0x59, 0x5a
+};
+
+/** Generated text */
+static uint8_t text_expected[XZ_TEST_TEXT_LEN];
+
+/** Generated text (maximum compression) */
+static struct xz_test text = {
+	.compressed_name = "text.xz",
+	.compressed = text_compressed,
+	.compressed_len = sizeof ( text_compressed ),
+	.expected_name = "text",
+	.expected = text_expected,
+	.expected_len = sizeof ( text_expected ),
+};
+
+/** Generated text (fast compression, multiple blocks) */
+static struct xz_test text_blocks = {
+	.compressed_name = "text_blocks.xz",
+	.compressed = text_blocks_compressed,
+	.compressed_len = sizeof ( text_blocks_compressed ),
+	.expected_name = "text_blocks",
+	.expected = text_expected,
+	.expected_len = sizeof ( text_expected ),
+};
+
+/**
+ * Generate text
+ *
+ * @v data		Buffer to fill in
+ * @v len		Length of buffer
+ */
+static void xz_test_text ( uint8_t *data, size_t len ) {
+	static const char *words[] = {
+		"the", "quick", "brown", "fox", "jumps", "over", "lazy",
+		"dog", "network", "boot", "firmware", "image", "kernel",
+		"initrd", "open", "source",
+	};
+	const char *word;
+	uint32_t state = 1;
+	size_t offset = 0;
+
+	while ( offset < len ) {
+		state = ( ( state * 1103515245UL ) + 12345 );
+		word = words[ ( state >> 16 ) %
+			      ( sizeof ( words ) / sizeof ( words[0] ) ) ];
+		while ( *word && ( offset < len ) )
+			data[offset++] = *(word++);
+		if ( offset < len ) {
+			data[offset++] = ( ( ( state >> 8 ) & 7 ) ?
+					   ' ' : '\n' );
+		}
+	}
+}
+
+/**
+ * Report xz test result
+ *
+ * @v test		xz test
+ * @v file		Test code file
+ * @v line		Test code line
+ */
+static void xz_okx ( struct xz_test *test, const char *file,
+		       unsigned int line ) {
+	struct image *image;
+	struct image *extracted;
+
+	/* Construct compressed image */
+	image = image_memory ( test->compressed_name, test->compressed,
+			       test->compressed_len );
+	okx ( image != NULL, file, line );
+	okx ( image->len == test->compressed_len, file, line );
+
+	/* Check type detection */
+	okx ( image->type == &xz_image_type, file, line );
+
+	/* Extract archive image */
+	okx ( image_extract ( image, NULL, &extracted ) == 0, file, line );
+
+	/* Verify extracted image content */
+	okx ( extracted->len == test->expected_len, file, line );
+	okx ( memcmp ( extracted->data, test->expected,
+		       test->expected_len ) == 0, file, line );
+
+	/* Verify extracted image name */
+	okx ( strcmp ( extracted->name, test->expected_name ) == 0,
+	      file, line );
+
+	/* Unregister images */
+	unregister_image ( extracted );
+	unregister_image ( image );
+}
+#define xz_ok( test ) xz_okx ( test, __FILE__, __LINE__ )
+
+/**
+ * Report xz failure test result
+ *
+ * @v test		xz test
+ * @v len		Length of compressed data to use
+ * @v file		Test code file
+ * @v line		Test code line
+ */
+static void xz_fail_okx ( struct xz_test *test, size_t len,
+			    const char *file, unsigned int line ) {
+	struct image *image;
+	struct image *extracted;
+
+	/* Construct compressed image */
+	image = image_memory ( test->compressed_name, test->compressed, len );
+	okx ( image != NULL, file, line );
+	okx ( image->type == &xz_image_type, file, line );
+
+	/* Check that extraction fails */
+	okx ( image_extract ( image, NULL, &extracted ) != 0, file, line );
+
+	/* Unregister image */
+	unregister_image ( image );
+}
+#define xz_fail_ok( test, len ) \
+	xz_fail_okx ( test, len, __FILE__, __LINE__ )
+
+/**
+ * Perform xz self-test
+ *
+ */
+static void xz_test_exec ( void ) {
+
+	/* Construct generated text */
+	xz_test_text ( text_expected, sizeof ( text_expected ) );
+
+	/* Check successful extraction */
+	xz_ok ( &hello_crc64 );
+	xz_ok ( &hello_crc32 );
+	xz_ok ( &hello_none );
+	xz_ok ( &hello_sha256 );
+	xz_ok ( &hello_streams );
+	xz_ok ( &text );
+	xz_ok ( &text_blocks );
+
+	/* Check failure cases */
+	xz_fail_ok ( &hello_corrupt, hello_corrupt.compressed_len );
+	xz_fail_ok ( &hello_crc64, ( hello_crc64.compressed_len - 4 ) );
+	xz_fail_ok ( &hello_streams, ( hello_streams.compressed_len - 1 ) );
+	xz_fail_ok ( &text, ( text.compressed_len - 4 ) );
+}
+
+/** xz self-test */
+struct self_test xz_test __self_test = {
+	.name = "xz",
+	.exec = xz_test_exec,
+};
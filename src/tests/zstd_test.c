@@ -0,0 +1,462 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+/** @file
+ *
+ * Zstandard image tests
+ *
+ */
+
+/* Forcibly enable assertions */
+#undef NDEBUG
+
+#include <stdint.h>
+#include <string.h>
+#include <ipxe/image.h>
+#include <ipxe/zstd.h>
+#include <ipxe/test.h>
+
+/** A Zstandard test */
+struct zstd_test {
+	/** Compressed filename */
+	const char *compressed_name;
+	/** Compressed data */
+	const void *compressed;
+	/** Length of compressed data */
+	size_t compressed_len;
+	/** Expected uncompressed name */
+	const char *expected_name;
+	/** Expected uncompressed data */
+	const void *expected;
+	/** Length of expected uncompressed data */
+	size_t expected_len;
+};
+
+/** Define inline data */
+#define DATA(...) { __VA_ARGS__ }
+
+/** Define a Zstandard test */
+#define ZSTD( name, COMPRESSED, EXPECTED )				\
+	static const uint8_t name ## _compressed[] = COMPRESSED;	\
+	static const uint8_t name ## _expected[] = EXPECTED;		\
+	static struct zstd_test name = {				\
+		.compressed_name = #name ".zst",			\
+		.compressed = name ## _compressed,			\
+		.compressed_len = sizeof ( name ## _compressed ),	\
+		.expected_name = #name,					\
+		.expected = name ## _expected,				\
+		.expected_len = sizeof ( name ## _expected ),		\
+	};
+
+/** Length of generated text */
+#define ZSTD_TEST_TEXT_LEN 4000
+
+/** "Hello world" */
+ZSTD ( hello_world,
+       DATA ( 0x28, 0xb5, 0x2f, 0xfd, 0x04, 0x58, 0x59, 0x00, 0x00, 0x48,
+	      0x65, 0x6c, 0x6c, 0x6f, 0x20, 0x77, 0x6f, 0x72, 0x6c, 0x64,
+	      0xd8, 0x76, 0xb3, 0x12 ),
+       DATA ( 0x48, 0x65, 0x6c, 0x6c, 0x6f, 0x20, 0x77, 0x6f, 0x72, 0x6c,
+	      0x64 ) );
+
+/** "Hello world" with frame content size */
+ZSTD ( hello_fcs,
+       DATA ( 0x28, 0xb5, 0x2f, 0xfd, 0x24, 0x0b, 0x59, 0x00, 0x00, 0x48,
+	      0x65, 0x6c, 0x6c, 0x6f, 0x20, 0x77, 0x6f, 0x72, 0x6c, 0x64,
+	      0xd8, 0x76, 0xb3, 0x12 ),
+       DATA ( 0x48, 0x65, 0x6c, 0x6c, 0x6f, 0x20, 0x77, 0x6f, 0x72, 0x6c,
+	      0x64 ) );
+
+/** "Hello world" with corrupted checksum */
+ZSTD ( hello_corrupt,
+       DATA ( 0x28, 0xb5, 0x2f, 0xfd, 0x04, 0x58, 0x59, 0x00, 0x00, 0x48,
+	      0x65, 0x6c, 0x6c, 0x6f, 0x20, 0x77, 0x6f, 0x72, 0x6c, 0x64,
+	      0xd8, 0x76, 0xb3, 0x13 ),
+       DATA ( 0x48, 0x65, 0x6c, 0x6c, 0x6f, 0x20, 0x77, 0x6f, 0x72, 0x6c,
+	      0x64 ) );
+
+/** "Hello world" split across frames */
+ZSTD ( hello_frames,
+       DATA ( 0x28, 0xb5, 0x2f, 0xfd, 0x00, 0x58, 0x29, 0x00, 0x00, 0x48,
+	      0x65, 0x6c, 0x6c, 0x6f, 0x5e, 0x2a, 0x4d, 0x18, 0x04, 0x00,
+	      0x00, 0x00, 0x6a, 0x75, 0x6e, 0x6b, 0x28, 0xb5, 0x2f, 0xfd,
+	      0x04, 0x58, 0x31, 0x00, 0x00, 0x20, 0x77, 0x6f, 0x72, 0x6c,
+	      0x64, 0xa9, 0x33, 0xd5, 0xb4 ),
+       DATA ( 0x48, 0x65, 0x6c, 0x6c, 0x6f, 0x20, 0x77, 0x6f, 0x72, 0x6c,
+	      0x64 ) );
+
+/** Generated text (maximum compression) */
+static const uint8_t text_compressed[] = {
+	0x28, 0xb5, 0x2f, 0xfd, 0x64, 0xa0, 0x0e, 0xb5, 0x1a, 0x00,
+	0x72, 0xc6, 0x13, 0x12, 0x90, 0xcf, 0x01, 0x60, 0x83, 0x0d,
+	0x36, 0xd8, 0x60, 0x2d, 0x00, 0xfe, 0xff, 0x3f, 0xfd, 0xcb,
+	0x01, 0x15, 0xff, 0xff, 0xff, 0xff, 0xfb, 0xcc, 0xff, 0xb1,
+	0xab, 0xbb, 0xae, 0x5c, 0x45, 0x67, 0x67, 0x37, 0xd0, 0x31,
+	0x58, 0x16, 0x51, 0x01, 0xd3, 0x39, 0x71, 0x60, 0x1c, 0x59,
+	0xdd, 0x62, 0x2b, 0xd0, 0x23, 0x52, 0x27, 0x01, 0x89, 0x13,
+	0x35, 0x04, 0xe4, 0x63, 0x34, 0x35, 0xeb, 0xa2, 0x68, 0x13,
+	0x18, 0x02, 0x6a, 0x20, 0x0a, 0xdf, 0xfa, 0x39, 0x80, 0x73,
+	0x58, 0x01, 0x81, 0xae, 0xa8, 0xa1, 0x2f, 0x48, 0xda, 0xdf,
+	0x21, 0x08, 0x02, 0x31, 0x90, 0x46, 0x2d, 0xed, 0x01, 0x21,
+	0x08, 0x8b, 0x78, 0xc4, 0x60, 0x47, 0x4c, 0x25, 0x29, 0x0c,
+	0x07, 0x47, 0x61, 0xc3, 0xf6, 0xc5, 0x71, 0x5c, 0x4d, 0x0c,
+	0x7f, 0xbb, 0x91, 0x79, 0x95, 0x3f, 0x3d, 0xbf, 0x90, 0x23,
+	0x56, 0xf5, 0x9d, 0x2a, 0xe5, 0x29, 0x23, 0x0f, 0xba, 0x80,
+	0xc6, 0xf2, 0x4e, 0x72, 0x3a, 0xc0, 0x75, 0x24, 0x7a, 0xc1,
+	0xf1, 0x10, 0x99, 0x7b, 0x49, 0x18, 0xb1, 0x32, 0x1c, 0x44,
+	0xee, 0x38, 0xaf, 0x37, 0x23, 0xc5, 0x79, 0x69, 0xfb, 0x81,
+	0x5b, 0x4c, 0xbc, 0x76, 0xc9, 0x01, 0x41, 0x3c, 0x98, 0x48,
+	0x5d, 0xc3, 0x3b, 0x96, 0x3a, 0x1d, 0xf1, 0x35, 0xbd, 0x8e,
+	0x51, 0xa9, 0xef, 0x5b, 0xb2, 0x33, 0x24, 0x96, 0xc1, 0x67,
+	0x60, 0x78, 0x03, 0xd7, 0x35, 0x02, 0x18, 0x2d, 0x0d, 0xa2,
+	0xc9, 0xd0, 0xa5, 0x4e, 0x03, 0x2d, 0x15, 0x7a, 0xe9, 0xd6,
+	0x69, 0xc8, 0x73, 0xe4, 0xa7, 0x61, 0x31, 0x6a, 0x95, 0xea,
+	0x3b, 0xe0, 0xd5, 0xfc, 0x7a, 0x64, 0x1a, 0x6b, 0xdb, 0xcb,
+	0x0b, 0x79, 0x2b, 0xc8, 0x0c, 0x2c, 0x0d, 0x0d, 0xb7, 0x65,
+	0x71, 0xc4, 0xcc, 0xa6, 0x43, 0x20, 0xbf, 0x9f, 0x93, 0xb9,
+	0x06, 0x94, 0xe3, 0xf3, 0x2a, 0xcf, 0x13, 0x04, 0xf4, 0x10,
+	0x6e, 0x91, 0x1f, 0x29, 0x93, 0x2e, 0x9a, 0xfd, 0x62, 0xec,
+	0xdd, 0x51, 0xc0, 0xbf, 0xad, 0xa4, 0x8f, 0xfa, 0x19, 0xb7,
+	0xf3, 0x0e, 0x5e, 0xde, 0x3f, 0xd0, 0xda, 0x57, 0x5b, 0x68,
+	0x4b, 0x9b, 0x33, 0x18, 0xab, 0x95, 0x66, 0xf2, 0x4c, 0x2d,
+	0x22, 0x8a, 0x21, 0x4a, 0x2b, 0x25, 0x04, 0x25, 0x78, 0xc2,
+	0x4c, 0x40, 0x7a, 0x2b, 0x8e, 0x86, 0x15, 0x16, 0x42, 0xa3,
+	0x4e, 0xef, 0x15, 0xba, 0xa7, 0x75, 0x4d, 0xea, 0x26, 0x32,
+	0xe9, 0xe3, 0x7a, 0x88, 0x73, 0xc4, 0x1f, 0x30, 0x5d, 0x34,
+	0xb7, 0xfb, 0x6d, 0x0b, 0x59, 0x50, 0x0e, 0x58, 0x4d, 0xfc,
+	0x61, 0x25, 0xcc, 0x17, 0x1e, 0x87, 0xed, 0x52, 0x26, 0x36,
+	0xda, 0x01, 0x1b, 0xf5, 0x91, 0xb7, 0xe8, 0x75, 0x7b, 0x7c,
+	0xa1, 0x27, 0x73, 0x4c, 0x15, 0x56, 0x1a, 0xb1, 0x31, 0xb6,
+	0x70, 0xae, 0x19, 0x10, 0x52, 0xae, 0x2d, 0x8a, 0x8e, 0x77,
+	0xfc, 0x6e, 0xc8, 0x47, 0xcd, 0x40, 0xed, 0x76, 0x8c, 0x21,
+	0xda, 0xee, 0x9c, 0xf6, 0xfd, 0x66, 0x64, 0x94, 0xf6, 0x5f,
+	0xaa, 0xed, 0x59, 0xc0, 0xa7, 0x49, 0x87, 0x33, 0x56, 0x26,
+	0x5b, 0x41, 0xd1, 0x02, 0xed, 0x62, 0xbe, 0x52, 0x8e, 0x00,
+	0x5c, 0x30, 0xe3, 0xad, 0x38, 0xca, 0x90, 0x56, 0x56, 0x16,
+	0x00, 0x06, 0x34, 0x9f, 0x67, 0x0e, 0x5f, 0x1f, 0x3c, 0x2b,
+	0xd0, 0x5f, 0x6a, 0x21, 0xae, 0x14, 0x7f, 0x0f, 0x5d, 0x81,
+	0xf0, 0xbd, 0x91, 0xb9, 0xd7, 0x0c, 0x48, 0x00, 0x21, 0xe7,
+	0xc0, 0x57, 0x47, 0xdd, 0x9b, 0x04, 0x7a, 0xb2, 0x57, 0x73,
+	0x3c, 0xbb, 0xd1, 0x44, 0x09, 0x21, 0x38, 0xa7, 0x27, 0xd0,
+	0x09, 0x32, 0x99, 0x2f, 0xcc, 0xe6, 0xe0, 0xec, 0x72, 0xc1,
+	0x4e, 0x11, 0xec, 0x43, 0x83, 0x31, 0x06, 0x10, 0xfc, 0x45,
+	0x7c, 0xf0, 0x71, 0x99, 0x54, 0x4a, 0xc4, 0x35, 0x68, 0xbf,
+	0x62, 0x4e, 0xf5, 0x36, 0xc6, 0xb5, 0x49, 0x92, 0x09, 0x4e,
+	0xa2, 0x36, 0x61, 0xb0, 0xac, 0x93, 0x0d, 0xb8, 0xd4, 0x42,
+	0xdd, 0x99, 0x47, 0x12, 0x71, 0xc9, 0x19, 0x8f, 0x2f, 0x81,
+	0x63, 0x56, 0xea, 0xfc, 0x1b, 0xd8, 0xd6, 0x97, 0xae, 0xb1,
+	0x22, 0x66, 0x00, 0x8f, 0x66, 0xf8, 0xe8, 0x3d, 0x4d, 0x31,
+	0x80, 0x6a, 0x86, 0xd7, 0x49, 0xca, 0x8a, 0x09, 0x54, 0x14,
+	0xdf, 0xb0, 0x87, 0x2b, 0x43, 0x88, 0x9e, 0x51, 0xf8, 0x1c,
+	0x25, 0x88, 0xc9, 0x26, 0xd0, 0xd3, 0x86, 0x82, 0x8e, 0x0d,
+	0x11, 0xdc, 0x25, 0x4b, 0xaa, 0x11, 0xcf, 0xc1, 0xd7, 0x90,
+	0xba, 0x67, 0x65, 0x61, 0x66, 0x09, 0x14, 0x78, 0x1a, 0x87,
+	0x2b, 0x03, 0x80, 0xb3, 0xdb, 0x22, 0xbf, 0x0d, 0x00, 0x4a,
+	0x00, 0x1b, 0xd3, 0x99, 0x30, 0x21, 0x9c, 0x52, 0xbd, 0x89,
+	0x25, 0xaf, 0x25, 0x6e, 0x31, 0x07, 0xed, 0xc6, 0x3d, 0xd0,
+	0xe5, 0x65, 0xb0, 0xf6, 0x35, 0x23, 0x24, 0x03, 0x8b, 0xfa,
+	0x6b, 0x0a, 0xcb, 0xc7, 0xb4, 0x0a, 0x41, 0x72, 0x67, 0xd6,
+	0x43, 0x12, 0x27, 0x9e, 0x11, 0xcd, 0x1c, 0x2a, 0xc0, 0x47,
+	0x11, 0x4c, 0x81, 0x8b, 0x46, 0xd3, 0x65, 0x66, 0xd7, 0x1a,
+	0x05, 0x4e, 0x41, 0x70, 0x81, 0x13, 0xa5, 0x74, 0x72, 0xe1,
+	0x60, 0xc5, 0x11, 0xd6, 0xf6, 0xd1, 0x84, 0xbc, 0x42, 0x79,
+	0xe2, 0x6f, 0xb8, 0xa8, 0x3d, 0x0d, 0xd9, 0x2d, 0x95, 0xa8,
+	0x95, 0x94, 0xee, 0x77, 0x33, 0x0e, 0x16, 0x97, 0x8f, 0x0c,
+	0x9f, 0x7f, 0x8a, 0xbd, 0x5a, 0x8d, 0x7e, 0x8d, 0x28, 0x64,
+	0x1d, 0x0f, 0x68, 0xb7, 0x24, 0x41, 0xf7, 0xfa, 0xb3, 0xbc,
+	0x2d, 0xa4, 0x4f, 0xa2, 0x08, 0x3d, 0x32, 0xe8, 0xf8, 0x89,
+	0x99, 0x5c, 0x37, 0x83, 0xc3, 0x75, 0xf8, 0xc5, 0xb5, 0x5e,
+	0xe7, 0x7a, 0x63, 0x13, 0x2d, 0x46, 0x6a, 0x22, 0xac, 0x88,
+	0xb1, 0x6b, 0xea, 0x07, 0x8a, 0x6f, 0xda, 0x02, 0x66, 0xd5,
+	0x24, 0x2d, 0xfd, 0x4d, 0x78, 0x51, 0x23, 0x30, 0x00, 0xbc,
+	0x43, 0x27, 0x4f, 0x40, 0x27, 0x1a, 0x63, 0xaa, 0x16, 0xa4,
+	0x8b, 0x00, 0x70, 0x63, 0x29, 0xc3, 0xf0, 0x16, 0x82, 0xcd,
+	0x98, 0x80, 0x4e, 0x9d, 0x34, 0xce, 0x60, 0x3e, 0x48, 0x11,
+	0x05, 0x74, 0x9c, 0x38, 0x8f, 0x52, 0x75, 0x09, 0xf5, 0x37,
+	0xff, 0x98, 0x6c, 0x15, 0xf7, 0xd2, 0xad, 0x31
+};
+
+/** Generated text (fast compression) */
+static const uint8_t text_fast_compressed[] = {
+	0x28, 0xb5, 0x2f, 0xfd, 0x00, 0x48, 0xed, 0x22, 0x00, 0xb6,
+	0xa5, 0x5d, 0x15, 0x90, 0x57, 0x07, 0x44, 0x40, 0x2d, 0x51,
+	0xc8, 0x71, 0x1b, 0xde, 0xb5, 0xc9, 0xfe, 0xcc, 0xcc, 0xcc,
+	0x8c, 0x39, 0x31, 0xcc, 0x59, 0x00, 0x54, 0x00, 0x58, 0x00,
+	0x57, 0xc2, 0xb1, 0x17, 0xf0, 0x16, 0xd7, 0x66, 0x9c, 0x0b,
+	0xfc, 0xd1, 0x78, 0x90, 0x95, 0x02, 0xdf, 0xe8, 0x6d, 0xba,
+	0x4c, 0x0c, 0xc6, 0xea, 0x68, 0xff, 0x45, 0xd1, 0x8d, 0xc6,
+	0x83, 0x2c, 0x45, 0x37, 0x8a, 0x6e, 0x9a, 0x71, 0x2e, 0x19,
+	0x0f, 0xb2, 0xb4, 0xad, 0xbb, 0x0a, 0x80, 0x7a, 0x83, 0x00,
+	0xa8, 0x37, 0x28, 0xba, 0x59, 0xdb, 0x78, 0x05, 0x5d, 0x80,
+	0xdf, 0x09, 0x35, 0xdc, 0xaa, 0x29, 0x8d, 0x07, 0x59, 0x4a,
+	0x38, 0xf6, 0x82, 0x66, 0x9c, 0xcb, 0x22, 0xc2, 0x94, 0x0a,
+	0x80, 0x7a, 0x43, 0xb6, 0x75, 0xd7, 0x78, 0x90, 0x15, 0x5b,
+	0x3c, 0x75, 0x2e, 0x22, 0x4c, 0xa5, 0x5e, 0x44, 0x98, 0x4a,
+	0x01, 0x50, 0x6f, 0x48, 0x74, 0xc3, 0x5b, 0x5c, 0x01, 0xf5,
+	0x86, 0x6c, 0xc6, 0xb9, 0x64, 0x3c, 0xc8, 0xe2, 0x2d, 0x1e,
+	0x0f, 0xb2, 0xe0, 0x8f, 0x36, 0xe3, 0x5c, 0xb4, 0xff, 0x82,
+	0x08, 0x53, 0xf0, 0x27, 0xfb, 0x2f, 0xca, 0x5b, 0x5c, 0x37,
+	0x75, 0xf2, 0x16, 0x4f, 0xad, 0x9b, 0x3a, 0x1e, 0x64, 0x65,
+	0xb6, 0x75, 0x87, 0x3f, 0xfd, 0x17, 0xed, 0xbf, 0x24, 0xfc,
+	0xc9, 0xfe, 0x8b, 0x36, 0xe3, 0x5c, 0x78, 0x8b, 0x67, 0x5b,
+	0x77, 0xde, 0x22, 0x02, 0xa0, 0xde, 0x00, 0x7f, 0x04, 0x40,
+	0xbd, 0x41, 0xe3, 0x41, 0x56, 0x5b, 0xf7, 0x78, 0x90, 0x85,
+	0x6e, 0x10, 0x61, 0x0a, 0xfe, 0xc0, 0x1f, 0x85, 0x3f, 0x0a,
+	0x7f, 0x52, 0xf3, 0x16, 0x57, 0x74, 0x93, 0xf1, 0x20, 0x0b,
+	0xfe, 0x10, 0x8e, 0xbd, 0x40, 0xfb, 0x47, 0x84, 0x21, 0xc2,
+	0x14, 0xba, 0xc9, 0x44, 0x84, 0xa9, 0xb6, 0xee, 0xda, 0x7f,
+	0x21, 0x1c, 0x7b, 0x41, 0xff, 0x25, 0x79, 0x8b, 0x6f, 0x6a,
+	0xed, 0xbf, 0xa0, 0x1b, 0x25, 0x1c, 0x7b, 0x01, 0xfc, 0x49,
+	0xf8, 0xa3, 0x02, 0xa0, 0xde, 0xd0, 0xd6, 0x1d, 0x11, 0xc6,
+	0x01, 0x5c, 0x94, 0x70, 0xec, 0x05, 0xa9, 0xb3, 0xff, 0xa2,
+	0x99, 0x86, 0x5b, 0xb5, 0x14, 0x00, 0xf5, 0x06, 0xe3, 0x5c,
+	0xe2, 0x41, 0x56, 0xea, 0x6c, 0xc6, 0xb9, 0x64, 0xff, 0xe8,
+	0x86, 0x70, 0xec, 0x05, 0xe8, 0x26, 0x75, 0xc2, 0x6f, 0x6a,
+	0x45, 0x37, 0x09, 0x7f, 0xda, 0xba, 0x75, 0x6f, 0xc6, 0xb9,
+	0x64, 0xff, 0x45, 0x05, 0x40, 0xbd, 0x61, 0xdd, 0x33, 0xe3,
+	0x41, 0x56, 0x6a, 0x85, 0x3f, 0xeb, 0xae, 0xbc, 0xc5, 0x37,
+	0xb5, 0xe1, 0x56, 0x2d, 0x1e, 0x64, 0xf5, 0x5f, 0x14, 0xfe,
+	0xf0, 0x16, 0x4f, 0x8d, 0x6e, 0x02, 0x81, 0x6d, 0xa8, 0x81,
+	0x8e, 0x54, 0x8d, 0x04, 0x49, 0x92, 0x54, 0xb2, 0x1c, 0x31,
+	0x04, 0x0d, 0x43, 0x81, 0x30, 0xf6, 0xee, 0x11, 0x20, 0x08,
+	0x42, 0xa4, 0x90, 0xba, 0x2a, 0x2d, 0x0c, 0x07, 0x0d, 0x8f,
+	0x37, 0xc2, 0xcc, 0x20, 0x2a, 0x43, 0xc8, 0xc5, 0x4a, 0xf7,
+	0x21, 0x9f, 0xb1, 0x7b, 0xbf, 0xbf, 0x3b, 0xc6, 0x8f, 0xa3,
+	0x69, 0xbe, 0x13, 0xcb, 0xdf, 0xac, 0x53, 0xb8, 0x3f, 0x76,
+	0x83, 0x46, 0x6b, 0x9d, 0x2c, 0xb1, 0xed, 0xdb, 0x52, 0xc5,
+	0x70, 0x27, 0x8f, 0x02, 0xb5, 0xed, 0x33, 0xf9, 0x6b, 0xe0,
+	0x08, 0x2f, 0x6b, 0xfc, 0x91, 0x7c, 0xec, 0x1b, 0x46, 0xe5,
+	0x73, 0xb9, 0x08, 0xf3, 0xb2, 0x6f, 0xc9, 0x82, 0xc6, 0xdb,
+	0xad, 0x07, 0xc8, 0xe6, 0x47, 0x86, 0x8a, 0xe2, 0x8c, 0x94,
+	0x6d, 0xb0, 0x52, 0x8f, 0x97, 0xb3, 0x14, 0x65, 0x9f, 0x79,
+	0x21, 0x54, 0xaa, 0x3d, 0x09, 0x45, 0x95, 0x82, 0xcf, 0x34,
+	0xa1, 0x00, 0x76, 0xa0, 0xd6, 0x5c, 0x9d, 0x00, 0x9f, 0x4e,
+	0x43, 0x73, 0x92, 0x69, 0x5e, 0xe0, 0xa9, 0x9b, 0x7a, 0xd1,
+	0x4f, 0xc0, 0x93, 0x11, 0x4f, 0x2b, 0x62, 0x90, 0x5f, 0x3f,
+	0x98, 0x9a, 0x8c, 0x02, 0x86, 0xb2, 0xad, 0x6b, 0xf3, 0xcb,
+	0xbb, 0x75, 0x1c, 0x94, 0x69, 0xbb, 0x17, 0x0d, 0x54, 0x6b,
+	0x9e, 0x59, 0x03, 0x39, 0xc2, 0x61, 0x8e, 0x4a, 0x19, 0xa4,
+	0x9e, 0xfc, 0x9a, 0xa9, 0xbf, 0x92, 0x92, 0xf9, 0xce, 0x4a,
+	0x8e, 0x6a, 0x87, 0xfb, 0x88, 0x5d, 0x1a, 0xb2, 0x08, 0xd7,
+	0x20, 0x0d, 0x91, 0x32, 0xe3, 0xe9, 0x18, 0x83, 0x3b, 0x2c,
+	0x78, 0xb0, 0x0b, 0x0d, 0xc5, 0xcc, 0xcf, 0x08, 0x3b, 0x3a,
+	0x5c, 0x95, 0x08, 0x68, 0xfd, 0xd4, 0x9c, 0xe8, 0xc4, 0x45,
+	0x5c, 0x16, 0x1b, 0x84, 0x58, 0xcd, 0xfc, 0x72, 0x6d, 0x89,
+	0xcb, 0x46, 0x2e, 0xa5, 0xda, 0x24, 0x9d, 0x7d, 0xc1, 0x1a,
+	0xf3, 0x1b, 0x80, 0xc3, 0x21, 0x59, 0x15, 0x21, 0x13, 0xca,
+	0xa0, 0x3b, 0xd3, 0xc5, 0x07, 0xfd, 0x92, 0xe9, 0x0f, 0x40,
+	0xe0, 0x53, 0xdf, 0x3a, 0x87, 0x02, 0x3b, 0x67, 0x41, 0x0e,
+	0xf8, 0x5f, 0x3d, 0x44, 0x1d, 0x52, 0x8e, 0xad, 0x7b, 0x15,
+	0xf9, 0x10, 0xe4, 0x61, 0x22, 0x94, 0x6f, 0x70, 0x59, 0x42,
+	0xc4, 0xbf, 0x1f, 0x1e, 0xa3, 0x5e, 0x26, 0x05, 0xbe, 0x44,
+	0xf7, 0xb6, 0xe7, 0x17, 0x6c, 0xcf, 0x95, 0x98, 0x27, 0x47,
+	0x6c, 0x14, 0x5b, 0x69, 0xae, 0x03, 0x10, 0x2f, 0x35, 0x21,
+	0xc1, 0x39, 0xc7, 0x47, 0x51, 0x06, 0x22, 0xe9, 0x6c, 0x73,
+	0xac, 0x05, 0x22, 0xaf, 0x07, 0xee, 0x64, 0xde, 0x87, 0x4e,
+	0x74, 0x0f, 0x62, 0x15, 0xc5, 0x0f, 0x04, 0x48, 0xe9, 0xd4,
+	0x85, 0x63, 0x1f, 0xc7, 0x8e, 0xa7, 0x05, 0x12, 0x5f, 0x9c,
+	0x2e, 0x8c, 0x0f, 0xad, 0x96, 0xc6, 0x14, 0x50, 0x47, 0x8d,
+	0xa4, 0xfd, 0xca, 0x1c, 0x00, 0x02, 0xfa, 0xc7, 0x3d, 0xc1,
+	0xb2, 0xd1, 0x3e, 0x44, 0xb5, 0xeb, 0x8f, 0x68, 0x11, 0x56,
+	0xe9, 0x3d, 0xa2, 0x2d, 0x04, 0x02, 0xae, 0xa2, 0x8a, 0xb7,
+	0x82, 0x1f, 0x44, 0xe8, 0x64, 0x3a, 0x89, 0x25, 0x88, 0x8a,
+	0xac, 0x67, 0x7f, 0xd5, 0x8c, 0x6f, 0x8e, 0x72, 0x8c, 0x70,
+	0x3e, 0x9f, 0xe2, 0x84, 0xae, 0x0a, 0xc9, 0xf6, 0xd5, 0x70,
+	0xb2, 0x74, 0x0c, 0xfc, 0x1c, 0x54, 0xda, 0x37, 0x30, 0xd1,
+	0x31, 0x84, 0xdc, 0xf8, 0x93, 0x30, 0x12, 0xad, 0x49, 0xd2,
+	0x42, 0xe2, 0x55, 0x5d, 0x3d, 0x18, 0x1d, 0x7d, 0x1c, 0x8c,
+	0xaf, 0x93, 0x4e, 0x7b, 0x9c, 0xd4, 0x5e, 0xe1, 0xb6, 0x5b,
+	0xad, 0x71, 0x96, 0xb9, 0xc4, 0x9c, 0x22, 0x14, 0xab, 0x91,
+	0x18, 0xf1, 0x8a, 0x2f, 0x32, 0x1a, 0x6a, 0x1d, 0x13, 0xe4,
+	0xf0, 0x87, 0x04, 0x21, 0xb0, 0xad, 0x02, 0x47, 0xb9, 0xc7,
+	0xd3, 0xd4, 0x0c, 0x32, 0xd9, 0x74, 0xf2, 0x9c, 0x94, 0xa3,
+	0x9f, 0x09, 0xba, 0x7a, 0x5c, 0x02, 0xa9, 0x0c, 0x48, 0x53,
+	0x38, 0x5c, 0x20, 0x6c, 0x7b, 0x72, 0xfd, 0x7d, 0x75, 0x02,
+	0x08, 0x60, 0x39, 0xd1, 0x12, 0xd7, 0xb5, 0x96, 0x9c, 0x67,
+	0x4c, 0x0e, 0x18, 0x85, 0x82, 0xc8, 0xe9, 0xcd, 0xe0, 0x85,
+	0x0b, 0x8b, 0x66, 0x01, 0x49, 0x09, 0x3b, 0x6e, 0x8e, 0x18,
+	0x47, 0xc2, 0x19, 0x11, 0xb7, 0x77, 0xc4, 0x5e, 0x3e, 0x6e,
+	0xb4, 0xfa, 0x75, 0x85, 0x1b, 0x48, 0xd7, 0xef, 0x0c, 0x45,
+	0xb8, 0x56, 0x87, 0xa9, 0xf4, 0x30, 0x40, 0x2e, 0xb8, 0x61,
+	0xbc, 0xbf, 0x5a, 0x47, 0x47, 0x66, 0x6a, 0xa0, 0x4a, 0x6e,
+	0x03, 0x8d, 0xb6, 0x3b, 0xc7, 0x0c, 0x57, 0x53, 0x86, 0x93,
+	0x16, 0x24, 0xdd, 0x4f, 0x4b, 0x2d, 0x48, 0x98, 0xd0, 0xfe,
+	0x3d, 0x18, 0x21, 0x19, 0x48, 0x3f, 0x27, 0x34, 0xa3, 0xa6,
+	0xc9, 0x7b, 0x5e, 0x21, 0x4b, 0xba, 0x4c, 0x53, 0x8a, 0xbf,
+	0xfe, 0x9f, 0x7a, 0x8e, 0x5c, 0x5a, 0x64, 0x66, 0xb4, 0xe9,
+	0x92, 0x4b, 0x0e, 0x11, 0xcf, 0x04, 0x7f, 0x77, 0x70, 0x1e,
+	0xfb, 0x8a, 0x33, 0x8e, 0x1e, 0xcc, 0x28, 0x69, 0x85, 0xd9,
+	0xbd, 0x4f, 0x3c, 0x2a, 0x58, 0xa4, 0x07, 0x26, 0x37, 0x29,
+	0x31, 0xa5, 0x32, 0x13, 0x64, 0xdf, 0x80, 0x09, 0x52, 0x02,
+	0xc4, 0x04, 0x12, 0xd8, 0xf0, 0x3e, 0xd5, 0x2f, 0x50, 0x70,
+	0x59, 0xa8, 0x02, 0xf1, 0x8f, 0x14, 0xa7, 0x2c, 0xac, 0x90,
+	0xaa, 0x1b, 0xe6, 0x48, 0xc1, 0x1f
+};
+
+/** Generated text */
+static uint8_t text_expected[ZSTD_TEST_TEXT_LEN];
+
+/** Generated text (maximum compression) */
+static struct zstd_test text = {
+	.compressed_name = "text.zst",
+	.compressed = text_compressed,
+	.compressed_len = sizeof ( text_compressed ),
+	.expected_name = "text",
+	.expected = text_expected,
+	.expected_len = sizeof ( text_expected ),
+};
+
+/** Generated text (fast compression) */
+static struct zstd_test text_fast = {
+	.compressed_name = "text_fast.zst",
+	.compressed = text_fast_compressed,
+	.compressed_len = sizeof ( text_fast_compressed ),
+	.expected_name = "text_fast",
+	.expected = text_expected,
+	.expected_len = sizeof ( text_expected ),
+};
+
+/**
+ * Generate text
+ *
+ * @v data		Buffer to fill in
+ * @v len		Length of buffer
+ */
+static void zstd_test_text ( uint8_t *data, size_t len ) {
+	static const char *words[] = {
+		"the", "quick", "brown", "fox", "jumps", "over", "lazy",
+		"dog", "network", "boot", "firmware", "image", "kernel",
+		"initrd", "open", "source",
+	};
+	const char *word;
+	uint32_t state = 1;
+	size_t offset = 0;
+
+	while ( offset < len ) {
+		state = ( ( state * 1103515245UL ) + 12345 );
+		word = words[ ( state >> 16 ) %
+			      ( sizeof ( words ) / sizeof ( words[0] ) ) ];
+		while ( *word && ( offset < len ) )
+			data[offset++] = *(word++);
+		if ( offset < len ) {
+			data[offset++] = ( ( ( state >> 8 ) & 7 ) ?
+					   ' ' : '\n' );
+		}
+	}
+}
+
+/**
+ * Report Zstandard test result
+ *
+ * @v test		Zstandard test
+ * @v file		Test code file
+ * @v line		Test code line
+ */
+static void zstd_okx ( struct zstd_test *test, const char *file,
+		       unsigned int line ) {
+	struct image *image;
+	struct image *extracted;
+
+	/* Construct compressed image */
+	image = image_memory ( test->compressed_name, test->compressed,
+			       test->compressed_len );
+	okx ( image != NULL, file, line );
+	okx ( image->len == test->compressed_len, file, line );
+
+	/* Check type detection */
+	okx ( image->type == &zstd_image_type, file, line );
+
+	/* Extract archive image */
+	okx ( image_extract ( image, NULL, &extracted ) == 0, file, line );
+
+	/* Verify extracted image content */
+	okx ( extracted->len == test->expected_len, file, line );
+	okx ( memcmp ( extracted->data, test->expected,
+		       test->expected_len ) == 0, file, line );
+
+	/* Verify extracted image name */
+	okx ( strcmp ( extracted->name, test->expected_name ) == 0,
+	      file, line );
+
+	/* Unregister images */
+	unregister_image ( extracted );
+	unregister_image ( image );
+}
+#define zstd_ok( test ) zstd_okx ( test, __FILE__, __LINE__ )
+
+/**
+ * Report Zstandard failure test result
+ *
+ * @v test		Zstandard test
+ * @v len		Length of compressed data to use
+ * @v file		Test code file
+ * @v line		Test code line
+ */
+static void zstd_fail_okx ( struct zstd_test *test, size_t len,
+			    const char *file, unsigned int line ) {
+	struct image *image;
+	struct image *extracted;
+
+	/* Construct compressed image */
+	image = image_memory ( test->compressed_name, test->compressed, len );
+	okx ( image != NULL, file, line );
+	okx ( image->type == &zstd_image_type, file, line );
+
+	/* Check that extraction fails */
+	okx ( image_extract ( image, NULL, &extracted ) != 0, file, line );
+
+	/* Unregister image */
+	unregister_image ( image );
+}
+#define zstd_fail_ok( test, len ) \
+	zstd_fail_okx ( test, len, __FILE__, __LINE__ )
+
+/**
+ * Perform Zstandard self-test
+ *
+ */
+static void zstd_test_exec ( void ) {
+
+	/* Construct generated text */
+	zstd_test_text ( text_expected, sizeof ( text_expected ) );
+
+	/* Check successful extraction */
+	zstd_ok ( &hello_world );
+	zstd_ok ( &hello_fcs );
+	zstd_ok ( &hello_frames );
+	zstd_ok ( &text );
+	zstd_ok ( &text_fast );
+
+	/* Check failure cases */
+	zstd_fail_ok ( &hello_corrupt, hello_corrupt.compressed_len );
+	zstd_fail_ok ( &hello_world, ( hello_world.compressed_len - 1 ) );
+	zstd_fail_ok ( &text, ( text.compressed_len - 5 ) );
+}
+
+/** Zstandard self-test */
+struct self_test zstd_test __self_test = {
+	.name = "zstd",
+	.exec = zstd_test_exec,
+};
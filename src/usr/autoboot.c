@@ -162,7 +162,7 @@ int uriboot ( struct uri *filename, struct uri **root_paths,
 
 	/* Attempt filename boot if applicable */
 	if ( filename ) {
-		if ( ( rc = imgdownload ( filename, 0, &image ) ) != 0 )
+		if ( ( rc = imgdownload ( filename, 0, 0, &image ) ) != 0 )
 			goto err_download;
 		imgstat ( image );
 		image->flags |= IMAGE_AUTO_UNREGISTER;
@@ -384,29 +384,19 @@ static int have_pxe_menu ( void ) {
 }
 
 /**
- * Boot from a network device
+ * Boot from a configured network device
  *
  * @v netdev		Network device
  * @ret rc		Return status code
  */
-int netboot ( struct net_device *netdev ) {
+static int netboot_configured ( struct net_device *netdev ) {
 	struct san_boot_config san_config;
 	struct uri *filename;
 	struct uri *root_path;
 	char *san_filename;
 	int rc;
 
-	/* Close all other network devices */
-	close_other_netdevs ( netdev );
-
-	/* Open device and display device status */
-	if ( ( rc = ifopen ( netdev ) ) != 0 )
-		goto err_ifopen;
-	ifstat ( netdev );
-
-	/* Configure device */
-	if ( ( rc = ifconf ( netdev, NULL, 0 ) ) != 0 )
-		goto err_dhcp;
+	/* Display routing table */
 	route();
 
 	/* Try PXE menu boot, if applicable */
@@ -460,11 +450,34 @@ int netboot ( struct net_device *netdev ) {
 	uri_put ( root_path );
 	uri_put ( filename );
  err_pxe_menu_boot:
- err_dhcp:
- err_ifopen:
 	return rc;
 }
 
+/**
+ * Boot from a network device
+ *
+ * @v netdev		Network device
+ * @ret rc		Return status code
+ */
+int netboot ( struct net_device *netdev ) {
+	int rc;
+
+	/* Close all other network devices */
+	close_other_netdevs ( netdev );
+
+	/* Open device and display device status */
+	if ( ( rc = ifopen ( netdev ) ) != 0 )
+		return rc;
+	ifstat ( netdev );
+
+	/* Configure device */
+	if ( ( rc = ifconf ( netdev, NULL, 0 ) ) != 0 )
+		return rc;
+
+	/* Boot from device */
+	return netboot_configured ( netdev );
+}
+
 /**
  * Test if network device matches the autoboot device bus type and location
  *
@@ -540,6 +553,17 @@ static int autoboot ( void ) {
 	struct net_device *netdev;
 	int rc = -ENODEV;
 
+#ifdef AUTOBOOT_PARALLEL
+	/* Configure all candidate devices in parallel, and boot from
+	 * whichever completes configuration first.
+	 */
+	if ( ( rc = ifconf_any ( is_autoboot_device, NULL, 0,
+				 &netdev ) ) != 0 )
+		return rc;
+	ifstat ( netdev );
+	return netboot_configured ( netdev );
+#endif
+
 	/* Try booting from each network device.  If we have a
 	 * specified autoboot device location, then use only devices
 	 * matching that location.
@@ -103,6 +103,22 @@ static void ifstat_errors ( struct net_device_stats *stats,
 	}
 }
 
+/**
+ * Print network device datapath statistics
+ *
+ * @v dp_stats		Network device datapath statistics
+ */
+static void ifstat_datapath ( struct net_device_datapath_stats *dp_stats ) {
+
+	printf ( "  [TXB:%ld RXB:%ld TXDefer:%ld RXRefillErr:%ld "
+		 "RXEmpty:%ld]\n", dp_stats->tx_octets, dp_stats->rx_octets,
+		 dp_stats->tx_deferred, dp_stats->rx_refill_errs,
+		 dp_stats->rx_empty );
+	printf ( "  [Polls:%ld Idle:%ld MaxRXPerPoll:%d]\n",
+		 dp_stats->polls, dp_stats->idle_polls,
+		 dp_stats->rx_max_per_poll );
+}
+
 /**
  * Print status of network device
  *
@@ -125,6 +141,7 @@ void ifstat ( struct net_device *netdev ) {
 	}
 	ifstat_errors ( &netdev->tx_stats, "TXE" );
 	ifstat_errors ( &netdev->rx_stats, "RXE" );
+	ifstat_datapath ( &netdev->dp_stats );
 }
 
 /** Network device poller */
@@ -135,6 +152,8 @@ struct ifpoller {
 	struct net_device *netdev;
 	/** Network device configurator (if applicable) */
 	struct net_device_configurator *configurator;
+	/** Network device filter (if applicable) */
+	int ( * match ) ( struct net_device *netdev );
 	/**
 	 * Check progress
 	 *
@@ -167,6 +186,11 @@ static struct interface_operation ifpoller_job_op[] = {
 static struct interface_descriptor ifpoller_job_desc =
 	INTF_DESC ( struct ifpoller, job, ifpoller_job_op );
 
+/** Network device poller */
+static struct ifpoller ifpoller = {
+	.job = INTF_INIT ( ifpoller_job_desc ),
+};
+
 /**
  * Poll network device until completion
  *
@@ -180,9 +204,6 @@ static int ifpoller_wait ( struct net_device *netdev,
 			   struct net_device_configurator *configurator,
 			   unsigned long timeout,
 			   int ( * progress ) ( struct ifpoller *ifpoller ) ) {
-	static struct ifpoller ifpoller = {
-		.job = INTF_INIT ( ifpoller_job_desc ),
-	};
 
 	ifpoller.netdev = netdev;
 	ifpoller.configurator = configurator;
@@ -235,6 +256,26 @@ int iflinkwait ( struct net_device *netdev, unsigned long timeout,
 	return ifpoller_wait ( netdev, NULL, timeout, iflinkwait_progress );
 }
 
+/**
+ * Get completed configuration status
+ *
+ * @v netdev		Network device
+ * @v configurator	Network device configurator, or NULL to use all
+ * @ret rc		Return status code
+ */
+static int ifconf_rc ( struct net_device *netdev,
+		       struct net_device_configurator *configurator ) {
+	struct net_device_configuration *config;
+
+	if ( configurator ) {
+		config = netdev_configuration ( netdev, configurator );
+		return config->rc;
+	} else {
+		return ( netdev_configuration_ok ( netdev ) ?
+			 0 : -EADDRNOTAVAIL_CONFIG );
+	}
+}
+
 /**
  * Check configuration progress
  *
@@ -243,8 +284,6 @@ int iflinkwait ( struct net_device *netdev, unsigned long timeout,
  */
 static int ifconf_progress ( struct ifpoller *ifpoller ) {
 	struct net_device *netdev = ifpoller->netdev;
-	struct net_device_configurator *configurator = ifpoller->configurator;
-	struct net_device_configuration *config;
 	int rc;
 
 	/* Do nothing unless configuration has completed */
@@ -252,13 +291,7 @@ static int ifconf_progress ( struct ifpoller *ifpoller ) {
 		return 0;
 
 	/* Terminate with appropriate overall return status code */
-	if ( configurator ) {
-		config = netdev_configuration ( netdev, configurator );
-		rc = config->rc;
-	} else {
-		rc = ( netdev_configuration_ok ( netdev ) ?
-		       0 : -EADDRNOTAVAIL_CONFIG );
-	}
+	rc = ifconf_rc ( netdev, ifpoller->configurator );
 	intf_close ( &ifpoller->job, rc );
 
 	return rc;
@@ -305,3 +338,119 @@ int ifconf ( struct net_device *netdev,
 		 netdev->name, netdev->ll_protocol->ntoa ( netdev->ll_addr ) );
 	return ifpoller_wait ( netdev, configurator, timeout, ifconf_progress );
 }
+
+/**
+ * Check if network device is a candidate for parallel configuration
+ *
+ * @v netdev		Network device
+ * @v match		Network device filter, or NULL to use all devices
+ * @ret is_candidate	Network device is a candidate
+ */
+static int ifconf_any_candidate ( struct net_device *netdev,
+				  int ( * match ) ( struct net_device *netdev ) ){
+
+	return ( netdev_is_open ( netdev ) &&
+		 ( ( ! match ) || match ( netdev ) ) );
+}
+
+/**
+ * Check parallel configuration progress
+ *
+ * @v ifpoller		Network device poller
+ * @ret ongoing_rc	Ongoing job status code (if known)
+ */
+static int ifconf_any_progress ( struct ifpoller *ifpoller ) {
+	struct net_device *netdev;
+	int ongoing = 0;
+	int rc = -EADDRNOTAVAIL_CONFIG;
+
+	/* Check each candidate device */
+	for_each_netdev ( netdev ) {
+
+		/* Skip non-candidate devices */
+		if ( ! ifconf_any_candidate ( netdev, ifpoller->match ) )
+			continue;
+
+		/* Skip devices on which configuration is still ongoing */
+		if ( netdev_configuration_in_progress ( netdev ) ) {
+			ongoing = 1;
+			continue;
+		}
+
+		/* Terminate successfully on the first configured device */
+		rc = ifconf_rc ( netdev, ifpoller->configurator );
+		if ( rc == 0 ) {
+			ifpoller->netdev = netdev;
+			intf_close ( &ifpoller->job, 0 );
+			return 0;
+		}
+	}
+
+	/* Terminate with failure if all devices have failed */
+	if ( ! ongoing )
+		intf_close ( &ifpoller->job, rc );
+
+	return 0;
+}
+
+/**
+ * Perform network device configuration on multiple devices in parallel
+ *
+ * @v match		Network device filter, or NULL to use all devices
+ * @v configurator	Network device configurator, or NULL to use all
+ * @v timeout		Timeout period, in ticks
+ * @v configured	Configured network device to fill in
+ * @ret rc		Return status code
+ *
+ * All matching network devices are opened and configured
+ * simultaneously.  The first device to complete configuration
+ * successfully is returned, and all other candidate devices are
+ * closed.  Links are not waited for: configuration is started
+ * immediately, and configurators such as DHCP will continue to
+ * retransmit as links come up.
+ */
+int ifconf_any ( int ( * match ) ( struct net_device *netdev ),
+		 struct net_device_configurator *configurator,
+		 unsigned long timeout, struct net_device **configured ) {
+	struct net_device *netdev;
+	const char *sep = "";
+	int rc;
+
+	/* Open and start configuring all matching devices */
+	printf ( "Configuring (" );
+	for_each_netdev ( netdev ) {
+		if ( match && ( ! match ( netdev ) ) )
+			continue;
+		if ( ifopen ( netdev ) != 0 )
+			continue;
+		rc = ( configurator ? netdev_configure ( netdev, configurator ) :
+		       netdev_configure_all ( netdev ) );
+		if ( rc != 0 ) {
+			ifclose ( netdev );
+			continue;
+		}
+		printf ( "%s%s", sep, netdev->name );
+		sep = " ";
+	}
+	printf ( ")" );
+
+	/* Wait for the first device to complete configuration */
+	ifpoller.match = match;
+	rc = ifpoller_wait ( NULL, configurator, timeout,
+			     ifconf_any_progress );
+	ifpoller.match = NULL;
+	if ( rc != 0 )
+		return rc;
+	*configured = ifpoller.netdev;
+
+	/* Cancel configuration of all other candidate devices */
+	for_each_netdev ( netdev ) {
+		if ( ( netdev != *configured ) &&
+		     ifconf_any_candidate ( netdev, match ) ) {
+			ifclose ( netdev );
+		}
+	}
+	printf ( "Configured %s\n", ( *configured )->name );
+
+	return 0;
+}
@@ -29,11 +29,17 @@ FILE_SECBOOT ( PERMITTED );
 #include <stdio.h>
 #include <string.h>
 #include <errno.h>
+#include <ipxe/refcnt.h>
+#include <ipxe/list.h>
+#include <ipxe/interface.h>
+#include <ipxe/job.h>
 #include <ipxe/image.h>
 #include <ipxe/downloader.h>
 #include <ipxe/monojob.h>
 #include <ipxe/open.h>
 #include <ipxe/uri.h>
+#include <ipxe/asn1.h>
+#include <ipxe/settings.h>
 #include <usr/imgmgmt.h>
 
 /** @file
@@ -42,31 +48,283 @@ FILE_SECBOOT ( PERMITTED );
  *
  */
 
+/** A background image prefetch */
+struct imgprefetch {
+	/** Reference count */
+	struct refcnt refcnt;
+	/** List of prefetches */
+	struct list_head list;
+	/** Job control interface (to downloader) */
+	struct interface job;
+	/** Job monitor interface (to foreground job, if any) */
+	struct interface monitor;
+	/** Download flags */
+	unsigned int flags;
+	/** Image */
+	struct image *image;
+	/** Download status */
+	int rc;
+	/** Resolved URI string */
+	char uri_string[0];
+};
+
+/** List of background image prefetches */
+static LIST_HEAD ( imgprefetches );
+
+static void imgprefetch_close ( struct imgprefetch *prefetch, int rc );
+
+/** Download digest setting */
+const struct setting download_digest_setting __setting ( SETTING_MISC,
+							 download-digest ) = {
+	.name = "download-digest",
+	.description = "Digest algorithms to calculate during download",
+	.type = &setting_type_string,
+};
+
 /**
- * Download a new image
+ * Find digest algorithm by name
  *
- * @v uri		URI
- * @v timeout		Download timeout
- * @v image		Image to fill in
+ * @v name		Algorithm name
+ * @ret digest		Digest algorithm, or NULL if not found
+ */
+static struct digest_algorithm * imgdownload_find_digest ( const char *name ) {
+	struct asn1_algorithm *algorithm;
+
+	for_each_table_entry ( algorithm, ASN1_ALGORITHMS ) {
+		if ( algorithm->digest && ( ! algorithm->pubkey ) &&
+		     ( strcmp ( algorithm->name, name ) == 0 ) )
+			return algorithm->digest;
+	}
+	return NULL;
+}
+
+/**
+ * Start accumulating configured digests during download
+ *
+ * @v image		Image
  * @ret rc		Return status code
+ *
+ * The "download-digest" setting may contain a comma-separated list
+ * of digest algorithm names (e.g. "md5,sha256").
  */
-int imgdownload ( struct uri *uri, unsigned long timeout,
-		  struct image **image ) {
-	struct uri uri_redacted;
-	char *uri_string_redacted;
+static int imgdownload_start_digests ( struct image *image ) {
+	struct digest_algorithm *digest;
+	char *names;
+	char *name;
+	char *sep;
 	int rc;
 
-	/* Construct redacted URI */
-	memcpy ( &uri_redacted, uri, sizeof ( uri_redacted ) );
-	uri_redacted.user = NULL;
-	uri_redacted.password = NULL;
-	uri_redacted.equery = NULL;
-	uri_redacted.efragment = NULL;
-	uri_string_redacted = format_uri_alloc ( &uri_redacted );
-	if ( ! uri_string_redacted ) {
-		rc = -ENOMEM;
-		goto err_uri_string;
+	/* Fetch setting */
+	fetch_string_setting_copy ( NULL, &download_digest_setting, &names );
+	if ( ! names )
+		return 0;
+
+	/* Start each named digest */
+	for ( name = names ; name ; name = sep ) {
+		sep = strchr ( name, ',' );
+		if ( sep )
+			*(sep++) = '\0';
+		if ( ! *name )
+			continue;
+		digest = imgdownload_find_digest ( name );
+		if ( ! digest ) {
+			DBGC ( image, "IMAGE %s unknown digest \"%s\"\n",
+			       image->name, name );
+			continue;
+		}
+		if ( ( rc = image_digest_start ( image, digest ) ) != 0 )
+			goto err_start;
+	}
+	rc = 0;
+
+ err_start:
+	free ( names );
+	return rc;
+}
+
+/**
+ * Free background image prefetch
+ *
+ * @v refcnt		Reference count
+ */
+static void imgprefetch_free ( struct refcnt *refcnt ) {
+	struct imgprefetch *prefetch =
+		container_of ( refcnt, struct imgprefetch, refcnt );
+
+	image_put ( prefetch->image );
+	free ( prefetch );
+}
+
+/**
+ * Count background image prefetches still in progress
+ *
+ * @ret count		Number of prefetches still in progress
+ */
+static unsigned int imgprefetch_pending ( void ) {
+	struct imgprefetch *prefetch;
+	unsigned int count = 0;
+
+	list_for_each_entry ( prefetch, &imgprefetches, list ) {
+		if ( prefetch->rc == -EINPROGRESS )
+			count++;
 	}
+	return count;
+}
+
+/**
+ * Get combined progress of all background image prefetches
+ *
+ * @v intf		Waiter interface
+ * @v progress		Progress data to fill in
+ * @ret ongoing_rc	Ongoing job status code (if known)
+ */
+static int imgprefetch_waiter_progress ( struct interface *intf __unused,
+					 struct job_progress *progress ) {
+	struct imgprefetch *prefetch;
+	struct job_progress tmp;
+	unsigned int count = 0;
+	unsigned int done = 0;
+	int known = 1;
+
+	list_for_each_entry ( prefetch, &imgprefetches, list ) {
+		count++;
+		if ( prefetch->rc == -EINPROGRESS ) {
+			job_progress ( &prefetch->job, &tmp );
+		} else {
+			tmp.completed = tmp.total = prefetch->image->len;
+			done++;
+		}
+		progress->completed += tmp.completed;
+		progress->total += tmp.total;
+		if ( ! tmp.total )
+			known = 0;
+	}
+
+	/* Report total only if known for every download */
+	if ( ! known )
+		progress->total = 0;
+	snprintf ( progress->message, sizeof ( progress->message ),
+		   "%d/%d", done, count );
+
+	return 0;
+}
+
+/**
+ * Stop waiting for background image prefetches
+ *
+ * @v intf		Waiter interface
+ * @v rc		Reason for close
+ */
+static void imgprefetch_waiter_close ( struct interface *intf, int rc ) {
+	struct imgprefetch *prefetch;
+
+	/* Shut down interface */
+	intf_restart ( intf, rc );
+
+	/* Abort any prefetches still in progress (e.g. on timeout or
+	 * user cancellation).
+	 */
+	if ( rc != 0 ) {
+		list_for_each_entry ( prefetch, &imgprefetches, list ) {
+			if ( prefetch->rc == -EINPROGRESS )
+				imgprefetch_close ( prefetch, rc );
+		}
+	}
+}
+
+/** Background image prefetch waiter interface operations */
+static struct interface_operation imgprefetch_waiter_op[] = {
+	INTF_OP ( job_progress, struct interface *,
+		  imgprefetch_waiter_progress ),
+	INTF_OP ( intf_close, struct interface *, imgprefetch_waiter_close ),
+};
+
+/** Background image prefetch waiter interface descriptor */
+static struct interface_descriptor imgprefetch_waiter_desc =
+	INTF_DESC_PURE ( imgprefetch_waiter_op );
+
+/** Background image prefetch waiter interface */
+static struct interface imgprefetch_waiter =
+	INTF_INIT ( imgprefetch_waiter_desc );
+
+/**
+ * Finish background image prefetch
+ *
+ * @v prefetch		Background image prefetch
+ * @v rc		Reason for finishing
+ */
+static void imgprefetch_close ( struct imgprefetch *prefetch, int rc ) {
+
+	DBGC ( prefetch, "IMGPREFETCH %s finished: %s\n",
+	       prefetch->uri_string, strerror ( rc ) );
+
+	/* Record status */
+	if ( prefetch->rc == -EINPROGRESS )
+		prefetch->rc = rc;
+
+	/* Shut down all interfaces */
+	intfs_shutdown ( rc, &prefetch->job, &prefetch->monitor, NULL );
+
+	/* Notify waiter if all prefetches are now complete */
+	if ( ! imgprefetch_pending() )
+		intf_restart ( &imgprefetch_waiter, 0 );
+}
+
+/** Background image prefetch job control interface operations */
+static struct interface_operation imgprefetch_job_op[] = {
+	INTF_OP ( intf_close, struct imgprefetch *, imgprefetch_close ),
+};
+
+/** Background image prefetch job control interface descriptor */
+static struct interface_descriptor imgprefetch_job_desc =
+	INTF_DESC_PASSTHRU ( struct imgprefetch, job, imgprefetch_job_op,
+			     monitor );
+
+/** Background image prefetch job monitor interface operations */
+static struct interface_operation imgprefetch_monitor_op[] = {
+	INTF_OP ( intf_close, struct imgprefetch *, imgprefetch_close ),
+};
+
+/** Background image prefetch job monitor interface descriptor */
+static struct interface_descriptor imgprefetch_monitor_desc =
+	INTF_DESC_PASSTHRU ( struct imgprefetch, monitor,
+			     imgprefetch_monitor_op, job );
+
+/**
+ * Find background image prefetch
+ *
+ * @v uri_string	Resolved URI string
+ * @v flags		Download flags
+ * @ret prefetch	Background image prefetch, or NULL if not found
+ */
+static struct imgprefetch * imgprefetch_find ( const char *uri_string,
+					       unsigned int flags ) {
+	struct imgprefetch *prefetch;
+
+	list_for_each_entry ( prefetch, &imgprefetches, list ) {
+		if ( ( strcmp ( prefetch->uri_string, uri_string ) == 0 ) &&
+		     ( prefetch->flags == flags ) )
+			return prefetch;
+	}
+	return NULL;
+}
+
+/**
+ * Start downloading an image in the background
+ *
+ * @v uri		URI
+ * @v flags		Download flags
+ * @ret rc		Return status code
+ *
+ * A subsequent download of the same URI (with the same flags) will
+ * use the prefetched image, waiting for the background download to
+ * complete if necessary.
+ */
+int imgprefetch ( struct uri *uri, unsigned int flags ) {
+	struct imgprefetch *prefetch;
+	char *uri_string;
+	size_t len;
+	int rc;
 
 	/* Resolve URI */
 	uri = resolve_uri ( cwuri, uri );
@@ -74,6 +332,206 @@ int imgdownload ( struct uri *uri, unsigned long timeout,
 		rc = -ENOMEM;
 		goto err_resolve_uri;
 	}
+	uri_string = format_uri_alloc ( uri );
+	if ( ! uri_string ) {
+		rc = -ENOMEM;
+		goto err_uri_string;
+	}
+
+	/* Do nothing if this URI is already being prefetched */
+	if ( imgprefetch_find ( uri_string, flags ) ) {
+		rc = 0;
+		goto err_exists;
+	}
+
+	/* Allocate and initialise structure */
+	len = ( strlen ( uri_string ) + 1 /* NUL */ );
+	prefetch = zalloc ( sizeof ( *prefetch ) + len );
+	if ( ! prefetch ) {
+		rc = -ENOMEM;
+		goto err_alloc;
+	}
+	ref_init ( &prefetch->refcnt, imgprefetch_free );
+	intf_init ( &prefetch->job, &imgprefetch_job_desc,
+		    &prefetch->refcnt );
+	intf_init ( &prefetch->monitor, &imgprefetch_monitor_desc,
+		    &prefetch->refcnt );
+	prefetch->flags = flags;
+	prefetch->rc = -EINPROGRESS;
+	memcpy ( prefetch->uri_string, uri_string, len );
+
+	/* Allocate image */
+	prefetch->image = alloc_image ( uri );
+	if ( ! prefetch->image ) {
+		rc = -ENOMEM;
+		goto err_alloc_image;
+	}
+
+	/* Accumulate configured digests during download, if applicable */
+	if ( ( rc = imgdownload_start_digests ( prefetch->image ) ) != 0 )
+		goto err_digest;
+
+	/* Create downloader */
+	if ( ( rc = create_downloader ( &prefetch->job, prefetch->image,
+					flags ) ) != 0 )
+		goto err_create_downloader;
+
+	/* Add to list of prefetches (which holds the reference) */
+	DBGC ( prefetch, "IMGPREFETCH %s started\n", prefetch->uri_string );
+	list_add_tail ( &prefetch->list, &imgprefetches );
+	free ( uri_string );
+	uri_put ( uri );
+	return 0;
+
+ err_create_downloader:
+ err_digest:
+ err_alloc_image:
+	ref_put ( &prefetch->refcnt );
+ err_alloc:
+ err_exists:
+	free ( uri_string );
+ err_uri_string:
+	uri_put ( uri );
+ err_resolve_uri:
+	return rc;
+}
+
+/**
+ * Discard all background image prefetches
+ *
+ */
+void imgprefetch_discard ( void ) {
+	struct imgprefetch *prefetch;
+	struct imgprefetch *tmp;
+
+	list_for_each_entry_safe ( prefetch, tmp, &imgprefetches, list ) {
+		list_del ( &prefetch->list );
+		imgprefetch_close ( prefetch, -ECANCELED );
+		ref_put ( &prefetch->refcnt );
+	}
+}
+
+/**
+ * Wait for all background image prefetches to complete
+ *
+ * @v timeout		Download timeout
+ * @ret rc		Return status code
+ *
+ * All prefetched images are registered (and removed from the list of
+ * prefetches).  Failures are reported individually, and the first
+ * error encountered is returned.
+ */
+int imgprefetch_wait ( unsigned long timeout ) {
+	struct imgprefetch *prefetch;
+	struct imgprefetch *tmp;
+	char message[32];
+	unsigned int count;
+	int rc = 0;
+
+	/* Wait for any prefetches still in progress */
+	count = imgprefetch_pending();
+	if ( count ) {
+		snprintf ( message, sizeof ( message ),
+			   "Waiting for %d download%s", count,
+			   ( ( count == 1 ) ? "" : "s" ) );
+		intf_plug_plug ( &monojob, &imgprefetch_waiter );
+		rc = monojob_wait ( message, timeout );
+	}
+
+	/* Register completed images and report failures */
+	list_for_each_entry_safe ( prefetch, tmp, &imgprefetches, list ) {
+		list_del ( &prefetch->list );
+		if ( prefetch->rc == 0 ) {
+			prefetch->rc = register_image ( prefetch->image );
+		} else if ( prefetch->rc == -EINPROGRESS ) {
+			imgprefetch_close ( prefetch, -ECANCELED );
+		}
+		if ( prefetch->rc != 0 ) {
+			printf ( "Could not download %s: %s\n",
+				 prefetch->image->name,
+				 strerror ( prefetch->rc ) );
+			if ( rc == 0 )
+				rc = prefetch->rc;
+		}
+		ref_put ( &prefetch->refcnt );
+	}
+
+	return rc;
+}
+
+/**
+ * Claim a background image prefetch
+ *
+ * @v uri		Resolved URI
+ * @v timeout		Download timeout
+ * @v flags		Download flags
+ * @v message		Job description to display
+ * @v image		Image to fill in
+ * @ret rc		Return status code, or -ENOENT if not prefetched
+ */
+static int imgprefetch_claim ( struct uri *uri, unsigned long timeout,
+			       unsigned int flags, const char *message,
+			       struct image **image ) {
+	struct imgprefetch *prefetch;
+	char *uri_string;
+	int rc;
+
+	/* Find matching prefetch, if any */
+	uri_string = format_uri_alloc ( uri );
+	if ( ! uri_string )
+		return -ENOMEM;
+	prefetch = imgprefetch_find ( uri_string, flags );
+	free ( uri_string );
+	if ( ! prefetch )
+		return -ENOENT;
+
+	/* Remove from list of prefetches (taking ownership of reference) */
+	list_del ( &prefetch->list );
+
+	/* Wait for download to complete, if still in progress */
+	if ( prefetch->rc == -EINPROGRESS ) {
+		intf_plug_plug ( &monojob, &prefetch->monitor );
+		if ( ( rc = monojob_wait ( message, timeout ) ) != 0 )
+			goto err_wait;
+	} else if ( prefetch->rc == 0 ) {
+		printf ( "%s... ok\n", message );
+	} else {
+		/* Retry failed prefetches as a normal download */
+		rc = -ENOENT;
+		goto err_failed;
+	}
+
+	/* Register image */
+	*image = prefetch->image;
+	if ( ( rc = register_image ( *image ) ) != 0 ) {
+		printf ( "Could not register image: %s\n", strerror ( rc ) );
+		goto err_register_image;
+	}
+
+ err_register_image:
+ err_failed:
+ err_wait:
+	ref_put ( &prefetch->refcnt );
+	return rc;
+}
+
+/**
+ * Download a new image in the foreground
+ *
+ * @v uri		Resolved URI
+ * @v timeout		Download timeout
+ * @v flags		Download flags
+ * @v digest		Digest algorithm, or NULL
+ * @v message		Job description to display
+ * @v image		Image to fill in
+ * @ret rc		Return status code
+ */
+static int imgdownload_foreground ( struct uri *uri, unsigned long timeout,
+				    unsigned int flags,
+				    struct digest_algorithm *digest,
+				    const char *message,
+				    struct image **image ) {
+	int rc;
 
 	/* Allocate image */
 	*image = alloc_image ( uri );
@@ -82,14 +540,20 @@ int imgdownload ( struct uri *uri, unsigned long timeout,
 		goto err_alloc_image;
 	}
 
+	/* Accumulate digests during download, if applicable */
+	if ( digest && ( ( rc = image_digest_start ( *image, digest ) ) != 0 ) )
+		goto err_digest;
+	if ( ( rc = imgdownload_start_digests ( *image ) ) != 0 )
+		goto err_digest;
+
 	/* Create downloader */
-	if ( ( rc = create_downloader ( &monojob, *image ) ) != 0 ) {
+	if ( ( rc = create_downloader ( &monojob, *image, flags ) ) != 0 ) {
 		printf ( "Could not start download: %s\n", strerror ( rc ) );
 		goto err_create_downloader;
 	}
 
 	/* Wait for download to complete */
-	if ( ( rc = monojob_wait ( uri_string_redacted, timeout ) ) != 0 )
+	if ( ( rc = monojob_wait ( message, timeout ) ) != 0 )
 		goto err_monojob_wait;
 
 	/* Register image */
@@ -101,8 +565,59 @@ int imgdownload ( struct uri *uri, unsigned long timeout,
  err_register_image:
  err_monojob_wait:
  err_create_downloader:
+ err_digest:
 	image_put ( *image );
  err_alloc_image:
+	return rc;
+}
+
+/**
+ * Download a new image, accumulating a digest during download
+ *
+ * @v uri		URI
+ * @v timeout		Download timeout
+ * @v flags		Download flags
+ * @v digest		Digest algorithm, or NULL
+ * @v image		Image to fill in
+ * @ret rc		Return status code
+ */
+int imgdownload_digest ( struct uri *uri, unsigned long timeout,
+			 unsigned int flags, struct digest_algorithm *digest,
+			 struct image **image ) {
+	struct uri uri_redacted;
+	char *uri_string_redacted;
+	int rc;
+
+	/* Construct redacted URI */
+	memcpy ( &uri_redacted, uri, sizeof ( uri_redacted ) );
+	uri_redacted.user = NULL;
+	uri_redacted.password = NULL;
+	uri_redacted.equery = NULL;
+	uri_redacted.efragment = NULL;
+	uri_string_redacted = format_uri_alloc ( &uri_redacted );
+	if ( ! uri_string_redacted ) {
+		rc = -ENOMEM;
+		goto err_uri_string;
+	}
+
+	/* Resolve URI */
+	uri = resolve_uri ( cwuri, uri );
+	if ( ! uri ) {
+		rc = -ENOMEM;
+		goto err_resolve_uri;
+	}
+
+	/* Use prefetched image if available (and if no additional
+	 * digest is required), otherwise download image.
+	 */
+	rc = ( digest ? -ENOENT :
+	       imgprefetch_claim ( uri, timeout, flags, uri_string_redacted,
+				   image ) );
+	if ( rc == -ENOENT ) {
+		rc = imgdownload_foreground ( uri, timeout, flags, digest,
+					      uri_string_redacted, image );
+	}
+
 	uri_put ( uri );
  err_resolve_uri:
 	free ( uri_string_redacted );
@@ -110,23 +625,39 @@ int imgdownload ( struct uri *uri, unsigned long timeout,
 	return rc;
 }
 
+/**
+ * Download a new image
+ *
+ * @v uri		URI
+ * @v timeout		Download timeout
+ * @v flags		Download flags
+ * @v image		Image to fill in
+ * @ret rc		Return status code
+ */
+int imgdownload ( struct uri *uri, unsigned long timeout, unsigned int flags,
+		  struct image **image ) {
+
+	return imgdownload_digest ( uri, timeout, flags, NULL, image );
+}
+
 /**
  * Download a new image
  *
  * @v uri_string	URI string
  * @v timeout		Download timeout
+ * @v flags		Download flags
  * @v image		Image to fill in
  * @ret rc		Return status code
  */
 int imgdownload_string ( const char *uri_string, unsigned long timeout,
-			 struct image **image ) {
+			 unsigned int flags, struct image **image ) {
 	struct uri *uri;
 	int rc;
 
 	if ( ! ( uri = parse_uri ( uri_string ) ) )
 		return -ENOMEM;
 
-	rc = imgdownload ( uri, timeout, image );
+	rc = imgdownload ( uri, timeout, flags, image );
 
 	uri_put ( uri );
 	return rc;
@@ -137,11 +668,12 @@ int imgdownload_string ( const char *uri_string, unsigned long timeout,
  *
  * @v name_uri		Name or URI string
  * @v timeout		Download timeout
+ * @v flags		Download flags
  * @v image		Image to fill in
  * @ret rc		Return status code
  */
 int imgacquire ( const char *name_uri, unsigned long timeout,
-		 struct image **image ) {
+		 unsigned int flags, struct image **image ) {
 
 	/* If we already have an image with the specified name, use it */
 	*image = find_image ( name_uri );
@@ -149,7 +681,37 @@ int imgacquire ( const char *name_uri, unsigned long timeout,
 		return 0;
 
 	/* Otherwise, download a new image */
-	return imgdownload_string ( name_uri, timeout, image );
+	return imgdownload_string ( name_uri, timeout, flags, image );
+}
+
+/**
+ * Acquire an image, accumulating a digest if downloaded
+ *
+ * @v name_uri		Name or URI string
+ * @v timeout		Download timeout
+ * @v flags		Download flags
+ * @v digest		Digest algorithm, or NULL
+ * @v image		Image to fill in
+ * @ret rc		Return status code
+ */
+int imgacquire_digest ( const char *name_uri, unsigned long timeout,
+			unsigned int flags, struct digest_algorithm *digest,
+			struct image **image ) {
+	struct uri *uri;
+	int rc;
+
+	/* If we already have an image with the specified name, use it */
+	*image = find_image ( name_uri );
+	if ( *image )
+		return 0;
+
+	/* Otherwise, download a new image */
+	if ( ! ( uri = parse_uri ( name_uri ) ) )
+		return -ENOMEM;
+	rc = imgdownload_digest ( uri, timeout, flags, digest, image );
+	uri_put ( uri );
+
+	return rc;
 }
 
 /**
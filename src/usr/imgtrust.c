@@ -33,6 +33,7 @@ FILE_SECBOOT ( PERMITTED );
 #include <ipxe/cms.h>
 #include <ipxe/validator.h>
 #include <ipxe/monojob.h>
+#include <ipxe/trace.h>
 #include <usr/imgtrust.h>
 
 /** @file
@@ -41,6 +42,45 @@ FILE_SECBOOT ( PERMITTED );
  *
  */
 
+/**
+ * Identify digest algorithm used by downloaded signature
+ *
+ * @v signature		Image containing signature
+ * @v name		Required common name, or NULL to allow any name
+ * @ret digest		Digest algorithm, or NULL if not identifiable
+ *
+ * This may be used to start accumulating the image digest while the
+ * image is downloaded, prior to calling imgverify().
+ */
+struct digest_algorithm * imgverify_digest ( struct image *signature,
+					     const char *name ) {
+	struct digest_algorithm *digest = NULL;
+	struct cms_participant *part;
+	struct x509_certificate *cert;
+	struct cms_message *cms;
+
+	/* Parse signature */
+	if ( cms_message ( signature, &cms ) != 0 )
+		return NULL;
+
+	/* Use digest algorithm of first relevant signer */
+	if ( cms_is_signature ( cms ) ) {
+		list_for_each_entry ( part, &cms->participants, list ) {
+			cert = x509_first ( part->chain );
+			if ( name && ( ( ! cert ) ||
+				       ( x509_check_name ( cert, name ) != 0 ) ) )
+				continue;
+			digest = part->digest;
+			break;
+		}
+	}
+
+	/* Drop reference to message */
+	cms_put ( cms );
+
+	return digest;
+}
+
 /**
  * Verify image using downloaded signature
  *
@@ -63,7 +103,7 @@ int imgverify ( struct image *image, struct image *signature,
 	/* Complete all certificate chains */
 	list_for_each_entry ( part, &cms->participants, list ) {
 		if ( ( rc = create_validator ( &monojob, part->chain,
-					       NULL ) ) != 0 )
+					       NULL, NULL ) ) != 0 )
 			goto err_create_validator;
 		if ( ( rc = monojob_wait ( NULL, 0 ) ) != 0 )
 			goto err_validator_wait;
@@ -80,6 +120,7 @@ int imgverify ( struct image *image, struct image *signature,
 
 	/* Record signature verification */
 	syslog ( LOG_NOTICE, "Image \"%s\" signature OK\n", image->name );
+	trace ( "image", "verified", image, 0 );
 
 	return 0;
 
@@ -25,6 +25,9 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 FILE_SECBOOT ( PERMITTED );
 
 #include <stdio.h>
+#include <byteswap.h>
+#include <ipxe/socket.h>
+#include <ipxe/timer.h>
 #include <ipxe/tcp.h>
 #include <ipxe/ipstat.h>
 #include <usr/ipstat.h>
@@ -74,4 +77,42 @@ void ipstat ( void ) {
 		 tcp_stats.in_octets_good );
 	printf ( "  InDiscards:%ld InOutOfOrder:%ld\n",
 		 tcp_stats.in_discards, tcp_stats.in_out_of_order );
+	printf ( "  OutRetransSegs:%ld FastRetrans:%ld RackLoss:%ld\n",
+		 tcp_stats.out_rtx_segs, tcp_stats.fast_rtx,
+		 tcp_stats.rack_loss );
+	printf ( "  RcvWinMax:%ld RTT:%ldms RTTVar:%ldms RTO:%ldms\n",
+		 tcp_stats.rcv_win_max,
+		 ( ( tcp_stats.rtt * 1000 ) / TICKS_PER_SEC ),
+		 ( ( tcp_stats.rttvar * 1000 ) / TICKS_PER_SEC ),
+		 ( ( tcp_stats.rto * 1000 ) / TICKS_PER_SEC ) );
+	printf ( "  DupAcks:%ld ZeroWin:%ldms\n", tcp_stats.dupacks,
+		 ( ( tcp_stats.zero_win * 1000 ) / TICKS_PER_SEC ) );
+}
+
+/**
+ * Print per-connection TCP statistics
+ *
+ */
+void tcpstat ( void ) {
+	struct tcp_info info;
+	struct tcp_connection_statistics *stats = &info.stats;
+	unsigned int i;
+
+	for ( i = 0 ; tcp_info ( i, &info ) == 0 ; i++ ) {
+		printf ( "TCP %d -> %s:%d %s\n", info.local_port,
+			 sock_ntoa ( ( struct sockaddr * ) &info.peer ),
+			 ntohs ( info.peer.st_port ), info.state );
+		printf ( "  InSegs:%ld InOctets:%ld OutSegs:%ld "
+			 "OutOctets:%ld\n", stats->in_segs, stats->in_octets,
+			 stats->out_segs, stats->out_octets );
+		printf ( "  OutRetransSegs:%ld DupAcks:%ld OutOfOrder:%zd "
+			 "(%d ranges)\n", stats->out_rtx_segs, stats->dupacks,
+			 info.ooo_len, info.ooo_ranges );
+		printf ( "  RTT:%ldms RcvWin:%d SndWin:%d CWnd:%d\n",
+			 ( ( info.srtt * 1000 ) / TICKS_PER_SEC ),
+			 info.rcv_win, info.snd_win, info.cwnd );
+		printf ( "  RcvZeroWin:%ldms SndZeroWin:%ldms\n",
+			 ( ( stats->rcv_zero_win * 1000 ) / TICKS_PER_SEC ),
+			 ( ( stats->snd_zero_win * 1000 ) / TICKS_PER_SEC ) );
+	}
 }
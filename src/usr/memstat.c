@@ -0,0 +1,59 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+FILE_SECBOOT ( PERMITTED );
+
+#include <stdio.h>
+#include <ipxe/malloc.h>
+#include <ipxe/slab.h>
+#include <usr/memstat.h>
+
+/** @file
+ *
+ * Memory usage statistics
+ *
+ */
+
+/**
+ * Print memory usage statistics
+ *
+ */
+void memstat ( void ) {
+	struct slab_cache *cache;
+	struct heap *heap;
+
+	for_each_table_entry ( heap, HEAPS ) {
+		printf ( "%s: used %zdkB (max %zdkB) free %zdkB (largest "
+			 "%zdkB)\n", heap->name, ( heap->usedmem >> 10 ),
+			 ( heap->maxusedmem >> 10 ), ( heap->freemem >> 10 ),
+			 ( heap_largest ( heap ) >> 10 ) );
+		printf ( "%s: %ld allocations, grown %ld times\n",
+			 heap->name, heap->allocs, heap->grows );
+	}
+	list_for_each_entry ( cache, &slab_caches, list ) {
+		printf ( "%s: %d objects (max %d) in %d %zdkB slabs\n",
+			 cache->name, cache->used, cache->maxused,
+			 cache->slabs, ( cache->slab_size >> 10 ) );
+	}
+}
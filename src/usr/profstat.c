@@ -34,6 +34,43 @@ FILE_SECBOOT ( PERMITTED );
  *
  */
 
+/**
+ * Print profiling statistics for a single profiler
+ *
+ * @v profiler		Profiler
+ * @v histogram		Also print sample histogram
+ */
+void profstat_profiler ( struct profiler *profiler, int histogram ) {
+	unsigned long min;
+	unsigned long max;
+	unsigned int bucket;
+
+	/* Print summary statistics */
+	printf ( "%s: %ld +/- %ld ticks (%d samples) p50/p90/p99 %ld/%ld/%ld\n",
+		 profiler->name, profile_mean ( profiler ),
+		 profile_stddev ( profiler ), profiler->count,
+		 profile_percentile ( profiler, 50 ),
+		 profile_percentile ( profiler, 90 ),
+		 profile_percentile ( profiler, 99 ) );
+	if ( ! histogram )
+		return;
+
+	/* Print non-empty histogram buckets */
+	for ( bucket = 0 ; bucket < PROFILE_BUCKETS ; bucket++ ) {
+		if ( ! profiler->histogram[bucket] )
+			continue;
+		min = ( bucket ? ( 1UL << ( bucket - 1 ) ) : 0 );
+		max = ( bucket ? ( ( 2UL << ( bucket - 1 ) ) - 1 ) : 0 );
+		if ( bucket == ( PROFILE_BUCKETS - 1 ) ) {
+			printf ( "  %10ld +           : %d\n",
+				 min, profiler->histogram[bucket] );
+		} else {
+			printf ( "  %10ld - %10ld: %d\n",
+				 min, max, profiler->histogram[bucket] );
+		}
+	}
+}
+
 /**
  * Print profiling statistics
  *
@@ -41,9 +78,6 @@ FILE_SECBOOT ( PERMITTED );
 void profstat ( void ) {
 	struct profiler *profiler;
 
-	for_each_table_entry ( profiler, PROFILERS ) {
-		printf ( "%s: %ld +/- %ld ticks (%d samples)\n",
-			 profiler->name, profile_mean ( profiler ),
-			 profile_stddev ( profiler ), profiler->count );
-	}
+	for_each_table_entry ( profiler, PROFILERS )
+		profstat_profiler ( profiler, 0 );
 }
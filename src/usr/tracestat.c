@@ -0,0 +1,80 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+FILE_SECBOOT ( PERMITTED );
+
+#include <stdio.h>
+#include <ipxe/timer.h>
+#include <ipxe/trace.h>
+#include <usr/tracestat.h>
+
+/** @file
+ *
+ * Boot-time event tracing
+ *
+ */
+
+/**
+ * Print boot-time trace events
+ *
+ * Each event is shown with its time relative to the oldest retained
+ * event, both in milliseconds and in raw profiling timestamp units
+ * (which typically have a much finer resolution).
+ */
+void tracestat ( void ) {
+	struct trace_event *event;
+	unsigned long first_ticks = 0;
+	unsigned long first_timestamp = 0;
+	unsigned long ms;
+	unsigned int index;
+	int first = 1;
+
+	for ( index = 0 ; index < trace_count ; index++ ) {
+
+		/* Skip events that have been overwritten */
+		event = trace_event ( index );
+		if ( ! event )
+			continue;
+
+		/* Record time of oldest retained event */
+		if ( first ) {
+			if ( index ) {
+				printf ( "(%d earlier events discarded)\n",
+					 index );
+			}
+			first_ticks = event->ticks;
+			first_timestamp = event->timestamp;
+			first = 0;
+		}
+
+		/* Show event */
+		ms = ( ( ( event->ticks - first_ticks ) * 1000 ) /
+		       TICKS_PER_SEC );
+		printf ( "%4ld.%03ld %12ld %s %s %p %ld\n",
+			 ( ms / 1000 ), ( ms % 1000 ),
+			 ( event->timestamp - first_timestamp ),
+			 event->subsystem, event->name, event->object,
+			 event->value );
+	}
+}
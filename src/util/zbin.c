@@ -17,6 +17,17 @@
 /* LZMA preset choice.  This is a policy decision */
 #define LZMA_PRESET ( LZMA_PRESET_DEFAULT | LZMA_PRESET_EXTREME )
 
+/* LZ4 block format constants.  Must match those used by unlz4.S */
+#define LZ4_MIN_MATCH 4
+#define LZ4_MAX_OFFSET 0xffff
+#define LZ4_LEN_EXTEND 0x0f
+#define LZ4_LAST_LITERALS 5
+#define LZ4_MATCH_LIMIT 12
+
+/* LZ4 match finder choices.  This is a policy decision */
+#define LZ4_HASH_BITS 16
+#define LZ4_SEARCH_DEPTH 256
+
 #undef ELF_R_TYPE
 
 #ifdef ELF32
@@ -404,6 +415,182 @@ static int process_zinfo_pack ( struct input_file *input,
 	return 0;
 }
 
+static uint32_t lz4_hash ( const uint8_t *data ) {
+	uint32_t value;
+
+	memcpy ( &value, data, sizeof ( value ) );
+	return ( ( value * 2654435761U ) >> ( 32 - LZ4_HASH_BITS ) );
+}
+
+static uint8_t * lz4_length ( uint8_t *out, size_t len ) {
+	while ( len >= 0xff ) {
+		*(out++) = 0xff;
+		len -= 0xff;
+	}
+	*(out++) = len;
+	return out;
+}
+
+static uint8_t * lz4_sequence ( uint8_t *out, const uint8_t *literals,
+				size_t literals_len, size_t offset,
+				size_t match_len ) {
+	uint8_t *token = out++;
+
+	*token = ( ( ( literals_len < LZ4_LEN_EXTEND ) ?
+		     literals_len : LZ4_LEN_EXTEND ) << 4 );
+	if ( literals_len >= LZ4_LEN_EXTEND )
+		out = lz4_length ( out, ( literals_len - LZ4_LEN_EXTEND ) );
+	memcpy ( out, literals, literals_len );
+	out += literals_len;
+
+	if ( match_len ) {
+		*(out++) = ( offset & 0xff );
+		*(out++) = ( offset >> 8 );
+		match_len -= LZ4_MIN_MATCH;
+		*token |= ( ( match_len < LZ4_LEN_EXTEND ) ?
+			    match_len : LZ4_LEN_EXTEND );
+		if ( match_len >= LZ4_LEN_EXTEND ) {
+			out = lz4_length ( out,
+					   ( match_len - LZ4_LEN_EXTEND ) );
+		}
+	}
+
+	return out;
+}
+
+static int lz4_compress ( const uint8_t *in, size_t len, uint8_t *out,
+			  size_t *packed_len ) {
+	ssize_t *head;
+	ssize_t *prev;
+	uint8_t *start = out;
+	size_t limit = ( ( len > LZ4_MATCH_LIMIT ) ?
+			 ( len - LZ4_MATCH_LIMIT ) : 0 );
+	size_t anchor = 0;
+	size_t pos = 0;
+	size_t best_len;
+	size_t best_offset = 0;
+	size_t max_len;
+	size_t match_len;
+	ssize_t candidate;
+	uint32_t hash;
+	unsigned int depth;
+	unsigned int i;
+
+	/* Allocate hash chains */
+	head = malloc ( ( 1 << LZ4_HASH_BITS ) * sizeof ( head[0] ) );
+	prev = malloc ( ( len + 1 ) * sizeof ( prev[0] ) );
+	if ( ! ( head && prev ) ) {
+		fprintf ( stderr, "Could not allocate LZ4 hash chains\n" );
+		free ( head );
+		free ( prev );
+		return -1;
+	}
+	for ( i = 0 ; i < ( 1 << LZ4_HASH_BITS ) ; i++ )
+		head[i] = -1;
+
+	/* Greedily take the longest match found in each hash chain */
+	while ( pos < limit ) {
+		hash = lz4_hash ( in + pos );
+		max_len = ( len - LZ4_LAST_LITERALS - pos );
+		best_len = 0;
+		candidate = head[hash];
+		for ( depth = LZ4_SEARCH_DEPTH ; depth && ( candidate >= 0 ) &&
+			      ( ( pos - candidate ) <= LZ4_MAX_OFFSET ) ;
+		      depth-- ) {
+			for ( match_len = 0 ; ( ( match_len < max_len ) &&
+						( in[ candidate + match_len ] ==
+						  in[ pos + match_len ] ) ) ;
+			      match_len++ ) {}
+			if ( match_len > best_len ) {
+				best_len = match_len;
+				best_offset = ( pos - candidate );
+			}
+			candidate = prev[candidate];
+		}
+		if ( best_len < LZ4_MIN_MATCH )
+			best_len = 1;
+
+		/* Add all consumed positions to the hash chains */
+		for ( i = 0 ; i < best_len ; i++, pos++ ) {
+			if ( ( pos + sizeof ( hash ) ) > len )
+				continue;
+			hash = lz4_hash ( in + pos );
+			prev[pos] = head[hash];
+			head[hash] = pos;
+		}
+
+		/* Emit sequence, if a match was found */
+		if ( best_len >= LZ4_MIN_MATCH ) {
+			out = lz4_sequence ( out, ( in + anchor ),
+					     ( pos - best_len - anchor ),
+					     best_offset, best_len );
+			anchor = pos;
+		}
+	}
+
+	/* Emit final literals */
+	out = lz4_sequence ( out, ( in + anchor ), ( len - anchor ), 0, 0 );
+	*packed_len = ( out - start );
+
+	free ( head );
+	free ( prev );
+	return 0;
+}
+
+static int process_zinfo_pkl4 ( struct input_file *input,
+				struct output_file *output,
+				union zinfo_record *zinfo ) {
+	struct zinfo_pack *pack = &zinfo->pack;
+	size_t offset = pack->offset;
+	size_t len = pack->len;
+	size_t start_len;
+	size_t packed_len = 0;
+	void *packed;
+	uint32_t *len32;
+	uint32_t *crc32;
+
+	if ( ( offset + len ) > input->len ) {
+		fprintf ( stderr, "Input buffer overrun on pack\n" );
+		return -1;
+	}
+
+	output->len = align ( output->len, pack->align );
+	start_len = output->len;
+	len32 = ( output->buf + output->len );
+	output->len += sizeof ( *len32 );
+
+	/* Allow for worst-case expansion of incompressible data */
+	if ( ( output->len + len + ( len / 0xff ) + 16 ) > output->max_len ) {
+		fprintf ( stderr, "Output buffer overrun on pack\n" );
+		return -1;
+	}
+
+	packed = ( output->buf + output->len );
+	if ( lz4_compress ( ( input->buf + offset ), len, packed,
+			    &packed_len ) != 0 ) {
+		fprintf ( stderr, "Compression failure\n" );
+		return -1;
+	}
+	output->len += packed_len;
+
+	crc32 = ( output->buf + output->len );
+	output->len += sizeof ( *crc32 );
+	if ( output->len > output->max_len ) {
+		fprintf ( stderr, "Output buffer overrun on pack\n" );
+		return -1;
+	}
+	*len32 = ( packed_len + sizeof ( *crc32 ) );
+	*crc32 = crc32_le ( CRCSEED, packed, packed_len );
+
+	if ( DEBUG ) {
+		fprintf ( stderr, "PKL4 [%#zx,%#zx) to [%#zx,%#zx) crc %#08x\n",
+			  offset, ( offset + len ), start_len, output->len,
+			  *crc32 );
+	}
+
+	return 0;
+}
+
 static int process_zinfo_payl ( struct input_file *input
 					__attribute__ (( unused )),
 				struct output_file *output,
@@ -761,6 +948,7 @@ struct zinfo_processor {
 static struct zinfo_processor zinfo_processors[] = {
 	{ "COPY", process_zinfo_copy },
 	{ "PACK", process_zinfo_pack },
+	{ "PKL4", process_zinfo_pkl4 },
 	{ "PAYL", process_zinfo_payl },
 	{ "ADDB", process_zinfo_addb },
 	{ "ADDW", process_zinfo_addw },